@@ -0,0 +1,124 @@
+/**
+ * @file csv_parser.c
+ * @brief Allocation-free tokenizer for quoted CSV lines from JanOS
+ */
+
+#include "csv_parser.h"
+#include <limits.h>
+#include <stdint.h>
+
+static inline bool is_blank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+void csv_tokenizer_init(csv_tokenizer_t *tok, const char *line)
+{
+    tok->p = line ? line : "";
+    tok->done = false;
+}
+
+bool csv_next_field(csv_tokenizer_t *tok, csv_field_t *field)
+{
+    if (tok->done) return false;
+
+    const char *p = tok->p;
+    while (is_blank(*p)) p++;
+
+    field->quoted = false;
+    field->escaped = false;
+
+    if (*p == '"') {
+        // Quoted field: runs to the first unescaped closing quote
+        p++;
+        field->ptr = p;
+        field->quoted = true;
+        while (*p) {
+            if (*p == '\\' && p[1] == '"') {
+                field->escaped = true;
+                p += 2;
+            } else if (*p == '"' && p[1] == '"') {
+                field->escaped = true;
+                p += 2;
+            } else if (*p == '"') {
+                break;
+            } else {
+                p++;
+            }
+        }
+        field->len = p - field->ptr;
+        if (*p == '"') p++;
+
+        // Anything between the closing quote and the comma is ignored
+        while (*p && *p != ',') p++;
+    } else {
+        // Bare field: runs to the comma, trailing blanks trimmed
+        field->ptr = p;
+        while (*p && *p != ',') p++;
+        const char *end = p;
+        while (end > field->ptr && is_blank(end[-1])) end--;
+        field->len = end - field->ptr;
+    }
+
+    if (*p == ',') {
+        p++;
+    } else {
+        tok->done = true;
+    }
+    tok->p = p;
+    return true;
+}
+
+size_t csv_field_copy(const csv_field_t *field, char *dst, size_t dst_size)
+{
+    if (!dst || dst_size == 0) return 0;
+
+    size_t out = 0;
+    const char *p = field->ptr;
+    const char *end = field->ptr + field->len;
+
+    while (p < end && out < dst_size - 1) {
+        if (field->escaped && p + 1 < end && p[1] == '"' && (*p == '\\' || *p == '"')) {
+            p++;    // Drop the escape, keep the quote
+        }
+        dst[out++] = *p++;
+    }
+    dst[out] = '\0';
+    return out;
+}
+
+int csv_field_to_int(const csv_field_t *field)
+{
+    const char *p = field->ptr;
+    const char *end = field->ptr + field->len;
+
+    while (p < end && is_blank(*p)) p++;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    // Accumulate in 64 bits and saturate, so long digit runs cannot overflow
+    int64_t value = 0;
+    int64_t limit = negative ? -(int64_t)INT_MIN : INT_MAX;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        if (value > limit) value = limit;
+        p++;
+    }
+    return (int)(negative ? -value : value);
+}
+
+int csv_split(const char *line, csv_field_t *fields, int max_fields)
+{
+    csv_tokenizer_t tok;
+    csv_tokenizer_init(&tok, line);
+
+    int count = 0;
+    while (count < max_fields && csv_next_field(&tok, &fields[count])) {
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file bench_janos_proto.c
+ * @brief Throughput of the janos_proto parsers on the host
+ *
+ *   ./bench_janos_proto                  representative line per format
+ *   ./bench_janos_proto capture.txt      every line of a capture through
+ *                                        all parsers, as the firmware's
+ *                                        line routing would in the worst case
+ *
+ * Reports ns per line and MB/s. Host numbers only rank changes; the
+ * ESP32-S3 figures come from the benchmark screen.
+ */
+
+#include "janos_proto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MIN_NS    200000000LL     // Run each case at least 0.2 s
+#define CAPTURE_LINES   100000
+#define LINE_MAX_BYTES  1024
+
+typedef bool (*parse_fn_t)(const char *line, void *out);
+
+typedef struct {
+    const char *name;
+    parse_fn_t parse;
+    const char *line;
+} bench_case_t;
+
+static bool parse_scan(const char *line, void *out) { return janos_parse_scan_row(line, out); }
+static bool parse_deauth(const char *line, void *out) { return janos_parse_deauth(line, out); }
+static bool parse_bt(const char *line, void *out) { return janos_parse_bt_row(line, out); }
+static bool parse_list(const char *line, void *out) { return janos_parse_list_row(line, out); }
+static bool parse_arp(const char *line, void *out) { return janos_parse_arp_host(line, out); }
+static bool parse_hs(const char *line, void *out) { return janos_parse_capture_row(line, out); }
+static bool parse_handshake(const char *line, void *out) { return janos_parse_handshake(line, out); }
+static bool parse_dog(const char *line, void *out) { return janos_parse_dog_kick(line, out); }
+
+static const bench_case_t cases[] = {
+    { "scan_row", parse_scan,
+      "\"17\",\"Office Guest \\\"5G\\\"\",\"\",\"AA:BB:CC:DD:EE:FF\",\"36\",\"WPA2/WPA3\",\"-71\",\"5GHz\"" },
+    { "deauth", parse_deauth,
+      "[DEAUTH] CH: 11 | AP: Cafe Corner (aa:bb:cc:00:11:22) | RSSI: -67" },
+    { "bt_row", parse_bt,
+      "  23. C4:2B:44:12:29:15  RSSI: -82 dBm  Name: WH-1000XM4" },
+    { "list_row", parse_list,
+      "12 portal_login_page_with_a_long_name.html" },
+    { "arp_host", parse_arp,
+      "192.168.4.101  ->  C4:2B:44:12:29:15 [Huawei Device Co., Ltd.]" },
+    { "hs_row", parse_hs,
+      "\"AX3_2.4_12291C_79868.pcap\",\"AX3_2.4\",\"AA:BB:CC:12:29:1C\",\"1234\",\"0\",\"1186\",\"1739550000\"" },
+    { "handshake", parse_handshake,
+      "Complete 4-way handshake saved for SSID: Office Guest (MAC: 12291C, message_pair: 2)" },
+    { "dog_kick", parse_dog,
+      "[SnifferDog #1234] DEAUTH sent: AP=30:AA:E4:3C:3F:64 -> STA=A6:02:A5:BA:DA:AB (Ch=1, RSSI=-69)" },
+    // Misses cost as much as hits: most lines reach a parser that rejects them
+    { "miss", parse_bt,
+      "I (123456) wifi:new:<6,0>, old:<1,0>, ap:<255,255>, sta:<6,0>, prof:1" },
+};
+
+static long long now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static void report(const char *name, long long lines, long long bytes, long long ns, long long hits)
+{
+    printf("%-10s %9.1f ns/line %8.1f MB/s %10lld lines %10lld parsed\n", name,
+           (double)ns / (double)lines, (double)bytes * 1000.0 / (double)ns, lines, hits);
+}
+
+static void bench_cases(void)
+{
+    union {
+        janos_scan_row_t scan;
+        janos_deauth_t deauth;
+        janos_bt_row_t bt;
+        janos_list_row_t list;
+        janos_arp_host_t arp;
+        janos_capture_row_t hs;
+        janos_handshake_t handshake;
+        janos_dog_kick_t dog;
+    } out;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const bench_case_t *c = &cases[i];
+        size_t len = strlen(c->line);
+        long long lines = 0;
+        long long hits = 0;
+        long long start = now_ns();
+        long long elapsed;
+        do {
+            for (int n = 0; n < 10000; n++) hits += c->parse(c->line, &out);
+            lines += 10000;
+            elapsed = now_ns() - start;
+        } while (elapsed < BENCH_MIN_NS);
+        report(c->name, lines, lines * (long long)len, elapsed, hits);
+    }
+}
+
+static int bench_capture(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return 1;
+    }
+    char **lines = malloc(CAPTURE_LINES * sizeof(char *));
+    char buf[LINE_MAX_BYTES];
+    long long count = 0;
+    long long bytes = 0;
+    while (lines && count < CAPTURE_LINES && fgets(buf, sizeof(buf), f)) {
+        buf[strcspn(buf, "\r\n")] = '\0';
+        lines[count] = strdup(buf);
+        bytes += (long long)strlen(buf);
+        count++;
+    }
+    fclose(f);
+    if (count == 0) {
+        fprintf(stderr, "%s: no lines\n", path);
+        free(lines);
+        return 1;
+    }
+
+    long long hits[8] = { 0 };
+    long long passes = 0;
+    long long start = now_ns();
+    long long elapsed;
+    do {
+        for (long long i = 0; i < count; i++) {
+            janos_scan_row_t scan;
+            janos_deauth_t deauth;
+            janos_bt_row_t bt;
+            janos_list_row_t list;
+            janos_arp_host_t arp;
+            janos_capture_row_t hs;
+            janos_handshake_t handshake;
+            janos_dog_kick_t dog;
+            hits[0] += janos_parse_scan_row(lines[i], &scan);
+            hits[1] += janos_parse_deauth(lines[i], &deauth);
+            hits[2] += janos_parse_bt_row(lines[i], &bt);
+            hits[3] += janos_parse_list_row(lines[i], &list);
+            hits[4] += janos_parse_arp_host(lines[i], &arp);
+            hits[5] += janos_parse_capture_row(lines[i], &hs);
+            hits[6] += janos_parse_handshake(lines[i], &handshake);
+            hits[7] += janos_parse_dog_kick(lines[i], &dog);
+        }
+        passes++;
+        elapsed = now_ns() - start;
+    } while (elapsed < BENCH_MIN_NS);
+
+    report("capture", count * passes, bytes * passes, elapsed, 0);
+    printf("per pass: %lld scan, %lld deauth, %lld bt, %lld list, %lld arp, %lld hs, "
+           "%lld handshake, %lld dog of %lld lines\n",
+           hits[0] / passes, hits[1] / passes, hits[2] / passes, hits[3] / passes,
+           hits[4] / passes, hits[5] / passes, hits[6] / passes, hits[7] / passes, count);
+    for (long long i = 0; i < count; i++) free(lines[i]);
+    free(lines);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) return bench_capture(argv[1]);
+    bench_cases();
+    return 0;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file fuzz_janos_proto.c
+ * @brief libFuzzer target for every janos_proto parser
+ *
+ * Each input is one line and goes through all parsers; results are read
+ * back so the sanitizers see every span. Built with clang it is a
+ * libFuzzer target:
+ *   ./fuzz_janos_proto corpus/
+ * Otherwise a main() replays the files given, for reproducing crashes
+ * and running the corpus under gcc's sanitizers.
+ */
+
+#include "janos_proto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_MAX_BYTES  1024    // Longer than any UART line the handler assembles
+
+static volatile size_t sink;
+
+static void touch_span(const char *ptr, size_t len)
+{
+    size_t sum = 0;
+    for (size_t i = 0; i < len; i++) sum += (unsigned char)ptr[i];
+    sink += sum;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size > LINE_MAX_BYTES) return 0;
+    char *line = malloc(size + 1);      // Exact size, so ASan sees any overread
+    if (!line) return 0;
+    memcpy(line, data, size);
+    line[size] = '\0';
+
+    char copy[64];
+    janos_scan_row_t scan;
+    if (janos_parse_scan_row(line, &scan)) {
+        csv_field_copy(&scan.ssid, copy, sizeof(copy));
+        csv_field_copy(&scan.bssid, copy, sizeof(copy));
+        csv_field_copy(&scan.security, copy, sizeof(copy));
+        csv_field_copy(&scan.band, copy, sizeof(copy));
+        sink += (size_t)(scan.id + scan.channel + scan.rssi);
+    }
+
+    janos_deauth_t deauth;
+    if (janos_parse_deauth(line, &deauth)) {
+        touch_span(deauth.ap_name.ptr, deauth.ap_name.len);
+        janos_span_copy(deauth.ap_name, copy, sizeof(copy));
+    }
+
+    janos_bt_row_t bt;
+    if (janos_parse_bt_row(line, &bt)) {
+        touch_span(bt.mac_text, 17);
+        touch_span(bt.name.ptr, bt.name.len);
+    }
+
+    janos_list_row_t row;
+    if (janos_parse_list_row(line, &row)) {
+        touch_span(row.name.ptr, row.name.len);
+    }
+
+    janos_arp_host_t host;
+    if (janos_parse_arp_host(line, &host)) {
+        touch_span(host.vendor.ptr, host.vendor.len);
+    }
+
+    janos_capture_row_t capture;
+    if (janos_parse_capture_row(line, &capture)) {
+        csv_field_copy(&capture.name, copy, sizeof(copy));
+        csv_field_copy(&capture.ssid, copy, sizeof(copy));
+        sink += capture.eapol + capture.bytes + capture.mtime;
+    }
+
+    janos_handshake_t handshake;
+    if (janos_parse_handshake(line, &handshake)) {
+        touch_span(handshake.ssid.ptr, handshake.ssid.len);
+        janos_span_copy(handshake.ssid, copy, sizeof(copy));
+        sink += handshake.mac_tail + (size_t)handshake.message_pair;
+    }
+
+    janos_dog_kick_t dog;
+    if (janos_parse_dog_kick(line, &dog)) {
+        sink += (size_t)(dog.ap ^ dog.sta) + (size_t)(dog.count + dog.channel + dog.rssi);
+    }
+
+    csv_field_t fields[16];
+    int count = csv_split(line, fields, 16);
+    for (int i = 0; i < count; i++) {
+        csv_field_copy(&fields[i], copy, sizeof(copy));
+        sink += (size_t)csv_field_to_int(&fields[i]);
+    }
+
+    free(line);
+    return 0;
+}
+
+#ifndef JANOS_PROTO_LIBFUZZER
+int main(int argc, char **argv)
+{
+    static uint8_t buf[LINE_MAX_BYTES];
+    for (int i = 1; i < argc; i++) {
+        FILE *f = fopen(argv[i], "rb");
+        if (!f) {
+            fprintf(stderr, "%s: cannot open\n", argv[i]);
+            return 1;
+        }
+        size_t n = fread(buf, 1, sizeof(buf), f);
+        fclose(f);
+        LLVMFuzzerTestOneInput(buf, n);
+    }
+    printf("%d inputs OK\n", argc - 1);
+    return 0;
+}
+#endif
@@ -0,0 +1,73 @@
+/**
+ * @file csv_parser.h
+ * @brief Allocation-free tokenizer for quoted CSV lines from JanOS
+ *
+ * Yields field spans (pointer + length) straight into the line buffer;
+ * nothing is copied until the caller asks for it. Handles both quoted
+ * ("a","b") and bare (1,2) fields, with optional spaces after commas.
+ * Inside quoted fields a doubled quote ("") or a backslash-escaped quote
+ * (\") stands for a literal quote, so SSIDs containing quotes survive.
+ */
+
+#ifndef CSV_PARSER_H
+#define CSV_PARSER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// One field of a CSV line (points into the line, not NUL terminated)
+typedef struct {
+    const char *ptr;
+    size_t len;
+    bool quoted;
+    bool escaped;       // Contains escaped quotes - use csv_field_copy()
+} csv_field_t;
+
+// Tokenizer cursor
+typedef struct {
+    const char *p;
+    bool done;
+} csv_tokenizer_t;
+
+/**
+ * @brief Start tokenizing a line
+ * @param tok Tokenizer
+ * @param line NUL terminated line (must outlive the returned fields)
+ */
+void csv_tokenizer_init(csv_tokenizer_t *tok, const char *line);
+
+/**
+ * @brief Get the next field
+ * @param tok Tokenizer
+ * @param field Receives the field span
+ * @return false when the line has no more fields
+ */
+bool csv_next_field(csv_tokenizer_t *tok, csv_field_t *field);
+
+/**
+ * @brief Copy a field into a buffer, unescaping quotes and truncating
+ * @param field Field span
+ * @param dst Destination buffer
+ * @param dst_size Destination size (always NUL terminated if > 0)
+ * @return Number of characters written (excluding NUL)
+ */
+size_t csv_field_copy(const csv_field_t *field, char *dst, size_t dst_size);
+
+/**
+ * @brief Parse a field as a decimal integer (like atoi, no copy)
+ * @param field Field span
+ * @return Parsed value, 0 if the field has no leading digits; saturates at
+ *         INT_MAX / INT_MIN
+ */
+int csv_field_to_int(const csv_field_t *field);
+
+/**
+ * @brief Split a line into up to max_fields fields
+ * @param line NUL terminated line
+ * @param fields Output array
+ * @param max_fields Array length
+ * @return Number of fields found (at most max_fields)
+ */
+int csv_split(const char *line, csv_field_t *fields, int max_fields);
+
+#endif // CSV_PARSER_H
@@ -0,0 +1,179 @@
+/**
+ * @file janos_proto.h
+ * @brief Parsers for the JanOS text output lines
+ *
+ * Pure C with no ESP-IDF dependency, so the firmware, the desktop
+ * simulator and the host harness in host/ (fuzz targets, throughput
+ * benchmark) all build the same code. Each parser takes one NUL
+ * terminated line and fills a result whose text fields are spans into
+ * that line; nothing is copied or allocated until the caller asks with
+ * janos_span_copy() or csv_field_copy(). A parser that returns false has
+ * left its result in an unspecified state.
+ *
+ * Lines come from the UART handler without their line ending; a trailing
+ * CR or LF is tolerated and never part of a span.
+ */
+
+#ifndef JANOS_PROTO_H
+#define JANOS_PROTO_H
+
+#include "csv_parser.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define JANOS_DEAUTH_MARKER     "[DEAUTH] CH: "
+#define JANOS_HANDSHAKE_MARKER  "Complete 4-way handshake saved for SSID: "
+#define JANOS_DOG_MARKER        "[SnifferDog #"
+#define JANOS_RSSI_NONE         INT16_MIN       // Row without an RSSI
+
+// Text inside a line (not NUL terminated)
+typedef struct {
+    const char *ptr;
+    size_t len;
+} janos_span_t;
+
+/**
+ * Scan result (scan_networks, show_scan_results):
+ * "1","SSID","","AA:BB:CC:DD:EE:FF","6","WPA2","-45","2.4GHz"
+ */
+typedef struct {
+    int id;
+    csv_field_t ssid;           // May hold escaped quotes
+    csv_field_t bssid;
+    int channel;
+    csv_field_t security;
+    int rssi;
+    csv_field_t band;
+} janos_scan_row_t;
+
+/**
+ * Deauth detector report:
+ * "[DEAUTH] CH: 6 | AP: Name (AA:BB:CC:DD:EE:FF) | RSSI: -60"
+ */
+typedef struct {
+    int channel;
+    janos_span_t ap_name;
+    uint64_t bssid;             // Packed as mac_set keys are
+    int rssi;
+} janos_deauth_t;
+
+/**
+ * BT device (scan_bt list or a single tracked target):
+ * "  1. AA:BB:CC:DD:EE:FF  RSSI: -82 dBm  Name: Foo"
+ * "AA:BB:CC:DD:EE:FF  RSSI: -93 dBm"
+ */
+typedef struct {
+    int index;                  // Row number, -1 for an unnumbered row
+    uint64_t mac;
+    const char *mac_text;       // The 17 MAC characters in the line
+    int rssi;                   // JANOS_RSSI_NONE if the row has none
+    janos_span_t name;          // Empty if the row has none
+} janos_bt_row_t;
+
+/**
+ * Directory listing row (list_sd, list_dir): "12 portal.html"
+ */
+typedef struct {
+    int id;
+    janos_span_t name;          // Trailing whitespace trimmed
+} janos_list_row_t;
+
+/**
+ * ARP host (list_hosts_vendor):
+ * "192.168.4.1  ->  C4:2B:44:12:29:15 [Huawei Device Co., Ltd.]"
+ */
+typedef struct {
+    uint32_t ip;                // Host order, first octet in the top byte
+    uint64_t mac;
+    janos_span_t vendor;        // Bracketed vendor, empty if none
+} janos_arp_host_t;
+
+/**
+ * Capture summary (hs_info), one per .pcap:
+ * "AX3_2.4_12291C_79868.pcap","AX3_2.4","AA:BB:CC:12:29:1C","1234","0","1186","1739550000"
+ * Fields: file name, SSID, BSSID (may be empty), EAPOL messages present
+ * as digits, PMKID 0/1, size in bytes, modification time (Unix seconds,
+ * 0 if the card's clock was never set).
+ */
+typedef struct {
+    csv_field_t name;
+    csv_field_t ssid;           // May hold escaped quotes
+    uint64_t bssid;             // 0 if the field is empty
+    uint8_t eapol;              // Bit n-1 set for EAPOL message n
+    bool pmkid;
+    uint32_t bytes;
+    uint32_t mtime;
+} janos_capture_row_t;
+
+/**
+ * Handshake saved during start_handshake:
+ * "Complete 4-way handshake saved for SSID: AX3_2.4 (MAC: 12291C, message_pair: 2)"
+ * Older JanOS ends the line after the SSID.
+ */
+typedef struct {
+    janos_span_t ssid;          // May contain spaces
+    bool has_mac;
+    uint32_t mac_tail;          // Last three BSSID octets, as JanOS names files
+    int message_pair;           // hashcat message_pair, -1 if not given
+} janos_handshake_t;
+
+/**
+ * Sniffer Dog kick (start_sniffer_dog):
+ * "[SnifferDog #2] DEAUTH sent: AP=30:AA:E4:3C:3F:64 -> STA=A6:02:A5:BA:DA:AB (Ch=1, RSSI=-69)"
+ */
+typedef struct {
+    int count;                  // Kicks since the mode started
+    uint64_t ap;
+    uint64_t sta;
+    int channel;                // 0 if not given
+    int rssi;                   // JANOS_RSSI_NONE if not given
+} janos_dog_kick_t;
+
+/**
+ * @brief Parse "AA:BB:CC:DD:EE:FF" (':' or '-' separators, any case)
+ * @param text MAC after optional spaces; more text may follow
+ * @param mac Receives the MAC packed first octet high
+ * @return false if the 17 characters are not a MAC
+ */
+bool janos_parse_mac(const char *text, uint64_t *mac);
+
+bool janos_parse_scan_row(const char *line, janos_scan_row_t *out);
+
+/**
+ * @brief Parse a deauth report
+ * @param line Line containing JANOS_DEAUTH_MARKER anywhere
+ */
+bool janos_parse_deauth(const char *line, janos_deauth_t *out);
+
+bool janos_parse_bt_row(const char *line, janos_bt_row_t *out);
+
+/**
+ * @brief Parse a listing row: number, at least one space, non-empty name
+ */
+bool janos_parse_list_row(const char *line, janos_list_row_t *out);
+
+bool janos_parse_arp_host(const char *line, janos_arp_host_t *out);
+
+bool janos_parse_capture_row(const char *line, janos_capture_row_t *out);
+
+/**
+ * @brief Parse a handshake report
+ * @param line Line containing JANOS_HANDSHAKE_MARKER anywhere
+ */
+bool janos_parse_handshake(const char *line, janos_handshake_t *out);
+
+/**
+ * @brief Parse a Sniffer Dog kick
+ * @param line Line containing JANOS_DOG_MARKER anywhere
+ */
+bool janos_parse_dog_kick(const char *line, janos_dog_kick_t *out);
+
+/**
+ * @brief Copy a span into a buffer, truncating
+ * @param dst_size Destination size (always NUL terminated if > 0)
+ * @return Number of characters written (excluding NUL)
+ */
+size_t janos_span_copy(janos_span_t span, char *dst, size_t dst_size);
+
+#endif // JANOS_PROTO_H
@@ -0,0 +1,325 @@
+/**
+ * @file janos_proto.c
+ * @brief Parsers for the JanOS text output lines
+ *
+ * Every scan stops at the line's NUL, whatever the input, so the parsers
+ * are safe on truncated or corrupted lines (host/fuzz_janos_proto.c).
+ */
+
+#include "janos_proto.h"
+#include <string.h>
+
+#define SCAN_FIELDS     8
+#define CAPTURE_FIELDS  7
+#define INT_DIGITS_MAX  9       // Longer numbers saturate instead of overflowing
+
+static inline bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static int hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static const char *skip_spaces(const char *p)
+{
+    while (*p == ' ' || *p == '\t') p++;
+    return p;
+}
+
+/**
+ * @brief Decimal integer as atoi reads it, saturating
+ * @param end Receives the first character after the digits (NULL to ignore)
+ */
+static int parse_int(const char *p, const char **end)
+{
+    p = skip_spaces(p);
+    bool negative = false;
+    if (*p == '-' || *p == '+') {
+        negative = *p == '-';
+        p++;
+    }
+    int value = 0;
+    int digits = 0;
+    while (is_digit(*p)) {
+        if (digits++ < INT_DIGITS_MAX) value = value * 10 + (*p - '0');
+        p++;
+    }
+    if (end) *end = p;
+    return negative ? -value : value;
+}
+
+/**
+ * @brief Unsigned decimal field, saturating at UINT32_MAX
+ */
+static uint32_t field_to_u32(const csv_field_t *field)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < field->len && is_digit(field->ptr[i]); i++) {
+        value = value * 10 + (uint64_t)(field->ptr[i] - '0');
+        if (value > UINT32_MAX) return UINT32_MAX;
+    }
+    return (uint32_t)value;
+}
+
+/**
+ * @brief Span from p to the end of the line, trailing whitespace trimmed
+ */
+static janos_span_t rest_of_line(const char *p)
+{
+    janos_span_t span = { p, strlen(p) };
+    while (span.len > 0 && is_space(p[span.len - 1])) span.len--;
+    return span;
+}
+
+bool janos_parse_mac(const char *text, uint64_t *mac)
+{
+    if (!text) return false;
+    text = skip_spaces(text);
+
+    uint64_t value = 0;
+    for (int i = 0; i < 17; i++) {
+        char c = text[i];
+        if (i % 3 == 2) {
+            if (c != ':' && c != '-') return false;
+            continue;
+        }
+        int nibble = hex_nibble(c);
+        if (nibble < 0) return false;
+        value = (value << 4) | (uint64_t)nibble;
+    }
+    *mac = value;
+    return true;
+}
+
+bool janos_parse_scan_row(const char *line, janos_scan_row_t *out)
+{
+    if (!line || line[0] != '"') return false;
+
+    csv_field_t fields[SCAN_FIELDS];
+    if (csv_split(line, fields, SCAN_FIELDS) < SCAN_FIELDS) return false;
+
+    out->id = csv_field_to_int(&fields[0]);
+    out->ssid = fields[1];
+    // fields[2] is always empty
+    out->bssid = fields[3];
+    out->channel = csv_field_to_int(&fields[4]);
+    out->security = fields[5];
+    out->rssi = csv_field_to_int(&fields[6]);
+    out->band = fields[7];
+    while (out->band.len > 0 && is_space(out->band.ptr[out->band.len - 1])) out->band.len--;
+    return true;
+}
+
+bool janos_parse_deauth(const char *line, janos_deauth_t *out)
+{
+    const char *p = line ? strstr(line, JANOS_DEAUTH_MARKER) : NULL;
+    if (!p) return false;
+    out->channel = parse_int(p + strlen(JANOS_DEAUTH_MARKER), NULL);
+
+    const char *ap = strstr(p, " | AP: ");
+    if (!ap) return false;
+    ap += strlen(" | AP: ");
+
+    // The first " (" ends the name; the BSSID is inside the parentheses
+    const char *bssid = strstr(ap, " (");
+    if (!bssid) return false;
+    out->ap_name.ptr = ap;
+    out->ap_name.len = (size_t)(bssid - ap);
+    if (!janos_parse_mac(bssid + 2, &out->bssid)) return false;
+
+    const char *rssi = strstr(bssid, " | RSSI: ");
+    if (!rssi) return false;
+    out->rssi = parse_int(rssi + strlen(" | RSSI: "), NULL);
+    return true;
+}
+
+bool janos_parse_bt_row(const char *line, janos_bt_row_t *out)
+{
+    if (!line) return false;
+    const char *p = skip_spaces(line);
+
+    // Optional "N. " row number
+    out->index = -1;
+    if (is_digit(*p)) {
+        const char *end;
+        out->index = parse_int(p, &end);
+        if (*end != '.') return false;
+        p = skip_spaces(end + 1);
+    }
+
+    if (!janos_parse_mac(p, &out->mac)) return false;
+    out->mac_text = p;
+    const char *after = p + 17;
+
+    const char *rssi = strstr(after, "RSSI: ");
+    out->rssi = rssi ? parse_int(rssi + strlen("RSSI: "), NULL) : JANOS_RSSI_NONE;
+
+    const char *name = strstr(after, "Name: ");
+    if (name) {
+        out->name = rest_of_line(name + strlen("Name: "));
+    } else {
+        out->name.ptr = after;
+        out->name.len = 0;
+    }
+    return true;
+}
+
+bool janos_parse_list_row(const char *line, janos_list_row_t *out)
+{
+    if (!line) return false;
+    const char *p = line;
+    while (is_space(*p)) p++;
+    if (!is_digit(*p)) return false;
+
+    const char *end;
+    out->id = parse_int(p, &end);
+    if (*end != ' ' && *end != '\t') return false;
+
+    out->name = rest_of_line(skip_spaces(end));
+    return out->name.len > 0;
+}
+
+bool janos_parse_arp_host(const char *line, janos_arp_host_t *out)
+{
+    const char *arrow = line ? strstr(line, "->") : NULL;
+    if (!arrow) return false;
+
+    const char *p = line;
+    while (is_space(*p)) p++;
+    uint32_t ip = 0;
+    for (int octet = 0; octet < 4; octet++) {
+        if (octet > 0 && *p++ != '.') return false;
+        if (!is_digit(*p)) return false;
+        int value = 0;
+        for (int digits = 0; is_digit(*p); digits++, p++) {
+            if (digits == 3) return false;
+            value = value * 10 + (*p - '0');
+        }
+        if (value > 255) return false;
+        ip = (ip << 8) | (uint32_t)value;
+    }
+    out->ip = ip;
+
+    const char *mac = skip_spaces(arrow + 2);
+    if (!janos_parse_mac(mac, &out->mac)) return false;
+
+    out->vendor.ptr = mac + 17;
+    out->vendor.len = 0;
+    const char *open = strchr(mac + 17, '[');
+    if (open) {
+        const char *close = strchr(open + 1, ']');
+        if (close) {
+            out->vendor.ptr = open + 1;
+            out->vendor.len = (size_t)(close - open - 1);
+        }
+    }
+    return true;
+}
+
+bool janos_parse_capture_row(const char *line, janos_capture_row_t *out)
+{
+    if (!line || line[0] != '"') return false;
+
+    csv_field_t fields[CAPTURE_FIELDS];
+    if (csv_split(line, fields, CAPTURE_FIELDS) < CAPTURE_FIELDS) return false;
+    if (fields[0].len == 0) return false;
+
+    out->name = fields[0];
+    out->ssid = fields[1];
+    out->bssid = 0;
+    if (fields[2].len > 0) {
+        // csv_split stops at the field's end quote, so 17 characters fit
+        if (fields[2].len != 17 || !janos_parse_mac(fields[2].ptr, &out->bssid)) return false;
+    }
+    out->eapol = 0;
+    for (size_t i = 0; i < fields[3].len; i++) {
+        char c = fields[3].ptr[i];
+        if (c < '1' || c > '4') return false;
+        out->eapol |= (uint8_t)(1u << (c - '1'));
+    }
+    out->pmkid = fields[4].len > 0 && fields[4].ptr[0] == '1';
+    out->bytes = field_to_u32(&fields[5]);
+    out->mtime = field_to_u32(&fields[6]);
+    return true;
+}
+
+bool janos_parse_handshake(const char *line, janos_handshake_t *out)
+{
+    const char *p = line ? strstr(line, JANOS_HANDSHAKE_MARKER) : NULL;
+    if (!p) return false;
+    p += strlen(JANOS_HANDSHAKE_MARKER);
+
+    out->has_mac = false;
+    out->mac_tail = 0;
+    out->message_pair = -1;
+
+    // The last " (MAC: " ends the SSID, which may itself hold " ("
+    const char *details = NULL;
+    for (const char *q = strstr(p, " (MAC: "); q; q = strstr(q + 1, " (MAC: ")) details = q;
+    if (!details) {
+        out->ssid = rest_of_line(p);
+        return out->ssid.len > 0;
+    }
+    out->ssid.ptr = p;
+    out->ssid.len = (size_t)(details - p);
+    if (out->ssid.len == 0) return false;
+
+    const char *mac = details + strlen(" (MAC: ");
+    uint32_t tail = 0;
+    int digits = 0;
+    for (; digits < 6; digits++) {
+        int nibble = hex_nibble(mac[digits]);
+        if (nibble < 0) break;
+        tail = (tail << 4) | (uint32_t)nibble;
+    }
+    if (digits == 6) {
+        out->has_mac = true;
+        out->mac_tail = tail;
+    }
+
+    const char *pair = strstr(mac, "message_pair: ");
+    if (pair && is_digit(pair[strlen("message_pair: ")])) {
+        out->message_pair = parse_int(pair + strlen("message_pair: "), NULL);
+    }
+    return true;
+}
+
+bool janos_parse_dog_kick(const char *line, janos_dog_kick_t *out)
+{
+    const char *p = line ? strstr(line, JANOS_DOG_MARKER) : NULL;
+    if (!p) return false;
+    const char *end;
+    out->count = parse_int(p + strlen(JANOS_DOG_MARKER), &end);
+    if (end[0] != ']' || out->count <= 0) return false;
+
+    const char *ap = strstr(end, "AP=");
+    if (!ap || !janos_parse_mac(ap + 3, &out->ap)) return false;
+    const char *sta = strstr(ap, "STA=");
+    if (!sta || !janos_parse_mac(sta + 4, &out->sta)) return false;
+
+    const char *channel = strstr(sta, "Ch=");
+    out->channel = channel ? parse_int(channel + 3, NULL) : 0;
+    const char *rssi = strstr(sta, "RSSI=");
+    out->rssi = rssi ? parse_int(rssi + 5, NULL) : JANOS_RSSI_NONE;
+    return true;
+}
+
+size_t janos_span_copy(janos_span_t span, char *dst, size_t dst_size)
+{
+    if (!dst || dst_size == 0) return 0;
+    size_t n = span.len < dst_size - 1 ? span.len : dst_size - 1;
+    if (n > 0) memcpy(dst, span.ptr, n);
+    dst[n] = '\0';
+    return n;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file app_events.c
+ * @brief Wake-up events for the main UI loop
+ */
+
+#include "app_events.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+static const char *TAG = "APP_EVENTS";
+
+static QueueHandle_t event_queue = NULL;
+
+// Bit per event type queued and not yet taken by app_events_wait
+static volatile uint32_t pending_mask = 0;
+static portMUX_TYPE pending_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t app_events_init(void)
+{
+    if (event_queue) return ESP_OK;
+    
+    event_queue = xQueueCreate(APP_EVENT_QUEUE_LEN, sizeof(uint8_t));
+    if (!event_queue) {
+        ESP_LOGE(TAG, "Failed to create event queue");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void app_events_post(app_event_t event)
+{
+    if (!event_queue || event <= APP_EVENT_NONE || event >= APP_EVENT_COUNT) return;
+    
+    uint32_t bit = 1u << event;
+    portENTER_CRITICAL(&pending_lock);
+    bool queued = pending_mask & bit;
+    pending_mask |= bit;
+    portEXIT_CRITICAL(&pending_lock);
+    if (queued) return;
+    
+    uint8_t item = event;
+    if (xQueueSend(event_queue, &item, 0) != pdTRUE) {
+        portENTER_CRITICAL(&pending_lock);
+        pending_mask &= ~bit;
+        portEXIT_CRITICAL(&pending_lock);
+    }
+}
+
+void IRAM_ATTR app_events_post_from_isr(app_event_t event)
+{
+    if (!event_queue || event <= APP_EVENT_NONE || event >= APP_EVENT_COUNT) return;
+    
+    uint32_t bit = 1u << event;
+    portENTER_CRITICAL_ISR(&pending_lock);
+    bool queued = pending_mask & bit;
+    pending_mask |= bit;
+    portEXIT_CRITICAL_ISR(&pending_lock);
+    if (queued) return;
+    
+    uint8_t item = event;
+    BaseType_t woken = pdFALSE;
+    if (xQueueSendFromISR(event_queue, &item, &woken) != pdTRUE) {
+        portENTER_CRITICAL_ISR(&pending_lock);
+        pending_mask &= ~bit;
+        portEXIT_CRITICAL_ISR(&pending_lock);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+app_event_t app_events_wait(uint32_t timeout_ms)
+{
+    if (!event_queue) {
+        vTaskDelay(pdMS_TO_TICKS(timeout_ms));
+        return APP_EVENT_NONE;
+    }
+    
+    uint8_t item;
+    TickType_t ticks = pdMS_TO_TICKS(timeout_ms);
+    if (timeout_ms > 0 && ticks == 0) ticks = 1;
+    if (xQueueReceive(event_queue, &item, ticks) != pdTRUE) {
+        return APP_EVENT_NONE;
+    }
+    
+    // Clear before handling so events arriving meanwhile wake us again
+    portENTER_CRITICAL(&pending_lock);
+    pending_mask &= ~(1u << item);
+    portEXIT_CRITICAL(&pending_lock);
+    return (app_event_t)item;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file app_events.h
+ * @brief Wake-up events for the main UI loop
+ *
+ * Key interrupts, UART lines and timers post events here and the main
+ * loop sleeps on the queue until one arrives or the current screen's next
+ * tick is due. Each event type is queued at most once until the loop has
+ * taken it, so a burst of UART lines costs a single wake-up.
+ */
+
+#ifndef APP_EVENTS_H
+#define APP_EVENTS_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define APP_EVENT_QUEUE_LEN     8
+
+typedef enum {
+    APP_EVENT_NONE = 0,     // Wait timed out
+    APP_EVENT_KEY,          // Keyboard controller has pending key events
+    APP_EVENT_UART,         // One or more UART lines were dispatched
+    APP_EVENT_TIMER,        // A timer asks for the current screen's tick now
+    APP_EVENT_PROGRESS,     // An operation published progress (uart_progress.h)
+    APP_EVENT_COUNT
+} app_event_t;
+
+/**
+ * @brief Create the event queue
+ * @return ESP_OK on success
+ */
+esp_err_t app_events_init(void);
+
+/**
+ * @brief Post an event from task context
+ * @param event Event type
+ */
+void app_events_post(app_event_t event);
+
+/**
+ * @brief Post an event from an interrupt handler
+ * @param event Event type
+ */
+void app_events_post_from_isr(app_event_t event);
+
+/**
+ * @brief Wait for the next event
+ * @param timeout_ms Longest time to sleep
+ * @return Event taken, or APP_EVENT_NONE on timeout
+ */
+app_event_t app_events_wait(uint32_t timeout_ms);
+
+#endif // APP_EVENTS_H
@@ -0,0 +1,134 @@
+/**
+ * @file assets.c
+ * @brief Read-only asset bundle mapped from the "assets" flash partition
+ */
+
+#include "assets.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+static const char *TAG = "ASSETS";
+
+static const uint8_t *bundle = NULL;
+static const assets_entry_t *entries = NULL;
+static uint16_t entry_count = 0;
+static uint32_t bundle_version = 0;
+
+/**
+ * @brief Check that the directory points inside the bundle and is sorted
+ */
+static bool directory_valid(const assets_entry_t *dir, int count, uint32_t total_size)
+{
+    for (int i = 0; i < count; i++) {
+        const assets_entry_t *e = &dir[i];
+        if (e->name[ASSETS_NAME_LEN - 1] != '\0' || !e->name[0]) return false;
+        if ((e->offset & 3) || e->offset > total_size || e->size > total_size - e->offset) {
+            return false;
+        }
+        if (i > 0 && strcmp(dir[i - 1].name, e->name) >= 0) return false;
+    }
+    return true;
+}
+
+esp_err_t assets_init(void)
+{
+    if (bundle) return ESP_OK;
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY,
+                                                           ASSETS_PARTITION_LABEL);
+    if (!part) {
+        ESP_LOGW(TAG, "No \"%s\" partition, using built-in assets", ASSETS_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    assets_header_t header;
+    esp_err_t ret = esp_partition_read(part, 0, &header, sizeof(header));
+    if (ret != ESP_OK) return ret;
+    if (header.magic != ASSETS_MAGIC) {
+        // Erased flash reads 0xFF: nothing was written yet
+        ESP_LOGI(TAG, "Asset partition is empty, using built-in assets");
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (header.format != ASSETS_FORMAT_VERSION) {
+        ESP_LOGW(TAG, "Asset bundle format %u not supported (want %u)",
+                 header.format, ASSETS_FORMAT_VERSION);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    uint32_t dir_end = sizeof(header) + (uint32_t)header.entry_count * sizeof(assets_entry_t);
+    if (header.total_size < dir_end || header.total_size > part->size) {
+        ESP_LOGW(TAG, "Asset bundle size %lu does not fit the partition",
+                 (unsigned long)header.total_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const void *mapped = NULL;
+    esp_partition_mmap_handle_t handle;
+    ret = esp_partition_mmap(part, 0, header.total_size, ESP_PARTITION_MMAP_DATA, &mapped, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map asset partition: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    const uint8_t *base = mapped;
+    const assets_entry_t *dir = (const assets_entry_t *)(base + sizeof(header));
+
+#ifdef CONFIG_ASSETS_VERIFY_CRC
+    uint32_t crc = esp_rom_crc32_le(0, base + sizeof(header), header.total_size - sizeof(header));
+    if (crc != header.crc32) {
+        ESP_LOGW(TAG, "Asset bundle checksum mismatch (%08lx, header %08lx)",
+                 (unsigned long)crc, (unsigned long)header.crc32);
+        esp_partition_munmap(handle);
+        return ESP_ERR_INVALID_CRC;
+    }
+#endif
+    if (!directory_valid(dir, header.entry_count, header.total_size)) {
+        ESP_LOGW(TAG, "Asset bundle directory is corrupt");
+        esp_partition_munmap(handle);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Mapped for the lifetime of the firmware; handle is never released
+    entries = dir;
+    entry_count = header.entry_count;
+    bundle_version = header.bundle_version;
+    bundle = base;
+    ESP_LOGI(TAG, "Asset bundle r%lu: %u entries, %lu bytes at 0x%lx",
+             (unsigned long)bundle_version, entry_count,
+             (unsigned long)header.total_size, (unsigned long)part->address);
+    return ESP_OK;
+}
+
+bool assets_available(void)
+{
+    return bundle != NULL;
+}
+
+uint32_t assets_bundle_version(void)
+{
+    return bundle ? bundle_version : 0;
+}
+
+const void *assets_find(const char *name, size_t *size)
+{
+    if (!bundle || !name) return NULL;
+
+    int lo = 0;
+    int hi = (int)entry_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strcmp(entries[mid].name, name);
+        if (cmp == 0) {
+            if (size) *size = entries[mid].size;
+            return bundle + entries[mid].offset;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,113 @@
+/**
+ * @file assets.h
+ * @brief Read-only asset bundle mapped from the "assets" flash partition
+ *
+ * Large constant data (the full OUI registry, alert sounds, fonts, portal
+ * metadata) is kept in a data partition, built by tools/gen_assets.py and
+ * flashed separately from the app, so it can be refreshed without a
+ * firmware rebuild:
+ *
+ *   parttool.py write_partition --partition-name assets --input assets.bin
+ *
+ * The partition is memory mapped once at boot and entries are used in
+ * place; nothing is copied to RAM. Consumers fall back to their compiled
+ * defaults when the partition is blank, holds an unknown format or fails
+ * its checksum.
+ *
+ * Layout (little-endian, every offset from the start of the bundle):
+ *
+ *   assets_header_t                     32 bytes
+ *   assets_entry_t[entry_count]         32 bytes each, sorted by name
+ *   entry data                          4-byte aligned
+ */
+
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ASSETS_PARTITION_LABEL  "assets"
+#define ASSETS_MAGIC            0x4243534DUL      // "MSCB"
+#define ASSETS_FORMAT_VERSION   1
+#define ASSETS_NAME_LEN         24
+
+typedef struct {
+    uint32_t magic;
+    uint16_t format;            // ASSETS_FORMAT_VERSION
+    uint16_t entry_count;
+    uint32_t bundle_version;    // Content revision, set by the builder
+    uint32_t total_size;        // Header, directory and data
+    uint32_t crc32;             // esp_rom_crc32_le(0, ...) of the bytes after the header
+    uint8_t reserved[12];
+} assets_header_t;
+
+typedef struct {
+    char name[ASSETS_NAME_LEN]; // NUL-padded, e.g. "oui", "snd/attack"
+    uint32_t offset;
+    uint32_t size;
+} assets_entry_t;
+
+_Static_assert(sizeof(assets_header_t) == 32, "assets header layout");
+_Static_assert(sizeof(assets_entry_t) == 32, "assets entry layout");
+
+// "oui": the tables of oui_table.c, offsets relative to this header
+typedef struct {
+    uint32_t count;             // Prefixes
+    uint32_t vendors;
+    uint32_t prefixes_offset;   // uint8_t[count][3], sorted
+    uint32_t ids_offset;        // uint16_t[count]
+    uint32_t offsets_offset;    // uint32_t[vendors], into the pool
+    uint32_t pool_offset;       // NUL-terminated names
+} assets_oui_t;
+
+// "snd/<name>": buzzer sample, data follows the header
+typedef struct {
+    uint32_t frames;
+    uint16_t rate_hz;
+    uint8_t format;             // buzzer_sample_format_t
+    uint8_t reserved;
+} assets_sound_t;
+
+// "icon/<name>": sprite (sprite.h), data follows the header
+typedef struct {
+    uint8_t width;
+    uint8_t height;
+    uint8_t format;             // sprite_format_t
+    uint8_t reserved;
+    uint16_t key;               // SPRITE_RLE565 transparent color
+    uint16_t reserved2;
+} assets_sprite_t;
+
+/**
+ * @brief Map and validate the asset partition
+ *
+ * Safe to call again; a missing or invalid bundle is logged and leaves
+ * every lookup returning NULL.
+ * @return ESP_OK with a valid bundle, ESP_ERR_NOT_FOUND without partition
+ *         or bundle, ESP_ERR_INVALID_VERSION / ESP_ERR_INVALID_CRC when
+ *         the bundle is rejected
+ */
+esp_err_t assets_init(void);
+
+/**
+ * @brief Whether a bundle is mapped
+ */
+bool assets_available(void);
+
+/**
+ * @brief Content revision of the mapped bundle, 0 without one
+ */
+uint32_t assets_bundle_version(void);
+
+/**
+ * @brief Find an entry by name
+ * @param name Entry name
+ * @param size Receives the entry size (may be NULL)
+ * @return Entry data in mapped flash (valid forever), or NULL
+ */
+const void *assets_find(const char *name, size_t *size);
+
+#endif // ASSETS_H
@@ -0,0 +1,152 @@
+/**
+ * @file board_cache.c
+ * @brief What the JanOS board answered last boot, kept in NVS
+ *
+ * Stored as one blob with a version and size, appended to like the
+ * settings blob. Answers change at most a few times per boot, so each
+ * change is written straight away.
+ */
+
+#include "board_cache.h"
+#include "nvs.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stddef.h>
+#include <string.h>
+
+static const char *TAG = "BOARD_CACHE";
+
+#define NVS_NAMESPACE       "board"
+#define NVS_KEY_BLOB        "blob"
+#define CACHE_VERSION       1
+#define CACHE_BLOB_MAX      64      // Largest blob read back, newer fields included
+
+// Stored layout; append new fields at the end only
+typedef struct {
+    uint16_t version;
+    uint16_t size;
+    uint32_t baud_ceiling;      // Lowest rate that failed its check, 0 = none
+    uint8_t caps;               // BOARD_CAP_* JanOS acknowledged
+    uint8_t refused;            // BOARD_CAP_* it did not
+    uint8_t sd;                 // board_sd_state_t
+    uint8_t boots;              // Since everything was last offered
+} board_blob_t;
+
+static board_blob_t cache = {
+    .version = CACHE_VERSION,
+    .size = sizeof(board_blob_t),
+};
+static bool recheck = true;     // Offer everything this boot
+static SemaphoreHandle_t cache_mutex = NULL;
+
+/**
+ * @brief Write the cache (cache_mutex held)
+ */
+static void save(void)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(handle, NVS_KEY_BLOB, &cache, sizeof(cache));
+        if (ret == ESP_OK) ret = nvs_commit(handle);
+        nvs_close(handle);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Board cache not saved: %s", esp_err_to_name(ret));
+    }
+}
+
+esp_err_t board_cache_init(void)
+{
+    if (cache_mutex) return ESP_OK;
+    cache_mutex = xSemaphoreCreateMutex();
+    if (!cache_mutex) return ESP_ERR_NO_MEM;
+
+    uint8_t buf[CACHE_BLOB_MAX];
+    size_t len = sizeof(buf);
+    nvs_handle_t handle;
+    bool found = false;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        found = nvs_get_blob(handle, NVS_KEY_BLOB, buf, &len) == ESP_OK &&
+                len >= offsetof(board_blob_t, baud_ceiling);
+        nvs_close(handle);
+    }
+
+    if (found) {
+        memcpy(&cache, buf, len < sizeof(cache) ? len : sizeof(cache));
+        cache.version = CACHE_VERSION;
+        cache.size = sizeof(board_blob_t);
+        if (cache.sd > BOARD_SD_MISSING) cache.sd = BOARD_SD_UNKNOWN;
+
+        recheck = ++cache.boots >= BOARD_CACHE_RECHECK_BOOTS;
+        if (recheck) cache.boots = 0;
+        ESP_LOGI(TAG, "Board last took 0x%02x, refused 0x%02x, SD %d%s",
+                 cache.caps, cache.refused, cache.sd, recheck ? " (rechecking)" : "");
+    }
+
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    save();
+    xSemaphoreGive(cache_mutex);
+    return ESP_OK;
+}
+
+bool board_cache_skip(uint8_t cap)
+{
+    return !recheck && (cache.refused & cap);
+}
+
+void board_cache_note(uint8_t cap, bool accepted)
+{
+    if (!cache_mutex) return;
+
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    uint8_t caps = accepted ? (cache.caps | cap) : (cache.caps & ~cap);
+    uint8_t refused = accepted ? (cache.refused & ~cap) : (cache.refused | cap);
+    if (caps != cache.caps || refused != cache.refused) {
+        cache.caps = caps;
+        cache.refused = refused;
+        save();
+    }
+    xSemaphoreGive(cache_mutex);
+}
+
+uint32_t board_cache_baud_ceiling(void)
+{
+    return recheck ? 0 : cache.baud_ceiling;
+}
+
+void board_cache_note_baud(uint32_t baud, bool ok)
+{
+    if (!cache_mutex) return;
+
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    uint32_t ceiling = cache.baud_ceiling;
+    if (ok && ceiling && baud >= ceiling) {
+        ceiling = 0;
+    } else if (!ok && (!ceiling || baud < ceiling)) {
+        ceiling = baud;
+    }
+    if (ceiling != cache.baud_ceiling) {
+        cache.baud_ceiling = ceiling;
+        save();
+    }
+    xSemaphoreGive(cache_mutex);
+}
+
+board_sd_state_t board_cache_sd(void)
+{
+    return (board_sd_state_t)cache.sd;
+}
+
+void board_cache_set_sd(board_sd_state_t sd)
+{
+    if (!cache_mutex) return;
+
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    if (cache.sd != sd) {
+        cache.sd = (uint8_t)sd;
+        save();
+    }
+    xSemaphoreGive(cache_mutex);
+}
@@ -0,0 +1,81 @@
+/**
+ * @file board_cache.h
+ * @brief What the JanOS board answered last boot, kept in NVS
+ *
+ * The boot probe negotiates link options one request at a time: each
+ * offer JanOS does not acknowledge costs its full timeout, a baud step
+ * that fails its check costs UART_BAUD_REVERT_MS, and the board's SD card
+ * is only known after list_sd has had its say. The answers rarely change
+ * between boots, so they are cached here and used before the board is
+ * asked again:
+ *
+ * - Offers JanOS refused (binary framing, credits, compressed bulk) are
+ *   not made again, and the ladder stops below the first baud rate that
+ *   failed. Every BOARD_CACHE_RECHECK_BOOTS boots everything is offered
+ *   again, so updated JanOS firmware is picked up. The fastest rate that
+ *   worked is kept by settings (settings_get_uart_baud()).
+ * - The SD state gates board-card features from the first frame; the
+ *   boot probe verifies it in the background and updates the cache.
+ *
+ * JanOS has no version query, so what identifies a board here is the set
+ * of offers it takes; a different board shows up as different answers.
+ */
+
+#ifndef BOARD_CACHE_H
+#define BOARD_CACHE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BOARD_CACHE_RECHECK_BOOTS   16
+
+// Link options offered to JanOS
+#define BOARD_CAP_BINARY        0x01    // "proto binary"
+#define BOARD_CAP_CREDITS       0x02    // "proto credit"
+#define BOARD_CAP_BULK          0x04    // "proto lz4"
+#define BOARD_CAP_QUIET         0x08    // "proto quiet"
+
+typedef enum {
+    BOARD_SD_UNKNOWN = 0,       // Never checked
+    BOARD_SD_PRESENT,
+    BOARD_SD_MISSING,
+} board_sd_state_t;
+
+/**
+ * @brief Load the cache (after settings_init(), which brings up NVS)
+ * @return ESP_OK, also when nothing was cached yet
+ */
+esp_err_t board_cache_init(void);
+
+/**
+ * @brief Whether an offer can be left out this boot
+ * @param cap One BOARD_CAP_*
+ * @return true if JanOS refused it last time and this is not a recheck boot
+ */
+bool board_cache_skip(uint8_t cap);
+
+/**
+ * @brief Record JanOS's answer to an offer
+ */
+void board_cache_note(uint8_t cap, bool accepted);
+
+/**
+ * @brief Lowest baud rate that failed its link check
+ * @return Rate not to try this boot, 0 = climb the whole ladder
+ */
+uint32_t board_cache_baud_ceiling(void);
+
+/**
+ * @brief Record the result of a baud step
+ */
+void board_cache_note_baud(uint32_t baud, bool ok);
+
+/**
+ * @brief Board SD state found by the last check
+ */
+board_sd_state_t board_cache_sd(void);
+
+void board_cache_set_sd(board_sd_state_t sd);
+
+#endif // BOARD_CACHE_H
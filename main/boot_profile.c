@@ -0,0 +1,95 @@
+/**
+ * @file boot_profile.c
+ * @brief Per-phase boot timestamps for startup latency tracking
+ */
+
+#include "boot_profile.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "BOOT";
+
+static const char *phase_names[BOOT_PHASE_COUNT] = {
+    [BOOT_PHASE_NVS]         = "NVS",
+    [BOOT_PHASE_DISPLAY]     = "Disp",
+    [BOOT_PHASE_BATTERY]     = "Batt",
+    [BOOT_PHASE_SD]          = "SD",
+    [BOOT_PHASE_KEYBOARD]    = "Keys",
+    [BOOT_PHASE_UART]        = "UART",
+    [BOOT_PHASE_BOARD_PING]  = "Ping",
+    [BOOT_PHASE_BUZZER]      = "Buzz",
+    [BOOT_PHASE_FIRST_FRAME] = "Frame",
+};
+
+static boot_phase_info_t phases[BOOT_PHASE_COUNT];
+static int phases_ended = 0;
+static portMUX_TYPE profile_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void log_summary(void)
+{
+    char line[160];
+    int len = 0;
+    
+    for (int i = 0; i < BOOT_PHASE_COUNT && len < (int)sizeof(line); i++) {
+        const boot_phase_info_t *p = &phases[i];
+        len += snprintf(line + len, sizeof(line) - len, "%s%s %lu%s",
+                        i ? " " : "", phase_names[i],
+                        (unsigned long)((p->end_us - p->start_us) / 1000),
+                        p->ok ? "" : "!");
+    }
+    ESP_LOGI(TAG, "Boot ms: %s | interactive %ld", line,
+             (long)boot_profile_interactive_ms());
+}
+
+void boot_profile_begin(boot_phase_t phase)
+{
+    if (phase >= BOOT_PHASE_COUNT) return;
+    phases[phase].start_us = esp_timer_get_time();
+}
+
+void boot_profile_end(boot_phase_t phase, bool ok)
+{
+    if (phase >= BOOT_PHASE_COUNT) return;
+    
+    int64_t now = esp_timer_get_time();
+    bool all_done = false;
+    portENTER_CRITICAL(&profile_lock);
+    if (phases[phase].end_us == 0) {
+        if (phases[phase].start_us == 0) phases[phase].start_us = now;
+        phases[phase].end_us = now;
+        phases[phase].ok = ok;
+        all_done = (++phases_ended == BOOT_PHASE_COUNT);
+    }
+    portEXIT_CRITICAL(&profile_lock);
+    
+    if (all_done) {
+        log_summary();
+    }
+}
+
+void boot_profile_get(boot_phase_t phase, boot_phase_info_t *out)
+{
+    if (!out) return;
+    if (phase >= BOOT_PHASE_COUNT) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    portENTER_CRITICAL(&profile_lock);
+    *out = phases[phase];
+    portEXIT_CRITICAL(&profile_lock);
+}
+
+const char* boot_profile_phase_name(boot_phase_t phase)
+{
+    return phase < BOOT_PHASE_COUNT ? phase_names[phase] : "?";
+}
+
+int32_t boot_profile_interactive_ms(void)
+{
+    int64_t end = phases[BOOT_PHASE_FIRST_FRAME].end_us;
+    return end ? (int32_t)(end / 1000) : -1;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file boot_profile.h
+ * @brief Per-phase boot timestamps for startup latency tracking
+ *
+ * Phases run on different tasks (see main.c); each one records its own
+ * start and end. A one-line summary is logged once every phase has ended.
+ */
+
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    BOOT_PHASE_NVS = 0,
+    BOOT_PHASE_DISPLAY,
+    BOOT_PHASE_BATTERY,
+    BOOT_PHASE_SD,
+    BOOT_PHASE_KEYBOARD,
+    BOOT_PHASE_UART,
+    BOOT_PHASE_BOARD_PING,      // Ends at the first ping answer or miss
+    BOOT_PHASE_BUZZER,
+    BOOT_PHASE_FIRST_FRAME,     // Home screen push to first flush
+    BOOT_PHASE_COUNT
+} boot_phase_t;
+
+typedef struct {
+    int64_t start_us;           // esp_timer time, 0 = not started
+    int64_t end_us;             // 0 = still running
+    bool ok;
+} boot_phase_info_t;
+
+/**
+ * @brief Mark the start of a phase
+ */
+void boot_profile_begin(boot_phase_t phase);
+
+/**
+ * @brief Mark the end of a phase (only the first call counts)
+ * @param ok false if the phase failed or found nothing
+ */
+void boot_profile_end(boot_phase_t phase, bool ok);
+
+/**
+ * @brief Read a phase's timestamps
+ */
+void boot_profile_get(boot_phase_t phase, boot_phase_info_t *out);
+
+/**
+ * @brief Short display name of a phase ("NVS", "Disp", ...)
+ */
+const char* boot_profile_phase_name(boot_phase_t phase);
+
+/**
+ * @brief Time from reset to the end of the first frame
+ * @return Milliseconds, or -1 if no frame has been shown yet
+ */
+int32_t boot_profile_interactive_ms(void);
+
+#endif // BOOT_PROFILE_H
@@ -0,0 +1,223 @@
+/**
+ * @file bt_store.c
+ * @brief Shared store for BLE devices seen by scan_bt
+ */
+
+#include "bt_store.h"
+#include "mem_monitor.h"
+#include "mac_set.h"
+#include "fixed_containers.h"
+#include "janos_proto.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "BT_STORE";
+
+#ifdef CONFIG_SPIRAM
+#define STORE_CAPS      (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define STORE_CAPS      (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+MEM_BUDGET(bt_store, BT_STORE_MAX, sizeof(bt_record_t), MEM_BUDGET_PSRAM);
+
+static bt_record_t *records = NULL;
+static mac_set_t index_set;             // Packed MAC -> records[] index
+static SemaphoreHandle_t store_mutex = NULL;
+static volatile uint32_t generation = 0;
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+esp_err_t bt_store_init(void)
+{
+    if (records) return ESP_OK;
+
+    if (!store_mutex) {
+        store_mutex = xSemaphoreCreateMutex();
+        if (!store_mutex) return ESP_ERR_NO_MEM;
+    }
+
+    bt_record_t *recs = heap_caps_calloc(BT_STORE_MAX, sizeof(bt_record_t), STORE_CAPS);
+    if (!recs) recs = calloc(BT_STORE_MAX, sizeof(bt_record_t));
+    if (!recs || mac_set_init(&index_set, BT_STORE_MAX) != ESP_OK) {
+        ESP_LOGE(TAG, "No memory for %d BT devices", BT_STORE_MAX);
+        free(recs);
+        return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    records = recs;
+    xSemaphoreGive(store_mutex);
+    return ESP_OK;
+}
+
+void bt_store_clear(void)
+{
+    if (!records) return;
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    mac_set_clear(&index_set);
+    generation++;
+    xSemaphoreGive(store_mutex);
+}
+
+int bt_store_add_line(const char *line)
+{
+    if (!records || !line) return -1;
+
+    // Numbered list rows only ("  1. XX:XX:...")
+    janos_bt_row_t row;
+    if (!janos_parse_bt_row(line, &row) || row.index < 0) return -1;
+    uint64_t key = row.mac;
+
+    int rssi = row.rssi == JANOS_RSSI_NONE ? 0 : row.rssi;
+    if (rssi < -128) rssi = -128;
+    if (rssi > 127) rssi = 127;
+
+    uint32_t now = now_ms();
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+
+    // Seen before: refresh the same record, otherwise take a free (or the
+    // least recently seen) one
+    bool is_new;
+    int index = mac_set_add(&index_set, key, &is_new);
+    if (index < 0) {
+        xSemaphoreGive(store_mutex);
+        return -1;
+    }
+    bt_record_t *rec = &records[index];
+    if (is_new) {
+        memset(rec, 0, sizeof(*rec));
+        for (int i = 0; i < 6; i++) {
+            rec->mac[i] = (uint8_t)(key >> (40 - 8 * i));
+        }
+        rec->first_seen_ms = now;
+    }
+    rec->rssi = (int8_t)rssi;
+    rec->last_seen_ms = now;
+    if (rec->sightings < UINT16_MAX) rec->sightings++;
+
+    if (row.name.len > 0) {
+        // A name learned earlier is kept when a later row has none
+        janos_span_copy(row.name, rec->name, BT_STORE_NAME_LEN);
+    }
+    generation++;
+
+    xSemaphoreGive(store_mutex);
+    return index;
+}
+
+int bt_store_restore(const bt_record_t *rec)
+{
+    if (!records || !rec) return -1;
+
+    uint64_t key = 0;
+    for (int i = 0; i < 6; i++) key = (key << 8) | rec->mac[i];
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+
+    // A device scanned since boot has the newer reading
+    int index = -1;
+    bool is_new = false;
+    if (mac_set_find(&index_set, key) < 0) {
+        index = mac_set_add(&index_set, key, &is_new);
+    }
+    if (index >= 0) {
+        records[index] = *rec;
+        records[index].first_seen_ms = 0;
+        records[index].last_seen_ms = 0;
+        generation++;
+    }
+
+    xSemaphoreGive(store_mutex);
+    return index;
+}
+
+int bt_store_count(void)
+{
+    return records ? index_set.count : 0;
+}
+
+bool bt_store_get(int index, bt_record_t *out)
+{
+    if (!records || index < 0 || index >= index_set.count) return false;
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    *out = records[index];
+    xSemaphoreGive(store_mutex);
+    return true;
+}
+
+void bt_store_set_flag(int index, uint8_t flag, bool on)
+{
+    if (!records || index < 0 || index >= index_set.count) return;
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    if (on) {
+        records[index].flags |= flag;
+    } else {
+        records[index].flags &= ~flag;
+    }
+    generation++;
+    xSemaphoreGive(store_mutex);
+}
+
+uint32_t bt_store_generation(void)
+{
+    return generation;
+}
+
+static int compare_indices(int ia, int ib, void *ctx)
+{
+    const bt_record_t *a = &records[ia];
+    const bt_record_t *b = &records[ib];
+    int r = 0;
+
+    switch (*(const bt_sort_t *)ctx) {
+        case BT_SORT_RSSI:
+            r = b->rssi - a->rssi;
+            break;
+        case BT_SORT_LAST_SEEN:
+            r = (b->last_seen_ms > a->last_seen_ms) - (b->last_seen_ms < a->last_seen_ms);
+            break;
+        default:
+            break;
+    }
+
+    // Stable: ties keep store order
+    return r ? r : ia - ib;
+}
+
+int bt_store_view(uint16_t *order, int max, bt_sort_t sort, uint32_t max_age_ms)
+{
+    if (!records || !order) return 0;
+
+    uint32_t now = now_ms();
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+
+    int n = 0;
+    for (int i = 0; i < index_set.count && n < max; i++) {
+        const bt_record_t *rec = &records[i];
+        if (max_age_ms && now - rec->last_seen_ms > max_age_ms &&
+            !(rec->flags & BT_FLAG_MARKED)) {
+            continue;
+        }
+        order[n++] = (uint16_t)i;
+    }
+    fixed_index_sort(order, n, compare_indices, &sort);
+
+    xSemaphoreGive(store_mutex);
+    return n;
+}
+
+void bt_store_format_mac(const bt_record_t *rec, char *out)
+{
+    snprintf(out, 18, "%02X:%02X:%02X:%02X:%02X:%02X",
+             rec->mac[0], rec->mac[1], rec->mac[2], rec->mac[3], rec->mac[4], rec->mac[5]);
+}
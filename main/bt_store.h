@@ -0,0 +1,115 @@
+/**
+ * @file bt_store.h
+ * @brief Shared store for BLE devices seen by scan_bt
+ *
+ * Devices are hash-indexed by packed MAC (mac_set), so a repeat sighting
+ * updates its record in O(1). When the store is full the least recently
+ * seen device is replaced. Screens read the store through sorted views
+ * that can leave out devices not seen for a while, and poll
+ * bt_store_generation() to redraw only when something changed.
+ *
+ * Records are added by the UART RX task; any task may read.
+ */
+
+#ifndef BT_STORE_H
+#define BT_STORE_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef CONFIG_BT_STORE_MAX_DEVICES
+#define BT_STORE_MAX            CONFIG_BT_STORE_MAX_DEVICES
+#else
+#define BT_STORE_MAX            512
+#endif
+
+#define BT_STORE_NAME_LEN       24
+#define BT_FLAG_MARKED          0x01    // Picked in the locator for tracking
+
+// One device
+typedef struct {
+    uint8_t mac[6];
+    int8_t rssi;                // Latest reading
+    uint8_t flags;              // BT_FLAG_*
+    uint32_t first_seen_ms;     // Uptime of the first sighting
+    uint32_t last_seen_ms;
+    uint16_t sightings;
+    char name[BT_STORE_NAME_LEN];   // "" until a name is advertised
+} bt_record_t;
+
+// Sort keys for bt_store_view()
+typedef enum {
+    BT_SORT_RSSI = 0,           // Strongest first
+    BT_SORT_LAST_SEEN,          // Most recent first
+    BT_SORT_COUNT
+} bt_sort_t;
+
+/**
+ * @brief Allocate the store (safe to call again; keeps existing devices)
+ * @return ESP_OK, ESP_ERR_NO_MEM
+ */
+esp_err_t bt_store_init(void);
+
+/**
+ * @brief Forget all devices
+ */
+void bt_store_clear(void);
+
+/**
+ * @brief Add or refresh a device from a scan_bt list line
+ *
+ * Format: "  1. XX:XX:XX:XX:XX:XX  RSSI: -82 dBm  Name: Device Name"
+ * @return Record index, or -1 if the line is not a device row
+ */
+int bt_store_add_line(const char *line);
+
+/**
+ * @brief Put back a device saved before a reboot (store_snapshot)
+ *
+ * Its first and last seen times become 0, before this boot. Restore the
+ * least recently seen first so a full store replaces those first.
+ * @return Record index, or -1 if the device was scanned since boot
+ */
+int bt_store_restore(const bt_record_t *rec);
+
+/**
+ * @brief Devices in the store (indices 0 .. count - 1)
+ */
+int bt_store_count(void);
+
+/**
+ * @brief Copy a record
+ * @return false if index is out of range
+ */
+bool bt_store_get(int index, bt_record_t *out);
+
+/**
+ * @brief Set or clear a BT_FLAG_* on a record
+ */
+void bt_store_set_flag(int index, uint8_t flag, bool on);
+
+/**
+ * @brief Counter bumped on every add, flag change and clear
+ */
+uint32_t bt_store_generation(void);
+
+/**
+ * @brief Build a sorted list of record indices
+ * @param order Destination (BT_STORE_MAX entries is always enough)
+ * @param max Size of order
+ * @param sort Sort key
+ * @param max_age_ms Leave out devices not seen for this long (0 = keep all,
+ *                   marked devices are always kept)
+ * @return Number of indices written
+ */
+int bt_store_view(uint16_t *order, int max, bt_sort_t sort, uint32_t max_age_ms);
+
+/**
+ * @brief Format a record's MAC as "AA:BB:CC:DD:EE:FF"
+ * @param out At least 18 bytes
+ */
+void bt_store_format_mac(const bt_record_t *rec, char *out);
+
+#endif // BT_STORE_H
@@ -0,0 +1,325 @@
+/**
+ * @file capture_index.c
+ * @brief What each handshake capture on the JanOS card holds, cached locally
+ */
+
+#include "capture_index.h"
+#include "handshakes_screen.h"
+#include "janos_proto.h"
+#include "mac_set.h"
+#include "mem_monitor.h"
+#include "time_sync.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static const char *TAG = "CAPTURE_INDEX";
+
+#ifdef CONFIG_SPIRAM
+#define INDEX_CAPS      (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define INDEX_CAPS      (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+#define PCAP_EXT        ".pcap"
+#define HEADER_PREFIX   "Captures in "
+#define UNCHANGED       "Captures unchanged"
+#define FOOTER_PREFIX   "Found "
+#define GEN_NONE        UINT32_MAX
+
+MEM_BUDGET(capture_index, CAPTURE_INDEX_MAX, sizeof(capture_record_t), MEM_BUDGET_PSRAM);
+
+static capture_record_t *records = NULL;
+static mac_set_t index_set;             // Listed name hash -> records[] index
+static SemaphoreHandle_t index_mutex = NULL;
+static volatile uint32_t generation = 0;
+static volatile capture_index_state_t state = CAPTURE_INDEX_EMPTY;
+static uint32_t janos_generation = GEN_NONE;    // Last "(gen N)", this session only
+static bool got_header = false;         // RX task, one request at a time
+static int rows = 0;
+
+esp_err_t capture_index_init(void)
+{
+    if (records) return ESP_OK;
+
+    if (!index_mutex) {
+        index_mutex = xSemaphoreCreateMutex();
+        if (!index_mutex) return ESP_ERR_NO_MEM;
+    }
+
+    capture_record_t *recs = heap_caps_calloc(CAPTURE_INDEX_MAX, sizeof(capture_record_t), INDEX_CAPS);
+    if (!recs) recs = calloc(CAPTURE_INDEX_MAX, sizeof(capture_record_t));
+    if (!recs || mac_set_init(&index_set, CAPTURE_INDEX_MAX) != ESP_OK) {
+        ESP_LOGE(TAG, "No memory for %d captures", CAPTURE_INDEX_MAX);
+        free(recs);
+        return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTake(index_mutex, portMAX_DELAY);
+    records = recs;
+    xSemaphoreGive(index_mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Listed name of a capture file: extension dropped, cut as remote_dir cuts it
+ * @return false if the file is not a .pcap
+ */
+static bool listed_name(const char *file, size_t len, char *out)
+{
+    size_t ext_len = strlen(PCAP_EXT);
+    if (len <= ext_len || strncasecmp(file + len - ext_len, PCAP_EXT, ext_len) != 0) return false;
+    len -= ext_len;
+    if (len >= REMOTE_DIR_NAME_LEN) len = REMOTE_DIR_NAME_LEN - 1;
+    memcpy(out, file, len);
+    out[len] = '\0';
+    return true;
+}
+
+/**
+ * @brief Find or add a capture (index_mutex held)
+ * @return Record index, or -1
+ */
+static int slot_for(const char *name)
+{
+    bool is_new;
+    int index = mac_set_add(&index_set, mac_set_key_from_string(name), &is_new);
+    if (index < 0) return -1;
+    if (is_new) {
+        memset(&records[index], 0, sizeof(records[index]));
+        strlcpy(records[index].name, name, sizeof(records[index].name));
+    }
+    return index;
+}
+
+static void add_summary(const janos_capture_row_t *row)
+{
+    char file[REMOTE_DIR_NAME_LEN + 8];
+    char name[REMOTE_DIR_NAME_LEN];
+    size_t len = csv_field_copy(&row->name, file, sizeof(file));
+    if (!listed_name(file, len, name)) return;
+
+    xSemaphoreTake(index_mutex, portMAX_DELAY);
+    int index = slot_for(name);
+    if (index >= 0) {
+        capture_record_t *rec = &records[index];
+        csv_field_copy(&row->ssid, rec->ssid, sizeof(rec->ssid));
+        for (int i = 0; i < 6; i++) rec->bssid[i] = (uint8_t)(row->bssid >> (8 * (5 - i)));
+        rec->eapol = row->eapol;
+        rec->flags = CAPTURE_FLAG_SUMMARY | (row->pmkid ? CAPTURE_FLAG_PMKID : 0);
+        rec->bytes = row->bytes;
+        rec->mtime = row->mtime;
+        generation++;
+        rows++;
+    }
+    xSemaphoreGive(index_mutex);
+}
+
+/**
+ * @brief "(gen N)" in a header line
+ */
+static uint32_t parse_generation(const char *line)
+{
+    const char *gen = strstr(line, "(gen ");
+    if (!gen) return GEN_NONE;
+    char *end;
+    unsigned long value = strtoul(gen + 5, &end, 10);
+    return end == gen + 5 ? GEN_NONE : (uint32_t)value;
+}
+
+static bool is_log_line(const char *line)
+{
+    return (line[0] == 'I' || line[0] == 'W' || line[0] == 'E' || line[0] == 'D') &&
+           line[1] == ' ' && line[2] == '(';
+}
+
+/**
+ * @brief Parse one hs_info reply line
+ * @return true when the reply is complete
+ */
+static bool on_info_line(const char *line, void *user_data)
+{
+    (void)user_data;
+
+    if (!got_header) {
+        if (strncmp(line, UNCHANGED, strlen(UNCHANGED)) == 0) {
+            got_header = true;
+            return true;
+        }
+        if (strncmp(line, HEADER_PREFIX, strlen(HEADER_PREFIX)) == 0) {
+            got_header = true;
+            xSemaphoreTake(index_mutex, portMAX_DELAY);
+            // The reply lists every capture: anything else was deleted
+            mac_set_clear(&index_set);
+            janos_generation = parse_generation(line);
+            generation++;
+            xSemaphoreGive(index_mutex);
+            return false;
+        }
+        // JanOS logs may come first; any other answer means no hs_info
+        return !is_log_line(line);
+    }
+
+    if (strncmp(line, FOOTER_PREFIX, strlen(FOOTER_PREFIX)) == 0) return true;
+
+    janos_capture_row_t row;
+    if (janos_parse_capture_row(line, &row)) add_summary(&row);
+    return false;
+}
+
+static void on_info_done(uart_request_status_t status, void *user_data)
+{
+    (void)user_data;
+
+    if (!got_header) {
+        state = CAPTURE_INDEX_UNSUPPORTED;
+        ESP_LOGI(TAG, "JanOS has no %s, indexing saved captures only", CAPTURE_INFO_CMD);
+    } else {
+        if (status == UART_REQUEST_TIMEOUT) {
+            // Partial: ask for everything next time
+            janos_generation = GEN_NONE;
+        }
+        state = CAPTURE_INDEX_READY;
+        ESP_LOGI(TAG, "%d captures summarised (%d indexed%s)", rows, capture_index_count(),
+                 status == UART_REQUEST_TIMEOUT ? ", timed out" : "");
+    }
+    generation++;
+}
+
+esp_err_t capture_index_refresh(bool force)
+{
+    esp_err_t ret = capture_index_init();
+    if (ret != ESP_OK) return ret;
+    if (state == CAPTURE_INDEX_LOADING) return ESP_OK;
+    if (state == CAPTURE_INDEX_UNSUPPORTED && !force) return ESP_ERR_NOT_SUPPORTED;
+
+    char cmd[UART_REQUEST_CMD_LEN];
+    if (janos_generation != GEN_NONE && !force) {
+        snprintf(cmd, sizeof(cmd), "%s %s %lu", CAPTURE_INFO_CMD, HANDSHAKES_DIR,
+                 (unsigned long)janos_generation);
+    } else {
+        snprintf(cmd, sizeof(cmd), "%s %s", CAPTURE_INFO_CMD, HANDSHAKES_DIR);
+    }
+
+    got_header = false;
+    rows = 0;
+    state = CAPTURE_INDEX_LOADING;
+    const uart_request_t req = {
+        .cmd = cmd,
+        .on_line = on_info_line,
+        .on_done = on_info_done,
+        .timeout_ms = CAPTURE_INDEX_TIMEOUT_MS,
+    };
+    ret = uart_request(&req);
+    if (ret != ESP_OK) state = CAPTURE_INDEX_EMPTY;
+    return ret;
+}
+
+capture_index_state_t capture_index_state(void)
+{
+    return state;
+}
+
+uint32_t capture_index_generation(void)
+{
+    return generation;
+}
+
+bool capture_index_find(const char *name, capture_record_t *out)
+{
+    if (!records || !name || !name[0]) return false;
+
+    xSemaphoreTake(index_mutex, portMAX_DELAY);
+    int index = mac_set_find(&index_set, mac_set_key_from_string(name));
+    if (index >= 0) *out = records[index];
+    xSemaphoreGive(index_mutex);
+    return index >= 0;
+}
+
+bool capture_record_crackable(const capture_record_t *rec)
+{
+    if (rec->flags & CAPTURE_FLAG_PMKID) return true;
+    return (rec->eapol & (CAPTURE_EAPOL_M2 | CAPTURE_EAPOL_M4)) &&
+           (rec->eapol & (CAPTURE_EAPOL_M1 | CAPTURE_EAPOL_M3));
+}
+
+void capture_index_note_saved(const char *line)
+{
+    const char *path = strstr(line, CAPTURE_PCAP_MARKER);
+    if (!path || capture_index_init() != ESP_OK) return;
+    path += strlen(CAPTURE_PCAP_MARKER);
+
+    // "/sdcard/lab/handshakes/AX3_2.4_12291C_79868.pcap (1186 bytes)"
+    size_t path_len = strcspn(path, " ");
+    const char *file = path;
+    for (const char *p = path; p < path + path_len; p++) {
+        if (*p == '/') file = p + 1;
+    }
+    char name[REMOTE_DIR_NAME_LEN];
+    if (!listed_name(file, (size_t)(path + path_len - file), name)) return;
+
+    const char *size = strchr(path + path_len, '(');
+    uint32_t bytes = size ? (uint32_t)strtoul(size + 1, NULL, 10) : 0;
+    int64_t utc_us;
+    uint32_t mtime = time_sync_utc_us(esp_timer_get_time(), &utc_us) ? (uint32_t)(utc_us / 1000000) : 0;
+
+    // JanOS names captures <SSID>_<last three BSSID octets>_<n>
+    char ssid[MAX_SSID_LEN];
+    strlcpy(ssid, name, sizeof(ssid));
+    for (int cut = 0; cut < 2; cut++) {
+        char *underscore = strrchr(ssid, '_');
+        if (underscore) *underscore = '\0';
+    }
+
+    xSemaphoreTake(index_mutex, portMAX_DELAY);
+    int index = slot_for(name);
+    if (index >= 0) {
+        capture_record_t *rec = &records[index];
+        strlcpy(rec->ssid, ssid, sizeof(rec->ssid));
+        // JanOS only saves complete 4-way handshakes
+        rec->eapol = CAPTURE_EAPOL_M1 | CAPTURE_EAPOL_M2 | CAPTURE_EAPOL_M3 | CAPTURE_EAPOL_M4;
+        rec->flags &= (uint8_t)~CAPTURE_FLAG_SUMMARY;
+        rec->bytes = bytes;
+        rec->mtime = mtime;
+        generation++;
+    }
+    xSemaphoreGive(index_mutex);
+    ESP_LOGD(TAG, "Indexed %s (%lu bytes)", name, (unsigned long)bytes);
+}
+
+int capture_index_count(void)
+{
+    return records ? index_set.count : 0;
+}
+
+bool capture_index_get(int index, capture_record_t *out)
+{
+    if (!records || index < 0 || index >= index_set.count) return false;
+    xSemaphoreTake(index_mutex, portMAX_DELAY);
+    *out = records[index];
+    xSemaphoreGive(index_mutex);
+    return true;
+}
+
+int capture_index_restore(const capture_record_t *rec)
+{
+    if (!rec->name[0] || capture_index_init() != ESP_OK) return -1;
+
+    xSemaphoreTake(index_mutex, portMAX_DELAY);
+    int index = mac_set_find(&index_set, mac_set_key_from_string(rec->name));
+    if (index < 0) {
+        index = slot_for(rec->name);
+        if (index >= 0) {
+            records[index] = *rec;
+            generation++;
+        }
+    }
+    xSemaphoreGive(index_mutex);
+    return index;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file capture_index.h
+ * @brief What each handshake capture on the JanOS card holds, cached locally
+ *
+ * list_dir gives only file names. "hs_info <dir> [generation]" makes JanOS
+ * summarise every .pcap in one reply (janos_parse_capture_row): SSID,
+ * BSSID, which EAPOL messages and whether a PMKID are in it, size and
+ * time. The summaries are kept here, hash-indexed by file name (mac_set),
+ * so the handshakes screen can show them and filter to crackable captures
+ * with one lookup per row and no query per file.
+ *
+ * JanOS numbers the states of its capture directory. Asked with the
+ * generation it last gave, it answers "Captures unchanged (gen N)" when
+ * nothing was saved or deleted since, so reopening the list costs one
+ * line. The number is only trusted within a session: a different board
+ * may be on the link after a restart.
+ *
+ * Reply:
+ *   Captures in /sdcard/lab/handshakes (gen 17):
+ *   "AX3_2.4_12291C_79868.pcap","AX3_2.4","AA:BB:CC:12:29:1C","1234","0","1186","1739550000"
+ *   Found 1 capture(s)
+ *
+ * JanOS builds without hs_info answer something else (or nothing); the
+ * index then holds only captures saved while the Cardputer listened
+ * ("PCAP saved: ..." lines, always a complete 4-way handshake), plus what
+ * store_snapshot brought back from the last session.
+ *
+ * Written by the UART RX task; any task may read.
+ */
+
+#ifndef CAPTURE_INDEX_H
+#define CAPTURE_INDEX_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "remote_dir.h"
+#include "uart_handler.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef CONFIG_CAPTURE_INDEX_MAX
+#define CAPTURE_INDEX_MAX           CONFIG_CAPTURE_INDEX_MAX
+#else
+#define CAPTURE_INDEX_MAX           512
+#endif
+#define CAPTURE_INDEX_TIMEOUT_MS    REMOTE_DIR_TIMEOUT_MS
+#define CAPTURE_INFO_CMD            "hs_info"
+#define CAPTURE_PCAP_MARKER         "PCAP saved: "
+
+// EAPOL messages in a capture
+#define CAPTURE_EAPOL_M1            0x01
+#define CAPTURE_EAPOL_M2            0x02
+#define CAPTURE_EAPOL_M3            0x04
+#define CAPTURE_EAPOL_M4            0x08
+
+// capture_record_t flags
+#define CAPTURE_FLAG_PMKID          0x01
+#define CAPTURE_FLAG_SUMMARY        0x02    // From hs_info, not guessed from a capture line
+
+typedef enum {
+    CAPTURE_INDEX_EMPTY = 0,        // Not asked this session
+    CAPTURE_INDEX_LOADING,
+    CAPTURE_INDEX_READY,
+    CAPTURE_INDEX_UNSUPPORTED,      // JanOS did not answer hs_info
+} capture_index_state_t;
+
+typedef struct {
+    char name[REMOTE_DIR_NAME_LEN]; // Without ".pcap", as remote_dir lists it
+    char ssid[MAX_SSID_LEN];
+    uint8_t bssid[6];               // All zero if unknown
+    uint8_t eapol;                  // CAPTURE_EAPOL_*
+    uint8_t flags;                  // CAPTURE_FLAG_*
+    uint32_t bytes;
+    uint32_t mtime;                 // Unix seconds, 0 if unknown
+} capture_record_t;
+
+/**
+ * @brief Allocate the index (safe to call again; keeps existing records)
+ * @return ESP_OK, ESP_ERR_NO_MEM
+ */
+esp_err_t capture_index_init(void);
+
+/**
+ * @brief Ask JanOS for the summaries of HANDSHAKES_DIR
+ * @param force Ask even if JanOS did not answer before
+ * @return ESP_OK if asked (or a request is in flight), ESP_ERR_NOT_SUPPORTED
+ *         if JanOS has no hs_info and force is not set, or a uart_request error
+ */
+esp_err_t capture_index_refresh(bool force);
+
+capture_index_state_t capture_index_state(void);
+
+/**
+ * @brief Counter bumped on every change
+ */
+uint32_t capture_index_generation(void);
+
+/**
+ * @brief Look a capture up by its listed name (one hash lookup)
+ * @return false if the index knows nothing about it
+ */
+bool capture_index_find(const char *name, capture_record_t *out);
+
+/**
+ * @brief Whether hashcat can work on a capture
+ *
+ * A PMKID, or an EAPOL message from the station (M2 or M4) together with
+ * one carrying the AP's nonce (M1 or M3).
+ */
+bool capture_record_crackable(const capture_record_t *rec);
+
+/**
+ * @brief Record a capture from a "PCAP saved: <path> (<n> bytes)" line
+ */
+void capture_index_note_saved(const char *line);
+
+/**
+ * @brief Records in the index (indices 0 .. count - 1, for store_snapshot)
+ */
+int capture_index_count(void);
+
+/**
+ * @brief Copy a record by index
+ * @return false if index is out of range
+ */
+bool capture_index_get(int index, capture_record_t *out);
+
+/**
+ * @brief Put back a record saved before a reboot (store_snapshot)
+ *
+ * A capture already summarised this session is left alone.
+ * @return Record index, or -1 without memory
+ */
+int capture_index_restore(const capture_record_t *rec);
+
+#endif // CAPTURE_INDEX_H
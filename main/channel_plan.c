@@ -0,0 +1,144 @@
+/**
+ * @file channel_plan.c
+ * @brief Split the WiFi channels across attached JanOS boards
+ */
+
+#include "channel_plan.h"
+#include "network_store.h"
+#include "world_model.h"
+#include "fixed_containers.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "CH_PLAN";
+
+// Channels JanOS hops by default
+static const uint8_t plan_channels[] = {
+    1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13,
+    36, 40, 44, 48, 52, 56, 60, 64, 100, 104, 108, 112, 116,
+    120, 124, 128, 132, 136, 140, 144, 149, 153, 157, 161, 165,
+};
+#define PLAN_CHANNEL_COUNT  (sizeof(plan_channels) / sizeof(plan_channels[0]))
+_Static_assert(PLAN_CHANNEL_COUNT <= CHANNEL_PLAN_MAX, "CHANNEL_PLAN_MAX too small");
+
+// Heaviest first
+static int compare_weight(int a, int b, void *ctx)
+{
+    const uint16_t *weights = ctx;
+    return (int)weights[b] - (int)weights[a];
+}
+
+static uint16_t clamp_dwell(uint32_t ms)
+{
+    if (ms < CHANNEL_PLAN_DWELL_MIN_MS) return CHANNEL_PLAN_DWELL_MIN_MS;
+    if (ms > CHANNEL_PLAN_DWELL_MAX_MS) return CHANNEL_PLAN_DWELL_MAX_MS;
+    return (uint16_t)ms;
+}
+
+void channel_plan_build(channel_plan_t *plan, uint8_t links)
+{
+    memset(plan, 0, sizeof(*plan));
+    memset(plan->board_of, CHANNEL_PLAN_NONE, sizeof(plan->board_of));
+    plan->links = (links & UART_LINK_MASK_ALL) ? (links & UART_LINK_MASK_ALL) :
+                  UART_LINK_MASK(UART_LINK_PRIMARY);
+
+    // Every channel weighs at least 1, so unseen ones are still shared out
+    uint16_t weights[PLAN_CHANNEL_COUNT];
+    uint16_t aps[256] = {0};
+    int count = network_store_count();
+    for (int i = 0; i < count; i++) {
+        const network_record_t *rec = network_store_record(i);
+        if (rec && !(rec->flags & NETWORK_FLAG_STALE) && aps[rec->channel] < UINT16_MAX) {
+            aps[rec->channel]++;
+        }
+    }
+    for (size_t i = 0; i < PLAN_CHANNEL_COUNT; i++) {
+        uint8_t ch = plan_channels[i];
+        uint32_t w = 1 + aps[ch] + CHANNEL_PLAN_CLIENT_WEIGHT * world_model_channel_clients(ch);
+        weights[i] = (w > UINT16_MAX) ? UINT16_MAX : (uint16_t)w;
+    }
+
+    // Longest-processing-time first: heaviest channel to the lightest board
+    uint16_t order[PLAN_CHANNEL_COUNT];
+    for (size_t i = 0; i < PLAN_CHANNEL_COUNT; i++) order[i] = i;
+    fixed_index_sort(order, PLAN_CHANNEL_COUNT, compare_weight, weights);
+
+    for (size_t i = 0; i < PLAN_CHANNEL_COUNT; i++) {
+        int best = -1;
+        for (int b = 0; b < UART_LINK_COUNT; b++) {
+            if (!(plan->links & UART_LINK_MASK(b))) continue;
+            if (best < 0 || plan->boards[b].load < plan->boards[best].load) best = b;
+        }
+        plan->board_of[plan_channels[order[i]]] = best;
+        plan->boards[best].load += weights[order[i]];
+    }
+
+    // Lists in channel order, dwell limits from each list's weight spread
+    for (int b = 0; b < UART_LINK_COUNT; b++) {
+        channel_plan_board_t *board = &plan->boards[b];
+        if (!(plan->links & UART_LINK_MASK(b))) continue;
+
+        uint16_t lightest = UINT16_MAX, heaviest = 0;
+        for (size_t i = 0; i < PLAN_CHANNEL_COUNT; i++) {
+            if (plan->board_of[plan_channels[i]] != b) continue;
+            board->channels[board->count++] = plan_channels[i];
+            if (weights[i] < lightest) lightest = weights[i];
+            if (weights[i] > heaviest) heaviest = weights[i];
+        }
+        if (board->count == 0) continue;
+
+        board->dwell_min_ms = clamp_dwell((uint32_t)CHANNEL_PLAN_CYCLE_MS * lightest / board->load);
+        board->dwell_max_ms = clamp_dwell((uint32_t)CHANNEL_PLAN_CYCLE_MS * heaviest / board->load);
+    }
+}
+
+void channel_plan_build_connected(channel_plan_t *plan)
+{
+    uint8_t links = UART_LINK_MASK(UART_LINK_PRIMARY);
+    for (int b = 1; b < UART_LINK_COUNT; b++) {
+        if (uart_link_is_up((uart_link_id_t)b)) links |= UART_LINK_MASK(b);
+    }
+    channel_plan_build(plan, links);
+}
+
+int channel_plan_board_count(const channel_plan_t *plan)
+{
+    return __builtin_popcount(plan->links);
+}
+
+esp_err_t channel_plan_apply(const channel_plan_t *plan)
+{
+    esp_err_t result = ESP_OK;
+    bool split = channel_plan_board_count(plan) > 1;
+
+    for (int b = 0; b < UART_LINK_COUNT; b++) {
+        const channel_plan_board_t *board = &plan->boards[b];
+        if (!(plan->links & UART_LINK_MASK(b)) || board->count == 0) continue;
+
+        // Four characters per channel covers "165,"
+        char cmd[sizeof(CHANNEL_PLAN_LIST_CMD) + 1 + CHANNEL_PLAN_MAX * 4];
+        esp_err_t ret;
+        snprintf(cmd, sizeof(cmd), "channel_time set min %u", board->dwell_min_ms);
+        ret = uart_link_send_command((uart_link_id_t)b, cmd);
+        if (ret == ESP_OK) {
+            snprintf(cmd, sizeof(cmd), "channel_time set max %u", board->dwell_max_ms);
+            ret = uart_link_send_command((uart_link_id_t)b, cmd);
+        }
+
+        // A lone board keeps JanOS's own list, so it needs no list command
+        if (ret == ESP_OK && split) {
+            size_t len = strlcpy(cmd, CHANNEL_PLAN_LIST_CMD, sizeof(cmd));
+            for (int i = 0; i < board->count; i++) {
+                len += snprintf(cmd + len, sizeof(cmd) - len, "%c%u", i ? ',' : ' ',
+                                board->channels[i]);
+            }
+            ret = uart_link_send_command((uart_link_id_t)b, cmd);
+        }
+
+        ESP_LOGI(TAG, "Board %d: %u channels, load %u, dwell %u-%u ms", b + 1,
+                 board->count, board->load, board->dwell_min_ms, board->dwell_max_ms);
+        if (ret != ESP_OK && result == ESP_OK) result = ret;
+    }
+    return result;
+}
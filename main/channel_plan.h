@@ -0,0 +1,83 @@
+/**
+ * @file channel_plan.h
+ * @brief Split the WiFi channels across attached JanOS boards
+ *
+ * Each channel is weighted by what was seen on it: APs in the network
+ * store plus the clients the sniffer last listed (world_model). The
+ * channels are dealt heaviest first to the board with the least load so
+ * far, so every board hops a short list of about equal busyness instead
+ * of all boards hopping the same one. A board's channel_time min/max are
+ * then set from the spread of weights on its own list: a fixed hop cycle
+ * is shared out by weight, so quiet channels get the minimum dwell and
+ * busy ones the maximum.
+ *
+ * Results need no merging step: every board's lines already feed the
+ * same stores (uart_subscribe_link_lines).
+ */
+
+#ifndef CHANNEL_PLAN_H
+#define CHANNEL_PLAN_H
+
+#include "esp_err.h"
+#include "uart_handler.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CHANNEL_PLAN_MAX            40      // Channels one board can be given
+#define CHANNEL_PLAN_NONE           0xFF    // board_of[] for channels not planned
+#define CHANNEL_PLAN_DWELL_MIN_MS   100     // channel_time limits JanOS accepts
+#define CHANNEL_PLAN_DWELL_MAX_MS   1500
+#define CHANNEL_PLAN_CLIENT_WEIGHT  2       // A client counts as this many APs
+
+#ifdef CONFIG_CHANNEL_PLAN_CYCLE_MS
+#define CHANNEL_PLAN_CYCLE_MS       CONFIG_CHANNEL_PLAN_CYCLE_MS
+#else
+#define CHANNEL_PLAN_CYCLE_MS       4000
+#endif
+
+#ifdef CONFIG_JANOS_CHANNEL_LIST_CMD
+#define CHANNEL_PLAN_LIST_CMD       CONFIG_JANOS_CHANNEL_LIST_CMD
+#else
+#define CHANNEL_PLAN_LIST_CMD       "channel_list set"
+#endif
+
+// One board's share
+typedef struct {
+    uint8_t channels[CHANNEL_PLAN_MAX];     // Ascending
+    uint8_t count;
+    uint16_t load;                          // Sum of channel weights
+    uint16_t dwell_min_ms;
+    uint16_t dwell_max_ms;
+} channel_plan_board_t;
+
+typedef struct {
+    channel_plan_board_t boards[UART_LINK_COUNT];   // Indexed by uart_link_id_t
+    uint8_t board_of[256];                  // Per channel: link, or CHANNEL_PLAN_NONE
+    uint8_t links;                          // UART_LINK_MASK() bits of boards planned
+} channel_plan_t;
+
+/**
+ * @brief Partition the channels across boards from current densities
+ * @param plan Receives the plan
+ * @param links UART_LINK_MASK() bits of boards to use (0 = primary only)
+ */
+void channel_plan_build(channel_plan_t *plan, uint8_t links);
+
+/**
+ * @brief Partition across every board that has answered since boot
+ */
+void channel_plan_build_connected(channel_plan_t *plan);
+
+/**
+ * @brief Send each board its channel_time and, with several boards, its
+ *        channel list (CHANNEL_PLAN_LIST_CMD)
+ * @return ESP_OK, or the first send error
+ */
+esp_err_t channel_plan_apply(const channel_plan_t *plan);
+
+/**
+ * @brief Number of boards in a plan
+ */
+int channel_plan_board_count(const channel_plan_t *plan);
+
+#endif // CHANNEL_PLAN_H
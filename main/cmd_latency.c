@@ -0,0 +1,238 @@
+/**
+ * @file cmd_latency.c
+ * @brief Time to first line and to completion of JanOS commands
+ */
+
+#include "cmd_latency.h"
+#include "time_sync.h"
+#include "screenshot.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "CMD_LATENCY";
+
+#define FLIGHT_CMD_LEN  64
+
+// The command whose reply is being timed (lock held)
+typedef struct {
+    bool open;
+    bool exact;                 // Ended by cmd_latency_done(), not by silence
+    bool answered;
+    int slot;
+    char cmd[FLIGHT_CMD_LEN];
+    int64_t sent_us;
+    int64_t last_line_us;
+} flight_t;
+
+static cmd_latency_entry_t entries[CMD_LATENCY_COMMANDS];
+static int entry_count;
+static flight_t flight;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void add_sample(uint16_t *hist, uint64_t *total, uint32_t *max, uint32_t us)
+{
+    int bucket = 0;
+    while (bucket < CMD_LATENCY_BUCKETS - 1 && us >= ((uint32_t)CMD_LATENCY_BASE_US << bucket)) {
+        bucket++;
+    }
+    if (hist[bucket] < UINT16_MAX) hist[bucket]++;
+    *total += us;
+    if (us > *max) *max = us;
+}
+
+/**
+ * @brief Entry of a command's first word, added if new (lock held)
+ */
+static int find_slot(const char *cmd)
+{
+    size_t word = strcspn(cmd, " \n");
+    if (word >= CMD_LATENCY_NAME_LEN) word = CMD_LATENCY_NAME_LEN - 1;
+
+    for (int i = 0; i < entry_count; i++) {
+        if (strncmp(entries[i].name, cmd, word) == 0 && entries[i].name[word] == '\0') return i;
+    }
+    if (entry_count < CMD_LATENCY_COMMANDS - 1) {
+        cmd_latency_entry_t *e = &entries[entry_count];
+        memset(e, 0, sizeof(*e));
+        memcpy(e->name, cmd, word);
+        return entry_count++;
+    }
+    // Table full: the last entry pools the rest
+    if (entry_count == CMD_LATENCY_COMMANDS - 1) {
+        memset(&entries[entry_count], 0, sizeof(entries[0]));
+        strcpy(entries[entry_count].name, "other");
+        entry_count++;
+    }
+    return CMD_LATENCY_COMMANDS - 1;
+}
+
+/**
+ * @brief End the flight; when completed, end_us is its completion (lock held)
+ */
+static void close_flight(int64_t end_us, bool completed)
+{
+    if (!flight.open) return;
+    cmd_latency_hist_t *h = &entries[flight.slot].hist;
+    if (!flight.answered) {
+        h->unanswered++;
+    } else if (completed && end_us >= flight.sent_us) {
+        add_sample(h->done_hist, &h->done_total_us, &h->done_max_us,
+                   (uint32_t)(end_us - flight.sent_us));
+    }
+    flight.open = false;
+}
+
+/**
+ * @brief Close a flight that went quiet or never got a reply (lock held)
+ */
+static void expire(int64_t now_us)
+{
+    if (!flight.open) return;
+    if (!flight.answered && now_us - flight.sent_us > CMD_LATENCY_GIVEUP_MS * 1000LL) {
+        close_flight(now_us, false);
+    } else if (!flight.exact && flight.answered &&
+               now_us - flight.last_line_us > CMD_LATENCY_IDLE_MS * 1000LL) {
+        close_flight(flight.last_line_us, true);
+    }
+}
+
+void cmd_latency_sent(const char *cmd, bool exact)
+{
+    if (!cmd || !cmd[0]) return;
+    int64_t now_us = time_sync_now_us();
+
+    portENTER_CRITICAL(&lock);
+    expire(now_us);
+    // Superseded: whatever the old one printed so far is its reply
+    close_flight(flight.last_line_us, true);
+    flight = (flight_t){
+        .open = true,
+        .exact = exact,
+        .slot = find_slot(cmd),
+        .sent_us = now_us,
+    };
+    strlcpy(flight.cmd, cmd, sizeof(flight.cmd));
+    flight.cmd[strcspn(flight.cmd, "\n")] = '\0';
+    portEXIT_CRITICAL(&lock);
+}
+
+void cmd_latency_line(const char *line, int64_t time_us)
+{
+    portENTER_CRITICAL(&lock);
+    expire(time_us);
+    if (flight.open && (flight.answered || strcmp(line, flight.cmd) != 0)) {
+        if (!flight.answered) {
+            cmd_latency_hist_t *h = &entries[flight.slot].hist;
+            h->count++;
+            add_sample(h->first_hist, &h->first_total_us, &h->first_max_us,
+                       (uint32_t)(time_us - flight.sent_us));
+            flight.answered = true;
+        }
+        flight.last_line_us = time_us;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void cmd_latency_done(const char *cmd, bool ok)
+{
+    int64_t now_us = time_sync_now_us();
+
+    portENTER_CRITICAL(&lock);
+    if (flight.open && cmd && strncmp(flight.cmd, cmd, sizeof(flight.cmd)) == 0) {
+        close_flight(now_us, ok);
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+int cmd_latency_get(cmd_latency_entry_t *out, int max)
+{
+    if (!out || max <= 0) return 0;
+
+    portENTER_CRITICAL(&lock);
+    expire(time_sync_now_us());
+    int count = 0;
+    for (int i = 0; i < entry_count; i++) {
+        // Insertion by use count; the table is small
+        const cmd_latency_entry_t *e = &entries[i];
+        uint32_t uses = e->hist.count + e->hist.unanswered;
+        int pos = count < max ? count : max - 1;
+        if (count == max && out[pos].hist.count + out[pos].hist.unanswered >= uses) continue;
+        while (pos > 0 && out[pos - 1].hist.count + out[pos - 1].hist.unanswered < uses) {
+            out[pos] = out[pos - 1];
+            pos--;
+        }
+        out[pos] = *e;
+        if (count < max) count++;
+    }
+    portEXIT_CRITICAL(&lock);
+    return count;
+}
+
+uint32_t cmd_latency_percentile(const uint16_t *hist, uint32_t permille)
+{
+    uint32_t total = 0;
+    for (int i = 0; i < CMD_LATENCY_BUCKETS; i++) total += hist[i];
+    if (total == 0) return 0;
+
+    uint32_t seen = 0;
+    for (int i = 0; i < CMD_LATENCY_BUCKETS - 1; i++) {
+        seen += hist[i];
+        if (seen * 1000 >= total * permille) return (uint32_t)CMD_LATENCY_BASE_US << i;
+    }
+    return UINT32_MAX;
+}
+
+void cmd_latency_reset(void)
+{
+    portENTER_CRITICAL(&lock);
+    entry_count = 0;
+    flight.open = false;
+    portEXIT_CRITICAL(&lock);
+}
+
+esp_err_t cmd_latency_dump(void)
+{
+    if (!screenshot_is_available()) return ESP_ERR_INVALID_STATE;
+
+    static cmd_latency_entry_t list[CMD_LATENCY_COMMANDS];
+    int count = cmd_latency_get(list, CMD_LATENCY_COMMANDS);
+
+    FILE *f = fopen(CMD_LATENCY_FILE, "w");
+    if (!f) return ESP_FAIL;
+
+    fprintf(f, "command,count,unanswered,first_avg_us,first_max_us,done_avg_us,done_max_us");
+    for (int kind = 0; kind < 2; kind++) {
+        for (int i = 0; i < CMD_LATENCY_BUCKETS; i++) {
+            if (i < CMD_LATENCY_BUCKETS - 1) {
+                fprintf(f, ",%s_lt_%lums", kind ? "done" : "first",
+                        (unsigned long)((CMD_LATENCY_BASE_US << i) / 1000));
+            } else {
+                fprintf(f, ",%s_slower", kind ? "done" : "first");
+            }
+        }
+    }
+    fputc('\n', f);
+
+    for (int e = 0; e < count; e++) {
+        const cmd_latency_hist_t *h = &list[e].hist;
+        uint32_t done_samples = 0;
+        for (int i = 0; i < CMD_LATENCY_BUCKETS; i++) done_samples += h->done_hist[i];
+        fprintf(f, "%s,%lu,%lu,%llu,%lu,%llu,%lu", list[e].name,
+                (unsigned long)h->count, (unsigned long)h->unanswered,
+                (unsigned long long)(h->count ? h->first_total_us / h->count : 0),
+                (unsigned long)h->first_max_us,
+                (unsigned long long)(done_samples ? h->done_total_us / done_samples : 0),
+                (unsigned long)h->done_max_us);
+        for (int i = 0; i < CMD_LATENCY_BUCKETS; i++) fprintf(f, ",%u", h->first_hist[i]);
+        for (int i = 0; i < CMD_LATENCY_BUCKETS; i++) fprintf(f, ",%u", h->done_hist[i]);
+        fputc('\n', f);
+    }
+
+    bool ok = !ferror(f);
+    if (fclose(f) != 0) ok = false;
+    if (!ok) return ESP_FAIL;
+    ESP_LOGI(TAG, "Wrote %d commands to %s", count, CMD_LATENCY_FILE);
+    return ESP_OK;
+}
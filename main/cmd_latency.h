@@ -0,0 +1,94 @@
+/**
+ * @file cmd_latency.h
+ * @brief Time to first line and to completion of JanOS commands
+ *
+ * Every command sent to the primary board opens a flight, keyed by its
+ * first word ("scan_networks", "show_pass", ...). The first received
+ * line other than the echo of the command gives the time to first
+ * line. The flight completes when one of these happens:
+ * - its uart_request() finishes, or the scan it started does
+ * - for other commands, the link stays quiet for CMD_LATENCY_IDLE_MS
+ *   after a reply line (completion is that last line)
+ * - the next command is sent, which also ends it at its last line
+ * Commands that get no line within CMD_LATENCY_GIVEUP_MS, and requests
+ * that time out, count as unanswered. Batches (uart_send_batch) are not
+ * tracked.
+ *
+ * Both times go into log2 histograms per command, from
+ * CMD_LATENCY_BASE_US up; the last bucket holds everything slower. They
+ * show which commands are worth caching or paging first.
+ */
+
+#ifndef CMD_LATENCY_H
+#define CMD_LATENCY_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CMD_LATENCY_COMMANDS    24      // Distinct commands; later ones share "other"
+#define CMD_LATENCY_NAME_LEN    24
+#define CMD_LATENCY_BUCKETS     14      // <1 ms, <2 ms, ... <4.1 s, then slower
+#define CMD_LATENCY_BASE_US     1000
+#define CMD_LATENCY_IDLE_MS     1000    // Quiet time that ends a plain command
+#define CMD_LATENCY_GIVEUP_MS   30000   // No line at all: unanswered
+#define CMD_LATENCY_FILE        "/sdcard/cmd_latency.csv"
+
+typedef struct {
+    uint32_t count;                     // Flights that got a first line
+    uint32_t unanswered;
+    uint32_t first_max_us;
+    uint32_t done_max_us;
+    uint64_t first_total_us;
+    uint64_t done_total_us;
+    uint16_t first_hist[CMD_LATENCY_BUCKETS];
+    uint16_t done_hist[CMD_LATENCY_BUCKETS];
+} cmd_latency_hist_t;
+
+typedef struct {
+    char name[CMD_LATENCY_NAME_LEN];
+    cmd_latency_hist_t hist;
+} cmd_latency_entry_t;
+
+/**
+ * @brief A command left for the primary board (uart_handler)
+ * @param exact Its end is reported with cmd_latency_done() (requests, scans)
+ */
+void cmd_latency_sent(const char *cmd, bool exact);
+
+/**
+ * @brief A line arrived from the primary board (UART RX task)
+ * @param time_us Arrival of its last byte
+ */
+void cmd_latency_line(const char *line, int64_t time_us);
+
+/**
+ * @brief The command in flight finished (ok) or timed out (!ok)
+ */
+void cmd_latency_done(const char *cmd, bool ok);
+
+/**
+ * @brief Copy the per-command histograms, most used first
+ * @return Entries written
+ */
+int cmd_latency_get(cmd_latency_entry_t *out, int max);
+
+/**
+ * @brief Upper bound of the bucket holding the given share of samples
+ * @param permille 500 for the median, 900 for p90
+ * @return Microseconds, 0 without samples, UINT32_MAX in the open bucket
+ */
+uint32_t cmd_latency_percentile(const uint16_t *hist, uint32_t permille);
+
+/**
+ * @brief Forget all histograms
+ */
+void cmd_latency_reset(void);
+
+/**
+ * @brief Write the histograms to CMD_LATENCY_FILE as CSV
+ * @return ESP_OK, ESP_ERR_INVALID_STATE without SD card, ESP_FAIL
+ */
+esp_err_t cmd_latency_dump(void);
+
+#endif // CMD_LATENCY_H
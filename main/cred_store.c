@@ -0,0 +1,327 @@
+/**
+ * @file cred_store.c
+ * @brief Captured credentials shared by the portal and Evil Twin screens
+ *
+ * Live lines followed:
+ * Received POST data: email=a%40b.com&password=hunter2
+ * Wi-Fi: connected to SSID='Home' with password='hunter2'
+ * Password verified!
+ *
+ * show_pass rows: "SSID", "field1=value1", "field2=value2", ...
+ */
+
+#include "cred_store.h"
+#include "mem_monitor.h"
+#include "uart_handler.h"
+#include "csv_parser.h"
+#include "mac_set.h"
+#include "session_log.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+static const char *TAG = "CRED_STORE";
+
+#define POOL_INITIAL    2048
+#define KEY_TEXT_LEN    (CRED_SSID_LEN + CRED_DATA_LEN + 4)
+
+// One capture; SSID and data are NUL-terminated strings in the pool
+typedef struct {
+    uint16_t ssid_offset;
+    uint16_t data_offset;
+} cred_record_t;
+
+static const char *const kind_names[CRED_KIND_COUNT] = {
+    [CRED_PORTAL] = "portal",
+    [CRED_EVIL]   = "evil",
+};
+
+static cred_record_t records[CRED_KIND_COUNT][CRED_STORE_MAX];
+MEM_BUDGET(cred_store, CRED_KIND_COUNT * CRED_STORE_MAX, sizeof(cred_record_t),
+           MEM_BUDGET_STATIC);
+static int record_count[CRED_KIND_COUNT];
+static char *pool = NULL;
+static size_t pool_size = 0;
+static size_t pool_used = 0;
+static mac_set_t seen;                      // Hash of (kind, SSID, data)
+static uint32_t dropped = 0;
+static volatile uint32_t generation = 0;
+static volatile cred_load_state_t load_state[CRED_KIND_COUNT];
+static SemaphoreHandle_t store_mutex = NULL;
+
+// Live Evil Twin attempt, stored once JanOS verifies it (RX task only)
+static char pending_ssid[CRED_SSID_LEN];
+static char pending_password[CRED_DATA_LEN];
+static char portal_ssid[CRED_SSID_LEN];
+
+/**
+ * @brief Make room for len more pool bytes
+ */
+static bool pool_reserve(size_t len)
+{
+    if (pool_used + len <= pool_size) return true;
+
+    size_t size = pool_size ? pool_size : POOL_INITIAL;
+    while (size < pool_used + len) size *= 2;
+    if (size > CRED_POOL_MAX) size = CRED_POOL_MAX;
+    if (pool_used + len > size) return false;
+
+    char *grown = realloc(pool, size);
+    if (!grown) return false;
+    pool = grown;
+    pool_size = size;
+    return true;
+}
+
+static uint16_t pool_put(const char *text)
+{
+    size_t len = strlen(text) + 1;
+    uint16_t offset = (uint16_t)pool_used;
+    memcpy(pool + pool_used, text, len);
+    pool_used += len;
+    return offset;
+}
+
+bool cred_store_add(cred_kind_t kind, const char *ssid, const char *data, bool live)
+{
+    if (!store_mutex || kind >= CRED_KIND_COUNT || !ssid || !data || !data[0]) return false;
+
+    char text[KEY_TEXT_LEN];
+    snprintf(text, sizeof(text), "%d\x1f%.*s\x1f%.*s", (int)kind,
+             CRED_SSID_LEN - 1, ssid, CRED_DATA_LEN - 1, data);
+    uint64_t key = mac_set_key_from_string(text);
+
+    bool added = false;
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    if (mac_set_find(&seen, key) < 0) {
+        size_t ssid_len = strnlen(ssid, CRED_SSID_LEN - 1);
+        size_t data_len = strnlen(data, CRED_DATA_LEN - 1);
+
+        // A full store keeps what it has; the session log still gets the rest
+        if (record_count[kind] >= CRED_STORE_MAX || seen.count >= seen.capacity ||
+            !pool_reserve(ssid_len + data_len + 2)) {
+            dropped++;
+        } else {
+            char ssid_copy[CRED_SSID_LEN];
+            char data_copy[CRED_DATA_LEN];
+            memcpy(ssid_copy, ssid, ssid_len);
+            ssid_copy[ssid_len] = '\0';
+            memcpy(data_copy, data, data_len);
+            data_copy[data_len] = '\0';
+
+            cred_record_t *r = &records[kind][record_count[kind]];
+            r->ssid_offset = pool_put(ssid_copy);
+            r->data_offset = pool_put(data_copy);
+            record_count[kind]++;
+            mac_set_add(&seen, key, NULL);
+            generation++;
+            added = true;
+        }
+    }
+    xSemaphoreGive(store_mutex);
+
+    if (added && live) {
+        session_log_printf(SESSION_LOG_PORTAL, "CRED\t%s\t%s\t%s", kind_names[kind], ssid, data);
+        ESP_LOGI(TAG, "New %s capture for '%s'", kind_names[kind], ssid);
+    }
+    return added;
+}
+
+/**
+ * @brief Copy the value between prefix and the next quote
+ */
+static bool extract_quoted(const char *line, const char *prefix, char *out, size_t len)
+{
+    const char *start = strstr(line, prefix);
+    if (!start) return false;
+    start += strlen(prefix);
+    const char *end = strchr(start, '\'');
+    if (!end) return false;
+
+    size_t n = end - start;
+    if (n >= len) n = len - 1;
+    memcpy(out, start, n);
+    out[n] = '\0';
+    return true;
+}
+
+/**
+ * @brief Turn "a=x%40y&b=z+w" into "a=x@y, b=z w", the form show_pass prints
+ */
+static void decode_form(const char *in, char *out, size_t len)
+{
+    size_t n = 0;
+    for (const char *p = in; *p && n + 3 < len; p++) {
+        if (*p == '&') {
+            out[n++] = ',';
+            out[n++] = ' ';
+        } else if (*p == '+') {
+            out[n++] = ' ';
+        } else if (*p == '%' && isxdigit((unsigned char)p[1]) && isxdigit((unsigned char)p[2])) {
+            char hex[3] = { p[1], p[2], '\0' };
+            out[n++] = (char)strtol(hex, NULL, 16);
+            p += 2;
+        } else if (*p != '\r' && *p != '\n') {
+            out[n++] = *p;
+        }
+    }
+    out[n] = '\0';
+}
+
+/**
+ * @brief Follow capture lines of running attacks
+ */
+static void watch_line(const char *line, void *user_data)
+{
+    (void)user_data;
+
+    const char *post = strstr(line, "Received POST data: ");
+    if (post) {
+        if (portal_ssid[0]) {
+            char fields[CRED_DATA_LEN];
+            decode_form(post + strlen("Received POST data: "), fields, sizeof(fields));
+            cred_store_add(CRED_PORTAL, portal_ssid, fields, true);
+        }
+        return;
+    }
+
+    if (strstr(line, "Wi-Fi: connected to SSID='") && strstr(line, "with password='")) {
+        if (!extract_quoted(line, "SSID='", pending_ssid, sizeof(pending_ssid)) ||
+            !extract_quoted(line, "password='", pending_password, sizeof(pending_password))) {
+            pending_ssid[0] = '\0';
+        }
+        return;
+    }
+
+    if (strstr(line, "Password verified!") && pending_ssid[0]) {
+        cred_store_add(CRED_EVIL, pending_ssid, pending_password, true);
+        pending_ssid[0] = '\0';
+    }
+}
+
+/**
+ * @brief Parse one show_pass row; the first field is the SSID
+ */
+static bool on_load_line(const char *line, void *user_data)
+{
+    cred_kind_t kind = (cred_kind_t)(intptr_t)user_data;
+
+    csv_tokenizer_t tok;
+    csv_tokenizer_init(&tok, line);
+    csv_field_t f;
+    if (!csv_next_field(&tok, &f) || !f.quoted) return false;
+
+    char ssid[CRED_SSID_LEN];
+    csv_field_copy(&f, ssid, sizeof(ssid));
+
+    // Remaining fields are joined the way the screens show them
+    char data[CRED_DATA_LEN] = "";
+    char field[CRED_DATA_LEN];
+    while (csv_next_field(&tok, &f) && f.quoted) {
+        csv_field_copy(&f, field, sizeof(field));
+        if (data[0]) strlcat(data, ", ", sizeof(data));
+        strlcat(data, field, sizeof(data));
+        if (kind == CRED_EVIL) break;
+    }
+    cred_store_add(kind, ssid, data, false);
+    return false;
+}
+
+static void on_load_done(uart_request_status_t status, void *user_data)
+{
+    (void)status;
+    cred_kind_t kind = (cred_kind_t)(intptr_t)user_data;
+
+    load_state[kind] = CRED_READY;
+    generation++;
+    ESP_LOGI(TAG, "%d %s captures (%lu dropped)", record_count[kind], kind_names[kind],
+             (unsigned long)dropped);
+}
+
+esp_err_t cred_store_init(void)
+{
+    if (store_mutex) return ESP_OK;
+
+    store_mutex = xSemaphoreCreateMutex();
+    if (!store_mutex) return ESP_ERR_NO_MEM;
+    if (mac_set_init(&seen, CRED_STORE_MAX * CRED_KIND_COUNT) != ESP_OK) {
+        vSemaphoreDelete(store_mutex);
+        store_mutex = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    uart_subscribe_lines(UART_ROUTE_ANY, NULL, watch_line, NULL);
+    return ESP_OK;
+}
+
+esp_err_t cred_store_load(cred_kind_t kind)
+{
+    if (!store_mutex || kind >= CRED_KIND_COUNT) return ESP_ERR_INVALID_STATE;
+    if (load_state[kind] != CRED_EMPTY) return ESP_OK;
+
+    char cmd[24];
+    snprintf(cmd, sizeof(cmd), "show_pass %s", kind_names[kind]);
+
+    load_state[kind] = CRED_LOADING;
+    const uart_request_t req = {
+        .cmd = cmd,
+        .on_line = on_load_line,
+        .on_done = on_load_done,
+        .user_data = (void *)(intptr_t)kind,
+        .timeout_ms = CRED_LOAD_TIMEOUT_MS,
+    };
+    esp_err_t ret = uart_request(&req);
+    if (ret != ESP_OK) {
+        load_state[kind] = CRED_EMPTY;
+    }
+    return ret;
+}
+
+esp_err_t cred_store_reload(cred_kind_t kind)
+{
+    if (kind >= CRED_KIND_COUNT) return ESP_ERR_INVALID_ARG;
+    if (load_state[kind] == CRED_LOADING) return ESP_OK;
+
+    load_state[kind] = CRED_EMPTY;
+    return cred_store_load(kind);
+}
+
+cred_load_state_t cred_store_load_state(cred_kind_t kind)
+{
+    return kind < CRED_KIND_COUNT ? load_state[kind] : CRED_EMPTY;
+}
+
+void cred_store_set_portal_ssid(const char *ssid)
+{
+    strlcpy(portal_ssid, ssid ? ssid : "", sizeof(portal_ssid));
+}
+
+int cred_store_count(cred_kind_t kind)
+{
+    return kind < CRED_KIND_COUNT ? record_count[kind] : 0;
+}
+
+bool cred_store_get(cred_kind_t kind, int n, cred_entry_t *out)
+{
+    if (!store_mutex || kind >= CRED_KIND_COUNT || n < 0 || !out) return false;
+
+    bool ok = false;
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    if (n < record_count[kind]) {
+        const cred_record_t *r = &records[kind][n];
+        strlcpy(out->ssid, pool + r->ssid_offset, sizeof(out->ssid));
+        strlcpy(out->data, pool + r->data_offset, sizeof(out->data));
+        ok = true;
+    }
+    xSemaphoreGive(store_mutex);
+    return ok;
+}
+
+uint32_t cred_store_generation(void)
+{
+    return generation;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file cred_store.h
+ * @brief Captured credentials shared by the portal and Evil Twin screens
+ *
+ * Credentials arrive two ways: live, from the JanOS lines printed while a
+ * portal or Evil Twin runs, and once per boot from "show_pass portal" /
+ * "show_pass evil" for what earlier sessions saved on the card. Both go
+ * through one store that drops repeats of the same (SSID, fields), so the
+ * screens show new captures as they happen without querying JanOS again.
+ * Live captures are also written to the session log as CRED records.
+ */
+
+#ifndef CRED_STORE_H
+#define CRED_STORE_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef CONFIG_CRED_STORE_MAX_ENTRIES
+#define CRED_STORE_MAX          CONFIG_CRED_STORE_MAX_ENTRIES
+#else
+#define CRED_STORE_MAX          256
+#endif
+#define CRED_POOL_MAX           (16 * 1024)     // SSID and field bytes, grown on demand
+#define CRED_SSID_LEN           33
+#define CRED_DATA_LEN           256
+#define CRED_LOAD_TIMEOUT_MS    2000            // show_pass has no trailer
+
+typedef enum {
+    CRED_PORTAL = 0,            // Captive portal form fields
+    CRED_EVIL,                  // Evil Twin verified password
+    CRED_KIND_COUNT
+} cred_kind_t;
+
+typedef enum {
+    CRED_EMPTY = 0,             // Saved captures not asked for yet
+    CRED_LOADING,
+    CRED_READY,
+} cred_load_state_t;
+
+typedef struct {
+    char ssid[CRED_SSID_LEN];
+    char data[CRED_DATA_LEN];   // Portal: "field=value, field=value"; Evil: password
+} cred_entry_t;
+
+/**
+ * @brief Start following live capture lines (called once at boot)
+ * @return ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t cred_store_init(void);
+
+/**
+ * @brief Fetch the captures saved on the JanOS card, once per boot
+ * @param kind Which show_pass list
+ * @return ESP_OK if loaded, loading or requested
+ */
+esp_err_t cred_store_load(cred_kind_t kind);
+
+/**
+ * @brief Ask for a show_pass list again (background refresh)
+ *
+ * Captures already held are kept; only new ones are added.
+ * @return ESP_OK if loading or requested
+ */
+esp_err_t cred_store_reload(cred_kind_t kind);
+
+cred_load_state_t cred_store_load_state(cred_kind_t kind);
+
+/**
+ * @brief SSID that live portal captures are filed under
+ *
+ * Set by the screens that start a portal; NULL while none runs, so form
+ * posts of other attacks are not recorded as portal data.
+ * @param ssid Portal SSID or NULL
+ */
+void cred_store_set_portal_ssid(const char *ssid);
+
+/**
+ * @brief Add a capture unless the same one is stored
+ * @param kind Capture kind
+ * @param ssid Network name
+ * @param data Fields or password
+ * @param live Came from a running attack (logged to the session log)
+ * @return true if it was new
+ */
+bool cred_store_add(cred_kind_t kind, const char *ssid, const char *data, bool live);
+
+/**
+ * @return Captures of one kind, oldest first
+ */
+int cred_store_count(cred_kind_t kind);
+
+/**
+ * @brief Copy the n-th capture of one kind
+ * @return false if n is out of range
+ */
+bool cred_store_get(cred_kind_t kind, int n, cred_entry_t *out);
+
+/**
+ * @brief Bumps on every new capture and when a load finishes
+ */
+uint32_t cred_store_generation(void);
+
+#endif // CRED_STORE_H
@@ -4,13 +4,21 @@
  * 
  * Reads battery voltage through ADC on GPIO10.
  * Uses ESP-IDF v5+ ADC oneshot driver.
+ *
+ * Each sample averages BATTERY_OVERSAMPLE raw reads without the highest
+ * and lowest, converts once, and feeds an exponential filter. The trend
+ * and runtime estimate come from the filtered voltage's slope over the
+ * last BATTERY_TREND_MINUTES one-minute snapshots.
  */
 
 #include "battery.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_adc/adc_oneshot.h"
 #include "esp_adc/adc_cali.h"
 #include "esp_adc/adc_cali_scheme.h"
+#include <stdint.h>
+#include <string.h>
 
 static const char *TAG = "BATTERY";
 
@@ -27,19 +35,33 @@ static const char *TAG = "BATTERY";
 #define BATTERY_MIN_MV          3000    // 0% - battery empty
 #define BATTERY_MAX_MV          4200    // 100% - battery full
 
-// Smoothing
-#define BATTERY_SAMPLES         4       // Number of samples to average
+// Sampling
+#define BATTERY_OVERSAMPLE      16      // Raw reads per sample
+#define BATTERY_FILTER_SHIFT    3       // Filter weight of a new sample: 1/8
+#define BATTERY_TREND_MINUTES   10      // Slope window
+#define BATTERY_TREND_MV_MIN    2       // |slope| below this is "stable"
+#define SNAPSHOT_SAMPLES        (60000 / BATTERY_SAMPLE_PERIOD_MS)
+
+// Published word: voltage 13 bits | level 7 | trend 2 | runtime 10 (minutes)
+#define PACK(v, l, t, r)        ((uint32_t)(v) | ((uint32_t)(l) << 13) | \
+                                 ((uint32_t)(t) << 20) | ((uint32_t)(r) << 22))
+#define RUNTIME_UNKNOWN         0x3FF
 
 // ADC handles
 static adc_oneshot_unit_handle_t adc_handle = NULL;
 static adc_cali_handle_t cali_handle = NULL;
 static bool battery_initialized = false;
 static bool calibration_enabled = false;
+static esp_timer_handle_t sample_timer = NULL;
+
+// Sampler state (esp_timer task only)
+static int32_t filtered_mv_x16 = 0;     // Filtered voltage, 4 fractional bits
+static int snapshot_mv[BATTERY_TREND_MINUTES + 1];
+static int snapshot_count = 0;
+static int samples_since_snapshot = 0;
 
-// Smoothing buffer
-static int voltage_buffer[BATTERY_SAMPLES] = {0};
-static int buffer_index = 0;
-static bool buffer_filled = false;
+// Latest reading (any task)
+static volatile uint32_t published = 0;
 
 /**
  * @brief Initialize ADC calibration
@@ -76,6 +98,100 @@ static bool init_calibration(void)
     return false;
 }
 
+/**
+ * @brief One oversampled battery voltage reading
+ * @return Voltage in mV at the battery, or -1 on ADC error
+ */
+static int read_oversampled_mv(void)
+{
+    int sum = 0, lo = INT32_MAX, hi = INT32_MIN;
+    for (int i = 0; i < BATTERY_OVERSAMPLE; i++) {
+        int raw = 0;
+        if (adc_oneshot_read(adc_handle, BATTERY_ADC_CHANNEL, &raw) != ESP_OK) {
+            return -1;
+        }
+        sum += raw;
+        if (raw < lo) lo = raw;
+        if (raw > hi) hi = raw;
+    }
+    // Drop the extremes: single-read spikes from radio bursts
+    int raw_value = (sum - lo - hi) / (BATTERY_OVERSAMPLE - 2);
+    
+    int voltage_mv = 0;
+    
+    if (calibration_enabled && cali_handle != NULL) {
+        // Use calibrated conversion
+        if (adc_cali_raw_to_voltage(cali_handle, raw_value, &voltage_mv) != ESP_OK) {
+            // Fallback to simple conversion
+            voltage_mv = (raw_value * 3300) / 4095;
+        }
+    } else {
+        // Simple conversion without calibration
+        voltage_mv = (raw_value * 3300) / 4095;
+    }
+    
+    // Apply voltage divider ratio to get actual battery voltage
+    return (int)(voltage_mv * BATTERY_DIVIDER_RATIO);
+}
+
+static int level_from_mv(int voltage)
+{
+    // Clamp to valid range
+    if (voltage <= BATTERY_MIN_MV) {
+        return 0;
+    }
+    if (voltage >= BATTERY_MAX_MV) {
+        return 100;
+    }
+    
+    // Linear interpolation
+    return ((voltage - BATTERY_MIN_MV) * 100) / (BATTERY_MAX_MV - BATTERY_MIN_MV);
+}
+
+/**
+ * @brief Trend and minutes left from the one-minute snapshots
+ */
+static battery_trend_t compute_trend(int voltage, int *runtime_min)
+{
+    *runtime_min = RUNTIME_UNKNOWN;
+    if (snapshot_count < 2) return BATTERY_TREND_UNKNOWN;
+    
+    // Oldest snapshot against the newest, in mV per minute
+    int minutes = snapshot_count - 1;
+    int slope_x10 = (snapshot_mv[minutes] - snapshot_mv[0]) * 10 / minutes;
+    if (slope_x10 >= BATTERY_TREND_MV_MIN * 10) return BATTERY_TREND_CHARGING;
+    if (slope_x10 > -BATTERY_TREND_MV_MIN * 10) return BATTERY_TREND_STABLE;
+    
+    int left = (voltage - BATTERY_MIN_MV) * 10 / -slope_x10;
+    if (left < 0) left = 0;
+    *runtime_min = left < RUNTIME_UNKNOWN ? left : RUNTIME_UNKNOWN - 1;
+    return BATTERY_TREND_DISCHARGING;
+}
+
+static void sample_timer_cb(void *arg)
+{
+    (void)arg;
+    
+    int mv = read_oversampled_mv();
+    if (mv < 0) return;     // Keep the last reading
+    
+    filtered_mv_x16 += ((mv << 4) - filtered_mv_x16) >> BATTERY_FILTER_SHIFT;
+    int voltage = filtered_mv_x16 >> 4;
+    
+    if (++samples_since_snapshot >= SNAPSHOT_SAMPLES) {
+        samples_since_snapshot = 0;
+        if (snapshot_count > BATTERY_TREND_MINUTES) {
+            memmove(&snapshot_mv[0], &snapshot_mv[1], BATTERY_TREND_MINUTES * sizeof(snapshot_mv[0]));
+            snapshot_count = BATTERY_TREND_MINUTES;
+        }
+        snapshot_mv[snapshot_count++] = voltage;
+    }
+    
+    int runtime;
+    battery_trend_t trend = compute_trend(voltage, &runtime);
+    published = PACK(voltage & 0x1FFF, level_from_mv(voltage), trend, runtime);
+}
+
 esp_err_t battery_init(void)
 {
     ESP_LOGI(TAG, "Initializing battery monitoring (GPIO10)...");
@@ -108,15 +224,34 @@ esp_err_t battery_init(void)
     // Initialize calibration
     calibration_enabled = init_calibration();
     
-    battery_initialized = true;
+    // First reading seeds the filter so the title bar is right at once
+    int mv = read_oversampled_mv();
+    if (mv < 0) {
+        ESP_LOGE(TAG, "Initial battery read failed");
+        adc_oneshot_del_unit(adc_handle);
+        adc_handle = NULL;
+        return ESP_FAIL;
+    }
+    filtered_mv_x16 = mv << 4;
+    published = PACK(mv & 0x1FFF, level_from_mv(mv), BATTERY_TREND_UNKNOWN, RUNTIME_UNKNOWN);
     
-    // Take initial readings to fill buffer
-    for (int i = 0; i < BATTERY_SAMPLES; i++) {
-        battery_get_voltage_mv();
+    const esp_timer_create_args_t timer_args = {
+        .callback = sample_timer_cb,
+        .name = "battery",
+    };
+    ret = esp_timer_create(&timer_args, &sample_timer);
+    if (ret == ESP_OK) {
+        ret = esp_timer_start_periodic(sample_timer, BATTERY_SAMPLE_PERIOD_MS * 1000ULL);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start battery sampler: %s", esp_err_to_name(ret));
+        adc_oneshot_del_unit(adc_handle);
+        adc_handle = NULL;
+        return ret;
     }
     
-    int level = battery_get_level();
-    ESP_LOGI(TAG, "Battery monitoring initialized, level: %d%%", level);
+    battery_initialized = true;
+    ESP_LOGI(TAG, "Battery monitoring initialized, level: %d%% (%d mV)", level_from_mv(mv), mv);
     
     return ESP_OK;
 }
@@ -126,80 +261,27 @@ bool battery_is_available(void)
     return battery_initialized;
 }
 
-int battery_get_voltage_mv(void)
+battery_reading_t battery_get_reading(void)
 {
-    if (!battery_initialized || adc_handle == NULL) {
-        return -1;
-    }
-    
-    int raw_value = 0;
-    esp_err_t ret = adc_oneshot_read(adc_handle, BATTERY_ADC_CHANNEL, &raw_value);
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "ADC read failed: %s", esp_err_to_name(ret));
-        return -1;
-    }
-    
-    int voltage_mv = 0;
-    
-    if (calibration_enabled && cali_handle != NULL) {
-        // Use calibrated conversion
-        ret = adc_cali_raw_to_voltage(cali_handle, raw_value, &voltage_mv);
-        if (ret != ESP_OK) {
-            // Fallback to simple conversion
-            voltage_mv = (raw_value * 3300) / 4095;
-        }
-    } else {
-        // Simple conversion without calibration
-        voltage_mv = (raw_value * 3300) / 4095;
-    }
-    
-    // Apply voltage divider ratio to get actual battery voltage
-    int battery_voltage = (int)(voltage_mv * BATTERY_DIVIDER_RATIO);
-    
-    // Add to smoothing buffer
-    voltage_buffer[buffer_index] = battery_voltage;
-    buffer_index = (buffer_index + 1) % BATTERY_SAMPLES;
-    if (buffer_index == 0) {
-        buffer_filled = true;
-    }
+    battery_reading_t r = { -1, -1, BATTERY_TREND_UNKNOWN, -1 };
+    if (!battery_initialized) return r;
     
-    // Calculate average
-    int sum = 0;
-    int count = buffer_filled ? BATTERY_SAMPLES : buffer_index;
-    if (count == 0) count = 1;
-    
-    for (int i = 0; i < count; i++) {
-        sum += voltage_buffer[i];
-    }
-    
-    return sum / count;
+    // One load: the fields always belong to the same sample
+    uint32_t word = published;
+    r.voltage_mv = word & 0x1FFF;
+    r.level = (word >> 13) & 0x7F;
+    r.trend = (battery_trend_t)((word >> 20) & 0x3);
+    int runtime = (word >> 22) & 0x3FF;
+    r.runtime_min = runtime == RUNTIME_UNKNOWN ? -1 : runtime;
+    return r;
 }
 
-int battery_get_level(void)
+int battery_get_voltage_mv(void)
 {
-    int voltage = battery_get_voltage_mv();
-    if (voltage < 0) {
-        return -1;
-    }
-    
-    // Clamp to valid range
-    if (voltage <= BATTERY_MIN_MV) {
-        return 0;
-    }
-    if (voltage >= BATTERY_MAX_MV) {
-        return 100;
-    }
-    
-    // Linear interpolation
-    int level = ((voltage - BATTERY_MIN_MV) * 100) / (BATTERY_MAX_MV - BATTERY_MIN_MV);
-    
-    return level;
+    return battery_get_reading().voltage_mv;
 }
 
-
-
-
-
-
-
-
+int battery_get_level(void)
+{
+    return battery_get_reading().level;
+}
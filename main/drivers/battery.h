@@ -2,7 +2,10 @@
  * @file battery.h
  * @brief Battery level monitoring for M5Stack Cardputer-Adv
  * 
- * Uses ADC on GPIO10 to read battery voltage
+ * Uses ADC on GPIO10 to read battery voltage. A background esp_timer takes
+ * an oversampled, filtered reading every BATTERY_SAMPLE_PERIOD_MS and
+ * publishes it as one word, so the getters never touch the ADC and are
+ * safe to call from any task at any rate.
  */
 
 #ifndef BATTERY_H
@@ -11,12 +14,35 @@
 #include "esp_err.h"
 #include <stdbool.h>
 
+#define BATTERY_SAMPLE_PERIOD_MS    2000
+
+// Voltage direction over the last minutes
+typedef enum {
+    BATTERY_TREND_UNKNOWN = 0,  // Not enough history yet
+    BATTERY_TREND_STABLE,
+    BATTERY_TREND_CHARGING,
+    BATTERY_TREND_DISCHARGING,
+} battery_trend_t;
+
+// One published reading
+typedef struct {
+    int voltage_mv;             // -1 if not available
+    int level;                  // 0-100%, -1 if not available
+    battery_trend_t trend;
+    int runtime_min;            // Estimated minutes left while discharging, -1 if unknown
+} battery_reading_t;
+
 /**
  * @brief Initialize battery monitoring
  * @return ESP_OK on success, error code otherwise
  */
 esp_err_t battery_init(void);
 
+/**
+ * @brief Get the latest reading (voltage, level, trend and runtime together)
+ */
+battery_reading_t battery_get_reading(void);
+
 /**
  * @brief Get battery level as percentage
  * @return Battery level 0-100%, or -1 if not available
@@ -24,7 +50,7 @@ esp_err_t battery_init(void);
 int battery_get_level(void);
 
 /**
- * @brief Get raw battery voltage in millivolts
+ * @brief Get filtered battery voltage in millivolts
  * @return Voltage in mV, or -1 if not available
  */
 int battery_get_voltage_mv(void);
@@ -36,11 +62,3 @@ int battery_get_voltage_mv(void);
 bool battery_is_available(void);
 
 #endif // BATTERY_H
-
-
-
-
-
-
-
-
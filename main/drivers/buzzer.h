@@ -1,6 +1,9 @@
 /**
  * @file buzzer.h
  * @brief Audio driver for M5Stack Cardputer (ADV/K132)
+ *
+ * All beep functions only queue tones for the audio task (buzzer_engine.c)
+ * and return immediately, so they are safe from UART callbacks and timers.
  */
 
 #ifndef BUZZER_H
@@ -22,6 +25,26 @@
 // Speaker amplifier enable pin (active high, ADV only)
 #define SPEAKER_EN_PIN  46
 
+// One step of a tone sequence; frequency_hz 0 is a pause
+typedef struct {
+    uint16_t frequency_hz;
+    uint16_t duration_ms;
+} buzzer_tone_t;
+
+// Encodings accepted by buzzer_play_sample()
+typedef enum {
+    BUZZER_SAMPLE_PCM16 = 0,        // Signed 16-bit mono
+    BUZZER_SAMPLE_IMA_ADPCM,        // Headerless mono IMA ADPCM, low nibble first
+} buzzer_sample_format_t;
+
+// Recorded alert sound, normally const data in flash
+typedef struct {
+    const void *data;
+    uint32_t frames;                // Samples (nibbles for ADPCM)
+    uint16_t rate_hz;               // Source rate, resampled to the I2S rate
+    uint8_t format;                 // buzzer_sample_format_t
+} buzzer_sample_t;
+
 /**
  * @brief Initialize the audio driver (ES8311 + I2S)
  * @return ESP_OK on success
@@ -33,6 +56,24 @@ esp_err_t buzzer_init(void);
  */
 void buzzer_beep(uint32_t frequency_hz, uint32_t duration_ms);
 
+/**
+ * @brief Queue a tone sequence after whatever is already playing
+ *
+ * The sequence is dropped whole if the queue cannot hold it.
+ * @param tones Steps to play (copied)
+ * @param count Number of steps
+ */
+void buzzer_play(const buzzer_tone_t *tones, int count);
+
+/**
+ * @brief Queue a recorded sound after whatever is already playing
+ *
+ * Only the pointer is queued: sample and its data must stay valid until
+ * played (use static const data).
+ * @param sample Sound to play
+ */
+void buzzer_play_sample(const buzzer_sample_t *sample);
+
 /**
  * @brief Play a short beep when attack starts
  */
@@ -49,7 +90,7 @@ void buzzer_beep_success(void);
 void buzzer_beep_capture(void);
 
 /**
- * @brief Stop any currently playing tone
+ * @brief Stop the current tone and drop queued ones
  */
 void buzzer_stop(void);
 
@@ -6,6 +6,7 @@
  */
 
 #include "buzzer.h"
+#include "buzzer_engine.h"
 #include "driver/i2s_std.h"
 #include "driver/i2c.h"
 #include "driver/gpio.h"
@@ -13,22 +14,16 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
-#include <math.h>
 
 static const char *TAG = "BUZZER";
 
-#define I2S_SAMPLE_RATE     48000
-#define TONE_AMPLITUDE      6000
-#define CHUNK_FRAMES        512   // Fixed buffer size
+#define I2S_SAMPLE_RATE     BUZZER_SAMPLE_RATE
 
 #define ES8311_I2C_PORT     I2C_NUM_0
 
 static i2s_chan_handle_t tx_handle = NULL;
 static bool buzzer_initialized = false;
 
-// Fixed buffer to avoid malloc during beep
-static int16_t audio_buffer[CHUNK_FRAMES * 2];
-
 static esp_err_t es8311_write_reg(uint8_t reg, uint8_t val)
 {
     uint8_t data[2] = {reg, val};
@@ -157,10 +152,12 @@ esp_err_t buzzer_init(void)
         ESP_LOGW(TAG, "ES8311 init failed");
     }
     
-    // Prime DMA buffers with silence
-    memset(audio_buffer, 0, sizeof(audio_buffer));
-    size_t bytes_written;
-    i2s_channel_write(tx_handle, audio_buffer, sizeof(audio_buffer), &bytes_written, 100);
+    // Audio task owns the channel from here on
+    ret = buzzer_engine_start(tx_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Audio task start failed");
+        return ret;
+    }
     
     buzzer_initialized = true;
     ESP_LOGI(TAG, "Audio initialized");
@@ -170,73 +167,3 @@ esp_err_t buzzer_init(void)
     
     return ESP_OK;
 }
-
-void buzzer_beep(uint32_t frequency_hz, uint32_t duration_ms)
-{
-    if (!buzzer_initialized || !tx_handle) {
-        return;
-    }
-    
-    if (frequency_hz < 100) frequency_hz = 100;
-    if (frequency_hz > 8000) frequency_hz = 8000;
-    
-    ESP_LOGI(TAG, "Beep: %lu Hz, %lu ms", (unsigned long)frequency_hz, (unsigned long)duration_ms);
-    
-    uint32_t total_frames = (I2S_SAMPLE_RATE * duration_ms) / 1000;
-    uint32_t frames_done = 0;
-    size_t bytes_written;
-    
-    // Generate and play in chunks using fixed buffer
-    while (frames_done < total_frames) {
-        uint32_t chunk_frames = (total_frames - frames_done > CHUNK_FRAMES) 
-                               ? CHUNK_FRAMES : (total_frames - frames_done);
-        
-        // Generate sine wave chunk
-        for (uint32_t i = 0; i < chunk_frames; i++) {
-            uint32_t global_i = frames_done + i;
-            float amp = TONE_AMPLITUDE;
-            
-            // Fade out at end
-            if (global_i >= total_frames - 200 && total_frames > 200) {
-                amp *= (float)(total_frames - global_i) / 200.0f;
-            }
-            
-            int16_t val = (int16_t)(amp * sinf(2.0f * M_PI * frequency_hz * global_i / I2S_SAMPLE_RATE));
-            audio_buffer[i * 2] = val;
-            audio_buffer[i * 2 + 1] = val;
-        }
-        
-        // Write with short timeout to avoid blocking too long
-        i2s_channel_write(tx_handle, audio_buffer, chunk_frames * 4, &bytes_written, pdMS_TO_TICKS(50));
-        frames_done += chunk_frames;
-    }
-    
-    // Short silence at end
-    memset(audio_buffer, 0, 256 * 4);
-    i2s_channel_write(tx_handle, audio_buffer, 256 * 4, &bytes_written, pdMS_TO_TICKS(20));
-}
-
-void buzzer_beep_attack(void)
-{
-    buzzer_beep(2000, 80);
-}
-
-void buzzer_beep_success(void)
-{
-    buzzer_beep(1000, 100);
-    vTaskDelay(pdMS_TO_TICKS(30));
-    buzzer_beep(1500, 150);
-}
-
-void buzzer_beep_capture(void)
-{
-    buzzer_beep(1200, 60);
-}
-
-void buzzer_stop(void)
-{
-    if (!buzzer_initialized || !tx_handle) return;
-    memset(audio_buffer, 0, sizeof(audio_buffer));
-    size_t bytes_written;
-    i2s_channel_write(tx_handle, audio_buffer, sizeof(audio_buffer), &bytes_written, 0);
-}
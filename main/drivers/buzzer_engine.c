@@ -0,0 +1,361 @@
+/**
+ * @file buzzer_engine.c
+ * @brief Tone synthesizer task shared by the board audio drivers
+ */
+
+#include "buzzer.h"
+#include "buzzer_engine.h"
+#include "task_plan.h"
+#include "assets.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <string.h>
+#include <math.h>
+
+static const char *TAG = "BUZZER";
+
+#define TONE_AMPLITUDE      6000
+#define CHUNK_FRAMES        512
+#define FADE_FRAMES         200     // Linear fade-out at the end of a tone
+#define TAIL_FRAMES         256     // Silence written after the last queued tone
+
+// 256-entry sine table indexed by the top 8 bits of the phase
+#define WAVE_BITS           8
+#define WAVE_SIZE           (1 << WAVE_BITS)
+
+// Source position step for samples, 16.16 fixed point
+#define POS_FRAC_BITS       16
+
+// Queue entry: a synthesized tone or a pointer to a recorded sound
+typedef enum {
+    CMD_TONE = 0,
+    CMD_SAMPLE,
+} cmd_type_t;
+
+typedef struct {
+    uint8_t type;                   // cmd_type_t
+    union {
+        buzzer_tone_t tone;
+        const buzzer_sample_t *sample;
+    };
+} buzzer_cmd_t;
+
+// IMA ADPCM decoder state
+typedef struct {
+    int32_t predictor;
+    int index;
+} adpcm_state_t;
+
+static const int16_t adpcm_steps[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int8_t adpcm_index_adjust[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+// Alerts that a recorded sound from the asset bundle replaces
+typedef enum {
+    ALERT_ATTACK = 0,
+    ALERT_SUCCESS,
+    ALERT_CAPTURE,
+    ALERT_COUNT
+} alert_id_t;
+
+static const char *const alert_asset_names[ALERT_COUNT] = {
+    [ALERT_ATTACK]  = "snd/attack",
+    [ALERT_SUCCESS] = "snd/success",
+    [ALERT_CAPTURE] = "snd/capture",
+};
+
+// Queued by pointer, so kept for the lifetime of the firmware
+static buzzer_sample_t alert_samples[ALERT_COUNT];
+
+static int16_t wavetable[WAVE_SIZE];
+static int16_t audio_buffer[CHUNK_FRAMES * 2];
+
+static i2s_chan_handle_t tx_handle = NULL;
+static QueueHandle_t cmd_queue = NULL;
+static volatile bool stop_requested = false;
+
+static void write_frames(uint32_t frames)
+{
+    size_t bytes_written;
+    i2s_channel_write(tx_handle, audio_buffer, frames * 4, &bytes_written, portMAX_DELAY);
+}
+
+static void render_silence(uint32_t frames)
+{
+    memset(audio_buffer, 0, sizeof(audio_buffer));
+    while (frames > 0 && !stop_requested) {
+        uint32_t n = frames > CHUNK_FRAMES ? CHUNK_FRAMES : frames;
+        write_frames(n);
+        frames -= n;
+    }
+}
+
+static void render_tone(const buzzer_tone_t *tone)
+{
+    uint32_t total_frames = (BUZZER_SAMPLE_RATE * tone->duration_ms) / 1000;
+    if (tone->frequency_hz == 0) {
+        render_silence(total_frames);
+        return;
+    }
+    
+    // Phase step in 1/2^32 of a cycle per frame
+    uint32_t step = (uint32_t)(((uint64_t)tone->frequency_hz << 32) / BUZZER_SAMPLE_RATE);
+    uint32_t phase = 0;
+    uint32_t frames_done = 0;
+    
+    while (frames_done < total_frames && !stop_requested) {
+        uint32_t chunk_frames = (total_frames - frames_done > CHUNK_FRAMES)
+                               ? CHUNK_FRAMES : (total_frames - frames_done);
+        
+        for (uint32_t i = 0; i < chunk_frames; i++) {
+            int32_t val = wavetable[phase >> (32 - WAVE_BITS)];
+            phase += step;
+            
+            uint32_t remaining = total_frames - (frames_done + i);
+            if (remaining < FADE_FRAMES && total_frames > FADE_FRAMES) {
+                val = val * (int32_t)remaining / FADE_FRAMES;
+            }
+            audio_buffer[i * 2] = (int16_t)val;
+            audio_buffer[i * 2 + 1] = (int16_t)val;
+        }
+        
+        write_frames(chunk_frames);
+        frames_done += chunk_frames;
+    }
+}
+
+static int16_t adpcm_decode(adpcm_state_t *st, uint8_t nibble)
+{
+    int step = adpcm_steps[st->index];
+    int32_t diff = step >> 3;
+    if (nibble & 4) diff += step;
+    if (nibble & 2) diff += step >> 1;
+    if (nibble & 1) diff += step >> 2;
+    
+    st->predictor += (nibble & 8) ? -diff : diff;
+    if (st->predictor > INT16_MAX) st->predictor = INT16_MAX;
+    if (st->predictor < INT16_MIN) st->predictor = INT16_MIN;
+    
+    st->index += adpcm_index_adjust[nibble & 7];
+    if (st->index < 0) st->index = 0;
+    if (st->index > 88) st->index = 88;
+    return (int16_t)st->predictor;
+}
+
+// Fetch source sample n; ADPCM is decoded strictly in order
+static int16_t sample_at(const buzzer_sample_t *sample, uint32_t n, adpcm_state_t *st)
+{
+    if (sample->format == BUZZER_SAMPLE_PCM16) {
+        return ((const int16_t *)sample->data)[n];
+    }
+    uint8_t byte = ((const uint8_t *)sample->data)[n >> 1];
+    return adpcm_decode(st, (n & 1) ? (byte >> 4) : (byte & 0x0F));
+}
+
+static void render_sample(const buzzer_sample_t *sample)
+{
+    if (!sample->data || sample->frames == 0 || sample->rate_hz == 0) return;
+    
+    // Linear interpolation between the last two source samples
+    uint32_t step = ((uint32_t)sample->rate_hz << POS_FRAC_BITS) / BUZZER_SAMPLE_RATE;
+    uint32_t pos = 0;
+    uint32_t fetched = 0;
+    int32_t prev = 0;
+    int32_t cur = 0;
+    adpcm_state_t st = { 0 };
+    
+    while (!stop_requested) {
+        uint32_t chunk_frames = 0;
+        for (; chunk_frames < CHUNK_FRAMES; chunk_frames++) {
+            uint32_t want = (pos >> POS_FRAC_BITS) + 1;
+            if (want > sample->frames) break;
+            while (fetched < want) {
+                prev = cur;
+                cur = sample_at(sample, fetched++, &st);
+            }
+            int32_t frac = pos & ((1 << POS_FRAC_BITS) - 1);
+            int32_t val = prev + (int32_t)(((int64_t)(cur - prev) * frac) >> POS_FRAC_BITS);
+            audio_buffer[chunk_frames * 2] = (int16_t)val;
+            audio_buffer[chunk_frames * 2 + 1] = (int16_t)val;
+            pos += step;
+        }
+        if (chunk_frames == 0) break;
+        write_frames(chunk_frames);
+    }
+}
+
+static void audio_task(void *arg)
+{
+    (void)arg;
+    buzzer_cmd_t cmd;
+    
+    while (1) {
+        xQueueReceive(cmd_queue, &cmd, portMAX_DELAY);
+        stop_requested = false;
+        if (cmd.type == CMD_SAMPLE) {
+            render_sample(cmd.sample);
+        } else {
+            render_tone(&cmd.tone);
+        }
+        
+        // Queue drained: end on silence so the DMA ring does not loop the tone
+        if (uxQueueMessagesWaiting(cmd_queue) == 0) {
+            stop_requested = false;
+            render_silence(TAIL_FRAMES);
+        }
+    }
+}
+
+/**
+ * @brief Resolve the alert sounds of the asset bundle
+ */
+static void load_alert_sounds(void)
+{
+    for (int i = 0; i < ALERT_COUNT; i++) {
+        size_t size = 0;
+        const uint8_t *blob = assets_find(alert_asset_names[i], &size);
+        if (!blob || size < sizeof(assets_sound_t)) continue;
+
+        assets_sound_t hdr;
+        memcpy(&hdr, blob, sizeof(hdr));
+        size_t data_size = size - sizeof(hdr);
+        bool fits = (hdr.format == BUZZER_SAMPLE_PCM16 && hdr.frames <= data_size / 2) ||
+                    (hdr.format == BUZZER_SAMPLE_IMA_ADPCM && hdr.frames <= data_size * 2);
+        if (!fits || hdr.frames == 0 || hdr.rate_hz == 0) {
+            ESP_LOGW(TAG, "Ignoring malformed %s", alert_asset_names[i]);
+            continue;
+        }
+        alert_samples[i] = (buzzer_sample_t){
+            .data = blob + sizeof(hdr),
+            .frames = hdr.frames,
+            .rate_hz = hdr.rate_hz,
+            .format = hdr.format,
+        };
+        ESP_LOGI(TAG, "Alert %s: %lu frames at %u Hz", alert_asset_names[i],
+                 (unsigned long)hdr.frames, hdr.rate_hz);
+    }
+}
+
+/**
+ * @brief Play an alert from the asset bundle
+ * @return false if the bundle has none, to fall back to tones
+ */
+static bool play_alert(alert_id_t id)
+{
+    if (!alert_samples[id].data) return false;
+    buzzer_play_sample(&alert_samples[id]);
+    return true;
+}
+
+esp_err_t buzzer_engine_start(i2s_chan_handle_t tx)
+{
+    if (cmd_queue) return ESP_OK;
+    if (!tx) return ESP_ERR_INVALID_ARG;
+    
+    for (int i = 0; i < WAVE_SIZE; i++) {
+        wavetable[i] = (int16_t)(TONE_AMPLITUDE * sinf(2.0f * (float)M_PI * i / WAVE_SIZE));
+    }
+    tx_handle = tx;
+    load_alert_sounds();
+    
+    // Prime DMA buffers with silence
+    memset(audio_buffer, 0, sizeof(audio_buffer));
+    size_t bytes_written;
+    i2s_channel_write(tx_handle, audio_buffer, sizeof(audio_buffer), &bytes_written, 100);
+    
+    cmd_queue = xQueueCreate(BUZZER_QUEUE_LEN, sizeof(buzzer_cmd_t));
+    if (!cmd_queue) {
+        ESP_LOGE(TAG, "Failed to create tone queue");
+        return ESP_ERR_NO_MEM;
+    }
+    TaskHandle_t audio_handle = NULL;
+    if (xTaskCreatePinnedToCore(audio_task, "audio", TASK_AUDIO_STACK, NULL,
+                                TASK_AUDIO_PRIO, &audio_handle, TASK_AUDIO_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create audio task");
+        vQueueDelete(cmd_queue);
+        cmd_queue = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    task_plan_track(TASK_ID_AUDIO, audio_handle);
+    return ESP_OK;
+}
+
+void buzzer_play(const buzzer_tone_t *tones, int count)
+{
+    if (!cmd_queue || !tones) return;
+    
+    // A sequence is queued whole or not at all, never cut short
+    if ((int)uxQueueSpacesAvailable(cmd_queue) < count) {
+        ESP_LOGD(TAG, "Tone queue full, dropping %d tone(s)", count);
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        buzzer_cmd_t cmd = { .type = CMD_TONE, .tone = tones[i] };
+        if (cmd.tone.frequency_hz != 0) {
+            if (cmd.tone.frequency_hz < 100) cmd.tone.frequency_hz = 100;
+            if (cmd.tone.frequency_hz > 8000) cmd.tone.frequency_hz = 8000;
+        }
+        xQueueSend(cmd_queue, &cmd, 0);
+    }
+}
+
+void buzzer_play_sample(const buzzer_sample_t *sample)
+{
+    if (!cmd_queue || !sample) return;
+    
+    buzzer_cmd_t cmd = { .type = CMD_SAMPLE, .sample = sample };
+    if (xQueueSend(cmd_queue, &cmd, 0) != pdTRUE) {
+        ESP_LOGD(TAG, "Tone queue full, dropping sample");
+    }
+}
+
+void buzzer_beep(uint32_t frequency_hz, uint32_t duration_ms)
+{
+    ESP_LOGD(TAG, "Beep: %lu Hz, %lu ms", (unsigned long)frequency_hz, (unsigned long)duration_ms);
+    
+    if (frequency_hz == 0) frequency_hz = 100;
+    buzzer_tone_t tone = {
+        .frequency_hz = frequency_hz > UINT16_MAX ? UINT16_MAX : (uint16_t)frequency_hz,
+        .duration_ms = duration_ms > UINT16_MAX ? UINT16_MAX : (uint16_t)duration_ms,
+    };
+    buzzer_play(&tone, 1);
+}
+
+void buzzer_beep_attack(void)
+{
+    if (play_alert(ALERT_ATTACK)) return;
+    buzzer_beep(2000, 80);
+}
+
+void buzzer_beep_success(void)
+{
+    if (play_alert(ALERT_SUCCESS)) return;
+    static const buzzer_tone_t success[] = {
+        { 1000, 100 },
+        { 0, 30 },
+        { 1500, 150 },
+    };
+    buzzer_play(success, sizeof(success) / sizeof(success[0]));
+}
+
+void buzzer_beep_capture(void)
+{
+    if (play_alert(ALERT_CAPTURE)) return;
+    buzzer_beep(1200, 60);
+}
+
+void buzzer_stop(void)
+{
+    if (!cmd_queue) return;
+    xQueueReset(cmd_queue);
+    stop_requested = true;
+}
@@ -0,0 +1,28 @@
+/**
+ * @file buzzer_engine.h
+ * @brief Tone synthesizer task shared by the board audio drivers
+ *
+ * The board driver brings up its codec/amplifier and I2S channel, then
+ * hands the channel to the engine. buzzer_beep() and the tone sequences in
+ * buzzer.h only queue commands; an audio task renders them from a sine
+ * wavetable with a phase accumulator, or plays PCM16/IMA ADPCM samples
+ * resampled in fixed point, so callers never block on I2S.
+ */
+
+#ifndef BUZZER_ENGINE_H
+#define BUZZER_ENGINE_H
+
+#include "driver/i2s_std.h"
+#include "esp_err.h"
+
+#define BUZZER_SAMPLE_RATE      48000
+#define BUZZER_QUEUE_LEN        16
+
+/**
+ * @brief Start the audio task on an enabled 16-bit stereo I2S TX channel
+ * @param tx Channel configured for BUZZER_SAMPLE_RATE
+ * @return ESP_OK on success
+ */
+esp_err_t buzzer_engine_start(i2s_chan_handle_t tx);
+
+#endif // BUZZER_ENGINE_H
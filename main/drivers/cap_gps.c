@@ -1,19 +1,31 @@
 /**
  * @file cap_gps.c
  * @brief LoRa CAP GPS driver - reads NMEA from CAP device via UART2 (pins TX=15, RX=13)
+ *
+ * With CONFIG_CAP_GPS_ASSIST the last fix is kept in NVS and handed back
+ * to the ATGM336H as a CASIC AID-INI message at start, together with the
+ * system time when it survived the restart (software reset, not power
+ * off). The module then only searches for satellites it expects overhead.
  */
 
 #include "cap_gps.h"
+#include "task_plan.h"
+#include "time_sync.h"
+#include "mem_monitor.h"
+#include "sdkconfig.h"
 #include "driver/uart.h"
 #include "driver/gpio.h"
+#include "nvs.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
-#include <math.h>
+#include <sys/time.h>
 
 static const char *TAG = "CAP_GPS";
 
@@ -25,174 +37,507 @@ static const char *TAG = "CAP_GPS";
 #define CAP_LINE_SIZE   256
 #define CAP_FIX_TIMEOUT_US  2000000  // 2 seconds - no data = fix lost
 
+#ifdef CONFIG_CAP_GPS_RATE_HZ
+#define CAP_RATE_HZ     CONFIG_CAP_GPS_RATE_HZ
+#else
+#define CAP_RATE_HZ     5
+#endif
+
+#define NMEA_MAX_FIELDS 24      // GSV carries 4 satellites x 4 fields + header
+
+#ifdef CONFIG_CAP_GPS_HINT_SAVE_S
+#define HINT_SAVE_US    (CONFIG_CAP_GPS_HINT_SAVE_S * 1000000LL)
+#else
+#define HINT_SAVE_US    (600 * 1000000LL)
+#endif
+
+#define NVS_NAMESPACE       "cap_gps"
+#define NVS_KEY_HINT        "hint"
+#define HINT_VERSION        1
+#define HINT_MOVE_E7        90000           // ~1 km of latitude before saving again
+#define HINT_MIN_UTC        1704067200u     // 2024-01-01: an earlier clock was never set
+#define HINT_POS_ACC_M      10000.0f        // Where the device was, not where it is
+#define HINT_TIME_ACC_S     2.0f            // RTC drift over a restart
+
+// GPS time: weeks and seconds since 1980-01-06, no leap seconds
+#define GPS_EPOCH_UNIX      315964800u
+#define GPS_LEAP_SECONDS    18
+#define GPS_WEEK_S          604800u
+
+// Stored last fix; append new fields at the end only
+typedef struct {
+    uint16_t version;
+    uint16_t size;
+    int32_t lat_e7;
+    int32_t lon_e7;
+    int32_t alt_dm;
+    uint32_t utc_time;          // Unix seconds of the fix, 0 if the date was unknown
+} gps_hint_t;
+
+// CASIC AID-INI (class 0x0B, id 0x01): position and time aiding
+typedef struct {
+    double lat;                 // Degrees (LLA flag set)
+    double lon;
+    double alt;                 // Metres
+    double tow;                 // GPS time of week, seconds
+    float freq_offset;
+    float pos_acc;              // Metres
+    float time_acc;             // Seconds
+    float freq_acc;
+    uint32_t reserved;
+    uint16_t week;
+    uint8_t time_source;
+    uint8_t flags;
+} casic_aid_ini_t;
+
+_Static_assert(sizeof(casic_aid_ini_t) == 56, "AID-INI payload is 56 bytes");
+
+#define CASIC_AID_INI_POS_VALID     0x01
+#define CASIC_AID_INI_TIME_VALID    0x02
+#define CASIC_AID_INI_LLA           0x20
+
 // GPS state
-static SemaphoreHandle_t gps_mutex = NULL;
 static TaskHandle_t gps_task_handle = NULL;
 static volatile bool gps_running = false;
+static int32_t gps_mem_bytes = 0;            // Attributed to MEM_SUB_GPS while running
+
+// Writer copy (GPS task only) and the published copy readers take
+// through a sequence lock: odd seq = publish in progress
+static cap_gps_snapshot_t work;
+static cap_gps_snapshot_t shared;
+static volatile uint32_t shared_seq = 0;
+static portMUX_TYPE publish_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Parser counters, written by the GPS task only
+static volatile uint32_t sentence_count = 0;
+static volatile uint32_t checksum_error_count = 0;
+
+// Hot-start hint bookkeeping (GPS task, and deinit once the task stopped)
+static int64_t start_us = 0;
+static bool first_fix_seen = false;
+static bool aided = false;
+static int64_t hint_saved_us = 0;
+static gps_hint_t hint_saved;
+
+// Snapshot bytes covered by the version (everything before it)
+#define SNAPSHOT_CONTENT_SIZE   offsetof(cap_gps_snapshot_t, version)
+
+// Fix notifications, called on the GPS task
+static SemaphoreHandle_t callback_mutex = NULL;
+static cap_gps_fix_callback_t fix_callback = NULL;
+static void *fix_callback_user_data = NULL;
+static bool reported_fix = false;
+
+// Sentence assembly: bytes are stored once, fields are offsets into them
+typedef enum {
+    NMEA_IDLE = 0,      // Waiting for '$'
+    NMEA_BODY,          // Between '$' and '*'
+    NMEA_CHECKSUM_HI,
+    NMEA_CHECKSUM_LO,
+} nmea_state_t;
 
 static struct {
-    double lat;
-    double lon;
-    double alt;
-    double hdop;
-    int satellites;
-    bool fix;
-    int64_t last_update_us;
-} gps_data;
+    nmea_state_t state;
+    uint8_t checksum;
+    uint8_t expected;
+    int len;
+    int field_count;
+    uint16_t field_start[NMEA_MAX_FIELDS];
+    char buf[CAP_LINE_SIZE];
+} nmea;
+
+// Sentence IDs packed as three characters
+#define NMEA_ID(a, b, c)    (((uint32_t)(a) << 16) | ((uint32_t)(b) << 8) | (uint32_t)(c))
 
 /**
- * @brief Convert NMEA coordinate (DDMM.MMMM) to decimal degrees
+ * @brief Publish the writer copy if anything readers can see has changed
+ *
+ * The copy runs inside a critical section so a reader that preempts the
+ * GPS task on the same core never finds the sequence stuck odd; readers
+ * on the other core retry for the few hundred cycles the copy takes.
  */
-static double nmea_to_decimal(const char *coord, char hemisphere)
+static void publish(void)
 {
-    if (!coord || !coord[0]) return 0.0;
-
-    double raw = strtod(coord, NULL);
-    int degrees = (int)(raw / 100.0);
-    double minutes = raw - (degrees * 100.0);
-    double decimal = degrees + (minutes / 60.0);
+    if (memcmp(&work, &shared, SNAPSHOT_CONTENT_SIZE) == 0) return;
+    
+    portENTER_CRITICAL(&publish_lock);
+    __atomic_store_n(&shared_seq, shared_seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&shared, &work, SNAPSHOT_CONTENT_SIZE);
+    shared.version++;
+    __atomic_store_n(&shared_seq, shared_seq + 1, __ATOMIC_RELEASE);
+    portEXIT_CRITICAL(&publish_lock);
+}
 
-    if (hemisphere == 'S' || hemisphere == 'W') {
-        decimal = -decimal;
+/**
+ * @brief Tell the subscriber about a new position or a change of fix state
+ * @param position true after a sentence that carried a fresh position
+ */
+static void notify_fix(bool position)
+{
+    cap_gps_fix_t fix;
+    fix.fix = work.fix;
+    fix.lat_e7 = work.lat_e7;
+    fix.lon_e7 = work.lon_e7;
+    fix.alt_dm = work.alt_dm;
+    fix.hdop_x100 = work.hdop_x100;
+    fix.satellites = work.satellites;
+    fix.time_us = work.fix_time_us;
+    fix.utc_time = work.utc_time;
+    fix.utc_ms = work.utc_ms;
+    
+    if (!(position && fix.fix) && fix.fix == reported_fix) return;
+    reported_fix = fix.fix;
+    
+    xSemaphoreTake(callback_mutex, portMAX_DELAY);
+    if (fix_callback) {
+        fix_callback(&fix, fix_callback_user_data);
     }
-    return decimal;
+    xSemaphoreGive(callback_mutex);
+}
+
+static const char *field(int index)
+{
+    return index < nmea.field_count ? &nmea.buf[nmea.field_start[index]] : "";
 }
 
 /**
- * @brief Parse $GPGGA sentence
- * Format: $GPGGA,time,lat,N/S,lon,E/W,fix,sats,hdop,alt,M,...
+ * @brief Decimal field as a fixed-point integer with the given decimals
+ *
+ * "12.345" with decimals=2 gives 1234; extra digits are truncated.
  */
-static void parse_gga(const char *nmea)
+static int64_t field_fixed(int index, int decimals)
 {
-    char buf[CAP_LINE_SIZE];
-    strncpy(buf, nmea, sizeof(buf) - 1);
-    buf[sizeof(buf) - 1] = '\0';
-
-    char *save = NULL;
-    char *tok = strtok_r(buf, ",", &save);
-    int field = 0;
-
-    char lat_str[16] = {0}, ns = 0;
-    char lon_str[16] = {0}, ew = 0;
-    int fix_quality = -1;
-    int sats = -1;
-    double hdop_val = 99.9;
-    double alt_val = 0.0;
-
-    while (tok) {
-        switch (field) {
-            case 2:
-                strncpy(lat_str, tok, sizeof(lat_str) - 1);
-                break;
-            case 3:
-                if (tok[0]) ns = tok[0];
-                break;
-            case 4:
-                strncpy(lon_str, tok, sizeof(lon_str) - 1);
-                break;
-            case 5:
-                if (tok[0]) ew = tok[0];
-                break;
-            case 6:
-                fix_quality = atoi(tok);
-                break;
-            case 7:
-                sats = atoi(tok);
-                break;
-            case 8:
-                hdop_val = strtod(tok, NULL);
-                break;
-            case 9:
-                alt_val = strtod(tok, NULL);
-                break;
-        }
-        tok = strtok_r(NULL, ",", &save);
-        field++;
+    const char *p = field(index);
+    bool negative = (*p == '-');
+    if (negative) p++;
+    
+    int64_t value = 0;
+    while (*p >= '0' && *p <= '9') {
+        value = value * 10 + (*p++ - '0');
     }
+    if (*p == '.') p++;
+    for (int i = 0; i < decimals; i++) {
+        value *= 10;
+        if (*p >= '0' && *p <= '9') value += *p++ - '0';
+    }
+    return negative ? -value : value;
+}
+
+static int field_int(int index)
+{
+    return (int)field_fixed(index, 0);
+}
 
-    xSemaphoreTake(gps_mutex, portMAX_DELAY);
+/**
+ * @brief NMEA coordinate (D)DDMM.MMMM plus hemisphere to degrees x 1e7
+ * @return false if either field is empty
+ */
+static bool field_coordinate(int index, int32_t *out)
+{
+    const char *hemi = field(index + 1);
+    if (!field(index)[0] || !hemi[0]) return false;
+    
+    // Minutes x 1e6 keep 0.1 mm resolution through the division
+    int64_t raw = field_fixed(index, 6);
+    int64_t degrees = raw / 100000000;
+    int64_t minutes_e6 = raw % 100000000;
+    int64_t value = degrees * 10000000 + minutes_e6 / 6;
+    
+    *out = (int32_t)((hemi[0] == 'S' || hemi[0] == 'W') ? -value : value);
+    return true;
+}
 
-    if (sats >= 0) {
-        gps_data.satellites = sats;
+/**
+ * @brief Time field (hhmmss.sss) as milliseconds since midnight
+ * @return false if the field is missing or malformed
+ */
+static bool field_time_of_day(int index, int32_t *ms)
+{
+    if (strlen(field(index)) < 6) return false;
+    int64_t hms_ms = field_fixed(index, 3);         // hhmmss x 1000
+    int h = (int)(hms_ms / 10000000), mi = (int)(hms_ms / 100000 % 100);
+    int sec = (int)(hms_ms / 1000 % 100);
+    if (h > 23 || mi > 59 || sec > 60) return false;
+    *ms = ((h * 60 + mi) * 60 + sec) * 1000 + (int32_t)(hms_ms % 1000);
+    return true;
+}
+
+/**
+ * @brief RMC time (hhmmss.sss) and date (ddmmyy) as Unix seconds
+ * @return false if either field is missing or malformed
+ */
+static bool field_utc(int time_index, int date_index, uint32_t *seconds, uint16_t *ms)
+{
+    int32_t tod_ms;
+    if (!field_time_of_day(time_index, &tod_ms) || strlen(field(date_index)) != 6) return false;
+    
+    int date = field_int(date_index);
+    int day = date / 10000, mo = date / 100 % 100, y = date % 100;
+    y += (y < 80) ? 2000 : 1900;     // Two-digit year, 1980-2079
+    if (mo < 1 || mo > 12 || day < 1) return false;
+    
+    int64_t days = time_sync_days_from_civil(y, mo, day);
+    *seconds = (uint32_t)(days * 86400 + tod_ms / 1000);
+    *ms = (uint16_t)(tod_ms % 1000);
+    return true;
+}
+
+/**
+ * @brief GGA carries only the time of day: date it from the last RMC
+ */
+static void update_utc_from_gga(void)
+{
+    int32_t tod_ms;
+    if (work.utc_time == 0 || !field_time_of_day(1, &tod_ms)) return;
+    
+    uint32_t day = work.utc_time - work.utc_time % 86400;
+    uint32_t last_tod = work.utc_time % 86400;
+    uint32_t tod = (uint32_t)tod_ms / 1000;
+    if (tod + 43200 < last_tod) day += 86400;      // Passed midnight since that RMC
+    work.utc_time = day + tod;
+    work.utc_ms = (uint16_t)(tod_ms % 1000);
+}
+
+/**
+ * @brief $--GGA,time,lat,N/S,lon,E/W,quality,sats,hdop,alt,M,...
+ */
+static bool handle_gga(void)
+{
+    int quality = field(6)[0] ? field_int(6) : -1;
+    int32_t lat, lon;
+    bool has_pos = field_coordinate(2, &lat) && field_coordinate(4, &lon);
+    
+    if (field(7)[0]) {
+        work.satellites = field_int(7);
+    }
+    bool updated = quality > 0 && has_pos;
+    if (updated) {
+        work.fix = true;
+        work.lat_e7 = lat;
+        work.lon_e7 = lon;
+        work.alt_dm = (int32_t)field_fixed(9, 1);
+        work.hdop_x100 = field(8)[0] ? (int32_t)field_fixed(8, 2) : 9999;
+        work.fix_time_us = esp_timer_get_time();
+        update_utc_from_gga();
+    } else if (quality == 0) {
+        work.fix = false;
     }
+    return updated;
+}
 
-    if (fix_quality > 0 && lat_str[0] && lon_str[0] && ns && ew) {
-        gps_data.fix = true;
-        gps_data.lat = nmea_to_decimal(lat_str, ns);
-        gps_data.lon = nmea_to_decimal(lon_str, ew);
-        gps_data.alt = alt_val;
-        gps_data.hdop = hdop_val;
-        gps_data.last_update_us = esp_timer_get_time();
-    } else if (fix_quality == 0) {
-        gps_data.fix = false;
+/**
+ * @brief $--RMC,time,A/V,lat,N/S,lon,E/W,speed_kn,course,date,...
+ */
+static void handle_rmc(void)
+{
+    uint32_t utc;
+    uint16_t utc_ms;
+    if (field_utc(1, 9, &utc, &utc_ms)) {
+        work.utc_time = utc;
+        work.utc_ms = utc_ms;
+        time_sync_gps_utc(utc, utc_ms, time_sync_now_us());
     }
+    
+    char status = field(2)[0];
+    int32_t lat, lon;
+    bool has_pos = field_coordinate(3, &lat) && field_coordinate(5, &lon);
+    
+    if (status == 'A' && has_pos) {
+        work.fix = true;
+        work.lat_e7 = lat;
+        work.lon_e7 = lon;
+        work.fix_time_us = esp_timer_get_time();
+    } else if (status == 'V') {
+        work.fix = false;
+    }
+}
 
-    xSemaphoreGive(gps_mutex);
+/**
+ * @brief $--GSA,mode,fix(1-3),sv x 12,pdop,hdop,vdop[,system]
+ */
+static void handle_gsa(void)
+{
+    work.fix_mode = (uint8_t)field_int(2);
+    if (field(15)[0]) work.pdop_x100 = (int32_t)field_fixed(15, 2);
+    if (field(17)[0]) work.vdop_x100 = (int32_t)field_fixed(17, 2);
 }
 
 /**
- * @brief Parse $GPRMC sentence for fix status
- * Format: $GPRMC,time,A/V,lat,N/S,lon,E/W,...
+ * @brief $--GSV,messages,number,in_view,(prn,elev,azim,snr) x up to 4
  */
-static void parse_rmc(const char *nmea)
+static void handle_gsv(void)
 {
-    char buf[CAP_LINE_SIZE];
-    strncpy(buf, nmea, sizeof(buf) - 1);
-    buf[sizeof(buf) - 1] = '\0';
-
-    char *save = NULL;
-    char *tok = strtok_r(buf, ",", &save);
-    int field = 0;
-    char status = 0;
-    char lat_str[16] = {0}, ns = 0;
-    char lon_str[16] = {0}, ew = 0;
-
-    while (tok) {
-        switch (field) {
-            case 2:
-                if (tok[0]) status = tok[0];
-                break;
-            case 3:
-                strncpy(lat_str, tok, sizeof(lat_str) - 1);
-                break;
-            case 4:
-                if (tok[0]) ns = tok[0];
-                break;
-            case 5:
-                strncpy(lon_str, tok, sizeof(lon_str) - 1);
-                break;
-            case 6:
-                if (tok[0]) ew = tok[0];
-                break;
-        }
-        tok = strtok_r(NULL, ",", &save);
-        field++;
+    // The in-view total is repeated in every message of the group
+    if (!field(3)[0]) return;
+    work.satellites_in_view = field_int(3);
+}
+
+/**
+ * @brief $--VTG,course_true,T,course_mag,M,speed_kn,N,speed_kmh,K[,mode]
+ */
+static void handle_vtg(void)
+{
+    if (field(1)[0]) work.course_x10 = (int32_t)field_fixed(1, 1);
+    if (field(7)[0]) work.speed_kmh_x10 = (int32_t)field_fixed(7, 1);
+}
+
+/**
+ * @brief Checked sentence complete: dispatch on the sentence ID
+ *
+ * Field 0 is talker (2 chars, GP/GN/GL/GA/BD...) plus sentence ID; any
+ * talker is accepted so multi-constellation receivers work too.
+ */
+static void dispatch_sentence(void)
+{
+    const char *addr = field(0);
+    if (strlen(addr) != 5) return;
+    
+    sentence_count++;
+    switch (NMEA_ID(addr[2], addr[3], addr[4])) {
+        case NMEA_ID('G', 'G', 'A'): notify_fix(handle_gga()); break;
+        case NMEA_ID('R', 'M', 'C'): handle_rmc(); notify_fix(false); break;
+        case NMEA_ID('G', 'S', 'A'): handle_gsa(); break;
+        case NMEA_ID('G', 'S', 'V'): handle_gsv(); break;
+        case NMEA_ID('V', 'T', 'G'): handle_vtg(); break;
+        default: break;
     }
+    publish();
+}
 
-    xSemaphoreTake(gps_mutex, portMAX_DELAY);
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
 
-    if (status == 'A' && lat_str[0] && lon_str[0] && ns && ew) {
-        gps_data.fix = true;
-        gps_data.lat = nmea_to_decimal(lat_str, ns);
-        gps_data.lon = nmea_to_decimal(lon_str, ew);
-        gps_data.last_update_us = esp_timer_get_time();
-    } else if (status == 'V') {
-        gps_data.fix = false;
+/**
+ * @brief Feed one received byte to the sentence state machine
+ *
+ * Sentences without a valid *hh checksum are dropped, so line noise on
+ * UART2 cannot produce a fix.
+ */
+static void nmea_feed(char c)
+{
+    if (c == '$') {
+        // Always a fresh start, even mid-sentence after lost bytes
+        nmea.state = NMEA_BODY;
+        nmea.checksum = 0;
+        nmea.len = 0;
+        nmea.field_count = 1;
+        nmea.field_start[0] = 0;
+        return;
     }
+    
+    switch (nmea.state) {
+        case NMEA_IDLE:
+            break;
+            
+        case NMEA_BODY:
+            if (c == '*') {
+                nmea.buf[nmea.len] = '\0';
+                nmea.state = NMEA_CHECKSUM_HI;
+            } else if (c == '\r' || c == '\n' || nmea.len >= CAP_LINE_SIZE - 1) {
+                nmea.state = NMEA_IDLE;     // No checksum or too long
+                checksum_error_count++;
+            } else {
+                nmea.checksum ^= (uint8_t)c;
+                if (c == ',') {
+                    nmea.buf[nmea.len++] = '\0';
+                    if (nmea.field_count < NMEA_MAX_FIELDS) {
+                        nmea.field_start[nmea.field_count++] = nmea.len;
+                    }
+                } else {
+                    nmea.buf[nmea.len++] = c;
+                }
+            }
+            break;
+            
+        case NMEA_CHECKSUM_HI: {
+            int v = hex_value(c);
+            if (v < 0) {
+                nmea.state = NMEA_IDLE;
+                checksum_error_count++;
+            } else {
+                nmea.expected = v << 4;
+                nmea.state = NMEA_CHECKSUM_LO;
+            }
+            break;
+        }
+            
+        case NMEA_CHECKSUM_LO: {
+            int v = hex_value(c);
+            nmea.state = NMEA_IDLE;
+            if (v < 0 || (nmea.expected | v) != nmea.checksum) {
+                checksum_error_count++;
+            } else {
+                dispatch_sentence();
+            }
+            break;
+        }
+    }
+}
 
-    xSemaphoreGive(gps_mutex);
+#ifdef CONFIG_CAP_GPS_ASSIST
+/**
+ * @brief Store the current fix as the next start's hint
+ */
+static void save_hint(void)
+{
+    gps_hint_t hint = {
+        .version = HINT_VERSION,
+        .size = sizeof(gps_hint_t),
+        .lat_e7 = work.lat_e7,
+        .lon_e7 = work.lon_e7,
+        .alt_dm = work.alt_dm,
+        .utc_time = work.utc_time,
+    };
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(handle, NVS_KEY_HINT, &hint, sizeof(hint));
+        if (ret == ESP_OK) ret = nvs_commit(handle);
+        nvs_close(handle);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Last fix not saved: %s", esp_err_to_name(ret));
+        return;
+    }
+    hint_saved = hint;
+    hint_saved_us = esp_timer_get_time();
 }
 
-static void handle_nmea_line(const char *line)
+static bool hint_moved(void)
 {
-    const char *nmea = strchr(line, '$');
-    if (!nmea) return;
+    return abs(work.lat_e7 - hint_saved.lat_e7) > HINT_MOVE_E7 ||
+           abs(work.lon_e7 - hint_saved.lon_e7) > HINT_MOVE_E7;
+}
+#endif
 
-    if (strstr(nmea, "GGA") != NULL) {
-        parse_gga(nmea);
-    } else if (strstr(nmea, "RMC") != NULL) {
-        parse_rmc(nmea);
+/**
+ * @brief Log the time to first fix and keep the hint current
+ */
+static void track_fix(void)
+{
+    if (!work.fix) return;
+
+    if (!first_fix_seen) {
+        first_fix_seen = true;
+        ESP_LOGI(TAG, "First fix %lu ms after start (%s)",
+                 (unsigned long)((esp_timer_get_time() - start_us) / 1000),
+                 aided ? "aided" : "unaided");
+#ifdef CONFIG_CAP_GPS_ASSIST
+        save_hint();
+#endif
+        return;
+    }
+#ifdef CONFIG_CAP_GPS_ASSIST
+    if (esp_timer_get_time() - hint_saved_us >= HINT_SAVE_US && hint_moved()) {
+        save_hint();
     }
+#endif
 }
 
 /**
@@ -201,56 +546,176 @@ static void handle_nmea_line(const char *line)
 static void cap_gps_task(void *arg)
 {
     uint8_t rx_buf[CAP_BUF_SIZE];
-    char line_buf[CAP_LINE_SIZE];
-    int line_pos = 0;
 
     ESP_LOGI(TAG, "CAP GPS task started (UART%d, TX=%d, RX=%d, %d baud)",
              CAP_UART_NUM, CAP_TX_PIN, CAP_RX_PIN, CAP_BAUD_RATE);
 
+    nmea.state = NMEA_IDLE;
     while (gps_running) {
-        int len = uart_read_bytes(CAP_UART_NUM, rx_buf, sizeof(rx_buf) - 1, pdMS_TO_TICKS(100));
-        if (len > 0) {
-            for (int i = 0; i < len; i++) {
-                char c = (char)rx_buf[i];
-                if (c == '\n' || c == '\r') {
-                    if (line_pos > 0) {
-                        line_buf[line_pos] = '\0';
-                        handle_nmea_line(line_buf);
-                        line_pos = 0;
-                    }
-                } else if (line_pos < CAP_LINE_SIZE - 1) {
-                    line_buf[line_pos++] = c;
-                }
-            }
+        int len = uart_read_bytes(CAP_UART_NUM, rx_buf, sizeof(rx_buf), pdMS_TO_TICKS(100));
+        for (int i = 0; i < len; i++) {
+            nmea_feed((char)rx_buf[i]);
+        }
+        if (len > 0) track_fix();
+        
+        // Receiver gone quiet: report the loss instead of waiting for a 'V'
+        if (work.fix && esp_timer_get_time() - work.fix_time_us > CAP_FIX_TIMEOUT_US) {
+            work.fix = false;
+            publish();
+            notify_fix(false);
         }
     }
 
-    ESP_LOGI(TAG, "CAP GPS task stopped");
+    ESP_LOGI(TAG, "CAP GPS task stopped (%lu sentences, %lu bad)",
+             (unsigned long)sentence_count, (unsigned long)checksum_error_count);
+    task_plan_track(TASK_ID_GPS, NULL);
     vTaskDelete(NULL);
 }
 
+/**
+ * @brief Send a CASIC command ("PCASnn,...") with its checksum
+ */
+static void send_casic(const char *body)
+{
+    uint8_t checksum = 0;
+    for (const char *p = body; *p; p++) {
+        checksum ^= (uint8_t)*p;
+    }
+    char cmd[48];
+    int len = snprintf(cmd, sizeof(cmd), "$%s*%02X\r\n", body, checksum);
+    uart_write_bytes(CAP_UART_NUM, cmd, len);
+}
+
+/**
+ * @brief Ask the CAP's ATGM336H (CASIC protocol) for CAP_RATE_HZ output
+ *
+ * The module already talks at 115200 baud, the fastest PCAS01 rate, which
+ * carries the full GGA/RMC/VTG/GSA/GSV set at 10 Hz with room to spare.
+ * Receivers that do not speak CASIC ignore the sentence and stay at 1 Hz.
+ */
+static void configure_receiver(void)
+{
+    char body[24];
+    snprintf(body, sizeof(body), "PCAS02,%d", 1000 / CAP_RATE_HZ);
+    send_casic(body);
+    ESP_LOGI(TAG, "Requested %d Hz position output", CAP_RATE_HZ);
+}
+
+#ifdef CONFIG_CAP_GPS_ASSIST
+/**
+ * @brief Send a binary CASIC message
+ *
+ * Frame: BA CE, payload length (LE16), class, id, payload, checksum. The
+ * checksum is (id << 24) + (class << 16) + length plus the payload summed
+ * as little-endian 32-bit words.
+ */
+static void send_casic_binary(uint8_t cls, uint8_t id, const void *payload, uint16_t len)
+{
+    uint8_t frame[6 + sizeof(casic_aid_ini_t) + 4];
+    if (len % 4 != 0 || (size_t)len + 10 > sizeof(frame)) return;
+
+    uint32_t checksum = ((uint32_t)id << 24) + ((uint32_t)cls << 16) + len;
+    const uint8_t *p = payload;
+    for (uint16_t i = 0; i < len; i += 4) {
+        checksum += (uint32_t)p[i] | ((uint32_t)p[i + 1] << 8) |
+                    ((uint32_t)p[i + 2] << 16) | ((uint32_t)p[i + 3] << 24);
+    }
+
+    frame[0] = 0xBA;
+    frame[1] = 0xCE;
+    frame[2] = (uint8_t)len;
+    frame[3] = (uint8_t)(len >> 8);
+    frame[4] = cls;
+    frame[5] = id;
+    memcpy(&frame[6], payload, len);
+    for (int i = 0; i < 4; i++) frame[6 + len + i] = (uint8_t)(checksum >> (8 * i));
+    uart_write_bytes(CAP_UART_NUM, frame, 6 + len + 4);
+}
+
+/**
+ * @brief Hand the last fix, and the time if the clock kept it, to the module
+ * @return true if aiding was sent
+ */
+static bool assist_receiver(void)
+{
+    uint8_t buf[32];
+    size_t len = sizeof(buf);
+    nvs_handle_t handle;
+    bool found = false;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        found = nvs_get_blob(handle, NVS_KEY_HINT, buf, &len) == ESP_OK &&
+                len >= sizeof(gps_hint_t);
+        nvs_close(handle);
+    }
+    if (!found) return false;
+
+    gps_hint_t hint;
+    memcpy(&hint, buf, sizeof(hint));
+    hint_saved = hint;
+
+    casic_aid_ini_t aid = {
+        .lat = hint.lat_e7 / 1e7,
+        .lon = hint.lon_e7 / 1e7,
+        .alt = hint.alt_dm / 10.0,
+        .pos_acc = HINT_POS_ACC_M,
+        .flags = CASIC_AID_INI_POS_VALID | CASIC_AID_INI_LLA,
+    };
+
+    // The RTC runs through a software reset but restarts at 1970 from power off
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    bool time_valid = tv.tv_sec >= HINT_MIN_UTC && (uint32_t)tv.tv_sec >= hint.utc_time;
+    if (time_valid) {
+        uint32_t gps_s = (uint32_t)tv.tv_sec - GPS_EPOCH_UNIX + GPS_LEAP_SECONDS;
+        aid.week = (uint16_t)(gps_s / GPS_WEEK_S);
+        aid.tow = (gps_s % GPS_WEEK_S) + tv.tv_usec / 1e6;
+        aid.time_acc = HINT_TIME_ACC_S;
+        aid.flags |= CASIC_AID_INI_TIME_VALID;
+    }
+
+    send_casic_binary(0x0B, 0x01, &aid, sizeof(aid));
+    ESP_LOGI(TAG, "Aided start from %.4f, %.4f%s", aid.lat, aid.lon,
+             time_valid ? " with time" : "");
+    return true;
+}
+#endif
+
 esp_err_t cap_gps_init(void)
 {
     if (gps_running) {
         ESP_LOGW(TAG, "Already initialized");
         return ESP_OK;
     }
+#ifdef CONFIG_UART_SECOND_BOARD
+    ESP_LOGW(TAG, "UART%d belongs to the second JanOS board", CAP_UART_NUM);
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
 
     ESP_LOGI(TAG, "Initializing CAP GPS on UART%d (TX=%d, RX=%d)...",
              CAP_UART_NUM, CAP_TX_PIN, CAP_RX_PIN);
+    size_t mem_token = mem_scope_begin();
 
     // Init mutex
-    if (!gps_mutex) {
-        gps_mutex = xSemaphoreCreateMutex();
-        if (!gps_mutex) {
+    if (!callback_mutex) {
+        callback_mutex = xSemaphoreCreateMutex();
+        if (!callback_mutex) {
             ESP_LOGE(TAG, "Failed to create mutex");
             return ESP_ERR_NO_MEM;
         }
     }
 
-    // Clear state
-    memset(&gps_data, 0, sizeof(gps_data));
-    gps_data.satellites = -1;
+    // Clear state; the version keeps counting across restarts
+    memset(&work, 0, sizeof(work));
+    work.satellites = -1;
+    work.satellites_in_view = -1;
+    publish();
+    sentence_count = 0;
+    checksum_error_count = 0;
+    reported_fix = false;
+    first_fix_seen = false;
+    aided = false;
+    hint_saved_us = 0;
+    memset(&hint_saved, 0, sizeof(hint_saved));
 
     // Reset GPIO pins (ensure clean state, no SPI bus crosstalk)
     gpio_reset_pin(CAP_TX_PIN);
@@ -286,15 +751,24 @@ esp_err_t cap_gps_init(void)
         return ret;
     }
 
+    configure_receiver();
+#ifdef CONFIG_CAP_GPS_ASSIST
+    aided = assist_receiver();
+#endif
+    start_us = esp_timer_get_time();
+
     // Start reading task
     gps_running = true;
-    BaseType_t task_ret = xTaskCreate(cap_gps_task, "cap_gps", 4096, NULL, 5, &gps_task_handle);
+    BaseType_t task_ret = xTaskCreatePinnedToCore(cap_gps_task, "cap_gps", TASK_GPS_STACK, NULL,
+                                                  TASK_GPS_PRIO, &gps_task_handle, TASK_GPS_CORE);
     if (task_ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create GPS task");
         gps_running = false;
         uart_driver_delete(CAP_UART_NUM);
         return ESP_ERR_NO_MEM;
     }
+    task_plan_track(TASK_ID_GPS, gps_task_handle);
+    gps_mem_bytes = mem_scope_end(MEM_SUB_GPS, mem_token);
 
     ESP_LOGI(TAG, "CAP GPS initialized");
     return ESP_OK;
@@ -315,54 +789,75 @@ void cap_gps_deinit(void)
     }
 
     uart_driver_delete(CAP_UART_NUM);
+    mem_monitor_account(MEM_SUB_GPS, -gps_mem_bytes);
+
+#ifdef CONFIG_CAP_GPS_ASSIST
+    // Where the drive ended is the best hint for the next one
+    if (first_fix_seen && hint_moved()) save_hint();
+#endif
+    gps_mem_bytes = 0;
 
     ESP_LOGI(TAG, "CAP GPS deinitialized");
 }
 
-bool cap_gps_has_fix(void)
+bool cap_gps_get_snapshot(cap_gps_snapshot_t *out)
 {
-    if (!gps_running || !gps_mutex) return false;
-
-    xSemaphoreTake(gps_mutex, portMAX_DELAY);
-    bool fix = gps_data.fix;
-    int64_t last = gps_data.last_update_us;
-    xSemaphoreGive(gps_mutex);
+    if (!out || !gps_running) return false;
 
-    if (!fix) return false;
+    uint32_t seq;
+    do {
+        seq = __atomic_load_n(&shared_seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) continue;
+        memcpy(out, &shared, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || __atomic_load_n(&shared_seq, __ATOMIC_RELAXED) != seq);
 
-    // Check timeout
     int64_t now = esp_timer_get_time();
-    if (last == 0 || (now - last) > CAP_FIX_TIMEOUT_US) {
-        return false;
-    }
-
+    out->fix_age_ms = out->fix_time_us ? (uint32_t)((now - out->fix_time_us) / 1000) : UINT32_MAX;
+    out->sentences = sentence_count;
+    out->checksum_errors = checksum_error_count;
     return true;
 }
 
-bool cap_gps_get_position(double *lat, double *lon, double *alt, double *hdop)
+bool cap_gps_has_fix(void)
 {
-    if (!gps_running || !gps_mutex) return false;
+    cap_gps_snapshot_t snap;
+    if (!cap_gps_get_snapshot(&snap) || !snap.fix) return false;
 
-    xSemaphoreTake(gps_mutex, portMAX_DELAY);
-    bool fix = gps_data.fix;
-    if (fix) {
-        if (lat) *lat = gps_data.lat;
-        if (lon) *lon = gps_data.lon;
-        if (alt) *alt = gps_data.alt;
-        if (hdop) *hdop = gps_data.hdop;
-    }
-    xSemaphoreGive(gps_mutex);
+    // Check timeout
+    return snap.fix_age_ms <= CAP_FIX_TIMEOUT_US / 1000;
+}
 
-    return fix;
+bool cap_gps_get_position(double *lat, double *lon, double *alt, double *hdop)
+{
+    cap_gps_snapshot_t snap;
+    if (!cap_gps_get_snapshot(&snap) || !snap.fix) return false;
+
+    if (lat) *lat = snap.lat_e7 / 1e7;
+    if (lon) *lon = snap.lon_e7 / 1e7;
+    if (alt) *alt = snap.alt_dm / 10.0;
+    if (hdop) *hdop = snap.hdop_x100 / 100.0;
+    return true;
 }
 
 int cap_gps_get_satellites(void)
 {
-    if (!gps_running || !gps_mutex) return -1;
+    cap_gps_snapshot_t snap;
+    if (!cap_gps_get_snapshot(&snap)) return -1;
 
-    xSemaphoreTake(gps_mutex, portMAX_DELAY);
-    int sats = gps_data.satellites;
-    xSemaphoreGive(gps_mutex);
+    return snap.satellites;
+}
+
+void cap_gps_set_fix_callback(cap_gps_fix_callback_t callback, void *user_data)
+{
+    if (!callback_mutex) {
+        callback_mutex = xSemaphoreCreateMutex();
+        if (!callback_mutex) return;
+    }
 
-    return sats;
+    // Once this returns the previous callback is not running and never will
+    xSemaphoreTake(callback_mutex, portMAX_DELAY);
+    fix_callback = callback;
+    fix_callback_user_data = user_data;
+    xSemaphoreGive(callback_mutex);
 }
@@ -8,10 +8,54 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stdint.h>
+
+// Position delivered to the fix callback
+typedef struct {
+    bool fix;                   // false: fix lost (other fields are the last fix)
+    int32_t lat_e7;             // Degrees x 1e7
+    int32_t lon_e7;
+    int32_t alt_dm;             // Decimetres
+    int32_t hdop_x100;
+    int satellites;
+    int64_t time_us;            // esp_timer time of the fix
+    uint32_t utc_time;          // Unix seconds of the fix, 0 until the date is known
+    uint16_t utc_ms;
+} cap_gps_fix_t;
+
+/**
+ * @brief Called on the GPS task for every new position and on fix loss
+ */
+typedef void (*cap_gps_fix_callback_t)(const cap_gps_fix_t *fix, void *user_data);
+
+// Receiver state as one consistent copy (see cap_gps_get_snapshot)
+typedef struct {
+    bool fix;
+    uint8_t fix_mode;           // GSA: 1 none, 2 2D, 3 3D (0 = no GSA yet)
+    int32_t lat_e7;             // Degrees x 1e7
+    int32_t lon_e7;
+    int32_t alt_dm;             // Decimetres above MSL
+    int32_t hdop_x100;
+    int32_t pdop_x100;
+    int32_t vdop_x100;
+    int32_t speed_kmh_x10;
+    int32_t course_x10;         // Degrees true x 10
+    int satellites;             // Used in the fix (GGA), -1 if no data
+    int satellites_in_view;     // GSV, -1 if no data
+    uint32_t utc_time;          // Unix seconds from RMC, 0 until known
+    uint16_t utc_ms;
+    int64_t fix_time_us;        // esp_timer time of the last position
+    
+    // Fields from here on are not covered by version
+    uint32_t version;           // Bumps when anything above changes
+    uint32_t fix_age_ms;        // At the time of the read, UINT32_MAX if never
+    uint32_t sentences;         // Checksum-valid sentences
+    uint32_t checksum_errors;   // Dropped as corrupt or truncated
+} cap_gps_snapshot_t;
 
 /**
  * @brief Initialize CAP GPS UART2 and start reading task
- * @return ESP_OK on success
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED when UART2 serves a second JanOS board
  */
 esp_err_t cap_gps_init(void);
 
@@ -38,8 +82,26 @@ bool cap_gps_get_position(double *lat, double *lon, double *alt, double *hdop);
 
 /**
  * @brief Get satellite count
- * @return Number of satellites in view, -1 if no data
+ * @return Number of satellites used in the fix, -1 if no data
  */
 int cap_gps_get_satellites(void);
 
+/**
+ * @brief Copy the current receiver state
+ *
+ * Lock-free (sequence lock): the GPS task publishes whole snapshots, so
+ * the copy is always consistent. Compare version with the previous read
+ * to skip work when nothing changed.
+ * @return false if the driver is not running
+ */
+bool cap_gps_get_snapshot(cap_gps_snapshot_t *out);
+
+/**
+ * @brief Subscribe to fix updates (one subscriber; NULL to clear)
+ *
+ * At CONFIG_CAP_GPS_RATE_HZ the callback runs several times a second, so
+ * it should be quick. It must not call cap_gps_set_fix_callback().
+ */
+void cap_gps_set_fix_callback(cap_gps_fix_callback_t callback, void *user_data);
+
 #endif // CAP_GPS_H
@@ -4,13 +4,17 @@
  */
 
 #include "display.h"
+#include "trace.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_vendor.h"
 #include "esp_lcd_panel_ops.h"
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
 #include "driver/ledc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include <string.h>
 
 static const char *TAG = "DISPLAY";
@@ -30,17 +34,363 @@ static const char *TAG = "DISPLAY";
 
 static esp_lcd_panel_handle_t panel_handle = NULL;
 
-// Small line buffer for drawing operations
-#define LINE_BUFFER_SIZE (DISPLAY_WIDTH * 2)  // One line in RGB565
-static uint16_t line_buffer[DISPLAY_WIDTH];
+#if DISPLAY_INDEXED
+// Framebuffer of palette indices (half the RGB565 size). The palette holds
+// panel-order colors and is expanded row by row into the staging buffers
+// on flush. Colors are added as they are first drawn and the palette starts
+// over whenever the whole screen is cleared, so each screen gets
+// DISPLAY_PALETTE_SIZE colors of its own; past that a color is drawn as the
+// nearest one already in the palette.
+typedef uint8_t fb_pixel_t;
+static fb_pixel_t framebuffer[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+static uint16_t palette[DISPLAY_PALETTE_SIZE];
+static int palette_used = 0;
 
-// Framebuffer for screenshot functionality
-static uint16_t framebuffer[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+// Color -> index lookup, open addressing on the panel-order color. Colors
+// drawn as a nearest match are remembered too, while a slot is left free.
+#define PALETTE_HASH_SLOTS  (DISPLAY_PALETTE_SIZE * 2)
+static uint16_t hash_color[PALETTE_HASH_SLOTS];
+static uint16_t hash_index[PALETTE_HASH_SLOTS];     // Index + 1, 0 = free slot
+static int hash_used = 0;
+
+// Last color looked up; fills and glyph runs repeat one color
+static uint16_t last_pixel;
+static fb_pixel_t last_index;
+static bool last_valid = false;
+#else
+// Framebuffer - all drawing lands here, display_flush() pushes it to the panel.
+// Pixels are stored byte-swapped (panel order) so full-width bands can be
+// handed to the SPI DMA without any conversion.
+typedef uint16_t fb_pixel_t;
+static fb_pixel_t framebuffer[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+#endif
+
+#if DISPLAY_INDEXED
+// Every region is expanded into the staging buffers, so they ping-pong and
+// the flush returns while the last chunks are still on the wire
+#define STAGE_BUFFERS 2
+#elif DISPLAY_DOUBLE_BUFFER
+// Scan-out copy of the framebuffer. Full-width bands are copied here and
+// DMA'd from it, so display_flush() can return while the previous frame is
+// still on the wire and drawing into framebuffer carries on in parallel.
+static uint16_t scanout_buffer[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+#define STAGE_BUFFERS 2     // Ping-pong: pack one chunk while the other is sent
+#else
+#define STAGE_BUFFERS 1
+#endif
+
+// Staging buffers for dirty rectangles narrower than the screen
+// (their rows are not contiguous in the framebuffer), and in indexed mode
+// for everything
+#if DISPLAY_INDEXED
+#define STAGE_PIXELS (DISPLAY_WIDTH * 8)
+#else
+#define STAGE_PIXELS (DISPLAY_WIDTH * 16)
+#endif
+static uint16_t stage_buffer[STAGE_BUFFERS][STAGE_PIXELS];
+static int stage_index = 0;
+
+// Transfers queued by display_flush() that have not completed yet
+static int pending_transfers = 0;
+
+// Dirty rectangle tracking
+#define MAX_DIRTY_RECTS 8
+
+typedef struct {
+    int x0, y0;     // Inclusive
+    int x1, y1;     // Exclusive
+} dirty_rect_t;
+
+static dirty_rect_t dirty_rects[MAX_DIRTY_RECTS];
+static int dirty_count = 0;
+static portMUX_TYPE dirty_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Areas flushed since the last display_take_damage() (screen mirror),
+// accumulated only while tracking is on. Also under dirty_lock.
+_Static_assert(MAX_DIRTY_RECTS == DISPLAY_MAX_DAMAGE_RECTS, "damage list size");
+static dirty_rect_t damage_rects[MAX_DIRTY_RECTS];
+static int damage_count = 0;
+static bool damage_tracking = false;
+
+// Signalled by the panel IO once a color transfer has left the DMA
+static SemaphoreHandle_t trans_done_sem = NULL;
+
+// Updated by the flushing task only
+static display_stats_t stats;
+
+#define SWAP_BYTES(c) ((uint16_t)((((c) >> 8) & 0xFF) | (((c) & 0xFF) << 8)))
+
+#if DISPLAY_INDEXED
+/**
+ * @brief Forget every color (the whole screen is about to be overwritten)
+ */
+static void palette_reset(void)
+{
+    palette_used = 0;
+    hash_used = 0;
+    last_valid = false;
+    memset(hash_index, 0, sizeof(hash_index));
+}
+
+/**
+ * @brief Palette entry closest to a panel-order color (palette full)
+ */
+static fb_pixel_t palette_nearest(uint16_t pixel)
+{
+    uint16_t c = SWAP_BYTES(pixel);
+    int r = c >> 11, g = (c >> 5) & 0x3F, b = c & 0x1F;
+
+    int best = 0;
+    int best_dist = -1;
+    for (int i = 0; i < palette_used; i++) {
+        uint16_t p = SWAP_BYTES(palette[i]);
+        int dr = (p >> 11) - r, dg = ((p >> 5) & 0x3F) - g, db = (p & 0x1F) - b;
+        // Green has twice the steps of red and blue
+        int dist = 4 * dr * dr + dg * dg + 4 * db * db;
+        if (best_dist < 0 || dist < best_dist) {
+            best_dist = dist;
+            best = i;
+        }
+    }
+    return (fb_pixel_t)best;
+}
+
+/**
+ * @brief Palette index of a panel-order color, adding it if there is room
+ */
+static fb_pixel_t palette_index(uint16_t pixel)
+{
+    if (last_valid && pixel == last_pixel) return last_index;
+
+    uint32_t slot = ((pixel * 0x9E37u) >> 7) % PALETTE_HASH_SLOTS;
+    while (hash_index[slot] && hash_color[slot] != pixel) {
+        slot = (slot + 1) % PALETTE_HASH_SLOTS;
+    }
+
+    fb_pixel_t index;
+    if (hash_index[slot]) {
+        index = (fb_pixel_t)(hash_index[slot] - 1);
+    } else {
+        if (palette_used < DISPLAY_PALETTE_SIZE) {
+            index = (fb_pixel_t)palette_used;
+            palette[palette_used++] = pixel;
+        } else {
+            index = palette_nearest(pixel);
+        }
+        // One slot always stays free so probing ends
+        if (hash_used < PALETTE_HASH_SLOTS - 1) {
+            hash_color[slot] = pixel;
+            hash_index[slot] = index + 1;
+            hash_used++;
+        }
+    }
+
+    last_pixel = pixel;
+    last_index = index;
+    last_valid = true;
+    return index;
+}
+#endif
+
+static bool on_color_trans_done(esp_lcd_panel_io_handle_t panel_io,
+                                esp_lcd_panel_io_event_data_t *edata,
+                                void *user_ctx)
+{
+    BaseType_t high_task_woken = pdFALSE;
+    xSemaphoreGiveFromISR(trans_done_sem, &high_task_woken);
+    return high_task_woken == pdTRUE;
+}
+
+static inline bool rects_touch(const dirty_rect_t *a, const dirty_rect_t *b)
+{
+    return a->x0 <= b->x1 && b->x0 <= a->x1 && a->y0 <= b->y1 && b->y0 <= a->y1;
+}
+
+static inline void rect_union(dirty_rect_t *dst, const dirty_rect_t *src)
+{
+    if (src->x0 < dst->x0) dst->x0 = src->x0;
+    if (src->y0 < dst->y0) dst->y0 = src->y0;
+    if (src->x1 > dst->x1) dst->x1 = src->x1;
+    if (src->y1 > dst->y1) dst->y1 = src->y1;
+}
+
+static inline int rect_area(const dirty_rect_t *r)
+{
+    return (r->x1 - r->x0) * (r->y1 - r->y0);
+}
+
+/**
+ * @brief Add a rectangle to a list, merging overlapping or touching ones
+ *
+ * When the list is full the new region is folded into whichever rectangle
+ * grows the least. Caller holds dirty_lock.
+ */
+static void merge_rect(dirty_rect_t *list, int *count, dirty_rect_t r)
+{
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (int i = 0; i < *count; i++) {
+            if (rects_touch(&list[i], &r)) {
+                rect_union(&r, &list[i]);
+                list[i] = list[--(*count)];
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (*count < MAX_DIRTY_RECTS) {
+        list[(*count)++] = r;
+    } else {
+        int best = 0;
+        int best_growth = -1;
+        for (int i = 0; i < *count; i++) {
+            dirty_rect_t u = list[i];
+            rect_union(&u, &r);
+            int growth = rect_area(&u) - rect_area(&list[i]);
+            if (best_growth < 0 || growth < best_growth) {
+                best_growth = growth;
+                best = i;
+            }
+        }
+        rect_union(&list[best], &r);
+    }
+}
+
+/**
+ * @brief Record an already clipped region as needing a flush
+ */
+static void mark_dirty(int x, int y, int w, int h)
+{
+    dirty_rect_t r = { x, y, x + w, y + h };
+
+    portENTER_CRITICAL(&dirty_lock);
+    merge_rect(dirty_rects, &dirty_count, r);
+    portEXIT_CRITICAL(&dirty_lock);
+}
+
+/**
+ * @brief Block until at most max_pending transfers are still in flight
+ *
+ * Color transfers complete in queue order, so once only the newest N remain
+ * every buffer used by an older transfer is free again.
+ */
+static void wait_transfers(int max_pending)
+{
+    while (pending_transfers > max_pending) {
+        xSemaphoreTake(trans_done_sem, portMAX_DELAY);
+        pending_transfers--;
+    }
+}
+
+/**
+ * @brief Queue one region to the panel
+ */
+static void push_rect(const dirty_rect_t *r)
+{
+    int w = r->x1 - r->x0;
+
+#if !DISPLAY_INDEXED
+    if (w == DISPLAY_WIDTH) {
+        // Full-width band is contiguous in the framebuffer - one transfer
+        const uint16_t *band = &framebuffer[r->y0 * DISPLAY_WIDTH];
+#if DISPLAY_DOUBLE_BUFFER
+        uint16_t *out = &scanout_buffer[r->y0 * DISPLAY_WIDTH];
+        memcpy(out, band, (r->y1 - r->y0) * DISPLAY_WIDTH * sizeof(uint16_t));
+        band = out;
+#endif
+        esp_lcd_panel_draw_bitmap(panel_handle, 0, r->y0, DISPLAY_WIDTH, r->y1, band);
+        pending_transfers++;
+        stats.transactions++;
+        stats.pixels += (r->y1 - r->y0) * DISPLAY_WIDTH;
+        return;
+    }
+#endif
+
+    // Narrow rectangle (indexed: any) - pack rows into the staging buffers
+    // chunk by chunk
+    int rows_per_chunk = STAGE_PIXELS / w;
+    for (int y = r->y0; y < r->y1; y += rows_per_chunk) {
+        int rows = r->y1 - y;
+        if (rows > rows_per_chunk) rows = rows_per_chunk;
+
+        // Next staging buffer must not be in flight any more
+        stage_index = (stage_index + 1) % STAGE_BUFFERS;
+        wait_transfers(STAGE_BUFFERS - 1);
+
+        uint16_t *stage = stage_buffer[stage_index];
+        for (int row = 0; row < rows; row++) {
+#if DISPLAY_INDEXED
+            const fb_pixel_t *src = &framebuffer[(y + row) * DISPLAY_WIDTH + r->x0];
+            uint16_t *dst = &stage[row * w];
+            for (int x = 0; x < w; x++) {
+                dst[x] = palette[src[x]];
+            }
+#else
+            memcpy(&stage[row * w],
+                   &framebuffer[(y + row) * DISPLAY_WIDTH + r->x0],
+                   w * sizeof(uint16_t));
+#endif
+        }
+        esp_lcd_panel_draw_bitmap(panel_handle, r->x0, y, r->x1, y + rows, stage);
+        pending_transfers++;
+        stats.transactions++;
+        stats.pixels += rows * w;
+    }
+}
+
+#if DISPLAY_INDEXED
+/**
+ * @brief Fill n pixels with a palette index
+ */
+static inline void fill_span(fb_pixel_t *dst, int n, fb_pixel_t pixel)
+{
+    if (n > 0) memset(dst, pixel, n);
+}
+#else
+/**
+ * @brief Fill n pixels with a panel-order color, two pixels per 32-bit store
+ */
+static void fill_span(uint16_t *dst, int n, uint16_t pixel)
+{
+    if (n <= 0) return;
+
+    // Align to a word boundary
+    if ((uintptr_t)dst & 2) {
+        *dst++ = pixel;
+        n--;
+    }
+
+    uint32_t pattern = ((uint32_t)pixel << 16) | pixel;
+    uint32_t *dst32 = (uint32_t *)dst;
+    int words = n >> 1;
+
+    if ((pixel >> 8) == (pixel & 0xFF)) {
+        // Black, white and other byte-symmetric colors: plain memset
+        memset(dst32, pixel & 0xFF, words * sizeof(uint32_t));
+    } else {
+        for (int i = 0; i < words; i++) {
+            dst32[i] = pattern;
+        }
+    }
+
+    if (n & 1) {
+        dst[n - 1] = pixel;
+    }
+}
+#endif
 
 esp_err_t display_init(void)
 {
     ESP_LOGI(TAG, "Initializing ST7789 display...");
 
+    trans_done_sem = xSemaphoreCreateCounting(MAX_DIRTY_RECTS * 8, 0);
+    if (!trans_done_sem) {
+        ESP_LOGE(TAG, "Failed to create transfer semaphore");
+        return ESP_FAIL;
+    }
+
     // Configure backlight via LEDC PWM for brightness control
     ledc_timer_config_t ledc_timer = {
         .speed_mode       = BL_LEDC_MODE,
@@ -83,6 +433,7 @@ esp_err_t display_init(void)
         .lcd_param_bits = 8,
         .spi_mode = 0,
         .trans_queue_depth = 10,
+        .on_color_trans_done = on_color_trans_done,
     };
     ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)DISPLAY_SPI_HOST, &io_config, &io_handle));
 
@@ -111,8 +462,10 @@ esp_err_t display_init(void)
 
     // Clear screen to black
     display_clear(COLOR_BLACK);
+    display_flush();
 
-    ESP_LOGI(TAG, "Display initialized successfully (%dx%d)", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    ESP_LOGI(TAG, "Display initialized successfully (%dx%d, %s)", DISPLAY_WIDTH, DISPLAY_HEIGHT,
+             DISPLAY_INDEXED ? "indexed" : DISPLAY_DOUBLE_BUFFER ? "double buffered" : "single buffered");
     return ESP_OK;
 }
 
@@ -129,31 +482,97 @@ void display_fill_rect(int x, int y, int w, int h, uint16_t color)
     if (w <= 0 || h <= 0) return;
 
     // Swap bytes for ST7789 (big-endian)
-    uint16_t swapped = ((color >> 8) & 0xFF) | ((color & 0xFF) << 8);
+    uint16_t swapped = SWAP_BYTES(color);
+#if DISPLAY_INDEXED
+    if (w == DISPLAY_WIDTH && h == DISPLAY_HEIGHT) palette_reset();
+    fb_pixel_t pixel = palette_index(swapped);
+#else
+    fb_pixel_t pixel = swapped;
+#endif
     
-    // Fill line buffer
-    for (int i = 0; i < w && i < DISPLAY_WIDTH; i++) {
-        line_buffer[i] = swapped;
-    }
-    
-    // Draw line by line and update framebuffer
-    for (int row = y; row < y + h; row++) {
-        esp_lcd_panel_draw_bitmap(panel_handle, x, row, x + w, row + 1, line_buffer);
-        // Update framebuffer (store original color, not swapped)
-        for (int col = x; col < x + w; col++) {
-            framebuffer[row * DISPLAY_WIDTH + col] = color;
+    if (w == DISPLAY_WIDTH) {
+        // Full-width rows are contiguous - one span for the whole band
+        fill_span(&framebuffer[y * DISPLAY_WIDTH], w * h, pixel);
+    } else {
+        for (int row = y; row < y + h; row++) {
+            fill_span(&framebuffer[row * DISPLAY_WIDTH + x], w, pixel);
         }
     }
+
+    mark_dirty(x, y, w, h);
 }
 
 void display_draw_pixel(int x, int y, uint16_t color)
 {
     if (x < 0 || y < 0 || x >= DISPLAY_WIDTH || y >= DISPLAY_HEIGHT) return;
     
-    uint16_t swapped = ((color >> 8) & 0xFF) | ((color & 0xFF) << 8);
-    esp_lcd_panel_draw_bitmap(panel_handle, x, y, x + 1, y + 1, &swapped);
-    // Update framebuffer
-    framebuffer[y * DISPLAY_WIDTH + x] = color;
+#if DISPLAY_INDEXED
+    framebuffer[y * DISPLAY_WIDTH + x] = palette_index(SWAP_BYTES(color));
+#else
+    framebuffer[y * DISPLAY_WIDTH + x] = SWAP_BYTES(color);
+#endif
+    mark_dirty(x, y, 1, 1);
+}
+
+void display_blit(int x, int y, int w, int h, const uint16_t *pixels)
+{
+    if (!pixels || w <= 0 || h <= 0) return;
+
+    int stride = w;
+    int src_x = 0;
+    int src_y = 0;
+
+    // Clip to bounds
+    if (x < 0) { src_x = -x; w += x; x = 0; }
+    if (y < 0) { src_y = -y; h += y; y = 0; }
+    if (x + w > DISPLAY_WIDTH) w = DISPLAY_WIDTH - x;
+    if (y + h > DISPLAY_HEIGHT) h = DISPLAY_HEIGHT - y;
+
+    if (w <= 0 || h <= 0) return;
+
+    for (int row = 0; row < h; row++) {
+#if DISPLAY_INDEXED
+        fb_pixel_t *dst = &framebuffer[(y + row) * DISPLAY_WIDTH + x];
+        const uint16_t *src = &pixels[(src_y + row) * stride + src_x];
+        for (int col = 0; col < w; col++) {
+            dst[col] = palette_index(src[col]);
+        }
+#else
+        memcpy(&framebuffer[(y + row) * DISPLAY_WIDTH + x],
+               &pixels[(src_y + row) * stride + src_x],
+               w * sizeof(uint16_t));
+#endif
+    }
+
+    mark_dirty(x, y, w, h);
+}
+
+void display_scroll_region(int y, int h, int dy, uint16_t fill)
+{
+    // Clip band to the screen
+    if (y < 0) { h += y; y = 0; }
+    if (y + h > DISPLAY_HEIGHT) h = DISPLAY_HEIGHT - y;
+    if (h <= 0 || dy == 0) return;
+
+    int shift = dy < 0 ? -dy : dy;
+    if (shift >= h) {
+        display_fill_rect(0, y, DISPLAY_WIDTH, h, fill);
+        return;
+    }
+
+    // Rows are contiguous across the full width - one overlapping move
+    size_t keep = (size_t)(h - shift) * DISPLAY_WIDTH * sizeof(fb_pixel_t);
+    if (dy < 0) {
+        memmove(&framebuffer[y * DISPLAY_WIDTH],
+                &framebuffer[(y + shift) * DISPLAY_WIDTH], keep);
+        display_fill_rect(0, y + h - shift, DISPLAY_WIDTH, shift, fill);
+    } else {
+        memmove(&framebuffer[(y + shift) * DISPLAY_WIDTH],
+                &framebuffer[y * DISPLAY_WIDTH], keep);
+        display_fill_rect(0, y, DISPLAY_WIDTH, shift, fill);
+    }
+
+    mark_dirty(0, y, DISPLAY_WIDTH, h);
 }
 
 void display_draw_hline(int x, int y, int w, uint16_t color)
@@ -196,10 +615,92 @@ void display_set_backlight(uint8_t brightness)
 
 void display_flush(void)
 {
-    // No-op for direct drawing mode
+    if (!panel_handle) return;
+
+    // Snapshot and reset the dirty list; anything drawn while we are
+    // pushing lands in a fresh list and goes out on the next flush.
+    dirty_rect_t rects[MAX_DIRTY_RECTS];
+    portENTER_CRITICAL(&dirty_lock);
+    int count = dirty_count;
+    memcpy(rects, dirty_rects, count * sizeof(dirty_rect_t));
+    dirty_count = 0;
+    if (damage_tracking) {
+        for (int i = 0; i < count; i++) {
+            merge_rect(damage_rects, &damage_count, rects[i]);
+        }
+    }
+    portEXIT_CRITICAL(&dirty_lock);
+
+    if (count == 0) return;
+    TRACE_BEGIN(TRACE_EV_FLUSH, count);
+    int64_t start_us = esp_timer_get_time();
+
+#if DISPLAY_DOUBLE_BUFFER && !DISPLAY_INDEXED
+    // Previous frame may still be reading the scan-out and staging buffers
+    wait_transfers(0);
+#endif
+
+    for (int i = 0; i < count; i++) {
+        push_rect(&rects[i]);
+    }
+
+#if !DISPLAY_DOUBLE_BUFFER && !DISPLAY_INDEXED
+    // Wait for the frame to leave the DMA before the caller draws again
+    wait_transfers(0);
+#endif
+
+    stats.flushes++;
+    stats.flush_us += esp_timer_get_time() - start_us;
+    TRACE_END(TRACE_EV_FLUSH, count);
+}
+
+void display_get_stats(display_stats_t *out)
+{
+    if (out) *out = stats;
+}
+
+void display_track_damage(bool enable)
+{
+    portENTER_CRITICAL(&dirty_lock);
+    damage_tracking = enable;
+    damage_count = 0;
+    if (enable) {
+        damage_rects[damage_count++] = (dirty_rect_t){ 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT };
+    }
+    portEXIT_CRITICAL(&dirty_lock);
 }
 
-const uint16_t* display_get_framebuffer(void)
+int display_take_damage(display_rect_t *out)
 {
-    return framebuffer;
+    dirty_rect_t rects[MAX_DIRTY_RECTS];
+    portENTER_CRITICAL(&dirty_lock);
+    int count = damage_count;
+    memcpy(rects, damage_rects, count * sizeof(dirty_rect_t));
+    damage_count = 0;
+    portEXIT_CRITICAL(&dirty_lock);
+
+    for (int i = 0; i < count; i++) {
+        out[i] = (display_rect_t){
+            .x = rects[i].x0,
+            .y = rects[i].y0,
+            .w = rects[i].x1 - rects[i].x0,
+            .h = rects[i].y1 - rects[i].y0,
+        };
+    }
+    return count;
+}
+
+void display_read_pixels(int x, int y, int w, int h, uint16_t *out)
+{
+    for (int row = 0; row < h; row++) {
+        const fb_pixel_t *src = &framebuffer[(y + row) * DISPLAY_WIDTH + x];
+#if DISPLAY_INDEXED
+        for (int col = 0; col < w; col++) {
+            out[col] = palette[src[col]];
+        }
+#else
+        memcpy(out, src, w * sizeof(uint16_t));
+#endif
+        out += w;
+    }
 }
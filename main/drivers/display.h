@@ -30,6 +30,23 @@
 #define DISPLAY_SPI_HOST    SPI2_HOST
 #define DISPLAY_SPI_FREQ    80000000  // 80 MHz
 
+// Double buffering (second framebuffer used for DMA scan-out, ~64 KB SRAM).
+// Set by the build (-DDISPLAY_DOUBLE_BUFFER=ON/OFF, off by default on K132).
+#ifndef DISPLAY_DOUBLE_BUFFER
+#define DISPLAY_DOUBLE_BUFFER 0
+#endif
+
+// Indexed framebuffer: one byte per pixel into a palette of the colors
+// drawn since the last full clear, expanded to RGB565 while flushing
+// (~32 KB SRAM instead of ~64 KB; the flush then always returns early and
+// DISPLAY_DOUBLE_BUFFER has no effect). Colors past DISPLAY_PALETTE_SIZE
+// on one screen are drawn as the nearest palette entry. Set by the build
+// (-DDISPLAY_INDEXED=ON/OFF, on by default on K132).
+#ifndef DISPLAY_INDEXED
+#define DISPLAY_INDEXED 0
+#endif
+#define DISPLAY_PALETTE_SIZE    256
+
 // RGB565 color helpers
 #define RGB565(r, g, b) ((((r) & 0xF8) << 8) | (((g) & 0xFC) << 3) | (((b) & 0xF8) >> 3))
 
@@ -46,6 +63,16 @@
 #define COLOR_GRAY      0x8410
 #define COLOR_DARK_GRAY 0x2104
 
+/**
+ * @brief Convert an RGB565 color to panel (byte-swapped) order
+ * @param color RGB565 color
+ * @return Color as stored in the framebuffer / sent over SPI
+ */
+static inline uint16_t display_color_to_panel(uint16_t color)
+{
+    return (uint16_t)((color >> 8) | (color << 8));
+}
+
 /**
  * @brief Initialize the display
  * @return ESP_OK on success, ESP_FAIL otherwise
@@ -70,6 +97,31 @@ void display_fill_rect(int x, int y, int w, int h, uint16_t color);
  */
 void display_draw_pixel(int x, int y, uint16_t color);
 
+/**
+ * @brief Copy a block of pixels into the framebuffer
+ * @param x X coordinate
+ * @param y Y coordinate
+ * @param w Width of the block (also the source row stride)
+ * @param h Height of the block
+ * @param pixels Pixels in panel order (see display_color_to_panel)
+ */
+void display_blit(int x, int y, int w, int h, const uint16_t *pixels);
+
+/**
+ * @brief Scroll a full-width band of the screen vertically
+ *
+ * Moves the framebuffer contents of rows [y, y + h) by dy pixels and fills
+ * the exposed strip, so callers only render the newly visible content. The
+ * ST7789 VSCRDEF/VSCRSADD scroll runs along the panel's native 320-pixel
+ * axis, which is horizontal in the landscape orientation used here, so the
+ * scroll is done in RAM and the band goes out as one contiguous transfer.
+ * @param y Top of the band
+ * @param h Band height
+ * @param dy Pixels to move (negative = up)
+ * @param fill RGB565 color for the exposed strip
+ */
+void display_scroll_region(int y, int h, int dy, uint16_t fill);
+
 /**
  * @brief Draw a horizontal line
  * @param x X start
@@ -111,14 +163,66 @@ void display_clear(uint16_t color);
 void display_set_backlight(uint8_t brightness);
 
 /**
- * @brief Flush display buffer to screen (for buffered mode)
+ * @brief Push dirty regions of the framebuffer to the panel
+ *
+ * All drawing functions only update the RAM framebuffer and record the
+ * touched area. This sends the merged dirty rectangles to the ST7789 and
+ * returns once the transfers have completed. Cheap when nothing changed.
+ * With DISPLAY_DOUBLE_BUFFER it returns as soon as the transfers are queued;
+ * the next flush waits for them before reusing the DMA buffers.
  */
 void display_flush(void);
 
+// Cumulative panel traffic since boot (see display_get_stats)
+typedef struct {
+    uint32_t flushes;               // display_flush() calls that sent anything
+    uint32_t transactions;          // SPI color transfers queued
+    uint32_t pixels;                // Pixels pushed to the panel
+    uint64_t flush_us;              // Time spent inside display_flush()
+} display_stats_t;
+
 /**
- * @brief Get pointer to framebuffer for screenshot functionality
- * @return Pointer to RGB565 framebuffer (240x135 pixels)
+ * @brief Read the panel traffic counters
+ * @param out Counters; subtract two readings for a per-frame figure
+ */
+void display_get_stats(display_stats_t *out);
+
+// Flushed areas reported by display_take_damage()
+#define DISPLAY_MAX_DAMAGE_RECTS    8
+
+typedef struct {
+    int16_t x, y;
+    int16_t w, h;
+} display_rect_t;
+
+/**
+ * @brief Start or stop collecting the areas each flush sends to the panel
+ *
+ * For streaming the screen elsewhere (screen mirror). Enabling reports the
+ * whole screen once, so a consumer starts from a complete frame.
+ * @param enable true to collect
+ */
+void display_track_damage(bool enable);
+
+/**
+ * @brief Take the areas flushed since the last call, merged
+ *
+ * Pixels drawn while the consumer reads an area are flushed again later
+ * and reported again, so reading the framebuffer without the UI lock
+ * converges to the panel contents.
+ * @param out Receives up to DISPLAY_MAX_DAMAGE_RECTS rectangles
+ * @return Rectangle count (0 when nothing was flushed)
+ */
+int display_take_damage(display_rect_t *out);
+
+/**
+ * @brief Copy framebuffer pixels out (screenshots, recording, mirroring)
+ * @param x Left of the area
+ * @param y Top of the area
+ * @param w Width (also the row stride of out)
+ * @param h Height
+ * @param out Receives RGB565 pixels in panel (byte-swapped) order
  */
-const uint16_t* display_get_framebuffer(void);
+void display_read_pixels(int x, int y, int w, int h, uint16_t *out);
 
 #endif // DISPLAY_H
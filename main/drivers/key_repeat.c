@@ -0,0 +1,76 @@
+/**
+ * @file key_repeat.c
+ * @brief Auto-repeat for held navigation keys, shared by the keyboard drivers
+ */
+
+#include "key_repeat.h"
+
+bool key_repeat_is_repeatable(key_code_t key)
+{
+    switch (key) {
+        case KEY_UP:
+        case KEY_DOWN:
+        case KEY_LEFT:
+        case KEY_RIGHT:
+        case KEY_BACKSPACE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void key_repeat_press(key_repeat_t *r, key_code_t key, uint8_t id, int64_t now_us)
+{
+    if (KEY_REPEAT_DELAY_MS == 0 || !key_repeat_is_repeatable(key)) {
+        // Any other key interrupts a repeat, as on a desktop keyboard
+        key_repeat_cancel(r);
+        return;
+    }
+    
+    r->key = key;
+    r->id = id;
+    r->count = 0;
+    r->pressed_us = now_us;
+    r->next_us = now_us + (int64_t)KEY_REPEAT_DELAY_MS * 1000;
+}
+
+void key_repeat_release(key_repeat_t *r, uint8_t id)
+{
+    if (r->key != KEY_NONE && r->id == id) {
+        key_repeat_cancel(r);
+    }
+}
+
+void key_repeat_cancel(key_repeat_t *r)
+{
+    r->key = KEY_NONE;
+    r->count = 0;
+}
+
+key_code_t key_repeat_poll(key_repeat_t *r, int64_t now_us)
+{
+    if (r->key == KEY_NONE || now_us < r->next_us) return KEY_NONE;
+    
+    if (now_us - r->pressed_us > (int64_t)KEY_REPEAT_MAX_HOLD_MS * 1000) {
+        key_repeat_cancel(r);
+        return KEY_NONE;
+    }
+    
+    if (r->count < UINT16_MAX) r->count++;
+    int interval_ms = r->count >= KEY_REPEAT_ACCEL_AFTER ? KEY_REPEAT_FAST_MS : KEY_REPEAT_RATE_MS;
+    
+    // Schedule from the due time so a late poll does not slow the rate,
+    // but never queue up a burst after a long stall
+    r->next_us += (int64_t)interval_ms * 1000;
+    if (r->next_us < now_us) {
+        r->next_us = now_us + (int64_t)interval_ms * 1000;
+    }
+    return r->key;
+}
+
+int32_t key_repeat_due_ms(const key_repeat_t *r, int64_t now_us)
+{
+    if (r->key == KEY_NONE) return -1;
+    if (r->next_us <= now_us) return 0;
+    return (int32_t)((r->next_us - now_us + 999) / 1000);
+}
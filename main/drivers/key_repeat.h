@@ -0,0 +1,77 @@
+/**
+ * @file key_repeat.h
+ * @brief Auto-repeat for held navigation keys, shared by the keyboard drivers
+ *
+ * The driver reports presses and releases with an id for the physical
+ * switch; keyboard_process() polls for due repeats. After
+ * KEY_REPEAT_ACCEL_AFTER repeats the interval drops to KEY_REPEAT_FAST_MS.
+ */
+
+#ifndef KEY_REPEAT_H
+#define KEY_REPEAT_H
+
+#include "keyboard.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef CONFIG_KEY_REPEAT_DELAY_MS
+#define KEY_REPEAT_DELAY_MS     CONFIG_KEY_REPEAT_DELAY_MS
+#define KEY_REPEAT_RATE_MS      CONFIG_KEY_REPEAT_RATE_MS
+#define KEY_REPEAT_ACCEL_AFTER  CONFIG_KEY_REPEAT_ACCEL_AFTER
+#define KEY_REPEAT_FAST_MS      CONFIG_KEY_REPEAT_FAST_MS
+#else
+#define KEY_REPEAT_DELAY_MS     400     // Hold time before the first repeat (0 = off)
+#define KEY_REPEAT_RATE_MS      90
+#define KEY_REPEAT_ACCEL_AFTER  8
+#define KEY_REPEAT_FAST_MS      30
+#endif
+
+// Stop repeating a key held this long (guards against a lost release)
+#define KEY_REPEAT_MAX_HOLD_MS  20000
+
+typedef struct {
+    key_code_t key;         // KEY_NONE when nothing repeats
+    uint8_t id;             // Driver's identity of the held switch
+    uint16_t count;         // Repeats sent so far
+    int64_t pressed_us;
+    int64_t next_us;
+} key_repeat_t;
+
+/**
+ * @brief Check whether a key auto-repeats (arrows and backspace)
+ */
+bool key_repeat_is_repeatable(key_code_t key);
+
+/**
+ * @brief Start repeating a key; replaces any key already repeating
+ * @param r Repeat state
+ * @param key Decoded key (ignored unless repeatable)
+ * @param id Driver id of the switch, matched on release
+ * @param now_us Press time
+ */
+void key_repeat_press(key_repeat_t *r, key_code_t key, uint8_t id, int64_t now_us);
+
+/**
+ * @brief Stop repeating if the released switch is the one held
+ */
+void key_repeat_release(key_repeat_t *r, uint8_t id);
+
+/**
+ * @brief Stop any repeat
+ */
+void key_repeat_cancel(key_repeat_t *r);
+
+/**
+ * @brief Get the key to repeat now, if one is due
+ * @return Key, or KEY_NONE
+ */
+key_code_t key_repeat_poll(key_repeat_t *r, int64_t now_us);
+
+/**
+ * @brief Milliseconds until the next repeat is due
+ * @return Delay (0 if overdue), or -1 if nothing repeats
+ */
+int32_t key_repeat_due_ms(const key_repeat_t *r, int64_t now_us);
+
+#endif // KEY_REPEAT_H
@@ -85,6 +85,9 @@ typedef enum {
     KEY_MAX
 } key_code_t;
 
+// Presses queued by keyboard_inject() until the next keyboard_process()
+#define KEYBOARD_INJECT_QUEUE_LEN   16
+
 /**
  * @brief Check if shift key is currently held
  * @return true if shift is pressed
@@ -131,12 +134,47 @@ esp_err_t keyboard_init(void);
  */
 void keyboard_process(void);
 
+/**
+ * @brief Time until keyboard_process() must run to send the next auto-repeat
+ *
+ * Held arrows and backspace repeat after a delay and speed up after a few
+ * repeats (see key_repeat.h).
+ * @return Milliseconds (0 if due now), or -1 if no key is repeating
+ */
+int32_t keyboard_repeat_due_ms(void);
+
 /**
  * @brief Register a callback for key events
  * @param callback Function to call on key events
  */
 void keyboard_register_callback(key_event_callback_t callback);
 
+// Key event notification type (runs on the keyboard task or scan timer)
+typedef void (*keyboard_notify_callback_t)(void);
+
+/**
+ * @brief Register a function called when key events are waiting
+ *
+ * On boards whose keyboard controller has an interrupt line, a keyboard
+ * task reads the events when the line fires, queues them with timestamps
+ * and calls this; on the K132 matrix a periodic scan timer does the same.
+ * keyboard_process() then delivers them.
+ * @param callback Function called from the keyboard task or scan timer,
+ *                 or NULL to remove
+ * @return true if key events arrive by themselves, false if
+ *         keyboard_process() must be polled
+ */
+bool keyboard_set_notify_callback(keyboard_notify_callback_t callback);
+
+/**
+ * @brief Time of the key event being delivered
+ *
+ * Valid inside the key callback: when the key interrupt fired, or when the
+ * matrix scan accepted the press.
+ * @return esp_timer time in microseconds
+ */
+int64_t keyboard_get_event_time_us(void);
+
 /**
  * @brief Enable or disable forwarding key events to callback handlers
  * @param enabled true to call registered callback, false to suppress it
@@ -156,6 +194,17 @@ key_code_t keyboard_get_key(void);
  */
 bool keyboard_is_pressed(key_code_t key);
 
+/**
+ * @brief Queue a key press from another source (e.g. the screen mirror host)
+ *
+ * Delivered by the next keyboard_process() on the UI task, like a matrix
+ * press, without modifiers. Safe from any task; the caller should post
+ * APP_EVENT_KEY so it is processed promptly.
+ * @param key Key to press
+ * @return ESP_OK, ESP_ERR_TIMEOUT if the queue is full, ESP_ERR_INVALID_ARG
+ */
+esp_err_t keyboard_inject(key_code_t key);
+
 #endif // KEYBOARD_H
 
 
@@ -3,14 +3,21 @@
  * @brief Keyboard driver for M5Stack Cardputer ADV
  * 
  * Uses TCA8418 keyboard controller at I2C address 0x34
- * TCA8418 is a I2C/SMBus keyboard controller with interrupt support
+ * TCA8418 is a I2C/SMBus keyboard controller with interrupt support;
+ * its INT line (active low) is wired to KEYBOARD_INT_GPIO
  */
 
 #include "keyboard.h"
+#include "key_repeat.h"
+#include "keymap.h"
+#include "task_plan.h"
 #include "esp_log.h"
 #include "driver/i2c.h"
 #include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "freertos/queue.h"
 #include <string.h>
 
@@ -22,6 +29,13 @@ static const char *TAG = "KEYBOARD";
 #define KEYBOARD_I2C_SCL        9
 #define KEYBOARD_I2C_FREQ       100000
 #define KEYBOARD_I2C_ADDR       0x34  // TCA8418 address
+#define KEYBOARD_INT_GPIO       11    // TCA8418 INT, open drain
+
+// Key task (interrupt mode): woken by INT, drains the FIFO and hands
+// timestamped events to keyboard_process()
+#define KEY_TASK_IDLE_CHECK_MS  500
+#define KEY_RAW_QUEUE_LEN       32
+#define TCA8418_FIFO_DEPTH      10
 
 // TCA8418 Register addresses
 #define TCA8418_REG_CFG             0x01
@@ -87,10 +101,76 @@ static const char *TAG = "KEYBOARD";
 
 // Key event queue
 static QueueHandle_t key_queue = NULL;
+static QueueHandle_t inject_queue = NULL;   // Remote presses (keyboard_inject)
 static key_event_callback_t key_callback = NULL;
 static bool callback_enabled = true;
 static key_code_t last_key = KEY_NONE;
 static bool keyboard_initialized = false;
+static keyboard_notify_callback_t notify_callback = NULL;
+static bool int_available = false;
+
+// Raw FIFO entry as read by key_task
+typedef struct {
+    uint8_t raw;            // KEY_EVENT_A value: code | pressed bit
+    int64_t time_us;        // When the interrupt was taken
+} raw_key_event_t;
+
+static QueueHandle_t raw_queue = NULL;
+static TaskHandle_t key_task_handle = NULL;
+static volatile int64_t irq_time_us = 0;
+static int64_t event_time_us = 0;   // Timestamp of the event being delivered
+static key_repeat_t repeat;         // Held arrow/backspace, keyed by raw code
+
+static void key_task(void *arg);
+
+static void IRAM_ATTR keyboard_int_isr(void *arg)
+{
+    (void)arg;
+    irq_time_us = esp_timer_get_time();
+    if (key_task_handle) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(key_task_handle, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+/**
+ * @brief Route the TCA8418 INT line to key_task
+ */
+static void keyboard_int_init(void)
+{
+    gpio_config_t int_conf = {
+        .pin_bit_mask = 1ULL << KEYBOARD_INT_GPIO,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_NEGEDGE,
+    };
+    if (gpio_config(&int_conf) != ESP_OK) return;
+    
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "GPIO ISR service unavailable, keyboard is polled");
+        return;
+    }
+    raw_queue = xQueueCreate(KEY_RAW_QUEUE_LEN, sizeof(raw_key_event_t));
+    if (!raw_queue ||
+        xTaskCreatePinnedToCore(key_task, "keyboard", TASK_KEYBOARD_STACK, NULL,
+                                TASK_KEYBOARD_PRIO, &key_task_handle,
+                                TASK_KEYBOARD_CORE) != pdPASS) {
+        ESP_LOGW(TAG, "Key task unavailable, keyboard is polled");
+        key_task_handle = NULL;
+        return;
+    }
+    if (gpio_isr_handler_add(KEYBOARD_INT_GPIO, keyboard_int_isr, NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "Key interrupt unavailable, keyboard is polled");
+        vTaskDelete(key_task_handle);
+        key_task_handle = NULL;
+        return;
+    }
+    task_plan_track(TASK_ID_KEYBOARD, key_task_handle);
+    int_available = true;
+}
 
 /**
  * @brief Read a register from TCA8418
@@ -179,26 +259,6 @@ static esp_err_t tca8418_init(void)
     return ESP_OK;
 }
 
-/**
- * @brief Keyboard layout map from M5Stack official code
- * Layout: 4 rows × 14 columns after remap
- * 
- * Row 0: `  1  2  3  4  5  6  7  8  9  0  -  =  del
- * Row 1: tab q  w  e  r  t  y  u  i  o  p  [  ]  \
- * Row 2: shift caps a  s  d  f  g  h  j  k  l  ;  '  enter  
- * Row 3: ctrl opt alt z  x  c  v  b  n  m  ,  .  /  space
- */
-static const key_code_t _key_value_map[4][14] = {
-    // Row 0: ` 1 2 3 4 5 6 7 8 9 0 - = del
-    {KEY_GRAVE, KEY_1, KEY_2, KEY_3, KEY_4, KEY_5, KEY_6, KEY_7, KEY_8, KEY_9, KEY_0, KEY_MINUS, KEY_EQUAL, KEY_BACKSPACE},
-    // Row 1: tab q w e r t y u i o p [ ] backslash
-    {KEY_TAB, KEY_Q, KEY_W, KEY_E, KEY_R, KEY_T, KEY_Y, KEY_U, KEY_I, KEY_O, KEY_P, KEY_LBRACKET, KEY_RBRACKET, KEY_BACKSLASH},
-    // Row 2: shift capslock a s d f g h j k l ; ' enter
-    {KEY_SHIFT, KEY_CAPSLOCK, KEY_A, KEY_S, KEY_D, KEY_F, KEY_G, KEY_H, KEY_J, KEY_K, KEY_L, KEY_SEMICOLON, KEY_APOSTROPHE, KEY_ENTER},
-    // Row 3: ctrl opt alt z x c v b n m , . / space
-    {KEY_CTRL, KEY_OPT, KEY_ALT, KEY_Z, KEY_X, KEY_C, KEY_V, KEY_B, KEY_N, KEY_M, KEY_COMMA, KEY_DOT, KEY_SLASH, KEY_SPACE}
-};
-
 // Modifier key states (tracked by raw key code)
 static bool fn_held = false;      // Fn key (raw code 3)
 static bool shift_held = false;   // Shift/Aa key (raw code 7)
@@ -278,9 +338,17 @@ esp_err_t keyboard_init(void)
         ESP_LOGE(TAG, "Failed to create key queue");
         return ESP_FAIL;
     }
+    inject_queue = xQueueCreate(KEYBOARD_INJECT_QUEUE_LEN, sizeof(key_code_t));
+    if (inject_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create key inject queue");
+        return ESP_FAIL;
+    }
 
+    keyboard_int_init();
+    
     keyboard_initialized = true;
-    ESP_LOGI(TAG, "Keyboard initialized successfully");
+    ESP_LOGI(TAG, "Keyboard initialized successfully (%s)",
+             int_available ? "interrupt" : "polled");
     return ESP_OK;
 }
 
@@ -293,11 +361,11 @@ static void update_modifier_state_by_code(uint8_t raw_key_code, bool pressed)
     switch (raw_key_code) {
         case 3:  // Fn key
             fn_held = pressed;
-            ESP_LOGI(TAG, "Fn %s", pressed ? "HELD" : "released");
+            ESP_LOGD(TAG, "Fn %s", pressed ? "HELD" : "released");
             break;
         case 7:  // Shift/Aa key
             shift_held = pressed;
-            ESP_LOGI(TAG, "Shift %s", pressed ? "HELD" : "released");
+            ESP_LOGD(TAG, "Shift %s", pressed ? "HELD" : "released");
             break;
     }
 }
@@ -322,130 +390,241 @@ static void update_modifier_state(uint8_t row, uint8_t col, bool pressed)
     }
 }
 
-static void scan_keyboard(void)
+/**
+ * @brief Hand a decoded key press to the queue and callback
+ */
+static void deliver_key(key_code_t key)
 {
-    if (!keyboard_initialized) return;
+    last_key = key;
+    xQueueSend(key_queue, &key, 0);
+    
+    if (callback_enabled && key_callback) {
+        key_callback(key, true);
+    }
+}
 
-    // Read key event count
-    uint8_t key_lck_ec;
-    esp_err_t ret = tca8418_read_reg(TCA8418_REG_KEY_LCK_EC, &key_lck_ec);
-    if (ret != ESP_OK) return;
+/**
+ * @brief Decode one KEY_EVENT_A value and deliver it
+ */
+static void handle_key_event(uint8_t key_event)
+{
+    uint8_t raw_key_code = key_event & TCA8418_KEY_EVENT_CODE_MASK;
+    bool pressed = (key_event & TCA8418_KEY_EVENT_PRESSED) != 0;
     
-    uint8_t event_count = key_lck_ec & 0x0F;  // Lower 4 bits = event count
+    ESP_LOGD(TAG, "Key event: code=%d, %s, %lld us after interrupt", raw_key_code,
+             pressed ? "PRESSED" : "released", (long long)(esp_timer_get_time() - event_time_us));
     
-    // Process all pending key events
-    for (int i = 0; i < event_count && i < 10; i++) {
-        uint8_t key_event;
-        ret = tca8418_read_reg(TCA8418_REG_KEY_EVENT_A, &key_event);
-        if (ret != ESP_OK || key_event == 0) break;
-        
-        uint8_t raw_key_code = key_event & TCA8418_KEY_EVENT_CODE_MASK;
-        bool pressed = (key_event & TCA8418_KEY_EVENT_PRESSED) != 0;
-        
-        ESP_LOGI(TAG, "Key event: code=%d, %s", raw_key_code, pressed ? "PRESSED" : "released");
-        
-        // First, update modifier state by raw code (Fn=3, Shift=7)
-        update_modifier_state_by_code(raw_key_code, pressed);
-        
-        // Skip processing for pure modifier keys (Fn=3, Shift=7)
-        if (raw_key_code == 3 || raw_key_code == 7) {
-            continue;  // Don't send modifier keys as key events
+    if (!pressed) {
+        key_repeat_release(&repeat, raw_key_code);
+    }
+    
+    // First, update modifier state by raw code (Fn=3, Shift=7)
+    update_modifier_state_by_code(raw_key_code, pressed);
+    
+    // Skip processing for pure modifier keys (Fn=3, Shift=7)
+    if (raw_key_code == 3 || raw_key_code == 7) {
+        return;  // Don't send modifier keys as key events
+    }
+    
+    key_code_t key = KEY_NONE;
+    uint8_t row = 0, col = 0;
+    bool is_arrow_key = false;
+    bool is_special_fn_key = false;
+    
+    // ` key (code 1) = ESC
+    // In text_input_mode: requires Fn (without Fn = ` character)
+    // In navigation mode: ESC works without Fn
+    if (raw_key_code == 1) {
+        bool esc_active = text_input_mode ? fn_held : true;
+        if (esc_active) {
+            key = KEY_ESC;
+            is_special_fn_key = true;
         }
-        
-        key_code_t key = KEY_NONE;
-        uint8_t row = 0, col = 0;
-        bool is_arrow_key = false;
-        bool is_special_fn_key = false;
-        
-        // ` key (code 1) = ESC
-        // In text_input_mode: requires Fn (without Fn = ` character)
-        // In navigation mode: ESC works without Fn
-        if (raw_key_code == 1) {
-            bool esc_active = text_input_mode ? fn_held : true;
-            if (esc_active) {
-                key = KEY_ESC;
-                is_special_fn_key = true;
-            }
+    }
+    
+    // Arrow keys: codes 54/57/58/64
+    // In text_input_mode: arrows require Fn, without Fn = characters
+    // In navigation mode (default): arrows work without Fn
+    bool arrow_active = text_input_mode ? fn_held : true;
+    
+    if (arrow_active) {
+        switch (raw_key_code) {
+            case 57:  // ; or UP arrow
+                key = KEY_UP;
+                is_arrow_key = true;
+                break;
+            case 58:  // . or DOWN arrow  
+                key = KEY_DOWN;
+                is_arrow_key = true;
+                break;
+            case 54:  // , or LEFT arrow
+                key = KEY_LEFT;
+                is_arrow_key = true;
+                break;
+            case 64:  // / or RIGHT arrow
+                key = KEY_RIGHT;
+                is_arrow_key = true;
+                break;
         }
+    }
+    
+    // Parse normal matrix keys (including 54/57/58/64 when Fn not held)
+    if (!is_arrow_key && !is_special_fn_key && raw_key_code > 0) {
+        uint16_t buffer = raw_key_code;
+        buffer--;
+        uint8_t raw_row = buffer / 10;
+        uint8_t raw_col = buffer % 10;
         
-        // Arrow keys: codes 54/57/58/64
-        // In text_input_mode: arrows require Fn, without Fn = characters
-        // In navigation mode (default): arrows work without Fn
-        bool arrow_active = text_input_mode ? fn_held : true;
+        // Normal matrix key - apply remap
+        row = raw_row;
+        col = raw_col;
+        remap_key(&row, &col);
         
-        if (arrow_active) {
-            switch (raw_key_code) {
-                case 57:  // ; or UP arrow
-                    key = KEY_UP;
-                    is_arrow_key = true;
-                    break;
-                case 58:  // . or DOWN arrow  
-                    key = KEY_DOWN;
-                    is_arrow_key = true;
-                    break;
-                case 54:  // , or LEFT arrow
-                    key = KEY_LEFT;
-                    is_arrow_key = true;
-                    break;
-                case 64:  // / or RIGHT arrow
-                    key = KEY_RIGHT;
-                    is_arrow_key = true;
-                    break;
-            }
+        // Update modifier state by position (Ctrl, Capslock)
+        update_modifier_state(row, col, pressed);
+        
+        // Bounds check
+        if (row < KEYMAP_ROWS && col < KEYMAP_COLS) {
+            key = keymap_matrix[row][col];
+        } else {
+            ESP_LOGW(TAG, "Key out of bounds: code=%d raw(%d,%d) -> (%d,%d)", 
+                     raw_key_code, raw_row, raw_col, row, col);
+        }
+    }
+    
+    // Check if this is a modifier key (don't send as regular key event)
+    bool is_modifier = !is_arrow_key && (
+                      (row == 3 && col == 0));   // Ctrl only
+    
+    // Send non-modifier key press events
+    if (pressed && key != KEY_NONE && !is_modifier) {
+        key_repeat_press(&repeat, key, raw_key_code, event_time_us);
+        deliver_key(key);
+    }
+}
+
+/**
+ * @brief Read a run of consecutive registers (CFG has auto-increment set)
+ */
+static esp_err_t tca8418_read_regs(uint8_t reg, uint8_t *values, size_t len)
+{
+    return i2c_master_write_read_device(KEYBOARD_I2C_PORT, KEYBOARD_I2C_ADDR,
+                                        &reg, 1, values, len, pdMS_TO_TICKS(10));
+}
+
+/**
+ * @brief Drain the TCA8418 event FIFO and acknowledge the interrupt
+ *
+ * INT_STAT and KEY_LCK_EC are read in one transfer. Every read of
+ * KEY_EVENT_A pops the FIFO, so the events are fetched as repeated
+ * register reads chained into a single I2C transaction.
+ * @return Number of events stored, or -1 on bus error
+ */
+static int tca8418_read_fifo(uint8_t *events, int max)
+{
+    uint8_t stat[2];    // INT_STAT, KEY_LCK_EC
+    if (tca8418_read_regs(TCA8418_REG_INT_STAT, stat, sizeof(stat)) != ESP_OK) return -1;
+    
+    int count = stat[1] & 0x0F;  // Lower 4 bits = event count
+    if (count > max) count = max;
+    
+    if (count > 0) {
+        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+        if (!cmd) return -1;
+        for (int i = 0; i < count; i++) {
+            i2c_master_start(cmd);
+            i2c_master_write_byte(cmd, (KEYBOARD_I2C_ADDR << 1) | I2C_MASTER_WRITE, true);
+            i2c_master_write_byte(cmd, TCA8418_REG_KEY_EVENT_A, true);
+            i2c_master_start(cmd);
+            i2c_master_write_byte(cmd, (KEYBOARD_I2C_ADDR << 1) | I2C_MASTER_READ, true);
+            i2c_master_read_byte(cmd, &events[i], I2C_MASTER_NACK);
         }
+        i2c_master_stop(cmd);
+        esp_err_t ret = i2c_master_cmd_begin(KEYBOARD_I2C_PORT, cmd, pdMS_TO_TICKS(20));
+        i2c_cmd_link_delete(cmd);
+        if (ret != ESP_OK) return -1;
+    }
+    
+    if (stat[0]) {
+        tca8418_write_reg(TCA8418_REG_INT_STAT, stat[0]);  // Clear by writing 1s
+    }
+    return count;
+}
+
+/**
+ * @brief Key task: sleeps until the INT line fires, then drains the FIFO
+ *
+ * The INT level is re-checked every KEY_TASK_IDLE_CHECK_MS without touching
+ * the bus, in case an edge was missed while the FIFO was being read.
+ */
+static void key_task(void *arg)
+{
+    (void)arg;
+    uint8_t events[TCA8418_FIFO_DEPTH];
+    
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(KEY_TASK_IDLE_CHECK_MS));
         
-        // Parse normal matrix keys (including 54/57/58/64 when Fn not held)
-        if (!is_arrow_key && !is_special_fn_key && raw_key_code > 0) {
-            uint16_t buffer = raw_key_code;
-            buffer--;
-            uint8_t raw_row = buffer / 10;
-            uint8_t raw_col = buffer % 10;
-            
-            // Normal matrix key - apply remap
-            row = raw_row;
-            col = raw_col;
-            remap_key(&row, &col);
-            
-            // Update modifier state by position (Ctrl, Capslock)
-            update_modifier_state(row, col, pressed);
+        while (gpio_get_level(KEYBOARD_INT_GPIO) == 0) {
+            int count = tca8418_read_fifo(events, TCA8418_FIFO_DEPTH);
+            if (count <= 0) break;
             
-            // Bounds check
-            if (row < 4 && col < 14) {
-                key = _key_value_map[row][col];
-            } else {
-                ESP_LOGW(TAG, "Key out of bounds: code=%d raw(%d,%d) -> (%d,%d)", 
-                         raw_key_code, raw_row, raw_col, row, col);
+            int64_t time_us = irq_time_us;
+            for (int i = 0; i < count; i++) {
+                if (events[i] == 0) break;
+                raw_key_event_t ev = { .raw = events[i], .time_us = time_us };
+                if (xQueueSend(raw_queue, &ev, 0) != pdTRUE) {
+                    ESP_LOGW(TAG, "Key event queue full, dropping events");
+                    break;
+                }
             }
-        }
-        
-        // Check if this is a modifier key (don't send as regular key event)
-        bool is_modifier = !is_arrow_key && (
-                          (row == 3 && col == 0));   // Ctrl only
-        
-        // Send non-modifier key press events
-        if (pressed && key != KEY_NONE && !is_modifier) {
-            last_key = key;
-            xQueueSend(key_queue, &key, 0);
             
-            if (callback_enabled && key_callback) {
-                key_callback(key, true);
+            keyboard_notify_callback_t cb = notify_callback;
+            if (cb) {
+                cb();
             }
         }
     }
+}
+
+void keyboard_process(void)
+{
+    if (!keyboard_initialized) return;
     
-    // Clear interrupt if any events were processed
-    if (event_count > 0) {
-        uint8_t int_stat;
-        tca8418_read_reg(TCA8418_REG_INT_STAT, &int_stat);
-        if (int_stat) {
-            tca8418_write_reg(TCA8418_REG_INT_STAT, int_stat);
+    if (key_task_handle) {
+        // Interrupt mode: events were read by key_task
+        raw_key_event_t ev;
+        while (xQueueReceive(raw_queue, &ev, 0) == pdTRUE) {
+            event_time_us = ev.time_us;
+            handle_key_event(ev.raw);
+        }
+    } else {
+        // Polled mode
+        uint8_t events[TCA8418_FIFO_DEPTH];
+        int count = tca8418_read_fifo(events, TCA8418_FIFO_DEPTH);
+        event_time_us = esp_timer_get_time();
+        for (int i = 0; i < count; i++) {
+            if (events[i] == 0) break;
+            handle_key_event(events[i]);
         }
     }
+    
+    int64_t now_us = esp_timer_get_time();
+    key_code_t key = key_repeat_poll(&repeat, now_us);
+    if (key != KEY_NONE) {
+        event_time_us = now_us;
+        deliver_key(key);
+    }
+    
+    while (xQueueReceive(inject_queue, &key, 0) == pdTRUE) {
+        event_time_us = now_us;
+        deliver_key(key);
+    }
 }
 
-void keyboard_process(void)
+int32_t keyboard_repeat_due_ms(void)
 {
-    scan_keyboard();
+    return key_repeat_due_ms(&repeat, esp_timer_get_time());
 }
 
 void keyboard_register_callback(key_event_callback_t callback)
@@ -453,6 +632,17 @@ void keyboard_register_callback(key_event_callback_t callback)
     key_callback = callback;
 }
 
+int64_t keyboard_get_event_time_us(void)
+{
+    return event_time_us;
+}
+
+bool keyboard_set_notify_callback(keyboard_notify_callback_t callback)
+{
+    notify_callback = callback;
+    return int_available;
+}
+
 void keyboard_set_callback_enabled(bool enabled)
 {
     callback_enabled = enabled;
@@ -497,3 +687,10 @@ void keyboard_set_text_input_mode(bool enabled)
     text_input_mode = enabled;
     ESP_LOGI(TAG, "Text input mode: %s", enabled ? "ON" : "OFF");
 }
+
+esp_err_t keyboard_inject(key_code_t key)
+{
+    if (!inject_queue) return ESP_ERR_INVALID_STATE;
+    if (key == KEY_NONE || key >= KEY_MAX) return ESP_ERR_INVALID_ARG;
+    return xQueueSend(inject_queue, &key, 0) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+}
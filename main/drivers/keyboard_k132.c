@@ -1,12 +1,26 @@
 /**
  * @file keyboard_k132.c
  * @brief Keyboard driver for M5Stack Cardputer (K132) using 74HC138
+ *
+ * The matrix is scanned every K132_SCAN_MS by an esp_timer callback, so
+ * the scan runs on the high-priority timer task at a steady rate however
+ * long the UI spends drawing. Each key is debounced by a 2-bit integrator
+ * kept as bitmasks (one bit per column, a vertical counter per row): a
+ * change is accepted after four scans in a row that all disagree with the
+ * accepted state, and any agreeing scan restarts the count. Accepted
+ * changes go into a single-producer, single-consumer ring with the time
+ * of the scan, and the notify callback wakes the main loop;
+ * keyboard_process() then turns them into keys on the UI task, where the
+ * modifier and repeat state lives.
  */
 
 #include "keyboard.h"
+#include "key_repeat.h"
+#include "keymap.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "esp_rom_sys.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include <string.h>
@@ -21,16 +35,27 @@ static const char *TAG = "KEYBOARD";
 #define K132_ROWS 8
 #define K132_COLS 7
 
+#ifdef CONFIG_KEYBOARD_SCAN_MS
+#define K132_SCAN_MS        CONFIG_KEYBOARD_SCAN_MS
+#else
+#define K132_SCAN_MS        2
+#endif
+#define K132_ROW_SETTLE_US  30      // Column lines settle after a row change
+#define K132_EVENT_RING     32      // Power of two
+
 static const gpio_num_t k132_col_pins[K132_COLS] = {
     13, 15, 3, 4, 5, 6, 7
 };
 
 // Key event queue
 static QueueHandle_t key_queue = NULL;
+static QueueHandle_t inject_queue = NULL;   // Remote presses (keyboard_inject)
 static key_event_callback_t key_callback = NULL;
 static bool callback_enabled = true;
 static key_code_t last_key = KEY_NONE;
 static bool keyboard_initialized = false;
+static int64_t event_time_us = 0;    // Scan that accepted the key being delivered
+static key_repeat_t repeat;          // Held arrow/backspace, keyed by matrix position
 
 // Modifier key states
 static bool fn_held = false;
@@ -39,17 +64,28 @@ static bool ctrl_held = false;
 static bool capslock_state = false;
 
 static bool text_input_mode = false;
-static bool key_state[K132_ROWS][K132_COLS];
 
-/**
- * @brief Keyboard layout map (4 rows x 14 columns)
- */
-static const key_code_t key_value_map[4][14] = {
-    {KEY_GRAVE, KEY_1, KEY_2, KEY_3, KEY_4, KEY_5, KEY_6, KEY_7, KEY_8, KEY_9, KEY_0, KEY_MINUS, KEY_EQUAL, KEY_BACKSPACE},
-    {KEY_TAB, KEY_Q, KEY_W, KEY_E, KEY_R, KEY_T, KEY_Y, KEY_U, KEY_I, KEY_O, KEY_P, KEY_LBRACKET, KEY_RBRACKET, KEY_BACKSLASH},
-    {KEY_FN, KEY_SHIFT, KEY_A, KEY_S, KEY_D, KEY_F, KEY_G, KEY_H, KEY_J, KEY_K, KEY_L, KEY_SEMICOLON, KEY_APOSTROPHE, KEY_ENTER},
-    {KEY_CTRL, KEY_OPT, KEY_ALT, KEY_Z, KEY_X, KEY_C, KEY_V, KEY_B, KEY_N, KEY_M, KEY_COMMA, KEY_DOT, KEY_SLASH, KEY_SPACE}
-};
+// Debounced key change, from the scan to keyboard_process()
+typedef struct {
+    int64_t time_us;                // Scan that accepted it
+    uint8_t row;
+    uint8_t col;
+    bool pressed;
+} k132_event_t;
+
+// Scan state, one bit per column: accepted levels (1 = pressed) and a
+// 2-bit count per key of scans in a row that disagreed with them
+static uint8_t debounced[K132_ROWS];
+static uint8_t count_lo[K132_ROWS];
+static uint8_t count_hi[K132_ROWS];
+static esp_timer_handle_t scan_timer = NULL;
+static keyboard_notify_callback_t notify_callback = NULL;
+
+// Written at ring_head by the scan only, read at ring_tail by
+// keyboard_process() only; the indices run freely and wrap
+static k132_event_t event_ring[K132_EVENT_RING];
+static uint32_t ring_head = 0;
+static uint32_t ring_tail = 0;
 
 typedef struct {
     uint8_t x_1;
@@ -117,13 +153,31 @@ static bool raw_to_xy(uint8_t raw_row, uint8_t raw_col, uint8_t *x, uint8_t *y)
     return true;
 }
 
+/**
+ * @brief Hand a decoded key press to the queue and callback
+ */
+static void deliver_key(key_code_t key)
+{
+    last_key = key;
+    xQueueSend(key_queue, &key, 0);
+
+    if (callback_enabled && key_callback) {
+        key_callback(key, true);
+    }
+}
+
 static void handle_key_event(uint8_t raw_row, uint8_t raw_col, bool pressed)
 {
     uint8_t x = 0;
     uint8_t y = 0;
     if (!raw_to_xy(raw_row, raw_col, &x, &y)) return;
 
-    key_code_t key = key_value_map[y][x];
+    uint8_t switch_id = raw_row * K132_COLS + raw_col;
+    if (!pressed) {
+        key_repeat_release(&repeat, switch_id);
+    }
+
+    key_code_t key = keymap_matrix[y][x];
 
     update_modifier_state(key, pressed);
 
@@ -154,32 +208,80 @@ static void handle_key_event(uint8_t raw_row, uint8_t raw_col, bool pressed)
 
     if (key == KEY_NONE) return;
 
-    last_key = key;
-    xQueueSend(key_queue, &key, 0);
+    key_repeat_press(&repeat, key, switch_id, event_time_us);
+    deliver_key(key);
+}
 
-    if (callback_enabled && key_callback) {
-        key_callback(key, true);
+/**
+ * @brief Queue an accepted key change (scan side)
+ * @return false if the ring is full
+ */
+static bool push_event(uint8_t row, uint8_t col, bool pressed, int64_t time_us)
+{
+    uint32_t head = ring_head;
+    if (head - __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE) >= K132_EVENT_RING) {
+        return false;
     }
+    event_ring[head % K132_EVENT_RING] = (k132_event_t){
+        .time_us = time_us,
+        .row = row,
+        .col = col,
+        .pressed = pressed,
+    };
+    __atomic_store_n(&ring_head, head + 1, __ATOMIC_RELEASE);
+    return true;
 }
 
-static void scan_keyboard(void)
+/**
+ * @brief Sample every row once and queue the changes the integrator accepts
+ *
+ * A change that finds the ring full is not accepted: its key keeps the old
+ * level and is counted again, so a release is late rather than lost.
+ */
+static void scan_matrix(void)
 {
-    if (!keyboard_initialized) return;
+    int64_t now_us = esp_timer_get_time();
+    bool queued = false;
 
     for (uint8_t row = 0; row < K132_ROWS; row++) {
         set_row_select(row);
-        esp_rom_delay_us(30);
+        esp_rom_delay_us(K132_ROW_SETTLE_US);
 
+        uint8_t sample = 0;
         for (uint8_t col = 0; col < K132_COLS; col++) {
-            bool pressed = (gpio_get_level(k132_col_pins[col]) == 0);
-            if (pressed != key_state[row][col]) {
-                key_state[row][col] = pressed;
-                handle_key_event(row, col, pressed);
+            if (gpio_get_level(k132_col_pins[col]) == 0) {
+                sample |= (uint8_t)(1u << col);
             }
         }
+
+        // Count up where the sample differs, back to 0 where it agrees;
+        // a key whose count wraps after the fourth scan is accepted
+        uint8_t delta = sample ^ debounced[row];
+        count_hi[row] = (count_hi[row] ^ count_lo[row]) & delta;
+        count_lo[row] = (uint8_t)~count_lo[row] & delta;
+        uint8_t changed = delta & (uint8_t)~(count_lo[row] | count_hi[row]);
+
+        for (uint8_t col = 0; changed && col < K132_COLS; col++) {
+            uint8_t bit = (uint8_t)(1u << col);
+            if (!(changed & bit)) continue;
+            if (!push_event(row, col, sample & bit, now_us)) break;
+            debounced[row] ^= bit;
+            queued = true;
+        }
+    }
+
+    keyboard_notify_callback_t cb = notify_callback;
+    if (queued && cb) {
+        cb();
     }
 }
 
+static void scan_timer_cb(void *arg)
+{
+    (void)arg;
+    scan_matrix();
+}
+
 esp_err_t keyboard_init(void)
 {
     ESP_LOGI(TAG, "Initializing Cardputer K132 keyboard (74HC138)...");
@@ -209,22 +311,75 @@ esp_err_t keyboard_init(void)
     };
     gpio_config(&col_conf);
 
-    memset(key_state, 0, sizeof(key_state));
+    memset(debounced, 0, sizeof(debounced));
+    memset(count_lo, 0, sizeof(count_lo));
+    memset(count_hi, 0, sizeof(count_hi));
 
     key_queue = xQueueCreate(16, sizeof(key_code_t));
     if (key_queue == NULL) {
         ESP_LOGE(TAG, "Failed to create key queue");
         return ESP_FAIL;
     }
+    inject_queue = xQueueCreate(KEYBOARD_INJECT_QUEUE_LEN, sizeof(key_code_t));
+    if (inject_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create key inject queue");
+        return ESP_FAIL;
+    }
 
     keyboard_initialized = true;
-    ESP_LOGI(TAG, "Keyboard initialized successfully");
+
+    const esp_timer_create_args_t scan_args = {
+        .callback = scan_timer_cb,
+        .name = "k132_scan",
+    };
+    if (esp_timer_create(&scan_args, &scan_timer) != ESP_OK) {
+        scan_timer = NULL;
+    } else if (esp_timer_start_periodic(scan_timer, K132_SCAN_MS * 1000ULL) != ESP_OK) {
+        esp_timer_delete(scan_timer);
+        scan_timer = NULL;
+    }
+    if (!scan_timer) {
+        ESP_LOGW(TAG, "Scan timer unavailable, keyboard_process() scans instead");
+    }
+
+    ESP_LOGI(TAG, "Keyboard initialized successfully (%s)",
+             scan_timer ? "timer scan" : "polled");
     return ESP_OK;
 }
 
 void keyboard_process(void)
 {
-    scan_keyboard();
+    if (!keyboard_initialized) return;
+
+    if (!scan_timer) {
+        scan_matrix();
+    }
+
+    uint32_t tail = ring_tail;
+    uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    while (tail != head) {
+        k132_event_t ev = event_ring[tail % K132_EVENT_RING];
+        __atomic_store_n(&ring_tail, ++tail, __ATOMIC_RELEASE);
+        event_time_us = ev.time_us;
+        handle_key_event(ev.row, ev.col, ev.pressed);
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    key_code_t key = key_repeat_poll(&repeat, now_us);
+    if (key != KEY_NONE) {
+        event_time_us = now_us;
+        deliver_key(key);
+    }
+
+    while (xQueueReceive(inject_queue, &key, 0) == pdTRUE) {
+        event_time_us = now_us;
+        deliver_key(key);
+    }
+}
+
+int32_t keyboard_repeat_due_ms(void)
+{
+    return key_repeat_due_ms(&repeat, esp_timer_get_time());
 }
 
 void keyboard_register_callback(key_event_callback_t callback)
@@ -232,6 +387,18 @@ void keyboard_register_callback(key_event_callback_t callback)
     key_callback = callback;
 }
 
+int64_t keyboard_get_event_time_us(void)
+{
+    return event_time_us;
+}
+
+bool keyboard_set_notify_callback(keyboard_notify_callback_t callback)
+{
+    // No interrupt line, but the scan timer plays its part
+    notify_callback = callback;
+    return scan_timer != NULL;
+}
+
 void keyboard_set_callback_enabled(bool enabled)
 {
     callback_enabled = enabled;
@@ -276,3 +443,10 @@ void keyboard_set_text_input_mode(bool enabled)
     text_input_mode = enabled;
     ESP_LOGI(TAG, "Text input mode: %s", enabled ? "ON" : "OFF");
 }
+
+esp_err_t keyboard_inject(key_code_t key)
+{
+    if (!inject_queue) return ESP_ERR_INVALID_STATE;
+    if (key == KEY_NONE || key >= KEY_MAX) return ESP_ERR_INVALID_ARG;
+    return xQueueSend(inject_queue, &key, 0) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file keymap.c
+ * @brief US keyboard layout tables (see keymap.h)
+ */
+
+#include "keymap.h"
+
+/*
+ * Row 0: `  1  2  3  4  5  6  7  8  9  0  -  =  del
+ * Row 1: tab q  w  e  r  t  y  u  i  o  p  [  ]  \
+ * Row 2: shift caps a  s  d  f  g  h  j  k  l  ;  '  enter   (ADV)
+ *        fn shift   a  s  d  f  g  h  j  k  l  ;  '  enter   (K132)
+ * Row 3: ctrl opt alt z  x  c  v  b  n  m  ,  .  /  space
+ */
+const key_code_t keymap_matrix[KEYMAP_ROWS][KEYMAP_COLS] = {
+    {KEY_GRAVE, KEY_1, KEY_2, KEY_3, KEY_4, KEY_5, KEY_6, KEY_7, KEY_8, KEY_9, KEY_0, KEY_MINUS, KEY_EQUAL, KEY_BACKSPACE},
+    {KEY_TAB, KEY_Q, KEY_W, KEY_E, KEY_R, KEY_T, KEY_Y, KEY_U, KEY_I, KEY_O, KEY_P, KEY_LBRACKET, KEY_RBRACKET, KEY_BACKSLASH},
+#ifdef BOARD_K132
+    {KEY_FN, KEY_SHIFT, KEY_A, KEY_S, KEY_D, KEY_F, KEY_G, KEY_H, KEY_J, KEY_K, KEY_L, KEY_SEMICOLON, KEY_APOSTROPHE, KEY_ENTER},
+#else
+    {KEY_SHIFT, KEY_CAPSLOCK, KEY_A, KEY_S, KEY_D, KEY_F, KEY_G, KEY_H, KEY_J, KEY_K, KEY_L, KEY_SEMICOLON, KEY_APOSTROPHE, KEY_ENTER},
+#endif
+    {KEY_CTRL, KEY_OPT, KEY_ALT, KEY_Z, KEY_X, KEY_C, KEY_V, KEY_B, KEY_N, KEY_M, KEY_COMMA, KEY_DOT, KEY_SLASH, KEY_SPACE}
+};
+
+// Layers in keymap_layer_t order: base, shift, caps, shift+caps
+#define LETTER(k, lo, up)   [KEY_##k] = {lo, up, up, lo}
+#define SHIFTED(k, lo, up)  [KEY_##k] = {lo, up, lo, up}
+#define PLAIN(k, ch)        [KEY_##k] = {ch, ch, ch, ch}
+
+const char keymap_chars[KEY_MAX][KEYMAP_LAYER_COUNT] = {
+    LETTER(A, 'a', 'A'), LETTER(B, 'b', 'B'), LETTER(C, 'c', 'C'),
+    LETTER(D, 'd', 'D'), LETTER(E, 'e', 'E'), LETTER(F, 'f', 'F'),
+    LETTER(G, 'g', 'G'), LETTER(H, 'h', 'H'), LETTER(I, 'i', 'I'),
+    LETTER(J, 'j', 'J'), LETTER(K, 'k', 'K'), LETTER(L, 'l', 'L'),
+    LETTER(M, 'm', 'M'), LETTER(N, 'n', 'N'), LETTER(O, 'o', 'O'),
+    LETTER(P, 'p', 'P'), LETTER(Q, 'q', 'Q'), LETTER(R, 'r', 'R'),
+    LETTER(S, 's', 'S'), LETTER(T, 't', 'T'), LETTER(U, 'u', 'U'),
+    LETTER(V, 'v', 'V'), LETTER(W, 'w', 'W'), LETTER(X, 'x', 'X'),
+    LETTER(Y, 'y', 'Y'), LETTER(Z, 'z', 'Z'),
+
+    SHIFTED(1, '1', '!'), SHIFTED(2, '2', '@'), SHIFTED(3, '3', '#'),
+    SHIFTED(4, '4', '$'), SHIFTED(5, '5', '%'), SHIFTED(6, '6', '^'),
+    SHIFTED(7, '7', '&'), SHIFTED(8, '8', '*'), SHIFTED(9, '9', '('),
+    SHIFTED(0, '0', ')'),
+
+    SHIFTED(GRAVE, '`', '~'),       SHIFTED(MINUS, '-', '_'),
+    SHIFTED(EQUAL, '=', '+'),       SHIFTED(LBRACKET, '[', '{'),
+    SHIFTED(RBRACKET, ']', '}'),    SHIFTED(BACKSLASH, '\\', '|'),
+    SHIFTED(SEMICOLON, ';', ':'),   SHIFTED(APOSTROPHE, '\'', '"'),
+    SHIFTED(COMMA, ',', '<'),       SHIFTED(DOT, '.', '>'),
+    SHIFTED(SLASH, '/', '?'),
+
+    PLAIN(SPACE, ' '),
+    PLAIN(TAB, '\t'),
+};
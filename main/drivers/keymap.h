@@ -0,0 +1,43 @@
+/**
+ * @file keymap.h
+ * @brief Key matrix layout and key-to-character table shared by both boards
+ *
+ * keymap_matrix maps the 4x14 matrix position (after each driver's own
+ * remap) to a key code; only row 2 differs between ADV and K132.
+ * keymap_chars holds the character each key types on every modifier
+ * layer, so text entry is one table lookup. Letters follow Shift XOR
+ * Caps Lock, digits and symbols follow Shift only.
+ */
+
+#ifndef KEYMAP_H
+#define KEYMAP_H
+
+#include "keyboard.h"
+#include <stdbool.h>
+
+#define KEYMAP_ROWS     4
+#define KEYMAP_COLS     14
+
+// Modifier layer index: bit 0 = Shift, bit 1 = Caps Lock
+typedef enum {
+    KEYMAP_LAYER_BASE = 0,
+    KEYMAP_LAYER_SHIFT,
+    KEYMAP_LAYER_CAPS,
+    KEYMAP_LAYER_SHIFT_CAPS,
+    KEYMAP_LAYER_COUNT
+} keymap_layer_t;
+
+extern const key_code_t keymap_matrix[KEYMAP_ROWS][KEYMAP_COLS];
+extern const char keymap_chars[KEY_MAX][KEYMAP_LAYER_COUNT];
+
+/**
+ * @brief Character typed by a key on the given modifier layer
+ * @return 0 if the key does not type a character
+ */
+static inline char keymap_char(key_code_t key, bool shift, bool caps)
+{
+    if ((unsigned)key >= KEY_MAX) return 0;
+    return keymap_chars[key][(unsigned)shift | ((unsigned)caps << 1)];
+}
+
+#endif // KEYMAP_H
@@ -0,0 +1,274 @@
+/**
+ * @file screen_mirror.c
+ * @brief Live display mirroring over USB CDC with delta updates
+ *
+ * The display keeps a second dirty list of flushed areas while mirroring.
+ * The mirror task takes it every SCREEN_MIRROR_INTERVAL_MS and encodes the
+ * framebuffer pixels of each area, one row copy at a time, into the USB
+ * driver's ring in row bands that fit the encode buffer. The framebuffer is read without
+ * the UI lock: a pixel drawn meanwhile is flushed, reported and sent again.
+ */
+
+#include "screen_mirror.h"
+#include "display.h"
+#include "keyboard.h"
+#include "app_events.h"
+#include "usb_bridge.h"
+#include "usb_msc.h"
+#include "task_plan.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/usb_serial_jtag.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "SCREEN_MIRROR";
+
+#define MIRROR_VERSION          1
+
+#ifdef CONFIG_SCREEN_MIRROR_INTERVAL_MS
+#define MIRROR_INTERVAL_MS      CONFIG_SCREEN_MIRROR_INTERVAL_MS
+#else
+#define MIRROR_INTERVAL_MS      50
+#endif
+
+#define MIRROR_RING_SIZE        16384
+#define MIRROR_ENCODE_BUF_SIZE  4096
+#define MIRROR_WRITE_TIMEOUT_MS 100
+
+#define PACKET_HEADER_SIZE      7       // 'M' 'F' type u32 len
+#define RECT_HEADER_SIZE        8
+#define ROW_WORST_CASE          (DISPLAY_WIDTH * 4)
+
+typedef enum {
+    MIRROR_IDLE = 0,
+    MIRROR_RUNNING,
+    MIRROR_STOPPING,        // Task is releasing the USB driver
+} mirror_state_t;
+
+static volatile mirror_state_t state = MIRROR_IDLE;
+static uint8_t *encode_buf = NULL;
+static uint16_t row[DISPLAY_WIDTH];     // Pixels of the row being encoded
+static bool host_lost = false;          // A write timed out; resync on the next one
+
+static inline void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static inline void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+/**
+ * @brief Frame the payload already at encode_buf + PACKET_HEADER_SIZE and send it
+ * @return false if the host did not take it in time
+ */
+static bool send_packet(uint8_t type, size_t payload_len)
+{
+    encode_buf[0] = 'M';
+    encode_buf[1] = 'F';
+    encode_buf[2] = type;
+    put_u32(&encode_buf[3], payload_len);
+    
+    size_t len = PACKET_HEADER_SIZE + payload_len;
+    int sent = usb_serial_jtag_write_bytes(encode_buf, len,
+                                           pdMS_TO_TICKS(MIRROR_WRITE_TIMEOUT_MS));
+    if (sent != (int)len) {
+        host_lost = true;
+        return false;
+    }
+    return true;
+}
+
+static bool send_hello(void)
+{
+    uint8_t *p = encode_buf + PACKET_HEADER_SIZE;
+    put_u16(p, MIRROR_VERSION);
+    put_u16(p + 2, DISPLAY_WIDTH);
+    put_u16(p + 4, DISPLAY_HEIGHT);
+    return send_packet('H', 6);
+}
+
+/**
+ * @brief Encode one damaged area as one or more row-band rect packets
+ */
+static bool send_rect(const display_rect_t *r)
+{
+    int y = r->y;
+    int y_end = r->y + r->h;
+    
+    while (y < y_end) {
+        uint8_t *payload = encode_buf + PACKET_HEADER_SIZE;
+        uint8_t *p = payload + RECT_HEADER_SIZE;
+        uint8_t *limit = encode_buf + MIRROR_ENCODE_BUF_SIZE - ROW_WORST_CASE;
+        int band_y = y;
+        
+        // Runs never cross rows, so a band can end after any row
+        do {
+            display_read_pixels(r->x, y, r->w, 1, row);
+            uint16_t run_value = row[0];
+            uint16_t run = 1;
+            for (int x = 1; x < r->w; x++) {
+                if (row[x] == run_value) {
+                    run++;
+                    continue;
+                }
+                put_u16(p, run);
+                put_u16(p + 2, run_value);
+                p += 4;
+                run_value = row[x];
+                run = 1;
+            }
+            put_u16(p, run);
+            put_u16(p + 2, run_value);
+            p += 4;
+            y++;
+        } while (y < y_end && p <= limit);
+        
+        put_u16(payload, r->x);
+        put_u16(payload + 2, band_y);
+        put_u16(payload + 4, r->w);
+        put_u16(payload + 6, y - band_y);
+        if (!send_packet('R', p - payload)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Act on bytes the host sent (key presses, resync requests)
+ */
+static void handle_host_input(const uint8_t *data, int len)
+{
+    bool key_posted = false;
+    for (int i = 0; i < len; i++) {
+        if (data[i] == 'S') {
+            display_track_damage(true);
+        } else if (data[i] == 'K' && i + 1 < len) {
+            key_code_t key = (key_code_t)data[++i];
+            if (keyboard_inject(key) == ESP_OK) key_posted = true;
+        }
+    }
+    if (key_posted) {
+        app_events_post(APP_EVENT_KEY);
+    }
+}
+
+static void mirror_task(void *arg)
+{
+    (void)arg;
+    int64_t start_us = esp_timer_get_time();
+    uint8_t input[32];
+    display_rect_t rects[DISPLAY_MAX_DAMAGE_RECTS];
+    
+    host_lost = !send_hello();
+    
+    while (state == MIRROR_RUNNING) {
+        int len = usb_serial_jtag_read_bytes(input, sizeof(input),
+                                             pdMS_TO_TICKS(MIRROR_INTERVAL_MS));
+        if (len > 0) {
+            handle_host_input(input, len);
+        }
+        
+        if (host_lost) {
+            // Viewer missed part of the stream: start it over from a full screen
+            if (!send_hello()) continue;
+            host_lost = false;
+            display_track_damage(true);
+        }
+        
+        int count = display_take_damage(rects);
+        if (count == 0) continue;
+        
+        bool ok = true;
+        for (int i = 0; i < count && ok; i++) {
+            ok = send_rect(&rects[i]);
+        }
+        if (ok) {
+            put_u32(encode_buf + PACKET_HEADER_SIZE,
+                    (uint32_t)((esp_timer_get_time() - start_us) / 1000));
+            send_packet('F', 4);
+        }
+    }
+    
+    display_track_damage(false);
+    usb_serial_jtag_driver_uninstall();
+    free(encode_buf);
+    encode_buf = NULL;
+    esp_log_level_set("*", CONFIG_LOG_DEFAULT_LEVEL);
+    ESP_LOGI(TAG, "Mirroring stopped after %lld s",
+             (long long)((esp_timer_get_time() - start_us) / 1000000));
+    
+    state = MIRROR_IDLE;
+    vTaskDelete(NULL);
+}
+
+static esp_err_t mirror_start(void)
+{
+    if (usb_bridge_is_active() || usb_msc_is_active()) {
+        ESP_LOGW(TAG, "USB is in use by the bridge or the SD export, cannot mirror");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    encode_buf = malloc(MIRROR_ENCODE_BUF_SIZE);
+    if (!encode_buf) return ESP_ERR_NO_MEM;
+    
+    usb_serial_jtag_driver_config_t config = {
+        .rx_buffer_size = 256,
+        .tx_buffer_size = MIRROR_RING_SIZE,
+    };
+    esp_err_t ret = usb_serial_jtag_driver_install(&config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "USB driver install failed: %s", esp_err_to_name(ret));
+        free(encode_buf);
+        encode_buf = NULL;
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "Mirroring display over USB every %d ms, logging paused",
+             MIRROR_INTERVAL_MS);
+    // Log lines would corrupt the packet stream
+    esp_log_level_set("*", ESP_LOG_NONE);
+    
+    display_track_damage(true);
+    state = MIRROR_RUNNING;
+    if (xTaskCreatePinnedToCore(mirror_task, "screen_mirror", TASK_SCREEN_MIRROR_STACK, NULL,
+                                TASK_SCREEN_MIRROR_PRIO, NULL, TASK_SCREEN_MIRROR_CORE) != pdPASS) {
+        state = MIRROR_IDLE;
+        display_track_damage(false);
+        usb_serial_jtag_driver_uninstall();
+        free(encode_buf);
+        encode_buf = NULL;
+        esp_log_level_set("*", CONFIG_LOG_DEFAULT_LEVEL);
+        ESP_LOGE(TAG, "Failed to create mirror task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t screen_mirror_toggle(void)
+{
+    switch (state) {
+        case MIRROR_IDLE:
+            return mirror_start();
+        case MIRROR_RUNNING:
+            state = MIRROR_STOPPING;
+            return ESP_OK;
+        default:
+            ESP_LOGW(TAG, "Previous mirroring session still stopping");
+            return ESP_ERR_INVALID_STATE;
+    }
+}
+
+bool screen_mirror_is_active(void)
+{
+    return state == MIRROR_RUNNING;
+}
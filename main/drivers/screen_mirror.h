@@ -0,0 +1,48 @@
+/**
+ * @file screen_mirror.h
+ * @brief Live display mirroring over USB CDC with delta updates
+ *
+ * While active (Ctrl+M), the areas each flush sends to the panel are
+ * streamed over the USB Serial/JTAG CDC port, run-length encoded, and key
+ * presses from the host are injected as if typed on the keyboard.
+ * tools/mirror_viewer.py is the host side.
+ *
+ * Device -> host packets (little-endian):
+ *   u8 'M', u8 'F', u8 type, u32 payload_len, payload
+ *   'H' hello:  u16 version (1), u16 width, u16 height; sent on start and
+ *               after the host missed data, followed by the full screen
+ *   'R' rect:   u16 x, u16 y, u16 w, u16 h, then (u16 count, u16 value)
+ *               runs over the w x h pixels, row-major, panel (byte-swapped)
+ *               RGB565 order
+ *   'F' frame:  u32 time_ms; the rects since the previous 'F' form one
+ *               update and can be presented
+ * Host -> device:
+ *   'K' <key>   one key press, key is a key_code_t value (keyboard.h)
+ *   'S'         resend the full screen
+ *
+ * Log output shares the USB CDC port, so logging is silenced while
+ * mirroring. Mirroring and the USB bridge (usb_bridge.h) exclude each
+ * other.
+ */
+
+#ifndef SCREEN_MIRROR_H
+#define SCREEN_MIRROR_H
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+/**
+ * @brief Start mirroring, or stop it
+ * @return ESP_OK, ESP_ERR_INVALID_STATE while the USB bridge runs or the
+ *         previous session is still stopping, ESP_ERR_NO_MEM, or the USB
+ *         driver error
+ */
+esp_err_t screen_mirror_toggle(void);
+
+/**
+ * @brief Check if mirroring is running
+ */
+bool screen_mirror_is_active(void);
+
+#endif // SCREEN_MIRROR_H
@@ -0,0 +1,334 @@
+/**
+ * @file screen_record.c
+ * @brief Screen recording to SD card as delta-encoded frames
+ *
+ * The render task copies each flushed frame into a pending buffer. The
+ * recorder task samples it every SCREEN_RECORD_INTERVAL_MS, finds the
+ * bounding box of changed pixels against the previous sample and writes
+ * the run-length encoded XOR of that box.
+ */
+
+#include "screen_record.h"
+#include "screenshot.h"
+#include "display.h"
+#include "task_plan.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static const char *TAG = "SCREEN_REC";
+
+#define RECORD_DIR              "/sdcard/screens"
+#define RECORD_VERSION          1
+
+#ifdef CONFIG_SCREEN_RECORD_INTERVAL_MS
+#define RECORD_INTERVAL_MS      CONFIG_SCREEN_RECORD_INTERVAL_MS
+#else
+#define RECORD_INTERVAL_MS      200
+#endif
+
+#define RECORD_WRITE_BUF_SIZE   (16 * 1024)
+#define FRAME_PIXELS            (DISPLAY_WIDTH * DISPLAY_HEIGHT)
+
+#ifdef CONFIG_SPIRAM
+#define RECORD_BUF_CAPS         (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define RECORD_BUF_CAPS         MALLOC_CAP_8BIT
+#endif
+
+typedef enum {
+    REC_IDLE = 0,
+    REC_RUNNING,
+    REC_STOPPING,           // Task is closing the file
+} rec_state_t;
+
+// Frame buffers: pending is written by the render task under frame_lock;
+// cur and prev belong to the recorder task
+static uint16_t *pending = NULL;
+static uint16_t *cur = NULL;
+static uint16_t *prev = NULL;
+static uint8_t *write_buf = NULL;
+static bool pending_new = false;
+static SemaphoreHandle_t frame_lock = NULL;
+
+static volatile rec_state_t state = REC_IDLE;
+static FILE *rec_file = NULL;
+static size_t write_used = 0;
+static bool write_failed = false;
+
+static void free_buffers(void)
+{
+    free(pending);
+    free(cur);
+    free(prev);
+    free(write_buf);
+    pending = cur = prev = NULL;
+    write_buf = NULL;
+}
+
+static void out_flush(void)
+{
+    if (write_used > 0 && fwrite(write_buf, 1, write_used, rec_file) != write_used) {
+        write_failed = true;
+    }
+    write_used = 0;
+}
+
+static void out_write(const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    while (len > 0) {
+        size_t n = RECORD_WRITE_BUF_SIZE - write_used;
+        if (n > len) n = len;
+        memcpy(write_buf + write_used, p, n);
+        write_used += n;
+        p += n;
+        len -= n;
+        if (write_used == RECORD_WRITE_BUF_SIZE) {
+            out_flush();
+        }
+    }
+}
+
+static void out_u16(uint16_t v)
+{
+    uint8_t b[2] = { v & 0xFF, v >> 8 };
+    out_write(b, sizeof(b));
+}
+
+static void out_u32(uint32_t v)
+{
+    uint8_t b[4] = { v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF, v >> 24 };
+    out_write(b, sizeof(b));
+}
+
+/**
+ * @brief Bounding box of pixels that differ between cur and prev
+ * @return false if the frames are identical
+ */
+static bool find_dirty_rect(int *x0, int *y0, int *x1, int *y1)
+{
+    int top = -1, bottom = -1;
+    int left = DISPLAY_WIDTH, right = -1;
+    
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        const uint16_t *a = &cur[y * DISPLAY_WIDTH];
+        const uint16_t *b = &prev[y * DISPLAY_WIDTH];
+        if (memcmp(a, b, DISPLAY_WIDTH * sizeof(uint16_t)) == 0) continue;
+        
+        if (top < 0) top = y;
+        bottom = y;
+        int l = 0;
+        while (a[l] == b[l]) l++;
+        int r = DISPLAY_WIDTH - 1;
+        while (a[r] == b[r]) r--;
+        if (l < left) left = l;
+        if (r > right) right = r;
+    }
+    if (top < 0) return false;
+    
+    *x0 = left;
+    *y0 = top;
+    *x1 = right + 1;
+    *y1 = bottom + 1;
+    return true;
+}
+
+/**
+ * @brief Size of the RLE payload for a rectangle, so it can be written up front
+ */
+static uint32_t rle_pass(int x0, int y0, int x1, int y1, bool emit)
+{
+    uint32_t bytes = 0;
+    uint16_t run_value = 0;
+    uint32_t run = 0;
+    
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            int i = y * DISPLAY_WIDTH + x;
+            uint16_t v = cur[i] ^ prev[i];
+            if (run > 0 && (v != run_value || run == UINT16_MAX)) {
+                if (emit) { out_u16((uint16_t)run); out_u16(run_value); }
+                bytes += 4;
+                run = 0;
+            }
+            run_value = v;
+            run++;
+        }
+    }
+    if (run > 0) {
+        if (emit) { out_u16((uint16_t)run); out_u16(run_value); }
+        bytes += 4;
+    }
+    return bytes;
+}
+
+static void write_frame(uint32_t time_ms)
+{
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    find_dirty_rect(&x0, &y0, &x1, &y1);
+    
+    out_u32(time_ms);
+    out_u16(x0);
+    out_u16(y0);
+    out_u16(x1 - x0);
+    out_u16(y1 - y0);
+    out_u32(rle_pass(x0, y0, x1, y1, false));
+    rle_pass(x0, y0, x1, y1, true);
+    
+    uint16_t *tmp = prev;
+    prev = cur;
+    cur = tmp;
+}
+
+static void record_task(void *arg)
+{
+    (void)arg;
+    int64_t start_us = esp_timer_get_time();
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t frames = 0;
+    
+    while (state == REC_RUNNING && !write_failed) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(RECORD_INTERVAL_MS));
+        
+        bool fresh = false;
+        xSemaphoreTake(frame_lock, portMAX_DELAY);
+        if (pending_new) {
+            memcpy(cur, pending, FRAME_PIXELS * sizeof(uint16_t));
+            pending_new = false;
+            fresh = true;
+        }
+        xSemaphoreGive(frame_lock);
+        
+        // Unchanged screens cost nothing; the next frame's time covers the gap
+        if (fresh) {
+            write_frame((uint32_t)((esp_timer_get_time() - start_us) / 1000));
+            frames++;
+        }
+    }
+    
+    out_flush();
+    fclose(rec_file);
+    rec_file = NULL;
+    if (write_failed) {
+        ESP_LOGE(TAG, "Write failed, recording stopped");
+    }
+    ESP_LOGI(TAG, "Recording stopped: %lu frames, %lld s", (unsigned long)frames,
+             (long long)((esp_timer_get_time() - start_us) / 1000000));
+    
+    xSemaphoreTake(frame_lock, portMAX_DELAY);
+    free_buffers();
+    xSemaphoreGive(frame_lock);
+    state = REC_IDLE;
+    vTaskDelete(NULL);
+}
+
+static int next_recording_number(void)
+{
+    char path[64];
+    struct stat st;
+    for (int n = 1; n < 10000; n++) {
+        snprintf(path, sizeof(path), "%s/rec_%d.mrec", RECORD_DIR, n);
+        if (stat(path, &st) != 0) return n;
+    }
+    return -1;
+}
+
+static esp_err_t record_start(void)
+{
+    if (!screenshot_is_available()) {
+        ESP_LOGW(TAG, "SD card not mounted, cannot record");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!frame_lock) {
+        frame_lock = xSemaphoreCreateMutex();
+        if (!frame_lock) return ESP_ERR_NO_MEM;
+    }
+    
+    size_t fb_bytes = FRAME_PIXELS * sizeof(uint16_t);
+    pending = heap_caps_malloc(fb_bytes, RECORD_BUF_CAPS);
+    cur = heap_caps_malloc(fb_bytes, RECORD_BUF_CAPS);
+    prev = heap_caps_calloc(1, fb_bytes, RECORD_BUF_CAPS);   // First frame vs black
+    write_buf = heap_caps_malloc(RECORD_WRITE_BUF_SIZE, RECORD_BUF_CAPS);
+    if (!pending || !cur || !prev || !write_buf) {
+        ESP_LOGE(TAG, "No memory for recording buffers");
+        free_buffers();
+        return ESP_ERR_NO_MEM;
+    }
+    
+    int number = next_recording_number();
+    char path[64];
+    snprintf(path, sizeof(path), "%s/rec_%d.mrec", RECORD_DIR, number);
+    rec_file = number > 0 ? fopen(path, "wb") : NULL;
+    if (!rec_file) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        free_buffers();
+        return ESP_FAIL;
+    }
+    
+    write_used = 0;
+    write_failed = false;
+    out_write("MREC", 4);
+    out_u16(RECORD_VERSION);
+    out_u16(DISPLAY_WIDTH);
+    out_u16(DISPLAY_HEIGHT);
+    out_u16(RECORD_INTERVAL_MS);
+    
+    // Start from the frame currently on screen (caller holds the UI lock)
+    display_read_pixels(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, pending);
+    pending_new = true;
+    
+    state = REC_RUNNING;
+    if (xTaskCreatePinnedToCore(record_task, "screen_rec", TASK_SCREEN_RECORD_STACK, NULL,
+                                TASK_CAPTURE_PRIO, NULL, TASK_CAPTURE_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create recorder task");
+        state = REC_IDLE;
+        fclose(rec_file);
+        rec_file = NULL;
+        free_buffers();
+        return ESP_ERR_NO_MEM;
+    }
+    
+    ESP_LOGI(TAG, "Recording to %s every %d ms", path, RECORD_INTERVAL_MS);
+    return ESP_OK;
+}
+
+esp_err_t screen_record_toggle(void)
+{
+    switch (state) {
+        case REC_IDLE:
+            return record_start();
+        case REC_RUNNING:
+            state = REC_STOPPING;
+            return ESP_OK;
+        default:
+            ESP_LOGW(TAG, "Previous recording still being finished");
+            return ESP_ERR_INVALID_STATE;
+    }
+}
+
+bool screen_record_is_active(void)
+{
+    return state == REC_RUNNING;
+}
+
+void screen_record_capture(void)
+{
+    if (state != REC_RUNNING) return;
+    
+    // Never stall the render task behind the recorder
+    if (xSemaphoreTake(frame_lock, 0) != pdTRUE) return;
+    if (pending) {
+        display_read_pixels(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, pending);
+        pending_new = true;
+    }
+    xSemaphoreGive(frame_lock);
+}
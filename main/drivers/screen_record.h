@@ -0,0 +1,41 @@
+/**
+ * @file screen_record.h
+ * @brief Screen recording to SD card as delta-encoded frames
+ *
+ * File format (.mrec, little-endian):
+ *   header: "MREC", u16 version (1), u16 width, u16 height, u16 interval_ms
+ *   frame:  u32 time_ms, u16 x, u16 y, u16 w, u16 h, u32 payload_len,
+ *           payload = (u16 count, u16 value) runs of the XOR between this
+ *           frame and the previous one over the w x h rectangle, row-major.
+ * Pixels are RGB565 in panel (byte-swapped) order; the first frame is XORed
+ * against black. tools/mrec_convert.py turns a recording into a GIF.
+ */
+
+#ifndef SCREEN_RECORD_H
+#define SCREEN_RECORD_H
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+/**
+ * @brief Start recording to the next /sdcard/screens/rec_N.mrec, or stop
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE without SD card or while
+ *         the previous recording is still being finished, ESP_ERR_NO_MEM
+ */
+esp_err_t screen_record_toggle(void);
+
+/**
+ * @brief Check if a recording is running
+ */
+bool screen_record_is_active(void);
+
+/**
+ * @brief Offer the framebuffer just flushed to the recorder
+ *
+ * Called by the render task after each flush with the UI lock held; only
+ * copies the frame, and only while recording.
+ */
+void screen_record_capture(void);
+
+#endif // SCREEN_RECORD_H
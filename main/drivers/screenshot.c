@@ -2,20 +2,39 @@
  * @file screenshot.c
  * @brief Screenshot functionality with SD card storage
  * 
- * Saves screenshots as 24-bit BMP files to /screens/ directory on SD card.
- * File naming: scr_1.bmp, scr_2.bmp, etc.
+ * Saves screenshots as BMP files under /screens/ on the SD card, in one
+ * subdirectory per day (YYYY-MM-DD, from the GPS clock) or, without a
+ * date, per SCREENS_PER_BUCKET numbers (nNNN), so no directory grows large.
+ * File naming: scr_1.bmp, scr_2.bmp, etc., numbered across all of them.
+ *
+ * The next number is kept in a small index file read at boot; the full
+ * directory walk only runs on the screenshot task as a consistency check
+ * (e.g. after the card was used in another device).
+ *
+ * screenshot_take() only copies the framebuffer; a low-priority task
+ * encodes it as 8-bit RLE BMP (or RGB565 BMP above 256 colors) and writes
+ * it through a large buffer.
  */
 
 #include "screenshot.h"
 #include "display.h"
+#include "sd_io.h"
+#include "cap_gps.h"
+#include "task_plan.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "esp_vfs_fat.h"
 #include "sdmmc_cmd.h"
 #include "driver/sdspi_host.h"
 #include "driver/spi_common.h"
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <time.h>
 
 static const char *TAG = "SCREENSHOT";
 
@@ -28,14 +47,32 @@ static const char *TAG = "SCREENSHOT";
 // SD card mount point
 #define MOUNT_POINT     "/sdcard"
 #define SCREENS_DIR     MOUNT_POINT "/screens"
+#define SCREENS_INDEX   SCREENS_DIR "/next.idx"
+#define SCREENS_PER_BUCKET  100     // Undated screenshots per directory
 
 // Use SPI3_HOST (VSPI) for SD card - SPI2 is used by display
 #define SD_SPI_HOST     SPI3_HOST
 
+// Encoder task and its in-flight buffers
+#define SHOT_WRITE_BUF_SIZE     (16 * 1024)
+#ifdef CONFIG_SPIRAM
+#define SHOT_BUF_CAPS           (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define SHOT_BUF_CAPS           MALLOC_CAP_8BIT
+#endif
+
 // State
 static bool sd_mounted = false;
 static int screenshot_counter = 1;
+static portMUX_TYPE counter_lock = portMUX_INITIALIZER_UNLOCKED;
 static sdmmc_card_t *card = NULL;
+static sdmmc_card_t *export_card = NULL;   // Raw card while lent to USB
+
+static TaskHandle_t shot_task = NULL;
+static uint16_t *shot_snapshot = NULL;
+static uint8_t *shot_write_buf = NULL;
+static int shot_number = 0;
+static volatile bool shot_busy = false;
 
 // BMP file header structures (packed for correct byte alignment)
 #pragma pack(push, 1)
@@ -62,31 +99,142 @@ typedef struct {
 } bmp_info_header_t;
 #pragma pack(pop)
 
+static void screenshot_task(void *arg);
+
 /**
- * @brief Find next available screenshot number by scanning existing files
+ * @brief Next number from the index file, 0 if missing or unreadable
  */
-static void find_next_screenshot_number(void)
+static int read_counter_index(void)
 {
-    DIR *dir = opendir(SCREENS_DIR);
-    if (dir == NULL) {
-        screenshot_counter = 1;
-        return;
+    FILE *f = fopen(SCREENS_INDEX, "r");
+    if (!f) return 0;
+    int next = 0;
+    if (fscanf(f, "%d", &next) != 1 || next < 1) next = 0;
+    fclose(f);
+    return next;
+}
+
+static void write_counter_index(int next)
+{
+    FILE *f = fopen(SCREENS_INDEX, "w");
+    if (!f) return;
+    fprintf(f, "%d\n", next);
+    fclose(f);
+}
+
+/**
+ * @brief Hand out a number (take) or make sure later ones exceed a floor
+ */
+static int take_number(void)
+{
+    portENTER_CRITICAL(&counter_lock);
+    int n = screenshot_counter++;
+    portEXIT_CRITICAL(&counter_lock);
+    return n;
+}
+
+static bool raise_counter(int next)
+{
+    bool raised = false;
+    portENTER_CRITICAL(&counter_lock);
+    if (next > screenshot_counter) {
+        screenshot_counter = next;
+        raised = true;
     }
+    portEXIT_CRITICAL(&counter_lock);
+    return raised;
+}
+
+/**
+ * @brief Highest scr_N.bmp in a directory, descending one level into buckets
+ */
+static int scan_max_number(const char *path, bool descend)
+{
+    DIR *dir = opendir(path);
+    if (dir == NULL) return 0;
     
     int max_num = 0;
     struct dirent *entry;
     while ((entry = readdir(dir)) != NULL) {
         int num;
         if (sscanf(entry->d_name, "scr_%d.bmp", &num) == 1) {
-            if (num > max_num) {
-                max_num = num;
-            }
+            if (num > max_num) max_num = num;
+        } else if (descend && entry->d_type == DT_DIR && entry->d_name[0] != '.') {
+            char sub[64];
+            snprintf(sub, sizeof(sub), "%s/%.24s", path, entry->d_name);
+            num = scan_max_number(sub, false);
+            if (num > max_num) max_num = num;
         }
     }
     closedir(dir);
+    return max_num;
+}
+
+/**
+ * @brief Background check that the index is ahead of every file on the card
+ */
+static void check_counter_index(void)
+{
+    int64_t start_us = esp_timer_get_time();
+    int next = scan_max_number(SCREENS_DIR, true) + 1;
+    if (raise_counter(next)) {
+        write_counter_index(next);
+        ESP_LOGW(TAG, "Screenshot index was behind the card, next is %d", next);
+    }
+    ESP_LOGI(TAG, "Screenshot index checked in %lld ms",
+             (long long)((esp_timer_get_time() - start_us) / 1000));
+}
+
+/**
+ * @brief Directory for a screenshot: today's date when GPS knows it, else
+ * a bucket by number. Created if missing.
+ */
+static void bucket_dir(char *out, size_t len, int number)
+{
+    cap_gps_snapshot_t gps;
+    if (cap_gps_get_snapshot(&gps) && gps.utc_time != 0 && gps.fix_age_ms != UINT32_MAX) {
+        time_t now = gps.utc_time + gps.fix_age_ms / 1000;
+        struct tm tm;
+        gmtime_r(&now, &tm);
+        snprintf(out, len, "%s/%04d-%02d-%02d", SCREENS_DIR,
+                 tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+    } else {
+        snprintf(out, len, "%s/n%03d", SCREENS_DIR, number / SCREENS_PER_BUCKET);
+    }
     
-    screenshot_counter = max_num + 1;
-    ESP_LOGI(TAG, "Next screenshot number: %d", screenshot_counter);
+    struct stat st;
+    if (stat(out, &st) != 0) {
+        mkdir(out, 0755);
+    }
+}
+
+/**
+ * @brief Host and slot settings for the card on SD_SPI_HOST
+ */
+static void card_config(sdmmc_host_t *host, sdspi_device_config_t *slot)
+{
+    sdspi_device_config_t slot_config = SDSPI_DEVICE_CONFIG_DEFAULT();
+    slot_config.gpio_cs = SD_PIN_CS;
+    slot_config.host_id = SD_SPI_HOST;
+    *slot = slot_config;
+    
+    sdmmc_host_t host_config = SDSPI_HOST_DEFAULT();
+    host_config.slot = SD_SPI_HOST;
+    *host = host_config;
+}
+
+static esp_err_t mount_card(void)
+{
+    esp_vfs_fat_sdmmc_mount_config_t mount_config = {
+        .format_if_mount_failed = false,
+        .max_files = 8,                       // Log files stay open
+        .allocation_unit_size = SD_IO_CHUNK_SIZE
+    };
+    
+    sdmmc_host_t host;
+    sdspi_device_config_t slot_config;
+    card_config(&host, &slot_config);
+    return esp_vfs_fat_sdspi_mount(MOUNT_POINT, &host, &slot_config, &mount_config, &card);
 }
 
 esp_err_t screenshot_init(void)
@@ -102,7 +250,7 @@ esp_err_t screenshot_init(void)
         .sclk_io_num = SD_PIN_CLK,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
-        .max_transfer_sz = 4000,
+        .max_transfer_sz = SD_IO_CHUNK_SIZE,  // Chunk writes go out in one DMA setup
     };
     
     esp_err_t ret = spi_bus_initialize(SD_SPI_HOST, &bus_cfg, SPI_DMA_CH_AUTO);
@@ -111,21 +259,7 @@ esp_err_t screenshot_init(void)
         return ret;
     }
     
-    // Mount SD card
-    esp_vfs_fat_sdmmc_mount_config_t mount_config = {
-        .format_if_mount_failed = false,
-        .max_files = 5,
-        .allocation_unit_size = 16 * 1024
-    };
-    
-    sdspi_device_config_t slot_config = SDSPI_DEVICE_CONFIG_DEFAULT();
-    slot_config.gpio_cs = SD_PIN_CS;
-    slot_config.host_id = SD_SPI_HOST;
-    
-    sdmmc_host_t host = SDSPI_HOST_DEFAULT();
-    host.slot = SD_SPI_HOST;
-    
-    ret = esp_vfs_fat_sdspi_mount(MOUNT_POINT, &host, &slot_config, &mount_config, &card);
+    ret = mount_card();
     if (ret != ESP_OK) {
         if (ret == ESP_FAIL) {
             ESP_LOGW(TAG, "Failed to mount SD card filesystem");
@@ -138,6 +272,9 @@ esp_err_t screenshot_init(void)
     
     sd_mounted = true;
     ESP_LOGI(TAG, "SD card mounted successfully");
+    if (sd_io_init() != ESP_OK) {
+        ESP_LOGW(TAG, "SD writes will not wait for idle frames");
+    }
     
     // Print card info
     sdmmc_card_print_info(stdout, card);
@@ -151,8 +288,17 @@ esp_err_t screenshot_init(void)
         }
     }
     
-    // Find next available screenshot number
-    find_next_screenshot_number();
+    // Next number from the index; the directory walk runs on the task
+    int next = read_counter_index();
+    screenshot_counter = next > 0 ? next : 1;
+    ESP_LOGI(TAG, "Next screenshot number: %d", screenshot_counter);
+    
+    if (xTaskCreatePinnedToCore(screenshot_task, "screenshot", TASK_SCREENSHOT_STACK, NULL,
+                                TASK_CAPTURE_PRIO, &shot_task, TASK_CAPTURE_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create screenshot task");
+        shot_task = NULL;
+    }
+    task_plan_track(TASK_ID_SCREENSHOT, shot_task);
     
     ESP_LOGI(TAG, "Screenshot module initialized");
     return ESP_OK;
@@ -163,6 +309,71 @@ bool screenshot_is_available(void)
     return sd_mounted;
 }
 
+esp_err_t screenshot_export_begin(sdmmc_card_t **out)
+{
+    if (!out) return ESP_ERR_INVALID_ARG;
+    if (!sd_mounted || shot_busy) return ESP_ERR_INVALID_STATE;
+    if (sd_io_open_count() > 0) {
+        ESP_LOGW(TAG, "%d log files still open, not unmounting", sd_io_open_count());
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // From here on, writers see no card
+    sd_mounted = false;
+    esp_err_t ret = esp_vfs_fat_sdcard_unmount(MOUNT_POINT, card);
+    card = NULL;
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Unmount failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    // Re-probe the card without a filesystem on this side
+    sdmmc_host_t host;
+    sdspi_device_config_t slot_config;
+    card_config(&host, &slot_config);
+    sdspi_dev_handle_t handle;
+    ret = sdspi_host_init_device(&slot_config, &handle);
+    if (ret == ESP_OK) {
+        host.slot = handle;
+        export_card = calloc(1, sizeof(sdmmc_card_t));
+        ret = export_card ? sdmmc_card_init(&host, export_card) : ESP_ERR_NO_MEM;
+        if (ret != ESP_OK) {
+            free(export_card);
+            export_card = NULL;
+            sdspi_host_remove_device(handle);
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Card init for export failed: %s", esp_err_to_name(ret));
+        if (mount_card() == ESP_OK) sd_mounted = true;
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "SD card unmounted for export");
+    *out = export_card;
+    return ESP_OK;
+}
+
+esp_err_t screenshot_export_end(void)
+{
+    if (!export_card) return ESP_ERR_INVALID_STATE;
+    
+    sdspi_host_remove_device(export_card->host.slot);
+    free(export_card);
+    export_card = NULL;
+    
+    esp_err_t ret = mount_card();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Remount after export failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    sd_mounted = true;
+    // Files the host added are caught by the collision check when saving
+    raise_counter(read_counter_index());
+    ESP_LOGI(TAG, "SD card mounted again");
+    return ESP_OK;
+}
+
 /**
  * @brief Convert RGB565 to RGB888
  */
@@ -174,102 +385,281 @@ static inline void rgb565_to_rgb888(uint16_t color, uint8_t *r, uint8_t *g, uint
     *b = (color & 0x1F) << 3;          // 5 bits -> 8 bits
 }
 
-esp_err_t screenshot_take(void)
+// Buffered output so the SD card sees a few large writes instead of one per row
+typedef struct {
+    FILE *f;
+    uint8_t *buf;
+    size_t used;
+    size_t total;
+    bool failed;
+} out_stream_t;
+
+static void out_flush(out_stream_t *out)
 {
-    if (!sd_mounted) {
-        ESP_LOGW(TAG, "SD card not mounted, cannot take screenshot");
-        return ESP_ERR_INVALID_STATE;
+    if (out->used > 0 && fwrite(out->buf, 1, out->used, out->f) != out->used) {
+        out->failed = true;
     }
-    
-    ESP_LOGI(TAG, "Taking screenshot #%d...", screenshot_counter);
-    
-    // Generate filename
-    char filename[64];
-    snprintf(filename, sizeof(filename), "%s/scr_%d.bmp", SCREENS_DIR, screenshot_counter);
-    
-    // Open file for writing
-    FILE *f = fopen(filename, "wb");
-    if (f == NULL) {
-        ESP_LOGE(TAG, "Failed to open file for writing: %s", filename);
-        return ESP_FAIL;
+    out->used = 0;
+}
+
+static void out_write(out_stream_t *out, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    out->total += len;
+    while (len > 0) {
+        size_t n = SHOT_WRITE_BUF_SIZE - out->used;
+        if (n > len) n = len;
+        memcpy(out->buf + out->used, p, n);
+        out->used += n;
+        p += n;
+        len -= n;
+        if (out->used == SHOT_WRITE_BUF_SIZE) {
+            out_flush(out);
+        }
     }
-    
-    // Get framebuffer
-    const uint16_t *fb = display_get_framebuffer();
-    
-    // Calculate sizes
-    int width = DISPLAY_WIDTH;
-    int height = DISPLAY_HEIGHT;
-    int row_size = ((width * 3 + 3) / 4) * 4;  // Row size padded to 4 bytes
-    int image_size = row_size * height;
-    int file_size = 54 + image_size;  // Headers (14+40) + image data
-    
-    // Prepare BMP file header
+}
+
+static inline void out_byte(out_stream_t *out, uint8_t b)
+{
+    out_write(out, &b, 1);
+}
+
+// Palette lookup: open-addressed color -> index table
+#define PALETTE_HASH_SIZE   512
+
+typedef struct {
+    uint16_t colors[256];           // RGB565, CPU order
+    int count;
+    uint16_t slot_color[PALETTE_HASH_SIZE];
+    int16_t slot_index[PALETTE_HASH_SIZE];  // -1 = empty
+} palette_t;
+
+static int palette_index(palette_t *pal, uint16_t color, bool add)
+{
+    uint32_t h = ((uint32_t)color * 40503u) & (PALETTE_HASH_SIZE - 1);
+    while (pal->slot_index[h] >= 0) {
+        if (pal->slot_color[h] == color) return pal->slot_index[h];
+        h = (h + 1) & (PALETTE_HASH_SIZE - 1);
+    }
+    if (!add || pal->count >= 256) return -1;
+    pal->slot_color[h] = color;
+    pal->slot_index[h] = (int16_t)pal->count;
+    pal->colors[pal->count] = color;
+    return pal->count++;
+}
+
+static inline uint16_t pixel_at(const uint16_t *fb, int x, int y)
+{
+    // Snapshot holds panel (byte-swapped) order
+    uint16_t pixel = fb[y * DISPLAY_WIDTH + x];
+    return (uint16_t)((pixel >> 8) | (pixel << 8));
+}
+
+static bool build_palette(const uint16_t *fb, palette_t *pal)
+{
+    memset(pal->slot_index, 0xFF, sizeof(pal->slot_index));
+    pal->count = 0;
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            if (palette_index(pal, pixel_at(fb, x, y), true) < 0) return false;
+        }
+    }
+    return true;
+}
+
+static void write_headers(out_stream_t *out, uint32_t file_size, uint32_t offset,
+                          const bmp_info_header_t *info)
+{
     bmp_file_header_t file_header = {
         .type = 0x4D42,         // "BM"
         .size = file_size,
         .reserved1 = 0,
         .reserved2 = 0,
-        .offset = 54            // 14 + 40
+        .offset = offset
     };
+    out_write(out, &file_header, sizeof(file_header));
+    out_write(out, info, sizeof(*info));
+}
+
+/**
+ * @brief 8-bit RLE BMP: UI frames rarely use more than a handful of colors
+ *
+ * RLE bitmaps must be bottom-up. Headers are rewritten once the size is known.
+ */
+static void encode_rle8(out_stream_t *out, const uint16_t *fb, palette_t *pal)
+{
+    uint32_t offset = 54 + pal->count * 4;
+    bmp_info_header_t info = {
+        .size = 40,
+        .width = DISPLAY_WIDTH,
+        .height = DISPLAY_HEIGHT,
+        .planes = 1,
+        .bits = 8,
+        .compression = 1,       // BI_RLE8
+        .xresolution = 2835,    // 72 DPI
+        .yresolution = 2835,
+        .ncolours = pal->count,
+    };
+    write_headers(out, 0, offset, &info);
+    for (int i = 0; i < pal->count; i++) {
+        uint8_t r, g, b;
+        rgb565_to_rgb888(pal->colors[i], &r, &g, &b);
+        uint8_t entry[4] = { b, g, r, 0 };
+        out_write(out, entry, sizeof(entry));
+    }
     
-    // Prepare BMP info header
-    bmp_info_header_t info_header = {
+    for (int y = DISPLAY_HEIGHT - 1; y >= 0; y--) {
+        int x = 0;
+        while (x < DISPLAY_WIDTH) {
+            uint16_t color = pixel_at(fb, x, y);
+            int run = 1;
+            while (x + run < DISPLAY_WIDTH && run < 255 && pixel_at(fb, x + run, y) == color) {
+                run++;
+            }
+            out_byte(out, (uint8_t)run);
+            out_byte(out, (uint8_t)palette_index(pal, color, false));
+            x += run;
+        }
+        out_byte(out, 0);
+        out_byte(out, y == 0 ? 1 : 0);      // End of line / end of bitmap
+    }
+    out_flush(out);
+    
+    // Patch sizes now that the encoded length is known
+    info.imagesize = out->total - offset;
+    uint32_t file_size = out->total;
+    fseek(out->f, 0, SEEK_SET);
+    write_headers(out, file_size, offset, &info);
+    out_flush(out);
+}
+
+/**
+ * @brief 16-bit RGB565 BMP for frames with more than 256 colors
+ */
+static void encode_rgb565(out_stream_t *out, const uint16_t *fb)
+{
+    uint32_t image_size = DISPLAY_WIDTH * 2 * DISPLAY_HEIGHT;  // 480-byte rows need no padding
+    uint32_t offset = 54 + 12;
+    bmp_info_header_t info = {
         .size = 40,
-        .width = width,
-        .height = -height,      // Negative for top-down (matches our framebuffer layout)
+        .width = DISPLAY_WIDTH,
+        .height = -DISPLAY_HEIGHT,  // Negative for top-down (matches our framebuffer layout)
         .planes = 1,
-        .bits = 24,
-        .compression = 0,
+        .bits = 16,
+        .compression = 3,       // BI_BITFIELDS
         .imagesize = image_size,
-        .xresolution = 2835,    // 72 DPI
+        .xresolution = 2835,
         .yresolution = 2835,
-        .ncolours = 0,
-        .importantcolours = 0
     };
+    write_headers(out, offset + image_size, offset, &info);
+    static const uint32_t masks[3] = { 0xF800, 0x07E0, 0x001F };
+    out_write(out, masks, sizeof(masks));
     
-    // Write headers
-    fwrite(&file_header, sizeof(file_header), 1, f);
-    fwrite(&info_header, sizeof(info_header), 1, f);
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            uint16_t pixel = pixel_at(fb, x, y);
+            out_write(out, &pixel, 2);
+        }
+    }
+    out_flush(out);
+}
+
+static void save_snapshot(int number)
+{
+    char dir[48];
+    char filename[72];
+    struct stat st;
     
-    // Write pixel data row by row
-    uint8_t *row_buffer = malloc(row_size);
-    if (row_buffer == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate row buffer");
-        fclose(f);
-        return ESP_ERR_NO_MEM;
+    // A stale index (card written elsewhere) must not overwrite a shot
+    while (1) {
+        bucket_dir(dir, sizeof(dir), number);
+        snprintf(filename, sizeof(filename), "%s/scr_%d.bmp", dir, number);
+        if (stat(filename, &st) != 0) break;
+        number = take_number();
     }
     
-    for (int y = 0; y < height; y++) {
-        memset(row_buffer, 0, row_size);  // Clear padding bytes
-        
-        for (int x = 0; x < width; x++) {
-            uint16_t pixel = fb[y * width + x];
-            uint8_t r, g, b;
-            rgb565_to_rgb888(pixel, &r, &g, &b);
-            
-            // BMP stores pixels as BGR
-            row_buffer[x * 3 + 0] = b;
-            row_buffer[x * 3 + 1] = g;
-            row_buffer[x * 3 + 2] = r;
-        }
-        
-        fwrite(row_buffer, row_size, 1, f);
+    FILE *f = fopen(filename, "wb");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Failed to open file for writing: %s", filename);
+        return;
     }
     
-    free(row_buffer);
+    int64_t start_us = esp_timer_get_time();
+    out_stream_t out = { .f = f, .buf = shot_write_buf };
+    palette_t *pal = heap_caps_malloc(sizeof(palette_t), MALLOC_CAP_8BIT);
+    bool rle = pal && build_palette(shot_snapshot, pal);
+    if (rle) {
+        encode_rle8(&out, shot_snapshot, pal);
+    } else {
+        encode_rgb565(&out, shot_snapshot);
+    }
+    free(pal);
     fclose(f);
     
-    ESP_LOGI(TAG, "Screenshot saved: %s", filename);
-    screenshot_counter++;
+    if (out.failed) {
+        ESP_LOGE(TAG, "Write failed: %s", filename);
+        return;
+    }
+    ESP_LOGI(TAG, "Screenshot saved: %s (%s, %u bytes, %lld ms)", filename,
+             rle ? "RLE8" : "RGB565", (unsigned)out.total,
+             (long long)((esp_timer_get_time() - start_us) / 1000));
     
-    return ESP_OK;
+    raise_counter(number + 1);
+    portENTER_CRITICAL(&counter_lock);
+    int next = screenshot_counter;
+    portEXIT_CRITICAL(&counter_lock);
+    write_counter_index(next);
 }
 
+static void screenshot_task(void *arg)
+{
+    (void)arg;
+    
+    // Off the boot path: the only full directory walk
+    check_counter_index();
+    
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        save_snapshot(shot_number);
+        
+        // Buffers are only needed while a shot is in flight
+        free(shot_snapshot);
+        shot_snapshot = NULL;
+        shot_write_buf = NULL;
+        shot_busy = false;
+    }
+}
 
-
-
-
-
-
-
+esp_err_t screenshot_take(void)
+{
+    if (!sd_mounted || !shot_task) {
+        ESP_LOGW(TAG, "SD card not mounted, cannot take screenshot");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (shot_busy) {
+        ESP_LOGW(TAG, "Previous screenshot still being written");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // Snapshot and write buffer in one block, PSRAM first
+    size_t fb_bytes = DISPLAY_WIDTH * DISPLAY_HEIGHT * sizeof(uint16_t);
+    uint8_t *block = heap_caps_malloc(fb_bytes + SHOT_WRITE_BUF_SIZE, SHOT_BUF_CAPS);
+    if (!block) {
+        block = heap_caps_malloc(fb_bytes + SHOT_WRITE_BUF_SIZE, MALLOC_CAP_8BIT);
+    }
+    if (!block) {
+        ESP_LOGE(TAG, "No memory for screenshot snapshot");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // Caller holds the UI lock, so the framebuffer is a complete frame
+    shot_snapshot = (uint16_t *)block;
+    display_read_pixels(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, shot_snapshot);
+    shot_write_buf = block + fb_bytes;
+    shot_number = take_number();
+    shot_busy = true;
+    xTaskNotifyGive(shot_task);
+    
+    ESP_LOGI(TAG, "Screenshot #%d queued", shot_number);
+    return ESP_OK;
+}
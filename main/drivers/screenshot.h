@@ -9,6 +9,7 @@
 #include <stdbool.h>
 
 #include "esp_err.h"
+#include "sdmmc_cmd.h"
 
 /**
  * @brief Initialize screenshot module (mounts SD card)
@@ -17,8 +18,12 @@
 esp_err_t screenshot_init(void);
 
 /**
- * @brief Take a screenshot and save to SD card
- * @return ESP_OK on success, error code otherwise
+ * @brief Snapshot the framebuffer and queue it to be saved to SD card
+ *
+ * Returns after a framebuffer copy; encoding and writing happen on the
+ * screenshot task. Call with the UI lock held.
+ * @return ESP_OK if queued, ESP_ERR_INVALID_STATE without SD card or while
+ *         the previous shot is still being written, ESP_ERR_NO_MEM
  */
 esp_err_t screenshot_take(void);
 
@@ -28,6 +33,21 @@ esp_err_t screenshot_take(void);
  */
 bool screenshot_is_available(void);
 
+/**
+ * @brief Unmount the FAT volume and hand the raw card out (USB export)
+ *
+ * Refused while a screenshot is being written or any sd_io file is open;
+ * screenshot_is_available() reports false until screenshot_export_end().
+ * @param out Receives the initialized card for sector access
+ * @return ESP_OK, ESP_ERR_INVALID_STATE without card or while in use
+ */
+esp_err_t screenshot_export_begin(sdmmc_card_t **out);
+
+/**
+ * @brief Take the card back and mount the FAT volume again
+ */
+esp_err_t screenshot_export_end(void);
+
 #endif // SCREENSHOT_H
 
 
@@ -0,0 +1,232 @@
+/**
+ * @file sd_io.c
+ * @brief Append-only SD card files written in whole allocation units
+ */
+
+#include "sd_io.h"
+#include "trace.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_vfs_fat.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "SD_IO";
+
+#define SD_MOUNT_POINT      "/sdcard"
+#define RENDER_IDLE_BIT     BIT0
+
+struct sd_file {
+    int fd;
+    uint8_t *buf;           // One chunk, DMA-capable when possible
+    size_t fill;            // Bytes in buf
+    size_t base;            // File offset of buf[0], chunk-aligned
+    size_t prealloc;
+    bool rewound;           // Card may hold bytes past the end
+    bool failed;
+};
+
+static EventGroupHandle_t render_state = NULL;
+static portMUX_TYPE open_lock = portMUX_INITIALIZER_UNLOCKED;
+static int open_files = 0;
+
+esp_err_t sd_io_init(void)
+{
+    if (render_state) return ESP_OK;
+    render_state = xEventGroupCreate();
+    if (!render_state) return ESP_ERR_NO_MEM;
+    xEventGroupSetBits(render_state, RENDER_IDLE_BIT);
+    return ESP_OK;
+}
+
+void sd_io_render_begin(void)
+{
+    if (render_state) xEventGroupClearBits(render_state, RENDER_IDLE_BIT);
+}
+
+void sd_io_render_end(void)
+{
+    if (render_state) xEventGroupSetBits(render_state, RENDER_IDLE_BIT);
+}
+
+/**
+ * @brief Write buf[0..fill) at base, once the render task is between frames
+ */
+static bool write_chunk(sd_file_t *f)
+{
+    if (f->failed) return false;
+    if (render_state) {
+        xEventGroupWaitBits(render_state, RENDER_IDLE_BIT, pdFALSE, pdTRUE,
+                            pdMS_TO_TICKS(SD_IO_IDLE_WAIT_MS));
+    }
+    
+    TRACE_BEGIN(TRACE_EV_SD_WRITE, f->fill);
+    bool ok = lseek(f->fd, f->base, SEEK_SET) == (off_t)f->base &&
+              write(f->fd, f->buf, f->fill) == (ssize_t)f->fill;
+    TRACE_END(TRACE_EV_SD_WRITE, f->fill);
+    if (!ok) {
+        ESP_LOGE(TAG, "Chunk write at %u failed", (unsigned)f->base);
+        f->failed = true;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Allocate a file and its chunk buffer
+ */
+static sd_file_t *alloc_file(void)
+{
+    sd_file_t *f = calloc(1, sizeof(sd_file_t));
+    if (!f) return NULL;
+    
+    f->buf = heap_caps_malloc(SD_IO_CHUNK_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+    if (!f->buf) {
+        // Still aligned writes, the SD driver bounces them through its own buffer
+        f->buf = malloc(SD_IO_CHUNK_SIZE);
+    }
+    if (!f->buf) {
+        free(f);
+        return NULL;
+    }
+    return f;
+}
+
+static void count_open(int delta)
+{
+    portENTER_CRITICAL(&open_lock);
+    open_files += delta;
+    portEXIT_CRITICAL(&open_lock);
+}
+
+sd_file_t *sd_io_open(const char *path, size_t prealloc)
+{
+    sd_file_t *f = alloc_file();
+    if (!f) return NULL;
+    
+    // Whole chunks, so the extent ends on an allocation unit
+    prealloc = (prealloc + SD_IO_CHUNK_SIZE - 1) & ~(size_t)(SD_IO_CHUNK_SIZE - 1);
+    if (prealloc > 0) {
+        unlink(path);
+        esp_err_t ret = esp_vfs_fat_create_contiguous_file(SD_MOUNT_POINT, path, prealloc, true);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "No %uKB extent for %s (%s), growing instead",
+                     (unsigned)(prealloc / 1024), path, esp_err_to_name(ret));
+            prealloc = 0;
+        }
+    }
+    f->prealloc = prealloc;
+    f->fd = open(path, prealloc ? O_RDWR : (O_RDWR | O_CREAT | O_TRUNC), 0644);
+    if (f->fd < 0) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        free(f->buf);
+        free(f);
+        return NULL;
+    }
+    count_open(1);
+    return f;
+}
+
+sd_file_t *sd_io_resume(const char *path, size_t keep)
+{
+    sd_file_t *f = alloc_file();
+    if (!f) return NULL;
+    
+    f->fd = open(path, O_RDWR | O_CREAT, 0644);
+    off_t end = f->fd >= 0 ? lseek(f->fd, 0, SEEK_END) : -1;
+    if (end < 0) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        if (f->fd >= 0) close(f->fd);
+        free(f->buf);
+        free(f);
+        return NULL;
+    }
+    if ((size_t)end < keep) keep = (size_t)end;
+    
+    // The chunk holding the end is buffered again, so writes stay aligned
+    f->base = keep & ~(size_t)(SD_IO_CHUNK_SIZE - 1);
+    f->fill = keep - f->base;
+    f->rewound = (size_t)end > keep;    // Cut back to keep on close
+    if (f->fill > 0 && (lseek(f->fd, f->base, SEEK_SET) != (off_t)f->base ||
+                        read(f->fd, f->buf, f->fill) != (ssize_t)f->fill)) {
+        ESP_LOGE(TAG, "Failed to read the tail of %s", path);
+        f->failed = true;
+    }
+    count_open(1);
+    return f;
+}
+
+esp_err_t sd_io_write(sd_file_t *f, const void *data, size_t len)
+{
+    if (!f) return ESP_ERR_INVALID_ARG;
+    
+    const uint8_t *p = data;
+    while (len > 0 && !f->failed) {
+        size_t n = SD_IO_CHUNK_SIZE - f->fill;
+        if (n > len) n = len;
+        memcpy(f->buf + f->fill, p, n);
+        f->fill += n;
+        p += n;
+        len -= n;
+        
+        if (f->fill == SD_IO_CHUNK_SIZE && write_chunk(f)) {
+            f->base += SD_IO_CHUNK_SIZE;
+            f->fill = 0;
+        }
+    }
+    return f->failed ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t sd_io_rewind(sd_file_t *f, size_t size)
+{
+    if (!f) return ESP_ERR_INVALID_ARG;
+    if (size < f->base || size > f->base + f->fill) return ESP_ERR_INVALID_SIZE;
+    f->fill = size - f->base;
+    f->rewound = true;
+    return ESP_OK;
+}
+
+esp_err_t sd_io_sync(sd_file_t *f)
+{
+    if (!f) return ESP_ERR_INVALID_ARG;
+    
+    // The partial chunk stays buffered and is rewritten whole later
+    if (f->fill > 0) write_chunk(f);
+    if (!f->failed && fsync(f->fd) != 0) {
+        f->failed = true;
+    }
+    return f->failed ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t sd_io_close(sd_file_t *f)
+{
+    if (!f) return ESP_ERR_INVALID_ARG;
+    
+    sd_io_sync(f);
+    if ((f->prealloc > 0 || f->rewound) && !f->failed && ftruncate(f->fd, sd_io_size(f)) != 0) {
+        ESP_LOGW(TAG, "Could not trim preallocated tail");
+    }
+    bool ok = !f->failed;
+    if (close(f->fd) != 0) ok = false;
+    free(f->buf);
+    free(f);
+    count_open(-1);
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+int sd_io_open_count(void)
+{
+    portENTER_CRITICAL(&open_lock);
+    int n = open_files;
+    portEXIT_CRITICAL(&open_lock);
+    return n;
+}
+
+size_t sd_io_size(const sd_file_t *f)
+{
+    return f ? f->base + f->fill : 0;
+}
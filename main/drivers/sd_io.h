@@ -0,0 +1,104 @@
+/**
+ * @file sd_io.h
+ * @brief Append-only SD card files written in whole allocation units
+ *
+ * Log writers hand bytes to an sd_file_t, which collects them in a
+ * DMA-capable buffer of one FAT allocation unit (SD_IO_CHUNK_SIZE) and
+ * writes only whole, unit-aligned chunks, so FatFs passes them to the SD
+ * driver as multi-block transfers straight from the buffer: no sector
+ * cache, no bounce copies. A sync writes the partial chunk in place and
+ * the next write of that chunk overwrites it, keeping every write aligned.
+ *
+ * Files can be preallocated as one contiguous extent and stay open; the
+ * unused tail is trimmed on close. A file left open by a crash keeps its
+ * preallocated length, with unwritten bytes after the last sync.
+ *
+ * The display and the card are on separate SPI hosts, but chunk writes
+ * still compete with frame pushes for the CPU and internal RAM bandwidth:
+ * each chunk waits (up to SD_IO_IDLE_WAIT_MS) until the render task is
+ * between frames. Functions are for the writer task that owns the file.
+ */
+
+#ifndef SD_IO_H
+#define SD_IO_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Matches allocation_unit_size of the mount in screenshot_init()
+#define SD_IO_CHUNK_SIZE        (16 * 1024)
+
+// Longest a chunk write defers to a frame being rendered
+#define SD_IO_IDLE_WAIT_MS      50
+
+typedef struct sd_file sd_file_t;
+
+/**
+ * @brief Create the render-idle gate (called once the card is mounted)
+ */
+esp_err_t sd_io_init(void);
+
+/**
+ * @brief Create (or replace) a file for appending
+ * @param path Full path under the mount point
+ * @param prealloc Bytes to reserve as one contiguous extent (0 = grow as written)
+ * @return File, or NULL when the card is missing or out of memory
+ */
+sd_file_t *sd_io_open(const char *path, size_t prealloc);
+
+/**
+ * @brief Open a file to append after its first keep bytes (created if missing)
+ *
+ * For writes picked up where an earlier run stopped. Anything past keep
+ * is cut off on close.
+ * @param keep Bytes to keep (the whole file if it is shorter)
+ * @return File (sd_io_size() tells how much was kept), or NULL
+ */
+sd_file_t *sd_io_resume(const char *path, size_t keep);
+
+/**
+ * @brief Append bytes; whole chunks are written as they fill
+ * @return ESP_OK, or ESP_FAIL after a write error (the file stays failed)
+ */
+esp_err_t sd_io_write(sd_file_t *f, const void *data, size_t len);
+
+/**
+ * @brief Drop the bytes appended after size, while they are still buffered
+ *
+ * Lets a writer replace the tail it synced last (a growing block) in
+ * place. Bytes already on the card past size are overwritten by the next
+ * chunk write or cut off on close.
+ * @return ESP_OK, ESP_ERR_INVALID_SIZE if size is not in the buffered chunk
+ */
+esp_err_t sd_io_rewind(sd_file_t *f, size_t size);
+
+/**
+ * @brief Write the partial chunk and commit it to the card
+ */
+esp_err_t sd_io_sync(sd_file_t *f);
+
+/**
+ * @brief Sync, trim the preallocated tail and close
+ * @return ESP_OK, or ESP_FAIL if anything was lost
+ */
+esp_err_t sd_io_close(sd_file_t *f);
+
+/**
+ * @brief Bytes appended so far
+ */
+size_t sd_io_size(const sd_file_t *f);
+
+/**
+ * @brief Files currently open (the card cannot be unmounted while any are)
+ */
+int sd_io_open_count(void);
+
+/**
+ * @brief Mark the render task busy / idle (frame draw and flush)
+ */
+void sd_io_render_begin(void);
+void sd_io_render_end(void);
+
+#endif // SD_IO_H
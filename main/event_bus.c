@@ -0,0 +1,212 @@
+/**
+ * @file event_bus.c
+ * @brief Typed events from the parsers to whoever wants them
+ */
+
+#include "event_bus.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "EVENT_BUS";
+
+typedef struct {
+    QueueHandle_t queue;            // Pool indices; NULL = slot unused
+    uint32_t mask;
+    int depth;
+    char name[EVENT_BUS_NAME_LEN];
+    volatile uint32_t delivered;
+    volatile uint32_t dropped;
+} subscriber_t;
+
+static bus_event_t pool[EVENT_BUS_POOL_SIZE];
+static uint8_t refs[EVENT_BUS_POOL_SIZE];       // Queues still holding the event
+static portMUX_TYPE pool_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Publishers hold this while sending so a subscriber cannot vanish mid-send
+static SemaphoreHandle_t subs_mutex = NULL;
+static subscriber_t subs[EVENT_BUS_MAX_SUBSCRIBERS];
+static int reserved = 0;                        // Sum of subscriber depths
+static volatile uint32_t total_dropped = 0;
+
+static int pool_take(int ref_count)
+{
+    int slot = -1;
+    taskENTER_CRITICAL(&pool_lock);
+    for (int i = 0; i < EVENT_BUS_POOL_SIZE; i++) {
+        if (refs[i] == 0) {
+            refs[i] = (uint8_t)ref_count;
+            slot = i;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&pool_lock);
+    return slot;
+}
+
+static void pool_release(int slot)
+{
+    taskENTER_CRITICAL(&pool_lock);
+    if (refs[slot] > 0) refs[slot]--;
+    taskEXIT_CRITICAL(&pool_lock);
+}
+
+esp_err_t event_bus_init(void)
+{
+    if (subs_mutex) return ESP_OK;
+
+    subs_mutex = xSemaphoreCreateMutex();
+    if (!subs_mutex) {
+        ESP_LOGE(TAG, "Failed to create mutex");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+int event_bus_publish(bus_event_t *event)
+{
+    if (!subs_mutex || !event || event->type >= BUS_EVENT_COUNT) return 0;
+
+    uint32_t bit = BUS_EVENT_BIT(event->type);
+    event->time_us = uart_line_time_us();
+
+    xSemaphoreTake(subs_mutex, portMAX_DELAY);
+    int matches = 0;
+    for (int i = 0; i < EVENT_BUS_MAX_SUBSCRIBERS; i++) {
+        if (subs[i].queue && (subs[i].mask & bit)) matches++;
+    }
+    if (matches == 0) {
+        xSemaphoreGive(subs_mutex);
+        return 0;
+    }
+
+    // Depths are reserved out of the pool, so a slot is always free here
+    int slot = pool_take(matches);
+    if (slot < 0) {
+        xSemaphoreGive(subs_mutex);
+        total_dropped += matches;
+        ESP_LOGW(TAG, "Pool exhausted");
+        return 0;
+    }
+    pool[slot] = *event;
+
+    int taken = 0;
+    uint8_t item = (uint8_t)slot;
+    for (int i = 0; i < EVENT_BUS_MAX_SUBSCRIBERS; i++) {
+        subscriber_t *sub = &subs[i];
+        if (!sub->queue || !(sub->mask & bit)) continue;
+        if (xQueueSend(sub->queue, &item, 0) == pdTRUE) {
+            taken++;
+        } else {
+            sub->dropped++;
+            total_dropped++;
+            pool_release(slot);
+        }
+    }
+    xSemaphoreGive(subs_mutex);
+    return taken;
+}
+
+int event_bus_subscribe(uint32_t mask, int depth, const char *name)
+{
+    if (!subs_mutex || depth <= 0) return -1;
+
+    xSemaphoreTake(subs_mutex, portMAX_DELAY);
+    // One slot beyond the reservations is the publisher's while it sends
+    if (reserved + depth > EVENT_BUS_POOL_SIZE - 1) {
+        xSemaphoreGive(subs_mutex);
+        ESP_LOGW(TAG, "No pool space for '%s' (%d of %d reserved)",
+                 name ? name : "?", reserved, EVENT_BUS_POOL_SIZE - 1);
+        return -1;
+    }
+
+    int handle = -1;
+    for (int i = 0; i < EVENT_BUS_MAX_SUBSCRIBERS; i++) {
+        if (!subs[i].queue) {
+            handle = i;
+            break;
+        }
+    }
+    if (handle >= 0) {
+        subscriber_t *sub = &subs[handle];
+        sub->queue = xQueueCreate(depth, sizeof(uint8_t));
+        if (sub->queue) {
+            sub->mask = mask;
+            sub->depth = depth;
+            sub->delivered = 0;
+            sub->dropped = 0;
+            strlcpy(sub->name, name ? name : "", sizeof(sub->name));
+            reserved += depth;
+        } else {
+            handle = -1;
+        }
+    }
+    xSemaphoreGive(subs_mutex);
+
+    if (handle < 0) {
+        ESP_LOGW(TAG, "No subscriber slot for '%s'", name ? name : "?");
+    }
+    return handle;
+}
+
+void event_bus_unsubscribe(int handle)
+{
+    if (!subs_mutex || handle < 0 || handle >= EVENT_BUS_MAX_SUBSCRIBERS) return;
+
+    xSemaphoreTake(subs_mutex, portMAX_DELAY);
+    subscriber_t *sub = &subs[handle];
+    if (sub->queue) {
+        uint8_t item;
+        while (xQueueReceive(sub->queue, &item, 0) == pdTRUE) {
+            pool_release(item);
+        }
+        vQueueDelete(sub->queue);
+        sub->queue = NULL;
+        reserved -= sub->depth;
+    }
+    xSemaphoreGive(subs_mutex);
+}
+
+bool event_bus_receive(int handle, bus_event_t *out, uint32_t wait_ms)
+{
+    if (handle < 0 || handle >= EVENT_BUS_MAX_SUBSCRIBERS || !out) return false;
+
+    // The owner is the only one to unsubscribe, so the queue stays valid here
+    subscriber_t *sub = &subs[handle];
+    if (!sub->queue) return false;
+
+    uint8_t item;
+    if (xQueueReceive(sub->queue, &item, pdMS_TO_TICKS(wait_ms)) != pdTRUE) {
+        return false;
+    }
+    *out = pool[item];
+    pool_release(item);
+    sub->delivered++;
+    return true;
+}
+
+bool event_bus_get_stats(int handle, event_bus_sub_stats_t *out)
+{
+    if (!subs_mutex || handle < 0 || handle >= EVENT_BUS_MAX_SUBSCRIBERS || !out) return false;
+
+    xSemaphoreTake(subs_mutex, portMAX_DELAY);
+    const subscriber_t *sub = &subs[handle];
+    bool used = sub->queue != NULL;
+    if (used) {
+        strlcpy(out->name, sub->name, sizeof(out->name));
+        out->mask = sub->mask;
+        out->depth = sub->depth;
+        out->pending = (int)uxQueueMessagesWaiting(sub->queue);
+        out->delivered = sub->delivered;
+        out->dropped = sub->dropped;
+    }
+    xSemaphoreGive(subs_mutex);
+    return used;
+}
+
+uint32_t event_bus_total_dropped(void)
+{
+    return total_dropped;
+}
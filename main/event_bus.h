@@ -0,0 +1,160 @@
+/**
+ * @file event_bus.h
+ * @brief Typed events from the parsers to whoever wants them
+ *
+ * Parsers (world_model, uart_handler) publish small typed events; each
+ * subscriber has its own bounded queue and takes events on its own task.
+ * Events live in a fixed pool and are shared by reference, so publishing
+ * never allocates and never blocks: a subscriber whose queue is full
+ * loses that event and its drop counter says so. A slow consumer (the SD
+ * session log) therefore cannot hold up a fast one (a view's on_tick).
+ *
+ * Queue depths are reserved out of the pool when subscribing, so the pool
+ * itself never runs dry; drops only ever come from a full queue.
+ */
+
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "uart_handler.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef CONFIG_EVENT_BUS_POOL_SIZE
+#define EVENT_BUS_POOL_SIZE     CONFIG_EVENT_BUS_POOL_SIZE
+#else
+#define EVENT_BUS_POOL_SIZE     64
+#endif
+
+#define EVENT_BUS_MAX_SUBSCRIBERS   6
+#define EVENT_BUS_NAME_LEN          12
+
+typedef enum {
+    BUS_EVENT_NETWORK_SEEN = 0,     // Scan result stored
+    BUS_EVENT_STATION_SEEN,         // Sniffer client row
+    BUS_EVENT_DEAUTH_DETECTED,      // Deauth detector report
+    BUS_EVENT_HANDSHAKE_CAPTURED,   // 4-way handshake saved by JanOS
+    BUS_EVENT_GPS_FIX,              // JanOS GPS fix gained or lost
+    BUS_EVENT_LINK_STATE,           // Board ping result / link settings
+    BUS_EVENT_WATCHLIST_HIT,        // A line named a watchlist entry
+    BUS_EVENT_COUNT
+} bus_event_type_t;
+
+#define BUS_EVENT_BIT(type)     (1u << (type))
+#define BUS_EVENT_ALL           ((1u << BUS_EVENT_COUNT) - 1)
+
+typedef struct {
+    char ssid[MAX_SSID_LEN];
+    char bssid[MAX_BSSID_LEN];
+    char security[MAX_SECURITY_LEN];
+    char band[MAX_BAND_LEN];
+    int8_t rssi;
+    uint8_t channel;
+} bus_network_t;
+
+typedef struct {
+    uint64_t mac;                   // mac_set key
+} bus_station_t;
+
+typedef struct {
+    uint64_t bssid;                 // mac_set key
+    char ap_name[MAX_SSID_LEN];
+    int8_t rssi;
+    uint8_t channel;
+} bus_deauth_t;
+
+typedef struct {
+    char ssid[MAX_SSID_LEN];
+    uint32_t seq;                   // world_model_handshake_get() sequence
+} bus_handshake_t;
+
+typedef struct {
+    bool fix;
+} bus_gps_fix_t;
+
+typedef struct {
+    bool up;                        // Board answered a ping
+    bool binary;                    // Binary framing negotiated
+    uint32_t baud;
+} bus_link_state_t;
+
+typedef struct {
+    uint16_t entry;                 // Watchlist entry index
+    bool is_mac;                    // Matched by the MAC set, else by text
+    char pattern[MAX_SSID_LEN];     // Entry as written in the watchlist
+} bus_watch_hit_t;
+
+typedef struct {
+    bus_event_type_t type;
+    int64_t time_us;                // Arrival of the line it came from (uart_line_time_us)
+    union {
+        bus_network_t network;
+        bus_station_t station;
+        bus_deauth_t deauth;
+        bus_handshake_t handshake;
+        bus_gps_fix_t gps;
+        bus_link_state_t link;
+        bus_watch_hit_t watch;
+    };
+} bus_event_t;
+
+typedef struct {
+    char name[EVENT_BUS_NAME_LEN];
+    uint32_t mask;
+    int depth;
+    int pending;                    // Queued, not yet taken
+    uint32_t delivered;
+    uint32_t dropped;               // Lost to a full queue
+} event_bus_sub_stats_t;
+
+/**
+ * @brief Create the bus (call once before any publisher or subscriber)
+ * @return ESP_OK, ESP_ERR_NO_MEM
+ */
+esp_err_t event_bus_init(void);
+
+/**
+ * @brief Publish an event to every subscriber of its type (any task, never blocks)
+ * @param event Event to copy into the pool; time_us is filled in
+ * @return Subscribers that took it
+ */
+int event_bus_publish(bus_event_t *event);
+
+/**
+ * @brief Start receiving events
+ * @param mask BUS_EVENT_BIT() of the wanted types
+ * @param depth Queue length, reserved out of EVENT_BUS_POOL_SIZE
+ * @param name Shown in the stats
+ * @return Handle, or -1 if no slot or pool space is left
+ */
+int event_bus_subscribe(uint32_t mask, int depth, const char *name);
+
+/**
+ * @brief Stop receiving and release everything still queued
+ * @param handle From event_bus_subscribe (negative is ignored)
+ */
+void event_bus_unsubscribe(int handle);
+
+/**
+ * @brief Take the next event for a subscriber
+ * @param handle From event_bus_subscribe
+ * @param out Receives the event
+ * @param wait_ms Longest time to wait, 0 to poll
+ * @return false if nothing arrived in time
+ */
+bool event_bus_receive(int handle, bus_event_t *out, uint32_t wait_ms);
+
+/**
+ * @brief Counters of one subscriber slot
+ * @return false if the slot is unused
+ */
+bool event_bus_get_stats(int handle, event_bus_sub_stats_t *out);
+
+/**
+ * @brief Events dropped by all subscribers since boot
+ */
+uint32_t event_bus_total_dropped(void);
+
+#endif // EVENT_BUS_H
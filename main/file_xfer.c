@@ -0,0 +1,632 @@
+/**
+ * @file file_xfer.c
+ * @brief File transfer between the JanOS SD card, the Cardputer SD card and USB
+ */
+
+#include "file_xfer.h"
+#include "uart_handler.h"
+#include "uart_frame.h"
+#include "sd_io.h"
+#include "usb_bridge.h"
+#include "usb_msc.h"
+#include "screen_mirror.h"
+#include "task_plan.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "driver/usb_serial_jtag.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char *TAG = "FILE_XFER";
+
+#define USB_RING_SIZE       4096
+#define USB_TIMEOUT_MS      2000                // Host not reading: give up
+#define PART_EXT            ".part"
+#define QUEUE_DEPTH         (FILE_XFER_WINDOW + 4)  // Window plus wake-ups
+// Acknowledge every quarter window, so the sender never waits on a full one
+#define ACK_EVERY           (FILE_XFER_WINDOW / 4 > 0 ? FILE_XFER_WINDOW / 4 : 1)
+#define WINDOW_BYTES        ((uint32_t)FILE_XFER_WINDOW * UART_FILE_CHUNK)
+#define NO_GAP              UINT32_MAX
+
+// One in-order chunk for the transfer task; len 0 only wakes it
+typedef struct {
+    uint32_t offset;
+    uint16_t len;
+    uint8_t data[UART_FILE_CHUNK];
+} chunk_t;
+
+typedef struct {
+    file_xfer_dir_t dir;
+    uint8_t id;
+    char remote[FILE_XFER_PATH_LEN];
+    char local[FILE_XFER_PATH_LEN];             // Pull destination or push source
+    char part[FILE_XFER_PATH_LEN + sizeof(PART_EXT)];
+    sd_file_t *sink;                            // Pull to SD
+    FILE *source;                               // Push
+    uint32_t crc;                               // CRC-32 of the bytes stored (pull) or the file (push)
+    bool discard;                               // Pull: the .part cannot be resumed
+    int64_t start_us;
+    chunk_t chunk;                              // Task's receive / send buffer
+} xfer_job_t;
+
+static file_xfer_progress_t progress;
+static volatile bool cancel_requested = false;
+static xfer_job_t *job = NULL;
+static uint8_t next_id = 0;
+
+// Created once and kept: the RX task may still be posting when a job ends
+static QueueHandle_t chunk_queue = NULL;
+static SemaphoreHandle_t reply_sem = NULL;
+
+// Shared with the UART RX task, for the transfer whose id is active_id
+static volatile int active_id = -1;             // -1: every file frame is dropped
+static volatile bool receiving = false;         // Pull: JanOS said ok, data frames expected
+static volatile uint32_t rx_expected;           // Pull: offset of the next chunk to queue
+static volatile uint32_t gap_at = NO_GAP;       // Pull: position a resend was asked for
+static volatile bool gap_pending = false;
+static volatile bool end_seen = false;
+static volatile uint32_t end_size, end_crc;
+static volatile uint32_t peer_next;             // Push: receiver's position
+static volatile uint8_t peer_status;            // Push: uart_file_ack_t of its last ack
+static volatile bool peer_acked = false;
+static portMUX_TYPE peer_lock = portMUX_INITIALIZER_UNLOCKED;
+static chunk_t rx_chunk;                        // RX task only
+
+// Reply to file_get / file_put (RX task, then the transfer task)
+static volatile bool reply_ok;
+static volatile uint32_t reply_value;
+static char reply_error[sizeof(progress.error)];
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void set_error(const char *error)
+{
+    if (!progress.error[0]) strlcpy(progress.error, error, sizeof(progress.error));
+}
+
+/* --------------------------------------------------------------- RX task */
+
+static void wake_task(void)
+{
+    static const chunk_t wake = { 0 };
+    xQueueSend(chunk_queue, &wake, 0);          // Full: the task is busy anyway
+}
+
+static void on_data(const uint8_t *p, uint16_t len)
+{
+    if (!receiving || len <= UART_FILE_DATA_HEADER || len > UART_FILE_DATA_HEADER + UART_FILE_CHUNK) {
+        return;
+    }
+    uint32_t offset = get_u32(p + 1);
+    if (offset < rx_expected) return;           // Sent again after a gap, already queued
+    if (offset > rx_expected) {
+        // One before it was lost; ask once per position, the sender goes back
+        if (gap_at != rx_expected) {
+            gap_at = rx_expected;
+            gap_pending = true;
+            wake_task();
+        }
+        return;
+    }
+    rx_chunk.offset = offset;
+    rx_chunk.len = len - UART_FILE_DATA_HEADER;
+    memcpy(rx_chunk.data, p + UART_FILE_DATA_HEADER, rx_chunk.len);
+    // A full queue drops it like a damaged chunk; the next one reports the gap
+    if (xQueueSend(chunk_queue, &rx_chunk, 0) == pdTRUE) rx_expected = offset + rx_chunk.len;
+}
+
+void file_xfer_on_frame(const struct uart_frame *frame)
+{
+    const uint8_t *p = frame->payload;
+    if (active_id < 0 || frame->len < 1 || p[0] != (uint8_t)active_id) return;
+
+    switch (frame->type) {
+        case UART_FRAME_FILE_DATA:
+            on_data(p, frame->len);
+            break;
+        case UART_FRAME_FILE_ACK:
+            if (frame->len < UART_FILE_ACK_SIZE) return;
+            taskENTER_CRITICAL(&peer_lock);
+            peer_next = get_u32(p + 1);
+            peer_status = p[5];
+            peer_acked = true;
+            taskEXIT_CRITICAL(&peer_lock);
+            wake_task();
+            break;
+        case UART_FRAME_FILE_END:
+            if (frame->len < UART_FILE_END_SIZE) return;
+            end_size = get_u32(p + 1);
+            end_crc = get_u32(p + 5);
+            end_seen = true;
+            wake_task();
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Reply line to file_get / file_put: "<cmd> ok <n>" or "<cmd> error <reason>"
+ */
+static bool on_reply_line(const char *line, void *user_data)
+{
+    const char *cmd = user_data;
+    size_t cmd_len = strlen(cmd);
+
+    if (strncmp(line, cmd, cmd_len) != 0 || line[cmd_len] != ' ') return false;
+    line += cmd_len + 1;
+
+    unsigned long value;
+    if (sscanf(line, "ok %lu", &value) == 1) {
+        reply_value = (uint32_t)value;
+        reply_ok = true;
+        // Data may follow at once; the reply is handled first on this task
+        if (strcmp(cmd, FILE_XFER_GET_CMD) == 0) receiving = true;
+        return true;
+    }
+    if (strncmp(line, "error", 5) == 0) {
+        line += 5;
+        while (*line == ' ') line++;
+        strlcpy(reply_error, *line ? line : "JanOS refused", sizeof(reply_error));
+        return true;
+    }
+    return false;
+}
+
+static void on_reply_done(uart_request_status_t status, void *user_data)
+{
+    (void)user_data;
+    if (status == UART_REQUEST_TIMEOUT) strlcpy(reply_error, "No reply from JanOS", sizeof(reply_error));
+    xSemaphoreGive(reply_sem);
+}
+
+/* ------------------------------------------------------------ Transfer task */
+
+/**
+ * @brief Send file_get / file_put and wait for the answer
+ * @return true on "ok", with reply_value set
+ */
+static bool ask(const char *cmd_word, const char *cmd)
+{
+    reply_ok = false;
+    reply_error[0] = '\0';
+    xSemaphoreTake(reply_sem, 0);
+
+    uart_request_t req = {
+        .cmd = cmd,
+        .on_line = on_reply_line,
+        .on_done = on_reply_done,
+        .user_data = (void *)cmd_word,
+        .timeout_ms = FILE_XFER_REPLY_MS,
+    };
+    if (uart_request(&req) != ESP_OK) {
+        set_error("UART busy");
+        return false;
+    }
+    xSemaphoreTake(reply_sem, portMAX_DELAY);
+    if (!reply_ok) set_error(reply_error[0] ? reply_error : "JanOS refused");
+    return reply_ok;
+}
+
+static void send_ack(uint8_t id, uint32_t next, uart_file_ack_t status)
+{
+    uint8_t payload[UART_FILE_ACK_SIZE];
+    payload[0] = id;
+    put_u32(payload + 1, next);
+    payload[5] = (uint8_t)status;
+    uart_send_frame(UART_FRAME_FILE_ACK, payload, sizeof(payload));
+}
+
+static bool store(xfer_job_t *j, const uint8_t *data, size_t len)
+{
+    j->crc = esp_rom_crc32_le(j->crc, data, len);
+    if (j->dir == FILE_XFER_PULL_TO_USB) {
+        return usb_serial_jtag_write_bytes(data, len, pdMS_TO_TICKS(USB_TIMEOUT_MS)) == (int)len;
+    }
+    return sd_io_write(j->sink, data, len) == ESP_OK;
+}
+
+/**
+ * @brief Receive from JanOS until the file is stored and checked
+ */
+static bool pull_run(xfer_job_t *j)
+{
+    uint32_t stored = progress.resumed_from;
+    char cmd[FILE_XFER_PATH_LEN + 48];
+    snprintf(cmd, sizeof(cmd), "%s %u %lu %d %s", FILE_XFER_GET_CMD, j->id,
+             (unsigned long)stored, FILE_XFER_WINDOW, j->remote);
+    rx_expected = stored;
+    if (!ask(FILE_XFER_GET_CMD, cmd)) return false;
+    if (reply_value < stored) {
+        // Shorter than the .part: not the file it came from
+        send_ack(j->id, stored, UART_FILE_ACK_FAILED);
+        set_error("Changed on JanOS, retry");
+        j->discard = true;
+        return false;
+    }
+    progress.size = reply_value;
+    progress.done = stored;
+
+    int timeouts = 0;
+    int unacked = 0;
+    while (true) {
+        if (cancel_requested) {
+            send_ack(j->id, stored, UART_FILE_ACK_FAILED);
+            return false;
+        }
+        if (stored == progress.size && end_seen) {
+            bool ok = end_size == progress.size && end_crc == j->crc;
+            send_ack(j->id, stored, ok ? UART_FILE_ACK_DONE : UART_FILE_ACK_FAILED);
+            if (!ok) {
+                set_error("CRC mismatch");
+                j->discard = true;
+            }
+            return ok;
+        }
+        if (peer_acked && peer_status == UART_FILE_ACK_FAILED) {
+            set_error("JanOS gave up");
+            return false;
+        }
+        if (gap_pending) {
+            gap_pending = false;
+            send_ack(j->id, gap_at, UART_FILE_ACK_RESEND);
+        }
+
+        if (xQueueReceive(chunk_queue, &j->chunk, pdMS_TO_TICKS(FILE_XFER_ACK_TIMEOUT_MS)) != pdTRUE) {
+            // Quiet link: repeat where we are, in case the last ack was lost
+            if (++timeouts > FILE_XFER_MAX_TIMEOUTS) {
+                send_ack(j->id, stored, UART_FILE_ACK_FAILED);
+                set_error("No data from JanOS");
+                return false;
+            }
+            send_ack(j->id, stored, UART_FILE_ACK_MORE);
+            continue;
+        }
+        if (j->chunk.len == 0) continue;
+        timeouts = 0;
+        if (j->chunk.offset != stored || stored + j->chunk.len > progress.size ||
+            !store(j, j->chunk.data, j->chunk.len)) {
+            send_ack(j->id, stored, UART_FILE_ACK_FAILED);
+            set_error(j->chunk.offset != stored || stored + j->chunk.len > progress.size ?
+                      "Bad chunk from JanOS" : "Write failed");
+            return false;
+        }
+        stored += j->chunk.len;
+        progress.done = stored;
+        progress.elapsed_ms = (uint32_t)((esp_timer_get_time() - j->start_us) / 1000);
+        if (++unacked >= ACK_EVERY || stored == progress.size) {
+            unacked = 0;
+            send_ack(j->id, stored, UART_FILE_ACK_MORE);
+        }
+    }
+}
+
+/**
+ * @brief Position the source for the next data frame
+ */
+static bool seek_source(xfer_job_t *j, uint32_t offset)
+{
+    return fseek(j->source, (long)offset, SEEK_SET) == 0;
+}
+
+/**
+ * @brief Send to JanOS, keeping up to a window in flight, until it answers done
+ */
+static bool push_run(xfer_job_t *j)
+{
+    // The end frame carries the whole file's CRC, so it is read once up front
+    size_t n;
+    while ((n = fread(j->chunk.data, 1, sizeof(j->chunk.data), j->source)) > 0) {
+        if (cancel_requested) return false;
+        j->crc = esp_rom_crc32_le(j->crc, j->chunk.data, n);
+        progress.size += n;
+    }
+
+    char cmd[FILE_XFER_PATH_LEN + 48];
+    snprintf(cmd, sizeof(cmd), "%s %u %lu %d %s", FILE_XFER_PUT_CMD, j->id,
+             (unsigned long)progress.size, FILE_XFER_WINDOW, j->remote);
+    if (!ask(FILE_XFER_PUT_CMD, cmd)) return false;
+
+    uint32_t acked = reply_value <= progress.size ? reply_value : 0;
+    uint32_t sent = acked;
+    uint32_t rewound_to = NO_GAP;
+    bool end_sent = false;
+    int timeouts = 0;
+    progress.resumed_from = acked;
+    progress.done = acked;
+    if (!seek_source(j, sent)) {
+        set_error("Read failed");
+        return false;
+    }
+
+    uint8_t frame[UART_FILE_DATA_HEADER + UART_FILE_CHUNK];
+    frame[0] = j->id;
+    while (true) {
+        if (cancel_requested) {
+            send_ack(j->id, acked, UART_FILE_ACK_FAILED);
+            return false;
+        }
+
+        while (sent < progress.size && sent - acked < WINDOW_BYTES) {
+            uint32_t n = progress.size - sent;
+            if (n > UART_FILE_CHUNK) n = UART_FILE_CHUNK;
+            if (fread(frame + UART_FILE_DATA_HEADER, 1, n, j->source) != n) {
+                send_ack(j->id, acked, UART_FILE_ACK_FAILED);
+                set_error("Read failed");
+                return false;
+            }
+            put_u32(frame + 1, sent);
+            if (uart_send_bulk_frame(UART_FRAME_FILE_DATA, frame, (uint16_t)(UART_FILE_DATA_HEADER + n)) != ESP_OK) {
+                set_error("Link left binary mode");
+                return false;
+            }
+            sent += n;
+        }
+        if (sent == progress.size && !end_sent) {
+            uint8_t end[UART_FILE_END_SIZE];
+            end[0] = j->id;
+            put_u32(end + 1, progress.size);
+            put_u32(end + 5, j->crc);
+            uart_send_frame(UART_FRAME_FILE_END, end, sizeof(end));
+            end_sent = true;
+        }
+
+        bool woken = xQueueReceive(chunk_queue, &j->chunk, pdMS_TO_TICKS(FILE_XFER_ACK_TIMEOUT_MS)) == pdTRUE;
+        taskENTER_CRITICAL(&peer_lock);
+        bool acked_now = peer_acked;
+        uint32_t next = peer_next;
+        uint8_t status = peer_status;
+        peer_acked = false;
+        taskEXIT_CRITICAL(&peer_lock);
+
+        if (acked_now) {
+            if (status == UART_FILE_ACK_DONE) {
+                progress.done = progress.size;
+                return true;
+            }
+            if (status == UART_FILE_ACK_FAILED) {
+                set_error("JanOS gave up");
+                return false;
+            }
+            if (next > sent) next = sent;
+            if (next > acked) {
+                acked = next;
+                progress.done = acked;
+                progress.elapsed_ms = (uint32_t)((esp_timer_get_time() - j->start_us) / 1000);
+                timeouts = 0;
+            }
+            // Go back once per gap; later chunks of the same burst repeat the ask
+            if (status == UART_FILE_ACK_RESEND && next != rewound_to && next < sent) {
+                progress.resent += sent - next;
+                rewound_to = next;
+                sent = next;
+                end_sent = false;
+                if (!seek_source(j, sent)) {
+                    set_error("Read failed");
+                    return false;
+                }
+            }
+        } else if (!woken) {
+            // Nothing acknowledged for a while: resend from the last ack
+            if (++timeouts > FILE_XFER_MAX_TIMEOUTS) {
+                send_ack(j->id, acked, UART_FILE_ACK_FAILED);
+                set_error("No answer from JanOS");
+                return false;
+            }
+            progress.resent += sent - acked;
+            rewound_to = acked;
+            sent = acked;
+            end_sent = false;
+            if (!seek_source(j, sent)) {
+                set_error("Read failed");
+                return false;
+            }
+        }
+    }
+}
+
+static void release_job(xfer_job_t *j, bool ok)
+{
+    active_id = -1;
+    receiving = false;
+    if (j->source) fclose(j->source);
+    if (j->sink) {
+        bool closed = sd_io_close(j->sink) == ESP_OK;
+        if (ok && closed) {
+            unlink(j->local);
+            if (rename(j->part, j->local) != 0) {
+                set_error("Rename failed");
+                ok = false;
+            }
+        }
+        // A bad .part would only resume into the same failure
+        if (j->discard) unlink(j->part);
+    }
+    if (j->dir == FILE_XFER_PULL_TO_USB) {
+        usb_serial_jtag_driver_uninstall();
+        esp_log_level_set("*", CONFIG_LOG_DEFAULT_LEVEL);
+    }
+    free(j);
+}
+
+static void xfer_task(void *arg)
+{
+    xfer_job_t *j = arg;
+    bool ok = j->dir == FILE_XFER_PUSH ? push_run(j) : pull_run(j);
+    progress.elapsed_ms = (uint32_t)((esp_timer_get_time() - j->start_us) / 1000);
+    file_xfer_dir_t dir = j->dir;
+    char remote[FILE_XFER_PATH_LEN];
+    strlcpy(remote, j->remote, sizeof(remote));
+
+    release_job(j, ok);
+    ok = ok && !progress.error[0];
+    ESP_LOGI(TAG, "%s %s %s: %lu of %lu bytes in %lu ms, %lu resent%s%s",
+             dir == FILE_XFER_PUSH ? "Push to" : "Pull of", remote,
+             cancel_requested ? "cancelled" : ok ? "done" : "failed",
+             (unsigned long)progress.done, (unsigned long)progress.size,
+             (unsigned long)progress.elapsed_ms, (unsigned long)progress.resent,
+             progress.error[0] ? ", " : "", progress.error);
+    progress.state = cancel_requested ? FILE_XFER_CANCELLED : ok ? FILE_XFER_DONE : FILE_XFER_FAILED;
+    job = NULL;
+    vTaskDelete(NULL);
+}
+
+/* -------------------------------------------------------------------- API */
+
+/**
+ * @brief Checks and state shared by pulls and pushes
+ */
+static xfer_job_t *new_job(file_xfer_dir_t dir, const char *remote_path)
+{
+    if (!chunk_queue) chunk_queue = xQueueCreate(QUEUE_DEPTH, sizeof(chunk_t));
+    if (!reply_sem) reply_sem = xSemaphoreCreateBinary();
+    if (!chunk_queue || !reply_sem) return NULL;
+
+    xfer_job_t *j = calloc(1, sizeof(*j));
+    if (!j) return NULL;
+    j->dir = dir;
+    j->id = next_id++;
+    j->start_us = esp_timer_get_time();
+    strlcpy(j->remote, remote_path, sizeof(j->remote));
+
+    memset(&progress, 0, sizeof(progress));
+    progress.dir = dir;
+    const char *name = strrchr(remote_path, '/');
+    strlcpy(progress.name, name ? name + 1 : remote_path, sizeof(progress.name));
+    cancel_requested = false;
+
+    xQueueReset(chunk_queue);
+    receiving = false;
+    gap_at = NO_GAP;
+    gap_pending = false;
+    end_seen = false;
+    peer_acked = false;
+    return j;
+}
+
+static esp_err_t start_job(xfer_job_t *j)
+{
+    job = j;
+    active_id = j->id;
+    progress.state = FILE_XFER_RUNNING;
+    if (xTaskCreatePinnedToCore(xfer_task, "file_xfer", TASK_FILE_XFER_STACK, j,
+                                TASK_FILE_XFER_PRIO, NULL, TASK_FILE_XFER_CORE) != pdPASS) {
+        job = NULL;
+        release_job(j, false);
+        progress.state = FILE_XFER_FAILED;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Open <dest>.part where the last attempt left it, CRC of its bytes in j->crc
+ */
+static esp_err_t open_part(xfer_job_t *j)
+{
+    struct stat st;
+    if (stat(FILE_XFER_PULL_DIR, &st) != 0) mkdir(FILE_XFER_PULL_DIR, 0755);
+    snprintf(j->local, sizeof(j->local), "%s/%s", FILE_XFER_PULL_DIR, progress.name);
+    snprintf(j->part, sizeof(j->part), "%s%s", j->local, PART_EXT);
+
+    uint32_t kept = 0;
+    FILE *f = fopen(j->part, "rb");
+    if (f) {
+        size_t n;
+        while ((n = fread(j->chunk.data, 1, sizeof(j->chunk.data), f)) > 0) {
+            j->crc = esp_rom_crc32_le(j->crc, j->chunk.data, n);
+            kept += n;
+        }
+        fclose(f);
+    }
+    j->sink = sd_io_resume(j->part, kept);
+    if (!j->sink) return ESP_FAIL;
+    progress.resumed_from = kept;
+    return ESP_OK;
+}
+
+static esp_err_t open_usb(void)
+{
+    if (usb_bridge_is_active() || screen_mirror_is_active()) return ESP_ERR_INVALID_STATE;
+    usb_serial_jtag_driver_config_t config = {
+        .rx_buffer_size = 256,
+        .tx_buffer_size = USB_RING_SIZE,
+    };
+    // Any failure here means the port is taken; NOT_SUPPORTED is for text mode
+    if (usb_serial_jtag_driver_install(&config) != ESP_OK) return ESP_ERR_INVALID_STATE;
+    ESP_LOGI(TAG, "Streaming %s over USB, logging paused", progress.name);
+    // Log lines would corrupt the stream
+    esp_log_level_set("*", ESP_LOG_NONE);
+    return ESP_OK;
+}
+
+esp_err_t file_xfer_pull(const char *remote_path, bool to_usb)
+{
+    if (!remote_path || !remote_path[0]) return ESP_ERR_INVALID_ARG;
+    if (!uart_is_binary_mode()) return ESP_ERR_NOT_SUPPORTED;
+    if (job || (!to_usb && usb_msc_is_active())) return ESP_ERR_INVALID_STATE;
+
+    xfer_job_t *j = new_job(to_usb ? FILE_XFER_PULL_TO_USB : FILE_XFER_PULL_TO_SD, remote_path);
+    if (!j) return ESP_ERR_NO_MEM;
+
+    esp_err_t ret = to_usb ? open_usb() : open_part(j);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot pull %s: %s", remote_path, esp_err_to_name(ret));
+        j->dir = FILE_XFER_PULL_TO_SD;          // Nothing to undo on USB
+        release_job(j, false);
+        progress.state = FILE_XFER_FAILED;
+        return ret;
+    }
+    if (progress.resumed_from) {
+        ESP_LOGI(TAG, "Resuming %s at %lu bytes", remote_path, (unsigned long)progress.resumed_from);
+    }
+    return start_job(j);
+}
+
+esp_err_t file_xfer_push(const char *local_path, const char *remote_path)
+{
+    if (!local_path || !remote_path || !remote_path[0]) return ESP_ERR_INVALID_ARG;
+    if (!uart_is_binary_mode()) return ESP_ERR_NOT_SUPPORTED;
+    if (job || usb_msc_is_active()) return ESP_ERR_INVALID_STATE;
+
+    xfer_job_t *j = new_job(FILE_XFER_PUSH, remote_path);
+    if (!j) return ESP_ERR_NO_MEM;
+    strlcpy(j->local, local_path, sizeof(j->local));
+
+    j->source = fopen(local_path, "rb");
+    if (!j->source) {
+        release_job(j, false);
+        progress.state = FILE_XFER_FAILED;
+        return ESP_ERR_NOT_FOUND;
+    }
+    return start_job(j);
+}
+
+void file_xfer_cancel(void)
+{
+    if (job) cancel_requested = true;
+}
+
+void file_xfer_get_progress(file_xfer_progress_t *out)
+{
+    *out = progress;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file file_xfer.h
+ * @brief File transfer between the JanOS SD card, the Cardputer SD card and USB
+ *
+ * Captures, credential files and portal templates live on the JanOS card.
+ * In binary mode they move over the control link in fixed-size chunks:
+ *
+ *   pull   "file_get <id> <offset> <window> <path>"
+ *          JanOS: "file_get ok <size>" (or "file_get error <reason>"),
+ *          then data frames from offset, then an end frame
+ *   push   "file_put <id> <size> <window> <path>"
+ *          JanOS: "file_put ok <have>", the bytes it kept from an
+ *          interrupted put of that path; data goes from there
+ *
+ * Frames are UART_FRAME_FILE_DATA / _ACK / _END (uart_frame.h). The
+ * sender keeps at most <window> chunks beyond the receiver's last
+ * acknowledged position in flight, so the link stays busy for the whole
+ * round trip instead of idling on every chunk. The receiver takes chunks
+ * only in order: a chunk after a gap (one lost to a CRC error) is dropped
+ * and answered with a resend acknowledgement, and the sender goes back to
+ * the acknowledged position (go-back-N). Acknowledgements carry absolute
+ * offsets, so a lost one is made good by the next; with none for
+ * FILE_XFER_ACK_TIMEOUT_MS the sender resends from the last one. Once
+ * all bytes are stored, the end frame's CRC-32 of the whole file is
+ * checked and the receiver answers done (or failed).
+ *
+ * Pulls to the card go to FILE_XFER_PULL_DIR as <name>.part, renamed
+ * when the CRC matches. A pull of a name whose .part is there resumes at
+ * its end, the same way JanOS resumes a push. Pulls to USB stream the raw
+ * bytes over the USB CDC port (log output is paused meanwhile, as for
+ * obs_export) and always start at 0.
+ *
+ * One transfer runs at a time, on its own I/O task. Chunks reach it from
+ * the UART RX task through a queue a little deeper than the window.
+ */
+
+#ifndef FILE_XFER_H
+#define FILE_XFER_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+struct uart_frame;
+
+#ifdef CONFIG_FILE_XFER_WINDOW
+#define FILE_XFER_WINDOW            CONFIG_FILE_XFER_WINDOW
+#else
+#define FILE_XFER_WINDOW            16
+#endif
+
+#define FILE_XFER_PULL_DIR          "/sdcard/janos"     // Pulled files
+#define FILE_XFER_PUSH_DIR          "/sdcard/htmls"     // Templates offered for pushing
+#define FILE_XFER_JANOS_HTML_DIR    "/sdcard/lab/htmls" // Where list_sd finds them on JanOS
+#define FILE_XFER_PATH_LEN          96
+#define FILE_XFER_REPLY_MS          3000    // file_get / file_put answer
+#define FILE_XFER_ACK_TIMEOUT_MS    500     // No progress: resend from the last ack
+#define FILE_XFER_MAX_TIMEOUTS      8       // ... this many times in a row, then give up
+
+#define FILE_XFER_GET_CMD           "file_get"
+#define FILE_XFER_PUT_CMD           "file_put"
+
+typedef enum {
+    FILE_XFER_PULL_TO_SD = 0,
+    FILE_XFER_PULL_TO_USB,
+    FILE_XFER_PUSH,
+} file_xfer_dir_t;
+
+typedef enum {
+    FILE_XFER_IDLE = 0,
+    FILE_XFER_RUNNING,
+    FILE_XFER_DONE,
+    FILE_XFER_FAILED,
+    FILE_XFER_CANCELLED,
+} file_xfer_state_t;
+
+typedef struct {
+    file_xfer_state_t state;
+    file_xfer_dir_t dir;
+    uint32_t size;                  // File size, 0 until JanOS answered
+    uint32_t done;                  // Bytes stored by the receiver
+    uint32_t resumed_from;          // Bytes kept from an earlier attempt
+    uint32_t resent;                // Bytes sent again after a gap or timeout
+    uint32_t elapsed_ms;
+    char name[48];                  // File name, without directories
+    char error[32];                 // Why it failed
+} file_xfer_progress_t;
+
+/**
+ * @brief Fetch a file from the JanOS card
+ * @param remote_path Path on the JanOS card
+ * @param to_usb Stream it over USB instead of saving it to FILE_XFER_PULL_DIR
+ * @return ESP_OK once running, ESP_ERR_NOT_SUPPORTED in text mode,
+ *         ESP_ERR_INVALID_STATE if a transfer runs or USB is taken,
+ *         ESP_ERR_NO_MEM
+ */
+esp_err_t file_xfer_pull(const char *remote_path, bool to_usb);
+
+/**
+ * @brief Send a file from the Cardputer card to the JanOS card
+ * @param local_path Path on the Cardputer card
+ * @param remote_path Destination on the JanOS card
+ * @return As file_xfer_pull(), plus ESP_ERR_NOT_FOUND
+ */
+esp_err_t file_xfer_push(const char *local_path, const char *remote_path);
+
+/**
+ * @brief Ask the running transfer to stop (a pull's .part is kept for resuming)
+ */
+void file_xfer_cancel(void);
+
+void file_xfer_get_progress(file_xfer_progress_t *out);
+
+/**
+ * @brief Hand over a UART_FRAME_FILE_* frame (UART RX task)
+ */
+void file_xfer_on_frame(const struct uart_frame *frame);
+
+#endif // FILE_XFER_H
@@ -0,0 +1,95 @@
+/**
+ * @file fixed_containers.c
+ * @brief Allocation-free helpers for the store/view patterns used everywhere
+ */
+
+#include "fixed_containers.h"
+#include <string.h>
+
+static void sift_down(uint16_t *order, int root, int end,
+                      fixed_index_cmp_t cmp, void *ctx)
+{
+    while (1) {
+        int child = 2 * root + 1;
+        if (child >= end) return;
+        if (child + 1 < end && cmp(order[child], order[child + 1], ctx) < 0) child++;
+        if (cmp(order[root], order[child], ctx) >= 0) return;
+
+        uint16_t tmp = order[root];
+        order[root] = order[child];
+        order[child] = tmp;
+        root = child;
+    }
+}
+
+void fixed_index_sort(uint16_t *order, int count, fixed_index_cmp_t cmp, void *ctx)
+{
+    if (!order || !cmp || count < 2) return;
+
+    for (int i = count / 2 - 1; i >= 0; i--) {
+        sift_down(order, i, count, cmp, ctx);
+    }
+    for (int end = count - 1; end > 0; end--) {
+        uint16_t tmp = order[0];
+        order[0] = order[end];
+        order[end] = tmp;
+        sift_down(order, 0, end, cmp, ctx);
+    }
+}
+
+int fixed_index_insert_pos(const uint16_t *order, int count, int index,
+                           fixed_index_cmp_t cmp, void *ctx)
+{
+    if (!cmp) return count;
+
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (cmp(order[mid], index, ctx) <= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int fixed_index_insert(uint16_t *order, int *count, int capacity, int index,
+                       fixed_index_cmp_t cmp, void *ctx)
+{
+    if (*count >= capacity) return -1;
+
+    int pos = fixed_index_insert_pos(order, *count, index, cmp, ctx);
+    memmove(&order[pos + 1], &order[pos], (*count - pos) * sizeof(order[0]));
+    order[pos] = (uint16_t)index;
+    (*count)++;
+    return pos;
+}
+
+int fixed_bits_count(const uint32_t *bits, int n)
+{
+    int count = 0;
+    for (int w = 0; w < FIXED_BITS_WORDS(n); w++) {
+        count += __builtin_popcount(bits[w] & fixed_bits_live_mask(w, n));
+    }
+    return count;
+}
+
+int fixed_bits_next(const uint32_t *bits, int from, int n)
+{
+    if (from < 0) from = 0;
+    for (int w = from / 32; w < FIXED_BITS_WORDS(n); w++) {
+        uint32_t word = bits[w] & fixed_bits_live_mask(w, n);
+        if (w == from / 32) word &= ~0u << (from % 32);
+        if (word) return w * 32 + __builtin_ctz(word);
+    }
+    return -1;
+}
+
+int fixed_index_find(const uint16_t *order, int count, int index)
+{
+    for (int i = 0; i < count; i++) {
+        if (order[i] == index) return i;
+    }
+    return -1;
+}
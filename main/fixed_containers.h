@@ -0,0 +1,144 @@
+/**
+ * @file fixed_containers.h
+ * @brief Allocation-free helpers for the store/view patterns used everywhere
+ *
+ * Stores keep records in a fixed array and hand views out as uint16_t
+ * index arrays ("order"); these helpers sort, search and insert into such
+ * views with a context pointer instead of a file-scope sort key. The ring
+ * counts slots of a caller-owned array that keeps the newest entries.
+ * Bitsets hold one flag per store index, 32 to a word, so whole-store
+ * operations (select all, invert, intersect with a filter) are word-wide.
+ *
+ * Related fixed-capacity pieces live with their main users: mac_set (hash
+ * index with LRU eviction), ssid_pool (string interning) and event_bus (shared, reference-counted object pool).
+ */
+
+#ifndef FIXED_CONTAINERS_H
+#define FIXED_CONTAINERS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Order of two store indices for a view
+ * @return <0 if a goes first, >0 if b goes first; break ties on the
+ *         indices so views come out the same every time
+ */
+typedef int (*fixed_index_cmp_t)(int a, int b, void *ctx);
+
+/**
+ * @brief Sort a view in place (heapsort: no allocation, O(n log n))
+ */
+void fixed_index_sort(uint16_t *order, int count, fixed_index_cmp_t cmp, void *ctx);
+
+/**
+ * @brief Position in a sorted view where index belongs (after equal entries)
+ */
+int fixed_index_insert_pos(const uint16_t *order, int count, int index,
+                           fixed_index_cmp_t cmp, void *ctx);
+
+/**
+ * @brief Insert into a sorted view, keeping it sorted
+ * @param cmp NULL appends (arrival order)
+ * @return Position taken, or -1 if the view already holds capacity entries
+ */
+int fixed_index_insert(uint16_t *order, int *count, int capacity, int index,
+                       fixed_index_cmp_t cmp, void *ctx);
+
+/**
+ * @brief Row of a store index in a view
+ * @return Row, or -1 if not shown
+ */
+int fixed_index_find(const uint16_t *order, int count, int index);
+
+/**
+ * @brief Slot counters of a ring that keeps the newest entries
+ *
+ * The caller owns the array; head and tail only grow, so head - tail is
+ * the fill level and a reader can tell how many it missed.
+ */
+typedef struct {
+    uint32_t head;          // Next slot to write
+    uint32_t tail;          // Oldest kept
+    uint32_t capacity;
+} fixed_ring_t;
+
+static inline void fixed_ring_init(fixed_ring_t *ring, uint32_t capacity)
+{
+    ring->head = 0;
+    ring->tail = 0;
+    ring->capacity = capacity;
+}
+
+static inline uint32_t fixed_ring_count(const fixed_ring_t *ring)
+{
+    return ring->head - ring->tail;
+}
+
+/**
+ * @brief Array slot of the i-th oldest entry (i < fixed_ring_count)
+ */
+static inline uint32_t fixed_ring_slot(const fixed_ring_t *ring, uint32_t i)
+{
+    return (ring->tail + i) % ring->capacity;
+}
+
+/**
+ * @brief Claim the slot for a new entry, dropping the oldest when full
+ * @param dropped Set to true if the oldest entry was dropped (may be NULL)
+ * @return Array slot to write
+ */
+static inline uint32_t fixed_ring_push(fixed_ring_t *ring, bool *dropped)
+{
+    bool full = ring->head - ring->tail >= ring->capacity;
+    if (full) ring->tail++;
+    if (dropped) *dropped = full;
+    return ring->head++ % ring->capacity;
+}
+
+/**
+ * @brief Forget the n oldest entries
+ */
+static inline void fixed_ring_drop(fixed_ring_t *ring, uint32_t n)
+{
+    uint32_t count = ring->head - ring->tail;
+    ring->tail += n < count ? n : count;
+}
+
+#define FIXED_BITS_WORDS(n)     (((n) + 31) / 32)
+
+static inline bool fixed_bits_test(const uint32_t *bits, int i)
+{
+    return (bits[i / 32] >> (i % 32)) & 1;
+}
+
+static inline void fixed_bits_put(uint32_t *bits, int i, bool on)
+{
+    if (on) {
+        bits[i / 32] |= 1u << (i % 32);
+    } else {
+        bits[i / 32] &= ~(1u << (i % 32));
+    }
+}
+
+/**
+ * @brief Word w's mask of the indices below n
+ */
+static inline uint32_t fixed_bits_live_mask(int w, int n)
+{
+    int left = n - w * 32;
+    return left >= 32 ? 0xFFFFFFFFu : (left <= 0 ? 0 : (1u << left) - 1);
+}
+
+/**
+ * @brief Set bits among the first n
+ */
+int fixed_bits_count(const uint32_t *bits, int n);
+
+/**
+ * @brief First set bit at or after from, below n
+ * @return Index, or -1 if none
+ */
+int fixed_bits_next(const uint32_t *bits, int from, int n);
+
+#endif // FIXED_CONTAINERS_H
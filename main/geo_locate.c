@@ -0,0 +1,293 @@
+/**
+ * @file geo_locate.c
+ * @brief Walk-test localisation - weighted centroid and integer geo math
+ */
+
+#include "geo_locate.h"
+#include "cap_gps.h"
+#include <stdio.h>
+#include <string.h>
+
+// Local plane: 1e-7 degree of latitude is 0.111319 dm, as Q16
+#define DM_PER_E7_Q16       7295
+
+// Readings closer than this to the previous place are averaged into it
+// (about the scatter of a standing GPS fix)
+#define SPACING_DM          50
+
+// Farther than this from the origin starts a new walk (20 km)
+#define LOCAL_MAX_DM        200000
+
+// Power weights count from this level; -30 dBm and up weigh the same
+#define WEIGHT_FLOOR_DBM    (-100)
+#define WEIGHT_SPAN_DB      70
+
+// Below this the walk has not gone round anything yet
+#define MIN_SAMPLES         3
+#define MIN_SPREAD_M        15
+
+// Positions older or vaguer than this are not recorded
+#define FIX_FRESH_MS        2000
+#define FIX_MAX_HDOP_X100   500
+
+// 10^(k/10) for k = 0..9 dB, Q4: power within one 10 dB decade
+static const uint8_t power_q4[10] = { 16, 20, 25, 32, 40, 51, 64, 80, 101, 127 };
+
+// cos(d) for d = 0..90 degrees, Q15
+static const uint16_t cos_q15_table[91] = {
+    32768, 32763, 32748, 32723, 32688, 32643, 32588, 32524, 32449, 32365,
+    32270, 32166, 32052, 31928, 31795, 31651, 31499, 31336, 31164, 30983,
+    30792, 30592, 30382, 30163, 29935, 29698, 29452, 29197, 28932, 28660,
+    28378, 28088, 27789, 27482, 27166, 26842, 26510, 26170, 25822, 25466,
+    25102, 24730, 24351, 23965, 23571, 23170, 22763, 22348, 21926, 21498,
+    21063, 20622, 20174, 19720, 19261, 18795, 18324, 17847, 17364, 16877,
+    16384, 15886, 15384, 14876, 14365, 13848, 13328, 12803, 12275, 11743,
+    11207, 10668, 10126, 9580, 9032, 8481, 7927, 7371, 6813, 6252,
+    5690, 5126, 4560, 3993, 3425, 2856, 2286, 1715, 1144, 572,
+    0,
+};
+
+// atan(i / 32) for i = 0..32, degrees x 100
+static const uint16_t atan_x100_table[33] = {
+    0, 179, 358, 536, 713, 888, 1062, 1234, 1404, 1571, 1735,
+    1897, 2056, 2211, 2363, 2511, 2657, 2798, 2936, 3070, 3201,
+    3327, 3451, 3571, 3687, 3800, 3909, 4016, 4119, 4218, 4315,
+    4409, 4500,
+};
+
+static uint16_t cos_q15(int32_t lat_e7)
+{
+    int64_t a = lat_e7 < 0 ? -(int64_t)lat_e7 : lat_e7;
+    int deg = (int)(a / 10000000);
+    if (deg >= 90) return 0;
+    int64_t frac = a % 10000000;
+    int32_t lo = cos_q15_table[deg];
+    int32_t hi = cos_q15_table[deg + 1];
+    return (uint16_t)(lo - (lo - hi) * frac / 10000000);
+}
+
+static uint64_t isqrt64(uint64_t v)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ull << 62;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/**
+ * @brief Bearing of an east/north offset, degrees true x 100 (0..35999)
+ */
+static int32_t bearing_x100(int64_t east, int64_t north)
+{
+    int64_t ax = east < 0 ? -east : east;
+    int64_t ay = north < 0 ? -north : north;
+    if (ax == 0 && ay == 0) return 0;
+
+    // Angle off the nearer axis from the table, ratio in Q13 (32 steps of 256)
+    int64_t small = ax < ay ? ax : ay;
+    int64_t large = ax < ay ? ay : ax;
+    int32_t t = (int32_t)((small << 13) / large);
+    int i = t >> 8;
+    int32_t a = atan_x100_table[i];
+    if (i < 32) a += (atan_x100_table[i + 1] - a) * (t & 255) / 256;
+    if (ax > ay) a = 9000 - a;          // a is now off north, in the quadrant
+
+    if (north >= 0) return east >= 0 ? a : (36000 - a) % 36000;
+    return east >= 0 ? 18000 - a : 18000 + a;
+}
+
+/**
+ * @brief Received power above the floor, linear (up to 1.27e9 at the cap)
+ *
+ * Power rather than amplitude: the few loud places near the source then
+ * outweigh the many quiet ones, which otherwise drag the centroid to the
+ * middle of the walk. Scatter of a few dB still averages out.
+ */
+static uint32_t power_weight(int rssi)
+{
+    static const uint32_t decade[8] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+    };
+    int x = rssi - WEIGHT_FLOOR_DBM;
+    if (x < 0) x = 0;
+    if (x > WEIGHT_SPAN_DB) x = WEIGHT_SPAN_DB;
+    return power_q4[x % 10] * decade[x / 10];
+}
+
+static void project(const geo_locate_t *loc, int32_t lat_e7, int32_t lon_e7,
+                    int64_t *east_dm, int64_t *north_dm)
+{
+    *north_dm = ((int64_t)lat_e7 - loc->origin_lat_e7) * DM_PER_E7_Q16 / 65536;
+    *east_dm = ((int64_t)lon_e7 - loc->origin_lon_e7) * DM_PER_E7_Q16 * loc->origin_cos_q15 /
+               ((int64_t)65536 * 32768);
+}
+
+static void sums_add(geo_locate_t *loc, const geo_sample_t *s, int sign)
+{
+    loc->sum_w += sign * (int64_t)s->weight;
+    loc->sum_w_east += sign * (int64_t)s->weight * s->east_dm;
+    loc->sum_w_north += sign * (int64_t)s->weight * s->north_dm;
+}
+
+void geo_locate_reset(geo_locate_t *loc)
+{
+    memset(loc, 0, sizeof(*loc));
+    fixed_ring_init(&loc->ring, GEO_LOCATE_SAMPLES);
+}
+
+void geo_locate_add(geo_locate_t *loc, int32_t lat_e7, int32_t lon_e7, int rssi)
+{
+    uint32_t count = fixed_ring_count(&loc->ring);
+    int64_t east, north;
+
+    if (count > 0) {
+        project(loc, lat_e7, lon_e7, &east, &north);
+        if (east > LOCAL_MAX_DM || east < -LOCAL_MAX_DM ||
+            north > LOCAL_MAX_DM || north < -LOCAL_MAX_DM) {
+            geo_locate_reset(loc);
+            count = 0;
+        }
+    }
+    if (count == 0) {
+        loc->origin_lat_e7 = lat_e7;
+        loc->origin_lon_e7 = lon_e7;
+        loc->origin_cos_q15 = cos_q15(lat_e7);
+        east = 0;
+        north = 0;
+    }
+
+    if (count > 0) {
+        geo_sample_t *last = &loc->samples[fixed_ring_slot(&loc->ring, count - 1)];
+        int64_t de = east - last->east_dm;
+        int64_t dn = north - last->north_dm;
+        if (de * de + dn * dn < (int64_t)SPACING_DM * SPACING_DM) {
+            sums_add(loc, last, -1);
+            last->rssi = (int8_t)((last->rssi + rssi) / 2);
+            last->weight = power_weight(last->rssi);
+            sums_add(loc, last, 1);
+            return;
+        }
+        if (count == loc->ring.capacity) {
+            sums_add(loc, &loc->samples[fixed_ring_slot(&loc->ring, 0)], -1);
+        }
+    }
+
+    geo_sample_t *s = &loc->samples[fixed_ring_push(&loc->ring, NULL)];
+    s->east_dm = (int32_t)east;
+    s->north_dm = (int32_t)north;
+    s->rssi = (int8_t)(rssi < -128 ? -128 : (rssi > 0 ? 0 : rssi));
+    s->weight = power_weight(s->rssi);
+    sums_add(loc, s, 1);
+}
+
+bool geo_locate_estimate(const geo_locate_t *loc, geo_estimate_t *out)
+{
+    uint32_t count = fixed_ring_count(&loc->ring);
+    if (count == 0 || loc->sum_w <= 0) return false;
+
+    int64_t east = loc->sum_w_east / loc->sum_w;
+    int64_t north = loc->sum_w_north / loc->sum_w;
+    out->lat_e7 = (int32_t)(loc->origin_lat_e7 + north * 65536 / DM_PER_E7_Q16);
+    out->lon_e7 = loc->origin_cos_q15 == 0 ? loc->origin_lon_e7 :
+                  (int32_t)(loc->origin_lon_e7 + east * 65536 * 32768 /
+                            ((int64_t)DM_PER_E7_Q16 * loc->origin_cos_q15));
+
+    int32_t min_e = INT32_MAX, max_e = INT32_MIN, min_n = INT32_MAX, max_n = INT32_MIN;
+    int8_t rssi_max = INT8_MIN;
+    for (uint32_t i = 0; i < count; i++) {
+        const geo_sample_t *s = &loc->samples[fixed_ring_slot(&loc->ring, i)];
+        if (s->east_dm < min_e) min_e = s->east_dm;
+        if (s->east_dm > max_e) max_e = s->east_dm;
+        if (s->north_dm < min_n) min_n = s->north_dm;
+        if (s->north_dm > max_n) max_n = s->north_dm;
+        if (s->rssi > rssi_max) rssi_max = s->rssi;
+    }
+    int64_t de = (int64_t)max_e - min_e;
+    int64_t dn = (int64_t)max_n - min_n;
+    out->spread_m = (uint32_t)((isqrt64((uint64_t)(de * de + dn * dn)) + 5) / 10);
+    out->samples = (int)count;
+    out->rssi_max = rssi_max;
+    return true;
+}
+
+uint32_t geo_distance_m(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7, int32_t lon2_e7)
+{
+    uint16_t c = cos_q15((int32_t)(((int64_t)lat1_e7 + lat2_e7) / 2));
+    int64_t north = ((int64_t)lat2_e7 - lat1_e7) * DM_PER_E7_Q16 / 65536;
+    int64_t east = ((int64_t)lon2_e7 - lon1_e7) * DM_PER_E7_Q16 * c / ((int64_t)65536 * 32768);
+    return (uint32_t)((isqrt64((uint64_t)(east * east + north * north)) + 5) / 10);
+}
+
+int geo_bearing_deg(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7, int32_t lon2_e7)
+{
+    uint16_t c = cos_q15((int32_t)(((int64_t)lat1_e7 + lat2_e7) / 2));
+    int64_t north = ((int64_t)lat2_e7 - lat1_e7) * DM_PER_E7_Q16;
+    int64_t east = ((int64_t)lon2_e7 - lon1_e7) * DM_PER_E7_Q16 * c / 32768;
+    return (int)((bearing_x100(east, north) + 50) / 100) % 360;
+}
+
+const char *geo_compass_point(int bearing_deg)
+{
+    static const char *const points[8] = { "N", "NE", "E", "SE", "S", "SW", "W", "NW" };
+    int b = ((bearing_deg % 360) + 360) % 360;
+    return points[((b + 22) / 45) % 8];
+}
+
+/**
+ * @brief Current CAP GPS position, if fresh and tight enough to record
+ */
+static bool position_here(int32_t *lat_e7, int32_t *lon_e7)
+{
+    cap_gps_snapshot_t snap;
+    if (!cap_gps_get_snapshot(&snap) || !snap.fix || snap.fix_age_ms > FIX_FRESH_MS) return false;
+    if (snap.hdop_x100 > FIX_MAX_HDOP_X100) return false;
+    *lat_e7 = snap.lat_e7;
+    *lon_e7 = snap.lon_e7;
+    return true;
+}
+
+bool geo_locate_available(void)
+{
+    cap_gps_snapshot_t snap;
+    return cap_gps_get_snapshot(&snap);
+}
+
+bool geo_locate_add_here(geo_locate_t *loc, int rssi)
+{
+    int32_t lat, lon;
+    if (!position_here(&lat, &lon)) return false;
+    geo_locate_add(loc, lat, lon, rssi);
+    return true;
+}
+
+void geo_locate_describe(const geo_locate_t *loc, char *out, size_t size)
+{
+    int32_t lat, lon;
+    geo_estimate_t est;
+
+    if (!position_here(&lat, &lon)) {
+        snprintf(out, size, "Locate: need GPS fix");
+    } else if (!geo_locate_estimate(loc, &est)) {
+        snprintf(out, size, "Locate: walk around");
+    } else if (est.samples < MIN_SAMPLES || est.spread_m < MIN_SPREAD_M) {
+        snprintf(out, size, "Locate: walk around %um", (unsigned)est.spread_m);
+    } else {
+        uint32_t dist = geo_distance_m(lat, lon, est.lat_e7, est.lon_e7);
+        int bearing = geo_bearing_deg(lat, lon, est.lat_e7, est.lon_e7);
+        if (dist < 3) {
+            snprintf(out, size, "Src here  %dpt", est.samples);
+        } else {
+            snprintf(out, size, "Src %um %-2s %03d  %dpt",
+                     (unsigned)dist, geo_compass_point(bearing), bearing, est.samples);
+        }
+    }
+}
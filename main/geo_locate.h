@@ -0,0 +1,118 @@
+/**
+ * @file geo_locate.h
+ * @brief Walk-test localisation - where a transmitter is from RSSI along a walk
+ *
+ * Screens that follow one AP or BLE device feed (position, RSSI) samples
+ * while the user walks around; the transmitter is estimated as the centroid
+ * of the sample positions weighted by received power, so the spots
+ * where it was loud pull hardest. The weighted sums are kept as the ring
+ * fills and empties, so an estimate costs no more than a division.
+ *
+ * All geo math is integer: positions are degrees x 1e7 as the GPS driver
+ * delivers them, projected onto a local east/north plane in decimetres
+ * around the first sample (equirectangular, good to a few tens of km).
+ * The centroid never leaves the walked area, so the estimate is best when
+ * the walk goes round the source rather than towards it.
+ */
+
+#ifndef GEO_LOCATE_H
+#define GEO_LOCATE_H
+
+#include "fixed_containers.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef CONFIG_GEO_LOCATE_SAMPLES
+#define GEO_LOCATE_SAMPLES  CONFIG_GEO_LOCATE_SAMPLES
+#else
+#define GEO_LOCATE_SAMPLES  128
+#endif
+
+// One place on the walk
+typedef struct {
+    int32_t east_dm;            // From the origin
+    int32_t north_dm;
+    uint32_t weight;            // Linear power of rssi
+    int8_t rssi;
+} geo_sample_t;
+
+typedef struct {
+    geo_sample_t samples[GEO_LOCATE_SAMPLES];
+    fixed_ring_t ring;
+    int32_t origin_lat_e7;      // First sample of the walk
+    int32_t origin_lon_e7;
+    uint16_t origin_cos_q15;    // cos(origin latitude), east scale
+    int64_t sum_w;              // Running sums over the ring
+    int64_t sum_w_east;
+    int64_t sum_w_north;
+} geo_locate_t;
+
+// Result of geo_locate_estimate()
+typedef struct {
+    int32_t lat_e7;             // Estimated transmitter position
+    int32_t lon_e7;
+    int samples;
+    uint32_t spread_m;          // Diagonal of the walked area
+    int8_t rssi_max;            // Loudest place so far
+} geo_estimate_t;
+
+/**
+ * @brief Forget the walk
+ */
+void geo_locate_reset(geo_locate_t *loc);
+
+/**
+ * @brief Record a reading at a position
+ *
+ * A reading within a few metres of the previous place is averaged into it
+ * instead of taking a new slot, so standing still does not flush the walk
+ * out of the ring. A position too far from the origin for the local plane
+ * starts a new walk.
+ */
+void geo_locate_add(geo_locate_t *loc, int32_t lat_e7, int32_t lon_e7, int rssi);
+
+/**
+ * @brief Current estimate of the transmitter position
+ * @return false with no samples
+ */
+bool geo_locate_estimate(const geo_locate_t *loc, geo_estimate_t *out);
+
+/**
+ * @brief Ground distance in metres (equirectangular, integer)
+ */
+uint32_t geo_distance_m(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7, int32_t lon2_e7);
+
+/**
+ * @brief Initial bearing from point 1 to point 2, degrees true 0..359
+ */
+int geo_bearing_deg(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7, int32_t lon2_e7);
+
+/**
+ * @brief Eight-point compass name of a bearing ("N", "NE", ...)
+ */
+const char *geo_compass_point(int bearing_deg);
+
+/**
+ * @brief Whether positions can come at all (the CAP GPS driver runs)
+ *
+ * Screens lay out the locate line only then, so boards without a CAP
+ * keep their full layout.
+ */
+bool geo_locate_available(void);
+
+/**
+ * @brief Record a reading at the current CAP GPS position
+ * @return false (nothing recorded) without a fresh, usable fix
+ */
+bool geo_locate_add_here(geo_locate_t *loc, int rssi);
+
+/**
+ * @brief One status line for a screen: the way to the source from here
+ *
+ * "Src 42m NE 047  17pt" once the walk covers enough ground, otherwise
+ * what is missing (a GPS fix, more walking).
+ */
+void geo_locate_describe(const geo_locate_t *loc, char *out, size_t size);
+
+#endif // GEO_LOCATE_H
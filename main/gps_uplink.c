@@ -0,0 +1,105 @@
+/**
+ * @file gps_uplink.c
+ * @brief Batched CAP GPS track to JanOS over the binary frame protocol
+ */
+
+#include "gps_uplink.h"
+#include "uart_frame.h"
+#include "uart_handler.h"
+#include "fixed_containers.h"
+#include "power_governor.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "GPS_UPLINK";
+
+_Static_assert(GPS_UPLINK_BATCH_POINTS <= UART_GPS_TRACK_MAX_POINTS,
+               "GPS batch does not fit one frame");
+
+static cap_gps_fix_t fixes[GPS_UPLINK_RING];
+static fixed_ring_t ring = { .capacity = GPS_UPLINK_RING };    // Unsent fixes
+static int64_t last_send_us = 0;
+static uint32_t dropped = 0;
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p = put_u16(p, (uint16_t)(v & 0xFFFF));
+    return put_u16(p, (uint16_t)(v >> 16));
+}
+
+/**
+ * @brief Send up to one frame of queued fixes
+ * @return false if the frame could not be sent (fixes stay queued)
+ */
+static bool send_batch(bool has_fix)
+{
+    uint8_t payload[2 + UART_GPS_TRACK_MAX_POINTS * UART_GPS_POINT_SIZE];
+    uint32_t count = fixed_ring_count(&ring);
+    if (count > UART_GPS_TRACK_MAX_POINTS) count = UART_GPS_TRACK_MAX_POINTS;
+    
+    int64_t now = esp_timer_get_time();
+    uint8_t *p = payload;
+    *p++ = has_fix ? UART_GPS_TRACK_FIX : 0;
+    *p++ = (uint8_t)count;
+    for (uint32_t i = 0; i < count; i++) {
+        const cap_gps_fix_t *fix = &fixes[fixed_ring_slot(&ring, i)];
+        int64_t age_ms = (now - fix->time_us) / 1000;
+        int32_t hdop = fix->hdop_x100;
+        p = put_u32(p, fix->utc_time);
+        p = put_u16(p, fix->utc_ms);
+        p = put_u16(p, (uint16_t)(age_ms > 0xFFFF ? 0xFFFF : age_ms));
+        p = put_u32(p, (uint32_t)fix->lat_e7);
+        p = put_u32(p, (uint32_t)fix->lon_e7);
+        p = put_u32(p, (uint32_t)fix->alt_dm);
+        p = put_u16(p, (uint16_t)(hdop < 0 ? 0 : hdop > 0xFFFF ? 0xFFFF : hdop));
+    }
+    
+    if (uart_send_frame(UART_FRAME_GPS_TRACK, payload, (uint16_t)(p - payload)) != ESP_OK) {
+        return false;
+    }
+    fixed_ring_drop(&ring, count);
+    last_send_us = now;
+    return true;
+}
+
+void gps_uplink_reset(void)
+{
+    fixed_ring_init(&ring, GPS_UPLINK_RING);
+    last_send_us = 0;
+    dropped = 0;
+}
+
+void gps_uplink_push(const cap_gps_fix_t *fix)
+{
+    if (!fix->fix) {
+        while (fixed_ring_count(&ring) && send_batch(true)) {
+        }
+        if (!send_batch(false)) {
+            ESP_LOGW(TAG, "Fix-lost report not sent");
+        }
+        return;
+    }
+    
+    bool lost;
+    fixes[fixed_ring_push(&ring, &lost)] = *fix;
+    if (lost) dropped++;
+    
+    int64_t batch_us = (int64_t)power_governor_scale_ms(GPS_UPLINK_BATCH_MS) * 1000;
+    if (fixed_ring_count(&ring) >= GPS_UPLINK_BATCH_POINTS ||
+        fix->time_us - last_send_us >= batch_us) {
+        send_batch(true);
+    }
+}
+
+uint32_t gps_uplink_dropped(void)
+{
+    return dropped;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file gps_uplink.h
+ * @brief Batched CAP GPS track to JanOS over the binary frame protocol
+ *
+ * Fixes are queued in a small ring and sent as UART_FRAME_GPS_TRACK
+ * frames (layout in uart_frame.h), one frame per GPS_UPLINK_BATCH_MS or
+ * per GPS_UPLINK_BATCH_POINTS fixes (the time stretched by a saving power
+ * profile, power_governor.h). JanOS gets every fix at the receiver
+ * rate instead of a decimated text command, and can interpolate a
+ * position for observations made between two fixes.
+ *
+ * Only usable once binary framing is negotiated (uart_is_binary_mode);
+ * callers fall back to set_gps_position_cap otherwise. Not thread safe:
+ * push from the CAP GPS fix callback only, reset before registering it.
+ */
+
+#ifndef GPS_UPLINK_H
+#define GPS_UPLINK_H
+
+#include "cap_gps.h"
+#include <stdint.h>
+
+#define GPS_UPLINK_RING             32      // Fixes kept while the link is busy
+#define GPS_UPLINK_BATCH_POINTS     10
+#define GPS_UPLINK_BATCH_MS         1000
+
+/**
+ * @brief Drop queued fixes
+ */
+void gps_uplink_reset(void);
+
+/**
+ * @brief Queue a fix and send a batch when one is due
+ *
+ * A fix-lost report (fix->fix false) flushes the queue and sends an empty
+ * frame without UART_GPS_TRACK_FIX. If the ring is full the oldest fix is
+ * dropped.
+ */
+void gps_uplink_push(const cap_gps_fix_t *fix);
+
+/**
+ * @brief Fixes dropped from a full ring since the last reset
+ */
+uint32_t gps_uplink_dropped(void);
+
+#endif // GPS_UPLINK_H
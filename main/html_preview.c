@@ -0,0 +1,571 @@
+/**
+ * @file html_preview.c
+ * @brief Paged preview of portal HTML templates on the JanOS card
+ */
+
+#include "html_preview.h"
+#include "data_detail_screen.h"
+#include "screen_manager.h"
+#include "uart_handler.h"
+#include "mac_set.h"
+#include "mem_monitor.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static const char *TAG = "HTML_PREVIEW";
+
+#ifdef CONFIG_SPIRAM
+#define CACHE_CAPS      (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define CACHE_CAPS      (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+#define HEADER_PREFIX   "HTML "
+#define FOOTER_PREFIX   "Sent "
+#define TEXT_INITIAL    1024
+#define CUT_MARK        "\n[...]"
+#define NAME_LEN        8
+
+// One cached chunk of a template
+typedef struct {
+    uint64_t file;              // Name hash, 0 = free slot
+    uint32_t index;             // Chunk number in the file
+    uint32_t used;              // LRU stamp
+    uint16_t len;
+    bool last;                  // Ends the file
+    uint8_t data[HTML_PREVIEW_CHUNK];
+} cached_chunk_t;
+
+MEM_BUDGET(html_preview_cache, HTML_PREVIEW_CACHE_CHUNKS, sizeof(cached_chunk_t), MEM_BUDGET_PSRAM);
+
+typedef enum {
+    STRIP_TEXT = 0,
+    STRIP_TAG,
+    STRIP_COMMENT,
+    STRIP_ENTITY,
+} strip_mode_t;
+
+// HTML to text, one byte at a time so chunks can end anywhere
+typedef struct {
+    strip_mode_t mode;
+    char name[NAME_LEN + 1];    // Tag name, lowercase, cut
+    int name_len;
+    bool name_done;
+    bool closing;               // </tag>
+    char quote;                 // Inside a quoted attribute value
+    int lead;                   // "<!": dashes after it so far, -1 once decided
+    bool comment;               // "<!--", ends at "-->" rather than '>'
+    int dashes;                 // Comment: dashes just seen
+    char skip[NAME_LEN + 1];    // Inside <script> or <style> until its end tag
+    char entity[NAME_LEN + 1];
+    int entity_len;
+    bool space;                 // Whitespace pending before the next character
+} html_strip_t;
+
+// Chunk cache, shared with the RX task
+static cached_chunk_t *cache = NULL;
+static SemaphoreHandle_t cache_mutex = NULL;
+static uint32_t cache_stamp = 0;
+static uint32_t cache_listing_gen = 0;
+
+// The open preview (UI task, except state)
+static volatile html_preview_state_t state = HTML_PREVIEW_CLOSED;
+static sd_file_t file;
+static uint64_t file_key;
+static uint32_t next_chunk;         // First chunk not yet in the text
+static bool file_read;              // The last chunk is in the text
+static bool unsupported;            // JanOS answered html_read with something else
+static char *text = NULL;
+static size_t text_len;
+static size_t text_cap;
+static bool text_full;
+static html_strip_t strip;
+
+// Filled by the RX task while a chunk is asked for
+static uint64_t request_file;
+static uint32_t request_index;
+static uint8_t staging[HTML_PREVIEW_CHUNK];
+static size_t staging_len;
+static uint32_t reply_size;
+static bool got_header;
+
+static esp_err_t cache_init(void)
+{
+    if (cache) return ESP_OK;
+    if (!cache_mutex) {
+        cache_mutex = xSemaphoreCreateMutex();
+        if (!cache_mutex) return ESP_ERR_NO_MEM;
+    }
+    cached_chunk_t *chunks = heap_caps_calloc(HTML_PREVIEW_CACHE_CHUNKS, sizeof(cached_chunk_t), CACHE_CAPS);
+    if (!chunks) chunks = calloc(HTML_PREVIEW_CACHE_CHUNKS, sizeof(cached_chunk_t));
+    if (!chunks) return ESP_ERR_NO_MEM;
+    cache = chunks;
+    cache_listing_gen = sd_listing_generation();
+    return ESP_OK;
+}
+
+/**
+ * @brief Slot holding a chunk (cache_mutex held)
+ * @return Slot, or -1 if not cached
+ */
+static int cache_find(uint64_t key, uint32_t index)
+{
+    // A new SD listing may mean other files under the same names
+    if (cache_listing_gen != sd_listing_generation()) {
+        cache_listing_gen = sd_listing_generation();
+        for (int i = 0; i < HTML_PREVIEW_CACHE_CHUNKS; i++) cache[i].file = 0;
+    }
+    for (int i = 0; i < HTML_PREVIEW_CACHE_CHUNKS; i++) {
+        if (cache[i].file == key && cache[i].index == index) return i;
+    }
+    return -1;
+}
+
+static void cache_put(uint64_t key, uint32_t index, const uint8_t *data, size_t len, bool last)
+{
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    int slot = cache_find(key, index);
+    if (slot < 0) {
+        // Free slot, else the least recently used
+        slot = 0;
+        for (int i = 0; i < HTML_PREVIEW_CACHE_CHUNKS; i++) {
+            if (cache[i].file == 0) {
+                slot = i;
+                break;
+            }
+            if (cache[i].used < cache[slot].used) slot = i;
+        }
+    }
+    cached_chunk_t *chunk = &cache[slot];
+    chunk->file = key;
+    chunk->index = index;
+    chunk->used = ++cache_stamp;
+    chunk->len = (uint16_t)len;
+    chunk->last = last;
+    memcpy(chunk->data, data, len);
+    xSemaphoreGive(cache_mutex);
+}
+
+// ---------------------------------------------------------------------------
+// HTML to text
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief Make room for need more bytes of text
+ * @return false at HTML_PREVIEW_TEXT_MAX or without memory
+ */
+static bool reserve(size_t need)
+{
+    while (text_len + need > text_cap) {
+        if (text_cap >= HTML_PREVIEW_TEXT_MAX) return false;
+        size_t cap = text_cap * 2;
+        if (cap > HTML_PREVIEW_TEXT_MAX) cap = HTML_PREVIEW_TEXT_MAX;
+        char *grown = realloc(text, cap);
+        if (!grown) return false;
+        text = grown;
+        text_cap = cap;
+    }
+    return true;
+}
+
+static void put_raw(char c)
+{
+    if (text_full) return;
+
+    // Room for the cut mark is always kept
+    if (!reserve(2 + sizeof(CUT_MARK))) {
+        memcpy(text + text_len, CUT_MARK, sizeof(CUT_MARK));
+        text_len += sizeof(CUT_MARK) - 1;
+        text_full = true;
+        return;
+    }
+    text[text_len++] = c;
+    text[text_len] = '\0';
+}
+
+static void put_char(char c)
+{
+    if (strip.space && text_len > 0 && text[text_len - 1] != '\n') put_raw(' ');
+    strip.space = false;
+    put_raw(c);
+}
+
+static void put_newline(void)
+{
+    if (text_len > 0 && text[text_len - 1] != '\n') put_raw('\n');
+    strip.space = false;
+}
+
+static bool is_block_tag(const char *name)
+{
+    static const char *const blocks[] = {
+        "br", "p", "div", "h1", "h2", "h3", "h4", "h5", "h6", "li", "tr", "title",
+        "form", "label", "button", "option", "section", "header", "footer", "hr",
+        "table", "ul", "ol", "input", "select", "textarea",
+    };
+    for (size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++) {
+        if (strcmp(name, blocks[i]) == 0) return true;
+    }
+    return false;
+}
+
+static void end_tag(void)
+{
+    strip.mode = STRIP_TEXT;
+    if (strip.skip[0]) {
+        if (strip.closing && strcmp(strip.name, strip.skip) == 0) strip.skip[0] = '\0';
+        return;
+    }
+    if (!strip.closing && (strcmp(strip.name, "script") == 0 || strcmp(strip.name, "style") == 0)) {
+        strcpy(strip.skip, strip.name);
+        return;
+    }
+    if (is_block_tag(strip.name)) put_newline();
+}
+
+static void end_entity(char terminator)
+{
+    static const struct { const char *name; char c; } named[] = {
+        { "amp", '&' }, { "lt", '<' }, { "gt", '>' }, { "quot", '"' },
+        { "apos", '\'' }, { "nbsp", ' ' },
+    };
+    strip.mode = STRIP_TEXT;
+    strip.entity[strip.entity_len] = '\0';
+    if (strip.skip[0]) return;
+
+    if (terminator == ';') {
+        long code = -1;
+        if (strip.entity[0] == '#') {
+            char *end;
+            bool hex = strip.entity[1] == 'x' || strip.entity[1] == 'X';
+            code = strtol(strip.entity + (hex ? 2 : 1), &end, hex ? 16 : 10);
+            if (*end) code = -1;
+            else if (code < 0x20 || code > 0x7E) code = '?';
+        } else {
+            for (size_t i = 0; i < sizeof(named) / sizeof(named[0]); i++) {
+                if (strcmp(strip.entity, named[i].name) == 0) code = named[i].c;
+            }
+        }
+        if (code >= 0) {
+            put_char((char)code);
+            return;
+        }
+    }
+
+    // Not an entity after all: as written
+    put_char('&');
+    for (int i = 0; i < strip.entity_len; i++) put_char(strip.entity[i]);
+    if (terminator == ';') put_char(';');
+}
+
+static void strip_text(uint8_t c)
+{
+    if (c == '<') {
+        strip.mode = STRIP_TAG;
+        strip.name_len = 0;
+        strip.name[0] = '\0';
+        strip.name_done = false;
+        strip.closing = false;
+        strip.quote = 0;
+        return;
+    }
+    if (strip.skip[0]) return;          // Script or style
+    if (c == '&') {
+        strip.mode = STRIP_ENTITY;
+        strip.entity_len = 0;
+        return;
+    }
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+        strip.space = true;
+    } else if (c >= 0xC0) {
+        put_char('?');              // UTF-8 lead byte; the font is ASCII
+    } else if (c >= 0x20 && c < 0x7F) {
+        put_char((char)c);
+    }
+}
+
+static void strip_byte(uint8_t c)
+{
+    switch (strip.mode) {
+        case STRIP_TEXT:
+            strip_text(c);
+            break;
+
+        case STRIP_TAG:
+            if (strip.skip[0] && !strip.closing && c != '/') {
+                strip.mode = STRIP_TEXT;        // Only the end tag counts in a script
+            } else if (strip.quote) {
+                if (c == strip.quote) strip.quote = 0;
+            } else if (c == '>') {
+                end_tag();
+            } else if (!strip.name_done) {
+                if (c == '/' && strip.name_len == 0) {
+                    strip.closing = true;
+                } else if (c == '!' && strip.name_len == 0 && !strip.closing) {
+                    strip.mode = STRIP_COMMENT;
+                    strip.lead = 0;
+                    strip.comment = false;
+                    strip.dashes = 0;
+                } else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+                    if (strip.name_len < NAME_LEN) {
+                        strip.name[strip.name_len++] = (char)(c | 0x20);
+                        strip.name[strip.name_len] = '\0';
+                    }
+                } else {
+                    strip.name_done = true;
+                }
+            } else if ((c == '"' || c == '\'') && !strip.skip[0]) {
+                strip.quote = (char)c;
+            }
+            break;
+
+        case STRIP_COMMENT:
+            // "<!--" runs to "-->", other "<!" (DOCTYPE) to the first '>'
+            if (strip.lead >= 0) {
+                if (c == '-') {
+                    if (++strip.lead == 2) {
+                        strip.comment = true;
+                        strip.lead = -1;
+                    }
+                    break;
+                }
+                strip.lead = -1;
+            }
+            if (!strip.comment) {
+                if (c == '>') strip.mode = STRIP_TEXT;
+            } else if (c == '-') {
+                strip.dashes++;
+            } else {
+                if (c == '>' && strip.dashes >= 2) strip.mode = STRIP_TEXT;
+                strip.dashes = 0;
+            }
+            break;
+
+        case STRIP_ENTITY:
+            if (c == ';' || strip.entity_len == NAME_LEN ||
+                !((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '#')) {
+                end_entity((char)c);
+                if (c != ';') strip_byte(c);
+            } else {
+                strip.entity[strip.entity_len++] = (char)c;
+            }
+            break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// html_read
+// ---------------------------------------------------------------------------
+
+static bool is_log_line(const char *line)
+{
+    return (line[0] == 'I' || line[0] == 'W' || line[0] == 'E' || line[0] == 'D') &&
+           line[1] == ' ' && line[2] == '(';
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/**
+ * @brief Append a hex data line to the staging chunk
+ * @return false if the line is not hex data
+ */
+static bool add_hex_line(const char *line)
+{
+    size_t len = strcspn(line, "\r\n");
+    if (len == 0 || len % 2) return false;
+    for (size_t i = 0; i < len; i += 2) {
+        int hi = hex_value(line[i]);
+        int lo = hex_value(line[i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        if (staging_len < sizeof(staging)) staging[staging_len++] = (uint8_t)(hi << 4 | lo);
+    }
+    return true;
+}
+
+static bool on_read_line(const char *line, void *user_data)
+{
+    (void)user_data;
+
+    if (!got_header) {
+        int id;
+        unsigned long size, offset;
+        if (strncmp(line, HEADER_PREFIX, strlen(HEADER_PREFIX)) == 0 &&
+            sscanf(line, "HTML %d %*s (%lu bytes) at %lu:", &id, &size, &offset) == 3) {
+            got_header = true;
+            staging_len = 0;
+            reply_size = (uint32_t)size;
+            return false;
+        }
+        // JanOS logs may come first; any other answer means no html_read
+        if (!is_log_line(line)) {
+            unsupported = true;
+            return true;
+        }
+        return false;
+    }
+
+    if (strncmp(line, FOOTER_PREFIX, strlen(FOOTER_PREFIX)) == 0) {
+        uint32_t offset = request_index * HTML_PREVIEW_CHUNK;
+        cache_put(request_file, request_index, staging, staging_len,
+                  staging_len < HTML_PREVIEW_CHUNK || offset + staging_len >= reply_size);
+        return true;
+    }
+    add_hex_line(line);
+    return false;
+}
+
+static void on_read_done(uart_request_status_t status, void *user_data)
+{
+    (void)user_data;
+    if (state == HTML_PREVIEW_CLOSED) return;
+    if (status == UART_REQUEST_TIMEOUT || unsupported) {
+        ESP_LOGW(TAG, "Chunk %lu not received%s", (unsigned long)request_index,
+                 unsupported ? ": JanOS has no " HTML_PREVIEW_CMD : "");
+        state = HTML_PREVIEW_FAILED;
+    } else if (state == HTML_PREVIEW_WAITING) {
+        state = HTML_PREVIEW_PAUSED;
+    }
+}
+
+static void request_chunk(void)
+{
+    char cmd[UART_REQUEST_CMD_LEN];
+    snprintf(cmd, sizeof(cmd), "%s %d %lu %d", HTML_PREVIEW_CMD, file.id,
+             (unsigned long)next_chunk * HTML_PREVIEW_CHUNK, HTML_PREVIEW_CHUNK);
+
+    request_file = file_key;
+    request_index = next_chunk;
+    got_header = false;
+    state = HTML_PREVIEW_WAITING;
+    const uart_request_t req = {
+        .cmd = cmd,
+        .on_line = on_read_line,
+        .on_done = on_read_done,
+        .timeout_ms = HTML_PREVIEW_TIMEOUT_MS,
+    };
+    if (uart_request(&req) != ESP_OK) state = HTML_PREVIEW_FAILED;
+}
+
+// ---------------------------------------------------------------------------
+// Detail view source
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief Strip every cached chunk that continues the text
+ */
+static void take_cached(void)
+{
+    while (!file_read && !text_full) {
+        xSemaphoreTake(cache_mutex, portMAX_DELAY);
+        int slot = cache_find(file_key, next_chunk);
+        if (slot >= 0) {
+            cache[slot].used = ++cache_stamp;
+            for (int i = 0; i < cache[slot].len; i++) strip_byte(cache[slot].data[i]);
+            file_read = cache[slot].last;
+        }
+        xSemaphoreGive(cache_mutex);
+        if (slot < 0) break;
+        next_chunk++;
+    }
+    if ((file_read || text_full) && state != HTML_PREVIEW_CLOSED) state = HTML_PREVIEW_DONE;
+}
+
+static const char *source_text(void *ctx, size_t *len, bool *complete)
+{
+    (void)ctx;
+    take_cached();
+
+    if (state == HTML_PREVIEW_FAILED && !text_full) {
+        put_newline();
+        const char *why = unsupported ? "[JanOS has no " HTML_PREVIEW_CMD "]" :
+                          "[JanOS did not send more]";
+        for (const char *p = why; *p; p++) put_raw(*p);
+        text_full = true;
+    }
+    if (file_read && text_len == 0 && !text_full) {
+        const char *empty = "[No text in this file]";
+        for (const char *p = empty; *p; p++) put_raw(*p);
+        text_full = true;
+    }
+
+    *len = text_len;
+    *complete = file_read || text_full;
+    return text;
+}
+
+static void source_more(void *ctx)
+{
+    (void)ctx;
+    if (state != HTML_PREVIEW_PAUSED || file_read || text_full) return;
+
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    bool cached = cache_find(file_key, next_chunk) >= 0;
+    xSemaphoreGive(cache_mutex);
+    // Cached chunks are taken on the next source_text()
+    if (!cached) request_chunk();
+}
+
+static void source_close(void *ctx)
+{
+    (void)ctx;
+    state = HTML_PREVIEW_CLOSED;
+    free(text);
+    text = NULL;
+}
+
+esp_err_t html_preview_show(const sd_file_t *f)
+{
+    if (cache_init() != ESP_OK) return ESP_ERR_NO_MEM;
+
+    data_detail_params_t *params = calloc(1, sizeof(data_detail_params_t));
+    char *buf = malloc(TEXT_INITIAL);
+    if (!params || !buf) {
+        free(params);
+        free(buf);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Only one detail view shows a preview at a time
+    free(text);
+    text = buf;
+    text[0] = '\0';
+    text_len = 0;
+    text_cap = TEXT_INITIAL;
+    text_full = false;
+    memset(&strip, 0, sizeof(strip));
+    file = *f;
+    file_key = mac_set_key_from_string(f->name);
+    next_chunk = 0;
+    file_read = false;
+    unsupported = false;
+    state = HTML_PREVIEW_PAUSED;
+    ESP_LOGI(TAG, "Previewing %s (id %d)", file.name, file.id);
+
+    snprintf(params->title, sizeof(params->title), "%s", f->name);
+    params->source = (data_detail_source_t){
+        .text = source_text,
+        .more = source_more,
+        .close = source_close,
+    };
+    esp_err_t err = screen_manager_push(data_detail_screen_create, params);
+    if (err == ESP_ERR_NO_MEM) free(params);
+    if (err != ESP_OK) source_close(NULL);
+    return err;
+}
+
+html_preview_state_t html_preview_state(void)
+{
+    return state;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file html_preview.h
+ * @brief Paged preview of portal HTML templates on the JanOS card
+ *
+ * The HTML pickers list templates by file name only. A preview shows the
+ * text a template puts on screen (title, headings, labels) in the detail
+ * view without moving the whole file: "html_read <id> <offset> <length>"
+ * makes JanOS send one HTML_PREVIEW_CHUNK of the file, and the next chunk
+ * is asked for only when the view is scrolled to the end of the text so
+ * far. Tags, comments, scripts and styles are stripped as the chunks are
+ * read, and block elements start a new line.
+ *
+ * The last HTML_PREVIEW_CACHE_CHUNKS chunks stay cached (least recently
+ * used out first), so going back to a template just seen, or paging it
+ * again, costs no UART traffic. The cache is dropped with the SD listing,
+ * when JanOS reports a change of card.
+ *
+ * Reply (the file data hex-encoded, 64 bytes per line):
+ *   HTML 4 voda.html (3315 bytes) at 0:
+ *   3c21444f43545950452068746d6c3e0a3c68746d6c3e...
+ *   Sent 512 bytes
+ *
+ * JanOS builds without html_read answer something else; the preview then
+ * says so instead of showing text.
+ *
+ * Chunks are received on the UART RX task; the text is built on the UI
+ * task.
+ */
+
+#ifndef HTML_PREVIEW_H
+#define HTML_PREVIEW_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "sd_listing.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#define HTML_PREVIEW_CHUNK          512     // Bytes per html_read
+#ifdef CONFIG_HTML_PREVIEW_CACHE_CHUNKS
+#define HTML_PREVIEW_CACHE_CHUNKS   CONFIG_HTML_PREVIEW_CACHE_CHUNKS
+#else
+#define HTML_PREVIEW_CACHE_CHUNKS   8
+#endif
+#define HTML_PREVIEW_TEXT_MAX       8192    // Text shown per template, the rest is cut
+#define HTML_PREVIEW_TIMEOUT_MS     2000
+#define HTML_PREVIEW_CMD            "html_read"
+
+typedef enum {
+    HTML_PREVIEW_CLOSED = 0,
+    HTML_PREVIEW_WAITING,           // Chunk asked for
+    HTML_PREVIEW_PAUSED,            // More to read when the view needs it
+    HTML_PREVIEW_DONE,              // Whole file read, or the text is full
+    HTML_PREVIEW_FAILED,            // JanOS did not send the chunk
+} html_preview_state_t;
+
+/**
+ * @brief Open the detail view on a template's text
+ *
+ * One preview is open at a time; the previous one is closed.
+ * @param file Template as listed by sd_listing
+ * @return ESP_OK if the screen was pushed, ESP_ERR_NO_MEM
+ */
+esp_err_t html_preview_show(const sd_file_t *file);
+
+html_preview_state_t html_preview_state(void);
+
+#endif // HTML_PREVIEW_H
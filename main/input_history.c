@@ -0,0 +1,90 @@
+/**
+ * @file input_history.c
+ * @brief Per-field history of submitted text input, kept in NVS
+ */
+
+#include "input_history.h"
+#include "nvs.h"
+#include "esp_log.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "INPUT_HIST";
+
+#define NVS_NAMESPACE   "input_hist"
+
+void input_history_load(const char *field, input_history_t *history)
+{
+    memset(history, 0, sizeof(*history));
+    if (!field || INPUT_HISTORY_DEPTH == 0) return;
+
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) return;
+
+    // Entries are stored back to back without the count; a blob from a
+    // build with a different depth keeps as many entries as fit
+    size_t len = sizeof(history->entries);
+    esp_err_t ret = nvs_get_blob(handle, field, history->entries, &len);
+    if (ret == ESP_ERR_NVS_INVALID_LENGTH) {
+        len = 0;
+        nvs_get_blob(handle, field, NULL, &len);
+        char *blob = malloc(len);
+        if (blob && nvs_get_blob(handle, field, blob, &len) == ESP_OK) {
+            memcpy(history->entries, blob, sizeof(history->entries));
+            len = sizeof(history->entries);
+            ret = ESP_OK;
+        }
+        free(blob);
+    }
+    nvs_close(handle);
+    if (ret != ESP_OK) {
+        memset(history, 0, sizeof(*history));
+        return;
+    }
+
+    int stored = len / sizeof(history->entries[0]);
+    if (stored > INPUT_HISTORY_DEPTH) stored = INPUT_HISTORY_DEPTH;
+    for (int i = 0; i < stored && history->entries[i][0]; i++) {
+        history->entries[i][TEXT_INPUT_MAX_LEN] = '\0';
+        history->count++;
+    }
+}
+
+esp_err_t input_history_add(const char *field, input_history_t *history, const char *text)
+{
+    if (!field || !text || !text[0] || INPUT_HISTORY_DEPTH == 0) return ESP_OK;
+
+    // Drop an earlier copy, or the oldest entry if the list is full
+    int found = history->count;
+    for (int i = 0; i < history->count; i++) {
+        if (strcmp(history->entries[i], text) == 0) {
+            found = i;
+            break;
+        }
+    }
+    if (found == INPUT_HISTORY_DEPTH) found--;
+    if (found == 0 && history->count > 0) return ESP_OK;  // Already newest
+    memmove(history->entries[1], history->entries[0], found * sizeof(history->entries[0]));
+    memset(history->entries[0], 0, sizeof(history->entries[0]));
+    strncpy(history->entries[0], text, TEXT_INPUT_MAX_LEN);
+    if (found == history->count) history->count++;
+
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(handle, field, history->entries,
+                           history->count * sizeof(history->entries[0]));
+        if (ret == ESP_OK) ret = nvs_commit(handle);
+        nvs_close(handle);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to store %s history: %s", field, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+const char* input_history_get(const input_history_t *history, int age)
+{
+    if (age < 0 || age >= history->count) return NULL;
+    return history->entries[age];
+}
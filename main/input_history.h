@@ -0,0 +1,54 @@
+/**
+ * @file input_history.h
+ * @brief Per-field history of submitted text input, kept in NVS
+ *
+ * Each field (SSID, password, filter, ...) has its own list, newest
+ * first, stored as one blob under the field's key. Submitting a value
+ * already in the list moves it to the front instead of repeating it.
+ */
+
+#ifndef INPUT_HISTORY_H
+#define INPUT_HISTORY_H
+
+#include "text_input_screen.h"
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef CONFIG_INPUT_HISTORY_DEPTH
+#define INPUT_HISTORY_DEPTH     CONFIG_INPUT_HISTORY_DEPTH
+#else
+#define INPUT_HISTORY_DEPTH     8
+#endif
+
+#define INPUT_HISTORY_KEY_MAX   15      // NVS key length limit
+
+typedef struct {
+    uint8_t count;
+    char entries[INPUT_HISTORY_DEPTH > 0 ? INPUT_HISTORY_DEPTH : 1][TEXT_INPUT_MAX_LEN + 1];
+} input_history_t;
+
+/**
+ * @brief Load a field's history (empty if none is stored)
+ * @param field Field key, at most INPUT_HISTORY_KEY_MAX chars
+ * @param history Filled in
+ */
+void input_history_load(const char *field, input_history_t *history);
+
+/**
+ * @brief Put a value at the front of a field's history and store it
+ * @param field Field key
+ * @param history History loaded for the field, updated in place
+ * @param text Submitted value ("" is ignored)
+ * @return ESP_OK, or the NVS error
+ */
+esp_err_t input_history_add(const char *field, input_history_t *history, const char *text);
+
+/**
+ * @brief Get an entry by age
+ * @param age 0 for the newest entry
+ * @return Entry, or NULL if not that many are kept
+ */
+const char* input_history_get(const input_history_t *history, int age);
+
+#endif // INPUT_HISTORY_H
@@ -0,0 +1,177 @@
+/**
+ * @file job_manager.c
+ * @brief Long-running JanOS operations kept going while other views are open
+ */
+
+#include "job_manager.h"
+#include "uart_handler.h"
+#include "text_ui.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "JOBS";
+
+// Per kind: tray letter, name, and the commands that (re)start its operation
+typedef struct {
+    char letter;
+    const char *name;
+    const char *const *starts;
+} job_kind_info_t;
+
+static const char *const sniffer_starts[] = { "start_sniffer", "start_sniffer_noscan", NULL };
+static const char *const detector_starts[] = { "deauth_detector", NULL };
+static const char *const wardrive_starts[] = { "start_wardrive_promisc", "start_wardrive", NULL };
+static const char *const gps_raw_starts[] = { "start_gps_raw", NULL };
+
+static const job_kind_info_t kinds[JOB_KIND_COUNT] = {
+    [JOB_SNIFFER]         = { 'S', "Sniffer", sniffer_starts },
+    [JOB_DEAUTH_DETECTOR] = { 'D', "Deauth detector", detector_starts },
+    [JOB_WARDRIVE]        = { 'W', "Wardrive", wardrive_starts },
+    [JOB_GPS_RAW]         = { 'G', "GPS raw", gps_raw_starts },
+};
+
+// Written by the UI task; `ended` also by whichever task sends a command
+static job_info_t jobs[JOB_MANAGER_MAX];
+static int job_count = 0;
+static volatile uint32_t generation = 0;
+static portMUX_TYPE jobs_lock = portMUX_INITIALIZER_UNLOCKED;
+
+const char *job_kind_name(job_kind_t kind)
+{
+    return kind < JOB_KIND_COUNT ? kinds[kind].name : "?";
+}
+
+esp_err_t job_manager_background(job_kind_t kind, screen_t *screen)
+{
+    if (kind >= JOB_KIND_COUNT || !screen) return ESP_ERR_INVALID_ARG;
+    if (job_count >= JOB_MANAGER_MAX) {
+        ESP_LOGW(TAG, "%d jobs already in the background", job_count);
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = screen_manager_detach(screen);
+    if (ret != ESP_OK) return ret;
+
+    taskENTER_CRITICAL(&jobs_lock);
+    jobs[job_count++] = (job_info_t){
+        .kind = kind,
+        .screen = screen,
+        .started_us = esp_timer_get_time(),
+    };
+    generation++;
+    taskEXIT_CRITICAL(&jobs_lock);
+
+    ESP_LOGI(TAG, "%s running in the background", kinds[kind].name);
+    return ESP_OK;
+}
+
+/**
+ * @brief Whether the first word of a command is one of a kind's start commands
+ */
+static bool starts_kind(job_kind_t kind, const char *cmd, size_t word_len)
+{
+    for (const char *const *start = kinds[kind].starts; *start; start++) {
+        if (strlen(*start) == word_len && strncmp(cmd, *start, word_len) == 0) return true;
+    }
+    return false;
+}
+
+void job_manager_note_command(const char *cmd)
+{
+    if (!cmd || job_count == 0) return;
+
+    size_t word_len = strcspn(cmd, " \r\n");
+    bool stop = word_len == 4 && strncmp(cmd, "stop", 4) == 0;
+    bool operation = stop || strncmp(cmd, "start_", 6) == 0 ||
+                     (word_len == 13 && strncmp(cmd, "scan_networks", 13) == 0) ||
+                     (word_len == 15 && strncmp(cmd, "deauth_detector", 15) == 0);
+    if (!operation) return;
+
+    taskENTER_CRITICAL(&jobs_lock);
+    for (int i = 0; i < job_count; i++) {
+        if (!jobs[i].ended && (stop || !starts_kind(jobs[i].kind, cmd, word_len))) {
+            jobs[i].ended = true;
+            generation++;
+        }
+    }
+    taskEXIT_CRITICAL(&jobs_lock);
+}
+
+/**
+ * @brief Drop a job from the table (UI task)
+ */
+static void remove_job(int index)
+{
+    taskENTER_CRITICAL(&jobs_lock);
+    job_count--;
+    memmove(&jobs[index], &jobs[index + 1], (size_t)(job_count - index) * sizeof(jobs[0]));
+    generation++;
+    taskEXIT_CRITICAL(&jobs_lock);
+}
+
+void job_manager_service(void)
+{
+    char tray[UI_TITLE_TRAY_LEN + 1];
+    int len = 0;
+
+    for (int i = 0; i < job_count; ) {
+        if (jobs[i].ended) {
+            // Still listed while its on_destroy runs (job_manager_is_background)
+            ESP_LOGI(TAG, "%s job ended", kinds[jobs[i].kind].name);
+            screen_manager_destroy_detached(jobs[i].screen);
+            remove_job(i);
+            continue;
+        }
+        if (len < UI_TITLE_TRAY_LEN) tray[len++] = kinds[jobs[i].kind].letter;
+        i++;
+    }
+    tray[len] = '\0';
+    ui_set_title_tray(tray);
+}
+
+bool job_manager_is_background(const screen_t *screen)
+{
+    for (int i = 0; i < job_count; i++) {
+        if (jobs[i].screen == screen) return true;
+    }
+    return false;
+}
+
+int job_manager_count(void)
+{
+    return job_count;
+}
+
+bool job_manager_get(int index, job_info_t *out)
+{
+    if (index < 0 || index >= job_count || !out) return false;
+    taskENTER_CRITICAL(&jobs_lock);
+    *out = jobs[index];
+    taskEXIT_CRITICAL(&jobs_lock);
+    return true;
+}
+
+uint32_t job_manager_generation(void)
+{
+    return generation;
+}
+
+esp_err_t job_manager_reopen(int index)
+{
+    if (index < 0 || index >= job_count) return ESP_ERR_NOT_FOUND;
+    if (jobs[index].ended) return ESP_ERR_INVALID_STATE;
+
+    esp_err_t ret = screen_manager_attach(jobs[index].screen);
+    if (ret != ESP_OK) return ret;
+    remove_job(index);
+    return ESP_OK;
+}
+
+esp_err_t job_manager_stop(int index)
+{
+    if (index < 0 || index >= job_count) return ESP_ERR_NOT_FOUND;
+    // JanOS runs one operation: this ends every job sharing the board
+    return uart_send_command("stop");
+}
@@ -0,0 +1,110 @@
+/**
+ * @file job_manager.h
+ * @brief Long-running JanOS operations kept going while other views are open
+ *
+ * The sniffer, deauth detector, wardrive and GPS raw screens each drive
+ * one JanOS operation that runs until `stop`. Pressing B on one of them
+ * makes it a background job: the screen leaves the stack without being
+ * destroyed (screen_manager_detach()), the operation keeps running, and
+ * the screen's parsers keep receiving lines, so world_model, the stores
+ * and the screen's own counters go on filling in while the operator
+ * browses. A background screen is not ticked or drawn; reopening it from
+ * the jobs screen puts it back on top as it was.
+ *
+ * JanOS runs one operation at a time, so a job ends when `stop` or the
+ * start of another operation is sent, from any screen. Its screen is then
+ * destroyed by job_manager_service(). The title bar tray shows one letter
+ * per background job.
+ */
+
+#ifndef JOB_MANAGER_H
+#define JOB_MANAGER_H
+
+#include "screen_manager.h"
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define JOB_MANAGER_MAX     4
+
+typedef enum {
+    JOB_SNIFFER = 0,
+    JOB_DEAUTH_DETECTOR,
+    JOB_WARDRIVE,
+    JOB_GPS_RAW,
+    JOB_KIND_COUNT
+} job_kind_t;
+
+typedef struct {
+    job_kind_t kind;
+    screen_t *screen;
+    int64_t started_us;             // Sent to the background (esp_timer time)
+    bool ended;                     // Operation replaced or stopped, screen not yet destroyed
+} job_info_t;
+
+/**
+ * @brief Send the current screen to the background as a job
+ *
+ * Called from the screen's own key handler; the screen below becomes
+ * current.
+ * @param kind Operation the screen runs
+ * @param screen The current screen
+ * @return ESP_OK, ESP_ERR_NO_MEM if the job table is full, or the
+ *         screen_manager_detach() error
+ */
+esp_err_t job_manager_background(job_kind_t kind, screen_t *screen);
+
+/**
+ * @brief Note a command going to the primary board (UART TX path, any task)
+ *
+ * `stop` ends every job; the start of another operation ends the jobs it
+ * replaces.
+ */
+void job_manager_note_command(const char *cmd);
+
+/**
+ * @brief Destroy the screens of ended jobs and update the title bar tray
+ *
+ * Called from the main loop with the UI lock held.
+ */
+void job_manager_service(void);
+
+/**
+ * @brief Whether a screen is a background job (for its on_destroy)
+ */
+bool job_manager_is_background(const screen_t *screen);
+
+/**
+ * @brief Background jobs, ended ones included until serviced
+ */
+int job_manager_count(void);
+
+/**
+ * @brief Copy a job
+ * @return false if index is out of range
+ */
+bool job_manager_get(int index, job_info_t *out);
+
+/**
+ * @brief Counter bumped whenever the job list changes
+ */
+uint32_t job_manager_generation(void);
+
+/**
+ * @brief Bring a job's screen back to the foreground (UI lock held)
+ * @return ESP_OK, ESP_ERR_NOT_FOUND, ESP_ERR_INVALID_STATE if it ended,
+ *         or the screen_manager_attach() error
+ */
+esp_err_t job_manager_reopen(int index);
+
+/**
+ * @brief Stop a job's operation; its screen goes at the next service
+ */
+esp_err_t job_manager_stop(int index);
+
+/**
+ * @brief Short name of a job kind
+ */
+const char *job_kind_name(job_kind_t kind);
+
+#endif // JOB_MANAGER_H
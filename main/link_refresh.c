@@ -0,0 +1,119 @@
+/**
+ * @file link_refresh.c
+ * @brief Cached JanOS listings refreshed in idle link time
+ */
+
+#include "link_refresh.h"
+#include "uart_handler.h"
+#include "cred_store.h"
+#include "remote_dir.h"
+#include "world_model.h"
+#include "handshakes_screen.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "REFRESH";
+
+typedef struct {
+    const char *name;
+    uint32_t interval_ms;           // Shortest gap between two refreshes
+    bool periodic;                  // Else runs as soon as wanted
+    bool (*wanted)(void);           // Cached and worth refreshing now
+    esp_err_t (*run)(void);
+} refresh_source_t;
+
+static bool handshakes_wanted(void)
+{
+    return strcmp(remote_dir_path(), HANDSHAKES_DIR) == 0 &&
+           remote_dir_state() == REMOTE_DIR_EMPTY;
+}
+
+static esp_err_t handshakes_run(void)
+{
+    return remote_dir_open(HANDSHAKES_DIR, ".pcap", false);
+}
+
+static bool probes_wanted(void)
+{
+    return world_model_probe_listings() > 0;
+}
+
+/**
+ * @brief The header or "no probes" line ends the reply; world_model parses the rows
+ */
+static bool probes_line(const char *line, void *user_data)
+{
+    (void)user_data;
+    return strstr(line, "Probe requests: ") || strstr(line, "No probe") ||
+           strstr(line, "no probe");
+}
+
+static esp_err_t probes_run(void)
+{
+    const uart_request_t req = {
+        .cmd = "show_probes",
+        .on_line = probes_line,
+        .timeout_ms = LINK_REFRESH_PROBES_TIMEOUT_MS,
+    };
+    return uart_request(&req);
+}
+
+static bool evil_wanted(void)
+{
+    return cred_store_load_state(CRED_EVIL) == CRED_READY;
+}
+
+static esp_err_t evil_run(void)
+{
+    return cred_store_reload(CRED_EVIL);
+}
+
+static bool portal_wanted(void)
+{
+    return cred_store_load_state(CRED_PORTAL) == CRED_READY;
+}
+
+static esp_err_t portal_run(void)
+{
+    return cred_store_reload(CRED_PORTAL);
+}
+
+// Highest priority first
+static const refresh_source_t sources[] = {
+    {"handshakes", LINK_REFRESH_HANDSHAKES_MS, false, handshakes_wanted, handshakes_run},
+    {"probes", LINK_REFRESH_PROBES_MS, true, probes_wanted, probes_run},
+    {"evil", LINK_REFRESH_CREDS_MS, true, evil_wanted, evil_run},
+    {"portal", LINK_REFRESH_CREDS_MS, true, portal_wanted, portal_run},
+};
+
+#define SOURCE_COUNT (sizeof(sources) / sizeof(sources[0]))
+
+static int64_t last_run_ms[SOURCE_COUNT];
+static bool armed[SOURCE_COUNT];        // Wanted at the last look
+
+void link_refresh_service(void)
+{
+    int64_t now = esp_timer_get_time() / 1000;
+
+    int due = -1;
+    for (int i = 0; i < (int)SOURCE_COUNT; i++) {
+        if (!sources[i].wanted()) {
+            armed[i] = false;
+            continue;
+        }
+        if (!armed[i]) {
+            // A periodic listing that just loaded is fresh for an interval
+            armed[i] = true;
+            if (sources[i].periodic) last_run_ms[i] = now;
+        }
+        if (due < 0 && now - last_run_ms[i] >= sources[i].interval_ms) {
+            due = i;
+        }
+    }
+    if (due < 0 || !uart_link_idle(LINK_REFRESH_QUIET_MS)) return;
+
+    last_run_ms[due] = now;
+    esp_err_t ret = sources[due].run();
+    ESP_LOGD(TAG, "Refreshing %s: %s", sources[due].name, esp_err_to_name(ret));
+}
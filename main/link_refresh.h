@@ -0,0 +1,39 @@
+/**
+ * @file link_refresh.h
+ * @brief Cached JanOS listings refreshed in idle link time
+ *
+ * Views backed by a listing keep what they fetched last, so they open at
+ * once but drift: captures from another session, probes sniffed since,
+ * a handshakes listing dropped when a capture landed. From the main loop
+ * this scheduler looks for link time nobody uses (uart_link_idle() for
+ * LINK_REFRESH_QUIET_MS) and sends one refresh at a time:
+ *
+ *   source        priority  when
+ *   handshakes    0         listing was dropped (remote_dir_invalidate)
+ *   probes        1         every LINK_REFRESH_PROBES_MS once listed
+ *   Evil Twin     2         every LINK_REFRESH_CREDS_MS once loaded
+ *   portal data   3         every LINK_REFRESH_CREDS_MS once loaded
+ *
+ * Only listings something has asked for before are refreshed. A command
+ * the user sends makes the link busy, so nothing new starts until it has
+ * finished; a refresh already sent still runs to its end (JanOS cannot be
+ * stopped mid-listing), so a command waits for at most one listing.
+ */
+
+#ifndef LINK_REFRESH_H
+#define LINK_REFRESH_H
+
+#include "sdkconfig.h"
+
+#define LINK_REFRESH_QUIET_MS       1000    // Link silent this long before a refresh
+#define LINK_REFRESH_PROBES_MS      60000
+#define LINK_REFRESH_CREDS_MS       300000
+#define LINK_REFRESH_HANDSHAKES_MS  5000    // Shortest gap between two listings
+#define LINK_REFRESH_PROBES_TIMEOUT_MS  2000
+
+/**
+ * @brief Send the most urgent refresh that is due (main loop, UI lock held)
+ */
+void link_refresh_service(void);
+
+#endif // LINK_REFRESH_H
@@ -0,0 +1,90 @@
+/**
+ * @file listing_prefetch.c
+ * @brief Listings fetched while a menu cursor rests on the item that shows them
+ *
+ * Runs on the main loop only, like the screens that open the same
+ * listings, so the loaders never see two callers at once.
+ */
+
+#include "listing_prefetch.h"
+#include "uart_handler.h"
+#include "cred_store.h"
+#include "remote_dir.h"
+#include "sd_listing.h"
+#include "handshakes_screen.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "PREFETCH";
+
+static listing_t pending = LISTING_NONE;
+static int64_t due_ms = 0;          // Next look at the link
+static int64_t give_up_ms = 0;
+
+static int64_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+void listing_prefetch_hover(listing_t listing)
+{
+    pending = LISTING_PREFETCH_DWELL_MS > 0 ? listing : LISTING_NONE;
+    if (pending == LISTING_NONE) return;
+
+    due_ms = now_ms() + LISTING_PREFETCH_DWELL_MS;
+    give_up_ms = due_ms + LISTING_PREFETCH_GIVE_UP_MS;
+}
+
+void listing_prefetch_cancel(void)
+{
+    pending = LISTING_NONE;
+}
+
+int32_t listing_prefetch_due_ms(void)
+{
+    if (pending == LISTING_NONE) return -1;
+
+    int64_t left = due_ms - now_ms();
+    return left > 0 ? (int32_t)left : 0;
+}
+
+void listing_prefetch_service(void)
+{
+    if (pending == LISTING_NONE) return;
+
+    int64_t now = now_ms();
+    if (now < due_ms) return;
+    if (!uart_link_idle(LISTING_PREFETCH_QUIET_MS)) {
+        if (now >= give_up_ms) {
+            pending = LISTING_NONE;
+        } else {
+            due_ms = now + LISTING_PREFETCH_RETRY_MS;
+        }
+        return;
+    }
+
+    listing_t listing = pending;
+    pending = LISTING_NONE;
+
+    // Each loader returns at once when its listing is cached or loading
+    esp_err_t ret = ESP_OK;
+    switch (listing) {
+        case LISTING_EVIL_TWIN_PASSWORDS:
+            ret = cred_store_load(CRED_EVIL);
+            break;
+        case LISTING_PORTAL_DATA:
+            ret = cred_store_load(CRED_PORTAL);
+            break;
+        case LISTING_HANDSHAKES:
+            ret = remote_dir_open(HANDSHAKES_DIR, ".pcap", false);
+            break;
+        case LISTING_HTML_FILES:
+            ret = sd_listing_refresh(false);
+            break;
+        default:
+            break;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Prefetch %d not sent: %s", (int)listing, esp_err_to_name(ret));
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * @file listing_prefetch.h
+ * @brief Listings fetched while a menu cursor rests on the item that shows them
+ *
+ * Screens backed by a JanOS listing (saved passwords and portal data in
+ * cred_store, handshakes in remote_dir, HTML files in sd_listing) send
+ * their command only once pushed, so they open on "Loading...". Menus
+ * report the item under the cursor with listing_prefetch_hover(); once it
+ * has stayed there LISTING_PREFETCH_DWELL_MS and the link is idle
+ * (uart_link_idle()), the listing is requested into its usual cache, and
+ * the screen usually finds it ready when Enter is pressed.
+ *
+ * A prefetch not sent yet is dropped when the cursor moves on or the menu
+ * closes, and when Enter opens the listing screen itself; menus whose
+ * item reaches the listing only after more input (the HTML pickers) keep
+ * it. It gives up if the link stays busy for LISTING_PREFETCH_GIVE_UP_MS.
+ * A listing already cached is not fetched again; one already sent runs to
+ * the end, since its rows go to a shared cache whichever screen asked.
+ */
+
+#ifndef LISTING_PREFETCH_H
+#define LISTING_PREFETCH_H
+
+#include "sdkconfig.h"
+#include <stdint.h>
+
+#ifdef CONFIG_LISTING_PREFETCH_DWELL_MS
+#define LISTING_PREFETCH_DWELL_MS   CONFIG_LISTING_PREFETCH_DWELL_MS
+#else
+#define LISTING_PREFETCH_DWELL_MS   300
+#endif
+
+#define LISTING_PREFETCH_QUIET_MS   200     // Link silent this long counts as idle
+#define LISTING_PREFETCH_RETRY_MS   250     // Next look while the link is busy
+#define LISTING_PREFETCH_GIVE_UP_MS 5000
+
+typedef enum {
+    LISTING_NONE = 0,
+    LISTING_EVIL_TWIN_PASSWORDS,    // show_pass evil
+    LISTING_PORTAL_DATA,            // show_pass portal
+    LISTING_HANDSHAKES,             // list_dir of HANDSHAKES_DIR
+    LISTING_HTML_FILES,             // list_sd, for the HTML pickers
+} listing_t;
+
+/**
+ * @brief The menu cursor moved onto an item (UI lock held)
+ * @param listing What the item's screen lists, LISTING_NONE to drop a prefetch
+ */
+void listing_prefetch_hover(listing_t listing);
+
+/**
+ * @brief Drop a prefetch not sent yet (Enter pressed, menu closing)
+ */
+void listing_prefetch_cancel(void);
+
+/**
+ * @brief Milliseconds until listing_prefetch_service() has work
+ * @return -1 if nothing is waiting
+ */
+int32_t listing_prefetch_due_ms(void);
+
+/**
+ * @brief Send a prefetch that is due (main loop, UI lock held)
+ */
+void listing_prefetch_service(void);
+
+#endif // LISTING_PREFETCH_H
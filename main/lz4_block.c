@@ -0,0 +1,156 @@
+/**
+ * @file lz4_block.c
+ * @brief LZ4 block compression of small, self-contained buffers
+ */
+
+#include "lz4_block.h"
+#include <string.h>
+
+#define MIN_MATCH       4
+#define LAST_LITERALS   5       // A block ends with at least this many literals
+#define MATCH_LIMIT     12      // No match starts this close to the end
+#define TABLE_EMPTY     0xFFFF
+
+static uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t hash_at(const uint8_t *p)
+{
+    return (read32(p) * 2654435761U) >> (32 - LZ4_BLOCK_HASH_BITS);
+}
+
+/**
+ * @brief Length nibble overflow: bytes of 255 and a remainder
+ */
+static uint8_t *put_length(uint8_t *op, size_t length)
+{
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+/**
+ * @brief Emit literals and, with match_len, one match
+ * @return Advanced output pointer, or NULL when out of room
+ */
+static uint8_t *put_sequence(uint8_t *op, const uint8_t *op_end, const uint8_t *literals,
+                             size_t literal_len, size_t offset, size_t match_len)
+{
+    // Token, literal length bytes, literals, offset, match length bytes
+    if ((size_t)(op_end - op) < 1 + literal_len / 255 + 1 + literal_len + 2 + match_len / 255 + 1) {
+        return NULL;
+    }
+    uint8_t *token = op++;
+    *token = (uint8_t)((literal_len < 15 ? literal_len : 15) << 4);
+    if (literal_len >= 15) op = put_length(op, literal_len - 15);
+    memcpy(op, literals, literal_len);
+    op += literal_len;
+    if (match_len == 0) return op;
+
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    size_t m = match_len - MIN_MATCH;
+    *token |= (uint8_t)(m < 15 ? m : 15);
+    if (m >= 15) op = put_length(op, m - 15);
+    return op;
+}
+
+size_t lz4_block_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap,
+                          uint16_t *table)
+{
+    if (len > LZ4_BLOCK_INPUT_MAX) return 0;
+    uint8_t *op = dst;
+    const uint8_t *op_end = dst + cap;
+    size_t anchor = 0;
+
+    if (len > MATCH_LIMIT) {
+        memset(table, 0xFF, LZ4_BLOCK_TABLE_SIZE * sizeof(uint16_t));
+        size_t match_end_limit = len - LAST_LITERALS;
+        size_t ip = 0;
+        while (ip < len - MATCH_LIMIT) {
+            uint32_t h = hash_at(src + ip);
+            size_t ref = table[h];
+            table[h] = (uint16_t)ip;
+            if (ref == TABLE_EMPTY || read32(src + ref) != read32(src + ip)) {
+                ip++;
+                continue;
+            }
+
+            size_t match_len = MIN_MATCH;
+            while (ip + match_len < match_end_limit && src[ref + match_len] == src[ip + match_len]) {
+                match_len++;
+            }
+            op = put_sequence(op, op_end, src + anchor, ip - anchor, ip - ref, match_len);
+            if (!op) return 0;
+            ip += match_len;
+            anchor = ip;
+        }
+    }
+
+    op = put_sequence(op, op_end, src + anchor, len - anchor, 0, 0);
+    return op ? (size_t)(op - dst) : 0;
+}
+
+/**
+ * @brief Add the extension bytes of a length nibble that was 15
+ */
+static int read_length(const uint8_t **in, const uint8_t *end, size_t *length)
+{
+    uint8_t b;
+    do {
+        if (*in == end) return -1;
+        b = *(*in)++;
+        *length += b;
+    } while (b == 255);
+    return 0;
+}
+
+int lz4_block_decompress_prefix(const uint8_t *src, size_t len, uint8_t *dst, size_t cap,
+                                size_t prefix_len)
+{
+    const uint8_t *in = src;
+    const uint8_t *end = src + len;
+    uint8_t *op = dst;
+    const uint8_t *limit = dst + cap;
+
+    while (in < end) {
+        uint8_t token = *in++;
+        size_t literals = token >> 4;
+        if (literals == 15 && read_length(&in, end, &literals) < 0) return -1;
+        if (literals > (size_t)(end - in) || literals > (size_t)(limit - op)) return -1;
+        memcpy(op, in, literals);
+        op += literals;
+        in += literals;
+        if (in == end) break;
+
+        if (end - in < 2) return -1;
+        size_t offset = in[0] | (size_t)in[1] << 8;
+        in += 2;
+        if (offset == 0 || offset > (size_t)(op - dst) + prefix_len) return -1;
+
+        size_t match = token & 15;
+        if (match == 15 && read_length(&in, end, &match) < 0) return -1;
+        match += MIN_MATCH;
+        if (match > (size_t)(limit - op)) return -1;
+
+        // Byte by byte: an offset shorter than the match repeats a pattern
+        const uint8_t *ref = op - offset;
+        for (size_t i = 0; i < match; i++) {
+            op[i] = ref[i];
+        }
+        op += match;
+    }
+    return (int)(op - dst);
+}
+
+int lz4_block_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap)
+{
+    return lz4_block_decompress_prefix(src, len, dst, cap, 0);
+}
@@ -0,0 +1,53 @@
+/**
+ * @file lz4_block.h
+ * @brief LZ4 block compression of small, self-contained buffers
+ *
+ * Standard LZ4 block format (no frame header or checksum), so any LZ4
+ * implementation reads the output. The compressor is the greedy
+ * single-probe kind: one hash table of recent positions, no lazy
+ * matching. On repetitive text such as log records it reaches most of
+ * the ratio of the reference compressor at a fraction of its memory.
+ * Inputs are limited to 64 KB, so positions fit the u16 table.
+ *
+ * The decoder is the one parser of untrusted LZ4 in the firmware: it
+ * also expands the linked blocks of uart_bulk, whose matches reach into
+ * the text of earlier blocks.
+ */
+
+#ifndef LZ4_BLOCK_H
+#define LZ4_BLOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LZ4_BLOCK_HASH_BITS     11
+#define LZ4_BLOCK_TABLE_SIZE    (1 << LZ4_BLOCK_HASH_BITS)
+#define LZ4_BLOCK_INPUT_MAX     65535
+
+// Worst case output for len input bytes (all literals)
+#define LZ4_BLOCK_BOUND(len)    ((len) + (len) / 255 + 16)
+
+/**
+ * @brief Compress one buffer
+ * @param table Scratch of LZ4_BLOCK_TABLE_SIZE entries, contents ignored
+ * @return Compressed length, 0 if it did not fit in cap or len is too large
+ */
+size_t lz4_block_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap,
+                          uint16_t *table);
+
+/**
+ * @brief Expand one block
+ * @return Expanded length, or -1 if the block is malformed or exceeds cap
+ */
+int lz4_block_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+
+/**
+ * @brief Expand one block whose matches may reach into earlier output
+ * @param prefix_len History bytes just before dst that matches may copy
+ * @return Expanded length (the prefix not counted), or -1 if the block is
+ *         malformed or exceeds cap
+ */
+int lz4_block_decompress_prefix(const uint8_t *src, size_t len, uint8_t *dst, size_t cap,
+                                size_t prefix_len);
+
+#endif // LZ4_BLOCK_H
@@ -0,0 +1,181 @@
+/**
+ * @file mac_set.c
+ * @brief Fixed-capacity hash set for deduplicating MACs and SSIDs
+ */
+
+#include "mac_set.h"
+#include "janos_proto.h"
+#include <stdlib.h>
+#include <string.h>
+
+// SSID keys carry the top bit; MAC keys only use the low 48 bits
+#define STRING_KEY_TAG  (1ULL << 63)
+
+static uint32_t home_slot(const mac_set_t *set, uint64_t key)
+{
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & set->mask;
+}
+
+esp_err_t mac_set_init(mac_set_t *set, int capacity)
+{
+    memset(set, 0, sizeof(*set));
+    if (capacity < 1 || capacity >= MAC_SET_NONE) return ESP_ERR_INVALID_ARG;
+    
+    // Table at most half full keeps probe runs short
+    uint32_t size = 1;
+    while (size < 2u * capacity) size <<= 1;
+    
+    // One block: keys first for alignment, then the uint16 arrays
+    size_t bytes = capacity * sizeof(uint64_t) + (size + 2u * capacity) * sizeof(uint16_t);
+    uint8_t *block = malloc(bytes);
+    if (!block) return ESP_ERR_NO_MEM;
+    
+    set->keys = (uint64_t *)block;
+    set->slots = (uint16_t *)(block + capacity * sizeof(uint64_t));
+    set->lru_prev = set->slots + size;
+    set->lru_next = set->lru_prev + capacity;
+    set->capacity = capacity;
+    set->mask = size - 1;
+    mac_set_clear(set);
+    return ESP_OK;
+}
+
+void mac_set_free(mac_set_t *set)
+{
+    free(set->keys);
+    memset(set, 0, sizeof(*set));
+}
+
+void mac_set_clear(mac_set_t *set)
+{
+    if (!set->keys) return;
+    memset(set->slots, 0, (set->mask + 1) * sizeof(uint16_t));
+    set->count = 0;
+    set->lru_head = MAC_SET_NONE;
+    set->lru_tail = MAC_SET_NONE;
+    set->evictions = 0;
+}
+
+bool mac_set_key_from_mac(const char *mac, uint64_t *key)
+{
+    return janos_parse_mac(mac, key);
+}
+
+uint64_t mac_set_key_from_string(const char *text)
+{
+    // FNV-1a, 64-bit
+    uint64_t h = 14695981039346656037ULL;
+    for (const char *p = text; p && *p; p++) {
+        h = (h ^ (uint8_t)*p) * 1099511628211ULL;
+    }
+    return h | STRING_KEY_TAG;
+}
+
+static void lru_unlink(mac_set_t *set, uint16_t e)
+{
+    uint16_t prev = set->lru_prev[e];
+    uint16_t next = set->lru_next[e];
+    if (prev != MAC_SET_NONE) set->lru_next[prev] = next; else set->lru_head = next;
+    if (next != MAC_SET_NONE) set->lru_prev[next] = prev; else set->lru_tail = prev;
+}
+
+static void lru_push_front(mac_set_t *set, uint16_t e)
+{
+    set->lru_prev[e] = MAC_SET_NONE;
+    set->lru_next[e] = set->lru_head;
+    if (set->lru_head != MAC_SET_NONE) set->lru_prev[set->lru_head] = e;
+    set->lru_head = e;
+    if (set->lru_tail == MAC_SET_NONE) set->lru_tail = e;
+}
+
+static void lru_touch(mac_set_t *set, uint16_t e)
+{
+    if (set->lru_head == e) return;
+    lru_unlink(set, e);
+    lru_push_front(set, e);
+}
+
+/**
+ * @brief Slot holding key, or the empty slot ending its probe run
+ */
+static uint32_t probe(const mac_set_t *set, uint64_t key)
+{
+    uint32_t slot = home_slot(set, key);
+    while (set->slots[slot] && set->keys[set->slots[slot] - 1] != key) {
+        slot = (slot + 1) & set->mask;
+    }
+    return slot;
+}
+
+/**
+ * @brief Remove a slot from the table by shifting its probe run back
+ */
+static void remove_slot(mac_set_t *set, uint32_t hole)
+{
+    uint32_t j = hole;
+    for (;;) {
+        j = (j + 1) & set->mask;
+        if (!set->slots[j]) break;
+        
+        // Entry at j may move into the hole only if its home slot is not
+        // cyclically between the hole and j
+        uint32_t home = home_slot(set, set->keys[set->slots[j] - 1]);
+        bool stays = (hole <= j) ? (hole < home && home <= j) : (hole < home || home <= j);
+        if (!stays) {
+            set->slots[hole] = set->slots[j];
+            hole = j;
+        }
+    }
+    set->slots[hole] = 0;
+}
+
+int mac_set_find(mac_set_t *set, uint64_t key)
+{
+    if (!set->keys) return -1;
+    
+    uint32_t slot = probe(set, key);
+    if (!set->slots[slot]) return -1;
+    
+    uint16_t e = set->slots[slot] - 1;
+    lru_touch(set, e);
+    return e;
+}
+
+int mac_set_peek(const mac_set_t *set, uint64_t key)
+{
+    if (!set->keys) return -1;
+    
+    uint32_t slot = probe(set, key);
+    return set->slots[slot] ? set->slots[slot] - 1 : -1;
+}
+
+int mac_set_add(mac_set_t *set, uint64_t key, bool *is_new)
+{
+    if (is_new) *is_new = false;
+    if (!set->keys) return -1;
+    
+    uint32_t slot = probe(set, key);
+    if (set->slots[slot]) {
+        uint16_t e = set->slots[slot] - 1;
+        lru_touch(set, e);
+        return e;
+    }
+    
+    uint16_t e;
+    if (set->count < set->capacity) {
+        e = set->count++;
+    } else {
+        // Full: recycle the least recently seen entry
+        e = set->lru_tail;
+        lru_unlink(set, e);
+        remove_slot(set, probe(set, set->keys[e]));
+        set->evictions++;
+        slot = probe(set, key);     // Removal may have shifted the run
+    }
+    
+    set->keys[e] = key;
+    set->slots[slot] = e + 1;
+    lru_push_front(set, e);
+    if (is_new) *is_new = true;
+    return e;
+}
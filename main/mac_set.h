@@ -0,0 +1,83 @@
+/**
+ * @file mac_set.h
+ * @brief Fixed-capacity hash set for deduplicating MACs and SSIDs
+ *
+ * Open-addressing table keyed on packed 48-bit MACs or 64-bit SSID
+ * hashes. Each key owns an entry index in [0, capacity) that callers use
+ * to index their own record array. When the set is full, adding a new key
+ * evicts the least recently seen one and hands back its entry index.
+ */
+
+#ifndef MAC_SET_H
+#define MAC_SET_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MAC_SET_NONE    0xFFFF
+
+typedef struct {
+    uint64_t *keys;         // Key per entry
+    uint16_t *slots;        // Hash slots: entry index + 1, 0 = empty
+    uint16_t *lru_prev;     // Toward the most recently seen entry
+    uint16_t *lru_next;     // Toward the least recently seen entry
+    uint16_t lru_head;      // Most recently seen
+    uint16_t lru_tail;      // Next to evict
+    uint16_t capacity;
+    uint16_t count;
+    uint32_t mask;
+    uint32_t evictions;
+} mac_set_t;
+
+/**
+ * @brief Allocate a set
+ * @param capacity Maximum entries (1 .. 65534)
+ * @return ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t mac_set_init(mac_set_t *set, int capacity);
+
+/**
+ * @brief Release a set's memory (safe on a zeroed or freed set)
+ */
+void mac_set_free(mac_set_t *set);
+
+/**
+ * @brief Remove all entries
+ */
+void mac_set_clear(mac_set_t *set);
+
+/**
+ * @brief Key for a MAC in text form ("AA:BB:CC:DD:EE:FF", leading spaces allowed)
+ * @return false if the text does not start with a MAC
+ */
+bool mac_set_key_from_mac(const char *mac, uint64_t *key);
+
+/**
+ * @brief Key for an SSID or other short string (never equals a MAC key)
+ */
+uint64_t mac_set_key_from_string(const char *text);
+
+/**
+ * @brief Find a key and mark it recently seen
+ * @return Entry index, or -1 if absent
+ */
+int mac_set_find(mac_set_t *set, uint64_t key);
+
+/**
+ * @brief Find a key without marking it seen (lookups that are not sightings)
+ * @return Entry index, or -1 if absent
+ */
+int mac_set_peek(const mac_set_t *set, uint64_t key);
+
+/**
+ * @brief Find a key, adding it if absent
+ *
+ * When the set is full the least recently seen entry is evicted and its
+ * index reused, so the caller must overwrite that record.
+ * @param is_new Set to true if the caller's record at the index is stale
+ * @return Entry index, or -1 if the set was never initialized
+ */
+int mac_set_add(mac_set_t *set, uint64_t key, bool *is_new);
+
+#endif // MAC_SET_H
@@ -14,34 +14,95 @@
 #include "display.h"
 #include "keyboard.h"
 #include "uart_handler.h"
+#include "event_bus.h"
+#include "sd_listing.h"
+#include "cred_store.h"
+#include "world_model.h"
+#include "metrics_store.h"
+#include "survey_link.h"
 #include "screen_manager.h"
+#include "app_events.h"
+#include "boot_profile.h"
 #include "home_screen.h"
 #include "screenshot.h"
+#include "session_log.h"
+#include "store_snapshot.h"
+#include "watchlist.h"
+#include "job_manager.h"
+#include "listing_prefetch.h"
+#include "link_refresh.h"
 #include "battery.h"
 #include "settings.h"
+#include "board_cache.h"
+#include "power.h"
+#include "power_governor.h"
+#include "task_plan.h"
+#include "stall_watch.h"
+#include "mem_monitor.h"
+#include "assets.h"
+#include "oui_lookup.h"
 #include "buzzer.h"
 #include "text_ui.h"
-
-#define JANOS_ADV_VERSION "1.6.0"
+#include "version.h"
 
 // Screen timeout is now configurable via Settings (stored in NVS)
 
+// keyboard_process() period: matrix scan on polled boards; with a key
+// interrupt or scan timer it only drains events already read
+#define KEY_POLL_MS             10
+#define KEY_IRQ_POLL_MS         200
+
+// Shortest gap between UART-triggered screen ticks
+#define UART_TICK_MIN_MS        20
+
+// Board SD check listens this long after list_sd
+#define BOARD_SD_CHECK_MS       3000
+
+// Background boot probing: board ping retries (slower after a while),
+// and the settle time JanOS needs before list_sd
+#define BOARD_PING_TIMEOUT_MS   500
+#define BOARD_RETRY_MS          1000
+#define BOARD_RETRY_SLOW_MS     5000
+#define BOARD_RETRY_FAST_COUNT  10
+#define BOARD_SD_SETTLE_MS      1000
+
 static const char *TAG = "MAIN";
 
 static volatile bool board_sd_missing = false;
 static volatile bool board_sd_check_pending = false;
-static int64_t board_sd_check_start_ms = 0;
+static volatile bool board_sd_check_failed = false;
+static volatile bool board_sd_verified = false;    // Until set, the cached state answers
 static bool board_sd_popup_shown = false;
 
+// Set by the boot tasks once their probe has finished
+static volatile bool board_detected = false;
+static volatile bool board_probe_done = false;
+static volatile bool periph_init_done = false;
+
 bool is_board_sd_missing(void)
 {
-    return board_sd_missing;
+    return board_sd_verified ? board_sd_missing : board_cache_sd() == BOARD_SD_MISSING;
+}
+
+bool is_board_detected(void)
+{
+    return board_detected;
+}
+
+bool is_board_probe_done(void)
+{
+    return board_probe_done;
+}
+
+bool is_periph_init_done(void)
+{
+    return periph_init_done;
 }
 
 static void uart_sd_check_line_callback(const char *line, void *user_data)
 {
     (void)user_data;
-    if (!line || board_sd_missing || !board_sd_check_pending) {
+    if (!line || !board_sd_check_pending) {
         return;
     }
 
@@ -49,27 +110,183 @@ static void uart_sd_check_line_callback(const char *line, void *user_data)
         strstr(line, "ESP_ERR_INVALID_RESPONSE") != NULL ||
         strstr(line, "Make sure SD card is properly inserted.") != NULL ||
         strstr(line, "Command returned non-zero error code") != NULL) {
-        board_sd_missing = true;
+        board_sd_check_failed = true;
         board_sd_check_pending = false;
     }
 }
 
+/**
+ * @brief Run list_sd and listen for JanOS's SD errors
+ * @return true if the board reported its card missing
+ */
+static bool check_board_sd(void)
+{
+    board_sd_check_failed = false;
+    board_sd_check_pending = true;
+    sd_listing_refresh(true);   // Primes the listing shared by the HTML pickers
+
+    int64_t start_ms = esp_timer_get_time() / 1000;
+    while (board_sd_check_pending &&
+           sd_listing_state() != SD_LISTING_READY &&
+           (esp_timer_get_time() / 1000 - start_ms) < BOARD_SD_CHECK_MS) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    board_sd_check_pending = false;
+    return board_sd_check_failed;
+}
+
+static void key_events_notify(void)
+{
+    app_events_post(APP_EVENT_KEY);
+}
+
+static void uart_line_notify(const char *line, void *user_data)
+{
+    (void)line;
+    (void)user_data;
+    app_events_post(APP_EVENT_UART);
+}
+
+static inline int64_t min_deadline(int64_t a, int64_t b)
+{
+    return a < b ? a : b;
+}
+
+/**
+ * @brief Optional peripherals, brought up while the home screen is already live
+ */
+static void periph_init_task(void *arg)
+{
+    (void)arg;
+    
+    ESP_LOGI(TAG, "Initializing battery monitoring...");
+    boot_profile_begin(BOOT_PHASE_BATTERY);
+    esp_err_t ret = battery_init();
+    boot_profile_end(BOOT_PHASE_BATTERY, ret == ESP_OK);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Battery monitoring initialization failed - battery indicator disabled");
+    }
+
+    ESP_LOGI(TAG, "Initializing screenshot module...");
+    boot_profile_begin(BOOT_PHASE_SD);
+    ret = screenshot_init();
+    boot_profile_end(BOOT_PHASE_SD, ret == ESP_OK);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Screenshot module initialization failed - screenshots disabled");
+    }
+    else if (watchlist_load() != ESP_OK) {
+        ESP_LOGW(TAG, "Watchlist unavailable - no alerts for watched devices");
+    }
+#ifdef CONFIG_STORE_SNAPSHOT
+    if (ret == ESP_OK && store_snapshot_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Store snapshots unavailable");
+    }
+#endif
+#ifdef CONFIG_SESSION_LOG
+    if (ret == ESP_OK && session_log_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Session log unavailable");
+    }
+#endif
+
+    ESP_LOGI(TAG, "Initializing buzzer...");
+    boot_profile_begin(BOOT_PHASE_BUZZER);
+    ret = buzzer_init();
+    boot_profile_end(BOOT_PHASE_BUZZER, ret == ESP_OK);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Buzzer initialization failed - audio disabled");
+    }
+
+    periph_init_done = true;
+    screen_manager_invalidate(NULL);    // Battery and SD badges
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Find the ESP32C5 board, then ask it about its SD card
+ */
+static void board_probe_task(void *arg)
+{
+    (void)arg;
+    
+    ESP_LOGI(TAG, "Checking for ESP32C5 board...");
+    boot_profile_begin(BOOT_PHASE_BOARD_PING);
+    int attempts = 0;
+    while (!uart_check_board_ping(BOARD_PING_TIMEOUT_MS)) {
+        if (attempts++ == 0) {
+            boot_profile_end(BOOT_PHASE_BOARD_PING, false);
+            board_probe_done = true;        // First miss: show the badge
+            screen_manager_invalidate(NULL);
+        }
+        vTaskDelay(pdMS_TO_TICKS(attempts < BOARD_RETRY_FAST_COUNT ?
+                                 BOARD_RETRY_MS : BOARD_RETRY_SLOW_MS));
+    }
+    
+    ESP_LOGI(TAG, "ESP32C5 board detected");
+    boot_profile_end(BOOT_PHASE_BOARD_PING, true);
+    board_detected = true;
+    board_probe_done = true;
+    screen_manager_invalidate(NULL);
+    
+    // A card seen last boot is checked straight away; JanOS may still be
+    // bringing it up, so a miss is only believed after the settle time
+    ESP_LOGI(TAG, "Checking Monster SD card via list_sd...");
+    bool optimistic = board_cache_sd() == BOARD_SD_PRESENT;
+    if (!optimistic) {
+        vTaskDelay(pdMS_TO_TICKS(BOARD_SD_SETTLE_MS));  // Let JanOS finish SD init before querying
+    }
+    bool missing = check_board_sd();
+    if (missing && optimistic) {
+        vTaskDelay(pdMS_TO_TICKS(BOARD_SD_SETTLE_MS));
+        missing = check_board_sd();
+    }
+    board_sd_missing = missing;
+    board_sd_verified = true;
+    board_cache_set_sd(missing ? BOARD_SD_MISSING : BOARD_SD_PRESENT);
+    screen_manager_invalidate(NULL);
+    app_events_post(APP_EVENT_TIMER);   // Main loop shows the SD popup
+    vTaskDelete(NULL);
+}
+
 void app_main(void)
 {
     ESP_LOGI(TAG, "Cardputer-ADV WiFi Attack Application Starting...");
 
+    // Scale the CPU down between frames and UART bursts
+    power_init();
+
+    // Task placement is fixed in task_plan.h; app_main is tracked from here
+    if (task_plan_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Periodic task stack report unavailable");
+    }
+    if (mem_monitor_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Heap monitor unavailable - low-memory callbacks run only on screen push");
+    }
+    mem_monitor_log_budget();
+
+    // Asset bundle (OUI registry, alert sounds) is optional: tables compiled
+    // into the app are used without it
+    assets_init();
+    oui_lookup_init();
+
     // Initialize settings (NVS)
     ESP_LOGI(TAG, "Initializing settings...");
+    boot_profile_begin(BOOT_PHASE_NVS);
     esp_err_t ret = settings_init();
+    boot_profile_end(BOOT_PHASE_NVS, ret == ESP_OK);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Settings initialization failed!");
         return;
     }
     ESP_LOGI(TAG, "Settings initialized successfully");
+    if (board_cache_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Board cache unavailable - every boot negotiates from scratch");
+    }
 
     // Initialize display
     ESP_LOGI(TAG, "Initializing display...");
+    boot_profile_begin(BOOT_PHASE_DISPLAY);
     ret = display_init();
+    boot_profile_end(BOOT_PHASE_DISPLAY, ret == ESP_OK);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Display initialization failed!");
         return;
@@ -79,125 +296,69 @@ void app_main(void)
     // Apply saved brightness setting
     display_set_backlight(settings_get_screen_brightness());
 
-    // Initialize battery monitoring
-    ESP_LOGI(TAG, "Initializing battery monitoring...");
-    ret = battery_init();
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Battery monitoring initialization failed - battery indicator disabled");
-        // Continue anyway - battery monitoring is optional
-    } else {
-        ESP_LOGI(TAG, "Battery monitoring initialized successfully");
-    }
-
-    // Initialize screenshot module (SD card)
-    ESP_LOGI(TAG, "Initializing screenshot module...");
-    ret = screenshot_init();
-    bool sd_card_missing = false;
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Screenshot module initialization failed - screenshots disabled");
-        sd_card_missing = true;
-        // Continue anyway - screenshots are optional
-    } else {
-        ESP_LOGI(TAG, "Screenshot module initialized successfully");
-    }
-
     // Initialize keyboard
     ESP_LOGI(TAG, "Initializing keyboard...");
+    boot_profile_begin(BOOT_PHASE_KEYBOARD);
     ret = keyboard_init();
+    boot_profile_end(BOOT_PHASE_KEYBOARD, ret == ESP_OK);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Keyboard initialization failed!");
         return;
     }
     ESP_LOGI(TAG, "Keyboard initialized successfully");
 
-    // SD card warning popup (after keyboard init so ESC works)
-    if (sd_card_missing) {
-        ESP_LOGW(TAG, "SD card not detected, showing popup...");
-        ui_clear();
-        ui_show_message("Warning", "SD card not detected");
-        display_flush();
-
-        // Wait up to 2 seconds or until ESC is pressed
-        for (int i = 0; i < 200; i++) {
-            keyboard_process();
-            if (keyboard_get_key() == KEY_ESC) {
-                ESP_LOGI(TAG, "SD card warning popup dismissed by user");
-                break;
-            }
-            vTaskDelay(pdMS_TO_TICKS(10));
-        }
-
-        ui_clear();
+    // Parsers publish from the first UART line on
+    if (event_bus_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Event bus unavailable - session log and deauth detector miss typed results");
     }
 
     // Initialize UART handler
     ESP_LOGI(TAG, "Initializing UART handler...");
+    boot_profile_begin(BOOT_PHASE_UART);
+    size_t mem_token = mem_scope_begin();
     ret = uart_handler_init();
+    mem_scope_end(MEM_SUB_UART, mem_token);
+    boot_profile_end(BOOT_PHASE_UART, ret == ESP_OK);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "UART handler initialization failed!");
         return;
     }
     ESP_LOGI(TAG, "UART handler initialized successfully");
     uart_register_monitor_callback(uart_sd_check_line_callback, NULL);
+    if (cred_store_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Credential store unavailable - live captures are not listed");
+    }
+    if (world_model_init() != ESP_OK) {
+        ESP_LOGW(TAG, "World model unavailable - BT, probe and handshake views stay empty");
+    }
+    if (metrics_store_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Metrics store unavailable - no counter graphs");
+    }
+#ifdef CONFIG_SURVEY_LINK
+    if (survey_link_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Survey link unavailable - results stay on this unit");
+    }
+#endif
 
-    // Board detection - check if ESP32C5 board is connected
-    ESP_LOGI(TAG, "Checking for ESP32C5 board...");
-    bool board_detected = uart_check_board_ping(500);
-    bool popup_dismissed = false;
-
-    if (!board_detected) {
-        ESP_LOGW(TAG, "Board not detected, showing popup...");
-        
-        // Show popup
-        ui_clear();
-        ui_show_message("Warning", "Board not detected");
-        display_flush();
-        
-        // Retry loop - ping every 1s until board detected or ESC pressed
-        while (!board_detected && !popup_dismissed) {
-            // Check for ESC key to dismiss popup
-            // Poll keyboard for ~1 second in small intervals
-            for (int i = 0; i < 100 && !popup_dismissed; i++) {
-                keyboard_process();
-                key_code_t key = keyboard_get_key();
-                if (key == KEY_ESC) {
-                    popup_dismissed = true;
-                    ESP_LOGI(TAG, "Board detection popup dismissed by user");
-                    break;
-                }
-                vTaskDelay(pdMS_TO_TICKS(10));
-            }
-            
-            // If not dismissed, try ping again
-            if (!popup_dismissed) {
-                board_detected = uart_check_board_ping(500);
-            }
-        }
-        
-        // Clear popup
-        ui_clear();
+    // Board probing and optional peripherals finish in the background;
+    // the home screen shows badges until they report in
+    if (xTaskCreatePinnedToCore(periph_init_task, "boot_periph", TASK_BOOT_STACK, NULL,
+                                TASK_BOOT_PRIO, NULL, TASK_BOOT_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start peripheral init task");
     }
-    
-    if (board_detected) {
-        ESP_LOGI(TAG, "ESP32C5 board detected");
-        ESP_LOGI(TAG, "Checking Monster SD card via list_sd...");
-        vTaskDelay(pdMS_TO_TICKS(1000));  // Let JanOS finish SD init before querying
-        board_sd_check_pending = true;
-        board_sd_check_start_ms = esp_timer_get_time() / 1000;
-        uart_send_command("list_sd");
-    } else {
-        ESP_LOGW(TAG, "Continuing without board detection");
+    if (xTaskCreatePinnedToCore(board_probe_task, "boot_probe", TASK_BOOT_STACK, NULL,
+                                TASK_BOOT_PRIO, NULL, TASK_BOOT_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start board probe task");
     }
 
-    // Initialize buzzer
-    ESP_LOGI(TAG, "Initializing buzzer...");
-    ret = buzzer_init();
+    // Main loop wake-ups: key interrupt, UART lines, timers
+    ret = app_events_init();
     if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Buzzer initialization failed - audio disabled");
-        // Continue anyway - buzzer is optional
-    } else {
-        ESP_LOGI(TAG, "Buzzer initialized successfully");
+        ESP_LOGW(TAG, "Event queue unavailable - main loop falls back to polling");
     }
+    bool key_irq = keyboard_set_notify_callback(key_events_notify);
+    uart_subscribe_link_lines(UART_LINK_MASK_ALL, UART_ROUTE_ANY, NULL, uart_line_notify, NULL);
+    const int key_poll_ms = key_irq ? KEY_IRQ_POLL_MS : KEY_POLL_MS;
 
     // Initialize screen manager
     ESP_LOGI(TAG, "Initializing screen manager...");
@@ -206,28 +367,60 @@ void app_main(void)
 
     // Push home screen as the initial screen
     ESP_LOGI(TAG, "Loading home screen...");
+    boot_profile_begin(BOOT_PHASE_FIRST_FRAME);     // Ended by the render task
     screen_manager_push(home_screen_create, NULL);
 
     ESP_LOGI(TAG, "Application started successfully!");
 
-    // Main loop - process keyboard input and periodic screen updates
-    int tick_counter = 0;
+    // Main loop - sleep until a key, UART line or timer event arrives or the
+    // next deadline (screen tick, key poll, screen timeout) is reached
     bool screen_dimmed = false;
     int64_t last_activity_time = esp_timer_get_time() / 1000;  // Convert to ms
+    int64_t next_tick = last_activity_time + screen_manager_get_tick_interval();
+    int64_t next_key_poll = last_activity_time;
+    int64_t last_uart_tick = 0;
     
     while (1) {
-        keyboard_process();
+        int64_t now = esp_timer_get_time() / 1000;
+        int64_t deadline = min_deadline(next_tick, next_key_poll);
+        int32_t repeat_ms = keyboard_repeat_due_ms();
+        if (repeat_ms >= 0) {
+            deadline = min_deadline(deadline, now + repeat_ms);
+        }
+        int32_t prefetch_ms = listing_prefetch_due_ms();
+        if (prefetch_ms >= 0) {
+            deadline = min_deadline(deadline, now + prefetch_ms);
+        }
+        uint32_t timeout = settings_get_screen_timeout_ms();
+        if (!screen_dimmed && timeout > 0) {
+            deadline = min_deadline(deadline, last_activity_time + timeout + 1);
+        }
+        app_event_t event = app_events_wait(deadline > now ? (uint32_t)(deadline - now) : 0);
+        int64_t loop_start_us = esp_timer_get_time();
         
-        // Check for any key activity
-        key_code_t key = keyboard_get_key();
-        if (key != KEY_NONE) {
+        // Key handlers, popups and ticks draw into the framebuffer under the
+        // UI lock; the render task pushes the result to the panel
+        screen_manager_lock();
+        now = esp_timer_get_time() / 1000;
+        if (event == APP_EVENT_KEY || now >= next_key_poll || keyboard_repeat_due_ms() == 0) {
+            keyboard_process();
+            next_key_poll = now + key_poll_ms;
+        }
+        
+        // Check for any key activity (screens already got keys via callback)
+        bool key_activity = false;
+        while (keyboard_get_key() != KEY_NONE) {
+            key_activity = true;
+        }
+        if (key_activity) {
             // Reset activity timer on any keypress
             last_activity_time = esp_timer_get_time() / 1000;
             
             // Wake screen if dimmed
             if (screen_dimmed) {
-                display_set_backlight(settings_get_screen_brightness());
+                display_set_backlight(power_governor_brightness());
                 screen_dimmed = false;
+                screen_manager_set_visible(true);
                 ESP_LOGI(TAG, "Screen woken by keypress");
             }
         }
@@ -235,7 +428,7 @@ void app_main(void)
         // SD card missing: show warning and allow ESC to continue
         if (board_sd_missing && !board_sd_popup_shown) {
             ESP_LOGW(TAG, "Board SD card not detected, showing popup...");
-            display_set_backlight(settings_get_screen_brightness());
+            display_set_backlight(power_governor_brightness());
             ui_clear();
             ui_show_message_tall("Warning",
                             "SD missing in MonsterC5\n"
@@ -264,31 +457,51 @@ void app_main(void)
             ui_clear();
             screen_manager_redraw();
             board_sd_popup_shown = true;
+            loop_start_us = esp_timer_get_time();   // Waiting for ESC is no stall
         }
 
-        // Stop listening for SD check after a short timeout
-        if (board_sd_check_pending) {
-            int64_t now_ms = esp_timer_get_time() / 1000;
-            if ((now_ms - board_sd_check_start_ms) > 3000) {
-                board_sd_check_pending = false;
-            }
-        }
-        
         // Check for screen timeout (0 = stays on, never dims)
-        uint32_t timeout = settings_get_screen_timeout_ms();
-        int64_t now = esp_timer_get_time() / 1000;
+        timeout = settings_get_screen_timeout_ms();
+        now = esp_timer_get_time() / 1000;
         if (!screen_dimmed && timeout > 0 && (now - last_activity_time) > timeout) {
             display_set_backlight(0);
             screen_dimmed = true;
+            screen_manager_set_visible(false);
             ESP_LOGI(TAG, "Screen dimmed due to inactivity");
         }
+
+        // A new power profile rescales the backlight
+        if (power_governor_service() && !screen_dimmed) {
+            display_set_backlight(power_governor_brightness());
+        }
         
-        // Call screen tick every 500ms (50 * 10ms) for responsive UI updates
-        if (++tick_counter >= 50) {
-            tick_counter = 0;
+        // Screen tick at the rate the current screen asked for; UART lines,
+        // timer and progress events can bring it forward
+        uint32_t tick_ms = screen_manager_get_tick_interval();
+        if (now >= next_tick) {
+            screen_manager_tick();
+            next_tick = now + tick_ms;
+        } else if (event == APP_EVENT_TIMER ||
+                   ((event == APP_EVENT_PROGRESS ||
+                     (event == APP_EVENT_UART && screen_manager_ticks_on_uart())) &&
+                    now - last_uart_tick >= UART_TICK_MIN_MS)) {
             screen_manager_tick();
+            last_uart_tick = now;
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(10));
+        // A newly opened screen with a faster tick should not wait out the old period
+        if (next_tick > now + tick_ms) {
+            next_tick = now + tick_ms;
+        }
+
+        watchlist_service();
+        job_manager_service();
+        listing_prefetch_service();
+#ifdef CONFIG_LINK_REFRESH
+        link_refresh_service();
+#endif
+
+        screen_manager_unlock();
+        screen_manager_request_frame();
+        stall_watch_record(STALL_SITE_LOOP, NULL, (uint32_t)(esp_timer_get_time() - loop_start_us));
     }
 }
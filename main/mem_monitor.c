@@ -0,0 +1,220 @@
+/**
+ * @file mem_monitor.c
+ * @brief Heap, fragmentation and per-subsystem memory monitor
+ */
+
+#include "mem_monitor.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "MEM";
+
+typedef struct {
+    mem_low_callback_t callback;
+    void *arg;
+} low_callback_t;
+
+static const char *const sub_names[MEM_SUB_COUNT] = {
+    [MEM_SUB_SCREENS] = "Screen",
+    [MEM_SUB_UART]    = "UART",
+    [MEM_SUB_GPS]     = "GPS",
+    [MEM_SUB_LOGGER]  = "Log",
+};
+
+static const char *const where_names[MEM_BUDGET_WHERE_COUNT] = {
+    [MEM_BUDGET_STATIC] = "static",
+    [MEM_BUDGET_HEAP]   = "heap",
+    [MEM_BUDGET_PSRAM]  = "psram",
+    [MEM_BUDGET_SCREEN] = "screen",
+};
+
+// Section bounds from SURROUND(mem_budget) in mem_monitor.lf
+extern const mem_budget_t _mem_budget_start;
+extern const mem_budget_t _mem_budget_end;
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static mem_monitor_stats_t stats;
+static low_callback_t low_callbacks[MEM_LOW_CALLBACKS_MAX];
+static int low_callback_count = 0;
+static esp_timer_handle_t sample_timer = NULL;
+
+/**
+ * @brief Read the heap into stats (returns whether a low episode started)
+ */
+static bool sample(void)
+{
+    uint32_t internal_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    uint32_t internal_largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    uint32_t internal_min = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    uint32_t internal_total = heap_caps_get_total_size(MALLOC_CAP_INTERNAL);
+    uint32_t dma_free = heap_caps_get_free_size(MALLOC_CAP_DMA);
+    uint32_t dma_largest = heap_caps_get_largest_free_block(MALLOC_CAP_DMA);
+
+    bool below = internal_free < MEM_LOW_FREE || internal_largest < MEM_LOW_BLOCK;
+    bool clear = internal_free >= MEM_LOW_FREE + MEM_LOW_HYSTERESIS &&
+                 internal_largest >= MEM_LOW_BLOCK + MEM_LOW_HYSTERESIS;
+    bool started = false;
+
+    portENTER_CRITICAL(&stats_lock);
+    stats.internal_free = internal_free;
+    stats.internal_largest = internal_largest;
+    stats.internal_min_free = internal_min;
+    stats.internal_total = internal_total;
+    stats.dma_free = dma_free;
+    stats.dma_largest = dma_largest;
+    stats.fragmentation_pct = internal_free ?
+        (uint8_t)(100 - (uint64_t)internal_largest * 100 / internal_free) : 0;
+    if (!stats.low && below) {
+        stats.low = true;
+        stats.low_events++;
+        started = true;
+    } else if (stats.low && clear) {
+        stats.low = false;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+    return started;
+}
+
+static void sample_timer_callback(void *arg)
+{
+    (void)arg;
+    if (!sample()) return;
+
+    mem_monitor_stats_t s;
+    mem_monitor_get_stats(&s);
+    ESP_LOGW(TAG, "Low memory: %luKB free, largest block %luKB",
+             (unsigned long)(s.internal_free / 1024), (unsigned long)(s.internal_largest / 1024));
+    size_t released = mem_monitor_reclaim();
+    if (released) {
+        ESP_LOGI(TAG, "Low-memory callbacks released %uB", (unsigned)released);
+    }
+}
+
+esp_err_t mem_monitor_init(void)
+{
+    if (sample_timer) return ESP_OK;
+    sample();
+
+    const esp_timer_create_args_t args = {
+        .callback = sample_timer_callback,
+        .name = "mem_monitor",
+        .skip_unhandled_events = true,
+    };
+    esp_err_t ret = esp_timer_create(&args, &sample_timer);
+    if (ret != ESP_OK) return ret;
+    return esp_timer_start_periodic(sample_timer, MEM_MONITOR_PERIOD_MS * 1000ULL);
+}
+
+esp_err_t mem_monitor_register_low_callback(mem_low_callback_t callback, void *arg)
+{
+    if (!callback) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t ret = ESP_OK;
+    portENTER_CRITICAL(&stats_lock);
+    if (low_callback_count < MEM_LOW_CALLBACKS_MAX) {
+        low_callbacks[low_callback_count++] = (low_callback_t){ callback, arg };
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+    return ret;
+}
+
+size_t mem_monitor_reclaim(void)
+{
+    // Entries are only ever appended, so the copy stays valid
+    portENTER_CRITICAL(&stats_lock);
+    int count = low_callback_count;
+    portEXIT_CRITICAL(&stats_lock);
+
+    size_t released = 0;
+    for (int i = 0; i < count; i++) {
+        released += low_callbacks[i].callback(low_callbacks[i].arg);
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    stats.reclaimed += released;
+    portEXIT_CRITICAL(&stats_lock);
+    return released;
+}
+
+void mem_monitor_get_stats(mem_monitor_stats_t *out)
+{
+    if (!out) return;
+    sample();
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void mem_monitor_account(mem_sub_t sub, int32_t bytes)
+{
+    if (sub >= MEM_SUB_COUNT || bytes == 0) return;
+    portENTER_CRITICAL(&stats_lock);
+    mem_sub_usage_t *u = &stats.subs[sub];
+    u->bytes += bytes;
+    if (u->bytes < 0) u->bytes = 0;     // Scope estimates can undercount
+    if (u->bytes > u->peak) u->peak = u->bytes;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+const char *mem_monitor_sub_name(mem_sub_t sub)
+{
+    return sub < MEM_SUB_COUNT ? sub_names[sub] : "?";
+}
+
+void *mem_malloc(mem_sub_t sub, size_t size)
+{
+    void *ptr = malloc(size);
+    if (ptr) mem_monitor_account(sub, (int32_t)heap_caps_get_allocated_size(ptr));
+    return ptr;
+}
+
+void *mem_calloc(mem_sub_t sub, size_t count, size_t size)
+{
+    void *ptr = calloc(count, size);
+    if (ptr) mem_monitor_account(sub, (int32_t)heap_caps_get_allocated_size(ptr));
+    return ptr;
+}
+
+void mem_free(mem_sub_t sub, void *ptr)
+{
+    if (!ptr) return;
+    mem_monitor_account(sub, -(int32_t)heap_caps_get_allocated_size(ptr));
+    free(ptr);
+}
+
+size_t mem_scope_begin(void)
+{
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+int32_t mem_scope_end(mem_sub_t sub, size_t token)
+{
+    size_t now = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    int32_t taken = token > now ? (int32_t)(token - now) : 0;
+    mem_monitor_account(sub, taken);
+    return taken;
+}
+
+void mem_monitor_log_budget(void)
+{
+    uint32_t totals[MEM_BUDGET_WHERE_COUNT] = { 0 };
+    
+    for (const mem_budget_t *b = &_mem_budget_start; b < &_mem_budget_end; b++) {
+        uint32_t bytes = b->count * b->entry_size;
+        uint32_t where = b->where < MEM_BUDGET_WHERE_COUNT ? b->where : MEM_BUDGET_HEAP;
+        totals[where] += bytes;
+        ESP_LOGD(TAG, "  %-22s %5lu x %4lu = %6lu B %s", b->name, (unsigned long)b->count,
+                 (unsigned long)b->entry_size, (unsigned long)bytes, where_names[where]);
+    }
+    ESP_LOGI(TAG, "Capacity budget: static %lu KB, heap %lu KB, psram %lu KB, screens %lu KB",
+             (unsigned long)(totals[MEM_BUDGET_STATIC] / 1024),
+             (unsigned long)(totals[MEM_BUDGET_HEAP] / 1024),
+             (unsigned long)(totals[MEM_BUDGET_PSRAM] / 1024),
+             (unsigned long)(totals[MEM_BUDGET_SCREEN] / 1024));
+}
@@ -0,0 +1,178 @@
+/**
+ * @file mem_monitor.h
+ * @brief Heap, fragmentation and per-subsystem memory monitor
+ *
+ * A periodic sample records free internal and DMA heap, the largest free
+ * block (what the next big allocation can actually get) and the lowest
+ * free heap seen since boot.
+ *
+ * Memory is attributed to subsystems two ways:
+ *   - tagged allocations (mem_malloc / mem_calloc / mem_free), counted
+ *     exactly by block size;
+ *   - scopes around init code (mem_scope_begin / mem_scope_end), counted
+ *     as the drop in free heap, which also covers driver buffers, queues
+ *     and task stacks allocated on the subsystem's behalf. Allocations of
+ *     other tasks in the window are counted too, as for screen memory.
+ *
+ * When free internal heap or the largest block drops below its threshold
+ * the registered low-memory callbacks run, once per episode, so caches can
+ * shrink before an allocation fails mid-attack.
+ *
+ * Capacity-driven buffers (the "M5MonsterC5 capacity" Kconfig menu) are
+ * declared next to their owners with MEM_BUDGET(): count, entry size and
+ * where they live, evaluated at compile time into the .mem_budget linker
+ * section. The table is logged at boot and read from the ELF after a
+ * build by tools/mem_budget.py (`idf.py mem_budget`).
+ */
+
+#ifndef MEM_MONITOR_H
+#define MEM_MONITOR_H
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef CONFIG_MEM_MONITOR_PERIOD_MS
+#define MEM_MONITOR_PERIOD_MS   CONFIG_MEM_MONITOR_PERIOD_MS
+#define MEM_LOW_FREE            (CONFIG_MEM_LOW_FREE_KB * 1024)
+#define MEM_LOW_BLOCK           (CONFIG_MEM_LOW_BLOCK_KB * 1024)
+#else
+#define MEM_MONITOR_PERIOD_MS   1000
+#define MEM_LOW_FREE            (32 * 1024)
+#define MEM_LOW_BLOCK           (12 * 1024)
+#endif
+
+// Low state ends once both figures are this much above their thresholds
+#define MEM_LOW_HYSTERESIS      (4 * 1024)
+
+#define MEM_LOW_CALLBACKS_MAX   4
+
+typedef enum {
+    MEM_SUB_SCREENS = 0,        // Screen user data and arena
+    MEM_SUB_UART,               // JanOS link driver, buffers, RX task
+    MEM_SUB_GPS,                // CAP GPS driver and task
+    MEM_SUB_LOGGER,             // Session and wardrive log writers
+    MEM_SUB_COUNT
+} mem_sub_t;
+
+typedef struct {
+    int32_t bytes;              // Attributed now
+    int32_t peak;               // Highest since boot
+} mem_sub_usage_t;
+
+typedef struct {
+    uint32_t internal_free;
+    uint32_t internal_largest;  // Largest free block
+    uint32_t internal_min_free; // Lowest free since boot
+    uint32_t internal_total;
+    uint32_t dma_free;
+    uint32_t dma_largest;
+    uint8_t fragmentation_pct;  // 100 - largest * 100 / free
+    bool low;                   // Below a threshold right now
+    uint32_t low_events;        // Low-memory episodes since boot
+    uint32_t reclaimed;         // Bytes released by callbacks since boot
+    mem_sub_usage_t subs[MEM_SUB_COUNT];
+} mem_monitor_stats_t;
+
+/**
+ * @brief Release memory when the heap runs low
+ * @param arg Registration argument
+ * @return Bytes released (approximate)
+ */
+typedef size_t (*mem_low_callback_t)(void *arg);
+
+/**
+ * @brief Start periodic sampling
+ * @return ESP_OK, or the esp_timer error
+ */
+esp_err_t mem_monitor_init(void);
+
+/**
+ * @brief Register a low-memory callback
+ *
+ * Callbacks run on the esp_timer task (or on the caller of
+ * mem_monitor_reclaim()) and must be quick and thread-safe.
+ * @return ESP_ERR_NO_MEM when MEM_LOW_CALLBACKS_MAX are registered
+ */
+esp_err_t mem_monitor_register_low_callback(mem_low_callback_t callback, void *arg);
+
+/**
+ * @brief Run every low-memory callback now
+ * @return Bytes released
+ */
+size_t mem_monitor_reclaim(void);
+
+/**
+ * @brief Sample the heap now and copy the statistics
+ */
+void mem_monitor_get_stats(mem_monitor_stats_t *out);
+
+/**
+ * @brief Add (or with a negative value, remove) bytes held by a subsystem
+ */
+void mem_monitor_account(mem_sub_t sub, int32_t bytes);
+
+/**
+ * @brief Short name of a subsystem (at most 6 characters)
+ */
+const char *mem_monitor_sub_name(mem_sub_t sub);
+
+void *mem_malloc(mem_sub_t sub, size_t size);
+void *mem_calloc(mem_sub_t sub, size_t count, size_t size);
+
+/**
+ * @brief Free a block from mem_malloc() / mem_calloc() of the same subsystem
+ */
+void mem_free(mem_sub_t sub, void *ptr);
+
+/**
+ * @brief Start measuring what a piece of init code allocates
+ * @return Token for mem_scope_end()
+ */
+size_t mem_scope_begin(void);
+
+/**
+ * @brief Attribute the heap taken since mem_scope_begin() to a subsystem
+ * @return Bytes attributed (0 if the heap grew meanwhile); give the
+ *         negated value to mem_monitor_account() when releasing
+ */
+int32_t mem_scope_end(mem_sub_t sub, size_t token);
+
+// Where a budgeted buffer lives
+typedef enum {
+    MEM_BUDGET_STATIC = 0,      // .bss / .data
+    MEM_BUDGET_HEAP,            // Internal heap, held from its module's start
+    MEM_BUDGET_PSRAM,           // Heap, PSRAM when the build has it
+    MEM_BUDGET_SCREEN,          // Heap while its screen is open
+    MEM_BUDGET_WHERE_COUNT
+} mem_budget_where_t;
+
+typedef struct {
+    const char *name;
+    uint32_t count;
+    uint32_t entry_size;
+    uint32_t where;             // mem_budget_where_t
+} mem_budget_t;
+
+/**
+ * @brief Declare a capacity-driven buffer (file scope, once per buffer)
+ * @param id C identifier, unique in the image
+ * @param count Entries (usually a capacity setting)
+ * @param entry_size Bytes per entry (sizeof)
+ * @param where mem_budget_where_t
+ */
+#define MEM_BUDGET(id, count, entry_size, where)                                    \
+    static const mem_budget_t mem_budget_##id                                       \
+        __attribute__((used, aligned(__alignof__(mem_budget_t)),                    \
+                       section(".mem_budget." #id))) = {                            \
+        #id, (count), (entry_size), (where)                                         \
+    }
+
+/**
+ * @brief Log the MEM_BUDGET table with totals per placement
+ */
+void mem_monitor_log_budget(void);
+
+#endif // MEM_MONITOR_H
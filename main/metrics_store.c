@@ -0,0 +1,225 @@
+/**
+ * @file metrics_store.c
+ * @brief Round-robin history of live counters for graphs
+ */
+
+#include "metrics_store.h"
+#include "event_bus.h"
+#include "network_store.h"
+#include "cred_store.h"
+#include "uart_handler.h"
+#include "battery.h"
+#include "mac_set.h"
+#include "mem_monitor.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "METRICS";
+
+#ifdef CONFIG_SPIRAM
+#define METRICS_CAPS    (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define METRICS_CAPS    (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+#define SAMPLE_PERIOD_US    1000000
+
+MEM_BUDGET(metrics_store, METRIC_COUNT * METRICS_POINTS, sizeof(metrics_point_t), MEM_BUDGET_PSRAM);
+
+static const char *const names[METRIC_COUNT] = {
+    [METRIC_APS]      = "APs",
+    [METRIC_CLIENTS]  = "Clients",
+    [METRIC_DEAUTHS]  = "Deauth/s",
+    [METRIC_CREDS]    = "Creds",
+    [METRIC_LINK_BPS] = "Link B/s",
+    [METRIC_HEAP_KB]  = "Heap KB",
+    [METRIC_BATTERY]  = "Battery %",
+};
+
+static const int ring_len[METRICS_RES_COUNT] = {
+    METRICS_RING_1S, METRICS_RING_10S, METRICS_RING_60S,
+};
+static const int ring_offset[METRICS_RES_COUNT] = {
+    0, METRICS_RING_1S, METRICS_RING_1S + METRICS_RING_10S,
+};
+static const int step_s[METRICS_RES_COUNT] = { 1, 10, 60 };
+
+// Seconds gathered toward the next point of a coarser ring
+typedef struct {
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    int n;
+} accum_t;
+
+static metrics_point_t *points = NULL;  // [metric][METRICS_POINTS], rings back to back
+static int head[METRICS_RES_COUNT];     // Next point written
+static int filled[METRICS_RES_COUNT];
+static accum_t accum[METRIC_COUNT][METRICS_RES_COUNT];
+static SemaphoreHandle_t store_mutex = NULL;
+static esp_timer_handle_t sample_timer = NULL;
+static volatile uint32_t generation = 0;
+
+// Sampler state (esp_timer task only)
+static mac_set_t stations;
+static int bus_handle = -1;
+static uint32_t last_link_bytes = 0;
+
+static void push(int metric, metrics_res_t res, const metrics_point_t *p)
+{
+    points[metric * METRICS_POINTS + ring_offset[res] + head[res]] = *p;
+}
+
+static void advance(metrics_res_t res)
+{
+    head[res] = (head[res] + 1) % ring_len[res];
+    if (filled[res] < ring_len[res]) filled[res]++;
+}
+
+/**
+ * @brief Add a second to the rings (store_mutex held)
+ */
+static void record(const int32_t *values)
+{
+    bool closed[METRICS_RES_COUNT] = { [METRICS_RES_1S] = true };
+    for (int m = 0; m < METRIC_COUNT; m++) {
+        metrics_point_t p = { values[m], values[m], values[m] };
+        push(m, METRICS_RES_1S, &p);
+
+        for (int r = METRICS_RES_10S; r < METRICS_RES_COUNT; r++) {
+            accum_t *a = &accum[m][r];
+            if (a->n == 0 || values[m] < a->min) a->min = values[m];
+            if (a->n == 0 || values[m] > a->max) a->max = values[m];
+            a->sum += values[m];
+            if (++a->n < step_s[r]) continue;
+            metrics_point_t c = { a->min, a->max, (int32_t)(a->sum / a->n) };
+            push(m, r, &c);
+            memset(a, 0, sizeof(*a));
+            closed[r] = true;
+        }
+    }
+    for (int r = 0; r < METRICS_RES_COUNT; r++) {
+        if (closed[r]) advance(r);
+    }
+}
+
+static void sample_timer_callback(void *arg)
+{
+    (void)arg;
+    int32_t values[METRIC_COUNT];
+
+    int deauths = 0;
+    bus_event_t event;
+    while (bus_handle >= 0 && event_bus_receive(bus_handle, &event, 0)) {
+        if (event.type == BUS_EVENT_DEAUTH_DETECTED) {
+            deauths++;
+        } else if (event.type == BUS_EVENT_STATION_SEEN) {
+            bool is_new;
+            mac_set_add(&stations, event.station.mac, &is_new);
+        }
+    }
+
+    int creds = 0;
+    for (int k = 0; k < CRED_KIND_COUNT; k++) creds += cred_store_count(k);
+
+    uart_link_stats_t link;
+    uart_get_link_stats(&link);
+    uint32_t link_bytes = link.rx_bytes + link.tx_bytes;
+    // Counters go back to zero on uart_reset_link_stats
+    uint32_t link_rate = link_bytes >= last_link_bytes ? link_bytes - last_link_bytes : link_bytes;
+    last_link_bytes = link_bytes;
+
+    values[METRIC_APS] = network_store_count();
+    values[METRIC_CLIENTS] = (int32_t)(stations.count + stations.evictions);
+    values[METRIC_DEAUTHS] = deauths;
+    values[METRIC_CREDS] = creds;
+    values[METRIC_LINK_BPS] = (int32_t)link_rate;
+    values[METRIC_HEAP_KB] = (int32_t)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024);
+    values[METRIC_BATTERY] = battery_get_level();
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    record(values);
+    xSemaphoreGive(store_mutex);
+    generation++;
+}
+
+esp_err_t metrics_store_init(void)
+{
+    if (points) return ESP_OK;
+
+    store_mutex = xSemaphoreCreateMutex();
+    if (!store_mutex) return ESP_ERR_NO_MEM;
+
+    size_t count = (size_t)METRIC_COUNT * METRICS_POINTS;
+    points = heap_caps_calloc(count, sizeof(metrics_point_t), METRICS_CAPS);
+    if (!points) points = calloc(count, sizeof(metrics_point_t));
+    if (!points || mac_set_init(&stations, METRICS_STATIONS) != ESP_OK) {
+        ESP_LOGE(TAG, "No memory for %u points", (unsigned)count);
+        free(points);
+        points = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    bus_handle = event_bus_subscribe(BUS_EVENT_BIT(BUS_EVENT_STATION_SEEN) |
+                                     BUS_EVENT_BIT(BUS_EVENT_DEAUTH_DETECTED),
+                                     METRICS_BUS_DEPTH, "metrics");
+    if (bus_handle < 0) {
+        ESP_LOGW(TAG, "No event bus slot - clients and deauths stay at zero");
+    }
+
+    uart_link_stats_t link;
+    uart_get_link_stats(&link);
+    last_link_bytes = link.rx_bytes + link.tx_bytes;
+
+    const esp_timer_create_args_t args = {
+        .callback = sample_timer_callback,
+        .name = "metrics",
+        .skip_unhandled_events = true,
+    };
+    esp_err_t ret = esp_timer_create(&args, &sample_timer);
+    if (ret != ESP_OK) return ret;
+    ESP_LOGI(TAG, "%d metrics, %u bytes of history", METRIC_COUNT,
+             (unsigned)(count * sizeof(metrics_point_t)));
+    return esp_timer_start_periodic(sample_timer, SAMPLE_PERIOD_US);
+}
+
+int metrics_store_read(metric_id_t id, metrics_res_t res, metrics_point_t *out, int max)
+{
+    if (!points || id >= METRIC_COUNT || res >= METRICS_RES_COUNT || max <= 0) return 0;
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    int n = filled[res] < max ? filled[res] : max;
+    const metrics_point_t *ring = &points[id * METRICS_POINTS + ring_offset[res]];
+    int start = head[res] - n;
+    if (start < 0) start += ring_len[res];
+    for (int i = 0; i < n; i++) {
+        out[i] = ring[(start + i) % ring_len[res]];
+    }
+    xSemaphoreGive(store_mutex);
+    return n;
+}
+
+uint32_t metrics_store_generation(void)
+{
+    return generation;
+}
+
+const char *metrics_store_name(metric_id_t id)
+{
+    return id < METRIC_COUNT ? names[id] : "?";
+}
+
+int metrics_store_step_s(metrics_res_t res)
+{
+    return res < METRICS_RES_COUNT ? step_s[res] : 0;
+}
+
+int metrics_store_ring_len(metrics_res_t res)
+{
+    return res < METRICS_RES_COUNT ? ring_len[res] : 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file metrics_store.h
+ * @brief Round-robin history of live counters for graphs
+ *
+ * Once a second every metric is sampled into a ring at 1 s resolution.
+ * The samples are also consolidated into rings at 10 s and 60 s: each
+ * point keeps the minimum, maximum and average of the seconds it covers.
+ * Rings overwrite their oldest point, so memory is fixed at build time
+ * (METRIC_COUNT x METRICS_POINTS points, allocated once) however long
+ * the session runs.
+ *
+ * Sources:
+ *   APs        networks in network_store
+ *   Clients    distinct stations from BUS_EVENT_STATION_SEEN, counted in
+ *              a METRICS_STATIONS set (a station evicted from a full set
+ *              and seen again counts twice)
+ *   Deauth/s   BUS_EVENT_DEAUTH_DETECTED reports in the second
+ *   Creds      captures in cred_store
+ *   Link B/s   bytes in and out of the JanOS link in the second
+ *   Heap KB    free internal heap
+ *   Battery    level in percent, -1 without a gauge
+ *
+ * The bus events are taken from a METRICS_BUS_DEPTH queue once a second;
+ * a burst beyond that is lost to the counts (event_bus stats show it).
+ * Sampling runs on the esp_timer task; readers copy under a mutex.
+ */
+
+#ifndef METRICS_STORE_H
+#define METRICS_STORE_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define METRICS_RING_1S         120     // 2 minutes
+#define METRICS_RING_10S        90      // 15 minutes
+#define METRICS_RING_60S        120     // 2 hours
+#define METRICS_POINTS          (METRICS_RING_1S + METRICS_RING_10S + METRICS_RING_60S)
+#define METRICS_STATIONS        512
+#define METRICS_BUS_DEPTH       16
+
+typedef enum {
+    METRIC_APS = 0,
+    METRIC_CLIENTS,
+    METRIC_DEAUTHS,
+    METRIC_CREDS,
+    METRIC_LINK_BPS,
+    METRIC_HEAP_KB,
+    METRIC_BATTERY,
+    METRIC_COUNT
+} metric_id_t;
+
+typedef enum {
+    METRICS_RES_1S = 0,
+    METRICS_RES_10S,
+    METRICS_RES_60S,
+    METRICS_RES_COUNT
+} metrics_res_t;
+
+typedef struct {
+    int32_t min;
+    int32_t max;
+    int32_t avg;
+} metrics_point_t;
+
+/**
+ * @brief Allocate the rings and start sampling (call after event_bus_init)
+ * @return ESP_OK, ESP_ERR_NO_MEM, or an esp_timer error
+ */
+esp_err_t metrics_store_init(void);
+
+/**
+ * @brief Copy the newest points of one ring, oldest first
+ * @param max Capacity of out
+ * @return Points copied (fewer until the ring has filled)
+ */
+int metrics_store_read(metric_id_t id, metrics_res_t res, metrics_point_t *out, int max);
+
+/**
+ * @brief Counter bumped once per sample
+ */
+uint32_t metrics_store_generation(void);
+
+const char *metrics_store_name(metric_id_t id);
+
+/**
+ * @brief Seconds per point of a resolution
+ */
+int metrics_store_step_s(metrics_res_t res);
+
+/**
+ * @brief Points a ring of a resolution holds
+ */
+int metrics_store_ring_len(metrics_res_t res);
+
+#endif // METRICS_STORE_H
@@ -0,0 +1,880 @@
+/**
+ * @file network_store.c
+ * @brief Shared store for WiFi scan results
+ */
+
+#include "network_store.h"
+#include "mem_monitor.h"
+#include "fixed_containers.h"
+#include "ssid_pool.h"
+#include "cap_gps.h"
+#include "time_sync.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+static const char *TAG = "NET_STORE";
+
+#ifdef CONFIG_NETWORK_STORE_PSRAM
+#define STORE_CAPS      (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define STORE_CAPS      (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+MEM_BUDGET(network_store, NETWORK_STORE_MAX,
+           sizeof(network_record_t) + sizeof(network_sighting_t) + sizeof(int64_t),
+           MEM_BUDGET_PSRAM);
+
+_Static_assert(sizeof(network_record_t) == 16, "network_record_t not packed");
+
+#define CHUNK_COUNT     ((NETWORK_STORE_MAX + NETWORK_STORE_CHUNK - 1) / NETWORK_STORE_CHUNK)
+
+static network_record_t *chunks[CHUNK_COUNT];
+static network_sighting_t *sighting_chunks[CHUNK_COUNT];  // Optional, NULL if allocation failed
+static int64_t *seen_chunks[CHUNK_COUNT];                 // Last row's arrival, optional too
+
+// One bit per record: selection lives only here, the rest mirror record fields
+#define BIT_WORDS       FIXED_BITS_WORDS(NETWORK_STORE_MAX)
+static uint32_t selected_bits[BIT_WORDS];
+static uint32_t stale_bits[BIT_WORDS];
+static uint32_t open_bits[BIT_WORDS];
+static uint32_t foreign_bits[BIT_WORDS];     // id is not the primary board's
+static uint32_t band_bits[WIFI_BAND_COUNT][BIT_WORDS];
+static volatile int record_count = 0;
+static volatile uint32_t generation = 0;
+static uint32_t pass = 0;                   // Pass in progress or last begun
+static volatile uint32_t passes_done = 0;
+
+// Changes of the pass in progress, and of the last completed one. A record
+// is logged at most once a pass: on its first sighting, or as gone at the end.
+static network_diff_t pending[NETWORK_DIFF_MAX];
+static int pending_count = 0;
+static int pending_dropped = 0;
+static network_diff_t last_diff[NETWORK_DIFF_MAX];
+static int last_count = 0;
+static int last_dropped = 0;
+
+// Open-addressed BSSID index, at most half full: record index + 1, 0 = empty
+static uint16_t *bssid_slots = NULL;
+static uint32_t hash_mask = 0;
+
+static SemaphoreHandle_t store_mutex = NULL;
+
+static void *store_alloc(size_t size)
+{
+    void *p = heap_caps_malloc(size, STORE_CAPS);
+    return p ? p : malloc(size);
+}
+
+/**
+ * @brief Parse "AA:BB:CC:DD:EE:FF" into bytes
+ * @return false if the text is not a MAC address
+ */
+static bool parse_bssid(const char *text, uint8_t mac[6])
+{
+    int digits = 0;
+    
+    memset(mac, 0, 6);
+    for (const char *p = text; *p; p++) {
+        char c = *p;
+        int v;
+        if (c >= '0' && c <= '9') v = c - '0';
+        else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+        else if (c == ':' || c == '-') continue;
+        else return false;
+        if (digits >= 12) return false;
+        mac[digits / 2] = (mac[digits / 2] << 4) | v;
+        digits++;
+    }
+    
+    return digits == 12;
+}
+
+/**
+ * @brief Log a change for the pass in progress (store_mutex held)
+ * @param old Record before the change, for its RSSI and channel
+ */
+static void log_change(int index, const network_record_t *old, uint8_t changes)
+{
+    if (pending_count >= NETWORK_DIFF_MAX) {
+        pending_dropped++;
+        return;
+    }
+    
+    network_diff_t *d = &pending[pending_count];
+    d->index = (uint16_t)index;
+    d->changes = changes;
+    d->old_channel = old ? old->channel : 0;
+    d->old_rssi = old ? old->rssi : 0;
+    pending_count++;
+}
+
+static uint32_t hash_bssid(const uint8_t mac[6])
+{
+    uint64_t key = 0;
+    for (int i = 0; i < 6; i++) key = (key << 8) | mac[i];
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & hash_mask;
+}
+
+static network_record_t *record_at(int index)
+{
+    return &chunks[index / NETWORK_STORE_CHUNK][index % NETWORK_STORE_CHUNK];
+}
+
+// Case-insensitive substring search (needle already lower-case)
+static bool contains_nocase(const char *haystack, const char *needle)
+{
+    size_t n = strlen(needle);
+    for (const char *h = haystack; *h; h++) {
+        size_t i = 0;
+        while (i < n && h[i] && tolower((unsigned char)h[i]) == needle[i]) i++;
+        if (i == n) return true;
+    }
+    return n == 0;
+}
+
+/**
+ * @brief Mirror a record's band and security into the bitsets (store_mutex held)
+ */
+static void put_attribute_bits(int index, const network_record_t *rec)
+{
+    for (int band = 0; band < WIFI_BAND_COUNT; band++) {
+        fixed_bits_put(band_bits[band], index, rec->band == band);
+    }
+    fixed_bits_put(open_bits, index, rec->security == WIFI_SECURITY_OPEN);
+    fixed_bits_put(foreign_bits, index,
+                   rec->flags & (NETWORK_FLAG_SECOND | NETWORK_FLAG_REMOTE | NETWORK_FLAG_RESTORED));
+    fixed_bits_put(stale_bits, index, false);
+}
+
+static void note_seen(int index, int64_t time_us)
+{
+    int64_t *chunk = seen_chunks[index / NETWORK_STORE_CHUNK];
+    if (chunk) chunk[index % NETWORK_STORE_CHUNK] = time_us;
+}
+
+static network_sighting_t *sighting_at(int index)
+{
+    network_sighting_t *chunk = sighting_chunks[index / NETWORK_STORE_CHUNK];
+    return chunk ? &chunk[index % NETWORK_STORE_CHUNK] : NULL;
+}
+
+/**
+ * @brief Keep the position of the strongest row heard with a fix (store_mutex held)
+ */
+static void note_sighting(int index, int8_t rssi, const network_sighting_t *where)
+{
+    network_sighting_t *s = sighting_at(index);
+    if (!s || !where) return;
+    
+    if (s->fixes == 0 || rssi > s->rssi) {
+        s->lat_e7 = where->lat_e7;
+        s->lon_e7 = where->lon_e7;
+        s->rssi = rssi;
+    }
+    if (s->fixes < UINT16_MAX) s->fixes++;
+}
+
+/**
+ * @brief Find the BSSID slot holding mac, or the empty slot where it goes
+ */
+static uint32_t find_bssid_slot(const uint8_t mac[6])
+{
+    uint32_t slot = hash_bssid(mac);
+    while (bssid_slots[slot] &&
+           memcmp(record_at(bssid_slots[slot] - 1)->bssid, mac, 6) != 0) {
+        slot = (slot + 1) & hash_mask;
+    }
+    return slot;
+}
+
+esp_err_t network_store_init(void)
+{
+    if (bssid_slots) return ESP_OK;
+    
+    uint32_t size = 1;
+    while (size < 2 * NETWORK_STORE_MAX) size <<= 1;
+    
+    bssid_slots = store_alloc(size * sizeof(uint16_t));
+    store_mutex = xSemaphoreCreateMutex();
+    if (!bssid_slots || !store_mutex || ssid_pool_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate network store index");
+        return ESP_ERR_NO_MEM;
+    }
+    hash_mask = size - 1;
+    network_store_clear();
+    
+    ESP_LOGI(TAG, "Network store ready (up to %d networks, %u bytes each)",
+             NETWORK_STORE_MAX, (unsigned)sizeof(network_record_t));
+    return ESP_OK;
+}
+
+void network_store_clear(void)
+{
+    if (!store_mutex) return;
+    
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    int count = record_count;
+    record_count = 0;
+    for (int i = 0; i < count; i++) {
+        ssid_pool_release(record_at(i)->ssid);
+    }
+    memset(bssid_slots, 0, (hash_mask + 1) * sizeof(uint16_t));
+    pass = 0;
+    passes_done = 0;
+    pending_count = pending_dropped = 0;
+    last_count = last_dropped = 0;
+    memset(selected_bits, 0, sizeof(selected_bits));
+    memset(stale_bits, 0, sizeof(stale_bits));
+    generation++;
+    xSemaphoreGive(store_mutex);
+}
+
+int network_store_count(void)
+{
+    return record_count;
+}
+
+uint32_t network_store_generation(void)
+{
+    return generation;
+}
+
+const network_record_t* network_store_record(int index)
+{
+    if (index < 0 || index >= record_count) return NULL;
+    return record_at(index);
+}
+
+const char* network_store_ssid(const network_record_t *rec)
+{
+    return rec ? ssid_pool_str(rec->ssid) : "";
+}
+
+bool network_store_get(int index, wifi_network_t *network)
+{
+    const network_record_t *rec = network_store_record(index);
+    if (!rec || !network) return false;
+    
+    memset(network, 0, sizeof(*network));
+    network->id = rec->id;
+    snprintf(network->ssid, sizeof(network->ssid), "%s", ssid_pool_str(rec->ssid));
+    network_format_bssid(rec->bssid, network->bssid, sizeof(network->bssid));
+    network->channel = rec->channel;
+    snprintf(network->security, sizeof(network->security), "%s",
+             network_security_name(rec->security));
+    network->rssi = rec->rssi;
+    snprintf(network->band, sizeof(network->band), "%s", network_band_name(rec->band));
+    network->selected = fixed_bits_test(selected_bits, index);
+    network->link = (rec->flags & NETWORK_FLAG_SECOND) ? UART_LINK_SECONDARY : UART_LINK_PRIMARY;
+    return true;
+}
+
+void network_store_set_selected(int index, bool selected)
+{
+    if (index < 0 || index >= record_count) return;
+    
+    // Locked so a clear from the RX task cannot race the change
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    fixed_bits_put(selected_bits, index, selected);
+    xSemaphoreGive(store_mutex);
+}
+
+bool network_store_is_selected(int index)
+{
+    return index >= 0 && index < record_count && fixed_bits_test(selected_bits, index);
+}
+
+void network_store_select_all(bool selected)
+{
+    if (!store_mutex) return;
+    
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    for (int w = 0; w < FIXED_BITS_WORDS(record_count); w++) {
+        selected_bits[w] = selected ? fixed_bits_live_mask(w, record_count) : 0;
+    }
+    xSemaphoreGive(store_mutex);
+}
+
+void network_store_select_invert(void)
+{
+    if (!store_mutex) return;
+    
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    for (int w = 0; w < FIXED_BITS_WORDS(record_count); w++) {
+        selected_bits[w] = ~selected_bits[w] & fixed_bits_live_mask(w, record_count);
+    }
+    xSemaphoreGive(store_mutex);
+}
+
+int network_store_select_matching(const network_filter_t *filter, bool selected)
+{
+    if (!store_mutex) return 0;
+    
+    char needle[MAX_SSID_LEN] = "";
+    if (filter) {
+        int n = 0;
+        for (; filter->name[n] && n < (int)sizeof(needle) - 1; n++) {
+            needle[n] = tolower((unsigned char)filter->name[n]);
+        }
+        needle[n] = '\0';
+    }
+    
+    int matched = 0;
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    for (int w = 0; w < FIXED_BITS_WORDS(record_count); w++) {
+        uint32_t mask = fixed_bits_live_mask(w, record_count);
+        if (filter && filter->band != WIFI_BAND_UNKNOWN) mask &= band_bits[filter->band][w];
+        if (filter && filter->open_only) mask &= open_bits[w];
+        if (filter && filter->hide_stale) mask &= ~stale_bits[w];
+        
+        // Names are the one test that needs the records
+        for (uint32_t rest = needle[0] ? mask : 0; rest; rest &= rest - 1) {
+            int bit = __builtin_ctz(rest);
+            if (!contains_nocase(ssid_pool_str(record_at(w * 32 + bit)->ssid), needle)) {
+                mask &= ~(1u << bit);
+            }
+        }
+        
+        selected_bits[w] = selected ? (selected_bits[w] | mask) : (selected_bits[w] & ~mask);
+        matched += __builtin_popcount(mask);
+    }
+    xSemaphoreGive(store_mutex);
+    return matched;
+}
+
+int network_store_target_count(void)
+{
+    if (!store_mutex) return 0;
+    
+    int count = 0;
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    for (int w = 0; w < FIXED_BITS_WORDS(record_count); w++) {
+        count += __builtin_popcount(selected_bits[w] & ~stale_bits[w] & ~foreign_bits[w] &
+                                    fixed_bits_live_mask(w, record_count));
+    }
+    xSemaphoreGive(store_mutex);
+    return count;
+}
+
+static int compare_ids(int a, int b, void *ctx)
+{
+    (void)ctx;
+    return a - b;
+}
+
+int network_store_target_ids(uint16_t *ids, int max)
+{
+    if (!ids || !store_mutex) return 0;
+    
+    int count = 0;
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    for (int w = 0; w < FIXED_BITS_WORDS(record_count) && count < max; w++) {
+        uint32_t word = selected_bits[w] & ~stale_bits[w] & ~foreign_bits[w] &
+                        fixed_bits_live_mask(w, record_count);
+        for (; word && count < max; word &= word - 1) {
+            ids[count++] = record_at(w * 32 + __builtin_ctz(word))->id;
+        }
+    }
+    xSemaphoreGive(store_mutex);
+    
+    // Rescans renumber JanOS ids, so store order is not id order
+    fixed_index_sort(ids, count, compare_ids, NULL);
+    return count;
+}
+
+void network_store_begin_pass(void)
+{
+    if (!store_mutex) return;
+    
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    pass++;
+    pending_count = pending_dropped = 0;    // Drop what an aborted pass logged
+    for (int i = 0; i < record_count; i++) {
+        record_at(i)->flags &= ~NETWORK_FLAG_NEW;
+    }
+    xSemaphoreGive(store_mutex);
+}
+
+int network_store_end_pass(void)
+{
+    if (!store_mutex) return 0;
+    
+    int aged = 0;
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    for (int i = 0; i < record_count; i++) {
+        network_record_t *rec = record_at(i);
+        uint8_t missed = (uint8_t)pass - rec->seen_pass;
+        if (missed == 1) log_change(i, rec, NETWORK_DIFF_GONE);
+        if (missed >= NETWORK_STORE_STALE_PASSES && !(rec->flags & NETWORK_FLAG_STALE)) {
+            rec->flags |= NETWORK_FLAG_STALE;
+            fixed_bits_put(stale_bits, i, true);
+            aged++;
+        }
+    }
+    
+    // Publish this pass's changes; the next pass starts an empty log
+    memcpy(last_diff, pending, pending_count * sizeof(pending[0]));
+    last_count = pending_count;
+    last_dropped = pending_dropped;
+    pending_count = pending_dropped = 0;
+    passes_done++;
+    xSemaphoreGive(store_mutex);
+    return aged;
+}
+
+uint32_t network_store_passes(void)
+{
+    return passes_done;
+}
+
+bool network_store_is_stale(int index)
+{
+    const network_record_t *rec = network_store_record(index);
+    return rec && (rec->flags & NETWORK_FLAG_STALE);
+}
+
+bool network_store_sighting(int index, network_sighting_t *out)
+{
+    if (!out || !network_store_record(index)) return false;
+    
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    const network_sighting_t *s = sighting_at(index);
+    bool found = s && s->fixes > 0;
+    if (found) *out = *s;
+    xSemaphoreGive(store_mutex);
+    return found;
+}
+
+int64_t network_store_seen_us(int index)
+{
+    if (!network_store_record(index)) return 0;
+    
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    const int64_t *chunk = seen_chunks[index / NETWORK_STORE_CHUNK];
+    int64_t time_us = chunk ? chunk[index % NETWORK_STORE_CHUNK] : 0;
+    xSemaphoreGive(store_mutex);
+    return time_us;
+}
+
+int network_store_diff(network_diff_t *out, int max, int *dropped)
+{
+    if (!out || !store_mutex) return 0;
+    
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    int n = last_count < max ? last_count : max;
+    memcpy(out, last_diff, n * sizeof(out[0]));
+    if (dropped) *dropped = last_dropped + (last_count - n);
+    xSemaphoreGive(store_mutex);
+    return n;
+}
+
+/**
+ * @brief Fill the next free record (store_mutex held)
+ *
+ * Readers cannot see it until publish_record().
+ * @return Record index, or -1 if the store is full or out of memory
+ */
+static int append_record(const network_record_t *rec, bool selected)
+{
+    int index = record_count;
+    if (index >= NETWORK_STORE_MAX) return -1;
+    
+    network_record_t **chunk = &chunks[index / NETWORK_STORE_CHUNK];
+    if (!*chunk) {
+        *chunk = store_alloc(NETWORK_STORE_CHUNK * sizeof(network_record_t));
+        if (!*chunk) {
+            ESP_LOGW(TAG, "Out of memory at %d networks", index);
+            return -1;
+        }
+        sighting_chunks[index / NETWORK_STORE_CHUNK] =
+            store_alloc(NETWORK_STORE_CHUNK * sizeof(network_sighting_t));
+        seen_chunks[index / NETWORK_STORE_CHUNK] =
+            store_alloc(NETWORK_STORE_CHUNK * sizeof(int64_t));
+    }
+    
+    *record_at(index) = *rec;
+    put_attribute_bits(index, rec);
+    fixed_bits_put(selected_bits, index, selected);
+    network_sighting_t *sighting = sighting_at(index);
+    if (sighting) memset(sighting, 0, sizeof(*sighting));    // Slot reused after a clear
+    return index;
+}
+
+/**
+ * @brief Make an appended record visible (store_mutex held)
+ * @param slot Its empty BSSID slot, -1 without a BSSID
+ */
+static void publish_record(int index, int64_t slot)
+{
+    if (slot >= 0) {
+        bssid_slots[slot] = index + 1;
+    }
+    __sync_synchronize();   // Record is complete before readers can see it
+    record_count = index + 1;
+    generation++;
+}
+
+/**
+ * @brief Add or refresh a record; where is the position to file it under
+ *
+ * A remote row (another unit's) refreshes only the sighting of a record
+ * this unit's boards listed, so their id and fields stay authoritative.
+ */
+static int add_row(const wifi_network_t *network, const network_sighting_t *where, bool remote)
+{
+    network_record_t rec = {
+        .id = (uint16_t)network->id,
+        .rssi = (int8_t)(network->rssi < -128 ? -128 : (network->rssi > 127 ? 127 : network->rssi)),
+        .channel = (uint8_t)network->channel,
+        .security = network_security_from_name(network->security),
+        .band = network_band_from_name(network->band),
+        .flags = remote ? NETWORK_FLAG_REMOTE :
+                 (network->link == UART_LINK_SECONDARY) ? NETWORK_FLAG_SECOND : 0,
+    };
+    bool has_bssid = parse_bssid(network->bssid, rec.bssid);
+    int8_t fix_rssi = (remote && where) ? where->rssi : rec.rssi;   // Loudness at the position
+    int64_t seen_us = remote ? time_sync_now_us() : uart_line_time_us();
+    
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    
+    if (remote && has_bssid) {
+        uint32_t slot = find_bssid_slot(rec.bssid);
+        int index = bssid_slots[slot] - 1;
+        if (index >= 0 &&
+            !(record_at(index)->flags & (NETWORK_FLAG_REMOTE | NETWORK_FLAG_RESTORED))) {
+            note_sighting(index, fix_rssi, where);
+            generation++;
+            xSemaphoreGive(store_mutex);
+            return index;
+        }
+    }
+    
+    int ssid = ssid_pool_acquire(network->ssid);
+    if (ssid < 0) {
+        xSemaphoreGive(store_mutex);
+        ESP_LOGW(TAG, "SSID pool full at %d networks", record_count);
+        return -1;
+    }
+    rec.ssid = (ssid_handle_t)ssid;
+    rec.seen_pass = (uint8_t)pass;
+    
+    uint32_t slot = 0;
+    if (has_bssid) {
+        slot = find_bssid_slot(rec.bssid);
+        if (bssid_slots[slot]) {
+            // Seen before: refresh in place, keep index and selection
+            int index = bssid_slots[slot] - 1;
+            network_record_t *old = record_at(index);
+            rec.flags |= old->flags & ~(NETWORK_FLAG_STALE | NETWORK_FLAG_SECOND |
+                                        NETWORK_FLAG_REMOTE | NETWORK_FLAG_RESTORED);
+            
+            // First sighting this pass: compare with the last one
+            uint8_t missed = rec.seen_pass - old->seen_pass;
+            if (missed > 0 && passes_done > 0) {
+                uint8_t changes = 0;
+                if (missed > 1) changes |= NETWORK_DIFF_BACK;
+                if (abs(rec.rssi - old->rssi) >= NETWORK_DIFF_RSSI_DB) changes |= NETWORK_DIFF_RSSI;
+                if (rec.channel != old->channel) changes |= NETWORK_DIFF_CHANNEL;
+                if (changes) log_change(index, old, changes);
+            }
+            ssid_pool_release(old->ssid);
+            *old = rec;
+            put_attribute_bits(index, old);
+            note_sighting(index, fix_rssi, where);
+            note_seen(index, seen_us);
+            generation++;
+            xSemaphoreGive(store_mutex);
+            return index;
+        }
+    }
+    
+    // Only a rescan can turn up something new
+    if (passes_done > 0) rec.flags |= NETWORK_FLAG_NEW;
+    
+    int index = append_record(&rec, network->selected);
+    if (index < 0) {
+        ssid_pool_release(rec.ssid);
+        xSemaphoreGive(store_mutex);
+        return -1;
+    }
+    note_sighting(index, fix_rssi, where);
+    note_seen(index, seen_us);
+    publish_record(index, has_bssid ? (int64_t)slot : -1);
+    if (rec.flags & NETWORK_FLAG_NEW) log_change(index, NULL, NETWORK_DIFF_NEW);
+    
+    xSemaphoreGive(store_mutex);
+    return index;
+}
+
+int network_store_add(const wifi_network_t *network)
+{
+    if (!network || !store_mutex) return -1;
+    
+    // Position to file the row under, if the CAP GPS has a current fix
+    cap_gps_snapshot_t snapshot;
+    network_sighting_t here = {0};
+    const network_sighting_t *where = NULL;
+    if (cap_gps_get_snapshot(&snapshot) && snapshot.fix &&
+        snapshot.fix_age_ms < NETWORK_SIGHTING_FIX_MS) {
+        here.lat_e7 = snapshot.lat_e7;
+        here.lon_e7 = snapshot.lon_e7;
+        where = &here;
+    }
+    return add_row(network, where, false);
+}
+
+int network_store_add_remote(const wifi_network_t *network, const network_sighting_t *where)
+{
+    if (!network || !store_mutex) return -1;
+    return add_row(network, (where && where->fixes) ? where : NULL, true);
+}
+
+int network_store_restore(const network_record_t *rec, const char *ssid,
+                          const network_sighting_t *where)
+{
+    static const uint8_t no_bssid[6] = {0};
+    if (!rec || !store_mutex) return -1;
+    
+    network_record_t restored = *rec;
+    restored.flags = NETWORK_FLAG_RESTORED;
+    bool has_bssid = memcmp(rec->bssid, no_bssid, 6) != 0;
+    
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    
+    // A board that listed the BSSID already has the newer row
+    uint32_t slot = 0;
+    if (has_bssid) {
+        slot = find_bssid_slot(rec->bssid);
+        if (bssid_slots[slot]) {
+            xSemaphoreGive(store_mutex);
+            return -1;
+        }
+    }
+    
+    int handle = ssid_pool_acquire(ssid ? ssid : "");
+    if (handle < 0) {
+        xSemaphoreGive(store_mutex);
+        return -1;
+    }
+    restored.ssid = (ssid_handle_t)handle;
+    restored.seen_pass = (uint8_t)pass;
+    
+    int index = append_record(&restored, false);
+    if (index < 0) {
+        ssid_pool_release(restored.ssid);
+        xSemaphoreGive(store_mutex);
+        return -1;
+    }
+    network_sighting_t *s = sighting_at(index);
+    if (s && where && where->fixes) *s = *where;
+    note_seen(index, 0);
+    publish_record(index, has_bssid ? (int64_t)slot : -1);
+    
+    xSemaphoreGive(store_mutex);
+    return index;
+}
+
+int network_store_find(const char *bssid)
+{
+    uint8_t mac[6];
+    if (!bssid || !store_mutex || !parse_bssid(bssid, mac)) return -1;
+    
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    uint32_t slot = find_bssid_slot(mac);
+    int index = bssid_slots[slot] ? bssid_slots[slot] - 1 : -1;
+    xSemaphoreGive(store_mutex);
+    return index;
+}
+
+int network_store_find_ssid(const char *ssid, int channel)
+{
+    if (!ssid || !ssid[0] || !store_mutex) return -1;
+    
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    
+    // Records hold pool handles, so after one hash lookup the scan is integer compares
+    int handle = ssid_pool_find(ssid);
+    
+    int best = -1;
+    if (handle > 0) {
+        for (int i = 0; i < record_count; i++) {
+            const network_record_t *rec = record_at(i);
+            if (rec->ssid != handle || (channel > 0 && rec->channel != channel)) continue;
+            if (best < 0 || rec->rssi > record_at(best)->rssi) best = i;
+        }
+    }
+    
+    xSemaphoreGive(store_mutex);
+    return best;
+}
+
+static int compare_ssid(const network_record_t *a, const network_record_t *b)
+{
+    // Hidden networks sort after named ones
+    if (!a->ssid || !b->ssid) {
+        return (a->ssid ? 0 : 1) - (b->ssid ? 0 : 1);
+    }
+    return (a->ssid == b->ssid) ? 0 : strcasecmp(ssid_pool_str(a->ssid), ssid_pool_str(b->ssid));
+}
+
+int network_store_compare(int ia, int ib, network_sort_t key)
+{
+    const network_record_t *a = record_at(ia);
+    const network_record_t *b = record_at(ib);
+    int r = 0;
+    
+    switch (key) {
+        case NETWORK_SORT_RSSI:
+            r = b->rssi - a->rssi;
+            break;
+        case NETWORK_SORT_CHANNEL:
+            r = a->channel - b->channel;
+            if (r == 0) r = b->rssi - a->rssi;
+            break;
+        case NETWORK_SORT_SSID:
+            r = compare_ssid(a, b);
+            break;
+        case NETWORK_SORT_SECURITY:
+            r = a->security - b->security;
+            if (r == 0) r = b->rssi - a->rssi;
+            break;
+        default:
+            break;
+    }
+    
+    // Stable: ties keep arrival order
+    return r ? r : ia - ib;
+}
+
+bool network_store_matches(int index, const network_filter_t *filter)
+{
+    const network_record_t *rec = network_store_record(index);
+    if (!rec) return false;
+    if (!filter) return true;
+    
+    if (filter->hide_stale && (rec->flags & NETWORK_FLAG_STALE) &&
+        !fixed_bits_test(selected_bits, index)) {
+        return false;
+    }
+    if (filter->band != WIFI_BAND_UNKNOWN && rec->band != filter->band) return false;
+    if (filter->open_only && rec->security != WIFI_SECURITY_OPEN) return false;
+    if (filter->name[0]) {
+        char needle[MAX_SSID_LEN];
+        int n = 0;
+        for (; filter->name[n] && n < (int)sizeof(needle) - 1; n++) {
+            needle[n] = tolower((unsigned char)filter->name[n]);
+        }
+        needle[n] = '\0';
+        if (!contains_nocase(ssid_pool_str(rec->ssid), needle)) return false;
+    }
+    return true;
+}
+
+int network_store_compare_ctx(int ia, int ib, void *key)
+{
+    return network_store_compare(ia, ib, *(const network_sort_t *)key);
+}
+
+void network_store_sort(uint16_t *order, int count, network_sort_t key)
+{
+    fixed_index_sort(order, count, network_store_compare_ctx, &key);
+}
+
+// Display names, indexed by wifi_security_t
+static const char *security_names[WIFI_SECURITY_COUNT] = {
+    [WIFI_SECURITY_UNKNOWN]   = "Unknown",
+    [WIFI_SECURITY_OPEN]      = "Open",
+    [WIFI_SECURITY_WEP]       = "WEP",
+    [WIFI_SECURITY_WPA]       = "WPA",
+    [WIFI_SECURITY_WPA2]      = "WPA2",
+    [WIFI_SECURITY_WPA_WPA2]  = "WPA/WPA2",
+    [WIFI_SECURITY_WPA2_ENT]  = "WPA2-Ent",
+    [WIFI_SECURITY_WPA3]      = "WPA3",
+    [WIFI_SECURITY_WPA2_WPA3] = "WPA2/WPA3",
+    [WIFI_SECURITY_WPA3_ENT]  = "WPA3-Ent",
+    [WIFI_SECURITY_WAPI]      = "WAPI",
+    [WIFI_SECURITY_OWE]       = "OWE",
+};
+
+// JanOS spellings, compared upper-case with separators removed
+static const struct {
+    const char *name;
+    wifi_security_t security;
+} security_aliases[] = {
+    { "OPEN",           WIFI_SECURITY_OPEN },
+    { "NONE",           WIFI_SECURITY_OPEN },
+    { "WEP",            WIFI_SECURITY_WEP },
+    { "WPA",            WIFI_SECURITY_WPA },
+    { "WPAPSK",         WIFI_SECURITY_WPA },
+    { "WPA2",           WIFI_SECURITY_WPA2 },
+    { "WPA2PSK",        WIFI_SECURITY_WPA2 },
+    { "WPAWPA2",        WIFI_SECURITY_WPA_WPA2 },
+    { "WPAWPA2PSK",     WIFI_SECURITY_WPA_WPA2 },
+    { "WPA2ENT",        WIFI_SECURITY_WPA2_ENT },
+    { "WPA2ENTERPRISE", WIFI_SECURITY_WPA2_ENT },
+    { "WPAENTERPRISE",  WIFI_SECURITY_WPA2_ENT },
+    { "WPA3",           WIFI_SECURITY_WPA3 },
+    { "WPA3PSK",        WIFI_SECURITY_WPA3 },
+    { "WPA3SAE",        WIFI_SECURITY_WPA3 },
+    { "WPA2WPA3",       WIFI_SECURITY_WPA2_WPA3 },
+    { "WPA2WPA3PSK",    WIFI_SECURITY_WPA2_WPA3 },
+    { "WPA3ENT",        WIFI_SECURITY_WPA3_ENT },
+    { "WPA3ENTERPRISE", WIFI_SECURITY_WPA3_ENT },
+    { "WPA3ENT192",     WIFI_SECURITY_WPA3_ENT },
+    { "WAPI",           WIFI_SECURITY_WAPI },
+    { "WAPIPSK",        WIFI_SECURITY_WAPI },
+    { "OWE",            WIFI_SECURITY_OWE },
+};
+
+wifi_security_t network_security_from_name(const char *name)
+{
+    char key[MAX_SECURITY_LEN];
+    int n = 0;
+    
+    for (const char *p = name; p && *p && n < (int)sizeof(key) - 1; p++) {
+        if (isalnum((unsigned char)*p)) {
+            key[n++] = toupper((unsigned char)*p);
+        }
+    }
+    key[n] = '\0';
+    
+    for (size_t i = 0; i < sizeof(security_aliases) / sizeof(security_aliases[0]); i++) {
+        if (strcmp(key, security_aliases[i].name) == 0) {
+            return security_aliases[i].security;
+        }
+    }
+    return WIFI_SECURITY_UNKNOWN;
+}
+
+const char* network_security_name(wifi_security_t security)
+{
+    return (security < WIFI_SECURITY_COUNT) ? security_names[security] : security_names[0];
+}
+
+wifi_band_t network_band_from_name(const char *name)
+{
+    if (!name) return WIFI_BAND_UNKNOWN;
+    if (strncmp(name, "2.4", 3) == 0 || name[0] == '2') return WIFI_BAND_2G;
+    if (name[0] == '5') return WIFI_BAND_5G;
+    if (name[0] == '6') return WIFI_BAND_6G;
+    return WIFI_BAND_UNKNOWN;
+}
+
+const char* network_band_name(wifi_band_t band)
+{
+    static const char *names[WIFI_BAND_COUNT] = { "", "2.4GHz", "5GHz", "6GHz" };
+    return (band < WIFI_BAND_COUNT) ? names[band] : names[0];
+}
+
+void network_format_bssid(const uint8_t mac[6], char *out, size_t out_size)
+{
+    snprintf(out, out_size, "%02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
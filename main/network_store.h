@@ -0,0 +1,386 @@
+/**
+ * @file network_store.h
+ * @brief Shared store for WiFi scan results
+ *
+ * Records are packed (network_record_t, 16 bytes) and live in fixed-size
+ * chunks allocated on demand (PSRAM when CONFIG_NETWORK_STORE_PSRAM), so a
+ * record's address never changes while the store grows. SSIDs are interned
+ * in ssid_pool, shared with the other stores. A BSSID hash
+ * index dedupes rows in O(1). Text is produced only when a record is
+ * rendered or expanded into a wifi_network_t.
+ *
+ * Rescans that keep the store run as passes: each record remembers the
+ * last pass that saw it, records first seen after the first pass are
+ * flagged NEW for one pass, and records missed by NETWORK_STORE_STALE_PASSES
+ * passes in a row are flagged STALE until seen again. Records are never
+ * removed between clears, so indices held by views stay valid.
+ *
+ * The differences a pass found (new, back, gone, RSSI or channel moved)
+ * are logged as records change, not by comparing whole scans, and
+ * published when the pass ends (network_store_diff()).
+ *
+ * Rows heard while the CAP GPS has a fix also file a position: a side
+ * array beside each chunk keeps where each record was loudest. Another
+ * keeps when each record's last row arrived (time_sync timebase).
+ *
+ * Selection is one bit per record, with band, open and STALE mirrored
+ * into bitsets beside it, so select all, invert and select-by-filter work
+ * a word (32 records) at a time; only a name filter looks at records.
+ *
+ * Records are added by the UART RX tasks (one per board) and the
+ * survey_link RX task; adds are serialised, and readers on other tasks
+ * may use any index below network_store_count(). Passes follow the primary board's scans; a
+ * second board's rows count as seen in the current pass, and a record
+ * takes its JanOS id from whichever board listed it last.
+ *
+ * Rows other Cardputers heard (survey_link) are merged by BSSID too: one
+ * this unit's boards listed only gains the remote position, any other is
+ * kept as a REMOTE record until a local board lists it. Records saved
+ * before a reboot (store_snapshot) come back the same way, as RESTORED.
+ */
+
+#ifndef NETWORK_STORE_H
+#define NETWORK_STORE_H
+
+#include "uart_handler.h"
+#include "ssid_pool.h"
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef CONFIG_NETWORK_STORE_MAX_ENTRIES
+#define NETWORK_STORE_MAX       CONFIG_NETWORK_STORE_MAX_ENTRIES
+#else
+#define NETWORK_STORE_MAX       512
+#endif
+
+#define NETWORK_STORE_CHUNK     32      // Records per allocation
+
+#ifdef CONFIG_WIFI_STALE_SCANS
+#define NETWORK_STORE_STALE_PASSES  CONFIG_WIFI_STALE_SCANS
+#else
+#define NETWORK_STORE_STALE_PASSES  3
+#endif
+
+#ifdef CONFIG_WIFI_DIFF_RSSI_DB
+#define NETWORK_DIFF_RSSI_DB    CONFIG_WIFI_DIFF_RSSI_DB
+#else
+#define NETWORK_DIFF_RSSI_DB    10
+#endif
+#define NETWORK_DIFF_MAX        256     // Changes kept per pass
+
+// Change kinds in network_diff_t.changes
+#define NETWORK_DIFF_NEW        0x01    // First seen (after the first pass)
+#define NETWORK_DIFF_BACK       0x02    // Seen again after missing a pass
+#define NETWORK_DIFF_GONE       0x04    // Seen by the previous pass, missed by this one
+#define NETWORK_DIFF_RSSI       0x08    // RSSI moved by NETWORK_DIFF_RSSI_DB or more
+#define NETWORK_DIFF_CHANNEL    0x10    // Channel changed
+
+// Security as reported by JanOS (names in network_security_name())
+typedef enum {
+    WIFI_SECURITY_UNKNOWN = 0,
+    WIFI_SECURITY_OPEN,
+    WIFI_SECURITY_WEP,
+    WIFI_SECURITY_WPA,
+    WIFI_SECURITY_WPA2,
+    WIFI_SECURITY_WPA_WPA2,
+    WIFI_SECURITY_WPA2_ENT,
+    WIFI_SECURITY_WPA3,
+    WIFI_SECURITY_WPA2_WPA3,
+    WIFI_SECURITY_WPA3_ENT,
+    WIFI_SECURITY_WAPI,
+    WIFI_SECURITY_OWE,
+    WIFI_SECURITY_COUNT
+} wifi_security_t;
+
+typedef enum {
+    WIFI_BAND_UNKNOWN = 0,
+    WIFI_BAND_2G,
+    WIFI_BAND_5G,
+    WIFI_BAND_6G,
+    WIFI_BAND_COUNT
+} wifi_band_t;
+
+// Record flags; selection is kept in a bitset (network_store_select_*)
+#define NETWORK_FLAG_NEW        0x02    // First seen in the latest pass (not the first)
+#define NETWORK_FLAG_STALE      0x04    // Missed by the last NETWORK_STORE_STALE_PASSES passes
+#define NETWORK_FLAG_SECOND     0x08    // id is the second board's (UART_LINK_SECONDARY)
+#define NETWORK_FLAG_REMOTE     0x10    // Only another unit heard it (survey_link), no id
+#define NETWORK_FLAG_RESTORED   0x20    // From the boot snapshot (store_snapshot), no id
+
+// Packed scan record
+typedef struct {
+    uint8_t bssid[6];
+    ssid_handle_t ssid;     // ssid_pool handle, SSID_NONE = hidden
+    uint16_t id;            // JanOS network index
+    int8_t rssi;
+    uint8_t channel;
+    uint8_t security;       // wifi_security_t
+    uint8_t band;           // wifi_band_t
+    uint8_t flags;          // NETWORK_FLAG_*
+    uint8_t seen_pass;      // Low byte of the last pass that saw it
+} network_record_t;
+
+// One record's change between two passes
+typedef struct {
+    uint16_t index;         // Record index
+    uint8_t changes;        // NETWORK_DIFF_*
+    uint8_t old_channel;    // Before the pass (RSSI / CHANNEL changes)
+    int8_t old_rssi;
+} network_diff_t;
+
+// Where a record was heard loudest while the CAP GPS had a fix
+typedef struct {
+    int32_t lat_e7;         // Degrees x 1e7
+    int32_t lon_e7;
+    int8_t rssi;            // RSSI at that position
+    uint16_t fixes;         // Rows heard with a fix, 0 = never (rest unset)
+} network_sighting_t;
+
+#define NETWORK_SIGHTING_FIX_MS 2000    // Older GPS positions are not used
+
+// Sort keys for network_store_sort()
+typedef enum {
+    NETWORK_SORT_ARRIVAL = 0,   // Scan order
+    NETWORK_SORT_RSSI,          // Strongest first
+    NETWORK_SORT_CHANNEL,       // Ascending channel, then RSSI
+    NETWORK_SORT_SSID,          // Case-insensitive, hidden networks last
+    NETWORK_SORT_SECURITY,      // Weakest first, then RSSI
+    NETWORK_SORT_COUNT
+} network_sort_t;
+
+// Row filter for network_store_matches(); zeroed = everything
+typedef struct {
+    wifi_band_t band;           // WIFI_BAND_UNKNOWN = any band
+    bool open_only;
+    bool hide_stale;            // Skip STALE records unless selected
+    char name[MAX_SSID_LEN];    // Case-insensitive SSID substring, "" = any
+} network_filter_t;
+
+/**
+ * @brief Allocate the hash indices (records are allocated as they arrive)
+ * @return ESP_OK on success
+ */
+esp_err_t network_store_init(void);
+
+/**
+ * @brief Forget all records (chunks are kept for reuse)
+ */
+void network_store_clear(void);
+
+/**
+ * @brief Number of records in the store
+ */
+int network_store_count(void);
+
+/**
+ * @brief Counter bumped on every add, refresh and clear
+ */
+uint32_t network_store_generation(void);
+
+/**
+ * @brief Start a scan pass: clears last pass's NEW flags (RX task)
+ */
+void network_store_begin_pass(void);
+
+/**
+ * @brief End a scan pass and age out records it missed (RX task)
+ * @return Records that turned STALE
+ */
+int network_store_end_pass(void);
+
+/**
+ * @brief Passes completed since the last clear
+ */
+uint32_t network_store_passes(void);
+
+/**
+ * @brief Check a record's STALE flag
+ */
+bool network_store_is_stale(int index);
+
+/**
+ * @brief GPS position of a record's strongest row heard with a fix
+ * @return false if it was never heard with a fix
+ */
+bool network_store_sighting(int index, network_sighting_t *out);
+
+/**
+ * @brief When a record's last row arrived (uart_line_time_us)
+ * @return Monotonic us, 0 if unknown
+ */
+int64_t network_store_seen_us(int index);
+
+/**
+ * @brief Changes found by the last completed pass, in the order found
+ * @param out Receives up to max entries
+ * @param max Size of out
+ * @param dropped Receives changes beyond NETWORK_DIFF_MAX (may be NULL)
+ * @return Entries written
+ */
+int network_store_diff(network_diff_t *out, int max, int *dropped);
+
+/**
+ * @brief Get a packed record by arrival index
+ * @param index 0 .. network_store_count() - 1
+ * @return Record (stable until the next clear), NULL if out of range
+ */
+const network_record_t* network_store_record(int index);
+
+/**
+ * @brief SSID of a record ("" for hidden networks)
+ */
+const char* network_store_ssid(const network_record_t *rec);
+
+/**
+ * @brief Expand a record into the text form used by the attack screens
+ * @return false if index is out of range
+ */
+bool network_store_get(int index, wifi_network_t *network);
+
+/**
+ * @brief Mark a record selected for an attack
+ */
+void network_store_set_selected(int index, bool selected);
+
+/**
+ * @brief Check a record's selection bit
+ */
+bool network_store_is_selected(int index);
+
+/**
+ * @brief Select or clear every record
+ */
+void network_store_select_all(bool selected);
+
+/**
+ * @brief Flip the selection of every record
+ */
+void network_store_select_invert(void);
+
+/**
+ * @brief Select or clear the records a filter shows
+ *
+ * hide_stale leaves STALE records alone whatever their selection.
+ * @return Records the filter matched
+ */
+int network_store_select_matching(const network_filter_t *filter, bool selected);
+
+/**
+ * @brief Selected records that are not STALE (attack targets)
+ *
+ * Records last listed by the second board, and REMOTE and RESTORED
+ * records, are left out: their id means nothing to the primary, which
+ * runs the attacks.
+ */
+int network_store_target_count(void);
+
+/**
+ * @brief JanOS ids of the attack targets, ascending
+ * @param ids Receives up to max ids
+ * @return Ids written
+ */
+int network_store_target_ids(uint16_t *ids, int max);
+
+/**
+ * @brief Add a record, or update the existing one with the same BSSID
+ *
+ * An update keeps the record's index and selection flag.
+ * @param network Parsed network
+ * @return Record index, or -1 if the store or SSID pool is full
+ */
+int network_store_add(const wifi_network_t *network);
+
+/**
+ * @brief Merge a row another unit heard (survey_link)
+ *
+ * Any task may call this. A record listed by this unit's boards keeps
+ * its fields and only files the position; otherwise the row is added or
+ * refreshed as a REMOTE record.
+ * @param network Row (id is ignored for attacks)
+ * @param where Position it was heard loudest, NULL or fixes 0 = none
+ * @return Record index, or -1 if the store or SSID pool is full
+ */
+int network_store_add_remote(const wifi_network_t *network, const network_sighting_t *where);
+
+/**
+ * @brief Put back a record saved before a reboot (store_snapshot)
+ *
+ * The record is flagged RESTORED: like a REMOTE one it is shown but not
+ * attacked, since its id is from an earlier JanOS scan, until a board
+ * lists the BSSID again. A BSSID already in the store is left alone.
+ * @param rec Saved record (ssid, flags and seen_pass are ignored)
+ * @param ssid SSID text, "" for hidden
+ * @param where Saved loudest position, NULL or fixes 0 = none
+ * @return Record index, or -1 if present, full or out of memory
+ */
+int network_store_restore(const network_record_t *rec, const char *ssid,
+                          const network_sighting_t *where);
+
+/**
+ * @brief Look up a record by BSSID
+ * @param bssid "AA:BB:CC:DD:EE:FF" (case-insensitive)
+ * @return Record index, or -1 if not present
+ */
+int network_store_find(const char *bssid);
+
+/**
+ * @brief Look up a record by SSID, for screens that know a network by name
+ *
+ * Several BSSIDs may share the name (mesh, multi-band); the strongest on
+ * the channel wins. The record's id is the JanOS index for
+ * select_networks, valid until the next scan clears the store.
+ * @param ssid Exact SSID (hidden networks cannot be found)
+ * @param channel Channel to match, 0 = any
+ * @return Record index, or -1 if not present
+ */
+int network_store_find_ssid(const char *ssid, int channel);
+
+/**
+ * @brief Compare two records by index for a sort key
+ * @return <0, 0 or >0; ties fall back to arrival order
+ */
+int network_store_compare(int a, int b, network_sort_t key);
+
+/**
+ * @brief network_store_compare as a fixed_index_cmp_t
+ * @param key Points to the network_sort_t
+ */
+int network_store_compare_ctx(int a, int b, void *key);
+
+/**
+ * @brief Check a record against a filter
+ */
+bool network_store_matches(int index, const network_filter_t *filter);
+
+/**
+ * @brief Sort an array of record indices
+ *
+ * Only the index array is permuted; records stay where they are.
+ * @param order Record indices to sort in place
+ * @param count Number of entries in order
+ * @param key Sort key
+ */
+void network_store_sort(uint16_t *order, int count, network_sort_t key);
+
+/**
+ * @brief Map a JanOS security string ("WPA2_PSK", "wpa2-psk", ...) to the enum
+ */
+wifi_security_t network_security_from_name(const char *name);
+const char* network_security_name(wifi_security_t security);
+
+/**
+ * @brief Map a JanOS band string ("2.4GHz", "5GHz", ...) to the enum
+ */
+wifi_band_t network_band_from_name(const char *name);
+const char* network_band_name(wifi_band_t band);
+
+/**
+ * @brief Format a MAC as "AA:BB:CC:DD:EE:FF"
+ * @param out At least MAX_BSSID_LEN bytes
+ */
+void network_format_bssid(const uint8_t mac[6], char *out, size_t out_size);
+
+#endif // NETWORK_STORE_H
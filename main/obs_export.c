@@ -0,0 +1,1111 @@
+/**
+ * @file obs_export.c
+ * @brief Stream logged observations out in formats other tools read as-is
+ *
+ * The task reads the source one block (wardrive) or one record (session
+ * log) at a time, turns each into an obs_t and hands it to the format's
+ * writer, which fills a small output buffer; full buffers go to the sink.
+ * Tracks are not observations: their points go straight to the GPX writer.
+ */
+
+#include "obs_export.h"
+#include "wardrive_log.h"
+#include "track_log.h"
+#include "session_log.h"
+#include "session_file.h"
+#include "janos_proto.h"
+#include "time_sync.h"
+#include "sd_io.h"
+#include "usb_bridge.h"
+#include "usb_msc.h"
+#include "screen_mirror.h"
+#include "task_plan.h"
+#include "mem_monitor.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "driver/usb_serial_jtag.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+
+static const char *TAG = "OBS_EXPORT";
+
+#ifdef CONFIG_SPIRAM
+#define EXPORT_CAPS     (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define EXPORT_CAPS     (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+#define MWD_PAYLOAD_MAX     (32 * 1024)     // Larger blocks are corrupt
+#define MTK_PAYLOAD_MAX     (5 + TRACK_LOG_BLOCK_POINTS * (5 * 5 + 1))
+#define USB_RING_SIZE       4096
+#define PACKET_MAX          128             // Radiotap + one synthesized frame
+
+// pcapng (draft-ietf-opsawg-pcapng)
+#define PCAPNG_SHB              0x0A0D0D0A
+#define PCAPNG_IDB              0x00000001
+#define PCAPNG_EPB              0x00000006
+#define PCAPNG_BYTE_ORDER       0x1A2B3C4D
+#define PCAPNG_OPT_END          0
+#define PCAPNG_OPT_USERAPPL     4
+#define PCAPNG_OPT_CUSTOM_BIN   2989        // Copyable custom binary option
+#define LINKTYPE_RADIOTAP       127
+
+// Kismet's GPS custom option: PPI-style fixed point fields
+#define KISMET_PEN              55922
+#define KISMET_GPS_MAGIC        0x47
+#define KISMET_GPS_VERSION      1
+#define KISMET_GPS_LON          0x02
+#define KISMET_GPS_LAT          0x04
+#define KISMET_GPS_ALT          0x08
+#define KISMET_GPS_OPTION_LEN   (4 + 8 + 12)   // PEN, header, three fields
+
+static const char *const format_names[OBS_EXPORT_FORMAT_COUNT] = {
+    [OBS_EXPORT_KISMET] = "Kismet",
+    [OBS_EXPORT_WIGLE]  = "WiGLE",
+    [OBS_EXPORT_PCAPNG] = "pcapng",
+    [OBS_EXPORT_GPX]    = "GPX",
+};
+
+static const char *const format_ext[OBS_EXPORT_FORMAT_COUNT] = {
+    [OBS_EXPORT_KISMET] = "jsonl",
+    [OBS_EXPORT_WIGLE]  = "csv",
+    [OBS_EXPORT_PCAPNG] = "pcapng",
+    [OBS_EXPORT_GPX]    = "gpx",
+};
+
+typedef enum {
+    OBS_AP = 0,
+    OBS_CLIENT,
+    OBS_BLE,
+} obs_kind_t;
+
+// One observation, whatever the source
+typedef struct {
+    obs_kind_t kind;
+    uint8_t mac[6];
+    char name[WARDRIVE_LOG_SSID_MAX_LEN + 1];   // SSID, or BLE name
+    char auth[WARDRIVE_LOG_AUTH_MAX_LEN];
+    int channel;                    // 0 if unknown
+    int rssi;                       // 0 if unknown
+    int64_t time_us;                // UTC, or since boot if !utc
+    bool utc;
+    bool located;
+    int32_t lat_e7;
+    int32_t lon_e7;
+    int32_t alt_dm;
+    uint32_t acc_dm;
+} obs_t;
+
+// Wardrive file: dictionaries and one decoded block of columns
+typedef struct {
+    FILE *f;
+    uint16_t bssid_slots;
+    uint16_t ssid_slots;
+    uint8_t auth_slots;
+    uint8_t (*bssids)[6];
+    char (*ssids)[WARDRIVE_LOG_SSID_MAX_LEN + 1];
+    char (*auths)[WARDRIVE_LOG_AUTH_MAX_LEN];
+    uint8_t *payload;
+    uint32_t time[WARDRIVE_LOG_BLOCK_ROWS];
+    int32_t lat[WARDRIVE_LOG_BLOCK_ROWS];
+    int32_t lon[WARDRIVE_LOG_BLOCK_ROWS];
+    int32_t alt[WARDRIVE_LOG_BLOCK_ROWS];
+    uint32_t acc[WARDRIVE_LOG_BLOCK_ROWS];
+    uint16_t bssid[WARDRIVE_LOG_BLOCK_ROWS];
+    uint16_t ssid[WARDRIVE_LOG_BLOCK_ROWS];
+    uint8_t auth[WARDRIVE_LOG_BLOCK_ROWS];
+    uint8_t channel[WARDRIVE_LOG_BLOCK_ROWS];
+    int8_t rssi[WARDRIVE_LOG_BLOCK_ROWS];
+} mwd_reader_t;
+
+// Track file: one decoded block of columns
+typedef struct {
+    FILE *f;
+    uint8_t payload[MTK_PAYLOAD_MAX];
+    int64_t time_ms[TRACK_LOG_BLOCK_POINTS];    // Unix milliseconds
+    int32_t lat[TRACK_LOG_BLOCK_POINTS];
+    int32_t lon[TRACK_LOG_BLOCK_POINTS];
+    int32_t alt[TRACK_LOG_BLOCK_POINTS];
+    uint32_t hdop[TRACK_LOG_BLOCK_POINTS];
+    uint8_t flags[TRACK_LOG_BLOCK_POINTS];
+} mtk_reader_t;
+
+// Bounded cursor over a block payload
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool bad;
+} cursor_t;
+
+typedef struct {
+    obs_export_format_t format;
+    obs_export_sink_t sink;
+    mwd_reader_t *mwd;              // Wardrive source, or
+    mtk_reader_t *mtk;              // track source, or
+    session_file_reader_t *session; // session log source
+    bool session_current;           // The log being written now: times convert to UTC
+    sd_file_t *file;                // SD sink
+    uint8_t out[OBS_EXPORT_OUT_BUFFER];
+    size_t out_len;
+    bool out_failed;
+} export_job_t;
+
+static obs_export_progress_t progress;
+static volatile bool cancel_requested = false;
+static export_job_t *job = NULL;
+
+/* ---------------------------------------------------------------- Output */
+
+static void out_flush(export_job_t *j)
+{
+    if (j->out_len == 0 || j->out_failed) {
+        j->out_len = 0;
+        return;
+    }
+    if (j->sink == OBS_EXPORT_TO_USB) {
+        int sent = usb_serial_jtag_write_bytes(j->out, j->out_len,
+                                               pdMS_TO_TICKS(OBS_EXPORT_USB_TIMEOUT_MS));
+        j->out_failed = sent != (int)j->out_len;
+    } else {
+        j->out_failed = sd_io_write(j->file, j->out, j->out_len) != ESP_OK;
+    }
+    progress.bytes += j->out_len;
+    j->out_len = 0;
+}
+
+static void out_bytes(export_job_t *j, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    while (len > 0) {
+        size_t room = sizeof(j->out) - j->out_len;
+        size_t n = len < room ? len : room;
+        memcpy(j->out + j->out_len, p, n);
+        j->out_len += n;
+        p += n;
+        len -= n;
+        if (j->out_len == sizeof(j->out)) out_flush(j);
+    }
+}
+
+static void out_str(export_job_t *j, const char *s)
+{
+    out_bytes(j, s, strlen(s));
+}
+
+static void out_printf(export_job_t *j, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static void out_printf(export_job_t *j, const char *fmt, ...)
+{
+    char text[128];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    if (len > 0) out_bytes(j, text, len < (int)sizeof(text) ? (size_t)len : sizeof(text) - 1);
+}
+
+static void out_u16(export_job_t *j, uint16_t v)
+{
+    uint8_t b[2] = { v & 0xFF, v >> 8 };
+    out_bytes(j, b, sizeof(b));
+}
+
+static void out_u32(export_job_t *j, uint32_t v)
+{
+    uint8_t b[4] = { v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF, v >> 24 };
+    out_bytes(j, b, sizeof(b));
+}
+
+static void out_pad4(export_job_t *j, size_t len)
+{
+    static const uint8_t zeros[3] = { 0 };
+    out_bytes(j, zeros, (4 - (len & 3)) & 3);
+}
+
+/* ------------------------------------------------------------ Formatting */
+
+static void format_mac(char out[18], const uint8_t mac[6])
+{
+    snprintf(out, 18, "%02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+static bool parse_mac(const char *s, uint8_t mac[6])
+{
+    unsigned int b[6];
+    if (sscanf(s, "%2x:%2x:%2x:%2x:%2x:%2x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) mac[i] = (uint8_t)b[i];
+    return true;
+}
+
+/**
+ * @brief Fixed point value ("-12.3456789" for 7 decimals), no floats
+ */
+static void format_fixed(char *out, size_t size, int32_t value, int decimals)
+{
+    uint32_t scale = 1;
+    for (int i = 0; i < decimals; i++) scale *= 10;
+    uint32_t magnitude = value < 0 ? (uint32_t)-(int64_t)value : (uint32_t)value;
+    snprintf(out, size, "%s%lu.%0*lu", value < 0 ? "-" : "", (unsigned long)(magnitude / scale),
+             decimals, (unsigned long)(magnitude % scale));
+}
+
+/**
+ * @brief Whether an auth string names any encryption
+ */
+static bool auth_protected(const char *auth)
+{
+    static const char *const marks[] = { "WEP", "WPA", "SAE", "PSK", "EAP", "OWE" };
+    char upper[WARDRIVE_LOG_AUTH_MAX_LEN];
+    size_t i = 0;
+    for (; auth[i] && i < sizeof(upper) - 1; i++) upper[i] = (char)toupper((unsigned char)auth[i]);
+    upper[i] = '\0';
+    for (size_t m = 0; m < sizeof(marks) / sizeof(marks[0]); m++) {
+        if (strstr(upper, marks[m])) return true;
+    }
+    return false;
+}
+
+static int channel_mhz(int channel)
+{
+    if (channel == 14) return 2484;
+    if (channel >= 1 && channel <= 13) return 2407 + 5 * channel;
+    return 5000 + 5 * channel;
+}
+
+/* ------------------------------------------------------------ Kismet JSON */
+
+static void json_string(export_job_t *j, const char *s)
+{
+    out_str(j, "\"");
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            char esc[2] = { '\\', (char)c };
+            out_bytes(j, esc, 2);
+        } else if (c < 0x20) {
+            out_printf(j, "\\u%04x", c);
+        } else {
+            out_bytes(j, &c, 1);
+        }
+    }
+    out_str(j, "\"");
+}
+
+static void kismet_row(export_job_t *j, const obs_t *o)
+{
+    static const char *const types[] = {
+        [OBS_AP] = "Wi-Fi AP", [OBS_CLIENT] = "Wi-Fi Client", [OBS_BLE] = "BTLE",
+    };
+    char mac[18];
+    format_mac(mac, o->mac);
+    out_printf(j, "{\"kismet.device.base.macaddr\":\"%s\"", mac);
+    out_printf(j, ",\"kismet.device.base.phyname\":\"%s\"",
+               o->kind == OBS_BLE ? "Bluetooth" : "IEEE802.11");
+    out_printf(j, ",\"kismet.device.base.type\":\"%s\"", types[o->kind]);
+    if (o->name[0]) {
+        out_str(j, ",\"kismet.device.base.name\":");
+        json_string(j, o->name);
+    }
+    if (o->channel > 0) out_printf(j, ",\"kismet.device.base.channel\":\"%d\"", o->channel);
+    if (o->auth[0]) {
+        out_str(j, ",\"kismet.device.base.crypt\":");
+        json_string(j, o->auth);
+    }
+    out_printf(j, ",\"kismet.device.base.last_time\":%lld", (long long)(o->time_us / 1000000));
+    if (o->rssi != 0) out_printf(j, ",\"kismet.common.signal.last_signal\":%d", o->rssi);
+    if (o->located) {
+        char lat[16], lon[16], alt[16];
+        format_fixed(lat, sizeof(lat), o->lat_e7, 7);
+        format_fixed(lon, sizeof(lon), o->lon_e7, 7);
+        format_fixed(alt, sizeof(alt), o->alt_dm, 1);
+        // GeoJSON order, as Kismet stores it
+        out_printf(j, ",\"kismet.common.location.geopoint\":[%s,%s]", lon, lat);
+        out_printf(j, ",\"kismet.common.location.alt\":%s", alt);
+    }
+    out_str(j, "}\n");
+}
+
+/* -------------------------------------------------------------- WiGLE CSV */
+
+static void wigle_header(export_job_t *j)
+{
+    out_str(j, "WigleWifi-1.4,appRelease=1,model=Cardputer,release=1,"
+               "device=M5MonsterC5,display=,board=,brand=M5Stack\n");
+    out_str(j, "MAC,SSID,AuthMode,FirstSeen,Channel,RSSI,CurrentLatitude,CurrentLongitude,"
+               "AltitudeMeters,AccuracyMeters,Type\n");
+}
+
+static void csv_field(export_job_t *j, const char *s)
+{
+    if (!strpbrk(s, ",\"\r\n")) {
+        out_str(j, s);
+        return;
+    }
+    out_str(j, "\"");
+    for (; *s; s++) {
+        if (*s == '"') out_str(j, "\"");
+        out_bytes(j, s, 1);
+    }
+    out_str(j, "\"");
+}
+
+static bool wigle_row(export_job_t *j, const obs_t *o)
+{
+    // WiGLE takes positioned sightings only
+    if (!o->located || !o->utc) return false;
+
+    char mac[18], seen[24], lat[16], lon[16], alt[16], acc[16];
+    format_mac(mac, o->mac);
+    time_t secs = (time_t)(o->time_us / 1000000);
+    struct tm tm;
+    gmtime_r(&secs, &tm);
+    strftime(seen, sizeof(seen), "%Y-%m-%d %H:%M:%S", &tm);
+    format_fixed(lat, sizeof(lat), o->lat_e7, 7);
+    format_fixed(lon, sizeof(lon), o->lon_e7, 7);
+    format_fixed(alt, sizeof(alt), o->alt_dm, 1);
+    format_fixed(acc, sizeof(acc), (int32_t)o->acc_dm, 1);
+
+    out_str(j, mac);
+    out_str(j, ",");
+    csv_field(j, o->name);
+    out_str(j, ",");
+    csv_field(j, o->auth);
+    out_printf(j, ",%s,%d,%d,%s,%s,%s,%s,%s\n", seen, o->channel, o->rssi, lat, lon, alt, acc,
+               o->kind == OBS_BLE ? "BLE" : "WIFI");
+    return true;
+}
+
+/* ----------------------------------------------------------------- pcapng */
+
+static void pcapng_header(export_job_t *j)
+{
+    static const char app[] = "M5MonsterC5 Cardputer obs_export";
+    size_t app_len = sizeof(app) - 1;
+    size_t app_padded = (app_len + 3) & ~(size_t)3;
+    uint32_t shb_len = 28 + 4 + app_padded + 4;
+
+    out_u32(j, PCAPNG_SHB);
+    out_u32(j, shb_len);
+    out_u32(j, PCAPNG_BYTE_ORDER);
+    out_u16(j, 1);                      // Version 1.0
+    out_u16(j, 0);
+    out_u32(j, 0xFFFFFFFF);             // Section length unknown
+    out_u32(j, 0xFFFFFFFF);
+    out_u16(j, PCAPNG_OPT_USERAPPL);
+    out_u16(j, (uint16_t)app_len);
+    out_bytes(j, app, app_len);
+    out_pad4(j, app_len);
+    out_u32(j, PCAPNG_OPT_END);
+    out_u32(j, shb_len);
+
+    out_u32(j, PCAPNG_IDB);
+    out_u32(j, 20);
+    out_u16(j, LINKTYPE_RADIOTAP);
+    out_u16(j, 0);
+    out_u32(j, 0);                      // No snap length
+    out_u32(j, 20);
+}
+
+/**
+ * @brief Radiotap header and a beacon (AP) or wildcard probe request (station)
+ * @return Packet length
+ */
+static size_t build_packet(const obs_t *o, uint8_t *pkt)
+{
+    static const uint8_t rates_2g[] = { 0x82, 0x84, 0x8B, 0x96, 0x0C, 0x12, 0x18, 0x24 };
+    static const uint8_t rates_5g[] = { 0x8C, 0x12, 0x98, 0x24, 0xB0, 0x48, 0x60, 0x6C };
+    static const uint8_t broadcast[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    bool band_2g = o->channel >= 1 && o->channel <= 14;
+    size_t n = 0;
+
+    // Radiotap: channel (bit 3), antenna signal in dBm (bit 5)
+    uint16_t mhz = o->channel > 0 ? (uint16_t)channel_mhz(o->channel) : 0;
+    uint16_t chan_flags = o->channel <= 0 ? 0 : band_2g ? 0x0080 : 0x0100;
+    uint8_t radiotap[13] = {
+        0, 0, sizeof(radiotap), 0,
+        0x28, 0, 0, 0,
+        mhz & 0xFF, mhz >> 8, chan_flags & 0xFF, chan_flags >> 8,
+        (uint8_t)(int8_t)o->rssi,
+    };
+    memcpy(pkt, radiotap, sizeof(radiotap));
+    n += sizeof(radiotap);
+
+    bool beacon = o->kind == OBS_AP;
+    pkt[n++] = beacon ? 0x80 : 0x40;    // Management: beacon / probe request
+    pkt[n++] = 0;
+    pkt[n++] = 0;                       // Duration
+    pkt[n++] = 0;
+    memcpy(&pkt[n], broadcast, 6);
+    memcpy(&pkt[n + 6], o->mac, 6);
+    memcpy(&pkt[n + 12], beacon ? o->mac : broadcast, 6);
+    n += 18;
+    pkt[n++] = 0;                       // Sequence
+    pkt[n++] = 0;
+
+    if (beacon) {
+        memset(&pkt[n], 0, 8);          // TSF
+        n += 8;
+        pkt[n++] = 0x64;                // 100 TU
+        pkt[n++] = 0;
+        uint16_t capability = 0x0001 | (auth_protected(o->auth) ? 0x0010 : 0);
+        pkt[n++] = capability & 0xFF;
+        pkt[n++] = capability >> 8;
+    }
+
+    size_t ssid_len = beacon ? strlen(o->name) : 0;
+    pkt[n++] = 0;                       // SSID
+    pkt[n++] = (uint8_t)ssid_len;
+    memcpy(&pkt[n], o->name, ssid_len);
+    n += ssid_len;
+
+    pkt[n++] = 1;                       // Supported rates
+    pkt[n++] = sizeof(rates_2g);
+    memcpy(&pkt[n], band_2g || o->channel <= 0 ? rates_2g : rates_5g, sizeof(rates_2g));
+    n += sizeof(rates_2g);
+
+    if (beacon && o->channel > 0) {
+        pkt[n++] = 3;                   // DS parameter set
+        pkt[n++] = 1;
+        pkt[n++] = (uint8_t)o->channel;
+    }
+    return n;
+}
+
+static bool pcapng_row(export_job_t *j, const obs_t *o)
+{
+    // 802.11 only: BLE sightings have no frame to show
+    if (o->kind == OBS_BLE) return false;
+
+    uint8_t pkt[PACKET_MAX];
+    size_t len = build_packet(o, pkt);
+    size_t padded = (len + 3) & ~(size_t)3;
+    size_t options = 4 + (o->located ? 4 + KISMET_GPS_OPTION_LEN : 0);
+    uint32_t block_len = (uint32_t)(28 + padded + options + 4);
+    uint64_t ts = (uint64_t)o->time_us;
+
+    out_u32(j, PCAPNG_EPB);
+    out_u32(j, block_len);
+    out_u32(j, 0);                      // Interface
+    out_u32(j, (uint32_t)(ts >> 32));
+    out_u32(j, (uint32_t)ts);
+    out_u32(j, (uint32_t)len);
+    out_u32(j, (uint32_t)len);
+    out_bytes(j, pkt, len);
+    out_pad4(j, len);
+
+    if (o->located) {
+        out_u16(j, PCAPNG_OPT_CUSTOM_BIN);
+        out_u16(j, KISMET_GPS_OPTION_LEN);
+        out_u32(j, KISMET_PEN);
+        uint8_t head[4] = { KISMET_GPS_MAGIC, KISMET_GPS_VERSION, 12, 0 };
+        out_bytes(j, head, sizeof(head));
+        out_u32(j, KISMET_GPS_LON | KISMET_GPS_LAT | KISMET_GPS_ALT);
+        // fixed3_7: (degrees + 180) x 1e7, fixed6_4: (metres + 180000) x 1e4
+        out_u32(j, (uint32_t)(o->lon_e7 + 1800000000));
+        out_u32(j, (uint32_t)(o->lat_e7 + 1800000000));
+        out_u32(j, (uint32_t)((int64_t)o->alt_dm * 1000 + 1800000000));
+    }
+    out_u32(j, PCAPNG_OPT_END);
+    out_u32(j, block_len);
+    return true;
+}
+
+static void write_obs(export_job_t *j, const obs_t *o)
+{
+    bool written = true;
+    switch (j->format) {
+        case OBS_EXPORT_KISMET: kismet_row(j, o); break;
+        case OBS_EXPORT_WIGLE:  written = wigle_row(j, o); break;
+        case OBS_EXPORT_PCAPNG: written = pcapng_row(j, o); break;
+        default: written = false; break;
+    }
+    if (written) {
+        progress.observations++;
+    } else {
+        progress.skipped++;
+    }
+}
+
+/* --------------------------------------------------------- Wardrive input */
+
+static uint32_t get_varint(cursor_t *c)
+{
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (c->p >= c->end) {
+            c->bad = true;
+            return 0;
+        }
+        uint8_t b = *c->p++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (b < 0x80) return v;
+    }
+    c->bad = true;
+    return 0;
+}
+
+static int32_t get_svarint(cursor_t *c)
+{
+    uint32_t v = get_varint(c);
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static const uint8_t *get_bytes(cursor_t *c, size_t n)
+{
+    if ((size_t)(c->end - c->p) < n) {
+        c->bad = true;
+        return NULL;
+    }
+    const uint8_t *p = c->p;
+    c->p += n;
+    return p;
+}
+
+/**
+ * @brief String dictionary defines of a block
+ */
+static void read_string_defines(cursor_t *c, char *table, size_t stride, uint32_t slots)
+{
+    uint32_t n = get_varint(c);
+    for (uint32_t i = 0; i < n && !c->bad; i++) {
+        uint32_t slot = get_varint(c);
+        const uint8_t *len = get_bytes(c, 1);
+        const uint8_t *text = len ? get_bytes(c, *len) : NULL;
+        if (!text || slot >= slots) {
+            c->bad = true;
+            return;
+        }
+        size_t copy = *len < stride - 1 ? *len : stride - 1;
+        memcpy(table + slot * stride, text, copy);
+        table[slot * stride + copy] = '\0';
+    }
+}
+
+static void mwd_close(mwd_reader_t *r)
+{
+    if (!r) return;
+    if (r->f) fclose(r->f);
+    free(r->bssids);
+    free(r->ssids);
+    free(r->auths);
+    free(r->payload);
+    free(r);
+}
+
+static void *export_calloc(size_t n, size_t size)
+{
+    void *p = heap_caps_calloc(n, size, EXPORT_CAPS);
+    return p ? p : calloc(n, size);
+}
+
+static esp_err_t mwd_open(const char *path, mwd_reader_t **out)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return ESP_ERR_NOT_FOUND;
+
+    uint8_t h[WARDRIVE_LOG_HEADER_SIZE];
+    if (fread(h, 1, sizeof(h), f) != sizeof(h) ||
+        memcmp(h, WARDRIVE_LOG_MAGIC, 4) != 0 || h[4] != WARDRIVE_LOG_VERSION) {
+        fclose(f);
+        ESP_LOGE(TAG, "%s is not a wardrive log", path);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    mwd_reader_t *r = export_calloc(1, sizeof(*r));
+    if (!r) {
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+    r->f = f;
+    r->bssid_slots = h[5] | (h[6] << 8);
+    r->ssid_slots = h[7] | (h[8] << 8);
+    r->auth_slots = h[9];
+    r->bssids = export_calloc(r->bssid_slots ? r->bssid_slots : 1, sizeof(r->bssids[0]));
+    r->ssids = export_calloc(r->ssid_slots ? r->ssid_slots : 1, sizeof(r->ssids[0]));
+    r->auths = export_calloc(r->auth_slots ? r->auth_slots : 1, sizeof(r->auths[0]));
+    r->payload = export_calloc(1, MWD_PAYLOAD_MAX);
+    if (!r->bssids || !r->ssids || !r->auths || !r->payload) {
+        mwd_close(r);
+        return ESP_ERR_NO_MEM;
+    }
+    progress.source_done = sizeof(h);
+    *out = r;
+    return ESP_OK;
+}
+
+/**
+ * @brief Decode the next block into the reader's columns
+ * @return Rows, 0 at the end, -1 on a damaged block
+ */
+static int mwd_next_block(mwd_reader_t *r)
+{
+    uint8_t h[WARDRIVE_LOG_BLOCK_HEADER];
+    size_t got = fread(h, 1, sizeof(h), r->f);
+    if (got == 0) return 0;
+    uint16_t rows = h[1] | (h[2] << 8);
+    uint32_t len = h[3] | (h[4] << 8) | ((uint32_t)h[5] << 16) | ((uint32_t)h[6] << 24);
+    if (got < sizeof(h) || h[0] != WARDRIVE_LOG_BLOCK_MARKER ||
+        rows > WARDRIVE_LOG_BLOCK_ROWS || len > MWD_PAYLOAD_MAX ||
+        fread(r->payload, 1, len, r->f) != len) {
+        return -1;
+    }
+    progress.source_done += sizeof(h) + len;
+
+    cursor_t c = { r->payload, r->payload + len, false };
+    uint32_t n = get_varint(&c);
+    for (uint32_t i = 0; i < n && !c.bad; i++) {
+        uint32_t slot = get_varint(&c);
+        const uint8_t *mac = get_bytes(&c, 6);
+        if (!mac || slot >= r->bssid_slots) return -1;
+        memcpy(r->bssids[slot], mac, 6);
+    }
+    read_string_defines(&c, (char *)r->ssids, sizeof(r->ssids[0]), r->ssid_slots);
+    read_string_defines(&c, (char *)r->auths, sizeof(r->auths[0]), r->auth_slots);
+
+    // Delta columns restart from zero in every block
+    int32_t acc = 0;
+    for (int i = 0; i < rows; i++) r->time[i] = (uint32_t)(acc += get_svarint(&c));
+    acc = 0;
+    for (int i = 0; i < rows; i++) r->lat[i] = acc += get_svarint(&c);
+    acc = 0;
+    for (int i = 0; i < rows; i++) r->lon[i] = acc += get_svarint(&c);
+    acc = 0;
+    for (int i = 0; i < rows; i++) r->alt[i] = acc += get_svarint(&c);
+    for (int i = 0; i < rows; i++) r->acc[i] = get_varint(&c);
+    for (int i = 0; i < rows; i++) r->bssid[i] = (uint16_t)get_varint(&c);
+    for (int i = 0; i < rows; i++) r->ssid[i] = (uint16_t)get_varint(&c);
+    for (int i = 0; i < rows; i++) r->auth[i] = (uint8_t)get_varint(&c);
+    const uint8_t *channels = get_bytes(&c, rows);
+    const uint8_t *rssis = get_bytes(&c, rows);
+    if (c.bad) return -1;
+    memcpy(r->channel, channels, rows);
+    memcpy(r->rssi, rssis, rows);
+    return rows;
+}
+
+static void mwd_row(const mwd_reader_t *r, int i, obs_t *o)
+{
+    memset(o, 0, sizeof(*o));
+    o->kind = OBS_AP;
+    if (r->bssid[i] < r->bssid_slots) memcpy(o->mac, r->bssids[r->bssid[i]], 6);
+    if (r->ssid[i] < r->ssid_slots) strlcpy(o->name, r->ssids[r->ssid[i]], sizeof(o->name));
+    if (r->auth[i] < r->auth_slots) strlcpy(o->auth, r->auths[r->auth[i]], sizeof(o->auth));
+    o->channel = r->channel[i];
+    o->rssi = r->rssi[i];
+    o->time_us = (int64_t)r->time[i] * 1000000;
+    o->utc = true;
+    o->located = true;
+    o->lat_e7 = r->lat[i];
+    o->lon_e7 = r->lon[i];
+    o->alt_dm = r->alt[i];
+    o->acc_dm = r->acc[i];
+}
+
+static bool export_mwd(export_job_t *j)
+{
+    obs_t o;
+    int rows;
+    while (!cancel_requested && !j->out_failed && (rows = mwd_next_block(j->mwd)) > 0) {
+        for (int i = 0; i < rows; i++) {
+            mwd_row(j->mwd, i, &o);
+            write_obs(j, &o);
+        }
+    }
+    if (rows < 0) ESP_LOGW(TAG, "Damaged block, stopped at %lu bytes",
+                           (unsigned long)progress.source_done);
+    return !j->out_failed;
+}
+
+/* ------------------------------------------------------------ Track input */
+
+static void mtk_close(mtk_reader_t *r)
+{
+    if (!r) return;
+    if (r->f) fclose(r->f);
+    free(r);
+}
+
+static esp_err_t mtk_open(const char *path, mtk_reader_t **out)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return ESP_ERR_NOT_FOUND;
+
+    uint8_t h[TRACK_LOG_HEADER_SIZE];
+    if (fread(h, 1, sizeof(h), f) != sizeof(h) ||
+        memcmp(h, TRACK_LOG_MAGIC, 4) != 0 || h[4] != TRACK_LOG_VERSION) {
+        fclose(f);
+        ESP_LOGE(TAG, "%s is not a track log", path);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    mtk_reader_t *r = export_calloc(1, sizeof(*r));
+    if (!r) {
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+    r->f = f;
+    progress.source_done = sizeof(h);
+    *out = r;
+    return ESP_OK;
+}
+
+/**
+ * @brief Decode the next block into the reader's columns
+ * @return Points, 0 at the end, -1 on a damaged block
+ */
+static int mtk_next_block(mtk_reader_t *r)
+{
+    uint8_t h[TRACK_LOG_BLOCK_HEADER];
+    size_t got = fread(h, 1, sizeof(h), r->f);
+    if (got == 0) return 0;
+    uint16_t points = h[1] | (h[2] << 8);
+    uint32_t len = h[3] | (h[4] << 8) | ((uint32_t)h[5] << 16) | ((uint32_t)h[6] << 24);
+    if (got < sizeof(h) || h[0] != TRACK_LOG_BLOCK_MARKER ||
+        points > TRACK_LOG_BLOCK_POINTS || len > MTK_PAYLOAD_MAX ||
+        fread(r->payload, 1, len, r->f) != len) {
+        return -1;
+    }
+    progress.source_done += sizeof(h) + len;
+
+    cursor_t c = { r->payload, r->payload + len, false };
+    int64_t ms = (int64_t)get_varint(&c) * 1000;
+    for (int i = 0; i < points; i++) r->time_ms[i] = ms += get_svarint(&c);
+    int32_t acc = 0;
+    for (int i = 0; i < points; i++) r->lat[i] = acc += get_svarint(&c);
+    acc = 0;
+    for (int i = 0; i < points; i++) r->lon[i] = acc += get_svarint(&c);
+    acc = 0;
+    for (int i = 0; i < points; i++) r->alt[i] = acc += get_svarint(&c);
+    for (int i = 0; i < points; i++) r->hdop[i] = get_varint(&c);
+    const uint8_t *flags = get_bytes(&c, points);
+    if (c.bad) return -1;
+    memcpy(r->flags, flags, points);
+    return points;
+}
+
+/* -------------------------------------------------------------------- GPX */
+
+static void gpx_point(export_job_t *j, const mtk_reader_t *r, int i)
+{
+    char lat[16], lon[16], ele[16], hdop[16], when[24];
+    format_fixed(lat, sizeof(lat), r->lat[i], 7);
+    format_fixed(lon, sizeof(lon), r->lon[i], 7);
+    format_fixed(ele, sizeof(ele), r->alt[i], 1);
+    format_fixed(hdop, sizeof(hdop), (int32_t)r->hdop[i], 2);
+    time_t secs = (time_t)(r->time_ms[i] / 1000);
+    struct tm tm;
+    gmtime_r(&secs, &tm);
+    strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%S", &tm);
+    out_printf(j, "<trkpt lat=\"%s\" lon=\"%s\"><ele>%s</ele><time>%s.%03dZ</time>"
+                  "<hdop>%s</hdop></trkpt>\n",
+               lat, lon, ele, when, (int)(r->time_ms[i] % 1000), hdop);
+}
+
+/**
+ * @brief Write a track as one GPX trk, a trkseg per stretch with a fix
+ */
+static bool export_mtk(export_job_t *j)
+{
+    out_str(j, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+               "<gpx version=\"1.1\" creator=\"M5MonsterC5 Cardputer obs_export\" "
+               "xmlns=\"http://www.topografix.com/GPX/1/1\">\n<trk>\n");
+    bool open_seg = false;
+    int points = 0;
+    while (!cancel_requested && !j->out_failed && (points = mtk_next_block(j->mtk)) > 0) {
+        for (int i = 0; i < points; i++) {
+            if (!open_seg || (j->mtk->flags[i] & TRACK_LOG_FLAG_SEGMENT)) {
+                out_str(j, open_seg ? "</trkseg>\n<trkseg>\n" : "<trkseg>\n");
+                open_seg = true;
+            }
+            gpx_point(j, j->mtk, i);
+            progress.observations++;
+        }
+    }
+    if (points < 0) ESP_LOGW(TAG, "Damaged block, stopped at %lu bytes",
+                             (unsigned long)progress.source_done);
+    out_str(j, open_seg ? "</trkseg>\n</trk>\n</gpx>\n" : "</trk>\n</gpx>\n");
+    return !j->out_failed;
+}
+
+/* ---------------------------------------------------------- Session input */
+
+/**
+ * @brief Cut the next tab-separated field off *s
+ */
+static char *next_field(char **s)
+{
+    char *field = *s;
+    if (!field) return "";
+    char *tab = strchr(field, '\t');
+    if (tab) {
+        *tab = '\0';
+        *s = tab + 1;
+    } else {
+        *s = NULL;
+    }
+    return field;
+}
+
+/**
+ * @brief Turn a session log record into an observation
+ * @return false for records that are not sightings
+ */
+static bool session_record(export_job_t *j, char *record, obs_t *o)
+{
+    memset(o, 0, sizeof(*o));
+    char *rest = record;
+    int64_t time_us = strtoll(next_field(&rest), NULL, 10);
+    const char *type = next_field(&rest);
+
+    if (strcmp(type, "SCAN") == 0 || strcmp(type, "SNIFFER") == 0) {
+        // SCAN: bssid ssid channel rssi security band; SNIFFER: bssid ssid channel rssi clients
+        bool scan = type[1] == 'C';
+        if (!parse_mac(next_field(&rest), o->mac)) return false;
+        o->kind = OBS_AP;
+        strlcpy(o->name, next_field(&rest), sizeof(o->name));
+        o->channel = atoi(next_field(&rest));
+        o->rssi = atoi(next_field(&rest));
+        if (scan) strlcpy(o->auth, next_field(&rest), sizeof(o->auth));
+    } else if (strcmp(type, "CLIENT") == 0) {
+        if (!parse_mac(next_field(&rest), o->mac)) return false;
+        o->kind = OBS_CLIENT;
+    } else if (strcmp(type, "BT") == 0) {
+        // Typed: mac rssi name; else the JanOS list row, maybe marked "B2 "
+        char *first = next_field(&rest);
+        if (strncmp(first, "B2 ", 3) == 0) first += 3;
+        janos_bt_row_t row;
+        if (parse_mac(first, o->mac) && strlen(first) == 17 && rest) {
+            o->rssi = atoi(next_field(&rest));
+            strlcpy(o->name, next_field(&rest), sizeof(o->name));
+        } else if (janos_parse_bt_row(first, &row) && parse_mac(row.mac_text, o->mac)) {
+            o->rssi = row.rssi == JANOS_RSSI_NONE ? 0 : row.rssi;
+            size_t len = row.name.len < sizeof(o->name) - 1 ? row.name.len : sizeof(o->name) - 1;
+            memcpy(o->name, row.name.ptr, len);
+            o->name[len] = '\0';
+        } else {
+            return false;
+        }
+        o->kind = OBS_BLE;
+    } else {
+        return false;
+    }
+
+    o->time_us = time_us;
+    o->utc = j->session_current && time_sync_utc_us(time_us, &o->time_us);
+    return true;
+}
+
+static bool export_session(export_job_t *j)
+{
+    char record[SESSION_LOG_RECORD_MAX];
+    obs_t o;
+    uint32_t offset = 0;
+    size_t taken;
+    while (!cancel_requested && !j->out_failed &&
+           (taken = session_file_read(j->session, offset, record, sizeof(record))) > 0) {
+        offset += taken;
+        progress.source_done = offset;
+        if (session_record(j, record, &o)) write_obs(j, &o);
+    }
+    return !j->out_failed;
+}
+
+/* ------------------------------------------------------------------- Task */
+
+static void release_job(export_job_t *j)
+{
+    mwd_close(j->mwd);
+    mtk_close(j->mtk);
+    if (j->session) session_file_reader_close(j->session);
+    if (j->file) sd_io_close(j->file);
+    if (j->sink == OBS_EXPORT_TO_USB) {
+        usb_serial_jtag_driver_uninstall();
+        esp_log_level_set("*", CONFIG_LOG_DEFAULT_LEVEL);
+    }
+    free(j);
+}
+
+static void export_task(void *arg)
+{
+    export_job_t *j = arg;
+
+    switch (j->format) {
+        case OBS_EXPORT_WIGLE:  wigle_header(j); break;
+        case OBS_EXPORT_PCAPNG: pcapng_header(j); break;
+        default: break;
+    }
+    bool ok = j->mwd ? export_mwd(j) : j->mtk ? export_mtk(j) : export_session(j);
+    out_flush(j);
+    ok = ok && !j->out_failed;
+
+    release_job(j);
+    ESP_LOGI(TAG, "%s export to %s %s: %lu observations (%lu skipped), %lu bytes",
+             format_names[j->format], progress.output,
+             cancel_requested ? "cancelled" : ok ? "done" : "failed",
+             (unsigned long)progress.observations, (unsigned long)progress.skipped,
+             (unsigned long)progress.bytes);
+    progress.state = cancel_requested ? OBS_EXPORT_CANCELLED :
+                     ok ? OBS_EXPORT_DONE : OBS_EXPORT_FAILED;
+    job = NULL;
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief session_N of a session log path, or -1
+ */
+static int session_number(const char *name)
+{
+    int number;
+    char ext[8];
+    if (sscanf(name, "session_%d.%7s", &number, ext) != 2) return -1;
+    return strcmp(ext, "log") == 0 || strcmp(ext, "slz") == 0 ? number : -1;
+}
+
+static bool is_mwd(const char *name)
+{
+    size_t len = strlen(name);
+    return len > 4 && strcasecmp(name + len - 4, ".mwd") == 0;
+}
+
+static bool is_mtk(const char *name)
+{
+    size_t len = strlen(name);
+    return len > 4 && strcasecmp(name + len - 4, TRACK_LOG_EXT) == 0;
+}
+
+bool obs_export_is_source(const char *name)
+{
+    return is_mwd(name) || is_mtk(name) || session_number(name) >= 0;
+}
+
+static esp_err_t open_source(export_job_t *j, const char *source)
+{
+    const char *name = strrchr(source, '/');
+    name = name ? name + 1 : source;
+
+    // Tracks hold positions only, and only GPX holds tracks
+    if (is_mtk(name) != (j->format == OBS_EXPORT_GPX)) return ESP_ERR_NOT_SUPPORTED;
+    if (is_mtk(name)) {
+        struct stat st;
+        if (stat(source, &st) != 0) return ESP_ERR_NOT_FOUND;
+        progress.source_size = (uint32_t)st.st_size;
+        return mtk_open(source, &j->mtk);
+    }
+
+    if (is_mwd(name)) {
+        struct stat st;
+        if (stat(source, &st) != 0) return ESP_ERR_NOT_FOUND;
+        progress.source_size = (uint32_t)st.st_size;
+        return mwd_open(source, &j->mwd);
+    }
+
+    int number = session_number(name);
+    if (number < 0) return ESP_ERR_NOT_FOUND;
+    // No positions in session logs
+    if (j->format == OBS_EXPORT_WIGLE) return ESP_ERR_NOT_SUPPORTED;
+    j->session = session_file_reader_open(number);
+    if (!j->session) return ESP_ERR_NOT_FOUND;
+    progress.source_size = session_file_reader_size(j->session);
+
+    session_log_stats_t stats;
+    session_log_get_stats(&stats);
+    j->session_current = stats.active && stats.file_number == number;
+    return ESP_OK;
+}
+
+static esp_err_t open_sink(export_job_t *j, const char *source)
+{
+    if (j->sink == OBS_EXPORT_TO_USB) {
+        if (usb_bridge_is_active() || screen_mirror_is_active()) return ESP_ERR_INVALID_STATE;
+        usb_serial_jtag_driver_config_t config = {
+            .rx_buffer_size = 256,
+            .tx_buffer_size = USB_RING_SIZE,
+        };
+        esp_err_t ret = usb_serial_jtag_driver_install(&config);
+        if (ret != ESP_OK) return ret;
+        strlcpy(progress.output, "USB", sizeof(progress.output));
+        ESP_LOGI(TAG, "Streaming %s over USB, logging paused", format_names[j->format]);
+        // Log lines would corrupt the stream
+        esp_log_level_set("*", ESP_LOG_NONE);
+        return ESP_OK;
+    }
+
+    const char *name = strrchr(source, '/');
+    name = name ? name + 1 : source;
+    size_t stem = strcspn(name, ".");
+    struct stat st;
+    if (stat(OBS_EXPORT_DIR, &st) != 0) mkdir(OBS_EXPORT_DIR, 0755);
+    snprintf(progress.output, sizeof(progress.output), "%s/%.*s.%s", OBS_EXPORT_DIR,
+             (int)stem, name, format_ext[j->format]);
+    j->file = sd_io_open(progress.output, 0);
+    return j->file ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t obs_export_start(const char *source, obs_export_format_t format,
+                           obs_export_sink_t sink)
+{
+    if (!source || format >= OBS_EXPORT_FORMAT_COUNT || sink >= OBS_EXPORT_SINK_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // The card is lent to the PC while exported as a drive
+    if (job || usb_msc_is_active()) return ESP_ERR_INVALID_STATE;
+
+    export_job_t *j = calloc(1, sizeof(*j));
+    if (!j) return ESP_ERR_NO_MEM;
+    j->format = format;
+    j->sink = sink;
+    memset(&progress, 0, sizeof(progress));
+    cancel_requested = false;
+
+    esp_err_t ret = open_source(j, source);
+    if (ret == ESP_OK) {
+        ret = open_sink(j, source);
+        if (ret != ESP_OK) j->sink = OBS_EXPORT_TO_SD;     // Nothing to undo on USB
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot export %s as %s: %s", source, format_names[format],
+                 esp_err_to_name(ret));
+        release_job(j);
+        progress.state = OBS_EXPORT_FAILED;
+        return ret;
+    }
+
+    job = j;
+    progress.state = OBS_EXPORT_RUNNING;
+    if (xTaskCreatePinnedToCore(export_task, "obs_export", TASK_EXPORT_STACK, j,
+                                TASK_LOG_WRITER_PRIO, NULL, TASK_LOG_WRITER_CORE) != pdPASS) {
+        job = NULL;
+        release_job(j);
+        progress.state = OBS_EXPORT_FAILED;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void obs_export_cancel(void)
+{
+    if (job) cancel_requested = true;
+}
+
+void obs_export_get_progress(obs_export_progress_t *out)
+{
+    *out = progress;
+}
+
+const char *obs_export_format_name(obs_export_format_t format)
+{
+    return format < OBS_EXPORT_FORMAT_COUNT ? format_names[format] : "?";
+}
@@ -0,0 +1,107 @@
+/**
+ * @file obs_export.h
+ * @brief Stream logged observations out in formats other tools read as-is
+ *
+ * Sources are the logs already on the card, read one block at a time so a
+ * file of any size exports in constant memory:
+ *
+ *   wd_N.mwd       wardrive rows (wardrive_log.h), each with a GPS position
+ *   session_N      SCAN and SNIFFER rows (APs), CLIENT rows (stations) and
+ *                  BT rows of a session log (session_file.h); no positions
+ *   trk_N.mtk      the simplified wardrive route (track_log.h); GPX only
+ *
+ * Formats:
+ *
+ *   Kismet     JSON lines, one device record per observation, with the
+ *              field names of Kismet's simplified device view
+ *              ("kismet.device.base.macaddr", ...)
+ *   WiGLE      WigleWifi-1.4 CSV, as tools/mwd_to_wigle.py writes it;
+ *              positioned sources only
+ *   pcapng     one 802.11 + radiotap packet per observation: a beacon
+ *              for an AP, a wildcard probe request for a station (BLE
+ *              rows are skipped). Positions ride along as Kismet's GPS
+ *              custom option (PEN 55922), so Kismet and Wireshark
+ *              plugins map them without conversion.
+ *   GPX        GPX 1.1 track, one trkseg per stretch with a fix, for
+ *              track sources only
+ *
+ * Output goes to OBS_EXPORT_DIR/<source>.<ext> on the card, or as a raw byte
+ * stream over the USB CDC port (log output is paused meanwhile, as for
+ * screen mirroring). Session logs carry time since boot: rows of the
+ * current session are converted to UTC once the GPS gave the time,
+ * older sessions keep boot-relative times.
+ *
+ * One export runs at a time, on its own low-priority I/O task.
+ */
+
+#ifndef OBS_EXPORT_H
+#define OBS_EXPORT_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define OBS_EXPORT_DIR              "/sdcard/export"
+#define OBS_EXPORT_PATH_LEN         64
+#define OBS_EXPORT_OUT_BUFFER       2048        // Formatted bytes per sink write
+#define OBS_EXPORT_USB_TIMEOUT_MS   2000        // Host not reading: give up
+
+typedef enum {
+    OBS_EXPORT_KISMET = 0,
+    OBS_EXPORT_WIGLE,
+    OBS_EXPORT_PCAPNG,
+    OBS_EXPORT_GPX,
+    OBS_EXPORT_FORMAT_COUNT
+} obs_export_format_t;
+
+typedef enum {
+    OBS_EXPORT_TO_SD = 0,
+    OBS_EXPORT_TO_USB,
+    OBS_EXPORT_SINK_COUNT
+} obs_export_sink_t;
+
+typedef enum {
+    OBS_EXPORT_IDLE = 0,
+    OBS_EXPORT_RUNNING,
+    OBS_EXPORT_DONE,
+    OBS_EXPORT_FAILED,
+    OBS_EXPORT_CANCELLED,
+} obs_export_state_t;
+
+typedef struct {
+    obs_export_state_t state;
+    uint32_t observations;          // Written
+    uint32_t skipped;               // Not representable in the format
+    uint32_t bytes;                 // Output bytes
+    uint32_t source_done;           // Source bytes read
+    uint32_t source_size;
+    char output[OBS_EXPORT_PATH_LEN];   // File written, or "USB"
+} obs_export_progress_t;
+
+/**
+ * @brief Start exporting a log file
+ * @param source Path of a wd_N.mwd, trk_N.mtk or session_N.log / .slz file
+ * @return ESP_OK once running, ESP_ERR_INVALID_STATE if an export runs or
+ *         USB is taken, ESP_ERR_NOT_SUPPORTED for WiGLE from a session log
+ *         or GPX from anything but a track (and the reverse),
+ *         ESP_ERR_NOT_FOUND, ESP_ERR_NO_MEM
+ */
+esp_err_t obs_export_start(const char *source, obs_export_format_t format,
+                           obs_export_sink_t sink);
+
+/**
+ * @brief Ask a running export to stop (the output is kept, cut short)
+ */
+void obs_export_cancel(void);
+
+void obs_export_get_progress(obs_export_progress_t *out);
+
+/**
+ * @brief Whether a file name is something obs_export_start() reads
+ */
+bool obs_export_is_source(const char *name);
+
+const char *obs_export_format_name(obs_export_format_t format);
+
+#endif // OBS_EXPORT_H
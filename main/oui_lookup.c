@@ -0,0 +1,148 @@
+/**
+ * @file oui_lookup.c
+ * @brief Local MAC vendor lookup
+ */
+
+#include "oui_lookup.h"
+#include "assets.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "OUI";
+
+// Generated tables (oui_table.c)
+extern const uint32_t oui_entry_count;
+extern const uint8_t oui_prefixes[][3];
+extern const uint16_t oui_vendor_ids[];
+extern const uint32_t oui_vendor_offsets[];
+extern const char oui_vendor_pool[];
+
+// Table in use: the compiled one, or the "oui" entry of the asset bundle
+typedef struct {
+    uint32_t count;
+    const uint8_t (*prefixes)[3];
+    const uint16_t *vendor_ids;
+    const uint32_t *vendor_offsets;
+    const char *vendor_pool;
+} oui_table_t;
+
+static oui_table_t table = {
+    .count = 0,                 // Set by oui_lookup_init()
+    .prefixes = oui_prefixes,
+    .vendor_ids = oui_vendor_ids,
+    .vendor_offsets = oui_vendor_offsets,
+    .vendor_pool = oui_vendor_pool,
+};
+static bool table_ready = false;
+
+/**
+ * @brief Point the table at the bundle's OUI entry if it is well formed
+ */
+static bool use_asset_table(oui_table_t *t)
+{
+    size_t size = 0;
+    const uint8_t *blob = assets_find("oui", &size);
+    if (!blob || size < sizeof(assets_oui_t)) return false;
+
+    assets_oui_t hdr;
+    memcpy(&hdr, blob, sizeof(hdr));
+    if (hdr.count == 0 || hdr.vendors == 0 || hdr.vendors > 0x10000) return false;
+    if ((hdr.ids_offset & 1) || (hdr.offsets_offset & 3)) return false;
+    if (hdr.prefixes_offset > size || hdr.count > (size - hdr.prefixes_offset) / 3) return false;
+    if (hdr.ids_offset > size || hdr.count > (size - hdr.ids_offset) / 2) return false;
+    if (hdr.offsets_offset > size || hdr.vendors > (size - hdr.offsets_offset) / 4) return false;
+    if (hdr.pool_offset >= size || blob[size - 1] != '\0') return false;
+
+    const uint32_t *offsets = (const uint32_t *)(blob + hdr.offsets_offset);
+    for (uint32_t v = 0; v < hdr.vendors; v++) {
+        if (offsets[v] >= size - hdr.pool_offset) return false;
+    }
+    const uint16_t *ids = (const uint16_t *)(blob + hdr.ids_offset);
+    for (uint32_t i = 0; i < hdr.count; i++) {
+        if (ids[i] >= hdr.vendors) return false;
+    }
+
+    t->count = hdr.count;
+    t->prefixes = (const uint8_t (*)[3])(blob + hdr.prefixes_offset);
+    t->vendor_ids = ids;
+    t->vendor_offsets = offsets;
+    t->vendor_pool = (const char *)(blob + hdr.pool_offset);
+    return true;
+}
+
+void oui_lookup_init(void)
+{
+    if (table_ready) return;
+
+    oui_table_t asset_table;
+    if (use_asset_table(&asset_table)) {
+        table = asset_table;
+        ESP_LOGI(TAG, "Using %lu prefixes from the asset bundle", (unsigned long)table.count);
+    } else {
+        if (assets_find("oui", NULL)) {
+            ESP_LOGW(TAG, "Asset OUI table is malformed, using the compiled one");
+        }
+        table.count = oui_entry_count;
+    }
+    table_ready = true;
+}
+
+const char* oui_lookup(const uint8_t *mac)
+{
+    if (!mac) return NULL;
+    
+    // I/G or U/L bit set: not an IEEE-assigned prefix
+    if (mac[0] & 0x03) return NULL;
+    if (!table_ready) oui_lookup_init();
+    
+    int lo = 0;
+    int hi = (int)table.count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = memcmp(table.prefixes[mid], mac, 3);
+        if (cmp == 0) {
+            return &table.vendor_pool[table.vendor_offsets[table.vendor_ids[mid]]];
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return NULL;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+const char* oui_lookup_str(const char *mac)
+{
+    if (!mac) return NULL;
+    while (*mac == ' ') mac++;
+    
+    // "AA:BB:CC" - two hex digits per byte, one separator between
+    uint8_t prefix[3];
+    for (int i = 0; i < 3; i++) {
+        int hi = hex_value(mac[0]);
+        int lo = (hi >= 0) ? hex_value(mac[1]) : -1;
+        if (lo < 0) return NULL;
+        prefix[i] = (uint8_t)((hi << 4) | lo);
+        mac += 2;
+        if (i < 2) {
+            if (*mac != ':' && *mac != '-') return NULL;
+            mac++;
+        }
+    }
+    return oui_lookup(prefix);
+}
+
+int oui_table_size(void)
+{
+    if (!table_ready) oui_lookup_init();
+    return (int)table.count;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file oui_lookup.h
+ * @brief Local MAC vendor lookup
+ *
+ * Binary search over a sorted OUI table compiled into flash (oui_table.c,
+ * generated by tools/gen_oui_table.py), so screens can name devices
+ * without asking JanOS for vendor strings. A bundle in the asset
+ * partition (assets.h) with an "oui" entry replaces the compiled table,
+ * so the full IEEE registry can ship without growing the app image.
+ */
+
+#ifndef OUI_LOOKUP_H
+#define OUI_LOOKUP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Pick the asset bundle table or the compiled one
+ *
+ * Call once after assets_init(); the first lookup does it otherwise.
+ */
+void oui_lookup_init(void);
+
+/**
+ * @brief Look up the vendor of a MAC address
+ *
+ * Locally administered and multicast addresses (BLE random addresses,
+ * randomized probe MACs) have no vendor and return NULL.
+ * @param mac At least the first 3 bytes of the address
+ * @return Vendor name in flash, or NULL if unknown
+ */
+const char* oui_lookup(const uint8_t *mac);
+
+/**
+ * @brief Look up the vendor of a MAC address in text form
+ * @param mac "AA:BB:CC..." or "AA-BB-CC..." (leading spaces allowed)
+ * @return Vendor name in flash, or NULL if unknown or not a MAC
+ */
+const char* oui_lookup_str(const char *mac);
+
+/**
+ * @brief Number of prefixes in the table in use
+ */
+int oui_table_size(void);
+
+#endif // OUI_LOOKUP_H
@@ -0,0 +1,137 @@
+/**
+ * @file oui_table.c
+ * @brief OUI vendor table (generated, do not edit)
+ *
+ * Generated by tools/gen_oui_table.py from oui_seed.csv:
+ * 77 prefixes, 25 vendors, 283 bytes of names.
+ */
+
+#include <stdint.h>
+
+const uint32_t oui_entry_count = 77;
+
+// Sorted 24-bit prefixes, big-endian
+const uint8_t oui_prefixes[][3] = {
+    { 0x00, 0x00, 0x0C },
+    { 0x00, 0x03, 0x6B },
+    { 0x00, 0x03, 0x93 },
+    { 0x00, 0x04, 0x23 },
+    { 0x00, 0x04, 0x4B },
+    { 0x00, 0x09, 0x5B },
+    { 0x00, 0x09, 0xBF },
+    { 0x00, 0x0A, 0x95 },
+    { 0x00, 0x0C, 0x29 },
+    { 0x00, 0x0D, 0x93 },
+    { 0x00, 0x0E, 0x58 },
+    { 0x00, 0x10, 0x18 },
+    { 0x00, 0x11, 0x24 },
+    { 0x00, 0x12, 0xFB },
+    { 0x00, 0x14, 0x22 },
+    { 0x00, 0x14, 0x51 },
+    { 0x00, 0x14, 0x6C },
+    { 0x00, 0x15, 0x5D },
+    { 0x00, 0x16, 0x3E },
+    { 0x00, 0x16, 0xCB },
+    { 0x00, 0x17, 0xAB },
+    { 0x00, 0x17, 0xF2 },
+    { 0x00, 0x19, 0xE3 },
+    { 0x00, 0x1A, 0x11 },
+    { 0x00, 0x1B, 0x21 },
+    { 0x00, 0x1B, 0x63 },
+    { 0x00, 0x1C, 0x42 },
+    { 0x00, 0x1E, 0xC2 },
+    { 0x00, 0x21, 0xE9 },
+    { 0x00, 0x23, 0xDF },
+    { 0x00, 0x24, 0x36 },
+    { 0x00, 0x24, 0xD7 },
+    { 0x00, 0x25, 0x00 },
+    { 0x00, 0x25, 0xBC },
+    { 0x00, 0x26, 0x08 },
+    { 0x00, 0x26, 0x4A },
+    { 0x00, 0x26, 0xBB },
+    { 0x00, 0x50, 0x56 },
+    { 0x00, 0x50, 0xF2 },
+    { 0x00, 0xE0, 0x4C },
+    { 0x00, 0xE0, 0xFC },
+    { 0x04, 0x18, 0xD6 },
+    { 0x08, 0x00, 0x27 },
+    { 0x14, 0xCC, 0x20 },
+    { 0x18, 0xFE, 0x34 },
+    { 0x24, 0x0A, 0xC4 },
+    { 0x24, 0x6F, 0x28 },
+    { 0x24, 0xA4, 0x3C },
+    { 0x28, 0xCD, 0xC1 },
+    { 0x28, 0xCF, 0xE9 },
+    { 0x30, 0xAE, 0xA4 },
+    { 0x3C, 0x5A, 0xB4 },
+    { 0x3C, 0x71, 0xBF },
+    { 0x44, 0x65, 0x0D },
+    { 0x50, 0xC7, 0xBF },
+    { 0x5C, 0xAA, 0xFD },
+    { 0x5C, 0xCF, 0x7F },
+    { 0x60, 0x01, 0x94 },
+    { 0x74, 0xC2, 0x46 },
+    { 0x7C, 0x9E, 0xBD },
+    { 0x80, 0x2A, 0xA8 },
+    { 0x84, 0xCC, 0xA8 },
+    { 0xA4, 0xCF, 0x12 },
+    { 0xB4, 0xE6, 0x2D },
+    { 0xB8, 0x27, 0xEB },
+    { 0xB8, 0xE9, 0x37 },
+    { 0xC4, 0x2B, 0x44 },
+    { 0xD8, 0x3A, 0xDD },
+    { 0xDC, 0x4F, 0x22 },
+    { 0xDC, 0xA6, 0x32 },
+    { 0xE4, 0x5F, 0x01 },
+    { 0xEC, 0xFA, 0xBC },
+    { 0xF0, 0x18, 0x98 },
+    { 0xF0, 0x27, 0x2D },
+    { 0xF4, 0xF2, 0x6D },
+    { 0xF4, 0xF5, 0xD8 },
+    { 0xFC, 0xEC, 0xDA },
+};
+
+// Vendor of each prefix, index into oui_vendor_offsets
+const uint16_t oui_vendor_ids[] = {
+    3, 3, 1, 9, 13, 11, 12, 1, 23, 1, 20, 2,
+    1, 19, 4, 1, 11, 10, 24, 1, 12, 1, 1, 6,
+    9, 1, 15, 1, 1, 1, 1, 9, 1, 1, 1, 1,
+    1, 23, 10, 18, 7, 22, 14, 21, 5, 5, 5, 22,
+    17, 1, 5, 6, 5, 0, 21, 20, 5, 5, 0, 5,
+    22, 5, 5, 5, 16, 20, 8, 17, 5, 17, 17, 5,
+    1, 0, 21, 6, 22,
+};
+
+const uint32_t oui_vendor_offsets[] = {
+    0, 7, 13, 22, 36, 41, 51, 58, 65, 79, 85, 95,
+    103, 112, 119, 137, 147, 171, 192, 214, 234, 240, 248, 266,
+    273,
+};
+
+const char oui_vendor_pool[] =
+    "Amazon\0"
+    "Apple\0"
+    "Broadcom\0"
+    "Cisco Systems\0"
+    "Dell\0"
+    "Espressif\0"
+    "Google\0"
+    "Huawei\0"
+    "Huawei Device\0"
+    "Intel\0"
+    "Microsoft\0"
+    "Netgear\0"
+    "Nintendo\0"
+    "Nvidia\0"
+    "PCS Systemtechnik\0"
+    "Parallels\0"
+    "Raspberry Pi Foundation\0"
+    "Raspberry Pi Trading\0"
+    "Realtek Semiconductor\0"
+    "Samsung Electronics\0"
+    "Sonos\0"
+    "TP-LINK\0"
+    "Ubiquiti Networks\0"
+    "VMware\0"
+    "Xensource\0"
+    ;
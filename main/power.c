@@ -0,0 +1,87 @@
+/**
+ * @file power.c
+ * @brief CPU frequency scaling around rendering and UART bursts
+ *
+ * Light sleep is allowed in the PM configuration when tickless idle is
+ * built in, but while the JanOS link is open the UART driver holds an APB
+ * lock (its baud clock is APB), which keeps the chip awake. That is what
+ * we want: the characters that wake a sleeping UART are lost, and JanOS
+ * does not resend lines.
+ */
+
+#include "power.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include <stdbool.h>
+
+#ifdef CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
+
+static const char *TAG = "POWER";
+
+#ifdef CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t locks[POWER_LOCK_COUNT];
+static const char *const lock_names[POWER_LOCK_COUNT] = {
+    [POWER_LOCK_RENDER] = "render",
+    [POWER_LOCK_UART]   = "uart_rx",
+    [POWER_LOCK_USB]    = "usb_msc",
+};
+#endif
+
+esp_err_t power_init(void)
+{
+#ifdef CONFIG_PM_ENABLE
+    esp_pm_config_t config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = POWER_MIN_CPU_MHZ,
+#ifdef CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true,
+#else
+        .light_sleep_enable = false,
+#endif
+    };
+    esp_err_t ret = esp_pm_configure(&config);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "PM configure failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    for (int i = 0; i < POWER_LOCK_COUNT; i++) {
+        ret = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, lock_names[i], &locks[i]);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "PM lock '%s' failed: %s", lock_names[i], esp_err_to_name(ret));
+            locks[i] = NULL;
+        }
+    }
+
+    ESP_LOGI(TAG, "CPU %d-%d MHz, light sleep %s", POWER_MIN_CPU_MHZ,
+             CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, config.light_sleep_enable ? "on" : "off");
+    return ESP_OK;
+#else
+    ESP_LOGI(TAG, "Power management disabled (CONFIG_PM_ENABLE)");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void power_acquire(power_lock_t lock)
+{
+#ifdef CONFIG_PM_ENABLE
+    if (lock < POWER_LOCK_COUNT && locks[lock]) {
+        esp_pm_lock_acquire(locks[lock]);
+    }
+#else
+    (void)lock;
+#endif
+}
+
+void power_release(power_lock_t lock)
+{
+#ifdef CONFIG_PM_ENABLE
+    if (lock < POWER_LOCK_COUNT && locks[lock]) {
+        esp_pm_lock_release(locks[lock]);
+    }
+#else
+    (void)lock;
+#endif
+}
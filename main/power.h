@@ -0,0 +1,41 @@
+/**
+ * @file power.h
+ * @brief CPU frequency scaling around rendering and UART bursts
+ *
+ * With CONFIG_PM_ENABLE the CPU runs at POWER_MIN_CPU_MHZ while idle and
+ * is raised to the configured maximum while a frame is rendered and
+ * pushed over SPI, while a UART burst is split into lines, or for as long
+ * as the SD card is exported over USB. Without it
+ * the functions do nothing and the CPU stays at its default frequency.
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include "esp_err.h"
+
+#define POWER_MIN_CPU_MHZ   80
+
+typedef enum {
+    POWER_LOCK_RENDER = 0,      // Render task: redraw and display_flush
+    POWER_LOCK_UART,            // UART RX task: draining and dispatching lines
+    POWER_LOCK_USB,             // USB drive export: whole session, no light sleep
+    POWER_LOCK_COUNT
+} power_lock_t;
+
+/**
+ * @brief Configure power management (call once, early in app_main)
+ * @return ESP_OK, or ESP_ERR_NOT_SUPPORTED when PM is not enabled
+ */
+esp_err_t power_init(void);
+
+/**
+ * @brief Keep the CPU at full speed until the matching power_release()
+ *
+ * Not nested per lock: each owner acquires and releases in pairs.
+ */
+void power_acquire(power_lock_t lock);
+
+void power_release(power_lock_t lock);
+
+#endif // POWER_H
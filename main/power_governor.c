@@ -0,0 +1,121 @@
+/**
+ * @file power_governor.c
+ * @brief Battery-aware trade of responsiveness for runtime
+ *
+ * The profile in force is one byte written by the main loop only, so
+ * the render task, the GPS callback and the log writer read it without
+ * a lock.
+ */
+
+#include "power_governor.h"
+#include "screen_manager.h"
+#include "battery.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdio.h>
+
+static const char *TAG = "GOVERNOR";
+
+typedef struct {
+    const char *name;
+    uint16_t frame_ms;
+    uint8_t backlight_pct;          // Share of the brightness setting
+    uint8_t interval_scale;
+    bool defer_compression;
+    int level;                      // Auto: chosen at or below this battery level
+    int runtime_min;                // Auto: or this many minutes left
+} profile_params_t;
+
+static const profile_params_t params[POWER_PROFILE_COUNT] = {
+    [POWER_PROFILE_AUTO] = {"Auto"},
+    [POWER_PROFILE_PERFORMANCE] = {"Performance", RENDER_FRAME_INTERVAL_MS, 100, 1, false,
+                                   -1, -1},
+    [POWER_PROFILE_BALANCED] = {"Balanced", 50, 70, 2, false,
+                                POWER_GOVERNOR_BALANCED_LEVEL,
+                                POWER_GOVERNOR_BALANCED_RUNTIME_MIN},
+    [POWER_PROFILE_ENDURANCE] = {"Endurance", 100, 40, 4, true,
+                                 POWER_GOVERNOR_ENDURANCE_LEVEL,
+                                 POWER_GOVERNOR_ENDURANCE_RUNTIME_MIN},
+};
+
+static volatile uint8_t active = POWER_PROFILE_PERFORMANCE;
+static power_profile_t chosen = POWER_PROFILE_AUTO;     // Setting at the last look
+static int64_t next_sample_ms = 0;
+
+/**
+ * @brief Profile for a battery reading, leaving the current one only past the margin
+ */
+static power_profile_t auto_profile(const battery_reading_t *battery, power_profile_t current)
+{
+    if (battery->level < 0 || battery->trend == BATTERY_TREND_CHARGING) {
+        return POWER_PROFILE_PERFORMANCE;
+    }
+    for (int p = POWER_PROFILE_ENDURANCE; p > POWER_PROFILE_PERFORMANCE; p--) {
+        int margin = (int)current >= p ? POWER_GOVERNOR_HYSTERESIS : 0;
+        if (battery->level <= params[p].level + margin) return (power_profile_t)p;
+        if (battery->runtime_min >= 0 &&
+            battery->runtime_min <= params[p].runtime_min + margin * 3) {
+            return (power_profile_t)p;
+        }
+    }
+    return POWER_PROFILE_PERFORMANCE;
+}
+
+bool power_governor_service(void)
+{
+    power_profile_t setting = settings_get_power_profile();
+    int64_t now = esp_timer_get_time() / 1000;
+    if (setting == chosen && now < next_sample_ms) return false;
+    next_sample_ms = now + BATTERY_SAMPLE_PERIOD_MS;
+
+    power_profile_t current = (power_profile_t)active;
+    power_profile_t next = setting;
+    battery_reading_t battery = battery_get_reading();
+    if (setting == POWER_PROFILE_AUTO) {
+        next = auto_profile(&battery, current);
+    }
+    bool announce = setting == POWER_PROFILE_AUTO && setting == chosen;
+    chosen = setting;
+    if (next == current) return false;
+
+    active = (uint8_t)next;
+    ESP_LOGI(TAG, "%s profile (battery %d%%, %d min left)", params[next].name,
+             battery.level, battery.runtime_min);
+    if (announce) {
+        char text[32];
+        snprintf(text, sizeof(text), "Power: %s", params[next].name);
+        screen_manager_show_banner(text, POWER_GOVERNOR_BANNER_MS);
+    }
+    return true;
+}
+
+power_profile_t power_governor_profile(void)
+{
+    return (power_profile_t)active;
+}
+
+const char *power_governor_name(power_profile_t profile)
+{
+    return profile < POWER_PROFILE_COUNT ? params[profile].name : "?";
+}
+
+uint32_t power_governor_frame_ms(void)
+{
+    return params[active].frame_ms;
+}
+
+uint8_t power_governor_brightness(void)
+{
+    uint32_t level = settings_get_screen_brightness() * params[active].backlight_pct / 100;
+    return level > 0 ? (uint8_t)level : 1;
+}
+
+uint32_t power_governor_scale_ms(uint32_t interval_ms)
+{
+    return interval_ms * params[active].interval_scale;
+}
+
+bool power_governor_defer_compression(void)
+{
+    return params[active].defer_compression;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file power_governor.h
+ * @brief Battery-aware trade of responsiveness for runtime
+ *
+ * A power profile scales the costs that run for as long as a session
+ * does:
+ *
+ *   profile       frame cap  backlight  rescans, GPS  session log drafts
+ *   Performance   33 ms      100%       x1            compressed
+ *   Balanced      50 ms      70%        x2            compressed
+ *   Endurance     100 ms     40%        x4            stored raw
+ *
+ * "Rescans, GPS" multiplies the continuous rescan intervals
+ * (uart_rescan_if_due) and the CAP GPS forwarding cadence. Backlight is a
+ * share of the brightness setting. In Endurance a session log block is
+ * compressed once, when it is complete, instead of at every sync.
+ *
+ * The profile is a setting; Auto picks one from the background battery
+ * reading: Endurance at or below POWER_GOVERNOR_ENDURANCE_LEVEL percent
+ * or POWER_GOVERNOR_ENDURANCE_RUNTIME_MIN minutes left at the current
+ * drain, Balanced at or below the BALANCED pair, Performance above them
+ * or while charging. Stepping back up takes POWER_GOVERNOR_HYSTERESIS
+ * more, so a reading near a threshold does not flap. Getters are safe
+ * from any task.
+ */
+
+#ifndef POWER_GOVERNOR_H
+#define POWER_GOVERNOR_H
+
+#include "settings.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef CONFIG_POWER_GOVERNOR_BALANCED_LEVEL
+#define POWER_GOVERNOR_BALANCED_LEVEL   CONFIG_POWER_GOVERNOR_BALANCED_LEVEL
+#else
+#define POWER_GOVERNOR_BALANCED_LEVEL   50
+#endif
+
+#ifdef CONFIG_POWER_GOVERNOR_ENDURANCE_LEVEL
+#define POWER_GOVERNOR_ENDURANCE_LEVEL  CONFIG_POWER_GOVERNOR_ENDURANCE_LEVEL
+#else
+#define POWER_GOVERNOR_ENDURANCE_LEVEL  20
+#endif
+
+#define POWER_GOVERNOR_BALANCED_RUNTIME_MIN     120
+#define POWER_GOVERNOR_ENDURANCE_RUNTIME_MIN    45
+#define POWER_GOVERNOR_HYSTERESIS               5       // Percent, and minutes x3
+#define POWER_GOVERNOR_BANNER_MS                3000
+
+/**
+ * @brief Re-evaluate the profile (main loop)
+ *
+ * Looks at the battery once per sample and at the setting every call;
+ * an Auto change is announced with a banner.
+ * @return true if the profile changed and the backlight needs setting again
+ */
+bool power_governor_service(void);
+
+/**
+ * @brief Profile in force, never POWER_PROFILE_AUTO
+ */
+power_profile_t power_governor_profile(void);
+
+/**
+ * @brief Display name of a profile ("Auto", "Performance", ...)
+ */
+const char *power_governor_name(power_profile_t profile);
+
+/**
+ * @brief Shortest gap between two rendered frames
+ */
+uint32_t power_governor_frame_ms(void);
+
+/**
+ * @brief Backlight for the brightness setting under the profile (1-100)
+ */
+uint8_t power_governor_brightness(void);
+
+/**
+ * @brief Stretch a background interval (rescans, GPS forwarding) by the profile
+ */
+uint32_t power_governor_scale_ms(uint32_t interval_ms);
+
+/**
+ * @brief Whether partial session log blocks are stored without compressing
+ */
+bool power_governor_defer_compression(void);
+
+#endif // POWER_GOVERNOR_H
@@ -0,0 +1,278 @@
+/**
+ * @file probe_store.c
+ * @brief Shared store for probed SSIDs, fed by show_probes and list_probes
+ */
+
+#include "probe_store.h"
+#include "mem_monitor.h"
+#include "mac_set.h"
+#include "fixed_containers.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+static const char *TAG = "PROBE_STORE";
+
+MEM_BUDGET(probe_store, PROBE_STORE_MAX, sizeof(probe_record_t), MEM_BUDGET_HEAP);
+
+static probe_record_t *records = NULL;
+static mac_set_t index_set;             // SSID hash -> records[] index
+static mac_set_t pair_set;              // (SSID, station) hashes already counted
+static SemaphoreHandle_t store_mutex = NULL;
+static volatile uint32_t generation = 0;
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+esp_err_t probe_store_init(void)
+{
+    if (records) return ESP_OK;
+
+    if (!store_mutex) {
+        store_mutex = xSemaphoreCreateMutex();
+        if (!store_mutex) return ESP_ERR_NO_MEM;
+    }
+
+    probe_record_t *recs = calloc(PROBE_STORE_MAX, sizeof(probe_record_t));
+    if (!recs || ssid_pool_init() != ESP_OK || mac_set_init(&index_set, PROBE_STORE_MAX) != ESP_OK ||
+        mac_set_init(&pair_set, PROBE_STORE_PAIRS) != ESP_OK) {
+        ESP_LOGE(TAG, "No memory for %d probed SSIDs", PROBE_STORE_MAX);
+        mac_set_free(&index_set);
+        free(recs);
+        return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    records = recs;
+    xSemaphoreGive(store_mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Find or add an SSID (store_mutex held)
+ * @return Record index, or -1
+ */
+static int intern_ssid(const char *ssid, uint32_t now)
+{
+    uint64_t key = mac_set_key_from_string(ssid);
+    int index = mac_set_find(&index_set, key);
+    if (index < 0) {
+        int handle = ssid_pool_acquire(ssid);
+        if (handle < 0) return -1;
+
+        bool is_new;
+        index = mac_set_add(&index_set, key, &is_new);
+        if (index < 0) {
+            ssid_pool_release(handle);
+            return -1;
+        }
+
+        // New or least recently listed slot
+        probe_record_t *rec = &records[index];
+        ssid_pool_release(rec->ssid);
+        memset(rec, 0, sizeof(*rec));
+        rec->ssid = (ssid_handle_t)handle;
+        rec->first_seen_ms = now;
+    }
+    records[index].last_seen_ms = now;
+    return index;
+}
+
+static void trim_right(char *text)
+{
+    size_t len = strlen(text);
+    while (len > 0 && (text[len - 1] == '\n' || text[len - 1] == '\r' || text[len - 1] == ' ')) {
+        text[--len] = '\0';
+    }
+}
+
+int probe_store_add_probe_line(const char *line)
+{
+    if (!records || !line) return -1;
+
+    // Station MAC in the last parentheses
+    const char *open = strrchr(line, '(');
+    if (!open || open == line) return -1;
+    uint64_t mac_key;
+    if (!mac_set_key_from_mac(open + 1, &mac_key)) return -1;
+    const char *close = strchr(open, ')');
+    if (!close) return -1;
+
+    char ssid[PROBE_SSID_LEN];
+    size_t len = open - line;
+    if (len >= sizeof(ssid)) len = sizeof(ssid) - 1;
+    memcpy(ssid, line, len);
+    ssid[len] = '\0';
+    trim_right(ssid);
+    if (!ssid[0]) return -1;
+
+    char pair[PROBE_SSID_LEN + 20];
+    snprintf(pair, sizeof(pair), "%s\x1f%012llx", ssid, (unsigned long long)mac_key);
+    uint64_t pair_key = mac_set_key_from_string(pair);
+
+    uint32_t now = now_ms();
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+
+    int index = intern_ssid(ssid, now);
+    if (index >= 0) {
+        // A station listed again counts once
+        bool is_new;
+        mac_set_add(&pair_set, pair_key, &is_new);
+        if (is_new && records[index].clients < UINT16_MAX) {
+            records[index].clients++;
+        }
+        generation++;
+    }
+
+    xSemaphoreGive(store_mutex);
+    return index;
+}
+
+void probe_store_begin_list(void)
+{
+    if (!records) return;
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    for (int i = 0; i < index_set.count; i++) {
+        records[i].janos_id = 0;
+    }
+    generation++;
+    xSemaphoreGive(store_mutex);
+}
+
+int probe_store_add_list_line(const char *line)
+{
+    if (!records || !line) return -1;
+
+    // "1 SSID" or " 1 SSID"
+    const char *p = line;
+    while (*p == ' ') p++;
+    if (!isdigit((unsigned char)*p)) return -1;
+    int janos_id = atoi(p);
+    while (isdigit((unsigned char)*p)) p++;
+    if (*p != ' ' || janos_id <= 0 || janos_id > UINT16_MAX) return -1;
+    p++;
+
+    char ssid[PROBE_SSID_LEN];
+    strlcpy(ssid, p, sizeof(ssid));
+    trim_right(ssid);
+    if (!ssid[0]) return -1;
+
+    uint32_t now = now_ms();
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+
+    int index = intern_ssid(ssid, now);
+    if (index >= 0) {
+        records[index].janos_id = (uint16_t)janos_id;
+        generation++;
+    }
+
+    xSemaphoreGive(store_mutex);
+    return index;
+}
+
+int probe_store_restore(const char *ssid, uint16_t clients)
+{
+    if (!records || !ssid || !ssid[0]) return -1;
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+
+    int index = intern_ssid(ssid, 0);
+    if (index >= 0) {
+        if (clients > records[index].clients) records[index].clients = clients;
+        generation++;
+    }
+
+    xSemaphoreGive(store_mutex);
+    return index;
+}
+
+int probe_store_pair_keys(uint64_t *out, int max)
+{
+    if (!records || !out) return 0;
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    int n = pair_set.count < max ? pair_set.count : max;
+    memcpy(out, pair_set.keys, n * sizeof(out[0]));
+    xSemaphoreGive(store_mutex);
+    return n;
+}
+
+void probe_store_restore_pair(uint64_t key)
+{
+    if (!records) return;
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    mac_set_add(&pair_set, key, NULL);
+    xSemaphoreGive(store_mutex);
+}
+
+int probe_store_count(void)
+{
+    return records ? index_set.count : 0;
+}
+
+bool probe_store_get(int index, probe_record_t *out)
+{
+    if (!records || index < 0 || index >= index_set.count) return false;
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    *out = records[index];
+    xSemaphoreGive(store_mutex);
+    return true;
+}
+
+int probe_store_find(const char *ssid)
+{
+    if (!records || !ssid || !ssid[0]) return -1;
+
+    uint64_t key = mac_set_key_from_string(ssid);
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    int index = mac_set_find(&index_set, key);
+    xSemaphoreGive(store_mutex);
+    return index;
+}
+
+uint32_t probe_store_generation(void)
+{
+    return generation;
+}
+
+static int compare_indices(int ia, int ib, void *ctx)
+{
+    const probe_record_t *a = &records[ia];
+    const probe_record_t *b = &records[ib];
+    int r = 0;
+
+    if (*(const probe_sort_t *)ctx == PROBE_SORT_POPULAR) {
+        r = (int)b->clients - (int)a->clients;
+    }
+    if (!r) {
+        r = (b->last_seen_ms > a->last_seen_ms) - (b->last_seen_ms < a->last_seen_ms);
+    }
+
+    // Stable: ties keep store order
+    return r ? r : ia - ib;
+}
+
+int probe_store_view(uint16_t *order, int max, probe_sort_t sort, bool listed_only)
+{
+    if (!records || !order) return 0;
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+
+    int n = 0;
+    for (int i = 0; i < index_set.count && n < max; i++) {
+        if (listed_only && records[i].janos_id == 0) continue;
+        order[n++] = (uint16_t)i;
+    }
+    fixed_index_sort(order, n, compare_indices, &sort);
+
+    xSemaphoreGive(store_mutex);
+    return n;
+}
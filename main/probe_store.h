@@ -0,0 +1,129 @@
+/**
+ * @file probe_store.h
+ * @brief Shared store for probed SSIDs, fed by show_probes and list_probes
+ *
+ * Each probed SSID is kept once, hash-indexed by its name (mac_set), its
+ * text interned in ssid_pool alongside the scan results,
+ * with the number of distinct stations that asked for it and when it was
+ * last listed. A second set remembers (SSID, station) pairs so a station
+ * listed again is not counted twice. list_probes rows also record the
+ * number JanOS selects the SSID by, which Karma needs to start.
+ *
+ * When the store is full the least recently listed SSID is replaced.
+ * Records are added by the UART RX task; any task may read.
+ */
+
+#ifndef PROBE_STORE_H
+#define PROBE_STORE_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "ssid_pool.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef CONFIG_PROBE_STORE_MAX_ENTRIES
+#define PROBE_STORE_MAX         CONFIG_PROBE_STORE_MAX_ENTRIES
+#else
+#define PROBE_STORE_MAX         128
+#endif
+#define PROBE_STORE_PAIRS       512     // (SSID, station) pairs remembered
+#define PROBE_SSID_LEN          33
+
+// One probed SSID
+typedef struct {
+    ssid_handle_t ssid;         // ssid_pool handle; read with ssid_pool_str()
+    uint16_t janos_id;          // list_probes number, 0 = not listed yet
+    uint16_t clients;           // Distinct stations that probed for it
+    uint32_t first_seen_ms;     // Uptime when first listed
+    uint32_t last_seen_ms;
+} probe_record_t;
+
+// Sort keys for probe_store_view()
+typedef enum {
+    PROBE_SORT_POPULAR = 0,     // Most stations first, then most recent
+    PROBE_SORT_LAST_SEEN,       // Most recent first
+} probe_sort_t;
+
+/**
+ * @brief Allocate the store (safe to call again; keeps existing SSIDs)
+ * @return ESP_OK, ESP_ERR_NO_MEM
+ */
+esp_err_t probe_store_init(void);
+
+/**
+ * @brief Add a show_probes row
+ *
+ * Format: "SSID (AA:BB:CC:DD:EE:FF)"
+ * @return Record index, or -1 if the line is not a probe row
+ */
+int probe_store_add_probe_line(const char *line);
+
+/**
+ * @brief Forget list_probes numbers before JanOS lists them again
+ */
+void probe_store_begin_list(void);
+
+/**
+ * @brief Add a list_probes row and its JanOS number
+ *
+ * Format: "1 SSID"
+ * @return Record index, or -1 if the line is not a list row
+ */
+int probe_store_add_list_line(const char *line);
+
+/**
+ * @brief Put back an SSID saved before a reboot (store_snapshot)
+ *
+ * Times become 0 (before this boot) and the list_probes number is not
+ * kept; an SSID already listed since boot keeps the larger client count.
+ * @return Record index, or -1 if the store has no room
+ */
+int probe_store_restore(const char *ssid, uint16_t clients);
+
+/**
+ * @brief Copy the (SSID, station) pair hashes, so a restored store does
+ *        not count a station it already counted again
+ * @param out Receives up to max keys (PROBE_STORE_PAIRS is always enough)
+ * @return Keys written
+ */
+int probe_store_pair_keys(uint64_t *out, int max);
+
+/**
+ * @brief Put back a pair hash from probe_store_pair_keys()
+ */
+void probe_store_restore_pair(uint64_t key);
+
+/**
+ * @brief SSIDs in the store (indices 0 .. count - 1)
+ */
+int probe_store_count(void);
+
+/**
+ * @brief Copy a record
+ * @return false if index is out of range
+ */
+bool probe_store_get(int index, probe_record_t *out);
+
+/**
+ * @brief Index of an SSID's record (one hash lookup)
+ * @return Record index, -1 if nobody probed for it
+ */
+int probe_store_find(const char *ssid);
+
+/**
+ * @brief Counter bumped on every change
+ */
+uint32_t probe_store_generation(void);
+
+/**
+ * @brief Build a sorted list of record indices
+ * @param order Destination (PROBE_STORE_MAX entries is always enough)
+ * @param max Size of order
+ * @param sort Sort key
+ * @param listed_only Leave out SSIDs without a list_probes number
+ * @return Number of indices written
+ */
+int probe_store_view(uint16_t *order, int max, probe_sort_t sort, bool listed_only);
+
+#endif // PROBE_STORE_H
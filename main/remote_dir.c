@@ -0,0 +1,258 @@
+/**
+ * @file remote_dir.c
+ * @brief Paged access to a JanOS SD directory listing
+ *
+ * Output of "list_dir <path>":
+ * Files in /sdcard/lab/handshakes:
+ * 1 VMA84A66C-2.4_83C73F_91148.hccapx
+ * 2 VMA84A66C-2.4_83C73F_91148.pcap
+ * Found 2 file(s) in /sdcard/lab/handshakes
+ */
+
+#include "remote_dir.h"
+#include "uart_handler.h"
+#include "uart_progress.h"
+#include "janos_proto.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static const char *TAG = "REMOTE_DIR";
+
+#define POOL_INITIAL    2048
+
+// One entry; the name is NUL-terminated in the pool
+typedef struct {
+    uint16_t id;
+    uint16_t offset;
+} dir_entry_t;
+
+// Listing, written by the UART RX task and read under dir_mutex
+static dir_entry_t *entries = NULL;
+static int entry_count = 0;
+static char *pool = NULL;
+static size_t pool_size = 0;
+static size_t pool_used = 0;
+static char dir_path[REMOTE_DIR_PATH_LEN];
+static char dir_ext[REMOTE_DIR_EXT_LEN];
+static bool got_header = false;
+static volatile remote_dir_state_t state = REMOTE_DIR_EMPTY;
+static volatile uint32_t generation = 0;
+static volatile bool stale = false;     // Invalidated while a listing was in flight
+static uint32_t dropped = 0;
+static SemaphoreHandle_t dir_mutex = NULL;
+
+/**
+ * @brief Make room for len more name bytes
+ */
+static bool pool_reserve(size_t len)
+{
+    if (pool_used + len <= pool_size) return true;
+
+    size_t size = pool_size ? pool_size : POOL_INITIAL;
+    while (size < pool_used + len) size *= 2;
+    if (size > REMOTE_DIR_POOL_MAX) size = REMOTE_DIR_POOL_MAX;
+    if (pool_used + len > size) return false;
+
+    char *grown = realloc(pool, size);
+    if (!grown) return false;
+    pool = grown;
+    pool_size = size;
+    return true;
+}
+
+/**
+ * @brief Add one "N name" row if it passes the extension filter
+ */
+static void add_row(int id, const char *name, size_t len)
+{
+    size_t ext_len = strlen(dir_ext);
+    if (ext_len) {
+        if (len <= ext_len || strncasecmp(name + len - ext_len, dir_ext, ext_len) != 0) return;
+        len -= ext_len;
+    }
+    if (len >= REMOTE_DIR_NAME_LEN) len = REMOTE_DIR_NAME_LEN - 1;
+
+    bool page = false;
+    xSemaphoreTake(dir_mutex, portMAX_DELAY);
+    if (entry_count >= REMOTE_DIR_MAX_ENTRIES || !pool_reserve(len + 1)) {
+        dropped++;
+    } else {
+        dir_entry_t *e = &entries[entry_count++];
+        e->id = (uint16_t)id;
+        e->offset = (uint16_t)pool_used;
+        memcpy(pool + pool_used, name, len);
+        pool[pool_used + len] = '\0';
+        pool_used += len + 1;
+        page = entry_count % REMOTE_DIR_PAGE_ROWS == 0;
+        if (page) generation++;
+    }
+    int count = entry_count;
+    xSemaphoreGive(dir_mutex);
+
+    // Once per page, like the generation
+    if (page) {
+        uart_progress_record_t progress;
+        uart_progress_get(UART_OP_LIST_DIR, &progress);
+        progress.done = count;
+        progress.skipped = dropped;
+        uart_progress_publish(&progress);
+    }
+}
+
+/**
+ * @brief Parse one reply line
+ * @return true on the "Found N file(s)" footer or a no-files message
+ */
+static bool on_dir_line(const char *line, void *user_data)
+{
+    (void)user_data;
+
+    if (strncmp(line, "Files in", 8) == 0) {
+        got_header = true;
+        return false;
+    }
+    if (strncmp(line, "Found", 5) == 0) return true;
+    if (strstr(line, "No ") || strstr(line, "no ") || strstr(line, "not found") ||
+        strstr(line, "empty") || strstr(line, "Empty")) {
+        return true;
+    }
+
+    janos_list_row_t row;
+    if (janos_parse_list_row(line, &row)) add_row(row.id, row.name.ptr, row.name.len);
+    return false;
+}
+
+static void on_dir_done(uart_request_status_t status, void *user_data)
+{
+    (void)user_data;
+
+    xSemaphoreTake(dir_mutex, portMAX_DELAY);
+    if (status == UART_REQUEST_TIMEOUT && !got_header) {
+        entry_count = 0;
+        pool_used = 0;
+        state = REMOTE_DIR_EMPTY;
+        ESP_LOGW(TAG, "No listing of %s from JanOS", dir_path);
+    } else {
+        state = stale ? REMOTE_DIR_EMPTY : REMOTE_DIR_READY;
+        ESP_LOGI(TAG, "Listed %d entries of %s (%lu dropped%s)", entry_count, dir_path,
+                 (unsigned long)dropped, status == UART_REQUEST_TIMEOUT ? ", timed out" : "");
+    }
+    stale = false;
+    generation++;
+    uart_progress_record_t progress = {
+        .op = UART_OP_LIST_DIR,
+        .state = state == REMOTE_DIR_READY ? UART_PROGRESS_DONE : UART_PROGRESS_ERROR,
+        .percent = 100,
+        .done = entry_count,
+        .total = entry_count,
+        .skipped = dropped,
+    };
+    xSemaphoreGive(dir_mutex);
+
+    if (progress.state == UART_PROGRESS_ERROR) {
+        strlcpy(progress.text, "No listing from board", sizeof(progress.text));
+    }
+    uart_progress_publish(&progress);
+}
+
+esp_err_t remote_dir_open(const char *path, const char *ext, bool force)
+{
+    if (!path) return ESP_ERR_INVALID_ARG;
+    if (!dir_mutex) {
+        dir_mutex = xSemaphoreCreateMutex();
+        entries = malloc(sizeof(dir_entry_t) * REMOTE_DIR_MAX_ENTRIES);
+        if (!dir_mutex || !entries) return ESP_ERR_NO_MEM;
+    }
+
+    bool same = strcmp(path, dir_path) == 0 && strcmp(ext ? ext : "", dir_ext) == 0;
+    if (same && state == REMOTE_DIR_LOADING) return ESP_OK;
+    if (same && state == REMOTE_DIR_READY && !force) return ESP_OK;
+    if (state == REMOTE_DIR_LOADING) return ESP_ERR_INVALID_STATE;
+
+    char cmd[UART_REQUEST_CMD_LEN];
+    snprintf(cmd, sizeof(cmd), "list_dir %s", path);
+
+    xSemaphoreTake(dir_mutex, portMAX_DELAY);
+    strlcpy(dir_path, path, sizeof(dir_path));
+    strlcpy(dir_ext, ext ? ext : "", sizeof(dir_ext));
+    entry_count = 0;
+    pool_used = 0;
+    dropped = 0;
+    got_header = false;
+    stale = false;
+    state = REMOTE_DIR_LOADING;
+    generation++;
+    xSemaphoreGive(dir_mutex);
+
+    uart_progress_begin(UART_OP_LIST_DIR, "Loading...", 0);
+
+    const uart_request_t req = {
+        .cmd = cmd,
+        .on_line = on_dir_line,
+        .on_done = on_dir_done,
+        .timeout_ms = REMOTE_DIR_TIMEOUT_MS,
+    };
+    esp_err_t ret = uart_request(&req);
+    if (ret != ESP_OK) {
+        state = REMOTE_DIR_EMPTY;
+        uart_progress_record_t progress = {
+            .op = UART_OP_LIST_DIR,
+            .state = UART_PROGRESS_ERROR,
+            .percent = UART_PROGRESS_UNKNOWN,
+        };
+        uart_progress_publish(&progress);
+    }
+    return ret;
+}
+
+void remote_dir_invalidate(const char *path)
+{
+    if (!path || strcmp(path, dir_path) != 0) return;
+
+    if (state == REMOTE_DIR_LOADING) {
+        stale = true;
+    } else if (state == REMOTE_DIR_READY) {
+        state = REMOTE_DIR_EMPTY;
+    }
+}
+
+const char *remote_dir_path(void)
+{
+    return dir_path;
+}
+
+remote_dir_state_t remote_dir_state(void)
+{
+    return state;
+}
+
+uint32_t remote_dir_generation(void)
+{
+    return generation;
+}
+
+int remote_dir_count(void)
+{
+    return entry_count;
+}
+
+int remote_dir_page(int offset, int count, remote_dir_order_t order, remote_dir_entry_t *out)
+{
+    if (!dir_mutex || !out || offset < 0) return 0;
+
+    xSemaphoreTake(dir_mutex, portMAX_DELAY);
+    int n = 0;
+    for (int i = offset; i < entry_count && n < count; i++) {
+        int idx = (order == REMOTE_DIR_ORDER_NEWEST) ? entry_count - 1 - i : i;
+        out[n].id = entries[idx].id;
+        strlcpy(out[n].name, pool + entries[idx].offset, sizeof(out[n].name));
+        n++;
+    }
+    xSemaphoreGive(dir_mutex);
+    return n;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file remote_dir.h
+ * @brief Paged access to a JanOS SD directory listing
+ *
+ * list_dir streams the whole directory, so the listing is fetched once,
+ * filtered by extension as the rows arrive and kept in a packed name pool.
+ * Screens read it a page at a time and hold only the rows they show. The
+ * listing survives screen pops and is fetched again after
+ * remote_dir_invalidate() or when another directory is opened.
+ *
+ * Listing progress is published as UART_OP_LIST_DIR (uart_progress.h):
+ * rows so far once per page, then done or error.
+ */
+
+#ifndef REMOTE_DIR_H
+#define REMOTE_DIR_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define REMOTE_DIR_MAX_ENTRIES  1024
+#define REMOTE_DIR_POOL_MAX     (32 * 1024)     // Name bytes, grown on demand
+#define REMOTE_DIR_NAME_LEN     48
+#define REMOTE_DIR_PATH_LEN     48
+#define REMOTE_DIR_EXT_LEN      12
+#define REMOTE_DIR_TIMEOUT_MS   10000
+#define REMOTE_DIR_PAGE_ROWS    6               // Generation bumps each this many rows
+
+typedef enum {
+    REMOTE_DIR_EMPTY = 0,       // Never listed, or invalidated
+    REMOTE_DIR_LOADING,         // list_dir in flight; rows appear as they arrive
+    REMOTE_DIR_READY,
+} remote_dir_state_t;
+
+typedef enum {
+    REMOTE_DIR_ORDER_LISTED = 0,    // Directory order as JanOS lists it
+    REMOTE_DIR_ORDER_NEWEST,        // Reverse directory order
+} remote_dir_order_t;
+
+typedef struct {
+    int id;                     // 1-based index from list_dir
+    char name[REMOTE_DIR_NAME_LEN];
+} remote_dir_entry_t;
+
+/**
+ * @brief List a directory unless the same listing is cached
+ * @param path Directory on the JanOS SD card, e.g. "/sdcard/lab/handshakes"
+ * @param ext Keep only names ending in this extension, stored without it (NULL = all)
+ * @param force List again even if cached
+ * @return ESP_OK if cached or requested, else an error
+ */
+esp_err_t remote_dir_open(const char *path, const char *ext, bool force);
+
+/**
+ * @brief Drop the listing if it is of this directory
+ *
+ * Safe to call from UART callbacks.
+ * @param path Directory that changed
+ */
+void remote_dir_invalidate(const char *path);
+
+remote_dir_state_t remote_dir_state(void);
+
+/**
+ * @brief Directory last opened, "" if none
+ */
+const char *remote_dir_path(void);
+
+/**
+ * @brief Bumps every REMOTE_DIR_PAGE_ROWS rows, at the end and on invalidate
+ */
+uint32_t remote_dir_generation(void);
+
+/**
+ * @return Entries listed so far
+ */
+int remote_dir_count(void);
+
+/**
+ * @brief Copy a page of entries
+ * @param offset First entry in the given order
+ * @param count Capacity of out
+ * @param order Listing order
+ * @param out Receives the entries
+ * @return Entries copied
+ */
+int remote_dir_page(int offset, int count, remote_dir_order_t order, remote_dir_entry_t *out);
+
+#endif // REMOTE_DIR_H
@@ -0,0 +1,482 @@
+/**
+ * @file scenario.c
+ * @brief Scripted UI scenarios played on the device and timed step by step
+ */
+
+#include "scenario.h"
+#include "version.h"
+#include "task_plan.h"
+#include "app_events.h"
+#include "screen_manager.h"
+#include "uart_progress.h"
+#include "uart_transcript.h"
+#include "keyboard.h"
+#include "keymap.h"
+#include "display.h"
+#include "screenshot.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+
+static const char *TAG = "SCENARIO";
+
+// Named keys; letters and digits are parsed separately
+static const struct {
+    const char *name;
+    key_code_t key;
+} key_names[] = {
+    { "UP", KEY_UP }, { "DOWN", KEY_DOWN }, { "LEFT", KEY_LEFT }, { "RIGHT", KEY_RIGHT },
+    { "ENTER", KEY_ENTER }, { "ESC", KEY_ESC }, { "SPACE", KEY_SPACE },
+    { "BACKSPACE", KEY_BACKSPACE }, { "TAB", KEY_TAB }, { "DEL", KEY_DEL },
+};
+
+// One run: script, report and what the steps measure against
+typedef struct {
+    FILE *script;
+    FILE *report;
+    char label[32];
+    int step;
+    int line;
+    uint32_t progress_mark[UART_OP_COUNT];  // Sequences at the last action
+} run_t;
+
+// What a step measured
+typedef struct {
+    bool ok;
+    char result[24];
+    int64_t start_us;
+    int64_t end_us;                 // Where the step's time ends
+    display_stats_t display;        // At the start
+} step_t;
+
+static scenario_status_t status;
+static char script_path[SCENARIO_PATH_LEN];
+static portMUX_TYPE status_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void set_error(const char *error)
+{
+    portENTER_CRITICAL(&status_lock);
+    status.failed = true;
+    snprintf(status.error, sizeof(status.error), "%s", error);
+    portEXIT_CRITICAL(&status_lock);
+}
+
+static bool parse_key(const char *name, key_code_t *out)
+{
+    for (size_t i = 0; i < sizeof(key_names) / sizeof(key_names[0]); i++) {
+        if (strcasecmp(name, key_names[i].name) == 0) {
+            *out = key_names[i].key;
+            return true;
+        }
+    }
+    if (name[0] && !name[1]) {
+        char c = (char)tolower((unsigned char)name[0]);
+        if (c >= 'a' && c <= 'z') {
+            *out = (key_code_t)(KEY_A + (c - 'a'));
+            return true;
+        }
+        if (c >= '0' && c <= '9') {
+            *out = (key_code_t)(KEY_0 + (c - '0'));
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Key typing a character without modifiers
+ */
+static bool key_for_char(char c, key_code_t *out)
+{
+    for (int k = 0; k < KEY_MAX; k++) {
+        if (keymap_char((key_code_t)k, false, false) == c) {
+            *out = (key_code_t)k;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void mark_progress(run_t *run)
+{
+    uart_progress_record_t rec;
+    for (int op = 0; op < UART_OP_COUNT; op++) {
+        run->progress_mark[op] = uart_progress_get((uart_op_t)op, &rec);
+    }
+}
+
+/**
+ * @brief Press a key and wait for the first frame it causes
+ * @return Whether a frame was flushed within SCENARIO_FRAME_WAIT_MS
+ */
+static bool press(key_code_t key, int64_t *frame_us)
+{
+    display_stats_t before, now;
+    display_get_stats(&before);
+    if (keyboard_inject(key) != ESP_OK) return false;
+    app_events_post(APP_EVENT_KEY);
+
+    int64_t deadline = esp_timer_get_time() + SCENARIO_FRAME_WAIT_MS * 1000LL;
+    do {
+        vTaskDelay(pdMS_TO_TICKS(SCENARIO_POLL_MS));
+        display_get_stats(&now);
+        if (now.flushes != before.flushes) {
+            *frame_us = esp_timer_get_time();
+            return true;
+        }
+    } while (esp_timer_get_time() < deadline);
+    *frame_us = esp_timer_get_time();
+    return false;
+}
+
+/**
+ * @brief Run the key presses of a key or type step
+ */
+static void press_keys(const key_code_t *keys, int count, step_t *step)
+{
+    int missed = 0;
+    for (int i = 0; i < count; i++) {
+        if (!press(keys[i], &step->end_us)) missed++;
+    }
+    step->ok = true;
+    if (missed) {
+        snprintf(step->result, sizeof(step->result), "%d no frame", missed);
+        portENTER_CRITICAL(&status_lock);
+        status.misses += missed;
+        portEXIT_CRITICAL(&status_lock);
+    } else {
+        snprintf(step->result, sizeof(step->result), "ok");
+    }
+}
+
+/**
+ * @brief Whether a scan or listing finished since the last action
+ */
+static bool op_finished(const run_t *run, uart_op_t op, step_t *step)
+{
+    uart_progress_record_t rec;
+    uint32_t seq = uart_progress_get(op, &rec);
+    if (seq == run->progress_mark[op]) return false;
+    if (rec.state == UART_PROGRESS_DONE) {
+        snprintf(step->result, sizeof(step->result), "%u rows", rec.done);
+        return true;
+    }
+    if (rec.state == UART_PROGRESS_ERROR) {
+        snprintf(step->result, sizeof(step->result), "error");
+        return true;
+    }
+    return false;
+}
+
+static bool rows_reached(const run_t *run, int rows, step_t *step)
+{
+    static const uart_op_t ops[] = { UART_OP_WIFI_SCAN, UART_OP_LIST_DIR };
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        uart_progress_record_t rec;
+        uint32_t seq = uart_progress_get(ops[i], &rec);
+        if (seq != run->progress_mark[ops[i]] && rec.done >= rows) {
+            snprintf(step->result, sizeof(step->result), "%u rows", rec.done);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Poll a wait condition until it holds or the timeout runs out
+ */
+static void wait_for(const run_t *run, const char *what, int arg, int timeout_ms, step_t *step)
+{
+    int64_t deadline = step->start_us + timeout_ms * 1000LL;
+    display_stats_t last = step->display;
+    int64_t last_frame_us = step->start_us;
+
+    for (;;) {
+        int64_t now_us = esp_timer_get_time();
+        bool met = false;
+
+        if (strcmp(what, "scan") == 0) {
+            met = op_finished(run, UART_OP_WIFI_SCAN, step);
+        } else if (strcmp(what, "list") == 0) {
+            met = op_finished(run, UART_OP_LIST_DIR, step);
+        } else if (strcmp(what, "rows") == 0) {
+            met = rows_reached(run, arg, step);
+        } else if (strcmp(what, "replay") == 0) {
+            uart_transcript_status_t st;
+            uart_transcript_get_status(&st);
+            met = !st.replaying;
+            if (met) snprintf(step->result, sizeof(step->result), "%lu B", (unsigned long)st.bytes);
+        } else {
+            // idle: time to the last frame before a quiet spell of arg ms
+            display_stats_t ds;
+            display_get_stats(&ds);
+            if (ds.flushes != last.flushes) {
+                last = ds;
+                last_frame_us = now_us;
+            }
+            met = now_us - last_frame_us >= arg * 1000LL;
+            if (met) {
+                step->ok = true;
+                step->end_us = last_frame_us;
+                snprintf(step->result, sizeof(step->result), "settled");
+                return;
+            }
+        }
+
+        if (met) {
+            step->ok = true;
+            step->end_us = now_us;
+            return;
+        }
+        if (now_us >= deadline) {
+            step->end_us = now_us;
+            snprintf(step->result, sizeof(step->result), "timeout");
+            return;
+        }
+        vTaskDelay(pdMS_TO_TICKS(SCENARIO_POLL_MS));
+    }
+}
+
+/**
+ * @brief Run one script line
+ * @return false if the run has to end
+ */
+static bool run_step(run_t *run, char *line, step_t *step)
+{
+    if (strncmp(line, "type ", 5) == 0) {
+        // The text is the rest of the line, spaces included
+        key_code_t keys[SCENARIO_LINE_LEN];
+        int count = 0;
+        for (const char *c = line + 5; *c; c++) {
+            if (!key_for_char(*c, &keys[count++])) return false;
+        }
+        mark_progress(run);
+        press_keys(keys, count, step);
+        return true;
+    }
+
+    char *cmd = strtok(line, " \t");
+    char *arg1 = strtok(NULL, " \t");
+    char *arg2 = strtok(NULL, " \t");
+    char *arg3 = strtok(NULL, " \t");
+
+    if (strcmp(cmd, "key") == 0) {
+        key_code_t key;
+        if (!arg1 || !parse_key(arg1, &key)) return false;
+        int count = arg2 && (arg2[0] == 'x' || arg2[0] == 'X') ? atoi(arg2 + 1) : 1;
+        if (count < 1 || count > SCENARIO_LINE_LEN) return false;
+        key_code_t keys[SCENARIO_LINE_LEN];
+        for (int i = 0; i < count; i++) keys[i] = key;
+        mark_progress(run);
+        press_keys(keys, count, step);
+        return true;
+    }
+
+    if (strcmp(cmd, "sleep") == 0) {
+        if (!arg1) return false;
+        vTaskDelay(pdMS_TO_TICKS(atoi(arg1)));
+        step->ok = true;
+        step->end_us = esp_timer_get_time();
+        snprintf(step->result, sizeof(step->result), "ok");
+        return true;
+    }
+
+    if (strcmp(cmd, "replay") == 0) {
+        char path[SCENARIO_PATH_LEN];
+        if (arg1 && arg1[0] != '/') {
+            snprintf(path, sizeof(path), "%s/%s", UART_TRANSCRIPT_DIR, arg1);
+        } else if (arg1) {
+            snprintf(path, sizeof(path), "%s", arg1);
+        }
+        int speed = arg2 ? atoi(arg2) : 1;
+        mark_progress(run);
+        esp_err_t ret = uart_transcript_replay_start(arg1 ? path : NULL, speed);
+        step->end_us = esp_timer_get_time();
+        step->ok = ret == ESP_OK;
+        snprintf(step->result, sizeof(step->result), "%s", step->ok ? "started" : esp_err_to_name(ret));
+        return step->ok;
+    }
+
+    if (strcmp(cmd, "wait") == 0) {
+        if (!arg1) return false;
+        int arg = 0;
+        const char *timeout = arg2;
+        if (strcmp(arg1, "rows") == 0 || strcmp(arg1, "idle") == 0) {
+            if (!arg2) return false;
+            arg = atoi(arg2);
+            timeout = arg3;
+        } else if (strcmp(arg1, "scan") != 0 && strcmp(arg1, "list") != 0 &&
+                   strcmp(arg1, "replay") != 0) {
+            return false;
+        }
+        wait_for(run, arg1, arg, timeout ? atoi(timeout) : SCENARIO_WAIT_MS, step);
+        return step->ok;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Create SCENARIO_REPORT_DIR/<name>_<board>_<N>.csv with the next free N
+ */
+static FILE *open_report(const char *name, char *path, size_t path_size)
+{
+    struct stat st;
+    if (stat(SCENARIO_REPORT_DIR, &st) != 0) mkdir(SCENARIO_REPORT_DIR, 0755);
+
+    char prefix[48];
+    int prefix_len = snprintf(prefix, sizeof(prefix), "%s_%s_", name, FIRMWARE_BOARD_NAME);
+    int max_num = 0;
+    DIR *dir = opendir(SCENARIO_REPORT_DIR);
+    if (dir) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (strncmp(entry->d_name, prefix, prefix_len) != 0) continue;
+            int num = atoi(entry->d_name + prefix_len);
+            if (num > max_num) max_num = num;
+        }
+        closedir(dir);
+    }
+
+    snprintf(path, path_size, "%s/%s%d.csv", SCENARIO_REPORT_DIR, prefix, max_num + 1);
+    FILE *f = fopen(path, "w");
+    if (f) fprintf(f, "firmware,board,step,line,label,command,result,ms,frames,kpixels\n");
+    return f;
+}
+
+static void write_row(run_t *run, const char *command, const step_t *step)
+{
+    display_stats_t end;
+    display_get_stats(&end);
+    // Commands are written as one CSV field; quotes in them become apostrophes
+    char field[SCENARIO_LINE_LEN];
+    snprintf(field, sizeof(field), "%s", command);
+    for (char *p = field; *p; p++) {
+        if (*p == '"') *p = '\'';
+    }
+    fprintf(run->report, "%s,%s,%d,%d,%s,\"%s\",%s,%.1f,%lu,%lu\n",
+            JANOS_ADV_VERSION, FIRMWARE_BOARD_NAME, run->step, run->line, run->label,
+            field, step->result, (step->end_us - step->start_us) / 1000.0,
+            (unsigned long)(end.flushes - step->display.flushes),
+            (unsigned long)((end.pixels - step->display.pixels) / 1000));
+    fflush(run->report);
+}
+
+static void scenario_task(void *arg)
+{
+    (void)arg;
+    run_t run = { .label = "-" };
+    char line[SCENARIO_LINE_LEN];
+    char command[SCENARIO_LINE_LEN];
+
+    run.script = fopen(script_path, "r");
+    char name[32];
+    snprintf(name, sizeof(name), "%s", status.name);
+    char *ext = strstr(name, SCENARIO_EXT);
+    if (ext) *ext = '\0';
+    char report_path[SCENARIO_PATH_LEN];
+    run.report = run.script ? open_report(name, report_path, sizeof(report_path)) : NULL;
+
+    if (!run.script || !run.report) {
+        set_error(run.script ? "cannot write report" : "cannot read script");
+    } else {
+        portENTER_CRITICAL(&status_lock);
+        snprintf(status.report, sizeof(status.report), "%s", report_path);
+        portEXIT_CRITICAL(&status_lock);
+
+        // Every run starts from the same place
+        screen_manager_lock();
+        screen_manager_pop_to_root();
+        screen_manager_unlock();
+        app_events_post(APP_EVENT_KEY);
+        vTaskDelay(pdMS_TO_TICKS(SCENARIO_SETTLE_MS));
+
+        while (fgets(line, sizeof(line), run.script)) {
+            run.line++;
+            line[strcspn(line, "\r\n")] = '\0';
+            char *text = line;
+            while (*text == ' ' || *text == '\t') text++;
+            if (*text == '\0' || *text == '#') continue;
+            snprintf(command, sizeof(command), "%s", text);
+
+            if (strncmp(text, "mark ", 5) == 0) {
+                snprintf(run.label, sizeof(run.label), "%s", text + 5);
+                continue;
+            }
+
+            step_t step = { .start_us = esp_timer_get_time() };
+            display_get_stats(&step.display);
+            run.step++;
+            bool go_on = run_step(&run, text, &step);
+            if (!step.result[0]) {
+                snprintf(step.result, sizeof(step.result), "bad step");
+                step.end_us = esp_timer_get_time();
+            }
+            write_row(&run, command, &step);
+
+            portENTER_CRITICAL(&status_lock);
+            status.steps = run.step;
+            portEXIT_CRITICAL(&status_lock);
+
+            if (!go_on) {
+                char error[48];
+                snprintf(error, sizeof(error), "line %d: %s", run.line, step.result);
+                set_error(error);
+                break;
+            }
+        }
+        ESP_LOGI(TAG, "%s: %d steps, report %s", status.name, run.step, report_path);
+    }
+
+    if (run.script) fclose(run.script);
+    if (run.report) fclose(run.report);
+    portENTER_CRITICAL(&status_lock);
+    status.running = false;
+    portEXIT_CRITICAL(&status_lock);
+    vTaskDelete(NULL);
+}
+
+esp_err_t scenario_start(const char *path)
+{
+    if (!path) return ESP_ERR_INVALID_ARG;
+    struct stat st;
+    if (!screenshot_is_available() || stat(path, &st) != 0) return ESP_ERR_NOT_FOUND;
+
+    portENTER_CRITICAL(&status_lock);
+    bool busy = status.running;
+    if (!busy) {
+        const char *base = strrchr(path, '/');
+        memset(&status, 0, sizeof(status));
+        status.running = true;
+        snprintf(status.name, sizeof(status.name), "%s", base ? base + 1 : path);
+        snprintf(script_path, sizeof(script_path), "%s", path);
+    }
+    portEXIT_CRITICAL(&status_lock);
+    if (busy) return ESP_ERR_INVALID_STATE;
+
+    if (xTaskCreatePinnedToCore(scenario_task, "scenario", TASK_SCENARIO_STACK, NULL,
+                                TASK_SCENARIO_PRIO, NULL, TASK_SCENARIO_CORE) != pdPASS) {
+        portENTER_CRITICAL(&status_lock);
+        status.running = false;
+        portEXIT_CRITICAL(&status_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Playing %s", path);
+    return ESP_OK;
+}
+
+void scenario_get_status(scenario_status_t *out)
+{
+    if (!out) return;
+    portENTER_CRITICAL(&status_lock);
+    *out = status;
+    portEXIT_CRITICAL(&status_lock);
+}
@@ -0,0 +1,80 @@
+/**
+ * @file scenario.h
+ * @brief Scripted UI scenarios played on the device and timed step by step
+ *
+ * A scenario is a text file in SCENARIO_DIR ending in .scn, one step per
+ * line ('#' starts a comment):
+ *
+ *   key NAME [xN]          press a key (N times): UP DOWN LEFT RIGHT ENTER
+ *                          ESC SPACE BACKSPACE TAB DEL, a letter or a digit
+ *   type TEXT              press the key typing each character (no Shift)
+ *   sleep MS
+ *   replay [FILE [SPEED]]  replay a UART transcript (uart_transcript.h):
+ *                          FILE in UART_TRANSCRIPT_DIR unless it starts
+ *                          with '/', the newest one without; SPEED 1 =
+ *                          real time, 0 = no delays
+ *   wait scan [MS]         a WiFi scan finished
+ *   wait list [MS]         a list_dir listing finished
+ *   wait rows N [MS]       a scan or listing has N rows
+ *   wait replay [MS]       the transcript replay ended
+ *   wait idle Q [MS]       no frame for Q ms: the screen has settled
+ *   mark LABEL             label the steps that follow in the report
+ *
+ * Keys go in through keyboard_inject(), so the current screen gets them
+ * from the main loop like real presses. A run starts from the home screen.
+ * A key step lasts until the first frame flushed after the press
+ * (navigation latency), at most SCENARIO_FRAME_WAIT_MS. Scan and listing
+ * waits are met by progress (uart_progress.h) published since the last
+ * key, type or replay step. "wait idle" lasts until the last frame before
+ * the quiet spell (time to list-ready). A wait gives up after MS
+ * (SCENARIO_WAIT_MS by default), which ends the run, as the steps after it
+ * would act on the wrong screen.
+ *
+ * Each run writes SCENARIO_REPORT_DIR/<name>_<board>_<N>.csv with one row
+ * per step: firmware, board, step, script line, label, command, result,
+ * milliseconds, frames flushed and kilopixels sent during the step. The
+ * firmware and board columns let reports from several releases and both
+ * boards be concatenated and compared.
+ */
+
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCENARIO_DIR            "/sdcard/scenarios"
+#define SCENARIO_REPORT_DIR     "/sdcard/scenarios/results"
+#define SCENARIO_EXT            ".scn"
+#define SCENARIO_PATH_LEN       96
+#define SCENARIO_LINE_LEN       96
+#define SCENARIO_WAIT_MS        15000   // Wait steps without a timeout
+#define SCENARIO_FRAME_WAIT_MS  1000    // Key steps: no frame this long = no visible effect
+#define SCENARIO_SETTLE_MS      500     // After returning to the home screen
+#define SCENARIO_POLL_MS        2       // Frame and condition polling
+
+typedef struct {
+    bool running;
+    int steps;                      // Steps done
+    int misses;                     // Keys without a frame
+    bool failed;                    // Ended early (timeout or bad line)
+    char name[32];                  // Script file name
+    char report[SCENARIO_PATH_LEN]; // Report of the current or last run
+    char error[48];                 // Why it ended early
+} scenario_status_t;
+
+/**
+ * @brief Play a scenario in its own task
+ * @param path Script file
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if one is running,
+ *         ESP_ERR_NOT_FOUND, ESP_ERR_NO_MEM
+ */
+esp_err_t scenario_start(const char *path);
+
+/**
+ * @brief Progress and outcome of the current or last run
+ */
+void scenario_get_status(scenario_status_t *out);
+
+#endif // SCENARIO_H
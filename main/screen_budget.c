@@ -0,0 +1,172 @@
+/**
+ * @file screen_budget.c
+ * @brief Per-screen memory and CPU budgets, enforced by screen_manager
+ */
+
+#include "screen_budget.h"
+#include "text_ui.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "SCREEN_BUDGET";
+
+typedef struct {
+    screen_create_fn key;
+    screen_budget_report_t report;
+} budget_slot_t;
+
+// Only touched under the UI lock (on_draw and on_tick callers)
+static budget_slot_t slots[SCREEN_BUDGET_SLOTS];
+static int slot_count = 0;
+
+// CPU window of the screen drawing and ticking now
+static const screen_t *window_screen = NULL;
+static int64_t window_start_us = 0;
+static uint64_t window_busy_us = 0;
+
+// Read by the render task before it takes the UI lock
+static volatile uint8_t active_shift = 0;
+
+static budget_slot_t *slot_for(const screen_t *screen)
+{
+    for (int i = 0; i < slot_count; i++) {
+        if (slots[i].key == screen->create_fn) return &slots[i];
+    }
+    if (slot_count < SCREEN_BUDGET_SLOTS) {
+        budget_slot_t *slot = &slots[slot_count++];
+        memset(slot, 0, sizeof(*slot));
+        slot->key = screen->create_fn;
+        return slot;
+    }
+    return &slots[SCREEN_BUDGET_SLOTS - 1];
+}
+
+static uint8_t cpu_budget(const screen_t *screen)
+{
+    return screen->cpu_budget_pct ? screen->cpu_budget_pct : SCREEN_CPU_BUDGET_DEFAULT_PCT;
+}
+
+/**
+ * @brief Name a slot after the title the screen has drawn
+ */
+static void name_slot(budget_slot_t *slot)
+{
+    const char *title = ui_get_title();
+    if (title[0]) {
+        snprintf(slot->report.name, sizeof(slot->report.name), "%s", title);
+    }
+}
+
+void screen_budget_record_cpu(screen_t *screen, uint32_t us)
+{
+    if (!screen) return;
+
+    int64_t now = esp_timer_get_time();
+    if (screen != window_screen) {
+        window_screen = screen;
+        window_start_us = now - us;
+        window_busy_us = 0;
+    }
+    window_busy_us += us;
+    int64_t elapsed = now - window_start_us;
+    if (elapsed < SCREEN_BUDGET_WINDOW_US) return;
+
+    uint32_t pct = (uint32_t)(window_busy_us * 100 / (uint64_t)elapsed);
+    if (pct > 100) pct = 100;
+    window_start_us = now;
+    window_busy_us = 0;
+
+    budget_slot_t *slot = slot_for(screen);
+    screen_budget_report_t *r = &slot->report;
+    uint8_t budget = cpu_budget(screen);
+    name_slot(slot);
+    r->cpu_budget_pct = budget;
+    if (pct > r->cpu_peak_pct) r->cpu_peak_pct = (uint8_t)pct;
+
+    if (pct > budget) {
+        r->overruns++;
+        if (screen->budget_shift < SCREEN_BUDGET_MAX_SHIFT) {
+            screen->budget_shift++;
+            ESP_LOGW(TAG, "'%s' spent %lu%% in draw and tick (budget %u%%), "
+                     "frames and ticks slowed %ux", r->name, (unsigned long)pct,
+                     budget, 1u << screen->budget_shift);
+        }
+    } else if (screen->budget_shift && pct * 2 <= budget) {
+        // One step faster roughly doubles the share; it still fits
+        screen->budget_shift--;
+        ESP_LOGI(TAG, "'%s' at %lu%%, frames and ticks slowed %ux", r->name,
+                 (unsigned long)pct, 1u << screen->budget_shift);
+    }
+    if (screen->budget_shift > r->max_shift) r->max_shift = screen->budget_shift;
+    active_shift = screen->budget_shift;
+}
+
+bool screen_budget_check_mem(screen_t *screen)
+{
+    if (!screen) return false;
+
+    budget_slot_t *slot = slot_for(screen);
+    screen_budget_report_t *r = &slot->report;
+    name_slot(slot);
+    r->mem_budget = (uint32_t)(screen->mem_budget_kb ? screen->mem_budget_kb
+                                                     : SCREEN_MEM_BUDGET_DEFAULT_KB) * 1024;
+    r->cpu_budget_pct = cpu_budget(screen);
+    if (screen->owned_bytes > r->mem_peak) r->mem_peak = (uint32_t)screen->owned_bytes;
+
+    if (screen->owned_bytes <= r->mem_budget || screen->over_mem_budget) return false;
+    screen->over_mem_budget = true;
+    r->overruns++;
+    ESP_LOGW(TAG, "'%s' holds %luKB, over its %luKB budget", r->name,
+             (unsigned long)(screen->owned_bytes / 1024),
+             (unsigned long)(r->mem_budget / 1024));
+    return true;
+}
+
+void screen_budget_forget(const screen_t *screen)
+{
+    if (screen == window_screen) window_screen = NULL;
+}
+
+void screen_budget_set_active(screen_t *screen)
+{
+    active_shift = screen ? screen->budget_shift : 0;
+}
+
+uint8_t screen_budget_frame_shift(void)
+{
+    return active_shift;
+}
+
+/**
+ * @brief Share of its budget a screen reached at worst, in percent
+ */
+static uint32_t worst_use(const screen_budget_report_t *r)
+{
+    uint32_t mem = r->mem_budget ? (uint32_t)((uint64_t)r->mem_peak * 100 / r->mem_budget) : 0;
+    uint32_t cpu = r->cpu_budget_pct ? (uint32_t)r->cpu_peak_pct * 100 / r->cpu_budget_pct : 0;
+    return mem > cpu ? mem : cpu;
+}
+
+int screen_budget_get_report(screen_budget_report_t *out, int max)
+{
+    if (!out || max <= 0) return 0;
+
+    // Insertion into a short table, worst first
+    int count = 0;
+    for (int i = 0; i < slot_count; i++) {
+        const screen_budget_report_t *r = &slots[i].report;
+        if (!r->mem_budget && !r->cpu_budget_pct) continue;
+        uint32_t use = worst_use(r);
+
+        int pos = count < max ? count : max;
+        while (pos > 0 && worst_use(&out[pos - 1]) < use) pos--;
+        if (pos >= max) continue;
+        int tail = (count < max ? count : max - 1) - pos;
+        memmove(&out[pos + 1], &out[pos], tail * sizeof(*out));
+        out[pos] = *r;
+        if (count < max) count++;
+    }
+    return count;
+}
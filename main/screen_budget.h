@@ -0,0 +1,95 @@
+/**
+ * @file screen_budget.h
+ * @brief Per-screen memory and CPU budgets, enforced by screen_manager
+ *
+ * A screen may declare what it expects to need in its screen_t:
+ * mem_budget_kb for what it holds (screen_t.owned_bytes: the heap its
+ * create function took plus arena memory allocated since) and
+ * cpu_budget_pct for the share of each second it spends in on_draw and
+ * on_tick. Screens that declare nothing get the Kconfig defaults.
+ *
+ * Going over the memory budget is logged once per screen, and the cached
+ * models and snapshots of other screens are released to make room. Going
+ * over the CPU budget for a SCREEN_BUDGET_WINDOW_US window halves the
+ * screen's frame rate and tick rate, at most SCREEN_BUDGET_MAX_SHIFT
+ * times; a step is undone once the screen's measured share would fit at
+ * the faster rate. Peaks and overruns are kept per screen (named after
+ * its title bar text) for the memory diagnostics screen.
+ *
+ * Everything but screen_budget_frame_shift() runs under the UI lock.
+ */
+
+#ifndef SCREEN_BUDGET_H
+#define SCREEN_BUDGET_H
+
+#include "screen_manager.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef CONFIG_SCREEN_MEM_BUDGET_KB
+#define SCREEN_MEM_BUDGET_DEFAULT_KB    CONFIG_SCREEN_MEM_BUDGET_KB
+#else
+#define SCREEN_MEM_BUDGET_DEFAULT_KB    16
+#endif
+
+#ifdef CONFIG_SCREEN_CPU_BUDGET_PCT
+#define SCREEN_CPU_BUDGET_DEFAULT_PCT   CONFIG_SCREEN_CPU_BUDGET_PCT
+#else
+#define SCREEN_CPU_BUDGET_DEFAULT_PCT   30
+#endif
+
+// Distinct screens tracked; later ones share the last slot
+#define SCREEN_BUDGET_SLOTS         16
+#define SCREEN_BUDGET_WINDOW_US     1000000     // CPU share is measured per window
+#define SCREEN_BUDGET_MAX_SHIFT     2           // Frames and ticks slow down 4x at most
+
+typedef struct {
+    char name[20];
+    uint32_t mem_peak;              // Largest owned_bytes seen
+    uint32_t mem_budget;
+    uint8_t cpu_peak_pct;           // Busiest window
+    uint8_t cpu_budget_pct;
+    uint8_t max_shift;              // Deepest throttle applied
+    uint16_t overruns;              // Windows over the CPU budget, plus memory overruns
+} screen_budget_report_t;
+
+/**
+ * @brief Account time a screen spent in on_draw or on_tick
+ *
+ * Closes the CPU window when it is due and adjusts the screen's throttle.
+ */
+void screen_budget_record_cpu(screen_t *screen, uint32_t us);
+
+/**
+ * @brief Compare what a screen holds with its memory budget
+ * @return true the first time the screen is found over it
+ */
+bool screen_budget_check_mem(screen_t *screen);
+
+/**
+ * @brief Drop a screen being destroyed, so its address is not mistaken
+ *        for a later screen's
+ */
+void screen_budget_forget(const screen_t *screen);
+
+/**
+ * @brief Follow the current screen (called when the stack changes)
+ * @param screen New current screen, or NULL
+ */
+void screen_budget_set_active(screen_t *screen);
+
+/**
+ * @brief Throttle of the current screen, from any task
+ * @return Shift applied to its frame and tick periods (0 = none)
+ */
+uint8_t screen_budget_frame_shift(void);
+
+/**
+ * @brief Screens closest to or over their budgets, worst first
+ * @param out Table of max entries
+ * @return Entries filled
+ */
+int screen_budget_get_report(screen_budget_report_t *out, int max);
+
+#endif // SCREEN_BUDGET_H
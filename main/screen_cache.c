@@ -0,0 +1,155 @@
+/**
+ * @file screen_cache.c
+ * @brief Models kept alive across screen pops
+ */
+
+#include "screen_cache.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "SCREEN_CACHE";
+
+#ifdef CONFIG_SPIRAM
+#define CACHE_CAPS      (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define CACHE_CAPS      (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+typedef struct {
+    char key[SCREEN_CACHE_KEY_LEN];
+    void *model;
+    size_t size;
+    int64_t stored_us;
+} cache_entry_t;
+
+static cache_entry_t entries[SCREEN_CACHE_SLOTS];
+static SemaphoreHandle_t cache_mutex = NULL;
+
+static void entry_drop(cache_entry_t *entry)
+{
+    free(entry->model);
+    memset(entry, 0, sizeof(*entry));
+}
+
+static cache_entry_t *entry_find(const char *key)
+{
+    for (int i = 0; i < SCREEN_CACHE_SLOTS; i++) {
+        if (entries[i].model && strncmp(entries[i].key, key, SCREEN_CACHE_KEY_LEN - 1) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t screen_cache_init(void)
+{
+    if (cache_mutex) return ESP_OK;
+    
+    cache_mutex = xSemaphoreCreateMutex();
+    if (!cache_mutex) {
+        ESP_LOGE(TAG, "Failed to create cache mutex");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void screen_cache_store(const char *key, const void *model, size_t size)
+{
+    if (SCREEN_CACHE_TTL_MS == 0 || !cache_mutex || !key || !model || size == 0) return;
+    
+    void *copy = heap_caps_malloc(size, CACHE_CAPS);
+    if (!copy) copy = malloc(size);
+    if (!copy) {
+        ESP_LOGW(TAG, "No memory to cache '%s' (%u bytes)", key, (unsigned)size);
+        return;
+    }
+    memcpy(copy, model, size);
+    
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    
+    cache_entry_t *entry = entry_find(key);
+    if (!entry) {
+        // Free slot, else the oldest entry
+        entry = &entries[0];
+        for (int i = 0; i < SCREEN_CACHE_SLOTS; i++) {
+            if (!entries[i].model) {
+                entry = &entries[i];
+                break;
+            }
+            if (entries[i].stored_us < entry->stored_us) {
+                entry = &entries[i];
+            }
+        }
+    }
+    entry_drop(entry);
+    strncpy(entry->key, key, SCREEN_CACHE_KEY_LEN - 1);
+    entry->model = copy;
+    entry->size = size;
+    entry->stored_us = esp_timer_get_time();
+    
+    xSemaphoreGive(cache_mutex);
+    
+    ESP_LOGD(TAG, "Cached '%s' (%u bytes)", key, (unsigned)size);
+}
+
+bool screen_cache_load(const char *key, void *model, size_t size)
+{
+    if (!cache_mutex || !key || !model) return false;
+    
+    bool hit = false;
+    
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    
+    cache_entry_t *entry = entry_find(key);
+    if (entry) {
+        int64_t age_ms = (esp_timer_get_time() - entry->stored_us) / 1000;
+        if (age_ms > SCREEN_CACHE_TTL_MS || entry->size != size) {
+            entry_drop(entry);
+        } else {
+            memcpy(model, entry->model, size);
+            hit = true;
+        }
+    }
+    
+    xSemaphoreGive(cache_mutex);
+    
+    ESP_LOGD(TAG, "'%s': %s", key, hit ? "hit" : "miss");
+    return hit;
+}
+
+size_t screen_cache_clear(void)
+{
+    if (!cache_mutex) return 0;
+    
+    size_t released = 0;
+    
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    for (int i = 0; i < SCREEN_CACHE_SLOTS; i++) {
+        if (entries[i].model) {
+            released += entries[i].size;
+            entry_drop(&entries[i]);
+        }
+    }
+    xSemaphoreGive(cache_mutex);
+    
+    return released;
+}
+
+void screen_cache_invalidate(const char *key)
+{
+    if (!cache_mutex || !key) return;
+    
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    
+    cache_entry_t *entry = entry_find(key);
+    if (entry) {
+        entry_drop(entry);
+    }
+    
+    xSemaphoreGive(cache_mutex);
+}
@@ -0,0 +1,70 @@
+/**
+ * @file screen_cache.h
+ * @brief Models kept alive across screen pops
+ *
+ * List screens that fetch their content over UART can store their parsed
+ * model when they are destroyed and load it again on re-entry, drawing it
+ * immediately while the command runs again in the background. Entries
+ * are keyed by the UART command that produced them, expire after a TTL
+ * and can be invalidated by whoever knows the content changed.
+ */
+
+#ifndef SCREEN_CACHE_H
+#define SCREEN_CACHE_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SCREEN_CACHE_SLOTS      4
+#define SCREEN_CACHE_KEY_LEN    48
+
+#ifdef CONFIG_SCREEN_CACHE_TTL_S
+#define SCREEN_CACHE_TTL_MS     (CONFIG_SCREEN_CACHE_TTL_S * 1000)
+#else
+#define SCREEN_CACHE_TTL_MS     60000
+#endif
+
+/**
+ * @brief Initialize the cache (called by screen_manager_init)
+ * @return ESP_OK on success
+ */
+esp_err_t screen_cache_init(void);
+
+/**
+ * @brief Store a copy of a model, replacing any entry with the same key
+ *
+ * The least recently stored entry is dropped when all slots are in use.
+ * Does nothing when the cache is disabled (SCREEN_CACHE_TTL_MS == 0).
+ * @param key Cache key (truncated to SCREEN_CACHE_KEY_LEN - 1)
+ * @param model Model bytes
+ * @param size Model size
+ */
+void screen_cache_store(const char *key, const void *model, size_t size);
+
+/**
+ * @brief Copy a cached model if present, younger than the TTL and of the same size
+ * @param key Cache key
+ * @param model Receives the model
+ * @param size Model size expected by the caller
+ * @return true if model was filled
+ */
+bool screen_cache_load(const char *key, void *model, size_t size);
+
+/**
+ * @brief Drop every entry (used when memory runs low)
+ * @return Bytes released
+ */
+size_t screen_cache_clear(void);
+
+/**
+ * @brief Drop an entry whose content is known to have changed
+ *
+ * Safe to call from UART callbacks.
+ * @param key Cache key
+ */
+void screen_cache_invalidate(const char *key);
+
+#endif // SCREEN_CACHE_H
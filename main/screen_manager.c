@@ -4,29 +4,385 @@
  */
 
 #include "screen_manager.h"
+#include "screen_cache.h"
+#include "screen_snapshot.h"
 #include "text_ui.h"
 #include "screenshot.h"
+#include "screen_record.h"
+#include "screen_mirror.h"
+#include "sd_io.h"
+#include "boot_profile.h"
+#include "screen_profiler.h"
+#include "screen_budget.h"
+#include "trace.h"
+#include "stall_watch.h"
+#include "display.h"
+#include "power.h"
+#include "power_governor.h"
+#include "task_plan.h"
+#include "mem_monitor.h"
+#include "esp_timer.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 static const char *TAG = "SCREEN_MGR";
 
-// Screen stack
-static screen_t *screen_stack[MAX_SCREEN_STACK];
+// Screen stack, grown on demand
+static screen_t **screen_stack = NULL;
+static int stack_capacity = 0;
 static int stack_depth = 0;
 
+// Breadcrumb overlay (CONFIG_SCREEN_DEBUG_BREADCRUMB)
+#define BREADCRUMB_LEN      12
+
+// Alert banner over the status bar (UI lock held)
+static char banner_text[UI_COLS_MAX + 1];
+static int64_t banner_until_ms = 0;             // 0 = no banner
+
+// Render task state
+#define RENDER_BIT_FLUSH    (1 << 0)
+#define RENDER_BIT_REDRAW   (1 << 1)
+#define RENDER_BIT_DATA     (1 << 2)        // Paced by screen_manager_data_changed()
+
+static TaskHandle_t render_task_handle = NULL;
+static volatile uint16_t data_redraw_ms = SCREEN_DATA_REDRAW_MS;  // Of the screen reporting
+static volatile bool panel_visible = true;
+static volatile bool dark_pending = false;      // Data changed while the backlight was off
+static SemaphoreHandle_t ui_lock = NULL;
+
+// Outermost UI lock hold, for the stall watchdog (UI lock held)
+static int lock_depth = 0;
+static int64_t lock_taken_us = 0;
+static const void *lock_taker = NULL;
+
+// Screen arena: stack-ordered bump region plus a LIFO list of heap
+// blocks for requests that do not fit
+#ifdef CONFIG_SCREEN_ARENA_SIZE_KB
+#define SCREEN_ARENA_SIZE   (CONFIG_SCREEN_ARENA_SIZE_KB * 1024)
+#else
+#define SCREEN_ARENA_SIZE   (32 * 1024)
+#endif
+
+#ifdef CONFIG_SPIRAM
+#define ARENA_CAPS          (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define ARENA_CAPS          (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+#define ARENA_ALIGN         8
+
+typedef struct arena_overflow {
+    struct arena_overflow *next;
+    uint64_t payload[];                     // Keeps the payload 8-aligned
+} arena_overflow_t;
+
+// Screen whose line_cb currently sits in the UART line callback slot
+static screen_t *line_owner = NULL;
+
+static uint8_t *arena_base = NULL;
+static size_t arena_size = 0;
+static screen_arena_mark_t arena_top = { 0, NULL };
+static bool creating = false;               // Arena memory is measured by create_screen()
+
 // Key callback forward declaration
 static void key_event_handler(key_code_t key, bool pressed);
+static void render_task(void *arg);
+static void charge_arena(size_t size);
+
+void* screen_arena_alloc(size_t size)
+{
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    
+    if (arena_base && size <= arena_size - arena_top.offset) {
+        void *p = arena_base + arena_top.offset;
+        arena_top.offset += size;
+        memset(p, 0, size);
+        charge_arena(size);
+        return p;
+    }
+    
+    arena_overflow_t *block = heap_caps_calloc(1, sizeof(arena_overflow_t) + size, ARENA_CAPS);
+    if (!block) {
+        block = calloc(1, sizeof(arena_overflow_t) + size);
+    }
+    if (!block) {
+        ESP_LOGE(TAG, "Screen arena: no memory for %u bytes", (unsigned)size);
+        return NULL;
+    }
+    ESP_LOGD(TAG, "Screen arena full, %u bytes from heap", (unsigned)size);
+    block->next = arena_top.overflow;
+    arena_top.overflow = block;
+    charge_arena(size);
+    return block->payload;
+}
+
+size_t screen_arena_used(void)
+{
+    return arena_top.offset;
+}
+
+/**
+ * @brief Release everything allocated since mark was taken
+ */
+static void arena_release(screen_arena_mark_t mark)
+{
+    while (arena_top.overflow && arena_top.overflow != mark.overflow) {
+        arena_overflow_t *block = arena_top.overflow;
+        arena_top.overflow = block->next;
+        free(block);
+    }
+    if (mark.offset <= arena_top.offset) {
+        arena_top.offset = mark.offset;
+    }
+}
+
+/**
+ * @brief Make room for one more screen on the stack
+ */
+static bool stack_reserve(void)
+{
+    if (stack_depth < stack_capacity) return true;
+    if (stack_capacity >= MAX_SCREEN_STACK) return false;
+    
+    int capacity = stack_capacity ? stack_capacity * 2 : SCREEN_STACK_INITIAL;
+    if (capacity > MAX_SCREEN_STACK) capacity = MAX_SCREEN_STACK;
+    
+    screen_t **grown = realloc(screen_stack, capacity * sizeof(screen_t *));
+    if (!grown) return false;
+    
+    screen_stack = grown;
+    stack_capacity = capacity;
+    return true;
+}
+
+static size_t release_screen_cache(void *arg)
+{
+    (void)arg;
+    return screen_cache_clear() + screen_snapshot_release_all();
+}
+
+/**
+ * @brief Check the heap watermark, running the low-memory callbacks
+ *        (cached screen models and snapshots among them) if that helps
+ */
+static bool heap_allows_push(void)
+{
+    size_t free_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    if (free_internal >= SCREEN_PUSH_MIN_FREE) return true;
+    
+    size_t released = mem_monitor_reclaim();
+    free_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    ESP_LOGW(TAG, "Low memory (%uKB free), low-memory callbacks released %uB",
+             (unsigned)(free_internal / 1024), (unsigned)released);
+    return free_internal >= SCREEN_PUSH_MIN_FREE;
+}
+
+/**
+ * @brief Make room when a screen goes over its memory budget
+ */
+static void enforce_mem_budget(screen_t *screen)
+{
+    if (!screen_budget_check_mem(screen)) return;
+    
+    // What the other screens keep for later can be rebuilt
+    size_t released = release_screen_cache(NULL);
+    ESP_LOGW(TAG, "Screen over memory budget, cached screens released %uB",
+             (unsigned)released);
+}
+
+/**
+ * @brief Add arena memory the active screen took after create to what it holds
+ */
+static void charge_arena(size_t size)
+{
+    screen_t *current = screen_manager_get_current();
+    if (creating || !current) return;
+    
+    current->owned_bytes += size;
+    mem_monitor_account(MEM_SUB_SCREENS, (int32_t)size);
+    enforce_mem_budget(current);
+}
+
+/**
+ * @brief True if the screen is on the stack below the top
+ */
+static bool screen_in_background(const screen_t *screen)
+{
+    for (int i = 0; i < stack_depth - 1; i++) {
+        if (screen_stack[i] == screen) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Hand the UART link back to a screen that is becoming active
+ */
+static void attach_uart(screen_t *screen)
+{
+    for (int i = 0; i < SCREEN_MAX_UART_ROUTES; i++) {
+        if (screen->uart_routes[i]) {
+            uart_pause_lines(screen->uart_routes[i] - 1, false);
+        }
+    }
+    if (screen->line_cb) {
+        uart_register_line_callback(screen->line_cb, screen->line_cb_data);
+        line_owner = screen;
+    }
+}
+
+/**
+ * @brief Take the UART link away from a screen
+ * @param release true when the screen is going away, false when covered
+ */
+static void detach_uart(screen_t *screen, bool release)
+{
+    if (screen->relay_route) {
+        uart_unsubscribe_lines(screen->relay_route - 1);
+        screen->relay_route = 0;
+    }
+    for (int i = 0; i < SCREEN_MAX_UART_ROUTES; i++) {
+        if (!screen->uart_routes[i]) continue;
+        if (release) {
+            uart_unsubscribe_lines(screen->uart_routes[i] - 1);
+            screen->uart_routes[i] = 0;
+        } else {
+            uart_pause_lines(screen->uart_routes[i] - 1, true);
+        }
+    }
+    if (line_owner == screen) {
+        uart_clear_line_callback();
+        line_owner = NULL;
+    }
+    if (release) {
+        screen->line_cb = NULL;
+    }
+}
+
+/**
+ * @brief Run create_fn and record what the new screen took
+ *
+ * Memory is the drop in free heap plus arena growth across the call, so
+ * allocations made by other tasks meanwhile are counted too.
+ */
+static screen_t *create_screen(screen_create_fn create_fn, void *params)
+{
+    screen_arena_mark_t mark = arena_top;
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    
+    // New screens start in the normal layout until they pick another
+    ui_density_t density = ui_get_density();
+    ui_set_density(UI_DENSITY_NORMAL);
+    creating = true;
+    screen_t *screen = create_fn(params);
+    creating = false;
+    if (!screen) {
+        // The covered screen was detached, so the slot can only be ours
+        if (line_owner) {
+            uart_clear_line_callback();
+            line_owner = NULL;
+        }
+        ui_set_density(density);
+        arena_release(mark);
+        return NULL;
+    }
+    
+    size_t free_after = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    screen->arena_mark = mark;
+    screen->create_fn = create_fn;
+    screen->owned_bytes = (free_before > free_after ? free_before - free_after : 0) +
+                          (arena_top.offset - mark.offset);
+    mem_monitor_account(MEM_SUB_SCREENS, (int32_t)screen->owned_bytes);
+    enforce_mem_budget(screen);
+    return screen;
+}
+
+/**
+ * @brief Call on_draw, timing it for the stall watchdog, the screen's CPU
+ *        budget and the profiler
+ */
+static void draw_screen(screen_t *screen)
+{
+    TRACE_BEGIN(TRACE_EV_DRAW, stack_depth);
+    int64_t start_us = esp_timer_get_time();
+    screen->on_draw(screen);
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start_us);
+    TRACE_END(TRACE_EV_DRAW, stack_depth);
+    
+    stall_watch_record(STALL_SITE_DRAW, screen->on_draw, us);
+    screen_budget_record_cpu(screen, us);
+#ifdef CONFIG_SCREEN_PROFILER
+    screen_profiler_record_draw(screen, us);
+#endif
+}
+
+/**
+ * @brief Follow a change of the stack: throttle of the new top, log line
+ */
+static void stack_changed(const char *action)
+{
+    screen_budget_set_active(screen_manager_get_current());
+    
+    char crumbs[48];
+    screen_manager_format_breadcrumb(crumbs, sizeof(crumbs));
+    ESP_LOGI(TAG, "%s screen, depth: %d [%s], Arena: %uKB, Internal: %luKB, DMA: %luKB",
+             action, stack_depth, crumbs, (unsigned)(arena_top.offset / 1024),
+             (unsigned long)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024),
+             (unsigned long)(heap_caps_get_free_size(MALLOC_CAP_DMA) / 1024));
+}
+
+/**
+ * @brief Destroy a screen and return its arena memory
+ */
+static void destroy_screen(screen_t *screen)
+{
+    screen_arena_mark_t mark = screen->arena_mark;
+    
+    mem_monitor_account(MEM_SUB_SCREENS, -(int32_t)screen->owned_bytes);
+    screen_snapshot_free(screen->snapshot);
+    detach_uart(screen, true);
+    if (screen->on_destroy) {
+        screen->on_destroy(screen);
+    }
+    screen_budget_forget(screen);
+    free(screen);
+    arena_release(mark);
+}
 
 void screen_manager_init(void)
 {
     ESP_LOGI(TAG, "Initializing screen manager...");
     
-    memset(screen_stack, 0, sizeof(screen_stack));
     stack_depth = 0;
+    if (!stack_reserve()) {
+        ESP_LOGE(TAG, "Failed to allocate screen stack");
+    }
+    
+    ui_lock = xSemaphoreCreateRecursiveMutex();
+    if (!ui_lock) {
+        ESP_LOGE(TAG, "Failed to create UI lock");
+    }
+    
+    if (SCREEN_ARENA_SIZE > 0) {
+        arena_base = heap_caps_malloc(SCREEN_ARENA_SIZE, ARENA_CAPS);
+        arena_size = arena_base ? SCREEN_ARENA_SIZE : 0;
+        if (!arena_base) {
+            ESP_LOGW(TAG, "Screen arena unavailable, using heap");
+        }
+    }
+    
+    screen_cache_init();
+    screen_snapshot_init();
+    if (mem_monitor_register_low_callback(release_screen_cache, NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "Cached screens are not released on low memory");
+    }
     
     // Register for keyboard events
     keyboard_register_callback(key_event_handler);
@@ -34,6 +390,15 @@ void screen_manager_init(void)
     // Initialize UI
     ui_init();
     
+    // Render task owns the panel from here on
+    if (xTaskCreatePinnedToCore(render_task, "render", TASK_RENDER_STACK, NULL,
+                                TASK_RENDER_PRIO, &render_task_handle,
+                                TASK_RENDER_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create render task");
+        render_task_handle = NULL;
+    }
+    task_plan_track(TASK_ID_RENDER, render_task_handle);
+    
     ESP_LOGI(TAG, "Screen manager initialized");
 }
 
@@ -41,6 +406,7 @@ static void key_event_handler(key_code_t key, bool pressed)
 {
     // Only handle key press, not release
     if (!pressed) return;
+    TRACE_INSTANT(TRACE_EV_KEY, key);
     
     // Check for CTRL+S screenshot combination
     if (key == KEY_S && keyboard_is_ctrl_held()) {
@@ -48,7 +414,7 @@ static void key_event_handler(key_code_t key, bool pressed)
         if (screenshot_is_available()) {
             esp_err_t ret = screenshot_take();
             if (ret == ESP_OK) {
-                ESP_LOGI(TAG, "Screenshot saved successfully");
+                ESP_LOGI(TAG, "Screenshot queued");
             } else {
                 ESP_LOGE(TAG, "Screenshot failed: %s", esp_err_to_name(ret));
             }
@@ -58,6 +424,49 @@ static void key_event_handler(key_code_t key, bool pressed)
         return;  // Don't pass CTRL+S to screen
     }
     
+    // CTRL+R starts/stops screen recording
+    if (key == KEY_R && keyboard_is_ctrl_held()) {
+        esp_err_t ret = screen_record_toggle();
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Screen recording failed: %s", esp_err_to_name(ret));
+        }
+        return;
+    }
+    
+    // CTRL+M starts/stops mirroring the display over USB
+    if (key == KEY_M && keyboard_is_ctrl_held()) {
+        esp_err_t ret = screen_mirror_toggle();
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Screen mirroring failed: %s", esp_err_to_name(ret));
+        }
+        return;
+    }
+    
+#ifdef CONFIG_SCREEN_PROFILER
+    // CTRL+P dumps redraw statistics to the console
+    if (key == KEY_P && keyboard_is_ctrl_held()) {
+        screen_profiler_dump();
+        return;
+    }
+#endif
+    
+#ifdef CONFIG_EVENT_TRACE
+    // CTRL+T writes the event trace to the SD card
+    if (key == KEY_T && keyboard_is_ctrl_held()) {
+        esp_err_t ret = trace_dump();
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Trace dump failed: %s", esp_err_to_name(ret));
+        }
+        return;
+    }
+#endif
+    
+    // CTRL+W logs the stall watchdog's per-handler worst cases
+    if (key == KEY_W && keyboard_is_ctrl_held()) {
+        stall_watch_dump();
+        return;
+    }
+    
     screen_manager_handle_key(key);
 }
 
@@ -67,39 +476,91 @@ void screen_manager_handle_key(key_code_t key)
     
     // Always let the screen handle the key first
     if (current && current->on_key) {
-        current->on_key(current, key);
+#ifdef CONFIG_SCREEN_PROFILER
+        screen_profiler_record_key(current, keyboard_get_event_time_us());
+#endif
+        // A key that pops the screen frees it, so keep the handler aside
+        void (*on_key)(screen_t *, key_code_t) = current->on_key;
+        int64_t start_us = esp_timer_get_time();
+        on_key(current, key);
+        stall_watch_record(STALL_SITE_KEY, on_key,
+                           (uint32_t)(esp_timer_get_time() - start_us));
     }
 }
 
 esp_err_t screen_manager_push(screen_create_fn create_fn, void *params)
 {
-    if (stack_depth >= MAX_SCREEN_STACK) {
-        ESP_LOGE(TAG, "Screen stack overflow!");
-        return ESP_FAIL;
-    }
-    
     if (!create_fn) {
         ESP_LOGE(TAG, "No create function provided");
         return ESP_ERR_INVALID_ARG;
     }
     
-    // Create new screen
-    screen_t *new_screen = create_fn(params);
+    if (!stack_reserve()) {
+        ESP_LOGE(TAG, "Screen stack overflow!");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    if (!heap_allows_push()) {
+        ESP_LOGE(TAG, "Not opening screen: below %uKB free internal heap",
+                 (unsigned)(SCREEN_PUSH_MIN_FREE / 1024));
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // The covered screen stops listening before the new one can send
+    screen_t *prev = screen_manager_get_current();
+    if (prev) {
+        detach_uart(prev, false);
+        // Keep its pixels so going back needs no full redraw; not with a
+        // banner on them, which may have expired by then
+        if (prev->on_restore && !banner_until_ms && !prev->snapshot) {
+            prev->snapshot = screen_snapshot_take();
+        }
+    }
+    
+    // Create new screen; its arena allocations start at the current top
+    screen_t *new_screen = create_screen(create_fn, params);
     if (!new_screen) {
         ESP_LOGE(TAG, "Failed to create screen");
+        if (prev) {
+            screen_snapshot_free(prev->snapshot);
+            prev->snapshot = NULL;
+            attach_uart(prev);
+        }
         return ESP_FAIL;
     }
     
     // Push onto stack
     screen_stack[stack_depth++] = new_screen;
     
-    ESP_LOGI(TAG, "Pushed screen, depth: %d, Internal: %luKB, DMA: %luKB",
-             stack_depth,
-             (unsigned long)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024),
-             (unsigned long)(heap_caps_get_free_size(MALLOC_CAP_DMA) / 1024));
+    stack_changed("Pushed");
     return ESP_OK;
 }
 
+/**
+ * @brief Make the screen now on top active again after the one above left
+ */
+static void uncover_current(void)
+{
+    screen_t *prev = screen_manager_get_current();
+    if (prev) {
+        ui_set_density(prev->density);
+        attach_uart(prev);
+        if (screen_snapshot_restore(prev->snapshot)) {
+            // Its pixels are back as they were: only changes need painting
+            prev->on_restore(prev);
+        } else if (prev->on_resume) {
+            // on_resume handles its own redraw
+            prev->on_resume(prev);
+        } else if (prev->on_draw) {
+            // No on_resume, so we need to redraw
+            ui_clear();
+            draw_screen(prev);
+        }
+        screen_snapshot_free(prev->snapshot);
+        prev->snapshot = NULL;
+    }
+}
+
 esp_err_t screen_manager_pop(void)
 {
     if (stack_depth <= 1) {
@@ -112,29 +573,11 @@ esp_err_t screen_manager_pop(void)
     
     // Destroy current screen
     if (current) {
-        if (current->on_destroy) {
-            current->on_destroy(current);
-        }
-        free(current);
+        destroy_screen(current);
     }
     
-    // Redraw previous screen
-    screen_t *prev = screen_manager_get_current();
-    if (prev) {
-        if (prev->on_resume) {
-            // on_resume handles its own redraw
-            prev->on_resume(prev);
-        } else if (prev->on_draw) {
-            // No on_resume, so we need to redraw
-            ui_clear();
-            prev->on_draw(prev);
-        }
-    }
-    
-    ESP_LOGI(TAG, "Popped screen, depth: %d, Internal: %luKB, DMA: %luKB",
-             stack_depth,
-             (unsigned long)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024),
-             (unsigned long)(heap_caps_get_free_size(MALLOC_CAP_DMA) / 1024));
+    uncover_current();
+    stack_changed("Popped");
     return ESP_OK;
 }
 
@@ -147,29 +590,36 @@ esp_err_t screen_manager_replace(screen_create_fn create_fn, void *params)
     
     // Get current screen
     screen_t *current = screen_stack[stack_depth - 1];
+    if (current) {
+        detach_uart(current, false);
+    }
     
     // Create new screen first
-    screen_t *new_screen = create_fn(params);
+    screen_t *new_screen = create_screen(create_fn, params);
     if (!new_screen) {
         ESP_LOGE(TAG, "Failed to create replacement screen");
+        if (current) {
+            attach_uart(current);
+        }
         return ESP_FAIL;
     }
     
-    // Destroy old screen
+    // The replacement sits above the old screen's arena memory, so it
+    // inherits the old mark and both are released when it is popped
     if (current) {
+        new_screen->arena_mark = current->arena_mark;
+        detach_uart(current, true);
         if (current->on_destroy) {
             current->on_destroy(current);
         }
+        screen_budget_forget(current);
         free(current);
     }
     
     // Replace on stack
     screen_stack[stack_depth - 1] = new_screen;
     
-    ESP_LOGI(TAG, "Replaced screen, depth: %d, Internal: %luKB, DMA: %luKB",
-             stack_depth,
-             (unsigned long)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024),
-             (unsigned long)(heap_caps_get_free_size(MALLOC_CAP_DMA) / 1024));
+    stack_changed("Replaced");
     return ESP_OK;
 }
 
@@ -180,6 +630,86 @@ void screen_manager_pop_to_root(void)
     }
 }
 
+esp_err_t screen_manager_detach(screen_t *screen)
+{
+    if (stack_depth <= 1 || screen != screen_manager_get_current()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Everything above its mark is its own: it must have taken nothing
+    if (arena_top.offset != screen->arena_mark.offset ||
+        arena_top.overflow != screen->arena_mark.overflow) {
+        ESP_LOGW(TAG, "Screen holds arena memory, cannot detach");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    detach_uart(screen, false);
+    if (screen->line_cb) {
+        int handle = uart_subscribe_lines(UART_ROUTE_ANY, NULL, screen->line_cb,
+                                          screen->line_cb_data);
+        if (handle < 0) {
+            attach_uart(screen);
+            return ESP_ERR_NO_MEM;
+        }
+        screen->relay_route = (int8_t)(handle + 1);
+    }
+    // Its own routes keep delivering
+    for (int i = 0; i < SCREEN_MAX_UART_ROUTES; i++) {
+        if (screen->uart_routes[i]) {
+            uart_pause_lines(screen->uart_routes[i] - 1, false);
+        }
+    }
+    
+    stack_depth--;
+    uncover_current();
+    stack_changed("Detached");
+    return ESP_OK;
+}
+
+esp_err_t screen_manager_attach(screen_t *screen)
+{
+    if (!screen || !stack_reserve()) return ESP_FAIL;
+    
+    screen_t *prev = screen_manager_get_current();
+    if (prev) {
+        detach_uart(prev, false);
+        if (prev->on_restore && !banner_until_ms && !prev->snapshot) {
+            prev->snapshot = screen_snapshot_take();
+        }
+    }
+    
+    // Its arena share starts at the current top, and is empty
+    screen->arena_mark = arena_top;
+    if (screen->relay_route) {
+        uart_unsubscribe_lines(screen->relay_route - 1);
+        screen->relay_route = 0;
+    }
+    screen_stack[stack_depth++] = screen;
+    attach_uart(screen);
+    ui_set_density(screen->density);
+    if (screen->on_draw) {
+        ui_clear();
+        draw_screen(screen);
+    }
+    
+    stack_changed("Attached");
+    return ESP_OK;
+}
+
+void screen_manager_destroy_detached(screen_t *screen)
+{
+    if (!screen) return;
+    
+    // Holds no arena memory, so there is nothing to release there
+    mem_monitor_account(MEM_SUB_SCREENS, -(int32_t)screen->owned_bytes);
+    screen_snapshot_free(screen->snapshot);
+    detach_uart(screen, true);
+    if (screen->on_destroy) {
+        screen->on_destroy(screen);
+    }
+    screen_budget_forget(screen);
+    free(screen);
+}
+
 screen_t* screen_manager_get_current(void)
 {
     if (stack_depth > 0) {
@@ -193,6 +723,94 @@ int screen_manager_get_depth(void)
     return stack_depth;
 }
 
+void screen_manager_format_breadcrumb(char *buf, size_t len)
+{
+    if (!buf || len == 0) return;
+    buf[0] = '\0';
+    
+    // Fill from the top of the stack backwards so the newest screens show
+    char tmp[64];
+    size_t pos = sizeof(tmp) - 1;
+    tmp[pos] = '\0';
+    
+    for (int i = stack_depth - 1; i >= 0; i--) {
+        char item[12];
+        int n = snprintf(item, sizeof(item), "%s%u%s", i > 0 ? ">" : "",
+                         (unsigned)((screen_stack[i]->owned_bytes + 512) / 1024),
+                         i == stack_depth - 1 ? "K" : "");
+        // Always leave room for a ".." prefix
+        if (n + 2 > (int)pos || (sizeof(tmp) - 1 - pos) + n + 2 >= len) {
+            pos -= 2;
+            memcpy(&tmp[pos], "..", 2);
+            break;
+        }
+        pos -= n;
+        memcpy(&tmp[pos], item, n);
+    }
+    
+    strncpy(buf, &tmp[pos], len - 1);
+    buf[len - 1] = '\0';
+}
+
+void screen_set_density(screen_t *screen, ui_density_t density)
+{
+    if (!screen) return;
+    screen->density = density;
+    ui_set_density(density);
+}
+
+void screen_set_line_callback(screen_t *screen, uart_response_callback_t callback,
+                              void *user_data)
+{
+    if (!screen) return;
+    screen->line_cb = callback;
+    screen->line_cb_data = user_data;
+    
+    // A covered screen gets the slot back in attach_uart()
+    if (screen_in_background(screen)) return;
+    if (callback) {
+        uart_register_line_callback(callback, user_data);
+        line_owner = screen;
+    } else if (line_owner == screen) {
+        uart_clear_line_callback();
+        line_owner = NULL;
+    }
+}
+
+int screen_subscribe_lines(screen_t *screen, uart_route_kind_t kind, const char *pattern,
+                           uart_response_callback_t callback, void *user_data)
+{
+    if (!screen) return -1;
+    
+    int slot = 0;
+    while (slot < SCREEN_MAX_UART_ROUTES && screen->uart_routes[slot]) slot++;
+    if (slot == SCREEN_MAX_UART_ROUTES) {
+        ESP_LOGW(TAG, "Screen already holds %d UART routes", SCREEN_MAX_UART_ROUTES);
+        return -1;
+    }
+    
+    int handle = uart_subscribe_lines(kind, pattern, callback, user_data);
+    if (handle < 0) return -1;
+    screen->uart_routes[slot] = (int8_t)(handle + 1);
+    if (screen_in_background(screen)) {
+        uart_pause_lines(handle, true);
+    }
+    return handle;
+}
+
+void screen_unsubscribe_lines(screen_t *screen, int handle)
+{
+    if (!screen || handle < 0) return;
+    
+    for (int i = 0; i < SCREEN_MAX_UART_ROUTES; i++) {
+        if (screen->uart_routes[i] == handle + 1) {
+            uart_unsubscribe_lines(handle);
+            screen->uart_routes[i] = 0;
+            return;
+        }
+    }
+}
+
 screen_t* screen_alloc(void)
 {
     screen_t *screen = calloc(1, sizeof(screen_t));
@@ -207,14 +825,249 @@ void screen_manager_redraw(void)
 {
     screen_t *current = screen_manager_get_current();
     if (current && current->on_draw) {
-        current->on_draw(current);
+        draw_screen(current);
     }
 }
 
 void screen_manager_tick(void)
 {
+    // Expired banner: the screen redraws its own status bar
+    if (banner_until_ms && esp_timer_get_time() / 1000 >= banner_until_ms) {
+        banner_until_ms = 0;
+        screen_manager_invalidate(NULL);
+    }
+
     screen_t *current = screen_manager_get_current();
     if (current && current->on_tick) {
-        current->on_tick(current);
+        // A tick that pops the screen frees it, so keep the handler aside
+        void (*on_tick)(screen_t *) = current->on_tick;
+        int64_t start_us = esp_timer_get_time();
+        on_tick(current);
+        uint32_t us = (uint32_t)(esp_timer_get_time() - start_us);
+        stall_watch_record(STALL_SITE_TICK, on_tick, us);
+        // Only a screen the tick left on top is still there to charge
+        if (screen_manager_get_current() == current) {
+            screen_budget_record_cpu(current, us);
+        }
+    }
+}
+
+uint32_t screen_manager_get_tick_interval(void)
+{
+    screen_t *current = screen_manager_get_current();
+    if (!current) return SCREEN_TICK_DEFAULT_MS;
+    
+    uint32_t tick_ms = current->tick_ms > 0 ? current->tick_ms : SCREEN_TICK_DEFAULT_MS;
+    return tick_ms << current->budget_shift;
+}
+
+bool screen_manager_ticks_on_uart(void)
+{
+    screen_t *current = screen_manager_get_current();
+    return current && current->on_tick && current->tick_on_uart;
+}
+
+void screen_manager_lock(void)
+{
+    if (ui_lock) {
+        xSemaphoreTakeRecursive(ui_lock, portMAX_DELAY);
+        if (lock_depth++ == 0) {
+            lock_taken_us = esp_timer_get_time();
+            lock_taker = __builtin_return_address(0);
+        }
+    }
+}
+
+void screen_manager_unlock(void)
+{
+    if (!ui_lock) return;
+    
+    // Holds by the main loop are watched as whole iterations
+    bool outermost = --lock_depth == 0;
+    uint32_t held_us = (uint32_t)(esp_timer_get_time() - lock_taken_us);
+    const void *taker = lock_taker;
+    xSemaphoreGiveRecursive(ui_lock);
+    
+    if (outermost && task_plan_current() != TASK_ID_MAIN) {
+        stall_watch_record(STALL_SITE_UI_LOCK, taker, held_us);
+    }
+}
+
+void screen_manager_invalidate(screen_t *screen)
+{
+    if (screen && screen != screen_manager_get_current()) {
+        return;
+    }
+    if (render_task_handle) {
+        xTaskNotify(render_task_handle, RENDER_BIT_REDRAW, eSetBits);
+    }
+}
+
+void screen_manager_data_changed(screen_t *screen)
+{
+    if (!screen || screen != screen_manager_get_current()) {
+        return;
+    }
+    data_redraw_ms = screen->redraw_ms ? screen->redraw_ms : SCREEN_DATA_REDRAW_MS;
+    if (render_task_handle) {
+        xTaskNotify(render_task_handle, RENDER_BIT_DATA, eSetBits);
+    }
+}
+
+void screen_manager_set_visible(bool visible)
+{
+    panel_visible = visible;
+    if (visible && dark_pending) {
+        dark_pending = false;
+        screen_manager_invalidate(NULL);
+    }
+}
+
+void screen_manager_show_banner(const char *text, uint32_t duration_ms)
+{
+    screen_manager_lock();
+    strlcpy(banner_text, text ? text : "", sizeof(banner_text));
+    banner_until_ms = esp_timer_get_time() / 1000 + duration_ms;
+    screen_manager_unlock();
+    screen_manager_request_frame();
+}
+
+/**
+ * @brief Draw the banner on the bottom row while it lasts (UI lock held)
+ */
+static void draw_banner(void)
+{
+    if (!banner_until_ms || esp_timer_get_time() / 1000 >= banner_until_ms) return;
+
+    char row[UI_COLS_MAX + 1];
+    int cols = ui_cols();
+    snprintf(row, sizeof(row), " %-*.*s", cols - 1, cols - 1, banner_text);
+    ui_draw_text(0, ui_row_y(ui_rows() - 1), row, UI_COLOR_BG, UI_COLOR_HIGHLIGHT);
+}
+
+void screen_manager_request_frame(void)
+{
+    if (render_task_handle) {
+        xTaskNotify(render_task_handle, RENDER_BIT_FLUSH, eSetBits);
+    }
+}
+
+/**
+ * @brief Turn a data redraw into a redraw now, or hold it back
+ * @param bits Request bits of this frame
+ * @param held Set to RENDER_BIT_DATA if the redraw waits out its gap
+ * @param last_data When the last data redraw went out
+ * @return bits without RENDER_BIT_DATA
+ */
+static uint32_t pace_data_redraw(uint32_t bits, uint32_t *held, TickType_t *last_data)
+{
+    if (!(bits & RENDER_BIT_DATA)) return bits;
+    bits &= ~RENDER_BIT_DATA;
+
+    TickType_t now = xTaskGetTickCount();
+    if (bits & RENDER_BIT_REDRAW) {
+        *last_data = now;
+    } else if (!panel_visible) {
+        dark_pending = true;
+        // Woken meanwhile: set_visible may have missed the flag
+        if (panel_visible) {
+            dark_pending = false;
+            bits |= RENDER_BIT_REDRAW;
+        }
+    } else if (now - *last_data < pdMS_TO_TICKS(data_redraw_ms)) {
+        *held = RENDER_BIT_DATA;
+    } else {
+        *last_data = now;
+        bits |= RENDER_BIT_REDRAW;
+    }
+    return bits;
+}
+
+static void render_task(void *arg)
+{
+    TickType_t last_frame = xTaskGetTickCount() - pdMS_TO_TICKS(RENDER_FRAME_INTERVAL_MS);
+    TickType_t last_data = last_frame - pdMS_TO_TICKS(SCREEN_DATA_REDRAW_MS);
+    uint32_t held = 0;                      // Data redraw waiting out its gap
+    bool first_frame = true;
+    
+    while (1) {
+        TickType_t wait = portMAX_DELAY;
+        if (held) {
+            TickType_t since = xTaskGetTickCount() - last_data;
+            TickType_t gap = pdMS_TO_TICKS(data_redraw_ms);
+            wait = since < gap ? gap - since : 0;
+        }
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, wait);
+        uint32_t pending = held;
+        held = 0;
+        bits = pace_data_redraw(bits | pending, &held, &last_data);
+        if (!bits) continue;
+        
+        // Cap the frame rate (lower under a saving power profile or for a
+        // screen over its CPU budget); requests arriving meanwhile join this frame
+        TickType_t frame_ticks = pdMS_TO_TICKS(power_governor_frame_ms() <<
+                                               screen_budget_frame_shift());
+        TickType_t elapsed = xTaskGetTickCount() - last_frame;
+        if (elapsed < frame_ticks) {
+            vTaskDelay(frame_ticks - elapsed);
+        }
+        uint32_t more = 0;
+        if (xTaskNotifyWait(0, UINT32_MAX, &more, 0) == pdTRUE) {
+            bits |= more;
+        }
+        // Data arriving in the wait rides along with a redraw, else waits its gap
+        if (bits & RENDER_BIT_DATA) {
+            bits &= ~RENDER_BIT_DATA;
+            if (bits & RENDER_BIT_REDRAW) {
+                last_data = xTaskGetTickCount();
+            } else {
+                held = RENDER_BIT_DATA;
+            }
+        }
+        
+        power_acquire(POWER_LOCK_RENDER);
+        sd_io_render_begin();
+        screen_manager_lock();
+        if (bits & RENDER_BIT_REDRAW) {
+            screen_manager_redraw();
+        }
+        draw_banner();
+#ifdef CONFIG_SCREEN_DEBUG_BREADCRUMB
+        char crumbs[BREADCRUMB_LEN];
+        screen_manager_format_breadcrumb(crumbs, sizeof(crumbs));
+        ui_draw_text(2, 1, crumbs, UI_COLOR_HIGHLIGHT, UI_COLOR_TITLE_BG);
+#endif
+#ifdef CONFIG_SCREEN_PROFILER_OVERLAY
+        char overlay[UI_COLS + 1];
+        screen_profiler_format_overlay(overlay, sizeof(overlay));
+        ui_draw_text(2, 1, overlay, UI_COLOR_HIGHLIGHT, UI_COLOR_TITLE_BG);
+#endif
+#ifdef CONFIG_SCREEN_PROFILER
+        display_stats_t before, after;
+        display_get_stats(&before);
+        display_flush();
+        display_get_stats(&after);
+        display_stats_t delta = {
+            .flushes = after.flushes - before.flushes,
+            .transactions = after.transactions - before.transactions,
+            .pixels = after.pixels - before.pixels,
+            .flush_us = after.flush_us - before.flush_us,
+        };
+        screen_profiler_record_flush(screen_manager_get_current(), &delta);
+#else
+        display_flush();
+#endif
+        screen_record_capture();
+        screen_manager_unlock();
+        sd_io_render_end();
+        power_release(POWER_LOCK_RENDER);
+        
+        if (first_frame && stack_depth > 0) {
+            first_frame = false;
+            boot_profile_end(BOOT_PHASE_FIRST_FRAME, true);
+        }
+        
+        last_frame = xTaskGetTickCount();
     }
 }
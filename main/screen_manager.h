@@ -8,14 +8,50 @@
 
 #include "esp_err.h"
 #include "keyboard.h"
+#include "text_ui.h"
+#include "screen_snapshot.h"
+#include "uart_handler.h"
+#include "sdkconfig.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
-// Maximum screen stack depth
-#define MAX_SCREEN_STACK    8
+// Screen stack grows on demand from SCREEN_STACK_INITIAL up to MAX_SCREEN_STACK
+#define SCREEN_STACK_INITIAL    8
+#ifdef CONFIG_SCREEN_STACK_MAX
+#define MAX_SCREEN_STACK        CONFIG_SCREEN_STACK_MAX
+#else
+#define MAX_SCREEN_STACK        32
+#endif
+
+// Pushes are refused while free internal heap is below this watermark
+#ifdef CONFIG_SCREEN_PUSH_MIN_FREE_KB
+#define SCREEN_PUSH_MIN_FREE    (CONFIG_SCREEN_PUSH_MIN_FREE_KB * 1024)
+#else
+#define SCREEN_PUSH_MIN_FREE    (20 * 1024)
+#endif
+
+// UART routes one screen can hold through screen_subscribe_lines()
+#define SCREEN_MAX_UART_ROUTES  4
+
+// Screen tick period when the screen does not set tick_ms
+#define SCREEN_TICK_DEFAULT_MS      500
+
+// Render task frame pacing (~30 FPS cap); task parameters are in task_plan.h
+#define RENDER_FRAME_INTERVAL_MS    33
+
+// Shortest gap between data-driven redraws when the screen does not set redraw_ms
+#define SCREEN_DATA_REDRAW_MS       200
 
 // Forward declaration
 typedef struct screen_t screen_t;
 
+// Screen arena position, restored when the owning screen is destroyed
+typedef struct {
+    size_t offset;                          // Bump offset into the region
+    void *overflow;                         // Heap fallback list head
+} screen_arena_mark_t;
+
 // Screen create function type
 typedef screen_t* (*screen_create_fn)(void *params);
 
@@ -25,8 +61,32 @@ struct screen_t {
     void (*on_key)(screen_t *self, key_code_t key);  // Key event handler
     void (*on_destroy)(screen_t *self);     // Cleanup function
     void (*on_resume)(screen_t *self);      // Called when screen becomes active again
+    void (*on_restore)(screen_t *self);     // Set to be uncovered from a snapshot of its
+                                            // pixels instead: repaint what changed meanwhile
     void (*on_draw)(screen_t *self);        // Called to redraw the screen
     void (*on_tick)(screen_t *self);        // Called periodically from main loop
+    uint16_t tick_ms;                       // Tick period, 0 = SCREEN_TICK_DEFAULT_MS
+    bool tick_on_uart;                      // Also tick as soon as UART lines arrive
+                                            // (on_tick must not count ticks)
+    uint16_t redraw_ms;                     // Data redraw gap, 0 = SCREEN_DATA_REDRAW_MS
+    uint16_t mem_budget_kb;                 // Most owned_bytes expected (screen_budget.h),
+                                            // 0 = SCREEN_MEM_BUDGET_DEFAULT_KB
+    uint8_t cpu_budget_pct;                 // Most on_draw + on_tick share of a second,
+                                            // 0 = SCREEN_CPU_BUDGET_DEFAULT_PCT
+    uint8_t budget_shift;                   // Managed by screen_manager: frame and tick
+                                            // periods doubled this often, over CPU budget
+    bool over_mem_budget;                   // Managed by screen_manager
+    ui_density_t density;                   // Layout, set with screen_set_density()
+    screen_arena_mark_t arena_mark;         // Managed by screen_manager
+    screen_create_fn create_fn;             // Managed by screen_manager
+    screen_snapshot_t *snapshot;            // Managed by screen_manager, while covered
+    size_t owned_bytes;                     // Heap + arena taken by create, plus arena
+                                            // allocated while active (approx.)
+    uart_response_callback_t line_cb;       // Set with screen_set_line_callback()
+    void *line_cb_data;
+    int8_t uart_routes[SCREEN_MAX_UART_ROUTES]; // Route handle + 1, 0 = unused
+    int8_t relay_route;                     // Managed by screen_manager: line_cb route
+                                            // + 1 while detached, 0 = none
 };
 
 /**
@@ -36,9 +96,16 @@ void screen_manager_init(void);
 
 /**
  * @brief Push a new screen onto the stack
+ *
+ * Refused before create_fn runs when free internal heap is below
+ * SCREEN_PUSH_MIN_FREE even after dropping cached screen models, or when
+ * the stack is at MAX_SCREEN_STACK. create_fn frees params whether it
+ * succeeds or not, but a refused push never reaches it: on ESP_ERR_NO_MEM
+ * params still belong to the caller, which must free them.
  * @param create_fn Function to create the screen
  * @param params Parameters to pass to create function
- * @return ESP_OK on success
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if refused (params not
+ *         consumed), ESP_FAIL if create_fn failed
  */
 esp_err_t screen_manager_push(screen_create_fn create_fn, void *params);
 
@@ -50,6 +117,8 @@ esp_err_t screen_manager_pop(void);
 
 /**
  * @brief Replace current screen with a new one (same stack level)
+ *
+ * With an empty stack this is screen_manager_push(), refusals included.
  * @param create_fn Function to create the screen
  * @param params Parameters to pass to create function
  * @return ESP_OK on success
@@ -61,6 +130,29 @@ esp_err_t screen_manager_replace(screen_create_fn create_fn, void *params);
  */
 void screen_manager_pop_to_root(void);
 
+/**
+ * @brief Take the current screen off the stack without destroying it
+ *
+ * The screen below becomes current. The detached screen keeps receiving
+ * UART lines (its line callback through a route of its own) but is not
+ * ticked or drawn until screen_manager_attach(). The arena is a stack, so
+ * only a screen holding no arena memory may leave it.
+ * @return ESP_OK, ESP_ERR_INVALID_STATE for the root screen, a screen that
+ *         is not current, or one holding arena memory
+ */
+esp_err_t screen_manager_detach(screen_t *screen);
+
+/**
+ * @brief Put a detached screen back on top of the stack and draw it
+ * @return ESP_OK, ESP_FAIL if the stack is full
+ */
+esp_err_t screen_manager_attach(screen_t *screen);
+
+/**
+ * @brief Destroy a detached screen
+ */
+void screen_manager_destroy_detached(screen_t *screen);
+
 /**
  * @brief Get the current active screen
  * @return Pointer to current screen, or NULL if none
@@ -73,6 +165,15 @@ screen_t* screen_manager_get_current(void);
  */
 int screen_manager_get_depth(void);
 
+/**
+ * @brief Format the stack as a breadcrumb of per-screen memory, e.g. "2>14>3K"
+ *
+ * Leading screens are elided as ".." when the text does not fit.
+ * @param buf Output buffer
+ * @param len Buffer size
+ */
+void screen_manager_format_breadcrumb(char *buf, size_t len);
+
 /**
  * @brief Forward a key event to the current screen
  * @param key Key code
@@ -85,6 +186,75 @@ void screen_manager_handle_key(key_code_t key);
  */
 screen_t* screen_alloc(void);
 
+/**
+ * @brief Give a screen the UART line callback slot
+ *
+ * The manager installs the callback while the screen is on top, takes it
+ * away while another screen is pushed over it, puts it back before
+ * on_resume and drops it before on_destroy, so screens never clear or
+ * re-register it themselves. Lines that arrive while the screen is in the
+ * background are not delivered to it.
+ *
+ * Call it from the UI task only: it walks the screen stack unlocked, and
+ * may wait for a UART callback in flight. A line callback that is done
+ * listening sets a flag and lets on_tick drop itself.
+ * @param screen Owning screen (may still be inside its create function)
+ * @param callback Line callback, or NULL to stop listening
+ * @param user_data User data to pass to callback
+ */
+void screen_set_line_callback(screen_t *screen, uart_response_callback_t callback,
+                              void *user_data);
+
+/**
+ * @brief Subscribe a screen to matching UART lines
+ *
+ * Same matching as uart_subscribe_lines(); the route is paused while the
+ * screen is in the background and removed before on_destroy.
+ * @param screen Owning screen
+ * @param kind How pattern is matched
+ * @param pattern Prefix or tag text (ignored for UART_ROUTE_ANY, copied)
+ * @param callback Function to call for each matching line
+ * @param user_data User data to pass to callback
+ * @return Route handle (>= 0), or -1 if no route is free
+ */
+int screen_subscribe_lines(screen_t *screen, uart_route_kind_t kind, const char *pattern,
+                           uart_response_callback_t callback, void *user_data);
+
+/**
+ * @brief Remove a route created by screen_subscribe_lines before the screen goes
+ * @param screen Owning screen
+ * @param handle Route handle (negative values are ignored)
+ */
+void screen_unsubscribe_lines(screen_t *screen, int handle);
+
+/**
+ * @brief Select the layout density of a screen
+ *
+ * Call from the create function before drawing or initializing lists; the
+ * manager switches the layout back whenever the screen becomes active.
+ * @param screen Screen being created
+ * @param density Layout density
+ */
+void screen_set_density(screen_t *screen, ui_density_t density);
+
+/**
+ * @brief Allocate zeroed memory that lives until the screen is popped
+ *
+ * Comes from a region reserved at boot (PSRAM when available) and is
+ * released in bulk, without free(), when the screen being created or the
+ * active screen is destroyed. Call only from a create function or the
+ * active screen's handlers, with the UI lock held. Counts towards the
+ * screen's memory budget.
+ * @param size Bytes (rounded up to 8)
+ * @return Memory, or NULL if neither the region nor the heap has room
+ */
+void* screen_arena_alloc(size_t size);
+
+/**
+ * @brief Bytes of the arena region currently in use
+ */
+size_t screen_arena_used(void);
+
 /**
  * @brief Request a screen redraw
  */
@@ -95,4 +265,76 @@ void screen_manager_redraw(void);
  */
 void screen_manager_tick(void);
 
+/**
+ * @brief Tick period requested by the current screen
+ *
+ * Stretched while the screen is over its CPU budget (screen_budget.h).
+ * @return Milliseconds between ticks
+ */
+uint32_t screen_manager_get_tick_interval(void);
+
+/**
+ * @brief Check whether the current screen wants a tick when UART lines arrive
+ */
+bool screen_manager_ticks_on_uart(void);
+
+/**
+ * @brief Request a full redraw of a screen from any task or timer callback
+ *
+ * The redraw is performed by the render task, coalesced with other requests
+ * to at most one frame per RENDER_FRAME_INTERVAL_MS (longer under a saving
+ * power profile, power_governor.h, or over the screen's CPU budget,
+ * screen_budget.h). Ignored if the screen
+ * is no longer the active one.
+ * @param screen Screen to redraw, or NULL for the current screen
+ */
+void screen_manager_invalidate(screen_t *screen);
+
+/**
+ * @brief Report new data for a screen, from any task or timer callback
+ *
+ * A redraw paced by the data: the first change after a quiet spell is
+ * drawn at the next frame, a stream of them is coalesced to one redraw
+ * per screen->redraw_ms, and none are drawn while the backlight is off
+ * (one follows when it comes back). Screens showing live counters use
+ * this instead of polling a flag on a timer.
+ * @param screen Screen whose data changed; ignored if not the active one
+ */
+void screen_manager_data_changed(screen_t *screen);
+
+/**
+ * @brief Tell the render task whether the panel can be seen (backlight on)
+ */
+void screen_manager_set_visible(bool visible);
+
+/**
+ * @brief Ask the render task to push pending framebuffer changes to the panel
+ *
+ * Use after drawing directly into the framebuffer (under the UI lock).
+ */
+void screen_manager_request_frame(void);
+
+/**
+ * @brief Show a one-line alert over the status bar of whatever screen is up
+ *
+ * Drawn into every frame until it expires; the next screen tick after
+ * that redraws the screen underneath. A newer banner replaces the old one.
+ * @param text Banner text, cut to the screen width
+ * @param duration_ms How long it stays up
+ */
+void screen_manager_show_banner(const char *text, uint32_t duration_ms);
+
+/**
+ * @brief Take the UI lock (recursive)
+ *
+ * Held by whoever draws into the framebuffer or changes the screen stack
+ * outside the render task (main loop key/tick handling, timer callbacks).
+ */
+void screen_manager_lock(void);
+
+/**
+ * @brief Release the UI lock
+ */
+void screen_manager_unlock(void);
+
 #endif // SCREEN_MANAGER_H
@@ -0,0 +1,210 @@
+/**
+ * @file screen_profiler.c
+ * @brief Per-screen redraw and panel traffic statistics
+ */
+
+#include "screen_profiler.h"
+#include "text_ui.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "PROFILER";
+
+#define OVERLAY_WINDOW_US   1000000
+
+typedef struct {
+    screen_create_fn key;
+    char name[20];
+    uint32_t draws;
+    uint64_t draw_us;
+    uint32_t draw_max_us;
+    uint32_t flushes;
+    uint32_t transactions;
+    uint64_t pixels;
+    uint64_t flush_us;
+    screen_latency_t latency;
+} profile_slot_t;
+
+// Rolling one-second window for the overlay
+typedef struct {
+    int64_t start_us;
+    uint32_t frames;
+    uint32_t draws;
+    uint64_t draw_us;
+    uint64_t flush_us;
+} overlay_window_t;
+
+// Only touched under the UI lock (on_draw callers and the render task)
+static profile_slot_t slots[SCREEN_PROFILER_SLOTS];
+static int slot_count = 0;
+static overlay_window_t window;
+static overlay_window_t last_window;
+static profile_slot_t *key_slot = NULL;     // Screen of the key waiting for a frame
+static int64_t key_us;
+static uint32_t last_latency_us;
+
+static profile_slot_t *slot_for(const screen_t *screen)
+{
+    screen_create_fn key = screen ? screen->create_fn : NULL;
+    for (int i = 0; i < slot_count; i++) {
+        if (slots[i].key == key) return &slots[i];
+    }
+    if (slot_count < SCREEN_PROFILER_SLOTS) {
+        profile_slot_t *slot = &slots[slot_count++];
+        memset(slot, 0, sizeof(*slot));
+        slot->key = key;
+        return slot;
+    }
+    return &slots[SCREEN_PROFILER_SLOTS - 1];
+}
+
+static void roll_window(int64_t now)
+{
+    if (now - window.start_us >= OVERLAY_WINDOW_US) {
+        last_window = window;
+        memset(&window, 0, sizeof(window));
+        window.start_us = now;
+    }
+}
+
+void screen_profiler_record_draw(const screen_t *screen, uint32_t us)
+{
+    profile_slot_t *slot = slot_for(screen);
+    
+    // Title is drawn by on_draw itself, so it names the screen afterwards
+    const char *title = ui_get_title();
+    if (title[0]) {
+        snprintf(slot->name, sizeof(slot->name), "%s", title);
+    }
+    slot->draws++;
+    slot->draw_us += us;
+    if (us > slot->draw_max_us) slot->draw_max_us = us;
+    
+    roll_window(esp_timer_get_time());
+    window.draws++;
+    window.draw_us += us;
+}
+
+static void add_latency(screen_latency_t *latency, uint32_t us)
+{
+    int bucket = 0;
+    while (bucket < SCREEN_PROFILER_LATENCY_BUCKETS - 1 &&
+           us >= ((uint32_t)SCREEN_PROFILER_LATENCY_BASE_US << bucket)) {
+        bucket++;
+    }
+    if (latency->samples >= SCREEN_PROFILER_LATENCY_WINDOW) {
+        latency->samples = 0;
+        for (int i = 0; i < SCREEN_PROFILER_LATENCY_BUCKETS; i++) {
+            latency->hist[i] /= 2;
+            latency->samples += latency->hist[i];
+        }
+    }
+    latency->hist[bucket]++;
+    latency->samples++;
+    latency->last_us = us;
+    if (us > latency->max_us) latency->max_us = us;
+    last_latency_us = us;
+}
+
+void screen_profiler_record_key(const screen_t *screen, int64_t event_us)
+{
+    if (key_slot) return;
+    key_slot = slot_for(screen);
+    key_us = event_us;
+}
+
+void screen_profiler_record_flush(const screen_t *screen, const display_stats_t *delta)
+{
+    if (!delta) return;
+    
+    // The first frame after a key shows its effect, or nothing will
+    if (key_slot) {
+        if (delta->pixels > 0) {
+            add_latency(&key_slot->latency, (uint32_t)(esp_timer_get_time() - key_us));
+        } else {
+            key_slot->latency.unseen++;
+        }
+        key_slot = NULL;
+    }
+    if (delta->flushes == 0) return;
+    
+    profile_slot_t *slot = slot_for(screen);
+    slot->flushes += delta->flushes;
+    slot->transactions += delta->transactions;
+    slot->pixels += delta->pixels;
+    slot->flush_us += delta->flush_us;
+    
+    roll_window(esp_timer_get_time());
+    window.frames += delta->flushes;
+    window.flush_us += delta->flush_us;
+}
+
+void screen_profiler_format_overlay(char *buf, size_t len)
+{
+    roll_window(esp_timer_get_time());
+    
+    const overlay_window_t *w = &last_window;
+    uint32_t draw_ms = w->draws ? (uint32_t)(w->draw_us / w->draws / 1000) : 0;
+    uint32_t bus_pct = (uint32_t)(w->flush_us * 100 / OVERLAY_WINDOW_US);
+    snprintf(buf, len, "%luf %lums %lu%% k%lu", (unsigned long)w->frames,
+             (unsigned long)draw_ms, (unsigned long)bus_pct,
+             (unsigned long)(last_latency_us / 1000));
+}
+
+bool screen_profiler_get_latency(const screen_t *screen, screen_latency_t *out)
+{
+    screen_create_fn key = screen ? screen->create_fn : NULL;
+    for (int i = 0; i < slot_count; i++) {
+        if (slots[i].key != key) continue;
+        *out = slots[i].latency;
+        return out->samples > 0 || out->unseen > 0;
+    }
+    return false;
+}
+
+uint32_t screen_profiler_latency_percentile(const screen_latency_t *latency, uint32_t permille)
+{
+    if (latency->samples == 0) return 0;
+    
+    uint32_t seen = 0;
+    for (int i = 0; i < SCREEN_PROFILER_LATENCY_BUCKETS - 1; i++) {
+        seen += latency->hist[i];
+        if (seen * 1000 >= latency->samples * permille) {
+            return (uint32_t)SCREEN_PROFILER_LATENCY_BASE_US << i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+void screen_profiler_dump(void)
+{
+    ESP_LOGI(TAG, "%-19s %6s %8s %7s %6s %6s %9s %8s", "screen", "draws", "avg_us",
+             "max_us", "frames", "spi", "kpixels", "flush_ms");
+    for (int i = 0; i < slot_count; i++) {
+        const profile_slot_t *s = &slots[i];
+        ESP_LOGI(TAG, "%-19s %6lu %8lu %7lu %6lu %6lu %9lu %8lu",
+                 s->name[0] ? s->name : "?", (unsigned long)s->draws,
+                 (unsigned long)(s->draws ? s->draw_us / s->draws : 0),
+                 (unsigned long)s->draw_max_us, (unsigned long)s->flushes,
+                 (unsigned long)s->transactions, (unsigned long)(s->pixels / 1000),
+                 (unsigned long)(s->flush_us / 1000));
+    }
+    
+    // Percentiles are bucket bounds: "p50 4" means half the keys showed in under 4 ms
+    ESP_LOGI(TAG, "%-19s %6s %6s %6s %6s %6s %7s", "input", "keys", "unseen",
+             "p50_ms", "p95_ms", "max_ms", "last_ms");
+    for (int i = 0; i < slot_count; i++) {
+        const screen_latency_t *l = &slots[i].latency;
+        if (l->samples == 0 && l->unseen == 0) continue;
+        uint32_t p50 = screen_profiler_latency_percentile(l, 500);
+        uint32_t p95 = screen_profiler_latency_percentile(l, 950);
+        ESP_LOGI(TAG, "%-19s %6lu %6lu %6ld %6ld %6lu %7lu",
+                 slots[i].name[0] ? slots[i].name : "?", (unsigned long)l->samples,
+                 (unsigned long)l->unseen,
+                 p50 == UINT32_MAX ? -1L : (long)(p50 / 1000),
+                 p95 == UINT32_MAX ? -1L : (long)(p95 / 1000),
+                 (unsigned long)(l->max_us / 1000), (unsigned long)(l->last_us / 1000));
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ * @file screen_profiler.h
+ * @brief Per-screen redraw and panel traffic statistics
+ *
+ * Enabled with CONFIG_SCREEN_PROFILER. screen_manager times every on_draw
+ * and attributes each flush's SPI transfers and pixels to the active
+ * screen; screens are named after their title bar text.
+ *
+ * Input-to-photon latency: a key handed to a screen's on_key carries the
+ * keyboard driver's timestamp (key interrupt, or matrix scan on polled
+ * boards). The first flush after it ends the sample when it sent pixels;
+ * a flush that changed nothing means the key had no visible effect and
+ * the key is counted as unseen instead. While keys arrive faster than
+ * frames, the oldest waiting key is the one timed. Samples go into a log2
+ * histogram per screen that halves every SCREEN_PROFILER_LATENCY_WINDOW
+ * samples, so it follows recent behaviour.
+ */
+
+#ifndef SCREEN_PROFILER_H
+#define SCREEN_PROFILER_H
+
+#include "screen_manager.h"
+#include "display.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Distinct screens tracked; later ones share the last slot
+#define SCREEN_PROFILER_SLOTS   16
+
+#define SCREEN_PROFILER_LATENCY_BUCKETS 12      // <1 ms, <2 ms, ... <1 s, then slower
+#define SCREEN_PROFILER_LATENCY_BASE_US 1000
+#define SCREEN_PROFILER_LATENCY_WINDOW  256     // Samples before the histogram halves
+
+typedef struct {
+    uint32_t samples;               // In hist
+    uint32_t unseen;                // Keys whose first frame changed nothing
+    uint32_t last_us;
+    uint32_t max_us;
+    uint16_t hist[SCREEN_PROFILER_LATENCY_BUCKETS];
+} screen_latency_t;
+
+/**
+ * @brief Account one on_draw call
+ * @param screen Screen that drew
+ * @param us Time spent in on_draw
+ */
+void screen_profiler_record_draw(const screen_t *screen, uint32_t us);
+
+/**
+ * @brief Account one display_flush()
+ * @param screen Screen active during the flush
+ * @param delta Difference of display stats across the flush
+ */
+void screen_profiler_record_flush(const screen_t *screen, const display_stats_t *delta);
+
+/**
+ * @brief Start an input-to-photon sample (called before on_key)
+ * @param screen Screen the key goes to
+ * @param event_us Driver timestamp of the key (keyboard_get_event_time_us)
+ */
+void screen_profiler_record_key(const screen_t *screen, int64_t event_us);
+
+/**
+ * @brief Copy a screen's input latency histogram (UI lock held)
+ * @return false if the screen has no samples or unseen keys yet
+ */
+bool screen_profiler_get_latency(const screen_t *screen, screen_latency_t *out);
+
+/**
+ * @brief Upper bucket bound under which a share of the samples fall
+ * @param permille 500 for the median, 950 for p95
+ * @return Microseconds, 0 without samples, UINT32_MAX in the last bucket
+ */
+uint32_t screen_profiler_latency_percentile(const screen_latency_t *latency, uint32_t permille);
+
+/**
+ * @brief Overlay text for the current second, e.g. "12f 3ms 40% k45"
+ *
+ * Frames flushed, average on_draw time and SPI bus share of the last
+ * complete second, then the latest input-to-photon time in ms.
+ */
+void screen_profiler_format_overlay(char *buf, size_t len);
+
+/**
+ * @brief Log the per-screen tables (redraws, input latency) to the console
+ */
+void screen_profiler_dump(void);
+
+#endif // SCREEN_PROFILER_H
@@ -0,0 +1,59 @@
+/**
+ * @file screen_registry.c
+ * @brief Menu entries registered by the screens themselves
+ */
+
+#include "screen_registry.h"
+#include "esp_log.h"
+
+static const char *TAG = "SCREEN_REG";
+
+// Section bounds from SURROUND(screen_registry) in screen_registry.lf
+extern const screen_desc_t _screen_registry_start;
+extern const screen_desc_t _screen_registry_end;
+
+// Visible entries per menu and mode, [menu][red_team]
+static const screen_desc_t *menus[SCREEN_MENU_COUNT][2][SCREEN_MENU_MAX_ITEMS];
+static int menu_counts[SCREEN_MENU_COUNT][2];
+static bool menus_built = false;
+
+static void build_menus(void)
+{
+    for (const screen_desc_t *d = &_screen_registry_start; d < &_screen_registry_end; d++) {
+        if (d->menu >= SCREEN_MENU_COUNT) continue;
+        
+        for (int red_team = 0; red_team < 2; red_team++) {
+            if ((d->flags & SCREEN_CAP_RED_TEAM) && !red_team) continue;
+            
+            int *count = &menu_counts[d->menu][red_team];
+            if (*count >= SCREEN_MENU_MAX_ITEMS) {
+                ESP_LOGW(TAG, "Menu %d full, '%s' not listed", d->menu, d->title);
+                continue;
+            }
+            menus[d->menu][red_team][(*count)++] = d;
+        }
+    }
+    menus_built = true;
+    ESP_LOGI(TAG, "%d screens registered",
+             (int)(&_screen_registry_end - &_screen_registry_start));
+}
+
+const screen_desc_t *const *screen_registry_menu(screen_menu_t menu, bool red_team,
+                                                 int *out_count)
+{
+    // Menus are only opened from the UI task
+    if (!menus_built) build_menus();
+    
+    if (menu >= SCREEN_MENU_COUNT) {
+        if (out_count) *out_count = 0;
+        return NULL;
+    }
+    if (out_count) *out_count = menu_counts[menu][red_team ? 1 : 0];
+    return menus[menu][red_team ? 1 : 0];
+}
+
+const char *screen_registry_title(const screen_desc_t *desc, bool red_team)
+{
+    if (!desc) return "";
+    return (red_team || !desc->title_test) ? desc->title : desc->title_test;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file screen_registry.h
+ * @brief Menu entries registered by the screens themselves
+ *
+ * A screen that appears in a menu declares itself next to its create
+ * function with SCREEN_REGISTER(). The descriptor lands in the
+ * .screen_registry linker section (screen_registry.lf), sorted by menu and
+ * order key, so menus are a contiguous const table in flash with no list
+ * to keep in step. Entries keep their natural alignment (the compiler
+ * may otherwise pad larger objects), so the section is a plain array.
+ * The component links as a whole archive, so a screen
+ * that is only reached through its menu entry is still linked in; leaving
+ * its source out of the build (SCREENS_EXCLUDE in CMakeLists.txt) drops
+ * it and its entry together.
+ *
+ * The visible subset of each menu for both red team modes is collected
+ * once, on first use; after that a menu is a pointer and a count.
+ */
+
+#ifndef SCREEN_REGISTRY_H
+#define SCREEN_REGISTRY_H
+
+#include "screen_manager.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Menus that take registered entries
+typedef enum {
+    SCREEN_MENU_HOME = 0,
+    SCREEN_MENU_COUNT
+} screen_menu_t;
+
+// Longest menu (entries beyond it are not shown)
+#define SCREEN_MENU_MAX_ITEMS   16
+
+// Capability flags
+#define SCREEN_CAP_RED_TEAM     (1 << 0)    // Listed only with red team enabled
+
+typedef struct {
+    const char *title;              // Title with red team enabled
+    const char *title_test;         // Title otherwise, NULL = same
+    screen_create_fn create_fn;
+    uint8_t menu;                   // screen_menu_t
+    uint8_t flags;                  // SCREEN_CAP_*
+} screen_desc_t;
+
+/**
+ * @brief Register a menu entry
+ * @param menu Menu suffix (HOME for SCREEN_MENU_HOME)
+ * @param order Two-digit position key within the menu (10, 20, ...)
+ * @param fn Screen create function, also names the descriptor
+ * @param flags SCREEN_CAP_* flags
+ * @param title Title with red team enabled
+ * @param title_test Title otherwise, or NULL
+ */
+#define SCREEN_REGISTER(menu, order, fn, flags, title, title_test)                  \
+    static const screen_desc_t screen_desc_##fn                                     \
+        __attribute__((used, aligned(__alignof__(screen_desc_t)),                   \
+                       section(".screen_registry." #menu "." #order))) = {          \
+        (title), (title_test), (fn), SCREEN_MENU_##menu, (flags)                    \
+    }
+
+/**
+ * @brief Entries of a menu visible in a mode, in order
+ * @param menu Menu
+ * @param red_team Red team mode
+ * @param out_count Number of entries
+ * @return Table of out_count descriptors
+ */
+const screen_desc_t *const *screen_registry_menu(screen_menu_t menu, bool red_team,
+                                                 int *out_count);
+
+/**
+ * @brief Title of an entry for a mode
+ */
+const char *screen_registry_title(const screen_desc_t *desc, bool red_team);
+
+#endif // SCREEN_REGISTRY_H
@@ -0,0 +1,244 @@
+/**
+ * @file screen_snapshot.c
+ * @brief Compressed framebuffer copies of covered screens
+ */
+
+#include "screen_snapshot.h"
+#include "display.h"
+#include "mem_monitor.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "SCREEN_SNAP";
+
+#ifdef CONFIG_SPIRAM
+#define SNAPSHOT_CAPS   (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define SNAPSHOT_CAPS   (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+// Row coding, PackBits style on 16-bit pixels: a control byte below 0x80
+// is followed by that many plus one literal pixels, one from 0x80 up by a
+// single pixel repeated (control - 0x80 + 2) times. Rows start afresh.
+#define RUN_FLAG        0x80
+#define RUN_MIN         2
+#define RUN_MAX         (0x7F + RUN_MIN)
+#define LITERAL_MAX     0x80
+
+struct screen_snapshot {
+    uint8_t *data;                  // NULL once released on low memory
+    size_t bytes;
+    ui_frame_state_t ui;
+    screen_snapshot_t *next;        // Live snapshots
+};
+
+static SemaphoreHandle_t snapshot_mutex = NULL;
+static screen_snapshot_t *live = NULL;
+static size_t held = 0;             // Bytes of pixel data in live snapshots
+
+/**
+ * @brief Code one row
+ * @param out Destination, or NULL to measure
+ * @return Coded bytes
+ */
+static size_t encode_row(const uint16_t *px, int w, uint8_t *out)
+{
+    size_t bytes = 0;
+    int i = 0;
+
+    while (i < w) {
+        int run = 1;
+        while (i + run < w && run < RUN_MAX && px[i + run] == px[i]) run++;
+        if (run >= RUN_MIN) {
+            if (out) {
+                out[bytes] = (uint8_t)(RUN_FLAG | (run - RUN_MIN));
+                memcpy(&out[bytes + 1], &px[i], sizeof(uint16_t));
+            }
+            bytes += 1 + sizeof(uint16_t);
+            i += run;
+            continue;
+        }
+
+        // Literals up to where the next run starts
+        int count = 1;
+        while (i + count < w && count < LITERAL_MAX &&
+               !(i + count + 1 < w && px[i + count] == px[i + count + 1])) {
+            count++;
+        }
+        if (out) {
+            out[bytes] = (uint8_t)(count - 1);
+            memcpy(&out[bytes + 1], &px[i], count * sizeof(uint16_t));
+        }
+        bytes += 1 + count * sizeof(uint16_t);
+        i += count;
+    }
+    return bytes;
+}
+
+/**
+ * @brief Decode one row
+ * @return Bytes of in consumed
+ */
+static size_t decode_row(const uint8_t *in, uint16_t *px, int w)
+{
+    const uint8_t *p = in;
+    int i = 0;
+
+    while (i < w) {
+        uint8_t control = *p++;
+        if (control & RUN_FLAG) {
+            uint16_t value;
+            memcpy(&value, p, sizeof(value));
+            p += sizeof(value);
+            int run = (control & ~RUN_FLAG) + RUN_MIN;
+            if (run > w - i) run = w - i;
+            for (int k = 0; k < run; k++) px[i++] = value;
+        } else {
+            int count = control + 1;
+            if (count > w - i) count = w - i;
+            memcpy(&px[i], p, count * sizeof(uint16_t));
+            p += (control + 1) * sizeof(uint16_t);
+            i += count;
+        }
+    }
+    return (size_t)(p - in);
+}
+
+/**
+ * @brief Code the whole framebuffer
+ * @param out Destination, or NULL to measure
+ * @return Coded bytes
+ */
+static size_t encode_frame(uint8_t *out)
+{
+    uint16_t row[DISPLAY_WIDTH];
+    size_t bytes = 0;
+
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        display_read_pixels(0, y, DISPLAY_WIDTH, 1, row);
+        bytes += encode_row(row, DISPLAY_WIDTH, out ? out + bytes : NULL);
+    }
+    return bytes;
+}
+
+esp_err_t screen_snapshot_init(void)
+{
+    if (snapshot_mutex) return ESP_OK;
+
+    snapshot_mutex = xSemaphoreCreateMutex();
+    if (!snapshot_mutex) {
+        ESP_LOGE(TAG, "Failed to create snapshot mutex");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+screen_snapshot_t *screen_snapshot_take(void)
+{
+    if (SCREEN_SNAPSHOT_BUDGET == 0 || !snapshot_mutex) return NULL;
+
+    // Measured first, so the copy takes exactly its size
+    size_t bytes = encode_frame(NULL);
+    xSemaphoreTake(snapshot_mutex, portMAX_DELAY);
+    bool fits = bytes <= SCREEN_SNAPSHOT_BUDGET - held;
+    if (fits) held += bytes;
+    xSemaphoreGive(snapshot_mutex);
+    if (!fits) {
+        ESP_LOGD(TAG, "%u bytes would exceed the budget, not kept", (unsigned)bytes);
+        return NULL;
+    }
+
+    screen_snapshot_t *snap = calloc(1, sizeof(*snap));
+    uint8_t *data = heap_caps_malloc(bytes, SNAPSHOT_CAPS);
+    if (!data) data = malloc(bytes);
+    if (!snap || !data) {
+        free(snap);
+        free(data);
+        xSemaphoreTake(snapshot_mutex, portMAX_DELAY);
+        held -= bytes;
+        xSemaphoreGive(snapshot_mutex);
+        return NULL;
+    }
+    encode_frame(data);
+    ui_save_frame_state(&snap->ui);
+    mem_monitor_account(MEM_SUB_SCREENS, (int32_t)bytes);
+
+    xSemaphoreTake(snapshot_mutex, portMAX_DELAY);
+    snap->data = data;
+    snap->bytes = bytes;
+    snap->next = live;
+    live = snap;
+    xSemaphoreGive(snapshot_mutex);
+
+    ESP_LOGD(TAG, "Kept %u bytes (%u held)", (unsigned)bytes, (unsigned)held);
+    return snap;
+}
+
+bool screen_snapshot_restore(const screen_snapshot_t *snap)
+{
+    if (!snap) return false;
+
+    uint16_t row[DISPLAY_WIDTH];
+    xSemaphoreTake(snapshot_mutex, portMAX_DELAY);
+    const uint8_t *p = snap->data;
+    if (p) {
+        for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+            p += decode_row(p, row, DISPLAY_WIDTH);
+            display_blit(0, y, DISPLAY_WIDTH, 1, row);
+        }
+    }
+    xSemaphoreGive(snapshot_mutex);
+    if (!p) return false;
+
+    ui_restore_frame_state(&snap->ui);
+    return true;
+}
+
+/**
+ * @brief Free the pixels of a snapshot (snapshot_mutex held)
+ * @return Bytes released
+ */
+static size_t release_data(screen_snapshot_t *snap)
+{
+    if (!snap->data) return 0;
+    size_t bytes = snap->bytes;
+    free(snap->data);
+    snap->data = NULL;
+    held -= bytes;
+    mem_monitor_account(MEM_SUB_SCREENS, -(int32_t)bytes);
+    return bytes;
+}
+
+void screen_snapshot_free(screen_snapshot_t *snap)
+{
+    if (!snap) return;
+
+    xSemaphoreTake(snapshot_mutex, portMAX_DELAY);
+    release_data(snap);
+    for (screen_snapshot_t **link = &live; *link; link = &(*link)->next) {
+        if (*link == snap) {
+            *link = snap->next;
+            break;
+        }
+    }
+    xSemaphoreGive(snapshot_mutex);
+    free(snap);
+}
+
+size_t screen_snapshot_release_all(void)
+{
+    if (!snapshot_mutex) return 0;
+
+    size_t released = 0;
+    xSemaphoreTake(snapshot_mutex, portMAX_DELAY);
+    for (screen_snapshot_t *snap = live; snap; snap = snap->next) {
+        released += release_data(snap);
+    }
+    xSemaphoreGive(snapshot_mutex);
+    return released;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file screen_snapshot.h
+ * @brief Compressed framebuffer copies of covered screens
+ *
+ * A screen that can be put back from its pixels (it sets on_restore) has
+ * what it showed kept when another screen is pushed over it. The copy is
+ * run-length coded per row: the UI is mostly black and flat bars, so a
+ * menu costs a few KB instead of the 64 KB of the framebuffer. Popping
+ * back decodes it into the framebuffer, which the next flush sends as one
+ * full-screen transfer, and gives text_ui back its record of that frame,
+ * so the screen's retained widgets (ui_list rows, labels, status strips)
+ * still count as drawn and on_restore repaints only what changed.
+ *
+ * Snapshots share SCREEN_SNAPSHOT_BUDGET_KB; one that does not fit is not
+ * taken, and low memory releases them all. Either way the pop falls back
+ * to on_resume or a full redraw.
+ */
+
+#ifndef SCREEN_SNAPSHOT_H
+#define SCREEN_SNAPSHOT_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "text_ui.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef CONFIG_SCREEN_SNAPSHOT_BUDGET_KB
+#define SCREEN_SNAPSHOT_BUDGET  (CONFIG_SCREEN_SNAPSHOT_BUDGET_KB * 1024)
+#else
+#define SCREEN_SNAPSHOT_BUDGET  (48 * 1024)
+#endif
+
+typedef struct screen_snapshot screen_snapshot_t;
+
+/**
+ * @brief Initialize (called by screen_manager_init)
+ * @return ESP_OK, ESP_ERR_NO_MEM
+ */
+esp_err_t screen_snapshot_init(void);
+
+/**
+ * @brief Compress the framebuffer and text_ui's record of it (UI lock held)
+ * @return NULL when disabled, over budget or out of memory
+ */
+screen_snapshot_t *screen_snapshot_take(void);
+
+/**
+ * @brief Put a snapshot back into the framebuffer (UI lock held)
+ * @return false if low memory released it meanwhile; nothing was drawn
+ */
+bool screen_snapshot_restore(const screen_snapshot_t *snap);
+
+/**
+ * @brief Free a snapshot (NULL is ignored)
+ */
+void screen_snapshot_free(screen_snapshot_t *snap);
+
+/**
+ * @brief Drop the pixels of every snapshot (low-memory callback, any task)
+ * @return Bytes released
+ */
+size_t screen_snapshot_release_all(void);
+
+#endif // SCREEN_SNAPSHOT_H
@@ -1,10 +1,21 @@
 /**
  * @file airtag_scan_screen.c
  * @brief AirTag scan screen implementation
+ *
+ * scan_airtag only reports counts, so the screen runs scan_bt passes back
+ * to back instead: the pass summary gives the AirTag/SmartTag counts and
+ * every device world_model filed during the pass goes into the tracker
+ * sighting database together with the CAP GPS position, when there is one. The list below the counts is
+ * the database's answer to "what has been following me".
  */
 
 #include "airtag_scan_screen.h"
 #include "uart_handler.h"
+#include "bt_store.h"
+#include "world_model.h"
+#include "tracker_db.h"
+#include "cap_gps.h"
+#include "settings.h"
 #include "text_ui.h"
 #include "esp_log.h"
 #include "esp_timer.h"
@@ -14,82 +25,195 @@
 
 static const char *TAG = "AIRTAG_SCAN";
 
-// Refresh timer interval (200ms)
-#define REFRESH_INTERVAL_US 200000
+#define VISIBLE_ROWS        4
+#define LIST_START_ROW      3
+#define REDRAW_INTERVAL_US  500000  // Redraw at most twice a second
+#define GPS_MAX_AGE_MS      5000    // Older fixes are not used as positions
 
 // Screen user data
 typedef struct {
     int airtag_count;
     int smarttag_count;
-    bool needs_redraw;
-    esp_timer_handle_t refresh_timer;
+    uint16_t followers[TRACKER_DB_MAX];
+    int follower_count;
+    int scroll_offset;
+    uint32_t view_generation;
+    int64_t view_time_us;
+    uint16_t seen[BT_STORE_MAX];    // Store indices heard in the last pass
+    uint32_t bt_passes;             // world_model pass count at the last scan_bt
+    int64_t pass_start_us;
+    bool gps_ok;                    // Last pass had a position
+    bool is_cap_gps;
     screen_t *self;
 } airtag_scan_data_t;
 
-// Forward declaration
-static void draw_screen(screen_t *self);
+/**
+ * @brief Current CAP GPS position and time for a sighting
+ */
+static void current_where(airtag_scan_data_t *data, tracker_where_t *w)
+{
+    memset(w, 0, sizeof(*w));
+    if (!data->is_cap_gps) return;
+
+    cap_gps_snapshot_t snap;
+    if (!cap_gps_get_snapshot(&snap)) return;
+    if (snap.utc_time) {
+        w->utc = snap.utc_time + snap.fix_age_ms / 1000;
+    }
+    if (snap.fix && snap.fix_age_ms <= GPS_MAX_AGE_MS) {
+        w->has_position = true;
+        w->lat_e7 = snap.lat_e7;
+        w->lon_e7 = snap.lon_e7;
+    }
+}
 
 /**
- * @brief Timer callback - checks if redraw is needed
+ * @brief Put every device seen during the pass that just ended into the
+ *        sighting database
  */
-static void refresh_timer_callback(void *arg)
+static void record_pass(airtag_scan_data_t *data)
 {
-    airtag_scan_data_t *data = (airtag_scan_data_t *)arg;
-    if (data && data->needs_redraw && data->self) {
-        data->needs_redraw = false;
-        draw_screen(data->self);
+    int64_t now = esp_timer_get_time();
+    uint32_t pass_ms = (uint32_t)((now - data->pass_start_us) / 1000) + 1;
+    data->pass_start_us = now;
+
+    tracker_where_t where;
+    current_where(data, &where);
+    data->gps_ok = where.has_position;
+
+    int n = bt_store_view(data->seen, BT_STORE_MAX, BT_SORT_LAST_SEEN, pass_ms);
+    for (int i = 0; i < n; i++) {
+        bt_record_t rec;
+        if (bt_store_get(data->seen[i], &rec)) {
+            tracker_db_add(rec.mac, rec.rssi, &where);
+        }
+    }
+
+    if (world_model_tag_counts(&data->airtag_count, &data->smarttag_count)) {
+        ESP_LOGI(TAG, "AirTags: %d, SmartTags: %d", data->airtag_count, data->smarttag_count);
+    }
+}
+
+static void refresh_view(airtag_scan_data_t *data)
+{
+    data->view_generation = tracker_db_generation();
+    data->view_time_us = esp_timer_get_time();
+    data->follower_count = tracker_db_followers(data->followers, TRACKER_DB_MAX);
+    if (data->scroll_offset >= data->follower_count) {
+        data->scroll_offset = 0;
     }
 }
 
 /**
- * @brief UART line callback for parsing airtag scan output
- * Format: "2,3" where 2=airtag_count, 3=smarttag_count
+ * @brief Format a duration as "45s", "12m", "3h" or "2d"
  */
-static void uart_line_callback(const char *line, void *user_data)
+static void format_span(uint32_t seconds, char *out, size_t len)
 {
-    airtag_scan_data_t *data = (airtag_scan_data_t *)user_data;
-    if (!data) return;
-    
-    int airtags = 0, smarttags = 0;
-    
-    // Try to parse "N,M" format
-    if (sscanf(line, "%d,%d", &airtags, &smarttags) == 2) {
-        data->airtag_count = airtags;
-        data->smarttag_count = smarttags;
-        data->needs_redraw = true;
-        
-        ESP_LOGI(TAG, "AirTags: %d, SmartTags: %d", airtags, smarttags);
+    if (seconds < 60) {
+        snprintf(out, len, "%lus", (unsigned long)seconds);
+    } else if (seconds < 3600) {
+        snprintf(out, len, "%lum", (unsigned long)(seconds / 60));
+    } else if (seconds < 86400) {
+        snprintf(out, len, "%luh", (unsigned long)(seconds / 3600));
+    } else {
+        snprintf(out, len, "%lud", (unsigned long)(seconds / 86400));
     }
 }
 
 static void draw_screen(screen_t *self)
 {
     airtag_scan_data_t *data = (airtag_scan_data_t *)self->user_data;
-    
+    char line[40];
+
     ui_clear();
-    
+
     // Draw title
     ui_draw_title("AirTag Scan");
-    
-    // Draw AirTag count
-    char airtag_str[16];
-    snprintf(airtag_str, sizeof(airtag_str), "%d", data->airtag_count);
-    ui_print_center(2, airtag_str, UI_COLOR_HIGHLIGHT);
-    ui_print_center(3, "AirTags", UI_COLOR_TEXT);
-    
-    // Draw SmartTag count
-    char smarttag_str[16];
-    snprintf(smarttag_str, sizeof(smarttag_str), "%d", data->smarttag_count);
-    ui_print_center(5, smarttag_str, UI_COLOR_HIGHLIGHT);
-    ui_print_center(6, "SmartTags", UI_COLOR_TEXT);
-    
+
+    // Counts from the last pass
+    snprintf(line, sizeof(line), "AirTags: %d  SmartTags: %d",
+             data->airtag_count, data->smarttag_count);
+    ui_print_center(1, line, UI_COLOR_HIGHLIGHT);
+
+    snprintf(line, sizeof(line), "Devices: %d  Following: %d",
+             tracker_db_count(), data->follower_count);
+    ui_print(0, 2, line, UI_COLOR_TEXT);
+
+    if (data->follower_count == 0) {
+        ui_print_center(4, data->gps_ok ? "Nothing following you" : "Needs CAP GPS fix",
+                        UI_COLOR_DIMMED);
+    } else {
+        for (int i = 0; i < VISIBLE_ROWS; i++) {
+            int pos = data->scroll_offset + i;
+            tracker_entry_t e;
+            if (pos >= data->follower_count || !tracker_db_get(data->followers[pos], &e)) continue;
+
+            char span[8] = "?";
+            if (e.first_utc && e.last_utc >= e.first_utc) {
+                format_span(e.last_utc - e.first_utc, span, sizeof(span));
+            }
+            snprintf(line, sizeof(line), "%02X:%02X:%02X:%02X:%02X:%02X %2up %s",
+                     e.mac[0], e.mac[1], e.mac[2], e.mac[3], e.mac[4], e.mac[5],
+                     (unsigned)e.places, span);
+            ui_print(0, LIST_START_ROW + i, line, UI_COLOR_HIGHLIGHT);
+        }
+
+        // Scroll indicators
+        if (data->scroll_offset > 0) {
+            ui_print(UI_COLS - 1, LIST_START_ROW, "^", UI_COLOR_DIMMED);
+        }
+        if (data->scroll_offset + VISIBLE_ROWS < data->follower_count) {
+            ui_print(UI_COLS - 1, LIST_START_ROW + VISIBLE_ROWS - 1, "v", UI_COLOR_DIMMED);
+        }
+    }
+
     // Draw status bar
-    ui_draw_status("ESC: Stop & Exit");
+    ui_draw_status(data->gps_ok ? "GPS  UP/DOWN:Scroll ESC:Exit" : "UP/DOWN:Scroll ESC:Stop&Exit");
+}
+
+static void on_tick(screen_t *self)
+{
+    airtag_scan_data_t *data = (airtag_scan_data_t *)self->user_data;
+
+    // A finished pass is recorded and starts the next
+    uint32_t passes = world_model_bt_passes();
+    if (passes != data->bt_passes) {
+        data->bt_passes = passes;
+        record_pass(data);
+        uart_send_command("scan_bt");
+    }
+
+    // Queued sighting records go to the tracker_db writer task
+    tracker_db_sync();
+
+    int64_t now = esp_timer_get_time();
+    if (now - data->view_time_us < REDRAW_INTERVAL_US ||
+        tracker_db_generation() == data->view_generation) {
+        return;
+    }
+    refresh_view(data);
+    draw_screen(self);
 }
 
 static void on_key(screen_t *self, key_code_t key)
 {
+    airtag_scan_data_t *data = (airtag_scan_data_t *)self->user_data;
+
     switch (key) {
+        case KEY_UP:
+            if (data->scroll_offset > 0) {
+                data->scroll_offset--;
+                draw_screen(self);
+            }
+            break;
+
+        case KEY_DOWN:
+            if (data->scroll_offset + VISIBLE_ROWS < data->follower_count) {
+                data->scroll_offset++;
+                draw_screen(self);
+            }
+            break;
+
         case KEY_ESC:
         case KEY_Q:
         case KEY_BACKSPACE:
@@ -97,7 +221,7 @@ static void on_key(screen_t *self, key_code_t key)
             uart_send_command("stop");
             screen_manager_pop();
             break;
-            
+
         default:
             break;
     }
@@ -106,78 +230,58 @@ static void on_key(screen_t *self, key_code_t key)
 static void on_destroy(screen_t *self)
 {
     airtag_scan_data_t *data = (airtag_scan_data_t *)self->user_data;
-    
-    // Stop and delete timer
-    if (data && data->refresh_timer) {
-        esp_timer_stop(data->refresh_timer);
-        esp_timer_delete(data->refresh_timer);
-    }
-    
-    // Clear UART callback
-    uart_clear_line_callback();
-    
-    if (data) {
-        free(data);
+
+    if (data && data->is_cap_gps) {
+        cap_gps_deinit();
     }
+
+    tracker_db_close();
+    free(data);
 }
 
 screen_t* airtag_scan_screen_create(void *params)
 {
     (void)params;
-    
+
     ESP_LOGI(TAG, "Creating AirTag scan screen...");
-    
+
+    if (bt_store_init() != ESP_OK || tracker_db_open() != ESP_OK) return NULL;
+
     screen_t *screen = screen_alloc();
     if (!screen) return NULL;
-    
+
     // Allocate user data
     airtag_scan_data_t *data = calloc(1, sizeof(airtag_scan_data_t));
     if (!data) {
         free(screen);
         return NULL;
     }
-    
+
     data->self = screen;
-    data->airtag_count = 0;
-    data->smarttag_count = 0;
-    
+    data->is_cap_gps = (settings_get_gps_type() == GPS_TYPE_CAP);
+    data->bt_passes = world_model_bt_passes();
+    data->pass_start_us = esp_timer_get_time();
+    refresh_view(data);
+
     screen->user_data = data;
     screen->on_key = on_key;
     screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
-    
-    // Create periodic refresh timer
-    esp_timer_create_args_t timer_args = {
-        .callback = refresh_timer_callback,
-        .arg = data,
-        .name = "airtag_refresh"
-    };
-    
-    if (esp_timer_create(&timer_args, &data->refresh_timer) == ESP_OK) {
-        esp_timer_start_periodic(data->refresh_timer, REFRESH_INTERVAL_US);
-    } else {
-        ESP_LOGW(TAG, "Failed to create refresh timer");
+    screen->on_tick = on_tick;
+
+    if (data->is_cap_gps) {
+        esp_err_t ret = cap_gps_init();
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to init CAP GPS: %s", esp_err_to_name(ret));
+        }
     }
-    
-    // Register UART callback
-    uart_register_line_callback(uart_line_callback, data);
-    
-    // Send scan_airtag command
-    uart_send_command("scan_airtag");
-    
+
+    // Send scan_bt command (repeated from on_tick after each pass)
+    uart_send_command("scan_bt");
+
     // Draw initial screen
     draw_screen(screen);
-    
-    ESP_LOGI(TAG, "AirTag scan screen created");
+
+    ESP_LOGI(TAG, "AirTag scan screen created (%d devices on record)", tracker_db_count());
     return screen;
 }
-
-
-
-
-
-
-
-
-
-
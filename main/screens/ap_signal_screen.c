@@ -0,0 +1,240 @@
+/**
+ * @file ap_signal_screen.c
+ * @brief Live signal view for one access point
+ *
+ * Runs back-to-back scans with uart_refresh_wifi_scan(), so the network
+ * list behind this screen keeps its rows (and gets fresh RSSI), and
+ * graphs the AP's RSSI once per scan. A scan that misses the AP leaves
+ * a gap in the graph.
+ *
+ * With the CAP GPS running, each reading is also recorded against
+ * position (geo_locate) and a line under a shorter graph points towards
+ * the estimated AP.
+ */
+
+#include "ap_signal_screen.h"
+#include "geo_locate.h"
+#include "text_ui.h"
+#include "ui_widget.h"
+#include "esp_log.h"
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+static const char *TAG = "AP_SIGNAL";
+
+// Graph rows 3..5 (3..4 when locating), four pixels per scan (58 scans, a few minutes)
+#define SPARK_X             4
+#define SPARK_COL_W         4
+#define SPARK_RSSI_MIN      (-100)
+#define SPARK_RSSI_MAX      (-30)
+
+// Screen user data
+typedef struct {
+    wifi_network_t network;
+    int rssi;                   // Latest reading (valid when seen_last)
+    int channel;
+    int rssi_min;
+    int rssi_max;
+    int scans;
+    bool seen_last;             // AP was in the last completed scan
+    volatile bool seen;         // AP seen in the scan in progress
+    volatile bool scan_done;    // Scan finished, push a sample and rescan
+    bool scan_active;           // Our scan is running
+    bool paused;
+    screen_t *self;
+    // Retained widgets
+    bool layout_drawn;
+    uint32_t layout_generation;
+    ui_label_t ssid_label;
+    ui_label_t value_label;
+    ui_label_t range_label;
+    ui_label_t scans_label;
+    ui_history_t history;
+    ui_sparkline_t spark;
+    // Walk-test localisation (CAP GPS)
+    bool locate;
+    geo_locate_t walk;
+    ui_label_t locate_label;
+} ap_signal_data_t;
+
+/**
+ * @brief Streaming scan result (RX task, handler lock held: copy only)
+ */
+static void on_scan_result(const wifi_network_t *network, void *user_data)
+{
+    ap_signal_data_t *data = (ap_signal_data_t *)user_data;
+    if (strcasecmp(network->bssid, data->network.bssid) != 0) return;
+    data->rssi = network->rssi;
+    data->channel = network->channel;
+    data->seen = true;
+}
+
+static void on_scan_complete(int count, void *user_data)
+{
+    (void)count;
+    ap_signal_data_t *data = (ap_signal_data_t *)user_data;
+    data->scan_done = true;
+}
+
+static void start_scan(ap_signal_data_t *data)
+{
+    data->seen = false;
+    data->scan_done = false;
+    // Fails while another scan runs; on_tick retries
+    data->scan_active = uart_refresh_wifi_scan(on_scan_result, on_scan_complete, data) == ESP_OK;
+}
+
+static void draw_screen(screen_t *self)
+{
+    ap_signal_data_t *data = (ap_signal_data_t *)self->user_data;
+    wifi_network_t *net = &data->network;
+    char line[32];
+
+    // Static chrome only after a clear; widgets repaint themselves
+    if (!data->layout_drawn || data->layout_generation != ui_get_clear_generation()) {
+        ui_clear();
+        ui_draw_title("AP Signal");
+        data->layout_generation = ui_get_clear_generation();
+        data->layout_drawn = true;
+    }
+    ui_draw_status(data->paused ? "SPACE:Resume ESC:Back" : "SPACE:Pause ESC:Back");
+
+    snprintf(line, sizeof(line), "%.28s", net->ssid[0] ? net->ssid : net->bssid);
+    ui_label_set(&data->ssid_label, line);
+
+    if (data->scans == 0) {
+        ui_label_set_colors(&data->value_label, UI_COLOR_DIMMED, UI_COLOR_BG);
+        ui_label_set(&data->value_label, "Scanning...");
+    } else if (data->seen_last) {
+        snprintf(line, sizeof(line), "CH %d  %d dBm", data->channel, data->rssi);
+        ui_label_set_colors(&data->value_label, UI_COLOR_HIGHLIGHT, UI_COLOR_BG);
+        ui_label_set(&data->value_label, line);
+    } else {
+        ui_label_set_colors(&data->value_label, UI_COLOR_DIMMED, UI_COLOR_BG);
+        ui_label_set(&data->value_label, "Not in last scan");
+    }
+
+    ui_sparkline_update(&data->spark, &data->history);
+
+    if (data->rssi_min <= data->rssi_max) {
+        snprintf(line, sizeof(line), "min %d max %d dBm", data->rssi_min, data->rssi_max);
+        ui_label_set(&data->range_label, line);
+    }
+    snprintf(line, sizeof(line), "Scans: %d", data->scans);
+    ui_label_set(&data->scans_label, line);
+
+    if (data->locate) {
+        geo_locate_describe(&data->walk, line, sizeof(line));
+        ui_label_set(&data->locate_label, line);
+    }
+}
+
+static void on_tick(screen_t *self)
+{
+    ap_signal_data_t *data = (ap_signal_data_t *)self->user_data;
+
+    if (!data->scan_active) {
+        if (!data->paused) start_scan(data);
+        return;
+    }
+    if (!data->scan_done) return;
+    data->scan_active = false;
+
+    data->scans++;
+    data->seen_last = data->seen;
+    if (data->seen) {
+        if (data->rssi < data->rssi_min) data->rssi_min = data->rssi;
+        if (data->rssi > data->rssi_max) data->rssi_max = data->rssi;
+        if (data->locate) geo_locate_add_here(&data->walk, data->rssi);
+    }
+    ui_history_push(&data->history, data->seen ? (int8_t)data->rssi : UI_HISTORY_NONE);
+    draw_screen(self);
+
+    if (!data->paused) {
+        start_scan(data);
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    ap_signal_data_t *data = (ap_signal_data_t *)self->user_data;
+
+    switch (key) {
+        case KEY_SPACE:
+            data->paused = !data->paused;
+            draw_screen(self);
+            break;
+
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    ap_signal_data_t *data = (ap_signal_data_t *)self->user_data;
+
+    // A scan in progress finishes on its own; just stop hearing about it
+    uart_detach_wifi_scan(data);
+    free(data);
+}
+
+screen_t* ap_signal_screen_create(void *params)
+{
+    ap_signal_params_t *signal_params = (ap_signal_params_t *)params;
+    if (!signal_params) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return NULL;
+    }
+
+    screen_t *screen = screen_alloc();
+    if (!screen) {
+        free(signal_params);
+        return NULL;
+    }
+
+    ap_signal_data_t *data = calloc(1, sizeof(ap_signal_data_t));
+    if (!data) {
+        free(screen);
+        free(signal_params);
+        return NULL;
+    }
+
+    data->network = signal_params->network;
+    free(signal_params);
+
+    data->self = screen;
+    data->rssi_min = 0;
+    data->rssi_max = -128;
+    ui_label_init(&data->ssid_label, 0, 1, UI_COLS, UI_ALIGN_CENTER, UI_COLOR_TEXT, UI_COLOR_BG);
+    ui_label_init(&data->value_label, 0, 2, UI_COLS, UI_ALIGN_CENTER, UI_COLOR_DIMMED, UI_COLOR_BG);
+    ui_label_init(&data->range_label, 0, 6, 20, UI_ALIGN_LEFT, UI_COLOR_DIMMED, UI_COLOR_BG);
+    ui_label_init(&data->scans_label, 20, 6, UI_COLS - 20, UI_ALIGN_RIGHT, UI_COLOR_DIMMED, UI_COLOR_BG);
+    data->locate = geo_locate_available();
+    geo_locate_reset(&data->walk);
+    ui_label_init(&data->locate_label, 0, 5, UI_COLS, UI_ALIGN_CENTER, UI_COLOR_TEXT, UI_COLOR_BG);
+    int graph_rows = data->locate ? 2 : 3;
+    ui_history_reset(&data->history);
+    ui_sparkline_init(&data->spark, SPARK_X, 3 * (DISPLAY_HEIGHT / UI_ROWS) + 2,
+                      DISPLAY_WIDTH - 2 * SPARK_X, graph_rows * (DISPLAY_HEIGHT / UI_ROWS) - 4,
+                      SPARK_COL_W, SPARK_RSSI_MIN, SPARK_RSSI_MAX, UI_COLOR_TEXT, UI_COLOR_BG);
+
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+
+    ESP_LOGI(TAG, "Following %s (%s)", data->network.bssid, data->network.ssid);
+    draw_screen(screen);
+    start_scan(data);
+    return screen;
+}
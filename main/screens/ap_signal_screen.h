@@ -0,0 +1,24 @@
+/**
+ * @file ap_signal_screen.h
+ * @brief Live signal view for one access point
+ */
+
+#ifndef AP_SIGNAL_SCREEN_H
+#define AP_SIGNAL_SCREEN_H
+
+#include "screen_manager.h"
+#include "uart_handler.h"
+
+// Parameters for creating the AP signal screen
+typedef struct {
+    wifi_network_t network;   // AP to follow (copied)
+} ap_signal_params_t;
+
+/**
+ * @brief Create the AP signal screen
+ * @param params Pointer to a malloc'd ap_signal_params_t (freed by the screen)
+ * @return Created screen or NULL on failure
+ */
+screen_t* ap_signal_screen_create(void *params);
+
+#endif // AP_SIGNAL_SCREEN_H
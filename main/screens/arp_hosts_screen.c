@@ -1,115 +1,222 @@
 /**
  * @file arp_hosts_screen.c
  * @brief ARP hosts list screen implementation
- * 
- * Displays hosts from list_hosts_vendor command with optimized scrolling
+ *
+ * Sends list_hosts_vendor and lists each host as its row arrives. Hosts
+ * are packed records (IPv4 as a number, MAC as six bytes) indexed by MAC,
+ * with vendors resolved from the local OUI table; only vendors the table
+ * does not know are kept as JanOS sent them. The list is requested again
+ * every ARP_REFRESH_US, and each pass marks hosts that answered for the
+ * first time ('+') or stopped answering ('-'). TAB finds a host by
+ * vendor, or by IP when the vendor is unknown.
  */
 
 #include "arp_hosts_screen.h"
+#include "mem_monitor.h"
 #include "arp_attack_screen.h"
+#include "sdkconfig.h"
 #include "uart_handler.h"
+#include "oui_lookup.h"
+#include "mac_set.h"
+#include "janos_proto.h"
+#include "fixed_containers.h"
 #include "text_ui.h"
+#include "ui_list.h"
 #include "display.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 static const char *TAG = "ARP_HOSTS";
 
-#define MAX_HOSTS 64
-#define VISIBLE_ITEMS 6
+// A /23 worth by default; more are counted as dropped
+#ifdef CONFIG_ARP_MAX_HOSTS
+#define MAX_HOSTS           CONFIG_ARP_MAX_HOSTS
+#else
+#define MAX_HOSTS           512
+#endif
+#define VENDOR_POOL_SIZE    2048        // Vendors missing from the OUI table
+#define VENDOR_LEN          32
+#define ARP_REFRESH_US      30000000    // Ask for the host list again after 30 s
+#define REDRAW_INTERVAL_US  250000
 
-// Host entry structure
+// Record flags
+#define HOST_NEW            0x01        // First answered after the initial pass
+#define HOST_GONE           0x02        // Missing from the last pass
+#define HOST_SEEN           0x04        // Answered in the pass being received
+
+// One host
 typedef struct {
-    char ip[16];
-    char mac[18];
-    char vendor[32];
-} host_entry_t;
+    uint32_t ip;                // Host byte order, for sorting
+    uint8_t mac[6];
+    uint8_t flags;
+    uint16_t vendor;            // vendor_pool offset + 1, 0 = use the OUI table
+} host_record_t;
 
 // Screen state
 typedef struct {
-    host_entry_t hosts[MAX_HOSTS];
-    int host_count;
-    int selected_index;
-    int scroll_offset;
-    bool scanning;
-    bool needs_redraw;
-    bool not_connected;  // True if WiFi not connected
+    // Model, filled by the UART task (append-only)
+    host_record_t hosts[MAX_HOSTS];
+    mac_set_t index;            // MAC -> hosts[]
+    volatile int host_count;
+    char vendor_pool[VENDOR_POOL_SIZE];
+    int vendor_used;
+    int dropped;
+    int passes;                 // Host lists received
+    volatile bool in_pass;      // Between the header and the "Found" line
+    volatile uint32_t generation;
+    int64_t pass_end_us;
+    // Sorted view, rebuilt on the UI task
+    uint16_t order[MAX_HOSTS];
+    uint32_t view_generation;
+    int64_t draw_time_us;
+    ui_list_t list;
+    ui_typeahead_t find;
+    bool not_connected;         // True if WiFi not connected
     screen_t *self;
 } arp_hosts_data_t;
 
+MEM_BUDGET(arp_hosts, 1, sizeof(arp_hosts_data_t), MEM_BUDGET_SCREEN);
+
 static void draw_screen(screen_t *self);
-static void draw_hosts_list(arp_hosts_data_t *data);
+
+static void format_ip(uint32_t ip, char *buf, size_t len)
+{
+    snprintf(buf, len, "%u.%u.%u.%u", (unsigned)(ip >> 24), (unsigned)((ip >> 16) & 0xFF),
+             (unsigned)((ip >> 8) & 0xFF), (unsigned)(ip & 0xFF));
+}
+
+static void format_mac(const uint8_t *mac, char *buf, size_t len)
+{
+    snprintf(buf, len, "%02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+/**
+ * @brief Vendor of a host: OUI table first, then what JanOS reported
+ * @return Vendor name, or NULL if unknown
+ */
+static const char *host_vendor(const arp_hosts_data_t *data, const host_record_t *host)
+{
+    const char *vendor = oui_lookup(host->mac);
+    if (vendor) return vendor;
+    return host->vendor ? &data->vendor_pool[host->vendor - 1] : NULL;
+}
 
 /**
  * @brief Format host label for display
- * Shows IP + Vendor, or IP + MAC if vendor is Unknown
+ * Shows marker + IP + Vendor, or IP + MAC if the vendor is unknown
+ */
+static void host_row(int index, char *text, size_t len, void *user_data)
+{
+    arp_hosts_data_t *data = (arp_hosts_data_t *)user_data;
+    const host_record_t *host = &data->hosts[data->order[index]];
+    char ip[16];
+
+    format_ip(host->ip, ip, sizeof(ip));
+    char mark = (host->flags & HOST_GONE) ? '-' : (host->flags & HOST_NEW) ? '+' : ' ';
+    const char *vendor = host_vendor(data, host);
+    if (vendor) {
+        // Vendor is cut to the row width
+        snprintf(text, len, "%c%-14s %s", mark, ip, vendor);
+    } else {
+        char mac[18];
+        format_mac(host->mac, mac, sizeof(mac));
+        snprintf(text, len, "%c%-14s %s", mark, ip, mac);
+    }
+}
+
+/**
+ * @brief Name a host is found by: its vendor, or its IP if unknown
  */
-static void format_host_label(host_entry_t *host, char *buf, size_t len)
+static void host_name(int index, char *name, size_t len, void *user_data)
 {
-    if (strcmp(host->vendor, "Unknown") == 0) {
-        snprintf(buf, len, "%-13s %s", host->ip, host->mac);
+    arp_hosts_data_t *data = (arp_hosts_data_t *)user_data;
+    const host_record_t *host = &data->hosts[data->order[index]];
+    const char *vendor = host_vendor(data, host);
+    if (vendor) {
+        snprintf(name, len, "%s", vendor);
     } else {
-        // Truncate vendor to fit
-        snprintf(buf, len, "%-13s %.14s", host->ip, host->vendor);
+        format_ip(host->ip, name, len);
     }
 }
 
 /**
  * @brief Parse a host line from list_hosts_vendor output
  * Format: "192.168.4.1  ->  C4:2B:44:12:29:15 [Huawei Device Co., Ltd.]"
+ * @param vendor Receives the bracketed vendor ("" if none)
  */
-static bool parse_host_line(const char *line, host_entry_t *host)
+static bool parse_host_line(const char *line, uint32_t *ip, uint64_t *mac_key,
+                            char *vendor, size_t vendor_len)
 {
-    // Skip lines that don't contain "->"
-    const char *arrow = strstr(line, "->");
-    if (!arrow) return false;
-    
-    // Find IP (skip leading spaces)
-    const char *ip_start = line;
-    while (*ip_start == ' ') ip_start++;
-    
-    // Copy IP (up to spaces before arrow)
-    const char *ip_end = ip_start;
-    while (*ip_end && *ip_end != ' ') ip_end++;
-    
-    size_t ip_len = ip_end - ip_start;
-    if (ip_len == 0 || ip_len >= sizeof(host->ip)) return false;
-    
-    strncpy(host->ip, ip_start, ip_len);
-    host->ip[ip_len] = '\0';
-    
-    // Find MAC (after "->")
-    const char *mac_start = arrow + 2;
-    while (*mac_start == ' ') mac_start++;
-    
-    const char *mac_end = mac_start;
-    while (*mac_end && *mac_end != ' ' && *mac_end != '[') mac_end++;
-    
-    size_t mac_len = mac_end - mac_start;
-    if (mac_len == 0 || mac_len >= sizeof(host->mac)) return false;
-    
-    strncpy(host->mac, mac_start, mac_len);
-    host->mac[mac_len] = '\0';
-    
-    // Find vendor (inside brackets)
-    const char *vendor_start = strchr(mac_end, '[');
-    if (vendor_start) {
-        vendor_start++;
-        const char *vendor_end = strchr(vendor_start, ']');
-        if (vendor_end) {
-            size_t vendor_len = vendor_end - vendor_start;
-            if (vendor_len >= sizeof(host->vendor)) {
-                vendor_len = sizeof(host->vendor) - 1;
-            }
-            strncpy(host->vendor, vendor_start, vendor_len);
-            host->vendor[vendor_len] = '\0';
+    janos_arp_host_t host;
+    if (!janos_parse_arp_host(line, &host)) return false;
+
+    *ip = host.ip;
+    *mac_key = host.mac;
+    janos_span_copy(host.vendor, vendor, vendor_len);
+    return true;
+}
+
+/**
+ * @brief Add or refresh one host of the pass being received
+ */
+static void add_host(arp_hosts_data_t *data, uint32_t ip, uint64_t key, const char *vendor)
+{
+    int idx = mac_set_find(&data->index, key);
+    if (idx < 0) {
+        // Never let the set evict: records are what the view indexes
+        if (data->index.count >= MAX_HOSTS) {
+            data->dropped++;
+            return;
         }
-    } else {
-        strcpy(host->vendor, "Unknown");
+        bool is_new = false;
+        idx = mac_set_add(&data->index, key, &is_new);
+        if (idx < 0) return;
+
+        host_record_t *host = &data->hosts[idx];
+        memset(host, 0, sizeof(*host));
+        for (int i = 0; i < 6; i++) {
+            host->mac[i] = (uint8_t)(key >> (40 - 8 * i));
+        }
+        if (data->passes > 0) host->flags |= HOST_NEW;
+
+        // Keep JanOS's vendor only if the local table cannot name it
+        size_t vlen = strlen(vendor);
+        if (!oui_lookup(host->mac) && vlen && strcmp(vendor, "Unknown") != 0 &&
+            data->vendor_used + (int)vlen + 1 <= VENDOR_POOL_SIZE) {
+            memcpy(&data->vendor_pool[data->vendor_used], vendor, vlen + 1);
+            host->vendor = (uint16_t)(data->vendor_used + 1);
+            data->vendor_used += vlen + 1;
+        }
+        data->host_count = data->index.count;
     }
-    
-    return true;
+
+    host_record_t *host = &data->hosts[idx];
+    host->ip = ip;
+    host->flags = (host->flags & ~HOST_GONE) | HOST_SEEN;
+    data->generation++;
+}
+
+/**
+ * @brief Close a pass: hosts that did not answer are marked gone
+ */
+static void end_pass(arp_hosts_data_t *data)
+{
+    for (int i = 0; i < data->host_count; i++) {
+        host_record_t *host = &data->hosts[i];
+        if (host->flags & HOST_SEEN) {
+            host->flags &= ~HOST_SEEN;
+        } else {
+            host->flags |= HOST_GONE;
+        }
+    }
+    data->passes++;
+    data->in_pass = false;
+    data->pass_end_us = esp_timer_get_time();
+    data->generation++;
 }
 
 /**
@@ -119,190 +226,182 @@ static void uart_line_callback(const char *line, void *user_data)
 {
     arp_hosts_data_t *data = (arp_hosts_data_t *)user_data;
     if (!data) return;
-    
-    // Check for scan start
+
+    // Check for list start
     if (strstr(line, "=== Discovered Hosts ===") != NULL) {
-        data->scanning = true;
-        data->host_count = 0;
+        data->in_pass = true;
         return;
     }
-    
-    // Check for scan complete
+
+    // Check for list complete
     if (strstr(line, "Found") != NULL && strstr(line, "hosts") != NULL) {
-        data->scanning = false;
-        data->needs_redraw = true;
-        ESP_LOGI(TAG, "Host scan complete, found %d hosts", data->host_count);
+        if (data->in_pass) end_pass(data);
+        ESP_LOGI(TAG, "Host list %d: %d hosts (%d dropped)", data->passes, data->host_count,
+                 data->dropped);
         return;
     }
-    
-    // Try to parse as host entry
-    if (data->scanning && data->host_count < MAX_HOSTS) {
-        host_entry_t host = {0};
-        if (parse_host_line(line, &host)) {
-            data->hosts[data->host_count++] = host;
-            ESP_LOGD(TAG, "Added host: %s -> %s [%s]", host.ip, host.mac, host.vendor);
+
+    // Each host row is shown as it arrives
+    if (data->in_pass) {
+        uint32_t ip;
+        uint64_t key;
+        char vendor[VENDOR_LEN];
+        if (parse_host_line(line, &ip, &key, vendor, sizeof(vendor))) {
+            add_host(data, ip, key, vendor);
         }
     }
 }
 
+static int compare_ip(int a, int b, void *ctx)
+{
+    const host_record_t *hosts = ctx;
+    uint32_t ia = hosts[a].ip;
+    uint32_t ib = hosts[b].ip;
+    return ia != ib ? (ia > ib) - (ia < ib) : a - b;
+}
+
+/**
+ * @brief Rebuild the IP-sorted view, keeping the cursor on the same host
+ */
+static void refresh_view(arp_hosts_data_t *data)
+{
+    int selected_host = data->list.count > 0 ? data->order[data->list.selected] : -1;
+
+    data->view_generation = data->generation;
+    int count = data->host_count;
+    for (int i = 0; i < count; i++) {
+        data->order[i] = (uint16_t)i;
+    }
+    fixed_index_sort(data->order, count, compare_ip, data->hosts);
+    ui_list_rows_moved(&data->list);
+    ui_list_set_count(&data->list, count);
+
+    int row = fixed_index_find(data->order, count, selected_host);
+    if (row >= 0) ui_list_select(&data->list, row);
+}
+
+static void draw_title(arp_hosts_data_t *data)
+{
+    int added = 0, gone = 0;
+    for (int i = 0; i < data->list.count; i++) {
+        uint8_t flags = data->hosts[data->order[i]].flags;
+        if (flags & HOST_GONE) gone++;
+        else if (flags & HOST_NEW) added++;
+    }
+
+    char title[32];
+    if (added || gone) {
+        snprintf(title, sizeof(title), "ARP Hosts %d +%d -%d", data->list.count, added, gone);
+    } else {
+        snprintf(title, sizeof(title), "ARP Hosts (%d)", data->list.count);
+    }
+    ui_draw_title(title);
+}
+
 static void draw_screen(screen_t *self)
 {
     arp_hosts_data_t *data = (arp_hosts_data_t *)self->user_data;
-    
+
+    int mid = ui_rows() / 2;
+
     ui_clear();
-    ui_draw_title("ARP Hosts");
-    
+
     if (data->not_connected) {
-        ui_print_center(2, "Not connected to WiFi", UI_COLOR_TEXT);
-        ui_print_center(4, "Connect first via", UI_COLOR_DIMMED);
-        ui_print_center(5, "Network Attacks menu", UI_COLOR_DIMMED);
+        ui_draw_title("ARP Hosts");
+        ui_print_center(mid - 2, "Not connected to WiFi", UI_COLOR_TEXT);
+        ui_print_center(mid, "Connect first via", UI_COLOR_DIMMED);
+        ui_print_center(mid + 1, "Network Attacks menu", UI_COLOR_DIMMED);
         ui_draw_status("ESC:Back");
         return;
     }
-    
-    if (data->scanning) {
-        ui_print_center(3, "Scanning network...", UI_COLOR_DIMMED);
-    } else if (data->host_count == 0) {
-        ui_print_center(3, "No hosts found", UI_COLOR_DIMMED);
+
+    refresh_view(data);
+    draw_title(data);
+
+    if (data->list.count > 0) {
+        ui_list_draw(&data->list);
+    } else if (data->passes == 0) {
+        ui_print_center(mid - 1, "Scanning network...", UI_COLOR_DIMMED);
     } else {
-        draw_hosts_list(data);
+        ui_print_center(mid - 1, "No hosts found", UI_COLOR_DIMMED);
     }
-    
-    ui_draw_status("UP/DOWN:Navigate ENTER:Attack ESC:Back");
-}
 
-static void draw_hosts_list(arp_hosts_data_t *data)
-{
-    int visible_end = data->scroll_offset + VISIBLE_ITEMS;
-    if (visible_end > data->host_count) {
-        visible_end = data->host_count;
-    }
-    
-    for (int i = data->scroll_offset; i < visible_end; i++) {
-        int row = (i - data->scroll_offset) + 1;
-        bool selected = (i == data->selected_index);
-        
-        char display_text[32];
-        format_host_label(&data->hosts[i], display_text, sizeof(display_text));
-        
-        ui_draw_menu_item(row, display_text, selected, false, false);
-    }
+    ui_list_draw_status(&data->list, "ENTER:Attack R:Rescan TAB:Find ESC:Back");
+    data->draw_time_us = esp_timer_get_time();
 }
 
-// Optimized: redraw only affected menu items
-static void redraw_two_items(arp_hosts_data_t *data, int old_index, int new_index)
+static void request_hosts(arp_hosts_data_t *data)
 {
-    char label[32];
-    
-    if (old_index >= data->scroll_offset && old_index < data->scroll_offset + VISIBLE_ITEMS) {
-        int old_row = (old_index - data->scroll_offset) + 1;
-        format_host_label(&data->hosts[old_index], label, sizeof(label));
-        ui_draw_menu_item(old_row, label, false, false, false);
-    }
-    
-    if (new_index >= data->scroll_offset && new_index < data->scroll_offset + VISIBLE_ITEMS) {
-        int new_row = (new_index - data->scroll_offset) + 1;
-        format_host_label(&data->hosts[new_index], label, sizeof(label));
-        ui_draw_menu_item(new_row, label, true, false, false);
-    }
+    data->pass_end_us = 0;
+    uart_send_command("list_hosts_vendor");
 }
 
 static void on_tick(screen_t *self)
 {
     arp_hosts_data_t *data = (arp_hosts_data_t *)self->user_data;
-    
-    if (data->needs_redraw) {
-        data->needs_redraw = false;
+    if (data->not_connected) return;
+
+    int64_t now = esp_timer_get_time();
+
+    // Delta refresh: the next pass marks new and gone hosts
+    if (!data->in_pass && data->pass_end_us && now - data->pass_end_us >= ARP_REFRESH_US) {
+        request_hosts(data);
+    }
+
+    if (data->generation == data->view_generation || now - data->draw_time_us < REDRAW_INTERVAL_US) {
+        return;
+    }
+
+    if (data->list.count == 0) {
         draw_screen(self);
+    } else {
+        // Rows arrived: only the title and the rows that changed are painted
+        refresh_view(data);
+        draw_title(data);
+        ui_list_draw(&data->list);
+        data->draw_time_us = now;
     }
 }
 
 static void on_key(screen_t *self, key_code_t key)
 {
     arp_hosts_data_t *data = (arp_hosts_data_t *)self->user_data;
-    
-    if (data->scanning || data->host_count == 0) {
-        if (key == KEY_ESC || key == KEY_BACKSPACE) {
-            screen_manager_pop();
-        }
+
+    if (ui_list_handle_key(&data->list, key)) {
+        ui_list_draw(&data->list);
         return;
     }
-    
+
     switch (key) {
-        case KEY_UP:
-            if (data->selected_index > 0) {
-                int old_index = data->selected_index;
-                
-                // Check if at first visible item on page - do page jump
-                if (data->selected_index == data->scroll_offset && data->scroll_offset > 0) {
-                    // Page up - jump by VISIBLE_ITEMS
-                    data->scroll_offset -= VISIBLE_ITEMS;
-                    if (data->scroll_offset < 0) data->scroll_offset = 0;
-                    // Land on last item of previous page
-                    data->selected_index = data->scroll_offset + VISIBLE_ITEMS - 1;
-                    if (data->selected_index >= data->host_count) {
-                        data->selected_index = data->host_count - 1;
-                    }
-                    draw_screen(self);
-                } else {
-                    // Just moved within page
-                    data->selected_index--;
-                    redraw_two_items(data, old_index, data->selected_index);
-                }
-            } else if (data->host_count > 0) {
-                data->selected_index = data->host_count - 1;
-                data->scroll_offset = (data->selected_index / VISIBLE_ITEMS) * VISIBLE_ITEMS;
-                draw_screen(self);
-            }
-            break;
-            
-        case KEY_DOWN:
-            if (data->selected_index < data->host_count - 1) {
-                int old_index = data->selected_index;
-                data->selected_index++;
-                
-                // Check if we need to scroll
-                if (data->selected_index >= data->scroll_offset + VISIBLE_ITEMS) {
-                    // Page down - jump by VISIBLE_ITEMS - don't adjust back for partial pages
-                    data->scroll_offset += VISIBLE_ITEMS;
-                    data->selected_index = data->scroll_offset;
-                    draw_screen(self);
-                } else {
-                    // Just moved within page
-                    redraw_two_items(data, old_index, data->selected_index);
-                }
-            } else if (data->host_count > 0) {
-                data->selected_index = 0;
-                data->scroll_offset = 0;
-                draw_screen(self);
-            }
-            break;
-            
         case KEY_ENTER:
         case KEY_SPACE:
-            if (data->selected_index >= 0 && data->selected_index < data->host_count) {
-                host_entry_t *host = &data->hosts[data->selected_index];
-                
+            if (data->list.count > 0) {
+                const host_record_t *host = &data->hosts[data->order[data->list.selected]];
+
                 // Create params with full host info
                 arp_attack_params_t *params = malloc(sizeof(arp_attack_params_t));
                 if (params) {
-                    strncpy(params->ip, host->ip, sizeof(params->ip) - 1);
-                    params->ip[sizeof(params->ip) - 1] = '\0';
-                    strncpy(params->mac, host->mac, sizeof(params->mac) - 1);
-                    params->mac[sizeof(params->mac) - 1] = '\0';
-                    strncpy(params->vendor, host->vendor, sizeof(params->vendor) - 1);
-                    params->vendor[sizeof(params->vendor) - 1] = '\0';
-                    
-                    screen_manager_push(arp_attack_screen_create, params);
+                    const char *vendor = host_vendor(data, host);
+                    format_ip(host->ip, params->ip, sizeof(params->ip));
+                    format_mac(host->mac, params->mac, sizeof(params->mac));
+                    snprintf(params->vendor, sizeof(params->vendor), "%s", vendor ? vendor : "Unknown");
+
+                    if (screen_manager_push(arp_attack_screen_create, params) == ESP_ERR_NO_MEM) free(params);
                 }
             }
             break;
-            
+
+        case KEY_R:
+            if (!data->not_connected && !data->in_pass) {
+                request_hosts(data);
+            }
+            break;
+
         case KEY_ESC:
         case KEY_BACKSPACE:
             screen_manager_pop();
             break;
-            
+
         default:
             break;
     }
@@ -310,61 +409,75 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
-    uart_clear_line_callback();
-    
-    if (self->user_data) {
-        free(self->user_data);
+    arp_hosts_data_t *data = (arp_hosts_data_t *)self->user_data;
+
+    // User data lives in the screen arena and is released on pop
+    if (data) {
+        mac_set_free(&data->index);
+        ui_typeahead_free(&data->find);
     }
 }
 
 static void on_resume(screen_t *self)
 {
-    // Redraw when returning from attack screen
+    arp_hosts_data_t *data = (arp_hosts_data_t *)self->user_data;
+
+    // Lines sent while the attack screen was on top were not ours
+    if (!data->not_connected) {
+        data->in_pass = false;
+        request_hosts(data);
+    }
     draw_screen(self);
 }
 
 screen_t* arp_hosts_screen_create(void *params)
 {
     (void)params;
-    
+
     ESP_LOGI(TAG, "Creating ARP hosts screen...");
-    
+
     screen_t *screen = screen_alloc();
     if (!screen) return NULL;
-    
+
     // Allocate user data
-    arp_hosts_data_t *data = calloc(1, sizeof(arp_hosts_data_t));
+    arp_hosts_data_t *data = screen_arena_alloc(sizeof(arp_hosts_data_t));
     if (!data) {
         free(screen);
         return NULL;
     }
-    
+
+    if (mac_set_init(&data->index, MAX_HOSTS) != ESP_OK) {
+        free(screen);
+        return NULL;
+    }
     data->self = screen;
-    
-    // Check if WiFi is connected
-    if (!uart_is_wifi_connected()) {
-        data->not_connected = true;
-        data->scanning = false;
-    } else {
-        data->scanning = true;
+    screen_set_density(screen, UI_DENSITY_COMPACT);
+    ui_list_init(&data->list, 1, UI_LIST_MAX_ROWS, host_row, data);
+    if (ui_typeahead_init(&data->find, MAX_HOSTS, host_name, data) == ESP_OK) {
+        ui_list_set_typeahead(&data->list, &data->find);
     }
-    
+
+    // Check if WiFi is connected
+    data->not_connected = !uart_is_wifi_connected();
+
     screen->user_data = data;
+    screen->mem_budget_kb = 56;     // Host table, MAC index and type-ahead
     screen->on_key = on_key;
     screen->on_destroy = on_destroy;
     screen->on_resume = on_resume;
     screen->on_draw = draw_screen;
     screen->on_tick = on_tick;
-    
+    screen->tick_on_uart = true;    // on_tick only redraws when rows arrived
+
     // Draw initial screen
     draw_screen(screen);
-    
+
     // Only start scan if connected
     if (!data->not_connected) {
-        uart_register_line_callback(uart_line_callback, data);
-        uart_send_command("list_hosts_vendor");
+        screen_set_line_callback(screen, uart_line_callback, data);
+        request_hosts(data);
     }
-    
+
     ESP_LOGI(TAG, "ARP hosts screen created");
     return screen;
 }
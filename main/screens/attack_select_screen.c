@@ -12,6 +12,7 @@
 #include "handshaker_screen.h"
 #include "sniffer_screen.h"
 #include "settings.h"
+#include "listing_prefetch.h"
 #include "uart_handler.h"
 #include "text_ui.h"
 #include "buzzer.h"
@@ -85,6 +86,19 @@ static void draw_screen(screen_t *self)
     ui_draw_status("UP/DOWN:Nav ENTER:Run ESC:Back");
 }
 
+/**
+ * @brief Fetch the HTML file list while Evil Twin or Rogue AP is highlighted
+ *
+ * Not dropped on Enter: their HTML picker comes after the name screens.
+ */
+static void prefetch_selected(attack_select_data_t *data)
+{
+    attack_type_t attack = data->visible_count > 0 ?
+                           data->visible_attacks[data->selected_index] : ATTACK_COUNT;
+    listing_prefetch_hover(attack == ATTACK_EVIL_TWIN || attack == ATTACK_ROGUE_AP ?
+                           LISTING_HTML_FILES : LISTING_NONE);
+}
+
 // Optimized: redraw only two changed rows
 static void redraw_selection(attack_select_data_t *data, int old_index, int new_index)
 {
@@ -92,6 +106,7 @@ static void redraw_selection(attack_select_data_t *data, int old_index, int new_
     ui_draw_menu_item(old_index + 1, data->visible_names[old_index], false, false, false);
     // Redraw new selection (now selected)
     ui_draw_menu_item(new_index + 1, data->visible_names[new_index], true, false, false);
+    prefetch_selected(data);
 }
 
 static void on_key(screen_t *self, key_code_t key)
@@ -143,7 +158,10 @@ static void on_key(screen_t *self, key_code_t key)
                                 if (params->networks) {
                                     memcpy(params->networks, data->networks, 
                                            data->network_count * sizeof(wifi_network_t));
-                                    screen_manager_push(deauth_screen_create, params);
+                                    if (screen_manager_push(deauth_screen_create, params) == ESP_ERR_NO_MEM) {
+                                        free(params->networks);
+                                        free(params);
+                                    }
                                 } else {
                                     free(params);
                                 }
@@ -161,7 +179,10 @@ static void on_key(screen_t *self, key_code_t key)
                                 if (params->networks) {
                                     memcpy(params->networks, data->networks, 
                                            data->network_count * sizeof(wifi_network_t));
-                                    screen_manager_push(evil_twin_name_screen_create, params);
+                                    if (screen_manager_push(evil_twin_name_screen_create, params) == ESP_ERR_NO_MEM) {
+                                        free(params->networks);
+                                        free(params);
+                                    }
                                 } else {
                                     free(params);
                                 }
@@ -182,7 +203,7 @@ static void on_key(screen_t *self, key_code_t key)
                                 strncpy(params->ssid, data->networks[0].ssid, sizeof(params->ssid) - 1);
                                 params->ssid[sizeof(params->ssid) - 1] = '\0';
                                 params->network_id = data->networks[0].id;
-                                screen_manager_push(rogue_ap_password_screen_create, params);
+                                if (screen_manager_push(rogue_ap_password_screen_create, params) == ESP_ERR_NO_MEM) free(params);
                             }
                         }
                         break;
@@ -201,7 +222,7 @@ static void on_key(screen_t *self, key_code_t key)
                             sae_overflow_screen_params_t *params = malloc(sizeof(sae_overflow_screen_params_t));
                             if (params) {
                                 params->network = data->networks[0];
-                                screen_manager_push(sae_overflow_screen_create, params);
+                                if (screen_manager_push(sae_overflow_screen_create, params) == ESP_ERR_NO_MEM) free(params);
                             }
                         }
                         break;
@@ -219,7 +240,10 @@ static void on_key(screen_t *self, key_code_t key)
                                 if (params->networks) {
                                     memcpy(params->networks, data->networks, 
                                            data->network_count * sizeof(wifi_network_t));
-                                    screen_manager_push(handshaker_screen_create, params);
+                                    if (screen_manager_push(handshaker_screen_create, params) == ESP_ERR_NO_MEM) {
+                                        free(params->networks);
+                                        free(params);
+                                    }
                                 } else {
                                     free(params);
                                 }
@@ -240,7 +264,10 @@ static void on_key(screen_t *self, key_code_t key)
                                 if (params->networks) {
                                     memcpy(params->networks, data->networks, 
                                            data->network_count * sizeof(wifi_network_t));
-                                    screen_manager_push(sniffer_screen_create, params);
+                                    if (screen_manager_push(sniffer_screen_create, params) == ESP_ERR_NO_MEM) {
+                                        free(params->networks);
+                                        free(params);
+                                    }
                                 } else {
                                     free(params);
                                 }
@@ -268,6 +295,7 @@ static void on_destroy(screen_t *self)
 {
     attack_select_data_t *data = (attack_select_data_t *)self->user_data;
     
+    listing_prefetch_cancel();
     if (data) {
         if (data->networks) {
             free(data->networks);
@@ -344,6 +372,7 @@ screen_t* attack_select_screen_create(void *params)
     
     // Draw initial screen
     draw_screen(screen);
+    prefetch_selected(data);
     
     ESP_LOGI(TAG, "Attack select screen created");
     return screen;
@@ -0,0 +1,322 @@
+/**
+ * @file benchmark_screen.c
+ * @brief On-device micro-benchmark screen implementation
+ *
+ * Runs timed loops for display, parsing and storage, one test per tick so
+ * the results fill in as they finish. Each row shows the average time and
+ * CPU cycles per iteration (throughput for the SD test). Results are
+ * appended to /sdcard/bench.txt to compare boards and SD cards.
+ */
+
+#include "benchmark_screen.h"
+#include "scenario_screen.h"
+#include "uart_frame.h"
+#include "screenshot.h"
+#include "version.h"
+#include "text_ui.h"
+#include "display.h"
+#include "keyboard.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "nvs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *TAG = "BENCHMARK";
+
+#define BENCH_RESULTS_FILE  "/sdcard/bench.txt"
+#define BENCH_SD_TMP_FILE   "/sdcard/bench.tmp"
+#define BENCH_SD_CHUNK      (16 * 1024)
+#define BENCH_SD_TOTAL      (256 * 1024)
+#define BENCH_NVS_NAMESPACE "bench"
+#define BENCH_NVS_OPS       50
+
+#define BENCH_BOARD_NAME    FIRMWARE_BOARD_NAME
+
+typedef enum {
+    BENCH_CLEAR = 0,
+    BENCH_TEXT_PAGE,
+    BENCH_MENU_SCROLL,
+    BENCH_UART_PARSE,
+    BENCH_SD_WRITE,
+    BENCH_NVS,
+    BENCH_COUNT
+} bench_id_t;
+
+typedef struct {
+    const char *name;
+    int iterations;
+} bench_def_t;
+
+static const bench_def_t benches[BENCH_COUNT] = {
+    [BENCH_CLEAR]       = { "Clear",  20 },
+    [BENCH_TEXT_PAGE]   = { "Text",   20 },
+    [BENCH_MENU_SCROLL] = { "Menu",   30 },
+    [BENCH_UART_PARSE]  = { "Parse",  1000 },
+    [BENCH_SD_WRITE]    = { "SD wr",  BENCH_SD_TOTAL / BENCH_SD_CHUNK },
+    [BENCH_NVS]         = { "NVS",    BENCH_NVS_OPS },
+};
+
+typedef struct {
+    bool done;
+    bool failed;
+    uint64_t us;
+    uint64_t cycles;
+} bench_result_t;
+
+typedef struct {
+    bool running;
+    int next;
+    bench_result_t results[BENCH_COUNT];
+} benchmark_data_t;
+
+static void run_clear(int n)
+{
+    for (int i = 0; i < n; i++) {
+        ui_clear();
+        display_flush();
+    }
+}
+
+static void run_text_page(int n)
+{
+    static const char *line = "The quick brown fox jumps 0123";
+    for (int i = 0; i < n; i++) {
+        ui_clear();
+        ui_draw_title("Benchmark");
+        for (int row = 1; row < UI_ROWS - 1; row++) {
+            ui_print(0, row, line, UI_COLOR_TEXT);
+        }
+        ui_draw_status("Rendering text page");
+        display_flush();
+    }
+}
+
+static void run_menu_scroll(int n)
+{
+    for (int i = 0; i < n; i++) {
+        int selected = i % 6;
+        for (int row = 1; row <= 6; row++) {
+            ui_draw_menu_item(row, "Menu item", row - 1 == selected, false, false);
+        }
+        display_flush();
+    }
+}
+
+static bool run_uart_parse(int n)
+{
+    static const char *line =
+        "\"12\",\"CoffeeShop-Guest 5G\",\"\",\"A4:2B:B0:12:34:56\",\"36\",\"WPA2/WPA3\",\"-67\",\"5GHz\"";
+    wifi_network_t network;
+    int ok = 0;
+    for (int i = 0; i < n; i++) {
+        ok += uart_frame_parse_scan_line(line, &network);
+    }
+    return ok == n;
+}
+
+static bool run_sd_write(int n)
+{
+    if (!screenshot_is_available()) return false;
+    
+    uint8_t *buf = malloc(BENCH_SD_CHUNK);
+    if (!buf) return false;
+    memset(buf, 0xA5, BENCH_SD_CHUNK);
+    
+    FILE *f = fopen(BENCH_SD_TMP_FILE, "wb");
+    bool ok = f != NULL;
+    for (int i = 0; ok && i < n; i++) {
+        ok = fwrite(buf, 1, BENCH_SD_CHUNK, f) == BENCH_SD_CHUNK;
+    }
+    if (f) {
+        ok = (fclose(f) == 0) && ok;
+        unlink(BENCH_SD_TMP_FILE);
+    }
+    free(buf);
+    return ok;
+}
+
+static bool run_nvs(int n)
+{
+    nvs_handle_t handle;
+    if (nvs_open(BENCH_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) return false;
+    
+    bool ok = true;
+    for (int i = 0; ok && i < n; i++) {
+        uint32_t value = 0;
+        ok = nvs_set_u32(handle, "v", (uint32_t)i) == ESP_OK &&
+             nvs_commit(handle) == ESP_OK &&
+             nvs_get_u32(handle, "v", &value) == ESP_OK && value == (uint32_t)i;
+    }
+    nvs_erase_key(handle, "v");
+    nvs_commit(handle);
+    nvs_close(handle);
+    return ok;
+}
+
+static void run_bench(bench_id_t id, bench_result_t *res)
+{
+    int n = benches[id].iterations;
+    bool ok = true;
+    
+    int64_t start_us = esp_timer_get_time();
+    uint32_t start_cycles = esp_cpu_get_cycle_count();
+    switch (id) {
+        case BENCH_CLEAR:       run_clear(n); break;
+        case BENCH_TEXT_PAGE:   run_text_page(n); break;
+        case BENCH_MENU_SCROLL: run_menu_scroll(n); break;
+        case BENCH_UART_PARSE:  ok = run_uart_parse(n); break;
+        case BENCH_SD_WRITE:    ok = run_sd_write(n); break;
+        case BENCH_NVS:         ok = run_nvs(n); break;
+        default: break;
+    }
+    // 32-bit cycle counter wraps after ~18 s at 240 MHz; every test is far shorter
+    uint32_t cycles = esp_cpu_get_cycle_count() - start_cycles;
+    res->us = esp_timer_get_time() - start_us;
+    res->cycles = cycles;
+    res->failed = !ok;
+    res->done = true;
+}
+
+static void format_result(bench_id_t id, const bench_result_t *res, char *buf, size_t len)
+{
+    const bench_def_t *def = &benches[id];
+    
+    if (!res->done) {
+        snprintf(buf, len, " %-6s     -", def->name);
+    } else if (res->failed) {
+        snprintf(buf, len, " %-6s  failed", def->name);
+    } else if (id == BENCH_SD_WRITE) {
+        uint32_t kbps = res->us ? (uint32_t)((uint64_t)BENCH_SD_TOTAL * 1000000 / res->us / 1024) : 0;
+        snprintf(buf, len, " %-6s %6lu KB/s", def->name, (unsigned long)kbps);
+    } else {
+        // Per iteration: ms with one decimal, kilocycles
+        uint32_t us = (uint32_t)(res->us / def->iterations);
+        uint32_t kcycles = (uint32_t)(res->cycles / def->iterations / 1000);
+        snprintf(buf, len, " %-6s %4lu.%lums %6luk", def->name,
+                 (unsigned long)(us / 1000), (unsigned long)(us % 1000 / 100),
+                 (unsigned long)kcycles);
+    }
+}
+
+static void save_results(const benchmark_data_t *data)
+{
+    if (!screenshot_is_available()) return;
+    
+    FILE *f = fopen(BENCH_RESULTS_FILE, "a");
+    if (!f) {
+        ESP_LOGW(TAG, "Cannot open %s", BENCH_RESULTS_FILE);
+        return;
+    }
+    fprintf(f, "board=%s uptime_s=%lld\n", BENCH_BOARD_NAME,
+            (long long)(esp_timer_get_time() / 1000000));
+    for (int i = 0; i < BENCH_COUNT; i++) {
+        const bench_result_t *res = &data->results[i];
+        fprintf(f, "  %s iterations=%d total_us=%llu cycles=%llu%s\n",
+                benches[i].name, benches[i].iterations,
+                (unsigned long long)res->us, (unsigned long long)res->cycles,
+                res->failed ? " FAILED" : "");
+    }
+    fclose(f);
+    ESP_LOGI(TAG, "Results appended to %s", BENCH_RESULTS_FILE);
+}
+
+static void draw_screen(screen_t *self)
+{
+    benchmark_data_t *data = (benchmark_data_t *)self->user_data;
+    
+    ui_clear();
+    ui_draw_title("Benchmark " BENCH_BOARD_NAME);
+    
+    char line[UI_COLS + 1];
+    for (int i = 0; i < BENCH_COUNT; i++) {
+        format_result((bench_id_t)i, &data->results[i], line, sizeof(line));
+        uint16_t fg = data->results[i].failed ? UI_COLOR_DIMMED : UI_COLOR_TEXT;
+        if (data->running && data->next == i) fg = UI_COLOR_HIGHLIGHT;
+        ui_print(0, 1 + i, line, fg);
+    }
+    
+    ui_draw_status(data->running ? "Running..." : "ENTER:Run S:Scenarios ESC:Back");
+}
+
+static void on_tick(screen_t *self)
+{
+    benchmark_data_t *data = (benchmark_data_t *)self->user_data;
+    if (!data->running) return;
+    
+    bench_id_t id = (bench_id_t)data->next;
+    ESP_LOGI(TAG, "Running %s x%d", benches[id].name, benches[id].iterations);
+    run_bench(id, &data->results[id]);
+    
+    if (++data->next >= BENCH_COUNT) {
+        data->running = false;
+        save_results(data);
+    }
+    draw_screen(self);
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    benchmark_data_t *data = (benchmark_data_t *)self->user_data;
+    if (data->running) return;
+    
+    switch (key) {
+        case KEY_ENTER:
+            memset(data->results, 0, sizeof(data->results));
+            data->next = 0;
+            data->running = true;
+            draw_screen(self);
+            break;
+            
+        case KEY_S:
+            screen_manager_push(scenario_screen_create, NULL);
+            break;
+            
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    if (self->user_data) {
+        free(self->user_data);
+    }
+}
+
+screen_t* benchmark_screen_create(void *params)
+{
+    (void)params;
+    
+    ESP_LOGI(TAG, "Creating benchmark screen...");
+    
+    screen_t *screen = screen_alloc();
+    if (!screen) return NULL;
+    
+    benchmark_data_t *data = calloc(1, sizeof(benchmark_data_t));
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    screen->tick_ms = 50;       // Next test starts right after the results row is drawn
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "Benchmark screen created");
+    return screen;
+}
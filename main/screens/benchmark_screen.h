@@ -0,0 +1,18 @@
+/**
+ * @file benchmark_screen.h
+ * @brief On-device micro-benchmark screen (hidden, Settings + B; S opens the scenario runner)
+ */
+
+#ifndef BENCHMARK_SCREEN_H
+#define BENCHMARK_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the benchmark screen
+ * @param params Unused
+ * @return Screen instance
+ */
+screen_t* benchmark_screen_create(void *params);
+
+#endif // BENCHMARK_SCREEN_H
@@ -0,0 +1,136 @@
+/**
+ * @file boot_timing_screen.c
+ * @brief Boot phase timing diagnostics screen implementation
+ *
+ * Shows how long each init phase took, two per row, so startup latency
+ * can be compared across firmware builds. Failed phases are dimmed with a
+ * "!", phases still running (e.g. the board ping) show "..".
+ */
+
+#include "boot_timing_screen.h"
+#include "boot_profile.h"
+#include "text_ui.h"
+#include "keyboard.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *TAG = "BOOT_TIMING";
+
+// Refresh while background phases may still be finishing
+#define REFRESH_INTERVAL_US 500000
+
+typedef struct {
+    int64_t last_refresh_us;
+} boot_timing_data_t;
+
+static void format_phase(boot_phase_t phase, char *buf, size_t len, uint16_t *fg)
+{
+    boot_phase_info_t info;
+    boot_profile_get(phase, &info);
+    
+    *fg = UI_COLOR_TEXT;
+    if (info.start_us == 0) {
+        snprintf(buf, len, "%-5s    -", boot_profile_phase_name(phase));
+        *fg = UI_COLOR_DIMMED;
+    } else if (info.end_us == 0) {
+        snprintf(buf, len, "%-5s   ..", boot_profile_phase_name(phase));
+        *fg = UI_COLOR_DIMMED;
+    } else {
+        snprintf(buf, len, "%-5s%5lu%s", boot_profile_phase_name(phase),
+                 (unsigned long)((info.end_us - info.start_us) / 1000),
+                 info.ok ? "" : "!");
+        if (!info.ok) *fg = UI_COLOR_DIMMED;
+    }
+}
+
+static void draw_screen(screen_t *self)
+{
+    (void)self;
+    
+    ui_clear();
+    ui_draw_title("Boot Timing (ms)");
+    
+    char text[16];
+    uint16_t fg;
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        int row = 1 + i / 2;
+        int col = (i % 2) ? 16 : 1;
+        format_phase((boot_phase_t)i, text, sizeof(text), &fg);
+        ui_print(col, row, text, fg);
+    }
+    
+    int32_t ready_ms = boot_profile_interactive_ms();
+    char line[UI_COLS + 1];
+    if (ready_ms >= 0) {
+        snprintf(line, sizeof(line), " Interactive at %ld ms", (long)ready_ms);
+    } else {
+        snprintf(line, sizeof(line), " Interactive: pending");
+    }
+    ui_print(0, 6, line, UI_COLOR_HIGHLIGHT);
+    
+    ui_draw_status("ESC:Back");
+}
+
+static void on_tick(screen_t *self)
+{
+    boot_timing_data_t *data = (boot_timing_data_t *)self->user_data;
+    
+    int64_t now = esp_timer_get_time();
+    if (now - data->last_refresh_us >= REFRESH_INTERVAL_US) {
+        data->last_refresh_us = now;
+        draw_screen(self);
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    (void)self;
+    
+    switch (key) {
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    if (self->user_data) {
+        free(self->user_data);
+    }
+}
+
+screen_t* boot_timing_screen_create(void *params)
+{
+    (void)params;
+    
+    ESP_LOGI(TAG, "Creating boot timing screen...");
+    
+    screen_t *screen = screen_alloc();
+    if (!screen) return NULL;
+    
+    boot_timing_data_t *data = calloc(1, sizeof(boot_timing_data_t));
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    data->last_refresh_us = esp_timer_get_time();
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "Boot timing screen created");
+    return screen;
+}
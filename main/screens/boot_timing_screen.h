@@ -0,0 +1,18 @@
+/**
+ * @file boot_timing_screen.h
+ * @brief Boot phase timing diagnostics screen
+ */
+
+#ifndef BOOT_TIMING_SCREEN_H
+#define BOOT_TIMING_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the boot timing screen
+ * @param params Unused
+ * @return Screen instance
+ */
+screen_t* boot_timing_screen_create(void *params);
+
+#endif // BOOT_TIMING_SCREEN_H
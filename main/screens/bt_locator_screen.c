@@ -1,39 +1,42 @@
 /**
  * @file bt_locator_screen.c
  * @brief BT Locator device selection screen - selectable list of BLE devices
+ *
+ * Shares the BT store with the scan screen. scan_bt repeats while the
+ * list is shown, the list is re-sorted by RSSI as results arrive, and the
+ * cursor stays on the device it was on.
  */
 
 #include "bt_locator_screen.h"
 #include "bt_locator_track_screen.h"
 #include "uart_handler.h"
+#include "bt_store.h"
+#include "world_model.h"
 #include "text_ui.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
+#include <stdio.h>
 
 static const char *TAG = "BT_LOCATOR";
 
-// Maximum devices
-#define MAX_DEVICES     64
-#define MAX_NAME_LEN    24
-#define MAX_MAC_LEN     18
-
-// Device entry
-typedef struct {
-    char mac[MAX_MAC_LEN];
-    char name[MAX_NAME_LEN];
-    int rssi;
-} bt_device_t;
+#define VISIBLE_ROWS        6
+#define LOCATOR_MAX_AGE_MS  120000  // Hide devices silent for two minutes
+#define VIEW_REFRESH_US     1000000 // Re-sort at most once a second
 
 // Screen user data
 typedef struct {
-    bt_device_t devices[MAX_DEVICES];
+    uint16_t order[BT_STORE_MAX];   // Store indices, strongest first
     int device_count;
-    int selected_index;
+    int marked_count;
+    int selected_index;             // Position in order[]
     int scroll_offset;
+    uint32_t view_generation;
+    int64_t view_time_us;
+    uint32_t bt_passes;             // world_model pass count at the last scan_bt
+    bool scanning;                  // scan_bt is repeated after each pass
     bool loading;
-    bool needs_redraw;
     screen_t *self;
 } bt_locator_data_t;
 
@@ -41,220 +44,182 @@ typedef struct {
 static void draw_screen(screen_t *self);
 
 /**
- * @brief Check if line is an ESP log line
+ * @brief Re-sort from the store, keeping the cursor on the same device
  */
-static bool is_esp_log_line(const char *line)
+static void refresh_view(bt_locator_data_t *data)
 {
-    if (strlen(line) < 3) return false;
-    
-    if ((line[0] == 'I' || line[0] == 'W' || line[0] == 'E' || line[0] == 'D') 
-        && line[1] == ' ' && line[2] == '(') {
-        return true;
+    int selected_dev = -1;
+    if (data->selected_index < data->device_count) {
+        selected_dev = data->order[data->selected_index];
+    }
+
+    data->view_generation = bt_store_generation();
+    data->view_time_us = esp_timer_get_time();
+    data->device_count = bt_store_view(data->order, BT_STORE_MAX, BT_SORT_RSSI, LOCATOR_MAX_AGE_MS);
+
+    data->marked_count = 0;
+    data->selected_index = 0;
+    for (int i = 0; i < data->device_count; i++) {
+        bt_record_t dev;
+        if (!bt_store_get(data->order[i], &dev)) continue;
+        if (dev.flags & BT_FLAG_MARKED) data->marked_count++;
+        if (data->order[i] == selected_dev) data->selected_index = i;
+    }
+
+    // Keep the cursor on screen
+    if (data->selected_index < data->scroll_offset ||
+        data->selected_index >= data->scroll_offset + VISIBLE_ROWS) {
+        data->scroll_offset = (data->selected_index / VISIBLE_ROWS) * VISIBLE_ROWS;
     }
-    
-    if (strstr(line, "[MEM]") != NULL) return true;
-    if (strncmp(line, "scan_bt", 7) == 0) return true;
-    
-    return false;
 }
 
 /**
- * @brief UART line callback for parsing scan_bt output
+ * @brief Draw one device row (checkbox shows the tracking mark)
  */
-static void uart_line_callback(const char *line, void *user_data)
+static void draw_device_row(bt_locator_data_t *data, int pos, int row)
 {
-    bt_locator_data_t *data = (bt_locator_data_t *)user_data;
-    if (!data || data->device_count >= MAX_DEVICES) return;
-    
-    if (strlen(line) == 0) return;
-    if (is_esp_log_line(line)) return;
-    
-    // Check for "Found N devices:"
-    if (strstr(line, "Found") != NULL && strstr(line, "devices") != NULL) {
-        data->loading = false;
-        return;
-    }
-    
-    // Check for Summary line
-    if (strstr(line, "Summary:") != NULL) {
-        data->loading = false;
-        data->needs_redraw = true;
-        return;
-    }
-    
-    // Parse device line
-    const char *p = line;
-    while (*p == ' ') p++;
-    
-    if (!isdigit((unsigned char)*p)) return;
-    while (isdigit((unsigned char)*p)) p++;
-    if (*p != '.') return;
-    p++;
-    while (*p == ' ') p++;
-    
-    if (strlen(p) < 17) return;
-    
-    bt_device_t *dev = &data->devices[data->device_count];
-    strncpy(dev->mac, p, 17);
-    dev->mac[17] = '\0';
-    
-    const char *rssi_marker = "RSSI: ";
-    const char *rssi_pos = strstr(p, rssi_marker);
-    if (rssi_pos) {
-        dev->rssi = atoi(rssi_pos + strlen(rssi_marker));
-    } else {
-        dev->rssi = 0;
-    }
-    
-    const char *name_marker = "Name: ";
-    const char *name_pos = strstr(p, name_marker);
-    if (name_pos) {
-        strncpy(dev->name, name_pos + strlen(name_marker), MAX_NAME_LEN - 1);
-        dev->name[MAX_NAME_LEN - 1] = '\0';
-        char *end = dev->name + strlen(dev->name) - 1;
-        while (end > dev->name && (*end == '\n' || *end == '\r' || *end == ' ')) {
-            *end = '\0';
-            end--;
-        }
+    bt_record_t dev;
+    if (!bt_store_get(data->order[pos], &dev)) return;
+
+    char line[32];
+    if (dev.name[0] != '\0') {
+        snprintf(line, sizeof(line), "%-18.18s%4d", dev.name, dev.rssi);
     } else {
-        dev->name[0] = '\0';
+        char mac[18];
+        bt_store_format_mac(&dev, mac);
+        snprintf(line, sizeof(line), "%s %d", mac, dev.rssi);
     }
-    
-    data->device_count++;
-    data->needs_redraw = true;
+
+    bool selected = (pos == data->selected_index);
+    ui_draw_menu_item(row, line, selected, true, (dev.flags & BT_FLAG_MARKED) != 0);
 }
 
 static void draw_screen(screen_t *self)
 {
     bt_locator_data_t *data = (bt_locator_data_t *)self->user_data;
-    
+
     ui_clear();
-    
+
     // Draw title
     char title[32];
     snprintf(title, sizeof(title), "BT Locator (%d)", data->device_count);
     ui_draw_title(title);
-    
+
     if (data->loading && data->device_count == 0) {
         ui_print_center(3, "Scanning...", UI_COLOR_DIMMED);
     } else if (data->device_count == 0) {
         ui_print_center(3, "No devices found", UI_COLOR_DIMMED);
     } else {
-        int visible_rows = 6;
         int start_row = 1;
-        
-        for (int i = 0; i < visible_rows; i++) {
-            int dev_idx = data->scroll_offset + i;
-            
-            if (dev_idx < data->device_count) {
-                bt_device_t *dev = &data->devices[dev_idx];
-                char line[32];
-                
-                if (dev->name[0] != '\0') {
-                    snprintf(line, sizeof(line), "%.20s", dev->name);
-                } else {
-                    snprintf(line, sizeof(line), "%s", dev->mac);
-                }
-                
-                bool selected = (dev_idx == data->selected_index);
-                ui_draw_menu_item(start_row + i, line, selected, false, false);
+
+        for (int i = 0; i < VISIBLE_ROWS; i++) {
+            int pos = data->scroll_offset + i;
+            if (pos < data->device_count) {
+                draw_device_row(data, pos, start_row + i);
             }
         }
-        
+
         // Scroll indicators
         if (data->scroll_offset > 0) {
             ui_print(UI_COLS - 2, 1, "^", UI_COLOR_DIMMED);
         }
-        if (data->scroll_offset + visible_rows < data->device_count) {
-            ui_print(UI_COLS - 2, visible_rows, "v", UI_COLOR_DIMMED);
+        if (data->scroll_offset + VISIBLE_ROWS < data->device_count) {
+            ui_print(UI_COLS - 2, VISIBLE_ROWS, "v", UI_COLOR_DIMMED);
         }
     }
-    
+
     // Draw status bar
-    ui_draw_status("UP/DOWN:Nav ENTER:Track ESC:Back");
+    ui_draw_status(data->marked_count > 0 ? "SPC:Mark ENTER:Track marked" :
+                                            "SPC:Mark ENTER:Track ESC:Back");
+}
+
+static void start_scanning(bt_locator_data_t *data)
+{
+    data->bt_passes = world_model_bt_passes();
+    uart_send_command("scan_bt");
+    data->scanning = true;
 }
 
 static void on_tick(screen_t *self)
 {
     bt_locator_data_t *data = (bt_locator_data_t *)self->user_data;
-    
-    if (data->needs_redraw) {
-        data->needs_redraw = false;
-        draw_screen(self);
+
+    // A finished pass starts the next
+    uint32_t passes = world_model_bt_passes();
+    if (data->scanning && passes != data->bt_passes) {
+        data->bt_passes = passes;
+        data->loading = false;
+        uart_send_command("scan_bt");
+    }
+    if (bt_store_generation() != data->view_generation) {
+        data->loading = false;
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (now - data->view_time_us < VIEW_REFRESH_US) return;
+    if (bt_store_generation() == data->view_generation &&
+        now - data->view_time_us < (int64_t)LOCATOR_MAX_AGE_MS * 1000 / 8) {
+        return;
+    }
+    refresh_view(data);
+    draw_screen(self);
+}
+
+/**
+ * @brief Redraw the rows between two cursor positions (same page)
+ */
+static void redraw_rows(bt_locator_data_t *data, int from, int to)
+{
+    int lo = from < to ? from : to;
+    int hi = from < to ? to : from;
+    for (int pos = lo; pos <= hi; pos++) {
+        int i = pos - data->scroll_offset;
+        if (i >= 0 && i < VISIBLE_ROWS && pos < data->device_count) {
+            draw_device_row(data, pos, 1 + i);
+        }
     }
 }
 
 static void on_key(screen_t *self, key_code_t key)
 {
     bt_locator_data_t *data = (bt_locator_data_t *)self->user_data;
-    int visible_rows = 6;
-    
+
     switch (key) {
         case KEY_UP:
             if (data->selected_index > 0) {
                 int old_idx = data->selected_index;
                 // Check if at first visible item on page - do page jump
                 if (data->selected_index == data->scroll_offset && data->scroll_offset > 0) {
-                    data->scroll_offset -= visible_rows;
+                    data->scroll_offset -= VISIBLE_ROWS;
                     if (data->scroll_offset < 0) data->scroll_offset = 0;
-                    data->selected_index = data->scroll_offset + visible_rows - 1;
+                    data->selected_index = data->scroll_offset + VISIBLE_ROWS - 1;
                     if (data->selected_index >= data->device_count) {
                         data->selected_index = data->device_count - 1;
                     }
                     draw_screen(self);  // Full redraw on page jump
                 } else {
                     data->selected_index--;
-                    // Redraw only 2 rows
-                    int start_row = 1;
-                    for (int idx = old_idx; idx >= data->selected_index; idx--) {
-                        int i = idx - data->scroll_offset;
-                        if (i >= 0 && i < visible_rows && idx < data->device_count) {
-                            bt_device_t *dev = &data->devices[idx];
-                            char line[32];
-                            if (dev->name[0] != '\0') {
-                                snprintf(line, sizeof(line), "%.20s", dev->name);
-                            } else {
-                                snprintf(line, sizeof(line), "%s", dev->mac);
-                            }
-                            bool selected = (idx == data->selected_index);
-                            ui_draw_menu_item(start_row + i, line, selected, false, false);
-                        }
-                    }
+                    redraw_rows(data, old_idx, data->selected_index);
                 }
             } else if (data->device_count > 0) {
                 data->selected_index = data->device_count - 1;
-                data->scroll_offset = (data->selected_index / visible_rows) * visible_rows;
+                data->scroll_offset = (data->selected_index / VISIBLE_ROWS) * VISIBLE_ROWS;
                 draw_screen(self);
             }
             break;
-            
+
         case KEY_DOWN:
             if (data->selected_index < data->device_count - 1) {
                 int old_idx = data->selected_index;
                 // Check if at last visible item on page - do page jump
-                if (data->selected_index == data->scroll_offset + visible_rows - 1) {
+                if (data->selected_index == data->scroll_offset + VISIBLE_ROWS - 1) {
                     // Jump to next page - don't adjust back for partial pages
-                    data->scroll_offset += visible_rows;
+                    data->scroll_offset += VISIBLE_ROWS;
                     data->selected_index = data->scroll_offset;
                     draw_screen(self);  // Full redraw on page jump
                 } else {
                     data->selected_index++;
-                    // Redraw only 2 rows
-                    int start_row = 1;
-                    for (int idx = old_idx; idx <= data->selected_index; idx++) {
-                        int i = idx - data->scroll_offset;
-                        if (i >= 0 && i < visible_rows && idx < data->device_count) {
-                            bt_device_t *dev = &data->devices[idx];
-                            char line[32];
-                            if (dev->name[0] != '\0') {
-                                snprintf(line, sizeof(line), "%.20s", dev->name);
-                            } else {
-                                snprintf(line, sizeof(line), "%s", dev->mac);
-                            }
-                            bool selected = (idx == data->selected_index);
-                            ui_draw_menu_item(start_row + i, line, selected, false, false);
-                        }
-                    }
+                    redraw_rows(data, old_idx, data->selected_index);
                 }
             } else if (data->device_count > 0) {
                 data->selected_index = 0;
@@ -262,86 +227,119 @@ static void on_key(screen_t *self, key_code_t key)
                 draw_screen(self);
             }
             break;
-            
-        case KEY_ENTER:
+
         case KEY_SPACE:
-            if (data->device_count > 0 && data->selected_index < data->device_count) {
-                bt_device_t *dev = &data->devices[data->selected_index];
-                
-                // Create params for tracking screen
-                bt_locator_track_params_t *params = malloc(sizeof(bt_locator_track_params_t));
-                if (params) {
-                    strncpy(params->mac, dev->mac, sizeof(params->mac) - 1);
-                    params->mac[sizeof(params->mac) - 1] = '\0';
-                    strncpy(params->name, dev->name, sizeof(params->name) - 1);
-                    params->name[sizeof(params->name) - 1] = '\0';
-                    
-                    ESP_LOGI(TAG, "Selected device: %s (%s)", dev->mac, dev->name);
-                    screen_manager_push(bt_locator_track_screen_create, params);
+            // Mark up to BT_LOCATOR_MAX_TARGETS devices to track together
+            if (data->selected_index < data->device_count) {
+                int index = data->order[data->selected_index];
+                bt_record_t dev;
+                if (!bt_store_get(index, &dev)) break;
+                if (dev.flags & BT_FLAG_MARKED) {
+                    bt_store_set_flag(index, BT_FLAG_MARKED, false);
+                    data->marked_count--;
+                } else if (data->marked_count < BT_LOCATOR_MAX_TARGETS) {
+                    bt_store_set_flag(index, BT_FLAG_MARKED, true);
+                    data->marked_count++;
+                }
+                redraw_rows(data, data->selected_index, data->selected_index);
+                ui_draw_status(data->marked_count > 0 ? "SPC:Mark ENTER:Track marked" :
+                                                        "SPC:Mark ENTER:Track ESC:Back");
+            }
+            break;
+
+        case KEY_ENTER:
+            if (data->selected_index < data->device_count) {
+                // Create params for tracking screen: marked devices, or the
+                // highlighted one if nothing is marked
+                bt_locator_track_params_t *params = calloc(1, sizeof(bt_locator_track_params_t));
+                if (!params) break;
+
+                for (int i = 0; i < data->device_count && params->count < BT_LOCATOR_MAX_TARGETS; i++) {
+                    bt_record_t dev;
+                    if (!bt_store_get(data->order[i], &dev)) continue;
+                    bool pick = data->marked_count > 0 ? (dev.flags & BT_FLAG_MARKED) != 0 :
+                                                         i == data->selected_index;
+                    if (!pick) continue;
+
+                    bt_store_format_mac(&dev, params->targets[params->count].mac);
+                    strncpy(params->targets[params->count].name, dev.name,
+                            sizeof(params->targets[0].name) - 1);
+                    ESP_LOGI(TAG, "Selected device: %s (%s)",
+                             params->targets[params->count].mac, dev.name);
+                    params->count++;
                 }
+
+                // The tracker owns the link until it returns
+                uart_send_command("stop");
+                data->scanning = false;
+                if (screen_manager_push(bt_locator_track_screen_create, params) == ESP_ERR_NO_MEM) free(params);
             }
             break;
-            
+
         case KEY_ESC:
         case KEY_Q:
         case KEY_BACKSPACE:
+            uart_send_command("stop");
             screen_manager_pop();
             break;
-            
+
         default:
             break;
     }
 }
 
-static void on_destroy(screen_t *self)
+static void on_resume(screen_t *self)
 {
     bt_locator_data_t *data = (bt_locator_data_t *)self->user_data;
-    
-    uart_clear_line_callback();
-    
-    if (data) {
-        free(data);
+
+    if (!data->scanning) {
+        start_scanning(data);
     }
+    refresh_view(data);
+    draw_screen(self);
+}
+
+static void on_destroy(screen_t *self)
+{
+    free(self->user_data);
 }
 
 screen_t* bt_locator_screen_create(void *params)
 {
     (void)params;
-    
+
     ESP_LOGI(TAG, "Creating BT Locator screen...");
-    
+
+    if (bt_store_init() != ESP_OK) return NULL;
+
     screen_t *screen = screen_alloc();
     if (!screen) return NULL;
-    
+
     bt_locator_data_t *data = calloc(1, sizeof(bt_locator_data_t));
     if (!data) {
         free(screen);
         return NULL;
     }
-    
+
+    // Marks from an earlier visit do not carry over
+    for (int i = 0; i < bt_store_count(); i++) {
+        bt_store_set_flag(i, BT_FLAG_MARKED, false);
+    }
     data->loading = true;
     data->self = screen;
-    
+    refresh_view(data);
+
     screen->user_data = data;
     screen->on_key = on_key;
     screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
     screen->on_tick = on_tick;
-    
-    uart_register_line_callback(uart_line_callback, data);
-    uart_send_command("scan_bt");
+    screen->on_resume = on_resume;
+    screen->tick_on_uart = true;    // on_tick only acts on new passes and rows
+
+    start_scanning(data);
     draw_screen(screen);
-    
+
     ESP_LOGI(TAG, "BT Locator screen created");
     return screen;
 }
-
-
-
-
-
-
-
-
-
-
@@ -1,117 +1,248 @@
 /**
  * @file bt_locator_track_screen.c
- * @brief BT Locator tracking screen - tracks single device RSSI
+ * @brief BT Locator tracking screen - smoothed RSSI, trend and history per device
+ *
+ * Following a single device with the CAP GPS running, the smoothed RSSI
+ * is also recorded against position once a second (geo_locate) and the
+ * screen points towards the estimated source.
  */
 
 #include "bt_locator_track_screen.h"
 #include "uart_handler.h"
+#include "mac_set.h"
+#include "geo_locate.h"
+#include "janos_proto.h"
 #include "text_ui.h"
+#include "ui_widget.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 static const char *TAG = "BT_TRACK";
 
-// Refresh timer interval (200ms)
+// Refresh timer interval (200ms), also the history sample period
 #define REFRESH_INTERVAL_US 200000
 
-// Screen user data
+// Readings are drawn as they arrive, up to the render frame cap
+#define TRACK_REDRAW_MS     RENDER_FRAME_INTERVAL_MS
+
+// 1-D Kalman filter on RSSI: the device (or the hunter) moves, so the true
+// level drifts; single readings scatter by several dB from multipath
+#define KALMAN_Q_PER_S      9.0f    // Process noise, dB^2 per second
+#define KALMAN_R            25.0f   // Measurement noise, dB^2 (5 dB sd)
+
+// Trend: smoothed RSSI now versus TREND_SAMPLES history samples (2 s) ago
+#define TREND_SAMPLES       10
+#define TREND_DB            2
+
+// No reading for this long: history shows a gap, label goes dim
+#define STALE_US            3000000
+
+// Walk-test sampling period (single device)
+#define LOCATE_TICK_MS      1000
+
+// History sparkline under each device's label: 116 samples (23 s)
+#define SPARK_X             4
+#define SPARK_W             (DISPLAY_WIDTH - 2 * SPARK_X)
+#define SPARK_H             12
+#define SPARK_COL_W         2
+#define SPARK_RSSI_MIN      (-100)
+#define SPARK_RSSI_MAX      (-30)
+
+// One tracked device
 typedef struct {
     char mac[18];
     char name[24];
-    int rssi;
-    bool device_found;
-    bool needs_redraw;
+    bool seen;
+    float estimate;             // Smoothed RSSI
+    float variance;
+    int64_t last_us;            // Time of the last reading
+    ui_history_t history;       // Smoothed RSSI, one sample per refresh
+    ui_label_t label;
+    ui_sparkline_t spark;
+} bt_target_t;
+
+// Screen user data
+typedef struct {
+    bt_target_t targets[BT_LOCATOR_MAX_TARGETS];
+    int target_count;
+    mac_set_t index;            // Packed MAC -> targets[] index
+    bool rescan;                // Multi-target: list scan finished, start the next
     esp_timer_handle_t refresh_timer;
     screen_t *self;
+    // Retained widgets: updates repaint only the changed cells and columns
+    bool layout_drawn;
+    uint32_t layout_generation;
+    ui_label_t strength_label;
+    // Walk-test localisation (single device with a CAP GPS)
+    bool locate;
+    geo_locate_t walk;
+    ui_label_t locate_label;
 } bt_track_data_t;
 
 // Forward declaration
 static void draw_screen(screen_t *self);
 
 /**
- * @brief Timer callback - checks if redraw is needed
+ * @brief Fold one RSSI reading into a target's Kalman estimate
+ */
+static void target_update(bt_target_t *t, int rssi, int64_t now)
+{
+    if (!t->seen) {
+        t->estimate = (float)rssi;
+        t->variance = KALMAN_R;
+        t->seen = true;
+    } else {
+        float dt = (now - t->last_us) / 1e6f;
+        t->variance += KALMAN_Q_PER_S * dt;
+        float gain = t->variance / (t->variance + KALMAN_R);
+        t->estimate += gain * ((float)rssi - t->estimate);
+        t->variance *= 1.0f - gain;
+    }
+    t->last_us = now;
+}
+
+static bool target_stale(const bt_target_t *t, int64_t now)
+{
+    return !t->seen || now - t->last_us > STALE_US;
+}
+
+/**
+ * @brief Timer callback - samples history, restarts list scans, requests redraws
  */
 static void refresh_timer_callback(void *arg)
 {
     bt_track_data_t *data = (bt_track_data_t *)arg;
-    if (data && data->needs_redraw && data->self) {
-        data->needs_redraw = false;
-        draw_screen(data->self);
+    if (!data || !data->self) return;
+
+    int64_t now = esp_timer_get_time();
+    for (int i = 0; i < data->target_count; i++) {
+        bt_target_t *t = &data->targets[i];
+        ui_history_push(&t->history,
+                        target_stale(t, now) ? UI_HISTORY_NONE : (int8_t)(t->estimate - 0.5f));
     }
+
+    if (data->rescan) {
+        data->rescan = false;
+        uart_send_command("scan_bt");
+    }
+
+    screen_manager_data_changed(data->self);
 }
 
 /**
  * @brief UART line callback for parsing tracking output
- * Format: "XX:XX:XX:XX:XX:XX  RSSI: -93 dBm  Name: ..."
+ *
+ * Single target (scan_bt <MAC>): "XX:XX:XX:XX:XX:XX  RSSI: -93 dBm  Name: ..."
+ * Several (repeated scan_bt): "  3. XX:XX:XX:XX:XX:XX  RSSI: -93 dBm  Name: ..."
  */
 static void uart_line_callback(const char *line, void *user_data)
 {
     bt_track_data_t *data = (bt_track_data_t *)user_data;
     if (!data) return;
-    
-    // Check if this line contains our target MAC
-    if (strstr(line, data->mac) == NULL) return;
-    
-    // Parse RSSI
-    const char *rssi_marker = "RSSI: ";
-    const char *rssi_pos = strstr(line, rssi_marker);
-    if (rssi_pos) {
-        data->rssi = atoi(rssi_pos + strlen(rssi_marker));
-        data->device_found = true;
-        data->needs_redraw = true;
-        
-        ESP_LOGI(TAG, "Device %s RSSI: %d", data->mac, data->rssi);
+
+    if (data->target_count > 1 && strstr(line, "Summary:") != NULL) {
+        data->rescan = true;
+        return;
     }
+
+    janos_bt_row_t row;
+    if (!janos_parse_bt_row(line, &row)) return;
+
+    int index = mac_set_find(&data->index, row.mac);
+    if (index < 0) return;
+
+    if (row.rssi != JANOS_RSSI_NONE) {
+        bt_target_t *t = &data->targets[index];
+        int rssi = row.rssi;
+        target_update(t, rssi, esp_timer_get_time());
+        screen_manager_data_changed(data->self);
+
+        ESP_LOGD(TAG, "Device %s RSSI: %d (smoothed %.1f)", t->mac, rssi, t->estimate);
+    }
+}
+
+static const char *trend_arrow(const bt_target_t *t)
+{
+    int8_t now = ui_history_get(&t->history, 0);
+    int8_t then = ui_history_get(&t->history, TREND_SAMPLES);
+    if (now == UI_HISTORY_NONE || then == UI_HISTORY_NONE) return " ";
+    if (now - then >= TREND_DB) return "^";     // Getting closer
+    if (then - now >= TREND_DB) return "v";
+    return "=";
 }
 
 static void draw_screen(screen_t *self)
 {
     bt_track_data_t *data = (bt_track_data_t *)self->user_data;
-    
-    ui_clear();
-    
-    // Draw title
-    ui_draw_title("BT Locator");
-    
-    int row = 2;
-    
-    // Show device name or MAC
-    if (data->name[0] != '\0') {
-        ui_print_center(row, data->name, UI_COLOR_HIGHLIGHT);
-    } else {
-        ui_print_center(row, data->mac, UI_COLOR_HIGHLIGHT);
-    }
-    row += 2;
-    
-    // Show RSSI
-    if (data->device_found) {
-        char rssi_str[32];
-        snprintf(rssi_str, sizeof(rssi_str), "RSSI: %d dBm", data->rssi);
-        ui_print_center(row, rssi_str, UI_COLOR_TEXT);
-        
-        // Show signal strength indicator
-        row += 2;
-        const char *strength;
-        if (data->rssi > -50) {
-            strength = "Signal: EXCELLENT";
-        } else if (data->rssi > -60) {
-            strength = "Signal: GOOD";
-        } else if (data->rssi > -70) {
-            strength = "Signal: FAIR";
-        } else if (data->rssi > -80) {
-            strength = "Signal: WEAK";
+    int64_t now = esp_timer_get_time();
+
+    // Static chrome only after a clear; widgets repaint themselves
+    if (!data->layout_drawn || data->layout_generation != ui_get_clear_generation()) {
+        ui_clear();
+        ui_draw_title(data->target_count > 1 ? "BT Locator (multi)" : "BT Locator");
+        ui_draw_status("ESC: Stop & Exit");
+        data->layout_generation = ui_get_clear_generation();
+        data->layout_drawn = true;
+    }
+
+    for (int i = 0; i < data->target_count; i++) {
+        bt_target_t *t = &data->targets[i];
+        const char *who = t->name[0] != '\0' ? t->name : t->mac;
+        char line[UI_COLS + 1];
+
+        if (target_stale(t, now)) {
+            snprintf(line, sizeof(line), "%-19.19s %s", who, t->seen ? "  lost" : "search");
+            ui_label_set_colors(&t->label, UI_COLOR_DIMMED, UI_COLOR_BG);
         } else {
-            strength = "Signal: VERY WEAK";
+            snprintf(line, sizeof(line), "%-19.19s %4ddBm %s",
+                     who, (int)(t->estimate - 0.5f), trend_arrow(t));
+            ui_label_set_colors(&t->label, UI_COLOR_HIGHLIGHT, UI_COLOR_BG);
         }
-        ui_print_center(row, strength, UI_COLOR_DIMMED);
-    } else {
-        ui_print_center(row, "Searching...", UI_COLOR_DIMMED);
+        ui_label_set(&t->label, line);
+        ui_sparkline_update(&t->spark, &t->history);
+    }
+
+    // Single device: room for a plain-language strength line
+    if (data->target_count == 1) {
+        bt_target_t *t = &data->targets[0];
+        const char *strength = NULL;
+        if (!target_stale(t, now)) {
+            int rssi = (int)(t->estimate - 0.5f);
+            if (rssi > -50) {
+                strength = "Signal: EXCELLENT";
+            } else if (rssi > -60) {
+                strength = "Signal: GOOD";
+            } else if (rssi > -70) {
+                strength = "Signal: FAIR";
+            } else if (rssi > -80) {
+                strength = "Signal: WEAK";
+            } else {
+                strength = "Signal: VERY WEAK";
+            }
+        }
+        ui_label_set(&data->strength_label, strength);
+    }
+
+    if (data->locate) {
+        char line[UI_COLS + 1];
+        geo_locate_describe(&data->walk, line, sizeof(line));
+        ui_label_set(&data->locate_label, line);
     }
-    
-    // Draw status bar
-    ui_draw_status("ESC: Stop & Exit");
+}
+
+/**
+ * @brief Record the smoothed RSSI at the current position
+ */
+static void on_tick(screen_t *self)
+{
+    bt_track_data_t *data = (bt_track_data_t *)self->user_data;
+    bt_target_t *t = &data->targets[0];
+
+    if (!data->locate || target_stale(t, esp_timer_get_time())) return;
+    geo_locate_add_here(&data->walk, (int)(t->estimate - 0.5f));
 }
 
 static void on_key(screen_t *self, key_code_t key)
@@ -123,7 +254,7 @@ static void on_key(screen_t *self, key_code_t key)
             uart_send_command("stop");
             screen_manager_pop();
             break;
-            
+
         default:
             break;
     }
@@ -132,15 +263,14 @@ static void on_key(screen_t *self, key_code_t key)
 static void on_destroy(screen_t *self)
 {
     bt_track_data_t *data = (bt_track_data_t *)self->user_data;
-    
+
     if (data && data->refresh_timer) {
         esp_timer_stop(data->refresh_timer);
         esp_timer_delete(data->refresh_timer);
     }
-    
-    uart_clear_line_callback();
-    
+
     if (data) {
+        mac_set_free(&data->index);
         free(data);
     }
 }
@@ -148,74 +278,101 @@ static void on_destroy(screen_t *self)
 screen_t* bt_locator_track_screen_create(void *params)
 {
     bt_locator_track_params_t *track_params = (bt_locator_track_params_t *)params;
-    
-    if (!track_params) {
+
+    if (!track_params || track_params->count < 1) {
         ESP_LOGE(TAG, "No parameters provided");
+        free(track_params);
         return NULL;
     }
-    
-    ESP_LOGI(TAG, "Creating BT tracking screen for: %s (%s)", 
-             track_params->mac, track_params->name);
-    
+
     screen_t *screen = screen_alloc();
     if (!screen) {
         free(track_params);
         return NULL;
     }
-    
+
     bt_track_data_t *data = calloc(1, sizeof(bt_track_data_t));
-    if (!data) {
+    if (!data || mac_set_init(&data->index, BT_LOCATOR_MAX_TARGETS) != ESP_OK) {
+        free(data);
         free(screen);
         free(track_params);
         return NULL;
     }
-    
-    strncpy(data->mac, track_params->mac, sizeof(data->mac) - 1);
-    data->mac[sizeof(data->mac) - 1] = '\0';
-    strncpy(data->name, track_params->name, sizeof(data->name) - 1);
-    data->name[sizeof(data->name) - 1] = '\0';
+
+    int count = track_params->count;
+    if (count > BT_LOCATOR_MAX_TARGETS) count = BT_LOCATOR_MAX_TARGETS;
+    for (int i = 0; i < count; i++) {
+        uint64_t key;
+        if (!mac_set_key_from_mac(track_params->targets[i].mac, &key)) continue;
+        bool is_new;
+        int index = mac_set_add(&data->index, key, &is_new);
+        if (index < 0 || !is_new) continue;
+
+        bt_target_t *t = &data->targets[index];
+        strncpy(t->mac, track_params->targets[i].mac, sizeof(t->mac) - 1);
+        strncpy(t->name, track_params->targets[i].name, sizeof(t->name) - 1);
+        ui_history_reset(&t->history);
+        ui_label_init(&t->label, 0, 1 + index * 2, UI_COLS, UI_ALIGN_LEFT,
+                      UI_COLOR_DIMMED, UI_COLOR_BG);
+        ui_sparkline_init(&t->spark, SPARK_X, (2 + index * 2) * (DISPLAY_HEIGHT / UI_ROWS) + 2,
+                          SPARK_W, SPARK_H, SPARK_COL_W, SPARK_RSSI_MIN, SPARK_RSSI_MAX,
+                          UI_COLOR_TEXT, UI_COLOR_BG);
+        ESP_LOGI(TAG, "Tracking %s (%s)", t->mac, t->name);
+    }
+    data->target_count = data->index.count;
     data->self = screen;
-    data->device_found = false;
-    
+    ui_label_init(&data->strength_label, 0, 4, UI_COLS, UI_ALIGN_CENTER, UI_COLOR_DIMMED, UI_COLOR_BG);
+    data->locate = data->target_count == 1 && geo_locate_available();
+    geo_locate_reset(&data->walk);
+    ui_label_init(&data->locate_label, 0, 5, UI_COLS, UI_ALIGN_CENTER, UI_COLOR_TEXT, UI_COLOR_BG);
+
     free(track_params);
-    
+
+    if (data->target_count == 0) {
+        ESP_LOGE(TAG, "No valid MAC to track");
+        mac_set_free(&data->index);
+        free(data);
+        free(screen);
+        return NULL;
+    }
+
     screen->user_data = data;
     screen->on_key = on_key;
     screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
-    
+    screen->redraw_ms = TRACK_REDRAW_MS;
+    if (data->locate) {
+        screen->on_tick = on_tick;
+        screen->tick_ms = LOCATE_TICK_MS;
+    }
+
     // Create periodic refresh timer
     esp_timer_create_args_t timer_args = {
         .callback = refresh_timer_callback,
         .arg = data,
         .name = "bt_track_refresh"
     };
-    
+
     if (esp_timer_create(&timer_args, &data->refresh_timer) == ESP_OK) {
         esp_timer_start_periodic(data->refresh_timer, REFRESH_INTERVAL_US);
     } else {
         ESP_LOGW(TAG, "Failed to create refresh timer");
     }
-    
-    uart_register_line_callback(uart_line_callback, data);
-    
-    // Send scan_bt with MAC address
-    char cmd[48];
-    snprintf(cmd, sizeof(cmd), "scan_bt %s", data->mac);
-    uart_send_command(cmd);
-    
-    draw_screen(screen);
-    
-    ESP_LOGI(TAG, "BT tracking screen created");
-    return screen;
-}
-
-
-
-
-
-
 
+    screen_set_line_callback(screen, uart_line_callback, data);
 
+    // JanOS follows one MAC natively; several devices come from back-to-back
+    // list scans, restarted from the timer when each one ends
+    if (data->target_count == 1) {
+        char cmd[48];
+        snprintf(cmd, sizeof(cmd), "scan_bt %s", data->targets[0].mac);
+        uart_send_command(cmd);
+    } else {
+        uart_send_command("scan_bt");
+    }
 
+    draw_screen(screen);
 
+    ESP_LOGI(TAG, "BT tracking screen created (%d devices)", data->target_count);
+    return screen;
+}
@@ -8,17 +8,22 @@
 
 #include "screen_manager.h"
 
+#define BT_LOCATOR_MAX_TARGETS  3   // Two display rows per device
+
 /**
  * @brief Parameters for BT locator tracking screen
  */
 typedef struct {
-    char mac[18];    // MAC address to track
-    char name[24];   // Device name (may be empty)
+    int count;                  // Devices to track (1 .. BT_LOCATOR_MAX_TARGETS)
+    struct {
+        char mac[18];           // MAC address to track
+        char name[24];          // Device name (may be empty)
+    } targets[BT_LOCATOR_MAX_TARGETS];
 } bt_locator_track_params_t;
 
 /**
  * @brief Create the BT Locator tracking screen
- * @param params Pointer to bt_locator_track_params_t
+ * @param params Pointer to a malloc'd bt_locator_track_params_t (freed by the screen)
  * @return Pointer to the created screen, or NULL on failure
  */
 screen_t* bt_locator_track_screen_create(void *params);
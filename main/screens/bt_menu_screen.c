@@ -4,6 +4,7 @@
  */
 
 #include "bt_menu_screen.h"
+#include "screen_registry.h"
 #include "airtag_scan_screen.h"
 #include "bt_scan_screen.h"
 #include "bt_locator_screen.h"
@@ -151,12 +152,4 @@ screen_t* bt_menu_screen_create(void *params)
     return screen;
 }
 
-
-
-
-
-
-
-
-
-
+SCREEN_REGISTER(HOME, 50, bt_menu_screen_create, 0, "Bluetooth", NULL);
@@ -1,246 +1,222 @@
 /**
  * @file bt_scan_screen.c
- * @brief BT scan screen implementation - shows scrollable list of BLE devices
+ * @brief BT scan screen implementation - live, sorted list of BLE devices
+ *
+ * scan_bt runs back to back while the screen is open; world_model files
+ * every result in the shared BT store and the list is rebuilt from a
+ * sorted view of it. Devices not heard for BT_SCAN_MAX_AGE_MS drop out of
+ * the list. TAB finds a device by name (vendor or MAC when it has none)
+ * and pages to it; the device found stays highlighted.
  */
 
 #include "bt_scan_screen.h"
 #include "uart_handler.h"
+#include "bt_store.h"
+#include "world_model.h"
+#include "oui_lookup.h"
 #include "text_ui.h"
+#include "ui_typeahead.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
+#include <stdio.h>
 
 static const char *TAG = "BT_SCAN";
 
-// Maximum devices
-#define MAX_DEVICES     64
-#define MAX_NAME_LEN    24
-#define MAX_MAC_LEN     18
-
-// Device entry
-typedef struct {
-    char mac[MAX_MAC_LEN];
-    char name[MAX_NAME_LEN];
-    int rssi;
-} bt_device_t;
+#define VISIBLE_ROWS        6
+#define BT_SCAN_MAX_AGE_MS  120000  // Hide devices silent for two minutes
+#define VIEW_REFRESH_US     500000  // Re-sort at most twice a second
 
 // Screen user data
 typedef struct {
-    bt_device_t devices[MAX_DEVICES];
-    int device_count;
-    int total_count;
+    uint16_t order[BT_STORE_MAX];   // Store indices, sorted
+    int count;
+    bt_sort_t sort;
+    uint32_t view_generation;       // Store generation behind order[]
+    int64_t view_time_us;
     int scroll_offset;
+    uint32_t bt_passes;             // world_model pass count at the last scan_bt
     bool loading;
-    bool needs_redraw;
+    ui_typeahead_t find;
+    int found;                      // Store index of the device found, -1 none
     screen_t *self;
 } bt_scan_data_t;
 
-// Forward declaration
-static void draw_screen(screen_t *self);
+static const char *sort_names[BT_SORT_COUNT] = {
+    [BT_SORT_RSSI] = "RSSI",
+    [BT_SORT_LAST_SEEN] = "Recent",
+};
 
 /**
- * @brief Check if line is an ESP log line
+ * @brief Rebuild the sorted view from the store
  */
-static bool is_esp_log_line(const char *line)
+static void refresh_view(bt_scan_data_t *data)
 {
-    if (strlen(line) < 3) return false;
-    
-    if ((line[0] == 'I' || line[0] == 'W' || line[0] == 'E' || line[0] == 'D') 
-        && line[1] == ' ' && line[2] == '(') {
-        return true;
+    data->view_generation = bt_store_generation();
+    data->view_time_us = esp_timer_get_time();
+    data->count = bt_store_view(data->order, BT_STORE_MAX, data->sort, BT_SCAN_MAX_AGE_MS);
+    ui_typeahead_rows_moved(&data->find);
+
+    if (data->scroll_offset >= data->count) {
+        data->scroll_offset = data->count > 0 ?
+            ((data->count - 1) / VISIBLE_ROWS) * VISIBLE_ROWS : 0;
     }
-    
-    if (strstr(line, "[MEM]") != NULL) return true;
-    if (strncmp(line, "scan_bt", 7) == 0) return true;
-    
-    return false;
 }
 
-/**
- * @brief UART line callback for parsing scan_bt output
- * Format: "  1. XX:XX:XX:XX:XX:XX  RSSI: -82 dBm  Name: Device Name"
- */
-static void uart_line_callback(const char *line, void *user_data)
+static void device_name(int index, char *name, size_t len, void *user_data)
 {
     bt_scan_data_t *data = (bt_scan_data_t *)user_data;
-    if (!data || data->device_count >= MAX_DEVICES) return;
-    
-    // Skip empty lines
-    if (strlen(line) == 0) return;
-    
-    // Skip ESP log lines
-    if (is_esp_log_line(line)) return;
-    
-    // Check for "Found N devices:"
-    if (strstr(line, "Found") != NULL && strstr(line, "devices") != NULL) {
-        int count = 0;
-        if (sscanf(line, "Found %d devices", &count) == 1) {
-            data->total_count = count;
-            data->loading = false;
-            ESP_LOGI(TAG, "Found %d devices", count);
-        }
-        return;
-    }
-    
-    // Check for Summary line (end of scan)
-    if (strstr(line, "Summary:") != NULL) {
-        data->loading = false;
-        data->needs_redraw = true;
-        return;
-    }
-    
-    // Parse device line: "  1. XX:XX:XX:XX:XX:XX  RSSI: -82 dBm  Name: ..."
-    const char *p = line;
-    
-    // Skip leading whitespace
-    while (*p == ' ') p++;
-    
-    // Check for number followed by dot
-    if (!isdigit((unsigned char)*p)) return;
-    while (isdigit((unsigned char)*p)) p++;
-    if (*p != '.') return;
-    p++; // Skip dot
-    while (*p == ' ') p++; // Skip space after dot
-    
-    // Now p should point to MAC address
-    if (strlen(p) < 17) return;
-    
-    // Copy MAC (17 chars)
-    bt_device_t *dev = &data->devices[data->device_count];
-    strncpy(dev->mac, p, 17);
-    dev->mac[17] = '\0';
-    
-    // Find RSSI
-    const char *rssi_marker = "RSSI: ";
-    const char *rssi_pos = strstr(p, rssi_marker);
-    if (rssi_pos) {
-        dev->rssi = atoi(rssi_pos + strlen(rssi_marker));
-    } else {
-        dev->rssi = 0;
-    }
-    
-    // Find Name (optional)
-    const char *name_marker = "Name: ";
-    const char *name_pos = strstr(p, name_marker);
-    if (name_pos) {
-        strncpy(dev->name, name_pos + strlen(name_marker), MAX_NAME_LEN - 1);
-        dev->name[MAX_NAME_LEN - 1] = '\0';
-        // Remove trailing whitespace
-        char *end = dev->name + strlen(dev->name) - 1;
-        while (end > dev->name && (*end == '\n' || *end == '\r' || *end == ' ')) {
-            *end = '\0';
-            end--;
-        }
-    } else {
-        dev->name[0] = '\0';
-    }
-    
-    ESP_LOGI(TAG, "Device %d: %s RSSI:%d Name:'%s'", 
-             data->device_count, dev->mac, dev->rssi, dev->name);
-    
-    data->device_count++;
-    data->needs_redraw = true;
+    bt_record_t dev;
+    if (!bt_store_get(data->order[index], &dev)) return;
+
+    char mac[18];
+    bt_store_format_mac(&dev, mac);
+    const char *vendor = oui_lookup_str(mac);
+    snprintf(name, len, "%s", dev.name[0] ? dev.name : vendor ? vendor : mac);
 }
 
 static void draw_screen(screen_t *self)
 {
     bt_scan_data_t *data = (bt_scan_data_t *)self->user_data;
-    
+
     ui_clear();
-    
+
     // Draw title with count
     char title[32];
-    snprintf(title, sizeof(title), "BT Scan (%d)", data->device_count);
+    snprintf(title, sizeof(title), "BT Scan (%d) %s", data->count, sort_names[data->sort]);
     ui_draw_title(title);
-    
-    if (data->loading && data->device_count == 0) {
+
+    if (data->loading && data->count == 0) {
         ui_print_center(3, "Scanning...", UI_COLOR_DIMMED);
-    } else if (data->device_count == 0) {
+    } else if (data->count == 0) {
         ui_print_center(3, "No devices found", UI_COLOR_DIMMED);
     } else {
         // Draw visible devices
-        int visible_rows = 6;
         int start_row = 1;
-        
-        for (int i = 0; i < visible_rows; i++) {
-            int dev_idx = data->scroll_offset + i;
-            
-            if (dev_idx < data->device_count) {
-                bt_device_t *dev = &data->devices[dev_idx];
-                char line[40];
-                
-                if (dev->name[0] != '\0') {
-                    // Show name and RSSI
-                    snprintf(line, sizeof(line), "%.18s %ddB", dev->name, dev->rssi);
+
+        for (int i = 0; i < VISIBLE_ROWS; i++) {
+            int pos = data->scroll_offset + i;
+            bt_record_t dev;
+            if (pos >= data->count || !bt_store_get(data->order[pos], &dev)) continue;
+
+            char mac[18];
+            char line[40];
+            bt_store_format_mac(&dev, mac);
+
+            if (dev.name[0] != '\0') {
+                // Show name and RSSI
+                snprintf(line, sizeof(line), "%.18s %ddB", dev.name, dev.rssi);
+            } else {
+                // Show vendor (public addresses only) or MAC, and RSSI
+                const char *vendor = oui_lookup_str(mac);
+                if (vendor) {
+                    snprintf(line, sizeof(line), "%.12s %.8s %ddB", vendor, mac + 9, dev.rssi);
                 } else {
-                    // Show MAC and RSSI
-                    snprintf(line, sizeof(line), "%s %ddB", dev->mac, dev->rssi);
+                    snprintf(line, sizeof(line), "%s %ddB", mac, dev.rssi);
                 }
-                
-                ui_print(0, start_row + i, line, UI_COLOR_TEXT);
             }
+
+            ui_print(0, start_row + i, line,
+                     data->order[pos] == data->found ? UI_COLOR_HIGHLIGHT : UI_COLOR_TEXT);
         }
-        
+
         // Scroll indicators
         if (data->scroll_offset > 0) {
             ui_print(UI_COLS - 2, 1, "^", UI_COLOR_DIMMED);
         }
-        if (data->scroll_offset + visible_rows < data->device_count) {
-            ui_print(UI_COLS - 2, visible_rows, "v", UI_COLOR_DIMMED);
+        if (data->scroll_offset + VISIBLE_ROWS < data->count) {
+            ui_print(UI_COLS - 2, VISIBLE_ROWS, "v", UI_COLOR_DIMMED);
         }
     }
-    
+
     // Draw status bar
-    ui_draw_status("UP/DOWN:Scroll ESC:Back");
+    ui_typeahead_draw_status(&data->find, "UP/DN:Scroll S:Sort TAB:Find");
 }
 
 static void on_tick(screen_t *self)
 {
     bt_scan_data_t *data = (bt_scan_data_t *)self->user_data;
-    
-    if (data->needs_redraw) {
-        data->needs_redraw = false;
-        draw_screen(self);
+
+    // A finished pass starts the next
+    uint32_t passes = world_model_bt_passes();
+    if (passes != data->bt_passes) {
+        data->bt_passes = passes;
+        data->loading = false;
+        uart_send_command("scan_bt");
     }
+    if (bt_store_generation() != data->view_generation) {
+        data->loading = false;
+    }
+
+    // Rebuild when the store changed, or now and then so silent devices age out
+    int64_t now = esp_timer_get_time();
+    if (now - data->view_time_us < VIEW_REFRESH_US) return;
+    if (bt_store_generation() == data->view_generation &&
+        now - data->view_time_us < (int64_t)BT_SCAN_MAX_AGE_MS * 1000 / 8) {
+        return;
+    }
+    refresh_view(data);
+    draw_screen(self);
 }
 
 static void on_key(screen_t *self, key_code_t key)
 {
     bt_scan_data_t *data = (bt_scan_data_t *)self->user_data;
-    int visible_rows = 6;
-    
+
+    int row;
+    switch (ui_typeahead_handle_key(&data->find, key, data->count, &row)) {
+        case UI_TYPEAHEAD_IGNORED:
+            break;
+        case UI_TYPEAHEAD_JUMP:
+            // Same pages as UP/DOWN
+            data->found = data->order[row];
+            data->scroll_offset = row - row % VISIBLE_ROWS;
+            draw_screen(self);
+            return;
+        default:
+            return;
+    }
+
     switch (key) {
         case KEY_UP:
             if (data->scroll_offset > 0) {
                 // Page jump up
-                data->scroll_offset -= visible_rows;
+                data->scroll_offset -= VISIBLE_ROWS;
                 if (data->scroll_offset < 0) data->scroll_offset = 0;
                 draw_screen(self);
-            } else if (data->device_count > visible_rows) {
-                int max_offset = ((data->device_count - 1) / visible_rows) * visible_rows;
+            } else if (data->count > VISIBLE_ROWS) {
+                int max_offset = ((data->count - 1) / VISIBLE_ROWS) * VISIBLE_ROWS;
                 data->scroll_offset = max_offset;
                 draw_screen(self);
             }
             break;
-            
+
         case KEY_DOWN:
-            if (data->scroll_offset + visible_rows < data->device_count) {
+            if (data->scroll_offset + VISIBLE_ROWS < data->count) {
                 // Page jump down - don't adjust back for partial pages
-                data->scroll_offset += visible_rows;
+                data->scroll_offset += VISIBLE_ROWS;
                 draw_screen(self);
-            } else if (data->device_count > visible_rows) {
+            } else if (data->count > VISIBLE_ROWS) {
                 data->scroll_offset = 0;
                 draw_screen(self);
             }
             break;
-            
+
+        case KEY_S:
+            data->sort = (bt_sort_t)((data->sort + 1) % BT_SORT_COUNT);
+            data->scroll_offset = 0;
+            refresh_view(data);
+            draw_screen(self);
+            break;
+
         case KEY_ESC:
         case KEY_Q:
         case KEY_BACKSPACE:
+            uart_send_command("stop");
             screen_manager_pop();
             break;
-            
+
         default:
             break;
     }
@@ -249,58 +225,49 @@ static void on_key(screen_t *self, key_code_t key)
 static void on_destroy(screen_t *self)
 {
     bt_scan_data_t *data = (bt_scan_data_t *)self->user_data;
-    
-    uart_clear_line_callback();
-    
-    if (data) {
-        free(data);
-    }
+    ui_typeahead_free(&data->find);
+    free(data);
 }
 
 screen_t* bt_scan_screen_create(void *params)
 {
     (void)params;
-    
+
     ESP_LOGI(TAG, "Creating BT scan screen...");
-    
+
+    if (bt_store_init() != ESP_OK) return NULL;
+
     screen_t *screen = screen_alloc();
     if (!screen) return NULL;
-    
+
     // Allocate user data
     bt_scan_data_t *data = calloc(1, sizeof(bt_scan_data_t));
     if (!data) {
         free(screen);
         return NULL;
     }
-    
+
     data->loading = true;
+    data->sort = BT_SORT_RSSI;
     data->self = screen;
-    
+    data->bt_passes = world_model_bt_passes();
+    data->found = -1;
+    ui_typeahead_init(&data->find, BT_STORE_MAX, device_name, data);
+    refresh_view(data);
+
     screen->user_data = data;
     screen->on_key = on_key;
     screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
     screen->on_tick = on_tick;
-    
-    // Register UART callback
-    uart_register_line_callback(uart_line_callback, data);
-    
-    // Send scan_bt command
+    screen->tick_on_uart = true;    // on_tick only acts on new passes and rows
+
+    // Send scan_bt command (repeated from on_tick after each pass)
     uart_send_command("scan_bt");
-    
+
     // Draw initial screen
     draw_screen(screen);
-    
+
     ESP_LOGI(TAG, "BT scan screen created");
     return screen;
 }
-
-
-
-
-
-
-
-
-
-
@@ -1,11 +1,17 @@
 /**
  * @file channel_time_settings_screen.c
  * @brief Channel time settings screen implementation
+ *
+ * Both values are read with pipelined requests; their progress goes
+ * through uart_progress (UART_OP_CHANNEL_TIME) so the loading view and
+ * the redraw when they arrive follow the shared progress events.
  */
 
 #include "channel_time_settings_screen.h"
 #include "uart_handler.h"
+#include "uart_progress.h"
 #include "text_ui.h"
+#include "ui_widget.h"
 #include "keyboard.h"
 #include "esp_log.h"
 #include <string.h>
@@ -35,8 +41,9 @@ typedef struct {
     bool loading;               // Waiting for UART responses
     int loading_count;          // How many responses we still expect
     bool saved;                 // Shows "Saved!" message
-    bool needs_redraw;          // Flag for deferred redraw from UART callback
     char status_msg[64];        // Error/status message
+    ui_progress_t progress;     // Loading view
+    uint32_t progress_seq;      // Last uart_progress sequence shown
 } channel_time_data_t;
 
 /**
@@ -93,65 +100,97 @@ static bool validate_values(channel_time_data_t *data)
 }
 
 /**
- * @brief UART response callback - runs in UART RX task context
+ * @brief Check for ESP-IDF log lines and memory reports from JanOS
+ */
+static bool is_log_line(const char *line)
+{
+    if (strlen(line) >= 3 &&
+        (line[0] == 'I' || line[0] == 'W' || line[0] == 'E' || line[0] == 'D') &&
+        line[1] == ' ' && line[2] == '(') {
+        return true;
+    }
+    return strstr(line, "[MEM]") != NULL;
+}
+
+/**
+ * @brief Reply handlers - run in UART RX task context
  * CRITICAL: DO NOT call display functions here!
+ * @return true once the value line has been parsed
  */
-static void on_uart_response(const char *line, void *user_data)
+static bool on_min_reply(const char *line, void *user_data)
 {
-    screen_t *self = (screen_t *)user_data;
-    channel_time_data_t *data = (channel_time_data_t *)self->user_data;
+    channel_time_data_t *data = (channel_time_data_t *)user_data;
+    if (is_log_line(line)) return false;
     
-    if (!line || data->loading_count <= 0) {
-        return;
-    }
+    int value = parse_integer_response(line);
+    if (value < 0) return false;
+    
+    data->min_value = value;
+    data->edited_min = value;
+    ESP_LOGI(TAG, "Parsed min: %d", value);
+    return true;
+}
+
+static bool on_max_reply(const char *line, void *user_data)
+{
+    channel_time_data_t *data = (channel_time_data_t *)user_data;
+    if (is_log_line(line)) return false;
     
-    ESP_LOGI(TAG, "Response: %s", line);
+    int value = parse_integer_response(line);
+    if (value < 0) return false;
     
-    // Parse response - we expect either "get min" or "get max" responses
-    if (strstr(line, "min") != NULL) {
-        int value = parse_integer_response(line);
-        if (value >= 0) {
-            data->min_value = value;
-            data->edited_min = value;
-            data->loading_count--;
-            ESP_LOGI(TAG, "Parsed min: %d", value);
-        }
-    } else if (strstr(line, "max") != NULL) {
-        int value = parse_integer_response(line);
-        if (value >= 0) {
-            data->max_value = value;
-            data->edited_max = value;
-            data->loading_count--;
-            ESP_LOGI(TAG, "Parsed max: %d", value);
-        }
+    data->max_value = value;
+    data->edited_max = value;
+    ESP_LOGI(TAG, "Parsed max: %d", value);
+    return true;
+}
+
+static void on_read_done(uart_request_status_t status, void *user_data)
+{
+    channel_time_data_t *data = (channel_time_data_t *)user_data;
+    uart_progress_record_t progress;
+    uart_progress_get(UART_OP_CHANNEL_TIME, &progress);
+    
+    if (status == UART_REQUEST_TIMEOUT) {
+        snprintf(data->status_msg, sizeof(data->status_msg), "No reply from board");
+        progress.failed++;
     } else {
-        // Try to parse as plain number if neither min/max in response
-        int value = parse_integer_response(line);
-        if (value >= 0 && data->loading_count > 0) {
-            // Assume first response is min, second is max
-            if (data->loading_count == 2) {
-                data->min_value = value;
-                data->edited_min = value;
-                data->loading_count--;
-                ESP_LOGI(TAG, "Parsed value as min: %d", value);
-            } else if (data->loading_count == 1) {
-                data->max_value = value;
-                data->edited_max = value;
-                data->loading_count--;
-                ESP_LOGI(TAG, "Parsed value as max: %d", value);
-            }
-        }
+        progress.done++;
     }
     
-    // If we got all responses, signal redraw
-    if (data->loading_count == 0) {
+    // Both replies in (or given up on); the event brings on_tick round
+    if (--data->loading_count <= 0) {
         data->loading = false;
-        data->status_msg[0] = '\0';
-        uart_clear_line_callback();
-        data->needs_redraw = true;
+        progress.state = progress.failed ? UART_PROGRESS_ERROR : UART_PROGRESS_DONE;
+    }
+    uart_progress_publish(&progress);
+}
+
+/**
+ * @brief Pipeline both reads; replies are matched to requests in order
+ */
+static void request_values(channel_time_data_t *data)
+{
+    const uart_request_t reads[] = {
+        { .cmd = "channel_time read min", .on_line = on_min_reply,
+          .on_done = on_read_done, .user_data = data },
+        { .cmd = "channel_time read max", .on_line = on_max_reply,
+          .on_done = on_read_done, .user_data = data },
+    };
+    
+    uart_cancel_requests(data);
+    data->loading = true;
+    data->loading_count = 2;  // We expect 2 responses
+    uart_progress_begin(UART_OP_CHANNEL_TIME, "Loading...", 2);
+    for (int i = 0; i < 2; i++) {
+        if (uart_request(&reads[i]) != ESP_OK) {
+            on_read_done(UART_REQUEST_TIMEOUT, data);
+        }
     }
 }
 
+static void draw_screen(screen_t *self);
+
 /**
  * @brief Periodic tick handler - runs in main task context
  * Safe place to call display functions!
@@ -160,9 +199,15 @@ static void on_tick(screen_t *self)
 {
     channel_time_data_t *data = (channel_time_data_t *)self->user_data;
     
-    if (data->needs_redraw) {
-        data->needs_redraw = false;
-        // Draw will be called by screen manager
+    uart_progress_record_t progress;
+    uint32_t seq = uart_progress_get(UART_OP_CHANNEL_TIME, &progress);
+    if (seq == data->progress_seq) return;
+    data->progress_seq = seq;
+    
+    if (data->loading) {
+        ui_progress_set(&data->progress, &progress);
+    } else {
+        draw_screen(self);
     }
 }
 
@@ -174,7 +219,9 @@ static void draw_screen(screen_t *self)
     ui_draw_title("Channel Time");
     
     if (data->loading) {
-        ui_print_center(3, "Loading...", UI_COLOR_DIMMED);
+        uart_progress_record_t progress;
+        uart_progress_get(UART_OP_CHANNEL_TIME, &progress);
+        ui_progress_set(&data->progress, &progress);
     } else {
         // Draw min field
         const char *min_label = "Min (ms):";
@@ -218,7 +265,6 @@ static void on_key(screen_t *self, key_code_t key)
     
     if (data->loading) {
         if (key == KEY_ESC || key == KEY_Q || key == KEY_BACKSPACE) {
-            uart_clear_line_callback();
             screen_manager_pop();
         }
         return;
@@ -307,10 +353,9 @@ static void on_key(screen_t *self, key_code_t key)
                 snprintf(cmd_min, sizeof(cmd_min), "channel_time set min %d", data->edited_min);
                 snprintf(cmd_max, sizeof(cmd_max), "channel_time set max %d", data->edited_max);
                 
-                esp_err_t ret1 = uart_send_command(cmd_min);
-                esp_err_t ret2 = uart_send_command(cmd_max);
+                const char *const sets[] = { cmd_min, cmd_max };
                 
-                if (ret1 == ESP_OK && ret2 == ESP_OK) {
+                if (uart_send_batch(sets, 2, NULL, NULL) == ESP_OK) {
                     data->min_value = data->edited_min;
                     data->max_value = data->edited_max;
                     data->saved = true;
@@ -327,7 +372,6 @@ static void on_key(screen_t *self, key_code_t key)
         case KEY_ESC:
         case KEY_Q:
         case KEY_BACKSPACE:
-            uart_clear_line_callback();
             screen_manager_pop();
             break;
             
@@ -338,8 +382,8 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
-    uart_clear_line_callback();
     if (self->user_data) {
+        uart_cancel_requests(self->user_data);
         free(self->user_data);
     }
 }
@@ -349,17 +393,10 @@ static void on_resume(screen_t *self)
     channel_time_data_t *data = (channel_time_data_t *)self->user_data;
     
     // Reset state and request current values
-    data->loading = true;
-    data->loading_count = 2;  // We expect 2 responses
     data->saved = false;
-    data->needs_redraw = false;
     data->status_msg[0] = '\0';
     data->selected_field = FIELD_MIN;
-    
-    // Register callback and send commands
-    uart_register_line_callback(on_uart_response, self);
-    uart_send_command("channel_time read min");
-    uart_send_command("channel_time read max");
+    request_values(data);
     
     draw_screen(self);
 }
@@ -390,8 +427,8 @@ screen_t* channel_time_settings_screen_create(void *params)
     data->loading = true;
     data->loading_count = 2;
     data->saved = false;
-    data->needs_redraw = false;
     data->status_msg[0] = '\0';
+    ui_progress_init(&data->progress, 3);
     
     screen->user_data = data;
     screen->on_key = on_key;
@@ -401,9 +438,7 @@ screen_t* channel_time_settings_screen_create(void *params)
     screen->on_tick = on_tick;
     
     // Load initial values
-    uart_register_line_callback(on_uart_response, screen);
-    uart_send_command("channel_time read min");
-    uart_send_command("channel_time read max");
+    request_values(data);
     
     draw_screen(screen);
     
@@ -0,0 +1,322 @@
+/**
+ * @file channel_usage_screen.c
+ * @brief Per-channel AP and client counts as a bar chart
+ *
+ * One band at a time: per channel, a bar of the APs in the network store
+ * colored by the strongest RSSI, and beside it a bar of the clients the
+ * sniffer last listed on that channel (world_model). Rows are counted as
+ * they stream in; a finished rescan moves RSSI and channels of rows
+ * already counted, so it recounts the store. Bars are retained widgets,
+ * so a tick repaints only the strips that changed. P splits the channels
+ * across the attached boards from these counts (channel_plan).
+ */
+
+#include "channel_usage_screen.h"
+#include "screen_registry.h"
+#include "network_store.h"
+#include "world_model.h"
+#include "channel_plan.h"
+#include "uart_handler.h"
+#include "text_ui.h"
+#include "ui_widget.h"
+#include "esp_log.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "CH_USAGE";
+
+#define CELL_H          (DISPLAY_HEIGHT / UI_ROWS)
+#define CHART_Y         (CELL_H + 4)
+#define CHART_H         (4 * CELL_H - 4)
+#define CURSOR_Y        (CHART_Y + CHART_H + 2)
+#define CURSOR_H        3
+#define DETAIL_ROW      6
+#define MIN_SCALE       4       // Bars never scale below this many
+
+#define COLOR_CLIENTS   RGB565(80, 160, 255)
+#define COLOR_RSSI_GOOD UI_COLOR_HIGHLIGHT
+#define COLOR_RSSI_FAIR RGB565(255, 200, 0)
+#define COLOR_RSSI_POOR RGB565(255, 80, 0)
+
+static const uint8_t channels_2g[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14 };
+static const uint8_t channels_5g[] = {
+    36, 40, 44, 48, 52, 56, 60, 64, 100, 104, 108, 112, 116,
+    120, 124, 128, 132, 136, 140, 144, 149, 153, 157, 161, 165,
+};
+
+typedef struct {
+    const char *name;
+    const uint8_t *channels;
+    int count;
+} band_t;
+
+static const band_t bands[] = {
+    { "2.4G", channels_2g, sizeof(channels_2g) },
+    { "5G", channels_5g, sizeof(channels_5g) },
+};
+#define BAND_COUNT  (sizeof(bands) / sizeof(bands[0]))
+
+// Aggregate per channel number
+typedef struct {
+    uint16_t aps;
+    int8_t best_rssi;
+} channel_stat_t;
+
+// Screen user data
+typedef struct {
+    channel_stat_t stats[256];
+    int counted;                // Store records folded into stats
+    uint32_t passes;            // network_store_passes() the counts are from
+    int band;                   // bands[] index
+    int cursor;                 // Channel index within the band
+    int drawn_cursor;           // Marker on screen, -1 = none
+    uint32_t drawn_generation;  // ui_clear generation of the marker
+    ui_bars_t ap_bars;
+    ui_bars_t client_bars;
+    ui_label_t detail;
+    channel_plan_t plan;
+    bool planned;               // plan was applied, detail shows boards
+    char title[32];
+} channel_usage_data_t;
+
+static void count_record(channel_usage_data_t *data, int index)
+{
+    const network_record_t *rec = network_store_record(index);
+    if (!rec || (rec->flags & NETWORK_FLAG_STALE)) return;
+    
+    channel_stat_t *s = &data->stats[rec->channel];
+    if (s->aps == 0 || rec->rssi > s->best_rssi) s->best_rssi = rec->rssi;
+    s->aps++;
+}
+
+/**
+ * @brief Fold in rows that arrived since the last tick
+ */
+static void update_counts(channel_usage_data_t *data)
+{
+    int count = network_store_count();
+    uint32_t passes = network_store_passes();
+    if (passes != data->passes || count < data->counted) {
+        memset(data->stats, 0, sizeof(data->stats));
+        data->counted = 0;
+        data->passes = passes;
+    }
+    
+    for (; data->counted < count; data->counted++) {
+        count_record(data, data->counted);
+    }
+}
+
+static uint16_t rssi_color(int8_t rssi)
+{
+    if (rssi >= -60) return COLOR_RSSI_GOOD;
+    if (rssi >= -75) return COLOR_RSSI_FAIR;
+    return COLOR_RSSI_POOR;
+}
+
+/**
+ * @brief Lay out both bar charts for the current band
+ */
+static void layout_band(channel_usage_data_t *data)
+{
+    const band_t *band = &bands[data->band];
+    int pitch = DISPLAY_WIDTH / band->count;
+    int x = (DISPLAY_WIDTH - band->count * pitch) / 2;
+    int client_w = pitch / 3;
+    int ap_w = pitch - client_w - 1;
+    
+    ui_bars_init(&data->ap_bars, x, CHART_Y, CHART_H, pitch, ap_w,
+                 band->count, MIN_SCALE, UI_COLOR_BG);
+    ui_bars_init(&data->client_bars, x + ap_w, CHART_Y, CHART_H, pitch, client_w,
+                 band->count, MIN_SCALE, UI_COLOR_BG);
+    if (data->cursor >= band->count) data->cursor = band->count - 1;
+    data->drawn_cursor = -1;
+}
+
+static void draw_cursor(channel_usage_data_t *data)
+{
+    // Marker under the chart; ui_clear() took the old one with it
+    if (data->drawn_generation != ui_get_clear_generation()) data->drawn_cursor = -1;
+    if (data->drawn_cursor == data->cursor) return;
+    
+    const ui_bars_t *bars = &data->ap_bars;
+    int width = bars->pitch - 1;
+    if (data->drawn_cursor >= 0) {
+        display_fill_rect(bars->x + data->drawn_cursor * bars->pitch, CURSOR_Y,
+                          width, CURSOR_H, UI_COLOR_BG);
+    }
+    display_fill_rect(bars->x + data->cursor * bars->pitch, CURSOR_Y,
+                      width, CURSOR_H, UI_COLOR_TEXT);
+    data->drawn_cursor = data->cursor;
+    data->drawn_generation = ui_get_clear_generation();
+}
+
+/**
+ * @brief Bring title, bars, marker and detail line up to date
+ */
+static void refresh(channel_usage_data_t *data)
+{
+    const band_t *band = &bands[data->band];
+    
+    int total = 0, max_aps = MIN_SCALE, max_clients = MIN_SCALE;
+    for (int i = 0; i < band->count; i++) {
+        uint8_t ch = band->channels[i];
+        int clients = world_model_channel_clients(ch);
+        total += data->stats[ch].aps;
+        if (data->stats[ch].aps > max_aps) max_aps = data->stats[ch].aps;
+        if (clients > max_clients) max_clients = clients;
+    }
+    
+    char title[sizeof(data->title)];
+    snprintf(title, sizeof(title), "Channels %s: %d APs%s", band->name, total,
+             uart_is_scanning() ? "*" : "");
+    if (strcmp(title, data->title) != 0) {
+        strcpy(data->title, title);
+        ui_draw_title(title);
+    }
+    
+    ui_bars_set_max(&data->ap_bars, max_aps);
+    ui_bars_set_max(&data->client_bars, max_clients);
+    for (int i = 0; i < band->count; i++) {
+        const channel_stat_t *s = &data->stats[band->channels[i]];
+        ui_bars_set(&data->ap_bars, i, s->aps, rssi_color(s->best_rssi));
+        ui_bars_set(&data->client_bars, i, world_model_channel_clients(band->channels[i]),
+                    COLOR_CLIENTS);
+    }
+    draw_cursor(data);
+    
+    uint8_t ch = band->channels[data->cursor];
+    const channel_stat_t *s = &data->stats[ch];
+    char detail[UI_COLS + 1];
+    int len;
+    if (s->aps) {
+        len = snprintf(detail, sizeof(detail), "Ch%u: %u AP %ddBm %d cl", ch, s->aps,
+                       s->best_rssi, world_model_channel_clients(ch));
+    } else {
+        len = snprintf(detail, sizeof(detail), "Ch%u: no APs %d cl", ch,
+                       world_model_channel_clients(ch));
+    }
+    if (data->planned && data->plan.board_of[ch] != CHANNEL_PLAN_NONE &&
+        len < (int)sizeof(detail)) {
+        snprintf(detail + len, sizeof(detail) - len, " B%d", data->plan.board_of[ch] + 1);
+    }
+    ui_label_set(&data->detail, detail);
+}
+
+static void draw_screen(screen_t *self)
+{
+    channel_usage_data_t *data = (channel_usage_data_t *)self->user_data;
+    
+    ui_clear();
+    data->title[0] = '\0';
+    refresh(data);
+    ui_draw_status("</>:Ch B:Band R:Scan P:Plan");
+}
+
+static void on_tick(screen_t *self)
+{
+    channel_usage_data_t *data = (channel_usage_data_t *)self->user_data;
+    
+    // Client totals change without store rows, so every tick refreshes;
+    // unchanged bars and text cost nothing
+    update_counts(data);
+    refresh(data);
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    channel_usage_data_t *data = (channel_usage_data_t *)self->user_data;
+    const band_t *band = &bands[data->band];
+    
+    switch (key) {
+        case KEY_LEFT:
+        case KEY_UP:
+            data->cursor = (data->cursor + band->count - 1) % band->count;
+            refresh(data);
+            break;
+            
+        case KEY_RIGHT:
+        case KEY_DOWN:
+            data->cursor = (data->cursor + 1) % band->count;
+            refresh(data);
+            break;
+            
+        case KEY_B:
+        case KEY_TAB:
+            data->band = (data->band + 1) % BAND_COUNT;
+            layout_band(data);
+            draw_screen(self);
+            break;
+            
+        case KEY_R:
+            // Merges into the store, so the counts only move
+            if (!uart_is_scanning()) uart_refresh_wifi_scan(NULL, NULL, NULL);
+            break;
+            
+        case KEY_P:
+            // Weighted by what is counted now; rebuild after a rescan
+            channel_plan_build_connected(&data->plan);
+            data->planned = channel_plan_apply(&data->plan) == ESP_OK;
+            refresh(data);
+            break;
+            
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    free(self->user_data);
+}
+
+static void on_resume(screen_t *self)
+{
+    draw_screen(self);
+}
+
+screen_t* channel_usage_screen_create(void *params)
+{
+    (void)params;
+    
+    ESP_LOGI(TAG, "Creating channel usage screen...");
+    
+    screen_t *screen = screen_alloc();
+    if (!screen) return NULL;
+    
+    channel_usage_data_t *data = calloc(1, sizeof(channel_usage_data_t));
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    ui_label_init(&data->detail, 0, DETAIL_ROW, UI_COLS, UI_ALIGN_LEFT, UI_COLOR_TEXT, UI_COLOR_BG);
+    layout_band(data);
+    update_counts(data);
+    
+    // Nothing scanned yet: start one, rows are counted as they arrive
+    if (network_store_count() == 0 && !uart_is_scanning()) {
+        uart_refresh_wifi_scan(NULL, NULL, NULL);
+    }
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_resume = on_resume;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    screen->tick_on_uart = true;    // on_tick only repaints what changed
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "Channel usage screen created");
+    return screen;
+}
+
+SCREEN_REGISTER(HOME, 15, channel_usage_screen_create, 0, "WiFi Channel Usage", NULL);
@@ -0,0 +1,18 @@
+/**
+ * @file channel_usage_screen.h
+ * @brief Per-channel AP and client counts as a bar chart
+ */
+
+#ifndef CHANNEL_USAGE_SCREEN_H
+#define CHANNEL_USAGE_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the channel usage screen
+ * @param params Unused
+ * @return Created screen or NULL on failure
+ */
+screen_t* channel_usage_screen_create(void *params);
+
+#endif // CHANNEL_USAGE_SCREEN_H
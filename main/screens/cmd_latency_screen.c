@@ -0,0 +1,203 @@
+/**
+ * @file cmd_latency_screen.c
+ * @brief Per-command reply latency of the JanOS link
+ *
+ * One row per command word, most used first: median time to the first
+ * reply line and median time to completion. The rows above the status
+ * bar show p90, maximum and unanswered count of the selected command.
+ * Medians and p90 are bucket bounds of the log2 histograms (cmd_latency),
+ * so "<8ms" means between 4 and 8 ms. D writes the histograms to
+ * CMD_LATENCY_FILE.
+ */
+
+#include "cmd_latency_screen.h"
+#include "cmd_latency.h"
+#include "text_ui.h"
+#include "ui_list.h"
+#include "keyboard.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+static const char *TAG = "CMD_LAT_SCR";
+
+// Detail rows above the status bar
+#define DETAIL_ROWS         2
+
+// Refresh interval while open
+#define REFRESH_INTERVAL_US 1000000
+
+// Screen user data
+typedef struct {
+    ui_list_t list;
+    cmd_latency_entry_t entries[CMD_LATENCY_COMMANDS];
+    int64_t last_refresh_us;
+} cmd_latency_data_t;
+
+/**
+ * @brief "850us", "12ms", "4.2s"; "-" without samples, ">4s" past the top bucket
+ */
+static void format_us(char *buf, size_t len, uint32_t us, const char *prefix)
+{
+    if (us == 0) {
+        snprintf(buf, len, "-");
+    } else if (us == UINT32_MAX) {
+        snprintf(buf, len, ">%lus",
+                 (unsigned long)(((uint32_t)CMD_LATENCY_BASE_US << (CMD_LATENCY_BUCKETS - 2)) / 1000000));
+    } else if (us < 1000) {
+        snprintf(buf, len, "%s%luus", prefix, (unsigned long)us);
+    } else if (us < 1000000) {
+        snprintf(buf, len, "%s%lums", prefix, (unsigned long)(us / 1000));
+    } else {
+        snprintf(buf, len, "%s%lu.%lus", prefix, (unsigned long)(us / 1000000),
+                 (unsigned long)(us / 100000 % 10));
+    }
+}
+
+static void entry_row(int index, char *text, size_t len, void *user_data)
+{
+    cmd_latency_data_t *data = (cmd_latency_data_t *)user_data;
+    const cmd_latency_hist_t *h = &data->entries[index].hist;
+    char first[12], done[12];
+    
+    format_us(first, sizeof(first), cmd_latency_percentile(h->first_hist, 500), "<");
+    format_us(done, sizeof(done), cmd_latency_percentile(h->done_hist, 500), "<");
+    snprintf(text, len, "%-13.13s %7s %7s", data->entries[index].name, first, done);
+}
+
+static void load(cmd_latency_data_t *data)
+{
+    int count = cmd_latency_get(data->entries, CMD_LATENCY_COMMANDS);
+    ui_list_set_count(&data->list, count);
+    data->last_refresh_us = esp_timer_get_time();
+}
+
+static void draw_detail(const cmd_latency_data_t *data)
+{
+    int first_row = ui_rows() - 1 - DETAIL_ROWS;
+    char lines[DETAIL_ROWS][UI_COLS_MAX + 1] = { "", "" };
+    
+    if (data->list.count > 0) {
+        const cmd_latency_hist_t *h = &data->entries[data->list.selected].hist;
+        char p90[12], max[12];
+        format_us(p90, sizeof(p90), cmd_latency_percentile(h->first_hist, 900), "<");
+        format_us(max, sizeof(max), h->first_max_us, "");
+        snprintf(lines[0], sizeof(lines[0]), "1st p90 %s max %s  n %lu", p90, max,
+                 (unsigned long)h->count);
+        format_us(p90, sizeof(p90), cmd_latency_percentile(h->done_hist, 900), "<");
+        format_us(max, sizeof(max), h->done_max_us, "");
+        snprintf(lines[1], sizeof(lines[1]), "end p90 %s max %s  no %lu", p90, max,
+                 (unsigned long)h->unanswered);
+    }
+    
+    for (int i = 0; i < DETAIL_ROWS; i++) {
+        char padded[UI_COLS_MAX + 1];
+        snprintf(padded, sizeof(padded), " %-*.*s", ui_cols() - 1, ui_cols() - 1, lines[i]);
+        ui_print(0, first_row + i, padded, UI_COLOR_DIMMED);
+    }
+}
+
+static void draw_screen(screen_t *self)
+{
+    cmd_latency_data_t *data = (cmd_latency_data_t *)self->user_data;
+    
+    ui_clear();
+    ui_draw_title("Command    1st median  end");
+    
+    if (data->list.count == 0) {
+        ui_print_center(ui_rows() / 2 - 1, "No commands timed yet", UI_COLOR_DIMMED);
+    } else {
+        ui_list_draw(&data->list);
+        draw_detail(data);
+    }
+    
+    ui_draw_status("D:Dump to SD R:Reset");
+}
+
+static void on_tick(screen_t *self)
+{
+    cmd_latency_data_t *data = (cmd_latency_data_t *)self->user_data;
+    
+    if (esp_timer_get_time() - data->last_refresh_us < REFRESH_INTERVAL_US) return;
+    load(data);
+    ui_list_draw(&data->list);
+    if (data->list.count > 0) {
+        draw_detail(data);
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    cmd_latency_data_t *data = (cmd_latency_data_t *)self->user_data;
+    
+    if (ui_list_handle_key(&data->list, key)) {
+        ui_list_draw(&data->list);
+        draw_detail(data);
+        return;
+    }
+    
+    switch (key) {
+        case KEY_D: {
+            esp_err_t ret = cmd_latency_dump();
+            ui_draw_status(ret == ESP_OK ? "Saved cmd_latency.csv" :
+                           ret == ESP_ERR_INVALID_STATE ? "No SD card" : "Write failed");
+            break;
+        }
+            
+        case KEY_R:
+            cmd_latency_reset();
+            load(data);
+            draw_screen(self);
+            break;
+            
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    free(self->user_data);
+}
+
+static void on_resume(screen_t *self)
+{
+    draw_screen(self);
+}
+
+screen_t* cmd_latency_screen_create(void *params)
+{
+    (void)params;
+    
+    ESP_LOGI(TAG, "Creating command latency screen...");
+    
+    screen_t *screen = screen_alloc();
+    cmd_latency_data_t *data = screen ? calloc(1, sizeof(cmd_latency_data_t)) : NULL;
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    ui_list_init(&data->list, 1, ui_rows() - 2 - DETAIL_ROWS, entry_row, data);
+    load(data);
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_resume = on_resume;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "Command latency screen created");
+    return screen;
+}
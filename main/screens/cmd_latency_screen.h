@@ -0,0 +1,18 @@
+/**
+ * @file cmd_latency_screen.h
+ * @brief Per-command reply latency of the JanOS link
+ */
+
+#ifndef CMD_LATENCY_SCREEN_H
+#define CMD_LATENCY_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the command latency screen
+ * @param params Unused
+ * @return Screen instance
+ */
+screen_t* cmd_latency_screen_create(void *params);
+
+#endif // CMD_LATENCY_SCREEN_H
@@ -4,9 +4,11 @@
  */
 
 #include "compromised_menu_screen.h"
+#include "screen_registry.h"
 #include "evil_twin_passwords_screen.h"
 #include "portal_data_screen.h"
 #include "handshakes_screen.h"
+#include "listing_prefetch.h"
 #include "text_ui.h"
 #include "esp_log.h"
 #include <string.h>
@@ -17,12 +19,13 @@ static const char *TAG = "COMPROMISED_MENU";
 typedef struct {
     const char *title;
     screen_create_fn create_fn;
+    listing_t listing;          // Fetched while the item is highlighted
 } menu_item_t;
 
 static const menu_item_t menu_items[] = {
-    {"Evil Twin Passwords", evil_twin_passwords_screen_create},
-    {"Portal Data", portal_data_screen_create},
-    {"Handshakes", handshakes_screen_create},
+    {"Evil Twin Passwords", evil_twin_passwords_screen_create, LISTING_EVIL_TWIN_PASSWORDS},
+    {"Portal Data", portal_data_screen_create, LISTING_PORTAL_DATA},
+    {"Handshakes", handshakes_screen_create, LISTING_HANDSHAKES},
 };
 
 #define MENU_ITEM_COUNT (sizeof(menu_items) / sizeof(menu_items[0]))
@@ -57,6 +60,7 @@ static void redraw_selection(compromised_menu_data_t *data, int old_index, int n
     ui_draw_menu_item(old_index + 1, menu_items[old_index].title, false, false, false);
     // Redraw new selection (now selected)
     ui_draw_menu_item(new_index + 1, menu_items[new_index].title, true, false, false);
+    listing_prefetch_hover(menu_items[new_index].listing);
 }
 
 static void on_key(screen_t *self, key_code_t key)
@@ -92,6 +96,7 @@ static void on_key(screen_t *self, key_code_t key)
         case KEY_SPACE:
             {
                 const menu_item_t *item = &menu_items[data->selected_index];
+                listing_prefetch_cancel();
                 if (item->create_fn) {
                     screen_manager_push(item->create_fn, NULL);
                     // Immediately trigger first draw of new screen
@@ -113,6 +118,7 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
+    listing_prefetch_cancel();
     if (self->user_data) {
         free(self->user_data);
     }
@@ -120,7 +126,9 @@ static void on_destroy(screen_t *self)
 
 static void on_resume(screen_t *self)
 {
+    compromised_menu_data_t *data = (compromised_menu_data_t *)self->user_data;
     draw_screen(self);
+    listing_prefetch_hover(menu_items[data->selected_index].listing);
 }
 
 screen_t* compromised_menu_screen_create(void *params)
@@ -147,10 +155,10 @@ screen_t* compromised_menu_screen_create(void *params)
     
     // Draw initial screen
     draw_screen(screen);
+    listing_prefetch_hover(menu_items[0].listing);
     
     ESP_LOGI(TAG, "Compromised menu screen created");
     return screen;
 }
 
-
-
+SCREEN_REGISTER(HOME, 60, compromised_menu_screen_create, 0, "Compromised data", NULL);
@@ -0,0 +1,375 @@
+/**
+ * @file dashboard_screen.c
+ * @brief Live overview for unattended collection
+ *
+ * Panes, each a set of retained widgets with its own refresh period:
+ *
+ *   row 1    APs in network_store and how many appeared in the last minute
+ *   row 2    distinct clients (metrics_store)
+ *   rows 3-4 deauth detections per second and their last two minutes
+ *   row 5    CAP GPS fix, satellites and speed (JanOS fix state without it)
+ *   row 6    JanOS link throughput and rate, battery level
+ *
+ * A pane refreshes when its period comes round, or sooner when a bus
+ * event concerns it (a new AP, a fix gained or lost, the link renegotiated),
+ * but never more often than DASH_MIN_GAP_US. Widgets repaint only the
+ * cells that changed, so a quiet pane costs a counter read per period and
+ * no display traffic. Counts that need history (new APs, clients,
+ * deauths per second, link bytes) are read from metrics_store, which
+ * already takes them off the bus once a second; the dashboard's own bus
+ * queue only carries the events that make a pane refresh early.
+ */
+
+#include "dashboard_screen.h"
+#include "screen_registry.h"
+#include "event_bus.h"
+#include "metrics_store.h"
+#include "network_store.h"
+#include "uart_handler.h"
+#include "text_ui.h"
+#include "ui_widget.h"
+#include "display.h"
+#include "battery.h"
+#include "cap_gps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "DASHBOARD";
+
+#define DASH_TICK_MS        100     // Pane deadlines are checked this often
+#define DASH_MIN_GAP_US     250000  // An event-driven refresh comes no sooner
+#define DASH_BUS_DEPTH      8       // Events waiting for on_tick (only wake-ups)
+#define DASH_NEW_AP_WINDOW  60      // Seconds behind the "+N/min" figure
+
+// Deauth graph on rows 3-4, right of its labels
+#define DEAUTH_LABEL_COLS   11
+#define DEAUTH_SPARK_FULL   10      // Detections per second drawn as a full bar
+
+typedef enum {
+    PANE_APS = 0,
+    PANE_CLIENTS,
+    PANE_DEAUTH,
+    PANE_GPS,
+    PANE_LINK,
+    PANE_BATTERY,
+    PANE_COUNT
+} pane_id_t;
+
+typedef struct dashboard_data dashboard_data_t;
+
+typedef struct {
+    uint32_t period_ms;
+    void (*refresh)(dashboard_data_t *data);
+} pane_def_t;
+
+// Pane state: when it next refreshes, whether an event asked for it sooner
+typedef struct {
+    int64_t due_us;
+    int64_t last_us;
+    bool dirty;
+} pane_t;
+
+struct dashboard_data {
+    int bus_handle;
+    pane_t panes[PANE_COUNT];
+    bool layout_drawn;
+    uint32_t layout_generation;
+    // APs
+    ui_label_t aps;
+    ui_label_t new_aps;
+    // Clients
+    ui_label_t clients;
+    // Deauth
+    ui_label_t deauth_rate;
+    ui_label_t deauth_total;
+    ui_history_t deauth_history;
+    ui_sparkline_t deauth_spark;
+    uint32_t metrics_generation;    // Last metrics sample taken into the history
+    uint32_t deauth_count;          // Since the dashboard opened
+    // GPS
+    ui_label_t gps;
+    bool janos_fix;
+    bool janos_fix_known;
+    // Link
+    ui_label_t link;
+    bus_link_state_t link_state;
+    // Battery
+    ui_label_t battery;
+};
+
+/**
+ * @brief Newest 1 s point of a metric
+ * @return false until the store has sampled it
+ */
+static bool latest_metric(metric_id_t id, metrics_point_t *out)
+{
+    return metrics_store_read(id, METRICS_RES_1S, out, 1) == 1;
+}
+
+static void refresh_aps(dashboard_data_t *data)
+{
+    char text[UI_COLS + 1];
+    snprintf(text, sizeof(text), "APs %d", network_store_count());
+    ui_label_set(&data->aps, text);
+
+    // Stored count now against DASH_NEW_AP_WINDOW seconds ago
+    metrics_point_t points[DASH_NEW_AP_WINDOW + 1];
+    int n = metrics_store_read(METRIC_APS, METRICS_RES_1S, points, DASH_NEW_AP_WINDOW + 1);
+    if (n < 2) {
+        ui_label_set(&data->new_aps, NULL);
+        return;
+    }
+    int32_t added = points[n - 1].max - points[0].min;
+    snprintf(text, sizeof(text), "+%ld/min", (long)(added > 0 ? added : 0));
+    ui_label_set(&data->new_aps, text);
+}
+
+static void refresh_clients(dashboard_data_t *data)
+{
+    metrics_point_t point;
+    char text[UI_COLS + 1];
+    if (latest_metric(METRIC_CLIENTS, &point)) {
+        snprintf(text, sizeof(text), "Clients %ld", (long)point.max);
+    } else {
+        snprintf(text, sizeof(text), "Clients -");
+    }
+    ui_label_set(&data->clients, text);
+}
+
+static void refresh_deauth(dashboard_data_t *data)
+{
+    // Every second sampled since the last refresh, zeros included, so the
+    // sweep keeps moving
+    uint32_t generation = metrics_store_generation();
+    uint32_t missed = generation - data->metrics_generation;
+    if (missed > METRICS_RING_1S) missed = METRICS_RING_1S;
+    data->metrics_generation = generation;
+    if (missed > 0) {
+        metrics_point_t points[METRICS_RING_1S];
+        int n = metrics_store_read(METRIC_DEAUTHS, METRICS_RES_1S, points, (int)missed);
+        for (int i = 0; i < n; i++) {
+            int32_t count = points[i].max;
+            data->deauth_count += (uint32_t)count;
+            ui_history_push(&data->deauth_history, (int8_t)(count > INT8_MAX ? INT8_MAX : count));
+        }
+    }
+
+    char text[UI_COLS + 1];
+    int8_t newest = ui_history_get(&data->deauth_history, 0);
+    snprintf(text, sizeof(text), "Deauth %d/s", newest == UI_HISTORY_NONE ? 0 : newest);
+    ui_label_set(&data->deauth_rate, text);
+    snprintf(text, sizeof(text), "total %lu", (unsigned long)data->deauth_count);
+    ui_label_set(&data->deauth_total, text);
+    ui_sparkline_update(&data->deauth_spark, &data->deauth_history);
+}
+
+static void refresh_gps(dashboard_data_t *data)
+{
+    char text[UI_COLS + 1];
+    cap_gps_snapshot_t gps;
+    if (cap_gps_get_snapshot(&gps)) {
+        if (gps.fix) {
+            snprintf(text, sizeof(text), "GPS %dD %dsat %ld.%ldkm/h",
+                     gps.fix_mode == 3 ? 3 : 2, gps.satellites,
+                     (long)(gps.speed_kmh_x10 / 10), (long)(gps.speed_kmh_x10 % 10));
+        } else {
+            snprintf(text, sizeof(text), "GPS no fix, %d in view",
+                     gps.satellites_in_view < 0 ? 0 : gps.satellites_in_view);
+        }
+    } else if (data->janos_fix_known) {
+        snprintf(text, sizeof(text), "GPS JanOS %s", data->janos_fix ? "fix" : "no fix");
+    } else {
+        snprintf(text, sizeof(text), "GPS -");
+    }
+    ui_label_set(&data->gps, text);
+}
+
+static void refresh_link(dashboard_data_t *data)
+{
+    metrics_point_t point;
+    char text[UI_COLS + 1];
+    if (!data->link_state.up) {
+        snprintf(text, sizeof(text), "Link down");
+    } else {
+        long bps = latest_metric(METRIC_LINK_BPS, &point) ? (long)point.avg : 0;
+        snprintf(text, sizeof(text), "Link %ld.%ldK/s %luk %s", bps / 1024, bps % 1024 * 10 / 1024,
+                 (unsigned long)(data->link_state.baud / 1000), data->link_state.binary ? "bin" : "txt");
+    }
+    ui_label_set(&data->link, text);
+}
+
+static void refresh_battery(dashboard_data_t *data)
+{
+    char text[UI_COLS + 1];
+    int level = battery_get_level();
+    if (level < 0) {
+        snprintf(text, sizeof(text), "Bat -");
+    } else {
+        snprintf(text, sizeof(text), "Bat %d%%", level);
+    }
+    ui_label_set(&data->battery, text);
+}
+
+static const pane_def_t pane_defs[PANE_COUNT] = {
+    [PANE_APS]     = { 1000,  refresh_aps },
+    [PANE_CLIENTS] = { 1000,  refresh_clients },
+    [PANE_DEAUTH]  = { 1000,  refresh_deauth },
+    [PANE_GPS]     = { 500,   refresh_gps },
+    [PANE_LINK]    = { 1000,  refresh_link },
+    [PANE_BATTERY] = { 10000, refresh_battery },
+};
+
+static void refresh_pane(dashboard_data_t *data, pane_id_t id, int64_t now)
+{
+    pane_t *pane = &data->panes[id];
+    pane_defs[id].refresh(data);
+    pane->dirty = false;
+    pane->last_us = now;
+    pane->due_us = now + pane_defs[id].period_ms * 1000LL;
+}
+
+static void draw_screen(screen_t *self)
+{
+    dashboard_data_t *data = (dashboard_data_t *)self->user_data;
+
+    // Static chrome only after a clear; the widgets then repaint in full
+    if (!data->layout_drawn || data->layout_generation != ui_get_clear_generation()) {
+        ui_clear();
+        ui_draw_title("Dashboard");
+        ui_draw_status("ESC:Back");
+        data->layout_generation = ui_get_clear_generation();
+        data->layout_drawn = true;
+    }
+
+    int64_t now = esp_timer_get_time();
+    for (int i = 0; i < PANE_COUNT; i++) {
+        refresh_pane(data, (pane_id_t)i, now);
+    }
+}
+
+/**
+ * @brief Note a bus event and mark the panes it concerns
+ */
+static void take_event(dashboard_data_t *data, const bus_event_t *event)
+{
+    switch (event->type) {
+        case BUS_EVENT_NETWORK_SEEN:
+            data->panes[PANE_APS].dirty = true;
+            break;
+        case BUS_EVENT_GPS_FIX:
+            data->janos_fix = event->gps.fix;
+            data->janos_fix_known = true;
+            data->panes[PANE_GPS].dirty = true;
+            break;
+        case BUS_EVENT_LINK_STATE:
+            data->link_state = event->link;
+            data->panes[PANE_LINK].dirty = true;
+            break;
+        default:
+            break;
+    }
+}
+
+static void on_tick(screen_t *self)
+{
+    dashboard_data_t *data = (dashboard_data_t *)self->user_data;
+
+    bus_event_t event;
+    while (event_bus_receive(data->bus_handle, &event, 0)) {
+        take_event(data, &event);
+    }
+
+    int64_t now = esp_timer_get_time();
+    for (int i = 0; i < PANE_COUNT; i++) {
+        pane_t *pane = &data->panes[i];
+        bool due = now >= pane->due_us;
+        bool early = pane->dirty && now - pane->last_us >= DASH_MIN_GAP_US;
+        if (due || early) refresh_pane(data, (pane_id_t)i, now);
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    (void)self;
+    switch (key) {
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    dashboard_data_t *data = (dashboard_data_t *)self->user_data;
+    if (data) {
+        event_bus_unsubscribe(data->bus_handle);
+        free(data);
+    }
+}
+
+screen_t* dashboard_screen_create(void *params)
+{
+    (void)params;
+    ESP_LOGI(TAG, "Creating dashboard screen...");
+
+    screen_t *screen = screen_alloc();
+    dashboard_data_t *data = screen ? calloc(1, sizeof(dashboard_data_t)) : NULL;
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+
+    int half = UI_COLS / 2;
+    ui_label_init(&data->aps, 0, 1, half, UI_ALIGN_LEFT, UI_COLOR_TEXT, UI_COLOR_BG);
+    ui_label_init(&data->new_aps, half, 1, UI_COLS - half, UI_ALIGN_RIGHT, UI_COLOR_HIGHLIGHT, UI_COLOR_BG);
+    ui_label_init(&data->clients, 0, 2, UI_COLS, UI_ALIGN_LEFT, UI_COLOR_TEXT, UI_COLOR_BG);
+    ui_label_init(&data->deauth_rate, 0, 3, DEAUTH_LABEL_COLS, UI_ALIGN_LEFT, UI_COLOR_TEXT, UI_COLOR_BG);
+    ui_label_init(&data->deauth_total, 0, 4, DEAUTH_LABEL_COLS, UI_ALIGN_LEFT, UI_COLOR_DIMMED, UI_COLOR_BG);
+    ui_label_init(&data->gps, 0, 5, UI_COLS, UI_ALIGN_LEFT, UI_COLOR_TEXT, UI_COLOR_BG);
+    ui_label_init(&data->link, 0, 6, UI_COLS - 8, UI_ALIGN_LEFT, UI_COLOR_TEXT, UI_COLOR_BG);
+    ui_label_init(&data->battery, UI_COLS - 8, 6, 8, UI_ALIGN_RIGHT, UI_COLOR_TEXT, UI_COLOR_BG);
+
+    int spark_x = DEAUTH_LABEL_COLS * UI_CELL_W_NORMAL;
+    ui_history_reset(&data->deauth_history);
+    ui_sparkline_init(&data->deauth_spark, spark_x, ui_row_y(3) + 2,
+                      DISPLAY_WIDTH - spark_x - 2, 2 * UI_CELL_H_NORMAL - 4, 2,
+                      0, DEAUTH_SPARK_FULL, UI_COLOR_HIGHLIGHT, UI_COLOR_BG);
+    data->metrics_generation = metrics_store_generation();
+
+    // Until the next renegotiation says otherwise
+    data->link_state.up = uart_link_is_up(UART_LINK_PRIMARY);
+    data->link_state.binary = uart_is_binary_mode();
+    data->link_state.baud = uart_get_baud_rate();
+
+    // A scan burst beyond DASH_BUS_DEPTH per tick is dropped by the bus;
+    // one event is enough to bring the AP pane forward
+    data->bus_handle = event_bus_subscribe(BUS_EVENT_BIT(BUS_EVENT_NETWORK_SEEN) |
+                                           BUS_EVENT_BIT(BUS_EVENT_GPS_FIX) |
+                                           BUS_EVENT_BIT(BUS_EVENT_LINK_STATE),
+                                           DASH_BUS_DEPTH, "dashboard");
+    if (data->bus_handle < 0) {
+        ESP_LOGW(TAG, "No event bus queue, panes refresh on their period only");
+    }
+
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    screen->tick_ms = DASH_TICK_MS;
+
+    draw_screen(screen);
+
+    ESP_LOGI(TAG, "Dashboard screen created");
+    return screen;
+}
+
+SCREEN_REGISTER(HOME, 75, dashboard_screen_create, 0, "Dashboard", NULL);
@@ -0,0 +1,18 @@
+/**
+ * @file dashboard_screen.h
+ * @brief Live overview for unattended collection (APs, clients, deauths, GPS, link, battery)
+ */
+
+#ifndef DASHBOARD_SCREEN_H
+#define DASHBOARD_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the dashboard screen
+ * @param params Unused (NULL)
+ * @return Created screen or NULL on failure
+ */
+screen_t* dashboard_screen_create(void *params);
+
+#endif // DASHBOARD_SCREEN_H
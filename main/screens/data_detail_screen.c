@@ -4,6 +4,13 @@
  * 
  * Displays a title (SSID) and full content with automatic line wrapping
  * and vertical scrolling support. Optionally supports WiFi auto-connect.
+ *
+ * Content is never copied into lines: the wrap index keeps only the start
+ * offset of each wrapped line and is extended on demand as far as the
+ * visible window needs, so content of any length opens at once. With a
+ * data_detail_source_t the content itself arrives the same way: the
+ * source is asked for more only when the index runs into the end of the
+ * text it has given.
  */
 
 #include "data_detail_screen.h"
@@ -13,13 +20,14 @@
 #include "esp_log.h"
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 
 static const char *TAG = "DATA_DETAIL";
 
 // Display constants
 #define CHARS_PER_LINE  28  // Leave some margin
 #define CONTENT_ROWS    5   // Rows available for content (rows 1-5, row 0=title, row 7=status)
-#define MAX_LINES       32  // Maximum wrapped lines to support
+#define INDEX_INITIAL   16  // Wrap index entries before the first growth
 
 // Screen states
 typedef enum {
@@ -31,8 +39,16 @@ typedef enum {
 // Screen user data
 typedef struct {
     char title[DETAIL_MAX_TITLE_LEN];
-    char *lines[MAX_LINES];  // Pointers to wrapped lines
-    int line_count;
+    char *content;           // Owned text being shown (the source's when streaming)
+    data_detail_source_t source;
+    size_t content_len;      // Source text so far
+    bool source_done;        // Source has no more to give
+    char separator;          // Segment end: ',' for content, '\n' for a source
+    uint32_t *line_starts;   // Wrap index: content offset of each line found so far
+    int line_count;          // Lines in the index
+    int index_capacity;
+    size_t wrap_pos;         // Where the next line search starts
+    bool wrap_done;          // Index covers the whole content
     int scroll_offset;
     // Connect feature
     char connect_ssid[33];
@@ -49,100 +65,116 @@ typedef struct {
 static void draw_screen(screen_t *self);
 
 /**
- * @brief Wrap content into lines
- * Splits content by comma/space and wraps long segments
+ * @brief Find the wrapped line that starts at or after pos
+ *
+ * Content splits at the separator into segments; a segment longer than a
+ * line wraps at a space in the second half of the line if it has one.
+ * @param text Content
+ * @param pos Search position
+ * @param separator Segment end (',' or '\n')
+ * @param start Receives the line start
+ * @param len Receives the line length
+ * @return Position after the line, or 0 if no line is left
  */
-static void wrap_content(data_detail_data_t *data, const char *content)
+static size_t wrap_line(const char *text, size_t pos, char separator, size_t *start, size_t *len)
 {
-    data->line_count = 0;
+    const char *p = text + pos;
     
-    if (!content || strlen(content) == 0) {
-        return;
+    // Skip leading whitespace and empty segments
+    while (*p == ' ' || *p == '\t' || *p == separator) p++;
+    if (*p == '\0') return 0;
+    
+    const char *seg_end = p;
+    while (*seg_end && *seg_end != separator) seg_end++;
+    
+    // Trim trailing whitespace from segment
+    size_t seg_len = seg_end - p;
+    while (seg_len > 0 && (p[seg_len - 1] == ' ' || p[seg_len - 1] == '\t')) {
+        seg_len--;
     }
     
-    // Make a working copy
-    char *work = strdup(content);
-    if (!work) return;
+    size_t chunk = seg_len;
+    if (chunk > CHARS_PER_LINE) {
+        chunk = CHARS_PER_LINE;
+        // Try to break at space
+        for (size_t i = chunk; i > chunk / 2; i--) {
+            if (p[i] == ' ') {
+                chunk = i;
+                break;
+            }
+        }
+    }
     
-    const char *p = work;
+    *start = p - text;
+    *len = chunk;
+    while (*len > 0 && p[*len - 1] == ' ') (*len)--;
     
-    while (*p && data->line_count < MAX_LINES) {
-        // Skip leading whitespace
-        while (*p == ' ' || *p == '\t') p++;
-        if (*p == '\0') break;
-        
-        // Find segment end (comma or end of string)
-        const char *seg_start = p;
-        const char *seg_end = p;
-        
-        // Look for comma separator or end
-        while (*seg_end && *seg_end != ',') seg_end++;
-        
-        size_t seg_len = seg_end - seg_start;
+    // Rest of a wrapped segment, or past the comma
+    return (chunk < seg_len) ? (size_t)(p + chunk - text) : (size_t)(seg_end - text);
+}
+
+/**
+ * @brief Take what the source has added since the last call
+ * @return true if the text grew or ended
+ */
+static bool pull_source(data_detail_data_t *data)
+{
+    if (!data->source.text) return false;
+    size_t len = 0;
+    bool done = false;
+    data->content = (char *)data->source.text(data->source.ctx, &len, &done);
+    bool changed = len != data->content_len || done != data->source_done;
+    data->content_len = len;
+    data->source_done = done;
+    return changed;
+}
+
+/**
+ * @brief Extend the wrap index until it holds count lines or the content ends
+ */
+static void index_lines(data_detail_data_t *data, int count)
+{
+    pull_source(data);
+    while (!data->wrap_done && data->line_count < count) {
+        size_t start, len;
+        size_t next = data->content ? wrap_line(data->content, data->wrap_pos, data->separator,
+                                                &start, &len) : 0;
         
-        // Trim trailing whitespace from segment
-        while (seg_len > 0 && (seg_start[seg_len-1] == ' ' || seg_start[seg_len-1] == '\t')) {
-            seg_len--;
+        // A line running into the end of streamed text may go on in the next part
+        if (data->source.text && !data->source_done && (next == 0 || next >= data->content_len)) {
+            data->source.more(data->source.ctx);
+            break;
         }
-        
-        if (seg_len > 0) {
-            // If segment fits on one line
-            if (seg_len <= CHARS_PER_LINE) {
-                char *line = malloc(seg_len + 1);
-                if (line) {
-                    strncpy(line, seg_start, seg_len);
-                    line[seg_len] = '\0';
-                    data->lines[data->line_count++] = line;
-                }
-            } else {
-                // Need to wrap this segment
-                size_t offset = 0;
-                while (offset < seg_len && data->line_count < MAX_LINES) {
-                    size_t chunk = seg_len - offset;
-                    if (chunk > CHARS_PER_LINE) {
-                        chunk = CHARS_PER_LINE;
-                        // Try to break at space
-                        size_t break_at = chunk;
-                        for (size_t i = chunk; i > chunk/2; i--) {
-                            if (seg_start[offset + i] == ' ') {
-                                break_at = i;
-                                break;
-                            }
-                        }
-                        chunk = break_at;
-                    }
-                    
-                    char *line = malloc(chunk + 1);
-                    if (line) {
-                        strncpy(line, seg_start + offset, chunk);
-                        line[chunk] = '\0';
-                        // Trim leading space on continuation
-                        char *trimmed = line;
-                        while (*trimmed == ' ') trimmed++;
-                        if (trimmed != line) {
-                            memmove(line, trimmed, strlen(trimmed) + 1);
-                        }
-                        if (strlen(line) > 0) {
-                            data->lines[data->line_count++] = line;
-                        } else {
-                            free(line);
-                        }
-                    }
-                    offset += chunk;
-                }
-            }
+        if (next == 0) {
+            data->wrap_done = true;
+            break;
         }
         
-        // Move past segment
-        p = seg_end;
-        if (*p == ',') {
-            p++;  // Skip comma
-            // Skip space after comma
-            while (*p == ' ') p++;
+        if (data->line_count == data->index_capacity) {
+            int capacity = data->index_capacity ? data->index_capacity * 2 : INDEX_INITIAL;
+            uint32_t *grown = realloc(data->line_starts, capacity * sizeof(uint32_t));
+            if (!grown) {
+                data->wrap_done = true;
+                break;
+            }
+            data->line_starts = grown;
+            data->index_capacity = capacity;
         }
+        data->line_starts[data->line_count++] = (uint32_t)start;
+        data->wrap_pos = next;
     }
-    
-    free(work);
+}
+
+/**
+ * @brief Copy wrapped line idx (which must be in the index) for display
+ */
+static void get_line(data_detail_data_t *data, int idx, char *out, size_t out_len)
+{
+    size_t start, len;
+    wrap_line(data->content, data->line_starts[idx], data->separator, &start, &len);
+    if (len >= out_len) len = out_len - 1;
+    memcpy(out, data->content + start, len);
+    out[len] = '\0';
 }
 
 /**
@@ -206,8 +238,11 @@ static void draw_screen(screen_t *self)
     }
     
     // STATE_VIEW - normal content display
+    // One line past the window tells whether there is more below
+    index_lines(data, data->scroll_offset + CONTENT_ROWS + 1);
     if (data->line_count == 0) {
-        ui_print_center(3, "No data", UI_COLOR_DIMMED);
+        bool waiting = data->source.text && !data->source_done;
+        ui_print_center(3, waiting ? "Loading..." : "No data", UI_COLOR_DIMMED);
     } else {
         // Draw visible content lines
         for (int i = 0; i < CONTENT_ROWS; i++) {
@@ -215,7 +250,9 @@ static void draw_screen(screen_t *self)
             int row = i + 1;  // Start from row 1 (after title)
             
             if (line_idx < data->line_count) {
-                ui_print(0, row, data->lines[line_idx], UI_COLOR_TEXT);
+                char line[CHARS_PER_LINE + 1];
+                get_line(data, line_idx, line, sizeof(line));
+                ui_print(0, row, line, UI_COLOR_TEXT);
             }
         }
         
@@ -231,6 +268,9 @@ static void draw_screen(screen_t *self)
     // Draw status bar based on features
     if (data->has_connect) {
         ui_draw_status("ENTER:Connect ESC:Back");
+    } else if (data->source.text && !data->source_done &&
+               data->line_count < data->scroll_offset + CONTENT_ROWS + 1) {
+        ui_draw_status("Loading... ESC:Back");
     } else if (data->line_count > CONTENT_ROWS) {
         ui_draw_status("UP/DOWN:Scroll ESC:Back");
     } else {
@@ -242,6 +282,12 @@ static void on_tick(screen_t *self)
 {
     data_detail_data_t *data = (data_detail_data_t *)self->user_data;
     
+    // Streamed text only matters while the window waits for it
+    if (data->state == STATE_VIEW && !data->wrap_done && pull_source(data) &&
+        data->line_count < data->scroll_offset + CONTENT_ROWS + 1) {
+        data->needs_redraw = true;
+    }
+    
     if (data->needs_redraw) {
         data->needs_redraw = false;
         draw_screen(self);
@@ -257,7 +303,7 @@ static void on_key(screen_t *self, key_code_t key)
         if (key == KEY_ENTER || key == KEY_SPACE) {
             if (data->connect_success) {
                 // Push ARP hosts screen
-                uart_clear_line_callback();
+                screen_set_line_callback(self, NULL, NULL);
                 screen_manager_push(arp_hosts_screen_create, NULL);
             } else {
                 // Go back to view state
@@ -274,7 +320,6 @@ static void on_key(screen_t *self, key_code_t key)
     if (data->state == STATE_CONNECTING) {
         if (key == KEY_ESC) {
             // Cancel and go back
-            uart_clear_line_callback();
             screen_manager_pop();
         }
         return;
@@ -286,7 +331,10 @@ static void on_key(screen_t *self, key_code_t key)
             if (data->scroll_offset > 0) {
                 data->scroll_offset--;
                 draw_screen(self);
-            } else if (data->line_count > CONTENT_ROWS) {
+            } else if (data->line_count > CONTENT_ROWS &&
+                       (!data->source.text || data->source_done)) {
+                // Wrapping to the end needs the whole index
+                index_lines(data, INT_MAX);
                 data->scroll_offset = data->line_count - CONTENT_ROWS;
                 draw_screen(self);
             }
@@ -311,7 +359,7 @@ static void on_key(screen_t *self, key_code_t key)
                 draw_screen(self);
                 
                 // Register UART callback
-                uart_register_line_callback(uart_line_callback, data);
+                screen_set_line_callback(self, uart_line_callback, data);
                 
                 // Send connect command
                 char cmd[128];
@@ -336,15 +384,12 @@ static void on_destroy(screen_t *self)
 {
     data_detail_data_t *data = (data_detail_data_t *)self->user_data;
     
-    // Clear UART callback if we registered one
-    uart_clear_line_callback();
-    
     if (data) {
-        // Free all wrapped lines
-        for (int i = 0; i < data->line_count; i++) {
-            if (data->lines[i]) {
-                free(data->lines[i]);
-            }
+        free(data->line_starts);
+        if (data->source.text) {
+            if (data->source.close) data->source.close(data->source.ctx);
+        } else {
+            free(data->content);
         }
         free(data);
     }
@@ -367,15 +412,13 @@ screen_t* data_detail_screen_create(void *params)
     
     ESP_LOGI(TAG, "Creating data detail screen for '%s'...", detail_params->title);
     
+    const data_detail_source_t *source = &detail_params->source;
     screen_t *screen = screen_alloc();
-    if (!screen) {
-        free(detail_params);
-        return NULL;
-    }
-    
-    data_detail_data_t *data = calloc(1, sizeof(data_detail_data_t));
+    data_detail_data_t *data = screen ? calloc(1, sizeof(data_detail_data_t)) : NULL;
     if (!data) {
         free(screen);
+        if (source->text && source->close) source->close(source->ctx);
+        free(detail_params->content);
         free(detail_params);
         return NULL;
     }
@@ -387,8 +430,16 @@ screen_t* data_detail_screen_create(void *params)
     strncpy(data->title, detail_params->title, DETAIL_MAX_TITLE_LEN - 1);
     data->title[DETAIL_MAX_TITLE_LEN - 1] = '\0';
     
-    // Wrap content into lines
-    wrap_content(data, detail_params->content);
+    // Take over the content; lines are indexed when drawn
+    data->separator = ',';
+    if (detail_params->source.text) {
+        free(detail_params->content);
+        data->source = detail_params->source;
+        data->separator = '\n';
+        screen->tick_on_uart = true;    // Parts arrive as UART replies
+    } else {
+        data->content = detail_params->content;
+    }
     
     // Copy connect credentials if provided
     if (detail_params->connect_ssid[0] != '\0') {
@@ -413,6 +464,8 @@ screen_t* data_detail_screen_create(void *params)
     // Draw initial screen
     draw_screen(screen);
     
-    ESP_LOGI(TAG, "Data detail screen created with %d lines", data->line_count);
+    ESP_LOGI(TAG, "Data detail screen created (%u bytes of content%s)",
+             data->content ? (unsigned)strlen(data->content) : 0,
+             data->source.text && !data->source_done ? " so far" : "");
     return screen;
 }
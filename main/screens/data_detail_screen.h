@@ -7,15 +7,33 @@
 #define DATA_DETAIL_SCREEN_H
 
 #include "screen_manager.h"
+#include <stdbool.h>
+#include <stddef.h>
 
 // Maximum lengths for parameters
 #define DETAIL_MAX_TITLE_LEN    64
-#define DETAIL_MAX_CONTENT_LEN  256
+
+/**
+ * Content that arrives while the screen is open, for text too large to
+ * fetch before showing it. The screen asks for more only when the view
+ * reaches the end of what it has. Source text wraps at newlines rather
+ * than commas. All calls come from the UI task.
+ */
+typedef struct {
+    // Text so far (NUL-terminated, valid until the next call); *complete
+    // once no more will come
+    const char *(*text)(void *ctx, size_t *len, bool *complete);
+    void (*more)(void *ctx);                // The view reached the end: fetch on
+    void (*close)(void *ctx);               // Screen closed (may be NULL)
+    void *ctx;
+} data_detail_source_t;
 
 // Parameters for detail screen
 typedef struct {
     char title[DETAIL_MAX_TITLE_LEN];      // SSID or header
-    char content[DETAIL_MAX_CONTENT_LEN];  // Full content to display
+    char *content;                         // Full content to display (heap, any length,
+                                           // freed by the screen; NULL shows "No data")
+    data_detail_source_t source;           // Used instead of content when text is set
     // Optional: WiFi credentials for auto-connect feature
     char connect_ssid[33];                 // If non-empty, enables Connect option
     char connect_password[65];             // WiFi password for connect
@@ -1,168 +1,398 @@
 /**
  * @file deauth_detector_screen.c
  * @brief Deauth attack detector screen implementation
- * 
- * Displays detected deauth attacks in real-time.
- * Parses UART output: [DEAUTH] CH: <ch> | AP: <name> (<bssid>) | RSSI: <rssi>
+ *
+ * Aggregates detections per BSSID and per channel, each with a ring of
+ * per-second counts giving frame rates over 1 s, 10 s and 60 s. The
+ * screen shows the overall rates, the busiest BSSIDs and channels, and a
+ * graph of the detection rate over the last two minutes. A BSSID whose
+ * 10 s rate crosses DEAUTH_ALERT_RATE raises a buzzer and session log
+ * alert.
+ * Detections arrive as BUS_EVENT_DEAUTH_DETECTED events (parsed from the
+ * "[DEAUTH]" lines by world_model) and are counted in on_tick.
  */
 
 #include "deauth_detector_screen.h"
+#include "mem_monitor.h"
+#include "screen_registry.h"
+#include "sdkconfig.h"
 #include "uart_handler.h"
+#include "event_bus.h"
+#include "job_manager.h"
+#include "mac_set.h"
+#include "session_log.h"
+#include "buzzer.h"
 #include "text_ui.h"
+#include "ui_widget.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 
 static const char *TAG = "DEAUTH_DETECTOR";
 
-// Screen user data
+// Detail area: grid rows 2..6 between title and status bar
+#define DETAIL_FIRST_ROW    2
+#define DETAIL_ROWS         5
+#define TOP_BSSIDS          3       // Rows 3..5
+#define TOP_CHANNELS        3       // Row 6
+
+// Row 1: detections per second over the last two minutes
+#define RATE_SAMPLE_US      1000000
+#define RATE_SPARK_X        4
+#define RATE_SPARK_H        12
+#define RATE_SPARK_FULL     10      // Detections per second drawn as a full bar
+
+// Aggregation
+// Least recently seen BSSIDs are evicted
+#ifdef CONFIG_DEAUTH_MAX_BSSIDS
+#define MAX_BSSIDS          CONFIG_DEAUTH_MAX_BSSIDS
+#else
+#define MAX_BSSIDS          64
+#endif
+#define MAX_CHANNELS        32
+#define RATE_SECONDS        60      // Longest window
+#define REDRAW_INTERVAL_US  250000  // A flood repaints at most this often
+#define BUS_DEPTH           32      // Detections waiting for on_tick
+
+// Alerts
+#define DEAUTH_ALERT_RATE   10      // Frames/s over 10 s from one BSSID
+#define DEAUTH_ALERT_HOLD_US 30000000   // Quiet time before the same BSSID alerts again
+
+// Per-second counts of the last RATE_SECONDS seconds
+typedef struct {
+    uint16_t buckets[RATE_SECONDS];
+    uint32_t sec;               // Second the newest bucket belongs to
+} rate_ring_t;
+
 typedef struct {
-    int channel;
     char ap_name[33];
-    char bssid[18];
-    int rssi;
-    int detection_count;
-    bool has_detection;
+    uint8_t channel;
+    int8_t rssi;                // Last seen
+    uint32_t total;
+    int64_t alert_us;           // Last alert, 0 = never
+    rate_ring_t rate;
+} bssid_stats_t;
+
+typedef struct {
+    uint32_t total;
+    rate_ring_t rate;
+} channel_stats_t;
+
+// Screen user data
+typedef struct {
+    int bus_handle;
+    mac_set_t bssid_index;      // BSSID -> bssids[]
+    bssid_stats_t bssids[MAX_BSSIDS];
+    mac_set_t channel_index;    // Channel -> channels[]
+    channel_stats_t channels[MAX_CHANNELS];
+    uint8_t channel_numbers[MAX_CHANNELS];
+    rate_ring_t overall;
+    uint32_t detection_count;
     bool needs_redraw;
     screen_t *self;
+    int64_t last_draw_us;
+    // Retained rows 2..6: a new detection repaints only the changed cells
+    bool layout_drawn;
+    uint32_t layout_generation;
+    ui_label_t rows[DETAIL_ROWS];
+    // Detection rate history
+    int second_count;           // Detections since the last sample
+    int64_t last_sample_us;
+    ui_history_t rate;
+    ui_sparkline_t rate_spark;
 } deauth_detector_data_t;
 
+MEM_BUDGET(deauth_detector, 1, sizeof(deauth_detector_data_t), MEM_BUDGET_SCREEN);
+
 // Forward declaration
 static void draw_screen(screen_t *self);
 
+static uint32_t now_seconds(void)
+{
+    return (uint32_t)(esp_timer_get_time() / RATE_SAMPLE_US);
+}
+
 /**
- * @brief Parse deauth detection line
- * Format: [DEAUTH] CH: <ch> | AP: <name> (<bssid>) | RSSI: <rssi>
+ * @brief Count one frame in the current second, zeroing skipped seconds
  */
-static bool parse_deauth_line(const char *line, deauth_detector_data_t *data)
-{
-    // Check if line starts with [DEAUTH]
-    const char *marker = "[DEAUTH] CH: ";
-    const char *start = strstr(line, marker);
-    if (!start) return false;
-    
-    start += strlen(marker);
-    
-    // Parse channel
-    int channel = 0;
-    while (*start >= '0' && *start <= '9') {
-        channel = channel * 10 + (*start - '0');
-        start++;
-    }
-    
-    // Find " | AP: "
-    const char *ap_marker = " | AP: ";
-    const char *ap_start = strstr(start, ap_marker);
-    if (!ap_start) return false;
-    ap_start += strlen(ap_marker);
-    
-    // Find " (" before BSSID
-    const char *bssid_start = strstr(ap_start, " (");
-    if (!bssid_start) return false;
-    
-    // Extract AP name
-    int ap_len = bssid_start - ap_start;
-    if (ap_len > 32) ap_len = 32;
-    strncpy(data->ap_name, ap_start, ap_len);
-    data->ap_name[ap_len] = '\0';
-    
-    // Skip " ("
-    bssid_start += 2;
-    
-    // Find ")" after BSSID
-    const char *bssid_end = strchr(bssid_start, ')');
-    if (!bssid_end) return false;
-    
-    // Extract BSSID
-    int bssid_len = bssid_end - bssid_start;
-    if (bssid_len > 17) bssid_len = 17;
-    strncpy(data->bssid, bssid_start, bssid_len);
-    data->bssid[bssid_len] = '\0';
-    
-    // Find " | RSSI: "
-    const char *rssi_marker = " | RSSI: ";
-    const char *rssi_start = strstr(bssid_end, rssi_marker);
-    if (!rssi_start) return false;
-    rssi_start += strlen(rssi_marker);
-    
-    // Parse RSSI (can be negative)
-    int rssi = atoi(rssi_start);
-    
-    // Update data
-    data->channel = channel;
-    data->rssi = rssi;
-    data->has_detection = true;
+static void rate_add(rate_ring_t *ring, uint32_t sec)
+{
+    if (sec != ring->sec) {
+        uint32_t gap = sec - ring->sec;
+        if (gap > RATE_SECONDS) gap = RATE_SECONDS;
+        for (uint32_t i = 1; i <= gap; i++) {
+            ring->buckets[(ring->sec + i) % RATE_SECONDS] = 0;
+        }
+        ring->sec = sec;
+    }
+    uint16_t *bucket = &ring->buckets[sec % RATE_SECONDS];
+    if (*bucket < UINT16_MAX) (*bucket)++;
+}
+
+/**
+ * @brief Frames in the last `seconds` complete seconds before `sec`
+ */
+static uint32_t rate_sum(const rate_ring_t *ring, uint32_t sec, int seconds)
+{
+    uint32_t sum = 0;
+    for (int i = 1; i <= seconds; i++) {
+        uint32_t s = sec - i;
+        // Newer than the ring's last write: nothing counted yet
+        if ((int32_t)(s - ring->sec) > 0) continue;
+        // Older than the ring holds: overwritten
+        if (ring->sec - s >= RATE_SECONDS) break;
+        sum += ring->buckets[s % RATE_SECONDS];
+    }
+    return sum;
+}
+
+/**
+ * @brief Frames per second over a window, rounded
+ */
+static uint32_t rate_per_sec(const rate_ring_t *ring, uint32_t sec, int seconds)
+{
+    return (rate_sum(ring, sec, seconds) + seconds / 2) / seconds;
+}
+
+static void format_bssid(uint64_t key, char *buf, size_t len)
+{
+    snprintf(buf, len, "%02X:%02X:%02X:%02X:%02X:%02X",
+             (unsigned)(key >> 40) & 0xFF, (unsigned)(key >> 32) & 0xFF,
+             (unsigned)(key >> 24) & 0xFF, (unsigned)(key >> 16) & 0xFF,
+             (unsigned)(key >> 8) & 0xFF, (unsigned)key & 0xFF);
+}
+
+/**
+ * @brief Count one detection; a flood costs two hash lookups per line
+ */
+static void record_detection(deauth_detector_data_t *data, const bus_deauth_t *d)
+{
+    uint32_t sec = now_seconds();
+
+    bool is_new = false;
+    int idx = mac_set_add(&data->bssid_index, d->bssid, &is_new);
+    if (idx >= 0) {
+        bssid_stats_t *b = &data->bssids[idx];
+        if (is_new) {
+            // New or evicted slot
+            memset(b, 0, sizeof(*b));
+            b->rate.sec = sec;
+        }
+        strlcpy(b->ap_name, d->ap_name, sizeof(b->ap_name));
+        b->channel = d->channel;
+        b->rssi = d->rssi;
+        b->total++;
+        rate_add(&b->rate, sec);
+    }
+
+    idx = mac_set_add(&data->channel_index, (uint64_t)d->channel, &is_new);
+    if (idx >= 0) {
+        channel_stats_t *c = &data->channels[idx];
+        if (is_new) {
+            memset(c, 0, sizeof(*c));
+            c->rate.sec = sec;
+            data->channel_numbers[idx] = (uint8_t)d->channel;
+        }
+        c->total++;
+        rate_add(&c->rate, sec);
+    }
+
+    rate_add(&data->overall, sec);
     data->detection_count++;
-    
-    ESP_LOGI(TAG, "Parsed: CH=%d AP=%s BSSID=%s RSSI=%d (total: %d)",
-             data->channel, data->ap_name, data->bssid, data->rssi, data->detection_count);
-    
-    return true;
 }
 
 /**
- * @brief UART line callback for parsing deauth detector output
+ * @brief Alert on BSSIDs flooding above DEAUTH_ALERT_RATE (once per second)
  */
-static void uart_line_callback(const char *line, void *user_data)
+static void check_alerts(deauth_detector_data_t *data)
 {
-    deauth_detector_data_t *data = (deauth_detector_data_t *)user_data;
-    if (!data) return;
-    
-    if (parse_deauth_line(line, data)) {
-        data->needs_redraw = true;
+    uint32_t sec = now_seconds();
+    int64_t now = esp_timer_get_time();
+    bool beep = false;
+
+    for (int i = 0; i < data->bssid_index.count; i++) {
+        bssid_stats_t *b = &data->bssids[i];
+        uint32_t rate = rate_per_sec(&b->rate, sec, 10);
+        if (rate < DEAUTH_ALERT_RATE) continue;
+        if (b->alert_us && now - b->alert_us < DEAUTH_ALERT_HOLD_US) {
+            b->alert_us = now;      // Still flooding: keep quiet
+            continue;
+        }
+        b->alert_us = now;
+        beep = true;
+
+        char bssid[18];
+        format_bssid(data->bssid_index.keys[i], bssid, sizeof(bssid));
+        ESP_LOGW(TAG, "Deauth flood: %s '%s' CH %d, %lu frames/s",
+                 bssid, b->ap_name, b->channel, (unsigned long)rate);
+        session_log_printf(SESSION_LOG_DEAUTH, "ALERT\t%s\t%s\t%d\t%lu",
+                           bssid, b->ap_name, b->channel, (unsigned long)rate);
     }
+
+    if (beep) buzzer_beep_attack();
+}
+
+/**
+ * @brief Indices of the n entries with the highest keys, best first
+ * @return Entries found
+ */
+static int top_n(const uint32_t *keys, int count, int *out, int n)
+{
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        int pos = found < n ? found : n;
+        while (pos > 0 && keys[out[pos - 1]] < keys[i]) {
+            if (pos < n) out[pos] = out[pos - 1];
+            pos--;
+        }
+        if (pos < n) {
+            out[pos] = i;
+            if (found < n) found++;
+        }
+    }
+    return found;
+}
+
+static uint32_t rank_part(uint32_t value)
+{
+    return value > UINT16_MAX ? UINT16_MAX : value;
+}
+
+/**
+ * @brief Set one detail row (left text is indented one column like ui_print(1, ...))
+ */
+static void set_row(deauth_detector_data_t *data, int row, const char *text,
+                    uint16_t fg, ui_align_t align)
+{
+    ui_label_t *label = &data->rows[row - DETAIL_FIRST_ROW];
+    label->align = align;
+    ui_label_set_colors(label, fg, UI_COLOR_BG);
+    ui_label_set(label, text);
+}
+
+/**
+ * @brief Rows 2..6: overall rates, busiest BSSIDs, busiest channels
+ */
+static void draw_stats(deauth_detector_data_t *data)
+{
+    uint32_t sec = now_seconds();
+    // Ranked by 10 s rate, then total, so past floods keep their place
+    uint32_t keys[MAX_BSSIDS > MAX_CHANNELS ? MAX_BSSIDS : MAX_CHANNELS];
+    int top[TOP_BSSIDS > TOP_CHANNELS ? TOP_BSSIDS : TOP_CHANNELS];
+    char text[UI_COLS + 1];
+
+    snprintf(text, sizeof(text), "Tot %-6lu 1s%3lu 10s%3lu 60s%3lu",
+             (unsigned long)data->detection_count,
+             (unsigned long)rate_per_sec(&data->overall, sec, 1),
+             (unsigned long)rate_per_sec(&data->overall, sec, 10),
+             (unsigned long)rate_per_sec(&data->overall, sec, 60));
+    set_row(data, 2, text, UI_COLOR_TEXT, UI_ALIGN_LEFT);
+
+    int count = data->bssid_index.count;
+    for (int i = 0; i < count; i++) {
+        uint32_t total = data->bssids[i].total;
+        keys[i] = (rank_part(rate_sum(&data->bssids[i].rate, sec, 10)) << 16) |
+                  rank_part(total);
+    }
+    int shown = top_n(keys, count, top, TOP_BSSIDS);
+    for (int i = 0; i < TOP_BSSIDS; i++) {
+        if (i >= shown) {
+            set_row(data, 3 + i, NULL, UI_COLOR_TEXT, UI_ALIGN_LEFT);
+            continue;
+        }
+        const bssid_stats_t *b = &data->bssids[top[i]];
+        uint32_t rate = rate_per_sec(&b->rate, sec, 10);
+        char name[18];
+        if (b->ap_name[0]) {
+            strlcpy(name, b->ap_name, sizeof(name));
+        } else {
+            format_bssid(data->bssid_index.keys[top[i]], name, sizeof(name));
+        }
+        snprintf(text, sizeof(text), "%c%-13.13s c%-3d%4lu/s %4d",
+                 rate >= DEAUTH_ALERT_RATE ? '!' : ' ', name, b->channel,
+                 (unsigned long)rate, b->rssi);
+        set_row(data, 3 + i, text,
+                rate >= DEAUTH_ALERT_RATE ? UI_COLOR_HIGHLIGHT : UI_COLOR_TEXT, UI_ALIGN_LEFT);
+    }
+
+    count = data->channel_index.count;
+    for (int i = 0; i < count; i++) {
+        uint32_t total = data->channels[i].total;
+        keys[i] = (rank_part(rate_sum(&data->channels[i].rate, sec, 10)) << 16) |
+                  rank_part(total);
+    }
+    shown = top_n(keys, count, top, TOP_CHANNELS);
+    int len = snprintf(text, sizeof(text), "CH");
+    for (int i = 0; i < shown && len < (int)sizeof(text); i++) {
+        len += snprintf(text + len, sizeof(text) - len, " %d:%lu/s",
+                        data->channel_numbers[top[i]],
+                        (unsigned long)rate_per_sec(&data->channels[top[i]].rate, sec, 10));
+    }
+    set_row(data, 6, text, UI_COLOR_DIMMED, UI_ALIGN_LEFT);
 }
 
 static void draw_screen(screen_t *self)
 {
     deauth_detector_data_t *data = (deauth_detector_data_t *)self->user_data;
-    
-    ui_clear();
-    
-    // Draw title
-    ui_draw_title("DEAUTH DETECTOR");
-    
-    if (data->has_detection) {
-        // Show last detection
-        ui_print(1, 2, "Last Detection:", UI_COLOR_TEXT);
-        
-        // Channel and RSSI on same line
-        char info_str[32];
-        snprintf(info_str, sizeof(info_str), "CH: %d  RSSI: %d dBm", data->channel, data->rssi);
-        ui_print(1, 3, info_str, UI_COLOR_HIGHLIGHT);
-        
-        // AP name
-        char ap_str[32];
-        snprintf(ap_str, sizeof(ap_str), "AP: %.24s", data->ap_name);
-        ui_print(1, 4, ap_str, UI_COLOR_TEXT);
-        
-        // BSSID
-        char bssid_str[32];
-        snprintf(bssid_str, sizeof(bssid_str), "BSSID: %s", data->bssid);
-        ui_print(1, 5, bssid_str, UI_COLOR_DIMMED);
-        
-        // Total count (row 6 to avoid overlap with status bar)
-        char count_str[32];
-        snprintf(count_str, sizeof(count_str), "Total: %d detections", data->detection_count);
-        ui_print_center(6, count_str, UI_COLOR_TEXT);
+
+    // Static chrome only after a clear; rows repaint themselves
+    if (!data->layout_drawn || data->layout_generation != ui_get_clear_generation()) {
+        ui_clear();
+        ui_draw_title("DEAUTH DETECTOR");
+        ui_draw_status("ESC: Stop  B: Background");
+        data->layout_generation = ui_get_clear_generation();
+        data->layout_drawn = true;
+    }
+
+    ui_sparkline_update(&data->rate_spark, &data->rate);
+
+    if (data->detection_count > 0) {
+        draw_stats(data);
     } else {
         // Waiting for detections
-        ui_print_center(3, "Scanning for deauth", UI_COLOR_TEXT);
-        ui_print_center(4, "attacks...", UI_COLOR_TEXT);
-        ui_print_center(6, "Waiting for data", UI_COLOR_DIMMED);
+        set_row(data, 2, NULL, UI_COLOR_TEXT, UI_ALIGN_CENTER);
+        set_row(data, 3, "Scanning for deauth", UI_COLOR_TEXT, UI_ALIGN_CENTER);
+        set_row(data, 4, "attacks...", UI_COLOR_TEXT, UI_ALIGN_CENTER);
+        set_row(data, 5, NULL, UI_COLOR_TEXT, UI_ALIGN_CENTER);
+        set_row(data, 6, "Waiting for data", UI_COLOR_DIMMED, UI_ALIGN_CENTER);
     }
-    
-    // Draw status bar
-    ui_draw_status("ESC: Stop");
+    data->last_draw_us = esp_timer_get_time();
 }
 
 static void on_tick(screen_t *self)
 {
     deauth_detector_data_t *data = (deauth_detector_data_t *)self->user_data;
-    
-    // Check if redraw needed from UART callback
-    if (data->needs_redraw) {
+
+    bus_event_t event;
+    while (event_bus_receive(data->bus_handle, &event, 0)) {
+        record_detection(data, &event.deauth);
+        data->second_count++;
+        data->needs_redraw = true;
+    }
+
+    // One rate sample per elapsed second, zeros included, so the graph
+    // keeps moving while nothing is detected
+    int64_t now = esp_timer_get_time();
+    bool sampled = false;
+    while (now - data->last_sample_us >= RATE_SAMPLE_US) {
+        int n = data->second_count;
+        data->second_count = 0;
+        ui_history_push(&data->rate, (int8_t)(n > INT8_MAX ? INT8_MAX : n));
+        data->last_sample_us += RATE_SAMPLE_US;
+        if (now - data->last_sample_us >= RATE_SAMPLE_US * UI_HISTORY_LEN) {
+            data->last_sample_us = now;     // Long stall: skip ahead
+        }
+        sampled = true;
+    }
+    if (sampled) {
+        check_alerts(data);
+        data->needs_redraw = true;
+    }
+
+    // Detections are counted per line but drawn at most every REDRAW_INTERVAL_US
+    if (data->needs_redraw && (sampled || now - data->last_draw_us >= REDRAW_INTERVAL_US)) {
         data->needs_redraw = false;
         draw_screen(self);
     }
@@ -171,6 +401,11 @@ static void on_tick(screen_t *self)
 static void on_key(screen_t *self, key_code_t key)
 {
     switch (key) {
+        case KEY_B:
+            // Keep detecting while other views are open
+            job_manager_background(JOB_DEAUTH_DETECTOR, self);
+            break;
+
         case KEY_ESC:
         case KEY_Q:
             // Stop detector and go back
@@ -178,7 +413,7 @@ static void on_key(screen_t *self, key_code_t key)
             uart_send_command("stop");
             screen_manager_pop();
             break;
-            
+
         default:
             break;
     }
@@ -186,9 +421,15 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
-    // Clear UART callback
-    uart_clear_line_callback();
-    
+    deauth_detector_data_t *data = (deauth_detector_data_t *)self->user_data;
+    if (data) {
+        ESP_LOGI(TAG, "%lu detections from %d BSSIDs", (unsigned long)data->detection_count,
+                 data->bssid_index.count);
+        event_bus_unsubscribe(data->bus_handle);
+        mac_set_free(&data->bssid_index);
+        mac_set_free(&data->channel_index);
+    }
+
     if (self->user_data) {
         free(self->user_data);
     }
@@ -197,40 +438,63 @@ static void on_destroy(screen_t *self)
 screen_t* deauth_detector_screen_create(void *params)
 {
     (void)params;
-    
+
     ESP_LOGI(TAG, "Creating deauth detector screen...");
-    
+
     screen_t *screen = screen_alloc();
     if (!screen) return NULL;
-    
+
     // Allocate user data
     deauth_detector_data_t *data = calloc(1, sizeof(deauth_detector_data_t));
     if (!data) {
         free(screen);
         return NULL;
     }
-    
+
+    if (mac_set_init(&data->bssid_index, MAX_BSSIDS) != ESP_OK ||
+        mac_set_init(&data->channel_index, MAX_CHANNELS) != ESP_OK) {
+        mac_set_free(&data->bssid_index);
+        free(data);
+        free(screen);
+        return NULL;
+    }
+
     data->self = screen;
-    data->has_detection = false;
-    data->detection_count = 0;
-    data->needs_redraw = false;
-    
+    data->overall.sec = now_seconds();
+    for (int i = 0; i < DETAIL_ROWS; i++) {
+        ui_label_init(&data->rows[i], 0, DETAIL_FIRST_ROW + i, UI_COLS,
+                      UI_ALIGN_LEFT, UI_COLOR_TEXT, UI_COLOR_BG);
+    }
+    ui_history_reset(&data->rate);
+    ui_sparkline_init(&data->rate_spark, RATE_SPARK_X, 1 * (DISPLAY_HEIGHT / UI_ROWS) + 2,
+                      DISPLAY_WIDTH - 2 * RATE_SPARK_X, RATE_SPARK_H, 2,
+                      0, RATE_SPARK_FULL, UI_COLOR_HIGHLIGHT, UI_COLOR_BG);
+    data->last_sample_us = esp_timer_get_time();
+
     screen->user_data = data;
+    screen->mem_budget_kb = 64;     // BSSID and channel stats with their MAC indexes
     screen->on_key = on_key;
     screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
     screen->on_tick = on_tick;
-    
-    // Register UART callback
-    uart_register_line_callback(uart_line_callback, data);
-    
+    screen->tick_on_uart = true;
+
+    // A flood beyond BUS_DEPTH between ticks is dropped by the bus rather
+    // than queued behind the render path
+    data->bus_handle = event_bus_subscribe(BUS_EVENT_BIT(BUS_EVENT_DEAUTH_DETECTED),
+                                           BUS_DEPTH, "deauth");
+    if (data->bus_handle < 0) {
+        ESP_LOGW(TAG, "No event bus queue, detections will not be shown");
+    }
+
     // Send command to start deauth detector
     uart_send_command("deauth_detector");
-    
+
     // Draw initial screen
     draw_screen(screen);
-    
+
     ESP_LOGI(TAG, "Deauth detector screen created");
     return screen;
 }
 
+SCREEN_REGISTER(HOME, 40, deauth_detector_screen_create, 0, "Deauth Detector", NULL);
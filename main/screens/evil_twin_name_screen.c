@@ -143,7 +143,10 @@ static void on_select(evil_twin_name_data_t *data)
             ESP_LOGI(TAG, "Selected Evil Twin Name: %s (ID: %d)", 
                      data->networks[chosen_idx].ssid, 
                      data->networks[chosen_idx].id);
-            screen_manager_push(html_select_screen_create, params);
+            if (screen_manager_push(html_select_screen_create, params) == ESP_ERR_NO_MEM) {
+                free(params->networks);
+                free(params);
+            }
         } else {
             free(params);
         }
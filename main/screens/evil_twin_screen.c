@@ -8,15 +8,12 @@
 #include "text_ui.h"
 #include "buzzer.h"
 #include "esp_log.h"
-#include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 static const char *TAG = "EVIL_TWIN";
 
-// Refresh timer interval (200ms)
-#define REFRESH_INTERVAL_US 200000
-
 // Screen states
 typedef enum {
     STATE_RUNNING,   // Attack active
@@ -31,26 +28,12 @@ typedef struct {
     evil_twin_state_t state;
     char captured_ssid[MAX_SSID_LEN];
     char captured_password[64];
-    bool needs_redraw;  // Flag for thread-safe redraw
-    esp_timer_handle_t refresh_timer;
     screen_t *self;  // Reference to self for callback
 } evil_twin_screen_data_t;
 
 // Forward declaration
 static void draw_screen(screen_t *self);
 
-/**
- * @brief Timer callback - checks if redraw is needed
- */
-static void refresh_timer_callback(void *arg)
-{
-    evil_twin_screen_data_t *data = (evil_twin_screen_data_t *)arg;
-    if (data && data->needs_redraw && data->self) {
-        data->needs_redraw = false;
-        draw_screen(data->self);
-    }
-}
-
 /**
  * @brief Extract value between single quotes from a string
  * @param line Input line
@@ -103,7 +86,7 @@ static void uart_line_callback(const char *line, void *user_data)
         if (data->captured_ssid[0] && data->captured_password[0]) {
             data->state = STATE_SUCCESS;
             ESP_LOGI(TAG, "Password verified! Attack successful.");
-            data->needs_redraw = true;
+            screen_manager_data_changed(data->self);
             buzzer_beep_success();
         }
     }
@@ -114,7 +97,7 @@ static void uart_line_callback(const char *line, void *user_data)
             data->state = STATE_STOPPED;
         }
         ESP_LOGI(TAG, "Evil Twin portal shut down.");
-        data->needs_redraw = true;
+        screen_manager_data_changed(data->self);
     }
 }
 
@@ -240,15 +223,6 @@ static void on_destroy(screen_t *self)
 {
     evil_twin_screen_data_t *data = (evil_twin_screen_data_t *)self->user_data;
     
-    // Stop and delete timer
-    if (data && data->refresh_timer) {
-        esp_timer_stop(data->refresh_timer);
-        esp_timer_delete(data->refresh_timer);
-    }
-    
-    // Clear UART callback
-    uart_clear_line_callback();
-    
     if (data) {
         if (data->networks) {
             free(data->networks);
@@ -296,21 +270,8 @@ screen_t* evil_twin_screen_create(void *params)
     screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
     
-    // Create periodic refresh timer
-    esp_timer_create_args_t timer_args = {
-        .callback = refresh_timer_callback,
-        .arg = data,
-        .name = "evil_twin_refresh"
-    };
-    
-    if (esp_timer_create(&timer_args, &data->refresh_timer) == ESP_OK) {
-        esp_timer_start_periodic(data->refresh_timer, REFRESH_INTERVAL_US);
-    } else {
-        ESP_LOGW(TAG, "Failed to create refresh timer");
-    }
-    
     // Register UART callback for parsing Evil Twin output
-    uart_register_line_callback(uart_line_callback, data);
+    screen_set_line_callback(screen, uart_line_callback, data);
     
     // Draw initial screen
     draw_screen(screen);
@@ -0,0 +1,220 @@
+/**
+ * @file export_screen.c
+ * @brief Pick a log on the card and export it (obs_export)
+ *
+ * Lists the wardrive logs, tracks and session logs on the card. F cycles the
+ * format, U switches between the card and the USB port, ENTER starts;
+ * progress runs in the status bar until the export ends.
+ */
+
+#include "export_screen.h"
+#include "obs_export.h"
+#include "session_log.h"
+#include "wardrive_log.h"
+#include "text_ui.h"
+#include "ui_list.h"
+#include "esp_log.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "EXPORT_SCREEN";
+
+#define EXPORT_MAX_SOURCES  32
+
+// Screen user data
+typedef struct {
+    ui_list_t list;
+    char sources[EXPORT_MAX_SOURCES][OBS_EXPORT_PATH_LEN];
+    obs_export_format_t format;
+    obs_export_sink_t sink;
+    obs_export_progress_t shown;    // Last progress drawn
+} export_data_t;
+
+static void source_row(int index, char *text, size_t len, void *user_data)
+{
+    export_data_t *data = (export_data_t *)user_data;
+    const char *name = strrchr(data->sources[index], '/');
+    snprintf(text, len, "%s", name ? name + 1 : data->sources[index]);
+}
+
+static void add_sources(export_data_t *data, const char *dir, int *count)
+{
+    DIR *d = opendir(dir);
+    if (!d) return;
+    struct dirent *entry;
+    while (*count < EXPORT_MAX_SOURCES && (entry = readdir(d)) != NULL) {
+        if (!obs_export_is_source(entry->d_name)) continue;
+        snprintf(data->sources[*count], OBS_EXPORT_PATH_LEN, "%s/%s", dir, entry->d_name);
+        (*count)++;
+    }
+    closedir(d);
+}
+
+static void load_sources(export_data_t *data)
+{
+    int count = 0;
+    add_sources(data, WARDRIVE_LOG_DIR, &count);
+    add_sources(data, SESSION_LOG_DIR, &count);
+    ui_list_set_count(&data->list, count);
+}
+
+static void draw_status(export_data_t *data)
+{
+    obs_export_progress_t *p = &data->shown;
+    char status[48];
+    switch (p->state) {
+        case OBS_EXPORT_RUNNING:
+            snprintf(status, sizeof(status), "%lu%% %lu obs ESC:Stop",
+                     (unsigned long)(p->source_size ? (uint64_t)p->source_done * 100 / p->source_size : 0),
+                     (unsigned long)p->observations);
+            break;
+        case OBS_EXPORT_DONE:
+        case OBS_EXPORT_CANCELLED:
+            snprintf(status, sizeof(status), "%s %lu obs, %luKB",
+                     p->state == OBS_EXPORT_DONE ? "Done" : "Stopped",
+                     (unsigned long)p->observations, (unsigned long)(p->bytes / 1024));
+            break;
+        case OBS_EXPORT_FAILED:
+            snprintf(status, sizeof(status), "Failed, %lu obs written",
+                     (unsigned long)p->observations);
+            break;
+        default:
+            snprintf(status, sizeof(status), "F:%s U:%s ENT:Go", obs_export_format_name(data->format),
+                     data->sink == OBS_EXPORT_TO_USB ? "USB" : "SD");
+            break;
+    }
+    ui_list_draw_status(&data->list, status);
+}
+
+static void draw_screen(screen_t *self)
+{
+    export_data_t *data = (export_data_t *)self->user_data;
+    
+    ui_clear();
+    ui_draw_title("Data Export");
+    
+    if (data->list.count == 0) {
+        ui_print_center(ui_rows() / 2 - 1, "No logs on the card", UI_COLOR_DIMMED);
+    } else {
+        ui_list_draw(&data->list);
+    }
+    draw_status(data);
+}
+
+static void on_tick(screen_t *self)
+{
+    export_data_t *data = (export_data_t *)self->user_data;
+    
+    obs_export_progress_t p;
+    obs_export_get_progress(&p);
+    if (p.state == data->shown.state && p.source_done == data->shown.source_done &&
+        p.observations == data->shown.observations) {
+        ui_list_tick(&data->list);
+        return;
+    }
+    data->shown = p;
+    draw_status(data);
+}
+
+static void start_export(export_data_t *data)
+{
+    if (data->list.count == 0) return;
+    
+    esp_err_t ret = obs_export_start(data->sources[data->list.selected], data->format, data->sink);
+    if (ret == ESP_ERR_NOT_SUPPORTED) {
+        ui_list_draw_status(&data->list, "Format does not fit this log");
+    } else if (ret == ESP_ERR_INVALID_STATE) {
+        ui_list_draw_status(&data->list, "Busy: export or USB in use");
+    } else if (ret != ESP_OK) {
+        ui_list_draw_status(&data->list, "Cannot start export");
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    export_data_t *data = (export_data_t *)self->user_data;
+    bool running = data->shown.state == OBS_EXPORT_RUNNING;
+    
+    if (ui_list_handle_key(&data->list, key)) {
+        ui_list_draw(&data->list);
+        return;
+    }
+    
+    switch (key) {
+        case KEY_ENTER:
+            if (!running) start_export(data);
+            break;
+            
+        case KEY_F:
+            if (running) break;
+            data->format = (data->format + 1) % OBS_EXPORT_FORMAT_COUNT;
+            data->shown.state = OBS_EXPORT_IDLE;
+            draw_status(data);
+            break;
+            
+        case KEY_U:
+            if (running) break;
+            data->sink = data->sink == OBS_EXPORT_TO_SD ? OBS_EXPORT_TO_USB : OBS_EXPORT_TO_SD;
+            data->shown.state = OBS_EXPORT_IDLE;
+            draw_status(data);
+            break;
+            
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            // First press stops a running export, the next leaves
+            if (running) {
+                obs_export_cancel();
+            } else {
+                screen_manager_pop();
+            }
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    free(self->user_data);
+}
+
+static void on_resume(screen_t *self)
+{
+    draw_screen(self);
+}
+
+screen_t* export_screen_create(void *params)
+{
+    (void)params;
+    ESP_LOGI(TAG, "Creating export screen...");
+    
+    screen_t *screen = screen_alloc();
+    export_data_t *data = screen ? calloc(1, sizeof(export_data_t)) : NULL;
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    screen_set_density(screen, UI_DENSITY_COMPACT);
+    ui_list_init(&data->list, 1, UI_LIST_MAX_ROWS, source_row, data);
+    ui_list_set_marquee(&data->list, true);
+    load_sources(data);
+    obs_export_get_progress(&data->shown);
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_resume = on_resume;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    screen->tick_ms = UI_MARQUEE_STEP_MS;
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "Export screen created");
+    return screen;
+}
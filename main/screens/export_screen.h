@@ -0,0 +1,18 @@
+/**
+ * @file export_screen.h
+ * @brief Pick a log on the card and export it (obs_export)
+ */
+
+#ifndef EXPORT_SCREEN_H
+#define EXPORT_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the data export screen
+ * @param params Unused (NULL)
+ * @return Created screen or NULL on failure
+ */
+screen_t* export_screen_create(void *params);
+
+#endif // EXPORT_SCREEN_H
@@ -0,0 +1,217 @@
+/**
+ * @file file_xfer_screen.c
+ * @brief Push portal templates to JanOS and follow file transfers (file_xfer)
+ *
+ * Lists the .html templates in FILE_XFER_PUSH_DIR; ENTER sends the
+ * selected one to FILE_XFER_JANOS_HTML_DIR, where the portal screens find
+ * it. The handshakes screen opens this screen after starting a pull, so
+ * either direction shows its progress in the status bar until it ends.
+ */
+
+#include "file_xfer_screen.h"
+#include "file_xfer.h"
+#include "sd_listing.h"
+#include "text_ui.h"
+#include "ui_list.h"
+#include "esp_log.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static const char *TAG = "FILE_XFER_SCREEN";
+
+#define XFER_MAX_TEMPLATES  32
+#define XFER_NAME_LEN       48
+
+// Screen user data
+typedef struct {
+    ui_list_t list;
+    char names[XFER_MAX_TEMPLATES][XFER_NAME_LEN];
+    file_xfer_progress_t shown;     // Last progress drawn
+} xfer_data_t;
+
+static void template_row(int index, char *text, size_t len, void *user_data)
+{
+    xfer_data_t *data = (xfer_data_t *)user_data;
+    snprintf(text, len, "%s", data->names[index]);
+}
+
+static bool is_template(const char *name)
+{
+    size_t len = strlen(name);
+    return len > 5 && len < XFER_NAME_LEN && strcasecmp(name + len - 5, ".html") == 0;
+}
+
+static void load_templates(xfer_data_t *data)
+{
+    int count = 0;
+    DIR *d = opendir(FILE_XFER_PUSH_DIR);
+    if (d) {
+        struct dirent *entry;
+        while (count < XFER_MAX_TEMPLATES && (entry = readdir(d)) != NULL) {
+            if (!is_template(entry->d_name)) continue;
+            strlcpy(data->names[count++], entry->d_name, XFER_NAME_LEN);
+        }
+        closedir(d);
+    }
+    ui_list_set_count(&data->list, count);
+}
+
+static void draw_status(xfer_data_t *data)
+{
+    file_xfer_progress_t *p = &data->shown;
+    const char *verb = p->dir == FILE_XFER_PUSH ? "Push" : "Pull";
+    // Rate over this attempt only, resumed bytes were not moved now
+    unsigned long kbps = p->elapsed_ms ?
+        (unsigned long)((uint64_t)(p->done - p->resumed_from) * 1000 / p->elapsed_ms / 1024) : 0;
+    char status[48];
+    switch (p->state) {
+        case FILE_XFER_RUNNING:
+            snprintf(status, sizeof(status), "%s %lu%% %luKB/s ESC:Stop", verb,
+                     (unsigned long)(p->size ? (uint64_t)p->done * 100 / p->size : 0), kbps);
+            break;
+        case FILE_XFER_DONE:
+            snprintf(status, sizeof(status), "%s done %luKB %luKB/s", verb,
+                     (unsigned long)(p->size / 1024), kbps);
+            break;
+        case FILE_XFER_CANCELLED:
+            snprintf(status, sizeof(status), "%s stopped at %luKB", verb,
+                     (unsigned long)(p->done / 1024));
+            break;
+        case FILE_XFER_FAILED:
+            snprintf(status, sizeof(status), "%s", p->error[0] ? p->error : "Transfer failed");
+            break;
+        default:
+            snprintf(status, sizeof(status), "ENT:Push to JanOS ESC:Exit");
+            break;
+    }
+    ui_list_draw_status(&data->list, status);
+}
+
+static void draw_screen(screen_t *self)
+{
+    xfer_data_t *data = (xfer_data_t *)self->user_data;
+    
+    ui_clear();
+    ui_draw_title("File Transfer");
+    
+    if (data->list.count == 0) {
+        ui_print_center(ui_rows() / 2 - 1, "No templates in " FILE_XFER_PUSH_DIR, UI_COLOR_DIMMED);
+    } else {
+        ui_list_draw(&data->list);
+    }
+    draw_status(data);
+}
+
+static void on_tick(screen_t *self)
+{
+    xfer_data_t *data = (xfer_data_t *)self->user_data;
+    
+    file_xfer_progress_t p;
+    file_xfer_get_progress(&p);
+    if (p.state == data->shown.state && p.done == data->shown.done && p.size == data->shown.size) {
+        ui_list_tick(&data->list);
+        return;
+    }
+    // The JanOS listing cached for the portal screens lacks the new template
+    if (p.state == FILE_XFER_DONE && data->shown.state == FILE_XFER_RUNNING && p.dir == FILE_XFER_PUSH) {
+        sd_listing_invalidate();
+    }
+    data->shown = p;
+    draw_status(data);
+}
+
+static void start_push(xfer_data_t *data)
+{
+    if (data->list.count == 0) return;
+    
+    const char *name = data->names[data->list.selected];
+    char local[FILE_XFER_PATH_LEN];
+    char remote[FILE_XFER_PATH_LEN];
+    snprintf(local, sizeof(local), "%s/%s", FILE_XFER_PUSH_DIR, name);
+    snprintf(remote, sizeof(remote), "%s/%s", FILE_XFER_JANOS_HTML_DIR, name);
+    
+    esp_err_t ret = file_xfer_push(local, remote);
+    if (ret == ESP_ERR_NOT_SUPPORTED) {
+        ui_list_draw_status(&data->list, "Needs binary link to JanOS");
+    } else if (ret == ESP_ERR_INVALID_STATE) {
+        ui_list_draw_status(&data->list, "Busy: transfer or USB drive");
+    } else if (ret != ESP_OK) {
+        ui_list_draw_status(&data->list, "Cannot start transfer");
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    xfer_data_t *data = (xfer_data_t *)self->user_data;
+    bool running = data->shown.state == FILE_XFER_RUNNING;
+    
+    if (ui_list_handle_key(&data->list, key)) {
+        ui_list_draw(&data->list);
+        return;
+    }
+    
+    switch (key) {
+        case KEY_ENTER:
+            if (!running) start_push(data);
+            break;
+            
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            // First press stops a running transfer, the next leaves
+            if (running) {
+                file_xfer_cancel();
+            } else {
+                screen_manager_pop();
+            }
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    free(self->user_data);
+}
+
+static void on_resume(screen_t *self)
+{
+    draw_screen(self);
+}
+
+screen_t* file_xfer_screen_create(void *params)
+{
+    (void)params;
+    ESP_LOGI(TAG, "Creating file transfer screen...");
+    
+    screen_t *screen = screen_alloc();
+    xfer_data_t *data = screen ? calloc(1, sizeof(xfer_data_t)) : NULL;
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    screen_set_density(screen, UI_DENSITY_COMPACT);
+    ui_list_init(&data->list, 1, UI_LIST_MAX_ROWS, template_row, data);
+    ui_list_set_marquee(&data->list, true);
+    load_templates(data);
+    file_xfer_get_progress(&data->shown);
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_resume = on_resume;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    screen->tick_ms = UI_MARQUEE_STEP_MS;
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "File transfer screen created");
+    return screen;
+}
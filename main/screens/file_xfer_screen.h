@@ -0,0 +1,18 @@
+/**
+ * @file file_xfer_screen.h
+ * @brief Push portal templates to JanOS and follow file transfers (file_xfer)
+ */
+
+#ifndef FILE_XFER_SCREEN_H
+#define FILE_XFER_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the file transfer screen
+ * @param params Unused (NULL)
+ * @return Created screen or NULL on failure
+ */
+screen_t* file_xfer_screen_create(void *params);
+
+#endif // FILE_XFER_SCREEN_H
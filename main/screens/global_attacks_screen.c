@@ -4,6 +4,7 @@
  */
 
 #include "global_attacks_screen.h"
+#include "screen_registry.h"
 #include "blackout_screen.h"
 #include "global_handshaker_screen.h"
 #include "text_input_screen.h"
@@ -12,6 +13,7 @@
 #include "wardrive_screen.h"
 #include "placeholder_screen.h"
 #include "settings.h"
+#include "listing_prefetch.h"
 #include "text_ui.h"
 #include "esp_log.h"
 #include <string.h>
@@ -65,7 +67,7 @@ static void on_portal_ssid_entered(const char *ssid, void *user_data)
         
         // Pop the text input screen and push HTML selection
         screen_manager_pop();
-        screen_manager_push(global_portal_html_screen_create, params);
+        if (screen_manager_push(global_portal_html_screen_create, params) == ESP_ERR_NO_MEM) free(params);
     }
 }
 
@@ -96,11 +98,24 @@ static void draw_screen(screen_t *self)
     ui_draw_status("UP/DOWN:Nav ENTER:Select ESC:Back");
 }
 
+/**
+ * @brief Fetch the HTML file list while Portal is highlighted
+ *
+ * Not dropped on Enter: the picker opens after the SSID is typed.
+ */
+static void prefetch_selected(global_attacks_data_t *data)
+{
+    bool portal = data->visible_count > 0 &&
+                  data->visible_attacks[data->selected_index] == GLOBAL_ATK_PORTAL;
+    listing_prefetch_hover(portal ? LISTING_HTML_FILES : LISTING_NONE);
+}
+
 // Optimized: redraw only two changed rows
 static void redraw_selection(global_attacks_data_t *data, int old_index, int new_index)
 {
     ui_draw_menu_item(old_index + 1, data->visible_names[old_index], false, false, false);
     ui_draw_menu_item(new_index + 1, data->visible_names[new_index], true, false, false);
+    prefetch_selected(data);
 }
 
 static void on_key(screen_t *self, key_code_t key)
@@ -155,7 +170,9 @@ static void on_key(screen_t *self, key_code_t key)
                                 params->hint = "Use keyboard, ENTER to confirm";
                                 params->on_submit = on_portal_ssid_entered;
                                 params->user_data = NULL;
-                                screen_manager_push(text_input_screen_create, params);
+                                params->history = "portal_ssid";
+                                params->complete_ssids = true;
+                                if (screen_manager_push(text_input_screen_create, params) == ESP_ERR_NO_MEM) free(params);
                             }
                         }
                         break;
@@ -187,6 +204,7 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
+    listing_prefetch_cancel();
     if (self->user_data) {
         free(self->user_data);
     }
@@ -195,6 +213,7 @@ static void on_destroy(screen_t *self)
 static void on_resume(screen_t *self)
 {
     draw_screen(self);
+    prefetch_selected((global_attacks_data_t *)self->user_data);
 }
 
 static void build_visible_global_attacks(global_attacks_data_t *data)
@@ -244,9 +263,10 @@ screen_t* global_attacks_screen_create(void *params)
     
     // Draw initial screen
     draw_screen(screen);
+    prefetch_selected(data);
     
     ESP_LOGI(TAG, "Global attacks screen created");
     return screen;
 }
 
-
+SCREEN_REGISTER(HOME, 20, global_attacks_screen_create, 0, "Global WiFi Attacks", "Global WiFi Tests");
@@ -1,87 +1,73 @@
 /**
  * @file global_handshaker_screen.c
  * @brief Global Handshaker attack screen implementation
+ *
+ * A global run attacks every network it finds, so it can capture from
+ * hundreds of APs. Each AP is one row of a virtualized list, first
+ * captured first, with its BSSID tail, capture count and V once an
+ * authorized pair is in; the totals stay exact however long the run.
  */
 
 #include "global_handshaker_screen.h"
 #include "uart_handler.h"
 #include "text_ui.h"
+#include "ui_list.h"
+#include "world_model.h"
 #include "buzzer.h"
 #include "esp_log.h"
-#include "esp_timer.h"
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 static const char *TAG = "GLOBAL_HS";
 
-// Maximum SSID length
-#define MAX_SSID_LEN 33
-
-// Refresh timer interval (200ms)
-#define REFRESH_INTERVAL_US  200000
+#define SUMMARY_ROWS    2       // Last capture, totals
+#define AP_COLS         13      // " 12291C x12 V"
 
 // Screen user data
 typedef struct {
-    char last_ssid[MAX_SSID_LEN];
-    int total_count;
-    bool needs_redraw;
-    esp_timer_handle_t refresh_timer;
+    ui_list_t list;
+    world_capture_run_t run;    // Captures per AP since the attack started
     screen_t *self;
 } global_handshaker_data_t;
 
-// Forward declaration
-static void draw_screen(screen_t *self);
-
-/**
- * @brief Timer callback - checks if redraw is needed
- */
-static void refresh_timer_callback(void *arg)
+static void ap_row(int index, char *text, size_t len, void *user_data)
 {
-    global_handshaker_data_t *data = (global_handshaker_data_t *)arg;
-    if (data && data->needs_redraw && data->self) {
-        data->needs_redraw = false;
-        draw_screen(data->self);
+    global_handshaker_data_t *data = (global_handshaker_data_t *)user_data;
+    world_capture_ap_t ap;
+    int name_cols = (int)len - 2 - AP_COLS;
+
+    if (!world_model_capture_run_get(&data->run, index, &ap)) {
+        snprintf(text, len, "(forgotten)");
+        return;
     }
+    char mac[8] = "------";
+    if (ap.has_mac) snprintf(mac, sizeof(mac), "%06lX", (unsigned long)ap.mac_tail);
+    snprintf(text, len, "%-*.*s %s x%-2u %c", name_cols, name_cols,
+             ap.ssid[0] ? ap.ssid : "[Hidden]", mac, (unsigned)ap.captures,
+             world_capture_ap_verified(&ap) ? 'V' : ' ');
 }
 
-/**
- * @brief UART line callback for parsing handshake capture output
- */
-static void uart_line_callback(const char *line, void *user_data)
+static void draw_summary(global_handshaker_data_t *data)
 {
-    global_handshaker_data_t *data = (global_handshaker_data_t *)user_data;
-    if (!data) return;
-    
-    // Look for: "Complete 4-way handshake saved for SSID: [SSID]"
-    const char *marker = "Complete 4-way handshake saved for SSID: ";
-    const char *found = strstr(line, marker);
-    
-    if (found) {
-        // Extract SSID - it's after the marker, until end of line or ' ('
-        const char *ssid_start = found + strlen(marker);
-        const char *ssid_end = strchr(ssid_start, ' ');
-        if (!ssid_end) {
-            ssid_end = ssid_start + strlen(ssid_start);
-        }
-        
-        size_t ssid_len = ssid_end - ssid_start;
-        if (ssid_len >= MAX_SSID_LEN) {
-            ssid_len = MAX_SSID_LEN - 1;
-        }
-        
-        // Store last SSID
-        strncpy(data->last_ssid, ssid_start, ssid_len);
-        data->last_ssid[ssid_len] = '\0';
-        
-        // Increment total count
-        data->total_count++;
-        
-        ESP_LOGI(TAG, "Handshake #%d captured for SSID: %s", 
-                 data->total_count, data->last_ssid);
-        
-        // Signal redraw needed - timer will handle it
-        data->needs_redraw = true;
+    char line[UI_COLS_MAX + 1];
+    int row = ui_rows() - 1 - SUMMARY_ROWS;
+    uint32_t total = world_model_handshake_count() - data->run.start_seq;
+
+    world_handshake_t hs;
+    if (total > 0 && world_model_handshake_get(world_model_handshake_count(), &hs)) {
+        snprintf(line, sizeof(line), "Last: %-*.*s", ui_cols() - 6, ui_cols() - 6, hs.ssid);
+        ui_print(0, row, line, UI_COLOR_HIGHLIGHT);
+    } else {
+        snprintf(line, sizeof(line), "%-*s", ui_cols(), "Last: -");
+        ui_print(0, row, line, UI_COLOR_DIMMED);
     }
+
+    char totals[48];
+    snprintf(totals, sizeof(totals), "Total %lu  APs %d  Verified %d",
+             (unsigned long)total, data->run.aps, data->run.verified);
+    snprintf(line, sizeof(line), "%-*s", ui_cols(), totals);
+    ui_print(0, row + 1, line, UI_COLOR_TEXT);
 }
 
 static void draw_screen(screen_t *self)
@@ -93,29 +79,27 @@ static void draw_screen(screen_t *self)
     // Draw title
     ui_draw_title("Global Handshaker");
     
-    int row = 2;
-    
-    // Last handshake
-    if (data->last_ssid[0] != '\0') {
-        char line[48];
-        snprintf(line, sizeof(line), "Last handshake: %.20s", data->last_ssid);
-        ui_print(0, row, line, UI_COLOR_HIGHLIGHT);
+    ui_list_set_count(&data->list, data->run.aps);
+    if (data->run.aps == 0) {
+        ui_print_center(ui_rows() / 2 - 2, "Waiting for handshake...", UI_COLOR_DIMMED);
     } else {
-        ui_print(0, row, "Last handshake: -", UI_COLOR_DIMMED);
+        ui_list_draw(&data->list);
     }
-    row += 2;
-    
-    // Total count
-    char total_line[32];
-    snprintf(total_line, sizeof(total_line), "Total: %d", data->total_count);
-    ui_print(0, row, total_line, UI_COLOR_TEXT);
+    draw_summary(data);
     
     // Draw status bar
-    ui_draw_status("ESC: Stop");
+    ui_draw_status("UP/DN:Scroll ESC:Stop");
 }
 
 static void on_key(screen_t *self, key_code_t key)
 {
+    global_handshaker_data_t *data = (global_handshaker_data_t *)self->user_data;
+    
+    if (ui_list_handle_key(&data->list, key)) {
+        ui_list_draw(&data->list);
+        return;
+    }
+    
     switch (key) {
         case KEY_ESC:
         case KEY_Q:
@@ -130,18 +114,27 @@ static void on_key(screen_t *self, key_code_t key)
     }
 }
 
-static void on_destroy(screen_t *self)
+static void on_tick(screen_t *self)
 {
     global_handshaker_data_t *data = (global_handshaker_data_t *)self->user_data;
     
-    // Stop and delete timer
-    if (data && data->refresh_timer) {
-        esp_timer_stop(data->refresh_timer);
-        esp_timer_delete(data->refresh_timer);
-    }
+    // Take in the captures world_model filed since the last tick
+    int aps = data->run.aps;
+    if (!world_model_capture_run_update(&data->run)) return;
     
-    // Clear UART callback
-    uart_clear_line_callback();
+    if (aps == 0) {
+        draw_screen(self);
+        return;
+    }
+    // Only rows whose text changed are repainted
+    ui_list_set_count(&data->list, data->run.aps);
+    ui_list_draw(&data->list);
+    draw_summary(data);
+}
+
+static void on_destroy(screen_t *self)
+{
+    global_handshaker_data_t *data = (global_handshaker_data_t *)self->user_data;
     
     if (data) {
         free(data);
@@ -165,29 +158,16 @@ screen_t* global_handshaker_screen_create(void *params)
     }
     
     data->self = screen;
-    data->last_ssid[0] = '\0';
-    data->total_count = 0;
+    world_model_capture_run_start(&data->run);
+    screen_set_density(screen, UI_DENSITY_COMPACT);
+    ui_list_init(&data->list, 1, ui_rows() - 2 - SUMMARY_ROWS, ap_row, data);
     
     screen->user_data = data;
     screen->on_key = on_key;
     screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
-    
-    // Create periodic refresh timer
-    esp_timer_create_args_t timer_args = {
-        .callback = refresh_timer_callback,
-        .arg = data,
-        .name = "ghs_refresh"
-    };
-    
-    if (esp_timer_create(&timer_args, &data->refresh_timer) == ESP_OK) {
-        esp_timer_start_periodic(data->refresh_timer, REFRESH_INTERVAL_US);
-    } else {
-        ESP_LOGW(TAG, "Failed to create refresh timer");
-    }
-    
-    // Register UART callback for parsing handshake output
-    uart_register_line_callback(uart_line_callback, data);
+    screen->on_tick = on_tick;
+    screen->tick_on_uart = true;    // on_tick only redraws on new captures
     
     // Send start_handshake command (no select_networks needed)
     uart_send_command("start_handshake");
@@ -199,13 +179,3 @@ screen_t* global_handshaker_screen_create(void *params)
     ESP_LOGI(TAG, "Global handshaker screen created");
     return screen;
 }
-
-
-
-
-
-
-
-
-
-
@@ -1,32 +1,33 @@
 /**
  * @file global_portal_html_screen.c
  * @brief HTML selection screen for Global Portal attack
+ *
+ * P previews the text of the template under the cursor.
  */
 
 #include "global_portal_html_screen.h"
 #include "global_portal_screen.h"
 #include "uart_handler.h"
+#include "sd_listing.h"
+#include "html_preview.h"
+#include "cred_store.h"
 #include "text_ui.h"
 #include "buzzer.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
 
 static const char *TAG = "GPORTAL_HTML";
 
-// Maximum HTML files and visible items
-#define MAX_HTML_FILES  24
 #define VISIBLE_ITEMS   6
-#define MAX_FILENAME_LEN 32
 
 // Screen user data
 typedef struct {
     char ssid[33];
-    char html_files[MAX_HTML_FILES][MAX_FILENAME_LEN];
-    int file_ids[MAX_HTML_FILES];
+    sd_file_t files[SD_LISTING_MAX_FILES];
     int file_count;
+    uint32_t listing_generation;
     int selected_index;
     int scroll_offset;
     bool loading;
@@ -38,68 +39,28 @@ typedef struct {
 static void draw_screen(screen_t *self);
 
 /**
- * @brief UART line callback for parsing list_sd output
+ * @brief Take the HTML files from the shared SD listing
  */
-static void uart_line_callback(const char *line, void *user_data)
+static void load_files(global_portal_html_data_t *data)
 {
-    global_portal_html_data_t *data = (global_portal_html_data_t *)user_data;
-    if (!data || data->file_count >= MAX_HTML_FILES) return;
-    
-    // Skip header line
-    if (strstr(line, "HTML files found") != NULL) {
-        return;
-    }
-    
-    // Parse lines like "1 PLAY.html"
-    const char *ptr = line;
-    
-    // Skip leading whitespace
-    while (*ptr && isspace((unsigned char)*ptr)) ptr++;
-    
-    // Check if starts with digit
-    if (!isdigit((unsigned char)*ptr)) return;
-    
-    // Parse the number
-    int file_id = 0;
-    while (*ptr && isdigit((unsigned char)*ptr)) {
-        file_id = file_id * 10 + (*ptr - '0');
-        ptr++;
-    }
-    
-    // Skip whitespace after number
-    while (*ptr && isspace((unsigned char)*ptr)) ptr++;
-    
-    // Rest is filename - check if it ends with .html
-    if (strlen(ptr) < 6) return;
-    if (strstr(ptr, ".html") == NULL) return;
-    
-    // Store the file
-    strncpy(data->html_files[data->file_count], ptr, MAX_FILENAME_LEN - 1);
-    data->html_files[data->file_count][MAX_FILENAME_LEN - 1] = '\0';
-    
-    // Remove trailing whitespace/newline
-    char *end = data->html_files[data->file_count] + strlen(data->html_files[data->file_count]) - 1;
-    while (end > data->html_files[data->file_count] && isspace((unsigned char)*end)) {
-        *end = '\0';
-        end--;
-    }
-    
-    data->file_ids[data->file_count] = file_id;
-    data->file_count++;
-    
-    ESP_LOGI(TAG, "Found HTML file [%d]: %s", file_id, data->html_files[data->file_count - 1]);
-    
-    // Update loading state
-    if (data->loading && data->file_count > 0) {
-        data->loading = false;
-        data->needs_redraw = true;
+    data->listing_generation = sd_listing_generation();
+    data->file_count = sd_listing_copy(SD_LISTING_HTML, data->files, SD_LISTING_MAX_FILES);
+    data->loading = data->file_count == 0 && sd_listing_state() == SD_LISTING_LOADING;
+    if (data->selected_index >= data->file_count) {
+        data->selected_index = 0;
+        data->scroll_offset = 0;
     }
 }
 
 static void on_tick(screen_t *self)
 {
     global_portal_html_data_t *data = (global_portal_html_data_t *)self->user_data;
-    if (data && data->needs_redraw) {
+    if (sd_listing_generation() != data->listing_generation) {
+        load_files(data);
+        data->needs_redraw = true;
+    }
+    
+    if (data->needs_redraw) {
         data->needs_redraw = false;
         draw_screen(self);
     }
@@ -114,7 +75,7 @@ static void draw_file_row(global_portal_html_data_t *data, int file_idx)
     int start_row = 1;
     
     char label[28];
-    strncpy(label, data->html_files[file_idx], sizeof(label) - 1);
+    strncpy(label, data->files[file_idx].name, sizeof(label) - 1);
     label[sizeof(label) - 1] = '\0';
     char *ext = strstr(label, ".html");
     if (ext) *ext = '\0';
@@ -152,7 +113,7 @@ static void draw_screen(screen_t *self)
             if (file_idx < data->file_count) {
                 // Truncate filename for display
                 char label[28];
-                strncpy(label, data->html_files[file_idx], sizeof(label) - 1);
+                strncpy(label, data->files[file_idx].name, sizeof(label) - 1);
                 label[sizeof(label) - 1] = '\0';
                 
                 // Remove .html extension for cleaner display
@@ -188,7 +149,7 @@ static void draw_screen(screen_t *self)
     if (data->loading) {
         ui_draw_status("Loading HTML files...");
     } else {
-        ui_draw_status("ENTER:Select ESC:Back");
+        ui_draw_status("ENTER:Select P:View ESC:Back");
     }
 }
 
@@ -198,19 +159,18 @@ static void launch_portal(global_portal_html_data_t *data)
         return;
     }
     
-    // Send select_html command with the 1-based ID
+    // select_html with the 1-based ID, then start_portal with the SSID
     char cmd[32];
-    snprintf(cmd, sizeof(cmd), "select_html %d", data->file_ids[data->selected_index]);
-    uart_send_command(cmd);
-    
-    ESP_LOGI(TAG, "Selected HTML portal: %s (ID: %d)", 
-             data->html_files[data->selected_index], 
-             data->file_ids[data->selected_index]);
-    
-    // Send start_portal command with SSID
+    snprintf(cmd, sizeof(cmd), "select_html %d", data->files[data->selected_index].id);
     char portal_cmd[64];
     snprintf(portal_cmd, sizeof(portal_cmd), "start_portal %s", data->ssid);
-    uart_send_command(portal_cmd);
+    const char *const sequence[] = { cmd, portal_cmd };
+    uart_send_batch(sequence, 2, NULL, NULL);
+    
+    ESP_LOGI(TAG, "Selected HTML portal: %s (ID: %d)", 
+             data->files[data->selected_index].name, 
+             data->files[data->selected_index].id);
+    cred_store_set_portal_ssid(data->ssid);
     buzzer_beep_attack();
     
     // Create portal running screen params
@@ -218,7 +178,7 @@ static void launch_portal(global_portal_html_data_t *data)
     if (params) {
         strncpy(params->ssid, data->ssid, sizeof(params->ssid) - 1);
         params->ssid[sizeof(params->ssid) - 1] = '\0';
-        screen_manager_push(global_portal_screen_create, params);
+        if (screen_manager_push(global_portal_screen_create, params) == ESP_ERR_NO_MEM) free(params);
     }
 }
 
@@ -277,6 +237,12 @@ static void on_key(screen_t *self, key_code_t key)
             }
             break;
             
+        case KEY_P:
+            if (!data->loading && data->selected_index < data->file_count) {
+                html_preview_show(&data->files[data->selected_index]);
+            }
+            break;
+            
         case KEY_ESC:
         case KEY_BACKSPACE:
             screen_manager_pop();
@@ -289,9 +255,6 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
-    // Clear UART callback
-    uart_clear_line_callback();
-    
     if (self->user_data) {
         free(self->user_data);
     }
@@ -334,11 +297,9 @@ screen_t* global_portal_html_screen_create(void *params)
     screen->on_draw = draw_screen;
     screen->on_tick = on_tick;
     
-    // Register UART callback for parsing list_sd output
-    uart_register_line_callback(uart_line_callback, data);
-    
-    // Send list_sd command
-    uart_send_command("list_sd");
+    // Cached listing shows at once; list_sd runs only the first time
+    sd_listing_refresh(false);
+    load_files(data);
     
     // Request initial screen draw via on_tick (avoids double draw)
     data->needs_redraw = true;
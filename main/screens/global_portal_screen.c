@@ -8,43 +8,26 @@
 #include "text_ui.h"
 #include "buzzer.h"
 #include "esp_log.h"
-#include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 static const char *TAG = "GPORTAL";
 
 // Maximum length for captured data
 #define MAX_DATA_LEN 64
 
-// Refresh timer interval (200ms)
-#define REFRESH_INTERVAL_US 200000
-
 // Screen user data
 typedef struct {
     char ssid[33];
     char last_data[MAX_DATA_LEN];
     int submission_count;
-    bool needs_redraw;
-    esp_timer_handle_t refresh_timer;
     screen_t *self;
 } global_portal_data_t;
 
 // Forward declaration
 static void draw_screen(screen_t *self);
 
-/**
- * @brief Timer callback - checks if redraw is needed
- */
-static void refresh_timer_callback(void *arg)
-{
-    global_portal_data_t *data = (global_portal_data_t *)arg;
-    if (data && data->needs_redraw && data->self) {
-        data->needs_redraw = false;
-        draw_screen(data->self);
-    }
-}
-
 /**
  * @brief UART line callback for parsing form submissions
  */
@@ -70,7 +53,7 @@ static void uart_line_callback(const char *line, void *user_data)
         }
         
         data->submission_count++;
-        data->needs_redraw = true;
+        screen_manager_data_changed(data->self);
         buzzer_beep_capture();
         ESP_LOGI(TAG, "Password captured #%d: %s", data->submission_count, data->last_data);
         return;
@@ -90,7 +73,7 @@ static void uart_line_callback(const char *line, void *user_data)
         *end = '\0';
         
         data->submission_count++;
-        data->needs_redraw = true;
+        screen_manager_data_changed(data->self);
         buzzer_beep_capture();
         ESP_LOGI(TAG, "Form data captured #%d: %s", data->submission_count, data->last_data);
         return;
@@ -102,7 +85,7 @@ static void uart_line_callback(const char *line, void *user_data)
             strncpy(data->last_data, "(data saved)", MAX_DATA_LEN - 1);
         }
         data->submission_count++;
-        data->needs_redraw = true;
+        screen_manager_data_changed(data->self);
         buzzer_beep_capture();
         ESP_LOGI(TAG, "Portal data saved, submission #%d", data->submission_count);
     }
@@ -114,7 +97,7 @@ static void uart_line_callback(const char *line, void *user_data)
         const char *value = found + strlen(post_marker);
         strncpy(data->last_data, value, MAX_DATA_LEN - 1);
         data->last_data[MAX_DATA_LEN - 1] = '\0';
-        data->needs_redraw = true;
+        screen_manager_data_changed(data->self);
         ESP_LOGI(TAG, "POST data: %s", data->last_data);
     }
 }
@@ -180,15 +163,6 @@ static void on_destroy(screen_t *self)
 {
     global_portal_data_t *data = (global_portal_data_t *)self->user_data;
     
-    // Stop and delete timer
-    if (data && data->refresh_timer) {
-        esp_timer_stop(data->refresh_timer);
-        esp_timer_delete(data->refresh_timer);
-    }
-    
-    // Clear UART callback
-    uart_clear_line_callback();
-    
     if (data) {
         free(data);
     }
@@ -229,21 +203,8 @@ screen_t* global_portal_screen_create(void *params)
     screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
     
-    // Create periodic refresh timer
-    esp_timer_create_args_t timer_args = {
-        .callback = refresh_timer_callback,
-        .arg = data,
-        .name = "portal_refresh"
-    };
-    
-    if (esp_timer_create(&timer_args, &data->refresh_timer) == ESP_OK) {
-        esp_timer_start_periodic(data->refresh_timer, REFRESH_INTERVAL_US);
-    } else {
-        ESP_LOGW(TAG, "Failed to create refresh timer");
-    }
-    
     // Register UART callback for parsing form submissions
-    uart_register_line_callback(uart_line_callback, data);
+    screen_set_line_callback(screen, uart_line_callback, data);
     
     // Draw initial screen
     draw_screen(screen);
@@ -7,6 +7,8 @@
 #include "sniffer_results_screen.h"
 #include "sniffer_probes_screen.h"
 #include "uart_handler.h"
+#include "job_manager.h"
+#include "world_model.h"
 #include "text_ui.h"
 #include "buzzer.h"
 #include "esp_log.h"
@@ -18,34 +20,10 @@ static const char *TAG = "GLOBAL_SNIFF";
 // Screen user data
 typedef struct {
     int packet_count;
-    bool needs_redraw;
+    uint32_t report_seq;        // Last world_model packet report seen
     screen_t *self;
 } global_sniffer_data_t;
 
-// Forward declaration
-static void draw_screen(screen_t *self);
-
-/**
- * @brief UART line callback for parsing sniffer output
- */
-static void uart_line_callback(const char *line, void *user_data)
-{
-    global_sniffer_data_t *data = (global_sniffer_data_t *)user_data;
-    if (!data) return;
-    
-    // Parse: "Sniffer packet count: N"
-    const char *marker = "Sniffer packet count: ";
-    const char *found = strstr(line, marker);
-    
-    if (found) {
-        int count = atoi(found + strlen(marker));
-        if (count != data->packet_count) {
-            data->packet_count = count;
-            data->needs_redraw = true;
-        }
-    }
-}
-
 static void draw_screen(screen_t *self)
 {
     global_sniffer_data_t *data = (global_sniffer_data_t *)self->user_data;
@@ -64,17 +42,22 @@ static void draw_screen(screen_t *self)
     ui_print_center(5, "R: Results  P: Probes", UI_COLOR_TEXT);
     
     // Draw status bar
-    ui_draw_status("ESC: Stop");
+    ui_draw_status("ESC: Stop  B: Background");
 }
 
 static void on_tick(screen_t *self)
 {
     global_sniffer_data_t *data = (global_sniffer_data_t *)self->user_data;
     
-    // Check if redraw needed from UART callback (thread-safe)
-    if (data->needs_redraw) {
-        data->needs_redraw = false;
-        draw_screen(self);
+    // Redraw when world_model has a new packet count
+    uint32_t seq;
+    int count = world_model_sniffer_packets(&seq);
+    if (seq != data->report_seq) {
+        data->report_seq = seq;
+        if (count != data->packet_count) {
+            data->packet_count = count;
+            draw_screen(self);
+        }
     }
 }
 
@@ -93,6 +76,11 @@ static void on_key(screen_t *self, key_code_t key)
             screen_manager_push(sniffer_probes_screen_create, NULL);
             break;
             
+        case KEY_B:
+            // Keep sniffing while other views are open
+            job_manager_background(JOB_SNIFFER, self);
+            break;
+            
         case KEY_ESC:
         case KEY_Q:
         case KEY_BACKSPACE:
@@ -110,9 +98,6 @@ static void on_destroy(screen_t *self)
 {
     global_sniffer_data_t *data = (global_sniffer_data_t *)self->user_data;
     
-    // Clear UART callback
-    uart_clear_line_callback();
-    
     if (data) {
         free(data);
     }
@@ -120,14 +105,9 @@ static void on_destroy(screen_t *self)
 
 static void on_resume(screen_t *self)
 {
-    global_sniffer_data_t *data = (global_sniffer_data_t *)self->user_data;
-    
-    // Re-register UART callback after returning from sub-screens
-    uart_register_line_callback(uart_line_callback, data);
-    
     // Resume sniffer - unselect networks first (may have been selected for deauth)
-    uart_send_command("unselect_networks");
-    uart_send_command("start_sniffer_noscan");
+    static const char *const resume[] = { "unselect_networks", "start_sniffer_noscan" };
+    uart_send_batch(resume, 2, NULL, NULL);
     
     // Redraw the screen
     draw_screen(self);
@@ -150,6 +130,7 @@ screen_t* global_sniffer_screen_create(void *params)
     }
     
     data->self = screen;
+    world_model_sniffer_packets(&data->report_seq);    // Counts from earlier runs are not ours
     data->packet_count = 0;
     
     screen->user_data = data;
@@ -159,9 +140,6 @@ screen_t* global_sniffer_screen_create(void *params)
     screen->on_draw = draw_screen;
     screen->on_tick = on_tick;
     
-    // Register UART callback for parsing sniffer output
-    uart_register_line_callback(uart_line_callback, data);
-    
     // Send start_sniffer command directly (no network selection)
     uart_send_command("start_sniffer");
     buzzer_beep_attack();
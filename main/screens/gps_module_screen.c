@@ -96,7 +96,6 @@ static void on_key(screen_t *self, key_code_t key)
     // Ignore keys while loading
     if (data->loading) {
         if (key == KEY_ESC || key == KEY_Q || key == KEY_BACKSPACE) {
-            uart_clear_line_callback();
             screen_manager_pop();
         }
         return;
@@ -165,7 +164,6 @@ static void on_key(screen_t *self, key_code_t key)
         case KEY_ESC:
         case KEY_Q:
         case KEY_BACKSPACE:
-            uart_clear_line_callback();
             screen_manager_pop();
             break;
 
@@ -176,7 +174,6 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
-    uart_clear_line_callback();
     if (self->user_data) {
         free(self->user_data);
     }
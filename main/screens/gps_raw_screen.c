@@ -5,6 +5,7 @@
 
 #include "gps_raw_screen.h"
 #include "uart_handler.h"
+#include "job_manager.h"
 #include "text_ui.h"
 #include "keyboard.h"
 #include "settings.h"
@@ -47,6 +48,7 @@ typedef struct {
     bool needs_redraw;
     bool is_cap_gps;
     bool cap_inited;
+    uint32_t cap_version;       // Last cap_gps snapshot drawn
 } gps_raw_data_t;
 
 static void draw_screen(screen_t *self);
@@ -306,35 +308,34 @@ static void on_uart_response(const char *line, void *user_data)
     screen_t *self = (screen_t *)user_data;
     gps_raw_data_t *data = (gps_raw_data_t *)self->user_data;
 
-    if (strstr(line, "[GPS RAW]") != NULL) {
-        data->last_gps_us = esp_timer_get_time();
-        push_raw_line(data, line);
+    // Only "[GPS RAW]" lines are routed here
+    data->last_gps_us = esp_timer_get_time();
+    push_raw_line(data, line);
 
-        const char *text = skip_prefix(line);
-        if (text[0] == '$') {
-            data->pending_active = false;
-            data->pending_nmea[0] = '\0';
-        }
-        try_handle_line(data, text);
-        data->needs_redraw = true;
+    const char *text = skip_prefix(line);
+    if (text[0] == '$') {
+        data->pending_active = false;
+        data->pending_nmea[0] = '\0';
     }
+    try_handle_line(data, text);
+    data->needs_redraw = true;
 }
 
 static void on_tick(screen_t *self)
 {
     gps_raw_data_t *data = (gps_raw_data_t *)self->user_data;
 
-    // CAP GPS: poll position from driver
-    if (data->is_cap_gps && data->cap_inited) {
-        data->sat_count = cap_gps_get_satellites();
+    // CAP GPS: poll the driver snapshot, redraw only when it changed
+    cap_gps_snapshot_t snap;
+    if (data->is_cap_gps && data->cap_inited && cap_gps_get_snapshot(&snap) &&
+        snap.version != data->cap_version) {
+        data->cap_version = snap.version;
+        data->sat_count = snap.satellites;
         data->fix = cap_gps_has_fix();
-        if (data->fix) {
-            double lat, lon, alt, hdop;
-            if (cap_gps_get_position(&lat, &lon, &alt, &hdop)) {
-                snprintf(data->lat, sizeof(data->lat), "%.7f", lat);
-                snprintf(data->lon, sizeof(data->lon), "%.7f", lon);
-                snprintf(data->alt, sizeof(data->alt), "%.1fm", alt);
-            }
+        if (snap.fix) {
+            snprintf(data->lat, sizeof(data->lat), "%.7f", snap.lat_e7 / 1e7);
+            snprintf(data->lon, sizeof(data->lon), "%.7f", snap.lon_e7 / 1e7);
+            snprintf(data->alt, sizeof(data->alt), "%.1fm", snap.alt_dm / 10.0);
         }
         data->needs_redraw = true;
     }
@@ -397,12 +398,19 @@ static void draw_screen(screen_t *self)
     }
 
     // Draw status bar
-    ui_draw_status("ESC: Stop & Exit");
+    ui_draw_status(data->is_cap_gps ? "ESC: Stop & Exit" : "ESC: Stop  B: Background");
 }
 
 static void on_key(screen_t *self, key_code_t key)
 {
     switch (key) {
+        case KEY_B:
+            // JanOS GPS only: the CAP module is read by this screen itself
+            if (!((gps_raw_data_t *)self->user_data)->is_cap_gps) {
+                job_manager_background(JOB_GPS_RAW, self);
+            }
+            break;
+
         case KEY_ESC:
         case KEY_Q:
         case KEY_BACKSPACE:
@@ -428,9 +436,9 @@ static void on_destroy(screen_t *self)
         if (data->cap_inited) {
             cap_gps_deinit();
         }
-    } else {
+    } else if (!job_manager_is_background(self)) {
+        // A background job ends because JanOS moved on: do not stop that
         uart_send_command("stop");
-        uart_clear_line_callback();
     }
 
     if (self->user_data) {
@@ -487,7 +495,7 @@ screen_t* gps_raw_screen_create(void *params)
             ESP_LOGE(TAG, "Failed to init CAP GPS: %s", esp_err_to_name(ret));
         }
     } else {
-        uart_register_line_callback(on_uart_response, screen);
+        screen_subscribe_lines(screen, UART_ROUTE_TAG, "[GPS RAW]", on_uart_response, screen);
         uart_send_command("start_gps_raw");
     }
 
@@ -1,97 +1,57 @@
 /**
  * @file handshaker_screen.c
  * @brief Handshaker attack running screen implementation
+ *
+ * Captured APs are a virtualized list over world_model's capture run, one
+ * row per AP however many handshakes it gave.
  */
 
 #include "handshaker_screen.h"
 #include "uart_handler.h"
 #include "text_ui.h"
+#include "ui_list.h"
+#include "world_model.h"
 #include "esp_log.h"
-#include "esp_timer.h"
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 static const char *TAG = "HANDSHAKER";
 
-// Maximum captured handshakes to display
-#define MAX_CAPTURED  8
-
-// Refresh timer interval (200ms)
-#define REFRESH_INTERVAL_US  200000
+#define LIST_FIRST_ROW  4       // Below the targets and the capture count
+#define STATE_COLS      12      // " x12 Verified"
 
 // Screen user data
 typedef struct {
     wifi_network_t *networks;
     int count;
-    char captured_ssids[MAX_CAPTURED][MAX_SSID_LEN];
-    int captured_count;
-    bool needs_redraw;
-    esp_timer_handle_t refresh_timer;
+    ui_list_t list;
+    world_capture_run_t run;    // Captures per AP since the attack started
     screen_t *self;
 } handshaker_screen_data_t;
 
-// Forward declaration
-static void draw_screen(screen_t *self);
-
-/**
- * @brief Timer callback - checks if redraw is needed
- */
-static void refresh_timer_callback(void *arg)
+static void captured_row(int index, char *text, size_t len, void *user_data)
 {
-    handshaker_screen_data_t *data = (handshaker_screen_data_t *)arg;
-    if (data && data->needs_redraw && data->self) {
-        data->needs_redraw = false;
-        draw_screen(data->self);
+    handshaker_screen_data_t *data = (handshaker_screen_data_t *)user_data;
+    world_capture_ap_t ap;
+    int name_cols = (int)len - 2 - STATE_COLS;
+
+    if (!world_model_capture_run_get(&data->run, index, &ap)) {
+        snprintf(text, len, "(forgotten)");
+        return;
     }
+    snprintf(text, len, "%-*.*s x%-2u %s", name_cols, name_cols,
+             ap.ssid[0] ? ap.ssid : "[Hidden]", (unsigned)ap.captures,
+             world_capture_ap_verified(&ap) ? "Verified" : "Complete");
 }
 
-/**
- * @brief UART line callback for parsing handshake capture output
- */
-static void uart_line_callback(const char *line, void *user_data)
+static void draw_captured_count(handshaker_screen_data_t *data)
 {
-    handshaker_screen_data_t *data = (handshaker_screen_data_t *)user_data;
-    if (!data) return;
-    
-    // Look for: "Complete 4-way handshake saved for SSID: [SSID]"
-    const char *marker = "Complete 4-way handshake saved for SSID: ";
-    const char *found = strstr(line, marker);
-    
-    if (found && data->captured_count < MAX_CAPTURED) {
-        // Extract SSID - it's after the marker, until end of line or ' ('
-        const char *ssid_start = found + strlen(marker);
-        const char *ssid_end = strchr(ssid_start, ' ');
-        if (!ssid_end) {
-            ssid_end = ssid_start + strlen(ssid_start);
-        }
-        
-        size_t ssid_len = ssid_end - ssid_start;
-        if (ssid_len >= MAX_SSID_LEN) {
-            ssid_len = MAX_SSID_LEN - 1;
-        }
-        
-        // Check if we already captured this SSID
-        bool already_captured = false;
-        for (int i = 0; i < data->captured_count; i++) {
-            if (strncmp(data->captured_ssids[i], ssid_start, ssid_len) == 0 &&
-                data->captured_ssids[i][ssid_len] == '\0') {
-                already_captured = true;
-                break;
-            }
-        }
-        
-        if (!already_captured) {
-            strncpy(data->captured_ssids[data->captured_count], ssid_start, ssid_len);
-            data->captured_ssids[data->captured_count][ssid_len] = '\0';
-            data->captured_count++;
-            
-            ESP_LOGI(TAG, "Handshake captured for SSID: %s", 
-                     data->captured_ssids[data->captured_count - 1]);
-            
-            // Signal redraw needed - timer will handle it
-            data->needs_redraw = true;
-        }
-    }
+    char line[UI_COLS_MAX + 1];
+    char count[40];
+    snprintf(count, sizeof(count), "Captured %d AP(s), %d verified:", data->run.aps, data->run.verified);
+    snprintf(line, sizeof(line), "%-*s", ui_cols(), count);
+    ui_print(0, LIST_FIRST_ROW - 1, line, UI_COLOR_HIGHLIGHT);
 }
 
 static void draw_screen(screen_t *self)
@@ -130,32 +90,27 @@ static void draw_screen(screen_t *self)
     ui_print(0, row, networks_line, UI_COLOR_TEXT);
     row++;
     
-    // Empty row
-    row++;
-    
-    // Captured handshakes section
-    if (data->captured_count > 0) {
-        ui_print(0, row, "Captured:", UI_COLOR_HIGHLIGHT);
-        row++;
-        
-        for (int i = 0; i < data->captured_count && row < 7; i++) {
-            char line[48];
-            snprintf(line, sizeof(line), " %.18s - Complete!", data->captured_ssids[i]);
-            ui_print(0, row, line, RGB565(0, 255, 0));  // Bright green
-            row++;
-        }
+    // Captured APs section
+    ui_list_set_count(&data->list, data->run.aps);
+    if (data->run.aps > 0) {
+        draw_captured_count(data);
+        ui_list_draw(&data->list);
     } else {
-        ui_print(0, row, "Waiting for handshake...", UI_COLOR_DIMMED);
+        ui_print(0, LIST_FIRST_ROW - 1, "Waiting for handshake...", UI_COLOR_DIMMED);
     }
     
     // Draw status bar
-    ui_draw_status("ESC: Stop");
+    ui_draw_status("UP/DN:Scroll ESC:Stop");
 }
 
 static void on_key(screen_t *self, key_code_t key)
 {
     handshaker_screen_data_t *data = (handshaker_screen_data_t *)self->user_data;
-    (void)data;  // May be unused now
+    
+    if (ui_list_handle_key(&data->list, key)) {
+        ui_list_draw(&data->list);
+        return;
+    }
     
     switch (key) {
         case KEY_ESC:
@@ -170,18 +125,27 @@ static void on_key(screen_t *self, key_code_t key)
     }
 }
 
-static void on_destroy(screen_t *self)
+static void on_tick(screen_t *self)
 {
     handshaker_screen_data_t *data = (handshaker_screen_data_t *)self->user_data;
     
-    // Stop and delete timer
-    if (data && data->refresh_timer) {
-        esp_timer_stop(data->refresh_timer);
-        esp_timer_delete(data->refresh_timer);
-    }
+    // Take in the captures world_model filed since the last tick
+    int aps = data->run.aps;
+    if (!world_model_capture_run_update(&data->run)) return;
     
-    // Clear UART callback
-    uart_clear_line_callback();
+    if (aps == 0) {
+        draw_screen(self);
+        return;
+    }
+    // Only rows whose text changed are repainted
+    draw_captured_count(data);
+    ui_list_set_count(&data->list, data->run.aps);
+    ui_list_draw(&data->list);
+}
+
+static void on_destroy(screen_t *self)
+{
+    handshaker_screen_data_t *data = (handshaker_screen_data_t *)self->user_data;
     
     if (data) {
         if (data->networks) {
@@ -222,28 +186,17 @@ screen_t* handshaker_screen_create(void *params)
     data->networks = hs_params->networks;
     data->count = hs_params->count;
     data->self = screen;
+    world_model_capture_run_start(&data->run);  // Earlier captures are not listed
     free(hs_params);
+    screen_set_density(screen, UI_DENSITY_COMPACT);
+    ui_list_init(&data->list, LIST_FIRST_ROW, ui_rows() - 1 - LIST_FIRST_ROW, captured_row, data);
     
     screen->user_data = data;
     screen->on_key = on_key;
     screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
-    
-    // Create periodic refresh timer
-    esp_timer_create_args_t timer_args = {
-        .callback = refresh_timer_callback,
-        .arg = data,
-        .name = "hs_refresh"
-    };
-    
-    if (esp_timer_create(&timer_args, &data->refresh_timer) == ESP_OK) {
-        esp_timer_start_periodic(data->refresh_timer, REFRESH_INTERVAL_US);
-    } else {
-        ESP_LOGW(TAG, "Failed to create refresh timer");
-    }
-    
-    // Register UART callback for parsing handshake output
-    uart_register_line_callback(uart_line_callback, data);
+    screen->on_tick = on_tick;
+    screen->tick_on_uart = true;    // on_tick only redraws on new captures
     
     // Draw initial screen
     draw_screen(screen);
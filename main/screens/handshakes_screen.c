@@ -2,155 +2,172 @@
  * @file handshakes_screen.c
  * @brief Captured handshakes display screen implementation
  * 
- * Sends "list_dir /sdcard/lab/handshakes" command and parses output.
- * Filters for .pcap files only (ignores .hccapx) and displays
- * filenames without extension.
- * 
- * Example output:
- * Files in /sdcard/lab/handshakes:
- * 1 VMA84A66C-2.4_83C73F_91148.hccapx
- * 2 VMA84A66C-2.4_83C73F_91148.pcap
- * ...
- * Found 6 file(s) in /sdcard/lab/handshakes
+ * Lists /sdcard/lab/handshakes through remote_dir, keeping only .pcap
+ * files (not .hccapx) shown without extension. The list asks remote_dir
+ * for each visible row, so the screen holds no names of its own and opens
+ * at once at any directory size; the first page draws while the rest
+ * streams in.
+ *
+ * Each row ends with what capture_index knows of the file: the EAPOL
+ * messages in it ("1234", "-2-4") and P for a PMKID, or "?" before
+ * JanOS summarised it. F keeps only captures hashcat can work on; that
+ * view is a list of listing positions, rebuilt only when the listing or
+ * the index changes. TAB finds a capture by name. G copies the selected
+ * capture to the Cardputer card and U streams it over USB (file_xfer),
+ * then the transfer screen follows the copy.
  */
 
 #include "handshakes_screen.h"
-#include "uart_handler.h"
+#include "remote_dir.h"
+#include "capture_index.h"
+#include "file_xfer.h"
+#include "file_xfer_screen.h"
+#include "uart_progress.h"
 #include "text_ui.h"
+#include "ui_list.h"
 #include "esp_log.h"
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
 
 static const char *TAG = "HANDSHAKES";
 
-// Maximum entries
-#define MAX_ENTRIES     32
-#define MAX_NAME_LEN    48
-#define VISIBLE_ITEMS   6
+#define SUMMARY_COLS    6       // " 1234P"
+#define VIEW_PAGE       16      // Listing rows fetched per remote_dir_page call
 
 // Screen user data
 typedef struct {
-    char names[MAX_ENTRIES][MAX_NAME_LEN];
-    int entry_count;
-    int selected_index;
-    int scroll_offset;
-    bool loading;
-    bool needs_redraw;
-    bool first_draw_done;
-    int ticks_since_first_draw;  // Block redraws shortly after first render
+    ui_list_t list;
+    ui_typeahead_t find;
+    remote_dir_order_t order;
+    uint32_t progress_seq;      // Last UART_OP_LIST_DIR sequence drawn
+    uint32_t index_gen;         // Last capture_index generation drawn
+    bool crackable_only;
+    uint32_t view_dir_gen;      // remote_dir / capture_index generations of view[]
+    uint32_t view_index_gen;
+    int view_count;
+    uint16_t view[REMOTE_DIR_MAX_ENTRIES];  // Listing positions shown when filtered
 } handshakes_data_t;
 
-// Forward declaration
-static void draw_screen(screen_t *self);
-
 /**
- * @brief Check if line is an ESP log line or command echo
+ * @brief EAPOL messages and PMKID of a capture, "?" if not summarised
  */
-static bool is_skip_line(const char *line)
+static void format_summary(const char *name, char *out, size_t size)
 {
-    if (strlen(line) < 3) return true;
-    
-    // Check for ESP log format: "I (", "W (", "E (", "D ("
-    if ((line[0] == 'I' || line[0] == 'W' || line[0] == 'E' || line[0] == 'D') 
-        && line[1] == ' ' && line[2] == '(') {
-        return true;
+    capture_record_t rec;
+    if (!capture_index_find(name, &rec)) {
+        snprintf(out, size, "    ? ");
+        return;
     }
-    
-    // Skip other common patterns
-    if (strstr(line, "[MEM]") != NULL) return true;
-    if (strncmp(line, "list_dir", 8) == 0) return true;
-    
-    // Skip lines starting with ">" (command prompt)
-    const char *p = line;
-    while (*p == ' ') p++;
-    if (*p == '>') return true;
-    
-    // Skip header and footer lines
-    if (strncmp(line, "Files in", 8) == 0) return true;
-    if (strncmp(line, "Found", 5) == 0) return true;
-    
-    return false;
+    snprintf(out, size, "%c%c%c%c%c",
+             (rec.eapol & CAPTURE_EAPOL_M1) ? '1' : '-',
+             (rec.eapol & CAPTURE_EAPOL_M2) ? '2' : '-',
+             (rec.eapol & CAPTURE_EAPOL_M3) ? '3' : '-',
+             (rec.eapol & CAPTURE_EAPOL_M4) ? '4' : '-',
+             (rec.flags & CAPTURE_FLAG_PMKID) ? 'P' : ' ');
 }
 
 /**
- * @brief UART line callback for parsing list_dir output
- * Format: "1 filename.pcap" or "2 filename.hccapx"
- * We only want .pcap files, stripped of extension
+ * @brief Rebuild the crackable-only view if the listing or the index moved
  */
-static void uart_line_callback(const char *line, void *user_data)
+static void update_view(handshakes_data_t *data)
 {
-    handshakes_data_t *data = (handshakes_data_t *)user_data;
-    if (!data || data->entry_count >= MAX_ENTRIES) return;
-    
-    // Skip empty lines
-    if (strlen(line) == 0) return;
-    
-    // Skip log/system lines
-    if (is_skip_line(line)) return;
-    
-    // Check for "No" or "no" messages (no data)
-    if (strstr(line, "No ") != NULL || strstr(line, "no ") != NULL || 
-        strstr(line, "empty") != NULL || strstr(line, "Empty") != NULL ||
-        strstr(line, "not found") != NULL) {
-        data->loading = false;
-        if (data->first_draw_done) {
-            data->needs_redraw = true;
+    uint32_t dir_gen = remote_dir_generation();
+    uint32_t index_gen = capture_index_generation();
+    if (dir_gen == data->view_dir_gen && index_gen == data->view_index_gen) return;
+    data->view_dir_gen = dir_gen;
+    data->view_index_gen = index_gen;
+    ui_list_rows_moved(&data->list);
+
+    remote_dir_entry_t page[VIEW_PAGE];
+    capture_record_t rec;
+    int count = remote_dir_count();
+    data->view_count = 0;
+    for (int offset = 0; offset < count; offset += VIEW_PAGE) {
+        int got = remote_dir_page(offset, VIEW_PAGE, data->order, page);
+        if (got <= 0) break;
+        for (int i = 0; i < got; i++) {
+            if (capture_index_find(page[i].name, &rec) && capture_record_crackable(&rec)) {
+                data->view[data->view_count++] = (uint16_t)(offset + i);
+            }
         }
-        return;
     }
-    
-    // Parse numbered lines: "1 filename.pcap"
-    const char *p = line;
-    while (*p == ' ') p++;
-    
-    // First character should be a digit
-    if (!isdigit((unsigned char)*p)) return;
-    
-    // Skip the number
-    while (isdigit((unsigned char)*p)) p++;
-    
-    // Skip space after number
-    if (*p != ' ') return;
-    p++;
-    
-    // Skip any additional whitespace
-    while (*p == ' ') p++;
-    
-    // Check if this is a .pcap file (not .hccapx)
-    const char *pcap_ext = strstr(p, ".pcap");
-    if (pcap_ext == NULL) return;  // Not a .pcap file
-    
-    // Make sure it's actually .pcap and not .pcap-something
-    if (pcap_ext[5] != '\0' && pcap_ext[5] != '\n' && pcap_ext[5] != '\r' && pcap_ext[5] != ' ') {
-        return;  // Extension continues, skip
+}
+
+/**
+ * @brief Rows in the list as currently filtered
+ */
+static int shown_count(handshakes_data_t *data)
+{
+    if (!data->crackable_only) {
+        int count = remote_dir_count();
+        // Newest first: arriving rows go on top and push the rest down
+        if (data->order == REMOTE_DIR_ORDER_NEWEST && count != data->list.count) {
+            ui_list_rows_moved(&data->list);
+        }
+        return count;
     }
+    update_view(data);
+    return data->view_count;
+}
+
+static void entry_row(int index, char *text, size_t len, void *user_data)
+{
+    handshakes_data_t *data = (handshakes_data_t *)user_data;
+    remote_dir_entry_t entry;
     
-    // Copy filename without extension
-    size_t name_len = pcap_ext - p;
-    if (name_len >= MAX_NAME_LEN) {
-        name_len = MAX_NAME_LEN - 1;
+    if (data->crackable_only) {
+        if (index >= data->view_count) return;
+        index = data->view[index];
     }
     
-    strncpy(data->names[data->entry_count], p, name_len);
-    data->names[data->entry_count][name_len] = '\0';
-    
-    // Trim trailing whitespace
-    char *end = data->names[data->entry_count] + strlen(data->names[data->entry_count]) - 1;
-    while (end > data->names[data->entry_count] && (*end == '\n' || *end == '\r' || *end == ' ')) {
-        *end = '\0';
-        end--;
+    // Truncate long names for display, summary right-aligned
+    if (remote_dir_page(index, 1, data->order, &entry) == 1) {
+        char summary[SUMMARY_COLS + 1];
+        int name_cols = (int)len - 2 - SUMMARY_COLS;
+        format_summary(entry.name, summary, sizeof(summary));
+        if (name_cols < 8) {
+            snprintf(text, len, "%.*s", (int)len - 2, entry.name);
+        } else {
+            snprintf(text, len, "%-*.*s %s", name_cols, name_cols, entry.name, summary);
+        }
     }
-    
-    ESP_LOGI(TAG, "Parsed handshake: '%s'", data->names[data->entry_count]);
-    
-    data->entry_count++;
-    data->loading = false;
-    if (data->first_draw_done) {
-        data->needs_redraw = true;
+}
+
+/**
+ * @brief Listing position of a list row
+ */
+static int entry_position(handshakes_data_t *data, int index)
+{
+    if (!data->crackable_only) return index;
+    return index < data->view_count ? data->view[index] : -1;
+}
+
+static void entry_name(int index, char *name, size_t len, void *user_data)
+{
+    handshakes_data_t *data = (handshakes_data_t *)user_data;
+    remote_dir_entry_t entry;
+    index = entry_position(data, index);
+    if (index >= 0 && remote_dir_page(index, 1, data->order, &entry) == 1) {
+        snprintf(name, len, "%s", entry.name);
     }
 }
 
+static void draw_title(handshakes_data_t *data)
+{
+    char title[32];
+    const char *filter = data->crackable_only ? "Crackable" : "Handshakes";
+    snprintf(title, sizeof(title), remote_dir_state() == REMOTE_DIR_LOADING ?
+             "%s (%d...)" : "%s (%d)", filter, data->list.count);
+    ui_draw_title(title);
+}
+
+static void set_order(handshakes_data_t *data, remote_dir_order_t order)
+{
+    data->order = order;
+    data->view_dir_gen = data->view_index_gen = UINT32_MAX;     // Positions depend on the order
+}
+
 static void draw_screen(screen_t *self)
 {
     handshakes_data_t *data = (handshakes_data_t *)self->user_data;
@@ -158,68 +175,68 @@ static void draw_screen(screen_t *self)
     ui_clear();
     
     // Draw title
-    char title[32];
-    snprintf(title, sizeof(title), "Handshakes (%d)", data->entry_count);
-    ui_draw_title(title);
-    
-    if (data->loading) {
-        ui_print_center(3, "Loading...", UI_COLOR_DIMMED);
-    } else if (data->entry_count == 0) {
-        ui_print_center(3, "No handshakes found", UI_COLOR_DIMMED);
+    uart_progress_record_t progress;
+    data->progress_seq = uart_progress_get(UART_OP_LIST_DIR, &progress);
+    data->index_gen = capture_index_generation();
+    ui_list_set_count(&data->list, shown_count(data));
+    draw_title(data);
+    
+    if (data->list.count == 0) {
+        const char *empty = remote_dir_state() == REMOTE_DIR_LOADING ? "Loading..." :
+                            data->crackable_only ? "No crackable captures" : "No handshakes found";
+        ui_print_center(ui_rows() / 2 - 1, empty, UI_COLOR_DIMMED);
     } else {
-        // Draw visible entries
-        int start_row = 1;
-        
-        for (int i = 0; i < VISIBLE_ITEMS; i++) {
-            int entry_idx = data->scroll_offset + i;
-            
-            if (entry_idx < data->entry_count) {
-                // Truncate long names for display
-                char label[32];
-                snprintf(label, sizeof(label), "%.28s", data->names[entry_idx]);
-                
-                bool selected = (entry_idx == data->selected_index);
-                ui_draw_menu_item(start_row + i, label, selected, false, false);
-            }
-        }
-        
-        // Scroll indicators
-        if (data->scroll_offset > 0) {
-            ui_print(UI_COLS - 2, 1, "^", UI_COLOR_DIMMED);
-        }
-        if (data->scroll_offset + VISIBLE_ITEMS < data->entry_count) {
-            ui_print(UI_COLS - 2, VISIBLE_ITEMS, "v", UI_COLOR_DIMMED);
-        }
+        ui_list_draw(&data->list);
     }
     
     // Draw status bar
-    ui_draw_status("UP/DOWN:Scroll ESC:Back");
+    ui_list_draw_status(&data->list, data->order == REMOTE_DIR_ORDER_NEWEST ?
+                        "S:Listed F:Filter R:Reload TAB:Find ESC" : "S:Newest F:Filter R:Reload TAB:Find ESC");
 }
 
 static void on_tick(screen_t *self)
 {
     handshakes_data_t *data = (handshakes_data_t *)self->user_data;
     
-    // First tick after creation - do the initial draw with whatever data we have
-    if (!data->first_draw_done) {
-        data->first_draw_done = true;
-        data->ticks_since_first_draw = 0;
-        data->needs_redraw = false;
-        draw_screen(self);
-        return;
-    }
-    
-    data->ticks_since_first_draw++;
+    // Listing progress arrives once per page of new rows, not per row;
+    // summaries arrive in one hs_info reply
+    uart_progress_record_t progress;
+    uint32_t seq = uart_progress_get(UART_OP_LIST_DIR, &progress);
+    uint32_t index_gen = capture_index_generation();
+    if (seq == data->progress_seq && index_gen == data->index_gen) return;
     
-    // Block redraws for 2 ticks after first render to avoid double draw
-    if (data->ticks_since_first_draw <= 2) {
-        data->needs_redraw = false;
-        return;
-    }
-    
-    if (data->needs_redraw) {
-        data->needs_redraw = false;
+    if (data->list.count == 0) {
         draw_screen(self);
+    } else {
+        data->progress_seq = seq;
+        data->index_gen = index_gen;
+        ui_list_set_count(&data->list, shown_count(data));
+        draw_title(data);
+        ui_list_draw(&data->list);
+    }
+}
+
+/**
+ * @brief Copy the selected capture off JanOS and show the transfer
+ */
+static void pull_selected(handshakes_data_t *data, bool to_usb)
+{
+    char name[REMOTE_DIR_NAME_LEN];
+    char path[FILE_XFER_PATH_LEN];
+    name[0] = '\0';
+    entry_name(data->list.selected, name, sizeof(name), data);
+    if (data->list.count == 0 || !name[0]) return;
+    
+    snprintf(path, sizeof(path), "%s/%s.pcap", HANDSHAKES_DIR, name);
+    esp_err_t ret = file_xfer_pull(path, to_usb);
+    if (ret == ESP_OK) {
+        screen_manager_push(file_xfer_screen_create, NULL);
+    } else if (ret == ESP_ERR_NOT_SUPPORTED) {
+        ui_list_draw_status(&data->list, "Needs binary link to JanOS");
+    } else if (ret == ESP_ERR_INVALID_STATE) {
+        ui_list_draw_status(&data->list, "Busy: transfer or USB in use");
+    } else {
+        ui_list_draw_status(&data->list, "Cannot start transfer");
     }
 }
 
@@ -227,68 +244,35 @@ static void on_key(screen_t *self, key_code_t key)
 {
     handshakes_data_t *data = (handshakes_data_t *)self->user_data;
     
+    if (ui_list_handle_key(&data->list, key)) {
+        ui_list_draw(&data->list);
+        return;
+    }
+    
     switch (key) {
-        case KEY_UP:
-            if (data->selected_index > 0) {
-                int old_idx = data->selected_index;
-                // Check if at first visible item on page - do page jump
-                if (data->selected_index == data->scroll_offset && data->scroll_offset > 0) {
-                    data->scroll_offset -= VISIBLE_ITEMS;
-                    if (data->scroll_offset < 0) data->scroll_offset = 0;
-                    data->selected_index = data->scroll_offset + VISIBLE_ITEMS - 1;
-                    if (data->selected_index >= data->entry_count) {
-                        data->selected_index = data->entry_count - 1;
-                    }
-                    draw_screen(self);  // Full redraw on page jump
-                } else {
-                    data->selected_index--;
-                    // Redraw only 2 rows
-                    int start_row = 1;
-                    for (int idx = old_idx; idx >= data->selected_index; idx--) {
-                        int i = idx - data->scroll_offset;
-                        if (i >= 0 && i < VISIBLE_ITEMS && idx < data->entry_count) {
-                            char label[32];
-                            snprintf(label, sizeof(label), "%.28s", data->names[idx]);
-                            bool selected = (idx == data->selected_index);
-                            ui_draw_menu_item(start_row + i, label, selected, false, false);
-                        }
-                    }
-                }
-            } else if (data->entry_count > 0) {
-                data->selected_index = data->entry_count - 1;
-                data->scroll_offset = (data->selected_index / VISIBLE_ITEMS) * VISIBLE_ITEMS;
-                draw_screen(self);
-            }
+        case KEY_S:
+            set_order(data, data->order == REMOTE_DIR_ORDER_NEWEST ?
+                      REMOTE_DIR_ORDER_LISTED : REMOTE_DIR_ORDER_NEWEST);
+            ui_list_set_count(&data->list, 0);
+            draw_screen(self);
             break;
             
-        case KEY_DOWN:
-            if (data->selected_index < data->entry_count - 1) {
-                int old_idx = data->selected_index;
-                // Check if at last visible item on page - do page jump
-                if (data->selected_index == data->scroll_offset + VISIBLE_ITEMS - 1) {
-                    // Jump to next page - don't adjust back for partial pages
-                    data->scroll_offset += VISIBLE_ITEMS;
-                    data->selected_index = data->scroll_offset;
-                    draw_screen(self);  // Full redraw on page jump
-                } else {
-                    data->selected_index++;
-                    // Redraw only 2 rows
-                    int start_row = 1;
-                    for (int idx = old_idx; idx <= data->selected_index; idx++) {
-                        int i = idx - data->scroll_offset;
-                        if (i >= 0 && i < VISIBLE_ITEMS && idx < data->entry_count) {
-                            char label[32];
-                            snprintf(label, sizeof(label), "%.28s", data->names[idx]);
-                            bool selected = (idx == data->selected_index);
-                            ui_draw_menu_item(start_row + i, label, selected, false, false);
-                        }
-                    }
-                }
-            } else if (data->entry_count > 0) {
-                data->selected_index = 0;
-                data->scroll_offset = 0;
-                draw_screen(self);
-            }
+        case KEY_F:
+            data->crackable_only = !data->crackable_only;
+            ui_list_set_count(&data->list, 0);
+            draw_screen(self);
+            break;
+            
+        case KEY_G:
+        case KEY_U:
+            pull_selected(data, key == KEY_U);
+            break;
+            
+        case KEY_R:
+            remote_dir_open(HANDSHAKES_DIR, ".pcap", true);
+            capture_index_refresh(true);
+            ui_list_set_count(&data->list, 0);
+            draw_screen(self);
             break;
             
         case KEY_ESC:
@@ -304,11 +288,9 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
-    uart_clear_line_callback();
-    
-    if (self->user_data) {
-        free(self->user_data);
-    }
+    handshakes_data_t *data = (handshakes_data_t *)self->user_data;
+    ui_typeahead_free(&data->find);
+    free(data);
 }
 
 static void on_resume(screen_t *self)
@@ -331,8 +313,19 @@ screen_t* handshakes_screen_create(void *params)
         return NULL;
     }
     
-    data->loading = true;
-    data->first_draw_done = false;
+    // Newest captures first; list_dir runs only if nothing is cached
+    set_order(data, REMOTE_DIR_ORDER_NEWEST);
+    screen_set_density(screen, UI_DENSITY_COMPACT);
+    ui_list_init(&data->list, 1, UI_LIST_MAX_ROWS, entry_row, data);
+    if (ui_typeahead_init(&data->find, REMOTE_DIR_MAX_ENTRIES, entry_name, data) == ESP_OK) {
+        ui_list_set_typeahead(&data->list, &data->find);
+    }
+    esp_err_t ret = remote_dir_open(HANDSHAKES_DIR, ".pcap", false);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Cannot list %s: %s", HANDSHAKES_DIR, esp_err_to_name(ret));
+    }
+    // One line if nothing changed since the last time
+    capture_index_refresh(false);
     
     screen->user_data = data;
     screen->on_key = on_key;
@@ -341,13 +334,8 @@ screen_t* handshakes_screen_create(void *params)
     screen->on_draw = draw_screen;
     screen->on_tick = on_tick;
     
-    // Register UART callback and send command BEFORE any draw
-    uart_register_line_callback(uart_line_callback, data);
-    uart_send_command("list_dir /sdcard/lab/handshakes");
+    draw_screen(screen);
     
     ESP_LOGI(TAG, "Handshakes screen created");
     return screen;
 }
-
-
-
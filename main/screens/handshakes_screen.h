@@ -8,6 +8,9 @@
 
 #include "screen_manager.h"
 
+// Where JanOS saves captures
+#define HANDSHAKES_DIR  "/sdcard/lab/handshakes"
+
 /**
  * @brief Create the handshakes screen
  * @param params Unused
@@ -16,6 +19,3 @@
 screen_t* handshakes_screen_create(void *params);
 
 #endif // HANDSHAKES_SCREEN_H
-
-
-
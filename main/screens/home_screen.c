@@ -4,71 +4,113 @@
  */
 
 #include "home_screen.h"
-#include "wifi_scan_screen.h"
-#include "global_attacks_screen.h"
-#include "sniff_karma_menu_screen.h"
-#include "bt_menu_screen.h"
-#include "deauth_detector_screen.h"
-#include "compromised_menu_screen.h"
-#include "network_attacks_screen.h"
-#include "settings_screen.h"
-#include "placeholder_screen.h"
+#include "screen_registry.h"
 #include "settings.h"
+#include "screenshot.h"
+#include "cred_store.h"
+#include "cap_gps.h"
 #include "text_ui.h"
+#include "icons.h"
+#include "display.h"
 #include "esp_log.h"
 #include <string.h>
 
 static const char *TAG = "HOME_SCREEN";
 
-// Menu items with both attack and test versions of titles
-typedef struct {
-    const char *title_attack;   // Title when red team enabled
-    const char *title_test;     // Title when red team disabled
-    screen_create_fn create_fn;
-    const char *placeholder_title;
-} menu_item_t;
-
-static const menu_item_t menu_items[] = {
-    {"WiFi Scan & Attack", "WiFi Scan & Test", wifi_scan_screen_create, NULL},
-    {"Global WiFi Attacks", "Global WiFi Tests", global_attacks_screen_create, NULL},
-    {"WiFi Sniff&Karma", "WiFi Sniff&Karma", sniff_karma_menu_screen_create, NULL},
-    {"Deauth Detector", "Deauth Detector", deauth_detector_screen_create, NULL},
-    {"Bluetooth", "Bluetooth", bt_menu_screen_create, NULL},
-    {"Compromised data", "Compromised data", compromised_menu_screen_create, NULL},
-    {"Network Attacks", "Network Tests", network_attacks_screen_create, NULL},
-    {"Settings", "Settings", settings_screen_create, NULL},
-};
-
-// Helper to get the correct title based on red team setting
+// Boot probe status (defined in main.c)
+extern bool is_board_detected(void);
+extern bool is_board_probe_done(void);
+extern bool is_periph_init_done(void);
+
+// Status icons end just left of the battery icon; the capture count sits
+// between the voltage text and the title
+#define STATUS_RIGHT_X  (DISPLAY_WIDTH - 28)
+#define CAPTURE_RIGHT_X 70
+#define STATUS_Y        ((UI_CELL_H_NORMAL + 2 - ICON_SIZE) / 2)
+
+// Entries come from SCREEN_REGISTER(HOME, ...) in the screens themselves
+static const screen_desc_t *const *menu_items(int *count)
+{
+    return screen_registry_menu(SCREEN_MENU_HOME, settings_get_red_team_enabled(), count);
+}
+
+static int menu_count(void)
+{
+    int count;
+    menu_items(&count);
+    return count;
+}
+
 static const char* get_menu_title(int index)
 {
-    return settings_get_red_team_enabled() 
-        ? menu_items[index].title_attack 
-        : menu_items[index].title_test;
+    int count;
+    const screen_desc_t *const *items = menu_items(&count);
+    return index < count ? screen_registry_title(items[index], settings_get_red_team_enabled())
+                         : "";
 }
 
-#define MENU_ITEM_COUNT (sizeof(menu_items) / sizeof(menu_items[0]))
 #define VISIBLE_ITEMS 6
 
 // Screen user data
 typedef struct {
     int selected_index;
     int scroll_offset;
+    ui_status_strip_t status_strip;
+    ui_status_strip_t capture_strip;
+    bool drawn_red_team;            // Red team titles on screen
 } home_screen_data_t;
 
+/**
+ * @brief Title bar indicators
+ *
+ * Link is the JanOS board, SD the local card: yellow while probing, red
+ * when missing, green once found. GPS shows while the CAP module runs,
+ * green with a fix. Captures are the portal and Evil Twin credentials of
+ * this session. Repainted only when something changed.
+ */
+static void draw_status_icons(home_screen_data_t *data)
+{
+    ui_status_t status = {
+        .link = is_board_detected() ? ICON_STATE_OK :
+                is_board_probe_done() ? ICON_STATE_FAIL : ICON_STATE_PENDING,
+        .sd = !is_periph_init_done() ? ICON_STATE_PENDING :
+              screenshot_is_available() ? ICON_STATE_OK : ICON_STATE_FAIL,
+        .gps = ICON_STATE_HIDDEN,
+    };
+    cap_gps_snapshot_t gps;
+    if (cap_gps_get_snapshot(&gps)) {
+        status.gps = cap_gps_has_fix() ? ICON_STATE_OK : ICON_STATE_PENDING;
+    }
+    ui_status_strip_update(&data->status_strip, &status);
+    
+    int captures = cred_store_count(CRED_PORTAL) + cred_store_count(CRED_EVIL);
+    ui_status_t capture_status = {
+        .captures = captures > UINT16_MAX ? UINT16_MAX : (uint16_t)captures,
+    };
+    ui_status_strip_update(&data->capture_strip, &capture_status);
+}
+
 static void draw_screen(screen_t *self)
 {
     home_screen_data_t *data = (home_screen_data_t *)self->user_data;
     
     ui_clear();
+    data->drawn_red_team = settings_get_red_team_enabled();
     
     // Draw title
     ui_draw_title("LABORATORIUM");
+    draw_status_icons(data);
+    
+    // Red team toggled in Settings: the list may have changed length
+    if (data->selected_index >= menu_count()) {
+        data->selected_index = 0;
+        data->scroll_offset = 0;
+    }
     
     // Draw only visible menu items
     int visible_end = data->scroll_offset + VISIBLE_ITEMS;
-    if (visible_end > MENU_ITEM_COUNT) {
-        visible_end = MENU_ITEM_COUNT;
+    if (visible_end > menu_count()) {
+        visible_end = menu_count();
     }
     
     for (int i = data->scroll_offset; i < visible_end; i++) {
@@ -80,7 +122,7 @@ static void draw_screen(screen_t *self)
     if (data->scroll_offset > 0) {
         ui_print(UI_COLS - 2, 1, "^", UI_COLOR_DIMMED);
     }
-    if (data->scroll_offset + VISIBLE_ITEMS < (int)MENU_ITEM_COUNT) {
+    if (data->scroll_offset + VISIBLE_ITEMS < menu_count()) {
         ui_print(UI_COLS - 2, VISIBLE_ITEMS, "v", UI_COLOR_DIMMED);
     }
     
@@ -117,23 +159,23 @@ static void on_key(screen_t *self, key_code_t key)
                     if (data->scroll_offset < 0) data->scroll_offset = 0;
                     // Land on last item of previous page
                     data->selected_index = data->scroll_offset + VISIBLE_ITEMS - 1;
-                    if (data->selected_index >= (int)MENU_ITEM_COUNT) {
-                        data->selected_index = (int)MENU_ITEM_COUNT - 1;
+                    if (data->selected_index >= menu_count()) {
+                        data->selected_index = menu_count() - 1;
                     }
                     draw_screen(self);
                 } else {
                     data->selected_index--;
                     redraw_two_items(data, old_index, data->selected_index);
                 }
-            } else if ((int)MENU_ITEM_COUNT > 0) {
-                data->selected_index = (int)MENU_ITEM_COUNT - 1;
+            } else if (menu_count() > 0) {
+                data->selected_index = menu_count() - 1;
                 data->scroll_offset = (data->selected_index / VISIBLE_ITEMS) * VISIBLE_ITEMS;
                 draw_screen(self);
             }
             break;
             
         case KEY_DOWN:
-            if (data->selected_index < (int)MENU_ITEM_COUNT - 1) {
+            if (data->selected_index < menu_count() - 1) {
                 int old_index = data->selected_index;
                 data->selected_index++;
                 
@@ -146,7 +188,7 @@ static void on_key(screen_t *self, key_code_t key)
                 } else {
                     redraw_two_items(data, old_index, data->selected_index);
                 }
-            } else if ((int)MENU_ITEM_COUNT > 0) {
+            } else if (menu_count() > 0) {
                 data->selected_index = 0;
                 data->scroll_offset = 0;
                 draw_screen(self);
@@ -156,12 +198,10 @@ static void on_key(screen_t *self, key_code_t key)
         case KEY_ENTER:
         case KEY_SPACE:
             {
-                const menu_item_t *item = &menu_items[data->selected_index];
-                if (item->create_fn) {
-                    screen_manager_push(item->create_fn, NULL);
-                } else {
-                    // Push placeholder screen
-                    screen_manager_push(placeholder_screen_create, (void*)item->placeholder_title);
+                int count;
+                const screen_desc_t *const *items = menu_items(&count);
+                if (data->selected_index < count) {
+                    screen_manager_push(items[data->selected_index]->create_fn, NULL);
                 }
             }
             break;
@@ -183,6 +223,27 @@ static void on_resume(screen_t *self)
     draw_screen(self);
 }
 
+static void on_tick(screen_t *self)
+{
+    home_screen_data_t *data = (home_screen_data_t *)self->user_data;
+    
+    // Both are single blits, and nothing at all while the state holds
+    ui_refresh_title_battery();
+    draw_status_icons(data);
+}
+
+static void on_restore(screen_t *self)
+{
+    home_screen_data_t *data = (home_screen_data_t *)self->user_data;
+    
+    // Settings may have switched red team, renaming and adding items
+    if (data->drawn_red_team != settings_get_red_team_enabled()) {
+        draw_screen(self);
+        return;
+    }
+    on_tick(self);
+}
+
 screen_t* home_screen_create(void *params)
 {
     (void)params;
@@ -199,11 +260,16 @@ screen_t* home_screen_create(void *params)
         return NULL;
     }
     
+    ui_status_strip_init(&data->status_strip, STATUS_RIGHT_X, STATUS_Y, UI_COLOR_TITLE_BG);
+    ui_status_strip_init(&data->capture_strip, CAPTURE_RIGHT_X, STATUS_Y, UI_COLOR_TITLE_BG);
+    
     screen->user_data = data;
     screen->on_key = on_key;
     screen->on_destroy = on_destroy;
     screen->on_resume = on_resume;
+    screen->on_restore = on_restore;
     screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
     
     // Draw initial screen
     draw_screen(screen);
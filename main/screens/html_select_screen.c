@@ -1,37 +1,43 @@
 /**
  * @file html_select_screen.c
  * @brief HTML portal selection screen for Evil Twin attack
+ *
+ * Files come from the shared SD listing, so the list is shown at once on
+ * re-entry without listing the SD card again. TAB finds a portal by name,
+ * P previews the text of the one under the cursor.
  */
 
 #include "html_select_screen.h"
 #include "evil_twin_screen.h"
 #include "uart_handler.h"
 #include "text_ui.h"
+#include "ui_typeahead.h"
+#include "sd_listing.h"
+#include "html_preview.h"
+#include "cred_store.h"
 #include "buzzer.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
 
 static const char *TAG = "HTML_SEL";
 
-// Maximum HTML files and visible items
-#define MAX_HTML_FILES  24
+// Visible items
 #define VISIBLE_ITEMS   6
-#define MAX_FILENAME_LEN 32
 
 // Screen user data
 typedef struct {
     wifi_network_t *networks;
     int network_count;
-    char html_files[MAX_HTML_FILES][MAX_FILENAME_LEN];
-    int file_ids[MAX_HTML_FILES];  // Store the 1-based IDs from UART
+    sd_file_t files[SD_LISTING_MAX_FILES];
     int file_count;
+    uint32_t listing_generation;
     int selected_index;
     int scroll_offset;
     bool loading;
-    bool needs_redraw;  // Flag for thread-safe redraw
+    bool needs_redraw;
+    ui_typeahead_t find;
     screen_t *self;
 } html_select_screen_data_t;
 
@@ -39,65 +45,50 @@ typedef struct {
 static void draw_screen(screen_t *self);
 
 /**
- * @brief UART line callback for parsing list_sd output
+ * @brief Take the HTML files from the shared SD listing
  */
-static void uart_line_callback(const char *line, void *user_data)
+static void load_files(html_select_screen_data_t *data)
 {
-    html_select_screen_data_t *data = (html_select_screen_data_t *)user_data;
-    if (!data || data->file_count >= MAX_HTML_FILES) return;
-    
-    // Skip header line
-    if (strstr(line, "HTML files found") != NULL) {
-        return;
-    }
-    
-    // Parse lines like "1 PLAY.html" or "16 Starbucks.html"
-    // Format: number space filename.html
-    const char *ptr = line;
-    
-    // Skip leading whitespace
-    while (*ptr && isspace((unsigned char)*ptr)) ptr++;
-    
-    // Check if starts with digit
-    if (!isdigit((unsigned char)*ptr)) return;
-    
-    // Parse the number
-    int file_id = 0;
-    while (*ptr && isdigit((unsigned char)*ptr)) {
-        file_id = file_id * 10 + (*ptr - '0');
-        ptr++;
-    }
-    
-    // Skip whitespace after number
-    while (*ptr && isspace((unsigned char)*ptr)) ptr++;
-    
-    // Rest is filename - check if it ends with .html
-    if (strlen(ptr) < 6) return;  // At least "x.html"
-    if (strstr(ptr, ".html") == NULL) return;
-    
-    // Store the file
-    strncpy(data->html_files[data->file_count], ptr, MAX_FILENAME_LEN - 1);
-    data->html_files[data->file_count][MAX_FILENAME_LEN - 1] = '\0';
-    
-    // Remove trailing whitespace/newline
-    char *end = data->html_files[data->file_count] + strlen(data->html_files[data->file_count]) - 1;
-    while (end > data->html_files[data->file_count] && isspace((unsigned char)*end)) {
-        *end = '\0';
-        end--;
-    }
-    
-    data->file_ids[data->file_count] = file_id;
-    data->file_count++;
-    
-    ESP_LOGI(TAG, "Found HTML file [%d]: %s", file_id, data->html_files[data->file_count - 1]);
-    
-    // Update loading state - set flag for main task to redraw
-    if (data->loading && data->file_count > 0) {
-        data->loading = false;
-        data->needs_redraw = true;
+    data->listing_generation = sd_listing_generation();
+    data->file_count = sd_listing_copy(SD_LISTING_HTML, data->files, SD_LISTING_MAX_FILES);
+    data->loading = data->file_count == 0 && sd_listing_state() == SD_LISTING_LOADING;
+    ui_typeahead_rows_moved(&data->find);
+    if (data->selected_index >= data->file_count) {
+        data->selected_index = 0;
+        data->scroll_offset = 0;
     }
 }
 
+static void file_name(int index, char *name, size_t len, void *user_data)
+{
+    html_select_screen_data_t *data = (html_select_screen_data_t *)user_data;
+    snprintf(name, len, "%s", data->files[index].name);
+}
+
+/**
+ * @brief Name without .html, cut to the row
+ */
+static void format_label(const sd_file_t *file, char *label, size_t size)
+{
+    strncpy(label, file->name, size - 1);
+    label[size - 1] = '\0';
+    char *ext = strstr(label, ".html");
+    if (ext) *ext = '\0';
+}
+
+/**
+ * @brief Repaint one row if it is on the page
+ */
+static void draw_file_row(html_select_screen_data_t *data, int file_idx)
+{
+    int row = file_idx - data->scroll_offset;
+    if (row < 0 || row >= VISIBLE_ITEMS || file_idx >= data->file_count) return;
+
+    char label[28];
+    format_label(&data->files[file_idx], label, sizeof(label));
+    ui_draw_menu_item(1 + row, label, file_idx == data->selected_index, false, false);
+}
+
 static void draw_screen(screen_t *self)
 {
     html_select_screen_data_t *data = (html_select_screen_data_t *)self->user_data;
@@ -118,14 +109,8 @@ static void draw_screen(screen_t *self)
             int file_idx = data->scroll_offset + i;
             
             if (file_idx < data->file_count) {
-                // Truncate filename for display
                 char label[28];
-                strncpy(label, data->html_files[file_idx], sizeof(label) - 1);
-                label[sizeof(label) - 1] = '\0';
-                
-                // Remove .html extension for cleaner display
-                char *ext = strstr(label, ".html");
-                if (ext) *ext = '\0';
+                format_label(&data->files[file_idx], label, sizeof(label));
                 
                 bool is_selected = (file_idx == data->selected_index);
                 ui_draw_menu_item(start_row + i, label, is_selected, false, false);
@@ -156,7 +141,7 @@ static void draw_screen(screen_t *self)
     if (data->loading) {
         ui_draw_status("Loading HTML files...");
     } else {
-        ui_draw_status("ENTER:Select ESC:Back");
+        ui_typeahead_draw_status(&data->find, "ENTER:Sel P:View TAB:Find ESC");
     }
 }
 
@@ -166,17 +151,16 @@ static void launch_evil_twin(html_select_screen_data_t *data)
         return;
     }
     
-    // Send select_html command with the 1-based ID
+    // select_html with the 1-based ID, then start_evil_twin
     char cmd[32];
-    snprintf(cmd, sizeof(cmd), "select_html %d", data->file_ids[data->selected_index]);
-    uart_send_command(cmd);
+    snprintf(cmd, sizeof(cmd), "select_html %d", data->files[data->selected_index].id);
+    const char *const sequence[] = { cmd, "start_evil_twin" };
+    uart_send_batch(sequence, 2, NULL, NULL);
     
     ESP_LOGI(TAG, "Selected HTML portal: %s (ID: %d)", 
-             data->html_files[data->selected_index], 
-             data->file_ids[data->selected_index]);
-    
-    // Send start_evil_twin command
-    uart_send_command("start_evil_twin");
+             data->files[data->selected_index].name, 
+             data->files[data->selected_index].id);
+    cred_store_set_portal_ssid(NULL);   // Its form posts are not portal data
     buzzer_beep_attack();
     
     // Create evil twin screen params
@@ -189,7 +173,10 @@ static void launch_evil_twin(html_select_screen_data_t *data)
         if (params->networks) {
             memcpy(params->networks, data->networks, 
                    data->network_count * sizeof(wifi_network_t));
-            screen_manager_push(evil_twin_screen_create, params);
+            if (screen_manager_push(evil_twin_screen_create, params) == ESP_ERR_NO_MEM) {
+                free(params->networks);
+                free(params);
+            }
         } else {
             free(params);
         }
@@ -200,7 +187,11 @@ static void on_tick(screen_t *self)
 {
     html_select_screen_data_t *data = (html_select_screen_data_t *)self->user_data;
     
-    // Check if redraw needed from UART callback (thread-safe)
+    if (sd_listing_generation() != data->listing_generation) {
+        load_files(data);
+        data->needs_redraw = true;
+    }
+    
     if (data->needs_redraw) {
         data->needs_redraw = false;
         draw_screen(self);
@@ -211,6 +202,28 @@ static void on_key(screen_t *self, key_code_t key)
 {
     html_select_screen_data_t *data = (html_select_screen_data_t *)self->user_data;
     
+    int row;
+    switch (ui_typeahead_handle_key(&data->find, key, data->file_count, &row)) {
+        case UI_TYPEAHEAD_IGNORED:
+            break;
+        case UI_TYPEAHEAD_JUMP: {
+            // Same pages as UP/DOWN
+            int old_idx = data->selected_index;
+            int old_scroll = data->scroll_offset;
+            data->selected_index = row;
+            data->scroll_offset = row - row % VISIBLE_ITEMS;
+            if (data->scroll_offset != old_scroll) {
+                draw_screen(self);
+            } else {
+                draw_file_row(data, old_idx);
+                draw_file_row(data, row);
+            }
+            return;
+        }
+        default:
+            return;
+    }
+    
     switch (key) {
         case KEY_UP:
             if (!data->loading && data->selected_index > 0) {
@@ -228,26 +241,8 @@ static void on_key(screen_t *self, key_code_t key)
                 } else {
                     data->selected_index--;
                     // Just redraw the two affected rows
-                    int start_row = 1;
-                    int old_row = old_idx - data->scroll_offset;
-                    int new_row = data->selected_index - data->scroll_offset;
-                    
-                    if (old_row >= 0 && old_row < VISIBLE_ITEMS) {
-                        char label[28];
-                        strncpy(label, data->html_files[old_idx], sizeof(label) - 1);
-                        label[sizeof(label) - 1] = '\0';
-                        char *ext = strstr(label, ".html");
-                        if (ext) *ext = '\0';
-                        ui_draw_menu_item(start_row + old_row, label, false, false, false);
-                    }
-                    if (new_row >= 0 && new_row < VISIBLE_ITEMS) {
-                        char label[28];
-                        strncpy(label, data->html_files[data->selected_index], sizeof(label) - 1);
-                        label[sizeof(label) - 1] = '\0';
-                        char *ext = strstr(label, ".html");
-                        if (ext) *ext = '\0';
-                        ui_draw_menu_item(start_row + new_row, label, true, false, false);
-                    }
+                    draw_file_row(data, old_idx);
+                    draw_file_row(data, data->selected_index);
                 }
             } else if (!data->loading && data->file_count > 0) {
                 data->selected_index = data->file_count - 1;
@@ -269,26 +264,8 @@ static void on_key(screen_t *self, key_code_t key)
                 } else {
                     data->selected_index++;
                     // Just redraw the two affected rows
-                    int start_row = 1;
-                    int old_row = old_idx - data->scroll_offset;
-                    int new_row = data->selected_index - data->scroll_offset;
-                    
-                    if (old_row >= 0 && old_row < VISIBLE_ITEMS) {
-                        char label[28];
-                        strncpy(label, data->html_files[old_idx], sizeof(label) - 1);
-                        label[sizeof(label) - 1] = '\0';
-                        char *ext = strstr(label, ".html");
-                        if (ext) *ext = '\0';
-                        ui_draw_menu_item(start_row + old_row, label, false, false, false);
-                    }
-                    if (new_row >= 0 && new_row < VISIBLE_ITEMS) {
-                        char label[28];
-                        strncpy(label, data->html_files[data->selected_index], sizeof(label) - 1);
-                        label[sizeof(label) - 1] = '\0';
-                        char *ext = strstr(label, ".html");
-                        if (ext) *ext = '\0';
-                        ui_draw_menu_item(start_row + new_row, label, true, false, false);
-                    }
+                    draw_file_row(data, old_idx);
+                    draw_file_row(data, data->selected_index);
                 }
             } else if (!data->loading && data->file_count > 0) {
                 data->selected_index = 0;
@@ -304,6 +281,12 @@ static void on_key(screen_t *self, key_code_t key)
             }
             break;
             
+        case KEY_P:
+            if (!data->loading && data->selected_index < data->file_count) {
+                html_preview_show(&data->files[data->selected_index]);
+            }
+            break;
+            
         case KEY_ESC:
         case KEY_Q:
             screen_manager_pop();
@@ -318,13 +301,11 @@ static void on_destroy(screen_t *self)
 {
     html_select_screen_data_t *data = (html_select_screen_data_t *)self->user_data;
     
-    // Clear UART callback
-    uart_clear_line_callback();
-    
     if (data) {
         if (data->networks) {
             free(data->networks);
         }
+        ui_typeahead_free(&data->find);
         free(data);
     }
 }
@@ -359,8 +340,8 @@ screen_t* html_select_screen_create(void *params)
     // Take ownership
     data->networks = html_params->networks;
     data->network_count = html_params->network_count;
-    data->loading = true;
     data->self = screen;
+    ui_typeahead_init(&data->find, SD_LISTING_MAX_FILES, file_name, data);
     free(html_params);
     
     screen->user_data = data;
@@ -369,13 +350,11 @@ screen_t* html_select_screen_create(void *params)
     screen->on_draw = draw_screen;
     screen->on_tick = on_tick;
     
-    // Register UART callback for parsing list_sd output
-    uart_register_line_callback(uart_line_callback, data);
-    
-    // Send list_sd command
-    uart_send_command("list_sd");
+    // Cached listing shows at once; list_sd runs only the first time
+    sd_listing_refresh(false);
+    load_files(data);
     
-    // Draw initial screen (loading state)
+    // Draw initial screen (loading state or cached list)
     draw_screen(screen);
     
     ESP_LOGI(TAG, "HTML select screen created");
@@ -0,0 +1,155 @@
+/**
+ * @file jobs_screen.c
+ * @brief Background jobs: reopen or stop them
+ *
+ * One row per job with the time it has run in the background. ENTER puts
+ * its screen back on top, S sends `stop` (JanOS runs one operation, so
+ * that ends every job on the board). Redrawn when the job list changes
+ * and once a second for the run times.
+ */
+
+#include "jobs_screen.h"
+#include "job_manager.h"
+#include "screen_registry.h"
+#include "text_ui.h"
+#include "ui_list.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "JOBS_SCR";
+
+// Screen user data
+typedef struct {
+    ui_list_t list;
+    uint32_t generation;        // job_manager_generation() when loaded
+    uint32_t drawn_s;           // Uptime second of the last draw (run times in rows)
+} jobs_data_t;
+
+static void job_row(int index, char *text, size_t len, void *user_data)
+{
+    (void)user_data;
+    job_info_t job;
+    if (!job_manager_get(index, &job)) {
+        text[0] = '\0';
+        return;
+    }
+    uint32_t run_s = (uint32_t)((esp_timer_get_time() - job.started_us) / 1000000);
+    snprintf(text, len, "%-16s %3lum%02lus%s", job_kind_name(job.kind),
+             (unsigned long)(run_s / 60), (unsigned long)(run_s % 60), job.ended ? " end" : "");
+}
+
+static void load(jobs_data_t *data)
+{
+    data->generation = job_manager_generation();
+    ui_list_set_count(&data->list, job_manager_count());
+    data->drawn_s = (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+static void draw_screen(screen_t *self)
+{
+    jobs_data_t *data = (jobs_data_t *)self->user_data;
+    
+    ui_clear();
+    char title[32];
+    snprintf(title, sizeof(title), "Background Jobs: %d", data->list.count);
+    ui_draw_title(title);
+    
+    if (data->list.count == 0) {
+        ui_print_center(ui_rows() / 2 - 1, "No background jobs", UI_COLOR_DIMMED);
+        ui_print_center(ui_rows() / 2, "B on a running view", UI_COLOR_DIMMED);
+        ui_draw_status("ESC:Back");
+    } else {
+        ui_list_draw(&data->list);
+        ui_draw_status("ENTER:Open S:Stop ESC:Back");
+    }
+}
+
+static void on_tick(screen_t *self)
+{
+    jobs_data_t *data = (jobs_data_t *)self->user_data;
+    
+    uint32_t now_s = (uint32_t)(esp_timer_get_time() / 1000000);
+    if (data->generation == job_manager_generation() && now_s == data->drawn_s) return;
+    load(data);
+    draw_screen(self);
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    jobs_data_t *data = (jobs_data_t *)self->user_data;
+    
+    if (ui_list_handle_key(&data->list, key)) {
+        ui_list_draw(&data->list);
+        return;
+    }
+    
+    switch (key) {
+        case KEY_ENTER:
+            if (data->list.count > 0) {
+                esp_err_t ret = job_manager_reopen(data->list.selected);
+                if (ret != ESP_OK) {
+                    ESP_LOGW(TAG, "Cannot reopen job: %s", esp_err_to_name(ret));
+                }
+            }
+            break;
+            
+        case KEY_S:
+            if (data->list.count > 0) {
+                job_manager_stop(data->list.selected);
+            }
+            break;
+            
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    free(self->user_data);
+}
+
+static void on_resume(screen_t *self)
+{
+    load((jobs_data_t *)self->user_data);
+    draw_screen(self);
+}
+
+screen_t* jobs_screen_create(void *params)
+{
+    (void)params;
+    
+    ESP_LOGI(TAG, "Creating jobs screen...");
+    
+    screen_t *screen = screen_alloc();
+    jobs_data_t *data = screen ? calloc(1, sizeof(jobs_data_t)) : NULL;
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    ui_list_init(&data->list, 1, UI_LIST_MAX_ROWS, job_row, data);
+    load(data);
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_resume = on_resume;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "Jobs screen created");
+    return screen;
+}
+
+SCREEN_REGISTER(HOME, 85, jobs_screen_create, 0, "Background Jobs", NULL);
@@ -0,0 +1,18 @@
+/**
+ * @file jobs_screen.h
+ * @brief Background jobs: reopen or stop them
+ */
+
+#ifndef JOBS_SCREEN_H
+#define JOBS_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the background jobs screen
+ * @param params Unused
+ * @return Created screen or NULL on failure
+ */
+screen_t* jobs_screen_create(void *params);
+
+#endif // JOBS_SCREEN_H
@@ -8,9 +8,9 @@
 #include "text_ui.h"
 #include "buzzer.h"
 #include "esp_log.h"
-#include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 static const char *TAG = "KARMA_ATK";
 
@@ -19,35 +19,18 @@ static const char *TAG = "KARMA_ATK";
 #define MAX_MAC_LEN     18
 #define MAX_PWD_LEN     64
 
-// Refresh timer interval (200ms)
-#define REFRESH_INTERVAL_US 200000
-
 // Screen user data
 typedef struct {
     char ssid[MAX_SSID_LEN];
     char last_mac[MAX_MAC_LEN];
     char password[MAX_PWD_LEN];
     bool portal_started;
-    bool needs_redraw;
-    esp_timer_handle_t refresh_timer;
     screen_t *self;
 } karma_attack_data_t;
 
 // Forward declaration
 static void draw_screen(screen_t *self);
 
-/**
- * @brief Timer callback - checks if redraw is needed
- */
-static void refresh_timer_callback(void *arg)
-{
-    karma_attack_data_t *data = (karma_attack_data_t *)arg;
-    if (data && data->needs_redraw && data->self) {
-        data->needs_redraw = false;
-        draw_screen(data->self);
-    }
-}
-
 /**
  * @brief UART line callback for parsing karma attack output
  * Patterns:
@@ -64,7 +47,7 @@ static void uart_line_callback(const char *line, void *user_data)
     if (strstr(line, "Captive portal started") != NULL || 
         strstr(line, "AP Name:") != NULL) {
         data->portal_started = true;
-        data->needs_redraw = true;
+        screen_manager_data_changed(data->self);
         ESP_LOGI(TAG, "Portal started detected");
         return;
     }
@@ -84,7 +67,7 @@ static void uart_line_callback(const char *line, void *user_data)
         *end = '\0';
         
         ESP_LOGI(TAG, "Client connected: %s", data->last_mac);
-        data->needs_redraw = true;
+        screen_manager_data_changed(data->self);
         return;
     }
     
@@ -109,7 +92,7 @@ static void uart_line_callback(const char *line, void *user_data)
         }
         
         ESP_LOGI(TAG, "Password obtained: %s", data->password);
-        data->needs_redraw = true;
+        screen_manager_data_changed(data->self);
         buzzer_beep_capture();
         return;
     }
@@ -179,15 +162,6 @@ static void on_destroy(screen_t *self)
 {
     karma_attack_data_t *data = (karma_attack_data_t *)self->user_data;
     
-    // Stop and delete timer
-    if (data && data->refresh_timer) {
-        esp_timer_stop(data->refresh_timer);
-        esp_timer_delete(data->refresh_timer);
-    }
-    
-    // Clear UART callback
-    uart_clear_line_callback();
-    
     if (data) {
         free(data);
     }
@@ -229,21 +203,8 @@ screen_t* karma_attack_screen_create(void *params)
     screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
     
-    // Create periodic refresh timer
-    esp_timer_create_args_t timer_args = {
-        .callback = refresh_timer_callback,
-        .arg = data,
-        .name = "karma_refresh"
-    };
-    
-    if (esp_timer_create(&timer_args, &data->refresh_timer) == ESP_OK) {
-        esp_timer_start_periodic(data->refresh_timer, REFRESH_INTERVAL_US);
-    } else {
-        ESP_LOGW(TAG, "Failed to create refresh timer");
-    }
-    
     // Register UART callback for parsing attack output
-    uart_register_line_callback(uart_line_callback, data);
+    screen_set_line_callback(screen, uart_line_callback, data);
     
     // Draw initial screen
     draw_screen(screen);
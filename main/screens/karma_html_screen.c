@@ -1,30 +1,31 @@
 /**
  * @file karma_html_screen.c
  * @brief Karma HTML portal selection screen implementation
+ *
+ * P previews the text of the template under the cursor.
  */
 
 #include "karma_html_screen.h"
 #include "karma_attack_screen.h"
 #include "uart_handler.h"
+#include "sd_listing.h"
+#include "html_preview.h"
+#include "cred_store.h"
 #include "text_ui.h"
 #include "buzzer.h"
 #include "esp_log.h"
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
 
 static const char *TAG = "KARMA_HTML";
 
-// Maximum HTML files
-#define MAX_FILES       32
-#define MAX_FILENAME    32
-
 // Screen user data
 typedef struct {
     int probe_index;                    // 1-based probe index
     char ssid[33];                      // SSID for display and attack
-    char files[MAX_FILES][MAX_FILENAME];
+    sd_file_t files[SD_LISTING_MAX_FILES];
     int file_count;
+    uint32_t listing_generation;
     int selected_index;
     int scroll_offset;
     bool loading;
@@ -36,78 +37,16 @@ typedef struct {
 static void draw_screen(screen_t *self);
 
 /**
- * @brief Check if line is an ESP log line
+ * @brief Take the HTML files from the shared SD listing
  */
-static bool is_esp_log_line(const char *line)
+static void load_files(karma_html_data_t *data)
 {
-    if (strlen(line) < 3) return false;
-    
-    if ((line[0] == 'I' || line[0] == 'W' || line[0] == 'E' || line[0] == 'D') 
-        && line[1] == ' ' && line[2] == '(') {
-        return true;
-    }
-    
-    if (strstr(line, "[MEM]") != NULL) return true;
-    if (strncmp(line, "list_sd", 7) == 0) return true;
-    
-    return false;
-}
-
-/**
- * @brief UART line callback for parsing list_sd output
- * Format: "1 PLAY.html", "2 SocialMedium.html", etc.
- */
-static void uart_line_callback(const char *line, void *user_data)
-{
-    karma_html_data_t *data = (karma_html_data_t *)user_data;
-    if (!data || data->file_count >= MAX_FILES) return;
-    
-    // Skip empty lines
-    if (strlen(line) == 0) return;
-    
-    // Skip ESP log lines
-    if (is_esp_log_line(line)) return;
-    
-    // Skip "HTML files found" header
-    if (strstr(line, "HTML files") != NULL) {
-        data->loading = false;
-        data->needs_redraw = true;
-        return;
-    }
-    
-    // Skip command prompt
-    const char *p = line;
-    while (*p == ' ') p++;
-    if (*p == '>') return;
-    
-    // Parse numbered lines: "1 filename.html"
-    p = line;
-    while (*p == ' ') p++;
-    
-    if (!isdigit((unsigned char)*p)) return;
-    
-    // Skip the number
-    while (isdigit((unsigned char)*p)) p++;
-    
-    // Skip space after number
-    if (*p != ' ') return;
-    p++;
-    
-    // Rest is the filename
-    if (strlen(p) > 0 && strstr(p, ".html") != NULL) {
-        strncpy(data->files[data->file_count], p, MAX_FILENAME - 1);
-        data->files[data->file_count][MAX_FILENAME - 1] = '\0';
-        
-        // Remove trailing whitespace
-        char *end = data->files[data->file_count] + strlen(data->files[data->file_count]) - 1;
-        while (end > data->files[data->file_count] && (*end == '\n' || *end == '\r' || *end == ' ')) {
-            *end = '\0';
-            end--;
-        }
-        
-        ESP_LOGI(TAG, "HTML file %d: %s", data->file_count + 1, data->files[data->file_count]);
-        data->file_count++;
-        data->needs_redraw = true;
+    data->listing_generation = sd_listing_generation();
+    data->file_count = sd_listing_copy(SD_LISTING_HTML, data->files, SD_LISTING_MAX_FILES);
+    data->loading = data->file_count == 0 && sd_listing_state() == SD_LISTING_LOADING;
+    if (data->selected_index >= data->file_count) {
+        data->selected_index = 0;
+        data->scroll_offset = 0;
     }
 }
 
@@ -134,7 +73,7 @@ static void draw_screen(screen_t *self)
             
             if (file_idx < data->file_count) {
                 bool selected = (file_idx == data->selected_index);
-                ui_draw_menu_item(start_row + i, data->files[file_idx], selected, false, false);
+                ui_draw_menu_item(start_row + i, data->files[file_idx].name, selected, false, false);
             }
         }
         
@@ -148,13 +87,18 @@ static void draw_screen(screen_t *self)
     }
     
     // Draw status bar
-    ui_draw_status("UP/DOWN:Nav ENTER:Select ESC:Back");
+    ui_draw_status("ENTER:Select P:View ESC:Back");
 }
 
 static void on_tick(screen_t *self)
 {
     karma_html_data_t *data = (karma_html_data_t *)self->user_data;
     
+    if (sd_listing_generation() != data->listing_generation) {
+        load_files(data);
+        data->needs_redraw = true;
+    }
+    
     if (data->needs_redraw) {
         data->needs_redraw = false;
         draw_screen(self);
@@ -187,7 +131,7 @@ static void on_key(screen_t *self, key_code_t key)
                         int i = idx - data->scroll_offset;
                         if (i >= 0 && i < visible_rows && idx < data->file_count) {
                             bool selected = (idx == data->selected_index);
-                            ui_draw_menu_item(start_row + i, data->files[idx], selected, false, false);
+                            ui_draw_menu_item(start_row + i, data->files[idx].name, selected, false, false);
                         }
                     }
                 }
@@ -215,7 +159,7 @@ static void on_key(screen_t *self, key_code_t key)
                         int i = idx - data->scroll_offset;
                         if (i >= 0 && i < visible_rows && idx < data->file_count) {
                             bool selected = (idx == data->selected_index);
-                            ui_draw_menu_item(start_row + i, data->files[idx], selected, false, false);
+                            ui_draw_menu_item(start_row + i, data->files[idx].name, selected, false, false);
                         }
                     }
                 }
@@ -232,17 +176,17 @@ static void on_key(screen_t *self, key_code_t key)
                 ESP_LOGW(TAG, "=== KARMA HTML SELECTION ===");
                 ESP_LOGW(TAG, "Stored probe_index=%d, stored ssid='%s'", data->probe_index, data->ssid);
                 
-                // Send select_html command (1-based index)
+                // Send select_html command with the 1-based ID from the listing
                 char cmd[32];
-                snprintf(cmd, sizeof(cmd), "select_html %d", data->selected_index + 1);
-                ESP_LOGW(TAG, "UART TX: '%s'", cmd);
-                uart_send_command(cmd);
+                snprintf(cmd, sizeof(cmd), "select_html %d", data->files[data->selected_index].id);
                 
-                // Send start_karma command with probe index
+                // Then start_karma with the probe index, in the same write
                 char karma_cmd[32];
                 snprintf(karma_cmd, sizeof(karma_cmd), "start_karma %d", data->probe_index);
-                ESP_LOGW(TAG, "UART TX: '%s' (for SSID: '%s')", karma_cmd, data->ssid);
-                uart_send_command(karma_cmd);
+                ESP_LOGW(TAG, "UART TX: '%s', '%s' (for SSID: '%s')", cmd, karma_cmd, data->ssid);
+                const char *const sequence[] = { cmd, karma_cmd };
+                uart_send_batch(sequence, 2, NULL, NULL);
+                cred_store_set_portal_ssid(data->ssid);
                 buzzer_beep_attack();
                 
                 // Create params for attack screen
@@ -252,11 +196,17 @@ static void on_key(screen_t *self, key_code_t key)
                     params->ssid[sizeof(params->ssid) - 1] = '\0';
                     
                     ESP_LOGW(TAG, "Pushing attack screen with ssid='%s'", params->ssid);
-                    screen_manager_push(karma_attack_screen_create, params);
+                    if (screen_manager_push(karma_attack_screen_create, params) == ESP_ERR_NO_MEM) free(params);
                 }
             }
             break;
             
+        case KEY_P:
+            if (!data->loading && data->selected_index < data->file_count) {
+                html_preview_show(&data->files[data->selected_index]);
+            }
+            break;
+            
         case KEY_ESC:
         case KEY_Q:
         case KEY_BACKSPACE:
@@ -272,8 +222,6 @@ static void on_destroy(screen_t *self)
 {
     karma_html_data_t *data = (karma_html_data_t *)self->user_data;
     
-    uart_clear_line_callback();
-    
     if (data) {
         free(data);
     }
@@ -319,11 +267,9 @@ screen_t* karma_html_screen_create(void *params)
     screen->on_draw = draw_screen;
     screen->on_tick = on_tick;
     
-    // Register UART callback
-    uart_register_line_callback(uart_line_callback, data);
-    
-    // Send command to list HTML files
-    uart_send_command("list_sd");
+    // Cached listing shows at once; list_sd runs only the first time
+    sd_listing_refresh(false);
+    load_files(data);
     
     // Draw initial screen
     draw_screen(screen);
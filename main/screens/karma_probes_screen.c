@@ -1,31 +1,40 @@
 /**
  * @file karma_probes_screen.c
  * @brief Karma probes selection screen implementation
+ *
+ * Lists the probed SSIDs of the shared probe store that JanOS can start
+ * Karma with, ranked by how many stations asked for them. The store is
+ * refreshed every REFRESH_US while the screen is open, and the cursor
+ * stays on the most requested SSID until the user moves it. TAB finds
+ * an SSID by name.
  */
 
 #include "karma_probes_screen.h"
 #include "karma_html_screen.h"
 #include "uart_handler.h"
+#include "probe_store.h"
+#include "mac_set.h"
+#include "fixed_containers.h"
 #include "text_ui.h"
+#include "ui_list.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
 
 static const char *TAG = "KARMA_PROBES";
 
-// Maximum probes
-#define MAX_PROBES      32
-#define MAX_SSID_LEN    33
+#define REFRESH_US      10000000    // Ask JanOS for new probes this often
 
 // Screen user data
 typedef struct {
-    char ssids[MAX_PROBES][MAX_SSID_LEN];
-    int probe_count;
-    int selected_index;
-    int scroll_offset;
+    uint16_t order[PROBE_STORE_MAX];    // Listed SSIDs, most stations first
+    ui_list_t list;
+    ui_typeahead_t find;
+    uint32_t generation;
+    bool user_moved;                    // Until then the cursor follows the top SSID
     bool loading;
-    bool needs_redraw;
+    int64_t refresh_us;
     screen_t *self;
 } karma_probes_data_t;
 
@@ -48,18 +57,21 @@ static bool is_esp_log_line(const char *line)
     // Check for other common log patterns
     if (strstr(line, "[MEM]") != NULL) return true;
     if (strncmp(line, "list_probes", 11) == 0) return true;  // Echo of command
+    if (strncmp(line, "show_probes", 11) == 0) return true;
     
     return false;
 }
 
 /**
- * @brief UART line callback for parsing list_probes output
- * Format: "1 SSID_name", "2 SSID_name2", etc.
+ * @brief UART line callback for list_probes output
+ * Format: "1 SSID_name", "2 SSID_name2", etc. The numbering only means
+ * something for this request, so it is parsed here rather than in
+ * world_model, which files the show_probes rows ("SSID (MAC)").
  */
 static void uart_line_callback(const char *line, void *user_data)
 {
     karma_probes_data_t *data = (karma_probes_data_t *)user_data;
-    if (!data || data->probe_count >= MAX_PROBES) return;
+    if (!data) return;
     
     // Skip empty lines
     if (strlen(line) == 0) return;
@@ -75,44 +87,65 @@ static void uart_line_callback(const char *line, void *user_data)
     // Check for "No probes" message
     if (strstr(line, "No probe") != NULL || strstr(line, "no probe") != NULL) {
         data->loading = false;
-        data->needs_redraw = true;
         return;
     }
     
-    // Parse numbered lines: "1 SSID_name" or " 1 SSID_name"
-    p = line;
-    while (*p == ' ') p++;
-    
-    // First character should be a digit
-    if (!isdigit((unsigned char)*p)) return;
-    
-    // Skip the number
-    while (isdigit((unsigned char)*p)) p++;
-    
-    // Skip space after number
-    if (*p != ' ') return;
-    p++;
-    
-    // Rest is the SSID
-    if (strlen(p) > 0) {
-        strncpy(data->ssids[data->probe_count], p, MAX_SSID_LEN - 1);
-        data->ssids[data->probe_count][MAX_SSID_LEN - 1] = '\0';
-        
-        // Remove trailing whitespace
-        char *end = data->ssids[data->probe_count] + strlen(data->ssids[data->probe_count]) - 1;
-        while (end > data->ssids[data->probe_count] && (*end == '\n' || *end == '\r' || *end == ' ')) {
-            *end = '\0';
-            end--;
-        }
-        
-        ESP_LOGW(TAG, "PARSED: array[%d] = '%s' (from line: '%s')", 
-                 data->probe_count, data->ssids[data->probe_count], line);
-        data->probe_count++;
+    // Station counts come from show_probes, JanOS numbers from list_probes
+    const char *open = strrchr(line, '(');
+    uint64_t key;
+    if (open && mac_set_key_from_mac(open + 1, &key)) return;
+    if (probe_store_add_list_line(line) >= 0) {
         data->loading = false;
-        data->needs_redraw = true;
     }
 }
 
+static void probe_row(int index, char *text, size_t len, void *user_data)
+{
+    karma_probes_data_t *data = (karma_probes_data_t *)user_data;
+    probe_record_t rec;
+    if (probe_store_get(data->order[index], &rec)) {
+        // SSID padded so the client counts line up at the row's end
+        int width = (int)len - 6;
+        snprintf(text, len, "%-*.*s %3u", width, width, ssid_pool_str(rec.ssid), rec.clients);
+    }
+}
+
+static void probe_name(int index, char *name, size_t len, void *user_data)
+{
+    karma_probes_data_t *data = (karma_probes_data_t *)user_data;
+    probe_record_t rec;
+    if (probe_store_get(data->order[index], &rec)) {
+        snprintf(name, len, "%s", ssid_pool_str(rec.ssid));
+    }
+}
+
+/**
+ * @brief Rebuild the ranking; the cursor keeps its SSID once the user moved it
+ */
+static void refresh_view(karma_probes_data_t *data)
+{
+    int selected = data->list.count > 0 ? data->order[data->list.selected] : -1;
+
+    data->generation = probe_store_generation();
+    int count = probe_store_view(data->order, PROBE_STORE_MAX, PROBE_SORT_POPULAR, true);
+    ui_list_rows_moved(&data->list);
+    ui_list_set_count(&data->list, count);
+
+    if (!data->user_moved) {
+        ui_list_select(&data->list, 0);
+        return;
+    }
+    int row = fixed_index_find(data->order, count, selected);
+    if (row >= 0) ui_list_select(&data->list, row);
+}
+
+static void request_probes(karma_probes_data_t *data)
+{
+    static const char *const refresh[] = { "show_probes", "list_probes" };
+    uart_send_batch(refresh, 2, NULL, NULL);
+    data->refresh_us = esp_timer_get_time();
+}
+
 static void draw_screen(screen_t *self)
 {
     karma_probes_data_t *data = (karma_probes_data_t *)self->user_data;
@@ -122,44 +155,39 @@ static void draw_screen(screen_t *self)
     // Draw title
     ui_draw_title("Select Probe for Karma");
     
-    if (data->loading) {
-        ui_print_center(3, "Loading probes...", UI_COLOR_DIMMED);
-    } else if (data->probe_count == 0) {
-        ui_print_center(3, "No probes found", UI_COLOR_DIMMED);
+    refresh_view(data);
+    if (data->list.count > 0) {
+        ui_list_draw(&data->list);
+    } else if (data->loading) {
+        ui_print_center(ui_rows() / 2 - 1, "Loading probes...", UI_COLOR_DIMMED);
     } else {
-        // Draw visible probes as menu items
-        int visible_rows = 6;
-        int start_row = 1;
-        
-        for (int i = 0; i < visible_rows; i++) {
-            int probe_idx = data->scroll_offset + i;
-            
-            if (probe_idx < data->probe_count) {
-                bool selected = (probe_idx == data->selected_index);
-                ui_draw_menu_item(start_row + i, data->ssids[probe_idx], selected, false, false);
-            }
-        }
-        
-        // Scroll indicators
-        if (data->scroll_offset > 0) {
-            ui_print(UI_COLS - 2, 1, "^", UI_COLOR_DIMMED);
-        }
-        if (data->scroll_offset + visible_rows < data->probe_count) {
-            ui_print(UI_COLS - 2, visible_rows, "v", UI_COLOR_DIMMED);
-        }
+        ui_print_center(ui_rows() / 2 - 1, "No probes found", UI_COLOR_DIMMED);
     }
     
     // Draw status bar
-    ui_draw_status("UP/DOWN:Nav ENTER:Select ESC:Back");
+    ui_list_draw_status(&data->list, "UP/DOWN:Nav ENTER:Select TAB:Find ESC:Back");
 }
 
 static void on_tick(screen_t *self)
 {
     karma_probes_data_t *data = (karma_probes_data_t *)self->user_data;
     
-    // Check if redraw needed from UART callback (thread-safe)
-    if (data->needs_redraw) {
-        data->needs_redraw = false;
+    // Live data: stations keep probing while Karma is being set up
+    if (esp_timer_get_time() - data->refresh_us >= REFRESH_US) {
+        request_probes(data);
+    }
+    
+    if (probe_store_generation() != data->generation) {
+        if (data->list.count == 0) {
+            draw_screen(self);
+        } else {
+            // Ranking changed: only the rows that changed are painted
+            refresh_view(data);
+            ui_list_draw(&data->list);
+        }
+    } else if (data->loading && esp_timer_get_time() - data->refresh_us >= UART_REQUEST_TIMEOUT_MS * 1000) {
+        // Nothing listed: JanOS has no probes
+        data->loading = false;
         draw_screen(self);
     }
 }
@@ -167,88 +195,30 @@ static void on_tick(screen_t *self)
 static void on_key(screen_t *self, key_code_t key)
 {
     karma_probes_data_t *data = (karma_probes_data_t *)self->user_data;
-    int visible_rows = 6;
+    
+    if (ui_list_handle_key(&data->list, key)) {
+        data->user_moved = true;
+        ui_list_draw(&data->list);
+        return;
+    }
     
     switch (key) {
-        case KEY_UP:
-            if (data->selected_index > 0) {
-                int old_idx = data->selected_index;
-                // Check if at first visible item on page - do page jump
-                if (data->selected_index == data->scroll_offset && data->scroll_offset > 0) {
-                    data->scroll_offset -= visible_rows;
-                    if (data->scroll_offset < 0) data->scroll_offset = 0;
-                    data->selected_index = data->scroll_offset + visible_rows - 1;
-                    if (data->selected_index >= data->probe_count) {
-                        data->selected_index = data->probe_count - 1;
-                    }
-                    draw_screen(self);  // Full redraw on page jump
-                } else {
-                    data->selected_index--;
-                    // Redraw only 2 rows
-                    int start_row = 1;
-                    for (int idx = old_idx; idx >= data->selected_index; idx--) {
-                        int i = idx - data->scroll_offset;
-                        if (i >= 0 && i < visible_rows && idx < data->probe_count) {
-                            bool selected = (idx == data->selected_index);
-                            ui_draw_menu_item(start_row + i, data->ssids[idx], selected, false, false);
-                        }
-                    }
-                }
-            } else if (data->probe_count > 0) {
-                data->selected_index = data->probe_count - 1;
-                data->scroll_offset = (data->selected_index / visible_rows) * visible_rows;
-                draw_screen(self);
-            }
-            break;
-            
-        case KEY_DOWN:
-            if (data->selected_index < data->probe_count - 1) {
-                int old_idx = data->selected_index;
-                // Check if at last visible item on page - do page jump
-                if (data->selected_index == data->scroll_offset + visible_rows - 1) {
-                    // Jump to next page - don't adjust back for partial pages
-                    data->scroll_offset += visible_rows;
-                    data->selected_index = data->scroll_offset;
-                    draw_screen(self);  // Full redraw on page jump
-                } else {
-                    data->selected_index++;
-                    // Redraw only 2 rows
-                    int start_row = 1;
-                    for (int idx = old_idx; idx <= data->selected_index; idx++) {
-                        int i = idx - data->scroll_offset;
-                        if (i >= 0 && i < visible_rows && idx < data->probe_count) {
-                            bool selected = (idx == data->selected_index);
-                            ui_draw_menu_item(start_row + i, data->ssids[idx], selected, false, false);
-                        }
-                    }
-                }
-            } else if (data->probe_count > 0) {
-                data->selected_index = 0;
-                data->scroll_offset = 0;
-                draw_screen(self);
-            }
-            break;
-            
         case KEY_ENTER:
         case KEY_SPACE:
-            if (data->probe_count > 0 && data->selected_index < data->probe_count) {
+            probe_record_t rec;
+            if (data->list.count > 0 && probe_store_get(data->order[data->list.selected], &rec)) {
                 // Create params for karma HTML screen
                 karma_html_params_t *params = malloc(sizeof(karma_html_params_t));
                 if (params) {
-                    params->probe_index = data->selected_index + 1;  // 1-based index
-                    strncpy(params->ssid, data->ssids[data->selected_index], sizeof(params->ssid) - 1);
+                    params->probe_index = rec.janos_id;  // 1-based JanOS number
+                    strncpy(params->ssid, ssid_pool_str(rec.ssid), sizeof(params->ssid) - 1);
                     params->ssid[sizeof(params->ssid) - 1] = '\0';
                     
-                    ESP_LOGW(TAG, "=== KARMA PROBE SELECTION ===");
-                    ESP_LOGW(TAG, "probe_count=%d, selected_index=%d", data->probe_count, data->selected_index);
-                    ESP_LOGW(TAG, "probe_index (1-based)=%d, ssid='%s'", params->probe_index, params->ssid);
-                    ESP_LOGW(TAG, "All probes in array:");
-                    for (int i = 0; i < data->probe_count && i < 5; i++) {
-                        ESP_LOGW(TAG, "  [%d] = '%s'%s", i, data->ssids[i], 
-                                 (i == data->selected_index) ? " <-- SELECTED" : "");
-                    }
+                    ESP_LOGI(TAG, "Karma probe %d '%s' (%u stations, rank %d of %d)",
+                             params->probe_index, params->ssid, rec.clients,
+                             data->list.selected + 1, data->list.count);
                     
-                    screen_manager_push(karma_html_screen_create, params);
+                    if (screen_manager_push(karma_html_screen_create, params) == ESP_ERR_NO_MEM) free(params);
                 }
             }
             break;
@@ -268,12 +238,8 @@ static void on_destroy(screen_t *self)
 {
     karma_probes_data_t *data = (karma_probes_data_t *)self->user_data;
     
-    // Clear UART callback
-    uart_clear_line_callback();
-    
-    if (data) {
-        free(data);
-    }
+    ui_typeahead_free(&data->find);
+    free(data);
 }
 
 screen_t* karma_probes_screen_create(void *params)
@@ -292,20 +258,33 @@ screen_t* karma_probes_screen_create(void *params)
         return NULL;
     }
     
+    if (probe_store_init() != ESP_OK) {
+        free(data);
+        free(screen);
+        return NULL;
+    }
     data->loading = true;
     data->self = screen;
+    screen_set_density(screen, UI_DENSITY_COMPACT);
+    ui_list_init(&data->list, 1, UI_LIST_MAX_ROWS, probe_row, data);
+    if (ui_typeahead_init(&data->find, PROBE_STORE_MAX, probe_name, data) == ESP_OK) {
+        ui_list_set_typeahead(&data->list, &data->find);
+    }
     
     screen->user_data = data;
     screen->on_key = on_key;
     screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
     screen->on_tick = on_tick;
+    // Changed rankings are repainted row by row over the kept pixels
+    screen->on_restore = on_tick;
     
     // Register UART callback
-    uart_register_line_callback(uart_line_callback, data);
+    screen_set_line_callback(screen, uart_line_callback, data);
     
-    // Send command to get probes
-    uart_send_command("list_probes");
+    // JanOS numbers its list afresh for this visit
+    probe_store_begin_list();
+    request_probes(data);
     
     // Draw initial screen
     draw_screen(screen);
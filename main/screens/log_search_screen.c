@@ -0,0 +1,221 @@
+/**
+ * @file log_search_screen.c
+ * @brief Lookup of a MAC or SSID across the session logs on SD
+ *
+ * S or Enter on an empty list asks for a MAC or an exact SSID and lists
+ * the matching records of all kept session files, newest first, through
+ * the session_index. Enter opens the selected record with one field per
+ * line.
+ */
+
+#include "log_search_screen.h"
+#include "session_index.h"
+#include "session_log.h"
+#include "text_input_screen.h"
+#include "data_detail_screen.h"
+#include "screenshot.h"
+#include "text_ui.h"
+#include "ui_list.h"
+#include "keyboard.h"
+#include "esp_log.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+static const char *TAG = "LOG_SEARCH_SCR";
+
+#define MAX_HITS            48
+
+// Summary row above the status bar
+#define SUMMARY_ROWS        1
+
+// Screen user data
+typedef struct {
+    ui_list_t list;
+    char query[TEXT_INPUT_MAX_LEN + 1];
+    session_index_result_t result;
+    session_index_hit_t hits[MAX_HITS];
+} log_search_data_t;
+
+/**
+ * @brief Record fields after the time: "<TYPE>\t<fields>"
+ */
+static const char *record_body(const char *record)
+{
+    const char *tab = strchr(record, '\t');
+    return tab ? tab + 1 : record;
+}
+
+static void hit_row(int index, char *text, size_t len, void *user_data)
+{
+    log_search_data_t *data = (log_search_data_t *)user_data;
+    const session_index_hit_t *hit = &data->hits[index];
+    
+    int n = snprintf(text, len, "%d ", hit->file);
+    if (n < 0 || (size_t)n >= len) return;
+    strlcpy(text + n, record_body(hit->record), len - n);
+    for (char *p = text; *p; p++) {
+        if (*p == '\t') *p = ' ';
+    }
+}
+
+static void draw_summary(const log_search_data_t *data)
+{
+    char line[UI_COLS_MAX + 1] = "";
+    
+    if (data->query[0]) {
+        snprintf(line, sizeof(line), "%d hits %lu files %lums", data->result.hits,
+                 (unsigned long)data->result.files,
+                 (unsigned long)(data->result.elapsed_us / 1000));
+    }
+    char padded[UI_COLS_MAX + 1];
+    snprintf(padded, sizeof(padded), " %-*.*s", ui_cols() - 1, ui_cols() - 1, line);
+    ui_print(0, ui_rows() - 1 - SUMMARY_ROWS, padded, UI_COLOR_DIMMED);
+}
+
+static void draw_screen(screen_t *self)
+{
+    log_search_data_t *data = (log_search_data_t *)self->user_data;
+    
+    ui_clear();
+    if (data->query[0]) {
+        char title[UI_COLS_MAX + 1];
+        snprintf(title, sizeof(title), "Log: %s", data->query);
+        ui_draw_title(title);
+    } else {
+        ui_draw_title("Log Search");
+    }
+    
+    if (!screenshot_is_available()) {
+        ui_print_center(ui_rows() / 2 - 1, "No SD card", UI_COLOR_DIMMED);
+    } else if (!data->query[0]) {
+        ui_print_center(ui_rows() / 2 - 1, "S: search MAC or SSID", UI_COLOR_DIMMED);
+    } else if (data->list.count == 0) {
+        ui_print_center(ui_rows() / 2 - 1, "No records found", UI_COLOR_DIMMED);
+    } else {
+        ui_list_draw(&data->list);
+    }
+    draw_summary(data);
+    
+    ui_draw_status("S:Search ENT:Open");
+}
+
+static void on_query_submitted(const char *text, void *user_data)
+{
+    log_search_data_t *data = (log_search_data_t *)user_data;
+    
+    strlcpy(data->query, text, sizeof(data->query));
+    // Records still waiting for the card are not found; push them out
+    session_log_flush();
+    int count = session_index_find(data->query, data->hits, MAX_HITS, &data->result);
+    ui_list_set_count(&data->list, count);
+    ui_list_select(&data->list, 0);
+    
+    // on_resume redraws the results
+    screen_manager_pop();
+}
+
+static void ask_query(log_search_data_t *data)
+{
+    text_input_params_t *params = calloc(1, sizeof(text_input_params_t));
+    if (!params) return;
+    params->title = "Search Logs";
+    params->hint = "MAC or exact SSID";
+    params->on_submit = on_query_submitted;
+    params->user_data = data;
+    params->history = "log_search";
+    params->complete_ssids = true;
+    if (screen_manager_push(text_input_screen_create, params) == ESP_ERR_NO_MEM) free(params);
+}
+
+static void open_hit(const session_index_hit_t *hit)
+{
+    data_detail_params_t *params = calloc(1, sizeof(data_detail_params_t));
+    if (!params) return;
+    snprintf(params->title, DETAIL_MAX_TITLE_LEN, "Session %d @%lu", hit->file,
+             (unsigned long)hit->offset);
+    
+    // One field per line, the time first
+    size_t len = strlen(hit->record) + 8;
+    params->content = malloc(len);
+    if (params->content) {
+        snprintf(params->content, len, "us: %s", hit->record);
+        for (char *p = params->content; *p; p++) {
+            if (*p == '\t') *p = '\n';
+        }
+    }
+    if (screen_manager_push(data_detail_screen_create, params) == ESP_ERR_NO_MEM) {
+        free(params->content);
+        free(params);
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    log_search_data_t *data = (log_search_data_t *)self->user_data;
+    
+    if (ui_list_handle_key(&data->list, key)) {
+        ui_list_draw(&data->list);
+        return;
+    }
+    
+    switch (key) {
+        case KEY_S:
+            if (screenshot_is_available()) ask_query(data);
+            break;
+            
+        case KEY_ENTER:
+            if (data->list.count > 0) {
+                open_hit(&data->hits[data->list.selected]);
+            } else if (screenshot_is_available()) {
+                ask_query(data);
+            }
+            break;
+            
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    free(self->user_data);
+}
+
+static void on_resume(screen_t *self)
+{
+    draw_screen(self);
+}
+
+screen_t* log_search_screen_create(void *params)
+{
+    (void)params;
+    
+    ESP_LOGI(TAG, "Creating log search screen...");
+    
+    screen_t *screen = screen_alloc();
+    log_search_data_t *data = screen ? calloc(1, sizeof(log_search_data_t)) : NULL;
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    ui_list_init(&data->list, 1, ui_rows() - 2 - SUMMARY_ROWS, hit_row, data);
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_resume = on_resume;
+    screen->on_draw = draw_screen;
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "Log search screen created");
+    return screen;
+}
@@ -0,0 +1,18 @@
+/**
+ * @file log_search_screen.h
+ * @brief Lookup of a MAC or SSID across the session logs on SD
+ */
+
+#ifndef LOG_SEARCH_SCREEN_H
+#define LOG_SEARCH_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the log search screen
+ * @param params Unused
+ * @return Screen instance
+ */
+screen_t* log_search_screen_create(void *params);
+
+#endif // LOG_SEARCH_SCREEN_H
@@ -0,0 +1,169 @@
+/**
+ * @file mem_monitor_screen.c
+ * @brief Heap and per-subsystem memory diagnostics screen implementation
+ *
+ * Shows free internal heap with its largest block and minimum since boot,
+ * DMA heap, fragmentation and low-memory episodes, then what each
+ * subsystem holds now and at its peak. R runs the low-memory callbacks.
+ * B switches to the screens closest to or over their memory and CPU
+ * budgets (screen_budget.h), worst first.
+ */
+
+#include "mem_monitor_screen.h"
+#include "mem_monitor.h"
+#include "screen_budget.h"
+#include "text_ui.h"
+#include "keyboard.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *TAG = "MEM_SCREEN";
+
+#define REFRESH_INTERVAL_US 1000000
+#define BUDGET_ROWS         5
+
+typedef struct {
+    int64_t last_refresh_us;
+    bool budgets;                   // Showing the screen budget page
+} mem_screen_data_t;
+
+static void draw_budgets(void)
+{
+    screen_budget_report_t worst[BUDGET_ROWS];
+    int count = screen_budget_get_report(worst, BUDGET_ROWS);
+    
+    ui_clear();
+    ui_draw_title("Screen budgets");
+    
+    char line[UI_COLS + 1];
+    snprintf(line, sizeof(line), " %-11s  KB/max  CPU/max", "Screen");
+    ui_print(0, 1, line, UI_COLOR_DIMMED);
+    if (count == 0) {
+        ui_print(0, 2, " No screen measured yet", UI_COLOR_DIMMED);
+    }
+    for (int i = 0; i < count; i++) {
+        const screen_budget_report_t *r = &worst[i];
+        snprintf(line, sizeof(line), " %-11.11s%4luK/%-3lu %3u/%-3u%s",
+                 r->name[0] ? r->name : "?",
+                 (unsigned long)(r->mem_peak / 1024), (unsigned long)(r->mem_budget / 1024),
+                 r->cpu_peak_pct, r->cpu_budget_pct, r->max_shift ? "*" : "");
+        ui_print(0, 2 + i, line, r->overruns ? UI_COLOR_HIGHLIGHT : UI_COLOR_TEXT);
+    }
+    
+    ui_draw_status("ESC:Back B:Memory *:Slowed");
+}
+
+static void draw_screen(screen_t *self)
+{
+    mem_screen_data_t *data = (mem_screen_data_t *)self->user_data;
+    if (data->budgets) {
+        draw_budgets();
+        return;
+    }
+    
+    mem_monitor_stats_t s;
+    mem_monitor_get_stats(&s);
+    
+    ui_clear();
+    ui_draw_title("Memory");
+    
+    char line[UI_COLS + 1];
+    snprintf(line, sizeof(line), " Heap %3luK max %3luK min %3luK",
+             (unsigned long)(s.internal_free / 1024),
+             (unsigned long)(s.internal_largest / 1024),
+             (unsigned long)(s.internal_min_free / 1024));
+    ui_print(0, 1, line, s.low ? UI_COLOR_HIGHLIGHT : UI_COLOR_TEXT);
+    
+    snprintf(line, sizeof(line), " DMA  %3luK frag %2u%% low %lu",
+             (unsigned long)(s.dma_free / 1024), (unsigned)s.fragmentation_pct,
+             (unsigned long)s.low_events);
+    ui_print(0, 2, line, UI_COLOR_TEXT);
+    
+    for (int i = 0; i < MEM_SUB_COUNT; i++) {
+        const mem_sub_usage_t *u = &s.subs[i];
+        snprintf(line, sizeof(line), " %-6s %6luB peak %6luB",
+                 mem_monitor_sub_name((mem_sub_t)i),
+                 (unsigned long)u->bytes, (unsigned long)u->peak);
+        ui_print(0, 3 + i, line, u->bytes ? UI_COLOR_TEXT : UI_COLOR_DIMMED);
+    }
+    
+    snprintf(line, sizeof(line), "ESC R:Reclaim %luK B:Budgets",
+             (unsigned long)(s.reclaimed / 1024));
+    ui_draw_status(line);
+}
+
+static void on_tick(screen_t *self)
+{
+    mem_screen_data_t *data = (mem_screen_data_t *)self->user_data;
+    
+    int64_t now = esp_timer_get_time();
+    if (now - data->last_refresh_us >= REFRESH_INTERVAL_US) {
+        data->last_refresh_us = now;
+        draw_screen(self);
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    switch (key) {
+        case KEY_R: {
+            size_t released = mem_monitor_reclaim();
+            ESP_LOGI(TAG, "Manual reclaim released %uB", (unsigned)released);
+            draw_screen(self);
+            break;
+        }
+        
+        case KEY_B: {
+            mem_screen_data_t *data = (mem_screen_data_t *)self->user_data;
+            data->budgets = !data->budgets;
+            draw_screen(self);
+            break;
+        }
+        
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    if (self->user_data) {
+        free(self->user_data);
+    }
+}
+
+screen_t* mem_monitor_screen_create(void *params)
+{
+    (void)params;
+    
+    ESP_LOGI(TAG, "Creating memory screen...");
+    
+    screen_t *screen = screen_alloc();
+    if (!screen) return NULL;
+    
+    mem_screen_data_t *data = calloc(1, sizeof(mem_screen_data_t));
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    data->last_refresh_us = esp_timer_get_time();
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "Memory screen created");
+    return screen;
+}
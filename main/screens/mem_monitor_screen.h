@@ -0,0 +1,18 @@
+/**
+ * @file mem_monitor_screen.h
+ * @brief Heap and per-subsystem memory diagnostics screen
+ */
+
+#ifndef MEM_MONITOR_SCREEN_H
+#define MEM_MONITOR_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the memory diagnostics screen
+ * @param params Unused
+ * @return Screen instance
+ */
+screen_t* mem_monitor_screen_create(void *params);
+
+#endif // MEM_MONITOR_SCREEN_H
@@ -0,0 +1,170 @@
+/**
+ * @file metrics_screen.c
+ * @brief Graph of one live counter from the metrics store
+ *
+ * Each point is a column: a dim bar from the minimum to the maximum of
+ * the interval and a bright mark at its average. The scale fits the
+ * points shown. LEFT/RIGHT pick the metric, R steps through the 1 s,
+ * 10 s and 60 s rings. The graph follows metrics_store_generation().
+ */
+
+#include "metrics_screen.h"
+#include "metrics_store.h"
+#include "text_ui.h"
+#include "display.h"
+#include "keyboard.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *TAG = "METRICS_SCREEN";
+
+#define GRAPH_MAX_POINTS    METRICS_RING_60S
+
+typedef struct {
+    metric_id_t metric;
+    metrics_res_t res;
+    uint32_t generation;            // metrics_store_generation() drawn
+    metrics_point_t points[GRAPH_MAX_POINTS];
+} metrics_screen_data_t;
+
+static void draw_title(metrics_screen_data_t *data)
+{
+    char title[32];
+    snprintf(title, sizeof(title), "%s / %ds", metrics_store_name(data->metric),
+             metrics_store_step_s(data->res));
+    ui_draw_title(title);
+}
+
+static int graph_y(int32_t v, int32_t lo, int32_t hi, int top, int h)
+{
+    return top + h - 1 - (int)((int64_t)(v - lo) * (h - 1) / (hi - lo));
+}
+
+static void draw_graph(metrics_screen_data_t *data)
+{
+    int top = ui_row_y(1) + 1;
+    int h = ui_row_y(ui_rows() - 1) - top - 1;
+    int len = metrics_store_ring_len(data->res);
+    int col_w = DISPLAY_WIDTH / len;
+    int n = metrics_store_read(data->metric, data->res, data->points, GRAPH_MAX_POINTS);
+    data->generation = metrics_store_generation();
+    
+    display_fill_rect(0, top, DISPLAY_WIDTH, h, UI_COLOR_BG);
+    if (n == 0) {
+        ui_print_center(ui_rows() / 2, "Collecting...", UI_COLOR_DIMMED);
+        ui_draw_status("</>:Metric R:Res ESC:Back");
+        return;
+    }
+    
+    int32_t lo = data->points[0].min, hi = data->points[0].max;
+    for (int i = 1; i < n; i++) {
+        if (data->points[i].min < lo) lo = data->points[i].min;
+        if (data->points[i].max > hi) hi = data->points[i].max;
+    }
+    if (hi == lo) hi = lo + 1;
+    
+    // Newest point at the right edge
+    int x = DISPLAY_WIDTH - n * col_w;
+    for (int i = 0; i < n; i++, x += col_w) {
+        const metrics_point_t *p = &data->points[i];
+        int y_max = graph_y(p->max, lo, hi, top, h);
+        int y_min = graph_y(p->min, lo, hi, top, h);
+        display_fill_rect(x, y_max, col_w, y_min - y_max + 1, UI_COLOR_SELECTED);
+        display_draw_hline(x, graph_y(p->avg, lo, hi, top, h), col_w, UI_COLOR_HIGHLIGHT);
+    }
+    
+    char label[16];
+    snprintf(label, sizeof(label), "%ld", (long)hi);
+    ui_draw_text(0, top, label, UI_COLOR_DIMMED, UI_COLOR_BG);
+    snprintf(label, sizeof(label), "%ld", (long)lo);
+    ui_draw_text(0, top + h - ui_cell_height(), label, UI_COLOR_DIMMED, UI_COLOR_BG);
+    
+    char status[UI_COLS + 1];
+    snprintf(status, sizeof(status), "Now %ld  </>:Metric R:Res", (long)data->points[n - 1].avg);
+    ui_draw_status(status);
+}
+
+static void draw_screen(screen_t *self)
+{
+    metrics_screen_data_t *data = (metrics_screen_data_t *)self->user_data;
+    
+    ui_clear();
+    draw_title(data);
+    draw_graph(data);
+}
+
+static void on_tick(screen_t *self)
+{
+    metrics_screen_data_t *data = (metrics_screen_data_t *)self->user_data;
+    
+    if (metrics_store_generation() != data->generation) {
+        draw_graph(data);
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    metrics_screen_data_t *data = (metrics_screen_data_t *)self->user_data;
+    
+    switch (key) {
+        case KEY_LEFT:
+            data->metric = (data->metric + METRIC_COUNT - 1) % METRIC_COUNT;
+            draw_screen(self);
+            break;
+            
+        case KEY_RIGHT:
+            data->metric = (data->metric + 1) % METRIC_COUNT;
+            draw_screen(self);
+            break;
+            
+        case KEY_R:
+            data->res = (data->res + 1) % METRICS_RES_COUNT;
+            draw_screen(self);
+            break;
+            
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    free(self->user_data);
+}
+
+static void on_resume(screen_t *self)
+{
+    draw_screen(self);
+}
+
+screen_t* metrics_screen_create(void *params)
+{
+    (void)params;
+    ESP_LOGI(TAG, "Creating metrics screen...");
+    
+    screen_t *screen = screen_alloc();
+    metrics_screen_data_t *data = screen ? calloc(1, sizeof(metrics_screen_data_t)) : NULL;
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_resume = on_resume;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "Metrics screen created");
+    return screen;
+}
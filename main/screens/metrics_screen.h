@@ -0,0 +1,18 @@
+/**
+ * @file metrics_screen.h
+ * @brief Graph of one live counter from the metrics store
+ */
+
+#ifndef METRICS_SCREEN_H
+#define METRICS_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the metrics graph screen
+ * @param params Unused (NULL)
+ * @return Created screen or NULL on failure
+ */
+screen_t* metrics_screen_create(void *params);
+
+#endif // METRICS_SCREEN_H
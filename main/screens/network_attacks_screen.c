@@ -4,6 +4,7 @@
  */
 
 #include "network_attacks_screen.h"
+#include "screen_registry.h"
 #include "wifi_connect_screen.h"
 #include "arp_hosts_screen.h"
 #include "wpasec_upload_screen.h"
@@ -191,3 +192,5 @@ screen_t* network_attacks_screen_create(void *params)
     ESP_LOGI(TAG, "Network attacks screen created");
     return screen;
 }
+
+SCREEN_REGISTER(HOME, 70, network_attacks_screen_create, 0, "Network Attacks", "Network Tests");
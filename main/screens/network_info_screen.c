@@ -5,11 +5,23 @@
  * Displays detailed information about a WiFi network:
  * SSID, BSSID, security, signal strength, channel
  * With option to connect to the network.
+ *
+ * TAB shows what the other stores know about the AP: sniffed clients,
+ * stations probing for its SSID, deauth reports, captured handshakes and
+ * where the CAP GPS placed it. Each is a hash lookup by BSSID or SSID,
+ * so the page costs no UART query and follows the stores as they fill.
  */
 
 #include "network_info_screen.h"
 #include "text_input_screen.h"
 #include "arp_hosts_screen.h"
+#include "ap_signal_screen.h"
+#include "network_store.h"
+#include "probe_store.h"
+#include "world_model.h"
+#include "station_store.h"
+#include "mac_set.h"
+#include "time_sync.h"
 #include "text_ui.h"
 #include "esp_log.h"
 #include <string.h>
@@ -33,6 +45,8 @@ typedef struct {
     char result_msg[64];
     bool needs_redraw;
     bool needs_push_password;
+    bool show_joined;               // TAB page: data from the other stores
+    uint32_t joined_generation;     // Store generations summed at the last draw
     screen_t *self;
 } network_info_data_t;
 
@@ -68,6 +82,81 @@ static void uart_line_callback(const char *line, void *user_data)
     }
 }
 
+/**
+ * @brief Sum of the generations the joined page reads from
+ */
+static uint32_t joined_generation(void)
+{
+    return world_model_generation() + probe_store_generation() + station_store_generation() +
+           network_store_passes() + (uint32_t)network_store_count();
+}
+
+static uint32_t seconds_since(int64_t us)
+{
+    return (uint32_t)((time_sync_now_us() - us) / 1000000);
+}
+
+/**
+ * @brief Rows 1-6 of the joined page
+ */
+static void draw_joined(network_info_data_t *data)
+{
+    wifi_network_t *net = &data->network;
+    char line[32];
+    
+    int clients = world_model_ap_clients(net->ssid, net->channel);
+    station_ap_t sniffed;
+    if (station_store_ap_get(station_store_find_ap(net->ssid, net->channel), &sniffed)) {
+        // Listed by JanOS now, and kept in the station store
+        snprintf(line, sizeof(line), "Clients: %u, %u kept", sniffed.listed, sniffed.clients);
+    } else if (clients >= 0) {
+        snprintf(line, sizeof(line), "Clients: %d", clients);
+    } else {
+        snprintf(line, sizeof(line), "Clients: not sniffed");
+    }
+    ui_print(0, 1, line, UI_COLOR_TEXT);
+    
+    probe_record_t probe;
+    int probe_index = probe_store_find(net->ssid);
+    if (probe_index >= 0 && probe_store_get(probe_index, &probe)) {
+        snprintf(line, sizeof(line), "Probed by: %u stations", probe.clients);
+    } else {
+        snprintf(line, sizeof(line), "Probed by: none");
+    }
+    ui_print(0, 2, line, UI_COLOR_TEXT);
+    
+    uint64_t bssid_key;
+    world_deauth_t deauth;
+    if (mac_set_key_from_mac(net->bssid, &bssid_key) && world_model_deauths(bssid_key, &deauth)) {
+        snprintf(line, sizeof(line), "Deauths: %lu, %lus ago", (unsigned long)deauth.reports,
+                 (unsigned long)seconds_since(deauth.last_us));
+    } else {
+        snprintf(line, sizeof(line), "Deauths: none");
+    }
+    ui_print(0, 3, line, UI_COLOR_TEXT);
+    
+    world_handshake_t handshake;
+    int handshakes = world_model_handshakes_for(net->ssid, &handshake);
+    if (handshakes > 0) {
+        snprintf(line, sizeof(line), "Handshakes: %d, %lus ago", handshakes,
+                 (unsigned long)seconds_since(handshake.time_us));
+    } else {
+        snprintf(line, sizeof(line), "Handshakes: none");
+    }
+    ui_print(0, 4, line, UI_COLOR_TEXT);
+    
+    network_sighting_t sighting;
+    if (network_store_sighting(network_store_find(net->bssid), &sighting)) {
+        snprintf(line, sizeof(line), "GPS %.5f,%.5f", sighting.lat_e7 / 1e7, sighting.lon_e7 / 1e7);
+        ui_print(0, 5, line, UI_COLOR_TEXT);
+        snprintf(line, sizeof(line), "  at %d dBm, %u fixes", sighting.rssi, sighting.fixes);
+        ui_print(0, 6, line, UI_COLOR_DIMMED);
+    } else {
+        ui_print(0, 5, "GPS: no fix when heard", UI_COLOR_DIMMED);
+    }
+    data->joined_generation = joined_generation();
+}
+
 static void draw_screen(screen_t *self)
 {
     network_info_data_t *data = (network_info_data_t *)self->user_data;
@@ -105,6 +194,12 @@ static void draw_screen(screen_t *self)
     }
     
     // STATE_VIEW - normal info display
+    if (data->show_joined) {
+        draw_joined(data);
+        ui_draw_status("TAB:Info S:Signal ESC:Back");
+        return;
+    }
+    
     char line[32];
     
     // Row 1: SSID
@@ -135,7 +230,7 @@ static void draw_screen(screen_t *self)
     ui_print_center(6, "[ENTER to Connect]", UI_COLOR_HIGHLIGHT);
     
     // Draw status bar
-    ui_draw_status("ENTER:Connect ESC:Back");
+    ui_draw_status("ENT:Connect S:Signal TAB:More");
 }
 
 static void on_tick(screen_t *self)
@@ -152,7 +247,9 @@ static void on_tick(screen_t *self)
             params->hint = "WiFi password";
             params->on_submit = on_password_submitted;
             params->user_data = data;
-            screen_manager_push(text_input_screen_create, params);
+            params->history = "password";
+            params->complete_ssids = false;
+            if (screen_manager_push(text_input_screen_create, params) == ESP_ERR_NO_MEM) free(params);
         }
         return;
     }
@@ -160,6 +257,13 @@ static void on_tick(screen_t *self)
     if (data->needs_redraw) {
         data->needs_redraw = false;
         draw_screen(self);
+        return;
+    }
+    
+    // Joined page follows the stores while it is shown
+    if (data->state == STATE_VIEW && data->show_joined &&
+        joined_generation() != data->joined_generation) {
+        draw_screen(self);
     }
 }
 
@@ -184,7 +288,7 @@ static void on_password_submitted(const char *text, void *user_data)
     draw_screen(data->self);
     
     // Register UART callback
-    uart_register_line_callback(uart_line_callback, data);
+    screen_set_line_callback(data->self, uart_line_callback, data);
     
     // Send connect command
     char cmd[128];
@@ -201,7 +305,7 @@ static void on_key(screen_t *self, key_code_t key)
         if (key == KEY_ENTER || key == KEY_SPACE) {
             if (data->success) {
                 // Push ARP hosts screen
-                uart_clear_line_callback();
+                screen_set_line_callback(self, NULL, NULL);
                 screen_manager_push(arp_hosts_screen_create, NULL);
             } else {
                 // Try again - go back to view state
@@ -209,7 +313,6 @@ static void on_key(screen_t *self, key_code_t key)
                 draw_screen(self);
             }
         } else if (key == KEY_ESC || key == KEY_BACKSPACE) {
-            uart_clear_line_callback();
             screen_manager_pop();
         }
         return;
@@ -219,7 +322,6 @@ static void on_key(screen_t *self, key_code_t key)
     if (data->state == STATE_CONNECTING) {
         if (key == KEY_ESC) {
             // Cancel and go back
-            uart_clear_line_callback();
             screen_manager_pop();
         }
         return;
@@ -233,6 +335,21 @@ static void on_key(screen_t *self, key_code_t key)
             data->needs_push_password = true;
             break;
             
+        case KEY_TAB:
+            data->show_joined = !data->show_joined;
+            draw_screen(self);
+            break;
+            
+        case KEY_S: {
+            // Live RSSI graph for this AP
+            ap_signal_params_t *params = malloc(sizeof(ap_signal_params_t));
+            if (params) {
+                params->network = data->network;
+                if (screen_manager_push(ap_signal_screen_create, params) == ESP_ERR_NO_MEM) free(params);
+            }
+            break;
+        }
+            
         case KEY_ESC:
         case KEY_Q:
         case KEY_BACKSPACE:
@@ -248,9 +365,6 @@ static void on_destroy(screen_t *self)
 {
     network_info_data_t *data = (network_info_data_t *)self->user_data;
     
-    // Clear UART callback if we registered one
-    uart_clear_line_callback();
-    
     if (data) {
         free(data);
     }
@@ -1,14 +1,22 @@
 /**
  * @file network_list_screen.c
  * @brief Network list screen with checkboxes implementation
+ *
+ * TAB finds a network by SSID (hidden ones by BSSID) in the current view.
  */
 
 #include "network_list_screen.h"
 #include "attack_select_screen.h"
 #include "network_info_screen.h"
+#include "scan_diff_screen.h"
+#include "text_input_screen.h"
 #include "uart_handler.h"
+#include "network_store.h"
+#include "fixed_containers.h"
 #include "text_ui.h"
+#include "ui_typeahead.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -17,43 +25,125 @@ static const char *TAG = "NET_LIST";
 // Maximum visible items
 #define VISIBLE_ITEMS   5
 
+// Filter modes, cycled with F
+typedef enum {
+    FILTER_ALL = 0,
+    FILTER_2G,
+    FILTER_5G,
+    FILTER_OPEN,
+    FILTER_NAME,
+    FILTER_MODE_COUNT
+} filter_mode_t;
+
+static const char *sort_labels[NETWORK_SORT_COUNT] = { "", "RSSI", "Ch", "Name", "Sec" };
+
+// Live mode rescan intervals, cycled with L (0 = off)
+static const uint8_t live_intervals_s[] = { 0, 10, 30, 60 };
+#define LIVE_INTERVAL_COUNT (sizeof(live_intervals_s) / sizeof(live_intervals_s[0]))
+
 // Screen user data
 typedef struct {
-    wifi_network_t *networks;
-    int count;
-    int selected_index;
+    uint16_t *order;            // View: store indices, filtered and sorted
+    int count;                  // Rows in the view
+    int scanned;                // Store records taken into the view so far
+    bool scan_done;
+    network_sort_t sort;
+    filter_mode_t filter_mode;
+    network_filter_t filter;
+    int selected_index;         // View row under the cursor
     int scroll_offset;
     bool focus_on_next;
+    int live;                   // live_intervals_s index, 0 = one-shot
+    uint32_t passes;            // network_store_passes() the view reflects
+    ui_typeahead_t find;
 } network_list_data_t;
 
-static int count_selected(network_list_data_t *data)
+/**
+ * @brief Add store records that arrived since the last update to the view
+ * @return Lowest view row that changed, or -1 if none did
+ */
+static int view_add_new(network_list_data_t *data, int received)
 {
-    int count = 0;
-    for (int i = 0; i < data->count; i++) {
-        if (data->networks[i].selected) count++;
+    int first_changed = -1;
+    
+    for (int rec = data->scanned; rec < received; rec++) {
+        if (!network_store_matches(rec, &data->filter)) continue;
+        
+        int pos = fixed_index_insert(data->order, &data->count, NETWORK_STORE_MAX, rec,
+                                     data->sort == NETWORK_SORT_ARRIVAL ? NULL :
+                                     network_store_compare_ctx, &data->sort);
+        if (pos < 0) break;
+        if (pos < data->count - 1) ui_typeahead_rows_moved(&data->find);
+        
+        // Keep the cursor on the same network
+        if (data->count > 1 && pos <= data->selected_index) {
+            data->selected_index++;
+            data->scroll_offset++;
+        }
+        if (first_changed < 0 || pos < first_changed) first_changed = pos;
     }
-    return count;
+    data->scanned = received;
+    ui_typeahead_sync(&data->find, data->count);
+    return first_changed;
 }
 
-static void send_select_networks(network_list_data_t *data)
+/**
+ * @brief Rebuild the view after the sort or filter changed
+ */
+static void view_rebuild(network_list_data_t *data)
 {
-    char cmd[256] = "select_networks";
-    for (int i = 0; i < data->count; i++) {
-        if (data->networks[i].selected) {
-            char idx[8];
-            snprintf(idx, sizeof(idx), " %d", data->networks[i].id);
-            strlcat(cmd, idx, sizeof(cmd));
+    int cursor_rec = (data->selected_index < data->count) ? data->order[data->selected_index] : -1;
+    
+    data->count = 0;
+    for (int rec = 0; rec < data->scanned; rec++) {
+        if (network_store_matches(rec, &data->filter)) {
+            data->order[data->count++] = rec;
         }
     }
-    uart_send_command(cmd);
+    if (data->sort != NETWORK_SORT_ARRIVAL) {
+        network_store_sort(data->order, data->count, data->sort);
+    }
+    ui_typeahead_rows_moved(&data->find);
+    
+    // Follow the cursor's network if it is still shown, else start at the top
+    data->selected_index = fixed_index_find(data->order, data->count, cursor_rec);
+    if (data->selected_index < 0) data->selected_index = 0;
+    data->scroll_offset = data->selected_index - data->selected_index % VISIBLE_ITEMS;
+}
+
+/**
+ * @brief Selected and in the latest scans, so its JanOS index is current
+ */
+static bool is_target(int rec)
+{
+    return network_store_is_selected(rec) && !network_store_is_stale(rec);
+}
+
+static int count_selected(network_list_data_t *data)
+{
+    (void)data;
+    // Selections hidden by the filter still count; stale ones wait to be seen again
+    return network_store_target_count();
+}
+
+static void send_select_networks(int count)
+{
+    uint16_t *ids = malloc(count * sizeof(uint16_t));
+    if (!ids) return;
+    count = network_store_target_ids(ids, count);
+    if (count > 0) uart_select_networks(ids, count);
+    free(ids);
 }
 
 static void navigate_to_attack(network_list_data_t *data)
 {
+    // JanOS only accepts a selection once the scan dump has finished
+    if (!data->scan_done) return;
+    
     int sel_count = count_selected(data);
     if (sel_count > 0) {
         // Send select_networks command first
-        send_select_networks(data);
+        send_select_networks(sel_count);
         
         // Create attack params
         attack_select_params_t *params = malloc(sizeof(attack_select_params_t));
@@ -63,12 +153,15 @@ static void navigate_to_attack(network_list_data_t *data)
             params->count = 0;
             
             if (params->networks) {
-                for (int i = 0; i < data->count; i++) {
-                    if (data->networks[i].selected) {
-                        params->networks[params->count++] = data->networks[i];
+                for (int i = 0; i < data->scanned && params->count < sel_count; i++) {
+                    if (is_target(i)) {
+                        network_store_get(i, &params->networks[params->count++]);
                     }
                 }
-                screen_manager_push(attack_select_screen_create, params);
+                if (screen_manager_push(attack_select_screen_create, params) == ESP_ERR_NO_MEM) {
+                    free(params->networks);
+                    free(params);
+                }
             } else {
                 free(params);
             }
@@ -76,6 +169,34 @@ static void navigate_to_attack(network_list_data_t *data)
     }
 }
 
+// Row text, formatted from the packed record at draw time
+static void format_row_label(const network_record_t *net, char *label, size_t size)
+{
+    // New since the last rescan, or selected but no longer heard
+    const char *mark = (net->flags & NETWORK_FLAG_NEW) ? "+" :
+                       (net->flags & NETWORK_FLAG_STALE) ? "?" : "";
+    const char *ssid = network_store_ssid(net);
+    if (ssid[0]) {
+        snprintf(label, size, "%s%.18s %ddB", mark, ssid, net->rssi);
+    } else {
+        char bssid[MAX_BSSID_LEN];
+        network_format_bssid(net->bssid, bssid, sizeof(bssid));
+        snprintf(label, size, "%s[%.17s]", mark, bssid);
+    }
+}
+
+static void network_name(int index, char *name, size_t len, void *user_data)
+{
+    network_list_data_t *data = (network_list_data_t *)user_data;
+    const network_record_t *net = network_store_record(data->order[index]);
+    const char *ssid = network_store_ssid(net);
+    if (ssid[0]) {
+        snprintf(name, len, "%s", ssid);
+    } else {
+        network_format_bssid(net->bssid, name, len);
+    }
+}
+
 // Helper to draw a single network row
 static void draw_network_row(network_list_data_t *data, int net_idx)
 {
@@ -83,20 +204,14 @@ static void draw_network_row(network_list_data_t *data, int net_idx)
     if (row_on_screen < 0 || row_on_screen >= VISIBLE_ITEMS) return;
     
     int start_row = 1;
-    wifi_network_t *net = &data->networks[net_idx];
+    const network_record_t *net = network_store_record(data->order[net_idx]);
     
     char label[32];
-    if (net->ssid[0]) {
-        char ssid_short[20];
-        strncpy(ssid_short, net->ssid, sizeof(ssid_short) - 1);
-        ssid_short[sizeof(ssid_short) - 1] = '\0';
-        snprintf(label, sizeof(label), "%.18s %ddB", ssid_short, net->rssi);
-    } else {
-        snprintf(label, sizeof(label), "[%.17s]", net->bssid);
-    }
+    format_row_label(net, label, sizeof(label));
     
     bool is_selected = (!data->focus_on_next) && (net_idx == data->selected_index);
-    ui_draw_menu_item(start_row + row_on_screen, label, is_selected, true, net->selected);
+    ui_draw_menu_item(start_row + row_on_screen, label, is_selected, true,
+                      network_store_is_selected(data->order[net_idx]));
 }
 
 // Optimized: redraw only two changed rows (for navigation without scroll)
@@ -106,15 +221,56 @@ static void redraw_two_rows(network_list_data_t *data, int old_idx, int new_idx)
     draw_network_row(data, new_idx);
 }
 
+// Title text: live row count while the scan is still streaming
+static void format_title(network_list_data_t *data, char *title, size_t size)
+{
+    int sel = count_selected(data);
+    if (data->sort == NETWORK_SORT_ARRIVAL && data->filter_mode == FILTER_ALL) {
+        if (data->live) {
+            snprintf(title, size, "Live%us %d%s (%d sel)", live_intervals_s[data->live],
+                     data->count, data->scan_done ? "" : "*", sel);
+        } else if (data->scan_done) {
+            snprintf(title, size, "Networks (%d sel)", sel);
+        } else {
+            snprintf(title, size, "Scanning %d (%d sel)", data->count, sel);
+        }
+        return;
+    }
+    
+    // Shown/total plus the active sort and filter
+    static const char *filter_labels[FILTER_MODE_COUNT] = { "", "2.4G", "5G", "Open", "" };
+    char filt[12];
+    if (data->filter_mode == FILTER_NAME) {
+        snprintf(filt, sizeof(filt), "\"%.6s\"", data->filter.name);
+    } else {
+        snprintf(filt, sizeof(filt), "%s", filter_labels[data->filter_mode]);
+    }
+    snprintf(title, size, "%s %d/%d %s%s%s (%d)",
+             data->live ? "Live" : (data->scan_done ? "Nets" : "Scan"), data->count, data->scanned,
+             sort_labels[data->sort], (data->sort && filt[0]) ? " " : "", filt, sel);
+}
+
 // Update title only (for selection count change)
 static void redraw_title(network_list_data_t *data)
 {
     char title[32];
-    int sel = count_selected(data);
-    snprintf(title, sizeof(title), "Networks (%d sel)", sel);
+    format_title(data, title, sizeof(title));
     ui_draw_title(title);
 }
 
+static void draw_scroll_indicators(network_list_data_t *data)
+{
+    display_fill_rect(DISPLAY_WIDTH - 16, 1 * 16, 16, 16, UI_COLOR_BG);
+    display_fill_rect(DISPLAY_WIDTH - 16, VISIBLE_ITEMS * 16, 16, 16, UI_COLOR_BG);
+    
+    if (data->scroll_offset > 0) {
+        ui_print(UI_COLS - 2, 1, "^", UI_COLOR_DIMMED);
+    }
+    if (data->scroll_offset + VISIBLE_ITEMS < data->count) {
+        ui_print(UI_COLS - 2, VISIBLE_ITEMS, "v", UI_COLOR_DIMMED);
+    }
+}
+
 // Full list redraw (when scrolling)
 static void redraw_list(network_list_data_t *data)
 {
@@ -133,15 +289,7 @@ static void redraw_list(network_list_data_t *data)
     }
     
     // Redraw scroll indicators
-    display_fill_rect(DISPLAY_WIDTH - 16, 1 * 16, 16, 16, UI_COLOR_BG);
-    display_fill_rect(DISPLAY_WIDTH - 16, VISIBLE_ITEMS * 16, 16, 16, UI_COLOR_BG);
-    
-    if (data->scroll_offset > 0) {
-        ui_print(UI_COLS - 2, 1, "^", UI_COLOR_DIMMED);
-    }
-    if (data->scroll_offset + VISIBLE_ITEMS < data->count) {
-        ui_print(UI_COLS - 2, VISIBLE_ITEMS, "v", UI_COLOR_DIMMED);
-    }
+    draw_scroll_indicators(data);
 }
 
 static void draw_screen(screen_t *self)
@@ -152,8 +300,7 @@ static void draw_screen(screen_t *self)
     
     // Draw title with selected count
     char title[32];
-    int sel = count_selected(data);
-    snprintf(title, sizeof(title), "Networks (%d sel)", sel);
+    format_title(data, title, sizeof(title));
     ui_draw_title(title);
     
     // Draw visible network items
@@ -162,21 +309,14 @@ static void draw_screen(screen_t *self)
         int net_idx = data->scroll_offset + i;
         
         if (net_idx < data->count) {
-            wifi_network_t *net = &data->networks[net_idx];
+            const network_record_t *net = network_store_record(data->order[net_idx]);
             
-            // Build label - truncate SSID if needed
             char label[32];
-            if (net->ssid[0]) {
-                char ssid_short[20];
-                strncpy(ssid_short, net->ssid, sizeof(ssid_short) - 1);
-                ssid_short[sizeof(ssid_short) - 1] = '\0';
-                snprintf(label, sizeof(label), "%.18s %ddB", ssid_short, net->rssi);
-            } else {
-                snprintf(label, sizeof(label), "[%.17s]", net->bssid);
-            }
+            format_row_label(net, label, sizeof(label));
             
             bool is_selected = (!data->focus_on_next) && (net_idx == data->selected_index);
-            ui_draw_menu_item(start_row + i, label, is_selected, true, net->selected);
+            ui_draw_menu_item(start_row + i, label, is_selected, true,
+                              network_store_is_selected(data->order[net_idx]));
         }
     }
     
@@ -213,13 +353,79 @@ static void draw_screen(screen_t *self)
     }
     
     // Draw status bar
-    ui_draw_status("ENTER:Sel N:Nxt I:Info Esc:Bck");
+    ui_typeahead_draw_status(&data->find, "S:Sort F:Filt L:Live D:Diff");
+}
+
+/**
+ * @brief Translate the filter mode into the store filter and rebuild the view
+ */
+static void apply_filter_mode(network_list_data_t *data)
+{
+    data->filter.band = WIFI_BAND_UNKNOWN;
+    data->filter.open_only = false;
+    if (data->filter_mode != FILTER_NAME) {
+        data->filter.name[0] = '\0';
+    }
+    
+    switch (data->filter_mode) {
+        case FILTER_2G:   data->filter.band = WIFI_BAND_2G; break;
+        case FILTER_5G:   data->filter.band = WIFI_BAND_5G; break;
+        case FILTER_OPEN: data->filter.open_only = true; break;
+        default: break;
+    }
+    view_rebuild(data);
+}
+
+static void on_name_submitted(const char *text, void *user_data)
+{
+    network_list_data_t *data = (network_list_data_t *)user_data;
+    
+    snprintf(data->filter.name, sizeof(data->filter.name), "%s", text);
+    data->filter_mode = FILTER_NAME;
+    apply_filter_mode(data);
+    
+    // on_resume redraws the list
+    screen_manager_pop();
+}
+
+/**
+ * @brief Feed a key to the find prompt
+ * @return true if the prompt took it
+ */
+static bool find_key(screen_t *self, network_list_data_t *data, key_code_t key)
+{
+    int row;
+    switch (ui_typeahead_handle_key(&data->find, key, data->count, &row)) {
+        case UI_TYPEAHEAD_IGNORED:
+            return false;
+        case UI_TYPEAHEAD_JUMP:
+            break;
+        default:
+            return true;
+    }
+    
+    // Same paging as UP/DOWN: the page holding the row
+    int old_idx = data->selected_index;
+    int old_scroll = data->scroll_offset;
+    data->selected_index = row;
+    data->scroll_offset = row - row % VISIBLE_ITEMS;
+    if (data->focus_on_next) {
+        data->focus_on_next = false;
+        draw_screen(self);
+    } else if (data->scroll_offset != old_scroll) {
+        redraw_list(data);
+    } else {
+        redraw_two_rows(data, old_idx, row);
+    }
+    return true;
 }
 
 static void on_key(screen_t *self, key_code_t key)
 {
     network_list_data_t *data = (network_list_data_t *)self->user_data;
     
+    if (find_key(self, data, key)) return;
+    
     switch (key) {
         case KEY_UP:
             if (data->focus_on_next) {
@@ -289,13 +495,79 @@ static void on_key(screen_t *self, key_code_t key)
         case KEY_SPACE:
             if (!data->focus_on_next && data->selected_index < data->count) {
                 // Toggle selection
-                data->networks[data->selected_index].selected = 
-                    !data->networks[data->selected_index].selected;
+                int rec = data->order[data->selected_index];
+                network_store_set_selected(rec, !network_store_is_selected(rec));
                 redraw_title(data);  // Update selection count
                 draw_network_row(data, data->selected_index);  // Just this row
             }
             break;
             
+        case KEY_A:
+            // Select every row the filter shows
+            network_store_select_matching(&data->filter, true);
+            redraw_list(data);
+            break;
+            
+        case KEY_U:
+            // Clear the whole selection, shown or not
+            network_store_select_all(false);
+            redraw_list(data);
+            break;
+            
+        case KEY_X:
+            network_store_select_invert();
+            redraw_list(data);
+            break;
+            
+        case KEY_S:
+            // Cycle sort key
+            data->sort = (data->sort + 1) % NETWORK_SORT_COUNT;
+            view_rebuild(data);
+            draw_screen(self);
+            break;
+            
+        case KEY_F:
+            // Cycle filter: all, 2.4GHz, 5GHz, open, name search
+            if (data->filter_mode == FILTER_OPEN) {
+                // Back to all rows; the name filter takes effect once the
+                // text is submitted, so cancelling the input leaves it off
+                data->filter_mode = FILTER_ALL;
+                apply_filter_mode(data);
+                text_input_params_t *params = malloc(sizeof(text_input_params_t));
+                if (params) {
+                    params->title = "Filter by Name";
+                    params->hint = "Part of the SSID";
+                    params->on_submit = on_name_submitted;
+                    params->user_data = data;
+                    params->history = "ssid_filter";
+                    params->complete_ssids = true;
+                    if (screen_manager_push(text_input_screen_create, params) == ESP_ERR_NO_MEM) free(params);
+                } else {
+                    draw_screen(self);
+                }
+                break;
+            }
+            data->filter_mode = (data->filter_mode == FILTER_NAME) ? FILTER_ALL : data->filter_mode + 1;
+            apply_filter_mode(data);
+            draw_screen(self);
+            break;
+            
+        case KEY_L:
+            // Cycle live mode: off, then rescan every 10/30/60 s
+            data->live = (data->live + 1) % LIVE_INTERVAL_COUNT;
+            redraw_title(data);
+            break;
+            
+        case KEY_D: {
+            // Changes between the last two passes; keeps live mode's rescans going
+            scan_diff_params_t *params = malloc(sizeof(scan_diff_params_t));
+            if (params) {
+                params->interval_s = live_intervals_s[data->live];
+                if (screen_manager_push(scan_diff_screen_create, params) == ESP_ERR_NO_MEM) free(params);
+            }
+            break;
+        }
+            
         case KEY_N:
             // Quick shortcut to Next button (press N)
             data->focus_on_next = true;
@@ -305,10 +577,13 @@ static void on_key(screen_t *self, key_code_t key)
         case KEY_I:
             // Show network info for currently selected network
             if (!data->focus_on_next && data->selected_index < data->count) {
+                // Info screen copies the record during create
+                wifi_network_t net;
                 network_info_params_t *params = malloc(sizeof(network_info_params_t));
                 if (params) {
-                    params->network = &data->networks[data->selected_index];
-                    screen_manager_push(network_info_screen_create, params);
+                    network_store_get(data->order[data->selected_index], &net);
+                    params->network = &net;
+                    if (screen_manager_push(network_info_screen_create, params) == ESP_ERR_NO_MEM) free(params);
                 }
             }
             break;
@@ -325,8 +600,8 @@ static void on_key(screen_t *self, key_code_t key)
             } else {
                 // Toggle selection on enter too
                 if (data->selected_index < data->count) {
-                    data->networks[data->selected_index].selected = 
-                        !data->networks[data->selected_index].selected;
+                    int rec = data->order[data->selected_index];
+                    network_store_set_selected(rec, !network_store_is_selected(rec));
                     redraw_title(data);  // Update selection count
                     draw_network_row(data, data->selected_index);  // Just this row
                 }
@@ -343,6 +618,56 @@ static void on_key(screen_t *self, key_code_t key)
     }
 }
 
+/**
+ * @brief Pick up rows streamed in since the last tick
+ */
+static void on_tick(screen_t *self)
+{
+    network_list_data_t *data = (network_list_data_t *)self->user_data;
+    
+    // Live mode: rescans merge by BSSID, so rows keep their index and selection
+    if (data->live) uart_rescan_if_due(live_intervals_s[data->live] * 1000);
+    
+    bool done = !uart_is_scanning();
+    int received = network_store_count();
+    
+    // A rescan finished: RSSI, NEW and STALE changed on rows already shown
+    uint32_t passes = network_store_passes();
+    if (done && passes != data->passes) {
+        data->passes = passes;
+        data->scanned = received;
+        data->scan_done = true;
+        view_rebuild(data);
+        draw_screen(self);
+        return;
+    }
+    if (received == data->scanned && done == data->scan_done) return;
+    
+    int old_count = data->count;
+    int old_scroll = data->scroll_offset;
+    int first_changed = view_add_new(data, received);
+    data->scan_done = done;
+    
+    redraw_title(data);
+    
+    if (first_changed < 0) return;
+    if (data->scroll_offset != old_scroll || first_changed < old_count) {
+        // Sorted insert shifted rows on screen
+        if (!data->focus_on_next) {
+            redraw_list(data);
+        } else {
+            draw_scroll_indicators(data);
+        }
+        return;
+    }
+    
+    // Appended rows: only those landing in the visible window need painting
+    for (int i = old_count; i < data->count; i++) {
+        draw_network_row(data, i);
+    }
+    draw_scroll_indicators(data);
+}
+
 static void on_resume(screen_t *self)
 {
     // Redraw screen when returning from info view
@@ -354,23 +679,17 @@ static void on_destroy(screen_t *self)
     network_list_data_t *data = (network_list_data_t *)self->user_data;
     
     if (data) {
-        if (data->networks) {
-            free(data->networks);
-        }
+        ui_typeahead_free(&data->find);
+        free(data->order);
         free(data);
     }
 }
 
 screen_t* network_list_screen_create(void *params)
 {
-    network_list_params_t *list_params = (network_list_params_t *)params;
+    (void)params;
     
-    if (!list_params || !list_params->networks || list_params->count == 0) {
-        ESP_LOGE(TAG, "Invalid parameters");
-        return NULL;
-    }
-    
-    ESP_LOGI(TAG, "Creating network list screen with %d networks...", list_params->count);
+    ESP_LOGI(TAG, "Creating network list screen with %d networks...", network_store_count());
     
     screen_t *screen = screen_alloc();
     if (!screen) return NULL;
@@ -382,16 +701,26 @@ screen_t* network_list_screen_create(void *params)
         return NULL;
     }
     
-    // Take ownership of networks
-    data->networks = list_params->networks;
-    data->count = list_params->count;
-    free(list_params);  // Free params struct (we took ownership of networks)
+    data->order = malloc(NETWORK_STORE_MAX * sizeof(data->order[0]));
+    if (!data->order) {
+        free(data);
+        free(screen);
+        return NULL;
+    }
+    
+    // Rows keep arriving in the store until the scan finishes
+    data->scan_done = !uart_is_scanning();
+    data->passes = network_store_passes();
+    data->filter.hide_stale = true;
+    ui_typeahead_init(&data->find, NETWORK_STORE_MAX, network_name, data);
+    view_add_new(data, network_store_count());
     
     screen->user_data = data;
     screen->on_key = on_key;
     screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
     screen->on_resume = on_resume;
+    screen->on_tick = on_tick;
     
     // Draw initial screen
     draw_screen(screen);
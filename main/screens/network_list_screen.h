@@ -9,15 +9,10 @@
 #include "screen_manager.h"
 #include "uart_handler.h"
 
-// Parameters for creating the network list screen
-typedef struct {
-    wifi_network_t *networks;  // Array of networks (ownership transferred)
-    int count;                 // Number of networks
-} network_list_params_t;
-
 /**
  * @brief Create the network list screen
- * @param params Pointer to network_list_params_t
+ * Rows come from the network store and keep arriving while a scan runs.
+ * @param params Unused (NULL)
  * @return Created screen or NULL on failure
  */
 screen_t* network_list_screen_create(void *params);
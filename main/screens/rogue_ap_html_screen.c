@@ -2,31 +2,32 @@
  * @file rogue_ap_html_screen.c
  * @brief Rogue AP HTML selection screen
  * 
- * Sends list_sd, shows HTML files, then starts Rogue AP attack.
+ * Shows the HTML files from the shared SD listing, then starts Rogue AP attack.
+ * P previews the text of the template under the cursor.
  */
 
 #include "rogue_ap_html_screen.h"
 #include "rogue_ap_screen.h"
 #include "uart_handler.h"
+#include "sd_listing.h"
+#include "html_preview.h"
+#include "cred_store.h"
 #include "text_ui.h"
 #include "buzzer.h"
 #include "esp_log.h"
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
 
 static const char *TAG = "ROGUE_HTML";
 
-#define MAX_HTML_FILES  24
 #define VISIBLE_ITEMS   6
-#define MAX_FILENAME_LEN 32
 
 typedef struct {
     char ssid[33];
     char password[65];
-    char html_files[MAX_HTML_FILES][MAX_FILENAME_LEN];
-    int file_ids[MAX_HTML_FILES];
+    sd_file_t files[SD_LISTING_MAX_FILES];
     int file_count;
+    uint32_t listing_generation;
     int selected_index;
     int scroll_offset;
     bool loading;
@@ -38,61 +39,28 @@ typedef struct {
 static void draw_screen(screen_t *self);
 
 /**
- * @brief UART line callback for parsing list_sd output
+ * @brief Take the HTML files from the shared SD listing
  */
-static void uart_line_callback(const char *line, void *user_data)
+static void load_files(rogue_ap_html_data_t *data)
 {
-    rogue_ap_html_data_t *data = (rogue_ap_html_data_t *)user_data;
-    if (!data || data->file_count >= MAX_HTML_FILES) return;
-    
-    // Skip header line
-    if (strstr(line, "HTML files found") != NULL) {
-        return;
-    }
-    
-    // Parse lines like "1 PLAY.html"
-    const char *ptr = line;
-    
-    while (*ptr && isspace((unsigned char)*ptr)) ptr++;
-    
-    if (!isdigit((unsigned char)*ptr)) return;
-    
-    int file_id = 0;
-    while (*ptr && isdigit((unsigned char)*ptr)) {
-        file_id = file_id * 10 + (*ptr - '0');
-        ptr++;
-    }
-    
-    while (*ptr && isspace((unsigned char)*ptr)) ptr++;
-    
-    if (strlen(ptr) < 6) return;
-    if (strstr(ptr, ".html") == NULL) return;
-    
-    strncpy(data->html_files[data->file_count], ptr, MAX_FILENAME_LEN - 1);
-    data->html_files[data->file_count][MAX_FILENAME_LEN - 1] = '\0';
-    
-    // Remove trailing whitespace
-    char *end = data->html_files[data->file_count] + strlen(data->html_files[data->file_count]) - 1;
-    while (end > data->html_files[data->file_count] && isspace((unsigned char)*end)) {
-        *end = '\0';
-        end--;
-    }
-    
-    data->file_ids[data->file_count] = file_id;
-    data->file_count++;
-    
-    ESP_LOGI(TAG, "Found HTML file [%d]: %s", file_id, data->html_files[data->file_count - 1]);
-    
-    if (data->loading && data->file_count > 0) {
-        data->loading = false;
-        data->needs_redraw = true;
+    data->listing_generation = sd_listing_generation();
+    data->file_count = sd_listing_copy(SD_LISTING_HTML, data->files, SD_LISTING_MAX_FILES);
+    data->loading = data->file_count == 0 && sd_listing_state() == SD_LISTING_LOADING;
+    if (data->selected_index >= data->file_count) {
+        data->selected_index = 0;
+        data->scroll_offset = 0;
     }
 }
 
 static void on_tick(screen_t *self)
 {
     rogue_ap_html_data_t *data = (rogue_ap_html_data_t *)self->user_data;
-    if (data && data->needs_redraw) {
+    if (sd_listing_generation() != data->listing_generation) {
+        load_files(data);
+        data->needs_redraw = true;
+    }
+    
+    if (data->needs_redraw) {
         data->needs_redraw = false;
         draw_screen(self);
     }
@@ -107,7 +75,7 @@ static void draw_file_row(rogue_ap_html_data_t *data, int file_idx)
     int start_row = 1;
     
     char label[28];
-    strncpy(label, data->html_files[file_idx], sizeof(label) - 1);
+    strncpy(label, data->files[file_idx].name, sizeof(label) - 1);
     label[sizeof(label) - 1] = '\0';
     char *ext = strstr(label, ".html");
     if (ext) *ext = '\0';
@@ -146,7 +114,7 @@ static void draw_screen(screen_t *self)
             bool is_selected = (i == data->selected_index);
             
             char display_name[28];
-            strncpy(display_name, data->html_files[i], sizeof(display_name) - 1);
+            strncpy(display_name, data->files[i].name, sizeof(display_name) - 1);
             display_name[sizeof(display_name) - 1] = '\0';
             
             // Remove .html extension for display
@@ -168,7 +136,7 @@ static void draw_screen(screen_t *self)
     if (data->loading) {
         ui_draw_status("Loading HTML files...");
     } else {
-        ui_draw_status("ENTER:Select ESC:Back");
+        ui_draw_status("ENTER:Select P:View ESC:Back");
     }
 }
 
@@ -178,27 +146,27 @@ static void launch_rogue_ap(rogue_ap_html_data_t *data)
         return;
     }
 
-    // Ensure the selected network is set before starting
+    // Selected network (if any), HTML and start_rogueap in one write
+    const char *sequence[3];
+    int count = 0;
+    char select_cmd[32];
     if (data->network_id > 0) {
-        char select_cmd[32];
         snprintf(select_cmd, sizeof(select_cmd), "select_networks %d", data->network_id);
-        uart_send_command(select_cmd);
+        sequence[count++] = select_cmd;
     }
-    
-    // Send select_html command
     char cmd[32];
-    snprintf(cmd, sizeof(cmd), "select_html %d", data->file_ids[data->selected_index]);
-    uart_send_command(cmd);
-    
-    ESP_LOGI(TAG, "Selected HTML: %s (ID: %d)", 
-             data->html_files[data->selected_index], 
-             data->file_ids[data->selected_index]);
-    
-    // Send start_rogueap command
+    snprintf(cmd, sizeof(cmd), "select_html %d", data->files[data->selected_index].id);
+    sequence[count++] = cmd;
     char rogueap_cmd[128];
     snprintf(rogueap_cmd, sizeof(rogueap_cmd), "start_rogueap %s %s", 
              data->ssid, data->password);
-    uart_send_command(rogueap_cmd);
+    sequence[count++] = rogueap_cmd;
+    uart_send_batch(sequence, count, NULL, NULL);
+    
+    ESP_LOGI(TAG, "Selected HTML: %s (ID: %d)", 
+             data->files[data->selected_index].name, 
+             data->files[data->selected_index].id);
+    cred_store_set_portal_ssid(data->ssid);
     buzzer_beep_attack();
     
     // Create Rogue AP running screen
@@ -206,7 +174,7 @@ static void launch_rogue_ap(rogue_ap_html_data_t *data)
     if (params) {
         strncpy(params->ssid, data->ssid, sizeof(params->ssid) - 1);
         params->ssid[sizeof(params->ssid) - 1] = '\0';
-        screen_manager_push(rogue_ap_screen_create, params);
+        if (screen_manager_push(rogue_ap_screen_create, params) == ESP_ERR_NO_MEM) free(params);
     }
 }
 
@@ -262,6 +230,12 @@ static void on_key(screen_t *self, key_code_t key)
             launch_rogue_ap(data);
             break;
             
+        case KEY_P:
+            if (!data->loading && data->selected_index < data->file_count) {
+                html_preview_show(&data->files[data->selected_index]);
+            }
+            break;
+            
         case KEY_ESC:
         case KEY_Q:
             screen_manager_pop();
@@ -274,8 +248,6 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
-    uart_clear_line_callback();
-    
     if (self->user_data) {
         free(self->user_data);
     }
@@ -318,9 +290,9 @@ screen_t* rogue_ap_html_screen_create(void *params)
     screen->on_draw = draw_screen;
     screen->on_tick = on_tick;
     
-    // Register UART callback and send list_sd
-    uart_register_line_callback(uart_line_callback, data);
-    uart_send_command("list_sd");
+    // Cached listing shows at once; list_sd runs only the first time
+    sd_listing_refresh(false);
+    load_files(data);
     
     // Request initial screen draw via on_tick (avoids double draw)
     data->needs_redraw = true;
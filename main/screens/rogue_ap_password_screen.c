@@ -7,17 +7,24 @@
  */
 
 #include "rogue_ap_password_screen.h"
+#include "mem_monitor.h"
 #include "rogue_ap_html_screen.h"
 #include "text_input_screen.h"
+#include "sdkconfig.h"
 #include "uart_handler.h"
 #include "text_ui.h"
+#include "csv_parser.h"
 #include "esp_log.h"
 #include <string.h>
 #include <stdlib.h>
 
 static const char *TAG = "ROGUE_PASS";
 
+#ifdef CONFIG_ROGUE_AP_SAVED_PASSWORDS
+#define MAX_ENTRIES CONFIG_ROGUE_AP_SAVED_PASSWORDS
+#else
 #define MAX_ENTRIES 32
+#endif
 
 typedef struct {
     char ssid[33];
@@ -43,6 +50,8 @@ typedef struct {
     screen_t *self;
 } rogue_ap_password_data_t;
 
+MEM_BUDGET(rogue_ap_passwords, 1, sizeof(rogue_ap_password_data_t), MEM_BUDGET_SCREEN);
+
 static void draw_screen(screen_t *self);
 
 /**
@@ -67,30 +76,6 @@ static bool is_skip_line(const char *line)
     return false;
 }
 
-/**
- * @brief Parse a quoted field from CSV
- */
-static bool parse_quoted_field(const char **src, char *dest, size_t max_len)
-{
-    const char *p = *src;
-    
-    while (*p == ' ' || *p == ',' || *p == '\t') p++;
-    
-    if (*p != '"') return false;
-    p++;
-    
-    size_t i = 0;
-    while (*p && *p != '"' && i < max_len - 1) {
-        dest[i++] = *p++;
-    }
-    dest[i] = '\0';
-    
-    if (*p == '"') p++;
-    
-    *src = p;
-    return true;
-}
-
 /**
  * @brief UART callback for show_pass evil output
  */
@@ -113,11 +98,15 @@ static void uart_line_callback(const char *line, void *user_data)
     }
     
     // Parse: "SSID", "password"
-    const char *p = line;
+    csv_tokenizer_t tok;
+    csv_tokenizer_init(&tok, line);
     password_entry_t *entry = &data->entries[data->entry_count];
     
-    if (!parse_quoted_field(&p, entry->ssid, sizeof(entry->ssid))) return;
-    if (!parse_quoted_field(&p, entry->password, sizeof(entry->password))) return;
+    csv_field_t ssid_field, pass_field;
+    if (!csv_next_field(&tok, &ssid_field) || !ssid_field.quoted) return;
+    if (!csv_next_field(&tok, &pass_field) || !pass_field.quoted) return;
+    csv_field_copy(&ssid_field, entry->ssid, sizeof(entry->ssid));
+    csv_field_copy(&pass_field, entry->password, sizeof(entry->password));
     
     ESP_LOGI(TAG, "Parsed: SSID='%s', pass='%s'", entry->ssid, entry->password);
     data->entry_count++;
@@ -143,7 +132,7 @@ static void proceed_to_html(rogue_ap_password_data_t *data)
         
         ESP_LOGI(TAG, "Proceeding to HTML select with SSID=%s, password=%s", 
                  params->ssid, params->password);
-        screen_manager_push(rogue_ap_html_screen_create, params);
+        if (screen_manager_push(rogue_ap_html_screen_create, params) == ESP_ERR_NO_MEM) free(params);
     }
 }
 
@@ -233,7 +222,9 @@ static void on_key(screen_t *self, key_code_t key)
                     params->hint = NULL;
                     params->on_submit = on_password_submitted;
                     params->user_data = data;
-                    screen_manager_push(text_input_screen_create, params);
+                    params->history = "password";
+                    params->complete_ssids = false;
+                    if (screen_manager_push(text_input_screen_create, params) == ESP_ERR_NO_MEM) free(params);
                 }
             }
             break;
@@ -250,8 +241,6 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
-    uart_clear_line_callback();
-    
     if (self->user_data) {
         free(self->user_data);
     }
@@ -308,7 +297,7 @@ screen_t* rogue_ap_password_screen_create(void *params)
     screen->on_tick = on_tick;
     
     // Register UART callback and send command
-    uart_register_line_callback(uart_line_callback, data);
+    screen_set_line_callback(screen, uart_line_callback, data);
     uart_send_command("show_pass evil");
     
     draw_screen(screen);
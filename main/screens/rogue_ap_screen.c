@@ -7,6 +7,7 @@
 
 #include "rogue_ap_screen.h"
 #include "uart_handler.h"
+#include "text_log.h"
 #include "text_ui.h"
 #include "buzzer.h"
 #include "esp_log.h"
@@ -17,34 +18,49 @@ static const char *TAG = "ROGUE_AP";
 
 #define MAX_LOG_LINES 5
 #define MAX_LINE_LEN 32
+#define LOG_FIRST_ROW 3
 
 typedef struct {
     char ssid[33];
     int client_count;
-    char log_lines[MAX_LOG_LINES][MAX_LINE_LEN];
-    int log_count;
+    text_log_t log;             // Newest MAX_LOG_LINES events
+    int log_scrolled;           // Lines shifted out since the last draw
+    int log_drawn;              // Lines on screen after the last draw
     bool needs_redraw;
+    bool layout_drawn;
+    uint32_t layout_generation;
     screen_t *self;
 } rogue_ap_data_t;
 
 static void draw_screen(screen_t *self);
 
 /**
- * @brief Add a log line to the display buffer
+ * @brief Log lines on screen (at most MAX_LOG_LINES)
+ */
+static int log_count(rogue_ap_data_t *data)
+{
+    uint32_t held = text_log_end(&data->log) - text_log_first(&data->log);
+    return held < MAX_LOG_LINES ? (int)held : MAX_LOG_LINES;
+}
+
+/**
+ * @brief Add a log line; the ring drops the oldest, nothing is shifted
  */
 static void add_log_line(rogue_ap_data_t *data, const char *line)
 {
-    // Shift existing lines up
-    if (data->log_count >= MAX_LOG_LINES) {
-        for (int i = 0; i < MAX_LOG_LINES - 1; i++) {
-            strncpy(data->log_lines[i], data->log_lines[i + 1], MAX_LINE_LEN - 1);
-        }
-        data->log_count = MAX_LOG_LINES - 1;
+    if (log_count(data) >= MAX_LOG_LINES) {
+        data->log_scrolled++;
     }
-    
-    strncpy(data->log_lines[data->log_count], line, MAX_LINE_LEN - 1);
-    data->log_lines[data->log_count][MAX_LINE_LEN - 1] = '\0';
-    data->log_count++;
+    text_log_append(&data->log, NULL, line);
+}
+
+/**
+ * @brief Text of log row index (0 = oldest shown)
+ */
+static void get_log_line(rogue_ap_data_t *data, int index, char *out)
+{
+    uint32_t first = text_log_end(&data->log) - log_count(data);
+    text_log_get(&data->log, first + index, out, MAX_LINE_LEN);
 }
 
 /**
@@ -116,10 +132,56 @@ static void uart_line_callback(const char *line, void *user_data)
     }
 }
 
+/**
+ * @brief Repaint one log row (cleared first, it may hold scrolled content)
+ */
+static void draw_log_row(rogue_ap_data_t *data, int index)
+{
+    int row = LOG_FIRST_ROW + index;
+    display_fill_rect(0, row * 16, DISPLAY_WIDTH, 16, UI_COLOR_BG);
+    if (index < log_count(data)) {
+        char line[MAX_LINE_LEN];
+        get_log_line(data, index, line);
+        ui_print(1, row, line, UI_COLOR_DIMMED);
+    }
+}
+
+static void draw_client_count(rogue_ap_data_t *data)
+{
+    char count_line[24];
+    snprintf(count_line, sizeof(count_line), "Clients: %d", data->client_count);
+    display_fill_rect(0, 2 * 16, DISPLAY_WIDTH, 16, UI_COLOR_BG);
+    ui_print(1, 2, count_line, UI_COLOR_TEXT);
+}
+
 static void draw_screen(screen_t *self)
 {
     rogue_ap_data_t *data = (rogue_ap_data_t *)self->user_data;
     
+    int scrolled = data->log_scrolled;
+    data->log_scrolled = 0;
+    
+    if (data->layout_drawn && data->layout_generation == ui_get_clear_generation() &&
+        scrolled < MAX_LOG_LINES) {
+        // Incremental update: scroll the log up and paint only the new lines.
+        // The last row sits partly under the status bar, so the line that was
+        // there is repainted as well.
+        draw_client_count(data);
+        int first_new = data->log_drawn - scrolled;
+        if (scrolled > 0) {
+            ui_scroll_rows(LOG_FIRST_ROW, MAX_LOG_LINES, -scrolled);
+            first_new--;
+        }
+        if (first_new < 0) first_new = 0;
+        int count = log_count(data);
+        for (int i = first_new; i < count; i++) {
+            draw_log_row(data, i);
+        }
+        data->log_drawn = count;
+        ui_draw_status("ESC:Stop & Back");
+        return;
+    }
+    
     ui_clear();
     ui_draw_title("Rogue AP Running");
     
@@ -129,16 +191,21 @@ static void draw_screen(screen_t *self)
     ui_print(1, 1, ssid_line, UI_COLOR_TEXT);
     
     // Show client count
-    char count_line[24];
-    snprintf(count_line, sizeof(count_line), "Clients: %d", data->client_count);
-    ui_print(1, 2, count_line, UI_COLOR_TEXT);
+    draw_client_count(data);
     
     // Show log lines
-    for (int i = 0; i < data->log_count && i < MAX_LOG_LINES; i++) {
-        ui_print(1, 3 + i, data->log_lines[i], UI_COLOR_DIMMED);
+    int count = log_count(data);
+    for (int i = 0; i < count; i++) {
+        char line[MAX_LINE_LEN];
+        get_log_line(data, i, line);
+        ui_print(1, LOG_FIRST_ROW + i, line, UI_COLOR_DIMMED);
     }
     
     ui_draw_status("ESC:Stop & Back");
+    
+    data->log_drawn = count;
+    data->layout_drawn = true;
+    data->layout_generation = ui_get_clear_generation();
 }
 
 static void on_tick(screen_t *self)
@@ -176,10 +243,10 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
-    uart_clear_line_callback();
-    
-    if (self->user_data) {
-        free(self->user_data);
+    rogue_ap_data_t *data = (rogue_ap_data_t *)self->user_data;
+    if (data) {
+        text_log_free(&data->log);
+        free(data);
     }
 }
 
@@ -201,7 +268,9 @@ screen_t* rogue_ap_screen_create(void *params)
     }
     
     rogue_ap_data_t *data = calloc(1, sizeof(rogue_ap_data_t));
-    if (!data) {
+    if (!data || text_log_init(&data->log, MAX_LOG_LINES * MAX_LINE_LEN,
+                               MAX_LOG_LINES, false) != ESP_OK) {
+        free(data);
         free(screen);
         free(ap_params);
         return NULL;
@@ -218,7 +287,7 @@ screen_t* rogue_ap_screen_create(void *params)
     screen->on_tick = on_tick;
     
     // Register UART callback
-    uart_register_line_callback(uart_line_callback, data);
+    screen_set_line_callback(screen, uart_line_callback, data);
     
     draw_screen(screen);
     
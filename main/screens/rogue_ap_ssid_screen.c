@@ -87,7 +87,7 @@ static void on_select(rogue_ap_ssid_data_t *data)
         params->network_id = chosen->id;
         
         ESP_LOGI(TAG, "Selected SSID: %s", params->ssid);
-        screen_manager_push(rogue_ap_password_screen_create, params);
+        if (screen_manager_push(rogue_ap_password_screen_create, params) == ESP_ERR_NO_MEM) free(params);
     }
 }
 
@@ -0,0 +1,203 @@
+/**
+ * @file scan_diff_screen.c
+ * @brief What changed between the last two WiFi scans
+ *
+ * Shows network_store_diff(): networks the last pass found new, found
+ * again after missing a pass, or missed after seeing them the pass
+ * before, plus RSSI moves of NETWORK_DIFF_RSSI_DB or more and channel
+ * changes. The store logs these as records change, so the screen only
+ * copies a short list when a pass completes.
+ */
+
+#include "scan_diff_screen.h"
+#include "network_info_screen.h"
+#include "network_store.h"
+#include "uart_handler.h"
+#include "text_ui.h"
+#include "ui_list.h"
+#include "esp_log.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "SCAN_DIFF";
+
+// Screen user data
+typedef struct {
+    ui_list_t list;
+    network_diff_t diff[NETWORK_DIFF_MAX];
+    int dropped;                // Changes the store could not log
+    uint32_t passes;            // network_store_passes() the diff is from
+    uint32_t interval_ms;       // Live rescan interval, 0 = off
+} scan_diff_data_t;
+
+static void diff_row(int index, char *text, size_t len, void *user_data)
+{
+    scan_diff_data_t *data = (scan_diff_data_t *)user_data;
+    const network_diff_t *d = &data->diff[index];
+    const network_record_t *rec = network_store_record(d->index);
+    if (!rec) return;
+    
+    // Gone shows where it was last heard; the rest show what moved
+    char mark = (d->changes & NETWORK_DIFF_NEW) ? '+' :
+                (d->changes & NETWORK_DIFF_GONE) ? '-' :
+                (d->changes & NETWORK_DIFF_BACK) ? '*' : '~';
+    char detail[16];
+    if (d->changes & NETWORK_DIFF_CHANNEL) {
+        snprintf(detail, sizeof(detail), "ch%u>%u", d->old_channel, rec->channel);
+    } else if (d->changes & NETWORK_DIFF_RSSI) {
+        snprintf(detail, sizeof(detail), "%+ddB", rec->rssi - d->old_rssi);
+    } else {
+        snprintf(detail, sizeof(detail), "ch%u %ddB", rec->channel, rec->rssi);
+    }
+    
+    const char *ssid = network_store_ssid(rec);
+    if (ssid[0]) {
+        snprintf(text, len, "%c%.20s %s", mark, ssid, detail);
+    } else {
+        char bssid[MAX_BSSID_LEN];
+        network_format_bssid(rec->bssid, bssid, sizeof(bssid));
+        snprintf(text, len, "%c[%s] %s", mark, bssid, detail);
+    }
+}
+
+static void load_diff(scan_diff_data_t *data)
+{
+    data->passes = network_store_passes();
+    int count = network_store_diff(data->diff, NETWORK_DIFF_MAX, &data->dropped);
+    ui_list_set_count(&data->list, count);
+}
+
+static void draw_title(scan_diff_data_t *data)
+{
+    char title[32];
+    if (data->dropped) {
+        snprintf(title, sizeof(title), "Diff #%lu: %d (+%d)", (unsigned long)data->passes,
+                 data->list.count, data->dropped);
+    } else {
+        snprintf(title, sizeof(title), "Diff #%lu: %d", (unsigned long)data->passes,
+                 data->list.count);
+    }
+    ui_draw_title(title);
+}
+
+static void draw_screen(screen_t *self)
+{
+    scan_diff_data_t *data = (scan_diff_data_t *)self->user_data;
+    
+    ui_clear();
+    draw_title(data);
+    
+    if (data->list.count == 0) {
+        // The first pass has nothing to compare with
+        const char *text = uart_is_scanning() ? "Scanning..." :
+                           data->passes < 2 ? "Rescan to compare" : "No changes";
+        ui_print_center(ui_rows() / 2 - 1, text, UI_COLOR_DIMMED);
+    } else {
+        ui_list_draw(&data->list);
+    }
+    
+    ui_draw_status("ENT:Info R:Rescan ESC:Back");
+}
+
+static void on_tick(screen_t *self)
+{
+    scan_diff_data_t *data = (scan_diff_data_t *)self->user_data;
+    
+    if (data->interval_ms) uart_rescan_if_due(data->interval_ms);
+    
+    // A new diff replaces the old one when its pass completes
+    if (network_store_passes() == data->passes) return;
+    load_diff(data);
+    draw_screen(self);
+}
+
+static void show_info(scan_diff_data_t *data)
+{
+    if (data->list.count == 0) return;
+    
+    // Info screen copies the record during create
+    wifi_network_t net;
+    if (!network_store_get(data->diff[data->list.selected].index, &net)) return;
+    network_info_params_t *params = malloc(sizeof(network_info_params_t));
+    if (params) {
+        params->network = &net;
+        if (screen_manager_push(network_info_screen_create, params) == ESP_ERR_NO_MEM) free(params);
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    scan_diff_data_t *data = (scan_diff_data_t *)self->user_data;
+    
+    if (ui_list_handle_key(&data->list, key)) {
+        ui_list_draw(&data->list);
+        return;
+    }
+    
+    switch (key) {
+        case KEY_ENTER:
+        case KEY_I:
+            show_info(data);
+            break;
+            
+        case KEY_R:
+            if (!uart_is_scanning() && uart_refresh_wifi_scan(NULL, NULL, NULL) == ESP_OK) {
+                draw_screen(self);
+            }
+            break;
+            
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    free(self->user_data);
+}
+
+static void on_resume(screen_t *self)
+{
+    draw_screen(self);
+}
+
+screen_t* scan_diff_screen_create(void *params)
+{
+    scan_diff_params_t *diff_params = (scan_diff_params_t *)params;
+    
+    ESP_LOGI(TAG, "Creating scan diff screen...");
+    
+    screen_t *screen = screen_alloc();
+    scan_diff_data_t *data = screen ? calloc(1, sizeof(scan_diff_data_t)) : NULL;
+    if (!data) {
+        free(screen);
+        free(diff_params);
+        return NULL;
+    }
+    
+    if (diff_params) {
+        data->interval_ms = diff_params->interval_s * 1000;
+        free(diff_params);
+    }
+    screen_set_density(screen, UI_DENSITY_COMPACT);
+    ui_list_init(&data->list, 1, UI_LIST_MAX_ROWS, diff_row, data);
+    load_diff(data);
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_resume = on_resume;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "Scan diff screen created");
+    return screen;
+}
@@ -0,0 +1,23 @@
+/**
+ * @file scan_diff_screen.h
+ * @brief What changed between the last two WiFi scans
+ */
+
+#ifndef SCAN_DIFF_SCREEN_H
+#define SCAN_DIFF_SCREEN_H
+
+#include "screen_manager.h"
+
+// Parameters for creating the scan diff screen
+typedef struct {
+    int interval_s;             // Rescan every interval_s while shown, 0 = never
+} scan_diff_params_t;
+
+/**
+ * @brief Create the scan diff screen
+ * @param params Pointer to scan_diff_params_t (freed by the screen), or NULL
+ * @return Created screen or NULL on failure
+ */
+screen_t* scan_diff_screen_create(void *params);
+
+#endif // SCAN_DIFF_SCREEN_H
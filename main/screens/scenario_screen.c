@@ -0,0 +1,176 @@
+/**
+ * @file scenario_screen.c
+ * @brief Pick a scenario script and play it (scenario.h)
+ *
+ * Lists the scripts in SCENARIO_DIR; ENTER plays the selected one. The run
+ * starts from the home screen, so this screen goes away with it; opened
+ * again, its status bar sums up the last run.
+ */
+
+#include "scenario_screen.h"
+#include "scenario.h"
+#include "text_ui.h"
+#include "ui_list.h"
+#include "esp_log.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static const char *TAG = "SCENARIO_SCREEN";
+
+#define SCENARIO_MAX_SCRIPTS    32
+#define SCENARIO_NAME_LEN       32
+
+// Screen user data
+typedef struct {
+    ui_list_t list;
+    char names[SCENARIO_MAX_SCRIPTS][SCENARIO_NAME_LEN];
+} scenario_data_t;
+
+static void script_row(int index, char *text, size_t len, void *user_data)
+{
+    scenario_data_t *data = (scenario_data_t *)user_data;
+    snprintf(text, len, "%s", data->names[index]);
+}
+
+static bool is_script(const char *name)
+{
+    size_t len = strlen(name);
+    size_t ext = strlen(SCENARIO_EXT);
+    return len > ext && len < SCENARIO_NAME_LEN && strcasecmp(name + len - ext, SCENARIO_EXT) == 0;
+}
+
+static void load_scripts(scenario_data_t *data)
+{
+    int count = 0;
+    DIR *d = opendir(SCENARIO_DIR);
+    if (d) {
+        struct dirent *entry;
+        while (count < SCENARIO_MAX_SCRIPTS && (entry = readdir(d)) != NULL) {
+            if (!is_script(entry->d_name)) continue;
+            strlcpy(data->names[count++], entry->d_name, SCENARIO_NAME_LEN);
+        }
+        closedir(d);
+    }
+    ui_list_set_count(&data->list, count);
+}
+
+static void draw_status(scenario_data_t *data)
+{
+    scenario_status_t st;
+    scenario_get_status(&st);
+    char status[48];
+    if (st.running) {
+        snprintf(status, sizeof(status), "Playing %s: step %d", st.name, st.steps);
+    } else if (st.failed) {
+        snprintf(status, sizeof(status), "%s", st.error);
+    } else if (st.name[0]) {
+        snprintf(status, sizeof(status), "%d steps, %d no frame", st.steps, st.misses);
+    } else {
+        snprintf(status, sizeof(status), "ENTER:Run ESC:Back");
+    }
+    ui_list_draw_status(&data->list, status);
+}
+
+static void draw_screen(screen_t *self)
+{
+    scenario_data_t *data = (scenario_data_t *)self->user_data;
+    
+    ui_clear();
+    ui_draw_title("Scenarios");
+    
+    if (data->list.count == 0) {
+        ui_print_center(ui_rows() / 2 - 1, "No scripts in " SCENARIO_DIR, UI_COLOR_DIMMED);
+    } else {
+        ui_list_draw(&data->list);
+    }
+    draw_status(data);
+}
+
+static void on_tick(screen_t *self)
+{
+    scenario_data_t *data = (scenario_data_t *)self->user_data;
+    ui_list_tick(&data->list);
+}
+
+static void start_script(scenario_data_t *data)
+{
+    if (data->list.count == 0) return;
+    
+    char path[SCENARIO_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/%s", SCENARIO_DIR, data->names[data->list.selected]);
+    esp_err_t ret = scenario_start(path);
+    if (ret == ESP_ERR_INVALID_STATE) {
+        ui_list_draw_status(&data->list, "A scenario is playing");
+    } else if (ret != ESP_OK) {
+        ui_list_draw_status(&data->list, "Cannot start scenario");
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    scenario_data_t *data = (scenario_data_t *)self->user_data;
+    
+    if (ui_list_handle_key(&data->list, key)) {
+        ui_list_draw(&data->list);
+        return;
+    }
+    
+    switch (key) {
+        case KEY_ENTER:
+            start_script(data);
+            break;
+            
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    free(self->user_data);
+}
+
+static void on_resume(screen_t *self)
+{
+    draw_screen(self);
+}
+
+screen_t* scenario_screen_create(void *params)
+{
+    (void)params;
+    ESP_LOGI(TAG, "Creating scenario screen...");
+    
+    screen_t *screen = screen_alloc();
+    scenario_data_t *data = screen ? calloc(1, sizeof(scenario_data_t)) : NULL;
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    screen_set_density(screen, UI_DENSITY_COMPACT);
+    ui_list_init(&data->list, 1, UI_LIST_MAX_ROWS, script_row, data);
+    ui_list_set_marquee(&data->list, true);
+    load_scripts(data);
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_resume = on_resume;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    screen->tick_ms = UI_MARQUEE_STEP_MS;
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "Scenario screen created");
+    return screen;
+}
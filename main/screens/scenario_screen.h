@@ -0,0 +1,18 @@
+/**
+ * @file scenario_screen.h
+ * @brief Pick a scenario script and play it (scenario.h)
+ */
+
+#ifndef SCENARIO_SCREEN_H
+#define SCENARIO_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the scenario screen
+ * @param params Unused (NULL)
+ * @return Created screen or NULL on failure
+ */
+screen_t* scenario_screen_create(void *params);
+
+#endif // SCENARIO_SCREEN_H
@@ -4,11 +4,25 @@
  */
 
 #include "settings_screen.h"
+#include "screen_registry.h"
 #include "uart_pins_screen.h"
 #include "vendor_lookup_screen.h"
 #include "gps_module_screen.h"
 #include "channel_time_settings_screen.h"
+#include "uart_diag_screen.h"
+#include "cmd_latency_screen.h"
+#include "terminal_screen.h"
+#include "log_search_screen.h"
+#include "boot_timing_screen.h"
+#include "mem_monitor_screen.h"
+#include "metrics_screen.h"
+#include "usb_bridge_screen.h"
+#include "usb_msc_screen.h"
+#include "export_screen.h"
+#include "file_xfer_screen.h"
+#include "benchmark_screen.h"
 #include "settings.h"
+#include "power_governor.h"
 #include "display.h"
 #include "keyboard.h"
 #include "text_ui.h"
@@ -26,17 +40,38 @@ static const char *TAG = "SETTINGS_SCREEN";
 #define MENU_CHANNEL_TIME   3
 #define MENU_SCR_TIMEOUT    4
 #define MENU_SCR_BRIGHT     5
-#define MENU_RED_TEAM       6
-#define MENU_ITEM_COUNT     7
+#define MENU_POWER          6
+#define MENU_UART_LOG       7
+#define MENU_UART_DIAG      8
+#define MENU_CMD_LATENCY    9
+#define MENU_TERMINAL       10
+#define MENU_LOG_SEARCH     11
+#define MENU_USB_BRIDGE     12
+#define MENU_USB_DRIVE      13
+#define MENU_EXPORT         14
+#define MENU_FILE_XFER      15
+#define MENU_BOOT_TIMING    16
+#define MENU_MEMORY         17
+#define MENU_METRICS        18
+#define MENU_RED_TEAM       19
+#define MENU_ITEM_COUNT     20
+
+// Rows available below the title (no status bar on this screen)
+#define MENU_VISIBLE_ROWS   (UI_ROWS - 1)
 
 // Screen dimming timeout options (in ms)
 static const uint32_t timeout_options[] = { 10000, 30000, 60000, 300000, 0 };
 static const char *timeout_labels[] = { "10s", "30s", "1min", "5min", "Stays On" };
 #define TIMEOUT_OPTION_COUNT 5
 
+// UART log levels, indexed by uart_log_level_t
+static const char *uart_log_labels[] = { "Quiet", "Counters", "Lines", "Verbose" };
+#define UART_LOG_OPTION_COUNT 4
+
 // Screen user data
 typedef struct {
     int selected_index;
+    int scroll_offset;                 // First menu item shown
     bool awaiting_disclaimer_confirm;  // Waiting for user to confirm disclaimer
 } settings_screen_data_t;
 
@@ -74,29 +109,31 @@ static void format_setting_line(char *buf, size_t buf_size, const char *label, c
     snprintf(buf + pos, buf_size - pos, "%s", value);
 }
 
-static void draw_menu_item_at(int index, bool selected)
+static void draw_menu_item_at(settings_screen_data_t *data, int index, bool selected)
 {
     bool red_team = settings_get_red_team_enabled();
     char line[40];
+    int row = index - data->scroll_offset + 1;
+    if (row < 1 || row > MENU_VISIBLE_ROWS) return;
     
     switch (index) {
         case MENU_UART_PINS:
-            ui_draw_menu_item(index + 1, "UART Pins", selected, false, false);
+            ui_draw_menu_item(row, "UART Pins", selected, false, false);
             break;
         case MENU_VENDOR_LOOKUP:
-            ui_draw_menu_item(index + 1, "Vendor Lookup", selected, false, false);
+            ui_draw_menu_item(row, "Vendor Lookup", selected, false, false);
             break;
         case MENU_GPS_MODULE:
-            ui_draw_menu_item(index + 1, "GPS", selected, false, false);
+            ui_draw_menu_item(row, "GPS", selected, false, false);
             break;
         case MENU_CHANNEL_TIME:
-            ui_draw_menu_item(index + 1, "Channel Time", selected, false, false);
+            ui_draw_menu_item(row, "Channel Time", selected, false, false);
             break;
         case MENU_SCR_TIMEOUT:
         {
             int idx = get_timeout_option_index();
             format_setting_line(line, sizeof(line), "Dimming", timeout_labels[idx]);
-            ui_draw_menu_item(index + 1, line, selected, false, false);
+            ui_draw_menu_item(row, line, selected, false, false);
             break;
         }
         case MENU_SCR_BRIGHT:
@@ -104,11 +141,63 @@ static void draw_menu_item_at(int index, bool selected)
             char val[8];
             snprintf(val, sizeof(val), "%d%%", settings_get_screen_brightness());
             format_setting_line(line, sizeof(line), "Brightness", val);
-            ui_draw_menu_item(index + 1, line, selected, false, false);
+            ui_draw_menu_item(row, line, selected, false, false);
+            break;
+        }
+        case MENU_POWER:
+        {
+            power_profile_t profile = settings_get_power_profile();
+            char val[24];
+            if (profile == POWER_PROFILE_AUTO) {
+                snprintf(val, sizeof(val), "Auto: %s",
+                         power_governor_name(power_governor_profile()));
+            } else {
+                snprintf(val, sizeof(val), "%s", power_governor_name(profile));
+            }
+            format_setting_line(line, sizeof(line), "Power", val);
+            ui_draw_menu_item(row, line, selected, false, false);
             break;
         }
+        case MENU_UART_LOG:
+            format_setting_line(line, sizeof(line), "UART Log",
+                                uart_log_labels[settings_get_uart_log_level()]);
+            ui_draw_menu_item(row, line, selected, false, false);
+            break;
+        case MENU_UART_DIAG:
+            ui_draw_menu_item(row, "UART Diagnostics", selected, false, false);
+            break;
+        case MENU_CMD_LATENCY:
+            ui_draw_menu_item(row, "Command Latency", selected, false, false);
+            break;
+        case MENU_TERMINAL:
+            ui_draw_menu_item(row, "JanOS Terminal", selected, false, false);
+            break;
+        case MENU_LOG_SEARCH:
+            ui_draw_menu_item(row, "Log Search", selected, false, false);
+            break;
+        case MENU_USB_BRIDGE:
+            ui_draw_menu_item(row, "USB Bridge", selected, false, false);
+            break;
+        case MENU_USB_DRIVE:
+            ui_draw_menu_item(row, "USB SD Drive", selected, false, false);
+            break;
+        case MENU_EXPORT:
+            ui_draw_menu_item(row, "Data Export", selected, false, false);
+            break;
+        case MENU_FILE_XFER:
+            ui_draw_menu_item(row, "File Transfer", selected, false, false);
+            break;
+        case MENU_BOOT_TIMING:
+            ui_draw_menu_item(row, "Boot Timing", selected, false, false);
+            break;
+        case MENU_MEMORY:
+            ui_draw_menu_item(row, "Memory", selected, false, false);
+            break;
+        case MENU_METRICS:
+            ui_draw_menu_item(row, "Metrics", selected, false, false);
+            break;
         case MENU_RED_TEAM:
-            ui_draw_menu_item(index + 1, "Enable Red Team", selected, true, red_team);
+            ui_draw_menu_item(row, "Enable Red Team", selected, true, red_team);
             break;
     }
 }
@@ -122,17 +211,30 @@ static void draw_screen(screen_t *self)
     // Draw title
     ui_draw_title("Settings");
     
-    // Draw menu items (7 items + title = 8 rows, no room for status bar)
+    // Draw visible menu items (title + 7 rows, no room for status bar)
     for (int i = 0; i < MENU_ITEM_COUNT; i++) {
-        draw_menu_item_at(i, i == data->selected_index);
+        draw_menu_item_at(data, i, i == data->selected_index);
     }
 }
 
-// Optimized: redraw only two changed rows
-static void redraw_selection(settings_screen_data_t *data, int old_index, int new_index)
+// Optimized: redraw only two changed rows, or everything if the list scrolled
+static void redraw_selection(screen_t *self, int old_index, int new_index)
 {
-    draw_menu_item_at(old_index, false);
-    draw_menu_item_at(new_index, true);
+    settings_screen_data_t *data = (settings_screen_data_t *)self->user_data;
+    int old_scroll = data->scroll_offset;
+    
+    if (new_index < data->scroll_offset) {
+        data->scroll_offset = new_index;
+    } else if (new_index >= data->scroll_offset + MENU_VISIBLE_ROWS) {
+        data->scroll_offset = new_index - MENU_VISIBLE_ROWS + 1;
+    }
+    
+    if (data->scroll_offset != old_scroll) {
+        draw_screen(self);
+        return;
+    }
+    draw_menu_item_at(data, old_index, false);
+    draw_menu_item_at(data, new_index, true);
 }
 
 static void show_red_team_disclaimer(void)
@@ -154,6 +256,33 @@ static void cycle_timeout(int direction)
     settings_set_screen_timeout_ms(timeout_options[idx]);
 }
 
+/**
+ * @brief Cycle UART log level to the next/previous option
+ * @param direction +1 for next, -1 for previous
+ */
+static void cycle_uart_log(int direction)
+{
+    int idx = (int)settings_get_uart_log_level() + direction;
+    if (idx >= UART_LOG_OPTION_COUNT) idx = 0;
+    if (idx < 0) idx = UART_LOG_OPTION_COUNT - 1;
+    settings_set_uart_log_level((uart_log_level_t)idx);
+}
+
+/**
+ * @brief Cycle the power profile to the next/previous option
+ * @param direction +1 for next, -1 for previous
+ */
+static void cycle_power_profile(int direction)
+{
+    int idx = (int)settings_get_power_profile() + direction;
+    if (idx >= POWER_PROFILE_COUNT) idx = 0;
+    if (idx < 0) idx = POWER_PROFILE_COUNT - 1;
+    settings_set_power_profile((power_profile_t)idx);
+    // Apply now so the row and the backlight show the new profile
+    power_governor_service();
+    display_set_backlight(power_governor_brightness());
+}
+
 /**
  * @brief Adjust screen brightness
  * @param delta Amount to change (-100 to +100)
@@ -165,7 +294,7 @@ static void adjust_brightness(int delta)
     if (current < 1) current = 1;
     if (current > 100) current = 100;
     settings_set_screen_brightness((uint8_t)current);
-    display_set_backlight((uint8_t)current);
+    display_set_backlight(power_governor_brightness());
 }
 
 static void on_key(screen_t *self, key_code_t key)
@@ -192,11 +321,11 @@ static void on_key(screen_t *self, key_code_t key)
             if (data->selected_index > 0) {
                 int old = data->selected_index;
                 data->selected_index--;
-                redraw_selection(data, old, data->selected_index);
+                redraw_selection(self, old, data->selected_index);
             } else {
                 int old = data->selected_index;
                 data->selected_index = MENU_ITEM_COUNT - 1;
-                redraw_selection(data, old, data->selected_index);
+                redraw_selection(self, old, data->selected_index);
             }
             break;
             
@@ -204,35 +333,47 @@ static void on_key(screen_t *self, key_code_t key)
             if (data->selected_index < MENU_ITEM_COUNT - 1) {
                 int old = data->selected_index;
                 data->selected_index++;
-                redraw_selection(data, old, data->selected_index);
+                redraw_selection(self, old, data->selected_index);
             } else {
                 int old = data->selected_index;
                 data->selected_index = 0;
-                redraw_selection(data, old, data->selected_index);
+                redraw_selection(self, old, data->selected_index);
             }
             break;
             
         case KEY_LEFT:
             if (data->selected_index == MENU_SCR_TIMEOUT) {
                 cycle_timeout(-1);
-                draw_menu_item_at(MENU_SCR_TIMEOUT, true);
+                draw_menu_item_at(data, MENU_SCR_TIMEOUT, true);
+            } else if (data->selected_index == MENU_UART_LOG) {
+                cycle_uart_log(-1);
+                draw_menu_item_at(data, MENU_UART_LOG, true);
+            } else if (data->selected_index == MENU_POWER) {
+                cycle_power_profile(-1);
+                draw_menu_item_at(data, MENU_POWER, true);
             } else if (data->selected_index == MENU_SCR_BRIGHT) {
                 // Without Shift: -10%, with Shift: -1%
                 int step = keyboard_is_shift_held() ? -1 : -10;
                 adjust_brightness(step);
-                draw_menu_item_at(MENU_SCR_BRIGHT, true);
+                draw_menu_item_at(data, MENU_SCR_BRIGHT, true);
             }
             break;
             
         case KEY_RIGHT:
             if (data->selected_index == MENU_SCR_TIMEOUT) {
                 cycle_timeout(+1);
-                draw_menu_item_at(MENU_SCR_TIMEOUT, true);
+                draw_menu_item_at(data, MENU_SCR_TIMEOUT, true);
+            } else if (data->selected_index == MENU_UART_LOG) {
+                cycle_uart_log(+1);
+                draw_menu_item_at(data, MENU_UART_LOG, true);
+            } else if (data->selected_index == MENU_POWER) {
+                cycle_power_profile(+1);
+                draw_menu_item_at(data, MENU_POWER, true);
             } else if (data->selected_index == MENU_SCR_BRIGHT) {
                 // Without Shift: +10%, with Shift: +1%
                 int step = keyboard_is_shift_held() ? 1 : 10;
                 adjust_brightness(step);
-                draw_menu_item_at(MENU_SCR_BRIGHT, true);
+                draw_menu_item_at(data, MENU_SCR_BRIGHT, true);
             }
             break;
             
@@ -255,16 +396,57 @@ static void on_key(screen_t *self, key_code_t key)
                     case MENU_SCR_TIMEOUT:
                         // ENTER also cycles timeout forward
                         cycle_timeout(+1);
-                        draw_menu_item_at(MENU_SCR_TIMEOUT, true);
+                        draw_menu_item_at(data, MENU_SCR_TIMEOUT, true);
                         break;
                     case MENU_SCR_BRIGHT:
                         // No action on ENTER for brightness (use arrows)
                         break;
+                    case MENU_POWER:
+                        cycle_power_profile(+1);
+                        draw_menu_item_at(data, MENU_POWER, true);
+                        break;
+                    case MENU_UART_LOG:
+                        cycle_uart_log(+1);
+                        draw_menu_item_at(data, MENU_UART_LOG, true);
+                        break;
+                    case MENU_UART_DIAG:
+                        screen_manager_push(uart_diag_screen_create, NULL);
+                        break;
+                    case MENU_CMD_LATENCY:
+                        screen_manager_push(cmd_latency_screen_create, NULL);
+                        break;
+                    case MENU_TERMINAL:
+                        screen_manager_push(terminal_screen_create, NULL);
+                        break;
+                    case MENU_LOG_SEARCH:
+                        screen_manager_push(log_search_screen_create, NULL);
+                        break;
+                    case MENU_USB_BRIDGE:
+                        screen_manager_push(usb_bridge_screen_create, NULL);
+                        break;
+                    case MENU_USB_DRIVE:
+                        screen_manager_push(usb_msc_screen_create, NULL);
+                        break;
+                    case MENU_EXPORT:
+                        screen_manager_push(export_screen_create, NULL);
+                        break;
+                    case MENU_FILE_XFER:
+                        screen_manager_push(file_xfer_screen_create, NULL);
+                        break;
+                    case MENU_BOOT_TIMING:
+                        screen_manager_push(boot_timing_screen_create, NULL);
+                        break;
+                    case MENU_MEMORY:
+                        screen_manager_push(mem_monitor_screen_create, NULL);
+                        break;
+                    case MENU_METRICS:
+                        screen_manager_push(metrics_screen_create, NULL);
+                        break;
                     case MENU_RED_TEAM:
                         if (settings_get_red_team_enabled()) {
                             // Already enabled - just disable it
                             settings_set_red_team_enabled(false);
-                            draw_menu_item_at(MENU_RED_TEAM, true);
+                            draw_menu_item_at(data, MENU_RED_TEAM, true);
                         } else {
                             // Show disclaimer before enabling
                             show_red_team_disclaimer();
@@ -275,6 +457,11 @@ static void on_key(screen_t *self, key_code_t key)
             }
             break;
             
+        case KEY_B:
+            // Hidden: on-device benchmarks
+            screen_manager_push(benchmark_screen_create, NULL);
+            break;
+            
         case KEY_ESC:
         case KEY_Q:
         case KEY_BACKSPACE:
@@ -288,6 +475,9 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
+    // Save adjustments now rather than on the commit timer
+    settings_flush();
+    
     if (self->user_data) {
         free(self->user_data);
     }
@@ -326,3 +516,5 @@ screen_t* settings_screen_create(void *params)
     ESP_LOGI(TAG, "Settings screen created");
     return screen;
 }
+
+SCREEN_REGISTER(HOME, 80, settings_screen_create, 0, "Settings", NULL);
@@ -4,10 +4,12 @@
  */
 
 #include "sniff_karma_menu_screen.h"
+#include "screen_registry.h"
 #include "global_sniffer_screen.h"
 #include "sniffer_results_screen.h"
 #include "sniffer_probes_screen.h"
 #include "karma_probes_screen.h"
+#include "listing_prefetch.h"
 #include "text_ui.h"
 #include "esp_log.h"
 #include <string.h>
@@ -24,6 +26,7 @@ static const char *menu_items[] = {
 };
 
 #define MENU_ITEM_COUNT (sizeof(menu_items) / sizeof(menu_items[0]))
+#define MENU_KARMA      3       // Its HTML picker lists files on the board SD
 
 // Screen user data
 typedef struct {
@@ -53,6 +56,7 @@ static void redraw_selection(sniff_karma_menu_data_t *data, int old_index, int n
 {
     ui_draw_menu_item(old_index + 1, menu_items[old_index], false, false, false);
     ui_draw_menu_item(new_index + 1, menu_items[new_index], true, false, false);
+    listing_prefetch_hover(new_index == MENU_KARMA ? LISTING_HTML_FILES : LISTING_NONE);
 }
 
 static void on_key(screen_t *self, key_code_t key)
@@ -117,6 +121,7 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
+    listing_prefetch_cancel();
     if (self->user_data) {
         free(self->user_data);
     }
@@ -124,7 +129,9 @@ static void on_destroy(screen_t *self)
 
 static void on_resume(screen_t *self)
 {
+    sniff_karma_menu_data_t *data = (sniff_karma_menu_data_t *)self->user_data;
     draw_screen(self);
+    listing_prefetch_hover(data->selected_index == MENU_KARMA ? LISTING_HTML_FILES : LISTING_NONE);
 }
 
 screen_t* sniff_karma_menu_screen_create(void *params)
@@ -156,12 +163,4 @@ screen_t* sniff_karma_menu_screen_create(void *params)
     return screen;
 }
 
-
-
-
-
-
-
-
-
-
+SCREEN_REGISTER(HOME, 30, sniff_karma_menu_screen_create, 0, "WiFi Sniff&Karma", NULL);
@@ -1,106 +1,220 @@
 /**
  * @file sniffer_dog_screen.c
  * @brief Sniffer Dog attack screen implementation
+ *
+ * JanOS reports every deauth it sends for an (AP, station) pair it
+ * sniffed. Kicks are counted per pair in a MAC-pair hash table filled by
+ * the UART task (append-only, like the ARP host list), and shown as a
+ * virtualized list sorted by kicks, by last kick or by station. At high
+ * kick rates the view is rebuilt and the changed rows painted at most
+ * once per frame, not once per line.
  */
 
 #include "sniffer_dog_screen.h"
+#include "mem_monitor.h"
+#include "sdkconfig.h"
 #include "uart_handler.h"
+#include "mac_set.h"
+#include "janos_proto.h"
+#include "fixed_containers.h"
 #include "text_ui.h"
+#include "ui_list.h"
 #include "buzzer.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 static const char *TAG = "SNIFFER_DOG";
 
-// MAC address length (XX:XX:XX:XX:XX:XX + null)
-#define MAC_LEN 18
+#ifdef CONFIG_SNIFFER_DOG_MAX_PAIRS
+#define MAX_PAIRS           CONFIG_SNIFFER_DOG_MAX_PAIRS
+#else
+#define MAX_PAIRS           256
+#endif
+#define REDRAW_INTERVAL_US  (RENDER_FRAME_INTERVAL_MS * 1000)
+#define AGE_REFRESH_US      1000000     // Last-kick ages tick over once a second
 
-// Refresh timer interval (200ms)
-#define REFRESH_INTERVAL_US 200000
+typedef enum {
+    SORT_KICKS = 0,             // Most kicked first
+    SORT_RECENT,                // Last kicked first
+    SORT_STATION,               // By station MAC
+    SORT_COUNT
+} dog_sort_t;
+
+static const char *const sort_names[SORT_COUNT] = { "kicks", "recent", "station" };
+
+// One (AP, station) pair
+typedef struct {
+    uint64_t ap;
+    uint64_t sta;
+    uint32_t kicks;
+    uint32_t last_ms;           // esp_timer ms of the latest kick (32-bit: read whole)
+    uint8_t channel;
+    int8_t rssi;
+} dog_pair_t;
 
 // Screen user data
 typedef struct {
-    char last_ap[MAC_LEN];
-    char last_sta[MAC_LEN];
-    int kick_count;
-    bool needs_redraw;
-    esp_timer_handle_t refresh_timer;
+    // Model, filled by the UART task (append-only)
+    dog_pair_t pairs[MAX_PAIRS];
+    mac_set_t index;            // Pair hash -> pairs[]
+    volatile int pair_count;
+    volatile int kick_count;    // JanOS's own count, kicks before this screen included
+    int dropped;
+    volatile uint32_t generation;
+    // Sorted view, rebuilt on the UI task
+    uint16_t order[MAX_PAIRS];
+    uint32_t view_generation;
+    dog_sort_t sort;
+    int64_t draw_time_us;
+    int64_t age_time_us;
+    ui_list_t list;
     screen_t *self;
 } sniffer_dog_data_t;
 
-// Forward declaration
-static void draw_screen(screen_t *self);
+MEM_BUDGET(sniffer_dog, 1, sizeof(sniffer_dog_data_t), MEM_BUDGET_SCREEN);
+
+static uint64_t pair_key(uint64_t ap, uint64_t sta)
+{
+    char text[28];
+    snprintf(text, sizeof(text), "%012llx>%012llx", (unsigned long long)ap, (unsigned long long)sta);
+    return mac_set_key_from_string(text);
+}
 
 /**
- * @brief Timer callback - checks if redraw is needed
+ * @brief Count one kick against its pair
  */
-static void refresh_timer_callback(void *arg)
+static void add_kick(sniffer_dog_data_t *data, const janos_dog_kick_t *kick)
 {
-    sniffer_dog_data_t *data = (sniffer_dog_data_t *)arg;
-    if (data && data->needs_redraw && data->self) {
-        data->needs_redraw = false;
-        draw_screen(data->self);
+    uint64_t key = pair_key(kick->ap, kick->sta);
+    int idx = mac_set_find(&data->index, key);
+    if (idx < 0) {
+        // Never let the set evict: records are what the view indexes
+        if (data->index.count >= MAX_PAIRS) {
+            data->dropped++;
+            data->kick_count = kick->count;
+            data->generation++;
+            return;
+        }
+        bool is_new = false;
+        idx = mac_set_add(&data->index, key, &is_new);
+        if (idx < 0) return;
+
+        dog_pair_t *pair = &data->pairs[idx];
+        memset(pair, 0, sizeof(*pair));
+        pair->ap = kick->ap;
+        pair->sta = kick->sta;
+        data->pair_count = data->index.count;
     }
+
+    dog_pair_t *pair = &data->pairs[idx];
+    pair->kicks++;
+    pair->last_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    if (kick->channel > 0 && kick->channel < 256) pair->channel = (uint8_t)kick->channel;
+    if (kick->rssi != JANOS_RSSI_NONE) pair->rssi = (int8_t)kick->rssi;
+    data->kick_count = kick->count;
+    data->generation++;
 }
 
 /**
  * @brief UART line callback for parsing sniffer dog output
- * Pattern: [SnifferDog #N] DEAUTH sent: AP=XX:XX:XX:XX:XX:XX -> STA=YY:YY:YY:YY:YY:YY
+ * Pattern: [SnifferDog #N] DEAUTH sent: AP=XX:XX:XX:XX:XX:XX -> STA=YY:YY:YY:YY:YY:YY (Ch=1, RSSI=-69)
  */
 static void uart_line_callback(const char *line, void *user_data)
 {
     sniffer_dog_data_t *data = (sniffer_dog_data_t *)user_data;
     if (!data) return;
-    
-    // Look for "[SnifferDog #" pattern
-    const char *marker = "[SnifferDog #";
-    const char *found = strstr(line, marker);
-    
-    if (found) {
-        // Extract the number after #
-        const char *num_start = found + strlen(marker);
-        int count = atoi(num_start);
-        
-        if (count > 0) {
-            data->kick_count = count;
-            
-            // Extract AP MAC - look for "AP="
-            const char *ap_marker = "AP=";
-            const char *ap_start = strstr(line, ap_marker);
-            if (ap_start) {
-                ap_start += strlen(ap_marker);
-                // Copy 17 characters (MAC address)
-                strncpy(data->last_ap, ap_start, MAC_LEN - 1);
-                data->last_ap[MAC_LEN - 1] = '\0';
-                // Truncate at space or arrow if present
-                char *end = strchr(data->last_ap, ' ');
-                if (end) *end = '\0';
-            }
-            
-            // Extract STA MAC - look for "STA="
-            const char *sta_marker = "STA=";
-            const char *sta_start = strstr(line, sta_marker);
-            if (sta_start) {
-                sta_start += strlen(sta_marker);
-                // Copy 17 characters (MAC address)
-                strncpy(data->last_sta, sta_start, MAC_LEN - 1);
-                data->last_sta[MAC_LEN - 1] = '\0';
-                // Truncate at space or parenthesis if present
-                char *end = strchr(data->last_sta, ' ');
-                if (end) *end = '\0';
-                end = strchr(data->last_sta, '(');
-                if (end) *end = '\0';
-            }
-            
-            ESP_LOGI(TAG, "Kick #%d: STA=%s from AP=%s", 
-                     data->kick_count, data->last_sta, data->last_ap);
-            
-            // Signal redraw needed
-            data->needs_redraw = true;
-        }
+
+    janos_dog_kick_t kick;
+    if (janos_parse_dog_kick(line, &kick)) {
+        add_kick(data, &kick);
+    }
+}
+
+static int compare_pairs(int a, int b, void *ctx)
+{
+    const sniffer_dog_data_t *data = ctx;
+    const dog_pair_t *pa = &data->pairs[a];
+    const dog_pair_t *pb = &data->pairs[b];
+
+    switch (data->sort) {
+        case SORT_KICKS:
+            if (pa->kicks != pb->kicks) return pa->kicks > pb->kicks ? -1 : 1;
+            break;
+        case SORT_RECENT:
+            if (pa->last_ms != pb->last_ms) return (int32_t)(pb->last_ms - pa->last_ms) < 0 ? -1 : 1;
+            break;
+        case SORT_STATION:
+            if (pa->sta != pb->sta) return pa->sta < pb->sta ? -1 : 1;
+            if (pa->ap != pb->ap) return pa->ap < pb->ap ? -1 : 1;
+            break;
+        default:
+            break;
+    }
+    return a - b;
+}
+
+/**
+ * @brief Rebuild the sorted view, keeping the cursor on the same pair
+ */
+static void refresh_view(sniffer_dog_data_t *data)
+{
+    int selected_pair = data->list.count > 0 ? data->order[data->list.selected] : -1;
+
+    data->view_generation = data->generation;
+    int count = data->pair_count;
+    for (int i = 0; i < count; i++) {
+        data->order[i] = (uint16_t)i;
+    }
+    fixed_index_sort(data->order, count, compare_pairs, data);
+    ui_list_set_count(&data->list, count);
+
+    int row = fixed_index_find(data->order, count, selected_pair);
+    if (row >= 0) ui_list_select(&data->list, row);
+}
+
+/**
+ * @brief Station, AP tail, kicks and time since the last one
+ * "A6:02:A5:BA:DA:AB 3C3F64 x12   4s"
+ */
+static void pair_row(int index, char *text, size_t len, void *user_data)
+{
+    sniffer_dog_data_t *data = (sniffer_dog_data_t *)user_data;
+    const dog_pair_t *pair = &data->pairs[data->order[index]];
+    uint64_t sta = pair->sta;
+
+    uint32_t age_s = ((uint32_t)(esp_timer_get_time() / 1000) - pair->last_ms) / 1000;
+    char age[8];
+    if (age_s < 100) snprintf(age, sizeof(age), "%2lus", (unsigned long)age_s);
+    else if (age_s < 6000) snprintf(age, sizeof(age), "%2lum", (unsigned long)(age_s / 60));
+    else snprintf(age, sizeof(age), "%2luh", (unsigned long)(age_s / 3600 % 100));
+
+    snprintf(text, len, "%02X:%02X:%02X:%02X:%02X:%02X %06lX x%-4lu%s",
+             (unsigned)(sta >> 40) & 0xFF, (unsigned)(sta >> 32) & 0xFF, (unsigned)(sta >> 24) & 0xFF,
+             (unsigned)(sta >> 16) & 0xFF, (unsigned)(sta >> 8) & 0xFF, (unsigned)sta & 0xFF,
+             (unsigned long)(pair->ap & 0xFFFFFF), (unsigned long)pair->kicks, age);
+}
+
+static void draw_title(sniffer_dog_data_t *data)
+{
+    char title[40];
+    if (data->dropped) {
+        snprintf(title, sizeof(title), "Sniffer Dog %d kicks %d+%d pairs",
+                 data->kick_count, data->list.count, data->dropped);
+    } else {
+        snprintf(title, sizeof(title), "Sniffer Dog %d kicks %d pairs",
+                 data->kick_count, data->list.count);
     }
+    ui_draw_title(title);
+}
+
+static void draw_status(sniffer_dog_data_t *data)
+{
+    char status[40];
+    snprintf(status, sizeof(status), "S:Sort(%s) ESC:Stop", sort_names[data->sort]);
+    ui_draw_status(status);
 }
 
 static void draw_screen(screen_t *self)
@@ -109,38 +223,60 @@ static void draw_screen(screen_t *self)
     
     ui_clear();
     
-    // Draw title
-    ui_draw_title("Sniffer Dog");
-    
-    int row = 2;
-    
-    // Stations kicked out
-    char count_line[32];
-    snprintf(count_line, sizeof(count_line), "Stations kicked out: %d", data->kick_count);
-    ui_print(0, row, count_line, UI_COLOR_HIGHLIGHT);
-    row += 2;
-    
-    // Last station info
-    if (data->last_sta[0] != '\0') {
-        char sta_line[48];
-        snprintf(sta_line, sizeof(sta_line), "Last station STA=%s", data->last_sta);
-        ui_print(0, row, sta_line, UI_COLOR_TEXT);
-        row++;
-        
-        char ap_line[48];
-        snprintf(ap_line, sizeof(ap_line), "kicked out from AP=%s", data->last_ap);
-        ui_print(0, row, ap_line, UI_COLOR_TEXT);
+    refresh_view(data);
+    draw_title(data);
+    
+    if (data->list.count > 0) {
+        ui_list_draw(&data->list);
     } else {
-        ui_print(0, row, "Waiting for deauth events...", UI_COLOR_DIMMED);
+        ui_print_center(ui_rows() / 2 - 1, "Waiting for deauth events...", UI_COLOR_DIMMED);
     }
     
-    // Draw status bar
-    ui_draw_status("ESC: Stop & Exit");
+    draw_status(data);
+    data->draw_time_us = esp_timer_get_time();
+    data->age_time_us = data->draw_time_us;
+}
+
+static void on_tick(screen_t *self)
+{
+    sniffer_dog_data_t *data = (sniffer_dog_data_t *)self->user_data;
+    
+    int64_t now = esp_timer_get_time();
+    bool changed = data->generation != data->view_generation;
+    bool aged = data->list.count > 0 && now - data->age_time_us >= AGE_REFRESH_US;
+    if ((!changed && !aged) || now - data->draw_time_us < REDRAW_INTERVAL_US) return;
+    
+    if (data->list.count == 0) {
+        draw_screen(self);
+        return;
+    }
+    // Only the title and the rows whose text changed are painted
+    if (changed) {
+        refresh_view(data);
+        draw_title(data);
+    }
+    ui_list_draw(&data->list);
+    data->draw_time_us = now;
+    if (aged) data->age_time_us = now;
 }
 
 static void on_key(screen_t *self, key_code_t key)
 {
+    sniffer_dog_data_t *data = (sniffer_dog_data_t *)self->user_data;
+    
+    if (ui_list_handle_key(&data->list, key)) {
+        ui_list_draw(&data->list);
+        return;
+    }
+    
     switch (key) {
+        case KEY_S:
+            data->sort = (dog_sort_t)((data->sort + 1) % SORT_COUNT);
+            refresh_view(data);
+            ui_list_draw(&data->list);
+            draw_status(data);
+            break;
+            
         case KEY_ESC:
         case KEY_Q:
         case KEY_BACKSPACE:
@@ -158,17 +294,11 @@ static void on_destroy(screen_t *self)
 {
     sniffer_dog_data_t *data = (sniffer_dog_data_t *)self->user_data;
     
-    // Stop and delete timer
-    if (data && data->refresh_timer) {
-        esp_timer_stop(data->refresh_timer);
-        esp_timer_delete(data->refresh_timer);
-    }
-    
-    // Clear UART callback
-    uart_clear_line_callback();
-    
+    // User data lives in the screen arena and is released on pop
     if (data) {
-        free(data);
+        ESP_LOGI(TAG, "%d kicks over %d pairs (%d dropped)",
+                 data->kick_count, data->pair_count, data->dropped);
+        mac_set_free(&data->index);
     }
 }
 
@@ -182,37 +312,28 @@ screen_t* sniffer_dog_screen_create(void *params)
     if (!screen) return NULL;
     
     // Allocate user data
-    sniffer_dog_data_t *data = calloc(1, sizeof(sniffer_dog_data_t));
-    if (!data) {
+    sniffer_dog_data_t *data = screen_arena_alloc(sizeof(sniffer_dog_data_t));
+    if (!data || mac_set_init(&data->index, MAX_PAIRS) != ESP_OK) {
         free(screen);
         return NULL;
     }
     
     data->self = screen;
-    data->last_ap[0] = '\0';
-    data->last_sta[0] = '\0';
-    data->kick_count = 0;
+    data->sort = SORT_KICKS;
+    screen_set_density(screen, UI_DENSITY_COMPACT);
+    ui_list_init(&data->list, 1, UI_LIST_MAX_ROWS, pair_row, data);
     
     screen->user_data = data;
+    screen->mem_budget_kb = 48;     // Pair table and its MAC index
     screen->on_key = on_key;
     screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
-    
-    // Create periodic refresh timer
-    esp_timer_create_args_t timer_args = {
-        .callback = refresh_timer_callback,
-        .arg = data,
-        .name = "sniff_dog_refresh"
-    };
-    
-    if (esp_timer_create(&timer_args, &data->refresh_timer) == ESP_OK) {
-        esp_timer_start_periodic(data->refresh_timer, REFRESH_INTERVAL_US);
-    } else {
-        ESP_LOGW(TAG, "Failed to create refresh timer");
-    }
+    screen->on_tick = on_tick;
+    screen->tick_on_uart = true;    // on_tick redraws at most once per frame
+    screen->tick_ms = 100;          // Shows the tail of a burst held by that limit
     
     // Register UART callback for parsing sniffer dog output
-    uart_register_line_callback(uart_line_callback, data);
+    screen_set_line_callback(screen, uart_line_callback, data);
     
     // Send start_sniffer_dog command
     uart_send_command("start_sniffer_dog");
@@ -224,13 +345,3 @@ screen_t* sniffer_dog_screen_create(void *params)
     ESP_LOGI(TAG, "Sniffer dog screen created");
     return screen;
 }
-
-
-
-
-
-
-
-
-
-
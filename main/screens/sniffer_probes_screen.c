@@ -1,10 +1,15 @@
 /**
  * @file sniffer_probes_screen.c
  * @brief Sniffer probes screen showing probe requests
+ *
+ * world_model files show_probes rows into the shared probe store; the
+ * screen lists the probed SSIDs ranked by how many stations asked for them.
  */
 
 #include "sniffer_probes_screen.h"
 #include "uart_handler.h"
+#include "probe_store.h"
+#include "world_model.h"
 #include "text_ui.h"
 #include "esp_log.h"
 #include <string.h>
@@ -13,112 +18,29 @@
 
 static const char *TAG = "SNIFF_PROBES";
 
-// Maximum entries
-#define MAX_PROBES      32
-#define MAX_PROBE_LEN   32
+#define VISIBLE_ROWS    6
 
 // Screen user data
 typedef struct {
-    char probes[MAX_PROBES][MAX_PROBE_LEN];
+    uint16_t order[PROBE_STORE_MAX];    // SSIDs, most stations first
     int probe_count;
+    uint32_t generation;
     int total_probes;  // From header "Probe requests: N"
+    uint32_t listings;  // world_model listing count when show_probes was sent
     int scroll_offset;
     bool loading;
-    bool needs_redraw;
     screen_t *self;
 } sniffer_probes_data_t;
 
-// Forward declaration
-static void draw_screen(screen_t *self);
-
-/**
- * @brief Check if line is an ESP log line
- */
-static bool is_esp_log_line(const char *line)
-{
-    if (strlen(line) < 3) return false;
-    
-    // Check for ESP log format: "I (", "W (", "E (", "D ("
-    if ((line[0] == 'I' || line[0] == 'W' || line[0] == 'E' || line[0] == 'D') 
-        && line[1] == ' ' && line[2] == '(') {
-        return true;
-    }
-    
-    // Check for other common log patterns
-    if (strstr(line, "[MEM]") != NULL) return true;
-    if (strncmp(line, "show_probes", 11) == 0) return true;  // Echo of command
-    
-    return false;
-}
-
-/**
- * @brief Check if line is a probe entry (format: "SSID (MAC)")
- */
-static bool is_probe_line(const char *line)
-{
-    // Must contain "(" and end with ")"
-    const char *paren = strchr(line, '(');
-    if (!paren) return false;
-    
-    size_t len = strlen(line);
-    if (len == 0) return false;
-    
-    // Check if ends with ")" (possibly with trailing whitespace)
-    for (int i = len - 1; i >= 0; i--) {
-        if (line[i] == ')') return true;
-        if (line[i] != ' ' && line[i] != '\n' && line[i] != '\r') return false;
-    }
-    return false;
-}
-
-/**
- * @brief UART line callback for parsing probes
- */
-static void uart_line_callback(const char *line, void *user_data)
-{
-    sniffer_probes_data_t *data = (sniffer_probes_data_t *)user_data;
-    if (!data) return;
-    
-    // Skip empty lines
-    if (strlen(line) == 0) return;
-    
-    // Skip ESP log lines
-    if (is_esp_log_line(line)) return;
-    
-    // Check for header: "Probe requests: N"
-    const char *header = "Probe requests: ";
-    if (strstr(line, header)) {
-        const char *num_start = strstr(line, header);
-        if (num_start) {
-            data->total_probes = atoi(num_start + strlen(header));
-        }
-        data->loading = false;
-        data->needs_redraw = true;
-        return;
-    }
-    
-    // Check for "No probe requests" or similar
-    if (strstr(line, "No probe") != NULL || strstr(line, "no probe") != NULL) {
-        data->loading = false;
-        data->needs_redraw = true;
-        return;
-    }
-    
-    // Only store lines matching probe format: "SSID (MAC)"
-    if (is_probe_line(line) && data->probe_count < MAX_PROBES) {
-        strncpy(data->probes[data->probe_count], line, MAX_PROBE_LEN - 1);
-        data->probes[data->probe_count][MAX_PROBE_LEN - 1] = '\0';
-        data->probe_count++;
-        data->needs_redraw = true;
-    }
-}
-
 static void draw_screen(screen_t *self)
 {
     sniffer_probes_data_t *data = (sniffer_probes_data_t *)self->user_data;
     
     ui_clear();
     
+    data->generation = probe_store_generation();
+    data->probe_count = probe_store_view(data->order, PROBE_STORE_MAX, PROBE_SORT_POPULAR, false);
+    
     // Draw title with count
     char title[32];
     snprintf(title, sizeof(title), "Probes (%d)", data->total_probes);
@@ -129,19 +51,16 @@ static void draw_screen(screen_t *self)
     } else if (data->probe_count == 0) {
         ui_print_center(3, "No probes found", UI_COLOR_DIMMED);
     } else {
-        // Draw visible probes
-        int visible_rows = 6;
+        // Draw visible SSIDs with their station counts
         int start_row = 1;
         
-        for (int i = 0; i < visible_rows; i++) {
+        for (int i = 0; i < VISIBLE_ROWS; i++) {
             int probe_idx = data->scroll_offset + i;
+            probe_record_t rec;
             
-            if (probe_idx < data->probe_count) {
-                // Truncate for display
+            if (probe_idx < data->probe_count && probe_store_get(data->order[probe_idx], &rec)) {
                 char display[31];
-                strncpy(display, data->probes[probe_idx], 30);
-                display[30] = '\0';
-                
+                snprintf(display, sizeof(display), "%-24.24s %3u", ssid_pool_str(rec.ssid), rec.clients);
                 ui_print(0, start_row + i, display, UI_COLOR_TEXT);
             }
         }
@@ -150,8 +69,8 @@ static void draw_screen(screen_t *self)
         if (data->scroll_offset > 0) {
             ui_print(UI_COLS - 2, 1, "^", UI_COLOR_DIMMED);
         }
-        if (data->scroll_offset + visible_rows < data->probe_count) {
-            ui_print(UI_COLS - 2, visible_rows, "v", UI_COLOR_DIMMED);
+        if (data->scroll_offset + VISIBLE_ROWS < data->probe_count) {
+            ui_print(UI_COLS - 2, VISIBLE_ROWS, "v", UI_COLOR_DIMMED);
         }
     }
     
@@ -163,9 +82,16 @@ static void on_tick(screen_t *self)
 {
     sniffer_probes_data_t *data = (sniffer_probes_data_t *)self->user_data;
     
-    // Check if redraw needed from UART callback (thread-safe)
-    if (data->needs_redraw) {
-        data->needs_redraw = false;
+    // The reply's header (or "no probes") ends loading
+    uint32_t listings = world_model_probe_listings();
+    bool changed = probe_store_generation() != data->generation;
+    if (listings != data->listings) {
+        data->listings = listings;
+        data->total_probes = world_model_probe_total();
+        data->loading = false;
+        changed = true;
+    }
+    if (changed) {
         draw_screen(self);
     }
 }
@@ -173,7 +99,7 @@ static void on_tick(screen_t *self)
 static void on_key(screen_t *self, key_code_t key)
 {
     sniffer_probes_data_t *data = (sniffer_probes_data_t *)self->user_data;
-    int visible_rows = 6;
+    int visible_rows = VISIBLE_ROWS;
     
     switch (key) {
         case KEY_UP:
@@ -214,9 +140,6 @@ static void on_destroy(screen_t *self)
 {
     sniffer_probes_data_t *data = (sniffer_probes_data_t *)self->user_data;
     
-    // Clear UART callback
-    uart_clear_line_callback();
-    
     if (data) {
         free(data);
     }
@@ -240,7 +163,15 @@ screen_t* sniffer_probes_screen_create(void *params)
         return NULL;
     }
     
-    data->loading = true;
+    if (probe_store_init() != ESP_OK) {
+        free(data);
+        free(screen);
+        return NULL;
+    }
+    // Probes from an earlier listing show until the new one arrives
+    data->total_probes = world_model_probe_total();
+    data->listings = world_model_probe_listings();
+    data->loading = (probe_store_count() == 0);
     data->self = screen;
     
     screen->user_data = data;
@@ -249,9 +180,6 @@ screen_t* sniffer_probes_screen_create(void *params)
     screen->on_draw = draw_screen;
     screen->on_tick = on_tick;
     
-    // Register UART callback
-    uart_register_line_callback(uart_line_callback, data);
-    
     // Send command to get probes
     uart_send_command("show_probes");
     
@@ -4,29 +4,49 @@
  */
 
 #include "sniffer_results_screen.h"
+#include "mem_monitor.h"
 #include "station_deauth_screen.h"
+#include "sdkconfig.h"
 #include "uart_handler.h"
+#include "network_store.h"
+#include "station_store.h"
+#include "time_sync.h"
+#include "oui_lookup.h"
 #include "text_ui.h"
+#include "janos_proto.h"
 #include "buzzer.h"
+#include "fixed_containers.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
 
 static const char *TAG = "SNIFF_RES";
 
-// Maximum entries
-#define MAX_LINES       32
-#define MAX_LINE_LEN    32
-#define MAX_SSID_LEN    33
+// The model is station_store, filled by world_model from every listing
+#define MAX_ROWS            (STATION_STORE_APS + STATION_STORE_MAX)
+#define ROW_AP              0x8000      // Row value flag: AP index, else station index
+#define NO_ROW              0xFFFF
+#define VISIBLE_ROWS        6
+
+#define AUTO_REFRESH_US     10000000    // Re-request results every 10 s
+#define REDRAW_INTERVAL_US  250000
 
 // Screen user data
 typedef struct {
-    char lines[MAX_LINES][MAX_LINE_LEN];
-    char parent_ssid[MAX_LINES][MAX_SSID_LEN];  // Parent SSID for each MAC line
-    char current_ssid[MAX_SSID_LEN];            // Current SSID during parsing
-    int line_count;
-    int selected_index;     // Currently selected line
+    int passes;                                 // show_sniffer_results requests sent
+    int64_t new_since_us;                       // Stations first listed after this are new
+    // Flattened view, rebuilt on the UI task
+    uint16_t rows[MAX_ROWS];
+    int row_count;
+    int ap_count;                               // AP rows
+    int client_count;                           // Station rows
+    int new_clients;
+    uint32_t rows_generation;
+    int64_t refresh_time_us;
+    int64_t draw_time_us;
+    int selected_index;     // Currently selected row
     int scroll_offset;
     bool loading;
     bool needs_redraw;
@@ -37,6 +57,8 @@ typedef struct {
     char deauth_ssid[MAX_SSID_LEN];             // SSID to find in scan results
 } sniffer_results_data_t;
 
+MEM_BUDGET(sniffer_results, 1, sizeof(sniffer_results_data_t), MEM_BUDGET_SCREEN);
+
 // Forward declaration
 static void draw_screen(screen_t *self);
 
@@ -102,113 +124,45 @@ static bool is_no_results_line(const char *line)
 }
 
 /**
- * @brief Extract SSID from SSID line (everything before ", CH")
+ * @brief Parse scan result CSV line and extract index and SSID
+ * Format: "1","SSID","","BSSID","CH","Security","RSSI","Band"
+ * @return network index if successful, -1 on failure
  */
-static void extract_ssid(const char *line, char *ssid, size_t ssid_len)
+static int parse_scan_result_line(const char *line, char *ssid_out, size_t ssid_len)
 {
-    const char *ch_marker = strstr(line, ", CH");
-    if (ch_marker && ssid_len > 0) {
-        size_t len = ch_marker - line;
-        if (len >= ssid_len) len = ssid_len - 1;
-        strncpy(ssid, line, len);
-        ssid[len] = '\0';
-    } else if (ssid_len > 0) {
-        strncpy(ssid, line, ssid_len - 1);
-        ssid[ssid_len - 1] = '\0';
-    }
-}
+    janos_scan_row_t row;
+    if (!janos_parse_scan_row(line, &row) || !row.ssid.quoted || row.id <= 0) return -1;
 
-/**
- * @brief Extract MAC address from line (skip leading whitespace)
- */
-static void extract_mac(const char *line, char *mac, size_t mac_len)
-{
-    const char *p = line;
-    
-    // Skip leading whitespace
-    while (*p == ' ') p++;
-    
-    // Copy MAC (17 chars)
-    if (mac_len > 17) {
-        strncpy(mac, p, 17);
-        mac[17] = '\0';
-    } else if (mac_len > 0) {
-        strncpy(mac, p, mac_len - 1);
-        mac[mac_len - 1] = '\0';
-    }
+    csv_field_copy(&row.ssid, ssid_out, ssid_len);
+    return row.id;
 }
 
 /**
- * @brief Check if line is a scan result CSV line
- * Format: "1","SSID","","BSSID","CH","Security","RSSI","Band"
+ * @brief Execute deauth sequence after finding network index
  */
-static bool is_scan_result_line(const char *line)
-{
-    // Must start with a quote and digit
-    if (line[0] != '"') return false;
-    if (!isdigit((unsigned char)line[1])) return false;
-    return true;
-}
-
 /**
- * @brief Parse scan result CSV line and extract index and SSID
- * Format: "1","SSID","","BSSID","CH","Security","RSSI","Band"
- * @return network index if successful, -1 on failure
+ * @brief Aggregated acknowledgement of the deauth sequence (UART RX task)
  */
-static int parse_scan_result_line(const char *line, char *ssid_out, size_t ssid_len)
+static void on_deauth_acked(uart_request_status_t status, void *user_data)
 {
-    if (!is_scan_result_line(line)) return -1;
-    
-    // Parse index (first quoted field)
-    const char *p = line + 1;  // Skip opening quote
-    int index = atoi(p);
-    if (index <= 0) return -1;
-    
-    // Find second quoted field (SSID)
-    // Skip to first comma after index
-    p = strchr(p, ',');
-    if (!p) return -1;
-    p++;  // Skip comma
-    
-    // Skip opening quote of SSID field
-    if (*p != '"') return -1;
-    p++;
-    
-    // Find closing quote of SSID
-    const char *ssid_end = strchr(p, '"');
-    if (!ssid_end) return -1;
-    
-    // Copy SSID
-    size_t len = ssid_end - p;
-    if (len >= ssid_len) len = ssid_len - 1;
-    strncpy(ssid_out, p, len);
-    ssid_out[len] = '\0';
-    
-    return index;
+    (void)user_data;
+    if (status == UART_REQUEST_TIMEOUT) {
+        ESP_LOGW(TAG, "Deauth sequence not acknowledged by JanOS");
+    }
 }
 
-/**
- * @brief Execute deauth sequence after finding network index
- */
 static void execute_deauth_sequence(sniffer_results_data_t *data, int network_index)
 {
     ESP_LOGI(TAG, "Executing deauth: network=%d, station=%s", network_index, data->deauth_mac);
     
-    // Send stop first
-    uart_send_command("stop");
-    
-    // Select the network by index
+    // Stop, select network and station, start - in one write so JanOS
+    // never sits with only part of the selection applied
     char select_net_cmd[32];
     snprintf(select_net_cmd, sizeof(select_net_cmd), "select_networks %d", network_index);
-    uart_send_command(select_net_cmd);
-    
-    // Select the station
     char select_sta_cmd[64];
     snprintf(select_sta_cmd, sizeof(select_sta_cmd), "select_stations %s", data->deauth_mac);
-    uart_send_command(select_sta_cmd);
-    
-    // Start deauth
-    uart_send_command("start_deauth");
+    const char *const sequence[] = { "stop", select_net_cmd, select_sta_cmd, "start_deauth" };
+    uart_send_batch(sequence, 4, on_deauth_acked, NULL);
     buzzer_beep_attack();
     
     // Create params for station deauth screen
@@ -221,14 +175,18 @@ static void execute_deauth_sequence(sniffer_results_data_t *data, int network_in
         data->pending_deauth = false;
         
         // Push deauth screen
-        screen_manager_push(station_deauth_screen_create, params);
+        if (screen_manager_push(station_deauth_screen_create, params) == ESP_ERR_NO_MEM) free(params);
     } else {
         data->pending_deauth = false;
     }
 }
 
 /**
- * @brief UART line callback for parsing results
+ * @brief UART line callback: deauth lookups, and the end of loading
+ *
+ * world_model files the listing in station_store; only clients the store
+ * does not have yet change it, so a refresh costs nothing for what is
+ * already shown.
  */
 static void uart_line_callback(const char *line, void *user_data)
 {
@@ -265,9 +223,6 @@ static void uart_line_callback(const char *line, void *user_data)
         return;
     }
     
-    // Normal sniffer results parsing
-    if (data->line_count >= MAX_LINES) return;
-    
     // Check for "no results" message
     if (is_no_results_line(line)) {
         data->loading = false;
@@ -275,33 +230,111 @@ static void uart_line_callback(const char *line, void *user_data)
         return;
     }
     
-    // Check if it's an SSID line
-    if (is_ssid_line(line)) {
-        // Extract and store current SSID for following MAC lines
-        extract_ssid(line, data->current_ssid, MAX_SSID_LEN);
-        
-        // Store line
-        strncpy(data->lines[data->line_count], line, MAX_LINE_LEN - 1);
-        data->lines[data->line_count][MAX_LINE_LEN - 1] = '\0';
-        // SSID lines don't have a parent SSID
-        data->parent_ssid[data->line_count][0] = '\0';
-        data->line_count++;
+    if (is_ssid_line(line) || is_mac_line(line)) {
         data->loading = false;
-        data->needs_redraw = true;
     }
-    // Check if it's a MAC line
-    else if (is_mac_line(line)) {
-        // Store line
-        strncpy(data->lines[data->line_count], line, MAX_LINE_LEN - 1);
-        data->lines[data->line_count][MAX_LINE_LEN - 1] = '\0';
-        // Store parent SSID for this MAC
-        strncpy(data->parent_ssid[data->line_count], data->current_ssid, MAX_SSID_LEN - 1);
-        data->parent_ssid[data->line_count][MAX_SSID_LEN - 1] = '\0';
-        data->line_count++;
-        data->loading = false;
-        data->needs_redraw = true;
+}
+
+/**
+ * @brief Rebuild the flattened rows: APs by client count, each followed by its clients
+ *
+ * The selection stays on the same AP or client.
+ */
+static void rebuild_rows(sniffer_results_data_t *data)
+{
+    uint16_t selected = data->selected_index < data->row_count ?
+                        data->rows[data->selected_index] : NO_ROW;
+
+    data->rows_generation = station_store_generation();
+
+    uint16_t order[STATION_STORE_APS];
+    uint16_t clients[STATION_STORE_APS];
+    int ap_count = 0;
+    int slots = station_store_ap_slots();
+    for (int a = 0; a < slots; a++) {
+        station_ap_t ap;
+        if (!station_store_ap_get(a, &ap)) continue;
+
+        // Insertion sort, stable: ties keep slot order
+        int j = ap_count++;
+        while (j > 0 && clients[j - 1] < ap.clients) {
+            order[j] = order[j - 1];
+            clients[j] = clients[j - 1];
+            j--;
+        }
+        order[j] = (uint16_t)a;
+        clients[j] = ap.clients;
+    }
+
+    int n = 0;
+    int new_clients = 0;
+    for (int i = 0; i < ap_count && n < MAX_ROWS; i++) {
+        data->rows[n++] = ROW_AP | order[i];
+        int first = n;
+        n += station_store_clients_of(order[i], &data->rows[n], MAX_ROWS - n);
+        for (int r = first; r < n && data->new_since_us; r++) {
+            station_record_t sta;
+            if (station_store_get(data->rows[r], &sta) && sta.first_us >= data->new_since_us) {
+                new_clients++;
+            }
+        }
+    }
+    data->row_count = n;
+    data->ap_count = ap_count;
+    data->client_count = n - ap_count;
+    data->new_clients = new_clients;
+    if (n > 0) data->loading = false;
+
+    data->selected_index = fixed_index_find(data->rows, n, selected);
+    if (data->selected_index < 0) data->selected_index = 0;
+    if (data->selected_index < data->scroll_offset ||
+        data->selected_index >= data->scroll_offset + VISIBLE_ROWS) {
+        data->scroll_offset = (data->selected_index / VISIBLE_ROWS) * VISIBLE_ROWS;
     }
-    // Ignore all other lines
+}
+
+/**
+ * @brief Text of one row (built only for rows on screen)
+ */
+static void format_row(sniffer_results_data_t *data, uint16_t row, char *out, size_t len)
+{
+    if (row & ROW_AP) {
+        station_ap_t ap;
+        if (!station_store_ap_get(row & ~ROW_AP, &ap)) {
+            snprintf(out, len, "(gone)");
+            return;
+        }
+        snprintf(out, len, "%s, CH%u: %u", ap.ssid, ap.channel, ap.clients);
+        return;
+    }
+
+    station_record_t sta;
+    if (!station_store_get(row, &sta)) {
+        snprintf(out, len, " (gone)");
+        return;
+    }
+    char mac[18];
+    network_format_bssid(sta.mac, mac, sizeof(mac));
+    const char *vendor = oui_lookup_str(mac);
+    bool is_new = data->new_since_us && sta.first_us >= data->new_since_us;
+    snprintf(out, len, "%c%s %s", is_new ? '+' : ' ', mac, vendor ? vendor : "");
+}
+
+static void draw_row(sniffer_results_data_t *data, int row_idx)
+{
+    int i = row_idx - data->scroll_offset;
+    if (i < 0 || i >= VISIBLE_ROWS || row_idx >= data->row_count) return;
+
+    uint16_t row = data->rows[row_idx];
+    bool is_selected = (row_idx == data->selected_index);
+    bool is_mac = !(row & ROW_AP);
+    uint16_t color = is_selected ? UI_COLOR_SELECTED : (is_mac ? UI_COLOR_DIMMED : UI_COLOR_HIGHLIGHT);
+
+    // Build display string with selection indicator
+    char display[UI_COLS + 1];
+    display[0] = is_selected ? '>' : ' ';
+    format_row(data, row, display + 1, sizeof(display) - 1);
+    ui_print(0, 1 + i, display, color);
 }
 
 static void draw_screen(screen_t *self)
@@ -309,69 +342,66 @@ static void draw_screen(screen_t *self)
     sniffer_results_data_t *data = (sniffer_results_data_t *)self->user_data;
     
     ui_clear();
+    data->draw_time_us = esp_timer_get_time();
     
     // Draw title
-    ui_draw_title("Sniffer Results");
+    char title[32];
+    if (data->new_clients > 0) {
+        snprintf(title, sizeof(title), "Sniffer %d/%d +%d",
+                 data->ap_count, data->client_count, data->new_clients);
+    } else if (data->row_count > 0) {
+        snprintf(title, sizeof(title), "Sniffer %d/%d", data->ap_count, data->client_count);
+    } else {
+        snprintf(title, sizeof(title), "Sniffer Results");
+    }
+    ui_draw_title(title);
     
     if (data->loading) {
         ui_print_center(3, "Loading...", UI_COLOR_DIMMED);
-    } else if (data->line_count == 0) {
+    } else if (data->row_count == 0) {
         ui_print_center(3, "No results", UI_COLOR_DIMMED);
     } else {
-        // Draw visible lines
-        int visible_rows = 6;
-        int start_row = 1;
-        
-        for (int i = 0; i < visible_rows; i++) {
-            int line_idx = data->scroll_offset + i;
-            
-            if (line_idx < data->line_count) {
-                const char *line = data->lines[line_idx];
-                bool is_selected = (line_idx == data->selected_index);
-                bool is_mac = (line[0] == ' ');
-                uint16_t color;
-                
-                // Determine color based on selection and type
-                if (is_selected) {
-                    color = UI_COLOR_SELECTED;
-                } else if (is_mac) {
-                    color = UI_COLOR_DIMMED;
-                } else {
-                    color = UI_COLOR_HIGHLIGHT;
-                }
-                
-                // Build display string with selection indicator
-                char display[31];
-                if (is_selected) {
-                    display[0] = '>';
-                    strncpy(display + 1, line, 29);
-                    display[30] = '\0';
-                } else {
-                    display[0] = ' ';
-                    strncpy(display + 1, line, 29);
-                    display[30] = '\0';
-                }
-                
-                ui_print(0, start_row + i, display, color);
-            }
+        for (int i = 0; i < VISIBLE_ROWS; i++) {
+            draw_row(data, data->scroll_offset + i);
         }
         
         // Scroll indicators
         if (data->scroll_offset > 0) {
             ui_print(UI_COLS - 2, 1, "^", UI_COLOR_DIMMED);
         }
-        if (data->scroll_offset + visible_rows < data->line_count) {
-            ui_print(UI_COLS - 2, visible_rows, "v", UI_COLOR_DIMMED);
+        if (data->scroll_offset + VISIBLE_ROWS < data->row_count) {
+            ui_print(UI_COLS - 2, VISIBLE_ROWS, "v", UI_COLOR_DIMMED);
         }
     }
     
     // Draw status bar
-    ui_draw_status("UP/DN:Sel D:Deauth ESC:Back");
+    ui_draw_status("UP/DN:Sel D:Deauth R:Refresh");
+}
+
+static void request_results(sniffer_results_data_t *data)
+{
+    data->refresh_time_us = esp_timer_get_time();
+    // Clients first listed by a refresh are marked new
+    if (++data->passes == 2) data->new_since_us = time_sync_now_us();
+    uart_send_command("show_sniffer_results");
 }
 
 static void on_tick(screen_t *self)
 {
     sniffer_results_data_t *data = (sniffer_results_data_t *)self->user_data;
+    int64_t now = esp_timer_get_time();
+    
+    // Pick up new clients while the sniffer keeps running
+    if (!data->pending_deauth && now - data->refresh_time_us >= AUTO_REFRESH_US) {
+        request_results(data);
+    }
+    
+    station_store_expire();
+    if (station_store_generation() != data->rows_generation &&
+        now - data->draw_time_us >= REDRAW_INTERVAL_US) {
+        rebuild_rows(data);
+        data->needs_redraw = true;
+    }
     
     // Check if redraw needed from UART callback (thread-safe)
     if (data->needs_redraw) {
@@ -383,116 +413,101 @@ static void on_tick(screen_t *self)
 static void on_key(screen_t *self, key_code_t key)
 {
     sniffer_results_data_t *data = (sniffer_results_data_t *)self->user_data;
-    int visible_rows = 6;
     
     switch (key) {
         case KEY_UP:
             if (data->selected_index > 0) {
-                int old_idx = data->selected_index;
                 // Check if at first visible item on page - do page jump
                 if (data->selected_index == data->scroll_offset && data->scroll_offset > 0) {
-                    data->scroll_offset -= visible_rows;
+                    data->scroll_offset -= VISIBLE_ROWS;
                     if (data->scroll_offset < 0) data->scroll_offset = 0;
-                    data->selected_index = data->scroll_offset + visible_rows - 1;
-                    if (data->selected_index >= data->line_count) {
-                        data->selected_index = data->line_count - 1;
+                    data->selected_index = data->scroll_offset + VISIBLE_ROWS - 1;
+                    if (data->selected_index >= data->row_count) {
+                        data->selected_index = data->row_count - 1;
                     }
                     draw_screen(self);  // Full redraw on page jump
                 } else {
-                    data->selected_index--;
                     // Redraw only 2 rows
-                    int start_row = 1;
-                    for (int idx = old_idx; idx >= data->selected_index; idx--) {
-                        int i = idx - data->scroll_offset;
-                        if (i >= 0 && i < visible_rows && idx < data->line_count) {
-                            const char *line = data->lines[idx];
-                            bool is_selected = (idx == data->selected_index);
-                            bool is_mac = (line[0] == ' ');
-                            uint16_t color = is_selected ? UI_COLOR_SELECTED : (is_mac ? UI_COLOR_DIMMED : UI_COLOR_HIGHLIGHT);
-                            char display[31];
-                            display[0] = is_selected ? '>' : ' ';
-                            strncpy(display + 1, line, 29);
-                            display[30] = '\0';
-                            ui_print(0, start_row + i, display, color);
-                        }
-                    }
+                    data->selected_index--;
+                    draw_row(data, data->selected_index + 1);
+                    draw_row(data, data->selected_index);
                 }
-            } else if (data->line_count > 0) {
-                data->selected_index = data->line_count - 1;
-                data->scroll_offset = (data->selected_index / visible_rows) * visible_rows;
+            } else if (data->row_count > 0) {
+                data->selected_index = data->row_count - 1;
+                data->scroll_offset = (data->selected_index / VISIBLE_ROWS) * VISIBLE_ROWS;
                 draw_screen(self);
             }
             break;
             
         case KEY_DOWN:
-            if (data->selected_index < data->line_count - 1) {
-                int old_idx = data->selected_index;
+            if (data->selected_index < data->row_count - 1) {
                 // Check if at last visible item on page - do page jump
-                if (data->selected_index == data->scroll_offset + visible_rows - 1) {
+                if (data->selected_index == data->scroll_offset + VISIBLE_ROWS - 1) {
                     // Jump to next page - don't adjust back for partial pages
-                    data->scroll_offset += visible_rows;
+                    data->scroll_offset += VISIBLE_ROWS;
                     data->selected_index = data->scroll_offset;
                     draw_screen(self);  // Full redraw on page jump
                 } else {
-                    data->selected_index++;
                     // Redraw only 2 rows
-                    int start_row = 1;
-                    for (int idx = old_idx; idx <= data->selected_index; idx++) {
-                        int i = idx - data->scroll_offset;
-                        if (i >= 0 && i < visible_rows && idx < data->line_count) {
-                            const char *line = data->lines[idx];
-                            bool is_selected = (idx == data->selected_index);
-                            bool is_mac = (line[0] == ' ');
-                            uint16_t color = is_selected ? UI_COLOR_SELECTED : (is_mac ? UI_COLOR_DIMMED : UI_COLOR_HIGHLIGHT);
-                            char display[31];
-                            display[0] = is_selected ? '>' : ' ';
-                            strncpy(display + 1, line, 29);
-                            display[30] = '\0';
-                            ui_print(0, start_row + i, display, color);
-                        }
-                    }
+                    data->selected_index++;
+                    draw_row(data, data->selected_index - 1);
+                    draw_row(data, data->selected_index);
                 }
-            } else if (data->line_count > 0) {
+            } else if (data->row_count > 0) {
                 data->selected_index = 0;
                 data->scroll_offset = 0;
                 draw_screen(self);
             }
             break;
             
+        case KEY_R:
+            if (!data->pending_deauth) {
+                request_results(data);
+            }
+            break;
+            
         case KEY_D:
-            // Check if selected line is a MAC (client) line
-            if (data->line_count > 0 && data->selected_index < data->line_count) {
-                const char *line = data->lines[data->selected_index];
+            // Check if selected row is a client
+            if (data->row_count > 0 && data->selected_index < data->row_count) {
+                uint16_t row = data->rows[data->selected_index];
+                if (row & ROW_AP) break;
                 
-                // MAC lines start with space (indented)
-                if (line[0] == ' ' && is_mac_line(line)) {
-                    // Extract MAC address
-                    char mac[18];
-                    extract_mac(line, mac, sizeof(mac));
-                    
-                    // Get parent SSID
-                    const char *ssid = data->parent_ssid[data->selected_index];
-                    
-                    // Check if we have a valid SSID
-                    if (ssid[0] == '\0') {
-                        ESP_LOGW(TAG, "No parent SSID for MAC %s", mac);
-                        break;
-                    }
-                    
-                    ESP_LOGI(TAG, "Initiating deauth on station: %s from network: %s", mac, ssid);
-                    
-                    // Store deauth target info
-                    strncpy(data->deauth_mac, mac, sizeof(data->deauth_mac) - 1);
-                    data->deauth_mac[sizeof(data->deauth_mac) - 1] = '\0';
-                    strncpy(data->deauth_ssid, ssid, sizeof(data->deauth_ssid) - 1);
-                    data->deauth_ssid[sizeof(data->deauth_ssid) - 1] = '\0';
-                    
-                    // Set pending state and request scan results to find network index
-                    data->pending_deauth = true;
-                    uart_send_command("show_scan_results");
-                    
-                    ESP_LOGI(TAG, "Waiting for scan results to find network index...");
+                station_record_t sta;
+                station_ap_t ap;
+                if (!station_store_get(row, &sta) || sta.ap == STATION_NONE ||
+                    !station_store_ap_get(sta.ap, &ap)) {
+                    break;
+                }
+                char mac[18];
+                network_format_bssid(sta.mac, mac, sizeof(mac));
+                const char *ssid = ap.ssid;
+                
+                // Check if we have a valid SSID
+                if (ssid[0] == '\0') {
+                    ESP_LOGW(TAG, "No parent SSID for MAC %s", mac);
+                    break;
+                }
+                
+                ESP_LOGI(TAG, "Initiating deauth on station: %s from network: %s", mac, ssid);
+                
+                // Store deauth target info
+                strncpy(data->deauth_mac, mac, sizeof(data->deauth_mac) - 1);
+                data->deauth_mac[sizeof(data->deauth_mac) - 1] = '\0';
+                strncpy(data->deauth_ssid, ssid, sizeof(data->deauth_ssid) - 1);
+                data->deauth_ssid[sizeof(data->deauth_ssid) - 1] = '\0';
+                
+                // Known from an earlier scan: no need to dump the results again
+                int rec = station_store_network(sta.ap);
+                if (rec >= 0) {
+                    execute_deauth_sequence(data, network_store_record(rec)->id);
+                    break;
                 }
+                
+                // Set pending state and request scan results to find network index
+                data->pending_deauth = true;
+                uart_send_command("show_scan_results");
+                
+                ESP_LOGI(TAG, "Waiting for scan results to find network index...");
             }
             break;
             
@@ -507,16 +522,14 @@ static void on_key(screen_t *self, key_code_t key)
     }
 }
 
-static void on_destroy(screen_t *self)
+static void on_resume(screen_t *self)
 {
     sniffer_results_data_t *data = (sniffer_results_data_t *)self->user_data;
     
-    // Clear UART callback
-    uart_clear_line_callback();
-    
-    if (data) {
-        free(data);
-    }
+    // Back from a deauth: the line callback is ours again, catch up
+    data->pending_deauth = false;
+    request_results(data);
+    draw_screen(self);
 }
 
 screen_t* sniffer_results_screen_create(void *params)
@@ -530,12 +543,16 @@ screen_t* sniffer_results_screen_create(void *params)
         return NULL;
     }
     
-    // Allocate user data
-    sniffer_results_data_t *data = calloc(1, sizeof(sniffer_results_data_t));
+    // Allocate user data from the screen arena
+    sniffer_results_data_t *data = screen_arena_alloc(sizeof(sniffer_results_data_t));
     if (!data) {
         free(screen);
         return NULL;
     }
+    if (station_store_init() != ESP_OK) {
+        free(screen);
+        return NULL;
+    }
     
     data->loading = true;
     data->selected_index = 0;
@@ -543,15 +560,17 @@ screen_t* sniffer_results_screen_create(void *params)
     
     screen->user_data = data;
     screen->on_key = on_key;
-    screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
     screen->on_tick = on_tick;
+    screen->on_resume = on_resume;
+    screen->tick_on_uart = true;    // on_tick is time-based, extra ticks are harmless
     
     // Register UART callback
-    uart_register_line_callback(uart_line_callback, data);
+    screen_set_line_callback(screen, uart_line_callback, data);
     
-    // Send command to get results
-    uart_send_command("show_sniffer_results");
+    // Show what the store kept, then ask for more (repeated from on_tick)
+    rebuild_rows(data);
+    request_results(data);
     
     // Draw initial screen
     draw_screen(screen);
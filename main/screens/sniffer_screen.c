@@ -7,6 +7,8 @@
 #include "sniffer_results_screen.h"
 #include "sniffer_probes_screen.h"
 #include "uart_handler.h"
+#include "job_manager.h"
+#include "world_model.h"
 #include "text_ui.h"
 #include "buzzer.h"
 #include "esp_log.h"
@@ -20,35 +22,10 @@ typedef struct {
     wifi_network_t *networks;
     int count;
     int packet_count;
-    bool needs_redraw;
+    uint32_t report_seq;        // Last world_model packet report seen
     screen_t *self;
 } sniffer_screen_data_t;
 
-// Forward declaration
-static void draw_screen(screen_t *self);
-
-
-/**
- * @brief UART line callback for parsing sniffer output
- */
-static void uart_line_callback(const char *line, void *user_data)
-{
-    sniffer_screen_data_t *data = (sniffer_screen_data_t *)user_data;
-    if (!data) return;
-    
-    // Parse: "Sniffer packet count: N"
-    const char *marker = "Sniffer packet count: ";
-    const char *found = strstr(line, marker);
-    
-    if (found) {
-        int count = atoi(found + strlen(marker));
-        if (count != data->packet_count) {
-            data->packet_count = count;
-            data->needs_redraw = true;
-        }
-    }
-}
-
 static void draw_screen(screen_t *self)
 {
     sniffer_screen_data_t *data = (sniffer_screen_data_t *)self->user_data;
@@ -67,17 +44,22 @@ static void draw_screen(screen_t *self)
     ui_print_center(5, "R: Results  P: Probes", UI_COLOR_TEXT);
     
     // Draw status bar
-    ui_draw_status("ESC: Stop");
+    ui_draw_status("ESC: Stop  B: Background");
 }
 
 static void on_tick(screen_t *self)
 {
     sniffer_screen_data_t *data = (sniffer_screen_data_t *)self->user_data;
     
-    // Check if redraw needed from UART callback (thread-safe)
-    if (data->needs_redraw) {
-        data->needs_redraw = false;
-        draw_screen(self);
+    // Redraw when world_model has a new packet count
+    uint32_t seq;
+    int count = world_model_sniffer_packets(&seq);
+    if (seq != data->report_seq) {
+        data->report_seq = seq;
+        if (count != data->packet_count) {
+            data->packet_count = count;
+            draw_screen(self);
+        }
     }
 }
 
@@ -98,6 +80,11 @@ static void on_key(screen_t *self, key_code_t key)
             screen_manager_push(sniffer_probes_screen_create, NULL);
             break;
             
+        case KEY_B:
+            // Keep sniffing while other views are open
+            job_manager_background(JOB_SNIFFER, self);
+            break;
+            
         case KEY_ESC:
         case KEY_Q:
         case KEY_BACKSPACE:
@@ -115,9 +102,6 @@ static void on_destroy(screen_t *self)
 {
     sniffer_screen_data_t *data = (sniffer_screen_data_t *)self->user_data;
     
-    // Clear UART callback
-    uart_clear_line_callback();
-    
     if (data) {
         if (data->networks) {
             free(data->networks);
@@ -128,11 +112,6 @@ static void on_destroy(screen_t *self)
 
 static void on_resume(screen_t *self)
 {
-    sniffer_screen_data_t *data = (sniffer_screen_data_t *)self->user_data;
-    
-    // Re-register UART callback after returning from sub-screens
-    uart_register_line_callback(uart_line_callback, data);
-    
     // Resume sniffer with selected networks
     uart_send_command("start_sniffer");
     
@@ -171,6 +150,7 @@ screen_t* sniffer_screen_create(void *params)
     data->networks = sn_params->networks;
     data->count = sn_params->count;
     data->self = screen;
+    world_model_sniffer_packets(&data->report_seq);    // Counts from earlier runs are not ours
     free(sn_params);
     
     screen->user_data = data;
@@ -180,9 +160,6 @@ screen_t* sniffer_screen_create(void *params)
     screen->on_draw = draw_screen;
     screen->on_tick = on_tick;
     
-    // Register UART callback for parsing sniffer output
-    uart_register_line_callback(uart_line_callback, data);
-    
     // Draw initial screen
     draw_screen(screen);
     
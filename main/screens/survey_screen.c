@@ -0,0 +1,173 @@
+/**
+ * @file survey_screen.c
+ * @brief Units of the ESP-NOW survey and what they contributed
+ *
+ * On a coordinator, one row per satellite heard: frames, records merged
+ * and frames lost from its sequence, with the time since it was last
+ * heard. The merged networks themselves are in the network store, so
+ * the WiFi list and channel views show them. On a satellite, the send
+ * counters. Redrawn only when the link counters move.
+ */
+
+#include "survey_screen.h"
+#include "screen_registry.h"
+#include "survey_link.h"
+#include "network_store.h"
+#include "text_ui.h"
+#include "ui_list.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "SURVEY_SCR";
+
+// Screen user data
+typedef struct {
+    ui_list_t list;
+    survey_unit_t units[SURVEY_MAX_UNITS];
+    survey_stats_t stats;
+    uint32_t drawn_s;           // Uptime second of the last draw (ages in rows)
+} survey_data_t;
+
+static void unit_row(int index, char *text, size_t len, void *user_data)
+{
+    survey_data_t *data = (survey_data_t *)user_data;
+    const survey_unit_t *u = &data->units[index];
+    uint32_t age_s = (uint32_t)(esp_timer_get_time() / 1000 - u->last_ms) / 1000;
+    
+    snprintf(text, len, "%02X%02X%02X %4lur %3lum %3lus", u->mac[3], u->mac[4], u->mac[5],
+             (unsigned long)u->records, (unsigned long)u->lost, (unsigned long)age_s);
+}
+
+static void load(survey_data_t *data)
+{
+    survey_link_get_stats(&data->stats);
+    int count = survey_link_units(data->units, SURVEY_MAX_UNITS);
+    ui_list_set_count(&data->list, count);
+    data->drawn_s = (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+static void draw_satellite(const survey_data_t *data)
+{
+    char line[UI_COLS + 1];
+    snprintf(line, sizeof(line), "Satellite, channel %d", SURVEY_LINK_CHANNEL);
+    ui_print_center(2, line, UI_COLOR_TEXT);
+    snprintf(line, sizeof(line), "%lu frames, %lu records",
+             (unsigned long)data->stats.frames_sent, (unsigned long)data->stats.records_sent);
+    ui_print_center(3, line, UI_COLOR_TEXT);
+    snprintf(line, sizeof(line), "%lu send errors", (unsigned long)data->stats.send_errors);
+    ui_print_center(4, line, data->stats.send_errors ? UI_COLOR_DIMMED : UI_COLOR_TEXT);
+}
+
+static void draw_screen(screen_t *self)
+{
+    survey_data_t *data = (survey_data_t *)self->user_data;
+    survey_role_t role = survey_link_role();
+    
+    ui_clear();
+    char title[32];
+    if (role == SURVEY_ROLE_COORDINATOR) {
+        snprintf(title, sizeof(title), "Survey: %d units %d APs", data->list.count,
+                 network_store_count());
+    } else {
+        snprintf(title, sizeof(title), "Survey link");
+    }
+    ui_draw_title(title);
+    
+    if (role == SURVEY_ROLE_SATELLITE) {
+        draw_satellite(data);
+    } else if (role == SURVEY_ROLE_OFF) {
+        ui_print_center(ui_rows() / 2 - 1, "Survey link off", UI_COLOR_DIMMED);
+    } else if (data->list.count == 0) {
+        ui_print_center(ui_rows() / 2 - 1, "No satellites heard", UI_COLOR_DIMMED);
+    } else {
+        ui_list_draw(&data->list);
+    }
+    
+    char status[UI_COLS + 1];
+    if (role == SURVEY_ROLE_COORDINATOR) {
+        snprintf(status, sizeof(status), "Merged %lu drop %lu",
+                 (unsigned long)data->stats.records_merged,
+                 (unsigned long)data->stats.frames_dropped);
+    } else {
+        snprintf(status, sizeof(status), "ESC:Back");
+    }
+    ui_draw_status(status);
+}
+
+static void on_tick(screen_t *self)
+{
+    survey_data_t *data = (survey_data_t *)self->user_data;
+    
+    survey_stats_t stats;
+    survey_link_get_stats(&stats);
+    uint32_t now_s = (uint32_t)(esp_timer_get_time() / 1000000);
+    if (memcmp(&stats, &data->stats, sizeof(stats)) == 0 && now_s == data->drawn_s) return;
+    load(data);
+    draw_screen(self);
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    survey_data_t *data = (survey_data_t *)self->user_data;
+    
+    if (ui_list_handle_key(&data->list, key)) {
+        ui_list_draw(&data->list);
+        return;
+    }
+    
+    switch (key) {
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    free(self->user_data);
+}
+
+static void on_resume(screen_t *self)
+{
+    draw_screen(self);
+}
+
+screen_t* survey_screen_create(void *params)
+{
+    (void)params;
+    
+    ESP_LOGI(TAG, "Creating survey screen...");
+    
+    screen_t *screen = screen_alloc();
+    survey_data_t *data = screen ? calloc(1, sizeof(survey_data_t)) : NULL;
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    ui_list_init(&data->list, 1, UI_LIST_MAX_ROWS, unit_row, data);
+    load(data);
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_resume = on_resume;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "Survey screen created");
+    return screen;
+}
+
+#ifdef CONFIG_SURVEY_LINK
+SCREEN_REGISTER(HOME, 17, survey_screen_create, 0, "Survey Units", NULL);
+#endif
@@ -0,0 +1,18 @@
+/**
+ * @file survey_screen.h
+ * @brief Units of the ESP-NOW survey and what they contributed
+ */
+
+#ifndef SURVEY_SCREEN_H
+#define SURVEY_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the survey screen
+ * @param params Unused
+ * @return Created screen or NULL on failure
+ */
+screen_t* survey_screen_create(void *params);
+
+#endif // SURVEY_SCREEN_H
@@ -0,0 +1,424 @@
+/**
+ * @file terminal_screen.c
+ * @brief Raw JanOS output with scrollback, search and a command prompt
+ *
+ * Shows the uart_handler scrollback, which records every received line
+ * whether or not this screen is open. The view follows new lines until
+ * scrolled back; it then stays on the same lines (they are numbered)
+ * until Space returns to the live end or they drop out of the ring.
+ *
+ * Keys: Up/Down line, Left/Right page, Space live, Enter command prompt
+ * (Fn+Up/Down recall), F incremental search (newest match first), N next
+ * older match, C clear.
+ */
+
+#include "terminal_screen.h"
+#include "text_input_screen.h"
+#include "input_history.h"
+#include "uart_handler.h"
+#include "text_log.h"
+#include "text_ui.h"
+#include "keyboard.h"
+#include "keymap.h"
+#include "esp_log.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+static const char *TAG = "TERMINAL";
+
+#define HISTORY_KEY     "term"
+
+typedef enum {
+    MODE_VIEW = 0,
+    MODE_PROMPT,                // Typing a command
+    MODE_FIND,                  // Typing a search
+} term_mode_t;
+
+// Screen user data
+typedef struct {
+    text_log_t *log;
+    uint32_t bottom;            // Line on the last log row
+    bool follow;                // bottom tracks the newest line
+    uint32_t drawn_end;         // text_log_end() at the last log paint
+    uint32_t drawn_bottom;
+    term_mode_t mode;
+    char input[TEXT_INPUT_MAX_LEN + 1];
+    int input_len;
+    char query[TEXT_INPUT_MAX_LEN + 1];
+    bool has_match;
+    uint32_t match;
+    uint32_t find_origin;       // bottom when the search started
+    bool find_follow;           // ... and whether it was following
+    input_history_t history;
+    int history_pos;            // -1 = not recalling
+} terminal_data_t;
+
+static int log_rows(void)
+{
+    return ui_rows() - 2;
+}
+
+static void draw_row(terminal_data_t *data, int row, uint32_t n)
+{
+    char line[TEXT_LOG_LINE_MAX + 1];
+    char padded[UI_COLS_MAX + 1];
+    int cols = ui_cols();
+    
+    bool held = text_log_get(data->log, n, line, sizeof(line));
+    snprintf(padded, sizeof(padded), "%-*.*s", cols, cols, held ? line : "");
+    bool hit = data->has_match && n == data->match;
+    ui_print(0, 1 + row, padded, hit ? UI_COLOR_HIGHLIGHT : UI_COLOR_TEXT);
+}
+
+/**
+ * @brief Paint the log rows; only the new ones when following
+ */
+static void draw_log(terminal_data_t *data, bool full)
+{
+    int rows = log_rows();
+    uint32_t end = text_log_end(data->log);
+    uint32_t first = text_log_first(data->log);
+    
+    if (data->follow) {
+        data->bottom = end ? end - 1 : 0;
+    } else if (data->bottom < first) {
+        data->bottom = first;
+    }
+    
+    uint32_t moved = data->bottom - data->drawn_bottom;
+    if (!full && data->follow && moved > 0 && moved < (uint32_t)rows) {
+        ui_scroll_rows(1, rows, -(int)moved);
+        for (int r = rows - (int)moved; r < rows; r++) {
+            draw_row(data, r, data->bottom - (rows - 1 - r));
+        }
+    } else if (full || moved != 0) {
+        for (int r = 0; r < rows; r++) {
+            draw_row(data, r, data->bottom - (rows - 1 - r));
+        }
+    }
+    data->drawn_end = end;
+    data->drawn_bottom = data->bottom;
+}
+
+static void draw_title(terminal_data_t *data)
+{
+    char title[UI_COLS_MAX + 1];
+    uint32_t end = text_log_end(data->log);
+    if (data->follow || end == 0) {
+        snprintf(title, sizeof(title), "JanOS Terminal");
+    } else {
+        snprintf(title, sizeof(title), "JanOS Terminal  -%lu",
+                 (unsigned long)(end - 1 - data->bottom));
+    }
+    ui_draw_title(title);
+}
+
+static void draw_status(terminal_data_t *data)
+{
+    char status[UI_COLS + 1];
+    // Long input shows its tail, where the cursor is
+    const char *tail = data->input_len > UI_COLS - 4 ?
+        data->input + data->input_len - (UI_COLS - 4) : data->input;
+    
+    switch (data->mode) {
+        case MODE_PROMPT:
+            snprintf(status, sizeof(status), "> %s_", tail);
+            break;
+        case MODE_FIND:
+            snprintf(status, sizeof(status), "%s%s_",
+                     data->input_len && !data->has_match ? "?" : "/", tail);
+            break;
+        default:
+            snprintf(status, sizeof(status), "Ent:Cmd F:Find N:Next Spc:Live");
+            break;
+    }
+    ui_draw_status(status);
+}
+
+static void draw_screen(screen_t *self)
+{
+    terminal_data_t *data = (terminal_data_t *)self->user_data;
+    
+    ui_clear();
+    draw_title(data);
+    if (!data->log) {
+        ui_print_center(ui_rows() / 2 - 1, "No scrollback memory", UI_COLOR_DIMMED);
+    } else {
+        draw_log(data, true);
+    }
+    draw_status(data);
+}
+
+static void scroll(terminal_data_t *data, int lines)
+{
+    uint32_t first = text_log_first(data->log);
+    uint32_t end = text_log_end(data->log);
+    if (end == 0) return;
+    
+    int64_t target = (int64_t)data->bottom + lines;
+    // Keep a full screen above the bottom line where there is one
+    int64_t lowest = (int64_t)first + log_rows() - 1;
+    if (lowest > (int64_t)end - 1) lowest = end - 1;
+    if (target < lowest) target = lowest;
+    data->follow = target >= (int64_t)end - 1;
+    data->bottom = data->follow ? end - 1 : (uint32_t)target;
+    
+    draw_title(data);
+    draw_log(data, false);
+}
+
+/**
+ * @brief Jump to the newest match at or above from
+ */
+static void find_from(terminal_data_t *data, uint32_t from)
+{
+    uint32_t found;
+    data->has_match = text_log_find(data->log, from, data->query, true, &found);
+    if (data->has_match) {
+        data->match = found;
+        data->follow = false;
+        data->bottom = found;
+        if (data->bottom < text_log_first(data->log) + log_rows() - 1) {
+            data->bottom = text_log_first(data->log) + log_rows() - 1;
+        }
+        if (data->bottom >= text_log_end(data->log)) {
+            data->bottom = text_log_end(data->log) - 1;
+        }
+    }
+    draw_title(data);
+    draw_log(data, true);
+}
+
+static void start_input(terminal_data_t *data, term_mode_t mode)
+{
+    data->mode = mode;
+    data->input[0] = '\0';
+    data->input_len = 0;
+    data->history_pos = -1;
+    if (mode == MODE_FIND) {
+        data->find_origin = data->bottom;
+        data->find_follow = data->follow;
+    }
+    // , ; . / type characters; arrows need Fn
+    keyboard_set_text_input_mode(true);
+    draw_status(data);
+}
+
+static void end_input(terminal_data_t *data)
+{
+    data->mode = MODE_VIEW;
+    keyboard_set_text_input_mode(false);
+    draw_status(data);
+}
+
+static void set_input(terminal_data_t *data, const char *text)
+{
+    strlcpy(data->input, text, sizeof(data->input));
+    data->input_len = strlen(data->input);
+}
+
+static void input_changed(terminal_data_t *data)
+{
+    if (data->mode == MODE_FIND) {
+        strlcpy(data->query, data->input, sizeof(data->query));
+        if (data->input_len) {
+            find_from(data, data->find_origin);
+        } else {
+            data->has_match = false;
+            draw_log(data, true);
+        }
+    }
+    draw_status(data);
+}
+
+static void on_input_key(terminal_data_t *data, key_code_t key)
+{
+    switch (key) {
+        case KEY_ENTER:
+            if (data->mode == MODE_PROMPT && data->input_len) {
+                input_history_add(HISTORY_KEY, &data->history, data->input);
+                uart_send_command(data->input);
+                data->follow = true;
+                draw_title(data);
+                draw_log(data, false);
+            }
+            end_input(data);
+            break;
+            
+        case KEY_ESC:
+            if (data->mode == MODE_FIND) {
+                // Back to where the search started
+                data->has_match = false;
+                data->bottom = data->find_origin;
+                data->follow = data->find_follow;
+                draw_title(data);
+                draw_log(data, true);
+            }
+            end_input(data);
+            break;
+            
+        case KEY_UP:
+        case KEY_DOWN: {
+            if (data->mode != MODE_PROMPT) break;
+            int pos = data->history_pos + (key == KEY_UP ? 1 : -1);
+            const char *entry = pos >= 0 ? input_history_get(&data->history, pos) : "";
+            if (entry) {
+                data->history_pos = pos < 0 ? -1 : pos;
+                set_input(data, entry);
+                draw_status(data);
+            }
+            break;
+        }
+            
+        case KEY_BACKSPACE:
+        case KEY_DEL:
+            if (data->input_len > 0) {
+                data->input[--data->input_len] = '\0';
+                input_changed(data);
+            }
+            break;
+            
+        default: {
+            char ch = keymap_char(key, keyboard_is_shift_held(), keyboard_is_capslock_held());
+            if (ch && data->input_len < TEXT_INPUT_MAX_LEN) {
+                data->input[data->input_len++] = ch;
+                data->input[data->input_len] = '\0';
+                data->history_pos = -1;
+                input_changed(data);
+            }
+            break;
+        }
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    terminal_data_t *data = (terminal_data_t *)self->user_data;
+    
+    if (!data->log) {
+        if (key == KEY_ESC || key == KEY_Q || key == KEY_BACKSPACE) {
+            screen_manager_pop();
+        }
+        return;
+    }
+    if (data->mode != MODE_VIEW) {
+        on_input_key(data, key);
+        return;
+    }
+    
+    switch (key) {
+        case KEY_UP:
+            scroll(data, -1);
+            break;
+            
+        case KEY_DOWN:
+            scroll(data, 1);
+            break;
+            
+        case KEY_LEFT:
+            scroll(data, -(log_rows() - 1));
+            break;
+            
+        case KEY_RIGHT:
+            scroll(data, log_rows() - 1);
+            break;
+            
+        case KEY_SPACE:
+            data->follow = true;
+            data->has_match = false;
+            draw_title(data);
+            draw_log(data, true);
+            break;
+            
+        case KEY_ENTER:
+            start_input(data, MODE_PROMPT);
+            break;
+            
+        case KEY_F:
+            start_input(data, MODE_FIND);
+            break;
+            
+        case KEY_N:
+            if (data->query[0] && data->has_match && data->match > 0) {
+                find_from(data, data->match - 1);
+            }
+            break;
+            
+        case KEY_C:
+            text_log_clear(data->log);
+            data->has_match = false;
+            data->follow = true;
+            draw_screen(self);
+            break;
+            
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_tick(screen_t *self)
+{
+    terminal_data_t *data = (terminal_data_t *)self->user_data;
+    
+    if (!data->log || text_log_end(data->log) == data->drawn_end) return;
+    if (data->follow) {
+        draw_log(data, false);
+    } else {
+        // Lines below the view arrived; the distance to live grew
+        data->drawn_end = text_log_end(data->log);
+        draw_title(data);
+    }
+}
+
+static void on_resume(screen_t *self)
+{
+    terminal_data_t *data = (terminal_data_t *)self->user_data;
+    if (data->mode != MODE_VIEW) {
+        keyboard_set_text_input_mode(true);
+    }
+    draw_screen(self);
+}
+
+static void on_destroy(screen_t *self)
+{
+    keyboard_set_text_input_mode(false);
+    free(self->user_data);
+}
+
+screen_t* terminal_screen_create(void *params)
+{
+    (void)params;
+    
+    ESP_LOGI(TAG, "Creating terminal screen...");
+    
+    screen_t *screen = screen_alloc();
+    terminal_data_t *data = screen ? calloc(1, sizeof(terminal_data_t)) : NULL;
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    data->log = uart_scrollback();
+    data->follow = true;
+    data->history_pos = -1;
+    input_history_load(HISTORY_KEY, &data->history);
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_resume = on_resume;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "Terminal screen created");
+    return screen;
+}
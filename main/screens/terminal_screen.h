@@ -0,0 +1,18 @@
+/**
+ * @file terminal_screen.h
+ * @brief Raw JanOS output with scrollback, search and a command prompt
+ */
+
+#ifndef TERMINAL_SCREEN_H
+#define TERMINAL_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the terminal screen
+ * @param params Unused
+ * @return Screen instance
+ */
+screen_t* terminal_screen_create(void *params);
+
+#endif // TERMINAL_SCREEN_H
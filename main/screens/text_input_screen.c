@@ -5,13 +5,21 @@
 
 #include "text_input_screen.h"
 #include "text_ui.h"
+#include "ui_widget.h"
 #include "keyboard.h"
+#include "keymap.h"
+#include "input_history.h"
+#include "network_store.h"
 #include "esp_log.h"
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
 
 static const char *TAG = "TEXT_INPUT";
 
+#define FIELD_ROW       2
+#define HINT_ROW        4
+
 // Screen user data
 typedef struct {
     char title[32];
@@ -20,82 +28,30 @@ typedef struct {
     int cursor_pos;
     text_input_callback_t on_submit;
     void *callback_user_data;
+    ui_label_t field;
+    // History recall: -1 while editing, else the age of the entry shown
+    char history_key[INPUT_HISTORY_KEY_MAX + 1];
+    input_history_t history;
+    int history_pos;
+    char draft[TEXT_INPUT_MAX_LEN + 1];     // Text typed before recall started
+    // TAB completion: candidates are history entries, then scan records
+    bool complete_ssids;
+    bool completing;
+    char prefix[TEXT_INPUT_MAX_LEN + 1];
+    int candidate;                          // Last candidate shown
 } text_input_data_t;
 
 /**
- * @brief Convert key code to character
- * Returns lowercase by default, uppercase/special when shift or capslock held
- * Based on M5Stack official keyboard layout
+ * @brief Repaint the field; only cells that differ from the screen are drawn
  */
-static char key_to_char(key_code_t key)
+static void update_field(text_input_data_t *data)
 {
-    bool shift = keyboard_is_shift_held();
-    bool caps = keyboard_is_capslock_held();
-    
-    // For letters: shift XOR capslock for uppercase
-    bool upper = shift ^ caps;
-    
-    // Letters A-Z - lowercase by default, uppercase with shift or capslock
-    switch (key) {
-        case KEY_Q: return upper ? 'Q' : 'q';
-        case KEY_W: return upper ? 'W' : 'w';
-        case KEY_E: return upper ? 'E' : 'e';
-        case KEY_R: return upper ? 'R' : 'r';
-        case KEY_T: return upper ? 'T' : 't';
-        case KEY_Y: return upper ? 'Y' : 'y';
-        case KEY_U: return upper ? 'U' : 'u';
-        case KEY_I: return upper ? 'I' : 'i';
-        case KEY_O: return upper ? 'O' : 'o';
-        case KEY_P: return upper ? 'P' : 'p';
-        case KEY_A: return upper ? 'A' : 'a';
-        case KEY_S: return upper ? 'S' : 's';
-        case KEY_D: return upper ? 'D' : 'd';
-        case KEY_F: return upper ? 'F' : 'f';
-        case KEY_G: return upper ? 'G' : 'g';
-        case KEY_H: return upper ? 'H' : 'h';
-        case KEY_J: return upper ? 'J' : 'j';
-        case KEY_K: return upper ? 'K' : 'k';
-        case KEY_L: return upper ? 'L' : 'l';
-        case KEY_Z: return upper ? 'Z' : 'z';
-        case KEY_X: return upper ? 'X' : 'x';
-        case KEY_C: return upper ? 'C' : 'c';
-        case KEY_V: return upper ? 'V' : 'v';
-        case KEY_B: return upper ? 'B' : 'b';
-        case KEY_N: return upper ? 'N' : 'n';
-        case KEY_M: return upper ? 'M' : 'm';
-        
-        // Numbers - special chars with shift only (not capslock)
-        case KEY_1: return shift ? '!' : '1';
-        case KEY_2: return shift ? '@' : '2';
-        case KEY_3: return shift ? '#' : '3';
-        case KEY_4: return shift ? '$' : '4';
-        case KEY_5: return shift ? '%' : '5';
-        case KEY_6: return shift ? '^' : '6';
-        case KEY_7: return shift ? '&' : '7';
-        case KEY_8: return shift ? '*' : '8';
-        case KEY_9: return shift ? '(' : '9';
-        case KEY_0: return shift ? ')' : '0';
-        
-        // Symbol keys - special chars with shift only
-        case KEY_GRAVE:      return shift ? '~' : '`';
-        case KEY_MINUS:      return shift ? '_' : '-';
-        case KEY_EQUAL:      return shift ? '+' : '=';
-        case KEY_LBRACKET:   return shift ? '{' : '[';
-        case KEY_RBRACKET:   return shift ? '}' : ']';
-        case KEY_BACKSLASH:  return shift ? '|' : '\\';
-        case KEY_SEMICOLON:  return shift ? ':' : ';';
-        case KEY_APOSTROPHE: return shift ? '"' : '\'';
-        case KEY_COMMA:      return shift ? '<' : ',';
-        case KEY_DOT:        return shift ? '>' : '.';
-        case KEY_SLASH:      return shift ? '?' : '/';
-        
-        case KEY_SPACE: return ' ';
-        case KEY_TAB:   return '\t';
-        
-        default: break;
-    }
-    
-    return 0;  // No valid character
+    // Keep the cursor on screen by showing the tail of long input
+    char display[TEXT_INPUT_MAX_LEN + 2];
+    snprintf(display, sizeof(display), "%s_", data->input);
+    int len = strlen(display);
+    int skip = len > data->field.width ? len - data->field.width : 0;
+    ui_label_set(&data->field, display + skip);
 }
 
 static void draw_screen(screen_t *self)
@@ -107,31 +63,105 @@ static void draw_screen(screen_t *self)
     // Draw title
     ui_draw_title(data->title);
     
-    int row = 2;
-    
-    // Draw input field with cursor
-    char display[TEXT_INPUT_MAX_LEN + 2];
-    snprintf(display, sizeof(display), "%s_", data->input);
-    ui_print(0, row, display, UI_COLOR_HIGHLIGHT);
-    row += 2;
+    update_field(data);
     
     // Draw hint
     if (data->hint[0]) {
-        ui_print(0, row, data->hint, UI_COLOR_DIMMED);
+        ui_print(0, HINT_ROW, data->hint, UI_COLOR_DIMMED);
     }
     
     // Draw status bar
-    ui_draw_status("ENTER:OK ESC:Cancel");
+    ui_draw_status("ENTER:OK ESC:Cancel TAB:Fill");
+}
+
+static void set_input(text_input_data_t *data, const char *text)
+{
+    strncpy(data->input, text, TEXT_INPUT_MAX_LEN);
+    data->input[TEXT_INPUT_MAX_LEN] = '\0';
+    data->cursor_pos = strlen(data->input);
+    update_field(data);
+}
+
+/**
+ * @brief Candidate by position: history entries first, then scanned SSIDs
+ * @return NULL past the end, "" for a position to skip
+ */
+static const char* candidate_at(const text_input_data_t *data, int pos)
+{
+    if (pos < data->history.count) {
+        return input_history_get(&data->history, pos);
+    }
+    pos -= data->history.count;
+    if (!data->complete_ssids || pos >= network_store_count()) {
+        return NULL;
+    }
+
+    // SSIDs are interned, so records sharing a name share the pool offset;
+    // offer each name once, at its first record
+    const network_record_t *rec = network_store_record(pos);
+    if (!rec || rec->ssid == 0) return "";
+    for (int i = 0; i < pos; i++) {
+        const network_record_t *prev = network_store_record(i);
+        if (prev && prev->ssid == rec->ssid) return "";
+    }
+    return network_store_ssid(rec);
+}
+
+static void complete_next(text_input_data_t *data)
+{
+    if (!data->completing) {
+        strcpy(data->prefix, data->input);
+        data->candidate = -1;
+        data->completing = true;
+    }
+
+    // Walk forward from the last candidate, wrapping once
+    size_t prefix_len = strlen(data->prefix);
+    int total = data->history.count + (data->complete_ssids ? network_store_count() : 0);
+    if (total == 0) return;
+    for (int step = 1; step <= total; step++) {
+        int pos = (data->candidate + step) % total;
+        const char *text = candidate_at(data, pos);
+        if (!text || !text[0] || strncasecmp(text, data->prefix, prefix_len) != 0) {
+            continue;
+        }
+        if (strcmp(text, data->input) == 0 && step < total) {
+            continue;
+        }
+        data->candidate = pos;
+        set_input(data, text);
+        return;
+    }
+}
+
+static void recall(text_input_data_t *data, int delta)
+{
+    int pos = data->history_pos + delta;
+    if (pos < -1 || pos >= data->history.count) return;
+
+    if (data->history_pos < 0) {
+        strcpy(data->draft, data->input);
+    }
+    data->history_pos = pos;
+    set_input(data, pos < 0 ? data->draft : input_history_get(&data->history, pos));
 }
 
 static void on_key(screen_t *self, key_code_t key)
 {
     text_input_data_t *data = (text_input_data_t *)self->user_data;
     
+    if (key != KEY_TAB) {
+        data->completing = false;
+    }
+    
     switch (key) {
         case KEY_ENTER:
             // Submit if we have input
             if (data->cursor_pos > 0 && data->on_submit) {
+                // Store first: the callback may pop this screen
+                if (data->history_key[0]) {
+                    input_history_add(data->history_key, &data->history, data->input);
+                }
                 data->on_submit(data->input, data->callback_user_data);
             }
             break;
@@ -141,30 +171,44 @@ static void on_key(screen_t *self, key_code_t key)
             screen_manager_pop();
             break;
             
+        case KEY_UP:
+            recall(data, 1);
+            break;
+            
+        case KEY_DOWN:
+            recall(data, -1);
+            break;
+            
+        case KEY_TAB:
+            complete_next(data);
+            break;
+            
         case KEY_BACKSPACE:
         case KEY_DEL:
             // Delete last character
             if (data->cursor_pos > 0) {
                 data->cursor_pos--;
                 data->input[data->cursor_pos] = '\0';
-                draw_screen(self);
+                data->history_pos = -1;
+                update_field(data);
             }
             break;
             
         default:
             {
                 // Try to add character
-                char ch = key_to_char(key);
+                char ch = keymap_char(key, keyboard_is_shift_held(),
+                                      keyboard_is_capslock_held());
                 if (ch && data->cursor_pos < TEXT_INPUT_MAX_LEN) {
                     data->input[data->cursor_pos++] = ch;
                     data->input[data->cursor_pos] = '\0';
-                    draw_screen(self);
+                    data->history_pos = -1;
+                    update_field(data);
                 }
             }
             break;
     }
 }
-
 static void on_destroy(screen_t *self)
 {
     // Disable text input mode when leaving
@@ -211,6 +255,14 @@ screen_t* text_input_screen_create(void *params)
     data->callback_user_data = input_params->user_data;
     data->cursor_pos = 0;
     data->input[0] = '\0';
+    data->history_pos = -1;
+    data->complete_ssids = input_params->complete_ssids;
+    if (input_params->history) {
+        strncpy(data->history_key, input_params->history, INPUT_HISTORY_KEY_MAX);
+        input_history_load(data->history_key, &data->history);
+    }
+    ui_label_init(&data->field, 0, FIELD_ROW, UI_COLS, UI_ALIGN_LEFT,
+                  UI_COLOR_HIGHLIGHT, UI_COLOR_BG);
     
     free(input_params);
     
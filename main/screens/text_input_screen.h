@@ -1,6 +1,11 @@
 /**
  * @file text_input_screen.h
  * @brief Reusable text input screen with keyboard support
+ *
+ * Typing repaints only the changed cells of the field. With a history
+ * key, submitted values are remembered per field and recalled with
+ * Fn+Up/Down; TAB completes the typed prefix from that history and, for
+ * SSID fields, from the last scan.
  */
 
 #ifndef TEXT_INPUT_SCREEN_H
@@ -20,6 +25,8 @@ typedef struct {
     const char *hint;               // Hint text below input
     text_input_callback_t on_submit; // Called when ENTER pressed
     void *user_data;                // Passed to callback
+    const char *history;            // History key (NULL = none), see input_history.h
+    bool complete_ssids;            // TAB also offers SSIDs from network_store
 } text_input_params_t;
 
 /**
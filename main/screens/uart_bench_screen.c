@@ -0,0 +1,191 @@
+/**
+ * @file uart_bench_screen.c
+ * @brief UART link benchmark results per baud rate and framing
+ *
+ * One row per setting: baud rate, T(ext) or B(inary) framing, average
+ * round trip, TX/RX throughput in KB/s and the share of pings lost or
+ * corrupted. The two rows above the status bar show the round trip
+ * histogram of the selected setting. Enter runs the benchmark, which
+ * switches the link through every setting and back.
+ */
+
+#include "uart_bench_screen.h"
+#include "uart_bench.h"
+#include "text_ui.h"
+#include "ui_list.h"
+#include "keyboard.h"
+#include "esp_log.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+static const char *TAG = "UART_BENCH_SCR";
+
+// Histogram rows above the status bar
+#define HIST_ROWS       2
+
+static const char *const bucket_labels[UART_BENCH_RTT_BUCKETS] = {
+    "<.5", "<1", "<2", "<4", "<8", "<16", "<32", "32+",
+};
+
+// Screen user data
+typedef struct {
+    ui_list_t list;
+    uart_bench_result_t results[UART_BENCH_MAX_RESULTS];
+    uart_bench_status_t status;
+} bench_data_t;
+
+static void result_row(int index, char *text, size_t len, void *user_data)
+{
+    bench_data_t *data = (bench_data_t *)user_data;
+    const uart_bench_result_t *r = &data->results[index];
+    char mode = r->binary ? 'B' : 'T';
+    
+    if (!r->reached) {
+        snprintf(text, len, "%7lu %c no link", (unsigned long)r->baud, mode);
+        return;
+    }
+    unsigned err = r->sent ? (unsigned)((r->lost + r->corrupt) * 100 / r->sent) : 0;
+    snprintf(text, len, "%7lu %c %lu.%lums %lu/%lu%sK %u%%", (unsigned long)r->baud, mode,
+             (unsigned long)(r->rtt_avg_us / 1000), (unsigned long)(r->rtt_avg_us / 100 % 10),
+             (unsigned long)(r->tx_bytes_s / 1024), (unsigned long)(r->rx_bytes_s / 1024),
+             r->payload_echoed ? "" : "~", err);
+}
+
+static void load(bench_data_t *data)
+{
+    uart_bench_get_status(&data->status);
+    int count = uart_bench_results(data->results, UART_BENCH_MAX_RESULTS);
+    ui_list_set_count(&data->list, count);
+}
+
+static void draw_histogram(const bench_data_t *data)
+{
+    int first = ui_rows() - 1 - HIST_ROWS;
+    const uart_bench_result_t *r = data->list.count ? &data->results[data->list.selected] : NULL;
+    int per_row = UART_BENCH_RTT_BUCKETS / HIST_ROWS;
+    
+    for (int row = 0; row < HIST_ROWS; row++) {
+        char line[UI_COLS_MAX + 1] = "";
+        size_t used = 0;
+        for (int i = row * per_row; r && r->reached && i < (row + 1) * per_row; i++) {
+            used += snprintf(line + used, sizeof(line) - used, "%s:%u ",
+                             bucket_labels[i], r->rtt_hist[i]);
+            if (used >= sizeof(line)) break;
+        }
+        char padded[UI_COLS_MAX + 1];
+        snprintf(padded, sizeof(padded), " %-*.*s", ui_cols() - 1, ui_cols() - 1, line);
+        ui_print(0, first + row, padded, UI_COLOR_DIMMED);
+    }
+}
+
+static void draw_screen(screen_t *self)
+{
+    bench_data_t *data = (bench_data_t *)self->user_data;
+    
+    ui_clear();
+    char title[32];
+    if (data->status.running) {
+        snprintf(title, sizeof(title), "UART Bench %d/%d", data->status.step, data->status.steps);
+    } else {
+        snprintf(title, sizeof(title), "UART Bench");
+    }
+    ui_draw_title(title);
+    
+    if (data->list.count == 0) {
+        ui_print_center(ui_rows() / 2 - 1,
+                        data->status.running ? "Measuring..." : "Enter: run benchmark",
+                        UI_COLOR_DIMMED);
+    } else {
+        ui_list_draw(&data->list);
+        draw_histogram(data);
+    }
+    
+    ui_draw_status(data->status.running ? "S:Stop ESC:Back" : "Enter:Run ESC:Back");
+}
+
+static void on_tick(screen_t *self)
+{
+    bench_data_t *data = (bench_data_t *)self->user_data;
+    
+    uart_bench_status_t status;
+    uart_bench_get_status(&status);
+    if (status.running == data->status.running && status.step == data->status.step) return;
+    load(data);
+    draw_screen(self);
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    bench_data_t *data = (bench_data_t *)self->user_data;
+    
+    if (ui_list_handle_key(&data->list, key)) {
+        ui_list_draw(&data->list);
+        draw_histogram(data);
+        return;
+    }
+    
+    switch (key) {
+        case KEY_ENTER:
+            if (!data->status.running && uart_bench_start() != ESP_OK) {
+                ESP_LOGW(TAG, "Benchmark not started");
+            }
+            load(data);
+            draw_screen(self);
+            break;
+            
+        case KEY_S:
+            uart_bench_stop();
+            break;
+            
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    // A run left behind finishes its setting and restores the link
+    uart_bench_stop();
+    free(self->user_data);
+}
+
+static void on_resume(screen_t *self)
+{
+    draw_screen(self);
+}
+
+screen_t* uart_bench_screen_create(void *params)
+{
+    (void)params;
+    
+    ESP_LOGI(TAG, "Creating UART benchmark screen...");
+    
+    screen_t *screen = screen_alloc();
+    bench_data_t *data = screen ? calloc(1, sizeof(bench_data_t)) : NULL;
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    ui_list_init(&data->list, 1, ui_rows() - 2 - HIST_ROWS, result_row, data);
+    load(data);
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_resume = on_resume;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "UART benchmark screen created");
+    return screen;
+}
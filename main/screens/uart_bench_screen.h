@@ -0,0 +1,18 @@
+/**
+ * @file uart_bench_screen.h
+ * @brief UART link benchmark results per baud rate and framing
+ */
+
+#ifndef UART_BENCH_SCREEN_H
+#define UART_BENCH_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the UART benchmark screen
+ * @param params Unused
+ * @return Screen instance
+ */
+screen_t* uart_bench_screen_create(void *params);
+
+#endif // UART_BENCH_SCREEN_H
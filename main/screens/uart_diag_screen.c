@@ -0,0 +1,247 @@
+/**
+ * @file uart_diag_screen.c
+ * @brief UART link diagnostics screen implementation
+ *
+ * Shows the link counters kept by uart_handler so dropped input at the
+ * Cardputer end can be told apart from missing output from JanOS.
+ */
+
+#include "uart_diag_screen.h"
+#include "uart_bench_screen.h"
+#include "uart_handler.h"
+#include "uart_transcript.h"
+#include "event_bus.h"
+#include "time_sync.h"
+#include "text_ui.h"
+#include "ui_widget.h"
+#include "keyboard.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+static const char *TAG = "UART_DIAG";
+
+// Refresh interval (500ms)
+#define REFRESH_INTERVAL_US 500000
+
+// Fast replay time scale (F key)
+#define REPLAY_FAST_SPEED   8
+
+// Flow control in effect, by uart_flow_t
+static const char *const flow_names[] = { "none", "rts", "xon", "credit" };
+
+// Rows 1..6 between title and status bar
+#define STAT_FIRST_ROW  1
+#define STAT_ROWS       6
+
+// Screen user data
+typedef struct {
+    int64_t last_refresh_us;
+    bool layout_drawn;
+    uint32_t layout_generation;
+    ui_label_t rows[STAT_ROWS];
+} uart_diag_data_t;
+
+static void set_row(uart_diag_data_t *data, int row, uint16_t fg, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static void set_row(uart_diag_data_t *data, int row, uint16_t fg, const char *fmt, ...)
+{
+    char text[UI_COLS + 1];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    
+    ui_label_t *label = &data->rows[row - STAT_FIRST_ROW];
+    ui_label_set_colors(label, fg, UI_COLOR_BG);
+    ui_label_set(label, text);
+}
+
+static void draw_screen(screen_t *self)
+{
+    uart_diag_data_t *data = (uart_diag_data_t *)self->user_data;
+    
+    // Static chrome only after a clear; rows repaint themselves
+    if (!data->layout_drawn || data->layout_generation != ui_get_clear_generation()) {
+        ui_clear();
+        ui_draw_title("UART Link");
+        ui_draw_status("R:Rst T:Rec P/F:Play B:Bench");
+        data->layout_generation = ui_get_clear_generation();
+        data->layout_drawn = true;
+    }
+    
+    uart_link_stats_t st;
+    uart_get_link_stats(&st);
+    
+    // Best ping round trip, which time_sync takes off the JanOS clock offset
+    time_sync_status_t sync;
+    time_sync_get_status(&sync);
+    uint32_t rtt_us = sync.rtt_min_us[UART_LINK_PRIMARY];
+    // "+q": JanOS keeps its logs off the link
+    const char *mode = uart_get_quiet() != UART_QUIET_OFF ?
+                       (uart_is_binary_mode() ? "bin+q" : "text+q") :
+                       (uart_is_binary_mode() ? "binary" : "text");
+    if (rtt_us) {
+        set_row(data, 1, UI_COLOR_HIGHLIGHT, " %lu baud %s rtt %lu.%lums",
+                (unsigned long)uart_get_baud_rate(), mode,
+                (unsigned long)(rtt_us / 1000), (unsigned long)(rtt_us / 100 % 10));
+    } else {
+        set_row(data, 1, UI_COLOR_HIGHLIGHT, " %lu baud  %s",
+                (unsigned long)uart_get_baud_rate(), mode);
+    }
+    if (st.bulk_bytes) {
+        // Compressed share: wire bytes per 100 bytes of expanded text
+        set_row(data, 2, st.bulk_dropped ? UI_COLOR_ERROR : UI_COLOR_TEXT,
+                " RX %luB %lu lines lz4 %lu%%",
+                (unsigned long)st.rx_bytes, (unsigned long)st.rx_lines,
+                (unsigned long)((uint64_t)st.bulk_bytes * 100 / (st.bulk_text ? st.bulk_text : 1)));
+    } else {
+        set_row(data, 2, UI_COLOR_TEXT, " RX %luB %lu lines",
+                (unsigned long)st.rx_bytes, (unsigned long)st.rx_lines);
+    }
+    if (st.express_sent) {
+        // Slowest express command (stop), call to last byte on the wire
+        set_row(data, 3, UI_COLOR_TEXT, " TX %luB %lu lines stop %lums",
+                (unsigned long)st.tx_bytes, (unsigned long)st.tx_lines,
+                (unsigned long)((st.express_max_us + 999) / 1000));
+    } else {
+        set_row(data, 3, UI_COLOR_TEXT, " TX %luB %lu lines",
+                (unsigned long)st.tx_bytes, (unsigned long)st.tx_lines);
+    }
+    
+    // Anything lost at this end shows up red
+    bool rx_loss = st.truncated_lines || st.fifo_overflows || st.ring_overflows ||
+                   st.line_errors || st.frame_errors;
+    set_row(data, 4, rx_loss ? UI_COLOR_ERROR : UI_COLOR_TEXT,
+            " Ovf %lu/%lu Trunc %lu Err %lu",
+            (unsigned long)st.fifo_overflows, (unsigned long)st.ring_overflows,
+            (unsigned long)st.truncated_lines,
+            (unsigned long)(st.line_errors + st.frame_errors));
+    uint32_t bus_dropped = event_bus_total_dropped();
+    set_row(data, 5, (st.parse_failures || st.request_timeouts || bus_dropped) ?
+                     UI_COLOR_ERROR : UI_COLOR_TEXT,
+            " Parse fail %lu T/O %lu Bus %lu",
+            (unsigned long)st.parse_failures, (unsigned long)st.request_timeouts,
+            (unsigned long)bus_dropped);
+    
+    // Capture/replay state takes over the last row while active
+    uart_transcript_status_t ts;
+    uart_transcript_get_status(&ts);
+    if (ts.recording) {
+        set_row(data, 6, ts.dropped ? UI_COLOR_ERROR : UI_COLOR_HIGHLIGHT,
+                " REC %luB drop %lu",
+                (unsigned long)ts.bytes, (unsigned long)ts.dropped);
+    } else if (ts.replaying) {
+        set_row(data, 6, UI_COLOR_HIGHLIGHT, " PLAY %d%% lag %lums",
+                ts.progress_pct, (unsigned long)ts.max_lag_ms);
+    } else {
+        // Flow holds cost nothing but show how close the link runs to losing data
+        set_row(data, 6, UI_COLOR_TEXT, " Cb %lu/%luus %s %lu Stk %lu",
+                (unsigned long)st.callback_avg_us, (unsigned long)st.callback_max_us,
+                flow_names[st.flow], (unsigned long)st.flow_holds,
+                (unsigned long)st.rx_stack_free);
+    }
+}
+
+static void on_tick(screen_t *self)
+{
+    uart_diag_data_t *data = (uart_diag_data_t *)self->user_data;
+    
+    int64_t now = esp_timer_get_time();
+    if (now - data->last_refresh_us >= REFRESH_INTERVAL_US) {
+        data->last_refresh_us = now;
+        draw_screen(self);
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    switch (key) {
+        case KEY_R:
+            uart_reset_link_stats();
+            draw_screen(self);
+            break;
+            
+        case KEY_T: {
+            uart_transcript_status_t ts;
+            uart_transcript_get_status(&ts);
+            if (ts.recording) {
+                uart_transcript_record_stop();
+            } else if (uart_transcript_record_start() != ESP_OK) {
+                ESP_LOGW(TAG, "Capture not started");
+            }
+            draw_screen(self);
+            break;
+        }
+            
+        case KEY_P:
+        case KEY_F: {
+            uart_transcript_status_t ts;
+            uart_transcript_get_status(&ts);
+            if (ts.replaying) {
+                uart_transcript_replay_stop();
+            } else if (uart_transcript_replay_start(NULL, key == KEY_F ? REPLAY_FAST_SPEED : 1) != ESP_OK) {
+                ESP_LOGW(TAG, "No transcript to replay");
+            }
+            draw_screen(self);
+            break;
+        }
+            
+        case KEY_B:
+            screen_manager_push(uart_bench_screen_create, NULL);
+            break;
+            
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    if (self->user_data) {
+        free(self->user_data);
+    }
+}
+
+screen_t* uart_diag_screen_create(void *params)
+{
+    (void)params;
+    
+    ESP_LOGI(TAG, "Creating UART diagnostics screen...");
+    
+    screen_t *screen = screen_alloc();
+    if (!screen) return NULL;
+    
+    uart_diag_data_t *data = calloc(1, sizeof(uart_diag_data_t));
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    for (int i = 0; i < STAT_ROWS; i++) {
+        ui_label_init(&data->rows[i], 0, STAT_FIRST_ROW + i, UI_COLS,
+                      UI_ALIGN_LEFT, UI_COLOR_TEXT, UI_COLOR_BG);
+    }
+    data->last_refresh_us = esp_timer_get_time();
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    
+    draw_screen(screen);
+    
+    ESP_LOGI(TAG, "UART diagnostics screen created");
+    return screen;
+}
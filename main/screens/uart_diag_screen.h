@@ -0,0 +1,18 @@
+/**
+ * @file uart_diag_screen.h
+ * @brief UART link diagnostics screen
+ */
+
+#ifndef UART_DIAG_SCREEN_H
+#define UART_DIAG_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the UART link diagnostics screen
+ * @param params Unused
+ * @return Screen instance
+ */
+screen_t* uart_diag_screen_create(void *params);
+
+#endif // UART_DIAG_SCREEN_H
@@ -0,0 +1,185 @@
+/**
+ * @file usb_bridge_screen.c
+ * @brief USB to JanOS bridge status screen implementation
+ *
+ * Starts the bridge when opened and stops it when left. Shows throughput
+ * in both directions, drops, the local scan status and the last line
+ * JanOS sent, which the local parsers still see while PC tooling drives
+ * the board.
+ */
+
+#include "usb_bridge_screen.h"
+#include "usb_bridge.h"
+#include "uart_handler.h"
+#include "text_ui.h"
+#include "ui_widget.h"
+#include "keyboard.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+static const char *TAG = "USB_BRIDGE_SCR";
+
+#define REFRESH_INTERVAL_US 500000
+
+// Rows 1..6 between title and status bar
+#define STAT_FIRST_ROW  1
+#define STAT_ROWS       6
+
+typedef struct {
+    int64_t last_refresh_us;
+    bool layout_drawn;
+    uint32_t layout_generation;
+    ui_label_t rows[STAT_ROWS];
+    esp_err_t start_error;
+    usb_bridge_stats_t prev;        // Counters at the last refresh
+    int64_t prev_us;
+    char last_line[UI_COLS + 1];    // Written by the UART RX task
+} usb_bridge_data_t;
+
+static void set_row(usb_bridge_data_t *data, int row, uint16_t fg, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static void set_row(usb_bridge_data_t *data, int row, uint16_t fg, const char *fmt, ...)
+{
+    char text[UI_COLS + 1];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    
+    ui_label_t *label = &data->rows[row - STAT_FIRST_ROW];
+    ui_label_set_colors(label, fg, UI_COLOR_BG);
+    ui_label_set(label, text);
+}
+
+static void on_uart_line(const char *line, void *user_data)
+{
+    usb_bridge_data_t *data = (usb_bridge_data_t *)user_data;
+    strlcpy(data->last_line, line, sizeof(data->last_line));
+}
+
+static uint32_t rate_kbs(uint32_t now, uint32_t before, int64_t elapsed_us)
+{
+    if (elapsed_us <= 0) return 0;
+    return (uint32_t)((uint64_t)(now - before) * 1000000ULL / elapsed_us / 1024);
+}
+
+static void draw_screen(screen_t *self)
+{
+    usb_bridge_data_t *data = (usb_bridge_data_t *)self->user_data;
+    
+    if (!data->layout_drawn || data->layout_generation != ui_get_clear_generation()) {
+        ui_clear();
+        ui_draw_title("USB Bridge");
+        ui_draw_status("ESC:Stop bridge and back");
+        data->layout_generation = ui_get_clear_generation();
+        data->layout_drawn = true;
+    }
+    
+    usb_bridge_stats_t st;
+    usb_bridge_get_stats(&st);
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed = now - data->prev_us;
+    
+    if (st.active) {
+        set_row(data, 1, UI_COLOR_HIGHLIGHT, " Active, %lu baud",
+                (unsigned long)uart_get_baud_rate());
+    } else {
+        set_row(data, 1, UI_COLOR_BORDER, " Not running: %s",
+                esp_err_to_name(data->start_error));
+    }
+    set_row(data, 2, UI_COLOR_TEXT, " PC>JanOS %luB %luK/s",
+            (unsigned long)st.to_janos_bytes,
+            (unsigned long)rate_kbs(st.to_janos_bytes, data->prev.to_janos_bytes, elapsed));
+    set_row(data, 3, UI_COLOR_TEXT, " JanOS>PC %luB %luK/s",
+            (unsigned long)st.to_pc_bytes,
+            (unsigned long)rate_kbs(st.to_pc_bytes, data->prev.to_pc_bytes, elapsed));
+    
+    // Host not reading (or JanOS link stalled) shows up red
+    bool loss = st.to_pc_dropped || st.to_janos_dropped;
+    set_row(data, 4, loss ? UI_COLOR_ERROR : UI_COLOR_TEXT, " Drop %lu to PC %lu to JanOS",
+            (unsigned long)st.to_pc_dropped, (unsigned long)st.to_janos_dropped);
+    set_row(data, 5, UI_COLOR_TEXT, " %s", uart_get_scan_status());
+    set_row(data, 6, UI_COLOR_DIMMED, "%s", data->last_line);
+    
+    data->prev = st;
+    data->prev_us = now;
+}
+
+static void on_tick(screen_t *self)
+{
+    usb_bridge_data_t *data = (usb_bridge_data_t *)self->user_data;
+    
+    int64_t now = esp_timer_get_time();
+    if (now - data->last_refresh_us >= REFRESH_INTERVAL_US) {
+        data->last_refresh_us = now;
+        draw_screen(self);
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    (void)self;
+    
+    switch (key) {
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    usb_bridge_data_t *data = (usb_bridge_data_t *)self->user_data;
+    
+    usb_bridge_stop();
+    if (data) {
+        free(data);
+    }
+}
+
+screen_t* usb_bridge_screen_create(void *params)
+{
+    (void)params;
+    
+    ESP_LOGI(TAG, "Creating USB bridge screen...");
+    
+    screen_t *screen = screen_alloc();
+    if (!screen) return NULL;
+    
+    usb_bridge_data_t *data = calloc(1, sizeof(usb_bridge_data_t));
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    for (int i = 0; i < STAT_ROWS; i++) {
+        ui_label_init(&data->rows[i], 0, STAT_FIRST_ROW + i, UI_COLS,
+                      UI_ALIGN_LEFT, UI_COLOR_TEXT, UI_COLOR_BG);
+    }
+    screen_subscribe_lines(screen, UART_ROUTE_ANY, NULL, on_uart_line, data);
+    
+    // Logged before the bridge silences logging
+    ESP_LOGI(TAG, "USB bridge screen created");
+    data->start_error = usb_bridge_start();
+    data->last_refresh_us = esp_timer_get_time();
+    data->prev_us = data->last_refresh_us;
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    
+    draw_screen(screen);
+    return screen;
+}
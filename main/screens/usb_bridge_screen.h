@@ -0,0 +1,18 @@
+/**
+ * @file usb_bridge_screen.h
+ * @brief USB to JanOS bridge status screen
+ */
+
+#ifndef USB_BRIDGE_SCREEN_H
+#define USB_BRIDGE_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the USB bridge screen (the bridge runs while it is open)
+ * @param params Unused
+ * @return Screen instance
+ */
+screen_t* usb_bridge_screen_create(void *params);
+
+#endif // USB_BRIDGE_SCREEN_H
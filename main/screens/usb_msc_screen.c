@@ -0,0 +1,158 @@
+/**
+ * @file usb_msc_screen.c
+ * @brief USB SD drive export screen implementation
+ *
+ * Exports the SD card when opened and mounts it again when left. Shows
+ * whether a PC has enumerated the drive; anything that needs the card
+ * (screenshots, logs) waits until the screen is closed.
+ */
+
+#include "usb_msc_screen.h"
+#include "usb_msc.h"
+#include "text_ui.h"
+#include "ui_widget.h"
+#include "keyboard.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+static const char *TAG = "USB_MSC_SCR";
+
+#define REFRESH_INTERVAL_US 500000
+
+// Rows 1..5 between title and status bar
+#define STAT_FIRST_ROW  1
+#define STAT_ROWS       5
+
+typedef struct {
+    int64_t last_refresh_us;
+    int64_t start_us;
+    bool layout_drawn;
+    uint32_t layout_generation;
+    ui_label_t rows[STAT_ROWS];
+    esp_err_t start_error;
+} usb_msc_data_t;
+
+static void set_row(usb_msc_data_t *data, int row, uint16_t fg, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static void set_row(usb_msc_data_t *data, int row, uint16_t fg, const char *fmt, ...)
+{
+    char text[UI_COLS + 1];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    
+    ui_label_t *label = &data->rows[row - STAT_FIRST_ROW];
+    ui_label_set_colors(label, fg, UI_COLOR_BG);
+    ui_label_set(label, text);
+}
+
+static void draw_screen(screen_t *self)
+{
+    usb_msc_data_t *data = (usb_msc_data_t *)self->user_data;
+    
+    if (!data->layout_drawn || data->layout_generation != ui_get_clear_generation()) {
+        ui_clear();
+        ui_draw_title("USB SD Drive");
+        ui_draw_status("ESC:Remount SD and back");
+        data->layout_generation = ui_get_clear_generation();
+        data->layout_drawn = true;
+    }
+    
+    usb_msc_status_t st;
+    usb_msc_get_status(&st);
+    
+    if (!st.active) {
+        set_row(data, 1, UI_COLOR_BORDER, " Not exported: %s",
+                esp_err_to_name(data->start_error));
+        set_row(data, 2, UI_COLOR_DIMMED, " Needs an SD card, no");
+        set_row(data, 3, UI_COLOR_DIMMED, " wardrive, recording or");
+        set_row(data, 4, UI_COLOR_DIMMED, " USB bridge/mirror running");
+        set_row(data, 5, UI_COLOR_TEXT, "%s", "");
+        return;
+    }
+    
+    int64_t secs = (esp_timer_get_time() - data->start_us) / 1000000;
+    set_row(data, 1, UI_COLOR_HIGHLIGHT, " Exported %llu MB",
+            (unsigned long long)(st.card_bytes / (1024 * 1024)));
+    set_row(data, 2, st.host_connected ? UI_COLOR_HIGHLIGHT : UI_COLOR_TEXT, " %s",
+            st.host_connected ? "PC connected" : "Waiting for a PC...");
+    set_row(data, 3, UI_COLOR_TEXT, " Up %lld:%02lld", (long long)(secs / 60),
+            (long long)(secs % 60));
+    set_row(data, 4, UI_COLOR_DIMMED, " Eject on the PC first,");
+    set_row(data, 5, UI_COLOR_DIMMED, " logs resume after ESC");
+}
+
+static void on_tick(screen_t *self)
+{
+    usb_msc_data_t *data = (usb_msc_data_t *)self->user_data;
+    
+    int64_t now = esp_timer_get_time();
+    if (now - data->last_refresh_us >= REFRESH_INTERVAL_US) {
+        data->last_refresh_us = now;
+        draw_screen(self);
+    }
+}
+
+static void on_key(screen_t *self, key_code_t key)
+{
+    (void)self;
+    
+    switch (key) {
+        case KEY_ESC:
+        case KEY_Q:
+        case KEY_BACKSPACE:
+            screen_manager_pop();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void on_destroy(screen_t *self)
+{
+    usb_msc_stop();
+    free(self->user_data);
+}
+
+screen_t* usb_msc_screen_create(void *params)
+{
+    (void)params;
+    
+    ESP_LOGI(TAG, "Creating USB SD drive screen...");
+    
+    screen_t *screen = screen_alloc();
+    if (!screen) return NULL;
+    
+    usb_msc_data_t *data = calloc(1, sizeof(usb_msc_data_t));
+    if (!data) {
+        free(screen);
+        return NULL;
+    }
+    
+    for (int i = 0; i < STAT_ROWS; i++) {
+        ui_label_init(&data->rows[i], 0, STAT_FIRST_ROW + i, UI_COLS,
+                      UI_ALIGN_LEFT, UI_COLOR_TEXT, UI_COLOR_BG);
+    }
+    
+    // Logged before the export silences logging
+    ESP_LOGI(TAG, "USB SD drive screen created");
+    data->start_error = usb_msc_start();
+    data->start_us = esp_timer_get_time();
+    data->last_refresh_us = data->start_us;
+    
+    screen->user_data = data;
+    screen->on_key = on_key;
+    screen->on_destroy = on_destroy;
+    screen->on_draw = draw_screen;
+    screen->on_tick = on_tick;
+    
+    draw_screen(screen);
+    return screen;
+}
@@ -0,0 +1,18 @@
+/**
+ * @file usb_msc_screen.h
+ * @brief USB SD drive export screen
+ */
+
+#ifndef USB_MSC_SCREEN_H
+#define USB_MSC_SCREEN_H
+
+#include "screen_manager.h"
+
+/**
+ * @brief Create the USB SD drive screen (the card is exported while it is open)
+ * @param params Unused
+ * @return Screen instance
+ */
+screen_t* usb_msc_screen_create(void *params);
+
+#endif // USB_MSC_SCREEN_H
@@ -29,6 +29,7 @@ typedef struct {
     bool loading;
     bool saved;
     bool needs_redraw;   // Flag for deferred redraw from UART callback
+    bool answered;       // Reply seen; on_tick stops listening
     char status_msg[32];
 } vendor_lookup_data_t;
 
@@ -53,9 +54,9 @@ static void on_uart_response(const char *line, void *user_data)
         data->loading = false;
         data->status_msg[0] = '\0';
         
-        // Clear callback and set flag for deferred redraw
-        uart_clear_line_callback();
-        data->needs_redraw = true;  // Will be handled by on_tick
+        // Listening stops and the redraw happens in on_tick
+        data->answered = true;
+        data->needs_redraw = true;
     }
 }
 
@@ -64,6 +65,10 @@ static void on_tick(screen_t *self)
 {
     vendor_lookup_data_t *data = (vendor_lookup_data_t *)self->user_data;
     
+    if (data->answered) {
+        data->answered = false;
+        screen_set_line_callback(self, NULL, NULL);
+    }
     if (data->needs_redraw) {
         data->needs_redraw = false;
         draw_screen(self);
@@ -109,7 +114,6 @@ static void on_key(screen_t *self, key_code_t key)
     // Ignore keys while loading
     if (data->loading) {
         if (key == KEY_ESC || key == KEY_Q || key == KEY_BACKSPACE) {
-            uart_clear_line_callback();
             screen_manager_pop();
         }
         return;
@@ -166,7 +170,6 @@ static void on_key(screen_t *self, key_code_t key)
         case KEY_ESC:
         case KEY_Q:
         case KEY_BACKSPACE:
-            uart_clear_line_callback();
             screen_manager_pop();
             break;
             
@@ -177,7 +180,6 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
-    uart_clear_line_callback();
     if (self->user_data) {
         free(self->user_data);
     }
@@ -191,9 +193,10 @@ static void on_resume(screen_t *self)
     data->loading = true;
     data->saved = false;
     data->needs_redraw = false;
+    data->answered = false;
     data->status_msg[0] = '\0';
     
-    uart_register_line_callback(on_uart_response, self);
+    screen_set_line_callback(self, on_uart_response, self);
     uart_send_command("vendor read");
     
     draw_screen(self);
@@ -230,7 +233,7 @@ screen_t* vendor_lookup_screen_create(void *params)
     screen->on_tick = on_tick;
     
     // Register callback and send read command
-    uart_register_line_callback(on_uart_response, screen);
+    screen_set_line_callback(screen, on_uart_response, screen);
     uart_send_command("vendor read");
     
     // Draw initial screen
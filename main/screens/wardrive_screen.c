@@ -5,10 +5,16 @@
 
 #include "wardrive_screen.h"
 #include "uart_handler.h"
+#include "job_manager.h"
 #include "text_ui.h"
 #include "buzzer.h"
 #include "settings.h"
 #include "cap_gps.h"
+#include "wardrive_log.h"
+#include "wardrive_index.h"
+#include "track_log.h"
+#include "gps_uplink.h"
+#include "power_governor.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
@@ -16,14 +22,20 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 
 static const char *TAG = "WARDRIVE";
 
-// Refresh timer interval (200ms)
-#define REFRESH_INTERVAL_US 200000
+// CAP GPS satellite count poll while waiting for a fix
+#define CAP_POLL_INTERVAL_US 2000000
 
-// CAP GPS position update interval (~2 seconds = 10 ticks of 200ms)
-#define CAP_GPS_UPDATE_TICKS 10
+// Forward a CAP position to JanOS once it moved this far, or at least this
+// often so JanOS never sees it go stale
+#define CAP_FORWARD_MIN_M       5.0f
+#define CAP_FORWARD_MAX_US      2000000
+
+// Metres per 1e-7 degree of latitude
+#define METRES_PER_E7           0.011132f
 
 // Wardrive states
 typedef enum {
@@ -41,76 +53,122 @@ typedef struct {
     int gps_wait_elapsed;
     int gps_wait_timeout;
     int unique_networks;
-    bool needs_redraw;
-    esp_timer_handle_t refresh_timer;
+    esp_timer_handle_t refresh_timer;   // CAP GPS only
     screen_t *self;
     // CAP GPS
     bool is_cap_gps;
     bool wardrive_started;
-    int cap_tick_counter;
+    uint32_t cap_version;   // Snapshot version behind the satellite count shown
+    int32_t sent_lat_e7;    // Last position forwarded to JanOS
+    int32_t sent_lon_e7;
+    int64_t sent_time_us;
+    bool log_open;          // Observations also go to wd_N.mwd on SD
+    bool index_ready;       // Local unique counts from wardrive_index
+    bool track_open;        // CAP GPS route also goes to trk_N.mtk
+    bool last_is_new;       // last_ssid was a first sighting
 } wardrive_data_t;
 
 // Forward declaration
 static void draw_screen(screen_t *self);
 
 /**
- * @brief Timer callback - checks if redraw is needed and handles CAP GPS updates
+ * @brief Whether a CAP fix is worth forwarding: moved far enough or due
  */
-static void refresh_timer_callback(void *arg)
+static bool cap_should_forward(const wardrive_data_t *data, const cap_gps_fix_t *fix)
 {
-    wardrive_data_t *data = (wardrive_data_t *)arg;
-    if (!data || !data->self) return;
-
-    // CAP GPS position update loop
-    if (data->is_cap_gps) {
-        data->cap_tick_counter++;
-        if (data->cap_tick_counter >= CAP_GPS_UPDATE_TICKS) {
-            data->cap_tick_counter = 0;
-
-            if (cap_gps_has_fix()) {
-                double lat, lon, alt, hdop;
-                if (cap_gps_get_position(&lat, &lon, &alt, &hdop)) {
-                    // Send position to JanOS via UART1
-                    char cmd[96];
-                    snprintf(cmd, sizeof(cmd), "set_gps_position_cap %.7f %.7f %.1f %.1f",
-                             lat, lon, alt, hdop);
-                    uart_send_command(cmd);
-
-                    // Update display coordinates
-                    snprintf(data->lat, sizeof(data->lat), "%.7f", lat);
-                    snprintf(data->lon, sizeof(data->lon), "%.7f", lon);
+    if (data->sent_time_us == 0 || data->state != STATE_RUNNING) return true;
+    int64_t max_us = (int64_t)power_governor_scale_ms(CAP_FORWARD_MAX_US / 1000) * 1000;
+    if (fix->time_us - data->sent_time_us >= max_us) return true;
+    
+    // Equirectangular distance is plenty at these ranges
+    float dy = (fix->lat_e7 - data->sent_lat_e7) * METRES_PER_E7;
+    float dx = (fix->lon_e7 - data->sent_lon_e7) * METRES_PER_E7 *
+               cosf(fix->lat_e7 * 1e-7f * (float)M_PI / 180.0f);
+    return dx * dx + dy * dy >= CAP_FORWARD_MIN_M * CAP_FORWARD_MIN_M;
+}
 
-                    if (data->state == STATE_WAITING_GPS) {
-                        // First fix - start wardrive
-                        ESP_LOGI(TAG, "CAP GPS fix obtained! Starting wardrive...");
-                        uart_send_command("start_wardrive_promisc");
-                        buzzer_beep_attack();
-                        data->wardrive_started = true;
-                        data->state = STATE_RUNNING;
-                    } else if (data->state == STATE_GPS_LOST) {
-                        ESP_LOGI(TAG, "CAP GPS fix recovered!");
-                        data->state = STATE_RUNNING;
-                    }
-                    data->needs_redraw = true;
-                }
+/**
+ * @brief CAP GPS fix callback (GPS task) - forwards positions and tracks fix state
+ *
+ * With binary framing every fix goes to JanOS in batched track frames;
+ * otherwise positions are decimated into set_gps_position_cap commands.
+ * Every fix is also offered to the local track log.
+ */
+static void cap_fix_callback(const cap_gps_fix_t *fix, void *user_data)
+{
+    wardrive_data_t *data = (wardrive_data_t *)user_data;
+    bool track = uart_is_binary_mode();
+    
+    if (data->track_open) {
+        track_log_add_fix(fix);
+    }
+    
+    if (!fix->fix) {
+        if (data->state == STATE_RUNNING) {
+            ESP_LOGW(TAG, "CAP GPS fix lost!");
+            if (track) {
+                gps_uplink_push(fix);
             } else {
-                // No fix
-                if (data->state == STATE_RUNNING) {
-                    ESP_LOGW(TAG, "CAP GPS fix lost!");
-                    uart_send_command("set_gps_position_cap");
-                    data->state = STATE_GPS_LOST;
-                    data->needs_redraw = true;
-                } else if (data->state == STATE_WAITING_GPS) {
-                    // Update satellite count display
-                    data->needs_redraw = true;
-                }
+                uart_send_command("set_gps_position_cap");
             }
+            data->state = STATE_GPS_LOST;
+            data->sent_time_us = 0;
+            screen_manager_data_changed(data->self);
         }
+        return;
+    }
+    
+    if (track) {
+        gps_uplink_push(fix);
+    }
+    if (!cap_should_forward(data, fix)) return;
+    
+    // Send position to JanOS via UART1
+    double lat = fix->lat_e7 / 1e7;
+    double lon = fix->lon_e7 / 1e7;
+    if (!track) {
+        char cmd[96];
+        snprintf(cmd, sizeof(cmd), "set_gps_position_cap %.7f %.7f %.1f %.1f",
+                 lat, lon, fix->alt_dm / 10.0, fix->hdop_x100 / 100.0);
+        uart_send_command(cmd);
     }
+    data->sent_lat_e7 = fix->lat_e7;
+    data->sent_lon_e7 = fix->lon_e7;
+    data->sent_time_us = fix->time_us;
+    
+    // Update display coordinates
+    snprintf(data->lat, sizeof(data->lat), "%.7f", lat);
+    snprintf(data->lon, sizeof(data->lon), "%.7f", lon);
+    
+    if (data->state == STATE_WAITING_GPS) {
+        // First fix - start wardrive
+        ESP_LOGI(TAG, "CAP GPS fix obtained! Starting wardrive...");
+        uart_send_command("start_wardrive_promisc");
+        buzzer_beep_attack();
+        data->wardrive_started = true;
+        data->state = STATE_RUNNING;
+    } else if (data->state == STATE_GPS_LOST) {
+        ESP_LOGI(TAG, "CAP GPS fix recovered!");
+        data->state = STATE_RUNNING;
+    }
+    screen_manager_data_changed(data->self);
+}
+
+/**
+ * @brief Timer callback - refreshes the CAP satellite count while waiting for a fix
+ */
+static void refresh_timer_callback(void *arg)
+{
+    wardrive_data_t *data = (wardrive_data_t *)arg;
+    if (!data || !data->self) return;
 
-    if (data->needs_redraw) {
-        data->needs_redraw = false;
-        draw_screen(data->self);
+    // Positions arrive through cap_fix_callback; only the wait view polls
+    if (data->state == STATE_WAITING_GPS) {
+        cap_gps_snapshot_t snap;
+        if (cap_gps_get_snapshot(&snap) && snap.version != data->cap_version) {
+            data->cap_version = snap.version;
+            screen_manager_data_changed(data->self);
+        }
     }
 }
 
@@ -174,6 +232,7 @@ static void uart_line_callback(const char *line, void *user_data)
     // --- Network CSV lines: MAC,SSID,[AUTH],date,ch,rssi,lat,lon,alt,acc,WIFI ---
     if (strlen(line) > 18 && line[2] == ':' && line[5] == ':' && 
         line[8] == ':' && line[11] == ':' && line[14] == ':' && line[17] == ',') {
+        wardrive_log_add_line(line);
         const char *ssid_start = line + 18;
         const char *ssid_end = strchr(ssid_start, ',');
         if (ssid_end && ssid_end > ssid_start) {
@@ -216,8 +275,16 @@ static void uart_line_callback(const char *line, void *user_data)
                 }
             }
         }
-        data->unique_networks++;
-        data->needs_redraw = true;
+        // Local dedupe; JanOS lines repeat networks on every sighting
+        if (data->index_ready && comma_count >= 8) {
+            data->last_is_new = wardrive_index_add(line, field_starts[2], atoi(field_starts[4]));
+            wardrive_index_stats_t st;
+            wardrive_index_get_stats(&st);
+            data->unique_networks = st.unique;
+        } else {
+            data->unique_networks++;
+        }
+        screen_manager_data_changed(data->self);
         return;
     }
     
@@ -232,7 +299,7 @@ static void uart_line_callback(const char *line, void *user_data)
                 data->gps_wait_timeout = timeout;
             }
         }
-        data->needs_redraw = true;
+        screen_manager_data_changed(data->self);
         return;
     }
     
@@ -241,7 +308,7 @@ static void uart_line_callback(const char *line, void *user_data)
         ESP_LOGI(TAG, "GPS fix obtained!");
         data->state = STATE_RUNNING;
         parse_lat_lon(line, data);
-        data->needs_redraw = true;
+        screen_manager_data_changed(data->self);
         return;
     }
     
@@ -249,7 +316,7 @@ static void uart_line_callback(const char *line, void *user_data)
     if (strstr(line, "GPS fix lost") != NULL) {
         ESP_LOGW(TAG, "GPS fix lost!");
         data->state = STATE_GPS_LOST;
-        data->needs_redraw = true;
+        screen_manager_data_changed(data->self);
         return;
     }
     
@@ -258,7 +325,7 @@ static void uart_line_callback(const char *line, void *user_data)
         ESP_LOGI(TAG, "GPS fix recovered!");
         data->state = STATE_RUNNING;
         parse_lat_lon(line, data);
-        data->needs_redraw = true;
+        screen_manager_data_changed(data->self);
         return;
     }
     
@@ -266,9 +333,10 @@ static void uart_line_callback(const char *line, void *user_data)
     const char *promisc_stat = strstr(line, "Wardrive promisc:");
     if (promisc_stat) {
         int n = 0;
-        if (sscanf(promisc_stat, "Wardrive promisc: %d unique networks", &n) == 1) {
+        if (!data->index_ready &&
+            sscanf(promisc_stat, "Wardrive promisc: %d unique networks", &n) == 1) {
             data->unique_networks = n;
-            data->needs_redraw = true;
+            screen_manager_data_changed(data->self);
         }
         return;
     }
@@ -314,12 +382,25 @@ static void draw_screen(screen_t *self)
         char status_line[48];
         snprintf(status_line, sizeof(status_line), "Wardriving, %d networks found.", data->unique_networks);
         ui_print(0, row, status_line, UI_COLOR_TEXT);
-        row += 2;
+        row++;
+        
+        if (data->index_ready) {
+            wardrive_index_stats_t st;
+            wardrive_index_get_stats(&st);
+            snprintf(status_line, sizeof(status_line), "%s2G %lu 5G %lu  +%lu/min",
+                     st.exact ? "" : "~",
+                     (unsigned long)st.by_band[WIFI_BAND_2G],
+                     (unsigned long)st.by_band[WIFI_BAND_5G],
+                     (unsigned long)st.new_last_minute);
+            ui_print(0, row, status_line, UI_COLOR_DIMMED);
+        }
+        row++;
         
         if (data->last_ssid[0] != '\0') {
             char ssid_line[80];
-            snprintf(ssid_line, sizeof(ssid_line), "Last SSID: %s", data->last_ssid);
-            ui_print(0, row, ssid_line, UI_COLOR_TEXT);
+            snprintf(ssid_line, sizeof(ssid_line), "%s %s",
+                     data->last_is_new ? "New SSID:" : "Last SSID:", data->last_ssid);
+            ui_print(0, row, ssid_line, data->last_is_new ? UI_COLOR_HIGHLIGHT : UI_COLOR_TEXT);
         } else {
             ui_print(0, row, "Last SSID: -", UI_COLOR_DIMMED);
         }
@@ -343,12 +424,24 @@ static void draw_screen(screen_t *self)
     }
     
     // Draw status bar
-    ui_draw_status("ESC: Stop & Exit");
+    if (data->log_open) {
+        char status[40];
+        snprintf(status, sizeof(status), "ESC: Stop  B: Bg  Log: %lu",
+                 (unsigned long)wardrive_log_count());
+        ui_draw_status(status);
+    } else {
+        ui_draw_status("ESC: Stop  B: Background");
+    }
 }
 
 static void on_key(screen_t *self, key_code_t key)
 {
     switch (key) {
+        case KEY_B:
+            // Keep wardriving (and logging) while other views are open
+            job_manager_background(JOB_WARDRIVE, self);
+            break;
+            
         case KEY_ESC:
         case KEY_Q:
         case KEY_BACKSPACE:
@@ -374,11 +467,21 @@ static void on_destroy(screen_t *self)
     
     // Deinit CAP GPS if active
     if (data && data->is_cap_gps) {
+        cap_gps_set_fix_callback(NULL, NULL);
         cap_gps_deinit();
     }
     
-    // Clear UART callback
-    uart_clear_line_callback();
+    // No fixes arrive any more
+    if (data && data->track_open) {
+        track_log_close();
+    }
+    
+    if (data && data->log_open) {
+        wardrive_log_close();
+    }
+    if (data && data->index_ready) {
+        wardrive_index_free();
+    }
     
     if (data) {
         free(data);
@@ -408,28 +511,32 @@ screen_t* wardrive_screen_create(void *params)
     data->lon[0] = '\0';
     data->is_cap_gps = (settings_get_gps_type() == GPS_TYPE_CAP);
     data->wardrive_started = false;
-    data->cap_tick_counter = 0;
     
     screen->user_data = data;
     screen->on_key = on_key;
     screen->on_destroy = on_destroy;
     screen->on_draw = draw_screen;
     
-    // Create periodic refresh timer
-    esp_timer_create_args_t timer_args = {
-        .callback = refresh_timer_callback,
-        .arg = data,
-        .name = "wardrive_refresh"
-    };
-    
-    if (esp_timer_create(&timer_args, &data->refresh_timer) == ESP_OK) {
-        esp_timer_start_periodic(data->refresh_timer, REFRESH_INTERVAL_US);
-    } else {
-        ESP_LOGW(TAG, "Failed to create refresh timer");
+    // Redraws follow the data; only the CAP wait view polls
+    if (data->is_cap_gps) {
+        esp_timer_create_args_t timer_args = {
+            .callback = refresh_timer_callback,
+            .arg = data,
+            .name = "wardrive_refresh"
+        };
+        
+        if (esp_timer_create(&timer_args, &data->refresh_timer) == ESP_OK) {
+            esp_timer_start_periodic(data->refresh_timer, CAP_POLL_INTERVAL_US);
+        } else {
+            ESP_LOGW(TAG, "Failed to create refresh timer");
+        }
     }
     
+    data->log_open = (wardrive_log_open() == ESP_OK);
+    data->index_ready = (wardrive_index_init() == ESP_OK);
+    
     // Register UART callback for parsing wardrive output
-    uart_register_line_callback(uart_line_callback, data);
+    screen_set_line_callback(screen, uart_line_callback, data);
     
     // Draw initial screen first (shows "Acquiring GPS Fix...")
     draw_screen(screen);
@@ -437,13 +544,17 @@ screen_t* wardrive_screen_create(void *params)
     if (data->is_cap_gps) {
         // CAP GPS mode: init UART2 driver, wait for fix in timer callback
         ESP_LOGI(TAG, "CAP GPS mode - initializing CAP GPS driver...");
+        gps_uplink_reset();
+        data->track_open = (track_log_open() == ESP_OK);
+        cap_gps_set_fix_callback(cap_fix_callback, data);
         esp_err_t ret = cap_gps_init();
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "Failed to init CAP GPS: %s", esp_err_to_name(ret));
         }
-        // Wardrive will start when fix is obtained (in refresh_timer_callback)
+        // Wardrive will start when fix is obtained (in cap_fix_callback)
     } else {
         // Non-CAP GPS: existing behavior
+        display_flush();
         vTaskDelay(pdMS_TO_TICKS(3000));
         uart_send_command("start_wardrive_promisc");
         data->wardrive_started = true;
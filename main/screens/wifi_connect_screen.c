@@ -116,7 +116,9 @@ static void on_tick(screen_t *self)
             input_params->hint = "Network name";
             input_params->on_submit = on_ssid_submitted;
             input_params->user_data = data;
-            screen_manager_push(text_input_screen_create, input_params);
+            input_params->history = "ssid";
+            input_params->complete_ssids = true;
+            if (screen_manager_push(text_input_screen_create, input_params) == ESP_ERR_NO_MEM) free(input_params);
         }
         return;
     }
@@ -153,7 +155,9 @@ static void on_ssid_submitted(const char *text, void *user_data)
         params->hint = "WiFi password";
         params->on_submit = on_password_submitted;
         params->user_data = data;
-        screen_manager_push(text_input_screen_create, params);
+        params->history = "password";
+        params->complete_ssids = false;
+        if (screen_manager_push(text_input_screen_create, params) == ESP_ERR_NO_MEM) free(params);
     }
 }
 
@@ -178,7 +182,7 @@ static void on_password_submitted(const char *text, void *user_data)
     draw_screen(data->self);
     
     // Register UART callback
-    uart_register_line_callback(uart_line_callback, data);
+    screen_set_line_callback(data->self, uart_line_callback, data);
     
     // Send connect command
     char cmd[128];
@@ -211,8 +215,6 @@ static void on_key(screen_t *self, key_code_t key)
 
 static void on_destroy(screen_t *self)
 {
-    uart_clear_line_callback();
-    
     if (self->user_data) {
         free(self->user_data);
     }
@@ -4,9 +4,11 @@
  */
 
 #include "wifi_scan_screen.h"
+#include "screen_registry.h"
 #include "network_list_screen.h"
 #include "text_ui.h"
 #include "uart_handler.h"
+#include "network_store.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include <string.h>
@@ -17,14 +19,12 @@ static const char *TAG = "WIFI_SCAN";
 typedef struct {
     esp_timer_handle_t update_timer;
     bool scan_complete;
-    wifi_network_t *networks;
-    int network_count;
+    bool scan_started;          // Scan command accepted
     int animation_frame;
     screen_t *screen;
 } wifi_scan_data_t;
 
 // Forward declarations
-static void on_scan_complete(wifi_network_t *networks, int count, void *user_data);
 static void update_timer_callback(void *arg);
 static void draw_screen(screen_t *self);
 static void draw_screen_full(screen_t *self);
@@ -56,60 +56,42 @@ static void on_destroy(screen_t *self)
             esp_timer_delete(data->update_timer);
         }
         
-        if (data->networks) {
-            free(data->networks);
-        }
-        
         free(data);
     }
 }
 
-static void on_scan_complete(wifi_network_t *networks, int count, void *user_data)
+static void update_timer_callback(void *arg)
 {
-    wifi_scan_data_t *data = (wifi_scan_data_t *)user_data;
+    wifi_scan_data_t *data = (wifi_scan_data_t *)arg;
     
-    ESP_LOGI(TAG, "Scan complete callback, %d networks", count);
+    // Runs in the esp_timer task: draws and replaces the screen, so take the
+    // UI lock and let the render task push the result
+    screen_manager_lock();
     
-    // Copy networks
-    if (count > 0) {
-        data->networks = malloc(count * sizeof(wifi_network_t));
-        if (data->networks) {
-            memcpy(data->networks, networks, count * sizeof(wifi_network_t));
-            data->network_count = count;
-        }
+    // The screen may have been destroyed while we waited for the lock
+    screen_t *current = screen_manager_get_current();
+    if (!current || current->user_data != data) {
+        screen_manager_unlock();
+        return;
     }
     
-    data->scan_complete = true;
-}
-
-static void update_timer_callback(void *arg)
-{
-    wifi_scan_data_t *data = (wifi_scan_data_t *)arg;
-    
-    if (data->scan_complete) {
-        // Stop timer
+    if (data->scan_started && network_store_count() > 0) {
+        // First rows are in: the list screen keeps reading the store while
+        // the operator starts selecting targets
         esp_timer_stop(data->update_timer);
-        
-        // Transition to network list screen
-        if (data->network_count > 0) {
-            // Create params structure
-            network_list_params_t *params = malloc(sizeof(network_list_params_t));
-            if (params) {
-                params->networks = data->networks;
-                params->count = data->network_count;
-                data->networks = NULL;  // Transfer ownership
-                
-                screen_manager_replace(network_list_screen_create, params);
-            }
-        } else {
-            // No networks found, redraw with message
-            draw_screen_full(data->screen);
-        }
+        screen_manager_replace(network_list_screen_create, NULL);
+    } else if (!data->scan_started || !uart_is_scanning()) {
+        // No networks found (or the scan never started), redraw with message
+        esp_timer_stop(data->update_timer);
+        data->scan_complete = true;
+        draw_screen_full(data->screen);
     } else {
         // Update animation - only spinner, no full redraw
         data->animation_frame = (data->animation_frame + 1) % 4;
         update_spinner(data->screen);
     }
+    screen_manager_unlock();
+    screen_manager_request_frame();
 }
 
 static void draw_screen_full(screen_t *self)
@@ -121,7 +103,7 @@ static void draw_screen_full(screen_t *self)
     // Draw title
     ui_draw_title("WiFi Scan");
     
-    if (data->scan_complete && data->network_count == 0) {
+    if (data->scan_complete) {
         // No networks found
         ui_print_center(3, "No networks found", UI_COLOR_TEXT);
     } else {
@@ -191,12 +173,14 @@ screen_t* wifi_scan_screen_create(void *params)
     esp_timer_create(&timer_args, &data->update_timer);
     esp_timer_start_periodic(data->update_timer, 200000);  // 200ms
     
-    // Start WiFi scan
-    esp_err_t ret = uart_start_wifi_scan(on_scan_complete, data);
-    if (ret != ESP_OK) {
+    // Start WiFi scan; results stream into the network store
+    data->scan_started = (uart_start_wifi_scan(NULL, NULL) == ESP_OK);
+    if (!data->scan_started) {
         ESP_LOGE(TAG, "Failed to start scan");
     }
     
     ESP_LOGI(TAG, "WiFi scan screen created");
     return screen;
 }
+
+SCREEN_REGISTER(HOME, 10, wifi_scan_screen_create, 0, "WiFi Scan & Attack", "WiFi Scan & Test");
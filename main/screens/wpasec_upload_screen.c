@@ -6,7 +6,8 @@
  * 1. Check WiFi connection → if not connected show error
  * 2. Send "wpasec_key read" to check if API key is configured
  * 3. If key missing → show instructions
- * 4. If key present + WiFi + SD card → send "wpasec_upload" and display results
+ * 4. If key present + WiFi + SD card → send "wpasec_upload" and follow its
+ *    progress (UART_OP_WPASEC_UPLOAD in uart_progress.h) to the summary
  *
  * Redraws are deferred to on_tick (main task) to avoid SPI bus conflicts
  * with UART callbacks running on a separate task/core.
@@ -14,7 +15,9 @@
 
 #include "wpasec_upload_screen.h"
 #include "uart_handler.h"
+#include "uart_progress.h"
 #include "text_ui.h"
+#include "ui_widget.h"
 #include "esp_log.h"
 #include <string.h>
 #include <stdlib.h>
@@ -40,14 +43,13 @@ typedef enum {
 typedef struct {
     wpasec_state_t state;
     volatile bool needs_redraw;   // set from UART callback, consumed in on_tick
-    int uploaded;
-    int duplicate;
-    int failed;
+    ui_progress_t progress;
+    uint32_t progress_seq;        // Last uart_progress sequence shown
+    uart_progress_record_t result;
 } wpasec_data_t;
 
 // Forward declarations
 static void draw_screen(screen_t *self);
-static void upload_callback(const char *line, void *user_data);
 
 /**
  * @brief UART callback for wpasec_key read response
@@ -71,49 +73,17 @@ static void key_check_callback(const char *line, void *user_data)
                 data->state = STATE_NO_SD;
                 data->needs_redraw = true;
             } else {
+                // Progress is tracked by uart_progress from here on; the
+                // state change leaves this callback inert
+                uart_progress_begin(UART_OP_WPASEC_UPLOAD, "Uploading...", 0);
                 data->state = STATE_UPLOADING;
                 data->needs_redraw = true;
-                // Switch to upload callback before sending command
-                uart_register_line_callback(upload_callback, data);
                 uart_send_command("wpasec_upload");
             }
         }
     }
 }
 
-/**
- * @brief UART callback for wpasec_upload response
- * Runs on the UART RX task — must NOT touch display/SPI.
- */
-static void upload_callback(const char *line, void *user_data)
-{
-    wpasec_data_t *data = (wpasec_data_t *)user_data;
-    if (!data || data->state != STATE_UPLOADING) return;
-
-    // Look for "Done: %d uploaded, %d duplicate, %d failed"
-    if (strstr(line, "Done:") != NULL) {
-        int uploaded = 0, duplicate = 0, failed = 0;
-        const char *p = strstr(line, "Done:");
-        if (p && sscanf(p, "Done: %d uploaded, %d duplicate, %d failed",
-                        &uploaded, &duplicate, &failed) == 3) {
-            ESP_LOGI(TAG, "Upload done: %d uploaded, %d duplicate, %d failed",
-                     uploaded, duplicate, failed);
-            data->uploaded = uploaded;
-            data->duplicate = duplicate;
-            data->failed = failed;
-            data->state = STATE_UPLOAD_DONE;
-            data->needs_redraw = true;
-        } else {
-            // "Done" found but could not parse numbers
-            data->state = STATE_UPLOAD_FAILED;
-            data->needs_redraw = true;
-        }
-    } else if (strstr(line, "Failed") != NULL || strstr(line, "Error") != NULL) {
-        data->state = STATE_UPLOAD_FAILED;
-        data->needs_redraw = true;
-    }
-}
-
 static void draw_screen(screen_t *self)
 {
     wpasec_data_t *data = (wpasec_data_t *)self->user_data;
@@ -142,23 +112,25 @@ static void draw_screen(screen_t *self)
         break;
 
     case STATE_UPLOADING:
-        ui_print_center(3, "Uploading...", UI_COLOR_TEXT);
+        uart_progress_get(UART_OP_WPASEC_UPLOAD, &data->result);
+        ui_progress_set(&data->progress, &data->result);
         break;
 
     case STATE_UPLOAD_DONE: {
         char buf[32];
         ui_print_center(2, "Upload complete!", UI_COLOR_HIGHLIGHT);
-        snprintf(buf, sizeof(buf), "Uploaded:  %d", data->uploaded);
+        snprintf(buf, sizeof(buf), "Uploaded:  %u", data->result.done);
         ui_print_center(3, buf, UI_COLOR_TEXT);
-        snprintf(buf, sizeof(buf), "Duplicate: %d", data->duplicate);
+        snprintf(buf, sizeof(buf), "Duplicate: %u", data->result.skipped);
         ui_print_center(4, buf, UI_COLOR_TEXT);
-        snprintf(buf, sizeof(buf), "Failed:    %d", data->failed);
+        snprintf(buf, sizeof(buf), "Failed:    %u", data->result.failed);
         ui_print_center(5, buf, UI_COLOR_TEXT);
         break;
     }
 
     case STATE_UPLOAD_FAILED:
-        ui_print_center(3, "Failed to send.", UI_COLOR_HIGHLIGHT);
+        ui_print_center(3, data->result.text[0] ? data->result.text : "Failed to send.",
+                        UI_COLOR_HIGHLIGHT);
         break;
     }
 
@@ -172,7 +144,27 @@ static void draw_screen(screen_t *self)
 static void on_tick(screen_t *self)
 {
     wpasec_data_t *data = (wpasec_data_t *)self->user_data;
-    if (data && data->needs_redraw) {
+    if (!data) return;
+
+    if (data->state == STATE_UPLOADING) {
+        uint32_t seq = uart_progress_get(UART_OP_WPASEC_UPLOAD, &data->result);
+        if (seq != data->progress_seq) {
+            data->progress_seq = seq;
+            if (data->result.state == UART_PROGRESS_DONE) {
+                ESP_LOGI(TAG, "Upload done: %u uploaded, %u duplicate, %u failed",
+                         data->result.done, data->result.skipped, data->result.failed);
+                data->state = STATE_UPLOAD_DONE;
+                data->needs_redraw = true;
+            } else if (data->result.state == UART_PROGRESS_ERROR) {
+                data->state = STATE_UPLOAD_FAILED;
+                data->needs_redraw = true;
+            } else if (!data->needs_redraw) {
+                ui_progress_set(&data->progress, &data->result);
+            }
+        }
+    }
+
+    if (data->needs_redraw) {
         data->needs_redraw = false;
         draw_screen(self);
     }
@@ -185,7 +177,6 @@ static void on_key(screen_t *self, key_code_t key)
     switch (key) {
     case KEY_ESC:
     case KEY_BACKSPACE:
-        uart_clear_line_callback();
         screen_manager_pop();
         break;
     default:
@@ -197,8 +188,6 @@ static void on_destroy(screen_t *self)
 {
     wpasec_data_t *data = (wpasec_data_t *)self->user_data;
 
-    uart_clear_line_callback();
-
     if (data) {
         free(data);
     }
@@ -219,6 +208,8 @@ screen_t* wpasec_upload_screen_create(void *params)
         return NULL;
     }
 
+    ui_progress_init(&data->progress, 3);
+
     screen->user_data = data;
     screen->on_key = on_key;
     screen->on_destroy = on_destroy;
@@ -237,7 +228,7 @@ screen_t* wpasec_upload_screen_create(void *params)
     data->state = STATE_CHECKING_KEY;
     draw_screen(screen);
 
-    uart_register_line_callback(key_check_callback, data);
+    screen_set_line_callback(screen, key_check_callback, data);
     uart_send_command("wpasec_key read");
     // Callback will set needs_redraw → on_tick (main loop) redraws safely.
 
@@ -0,0 +1,185 @@
+/**
+ * @file sd_listing.c
+ * @brief Cached list_sd directory listing shared by the HTML pickers
+ */
+
+#include "sd_listing.h"
+#include "uart_handler.h"
+#include "janos_proto.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <ctype.h>
+
+static const char *TAG = "SD_LIST";
+
+#define LIST_CMD        "list_sd"
+#define LIST_HEADER     "HTML files found"
+
+// Published listing (readers copy under list_mutex)
+static sd_file_t files[SD_LISTING_MAX_FILES];
+static int file_count = 0;
+static volatile sd_listing_state_t state = SD_LISTING_EMPTY;
+static volatile uint32_t generation = 0;
+static volatile bool stale = false;         // Invalidated while a listing was in flight
+static SemaphoreHandle_t list_mutex = NULL;
+static int watch_route = -1;
+
+// Filled by the UART RX task while list_sd runs
+static sd_file_t staging[SD_LISTING_MAX_FILES];
+static int staging_count = 0;
+static bool got_header = false;
+
+/**
+ * @brief Watch for JanOS SD card messages that make the listing outdated
+ */
+static void watch_line(const char *line, void *user_data)
+{
+    (void)user_data;
+    if (strstr(line, "SD card") != NULL && strstr(line, LIST_HEADER) == NULL) {
+        sd_listing_invalidate();
+    }
+}
+
+/**
+ * @brief Parse one reply line: header, then "N filename" rows
+ * @return true once a non-row line follows the rows
+ */
+static bool on_list_line(const char *line, void *user_data)
+{
+    (void)user_data;
+
+    if (strstr(line, LIST_HEADER) != NULL) {
+        got_header = true;
+        staging_count = 0;
+        return false;
+    }
+
+    // Blank lines neither add a row nor end the listing
+    if (line[strspn(line, " \t\r\n")] == '\0') return false;
+
+    janos_list_row_t row;
+    if (janos_parse_list_row(line, &row)) {
+        if (staging_count < SD_LISTING_MAX_FILES) {
+            sd_file_t *f = &staging[staging_count++];
+            f->id = row.id;
+            janos_span_copy(row.name, f->name, sizeof(f->name));
+        }
+        return false;
+    }
+
+    // Anything else after the rows (prompt, next reply) ends the listing
+    return got_header && staging_count > 0;
+}
+
+static void on_list_done(uart_request_status_t status, void *user_data)
+{
+    (void)user_data;
+
+    // list_sd has no trailer, so a timeout after the header is a normal end
+    xSemaphoreTake(list_mutex, portMAX_DELAY);
+    if (got_header) {
+        memcpy(files, staging, sizeof(staging[0]) * staging_count);
+        file_count = staging_count;
+        state = stale ? SD_LISTING_EMPTY : SD_LISTING_READY;
+        ESP_LOGI(TAG, "Listed %d files", file_count);
+    } else {
+        file_count = 0;
+        state = SD_LISTING_EMPTY;
+        ESP_LOGW(TAG, "No listing from JanOS (%s)",
+                 status == UART_REQUEST_TIMEOUT ? "timeout" : "no header");
+    }
+    stale = false;
+    generation++;
+    xSemaphoreGive(list_mutex);
+}
+
+esp_err_t sd_listing_refresh(bool force)
+{
+    if (!list_mutex) {
+        list_mutex = xSemaphoreCreateMutex();
+        if (!list_mutex) return ESP_ERR_NO_MEM;
+    }
+    if (watch_route < 0) {
+        watch_route = uart_subscribe_lines(UART_ROUTE_ANY, NULL, watch_line, NULL);
+    }
+
+    if (state == SD_LISTING_LOADING) return ESP_OK;
+    if (state == SD_LISTING_READY && !force) return ESP_OK;
+
+    got_header = false;
+    staging_count = 0;
+    state = SD_LISTING_LOADING;
+
+    const uart_request_t req = {
+        .cmd = LIST_CMD,
+        .on_line = on_list_line,
+        .on_done = on_list_done,
+        .timeout_ms = SD_LISTING_TIMEOUT_MS,
+    };
+    esp_err_t ret = uart_request(&req);
+    if (ret != ESP_OK) {
+        state = SD_LISTING_EMPTY;
+    }
+    return ret;
+}
+
+void sd_listing_invalidate(void)
+{
+    if (state == SD_LISTING_LOADING) {
+        stale = true;
+    } else if (state == SD_LISTING_READY) {
+        state = SD_LISTING_EMPTY;
+    }
+}
+
+sd_listing_state_t sd_listing_state(void)
+{
+    return state;
+}
+
+uint32_t sd_listing_generation(void)
+{
+    return generation;
+}
+
+/**
+ * @brief Case-insensitive glob match ('*' any run, '?' any one character)
+ */
+static bool glob_match(const char *pattern, const char *text)
+{
+    while (*pattern) {
+        if (*pattern == '*') {
+            pattern++;
+            if (!*pattern) return true;
+            for (; *text; text++) {
+                if (glob_match(pattern, text)) return true;
+            }
+            return false;
+        }
+        if (!*text) return false;
+        if (*pattern != '?' &&
+            tolower((unsigned char)*pattern) != tolower((unsigned char)*text)) {
+            return false;
+        }
+        pattern++;
+        text++;
+    }
+    return *text == '\0';
+}
+
+int sd_listing_copy(const char *pattern, sd_file_t *out, int max)
+{
+    if (!list_mutex || !out) return 0;
+
+    xSemaphoreTake(list_mutex, portMAX_DELAY);
+    int n = 0;
+    for (int i = 0; i < file_count && n < max; i++) {
+        if (!pattern || glob_match(pattern, files[i].name)) {
+            out[n++] = files[i];
+        }
+    }
+    xSemaphoreGive(list_mutex);
+    return n;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file sd_listing.h
+ * @brief Cached list_sd directory listing shared by the HTML pickers
+ *
+ * One list_sd is parsed into a published listing with a generation
+ * counter; pickers copy the files matching a pattern and redraw when the
+ * generation moves. The listing is fetched again only after JanOS prints
+ * an SD card message (mount, failure) or sd_listing_invalidate() is
+ * called, so opening a picker after the first time costs no UART traffic.
+ */
+
+#ifndef SD_LISTING_H
+#define SD_LISTING_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SD_LISTING_MAX_FILES    64
+#define SD_LISTING_NAME_LEN     48
+#define SD_LISTING_TIMEOUT_MS   3000
+#define SD_LISTING_HTML         "*.html"    // Pattern for the portal pickers
+
+typedef enum {
+    SD_LISTING_EMPTY = 0,       // Never listed, or invalidated
+    SD_LISTING_LOADING,         // list_sd in flight
+    SD_LISTING_READY,
+} sd_listing_state_t;
+
+// One file as listed by JanOS
+typedef struct {
+    int id;                     // 1-based index for select_html
+    char name[SD_LISTING_NAME_LEN];
+} sd_file_t;
+
+/**
+ * @brief Fetch the listing unless a valid one is cached
+ * @param force List again even if the cached listing is valid
+ * @return ESP_OK if cached or requested, else the uart_request error
+ */
+esp_err_t sd_listing_refresh(bool force);
+
+/**
+ * @brief Drop the cached listing; the next refresh lists again
+ *
+ * Safe to call from UART callbacks.
+ */
+void sd_listing_invalidate(void);
+
+sd_listing_state_t sd_listing_state(void);
+
+/**
+ * @brief Bumps whenever a new listing is published or the cache is dropped
+ */
+uint32_t sd_listing_generation(void);
+
+/**
+ * @brief Copy the files whose names match a pattern
+ * @param pattern Case-insensitive glob with '*' and '?', e.g. "*.html" (NULL = all)
+ * @param out Receives the files in listing order
+ * @param max Capacity of out
+ * @return Number of files copied
+ */
+int sd_listing_copy(const char *pattern, sd_file_t *out, int max);
+
+#endif // SD_LISTING_H
@@ -0,0 +1,490 @@
+/**
+ * @file session_file.c
+ * @brief Session log files on SD, plain or LZ4-compressed in blocks
+ */
+
+#include "session_file.h"
+#include "session_log.h"
+#include "sd_io.h"
+#include "lz4_block.h"
+#include "power_governor.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "SESSION_FILE";
+
+#define FILE_MAGIC          "SLZ1"
+#define INDEX_MAGIC         "SLZI"
+#define INDEX_GROW          64          // Blocks added to the index at a time
+#define STORED_MAX          LZ4_BLOCK_BOUND(SESSION_FILE_BLOCK_SIZE)
+#define NO_DRAFT            SIZE_MAX
+
+struct session_file {
+    sd_file_t *io;
+    uint32_t text_size;
+#ifdef CONFIG_SESSION_LOG_COMPRESS
+    uint8_t *block;                 // Records of the open block
+    size_t block_fill;
+    uint32_t block_offset;          // Text offset of block[0]
+    size_t draft_at;                // Where its synced draft is stored, or NO_DRAFT
+    size_t draft_len;               // Record bytes in that draft
+    uint8_t *packed;                // Block header and stored bytes
+    uint16_t *table;                // lz4_block scratch
+    uint32_t *index;                // (text offset, stored offset) per block
+    int index_count;
+    int index_cap;
+    bool index_lost;                // Out of memory: close without the index
+#endif
+};
+
+struct session_file_reader {
+    FILE *f;
+    bool packed;
+    uint32_t size;                  // Text bytes
+    uint32_t *index;                // As written, or rebuilt from the headers
+    int count;
+    int cached;                     // Block in raw, -1 for none
+    uint8_t *raw;
+    size_t raw_len;
+    uint8_t *stored;
+};
+
+static void file_path(char *out, size_t size, int number, const char *ext)
+{
+    snprintf(out, size, "%s/session_%d.%s", SESSION_LOG_DIR, number, ext);
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return get_u16(p) | (uint32_t)get_u16(p + 2) << 16;
+}
+
+void session_file_remove(int number)
+{
+    char path[48];
+    file_path(path, sizeof(path), number, "log");
+    remove(path);
+    file_path(path, sizeof(path), number, "slz");
+    remove(path);
+}
+
+#ifdef CONFIG_SESSION_LOG_COMPRESS
+
+static bool add_to_index(session_file_t *f, uint32_t text_offset, uint32_t stored_offset)
+{
+    if (f->index_count == f->index_cap) {
+        uint32_t *grown = realloc(f->index, (f->index_cap + INDEX_GROW) * 2 * sizeof(uint32_t));
+        if (!grown) return false;
+        f->index = grown;
+        f->index_cap += INDEX_GROW;
+    }
+    f->index[2 * f->index_count] = text_offset;
+    f->index[2 * f->index_count + 1] = stored_offset;
+    f->index_count++;
+    return true;
+}
+
+/**
+ * @brief Compress and store the open block
+ * @param final The block is complete; otherwise it is a draft a later call replaces
+ */
+static esp_err_t write_block(session_file_t *f, bool final)
+{
+    if (f->draft_at != NO_DRAFT) {
+        if (f->block_fill == f->draft_len) {
+            // Nothing added since the draft, which stands as written
+            if (final) {
+                f->block_offset += f->block_fill;
+                f->block_fill = 0;
+                f->draft_at = NO_DRAFT;
+            }
+            return ESP_OK;
+        }
+        if (sd_io_rewind(f->io, f->draft_at) == ESP_OK) {
+            if (!f->index_lost) f->index_count--;
+        } else {
+            // The draft left the buffered chunk: it stays a short block
+            memmove(f->block, f->block + f->draft_len, f->block_fill - f->draft_len);
+            f->block_fill -= f->draft_len;
+            f->block_offset += f->draft_len;
+        }
+        f->draft_at = NO_DRAFT;
+    }
+    if (f->block_fill == 0) return ESP_OK;
+
+    uint8_t *payload = f->packed + SESSION_FILE_BLOCK_HEADER;
+    uint8_t flags = 0;
+    size_t stored = 0;
+    // A draft is replaced at the next sync: while saving power only the
+    // complete block is compressed
+    if (final || !power_governor_defer_compression()) {
+        stored = lz4_block_compress(f->block, f->block_fill, payload, STORED_MAX, f->table);
+    }
+    if (stored == 0 || stored >= f->block_fill) {
+        memcpy(payload, f->block, f->block_fill);
+        stored = f->block_fill;
+        flags |= SESSION_FILE_RAW;
+    }
+    f->packed[0] = SESSION_FILE_BLOCK_MARKER;
+    f->packed[1] = flags;
+    put_u16(f->packed + 2, (uint16_t)f->block_fill);
+    put_u16(f->packed + 4, (uint16_t)stored);
+    put_u32(f->packed + 6, f->block_offset);
+
+    size_t at = sd_io_size(f->io);
+    if (!f->index_lost && !add_to_index(f, f->block_offset, (uint32_t)at)) {
+        ESP_LOGW(TAG, "No memory for the block index, readers will rebuild it");
+        f->index_lost = true;
+    }
+    esp_err_t ret = sd_io_write(f->io, f->packed, SESSION_FILE_BLOCK_HEADER + stored);
+
+    if (final) {
+        f->block_offset += f->block_fill;
+        f->block_fill = 0;
+    } else {
+        f->draft_at = at;
+        f->draft_len = f->block_fill;
+    }
+    return ret;
+}
+
+static void free_file(session_file_t *f)
+{
+    free(f->block);
+    free(f->packed);
+    free(f->table);
+    free(f->index);
+    free(f);
+}
+
+session_file_t *session_file_create(int number, size_t prealloc)
+{
+    session_file_t *f = calloc(1, sizeof(session_file_t));
+    if (!f) return NULL;
+    f->block = malloc(SESSION_FILE_BLOCK_SIZE);
+    f->packed = malloc(SESSION_FILE_BLOCK_HEADER + STORED_MAX);
+    f->table = malloc(LZ4_BLOCK_TABLE_SIZE * sizeof(uint16_t));
+    f->draft_at = NO_DRAFT;
+    if (!f->block || !f->packed || !f->table) {
+        free_file(f);
+        return NULL;
+    }
+
+    char path[48];
+    file_path(path, sizeof(path), number, SESSION_FILE_EXT);
+    f->io = sd_io_open(path, prealloc);
+    if (!f->io) {
+        free_file(f);
+        return NULL;
+    }
+    uint8_t header[SESSION_FILE_HEADER_SIZE];
+    memcpy(header, FILE_MAGIC, 4);
+    put_u16(header + 4, SESSION_FILE_BLOCK_SIZE);
+    sd_io_write(f->io, header, sizeof(header));
+    return f;
+}
+
+esp_err_t session_file_append(session_file_t *f, const char *record, size_t len)
+{
+    if (!f || len > SESSION_FILE_BLOCK_SIZE) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t ret = ESP_OK;
+    if (f->block_fill + len > SESSION_FILE_BLOCK_SIZE) {
+        ret = write_block(f, true);
+    }
+    memcpy(f->block + f->block_fill, record, len);
+    f->block_fill += len;
+    f->text_size += len;
+    return ret;
+}
+
+esp_err_t session_file_sync(session_file_t *f)
+{
+    if (!f) return ESP_ERR_INVALID_ARG;
+    esp_err_t ret = write_block(f, false);
+    esp_err_t synced = sd_io_sync(f->io);
+    return ret != ESP_OK ? ret : synced;
+}
+
+esp_err_t session_file_close(session_file_t *f)
+{
+    if (!f) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t ret = write_block(f, true);
+    if (!f->index_lost) {
+        for (int i = 0; i < f->index_count && ret == ESP_OK; i++) {
+            uint8_t pair[8];
+            put_u32(pair, f->index[2 * i]);
+            put_u32(pair + 4, f->index[2 * i + 1]);
+            ret = sd_io_write(f->io, pair, sizeof(pair));
+        }
+        uint8_t trailer[8];
+        put_u32(trailer, (uint32_t)f->index_count);
+        memcpy(trailer + 4, INDEX_MAGIC, 4);
+        if (ret == ESP_OK) ret = sd_io_write(f->io, trailer, sizeof(trailer));
+    }
+    if (sd_io_close(f->io) != ESP_OK) ret = ESP_FAIL;
+    free_file(f);
+    return ret;
+}
+
+#else // CONFIG_SESSION_LOG_COMPRESS
+
+session_file_t *session_file_create(int number, size_t prealloc)
+{
+    session_file_t *f = calloc(1, sizeof(session_file_t));
+    if (!f) return NULL;
+    char path[48];
+    file_path(path, sizeof(path), number, SESSION_FILE_EXT);
+    f->io = sd_io_open(path, prealloc);
+    if (!f->io) {
+        free(f);
+        return NULL;
+    }
+    return f;
+}
+
+esp_err_t session_file_append(session_file_t *f, const char *record, size_t len)
+{
+    if (!f) return ESP_ERR_INVALID_ARG;
+    f->text_size += len;
+    return sd_io_write(f->io, record, len);
+}
+
+esp_err_t session_file_sync(session_file_t *f)
+{
+    return f ? sd_io_sync(f->io) : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t session_file_close(session_file_t *f)
+{
+    if (!f) return ESP_ERR_INVALID_ARG;
+    esp_err_t ret = sd_io_close(f->io);
+    free(f);
+    return ret;
+}
+
+#endif // CONFIG_SESSION_LOG_COMPRESS
+
+uint32_t session_file_text_size(const session_file_t *f)
+{
+    return f ? f->text_size : 0;
+}
+
+uint32_t session_file_stored_size(const session_file_t *f)
+{
+    return f ? (uint32_t)sd_io_size(f->io) : 0;
+}
+
+/**
+ * @brief Header of the block at pos, checked against the file size
+ */
+static bool read_block_header(FILE *f, long pos, long file_size, uint8_t header[SESSION_FILE_BLOCK_HEADER])
+{
+    if (pos + SESSION_FILE_BLOCK_HEADER > file_size ||
+        fseek(f, pos, SEEK_SET) != 0 ||
+        fread(header, SESSION_FILE_BLOCK_HEADER, 1, f) != 1) {
+        return false;
+    }
+    size_t stored = get_u16(header + 4);
+    return header[0] == SESSION_FILE_BLOCK_MARKER &&
+           get_u16(header + 2) <= SESSION_FILE_BLOCK_SIZE && stored <= STORED_MAX &&
+           pos + SESSION_FILE_BLOCK_HEADER + (long)stored <= file_size;
+}
+
+/**
+ * @brief Block index from the trailer, else by walking the block headers
+ */
+static bool load_index(session_file_reader_t *r, long file_size)
+{
+    uint8_t trailer[8];
+    if (fseek(r->f, file_size - 8, SEEK_SET) == 0 && fread(trailer, 8, 1, r->f) == 1 &&
+        memcmp(trailer + 4, INDEX_MAGIC, 4) == 0) {
+        uint32_t count = get_u32(trailer);
+        long index_at = file_size - 8 - (long)count * 8;
+        if (index_at >= SESSION_FILE_HEADER_SIZE) {
+            r->index = malloc((count ? count : 1) * 2 * sizeof(uint32_t));
+            if (!r->index) return false;
+            fseek(r->f, index_at, SEEK_SET);
+            uint8_t pair[8];
+            for (r->count = 0; r->count < (int)count; r->count++) {
+                if (fread(pair, 8, 1, r->f) != 1) return false;
+                r->index[2 * r->count] = get_u32(pair);
+                r->index[2 * r->count + 1] = get_u32(pair + 4);
+            }
+            file_size = index_at;
+        }
+    }
+
+    uint8_t header[SESSION_FILE_BLOCK_HEADER];
+    if (!r->index) {
+        // Cut short by a reset: the blocks up to the first bad header
+        int cap = 0;
+        long pos = SESSION_FILE_HEADER_SIZE;
+        while (read_block_header(r->f, pos, file_size, header)) {
+            if (r->count == cap) {
+                uint32_t *grown = realloc(r->index, (cap + INDEX_GROW) * 2 * sizeof(uint32_t));
+                if (!grown) return false;
+                r->index = grown;
+                cap += INDEX_GROW;
+            }
+            r->index[2 * r->count] = get_u32(header + 6);
+            r->index[2 * r->count + 1] = (uint32_t)pos;
+            r->count++;
+            pos += SESSION_FILE_BLOCK_HEADER + get_u16(header + 4);
+        }
+    }
+
+    r->size = 0;
+    if (r->count > 0 && read_block_header(r->f, r->index[2 * (r->count - 1) + 1], file_size, header)) {
+        r->size = get_u32(header + 6) + get_u16(header + 2);
+    }
+    return true;
+}
+
+session_file_reader_t *session_file_reader_open(int number)
+{
+    session_file_reader_t *r = calloc(1, sizeof(session_file_reader_t));
+    if (!r) return NULL;
+    r->cached = -1;
+
+    char path[48];
+    file_path(path, sizeof(path), number, "slz");
+    r->f = fopen(path, "rb");
+    r->packed = r->f != NULL;
+    if (!r->f) {
+        file_path(path, sizeof(path), number, "log");
+        r->f = fopen(path, "rb");
+    }
+    if (!r->f) {
+        free(r);
+        return NULL;
+    }
+
+    fseek(r->f, 0, SEEK_END);
+    long file_size = ftell(r->f);
+    if (!r->packed) {
+        r->size = file_size > 0 ? (uint32_t)file_size : 0;
+        return r;
+    }
+
+    char magic[4];
+    r->raw = malloc(SESSION_FILE_BLOCK_SIZE);
+    r->stored = malloc(STORED_MAX);
+    bool ok = r->raw && r->stored && fseek(r->f, 0, SEEK_SET) == 0 &&
+              fread(magic, 4, 1, r->f) == 1 && memcmp(magic, FILE_MAGIC, 4) == 0 &&
+              load_index(r, file_size);
+    if (!ok) {
+        ESP_LOGW(TAG, "%s: not a readable session log", path);
+        session_file_reader_close(r);
+        return NULL;
+    }
+    return r;
+}
+
+/**
+ * @brief Decompress block i into raw
+ */
+static bool load_block(session_file_reader_t *r, int i)
+{
+    if (r->cached == i) return true;
+    r->cached = -1;
+
+    uint8_t header[SESSION_FILE_BLOCK_HEADER];
+    if (fseek(r->f, r->index[2 * i + 1], SEEK_SET) != 0 ||
+        fread(header, sizeof(header), 1, r->f) != 1 ||
+        header[0] != SESSION_FILE_BLOCK_MARKER) {
+        return false;
+    }
+    size_t raw_len = get_u16(header + 2);
+    size_t stored = get_u16(header + 4);
+    if (raw_len > SESSION_FILE_BLOCK_SIZE || stored > STORED_MAX ||
+        fread(r->stored, 1, stored, r->f) != stored) {
+        return false;
+    }
+    if (header[1] & SESSION_FILE_RAW) {
+        if (stored != raw_len) return false;
+        memcpy(r->raw, r->stored, stored);
+    } else if (lz4_block_decompress(r->stored, stored, r->raw, raw_len) != (int)raw_len) {
+        return false;
+    }
+    r->raw_len = raw_len;
+    r->cached = i;
+    return true;
+}
+
+static size_t read_packed(session_file_reader_t *r, uint32_t offset, char *out, size_t size)
+{
+    // Last block starting at or before offset
+    int lo = 0, hi = r->count - 1, block = -1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (r->index[2 * mid] <= offset) {
+            block = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    if (block < 0 || !load_block(r, block)) return 0;
+
+    size_t pos = offset - r->index[2 * block];
+    if (pos >= r->raw_len) return 0;
+    const uint8_t *start = r->raw + pos;
+    const uint8_t *nl = memchr(start, '\n', r->raw_len - pos);
+    if (!nl) return 0;
+    size_t len = nl - start;
+    size_t copy = len < size - 1 ? len : size - 1;
+    memcpy(out, start, copy);
+    out[copy] = '\0';
+    return len + 1;
+}
+
+size_t session_file_read(session_file_reader_t *r, uint32_t offset, char *out, size_t size)
+{
+    if (!r || !out || size < 2) return 0;
+    if (r->packed) return read_packed(r, offset, out, size);
+
+    if (offset >= r->size || fseek(r->f, offset, SEEK_SET) != 0 || !fgets(out, size, r->f)) {
+        return 0;
+    }
+    // A reset leaves the preallocated tail as zeros; a longer line is not a record
+    size_t len = strlen(out);
+    if (len == 0 || out[len - 1] != '\n') return 0;
+    out[len - 1] = '\0';
+    return len;
+}
+
+uint32_t session_file_reader_size(const session_file_reader_t *r)
+{
+    return r ? r->size : 0;
+}
+
+void session_file_reader_close(session_file_reader_t *r)
+{
+    if (!r) return;
+    if (r->f) fclose(r->f);
+    free(r->index);
+    free(r->raw);
+    free(r->stored);
+    free(r);
+}
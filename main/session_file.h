@@ -0,0 +1,121 @@
+/**
+ * @file session_file.h
+ * @brief Session log files on SD, plain or LZ4-compressed in blocks
+ *
+ * With CONFIG_SESSION_LOG_COMPRESS, records are collected into blocks of
+ * up to SESSION_FILE_BLOCK_SIZE bytes of whole records, each compressed
+ * on its own (lz4_block) by the writer task. Blocks end on record
+ * boundaries and never refer to each other, so a reader can seek to any
+ * record by decompressing one block. Without the option, records are
+ * appended as text to session_N.log.
+ *
+ * File /sdcard/logs/session_N.slz (little-endian):
+ *
+ *   header  "SLZ1", u16 block_size
+ *   block   u8 0xB2, u8 flags, u16 raw_len, u16 stored_len, u32 raw_offset,
+ *           stored_len bytes: LZ4 block, or raw text with SESSION_FILE_RAW
+ *   index   n x (u32 raw_offset, u32 file_offset), u32 n, "SLZI"
+ *
+ * raw_offset is the block's position in the uncompressed text, which is
+ * what record offsets (session_index) refer to. The index of blocks is
+ * written on close; a file cut short by a reset lacks it, and readers find
+ * the blocks by walking their headers up to the first invalid one.
+ *
+ * A sync writes the open block as it stands. Records added after it are
+ * not lost on a reset, but the block is not final: the next sync or the
+ * block filling up rewrites it in place while it is still in sd_io's
+ * buffered chunk, so slow logging still produces full-size blocks.
+ * tools/slz_to_log.py turns a file back into the text log.
+ */
+
+#ifndef SESSION_FILE_H
+#define SESSION_FILE_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define SESSION_FILE_BLOCK_SIZE     4096        // Raw bytes per block
+#define SESSION_FILE_BLOCK_MARKER   0xB2
+#define SESSION_FILE_RAW            0x01        // Block flag: stored uncompressed
+#define SESSION_FILE_HEADER_SIZE    6
+#define SESSION_FILE_BLOCK_HEADER   10
+
+#ifdef CONFIG_SESSION_LOG_COMPRESS
+#include "lz4_block.h"
+#define SESSION_FILE_EXT            "slz"
+// Writer buffers beside sd_io's chunk: open block, compressed block, hash table
+#define SESSION_FILE_WRITE_MEM      (SESSION_FILE_BLOCK_SIZE + SESSION_FILE_BLOCK_HEADER + \
+                                     LZ4_BLOCK_BOUND(SESSION_FILE_BLOCK_SIZE) + \
+                                     LZ4_BLOCK_TABLE_SIZE * 2)
+#else
+#define SESSION_FILE_EXT            "log"
+#define SESSION_FILE_WRITE_MEM      0
+#endif
+
+typedef struct session_file session_file_t;
+typedef struct session_file_reader session_file_reader_t;
+
+/**
+ * @brief Create session_N.<SESSION_FILE_EXT> for appending (replaces it)
+ * @param prealloc Bytes to reserve on the card (sd_io_open)
+ * @return File, or NULL when the card is missing or out of memory
+ */
+session_file_t *session_file_create(int number, size_t prealloc);
+
+/**
+ * @brief Append one record (newline included)
+ * @return ESP_OK, or ESP_FAIL after a write error (the file stays failed)
+ */
+esp_err_t session_file_append(session_file_t *f, const char *record, size_t len);
+
+/**
+ * @brief Write everything appended so far to the card
+ */
+esp_err_t session_file_sync(session_file_t *f);
+
+/**
+ * @brief Write the last block and the block index, and close
+ * @return ESP_OK, or ESP_FAIL if anything was lost
+ */
+esp_err_t session_file_close(session_file_t *f);
+
+/**
+ * @brief Uncompressed bytes appended, the offset of the next record
+ */
+uint32_t session_file_text_size(const session_file_t *f);
+
+/**
+ * @brief Bytes on the card so far (rotation)
+ */
+uint32_t session_file_stored_size(const session_file_t *f);
+
+/**
+ * @brief Delete session_N in either format
+ */
+void session_file_remove(int number);
+
+/**
+ * @brief Open session_N for reading, compressed or plain
+ * @return Reader, or NULL if neither file exists
+ */
+session_file_reader_t *session_file_reader_open(int number);
+
+/**
+ * @brief Read the record starting at a text offset
+ * @param out Receives the record without its newline
+ * @return Bytes the record takes including the newline (the next record is
+ *         that far on), 0 past the end or on a read error
+ */
+size_t session_file_read(session_file_reader_t *r, uint32_t offset, char *out, size_t size);
+
+/**
+ * @brief Uncompressed bytes readable in the file
+ */
+uint32_t session_file_reader_size(const session_file_reader_t *r);
+
+void session_file_reader_close(session_file_reader_t *r);
+
+#endif // SESSION_FILE_H
@@ -0,0 +1,489 @@
+/**
+ * @file session_index.c
+ * @brief Hash index of session log records by MAC and SSID, kept on SD
+ */
+
+#include "session_index.h"
+#include "session_file.h"
+#include "mac_set.h"
+#include "mem_monitor.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *TAG = "SESSION_INDEX";
+
+#define RECORD_KEYS_MAX     4       // Keys taken from one record
+#define READ_BATCH          16      // Bucket entries per read
+
+typedef struct {
+    uint32_t key;
+    uint32_t offset;
+} index_entry_t;
+
+// On the card before each segment's entries, which follow sorted by key
+typedef struct {
+    uint32_t magic;
+    uint32_t end_offset;            // Log bytes covered once this segment is read
+    uint16_t count;
+    uint16_t bucket_start[SESSION_INDEX_BUCKETS + 1];
+} segment_header_t;
+
+// Entries of one log file not written out yet
+typedef struct {
+    int file;                       // 0 = none
+    uint32_t end_offset;
+    int count;
+    index_entry_t entries[SESSION_INDEX_SEGMENT];
+} segment_builder_t;
+
+MEM_BUDGET(session_index, 2 * SESSION_INDEX_SEGMENT, sizeof(index_entry_t), MEM_BUDGET_STATIC);
+
+static segment_builder_t live;          // The file being logged
+static segment_builder_t backfill;      // An older file being indexed
+static session_file_reader_t *backfill_log = NULL;
+static uint32_t backfill_offset;
+static int backfill_next;               // Next older file to check
+static int newest_file;
+static SemaphoreHandle_t lock = NULL;   // Builders and index file appends
+
+/**
+ * @brief 32-bit index key of a mac_set key (MAC or string)
+ */
+static uint32_t fold_key(uint64_t key)
+{
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static bool type_is(const char *type, session_log_type_t t)
+{
+    return strcmp(type, session_log_type_name(t)) == 0;
+}
+
+/**
+ * @brief First MAC in a field ("AA:BB:..." or "aa-bb-..."), if any
+ */
+static const char *find_mac(const char *field, uint64_t *key)
+{
+    for (const char *p = field; strlen(p) >= 17; p++) {
+        if (*p != ' ' && mac_set_key_from_mac(p, key)) return p;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Keys of one record: its MACs, and the SSID of typed network records
+ *
+ * The SSID is the field after the first whole-field MAC (scan, sniffer,
+ * deauth and frame handshake records), or the only field of a handshake
+ * record from the event bus.
+ */
+static int record_keys(const char *record, size_t len, uint64_t keys[RECORD_KEYS_MAX])
+{
+    char text[SESSION_LOG_RECORD_MAX + 1];
+    if (len > SESSION_LOG_RECORD_MAX) len = SESSION_LOG_RECORD_MAX;
+    memcpy(text, record, len);
+    text[len] = '\0';
+    text[strcspn(text, "\n")] = '\0';
+
+    // "<us>\t<TYPE>\t<fields>"
+    char *type = strchr(text, '\t');
+    if (!type) return 0;
+    type++;
+    char *field = strchr(type, '\t');
+    if (!field) return 0;
+    *field++ = '\0';
+
+    bool handshake = type_is(type, SESSION_LOG_HANDSHAKE);
+    bool want_ssid = handshake || type_is(type, SESSION_LOG_SCAN) ||
+                     type_is(type, SESSION_LOG_SNIFFER) || type_is(type, SESSION_LOG_DEAUTH);
+    bool after_mac = false;
+    int count = 0;
+
+    for (int index = 0; field && count < RECORD_KEYS_MAX; index++) {
+        char *next = strchr(field, '\t');
+        if (next) *next++ = '\0';
+
+        uint64_t key;
+        if (find_mac(field, &key)) {
+            keys[count++] = key;
+            after_mac = strlen(field) == 17;
+        } else {
+            bool ssid = after_mac || (handshake && index == 0 && !next);
+            if (want_ssid && ssid && field[0]) {
+                keys[count++] = mac_set_key_from_string(field);
+                want_ssid = false;
+            }
+            after_mac = false;
+        }
+        field = next;
+    }
+    return count;
+}
+
+/**
+ * @brief Key of a search: a MAC, else the whole text as an SSID
+ */
+static uint64_t query_key(const char *query)
+{
+    uint64_t key;
+    while (*query == ' ') query++;
+    if (strlen(query) == 17 && mac_set_key_from_mac(query, &key)) return key;
+    return mac_set_key_from_string(query);
+}
+
+void session_index_path(char *out, size_t size, int file)
+{
+    snprintf(out, size, "%s/session_%d.idx", SESSION_LOG_DIR, file);
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+    const index_entry_t *x = a, *y = b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return x->offset < y->offset ? -1 : x->offset > y->offset;
+}
+
+/**
+ * @brief Append the builder's entries as one segment and empty it (lock held)
+ */
+static void write_segment(segment_builder_t *b)
+{
+    if (b->file <= 0) return;
+
+    segment_header_t header = {
+        .magic = SESSION_INDEX_MAGIC,
+        .end_offset = b->end_offset,
+        .count = (uint16_t)b->count,
+    };
+    // Equal keys stay in offset order, which lookups rely on
+    qsort(b->entries, b->count, sizeof(index_entry_t), compare_entries);
+    int e = 0;
+    for (int bucket = 0; bucket <= SESSION_INDEX_BUCKETS; bucket++) {
+        while (e < b->count &&
+               (int)(b->entries[e].key >> (32 - SESSION_INDEX_BUCKET_BITS)) < bucket) {
+            e++;
+        }
+        header.bucket_start[bucket] = (uint16_t)e;
+    }
+    header.bucket_start[SESSION_INDEX_BUCKETS] = (uint16_t)b->count;
+
+    char path[48];
+    session_index_path(path, sizeof(path), b->file);
+    FILE *f = fopen(path, "ab");
+    bool ok = f && fwrite(&header, sizeof(header), 1, f) == 1 &&
+              (b->count == 0 ||
+               fwrite(b->entries, sizeof(index_entry_t), b->count, f) == (size_t)b->count);
+    if (f && fclose(f) != 0) ok = false;
+    if (!ok) {
+        ESP_LOGW(TAG, "Failed to append to %s", path);
+    }
+    b->count = 0;
+}
+
+static void add_entry(segment_builder_t *b, uint32_t key, uint32_t offset)
+{
+    if (b->count == SESSION_INDEX_SEGMENT) {
+        write_segment(b);
+    }
+    b->entries[b->count++] = (index_entry_t){ .key = key, .offset = offset };
+}
+
+/**
+ * @brief Log bytes of file N the index covers; a torn last segment is cut off
+ */
+static uint32_t indexed_bytes(int file)
+{
+    char path[48];
+    session_index_path(path, sizeof(path), file);
+    FILE *f = fopen(path, "r+b");
+    if (!f) return 0;
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    long pos = 0;
+    uint32_t covered = 0;
+    segment_header_t header;
+    while (pos + (long)sizeof(header) <= size &&
+           fseek(f, pos, SEEK_SET) == 0 && fread(&header, sizeof(header), 1, f) == 1 &&
+           header.magic == SESSION_INDEX_MAGIC && header.count <= SESSION_INDEX_SEGMENT) {
+        long end = pos + (long)sizeof(header) + header.count * (long)sizeof(index_entry_t);
+        if (end > size) break;
+        covered = header.end_offset;
+        pos = end;
+    }
+    if (pos < size) {
+        ESP_LOGW(TAG, "%s: dropping %ld torn bytes", path, size - pos);
+        fflush(f);
+        if (ftruncate(fileno(f), pos) != 0) covered = 0;
+    }
+    fclose(f);
+    return covered;
+}
+
+esp_err_t session_index_init(void)
+{
+    if (!lock) {
+        lock = xSemaphoreCreateMutex();
+        if (!lock) return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void session_index_open(int file)
+{
+    if (!lock) return;
+
+    // The log was just created, so any index with its name is stale
+    char path[48];
+    session_index_path(path, sizeof(path), file);
+    remove(path);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    live.file = file;
+    live.count = 0;
+    live.end_offset = 0;
+    newest_file = file;
+    xSemaphoreGive(lock);
+    if (!backfill_log) {
+        backfill_next = file - 1;
+    }
+}
+
+void session_index_add(uint32_t offset, const char *record, size_t len)
+{
+    if (!lock || live.file <= 0) return;
+    uint64_t keys[RECORD_KEYS_MAX];
+    int count = record_keys(record, len, keys);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    // A segment written before this record covers everything up to it
+    live.end_offset = offset;
+    for (int i = 0; i < count; i++) {
+        add_entry(&live, fold_key(keys[i]), offset);
+    }
+    live.end_offset = offset + len;
+    xSemaphoreGive(lock);
+}
+
+void session_index_close(uint32_t end_offset)
+{
+    if (!lock) return;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (live.file > 0) {
+        // Also written empty: it records that the whole file is covered
+        live.end_offset = end_offset;
+        write_segment(&live);
+        live.file = 0;
+    }
+    // The card may be lent out or the file deleted next; resume later
+    if (backfill_log) {
+        backfill.end_offset = backfill_offset;
+        write_segment(&backfill);
+        backfill_next = backfill.file;
+        backfill.file = 0;
+        session_file_reader_close(backfill_log);
+        backfill_log = NULL;
+    }
+    xSemaphoreGive(lock);
+}
+
+/**
+ * @brief Open file N for backfill if part of it is unindexed
+ */
+static bool start_backfill(int file)
+{
+    session_file_reader_t *r = session_file_reader_open(file);
+    if (!r) return false;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint32_t covered = indexed_bytes(file);
+    xSemaphoreGive(lock);
+
+    if (session_file_reader_size(r) <= covered) {
+        session_file_reader_close(r);
+        return false;
+    }
+    ESP_LOGI(TAG, "Indexing session %d from %lu", file, (unsigned long)covered);
+    backfill.file = file;
+    backfill.count = 0;
+    backfill_offset = covered;
+    backfill_log = r;
+    return true;
+}
+
+bool session_index_backfill(void)
+{
+    if (!lock) return false;
+    while (!backfill_log) {
+        if (backfill_next <= 0 || backfill_next <= newest_file - SESSION_LOG_KEEP_FILES) {
+            return false;
+        }
+        start_backfill(backfill_next--);
+    }
+
+    char line[SESSION_LOG_RECORD_MAX + 2];
+    uint32_t start = backfill_offset;
+    bool done = false;
+    while (backfill_offset - start < SESSION_INDEX_BACKFILL_BYTES) {
+        size_t len = session_file_read(backfill_log, backfill_offset, line, sizeof(line));
+        if (len == 0) {
+            done = true;
+            break;
+        }
+        uint64_t keys[RECORD_KEYS_MAX];
+        int count = record_keys(line, strlen(line), keys);
+
+        xSemaphoreTake(lock, portMAX_DELAY);
+        backfill.end_offset = backfill_offset;
+        for (int i = 0; i < count; i++) {
+            add_entry(&backfill, fold_key(keys[i]), backfill_offset);
+        }
+        xSemaphoreGive(lock);
+        backfill_offset += len;
+    }
+    if (!done) return true;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    backfill.end_offset = backfill_offset;
+    write_segment(&backfill);
+    ESP_LOGI(TAG, "Indexed session %d", backfill.file);
+    backfill.file = 0;
+    xSemaphoreGive(lock);
+    session_file_reader_close(backfill_log);
+    backfill_log = NULL;
+    return true;
+}
+
+// Offsets of the newest matches of one file, oldest first (ring of the last ones)
+typedef struct {
+    uint32_t offsets[SESSION_INDEX_CANDIDATES];
+    uint32_t total;
+} candidates_t;
+
+static void add_candidate(candidates_t *c, uint32_t offset)
+{
+    c->offsets[c->total % SESSION_INDEX_CANDIDATES] = offset;
+    c->total++;
+}
+
+/**
+ * @brief Matches of key in the segments of file N (lock held)
+ * @return false without an index file
+ */
+static bool read_index(int file, uint32_t key, candidates_t *c)
+{
+    char path[48];
+    session_index_path(path, sizeof(path), file);
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+
+    int bucket = key >> (32 - SESSION_INDEX_BUCKET_BITS);
+    long pos = 0;
+    segment_header_t header;
+    while (fseek(f, pos, SEEK_SET) == 0 && fread(&header, sizeof(header), 1, f) == 1 &&
+           header.magic == SESSION_INDEX_MAGIC && header.count <= SESSION_INDEX_SEGMENT) {
+        int first = header.bucket_start[bucket];
+        int last = header.bucket_start[bucket + 1];
+        if (first < last && last <= header.count &&
+            fseek(f, pos + sizeof(header) + first * sizeof(index_entry_t), SEEK_SET) == 0) {
+            index_entry_t batch[READ_BATCH];
+            while (first < last) {
+                int n = last - first < READ_BATCH ? last - first : READ_BATCH;
+                if (fread(batch, sizeof(index_entry_t), n, f) != (size_t)n) break;
+                for (int i = 0; i < n; i++) {
+                    if (batch[i].key == key) add_candidate(c, batch[i].offset);
+                }
+                first += n;
+            }
+        }
+        pos += sizeof(header) + header.count * sizeof(index_entry_t);
+    }
+    fclose(f);
+    return true;
+}
+
+/**
+ * @brief Matches of key not written out yet (lock held)
+ */
+static bool read_builder(const segment_builder_t *b, int file, uint32_t key, candidates_t *c)
+{
+    if (b->file != file) return false;
+    // Builders are in append order
+    for (int i = 0; i < b->count; i++) {
+        if (b->entries[i].key == key) add_candidate(c, b->entries[i].offset);
+    }
+    return true;
+}
+
+int session_index_find(const char *query, session_index_hit_t *out, int max,
+                       session_index_result_t *result)
+{
+    session_index_result_t res = { 0 };
+    int64_t start_us = esp_timer_get_time();
+    if (!lock || !query || !query[0] || !out || max <= 0) {
+        if (result) *result = res;
+        return 0;
+    }
+
+    uint64_t wanted = query_key(query);
+    uint32_t key = fold_key(wanted);
+    candidates_t *c = malloc(sizeof(candidates_t));
+    if (!c) {
+        if (result) *result = res;
+        return 0;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int newest = newest_file;
+    xSemaphoreGive(lock);
+
+    for (int file = newest; file > 0 && file > newest - SESSION_LOG_KEEP_FILES && res.hits < max;
+         file--) {
+        c->total = 0;
+        xSemaphoreTake(lock, portMAX_DELAY);
+        bool indexed = read_index(file, key, c);
+        indexed |= read_builder(&backfill, file, key, c);
+        indexed |= read_builder(&live, file, key, c);
+        xSemaphoreGive(lock);
+        if (!indexed) continue;
+        res.files++;
+        res.matches += c->total;
+        if (c->total == 0) continue;
+
+        // Newest first; drop records whose key only shares the hash
+        session_file_reader_t *r = session_file_reader_open(file);
+        if (!r) continue;
+        uint32_t oldest = c->total > SESSION_INDEX_CANDIDATES ?
+                          c->total - SESSION_INDEX_CANDIDATES : 0;
+        for (uint32_t i = c->total; i > oldest && res.hits < max; i--) {
+            uint32_t offset = c->offsets[(i - 1) % SESSION_INDEX_CANDIDATES];
+            session_index_hit_t *hit = &out[res.hits];
+            if (session_file_read(r, offset, hit->record, sizeof(hit->record)) == 0) continue;
+            uint64_t keys[RECORD_KEYS_MAX];
+            int count = record_keys(hit->record, strlen(hit->record), keys);
+            bool match = false;
+            for (int k = 0; k < count && !match; k++) {
+                match = keys[k] == wanted;
+            }
+            if (!match) continue;
+            hit->file = file;
+            hit->offset = offset;
+            res.hits++;
+        }
+        session_file_reader_close(r);
+    }
+    free(c);
+
+    res.elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+    ESP_LOGI(TAG, "\"%s\": %d hits from %lu matches in %d files, %lu us", query, res.hits,
+             (unsigned long)res.matches, res.files, (unsigned long)res.elapsed_us);
+    if (result) *result = res;
+    return res.hits;
+}
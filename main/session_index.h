@@ -0,0 +1,100 @@
+/**
+ * @file session_index.h
+ * @brief Hash index of session log records by MAC and SSID, kept on SD
+ *
+ * Every record the session log writes is keyed by the MACs it carries and,
+ * for scan, sniffer, deauth and handshake records, by its SSID. The keys
+ * (mac_set keys folded to 32 bits) and the record's offset in the
+ * uncompressed text (session_file.h) are collected in RAM and appended to
+ * /sdcard/logs/session_N.idx, next to the log file, as segments of up to
+ * SESSION_INDEX_SEGMENT entries:
+ *
+ *   header: magic, text bytes covered, entry count,
+ *           first entry of each of SESSION_INDEX_BUCKETS hash buckets
+ *   entries: (key, offset) pairs sorted by key
+ *
+ * A lookup reads one header and one bucket per segment, then the candidate
+ * records from the log to drop hash collisions, so it costs a few small
+ * reads per segment instead of a scan of every file. Segments are written
+ * when full and when the log file closes; entries not written yet are
+ * searched in RAM. Index files rotate and are deleted with their logs.
+ *
+ * Files written before the index existed, or left unindexed by a reset,
+ * are indexed in the background (SESSION_INDEX_BACKFILL_BYTES of log per
+ * idle pass of the writer task), newest first. Records written within the
+ * last SESSION_LOG_FLUSH_MS may not be on the card yet and are not found.
+ */
+
+#ifndef SESSION_INDEX_H
+#define SESSION_INDEX_H
+
+#include "session_log.h"
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stddef.h>
+
+#define SESSION_INDEX_SEGMENT           512     // Entries per segment
+#define SESSION_INDEX_BUCKET_BITS       5       // 32 hash buckets per segment
+#define SESSION_INDEX_BUCKETS           (1 << SESSION_INDEX_BUCKET_BITS)
+#define SESSION_INDEX_BACKFILL_BYTES    (8 * 1024)
+#define SESSION_INDEX_CANDIDATES        128     // Newest key matches verified per file
+#define SESSION_INDEX_MAGIC             0x58444953  // "SIDX"
+
+typedef struct {
+    int file;                           // N of session_N.log / .slz
+    uint32_t offset;                    // Of the record in that file
+    char record[SESSION_LOG_RECORD_MAX];    // Without the newline
+} session_index_hit_t;
+
+typedef struct {
+    int hits;                           // Records returned
+    uint32_t matches;                   // Index entries with the key, collisions included
+    int files;                          // Log files searched
+    uint32_t elapsed_us;
+} session_index_result_t;
+
+/**
+ * @brief Prepare the index; the writer task calls the rest (session_log)
+ */
+esp_err_t session_index_init(void);
+
+/**
+ * @brief Log file N was opened for appending (writer task)
+ */
+void session_index_open(int file);
+
+/**
+ * @brief Key a record appended at offset of the open file (writer task)
+ * @param record Record bytes including the newline
+ */
+void session_index_add(uint32_t offset, const char *record, size_t len);
+
+/**
+ * @brief The open log file is closing; write its remaining entries (writer task)
+ * @param end_offset Log bytes written
+ */
+void session_index_close(uint32_t end_offset);
+
+/**
+ * @brief Index a slice of an older, unindexed log file (writer task, idle)
+ * @return true while work is left
+ */
+bool session_index_backfill(void);
+
+/**
+ * @brief Path of the index of session log N
+ */
+void session_index_path(char *out, size_t size, int file);
+
+/**
+ * @brief Records with a MAC ("AA:BB:CC:DD:EE:FF") or an exact SSID, newest first
+ * @param out Hits, newest file and offset first
+ * @param result Optional counters
+ * @return Hits written
+ */
+int session_index_find(const char *query, session_index_hit_t *out, int max,
+                       session_index_result_t *result);
+
+#endif // SESSION_INDEX_H
@@ -0,0 +1,508 @@
+/**
+ * @file session_log.c
+ * @brief Background log of JanOS results to rotating files on SD
+ */
+
+#include "session_log.h"
+#include "session_index.h"
+#include "event_bus.h"
+#include "screenshot.h"
+#include "session_file.h"
+#include "sd_io.h"
+#include "janos_proto.h"
+#include "task_plan.h"
+#include "mem_monitor.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <strings.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+static const char *TAG = "SESSION_LOG";
+
+
+static const char *type_names[SESSION_LOG_TYPE_COUNT] = {
+    [SESSION_LOG_SESSION]   = "SESSION",
+    [SESSION_LOG_SCAN]      = "SCAN",
+    [SESSION_LOG_SNIFFER]   = "SNIFFER",
+    [SESSION_LOG_CLIENT]    = "CLIENT",
+    [SESSION_LOG_BT]        = "BT",
+    [SESSION_LOG_DEAUTH]    = "DEAUTH",
+    [SESSION_LOG_PORTAL]    = "PORTAL",
+    [SESSION_LOG_HANDSHAKE] = "HANDSHAKE",
+    [SESSION_LOG_GPS]       = "GPS",
+    [SESSION_LOG_STATUS]    = "STATUS",
+    [SESSION_LOG_LINK]      = "LINK",
+    [SESSION_LOG_WATCH]     = "WATCH",
+};
+
+// Untyped text lines worth keeping, matched in order; the whole line is
+// logged. Typed results arrive on the event bus instead.
+typedef struct {
+    const char *marker;
+    session_log_type_t type;
+} line_rule_t;
+
+static const line_rule_t line_rules[] = {
+    { "Password: ",                         SESSION_LOG_PORTAL },
+    { "password=",                          SESSION_LOG_PORTAL },
+    { "Received POST data: ",               SESSION_LOG_PORTAL },
+    { "Password verified!",                 SESSION_LOG_PORTAL },
+    { "Wi-Fi: connected to SSID='",         SESSION_LOG_PORTAL },
+    { ", CH",                               SESSION_LOG_SNIFFER },
+};
+
+static RingbufHandle_t record_buffer = NULL;
+static TaskHandle_t writer_handle = NULL;
+static int bus_handle = -1;
+static session_file_t *log_file = NULL;
+static int file_number = 0;
+static volatile uint32_t record_count = 0;
+static volatile uint32_t dropped_count = 0;
+static volatile uint32_t file_bytes = 0;         // Text, the offset of the next record
+static volatile uint32_t stored_bytes = 0;       // On the card
+static volatile bool pause_requested = false;
+static volatile bool writer_paused = false;
+
+const char *session_log_type_name(session_log_type_t type)
+{
+    return type < SESSION_LOG_TYPE_COUNT ? type_names[type] : "?";
+}
+
+/**
+ * @brief Lowest and highest N among session_N.log and .slz files
+ */
+static void scan_log_numbers(int *lowest, int *highest)
+{
+    *lowest = 0;
+    *highest = 0;
+    DIR *dir = opendir(SESSION_LOG_DIR);
+    if (!dir) return;
+    
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int num;
+        char ext[4];
+        if (sscanf(entry->d_name, "session_%d.%3s", &num, ext) != 2 || num <= 0) continue;
+        if (strcasecmp(ext, "log") != 0 && strcasecmp(ext, "slz") != 0) continue;
+        if (num > *highest) *highest = num;
+        if (*lowest == 0 || num < *lowest) *lowest = num;
+    }
+    closedir(dir);
+}
+
+/**
+ * @brief Close the current file (if any) and start the next one
+ */
+static bool open_next_file(void)
+{
+    if (log_file) {
+        session_file_close(log_file);
+        log_file = NULL;
+        session_index_close(file_bytes);
+    }
+    
+    int lowest, highest;
+    scan_log_numbers(&lowest, &highest);
+    file_number = highest + 1;
+    
+    // Keep SESSION_LOG_KEEP_FILES including the one about to be opened
+    char path[48];
+    for (int n = lowest; n > 0 && n <= file_number - SESSION_LOG_KEEP_FILES; n++) {
+        session_file_remove(n);
+        session_index_path(path, sizeof(path), n);
+        remove(path);
+    }
+    
+    snprintf(path, sizeof(path), "%s/session_%d.%s", SESSION_LOG_DIR, file_number,
+             SESSION_FILE_EXT);
+    // Files rotate at SESSION_LOG_FILE_MAX, so reserve exactly that
+    log_file = session_file_create(file_number, SESSION_LOG_FILE_MAX);
+    if (!log_file) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return false;
+    }
+    file_bytes = 0;
+    stored_bytes = 0;
+    session_index_open(file_number);
+    ESP_LOGI(TAG, "Logging to %s", path);
+    return true;
+}
+
+static void write_record(const char *data, size_t len)
+{
+    if (!log_file) return;
+    
+    uint32_t offset = file_bytes;
+    if (session_file_append(log_file, data, len) != ESP_OK) {
+        ESP_LOGE(TAG, "Write failed, logging stopped");
+        session_file_close(log_file);
+        log_file = NULL;
+        session_index_close(offset);
+        return;
+    }
+    session_index_add(offset, data, len);
+    file_bytes = session_file_text_size(log_file);
+    stored_bytes = session_file_stored_size(log_file);
+    if (stored_bytes >= SESSION_LOG_FILE_MAX) {
+        open_next_file();
+    }
+}
+
+static void log_event(const bus_event_t *event);
+
+/**
+ * @brief Drain records into the log file, which writes whole chunks as they
+ * fill; the partial chunk is synced after SESSION_LOG_FLUSH_MS or on request
+ */
+static void writer_task(void *arg)
+{
+    (void)arg;
+    bool unsynced = false;
+    bool reopen = false;
+    int64_t last_sync_us = esp_timer_get_time();
+    
+    while (1) {
+        // Paused: file closed, records wait in the buffer (or drop when full)
+        if (pause_requested) {
+            if (!writer_paused) {
+                bool had_file = log_file != NULL;
+                if (log_file) {
+                    session_file_close(log_file);
+                    log_file = NULL;
+                    session_index_close(file_bytes);
+                }
+                reopen = had_file;
+                writer_paused = true;
+            }
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SESSION_LOG_FLUSH_MS));
+            continue;
+        }
+        if (writer_paused) {
+            writer_paused = false;
+            if (reopen) open_next_file();
+            unsynced = false;
+        }
+        
+        // Wait on whichever source there is; the other is polled after
+        TickType_t wait = pdMS_TO_TICKS(SESSION_LOG_FLUSH_MS / 4);
+        bus_event_t event;
+        if (bus_handle >= 0) {
+            uint32_t wait_ms = SESSION_LOG_FLUSH_MS / 4;
+            while (event_bus_receive(bus_handle, &event, wait_ms)) {
+                log_event(&event);
+                wait_ms = 0;
+            }
+            wait = 0;
+        }
+        
+        size_t size = 0;
+        char *item;
+        bool idle = true;
+        while ((item = xRingbufferReceive(record_buffer, &size, wait)) != NULL) {
+            write_record(item, size);
+            vRingbufferReturnItem(record_buffer, item);
+            unsynced = true;
+            idle = false;
+            wait = 0;
+        }
+        // Older files get indexed while nothing else is written
+        if (idle && log_file) {
+            session_index_backfill();
+        }
+        
+        int64_t now = esp_timer_get_time();
+        bool flush_requested = ulTaskNotifyTake(pdTRUE, 0) > 0;
+        if (log_file && unsynced &&
+            (flush_requested || now - last_sync_us >= SESSION_LOG_FLUSH_MS * 1000LL)) {
+            session_file_sync(log_file);
+            stored_bytes = session_file_stored_size(log_file);
+            unsynced = false;
+            last_sync_us = now;
+        }
+    }
+}
+
+static void vlog_record(int64_t time_us, session_log_type_t type, const char *fmt, va_list args)
+{
+    if (!record_buffer) return;
+    
+    char record[SESSION_LOG_RECORD_MAX];
+    int len = snprintf(record, sizeof(record), "%lld\t%s\t", (long long)time_us,
+                       session_log_type_name(type));
+    int body = vsnprintf(record + len, sizeof(record) - len, fmt, args);
+    if (body < 0) return;
+    len += body;
+    if (len > (int)sizeof(record) - 2) len = sizeof(record) - 2;
+    
+    // Fields come from the air; keep one record per line
+    for (int i = 0; i < len; i++) {
+        if (record[i] == '\n' || record[i] == '\r') record[i] = ' ';
+    }
+    record[len++] = '\n';
+    
+    if (xRingbufferSend(record_buffer, record, len, 0) != pdTRUE) {
+        dropped_count++;
+        return;
+    }
+    record_count++;
+}
+
+void session_log_printf(session_log_type_t type, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vlog_record(uart_line_time_us(), type, fmt, args);
+    va_end(args);
+}
+
+/**
+ * @brief session_log_printf() stamped with a time taken earlier (bus events)
+ */
+static void log_record_at(int64_t time_us, session_log_type_t type, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vlog_record(time_us, type, fmt, args);
+    va_end(args);
+}
+
+static void format_mac(char out[18], const uint8_t mac[6])
+{
+    snprintf(out, 18, "%02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+static void format_mac_key(char out[18], uint64_t key)
+{
+    uint8_t mac[6];
+    for (int i = 0; i < 6; i++) {
+        mac[i] = (uint8_t)(key >> (40 - 8 * i));
+    }
+    format_mac(out, mac);
+}
+
+/**
+ * @brief Format one bus event into the ring (writer task)
+ */
+static void log_event(const bus_event_t *event)
+{
+    char mac[18];
+    
+    switch (event->type) {
+        case BUS_EVENT_NETWORK_SEEN: {
+            const bus_network_t *n = &event->network;
+            log_record_at(event->time_us, SESSION_LOG_SCAN, "%s\t%s\t%d\t%d\t%s\t%s",
+                          n->bssid, n->ssid, n->channel, n->rssi,
+                          n->security, n->band);
+            break;
+        }
+        case BUS_EVENT_STATION_SEEN:
+            format_mac_key(mac, event->station.mac);
+            log_record_at(event->time_us, SESSION_LOG_CLIENT, "%s", mac);
+            break;
+        case BUS_EVENT_DEAUTH_DETECTED:
+            format_mac_key(mac, event->deauth.bssid);
+            log_record_at(event->time_us, SESSION_LOG_DEAUTH, "%s\t%s\t%d\t%d", mac,
+                          event->deauth.ap_name, event->deauth.channel,
+                          event->deauth.rssi);
+            break;
+        case BUS_EVENT_HANDSHAKE_CAPTURED:
+            log_record_at(event->time_us, SESSION_LOG_HANDSHAKE, "%s", event->handshake.ssid);
+            break;
+        case BUS_EVENT_GPS_FIX:
+            log_record_at(event->time_us, SESSION_LOG_GPS, "%s", event->gps.fix ? "fix" : "lost");
+            break;
+        case BUS_EVENT_LINK_STATE:
+            log_record_at(event->time_us, SESSION_LOG_LINK, "%s\t%lu\t%s",
+                          event->link.up ? "up" : "down",
+                          (unsigned long)event->link.baud,
+                          event->link.binary ? "binary" : "text");
+            break;
+        case BUS_EVENT_WATCHLIST_HIT:
+            log_record_at(event->time_us, SESSION_LOG_WATCH, "%s\t%s",
+                          event->watch.is_mac ? "mac" : "text",
+                          event->watch.pattern);
+            break;
+        default:
+            break;
+    }
+}
+
+void session_log_frame(const uart_frame_t *frame)
+{
+    if (!record_buffer || !frame) return;
+    
+    switch (frame->type) {
+        case UART_FRAME_SNIFFER_ENTRY: {
+            uart_sniffer_record_t rec;
+            if (uart_frame_parse_sniffer(frame, &rec)) {
+                char mac[18];
+                format_mac(mac, rec.bssid);
+                session_log_printf(SESSION_LOG_SNIFFER, "%s\t%s\t%u\t%d\t%u",
+                                   mac, rec.ssid, rec.channel, rec.rssi, rec.client_count);
+            }
+            break;
+        }
+        case UART_FRAME_BT_DEVICE: {
+            uart_bt_record_t rec;
+            if (uart_frame_parse_bt_device(frame, &rec)) {
+                char mac[18];
+                format_mac(mac, rec.mac);
+                session_log_printf(SESSION_LOG_BT, "%s\t%d\t%s", mac, rec.rssi, rec.name);
+            }
+            break;
+        }
+        case UART_FRAME_HANDSHAKE: {
+            uart_handshake_record_t rec;
+            if (uart_frame_parse_handshake(frame, &rec)) {
+                char mac[18];
+                format_mac(mac, rec.bssid);
+                session_log_printf(SESSION_LOG_HANDSHAKE, "%s\t%s\t%u",
+                                   mac, rec.ssid, rec.channel);
+            }
+            break;
+        }
+        case UART_FRAME_STATUS: {
+            uart_status_record_t rec;
+            if (uart_frame_parse_status(frame, &rec)) {
+                session_log_printf(SESSION_LOG_STATUS, "%u\t%s", rec.code, rec.text);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief BT list row: "  1. XX:XX:XX:XX:XX:XX  RSSI: -82 dBm  Name: ..."
+ */
+static bool is_bt_device_line(const char *line)
+{
+    janos_bt_row_t row;
+    return janos_parse_bt_row(line, &row) && row.index >= 0 && row.rssi != JANOS_RSSI_NONE;
+}
+
+static void line_callback(const char *line, void *user_data)
+{
+    (void)user_data;
+    
+    // ESP log output from JanOS is never a result
+    if ((line[0] == 'I' || line[0] == 'W' || line[0] == 'E' || line[0] == 'D') &&
+        line[1] == ' ' && line[2] == '(') {
+        return;
+    }
+    
+    // Second board's lines are marked so the log tells the boards apart
+    const char *board = (uart_line_link() == UART_LINK_PRIMARY) ? "" : "B2 ";
+    for (size_t i = 0; i < sizeof(line_rules) / sizeof(line_rules[0]); i++) {
+        if (strstr(line, line_rules[i].marker)) {
+            session_log_printf(line_rules[i].type, "%s%s", board, line);
+            return;
+        }
+    }
+    
+    if (is_bt_device_line(line)) {
+        session_log_printf(SESSION_LOG_BT, "%s%s", board, line);
+    }
+}
+
+esp_err_t session_log_init(void)
+{
+    if (record_buffer) return ESP_OK;
+    if (!screenshot_is_available()) {
+        ESP_LOGW(TAG, "SD card not mounted, session log disabled");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    struct stat st;
+    if (stat(SESSION_LOG_DIR, &st) != 0) {
+        mkdir(SESSION_LOG_DIR, 0755);
+    }
+    if (session_index_init() != ESP_OK) {
+        ESP_LOGW(TAG, "No memory for the index, log search disabled");
+    }
+    if (!open_next_file()) {
+        return ESP_FAIL;
+    }
+    
+    RingbufHandle_t buf = xRingbufferCreate(SESSION_LOG_BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+    if (!buf) {
+        session_file_close(log_file);
+        log_file = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    record_buffer = buf;
+    
+    // Before the writer starts, which waits on it when there is one
+    bus_handle = event_bus_subscribe(BUS_EVENT_ALL, SESSION_LOG_BUS_DEPTH, "sd_log");
+    if (bus_handle < 0) {
+        ESP_LOGW(TAG, "No event bus queue, typed results will not be logged");
+    }
+    
+    if (xTaskCreatePinnedToCore(writer_task, "session_log", TASK_SESSION_LOG_STACK, NULL,
+                                TASK_LOG_WRITER_PRIO, &writer_handle,
+                                TASK_LOG_WRITER_CORE) != pdPASS) {
+        event_bus_unsubscribe(bus_handle);
+        bus_handle = -1;
+        record_buffer = NULL;
+        vRingbufferDelete(buf);
+        session_file_close(log_file);
+        log_file = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    task_plan_track(TASK_ID_SESSION_LOG, writer_handle);
+    // Runs beside other boot tasks, so counted by size rather than a heap scope
+    mem_monitor_account(MEM_SUB_LOGGER, SD_IO_CHUNK_SIZE + SESSION_FILE_WRITE_MEM +
+                                        SESSION_LOG_BUFFER_SIZE + TASK_SESSION_LOG_STACK);
+    
+    if (uart_subscribe_link_lines(UART_LINK_MASK_ALL, UART_ROUTE_ANY, NULL, line_callback, NULL) < 0) {
+        ESP_LOGW(TAG, "No free UART route, text results will not be logged");
+    }
+    session_log_printf(SESSION_LOG_SESSION, "start");
+    return ESP_OK;
+}
+
+void session_log_flush(void)
+{
+    if (writer_handle) {
+        xTaskNotifyGive(writer_handle);
+    }
+}
+
+esp_err_t session_log_pause(bool pause)
+{
+    pause_requested = pause;
+    if (!writer_handle) return ESP_OK;
+    xTaskNotifyGive(writer_handle);
+    
+    // Pausing waits until the file is closed
+    for (int waited = 0; pause && !writer_paused; waited += 10) {
+        if (waited >= SESSION_LOG_PAUSE_WAIT_MS) return ESP_ERR_TIMEOUT;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return ESP_OK;
+}
+
+void session_log_get_stats(session_log_stats_t *out)
+{
+    if (!out) return;
+    
+    out->active = log_file != NULL;
+    out->file_number = file_number;
+    out->records = record_count;
+    out->bytes = file_bytes;
+    out->stored_bytes = stored_bytes;
+    out->dropped = dropped_count;
+    
+    event_bus_sub_stats_t bus;
+    out->bus_dropped = event_bus_get_stats(bus_handle, &bus) ? bus.dropped : 0;
+}
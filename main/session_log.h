@@ -0,0 +1,128 @@
+/**
+ * @file session_log.h
+ * @brief Background log of JanOS results to rotating files on SD
+ *
+ * Scan rows, sniffer APs and clients, BT devices, deauth detections,
+ * portal captures, handshakes, GPS fixes and watchlist hits are appended as one text line
+ * each: "<us since boot>\t<TYPE>\t<fields>". Records are formatted on the
+ * producing task into a ring buffer and written by a low-priority task in
+ * large batches, so neither the RX task nor the UI waits on the card.
+ * Typed results (scan rows, clients, deauths, handshakes, GPS and link
+ * changes, watchlist hits) come off the event bus and are formatted on the writer task;
+ * SESSION_LOG_BUS_DEPTH of them can wait before the bus drops more.
+ * The time is when the record's line arrived (uart_line_time_us, in us),
+ * not when it was formatted, so queued events keep their order and logs
+ * of several links or units can be merged on it.
+ *
+ * Files are /sdcard/logs/session_N.log, or session_N.slz in LZ4 blocks with
+ * CONFIG_SESSION_LOG_COMPRESS (session_file.h); a new one starts at every
+ * boot and whenever the current one reaches SESSION_LOG_FILE_MAX bytes on
+ * the card, and only the newest SESSION_LOG_KEEP_FILES are kept. Each has a session_N.idx index
+ * by MAC and SSID beside it (session_index.h).
+ */
+
+#ifndef SESSION_LOG_H
+#define SESSION_LOG_H
+
+#include "uart_handler.h"
+#include "uart_frame.h"
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SESSION_LOG_DIR         "/sdcard/logs"
+
+#ifdef CONFIG_SESSION_LOG_FILE_KB
+#define SESSION_LOG_FILE_MAX    (CONFIG_SESSION_LOG_FILE_KB * 1024)
+#else
+#define SESSION_LOG_FILE_MAX    (512 * 1024)
+#endif
+
+#ifdef CONFIG_SESSION_LOG_KEEP_FILES
+#define SESSION_LOG_KEEP_FILES  CONFIG_SESSION_LOG_KEEP_FILES
+#else
+#define SESSION_LOG_KEEP_FILES  8
+#endif
+
+#define SESSION_LOG_BUFFER_SIZE (16 * 1024)     // Producers -> writer task
+#define SESSION_LOG_FLUSH_MS    2000            // Longest time a record waits for the card
+#define SESSION_LOG_RECORD_MAX  192             // Longest formatted record
+#define SESSION_LOG_PAUSE_WAIT_MS 1000          // Writer closing the file for a pause
+#define SESSION_LOG_BUS_DEPTH   24              // Event bus queue (event_bus.h)
+
+typedef enum {
+    SESSION_LOG_SESSION = 0,    // Logger start/stop
+    SESSION_LOG_SCAN,           // WiFi network from a scan
+    SESSION_LOG_SNIFFER,        // Sniffer AP summary
+    SESSION_LOG_CLIENT,         // Sniffer client MAC
+    SESSION_LOG_BT,             // BLE device
+    SESSION_LOG_DEAUTH,         // Deauth detection
+    SESSION_LOG_PORTAL,         // Portal / evil twin capture
+    SESSION_LOG_HANDSHAKE,      // Handshake saved
+    SESSION_LOG_GPS,            // GPS fix change
+    SESSION_LOG_STATUS,         // Binary status event
+    SESSION_LOG_LINK,           // Board link up/down
+    SESSION_LOG_WATCH,          // Watchlist entry seen
+    SESSION_LOG_TYPE_COUNT
+} session_log_type_t;
+
+typedef struct {
+    bool active;
+    int file_number;            // N of the current session_N.log
+    uint32_t records;
+    uint32_t bytes;             // Written to the current file, uncompressed
+    uint32_t stored_bytes;      // Of it on the card (less when compressed)
+    uint32_t dropped;           // Records lost to a full buffer
+    uint32_t bus_dropped;       // Events lost to a full bus queue
+} session_log_stats_t;
+
+/**
+ * @brief Open a new session file and start the writer task
+ *
+ * Call after the SD card is mounted (screenshot_init).
+ * @return ESP_OK, ESP_ERR_INVALID_STATE without SD card
+ */
+esp_err_t session_log_init(void);
+
+/**
+ * @brief Append a record (any task, never blocks)
+ * @param type Record type
+ * @param fmt printf-style fields, tab separated by convention
+ */
+void session_log_printf(session_log_type_t type, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Log a binary frame carrying a result record
+ *
+ * Scan results are taken from the event bus instead.
+ */
+void session_log_frame(const uart_frame_t *frame);
+
+/**
+ * @brief Ask the writer task to write out everything buffered now
+ */
+void session_log_flush(void);
+
+/**
+ * @brief Close the log file while the card is lent out, or reopen after
+ *
+ * While paused, records stay buffered until the buffer fills, then drop.
+ * Resuming starts a new session_N.log.
+ * @param pause true to pause (waits up to SESSION_LOG_PAUSE_WAIT_MS), false to resume
+ * @return ESP_OK, ESP_ERR_TIMEOUT if the writer did not close the file in time
+ */
+esp_err_t session_log_pause(bool pause);
+
+/**
+ * @brief Snapshot logger counters
+ */
+void session_log_get_stats(session_log_stats_t *out);
+
+/**
+ * @brief Record type name as written to the file
+ */
+const char *session_log_type_name(session_log_type_t type);
+
+#endif // SESSION_LOG_H
@@ -1,31 +1,89 @@
 /**
  * @file settings.c
  * @brief Application settings stored in NVS
+ *
+ * All settings live in one RAM copy of settings_blob_t. Setters change the
+ * copy and arm a one-shot timer, so a burst of changes (a brightness
+ * slider held down) ends in a single NVS write and commit
+ * SETTINGS_COMMIT_DELAY_MS after the last one.
+ *
+ * The blob carries a schema version and its size. Fields are only ever
+ * appended: a shorter blob from older firmware fills the fields it has and
+ * leaves defaults for the rest. Settings from firmware that kept one NVS
+ * key per setting are migrated on first boot, and those keys are erased
+ * with the first blob commit.
  */
 
 #include "settings.h"
+#include "uart_handler.h"
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stddef.h>
+#include <string.h>
 
 static const char *TAG = "SETTINGS";
 
 // NVS namespace and keys
 #define NVS_NAMESPACE       "settings"
+#define NVS_KEY_BLOB        "blob"
+
+// Keys of the one-key-per-setting layout, read once for migration
 #define NVS_KEY_UART_TX     "uart_tx"
 #define NVS_KEY_UART_RX     "uart_rx"
+#define NVS_KEY_UART_BAUD   "uart_baud"
+#define NVS_KEY_UART_LOG    "uart_log"
 #define NVS_KEY_RED_TEAM    "red_team"
 #define NVS_KEY_SCR_TIMEOUT "scr_tmout"
 #define NVS_KEY_SCR_BRIGHT  "scr_bright"
 #define NVS_KEY_GPS_TYPE    "gps_type"
 
+static const char *const legacy_keys[] = {
+    NVS_KEY_UART_TX, NVS_KEY_UART_RX, NVS_KEY_UART_BAUD, NVS_KEY_UART_LOG,
+    NVS_KEY_RED_TEAM, NVS_KEY_SCR_TIMEOUT, NVS_KEY_SCR_BRIGHT, NVS_KEY_GPS_TYPE,
+};
+
+#define SETTINGS_SCHEMA_VERSION 1
+#define SETTINGS_BLOB_MAX       128     // Largest blob read back, newer fields included
+
+// Stored layout; append new fields at the end only
+typedef struct {
+    uint16_t version;           // SETTINGS_SCHEMA_VERSION that wrote it
+    uint16_t size;              // sizeof(settings_blob_t) that wrote it
+    int8_t uart_tx_pin;
+    int8_t uart_rx_pin;
+    uint8_t uart_log_level;     // uart_log_level_t
+    uint8_t red_team_enabled;
+    uint32_t uart_baud;
+    uint32_t screen_timeout_ms;
+    uint8_t screen_brightness;  // 1-100
+    uint8_t gps_type;           // gps_type_t
+    uint8_t power_profile;      // power_profile_t
+    uint8_t reserved;
+} settings_blob_t;
+
 // Cached values
-static int uart_tx_pin = DEFAULT_UART_TX_PIN;
-static int uart_rx_pin = DEFAULT_UART_RX_PIN;
-static bool red_team_enabled = false;  // Default: disabled
-static uint32_t screen_timeout_ms = DEFAULT_SCREEN_TIMEOUT_MS;
-static uint8_t screen_brightness = DEFAULT_SCREEN_BRIGHTNESS;
-static gps_type_t gps_type = GPS_TYPE_ATGM;  // Default: ATGM
+static settings_blob_t current = {
+    .version = SETTINGS_SCHEMA_VERSION,
+    .size = sizeof(settings_blob_t),
+    .uart_tx_pin = DEFAULT_UART_TX_PIN,
+    .uart_rx_pin = DEFAULT_UART_RX_PIN,
+    .uart_log_level = DEFAULT_UART_LOG_LEVEL,
+    .red_team_enabled = 0,              // Default: disabled
+    .uart_baud = DEFAULT_UART_BAUD,
+    .screen_timeout_ms = DEFAULT_SCREEN_TIMEOUT_MS,
+    .screen_brightness = DEFAULT_SCREEN_BRIGHTNESS,
+    .gps_type = GPS_TYPE_ATGM,          // Default: ATGM
+};
+
+static SemaphoreHandle_t settings_mutex = NULL;
+static esp_timer_handle_t commit_timer = NULL;
+static uint32_t change_count = 0;       // Bumped by every setter
+static uint32_t committed_count = 0;    // change_count of the last commit
+static bool legacy_keys_present = false;
 
 // Reserved GPIO pins that should not be used (ESP32-S3 specific)
 // These include strapping pins, flash/PSRAM pins, USB pins, etc.
@@ -69,6 +127,121 @@ bool settings_is_valid_gpio_pin(int pin)
     return true;
 }
 
+/**
+ * @brief Clamp loaded values to what the rest of the firmware accepts
+ */
+static void validate(settings_blob_t *b)
+{
+    if (b->uart_baud < DEFAULT_UART_BAUD || b->uart_baud > 5000000) {
+        b->uart_baud = DEFAULT_UART_BAUD;
+    }
+    if (b->uart_log_level > UART_LOG_VERBOSE) {
+        b->uart_log_level = DEFAULT_UART_LOG_LEVEL;
+    }
+    b->red_team_enabled = b->red_team_enabled ? 1 : 0;
+    if (b->screen_brightness < 1 || b->screen_brightness > 100) {
+        b->screen_brightness = DEFAULT_SCREEN_BRIGHTNESS;
+    }
+    if (b->gps_type > GPS_TYPE_CAP) {
+        b->gps_type = GPS_TYPE_ATGM;
+    }
+    if (b->power_profile >= POWER_PROFILE_COUNT) {
+        b->power_profile = POWER_PROFILE_AUTO;
+    }
+}
+
+/**
+ * @brief Read the settings blob
+ * @return true if one was found
+ */
+static bool load_blob(nvs_handle_t handle)
+{
+    settings_blob_t stored;
+    size_t len = 0;
+    if (nvs_get_blob(handle, NVS_KEY_BLOB, NULL, &len) != ESP_OK ||
+        len < offsetof(settings_blob_t, uart_tx_pin)) {
+        return false;
+    }
+
+    // Newer firmware may have appended fields this build does not know
+    uint8_t buf[SETTINGS_BLOB_MAX];
+    if (len > sizeof(buf) || nvs_get_blob(handle, NVS_KEY_BLOB, buf, &len) != ESP_OK) {
+        ESP_LOGW(TAG, "Unreadable settings blob (%u bytes)", (unsigned)len);
+        return false;
+    }
+    memcpy(&stored, &current, sizeof(stored));
+    size_t read = len < sizeof(stored) ? len : sizeof(stored);
+    memcpy(&stored, buf, read);
+
+    ESP_LOGI(TAG, "Loaded settings v%u (%u bytes)", stored.version, (unsigned)len);
+    stored.version = SETTINGS_SCHEMA_VERSION;
+    stored.size = sizeof(settings_blob_t);
+    validate(&stored);
+    current = stored;
+
+    // A shorter blob gets the new fields' defaults written back
+    if (read < sizeof(stored)) change_count++;
+    return true;
+}
+
+/**
+ * @brief Read settings stored one key per setting by older firmware
+ * @return true if any key was found
+ */
+static bool load_legacy(nvs_handle_t handle)
+{
+    bool found = false;
+
+    int32_t tx = 0, rx = 0;
+    if (nvs_get_i32(handle, NVS_KEY_UART_TX, &tx) == ESP_OK) {
+        current.uart_tx_pin = (int8_t)tx;
+        found = true;
+    }
+    if (nvs_get_i32(handle, NVS_KEY_UART_RX, &rx) == ESP_OK) {
+        current.uart_rx_pin = (int8_t)rx;
+        found = true;
+    }
+
+    uint32_t u32 = 0;
+    if (nvs_get_u32(handle, NVS_KEY_UART_BAUD, &u32) == ESP_OK) {
+        current.uart_baud = u32;
+        found = true;
+    }
+    if (nvs_get_u32(handle, NVS_KEY_SCR_TIMEOUT, &u32) == ESP_OK) {
+        current.screen_timeout_ms = u32;
+        found = true;
+    }
+
+    uint8_t u8 = 0;
+    if (nvs_get_u8(handle, NVS_KEY_UART_LOG, &u8) == ESP_OK) {
+        current.uart_log_level = u8;
+        found = true;
+    }
+    if (nvs_get_u8(handle, NVS_KEY_RED_TEAM, &u8) == ESP_OK) {
+        current.red_team_enabled = u8;
+        found = true;
+    }
+    if (nvs_get_u8(handle, NVS_KEY_SCR_BRIGHT, &u8) == ESP_OK) {
+        current.screen_brightness = u8;
+        found = true;
+    }
+    if (nvs_get_u8(handle, NVS_KEY_GPS_TYPE, &u8) == ESP_OK) {
+        // Migration: old GPS_TYPE_EXTERNAL(2) removed, old GPS_TYPE_CAP(3) -> new GPS_TYPE_CAP(2)
+        if (u8 == 3) u8 = GPS_TYPE_CAP;
+        current.gps_type = u8;
+        found = true;
+    }
+
+    validate(&current);
+    return found;
+}
+
+static void commit_timer_cb(void *arg)
+{
+    (void)arg;
+    settings_flush();
+}
+
 esp_err_t settings_init(void)
 {
     ESP_LOGI(TAG, "Initializing settings...");
@@ -86,91 +259,57 @@ esp_err_t settings_init(void)
         return ret;
     }
     
+    settings_mutex = xSemaphoreCreateMutex();
+    const esp_timer_create_args_t timer_args = {
+        .callback = commit_timer_cb,
+        .name = "settings_commit",
+    };
+    if (!settings_mutex || esp_timer_create(&timer_args, &commit_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "No memory for settings commit timer");
+        return ESP_ERR_NO_MEM;
+    }
+    
     // Open NVS namespace
     nvs_handle_t handle;
     ret = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
     
     if (ret == ESP_OK) {
-        // Read stored values
-        int32_t tx = DEFAULT_UART_TX_PIN;
-        int32_t rx = DEFAULT_UART_RX_PIN;
-        
-        if (nvs_get_i32(handle, NVS_KEY_UART_TX, &tx) == ESP_OK) {
-            uart_tx_pin = (int)tx;
-            ESP_LOGI(TAG, "Loaded UART TX pin: %d", uart_tx_pin);
-        }
-        
-        if (nvs_get_i32(handle, NVS_KEY_UART_RX, &rx) == ESP_OK) {
-            uart_rx_pin = (int)rx;
-            ESP_LOGI(TAG, "Loaded UART RX pin: %d", uart_rx_pin);
-        }
-        
-        uint8_t red_team_val = 0;
-        if (nvs_get_u8(handle, NVS_KEY_RED_TEAM, &red_team_val) == ESP_OK) {
-            red_team_enabled = (red_team_val != 0);
-            ESP_LOGI(TAG, "Loaded Red Team enabled: %s", red_team_enabled ? "true" : "false");
+        if (!load_blob(handle) && load_legacy(handle)) {
+            // Rewritten as a blob by the first commit
+            ESP_LOGI(TAG, "Migrating per-key settings");
+            legacy_keys_present = true;
+            change_count++;
         }
-        
-        uint32_t timeout_val = 0;
-        if (nvs_get_u32(handle, NVS_KEY_SCR_TIMEOUT, &timeout_val) == ESP_OK) {
-            screen_timeout_ms = timeout_val;
-            ESP_LOGI(TAG, "Loaded screen timeout: %lu ms", (unsigned long)screen_timeout_ms);
-        }
-        
-        uint8_t bright_val = 0;
-        if (nvs_get_u8(handle, NVS_KEY_SCR_BRIGHT, &bright_val) == ESP_OK) {
-            if (bright_val >= 1 && bright_val <= 100) {
-                screen_brightness = bright_val;
-            }
-            ESP_LOGI(TAG, "Loaded screen brightness: %d%%", screen_brightness);
-        }
-        
-        uint8_t gps_val = 0;
-        if (nvs_get_u8(handle, NVS_KEY_GPS_TYPE, &gps_val) == ESP_OK) {
-            // Migration: old GPS_TYPE_EXTERNAL(2) removed, old GPS_TYPE_CAP(3) -> new GPS_TYPE_CAP(2)
-            if (gps_val == 3) gps_val = GPS_TYPE_CAP;
-            if (gps_val <= GPS_TYPE_CAP) {
-                gps_type = (gps_type_t)gps_val;
-            } else {
-                gps_type = GPS_TYPE_ATGM;
-            }
-            ESP_LOGI(TAG, "Loaded GPS type: %d", gps_type);
-        }
-        
         nvs_close(handle);
     } else if (ret == ESP_ERR_NVS_NOT_FOUND) {
         ESP_LOGI(TAG, "No settings found, using defaults (TX=%d, RX=%d)", 
-                 uart_tx_pin, uart_rx_pin);
+                 current.uart_tx_pin, current.uart_rx_pin);
     } else {
         ESP_LOGW(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(ret));
     }
     
-    ESP_LOGI(TAG, "Settings initialized (TX=%d, RX=%d)", uart_tx_pin, uart_rx_pin);
+    if (change_count != committed_count) {
+        settings_flush();
+    }
+    
+    ESP_LOGI(TAG, "Settings initialized (TX=%d, RX=%d, brightness %d%%, GPS %d)",
+             current.uart_tx_pin, current.uart_rx_pin, current.screen_brightness, current.gps_type);
     return ESP_OK;
 }
 
-int settings_get_uart_tx_pin(void)
-{
-    return uart_tx_pin;
-}
-
-int settings_get_uart_rx_pin(void)
-{
-    return uart_rx_pin;
-}
-
-esp_err_t settings_set_uart_pins(int tx_pin, int rx_pin)
+esp_err_t settings_flush(void)
 {
-    // Validate pins
-    if (!settings_is_valid_gpio_pin(tx_pin)) {
-        ESP_LOGE(TAG, "Invalid TX pin: %d", tx_pin);
-        return ESP_ERR_INVALID_ARG;
-    }
+    if (!settings_mutex) return ESP_ERR_INVALID_STATE;
     
-    if (!settings_is_valid_gpio_pin(rx_pin)) {
-        ESP_LOGE(TAG, "Invalid RX pin: %d", rx_pin);
-        return ESP_ERR_INVALID_ARG;
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    if (change_count == committed_count) {
+        xSemaphoreGive(settings_mutex);
+        return ESP_OK;
     }
+    esp_timer_stop(commit_timer);
+    settings_blob_t blob = current;
+    uint32_t count = change_count;
+    xSemaphoreGive(settings_mutex);
     
     // Open NVS for writing
     nvs_handle_t handle;
@@ -180,155 +319,192 @@ esp_err_t settings_set_uart_pins(int tx_pin, int rx_pin)
         return ret;
     }
     
-    // Write values
-    ret = nvs_set_i32(handle, NVS_KEY_UART_TX, (int32_t)tx_pin);
+    ret = nvs_set_blob(handle, NVS_KEY_BLOB, &blob, sizeof(blob));
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to write TX pin: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to write settings: %s", esp_err_to_name(ret));
         nvs_close(handle);
         return ret;
     }
     
-    ret = nvs_set_i32(handle, NVS_KEY_UART_RX, (int32_t)rx_pin);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to write RX pin: %s", esp_err_to_name(ret));
-        nvs_close(handle);
-        return ret;
+    if (legacy_keys_present) {
+        for (size_t i = 0; i < sizeof(legacy_keys) / sizeof(legacy_keys[0]); i++) {
+            nvs_erase_key(handle, legacy_keys[i]);
+        }
     }
     
     // Commit
     ret = nvs_commit(handle);
+    nvs_close(handle);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(ret));
-        nvs_close(handle);
         return ret;
     }
     
-    nvs_close(handle);
-    
-    // Update cached values
-    uart_tx_pin = tx_pin;
-    uart_rx_pin = rx_pin;
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    committed_count = count;
+    legacy_keys_present = false;
+    xSemaphoreGive(settings_mutex);
     
-    ESP_LOGI(TAG, "UART pins saved (TX=%d, RX=%d) - restart required", tx_pin, rx_pin);
+    ESP_LOGI(TAG, "Settings saved");
     return ESP_OK;
 }
 
-bool settings_get_red_team_enabled(void)
+/**
+ * @brief Record a change made under settings_mutex and (re)arm the commit timer
+ */
+static void mark_dirty(void)
 {
-    return red_team_enabled;
+    change_count++;
+    esp_timer_stop(commit_timer);
+    esp_timer_start_once(commit_timer, (uint64_t)SETTINGS_COMMIT_DELAY_MS * 1000);
 }
 
-esp_err_t settings_set_red_team_enabled(bool enabled)
+int settings_get_uart_tx_pin(void)
 {
-    // Open NVS for writing
-    nvs_handle_t handle;
-    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open NVS for writing: %s", esp_err_to_name(ret));
-        return ret;
-    }
-    
-    // Write value
-    ret = nvs_set_u8(handle, NVS_KEY_RED_TEAM, enabled ? 1 : 0);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to write Red Team setting: %s", esp_err_to_name(ret));
-        nvs_close(handle);
-        return ret;
+    return current.uart_tx_pin;
+}
+
+int settings_get_uart_rx_pin(void)
+{
+    return current.uart_rx_pin;
+}
+
+esp_err_t settings_set_uart_pins(int tx_pin, int rx_pin)
+{
+    // Validate pins
+    if (!settings_is_valid_gpio_pin(tx_pin)) {
+        ESP_LOGE(TAG, "Invalid TX pin: %d", tx_pin);
+        return ESP_ERR_INVALID_ARG;
     }
     
-    // Commit
-    ret = nvs_commit(handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(ret));
-        nvs_close(handle);
-        return ret;
+    if (!settings_is_valid_gpio_pin(rx_pin)) {
+        ESP_LOGE(TAG, "Invalid RX pin: %d", rx_pin);
+        return ESP_ERR_INVALID_ARG;
     }
+    if (!settings_mutex) return ESP_ERR_INVALID_STATE;
     
-    nvs_close(handle);
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    current.uart_tx_pin = (int8_t)tx_pin;
+    current.uart_rx_pin = (int8_t)rx_pin;
+    mark_dirty();
+    xSemaphoreGive(settings_mutex);
     
-    // Update cached value
-    red_team_enabled = enabled;
+    // Takes effect after a restart, so it must not wait for the timer
+    esp_err_t ret = settings_flush();
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "UART pins saved (TX=%d, RX=%d) - restart required", tx_pin, rx_pin);
+    }
+    return ret;
+}
+
+uint32_t settings_get_uart_baud(void)
+{
+    return current.uart_baud;
+}
+
+esp_err_t settings_set_uart_baud(uint32_t baud)
+{
+    if (baud < DEFAULT_UART_BAUD || baud > 5000000) {
+        ESP_LOGE(TAG, "Invalid UART baud: %lu", (unsigned long)baud);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!settings_mutex) return ESP_ERR_INVALID_STATE;
     
-    ESP_LOGI(TAG, "Red Team setting saved: %s", enabled ? "enabled" : "disabled");
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    if (current.uart_baud != baud) {
+        current.uart_baud = baud;
+        mark_dirty();
+    }
+    xSemaphoreGive(settings_mutex);
     return ESP_OK;
 }
 
-uint32_t settings_get_screen_timeout_ms(void)
+uart_log_level_t settings_get_uart_log_level(void)
 {
-    return screen_timeout_ms;
+    return (uart_log_level_t)current.uart_log_level;
 }
 
-esp_err_t settings_set_screen_timeout_ms(uint32_t timeout_ms)
+esp_err_t settings_set_uart_log_level(uart_log_level_t level)
 {
-    nvs_handle_t handle;
-    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open NVS for writing: %s", esp_err_to_name(ret));
-        return ret;
+    if (level > UART_LOG_VERBOSE) {
+        return ESP_ERR_INVALID_ARG;
     }
+    if (!settings_mutex) return ESP_ERR_INVALID_STATE;
     
-    ret = nvs_set_u32(handle, NVS_KEY_SCR_TIMEOUT, timeout_ms);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to write screen timeout: %s", esp_err_to_name(ret));
-        nvs_close(handle);
-        return ret;
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    bool changed = current.uart_log_level != level;
+    if (changed) {
+        current.uart_log_level = (uint8_t)level;
+        mark_dirty();
     }
+    xSemaphoreGive(settings_mutex);
     
-    ret = nvs_commit(handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(ret));
-        nvs_close(handle);
-        return ret;
+    // Counter reports are timed by the RX task, which may be idling
+    if (changed) uart_wake_rx();
+    return ESP_OK;
+}
+
+bool settings_get_red_team_enabled(void)
+{
+    return current.red_team_enabled != 0;
+}
+
+esp_err_t settings_set_red_team_enabled(bool enabled)
+{
+    if (!settings_mutex) return ESP_ERR_INVALID_STATE;
+    
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    if (current.red_team_enabled != (enabled ? 1 : 0)) {
+        current.red_team_enabled = enabled ? 1 : 0;
+        mark_dirty();
     }
+    xSemaphoreGive(settings_mutex);
     
-    nvs_close(handle);
-    screen_timeout_ms = timeout_ms;
+    ESP_LOGI(TAG, "Red Team setting: %s", enabled ? "enabled" : "disabled");
+    return ESP_OK;
+}
+
+uint32_t settings_get_screen_timeout_ms(void)
+{
+    return current.screen_timeout_ms;
+}
+
+esp_err_t settings_set_screen_timeout_ms(uint32_t timeout_ms)
+{
+    if (!settings_mutex) return ESP_ERR_INVALID_STATE;
     
-    ESP_LOGI(TAG, "Screen timeout saved: %lu ms", (unsigned long)timeout_ms);
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    if (current.screen_timeout_ms != timeout_ms) {
+        current.screen_timeout_ms = timeout_ms;
+        mark_dirty();
+    }
+    xSemaphoreGive(settings_mutex);
     return ESP_OK;
 }
 
 uint8_t settings_get_screen_brightness(void)
 {
-    return screen_brightness;
+    return current.screen_brightness;
 }
 
 esp_err_t settings_set_screen_brightness(uint8_t brightness)
 {
     if (brightness < 1) brightness = 1;
     if (brightness > 100) brightness = 100;
+    if (!settings_mutex) return ESP_ERR_INVALID_STATE;
     
-    nvs_handle_t handle;
-    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open NVS for writing: %s", esp_err_to_name(ret));
-        return ret;
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    if (current.screen_brightness != brightness) {
+        current.screen_brightness = brightness;
+        mark_dirty();
     }
-    
-    ret = nvs_set_u8(handle, NVS_KEY_SCR_BRIGHT, brightness);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to write screen brightness: %s", esp_err_to_name(ret));
-        nvs_close(handle);
-        return ret;
-    }
-    
-    ret = nvs_commit(handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(ret));
-        nvs_close(handle);
-        return ret;
-    }
-    
-    nvs_close(handle);
-    screen_brightness = brightness;
-    
-    ESP_LOGI(TAG, "Screen brightness saved: %d%%", brightness);
+    xSemaphoreGive(settings_mutex);
     return ESP_OK;
 }
 
 gps_type_t settings_get_gps_type(void)
 {
-    return gps_type;
+    return (gps_type_t)current.gps_type;
 }
 
 esp_err_t settings_set_gps_type(gps_type_t type)
@@ -336,31 +512,34 @@ esp_err_t settings_set_gps_type(gps_type_t type)
     if (type > GPS_TYPE_CAP) {
         return ESP_ERR_INVALID_ARG;
     }
+    if (!settings_mutex) return ESP_ERR_INVALID_STATE;
     
-    nvs_handle_t handle;
-    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open NVS for writing: %s", esp_err_to_name(ret));
-        return ret;
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    if (current.gps_type != type) {
+        current.gps_type = (uint8_t)type;
+        mark_dirty();
     }
-    
-    ret = nvs_set_u8(handle, NVS_KEY_GPS_TYPE, (uint8_t)type);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to write GPS type: %s", esp_err_to_name(ret));
-        nvs_close(handle);
-        return ret;
+    xSemaphoreGive(settings_mutex);
+    return ESP_OK;
+}
+
+power_profile_t settings_get_power_profile(void)
+{
+    return (power_profile_t)current.power_profile;
+}
+
+esp_err_t settings_set_power_profile(power_profile_t profile)
+{
+    if (profile >= POWER_PROFILE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
     }
+    if (!settings_mutex) return ESP_ERR_INVALID_STATE;
     
-    ret = nvs_commit(handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(ret));
-        nvs_close(handle);
-        return ret;
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    if (current.power_profile != profile) {
+        current.power_profile = (uint8_t)profile;
+        mark_dirty();
     }
-    
-    nvs_close(handle);
-    gps_type = type;
-    
-    ESP_LOGI(TAG, "GPS type saved: %d", type);
+    xSemaphoreGive(settings_mutex);
     return ESP_OK;
 }
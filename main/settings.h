@@ -1,23 +1,50 @@
 /**
  * @file settings.h
  * @brief Application settings stored in NVS
+ *
+ * Getters read a RAM copy. Setters update it at once and save it
+ * SETTINGS_COMMIT_DELAY_MS after the last change, as one versioned blob;
+ * settings_flush() saves pending changes right away.
  */
 
 #ifndef SETTINGS_H
 #define SETTINGS_H
 
 #include "esp_err.h"
+#include "sdkconfig.h"
 #include <stdint.h>
 #include <stdbool.h>
 
 // Default UART pin values
 #define DEFAULT_UART_TX_PIN     2
 #define DEFAULT_UART_RX_PIN     1
+#define DEFAULT_UART_BAUD       115200
+
+// UART console logging verbosity
+typedef enum {
+    UART_LOG_QUIET = 0,     // Warnings and errors only
+    UART_LOG_COUNTERS,      // Periodic lines/s and bytes/s summary
+    UART_LOG_LINES,         // Every RX/TX line
+    UART_LOG_VERBOSE,       // Lines plus heap report on every TX
+} uart_log_level_t;
+
+#if defined(CONFIG_UART_LOG_DEFAULT_VERBOSE)
+#define DEFAULT_UART_LOG_LEVEL  UART_LOG_VERBOSE
+#elif defined(CONFIG_UART_LOG_DEFAULT_LINES)
+#define DEFAULT_UART_LOG_LEVEL  UART_LOG_LINES
+#elif defined(CONFIG_UART_LOG_DEFAULT_COUNTERS)
+#define DEFAULT_UART_LOG_LEVEL  UART_LOG_COUNTERS
+#else
+#define DEFAULT_UART_LOG_LEVEL  UART_LOG_QUIET
+#endif
 
 // Default screen settings
 #define DEFAULT_SCREEN_TIMEOUT_MS   30000   // 30 seconds
 #define DEFAULT_SCREEN_BRIGHTNESS   100     // 100%
 
+// Pending changes are written this long after the last setter call
+#define SETTINGS_COMMIT_DELAY_MS    2000
+
 // Valid GPIO pin range for ESP32-S3
 #define MIN_GPIO_PIN            0
 #define MAX_GPIO_PIN            48
@@ -28,6 +55,15 @@
  */
 esp_err_t settings_init(void);
 
+/**
+ * @brief Write pending changes to NVS now
+ *
+ * Called by the commit timer, and by screens that change settings when
+ * they close so nothing waits on the timer.
+ * @return ESP_OK on success (or nothing pending)
+ */
+esp_err_t settings_flush(void);
+
 /**
  * @brief Get UART TX pin
  * @return GPIO pin number for UART TX
@@ -41,13 +77,39 @@ int settings_get_uart_tx_pin(void);
 int settings_get_uart_rx_pin(void);
 
 /**
- * @brief Set UART pins with validation
+ * @brief Set UART pins with validation (saved immediately: they apply after restart)
  * @param tx_pin TX GPIO pin number
  * @param rx_pin RX GPIO pin number
  * @return ESP_OK on success, ESP_ERR_INVALID_ARG if pin is invalid
  */
 esp_err_t settings_set_uart_pins(int tx_pin, int rx_pin);
 
+/**
+ * @brief Get last negotiated UART baud rate
+ * @return Baud rate (DEFAULT_UART_BAUD if never negotiated)
+ */
+uint32_t settings_get_uart_baud(void);
+
+/**
+ * @brief Store negotiated UART baud rate
+ * @param baud Baud rate (115200 - 5000000)
+ * @return ESP_OK on success
+ */
+esp_err_t settings_set_uart_baud(uint32_t baud);
+
+/**
+ * @brief Get UART console logging verbosity
+ * @return Log level (DEFAULT_UART_LOG_LEVEL if never set)
+ */
+uart_log_level_t settings_get_uart_log_level(void);
+
+/**
+ * @brief Set UART console logging verbosity (takes effect immediately)
+ * @param level Log level
+ * @return ESP_OK on success
+ */
+esp_err_t settings_set_uart_log_level(uart_log_level_t level);
+
 /**
  * @brief Check if a GPIO pin number is valid for UART
  * @param pin GPIO pin number
@@ -114,6 +176,28 @@ gps_type_t settings_get_gps_type(void);
  */
 esp_err_t settings_set_gps_type(gps_type_t type);
 
+// Power profiles (power_governor.h)
+typedef enum {
+    POWER_PROFILE_AUTO = 0,         // Picked from the battery level and drain
+    POWER_PROFILE_PERFORMANCE,
+    POWER_PROFILE_BALANCED,
+    POWER_PROFILE_ENDURANCE,
+    POWER_PROFILE_COUNT
+} power_profile_t;
+
+/**
+ * @brief Get the selected power profile
+ * @return Power profile, POWER_PROFILE_AUTO by default
+ */
+power_profile_t settings_get_power_profile(void);
+
+/**
+ * @brief Set the power profile
+ * @param profile Power profile
+ * @return ESP_OK on success
+ */
+esp_err_t settings_set_power_profile(power_profile_t profile);
+
 #endif // SETTINGS_H
 
 
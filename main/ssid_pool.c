@@ -0,0 +1,273 @@
+/**
+ * @file ssid_pool.c
+ * @brief Interned SSIDs shared by every store, addressed by 16-bit handles
+ */
+
+#include "ssid_pool.h"
+#include "network_store.h"
+#include "probe_store.h"
+#include "mem_monitor.h"
+#include "uart_handler.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "SSID_POOL";
+
+#ifdef CONFIG_NETWORK_STORE_PSRAM
+#define POOL_CAPS       (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define POOL_CAPS       (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+// Every store's records at once, plus screens holding a few
+#define SSID_POOL_MAX   (NETWORK_STORE_MAX + PROBE_STORE_MAX + 128)
+
+// Strings take whole units; freed blocks are reused by the same unit count
+#define UNIT            8
+#define CHUNK_UNITS     (SSID_POOL_CHUNK / UNIT)
+#define MAX_UNITS       ((MAX_SSID_LEN + UNIT - 1) / UNIT)
+
+_Static_assert(SSID_POOL_MAX < UINT16_MAX, "SSID handles are 16-bit");
+_Static_assert(SSID_POOL_CHUNKS * CHUNK_UNITS <= UINT16_MAX, "SSID units are 16-bit");
+
+typedef struct {
+    uint16_t unit;          // First unit of the text; next free entry while unused
+    uint16_t refs;          // 0 = unused
+} entry_t;
+
+MEM_BUDGET(ssid_pool, SSID_POOL_MAX, sizeof(entry_t) + 2 * sizeof(uint16_t), MEM_BUDGET_PSRAM);
+
+static char *chunks[SSID_POOL_CHUNKS];
+static uint32_t units_used = 1;                 // Unit 0 is never handed out
+static uint16_t free_blocks[MAX_UNITS + 1];     // First free block per size, 0 = none
+
+static entry_t *entries = NULL;                 // [SSID_POOL_MAX + 1]; 0 is SSID_NONE
+static uint16_t entries_used = 1;
+static uint16_t free_entry = 0;
+static int live = 0;
+
+// Open-addressed handles, at most half full
+static uint16_t *slots = NULL;
+static uint32_t hash_mask = 0;
+
+static SemaphoreHandle_t pool_mutex = NULL;
+
+static void *pool_alloc(size_t size)
+{
+    void *p = heap_caps_calloc(1, size, POOL_CAPS);
+    return p ? p : calloc(1, size);
+}
+
+static char *unit_at(uint32_t unit)
+{
+    return &chunks[unit / CHUNK_UNITS][(unit % CHUNK_UNITS) * UNIT];
+}
+
+static uint32_t hash_ssid(const char *ssid)
+{
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (const char *p = ssid; *p; p++) {
+        h = (h ^ (uint8_t)*p) * 16777619u;
+    }
+    return h & hash_mask;
+}
+
+/**
+ * @brief Slot holding ssid, or the empty slot where it goes (pool_mutex held)
+ */
+static uint32_t find_slot(const char *ssid)
+{
+    uint32_t slot = hash_ssid(ssid);
+    while (slots[slot] && strcmp(unit_at(entries[slots[slot]].unit), ssid) != 0) {
+        slot = (slot + 1) & hash_mask;
+    }
+    return slot;
+}
+
+/**
+ * @brief Empty a slot, moving later entries of its run back (pool_mutex held)
+ */
+static void remove_slot(uint32_t hole)
+{
+    uint32_t slot = hole;
+    while (1) {
+        slot = (slot + 1) & hash_mask;
+        if (!slots[slot]) break;
+        uint32_t home = hash_ssid(unit_at(entries[slots[slot]].unit));
+        // Stays put if its home lies cyclically in (hole, slot]
+        bool stays = hole <= slot ? (home > hole && home <= slot)
+                                  : (home > hole || home <= slot);
+        if (stays) continue;
+        slots[hole] = slots[slot];
+        hole = slot;
+    }
+    slots[hole] = 0;
+}
+
+static uint32_t take_block(uint32_t units)
+{
+    uint16_t unit = free_blocks[units];
+    if (unit) {
+        memcpy(&free_blocks[units], unit_at(unit), sizeof(uint16_t));
+        return unit;
+    }
+
+    uint32_t first = units_used;
+    if (first / CHUNK_UNITS != (first + units - 1) / CHUNK_UNITS) {
+        first = (first / CHUNK_UNITS + 1) * CHUNK_UNITS;
+    }
+    uint32_t chunk = first / CHUNK_UNITS;
+    if (chunk >= SSID_POOL_CHUNKS) return 0;
+    if (!chunks[chunk]) {
+        chunks[chunk] = pool_alloc(SSID_POOL_CHUNK);
+        if (!chunks[chunk]) return 0;
+    }
+    units_used = first + units;
+    return first;
+}
+
+static void give_block(uint32_t unit, uint32_t units)
+{
+    memcpy(unit_at(unit), &free_blocks[units], sizeof(uint16_t));
+    free_blocks[units] = (uint16_t)unit;
+}
+
+esp_err_t ssid_pool_init(void)
+{
+    if (entries) return ESP_OK;
+
+    uint32_t size = 1;
+    while (size < 2 * SSID_POOL_MAX) size <<= 1;
+
+    if (!pool_mutex) {
+        pool_mutex = xSemaphoreCreateMutex();
+        if (!pool_mutex) return ESP_ERR_NO_MEM;
+    }
+    entry_t *table = pool_alloc((SSID_POOL_MAX + 1) * sizeof(entry_t));
+    slots = pool_alloc(size * sizeof(uint16_t));
+    chunks[0] = pool_alloc(SSID_POOL_CHUNK);
+    if (!table || !slots || !chunks[0]) {
+        ESP_LOGE(TAG, "Failed to allocate SSID pool");
+        free(table);
+        free(slots);
+        free(chunks[0]);
+        slots = NULL;
+        chunks[0] = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    hash_mask = size - 1;
+    entries = table;
+
+    ESP_LOGI(TAG, "SSID pool ready (up to %d SSIDs)", SSID_POOL_MAX);
+    return ESP_OK;
+}
+
+int ssid_pool_acquire(const char *ssid)
+{
+    if (!ssid || !ssid[0]) return SSID_NONE;
+    if (!entries) return -1;
+
+    char text[MAX_SSID_LEN];
+    strlcpy(text, ssid, sizeof(text));
+    uint32_t len = strlen(text) + 1;
+    uint32_t units = (len + UNIT - 1) / UNIT;
+
+    xSemaphoreTake(pool_mutex, portMAX_DELAY);
+
+    uint32_t slot = find_slot(text);
+    uint16_t handle = slots[slot];
+    if (handle) {
+        if (entries[handle].refs < UINT16_MAX) entries[handle].refs++;
+        xSemaphoreGive(pool_mutex);
+        return handle;
+    }
+
+    if (free_entry) {
+        handle = free_entry;
+        free_entry = entries[handle].unit;
+    } else if (entries_used <= SSID_POOL_MAX) {
+        handle = entries_used++;
+    } else {
+        xSemaphoreGive(pool_mutex);
+        return -1;
+    }
+
+    uint32_t unit = take_block(units);
+    if (!unit) {
+        entries[handle].unit = free_entry;
+        free_entry = handle;
+        xSemaphoreGive(pool_mutex);
+        return -1;
+    }
+    memcpy(unit_at(unit), text, len);
+    entries[handle].unit = (uint16_t)unit;
+    entries[handle].refs = 1;
+    slots[slot] = handle;
+    live++;
+
+    xSemaphoreGive(pool_mutex);
+    return handle;
+}
+
+void ssid_pool_retain(ssid_handle_t handle)
+{
+    if (handle == SSID_NONE || !entries || handle > SSID_POOL_MAX) return;
+
+    xSemaphoreTake(pool_mutex, portMAX_DELAY);
+    if (entries[handle].refs && entries[handle].refs < UINT16_MAX) {
+        entries[handle].refs++;
+    }
+    xSemaphoreGive(pool_mutex);
+}
+
+void ssid_pool_release(ssid_handle_t handle)
+{
+    if (handle == SSID_NONE || !entries || handle > SSID_POOL_MAX) return;
+
+    xSemaphoreTake(pool_mutex, portMAX_DELAY);
+    entry_t *e = &entries[handle];
+    // A saturated count is never released, so the string just stays
+    if (e->refs && e->refs < UINT16_MAX && --e->refs == 0) {
+        const char *text = unit_at(e->unit);
+        uint32_t units = (strlen(text) + 1 + UNIT - 1) / UNIT;
+        remove_slot(find_slot(text));
+        give_block(e->unit, units);
+        e->unit = free_entry;
+        free_entry = handle;
+        live--;
+    }
+    xSemaphoreGive(pool_mutex);
+}
+
+int ssid_pool_find(const char *ssid)
+{
+    if (!ssid || !ssid[0]) return SSID_NONE;
+    if (!entries) return -1;
+
+    char text[MAX_SSID_LEN];
+    strlcpy(text, ssid, sizeof(text));
+
+    xSemaphoreTake(pool_mutex, portMAX_DELAY);
+    uint16_t handle = slots[find_slot(text)];
+    xSemaphoreGive(pool_mutex);
+    return handle ? handle : -1;
+}
+
+const char *ssid_pool_str(ssid_handle_t handle)
+{
+    if (handle == SSID_NONE || !entries || handle > SSID_POOL_MAX ||
+        !entries[handle].refs) {
+        return "";
+    }
+    return unit_at(entries[handle].unit);
+}
+
+int ssid_pool_count(void)
+{
+    return live;
+}
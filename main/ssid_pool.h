@@ -0,0 +1,70 @@
+/**
+ * @file ssid_pool.h
+ * @brief Interned SSIDs shared by every store, addressed by 16-bit handles
+ *
+ * Each distinct SSID is kept once and hash-indexed; records hold a
+ * handle, so the same network seen by a scan, the probe list and the
+ * sniffer costs one copy, and SSID equality is a handle compare.
+ * Handles are reference counted: a store acquires one per record and
+ * releases it when the record goes, and the string's space is reused by
+ * the next SSID of the same size class.
+ *
+ * String memory is never returned to the heap, so ssid_pool_str() stays
+ * readable for as long as the caller's record holds the handle. Any task
+ * may call in.
+ */
+
+#ifndef SSID_POOL_H
+#define SSID_POOL_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SSID_POOL_CHUNK     1024        // Strings never straddle a chunk
+#define SSID_POOL_CHUNKS    96
+
+#define SSID_NONE           0           // Handle of the empty (hidden) SSID
+
+typedef uint16_t ssid_handle_t;
+
+/**
+ * @brief Allocate the index (safe to call again)
+ * @return ESP_OK, ESP_ERR_NO_MEM
+ */
+esp_err_t ssid_pool_init(void);
+
+/**
+ * @brief Intern an SSID and take a reference to it
+ * @param ssid Text, cut at MAX_SSID_LEN - 1 bytes; empty gives SSID_NONE
+ * @return Handle, or -1 if the pool is full (no reference taken)
+ */
+int ssid_pool_acquire(const char *ssid);
+
+/**
+ * @brief Take another reference to a handle already held
+ */
+void ssid_pool_retain(ssid_handle_t handle);
+
+/**
+ * @brief Drop a reference; the SSID is forgotten with its last one
+ */
+void ssid_pool_release(ssid_handle_t handle);
+
+/**
+ * @brief Handle of an SSID if it is interned (no reference taken)
+ * @return Handle, SSID_NONE for an empty SSID, -1 if not interned
+ */
+int ssid_pool_find(const char *ssid);
+
+/**
+ * @brief Text of a handle ("" for SSID_NONE or a released handle)
+ */
+const char *ssid_pool_str(ssid_handle_t handle);
+
+/**
+ * @brief Distinct SSIDs currently interned
+ */
+int ssid_pool_count(void);
+
+#endif // SSID_POOL_H
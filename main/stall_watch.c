@@ -0,0 +1,126 @@
+/**
+ * @file stall_watch.c
+ * @brief Latency watchdog for loop iterations, handlers and UI lock holds
+ */
+
+#include "stall_watch.h"
+#include "text_ui.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+static const char *TAG = "STALL";
+
+static const char *const site_names[STALL_SITE_COUNT] = {
+    [STALL_SITE_LOOP]    = "loop",
+    [STALL_SITE_KEY]     = "on_key",
+    [STALL_SITE_TICK]    = "on_tick",
+    [STALL_SITE_DRAW]    = "on_draw",
+    [STALL_SITE_UART]    = "uart cb",
+    [STALL_SITE_UI_LOCK] = "ui lock",
+};
+
+static stall_handler_t handlers[STALL_WATCH_HANDLERS];
+static int64_t last_log_ms[STALL_WATCH_HANDLERS];
+static int handler_count;
+static uint32_t untracked;              // Reports of handlers beyond the table
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Slot of a handler, added if new (lock held)
+ * @return Index, or -1 when the table is full
+ */
+static int find_slot(stall_site_t site, const void *handler)
+{
+    for (int i = 0; i < handler_count; i++) {
+        if (handlers[i].handler == handler && handlers[i].site == site) return i;
+    }
+    if (handler_count == STALL_WATCH_HANDLERS) return -1;
+    handlers[handler_count] = (stall_handler_t){ .site = site, .handler = handler };
+    return handler_count++;
+}
+
+void stall_watch_record(stall_site_t site, const void *handler, uint32_t us)
+{
+    if (site >= STALL_SITE_COUNT) return;
+    bool stalled = STALL_WATCH_MS > 0 && us > STALL_WATCH_MS * 1000U;
+
+    // The title is only read for slow runs; a draw racing with it can tear it
+    char screen[sizeof(handlers[0].screen)] = "";
+    if (stalled) {
+        strlcpy(screen, ui_get_title(), sizeof(screen));
+    }
+
+    int64_t now_ms = esp_timer_get_time() / 1000;
+    bool log = false;
+    portENTER_CRITICAL(&lock);
+    int slot = find_slot(site, handler);
+    if (slot < 0) {
+        untracked++;
+    } else {
+        stall_handler_t *h = &handlers[slot];
+        h->calls++;
+        if (us > h->max_us) {
+            h->max_us = us;
+            memcpy(h->screen, screen, sizeof(h->screen));
+        }
+        if (stalled) {
+            h->stalls++;
+            if (h->stalls == 1 || now_ms - last_log_ms[slot] >= STALL_WATCH_LOG_MS) {
+                last_log_ms[slot] = now_ms;
+                log = true;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (log || (stalled && slot < 0)) {
+        ESP_LOGW(TAG, "%s %p took %lu ms on %s (screen \"%s\")", site_names[site], handler,
+                 (unsigned long)(us / 1000), pcTaskGetName(NULL), screen);
+    }
+}
+
+int stall_watch_get(stall_handler_t *out, int max)
+{
+    if (!out || max <= 0) return 0;
+
+    portENTER_CRITICAL(&lock);
+    int count = 0;
+    for (int i = 0; i < handler_count; i++) {
+        // Insertion by worst case; the table is small
+        stall_handler_t h = handlers[i];
+        int pos = count < max ? count : max - 1;
+        if (count == max && out[pos].max_us >= h.max_us) continue;
+        while (pos > 0 && out[pos - 1].max_us < h.max_us) {
+            out[pos] = out[pos - 1];
+            pos--;
+        }
+        out[pos] = h;
+        if (count < max) count++;
+    }
+    portEXIT_CRITICAL(&lock);
+    return count;
+}
+
+void stall_watch_dump(void)
+{
+    stall_handler_t list[STALL_WATCH_HANDLERS];
+    int count = stall_watch_get(list, STALL_WATCH_HANDLERS);
+
+    ESP_LOGI(TAG, "%-8s %-10s %7s %6s %8s  screen at worst", "site", "handler",
+             "calls", "stalls", "max ms");
+    for (int i = 0; i < count; i++) {
+        const stall_handler_t *h = &list[i];
+        ESP_LOGI(TAG, "%-8s %10p %7lu %6lu %8.1f  %s", site_names[h->site], h->handler,
+                 (unsigned long)h->calls, (unsigned long)h->stalls, h->max_us / 1000.0,
+                 h->screen);
+    }
+    if (untracked) {
+        ESP_LOGI(TAG, "%lu reports from handlers beyond the %d tracked",
+                 (unsigned long)untracked, STALL_WATCH_HANDLERS);
+    }
+}
@@ -0,0 +1,74 @@
+/**
+ * @file stall_watch.h
+ * @brief Latency watchdog for loop iterations, handlers and UI lock holds
+ *
+ * Callers time a piece of work and report it with the function that did
+ * it. Every report counts towards that handler's calls and worst case;
+ * one over STALL_WATCH_MS is logged with the screen that was on top, at
+ * most once a second per handler. Handlers are logged as code addresses,
+ * which idf.py monitor decodes to function names.
+ *
+ * Watched:
+ * - main loop iterations (handler NULL), and the on_key, on_tick and
+ *   on_draw calls inside them
+ * - UART line callbacks, on the RX task of their link
+ * - UI lock holds outside the main loop, attributed to the function that
+ *   took the lock: esp_timer callbacks that draw, and the render task.
+ *   The main loop and the render task wait for the lock meanwhile.
+ *
+ * Timer callbacks that never take the UI lock are not watched.
+ */
+
+#ifndef STALL_WATCH_H
+#define STALL_WATCH_H
+
+#include "sdkconfig.h"
+#include <stdint.h>
+
+#ifdef CONFIG_STALL_WATCH_MS
+#define STALL_WATCH_MS          CONFIG_STALL_WATCH_MS
+#else
+#define STALL_WATCH_MS          20
+#endif
+
+#define STALL_WATCH_HANDLERS    32      // Handlers tracked; later ones are not counted
+#define STALL_WATCH_LOG_MS      1000    // Least time between logs of one handler
+
+typedef enum {
+    STALL_SITE_LOOP = 0,
+    STALL_SITE_KEY,
+    STALL_SITE_TICK,
+    STALL_SITE_DRAW,
+    STALL_SITE_UART,
+    STALL_SITE_UI_LOCK,
+    STALL_SITE_COUNT
+} stall_site_t;
+
+typedef struct {
+    stall_site_t site;
+    const void *handler;
+    uint32_t calls;
+    uint32_t stalls;                    // Runs over STALL_WATCH_MS
+    uint32_t max_us;
+    char screen[20];                    // Title on top during the worst run, if it stalled
+} stall_handler_t;
+
+/**
+ * @brief Report one run of a handler (any task)
+ * @param handler Function that ran, NULL for a whole main loop iteration
+ * @param us Time it took
+ */
+void stall_watch_record(stall_site_t site, const void *handler, uint32_t us);
+
+/**
+ * @brief Copy the handler counters, worst case first
+ * @return Handlers written
+ */
+int stall_watch_get(stall_handler_t *out, int max);
+
+/**
+ * @brief Log the handler counters to the console
+ */
+void stall_watch_dump(void);
+
+#endif // STALL_WATCH_H
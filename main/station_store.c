@@ -0,0 +1,378 @@
+/**
+ * @file station_store.c
+ * @brief Sniffed stations and the APs they talk to, kept across views
+ */
+
+#include "station_store.h"
+#include "mem_monitor.h"
+#include "mac_set.h"
+#include "network_store.h"
+#include "ssid_pool.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "STATIONS";
+
+#ifdef CONFIG_SPIRAM
+#define STORE_CAPS      (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define STORE_CAPS      (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+#define MAX_AGE_US      ((int64_t)STATION_STORE_MAX_AGE_S * 1000000)
+#define SWEEP_US        ((int64_t)STATION_STORE_SWEEP_MS * 1000)
+
+// Station, linked into its AP's client list
+typedef struct {
+    int64_t first_us;
+    int64_t last_us;
+    uint16_t ap;                // STATION_NONE = unlinked
+    uint16_t prev;              // Neighbours in the AP's list
+    uint16_t next;
+    bool live;                  // false once aged out (the key stays until recycled)
+} sta_rec_t;
+
+// AP with the ends of its client list
+typedef struct {
+    int64_t last_us;
+    ssid_handle_t ssid;
+    uint16_t head;
+    uint16_t tail;
+    uint16_t clients;
+    uint16_t listed;
+    uint8_t channel;
+    bool live;
+} ap_rec_t;
+
+MEM_BUDGET(station_store, STATION_STORE_MAX, sizeof(sta_rec_t), MEM_BUDGET_PSRAM);
+
+static sta_rec_t *stations = NULL;
+static ap_rec_t *aps = NULL;
+static mac_set_t station_index;         // Packed MAC -> stations[]
+static mac_set_t ap_index;              // "SSID, CHn" -> aps[]
+static SemaphoreHandle_t store_mutex = NULL;
+static volatile uint32_t generation = 0;
+static int live_stations = 0;
+static int64_t last_sweep_us = 0;
+
+esp_err_t station_store_init(void)
+{
+    if (stations) return ESP_OK;
+
+    if (!store_mutex) {
+        store_mutex = xSemaphoreCreateMutex();
+        if (!store_mutex) return ESP_ERR_NO_MEM;
+    }
+
+    sta_rec_t *sta = heap_caps_calloc(STATION_STORE_MAX, sizeof(sta_rec_t), STORE_CAPS);
+    if (!sta) sta = calloc(STATION_STORE_MAX, sizeof(sta_rec_t));
+    ap_rec_t *ap = calloc(STATION_STORE_APS, sizeof(ap_rec_t));
+    if (!sta || !ap || mac_set_init(&station_index, STATION_STORE_MAX) != ESP_OK ||
+        mac_set_init(&ap_index, STATION_STORE_APS) != ESP_OK) {
+        ESP_LOGE(TAG, "No memory for %d stations", STATION_STORE_MAX);
+        mac_set_free(&station_index);
+        free(sta);
+        free(ap);
+        return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    aps = ap;
+    stations = sta;
+    xSemaphoreGive(store_mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Take a station off its AP's list (store_mutex held)
+ */
+static void unlink_station(uint16_t s)
+{
+    sta_rec_t *sta = &stations[s];
+    if (sta->ap == STATION_NONE) return;
+
+    ap_rec_t *ap = &aps[sta->ap];
+    if (sta->prev != STATION_NONE) stations[sta->prev].next = sta->next; else ap->head = sta->next;
+    if (sta->next != STATION_NONE) stations[sta->next].prev = sta->prev; else ap->tail = sta->prev;
+    ap->clients--;
+    sta->ap = STATION_NONE;
+}
+
+/**
+ * @brief Append a station to an AP's list (store_mutex held)
+ */
+static void link_station(uint16_t s, uint16_t a)
+{
+    sta_rec_t *sta = &stations[s];
+    ap_rec_t *ap = &aps[a];
+    sta->ap = a;
+    sta->prev = ap->tail;
+    sta->next = STATION_NONE;
+    if (ap->tail != STATION_NONE) stations[ap->tail].next = s; else ap->head = s;
+    ap->tail = s;
+    ap->clients++;
+}
+
+static void drop_station(uint16_t s)
+{
+    unlink_station(s);
+    stations[s].live = false;
+    live_stations--;
+}
+
+/**
+ * @brief Drop an AP; its remaining clients keep their records, unlinked
+ */
+static void drop_ap(uint16_t a)
+{
+    ap_rec_t *ap = &aps[a];
+    while (ap->head != STATION_NONE) unlink_station(ap->head);
+    ssid_pool_release(ap->ssid);
+    ap->live = false;
+}
+
+/**
+ * @brief Age out stations and APs not listed for STATION_STORE_MAX_AGE_S (store_mutex held)
+ */
+static void sweep(int64_t now_us)
+{
+    if (now_us - last_sweep_us < SWEEP_US) return;
+    last_sweep_us = now_us;
+
+    int dropped = 0;
+    for (int s = 0; s < station_index.count; s++) {
+        if (stations[s].live && now_us - stations[s].last_us > MAX_AGE_US) {
+            drop_station((uint16_t)s);
+            dropped++;
+        }
+    }
+    for (int a = 0; a < ap_index.count; a++) {
+        if (aps[a].live && now_us - aps[a].last_us > MAX_AGE_US) {
+            drop_ap((uint16_t)a);
+            dropped++;
+        }
+    }
+    if (dropped) {
+        generation++;
+        ESP_LOGD(TAG, "Aged out %d stations and APs", dropped);
+    }
+}
+
+void station_store_clear(void)
+{
+    if (!stations) return;
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    for (int a = 0; a < ap_index.count; a++) {
+        if (aps[a].live) ssid_pool_release(aps[a].ssid);
+        aps[a].live = false;
+    }
+    for (int s = 0; s < station_index.count; s++) stations[s].live = false;
+    mac_set_clear(&station_index);
+    mac_set_clear(&ap_index);
+    live_stations = 0;
+    generation++;
+    xSemaphoreGive(store_mutex);
+}
+
+uint32_t station_store_generation(void)
+{
+    return generation;
+}
+
+static uint64_t ap_key(const char *ssid, int channel)
+{
+    // SSIDs repeat across channels, so the key covers both
+    char key_text[MAX_SSID_LEN + 8];
+    snprintf(key_text, sizeof(key_text), "%s, CH%d", ssid, channel);
+    return mac_set_key_from_string(key_text);
+}
+
+int station_store_add_ap(const char *ssid, int channel, int listed)
+{
+    if (!stations || !ssid) return -1;
+
+    uint64_t key = ap_key(ssid, channel);
+    int64_t now = uart_line_time_us();
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    sweep(now);
+
+    bool is_new;
+    int index = mac_set_add(&ap_index, key, &is_new);
+    if (index < 0) {
+        xSemaphoreGive(store_mutex);
+        return -1;
+    }
+    ap_rec_t *ap = &aps[index];
+    if (is_new || !ap->live) {
+        // Recycled: the least recently listed AP goes, its clients unlinked
+        if (ap->live) drop_ap((uint16_t)index);
+        int handle = ssid_pool_acquire(ssid);
+        memset(ap, 0, sizeof(*ap));
+        ap->ssid = handle >= 0 ? (ssid_handle_t)handle : SSID_NONE;
+        ap->channel = (uint8_t)channel;
+        ap->head = STATION_NONE;
+        ap->tail = STATION_NONE;
+        ap->live = true;
+    }
+    ap->listed = (uint16_t)(listed < UINT16_MAX ? listed : UINT16_MAX);
+    ap->last_us = now;
+    generation++;
+    xSemaphoreGive(store_mutex);
+    return index;
+}
+
+int station_store_add(uint64_t mac, int ap)
+{
+    if (!stations) return -1;
+
+    int64_t now = uart_line_time_us();
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    sweep(now);
+
+    bool is_new;
+    int index = mac_set_add(&station_index, mac, &is_new);
+    if (index < 0) {
+        xSemaphoreGive(store_mutex);
+        return -1;
+    }
+    sta_rec_t *sta = &stations[index];
+    if (is_new || !sta->live) {
+        if (sta->live) drop_station((uint16_t)index);     // Least recently listed, recycled
+        memset(sta, 0, sizeof(*sta));
+        sta->ap = STATION_NONE;
+        sta->first_us = now;
+        sta->live = true;
+        live_stations++;
+    }
+    sta->last_us = now;
+
+    // Listed under another AP: it moved (or the old AP slot was recycled)
+    if (ap >= 0 && ap < ap_index.count && aps[ap].live && sta->ap != ap) {
+        unlink_station((uint16_t)index);
+        link_station((uint16_t)index, (uint16_t)ap);
+    }
+    generation++;
+    xSemaphoreGive(store_mutex);
+    return index;
+}
+
+void station_store_expire(void)
+{
+    if (!stations) return;
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    sweep(uart_line_time_us());
+    xSemaphoreGive(store_mutex);
+}
+
+int station_store_slots(void)
+{
+    return stations ? station_index.count : 0;
+}
+
+int station_store_count(void)
+{
+    return stations ? live_stations : 0;
+}
+
+bool station_store_get(int index, station_record_t *out)
+{
+    if (!stations || !out || index < 0 || index >= station_index.count) return false;
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    const sta_rec_t *sta = &stations[index];
+    bool live = sta->live;
+    if (live) {
+        uint64_t key = station_index.keys[index];
+        for (int i = 0; i < 6; i++) out->mac[i] = (uint8_t)(key >> (40 - 8 * i));
+        out->ap = sta->ap;
+        out->first_us = sta->first_us;
+        out->last_us = sta->last_us;
+    }
+    xSemaphoreGive(store_mutex);
+    return live;
+}
+
+int station_store_find(uint64_t mac)
+{
+    if (!stations) return -1;
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    int index = mac_set_peek(&station_index, mac);
+    if (index >= 0 && !stations[index].live) index = -1;
+    xSemaphoreGive(store_mutex);
+    return index;
+}
+
+int station_store_ap_of(uint64_t mac)
+{
+    if (!stations) return -1;
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    int index = mac_set_peek(&station_index, mac);
+    int ap = (index >= 0 && stations[index].live && stations[index].ap != STATION_NONE) ?
+             stations[index].ap : -1;
+    xSemaphoreGive(store_mutex);
+    return ap;
+}
+
+int station_store_ap_slots(void)
+{
+    return stations ? ap_index.count : 0;
+}
+
+bool station_store_ap_get(int ap, station_ap_t *out)
+{
+    if (!stations || !out || ap < 0 || ap >= ap_index.count) return false;
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    const ap_rec_t *rec = &aps[ap];
+    bool live = rec->live;
+    if (live) {
+        strlcpy(out->ssid, ssid_pool_str(rec->ssid), sizeof(out->ssid));
+        out->channel = rec->channel;
+        out->clients = rec->clients;
+        out->listed = rec->listed;
+        out->last_us = rec->last_us;
+    }
+    xSemaphoreGive(store_mutex);
+    return live;
+}
+
+int station_store_find_ap(const char *ssid, int channel)
+{
+    if (!stations || !ssid) return -1;
+
+    uint64_t key = ap_key(ssid, channel);
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    int index = mac_set_peek(&ap_index, key);
+    if (index >= 0 && !aps[index].live) index = -1;
+    xSemaphoreGive(store_mutex);
+    return index;
+}
+
+int station_store_clients_of(int ap, uint16_t *out, int max)
+{
+    if (!stations || !out || ap < 0 || ap >= ap_index.count) return 0;
+
+    int n = 0;
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    if (aps[ap].live) {
+        for (uint16_t s = aps[ap].head; s != STATION_NONE && n < max; s = stations[s].next) {
+            out[n++] = s;
+        }
+    }
+    xSemaphoreGive(store_mutex);
+    return n;
+}
+
+int station_store_network(int ap)
+{
+    station_ap_t rec;
+    if (!station_store_ap_get(ap, &rec)) return -1;
+    return network_store_find_ssid(rec.ssid, rec.channel);
+}
@@ -0,0 +1,170 @@
+/**
+ * @file station_store.h
+ * @brief Sniffed stations and the APs they talk to, kept across views
+ *
+ * show_sniffer_results lists each AP ("SSID, CHn: clients") followed by
+ * its clients, one indented MAC per line. world_model files every listing
+ * here as it arrives, whichever screen asked for it, so the sniffer
+ * results view, an AP's detail page and station deauth targeting read one
+ * model instead of parsing the listing again.
+ *
+ * Stations are hash-indexed by packed MAC and APs by "SSID, CHn" (the
+ * sniffer gives no BSSID), both with mac_set. Each station links into a
+ * list of its AP's clients, so "AP of a client" and "client count of an
+ * AP" are one lookup, and listing an AP's clients walks only them. A
+ * station listed under another AP moves to that AP's list.
+ *
+ * Stations not listed for STATION_STORE_MAX_AGE_S leave their AP's list,
+ * and APs not listed for that long are dropped; a sweep at most every
+ * STATION_STORE_SWEEP_MS does it, on the next add or
+ * station_store_expire() call. When full, the least recently listed
+ * station (or AP) is replaced. Indices stay valid until then, so views
+ * keep indices rather than copies.
+ *
+ * Allocated by the first view that needs it; listings arriving before
+ * that are not kept. Added to by the UART RX tasks; any task may read.
+ */
+
+#ifndef STATION_STORE_H
+#define STATION_STORE_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "uart_handler.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef CONFIG_SNIFFER_MAX_CLIENTS
+#define STATION_STORE_MAX           CONFIG_SNIFFER_MAX_CLIENTS
+#else
+#define STATION_STORE_MAX           1024
+#endif
+#ifdef CONFIG_SNIFFER_MAX_APS
+#define STATION_STORE_APS           CONFIG_SNIFFER_MAX_APS
+#else
+#define STATION_STORE_APS           128
+#endif
+#ifdef CONFIG_STATION_MAX_AGE_S
+#define STATION_STORE_MAX_AGE_S     CONFIG_STATION_MAX_AGE_S
+#else
+#define STATION_STORE_MAX_AGE_S     300
+#endif
+
+#define STATION_STORE_SWEEP_MS      5000
+#define STATION_NONE                0xFFFF
+
+// One station
+typedef struct {
+    uint8_t mac[6];
+    uint16_t ap;                    // AP index, STATION_NONE if its AP was dropped
+    int64_t first_us;               // First listed (time_sync timebase)
+    int64_t last_us;                // Last listed
+} station_record_t;
+
+// One AP of the sniffer listing
+typedef struct {
+    char ssid[MAX_SSID_LEN];
+    uint8_t channel;
+    uint16_t clients;               // Stations linked to it
+    uint16_t listed;                // Client count JanOS gave in its last listing
+    int64_t last_us;                // Last listed
+} station_ap_t;
+
+/**
+ * @brief Allocate the store (safe to call again; keeps existing records)
+ * @return ESP_OK, ESP_ERR_NO_MEM
+ */
+esp_err_t station_store_init(void);
+
+/**
+ * @brief Forget every station and AP
+ */
+void station_store_clear(void);
+
+/**
+ * @brief Counter bumped on every change
+ */
+uint32_t station_store_generation(void);
+
+/**
+ * @brief File a listed AP (RX task)
+ * @param ssid SSID as listed
+ * @param channel Channel
+ * @param listed Client count in the listing row
+ * @return AP index, -1 if the store is not allocated
+ */
+int station_store_add_ap(const char *ssid, int channel, int listed);
+
+/**
+ * @brief File a station listed under an AP (RX task)
+ * @param mac Packed MAC (mac_set key)
+ * @param ap AP index from station_store_add_ap(), -1 if unknown (keeps
+ *           the AP the station had)
+ * @return Station index, -1 if the store is not allocated
+ */
+int station_store_add(uint64_t mac, int ap);
+
+/**
+ * @brief Age out what was not listed lately (cheap when nothing is due)
+ */
+void station_store_expire(void);
+
+/**
+ * @brief Station slots in use (indices 0 .. count - 1; aged-out ones read as absent)
+ */
+int station_store_slots(void);
+
+/**
+ * @brief Stations not aged out
+ */
+int station_store_count(void);
+
+/**
+ * @brief Copy a station
+ * @return false if the index is out of range or aged out
+ */
+bool station_store_get(int index, station_record_t *out);
+
+/**
+ * @brief Look a station up by MAC
+ * @return Station index, -1 if not kept
+ */
+int station_store_find(uint64_t mac);
+
+/**
+ * @brief AP a station was last listed under
+ * @return AP index, -1 if unknown
+ */
+int station_store_ap_of(uint64_t mac);
+
+/**
+ * @brief AP slots in use (indices 0 .. count - 1; dropped ones read as absent)
+ */
+int station_store_ap_slots(void);
+
+/**
+ * @brief Copy an AP
+ * @return false if the index is out of range or dropped
+ */
+bool station_store_ap_get(int ap, station_ap_t *out);
+
+/**
+ * @brief Look an AP up as the sniffer lists it
+ * @return AP index, -1 if not kept
+ */
+int station_store_find_ap(const char *ssid, int channel);
+
+/**
+ * @brief Stations linked to an AP, in the order first listed under it
+ * @param out Receives up to max station indices
+ * @return Indices written
+ */
+int station_store_clients_of(int ap, uint16_t *out, int max);
+
+/**
+ * @brief The network_store record of an AP (strongest BSSID of that SSID on the channel)
+ * @return Record index, -1 if the AP was not scanned
+ */
+int station_store_network(int ap);
+
+#endif // STATION_STORE_H
@@ -0,0 +1,595 @@
+/**
+ * @file store_snapshot.c
+ * @brief The shared stores saved to SD and reloaded at boot
+ */
+
+#include "store_snapshot.h"
+#include "network_store.h"
+#include "bt_store.h"
+#include "probe_store.h"
+#include "cred_store.h"
+#include "capture_index.h"
+#include "ssid_pool.h"
+#include "screenshot.h"
+#include "task_plan.h"
+#include "mem_monitor.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static const char *TAG = "SNAPSHOT";
+
+#ifdef CONFIG_SPIRAM
+#define IMAGE_CAPS      (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define IMAGE_CAPS      (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+#define HEADER_LEN      16
+#define SECTION_LEN     8
+#define NETWORK_LEN     21      // Before the SSID
+#define BT_LEN          10      // Before the name
+#define CAPTURE_LEN     16      // Before the name
+#define IMAGE_INITIAL   8192
+#define TMP_FILE        STORE_SNAPSHOT_FILE ".tmp"
+
+// File image being built in RAM
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+    size_t section;             // Offset of the open section's header
+    uint16_t entries;           // In the open section
+    uint16_t sections;
+    bool failed;                // Out of memory or over STORE_SNAPSHOT_MAX_BYTES
+} image_t;
+
+// Read position in a loaded section
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+} cursor_t;
+
+static SemaphoreHandle_t save_mutex = NULL;
+static uint32_t saved_generation;
+
+// Save task only (store_snapshot_save() holds save_mutex)
+static uint16_t bt_order[BT_STORE_MAX];
+static uint64_t pair_keys[PROBE_STORE_PAIRS];
+MEM_BUDGET(store_snapshot, 1, sizeof(bt_order) + sizeof(pair_keys), MEM_BUDGET_STATIC);
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xFF;
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief Sum of the stores' change counters; moves whenever one changes
+ */
+static uint32_t generations(void)
+{
+    return network_store_generation() + bt_store_generation() +
+           probe_store_generation() + cred_store_generation() + capture_index_generation();
+}
+
+/**
+ * @brief Append len bytes to the image
+ * @return Where to write them, NULL once the image has failed
+ */
+static uint8_t *reserve(image_t *img, size_t len)
+{
+    if (img->failed) return NULL;
+
+    if (img->len + len > img->cap) {
+        size_t cap = img->cap ? img->cap : IMAGE_INITIAL;
+        while (cap < img->len + len) cap *= 2;
+        if (cap > STORE_SNAPSHOT_MAX_BYTES) cap = STORE_SNAPSHOT_MAX_BYTES;
+
+        uint8_t *grown = NULL;
+        if (img->len + len <= cap) {
+            grown = heap_caps_realloc(img->data, cap, IMAGE_CAPS);
+            if (!grown) grown = realloc(img->data, cap);
+        }
+        if (!grown) {
+            img->failed = true;
+            return NULL;
+        }
+        img->data = grown;
+        img->cap = cap;
+    }
+
+    uint8_t *p = img->data + img->len;
+    img->len += len;
+    return p;
+}
+
+/**
+ * @brief Append u8 length and text, cut to max bytes
+ */
+static void put_text(image_t *img, const char *text, size_t max)
+{
+    size_t len = strnlen(text, max);
+    uint8_t *p = reserve(img, 1 + len);
+    if (!p) return;
+    p[0] = (uint8_t)len;
+    memcpy(p + 1, text, len);
+}
+
+static void begin_section(image_t *img, store_snapshot_section_t id)
+{
+    img->section = img->len;
+    img->entries = 0;
+    uint8_t *p = reserve(img, SECTION_LEN);
+    if (!p) return;
+    memset(p, 0, SECTION_LEN);
+    p[0] = (uint8_t)id;
+}
+
+static void end_section(image_t *img)
+{
+    if (img->failed) return;
+    uint8_t *p = img->data + img->section;
+    put_u16(p + 2, img->entries);
+    put_u32(p + 4, (uint32_t)(img->len - img->section - SECTION_LEN));
+    img->sections++;
+}
+
+static void save_networks(image_t *img)
+{
+    int count = network_store_count();
+    if (count == 0) return;
+
+    begin_section(img, SNAPSHOT_NETWORKS);
+    for (int i = 0; i < count; i++) {
+        const network_record_t *rec = network_store_record(i);
+        if (!rec) break;
+        network_sighting_t where = {0};
+        network_store_sighting(i, &where);
+
+        uint8_t *p = reserve(img, NETWORK_LEN);
+        if (!p) return;
+        memcpy(p, rec->bssid, 6);
+        p[6] = (uint8_t)rec->rssi;
+        p[7] = rec->channel;
+        p[8] = rec->security;
+        p[9] = rec->band;
+        put_u16(p + 10, where.fixes);
+        put_u32(p + 12, (uint32_t)where.lat_e7);
+        put_u32(p + 16, (uint32_t)where.lon_e7);
+        p[20] = (uint8_t)where.rssi;
+        put_text(img, network_store_ssid(rec), MAX_SSID_LEN - 1);
+        img->entries++;
+    }
+    end_section(img);
+}
+
+static void save_bt(image_t *img)
+{
+    int count = bt_store_view(bt_order, BT_STORE_MAX, BT_SORT_LAST_SEEN, 0);
+    if (count == 0) return;
+
+    begin_section(img, SNAPSHOT_BT);
+    // Least recently seen first, the order a full store evicts in
+    for (int i = count - 1; i >= 0; i--) {
+        bt_record_t rec;
+        if (!bt_store_get(bt_order[i], &rec)) continue;
+
+        uint8_t *p = reserve(img, BT_LEN);
+        if (!p) return;
+        memcpy(p, rec.mac, 6);
+        p[6] = (uint8_t)rec.rssi;
+        p[7] = rec.flags;
+        put_u16(p + 8, rec.sightings);
+        put_text(img, rec.name, BT_STORE_NAME_LEN - 1);
+        img->entries++;
+    }
+    end_section(img);
+}
+
+static void save_probes(image_t *img)
+{
+    int count = probe_store_count();
+    if (count > 0) {
+        begin_section(img, SNAPSHOT_PROBES);
+        for (int i = 0; i < count; i++) {
+            probe_record_t rec;
+            if (!probe_store_get(i, &rec)) continue;
+
+            uint8_t *p = reserve(img, 2);
+            if (!p) return;
+            put_u16(p, rec.clients);
+            put_text(img, ssid_pool_str(rec.ssid), PROBE_SSID_LEN - 1);
+            img->entries++;
+        }
+        end_section(img);
+    }
+
+    int pairs = probe_store_pair_keys(pair_keys, PROBE_STORE_PAIRS);
+    if (pairs > 0) {
+        begin_section(img, SNAPSHOT_PAIRS);
+        uint8_t *p = reserve(img, (size_t)pairs * 8);
+        if (!p) return;
+        for (int i = 0; i < pairs; i++) {
+            put_u32(p + 8 * i, (uint32_t)pair_keys[i]);
+            put_u32(p + 8 * i + 4, (uint32_t)(pair_keys[i] >> 32));
+        }
+        img->entries = (uint16_t)pairs;
+        end_section(img);
+    }
+}
+
+static void save_creds(image_t *img)
+{
+    if (cred_store_count(CRED_PORTAL) + cred_store_count(CRED_EVIL) == 0) return;
+
+    static cred_entry_t entry;      // Save task only
+    begin_section(img, SNAPSHOT_CREDS);
+    for (int kind = 0; kind < CRED_KIND_COUNT; kind++) {
+        int count = cred_store_count(kind);
+        for (int i = 0; i < count; i++) {
+            if (!cred_store_get(kind, i, &entry)) break;
+
+            uint8_t *p = reserve(img, 1);
+            if (!p) return;
+            p[0] = (uint8_t)kind;
+            put_text(img, entry.ssid, CRED_SSID_LEN - 1);
+            size_t len = strnlen(entry.data, CRED_DATA_LEN - 1);
+            p = reserve(img, 2 + len);
+            if (!p) return;
+            put_u16(p, (uint16_t)len);
+            memcpy(p + 2, entry.data, len);
+            img->entries++;
+        }
+    }
+    end_section(img);
+}
+
+static void save_captures(image_t *img)
+{
+    int count = capture_index_count();
+    if (count == 0) return;
+
+    static capture_record_t rec;    // Save task only
+    begin_section(img, SNAPSHOT_CAPTURES);
+    for (int i = 0; i < count; i++) {
+        if (!capture_index_get(i, &rec)) break;
+
+        uint8_t *p = reserve(img, CAPTURE_LEN);
+        if (!p) return;
+        p[0] = rec.eapol;
+        p[1] = rec.flags;
+        memcpy(p + 2, rec.bssid, 6);
+        put_u32(p + 8, rec.bytes);
+        put_u32(p + 12, rec.mtime);
+        put_text(img, rec.name, sizeof(rec.name) - 1);
+        put_text(img, rec.ssid, sizeof(rec.ssid) - 1);
+        img->entries++;
+    }
+    end_section(img);
+}
+
+/**
+ * @brief Write the image to the temporary file, then move it over the snapshot
+ */
+static esp_err_t write_image(const image_t *img)
+{
+    struct stat st;
+    if (stat(STORE_SNAPSHOT_DIR, &st) != 0) {
+        mkdir(STORE_SNAPSHOT_DIR, 0755);
+    }
+
+    FILE *f = fopen(TMP_FILE, "wb");
+    if (!f) return ESP_FAIL;
+    bool ok = fwrite(img->data, 1, img->len, f) == img->len;
+    if (fclose(f) != 0) ok = false;
+    if (!ok) {
+        remove(TMP_FILE);
+        return ESP_FAIL;
+    }
+
+    // FAT cannot rename over a file; a reset in between leaves the
+    // complete .tmp, which the loader falls back to
+    remove(STORE_SNAPSHOT_FILE);
+    return rename(TMP_FILE, STORE_SNAPSHOT_FILE) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t store_snapshot_save(void)
+{
+    if (!save_mutex || !screenshot_is_available()) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(save_mutex, portMAX_DELAY);
+    int64_t start_us = esp_timer_get_time();
+    uint32_t generation = generations();
+
+    image_t img = {0};
+    reserve(&img, HEADER_LEN);
+    save_networks(&img);
+    save_bt(&img);
+    save_probes(&img);
+    save_creds(&img);
+    save_captures(&img);
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    if (!img.failed) {
+        uint32_t body = (uint32_t)(img.len - HEADER_LEN);
+        memcpy(img.data, "WSNP", 4);
+        put_u16(img.data + 4, STORE_SNAPSHOT_VERSION);
+        put_u16(img.data + 6, img.sections);
+        put_u32(img.data + 8, body);
+        put_u32(img.data + 12, esp_rom_crc32_le(0, img.data + HEADER_LEN, body));
+        ret = write_image(&img);
+    }
+
+    if (ret == ESP_OK) {
+        saved_generation = generation;
+        ESP_LOGD(TAG, "Saved %u bytes in %lu ms", (unsigned)img.len,
+                 (unsigned long)((esp_timer_get_time() - start_us) / 1000));
+    } else {
+        ESP_LOGW(TAG, "Snapshot not saved: %s", esp_err_to_name(ret));
+    }
+    free(img.data);
+    xSemaphoreGive(save_mutex);
+    return ret;
+}
+
+/**
+ * @brief Take n bytes from a section
+ * @return The bytes, NULL if the section is shorter
+ */
+static const uint8_t *take(cursor_t *c, size_t n)
+{
+    if ((size_t)(c->end - c->p) < n) return NULL;
+    const uint8_t *p = c->p;
+    c->p += n;
+    return p;
+}
+
+/**
+ * @brief Take u8 length and text, cut to fit out
+ */
+static bool take_text(cursor_t *c, char *out, size_t size)
+{
+    const uint8_t *len = take(c, 1);
+    const uint8_t *text = len ? take(c, *len) : NULL;
+    if (!text) return false;
+
+    size_t n = *len < size - 1 ? *len : size - 1;
+    memcpy(out, text, n);
+    out[n] = '\0';
+    return true;
+}
+
+static int load_networks(cursor_t *c, int count)
+{
+    int restored = 0;
+    for (int i = 0; i < count; i++) {
+        char ssid[MAX_SSID_LEN];
+        const uint8_t *e = take(c, NETWORK_LEN);
+        if (!e || !take_text(c, ssid, sizeof(ssid))) break;
+
+        network_record_t rec = {
+            .rssi = (int8_t)e[6],
+            .channel = e[7],
+            .security = e[8] < WIFI_SECURITY_COUNT ? e[8] : WIFI_SECURITY_UNKNOWN,
+            .band = e[9] < WIFI_BAND_COUNT ? e[9] : WIFI_BAND_UNKNOWN,
+        };
+        memcpy(rec.bssid, e, 6);
+        network_sighting_t where = {
+            .fixes = get_u16(e + 10),
+            .lat_e7 = (int32_t)get_u32(e + 12),
+            .lon_e7 = (int32_t)get_u32(e + 16),
+            .rssi = (int8_t)e[20],
+        };
+        if (network_store_restore(&rec, ssid, &where) >= 0) restored++;
+    }
+    return restored;
+}
+
+static int load_bt(cursor_t *c, int count)
+{
+    if (bt_store_init() != ESP_OK) return 0;
+
+    int restored = 0;
+    for (int i = 0; i < count; i++) {
+        bt_record_t rec = {0};
+        const uint8_t *e = take(c, BT_LEN);
+        if (!e || !take_text(c, rec.name, sizeof(rec.name))) break;
+
+        memcpy(rec.mac, e, 6);
+        rec.rssi = (int8_t)e[6];
+        rec.flags = e[7];
+        rec.sightings = get_u16(e + 8);
+        if (bt_store_restore(&rec) >= 0) restored++;
+    }
+    return restored;
+}
+
+static int load_probes(cursor_t *c, int count)
+{
+    if (probe_store_init() != ESP_OK) return 0;
+
+    int restored = 0;
+    for (int i = 0; i < count; i++) {
+        char ssid[PROBE_SSID_LEN];
+        const uint8_t *e = take(c, 2);
+        if (!e || !take_text(c, ssid, sizeof(ssid))) break;
+        if (probe_store_restore(ssid, get_u16(e)) >= 0) restored++;
+    }
+    return restored;
+}
+
+static void load_pairs(cursor_t *c, int count)
+{
+    if (probe_store_init() != ESP_OK) return;
+
+    for (int i = 0; i < count; i++) {
+        const uint8_t *e = take(c, 8);
+        if (!e) break;
+        probe_store_restore_pair(get_u32(e) | ((uint64_t)get_u32(e + 4) << 32));
+    }
+}
+
+static int load_creds(cursor_t *c, int count)
+{
+    char ssid[CRED_SSID_LEN];
+    char data[CRED_DATA_LEN];
+    int restored = 0;
+
+    for (int i = 0; i < count; i++) {
+        const uint8_t *kind = take(c, 1);
+        if (!kind || !take_text(c, ssid, sizeof(ssid))) break;
+        const uint8_t *len = take(c, 2);
+        const uint8_t *text = len ? take(c, get_u16(len)) : NULL;
+        if (!text) break;
+
+        size_t n = get_u16(len) < sizeof(data) - 1 ? get_u16(len) : sizeof(data) - 1;
+        memcpy(data, text, n);
+        data[n] = '\0';
+        if (*kind < CRED_KIND_COUNT && cred_store_add((cred_kind_t)*kind, ssid, data, false)) {
+            restored++;
+        }
+    }
+    return restored;
+}
+
+static int load_captures(cursor_t *c, int count)
+{
+    if (capture_index_init() != ESP_OK) return 0;
+
+    int restored = 0;
+    for (int i = 0; i < count; i++) {
+        capture_record_t rec = {0};
+        const uint8_t *e = take(c, CAPTURE_LEN);
+        if (!e || !take_text(c, rec.name, sizeof(rec.name)) ||
+            !take_text(c, rec.ssid, sizeof(rec.ssid))) {
+            break;
+        }
+
+        rec.eapol = e[0];
+        rec.flags = e[1];
+        memcpy(rec.bssid, e + 2, 6);
+        rec.bytes = get_u32(e + 8);
+        rec.mtime = get_u32(e + 12);
+        if (capture_index_restore(&rec) >= 0) restored++;
+    }
+    return restored;
+}
+
+/**
+ * @brief Read, check and restore one snapshot file
+ * @return false if it is missing or not a valid snapshot
+ */
+static bool load_file(const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) return false;
+    if (st.st_size < HEADER_LEN || st.st_size > STORE_SNAPSHOT_MAX_BYTES) {
+        ESP_LOGW(TAG, "%s: size %ld, ignored", path, (long)st.st_size);
+        return false;
+    }
+
+    size_t size = (size_t)st.st_size;
+    uint8_t *data = heap_caps_malloc(size, IMAGE_CAPS);
+    if (!data) data = malloc(size);
+    if (!data) return false;
+
+    FILE *f = fopen(path, "rb");
+    bool ok = f && fread(data, 1, size, f) == size;
+    if (f) fclose(f);
+
+    // The whole file is checked before any store is touched
+    ok = ok && memcmp(data, "WSNP", 4) == 0 && get_u16(data + 4) == STORE_SNAPSHOT_VERSION &&
+         get_u32(data + 8) == size - HEADER_LEN &&
+         get_u32(data + 12) == esp_rom_crc32_le(0, data + HEADER_LEN, size - HEADER_LEN);
+    if (!ok) {
+        ESP_LOGW(TAG, "%s is not a valid snapshot, ignored", path);
+        free(data);
+        return false;
+    }
+
+    int networks = 0, devices = 0, probes = 0, creds = 0, captures = 0;
+    cursor_t file = { data + HEADER_LEN, data + size };
+    for (int s = get_u16(data + 6); s > 0; s--) {
+        const uint8_t *h = take(&file, SECTION_LEN);
+        const uint8_t *body = h ? take(&file, get_u32(h + 4)) : NULL;
+        if (!body) break;
+
+        cursor_t c = { body, body + get_u32(h + 4) };
+        int count = get_u16(h + 2);
+        switch (h[0]) {
+            case SNAPSHOT_NETWORKS: networks = load_networks(&c, count); break;
+            case SNAPSHOT_BT:       devices = load_bt(&c, count); break;
+            case SNAPSHOT_PROBES:   probes = load_probes(&c, count); break;
+            case SNAPSHOT_PAIRS:    load_pairs(&c, count); break;
+            case SNAPSHOT_CREDS:    creds = load_creds(&c, count); break;
+            case SNAPSHOT_CAPTURES: captures = load_captures(&c, count); break;
+            default:                break;      // Newer section, skipped
+        }
+    }
+    free(data);
+
+    ESP_LOGI(TAG, "Restored %d networks, %d BT devices, %d probed SSIDs, %d credentials, "
+             "%d captures", networks, devices, probes, creds, captures);
+    return true;
+}
+
+static void save_task(void *arg)
+{
+    (void)arg;
+
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(STORE_SNAPSHOT_INTERVAL_S * 1000));
+        if (generations() != saved_generation && screenshot_is_available()) {
+            store_snapshot_save();
+        }
+    }
+}
+
+esp_err_t store_snapshot_init(void)
+{
+    if (save_mutex) return ESP_OK;
+
+    save_mutex = xSemaphoreCreateMutex();
+    if (!save_mutex) return ESP_ERR_NO_MEM;
+
+    int64_t start_us = esp_timer_get_time();
+    if (load_file(STORE_SNAPSHOT_FILE) || load_file(TMP_FILE)) {
+        ESP_LOGI(TAG, "Snapshot loaded in %lu ms",
+                 (unsigned long)((esp_timer_get_time() - start_us) / 1000));
+    }
+    // What was just loaded is on the card already
+    saved_generation = generations();
+
+    TaskHandle_t handle = NULL;
+    if (xTaskCreatePinnedToCore(save_task, "snapshot", TASK_SNAPSHOT_STACK, NULL,
+                                TASK_LOG_WRITER_PRIO, &handle, TASK_LOG_WRITER_CORE) != pdPASS) {
+        return ESP_FAIL;
+    }
+    task_plan_track(TASK_ID_SNAPSHOT, handle);
+    mem_monitor_account(MEM_SUB_LOGGER, TASK_SNAPSHOT_STACK);
+    return ESP_OK;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file store_snapshot.h
+ * @brief The shared stores saved to SD and reloaded at boot
+ *
+ * After a reboot or battery swap the networks, BT devices, probed SSIDs
+ * (with the stations counted toward them), credentials and what each
+ * handshake capture holds come back from
+ * the card instead of having to be scanned again over UART. A low-priority
+ * task writes them every STORE_SNAPSHOT_INTERVAL_S while any store's
+ * generation moved, to STORE_SNAPSHOT_FILE.tmp first and then renamed over
+ * the last snapshot, so a reset mid-write keeps the previous one.
+ *
+ * File STORE_SNAPSHOT_FILE (little-endian):
+ *
+ *   header   "WSNP", u16 version, u16 sections, u32 body bytes,
+ *            u32 esp_rom_crc32_le(0, body)
+ *   section  u8 id, u8 0, u16 entries, u32 bytes, then the entries:
+ *     NETWORKS  6 bytes BSSID, i8 rssi, u8 channel, u8 security, u8 band,
+ *               u16 fixes, i32 lat_e7, i32 lon_e7, i8 fix rssi,
+ *               u8 ssid length, SSID
+ *     BT        6 bytes MAC, i8 rssi, u8 flags, u16 sightings,
+ *               u8 name length, name (least recently seen first)
+ *     PROBES    u16 clients, u8 ssid length, SSID
+ *     PAIRS     u64 (SSID, station) hash (probe_store)
+ *     CREDS     u8 kind, u8 ssid length, SSID, u16 data length, data
+ *     CAPTURES  u8 eapol, u8 flags, 6 bytes BSSID, u32 bytes, u32 mtime,
+ *               u8 name length, name, u8 ssid length, SSID
+ *
+ * Readers skip sections they do not know. The whole file is read in one
+ * go and checked before anything is restored; a bad file is ignored.
+ * Restored networks are flagged RESTORED and are not attacked until a
+ * board lists them again (their JanOS ids are stale); restored BT devices
+ * and probes count as seen before this boot.
+ */
+
+#ifndef STORE_SNAPSHOT_H
+#define STORE_SNAPSHOT_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdint.h>
+
+#define STORE_SNAPSHOT_DIR          "/sdcard/state"
+#define STORE_SNAPSHOT_FILE         STORE_SNAPSHOT_DIR "/world.snap"
+#define STORE_SNAPSHOT_VERSION      1
+#define STORE_SNAPSHOT_MAX_BYTES    (256 * 1024)    // Larger files are not loaded
+
+#ifdef CONFIG_STORE_SNAPSHOT_INTERVAL_S
+#define STORE_SNAPSHOT_INTERVAL_S   CONFIG_STORE_SNAPSHOT_INTERVAL_S
+#else
+#define STORE_SNAPSHOT_INTERVAL_S   60
+#endif
+
+// Section ids
+typedef enum {
+    SNAPSHOT_NETWORKS = 1,
+    SNAPSHOT_BT,
+    SNAPSHOT_PROBES,
+    SNAPSHOT_PAIRS,
+    SNAPSHOT_CREDS,
+    SNAPSHOT_CAPTURES,
+} store_snapshot_section_t;
+
+/**
+ * @brief Load the last snapshot and start saving (call once the card is mounted)
+ * @return ESP_OK (also when there was nothing to load), ESP_FAIL if the
+ *         save task could not start
+ */
+esp_err_t store_snapshot_init(void);
+
+/**
+ * @brief Write a snapshot now, whatever changed
+ * @return ESP_OK, ESP_ERR_INVALID_STATE without a card, ESP_ERR_NO_MEM,
+ *         ESP_FAIL on a write error
+ */
+esp_err_t store_snapshot_save(void);
+
+#endif // STORE_SNAPSHOT_H
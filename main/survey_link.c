@@ -0,0 +1,367 @@
+/**
+ * @file survey_link.c
+ * @brief ESP-NOW link merging several Cardputers into one survey
+ */
+
+#include "survey_link.h"
+#include "network_store.h"
+#include "fixed_containers.h"
+#include "task_plan.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_event.h"
+#include "esp_wifi.h"
+#include "esp_now.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "SURVEY";
+
+static const uint8_t broadcast_mac[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+static survey_role_t role = SURVEY_ROLE_OFF;
+static survey_stats_t stats;
+
+// Satellite: which records went out, and for which pass
+static esp_timer_handle_t send_timer = NULL;
+static uint32_t sent_bits[FIXED_BITS_WORDS(NETWORK_STORE_MAX)];
+static uint8_t sent_pass[NETWORK_STORE_MAX];    // seen_pass of the copy sent
+static int send_cursor = 0;
+static int known_count = 0;
+static uint32_t known_passes = 0;
+static uint16_t send_seq = 0;
+
+// Coordinator: frames handed from the WiFi task to the merge task
+typedef struct {
+    uint8_t mac[6];
+    uint8_t len;
+    uint8_t data[SURVEY_FRAME_MAX];
+} rx_frame_t;
+
+static QueueHandle_t rx_queue = NULL;
+static survey_unit_t units[SURVEY_MAX_UNITS];
+static int unit_count = 0;
+static portMUX_TYPE units_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void put_i32(uint8_t *p, int32_t v)
+{
+    uint32_t u = (uint32_t)v;
+    p[0] = u; p[1] = u >> 8; p[2] = u >> 16; p[3] = u >> 24;
+}
+
+static int32_t get_i32(const uint8_t *p)
+{
+    return (int32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+/**
+ * @brief Pack one record at out
+ * @return Bytes written, 0 if it does not fit in room
+ */
+static size_t pack_record(int index, const network_record_t *rec, uint8_t *out, size_t room)
+{
+    const char *ssid = network_store_ssid(rec);
+    size_t ssid_len = strnlen(ssid, MAX_SSID_LEN - 1);
+    if (SURVEY_RECORD_FIXED + ssid_len > room) return 0;
+
+    network_sighting_t where;
+    bool fix = network_store_sighting(index, &where);
+    memcpy(out, rec->bssid, 6);
+    out[6] = rec->channel;
+    out[7] = (uint8_t)rec->rssi;
+    out[8] = rec->security;
+    out[9] = rec->band;
+    out[10] = fix ? SURVEY_RECORD_FIX : 0;
+    out[11] = fix ? (uint8_t)where.rssi : 0;
+    put_i32(&out[12], fix ? where.lat_e7 : 0);
+    put_i32(&out[16], fix ? where.lon_e7 : 0);
+    out[20] = (uint8_t)ssid_len;
+    memcpy(&out[SURVEY_RECORD_FIXED], ssid, ssid_len);
+    return SURVEY_RECORD_FIXED + ssid_len;
+}
+
+static bool needs_send(int index, const network_record_t *rec)
+{
+    // Not ours to repeat, or not heard since the reboot
+    if (rec->flags & (NETWORK_FLAG_REMOTE | NETWORK_FLAG_RESTORED)) return false;
+    return !fixed_bits_test(sent_bits, index) || sent_pass[index] != rec->seen_pass;
+}
+
+/**
+ * @brief Send records not sent yet, or seen again since (esp_timer task)
+ */
+static void send_tick(void *arg)
+{
+    (void)arg;
+
+    // A clear starts the store over, and the satellite with it
+    int count = network_store_count();
+    uint32_t passes = network_store_passes();
+    if (count < known_count || passes < known_passes) {
+        memset(sent_bits, 0, sizeof(sent_bits));
+        send_cursor = 0;
+    }
+    known_count = count;
+    known_passes = passes;
+    if (count == 0) return;
+
+    int scanned = 0;
+    for (int f = 0; f < SURVEY_FRAMES_PER_TICK && scanned < count; f++) {
+        uint8_t frame[SURVEY_FRAME_MAX];
+        uint16_t picked[(SURVEY_FRAME_MAX - SURVEY_FRAME_HEADER) / SURVEY_RECORD_FIXED];
+        uint8_t picked_pass[sizeof(picked) / sizeof(picked[0])];
+        size_t len = SURVEY_FRAME_HEADER;
+        int n = 0;
+        int cursor = send_cursor;
+
+        for (; scanned < count && n < (int)(sizeof(picked) / sizeof(picked[0])); scanned++) {
+            int index = cursor % count;
+            const network_record_t *rec = network_store_record(index);
+            if (rec && needs_send(index, rec)) {
+                size_t used = pack_record(index, rec, frame + len, sizeof(frame) - len);
+                if (used == 0) break;       // Frame full: next frame starts here
+                picked[n] = index;
+                picked_pass[n] = rec->seen_pass;
+                n++;
+                len += used;
+            }
+            cursor = index + 1;
+        }
+        if (n == 0) break;
+
+        frame[0] = SURVEY_MAGIC_0;
+        frame[1] = SURVEY_MAGIC_1;
+        frame[2] = SURVEY_VERSION;
+        frame[3] = n;
+        frame[4] = send_seq & 0xFF;
+        frame[5] = send_seq >> 8;
+        if (esp_now_send(broadcast_mac, frame, len) != ESP_OK) {
+            stats.send_errors++;    // Send queue full: the same records go next tick
+            break;
+        }
+        send_seq++;
+        send_cursor = cursor;
+        for (int i = 0; i < n; i++) {
+            fixed_bits_put(sent_bits, picked[i], true);
+            sent_pass[picked[i]] = picked_pass[i];
+        }
+        stats.frames_sent++;
+        stats.records_sent += n;
+    }
+}
+
+/**
+ * @brief Queue a frame for the merge task (WiFi task: no store work here)
+ */
+static void recv_cb(const esp_now_recv_info_t *info, const uint8_t *data, int len)
+{
+    if (len < SURVEY_FRAME_HEADER || len > SURVEY_FRAME_MAX ||
+        data[0] != SURVEY_MAGIC_0 || data[1] != SURVEY_MAGIC_1 || data[2] != SURVEY_VERSION) {
+        stats.frames_dropped++;
+        return;
+    }
+
+    rx_frame_t frame;
+    memcpy(frame.mac, info->src_addr, 6);
+    frame.len = (uint8_t)len;
+    memcpy(frame.data, data, len);
+    if (xQueueSend(rx_queue, &frame, 0) != pdTRUE) {
+        stats.frames_dropped++;
+        return;
+    }
+    stats.frames_received++;
+}
+
+/**
+ * @brief Count a frame against its sender (units_lock held)
+ */
+static void note_unit(const rx_frame_t *frame, uint16_t seq, int records)
+{
+    survey_unit_t *unit = NULL;
+    for (int i = 0; i < unit_count; i++) {
+        if (memcmp(units[i].mac, frame->mac, 6) == 0) {
+            unit = &units[i];
+            break;
+        }
+    }
+    if (!unit) {
+        if (unit_count >= SURVEY_MAX_UNITS) return;     // Still merged, not listed
+        unit = &units[unit_count++];
+        memset(unit, 0, sizeof(*unit));
+        memcpy(unit->mac, frame->mac, 6);
+    } else {
+        uint16_t gap = seq - unit->last_seq - 1;
+        if (gap < 0x8000) unit->lost += gap;            // Older or repeated: no loss
+    }
+    unit->frames++;
+    unit->records += records;
+    unit->last_seq = seq;
+    unit->last_ms = (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void merge_frame(const rx_frame_t *frame)
+{
+    const uint8_t *p = frame->data + SURVEY_FRAME_HEADER;
+    const uint8_t *end = frame->data + frame->len;
+    int count = frame->data[3];
+    uint16_t seq = frame->data[4] | (frame->data[5] << 8);
+
+    int merged = 0;
+    for (int i = 0; i < count; i++) {
+        if (end - p < SURVEY_RECORD_FIXED || end - p < SURVEY_RECORD_FIXED + p[20] ||
+            p[20] >= MAX_SSID_LEN) {
+            stats.frames_dropped++;     // Truncated: keep what parsed
+            break;
+        }
+
+        wifi_network_t net = {0};
+        memcpy(net.ssid, &p[SURVEY_RECORD_FIXED], p[20]);
+        network_format_bssid(p, net.bssid, sizeof(net.bssid));
+        net.channel = p[6];
+        net.rssi = (int8_t)p[7];
+        snprintf(net.security, sizeof(net.security), "%s",
+                 network_security_name(p[8] < WIFI_SECURITY_COUNT ? p[8] : WIFI_SECURITY_UNKNOWN));
+        snprintf(net.band, sizeof(net.band), "%s",
+                 network_band_name(p[9] < WIFI_BAND_COUNT ? p[9] : WIFI_BAND_UNKNOWN));
+
+        network_sighting_t where = {0};
+        if (p[10] & SURVEY_RECORD_FIX) {
+            where.rssi = (int8_t)p[11];
+            where.lat_e7 = get_i32(&p[12]);
+            where.lon_e7 = get_i32(&p[16]);
+            where.fixes = 1;
+        }
+        if (network_store_add_remote(&net, &where) >= 0) {
+            merged++;
+        } else {
+            stats.store_full++;
+        }
+        p += SURVEY_RECORD_FIXED + p[20];
+    }
+    stats.records_merged += merged;
+
+    portENTER_CRITICAL(&units_lock);
+    note_unit(frame, seq, merged);
+    portEXIT_CRITICAL(&units_lock);
+}
+
+static void survey_rx_task(void *arg)
+{
+    (void)arg;
+
+    rx_frame_t frame;
+    for (;;) {
+        if (xQueueReceive(rx_queue, &frame, portMAX_DELAY) == pdTRUE) {
+            merge_frame(&frame);
+        }
+    }
+}
+
+#ifdef CONFIG_SURVEY_LINK
+static esp_err_t start_wifi(void)
+{
+    // The default loop may already exist; WiFi only needs one to post to
+    esp_err_t ret = esp_event_loop_create_default();
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) return ret;
+
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ret = esp_wifi_init(&cfg);
+    if (ret == ESP_OK) ret = esp_wifi_set_storage(WIFI_STORAGE_RAM);
+    if (ret == ESP_OK) ret = esp_wifi_set_mode(WIFI_MODE_STA);
+    if (ret == ESP_OK) ret = esp_wifi_start();
+    if (ret == ESP_OK) ret = esp_wifi_set_channel(SURVEY_LINK_CHANNEL, WIFI_SECOND_CHAN_NONE);
+    if (ret == ESP_OK) ret = esp_now_init();
+    return ret;
+}
+
+static esp_err_t start_satellite(void)
+{
+    esp_now_peer_info_t peer = {
+        .channel = SURVEY_LINK_CHANNEL,
+        .ifidx = WIFI_IF_STA,
+        .encrypt = false,
+    };
+    memcpy(peer.peer_addr, broadcast_mac, 6);
+    esp_err_t ret = esp_now_add_peer(&peer);
+    if (ret != ESP_OK) return ret;
+
+    const esp_timer_create_args_t args = {
+        .callback = send_tick,
+        .name = "survey_tx",
+    };
+    ret = esp_timer_create(&args, &send_timer);
+    if (ret != ESP_OK) return ret;
+    return esp_timer_start_periodic(send_timer, SURVEY_LINK_SEND_MS * 1000ULL);
+}
+
+static esp_err_t start_coordinator(void)
+{
+    TaskHandle_t task = NULL;
+    rx_queue = xQueueCreate(SURVEY_RX_QUEUE, sizeof(rx_frame_t));
+    if (!rx_queue ||
+        xTaskCreatePinnedToCore(survey_rx_task, "survey_rx", TASK_SURVEY_RX_STACK, NULL,
+                                TASK_SURVEY_RX_PRIO, &task, TASK_SURVEY_RX_CORE) != pdPASS) {
+        if (rx_queue) vQueueDelete(rx_queue);
+        rx_queue = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    task_plan_track(TASK_ID_SURVEY_RX, task);
+    return esp_now_register_recv_cb(recv_cb);
+}
+#endif
+
+esp_err_t survey_link_init(void)
+{
+#ifdef CONFIG_SURVEY_LINK
+    if (role != SURVEY_ROLE_OFF) return ESP_OK;
+
+    esp_err_t ret = start_wifi();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "ESP-NOW start failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+#ifdef CONFIG_SURVEY_LINK_COORDINATOR
+    ret = start_coordinator();
+    if (ret == ESP_OK) role = SURVEY_ROLE_COORDINATOR;
+#else
+    ret = start_satellite();
+    if (ret == ESP_OK) role = SURVEY_ROLE_SATELLITE;
+#endif
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Survey link start failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ESP_LOGI(TAG, "Survey link up as %s on channel %d",
+             role == SURVEY_ROLE_COORDINATOR ? "coordinator" : "satellite", SURVEY_LINK_CHANNEL);
+    return ESP_OK;
+#else
+    (void)send_tick;
+    (void)recv_cb;
+    (void)survey_rx_task;
+    return ESP_OK;
+#endif
+}
+
+survey_role_t survey_link_role(void)
+{
+    return role;
+}
+
+void survey_link_get_stats(survey_stats_t *out)
+{
+    if (out) *out = stats;
+}
+
+int survey_link_units(survey_unit_t *out, int max)
+{
+    if (!out) return 0;
+
+    portENTER_CRITICAL(&units_lock);
+    int n = unit_count < max ? unit_count : max;
+    memcpy(out, units, n * sizeof(out[0]));
+    portEXIT_CRITICAL(&units_lock);
+    return n;
+}
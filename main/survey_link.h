@@ -0,0 +1,108 @@
+/**
+ * @file survey_link.h
+ * @brief ESP-NOW link merging several Cardputers into one survey
+ *
+ * Uses the Cardputer's own radio, which JanOS setups otherwise leave
+ * idle. A satellite broadcasts its network_store as packed records, each
+ * with the position it was heard loudest at (network_store_sighting),
+ * batched into ESP-NOW frames every SURVEY_LINK_SEND_MS. It walks the
+ * store round robin and sends records not sent yet or seen by a later
+ * pass, so a steady store costs no airtime. A coordinator merges every
+ * record it hears into its own network_store by BSSID
+ * (network_store_add_remote), so the list and channel views show the
+ * whole site. All units must share SURVEY_LINK_CHANNEL.
+ *
+ * Frame layout (little endian):
+ *   header   magic "SV", version, record count, u16 sequence
+ *   record   bssid[6], channel, rssi, security, band, flags,
+ *            fix rssi, i32 lat_e7, i32 lon_e7, ssid length, ssid bytes
+ * A record is SURVEY_RECORD_FIXED bytes plus its SSID (no terminator),
+ * so a frame holds about eight with typical names.
+ */
+
+#ifndef SURVEY_LINK_H
+#define SURVEY_LINK_H
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SURVEY_FRAME_MAX        250     // ESP-NOW payload limit
+#define SURVEY_FRAME_HEADER     6
+#define SURVEY_RECORD_FIXED     21      // Record bytes before the SSID
+#define SURVEY_MAGIC_0          'S'
+#define SURVEY_MAGIC_1          'V'
+#define SURVEY_VERSION          1
+
+#define SURVEY_RECORD_FIX       0x01    // lat/lon/fix rssi are set
+
+#define SURVEY_MAX_UNITS        8       // Satellites a coordinator tracks
+#define SURVEY_FRAMES_PER_TICK  4       // Satellite frames per send interval
+#define SURVEY_RX_QUEUE         16      // Frames waiting to be merged
+
+#ifdef CONFIG_SURVEY_LINK_CHANNEL
+#define SURVEY_LINK_CHANNEL     CONFIG_SURVEY_LINK_CHANNEL
+#else
+#define SURVEY_LINK_CHANNEL     1
+#endif
+
+#ifdef CONFIG_SURVEY_LINK_SEND_MS
+#define SURVEY_LINK_SEND_MS     CONFIG_SURVEY_LINK_SEND_MS
+#else
+#define SURVEY_LINK_SEND_MS     1000
+#endif
+
+typedef enum {
+    SURVEY_ROLE_OFF = 0,
+    SURVEY_ROLE_SATELLITE,
+    SURVEY_ROLE_COORDINATOR,
+} survey_role_t;
+
+// One satellite as the coordinator sees it
+typedef struct {
+    uint8_t mac[6];
+    uint32_t frames;
+    uint32_t records;
+    uint32_t lost;                      // Frames missing from the sequence
+    uint32_t last_ms;                   // Uptime of the latest frame
+    uint16_t last_seq;
+} survey_unit_t;
+
+typedef struct {
+    uint32_t frames_sent;
+    uint32_t records_sent;
+    uint32_t send_errors;
+    uint32_t frames_received;
+    uint32_t frames_dropped;            // RX queue full or malformed
+    uint32_t records_merged;
+    uint32_t store_full;                // Records the store could not take
+} survey_stats_t;
+
+/**
+ * @brief Start WiFi in station mode and ESP-NOW in the configured role
+ *
+ * Call once after uart_handler_init (it starts the network store).
+ * Does nothing (SURVEY_ROLE_OFF) unless CONFIG_SURVEY_LINK is set.
+ * @return ESP_OK, or the WiFi / ESP-NOW error
+ */
+esp_err_t survey_link_init(void);
+
+/**
+ * @brief Role this unit runs
+ */
+survey_role_t survey_link_role(void);
+
+/**
+ * @brief Copy the link counters
+ */
+void survey_link_get_stats(survey_stats_t *out);
+
+/**
+ * @brief Copy the satellites heard so far (coordinator)
+ * @param out Receives up to max units, oldest first
+ * @return Units written
+ */
+int survey_link_units(survey_unit_t *out, int max);
+
+#endif // SURVEY_LINK_H
@@ -0,0 +1,128 @@
+/**
+ * @file task_plan.c
+ * @brief Tracked task handles and stack high-water reporting
+ */
+
+#include "task_plan.h"
+#include "mem_monitor.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "TASKS";
+
+static TaskHandle_t handles[TASK_ID_COUNT];
+static portMUX_TYPE handles_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const task_names[TASK_ID_COUNT] = {
+    [TASK_ID_MAIN]        = "main",
+    [TASK_ID_UART_RX]     = "uart_rx",
+    [TASK_ID_UART2_RX]    = "uart2_rx",
+    [TASK_ID_GPS]         = "cap_gps",
+    [TASK_ID_RENDER]      = "render",
+    [TASK_ID_KEYBOARD]    = "keyboard",
+    [TASK_ID_AUDIO]       = "audio",
+    [TASK_ID_SESSION_LOG] = "session_log",
+    [TASK_ID_SCREENSHOT]  = "screenshot",
+    [TASK_ID_USB_BRIDGE]  = "usb_bridge",
+    [TASK_ID_SURVEY_RX]   = "survey_rx",
+    [TASK_ID_SNAPSHOT]    = "snapshot",
+};
+
+// Stacks of the tasks that run for the whole session
+MEM_BUDGET(stack_uart_rx, 1, TASK_UART_RX_STACK, MEM_BUDGET_HEAP);
+MEM_BUDGET(stack_render, 1, TASK_RENDER_STACK, MEM_BUDGET_HEAP);
+MEM_BUDGET(stack_keyboard, 1, TASK_KEYBOARD_STACK, MEM_BUDGET_HEAP);
+MEM_BUDGET(stack_audio, 1, TASK_AUDIO_STACK, MEM_BUDGET_HEAP);
+MEM_BUDGET(stack_session_log, 1, TASK_SESSION_LOG_STACK, MEM_BUDGET_HEAP);
+#ifdef CONFIG_STORE_SNAPSHOT
+MEM_BUDGET(stack_snapshot, 1, TASK_SNAPSHOT_STACK, MEM_BUDGET_HEAP);
+#endif
+MEM_BUDGET(stack_screenshot, 1, TASK_SCREENSHOT_STACK, MEM_BUDGET_HEAP);
+
+#if defined(CONFIG_TASK_STACK_REPORT_S) && CONFIG_TASK_STACK_REPORT_S > 0
+static esp_timer_handle_t report_timer = NULL;
+
+static void report_timer_callback(void *arg)
+{
+    (void)arg;
+    task_plan_log_stacks();
+}
+#endif
+
+esp_err_t task_plan_init(void)
+{
+    task_plan_track(TASK_ID_MAIN, xTaskGetCurrentTaskHandle());
+
+#if defined(CONFIG_TASK_STACK_REPORT_S) && CONFIG_TASK_STACK_REPORT_S > 0
+    if (report_timer) return ESP_OK;
+    const esp_timer_create_args_t args = {
+        .callback = report_timer_callback,
+        .name = "task_report",
+    };
+    esp_err_t ret = esp_timer_create(&args, &report_timer);
+    if (ret != ESP_OK) return ret;
+    return esp_timer_start_periodic(report_timer, CONFIG_TASK_STACK_REPORT_S * 1000000ULL);
+#else
+    return ESP_OK;
+#endif
+}
+
+void task_plan_track(task_id_t id, TaskHandle_t handle)
+{
+    if (id >= TASK_ID_COUNT) return;
+    portENTER_CRITICAL(&handles_lock);
+    handles[id] = handle;
+    portEXIT_CRITICAL(&handles_lock);
+}
+
+uint32_t task_plan_stack_free(task_id_t id)
+{
+    if (id >= TASK_ID_COUNT) return 0;
+
+    // Held across the query so a forgetting task cannot be deleted meanwhile
+    uint32_t free_bytes = 0;
+    portENTER_CRITICAL(&handles_lock);
+    if (handles[id]) {
+        free_bytes = uxTaskGetStackHighWaterMark(handles[id]);
+    }
+    portEXIT_CRITICAL(&handles_lock);
+    return free_bytes;
+}
+
+task_id_t task_plan_current(void)
+{
+    // Unlocked: a stale handle only fails to match
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int id = 0; id < TASK_ID_COUNT; id++) {
+        if (handles[id] == self) return (task_id_t)id;
+    }
+    return TASK_ID_COUNT;
+}
+
+const char *task_plan_name(task_id_t id)
+{
+    return id < TASK_ID_COUNT ? task_names[id] : "?";
+}
+
+void task_plan_log_stacks(void)
+{
+    for (int id = 0; id < TASK_ID_COUNT; id++) {
+        TaskHandle_t handle;
+        int core = -1;
+        unsigned prio = 0;
+        uint32_t free_bytes = 0;
+
+        portENTER_CRITICAL(&handles_lock);
+        handle = handles[id];
+        if (handle) {
+            core = (int)xTaskGetCoreID(handle);
+            prio = (unsigned)uxTaskPriorityGet(handle);
+            free_bytes = uxTaskGetStackHighWaterMark(handle);
+        }
+        portEXIT_CRITICAL(&handles_lock);
+
+        if (!handle) continue;
+        ESP_LOGI(TAG, "%-12s core %d prio %2u stack free %5luB",
+                 task_names[id], core, prio, (unsigned long)free_bytes);
+    }
+}
@@ -0,0 +1,262 @@
+/**
+ * @file task_plan.h
+ * @brief Core affinity, priority and stack size of every firmware task
+ *
+ * All tasks are created pinned, from the values here, so the topology is
+ * read and tuned in one place:
+ *
+ *   Core 0 (UI)  app_main (1), render (4), keyboard (6), audio (3),
+ *                screenshot / screen recorder (1), boot tasks (1)
+ *   Core 1 (I/O) uart_rx (10), usb_bridge (9), cap_gps (5),
+ *                survey_rx (4), uart_bench (3), transcript (2),
+ *                screen mirror (2), file transfer (2), scenario
+ *                runner (2), session / wardrive / track log
+ *                writers, store snapshot, observation export (1)
+ *
+ * UART bursts therefore only compete with other I/O work; key scanning
+ * and frame rendering keep their own core. app_main stays on CPU0
+ * (CONFIG_ESP_MAIN_TASK_AFFINITY_CPU0). On single-core builds everything
+ * runs on core 0 with the same priorities.
+ *
+ * Long-lived tasks are tracked so their stack high-water marks can be
+ * reported (task_plan_log_stacks(), and periodically with
+ * CONFIG_TASK_STACK_REPORT_S).
+ */
+
+#ifndef TASK_PLAN_H
+#define TASK_PLAN_H
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdint.h>
+
+#ifdef CONFIG_FREERTOS_UNICORE
+#define TASK_CORE_UI                0
+#define TASK_CORE_IO                0
+#else
+#define TASK_CORE_UI                0
+#define TASK_CORE_IO                1
+#endif
+
+// UART RX and line parsing
+#ifdef CONFIG_TASK_UART_RX_STACK
+#define TASK_UART_RX_STACK          CONFIG_TASK_UART_RX_STACK
+#define TASK_UART_RX_PRIO           CONFIG_TASK_UART_RX_PRIO
+#else
+#define TASK_UART_RX_STACK          4096
+#define TASK_UART_RX_PRIO           10
+#endif
+#define TASK_UART_RX_CORE           TASK_CORE_IO
+
+// USB to JanOS bridge (PC -> JanOS direction), just below UART RX
+#ifdef CONFIG_TASK_USB_BRIDGE_STACK
+#define TASK_USB_BRIDGE_STACK       CONFIG_TASK_USB_BRIDGE_STACK
+#else
+#define TASK_USB_BRIDGE_STACK       3072
+#endif
+#define TASK_USB_BRIDGE_PRIO        9
+#define TASK_USB_BRIDGE_CORE        TASK_CORE_IO
+
+// CAP GPS NMEA reader
+#ifdef CONFIG_TASK_GPS_STACK
+#define TASK_GPS_STACK              CONFIG_TASK_GPS_STACK
+#define TASK_GPS_PRIO               CONFIG_TASK_GPS_PRIO
+#else
+#define TASK_GPS_STACK              4096
+#define TASK_GPS_PRIO               5
+#endif
+#define TASK_GPS_CORE               TASK_CORE_IO
+
+// ESP-NOW survey records merged into the stores (coordinator only)
+#ifdef CONFIG_TASK_SURVEY_RX_STACK
+#define TASK_SURVEY_RX_STACK        CONFIG_TASK_SURVEY_RX_STACK
+#else
+#define TASK_SURVEY_RX_STACK        3072
+#endif
+#define TASK_SURVEY_RX_PRIO         4
+#define TASK_SURVEY_RX_CORE         TASK_CORE_IO
+
+// Frame rendering
+#ifdef CONFIG_TASK_RENDER_STACK
+#define TASK_RENDER_STACK           CONFIG_TASK_RENDER_STACK
+#define TASK_RENDER_PRIO            CONFIG_TASK_RENDER_PRIO
+#else
+#define TASK_RENDER_STACK           4096
+#define TASK_RENDER_PRIO            4
+#endif
+#define TASK_RENDER_CORE            TASK_CORE_UI
+
+// Keyboard interrupt reader (boards with a key interrupt)
+#ifdef CONFIG_TASK_KEYBOARD_STACK
+#define TASK_KEYBOARD_STACK         CONFIG_TASK_KEYBOARD_STACK
+#define TASK_KEYBOARD_PRIO          CONFIG_TASK_KEYBOARD_PRIO
+#else
+#define TASK_KEYBOARD_STACK         3072
+#define TASK_KEYBOARD_PRIO          6
+#endif
+#define TASK_KEYBOARD_CORE          TASK_CORE_UI
+
+// Tone synthesizer
+#ifdef CONFIG_TASK_AUDIO_STACK
+#define TASK_AUDIO_STACK            CONFIG_TASK_AUDIO_STACK
+#define TASK_AUDIO_PRIO             CONFIG_TASK_AUDIO_PRIO
+#else
+#define TASK_AUDIO_STACK            3072
+#define TASK_AUDIO_PRIO             3
+#endif
+#define TASK_AUDIO_CORE             TASK_CORE_UI
+
+// UART transcript writer / replay
+#ifdef CONFIG_TASK_TRANSCRIPT_STACK
+#define TASK_TRANSCRIPT_STACK       CONFIG_TASK_TRANSCRIPT_STACK
+#else
+#define TASK_TRANSCRIPT_STACK       4096
+#endif
+#define TASK_TRANSCRIPT_PRIO        2
+#define TASK_TRANSCRIPT_CORE        TASK_CORE_IO
+
+// Screen mirror over USB (reads the framebuffer, no UI lock)
+#ifdef CONFIG_TASK_SCREEN_MIRROR_STACK
+#define TASK_SCREEN_MIRROR_STACK    CONFIG_TASK_SCREEN_MIRROR_STACK
+#else
+#define TASK_SCREEN_MIRROR_STACK    3072
+#endif
+#define TASK_SCREEN_MIRROR_PRIO     2
+#define TASK_SCREEN_MIRROR_CORE     TASK_CORE_IO
+
+// File transfer with JanOS (feeds the UART TX, drains the RX chunk queue)
+#ifdef CONFIG_TASK_FILE_XFER_STACK
+#define TASK_FILE_XFER_STACK        CONFIG_TASK_FILE_XFER_STACK
+#else
+#define TASK_FILE_XFER_STACK        4096
+#endif
+#define TASK_FILE_XFER_PRIO         2
+#define TASK_FILE_XFER_CORE         TASK_CORE_IO
+
+// Scenario runner (injects keys, polls frame and progress counters, SD I/O)
+#ifdef CONFIG_TASK_SCENARIO_STACK
+#define TASK_SCENARIO_STACK         CONFIG_TASK_SCENARIO_STACK
+#else
+#define TASK_SCENARIO_STACK         4096
+#endif
+#define TASK_SCENARIO_PRIO          2
+#define TASK_SCENARIO_CORE          TASK_CORE_IO
+
+// SD card log writers, below UI and RX
+#ifdef CONFIG_TASK_SESSION_LOG_STACK
+#define TASK_SESSION_LOG_STACK      CONFIG_TASK_SESSION_LOG_STACK
+#else
+#define TASK_SESSION_LOG_STACK      4096
+#endif
+#ifdef CONFIG_TASK_WARDRIVE_LOG_STACK
+#define TASK_WARDRIVE_LOG_STACK     CONFIG_TASK_WARDRIVE_LOG_STACK
+#else
+#define TASK_WARDRIVE_LOG_STACK     3072
+#endif
+#ifdef CONFIG_TASK_TRACK_LOG_STACK
+#define TASK_TRACK_LOG_STACK        CONFIG_TASK_TRACK_LOG_STACK
+#else
+#define TASK_TRACK_LOG_STACK        3072
+#endif
+#ifdef CONFIG_TASK_TRACKER_DB_STACK
+#define TASK_TRACKER_DB_STACK       CONFIG_TASK_TRACKER_DB_STACK
+#else
+#define TASK_TRACKER_DB_STACK       3072
+#endif
+#ifdef CONFIG_TASK_SNAPSHOT_STACK
+#define TASK_SNAPSHOT_STACK         CONFIG_TASK_SNAPSHOT_STACK
+#else
+#define TASK_SNAPSHOT_STACK         4096
+#endif
+#ifdef CONFIG_TASK_EXPORT_STACK
+#define TASK_EXPORT_STACK           CONFIG_TASK_EXPORT_STACK
+#else
+#define TASK_EXPORT_STACK           4096
+#endif
+#define TASK_LOG_WRITER_PRIO        1
+#define TASK_LOG_WRITER_CORE        TASK_CORE_IO
+
+// Screenshot and screen recorder (encode from UI framebuffer copies)
+#ifdef CONFIG_TASK_SCREENSHOT_STACK
+#define TASK_SCREENSHOT_STACK       CONFIG_TASK_SCREENSHOT_STACK
+#else
+#define TASK_SCREENSHOT_STACK       4096
+#endif
+#ifdef CONFIG_TASK_SCREEN_RECORD_STACK
+#define TASK_SCREEN_RECORD_STACK    CONFIG_TASK_SCREEN_RECORD_STACK
+#else
+#define TASK_SCREEN_RECORD_STACK    4096
+#endif
+#define TASK_CAPTURE_PRIO           1
+#define TASK_CAPTURE_CORE           TASK_CORE_UI
+
+// UART link benchmark (uart_bench), short-lived; below UART RX, which
+// delivers its echoes
+#define TASK_UART_BENCH_STACK       3072
+#define TASK_UART_BENCH_PRIO        3
+#define TASK_UART_BENCH_CORE        TASK_CORE_IO
+
+// Background boot work: same priority as app_main, so UI setup is not preempted
+#ifdef CONFIG_TASK_BOOT_STACK
+#define TASK_BOOT_STACK             CONFIG_TASK_BOOT_STACK
+#else
+#define TASK_BOOT_STACK             4096
+#endif
+#define TASK_BOOT_PRIO              1
+#define TASK_BOOT_CORE              TASK_CORE_UI
+
+// Long-lived tasks whose stacks are reported
+typedef enum {
+    TASK_ID_MAIN = 0,
+    TASK_ID_UART_RX,
+    TASK_ID_UART2_RX,           // Second board (CONFIG_UART_SECOND_BOARD)
+    TASK_ID_GPS,
+    TASK_ID_RENDER,
+    TASK_ID_KEYBOARD,
+    TASK_ID_AUDIO,
+    TASK_ID_SESSION_LOG,
+    TASK_ID_SCREENSHOT,
+    TASK_ID_USB_BRIDGE,
+    TASK_ID_SURVEY_RX,          // CONFIG_SURVEY_LINK coordinator
+    TASK_ID_SNAPSHOT,           // CONFIG_STORE_SNAPSHOT
+    TASK_ID_COUNT
+} task_id_t;
+
+/**
+ * @brief Track app_main and start the periodic stack report (if enabled)
+ * @return ESP_OK, or the esp_timer error
+ */
+esp_err_t task_plan_init(void);
+
+/**
+ * @brief Remember (or, with NULL, forget) the handle of a long-lived task
+ *
+ * A task that deletes itself must forget its handle first.
+ */
+void task_plan_track(task_id_t id, TaskHandle_t handle);
+
+/**
+ * @brief Stack high-water mark of a tracked task
+ * @return Bytes never used, 0 if the task is not running
+ */
+uint32_t task_plan_stack_free(task_id_t id);
+
+/**
+ * @brief Id of the calling task
+ * @return TASK_ID_COUNT if it is not tracked
+ */
+task_id_t task_plan_current(void);
+
+/**
+ * @brief Short name of a task id ("?" if out of range)
+ */
+const char *task_plan_name(task_id_t id);
+
+/**
+ * @brief Log the core, priority and stack high-water mark of tracked tasks
+ */
+void task_plan_log_stacks(void);
+
+#endif // TASK_PLAN_H
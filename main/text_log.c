@@ -0,0 +1,135 @@
+/**
+ * @file text_log.c
+ * @brief Scrollback of text lines in one byte ring with a line index
+ */
+
+#include "text_log.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+
+static void *alloc(size_t size, bool psram)
+{
+    void *p = psram ? heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : NULL;
+    return p ? p : heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
+
+esp_err_t text_log_init(text_log_t *log, uint32_t byte_size, uint32_t line_count, bool psram)
+{
+    memset(log, 0, sizeof(*log));
+    log->bytes = alloc(byte_size, psram);
+    log->starts = alloc(line_count * sizeof(uint32_t), psram);
+    if (!log->bytes || !log->starts || line_count == 0) {
+        text_log_free(log);
+        return ESP_ERR_NO_MEM;
+    }
+    log->byte_size = byte_size;
+    fixed_ring_init(&log->lines, line_count);
+    portMUX_INITIALIZE(&log->lock);
+    return ESP_OK;
+}
+
+void text_log_free(text_log_t *log)
+{
+    free(log->bytes);
+    free(log->starts);
+    log->bytes = NULL;
+    log->starts = NULL;
+    log->byte_size = 0;
+}
+
+void text_log_clear(text_log_t *log)
+{
+    portENTER_CRITICAL(&log->lock);
+    fixed_ring_drop(&log->lines, fixed_ring_count(&log->lines));
+    portEXIT_CRITICAL(&log->lock);
+}
+
+/**
+ * @brief Copy into the byte ring at byte_head (lock held)
+ */
+static void put_bytes(text_log_t *log, const char *src, uint32_t len)
+{
+    uint32_t at = log->byte_head % log->byte_size;
+    uint32_t first = log->byte_size - at < len ? log->byte_size - at : len;
+    memcpy(log->bytes + at, src, first);
+    memcpy(log->bytes, src + first, len - first);
+    log->byte_head += len;
+}
+
+void text_log_append(text_log_t *log, const char *prefix, const char *line)
+{
+    if (!log->bytes) return;
+    uint32_t max = log->byte_size < TEXT_LOG_LINE_MAX ? log->byte_size : TEXT_LOG_LINE_MAX;
+    uint32_t prefix_len = prefix ? strnlen(prefix, max) : 0;
+    uint32_t line_len = strnlen(line, max - prefix_len);
+
+    portENTER_CRITICAL(&log->lock);
+    uint32_t start = log->byte_head;
+    put_bytes(log, prefix, prefix_len);
+    put_bytes(log, line, line_len);
+
+    // Drop lines whose bytes were just overwritten, then index this one
+    while (fixed_ring_count(&log->lines) > 0 &&
+           log->byte_head - log->starts[fixed_ring_slot(&log->lines, 0)] > log->byte_size) {
+        fixed_ring_drop(&log->lines, 1);
+    }
+    log->starts[fixed_ring_push(&log->lines, NULL)] = start;
+    portEXIT_CRITICAL(&log->lock);
+}
+
+uint32_t text_log_first(const text_log_t *log)
+{
+    return log->lines.tail;
+}
+
+uint32_t text_log_end(const text_log_t *log)
+{
+    return log->lines.head;
+}
+
+bool text_log_get(text_log_t *log, uint32_t n, char *out, size_t size)
+{
+    if (size == 0) return false;
+    out[0] = '\0';
+
+    portENTER_CRITICAL(&log->lock);
+    bool held = n - log->lines.tail < fixed_ring_count(&log->lines);
+    if (held) {
+        uint32_t i = n - log->lines.tail;
+        uint32_t start = log->starts[fixed_ring_slot(&log->lines, i)];
+        uint32_t end = i + 1 < fixed_ring_count(&log->lines) ?
+            log->starts[fixed_ring_slot(&log->lines, i + 1)] : log->byte_head;
+        uint32_t len = end - start < size - 1 ? end - start : (uint32_t)size - 1;
+        uint32_t at = start % log->byte_size;
+        uint32_t first = log->byte_size - at < len ? log->byte_size - at : len;
+        memcpy(out, log->bytes + at, first);
+        memcpy(out + first, log->bytes, len - first);
+        out[len] = '\0';
+    }
+    portEXIT_CRITICAL(&log->lock);
+    return held;
+}
+
+bool text_log_find(text_log_t *log, uint32_t from, const char *text, bool backward,
+                   uint32_t *found)
+{
+    size_t text_len = strlen(text);
+    if (text_len == 0) return false;
+
+    char line[TEXT_LOG_LINE_MAX + 1];
+    uint32_t n = from;
+    // Lines are copied one at a time so the writer is never held up long
+    while (text_log_get(log, n, line, sizeof(line))) {
+        for (const char *p = line; *p; p++) {
+            if (strncasecmp(p, text, text_len) == 0) {
+                *found = n;
+                return true;
+            }
+        }
+        if (backward && n == 0) break;
+        n += backward ? -1 : 1;
+    }
+    return false;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file text_log.h
+ * @brief Scrollback of text lines in one byte ring with a line index
+ *
+ * Appending copies the line once into the byte ring and records where it
+ * starts in a ring of offsets (fixed_ring_t), so it costs the same however
+ * much is kept. When either ring is full the oldest lines go. Lines are
+ * numbered from the first one ever appended; text_log_first() and
+ * text_log_end() bound the ones still held, so a reader keeps its place
+ * while new lines arrive.
+ *
+ * One writer and any number of readers in other tasks; a spinlock covers
+ * each append and each line copied out.
+ */
+
+#ifndef TEXT_LOG_H
+#define TEXT_LOG_H
+
+#include "fixed_containers.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TEXT_LOG_LINE_MAX   512     // Longer lines are cut
+
+typedef struct text_log {
+    char *bytes;
+    uint32_t byte_size;
+    uint32_t byte_head;             // Total bytes ever written
+    uint32_t *starts;               // byte_head at each line's start
+    fixed_ring_t lines;
+    portMUX_TYPE lock;
+} text_log_t;
+
+/**
+ * @brief Allocate the rings
+ * @param byte_size Text bytes kept
+ * @param line_count Lines kept
+ * @param psram Prefer PSRAM (internal RAM if there is none)
+ * @return ESP_OK or ESP_ERR_NO_MEM
+ */
+esp_err_t text_log_init(text_log_t *log, uint32_t byte_size, uint32_t line_count, bool psram);
+
+/**
+ * @brief Release the rings
+ */
+void text_log_free(text_log_t *log);
+
+/**
+ * @brief Forget every line (numbering carries on)
+ */
+void text_log_clear(text_log_t *log);
+
+/**
+ * @brief Append prefix and line as one line
+ * @param prefix May be NULL or ""
+ */
+void text_log_append(text_log_t *log, const char *prefix, const char *line);
+
+/**
+ * @brief Number of the oldest line held
+ */
+uint32_t text_log_first(const text_log_t *log);
+
+/**
+ * @brief Number the next appended line will get
+ */
+uint32_t text_log_end(const text_log_t *log);
+
+/**
+ * @brief Copy one line out
+ * @param n Line number
+ * @param out Destination, always terminated
+ * @param size Size of out
+ * @return false if the line is no longer (or not yet) held
+ */
+bool text_log_get(text_log_t *log, uint32_t n, char *out, size_t size);
+
+/**
+ * @brief Search for a line containing text, case-insensitive
+ * @param from First line to look at
+ * @param backward Toward older lines
+ * @param found Set to the matching line number
+ * @return true if a held line matches
+ */
+bool text_log_find(text_log_t *log, uint32_t from, const char *text, bool backward,
+                   uint32_t *found);
+
+#endif // TEXT_LOG_H
@@ -0,0 +1,157 @@
+/**
+ * @file time_sync.c
+ * @brief One monotonic timebase for Cardputer, JanOS and GPS times
+ */
+
+#include "time_sync.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <sys/time.h>
+#include <stdlib.h>
+
+static const char *TAG = "TIME_SYNC";
+
+// Best sample of the current window and of the one before
+typedef struct {
+    int64_t current;
+    int64_t previous;
+    uint32_t count;                     // Samples since the start
+} window_t;
+
+static window_t utc_window;
+static window_t janos_window[UART_LINK_COUNT];
+static uint32_t janos_last_ms[UART_LINK_COUNT];
+static uint32_t rtt_min_us[UART_LINK_COUNT];
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Add a sample; want_max picks the largest, else the smallest (lock held)
+ */
+static void window_add(window_t *w, int64_t sample, bool want_max)
+{
+    if (w->count % TIME_SYNC_WINDOW == 0) {
+        // Window full: the one just finished becomes the fallback
+        w->previous = w->count ? w->current : sample;
+        w->current = sample;
+    } else if (want_max ? sample > w->current : sample < w->current) {
+        w->current = sample;
+    }
+    w->count++;
+}
+
+static int64_t window_best(const window_t *w, bool want_max)
+{
+    if (want_max) return w->current > w->previous ? w->current : w->previous;
+    return w->current < w->previous ? w->current : w->previous;
+}
+
+int64_t time_sync_now_us(void)
+{
+    return esp_timer_get_time();
+}
+
+void time_sync_gps_utc(uint32_t utc_s, uint16_t utc_ms, int64_t rx_us)
+{
+    if (utc_s == 0) return;
+    int64_t utc_us = (int64_t)utc_s * 1000000 + (int64_t)utc_ms * 1000;
+
+    portENTER_CRITICAL(&lock);
+    window_add(&utc_window, utc_us - rx_us, true);
+    int64_t offset = window_best(&utc_window, true);
+    bool first = utc_window.count == 1;
+    portEXIT_CRITICAL(&lock);
+
+    // Step the system clock only when it is noticeably off
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t now_utc = time_sync_now_us() + offset;
+    int64_t error_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec - now_utc;
+    if (first || llabs(error_us) > TIME_SYNC_STEP_MS * 1000LL) {
+        tv.tv_sec = now_utc / 1000000;
+        tv.tv_usec = now_utc % 1000000;
+        settimeofday(&tv, NULL);
+        ESP_LOGI(TAG, "System clock set from GPS (was off by %lld ms)", (long long)(error_us / 1000));
+    }
+}
+
+void time_sync_janos_sample(uart_link_id_t link, uint32_t janos_ms, int64_t rx_us)
+{
+    if (link >= UART_LINK_COUNT) return;
+
+    portENTER_CRITICAL(&lock);
+    // Uptime went back: the board restarted, its old offset is void
+    if (janos_ms + 1000 < janos_last_ms[link]) janos_window[link].count = 0;
+    janos_last_ms[link] = janos_ms;
+    window_add(&janos_window[link], rx_us - (int64_t)janos_ms * 1000, false);
+    portEXIT_CRITICAL(&lock);
+}
+
+void time_sync_ping_rtt(uart_link_id_t link, uint32_t rtt_us)
+{
+    if (link >= UART_LINK_COUNT || rtt_us == 0) return;
+
+    portENTER_CRITICAL(&lock);
+    if (rtt_min_us[link] == 0 || rtt_us < rtt_min_us[link]) rtt_min_us[link] = rtt_us;
+    portEXIT_CRITICAL(&lock);
+}
+
+bool time_sync_utc_us(int64_t mono_us, int64_t *utc_us)
+{
+    portENTER_CRITICAL(&lock);
+    bool valid = utc_window.count > 0;
+    int64_t offset = window_best(&utc_window, true);
+    portEXIT_CRITICAL(&lock);
+
+    if (valid && utc_us) *utc_us = mono_us + offset;
+    return valid;
+}
+
+/**
+ * @brief Monotonic us = JanOS us + offset (lock held)
+ */
+static int64_t janos_offset(uart_link_id_t link)
+{
+    return window_best(&janos_window[link], false) - rtt_min_us[link] / 2;
+}
+
+bool time_sync_janos_to_mono(uart_link_id_t link, uint32_t janos_ms, int64_t *mono_us)
+{
+    if (link >= UART_LINK_COUNT) return false;
+
+    portENTER_CRITICAL(&lock);
+    bool valid = janos_window[link].count > 0;
+    int64_t offset = janos_offset(link);
+    portEXIT_CRITICAL(&lock);
+
+    if (valid && mono_us) *mono_us = (int64_t)janos_ms * 1000 + offset;
+    return valid;
+}
+
+void time_sync_get_status(time_sync_status_t *out)
+{
+    if (!out) return;
+
+    portENTER_CRITICAL(&lock);
+    out->utc_valid = utc_window.count > 0;
+    out->utc_offset_us = window_best(&utc_window, true);
+    out->utc_samples = utc_window.count;
+    for (int i = 0; i < UART_LINK_COUNT; i++) {
+        out->janos_valid[i] = janos_window[i].count > 0;
+        out->janos_offset_us[i] = janos_offset((uart_link_id_t)i);
+        out->janos_samples[i] = janos_window[i].count;
+        out->rtt_min_us[i] = rtt_min_us[i];
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+int64_t time_sync_days_from_civil(int year, int month, int day)
+{
+    // Years start in March, so the leap day ends the year
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yoe = year - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return (int64_t)era * 146097 + doe - 719468;
+}
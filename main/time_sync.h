@@ -0,0 +1,90 @@
+/**
+ * @file time_sync.h
+ * @brief One monotonic timebase for Cardputer, JanOS and GPS times
+ *
+ * Everything is stamped in esp_timer microseconds (time_sync_now_us),
+ * which never steps. The other clocks are kept as offsets to it:
+ *
+ * - UTC, from CAP GPS RMC sentences. A sentence names the UTC of its
+ *   epoch and reaches us some tens of ms later; that delay only ever
+ *   adds, so the largest UTC - arrival offset of a window is kept. The
+ *   system clock (time(), file dates) is set from it when it is off by
+ *   more than TIME_SYNC_STEP_MS.
+ * - Each JanOS board's uptime, from its ESP log lines ("I (12345) TAG:").
+ *   A line is stamped when its last byte arrived (uart_line_time_us), so
+ *   arrival - JanOS time is the offset plus the transit; the smallest of
+ *   a window is kept, less half the best ping round trip for the transit
+ *   even that one carried.
+ *
+ * Windows keep the best of the current and the previous
+ * TIME_SYNC_WINDOW samples, so an estimate follows slow drift without
+ * taking one delayed sample. Feeders run on the GPS and UART RX tasks;
+ * any task may read.
+ */
+
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include "uart_handler.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TIME_SYNC_WINDOW        32      // Samples per estimate window
+#define TIME_SYNC_STEP_MS       500     // System clock error that resets it
+
+typedef struct {
+    bool utc_valid;
+    int64_t utc_offset_us;              // UTC us = monotonic us + this
+    uint32_t utc_samples;
+    bool janos_valid[UART_LINK_COUNT];
+    int64_t janos_offset_us[UART_LINK_COUNT];   // Monotonic us = JanOS us + this
+    uint32_t janos_samples[UART_LINK_COUNT];
+    uint32_t rtt_min_us[UART_LINK_COUNT];       // Best ping round trip, 0 = none
+} time_sync_status_t;
+
+/**
+ * @brief Monotonic microseconds since boot (the timebase of every stamp)
+ */
+int64_t time_sync_now_us(void);
+
+/**
+ * @brief Feed the UTC of a GPS sentence and when it arrived (GPS task)
+ */
+void time_sync_gps_utc(uint32_t utc_s, uint16_t utc_ms, int64_t rx_us);
+
+/**
+ * @brief Feed a JanOS log timestamp and when its line arrived (RX task)
+ */
+void time_sync_janos_sample(uart_link_id_t link, uint32_t janos_ms, int64_t rx_us);
+
+/**
+ * @brief Feed a ping round trip to a board
+ */
+void time_sync_ping_rtt(uart_link_id_t link, uint32_t rtt_us);
+
+/**
+ * @brief Convert a monotonic stamp to UTC
+ * @return false until the GPS has given a time
+ */
+bool time_sync_utc_us(int64_t mono_us, int64_t *utc_us);
+
+/**
+ * @brief Convert a JanOS uptime to a monotonic stamp
+ * @return false until that board has printed a log timestamp
+ */
+bool time_sync_janos_to_mono(uart_link_id_t link, uint32_t janos_ms, int64_t *mono_us);
+
+/**
+ * @brief Copy the current estimates
+ */
+void time_sync_get_status(time_sync_status_t *out);
+
+/**
+ * @brief Days from 1970-01-01 to a civil date (proleptic Gregorian)
+ * @param year Full year
+ * @param month 1-12
+ * @param day 1-31, not checked against the month
+ */
+int64_t time_sync_days_from_civil(int year, int month, int day);
+
+#endif // TIME_SYNC_H
@@ -0,0 +1,115 @@
+/**
+ * @file trace.c
+ * @brief Binary event trace of the UART, render and SD paths
+ */
+
+#include "trace.h"
+
+#ifdef CONFIG_EVENT_TRACE
+
+#include "task_plan.h"
+#include "time_sync.h"
+#include "mem_monitor.h"
+#include "screenshot.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sys/stat.h>
+
+static const char *TAG = "TRACE";
+
+#define TRACE_DIR               "/sdcard/traces"
+
+static trace_record_t ring[TRACE_RING_SIZE];
+static uint32_t head;                   // Records ever taken; slot = head % size
+static bool paused;
+
+_Static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0,
+               "ring size must be a power of two so slots survive the counter wrap");
+
+MEM_BUDGET(trace_ring, TRACE_RING_SIZE, sizeof(trace_record_t), MEM_BUDGET_STATIC);
+
+void trace_record(trace_event_t event, trace_phase_t phase, uint32_t arg)
+{
+    if (__atomic_load_n(&paused, __ATOMIC_RELAXED)) return;
+
+    task_id_t task = task_plan_current();
+    uint32_t slot = __atomic_fetch_add(&head, 1, __ATOMIC_RELAXED) % TRACE_RING_SIZE;
+    trace_record_t *r = &ring[slot];
+    r->time_us = (uint64_t)time_sync_now_us();
+    r->task = task < TASK_ID_COUNT ? (uint8_t)task : TRACE_TASK_OTHER;
+    r->core = (uint8_t)xPortGetCoreID();
+    r->event = (uint8_t)event;
+    r->phase = (uint8_t)phase;
+    r->arg = arg;
+}
+
+static int next_trace_number(void)
+{
+    char path[64];
+    struct stat st;
+    for (int n = 1; n < 10000; n++) {
+        snprintf(path, sizeof(path), "%s/trace_%d.mtr", TRACE_DIR, n);
+        if (stat(path, &st) != 0) return n;
+    }
+    return -1;
+}
+
+static bool write_header(FILE *f, uint32_t count, uint32_t lost)
+{
+    const uint16_t version = TRACE_VERSION;
+    const uint16_t record_size = sizeof(trace_record_t);
+    const uint8_t names = TASK_ID_COUNT;
+    bool ok = fwrite("MTRC", 1, 4, f) == 4 &&
+              fwrite(&version, sizeof(version), 1, f) == 1 &&
+              fwrite(&record_size, sizeof(record_size), 1, f) == 1 &&
+              fwrite(&count, sizeof(count), 1, f) == 1 &&
+              fwrite(&lost, sizeof(lost), 1, f) == 1 &&
+              fwrite(&names, sizeof(names), 1, f) == 1;
+    for (int id = 0; ok && id < TASK_ID_COUNT; id++) {
+        char name[TRACE_NAME_LEN] = {0};
+        strncpy(name, task_plan_name((task_id_t)id), sizeof(name) - 1);
+        ok = fwrite(name, sizeof(name), 1, f) == 1;
+    }
+    return ok;
+}
+
+esp_err_t trace_dump(void)
+{
+    if (!screenshot_is_available()) {
+        ESP_LOGW(TAG, "SD card not mounted, cannot dump trace");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (__atomic_exchange_n(&paused, true, __ATOMIC_ACQUIRE)) return ESP_ERR_INVALID_STATE;
+
+    uint32_t total = __atomic_load_n(&head, __ATOMIC_RELAXED);
+    uint32_t count = total < TRACE_RING_SIZE ? total : TRACE_RING_SIZE;
+    uint32_t first = (total - count) % TRACE_RING_SIZE;
+
+    mkdir(TRACE_DIR, 0755);
+    int number = next_trace_number();
+    char path[64];
+    snprintf(path, sizeof(path), "%s/trace_%d.mtr", TRACE_DIR, number);
+    FILE *f = number > 0 ? fopen(path, "wb") : NULL;
+    bool ok = f && write_header(f, count, total - count);
+
+    // Oldest first: the tail of the ring, then its start
+    uint32_t tail = TRACE_RING_SIZE - first < count ? TRACE_RING_SIZE - first : count;
+    if (ok && tail) ok = fwrite(&ring[first], sizeof(trace_record_t), tail, f) == tail;
+    if (ok && count > tail) ok = fwrite(ring, sizeof(trace_record_t), count - tail, f) == count - tail;
+    if (f && fclose(f) != 0) ok = false;
+
+    __atomic_store_n(&paused, false, __ATOMIC_RELEASE);
+
+    if (!ok) {
+        ESP_LOGE(TAG, "Trace dump to %s failed", path);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Wrote %lu events to %s (%lu lost to wrap-around)",
+             (unsigned long)count, path, (unsigned long)(total - count));
+    return ESP_OK;
+}
+
+#endif // CONFIG_EVENT_TRACE
@@ -0,0 +1,99 @@
+/**
+ * @file trace.h
+ * @brief Binary event trace of the UART, render and SD paths
+ *
+ * Enabled with CONFIG_EVENT_TRACE; otherwise the TRACE_* macros compile
+ * to nothing and their arguments are not evaluated. Each event is one
+ * 16-byte record in a fixed RAM ring of TRACE_RING_SIZE, the oldest
+ * overwritten first: the monotonic stamp (time_sync_now_us), the tracked
+ * task (task_plan) and core, the event, its phase and one argument.
+ * Recording takes a slot with one atomic add and no lock, so it is cheap
+ * enough for every UART line.
+ *
+ * Ctrl+T writes the ring to the next /sdcard/traces/trace_N.mtr;
+ * tools/trace_to_perfetto.py turns it into Chrome trace JSON that
+ * ui.perfetto.dev and chrome://tracing open, one track per task.
+ *
+ * File format (.mtr, little endian):
+ *   header   "MTRC", u16 version (1), u16 record size (16),
+ *            u32 record count, u32 records lost to wrap-around,
+ *            u8 task name count, then 16-byte NUL-padded names by task id
+ *   record   u64 time_us, u8 task, u8 core, u8 event, u8 phase, u32 arg
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+
+#ifdef CONFIG_EVENT_TRACE_RING_SIZE
+#define TRACE_RING_SIZE         CONFIG_EVENT_TRACE_RING_SIZE
+#else
+#define TRACE_RING_SIZE         2048
+#endif
+
+#define TRACE_VERSION           1
+#define TRACE_NAME_LEN          16      // Task name field in the file header
+#define TRACE_TASK_OTHER        0xFF    // Task not tracked by task_plan
+
+typedef enum {
+    TRACE_EV_UART_LINE = 0,     // Line complete on a link (arg: link << 16 | length)
+    TRACE_EV_UART_FRAME,        // Binary frame complete (arg: link << 16 | type)
+    TRACE_EV_DISPATCH,          // Line handed to routes (arg: route count)
+    TRACE_EV_PARSE,             // Scan line or frame parsed into a network
+    TRACE_EV_DRAW,              // Screen on_draw
+    TRACE_EV_FLUSH,             // display_flush to the panel
+    TRACE_EV_KEY,               // Key press (arg: key code)
+    TRACE_EV_SD_WRITE,          // Chunk written to the card (arg: bytes)
+    TRACE_EV_COUNT
+} trace_event_t;
+
+typedef enum {
+    TRACE_PHASE_INSTANT = 0,
+    TRACE_PHASE_BEGIN,
+    TRACE_PHASE_END,
+} trace_phase_t;
+
+typedef struct __attribute__((packed)) {
+    uint64_t time_us;
+    uint8_t task;
+    uint8_t core;
+    uint8_t event;
+    uint8_t phase;
+    uint32_t arg;
+} trace_record_t;
+
+_Static_assert(sizeof(trace_record_t) == 16, "trace records are 16 bytes");
+
+#ifdef CONFIG_EVENT_TRACE
+
+/**
+ * @brief Append one record to the ring (any task)
+ */
+void trace_record(trace_event_t event, trace_phase_t phase, uint32_t arg);
+
+/**
+ * @brief Write the ring to the next /sdcard/traces/trace_N.mtr
+ *
+ * Recording pauses while the file is written, so events of the dump
+ * itself are not in it.
+ * @return ESP_OK, ESP_ERR_INVALID_STATE without SD card or while another
+ *         dump runs, or ESP_FAIL on a write error
+ */
+esp_err_t trace_dump(void);
+
+#define TRACE_INSTANT(ev, arg)  trace_record((ev), TRACE_PHASE_INSTANT, (arg))
+#define TRACE_BEGIN(ev, arg)    trace_record((ev), TRACE_PHASE_BEGIN, (arg))
+#define TRACE_END(ev, arg)      trace_record((ev), TRACE_PHASE_END, (arg))
+
+#else
+
+#define TRACE_INSTANT(ev, arg)  ((void)0)
+#define TRACE_BEGIN(ev, arg)    ((void)0)
+#define TRACE_END(ev, arg)      ((void)0)
+
+#endif // CONFIG_EVENT_TRACE
+
+#endif // TRACE_H
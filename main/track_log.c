@@ -0,0 +1,358 @@
+/**
+ * @file track_log.c
+ * @brief The wardrive route itself, simplified while it is recorded
+ *
+ * Fixes are simplified on the CAP GPS task (a window of distance checks
+ * per fix); a full block is encoded there and handed to a writer task so
+ * the card write never holds up the receiver.
+ */
+
+#include "track_log.h"
+#include "wardrive_log.h"
+#include "screenshot.h"
+#include "sd_io.h"
+#include "task_plan.h"
+#include "mem_monitor.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+static const char *TAG = "TRACK_LOG";
+
+// Metres per 1e-7 degree of latitude
+#define METRES_PER_E7       0.011132f
+
+// Header, base time, then every column at its widest
+#define BLOCK_BUFFER_SIZE   (TRACK_LOG_BLOCK_HEADER + 5 + TRACK_LOG_BLOCK_POINTS * (5 * 5 + 1))
+
+#define WRITER_QUEUE_LEN    4
+
+typedef struct {
+    uint32_t utc;               // Unix seconds
+    uint16_t utc_ms;
+    int32_t lat;                // Degrees x 1e7
+    int32_t lon;
+    int32_t alt;                // Decimetres
+    uint16_t hdop;              // x 100
+    uint8_t flags;              // TRACK_LOG_FLAG_*
+} point_t;
+
+typedef struct {
+    // Simplification
+    bool have_anchor;           // A point was kept in the current stretch
+    point_t anchor;             // Last kept point
+    float metres_per_e7_lon;    // At the anchor's latitude
+    point_t window[TRACK_LOG_WINDOW];   // Fixes since the anchor, oldest first
+    int window_count;
+    bool segment_start;         // Next kept point opens a stretch
+
+    // Block being collected
+    point_t points[TRACK_LOG_BLOCK_POINTS];
+    int point_count;
+    int64_t block_start_us;
+} track_state_t;
+
+// Queue item: encoded block, or NULL to close the file
+typedef struct {
+    uint8_t *data;
+    size_t len;
+} block_item_t;
+
+static track_state_t *state = NULL;
+static QueueHandle_t writer_queue = NULL;
+static int32_t state_mem_bytes = 0;          // Attributed to MEM_SUB_LOGGER while open
+static track_log_stats_t stats;
+
+static uint8_t *put_varint(uint8_t *p, uint32_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static uint8_t *put_svarint(uint8_t *p, int32_t v)
+{
+    return put_varint(p, ((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+}
+
+static void writer_task(void *arg)
+{
+    sd_file_t *f = arg;
+    block_item_t item;
+
+    while (1) {
+        xQueueReceive(writer_queue, &item, portMAX_DELAY);
+        if (!item.data) break;
+        // Blocks are minutes apart: commit each one
+        if (f && (sd_io_write(f, item.data, item.len) != ESP_OK || sd_io_sync(f) != ESP_OK)) {
+            ESP_LOGE(TAG, "Write failed, track closed");
+            sd_io_close(f);
+            f = NULL;
+        }
+        mem_free(MEM_SUB_LOGGER, item.data);
+    }
+
+    if (f) sd_io_close(f);
+    vQueueDelete(writer_queue);
+    writer_queue = NULL;
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Encode buffered points into one block and queue it for writing
+ */
+static void flush_block(void)
+{
+    track_state_t *s = state;
+    int n = s->point_count;
+    if (n == 0) return;
+    s->point_count = 0;
+
+    uint8_t *buf = mem_malloc(MEM_SUB_LOGGER, BLOCK_BUFFER_SIZE);
+    if (!buf) {
+        ESP_LOGW(TAG, "No memory for block, %d points lost", n);
+        return;
+    }
+
+    // Times as milliseconds after the block base: deltas fit 32 bits
+    const point_t *pt = s->points;
+    uint32_t base = pt[0].utc;
+    uint8_t *p = put_varint(buf + TRACK_LOG_BLOCK_HEADER, base);
+    int64_t prev_ms = 0;
+    for (int i = 0; i < n; i++) {
+        int64_t ms = (int64_t)(pt[i].utc - base) * 1000 + pt[i].utc_ms;
+        p = put_svarint(p, (int32_t)(ms - prev_ms));
+        prev_ms = ms;
+    }
+    for (int i = 0; i < n; i++) p = put_svarint(p, pt[i].lat - (i ? pt[i - 1].lat : 0));
+    for (int i = 0; i < n; i++) p = put_svarint(p, pt[i].lon - (i ? pt[i - 1].lon : 0));
+    for (int i = 0; i < n; i++) p = put_svarint(p, pt[i].alt - (i ? pt[i - 1].alt : 0));
+    for (int i = 0; i < n; i++) p = put_varint(p, pt[i].hdop);
+    for (int i = 0; i < n; i++) *p++ = pt[i].flags;
+
+    uint32_t payload = (uint32_t)(p - buf) - TRACK_LOG_BLOCK_HEADER;
+    buf[0] = TRACK_LOG_BLOCK_MARKER;
+    buf[1] = n & 0xFF;
+    buf[2] = n >> 8;
+    buf[3] = payload & 0xFF;
+    buf[4] = (payload >> 8) & 0xFF;
+    buf[5] = (payload >> 16) & 0xFF;
+    buf[6] = payload >> 24;
+
+    block_item_t item = { .data = buf, .len = payload + TRACK_LOG_BLOCK_HEADER };
+    if (!writer_queue || xQueueSend(writer_queue, &item, pdMS_TO_TICKS(100)) != pdTRUE) {
+        ESP_LOGW(TAG, "Writer behind, %d points lost", n);
+        mem_free(MEM_SUB_LOGGER, buf);
+    }
+}
+
+/**
+ * @brief Store a point and make it the anchor of the next line
+ */
+static void keep_point(track_state_t *s, const point_t *pt)
+{
+    if (s->point_count == 0) s->block_start_us = esp_timer_get_time();
+    point_t *out = &s->points[s->point_count++];
+    *out = *pt;
+    out->flags = s->segment_start ? TRACK_LOG_FLAG_SEGMENT : 0;
+    s->segment_start = false;
+    stats.kept++;
+
+    s->anchor = *pt;
+    s->have_anchor = true;
+    s->metres_per_e7_lon = METRES_PER_E7 * cosf(pt->lat * (float)(M_PI / 180.0 / 1e7));
+
+    if (s->point_count == TRACK_LOG_BLOCK_POINTS) flush_block();
+}
+
+/**
+ * @brief Whether every windowed fix lies within the tolerance of anchor -> end
+ */
+static bool line_fits(const track_state_t *s, const point_t *end)
+{
+    const float tol2 = (float)TRACK_LOG_TOLERANCE_M * TRACK_LOG_TOLERANCE_M;
+    const point_t *a = &s->anchor;
+    // Local plane in metres around the anchor
+    float ex = (end->lon - a->lon) * s->metres_per_e7_lon;
+    float ey = (end->lat - a->lat) * METRES_PER_E7;
+    float len2 = ex * ex + ey * ey;
+
+    for (int i = 0; i < s->window_count; i++) {
+        float px = (s->window[i].lon - a->lon) * s->metres_per_e7_lon;
+        float py = (s->window[i].lat - a->lat) * METRES_PER_E7;
+        // Distance to the segment, not the infinite line: a turn back
+        // along the same road must still be kept
+        float t = len2 > 0.0f ? (px * ex + py * ey) / len2 : 0.0f;
+        if (t < 0.0f) t = 0.0f;
+        if (t > 1.0f) t = 1.0f;
+        float dx = px - t * ex;
+        float dy = py - t * ey;
+        if (dx * dx + dy * dy > tol2) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Keep the newest windowed fix, if any, and empty the window
+ */
+static void keep_window_end(track_state_t *s)
+{
+    if (s->window_count == 0) return;
+    point_t end = s->window[s->window_count - 1];
+    s->window_count = 0;
+    keep_point(s, &end);
+}
+
+void track_log_add_fix(const cap_gps_fix_t *fix)
+{
+    track_state_t *s = state;
+    if (!s) return;
+
+    if (!fix->fix) {
+        // End the stretch where the fix was last good
+        keep_window_end(s);
+        s->have_anchor = false;
+        s->segment_start = true;
+        return;
+    }
+    if (fix->utc_time == 0) return;
+    stats.fixes++;
+
+    point_t pt = {
+        .utc = fix->utc_time,
+        .utc_ms = fix->utc_ms,
+        .lat = fix->lat_e7,
+        .lon = fix->lon_e7,
+        .alt = fix->alt_dm,
+        .hdop = (uint16_t)(fix->hdop_x100 > UINT16_MAX ? UINT16_MAX : fix->hdop_x100),
+    };
+
+    if (!s->have_anchor) {
+        keep_point(s, &pt);
+    } else {
+        if (!line_fits(s, &pt)) {
+            // The route bent: the previous fix ends the straight part
+            keep_window_end(s);
+        } else if (pt.utc - s->anchor.utc >= TRACK_LOG_MAX_GAP_S) {
+            keep_window_end(s);
+        }
+        if (s->window_count == TRACK_LOG_WINDOW) {
+            // Halve the window, keeping its newest fix: later checks see
+            // every other fix, which is enough at receiver rates
+            int kept = 0;
+            for (int i = 1; i < s->window_count; i += 2) s->window[kept++] = s->window[i];
+            s->window_count = kept;
+        }
+        s->window[s->window_count++] = pt;
+    }
+
+    if (s->point_count > 0 &&
+        esp_timer_get_time() - s->block_start_us >= TRACK_LOG_FLUSH_S * 1000000LL) {
+        flush_block();
+    }
+}
+
+/**
+ * @brief Highest N among trk_N.mtk files, 0 if none
+ */
+static int latest_track_number(void)
+{
+    DIR *dir = opendir(WARDRIVE_LOG_DIR);
+    if (!dir) return 0;
+
+    int max_num = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int num;
+        if (sscanf(entry->d_name, "trk_%d.mtk", &num) == 1 && num > max_num) {
+            max_num = num;
+        }
+    }
+    closedir(dir);
+    return max_num;
+}
+
+esp_err_t track_log_open(void)
+{
+    if (state || writer_queue) return ESP_ERR_INVALID_STATE;
+    if (!screenshot_is_available()) {
+        ESP_LOGW(TAG, "SD card not mounted, track log disabled");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t mem_token = mem_scope_begin();
+    track_state_t *s = calloc(1, sizeof(track_state_t));
+    if (!s) return ESP_ERR_NO_MEM;
+    s->segment_start = true;
+
+    struct stat st;
+    if (stat(WARDRIVE_LOG_DIR, &st) != 0) {
+        mkdir(WARDRIVE_LOG_DIR, 0755);
+    }
+    char path[48];
+    snprintf(path, sizeof(path), "%s/trk_%d%s", WARDRIVE_LOG_DIR, latest_track_number() + 1,
+             TRACK_LOG_EXT);
+    // Not preallocated, as for wardrive logs: a cut file ends on a block
+    sd_file_t *f = sd_io_open(path, 0);
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        free(s);
+        return ESP_FAIL;
+    }
+    uint8_t header[TRACK_LOG_HEADER_SIZE] = { 'M', 'T', 'K', '1', TRACK_LOG_VERSION };
+    sd_io_write(f, header, sizeof(header));
+
+    writer_queue = xQueueCreate(WRITER_QUEUE_LEN, sizeof(block_item_t));
+    if (!writer_queue ||
+        xTaskCreatePinnedToCore(writer_task, "track_log", TASK_TRACK_LOG_STACK, f,
+                                TASK_LOG_WRITER_PRIO, NULL, TASK_LOG_WRITER_CORE) != pdPASS) {
+        if (writer_queue) vQueueDelete(writer_queue);
+        writer_queue = NULL;
+        sd_io_close(f);
+        free(s);
+        return ESP_FAIL;
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    state_mem_bytes = mem_scope_end(MEM_SUB_LOGGER, mem_token);
+    state = s;
+    ESP_LOGI(TAG, "Logging track to %s", path);
+    return ESP_OK;
+}
+
+void track_log_close(void)
+{
+    track_state_t *s = state;
+    if (!s) return;
+
+    keep_window_end(s);
+    flush_block();
+    state = NULL;
+
+    block_item_t close_item = { 0 };
+    if (writer_queue) {
+        xQueueSend(writer_queue, &close_item, portMAX_DELAY);
+    }
+    ESP_LOGI(TAG, "Track closed, %lu of %lu fixes kept",
+             (unsigned long)stats.kept, (unsigned long)stats.fixes);
+
+    free(s);
+    mem_monitor_account(MEM_SUB_LOGGER, -state_mem_bytes);
+    state_mem_bytes = 0;
+}
+
+void track_log_get_stats(track_log_stats_t *out)
+{
+    *out = stats;
+}
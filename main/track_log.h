@@ -0,0 +1,95 @@
+/**
+ * @file track_log.h
+ * @brief The wardrive route itself, simplified while it is recorded
+ *
+ * CAP GPS fixes arrive at the receiver rate (5-10 Hz). Most of them lie on
+ * a straight line between their neighbours and add nothing to a coverage
+ * map, so they are thinned online before anything is stored: a fix is
+ * kept only where the route bends away from the straight line from the
+ * last kept point by more than TRACK_LOG_TOLERANCE_M (a streaming form of
+ * Douglas-Peucker). The fixes since the last kept point are held in a
+ * window of TRACK_LOG_WINDOW; when it fills, every other one is dropped,
+ * so memory stays fixed and a long straight or a stop costs nothing. A
+ * point is kept at least every TRACK_LOG_MAX_GAP_S so times along the
+ * route stay usable, and at the ends of every stretch with a fix.
+ *
+ * File /sdcard/wardrive/trk_N.mtk (little-endian, varints as in
+ * wardrive_log.h):
+ *
+ *   header  "MTK1", u8 version
+ *   block   u8 0xB2, u16 points, u32 payload_len, payload
+ *
+ * Payload:
+ *
+ *   varint     Unix seconds the block's times count from
+ *   columns    points values each:
+ *     time     svarint delta, milliseconds (first from the block base)
+ *     lat, lon svarint delta, degrees x 1e7 (first from 0)
+ *     alt      svarint delta, decimetres
+ *     hdop     varint, x 100
+ *     flags    u8, TRACK_LOG_FLAG_*
+ *
+ * Kept points are buffered and written a block at a time by a writer
+ * task, at the latest TRACK_LOG_FLUSH_S after the block's first point.
+ * Fixes without a UTC date yet are skipped. obs_export turns a track into
+ * GPX.
+ */
+
+#ifndef TRACK_LOG_H
+#define TRACK_LOG_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "cap_gps.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef CONFIG_TRACK_LOG_TOLERANCE_M
+#define TRACK_LOG_TOLERANCE_M       CONFIG_TRACK_LOG_TOLERANCE_M
+#else
+#define TRACK_LOG_TOLERANCE_M       3
+#endif
+
+#define TRACK_LOG_WINDOW            32      // Fixes held since the last kept point
+#define TRACK_LOG_MAX_GAP_S         60      // Keep a point at least this often
+#define TRACK_LOG_BLOCK_POINTS      256
+#define TRACK_LOG_FLUSH_S           60      // Longest a kept point waits in RAM
+
+// File layout, for readers (obs_export)
+#define TRACK_LOG_MAGIC             "MTK1"
+#define TRACK_LOG_VERSION           1
+#define TRACK_LOG_HEADER_SIZE       5
+#define TRACK_LOG_BLOCK_MARKER      0xB2
+#define TRACK_LOG_BLOCK_HEADER      7
+#define TRACK_LOG_EXT               ".mtk"
+
+#define TRACK_LOG_FLAG_SEGMENT      0x01    // First point after a gap in the fix
+
+typedef struct {
+    uint32_t fixes;                 // Fixes offered
+    uint32_t kept;                  // Points stored
+} track_log_stats_t;
+
+/**
+ * @brief Open the next trk_N.mtk in WARDRIVE_LOG_DIR
+ * @return ESP_OK, ESP_ERR_INVALID_STATE without SD card or if already open
+ */
+esp_err_t track_log_open(void);
+
+/**
+ * @brief Offer a CAP GPS fix (from the fix callback only)
+ *
+ * A fix-lost report (fix->fix false) closes the current stretch.
+ */
+void track_log_add_fix(const cap_gps_fix_t *fix);
+
+/**
+ * @brief Keep the pending end point, write buffered points and close the file
+ *
+ * Call once no more fixes can arrive (after cap_gps_deinit).
+ */
+void track_log_close(void);
+
+void track_log_get_stats(track_log_stats_t *out);
+
+#endif // TRACK_LOG_H
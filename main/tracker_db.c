@@ -0,0 +1,500 @@
+/**
+ * @file tracker_db.c
+ * @brief Sighting database for BLE trackers, persisted on SD
+ *
+ * Records are staged under db_mutex; a full stage, or tracker_db_sync(),
+ * hands them to a writer task as one block, so neither the UART task nor
+ * the screen tick waits for the card.
+ */
+
+#include "tracker_db.h"
+#include "mem_monitor.h"
+#include "mac_set.h"
+#include "fixed_containers.h"
+#include "screenshot.h"
+#include "sd_io.h"
+#include "task_plan.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/stat.h>
+
+static const char *TAG = "TRACKER_DB";
+
+#ifdef CONFIG_SPIRAM
+#define DB_CAPS         (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define DB_CAPS         (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+#define DB_VERSION      1
+#define HEADER_LEN      5
+#define RECORD_LEN      22
+#define QUEUE_RECORDS   128
+#define WRITER_DEPTH    4       // Blocks waiting for the card
+#define SYNC_IDLE_MS    2000    // Commit after this long without records
+
+// Entry plus logging state that does not go to readers
+typedef struct {
+    tracker_entry_t e;
+    uint32_t logged_ms;         // Uptime of the last queued record
+    uint16_t unlogged;          // Sightings not yet in a record
+} db_entry_t;
+
+// Held while the AirTag scan screen has the database open
+MEM_BUDGET(tracker_db, TRACKER_DB_MAX, sizeof(db_entry_t), MEM_BUDGET_SCREEN);
+
+static db_entry_t *entries = NULL;
+static mac_set_t index_set;             // Packed MAC -> entries[] index
+static SemaphoreHandle_t db_mutex = NULL;
+static volatile uint32_t generation = 0;
+static uint32_t dropped = 0;
+
+// Queue item: records to append, or NULL to close the log
+typedef struct {
+    uint8_t *data;
+    size_t len;
+} block_item_t;
+
+typedef struct {
+    sd_file_t *file;
+    QueueHandle_t queue;
+} writer_t;
+
+static QueueHandle_t writer_queue = NULL;       // Set while the log is open
+static SemaphoreHandle_t writer_idle = NULL;    // Given while no writer task runs
+static size_t log_bytes = 0;            // Whole records on SD, kept when appending again
+static bool replayed = false;           // Log history is in the index
+static uint8_t queue[QUEUE_RECORDS][RECORD_LEN];
+static int queued = 0;
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xFF;
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief Approximate ground distance in metres (equirectangular, fine at city scale)
+ */
+static float distance_m(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2)
+{
+    float mid_lat = (float)(lat1 / 2 + lat2 / 2) * 1e-7f * (float)M_PI / 180.0f;
+    float dy = (float)(lat2 - lat1);
+    float dx = (float)(lon2 - lon1) * cosf(mid_lat);
+    return sqrtf(dx * dx + dy * dy) * 0.011132f;    // 1e-7 deg = 1.1132 cm
+}
+
+/**
+ * @brief Fold a sighting (or a replayed record worth count sightings) into an entry
+ * @return true if the sighting started a new place
+ */
+static bool apply(tracker_entry_t *e, bool is_new, int8_t rssi, const tracker_where_t *w,
+                  uint32_t count)
+{
+    bool new_place = false;
+
+    if (is_new) {
+        e->first_utc = w->utc;
+    } else if (e->first_utc == 0) {
+        e->first_utc = w->utc;
+    }
+    if (w->utc) e->last_utc = w->utc;
+    e->rssi = rssi;
+    e->sightings += count;
+
+    if (w->has_position) {
+        if (!(e->flags & TRACKER_FLAG_POSITION)) {
+            e->flags |= TRACKER_FLAG_POSITION;
+            e->first_lat_e7 = e->place_lat_e7 = w->lat_e7;
+            e->first_lon_e7 = e->place_lon_e7 = w->lon_e7;
+            e->places = 1;
+            new_place = true;
+        } else if (distance_m(e->place_lat_e7, e->place_lon_e7,
+                              w->lat_e7, w->lon_e7) >= TRACKER_PLACE_M) {
+            e->place_lat_e7 = w->lat_e7;
+            e->place_lon_e7 = w->lon_e7;
+            if (e->places < UINT16_MAX) e->places++;
+            new_place = true;
+        }
+        e->last_lat_e7 = w->lat_e7;
+        e->last_lon_e7 = w->lon_e7;
+    }
+    return new_place;
+}
+
+static void writer_task(void *arg)
+{
+    writer_t *w = arg;
+    sd_file_t *f = w->file;
+    block_item_t item;
+    bool unsynced = false;
+
+    while (1) {
+        if (xQueueReceive(w->queue, &item, pdMS_TO_TICKS(SYNC_IDLE_MS)) != pdTRUE) {
+            // Quiet spell: commit the partial chunk
+            if (f && unsynced && sd_io_sync(f) == ESP_OK) log_bytes = sd_io_size(f);
+            unsynced = false;
+            continue;
+        }
+        if (!item.data) break;
+        if (f && sd_io_write(f, item.data, item.len) != ESP_OK) {
+            ESP_LOGE(TAG, "Write to %s failed, sightings kept in RAM only", TRACKER_DB_FILE);
+            sd_io_close(f);
+            f = NULL;
+        }
+        unsynced = true;
+        mem_free(MEM_SUB_LOGGER, item.data);
+    }
+
+    if (f) {
+        size_t size = sd_io_size(f);
+        if (sd_io_close(f) == ESP_OK) log_bytes = size;
+    }
+    vQueueDelete(w->queue);
+    free(w);
+    xSemaphoreGive(writer_idle);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Pass the staged records to the writer task (db_mutex held)
+ * @param wait_ms How long to wait for room in the writer queue
+ * @return false if they were dropped
+ */
+static bool hand_off(uint32_t wait_ms)
+{
+    if (queued == 0) return true;
+
+    size_t len = (size_t)queued * RECORD_LEN;
+    uint8_t *buf = writer_queue ? mem_malloc(MEM_SUB_LOGGER, len) : NULL;
+    block_item_t item = { .data = buf, .len = len };
+    if (buf) memcpy(buf, queue, len);
+    if (!buf || xQueueSend(writer_queue, &item, pdMS_TO_TICKS(wait_ms)) != pdTRUE) {
+        mem_free(MEM_SUB_LOGGER, buf);
+        dropped += queued;
+        queued = 0;
+        return false;
+    }
+    queued = 0;
+    return true;
+}
+
+/**
+ * @brief Start the writer task on an open log file (db_mutex held)
+ */
+static void start_writer(sd_file_t *f)
+{
+    writer_t *w = calloc(1, sizeof(writer_t));
+    QueueHandle_t q = xQueueCreate(WRITER_DEPTH, sizeof(block_item_t));
+    if (w) {
+        w->file = f;
+        w->queue = q;
+    }
+    if (!w || !q ||
+        xTaskCreatePinnedToCore(writer_task, "tracker_db", TASK_TRACKER_DB_STACK, w,
+                                TASK_LOG_WRITER_PRIO, NULL, TASK_LOG_WRITER_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "No writer task, sightings kept in RAM only");
+        if (q) vQueueDelete(q);
+        free(w);
+        sd_io_close(f);
+        xSemaphoreGive(writer_idle);
+        return;
+    }
+    writer_queue = q;
+}
+
+/**
+ * @brief Queue a record carrying an entry's unlogged sightings (db_mutex held)
+ */
+static void queue_record(db_entry_t *d, const tracker_where_t *w)
+{
+    if (!writer_queue || d->unlogged == 0) return;
+    if (queued >= QUEUE_RECORDS && !hand_off(0)) return;
+
+    uint8_t *r = queue[queued++];
+    memcpy(r, d->e.mac, 6);
+    r[6] = (uint8_t)d->e.rssi;
+    r[7] = w->has_position ? TRACKER_FLAG_POSITION : 0;
+    put_u32(r + 8, w->utc);
+    put_u32(r + 12, (uint32_t)w->lat_e7);
+    put_u32(r + 16, (uint32_t)w->lon_e7);
+    put_u16(r + 20, d->unlogged);
+
+    d->unlogged = 0;
+    d->logged_ms = now_ms();
+}
+
+static uint64_t key_from_bytes(const uint8_t mac[6])
+{
+    uint64_t key = 0;
+    for (int i = 0; i < 6; i++) key = (key << 8) | mac[i];
+    return key;
+}
+
+/**
+ * @brief Rebuild the index from the log
+ * @return Bytes of whole records to keep, 0 to start a new log
+ */
+static size_t replay_log(void)
+{
+    struct stat st;
+    if (stat(TRACKER_DB_DIR, &st) != 0) {
+        mkdir(TRACKER_DB_DIR, 0755);
+    }
+
+    uint32_t records = 0;
+    size_t keep = 0;
+    FILE *f = fopen(TRACKER_DB_FILE, "rb");
+    if (f) {
+        uint8_t header[HEADER_LEN];
+        if (fread(header, 1, HEADER_LEN, f) == HEADER_LEN &&
+            memcmp(header, "TDB1", 4) == 0 && header[4] == DB_VERSION) {
+            uint8_t r[RECORD_LEN];
+            while (fread(r, 1, RECORD_LEN, f) == RECORD_LEN) {
+                bool is_new;
+                int index = mac_set_add(&index_set, key_from_bytes(r), &is_new);
+                if (index < 0) continue;
+                db_entry_t *d = &entries[index];
+                if (is_new) {
+                    memset(d, 0, sizeof(*d));
+                    memcpy(d->e.mac, r, 6);
+                }
+                tracker_where_t w = {
+                    .has_position = (r[7] & TRACKER_FLAG_POSITION) != 0,
+                    .utc = get_u32(r + 8),
+                    .lat_e7 = (int32_t)get_u32(r + 12),
+                    .lon_e7 = (int32_t)get_u32(r + 16),
+                };
+                apply(&d->e, is_new, (int8_t)r[6], &w, get_u16(r + 20));
+                records++;
+            }
+            // A torn last record is cut off when appending resumes
+            keep = HEADER_LEN + (size_t)records * RECORD_LEN;
+        } else {
+            ESP_LOGW(TAG, "%s has an unknown format, starting over", TRACKER_DB_FILE);
+        }
+        fclose(f);
+    }
+
+    ESP_LOGI(TAG, "Replayed %lu records, %d devices",
+             (unsigned long)records, index_set.count);
+    return keep;
+}
+
+/**
+ * @brief Open the log for appending after keep bytes, or start a new one
+ */
+static sd_file_t *open_log(size_t keep)
+{
+    if (keep > 0) {
+        sd_file_t *f = sd_io_resume(TRACKER_DB_FILE, keep);
+        if (f && sd_io_size(f) >= HEADER_LEN) return f;
+        if (f) sd_io_close(f);
+    }
+
+    sd_file_t *f = sd_io_open(TRACKER_DB_FILE, 0);
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open %s", TRACKER_DB_FILE);
+        return NULL;
+    }
+    const uint8_t header[HEADER_LEN] = { 'T', 'D', 'B', '1', DB_VERSION };
+    if (sd_io_write(f, header, HEADER_LEN) != ESP_OK || sd_io_sync(f) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write %s", TRACKER_DB_FILE);
+        sd_io_close(f);
+        return NULL;
+    }
+    return f;
+}
+
+esp_err_t tracker_db_open(void)
+{
+    if (!db_mutex) {
+        db_mutex = xSemaphoreCreateMutex();
+        if (!db_mutex) return ESP_ERR_NO_MEM;
+    }
+    if (!writer_idle) {
+        writer_idle = xSemaphoreCreateBinary();
+        if (!writer_idle) return ESP_ERR_NO_MEM;
+        xSemaphoreGive(writer_idle);
+    }
+
+    if (!entries) {
+        db_entry_t *e = heap_caps_calloc(TRACKER_DB_MAX, sizeof(db_entry_t), DB_CAPS);
+        if (!e) e = calloc(TRACKER_DB_MAX, sizeof(db_entry_t));
+        if (!e || mac_set_init(&index_set, TRACKER_DB_MAX) != ESP_OK) {
+            ESP_LOGE(TAG, "No memory for %d devices", TRACKER_DB_MAX);
+            free(e);
+            return ESP_ERR_NO_MEM;
+        }
+        entries = e;
+    }
+
+    if (writer_queue) return ESP_OK;
+    if (!screenshot_is_available()) {
+        ESP_LOGW(TAG, "SD card not mounted, sightings kept in RAM only");
+        return ESP_OK;
+    }
+
+    // The writer of the last session may still be finishing its file
+    xSemaphoreTake(writer_idle, portMAX_DELAY);
+    xSemaphoreTake(db_mutex, portMAX_DELAY);
+    if (!replayed) {
+        log_bytes = replay_log();
+        replayed = true;
+    }
+    queued = 0;
+    sd_file_t *f = open_log(log_bytes);
+    if (f) {
+        start_writer(f);
+    } else {
+        xSemaphoreGive(writer_idle);
+    }
+    generation++;
+    xSemaphoreGive(db_mutex);
+    return ESP_OK;
+}
+
+void tracker_db_close(void)
+{
+    if (!entries) return;
+
+    // Every pending count is queued; a full stage waits for the writer
+    // rather than dropping, so the log gets all of them
+    xSemaphoreTake(db_mutex, portMAX_DELAY);
+    for (int i = 0; i < index_set.count && writer_queue; i++) {
+        db_entry_t *d = &entries[i];
+        tracker_where_t w = {
+            .has_position = (d->e.flags & TRACKER_FLAG_POSITION) != 0,
+            .lat_e7 = d->e.last_lat_e7,
+            .lon_e7 = d->e.last_lon_e7,
+            .utc = d->e.last_utc,
+        };
+        if (d->unlogged && queued >= QUEUE_RECORDS) hand_off(portMAX_DELAY);
+        queue_record(d, &w);
+    }
+    if (writer_queue) {
+        hand_off(portMAX_DELAY);
+        block_item_t close_item = { 0 };
+        xQueueSend(writer_queue, &close_item, portMAX_DELAY);
+        writer_queue = NULL;
+    }
+    xSemaphoreGive(db_mutex);
+}
+
+int tracker_db_add(const uint8_t mac[6], int8_t rssi, const tracker_where_t *where)
+{
+    if (!entries || !mac || !where) return -1;
+
+    xSemaphoreTake(db_mutex, portMAX_DELAY);
+
+    bool is_new;
+    int index = mac_set_add(&index_set, key_from_bytes(mac), &is_new);
+    if (index < 0) {
+        xSemaphoreGive(db_mutex);
+        return -1;
+    }
+    db_entry_t *d = &entries[index];
+    if (is_new) {
+        memset(d, 0, sizeof(*d));
+        memcpy(d->e.mac, mac, 6);
+    }
+
+    bool new_place = apply(&d->e, is_new, rssi, where, 1);
+    if (d->unlogged < UINT16_MAX) d->unlogged++;
+    if (is_new || new_place || now_ms() - d->logged_ms >= TRACKER_LOG_INTERVAL_MS) {
+        queue_record(d, where);
+    }
+    generation++;
+
+    xSemaphoreGive(db_mutex);
+    return index;
+}
+
+void tracker_db_sync(void)
+{
+    if (!db_mutex) return;
+
+    xSemaphoreTake(db_mutex, portMAX_DELAY);
+    if (writer_queue) hand_off(0);
+    xSemaphoreGive(db_mutex);
+}
+
+int tracker_db_count(void)
+{
+    return entries ? index_set.count : 0;
+}
+
+bool tracker_db_get(int index, tracker_entry_t *out)
+{
+    if (!entries || index < 0 || index >= index_set.count) return false;
+    xSemaphoreTake(db_mutex, portMAX_DELAY);
+    *out = entries[index].e;
+    xSemaphoreGive(db_mutex);
+    return true;
+}
+
+// Followers are sorted under db_mutex
+static int compare_followers(int ia, int ib, void *ctx)
+{
+    (void)ctx;
+    const tracker_entry_t *a = &entries[ia].e;
+    const tracker_entry_t *b = &entries[ib].e;
+    if (a->places != b->places) return b->places - a->places;
+    int r = (b->last_utc > a->last_utc) - (b->last_utc < a->last_utc);
+    return r ? r : ia - ib;
+}
+
+int tracker_db_followers(uint16_t *order, int max)
+{
+    if (!entries || !order) return 0;
+
+    xSemaphoreTake(db_mutex, portMAX_DELAY);
+    int n = 0;
+    for (int i = 0; i < index_set.count && n < max; i++) {
+        if (entries[i].e.places >= TRACKER_FOLLOW_PLACES) {
+            order[n++] = (uint16_t)i;
+        }
+    }
+    fixed_index_sort(order, n, compare_followers, NULL);
+    xSemaphoreGive(db_mutex);
+    return n;
+}
+
+uint32_t tracker_db_generation(void)
+{
+    return generation;
+}
+
+uint32_t tracker_db_dropped(void)
+{
+    return dropped;
+}
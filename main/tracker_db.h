@@ -0,0 +1,126 @@
+/**
+ * @file tracker_db.h
+ * @brief Sighting database for BLE trackers, persisted on SD
+ *
+ * Every BLE device seen during an AirTag scan gets an entry keyed by MAC
+ * with first/last seen time, first/last position and a sighting count.
+ * A device also counts "places": a sighting with a position at least
+ * TRACKER_PLACE_M away from the previous place starts a new one. Seen at
+ * TRACKER_FOLLOW_PLACES or more places means it has been travelling with
+ * us, which is what tracker_db_followers() lists.
+ *
+ * The RAM index is rebuilt at open by replaying an append-only log
+ * (TRACKER_DB_FILE, little-endian):
+ *
+ *   header  "TDB1", u8 version
+ *   record  6 bytes MAC, i8 rssi, u8 flags, u32 utc, i32 lat_e7, i32 lon_e7,
+ *           u16 sightings since the previous record of that MAC
+ *
+ * Records are queued by tracker_db_add() and appended by a writer task,
+ * which gets them whenever the queue fills and on tracker_db_sync(), so
+ * neither the UART task nor the UI waits for SD. A MAC is logged when
+ * first seen, when it reaches a new place and otherwise at most every
+ * TRACKER_LOG_INTERVAL_MS. Without SD the database works from RAM only.
+ */
+
+#ifndef TRACKER_DB_H
+#define TRACKER_DB_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TRACKER_DB_DIR          "/sdcard/trackers"
+#define TRACKER_DB_FILE         TRACKER_DB_DIR "/sightings.tdb"
+// Devices indexed (least recent evicted)
+#ifdef CONFIG_TRACKER_DB_MAX_DEVICES
+#define TRACKER_DB_MAX          CONFIG_TRACKER_DB_MAX_DEVICES
+#else
+#define TRACKER_DB_MAX          1024
+#endif
+#define TRACKER_PLACE_M         300     // Distance that makes a new place
+#define TRACKER_FOLLOW_PLACES   3       // Places before a device counts as following
+#define TRACKER_LOG_INTERVAL_MS 300000  // Re-log a stationary device every 5 min
+
+#define TRACKER_FLAG_POSITION   0x01    // Record / entry has a GPS position
+
+// One device
+typedef struct {
+    uint8_t mac[6];
+    int8_t rssi;                // Latest reading
+    uint8_t flags;              // TRACKER_FLAG_POSITION once any sighting had one
+    uint32_t first_utc;         // Unix seconds, 0 if seen without a clock
+    uint32_t last_utc;
+    int32_t first_lat_e7;
+    int32_t first_lon_e7;
+    int32_t last_lat_e7;
+    int32_t last_lon_e7;
+    int32_t place_lat_e7;       // Where the current place started
+    int32_t place_lon_e7;
+    uint32_t sightings;
+    uint16_t places;
+} tracker_entry_t;
+
+// Position and time of a sighting (both optional)
+typedef struct {
+    bool has_position;
+    int32_t lat_e7;
+    int32_t lon_e7;
+    uint32_t utc;               // 0 if unknown
+} tracker_where_t;
+
+/**
+ * @brief Allocate the index and replay the SD log (safe to call again)
+ * @return ESP_OK (also without SD), ESP_ERR_NO_MEM
+ */
+esp_err_t tracker_db_open(void);
+
+/**
+ * @brief Queue pending counts, hand everything to the writer and close the log
+ *
+ * Waits for room in the writer queue instead of dropping records, but
+ * not for the card. The RAM index stays; the next tracker_db_open()
+ * appends again.
+ */
+void tracker_db_close(void);
+
+/**
+ * @brief Record one sighting
+ * @return Entry index, -1 if the database is not open
+ */
+int tracker_db_add(const uint8_t mac[6], int8_t rssi, const tracker_where_t *where);
+
+/**
+ * @brief Hand queued records to the writer task (never blocks on SD)
+ */
+void tracker_db_sync(void);
+
+/**
+ * @brief Devices in the database (indices 0 .. count - 1)
+ */
+int tracker_db_count(void);
+
+/**
+ * @brief Copy an entry
+ * @return false if index is out of range
+ */
+bool tracker_db_get(int index, tracker_entry_t *out);
+
+/**
+ * @brief Devices seen at TRACKER_FOLLOW_PLACES or more places, most places first
+ * @return Number of indices written to order
+ */
+int tracker_db_followers(uint16_t *order, int max);
+
+/**
+ * @brief Bumps on every change; poll to redraw only when needed
+ */
+uint32_t tracker_db_generation(void);
+
+/**
+ * @brief Records dropped because the writer was behind or out of memory
+ */
+uint32_t tracker_db_dropped(void);
+
+#endif // TRACKER_DB_H
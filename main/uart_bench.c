@@ -0,0 +1,319 @@
+/**
+ * @file uart_bench.c
+ * @brief Round-trip and throughput benchmark of the primary JanOS link
+ */
+
+#include "uart_bench.h"
+#include "uart_handler.h"
+#include "task_plan.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "UART_BENCH";
+
+// Candidate rates: the handshake rate, then the negotiation ladder
+static const uint32_t ladder[] = UART_BAUD_LADDER;
+#define RATE_COUNT      (1 + (int)(sizeof(ladder) / sizeof(ladder[0])))
+
+#ifdef CONFIG_UART_BINARY_PROTOCOL
+#define MODE_COUNT      2           // Text, then binary framing
+#else
+#define MODE_COUNT      1
+#endif
+
+typedef enum {
+    PHASE_IDLE = 0,             // Pongs of the baud handshake are not ours
+    PHASE_RTT,
+    PHASE_BURST,
+} bench_phase_t;
+
+// Echo bookkeeping shared with the RX task
+typedef struct {
+    bench_phase_t phase;
+    uint32_t awaited_seq;       // PHASE_RTT: the one ping in flight
+    int64_t echo_us;            // PHASE_RTT: arrival of its echo
+    uint16_t echoed;
+    uint16_t corrupt;
+    bool payload_echoed;
+    uint32_t rx_bytes;          // Echo bytes after the first echo
+    int64_t first_rx_us;
+    int64_t last_rx_us;
+} echo_state_t;
+
+static echo_state_t echo;
+static portMUX_TYPE echo_lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t echo_done = NULL;
+
+static uart_bench_result_t results[UART_BENCH_MAX_RESULTS];
+static uart_bench_status_t status;
+static int result_count;
+static volatile bool stop_requested;
+static portMUX_TYPE results_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Payload of ping seq: "B<seq>:" then letters that vary with both
+ */
+static void make_payload(uint32_t seq, char *out)
+{
+    int n = snprintf(out, UART_BENCH_PAYLOAD + 1, "B%lu:", (unsigned long)seq);
+    for (int i = n; i < UART_BENCH_PAYLOAD; i++) {
+        out[i] = 'a' + (seq + i) % 26;
+    }
+    out[UART_BENCH_PAYLOAD] = '\0';
+}
+
+/**
+ * @brief RX task: account one "pong" line
+ */
+static void pong_callback(const char *line, void *user_data)
+{
+    (void)user_data;
+    int64_t now_us = uart_line_time_us();
+
+    // Bare "pong", or "pong " plus the payload
+    bool bare = strcmp(line, "pong") == 0;
+    bool intact = false;
+    uint32_t seq = 0;
+    if (!bare) {
+        if (strncmp(line, "pong B", 6) != 0) return;
+        char expected[UART_BENCH_PAYLOAD + 1];
+        seq = strtoul(line + 6, NULL, 10);
+        make_payload(seq, expected);
+        intact = strcmp(line + 5, expected) == 0;
+    }
+
+    bool wake = false;
+    portENTER_CRITICAL(&echo_lock);
+    if (echo.phase == PHASE_RTT) {
+        if (bare || seq == echo.awaited_seq) {
+            echo.echo_us = now_us;
+            echo.echoed++;
+            if (!bare && !intact) echo.corrupt++;
+            wake = true;
+        }
+    } else if (echo.phase == PHASE_BURST) {
+        if (echo.echoed == 0) {
+            echo.first_rx_us = now_us;
+        } else {
+            echo.rx_bytes += strlen(line) + 1;
+        }
+        echo.last_rx_us = now_us;
+        echo.echoed++;
+        if (!bare && !intact) echo.corrupt++;
+        wake = echo.echoed == UART_BENCH_BURST;
+    }
+    if (intact) echo.payload_echoed = true;
+    portEXIT_CRITICAL(&echo_lock);
+
+    if (wake) xSemaphoreGive(echo_done);
+}
+
+static void set_phase(bench_phase_t phase, uint32_t awaited_seq)
+{
+    portENTER_CRITICAL(&echo_lock);
+    echo.phase = phase;
+    echo.awaited_seq = awaited_seq;
+    echo.echoed = 0;
+    echo.corrupt = 0;
+    echo.rx_bytes = 0;
+    portEXIT_CRITICAL(&echo_lock);
+}
+
+static esp_err_t send_ping(uint32_t seq)
+{
+    char cmd[8 + UART_BENCH_PAYLOAD];
+    char payload[UART_BENCH_PAYLOAD + 1];
+    make_payload(seq, payload);
+    snprintf(cmd, sizeof(cmd), "ping %s", payload);
+    return uart_link_send_command(UART_LINK_PRIMARY, cmd);
+}
+
+static void measure_rtt(uart_bench_result_t *r, uint32_t *seq)
+{
+    uint64_t total_us = 0;
+    int answered = 0;
+
+    for (int i = 0; i < UART_BENCH_RTT_PINGS; i++) {
+        uint32_t s = (*seq)++;
+        xSemaphoreTake(echo_done, 0);
+        set_phase(PHASE_RTT, s);
+        int64_t sent_us = esp_timer_get_time();
+        send_ping(s);
+        r->sent++;
+
+        bool got = xSemaphoreTake(echo_done, pdMS_TO_TICKS(UART_BENCH_RTT_MS)) == pdTRUE;
+        portENTER_CRITICAL(&echo_lock);
+        int64_t echo_us = echo.echo_us;
+        uint16_t corrupt = echo.corrupt;
+        echo.phase = PHASE_IDLE;
+        portEXIT_CRITICAL(&echo_lock);
+
+        r->corrupt += corrupt;
+        if (!got) {
+            r->lost++;
+            continue;
+        }
+        uint32_t rtt = echo_us > sent_us ? (uint32_t)(echo_us - sent_us) : 0;
+        int bucket = 0;
+        while (bucket < UART_BENCH_RTT_BUCKETS - 1 && rtt >= (UART_BENCH_RTT_BASE_US << bucket)) {
+            bucket++;
+        }
+        r->rtt_hist[bucket]++;
+        if (answered == 0 || rtt < r->rtt_min_us) r->rtt_min_us = rtt;
+        if (rtt > r->rtt_max_us) r->rtt_max_us = rtt;
+        total_us += rtt;
+        answered++;
+    }
+    r->rtt_avg_us = answered ? (uint32_t)(total_us / answered) : 0;
+}
+
+static void measure_burst(uart_bench_result_t *r, uint32_t *seq)
+{
+    xSemaphoreTake(echo_done, 0);
+    set_phase(PHASE_BURST, 0);
+
+    // Each ping is "ping " + payload + newline
+    const uint32_t ping_bytes = 5 + UART_BENCH_PAYLOAD + 1;
+    int64_t start_us = esp_timer_get_time();
+    for (int i = 0; i < UART_BENCH_BURST; i++) {
+        send_ping((*seq)++);
+    }
+    uart_link_wait_tx_done(UART_LINK_PRIMARY, UART_BENCH_BURST_MS);
+    int64_t tx_us = esp_timer_get_time() - start_us;
+    r->sent += UART_BENCH_BURST;
+    r->tx_bytes_s = tx_us > 0 ? (uint32_t)((uint64_t)UART_BENCH_BURST * ping_bytes * 1000000 / tx_us) : 0;
+
+    xSemaphoreTake(echo_done, pdMS_TO_TICKS(UART_BENCH_BURST_MS));
+    portENTER_CRITICAL(&echo_lock);
+    echo.phase = PHASE_IDLE;
+    uint16_t echoed = echo.echoed;
+    uint32_t rx_bytes = echo.rx_bytes;
+    int64_t rx_us = echo.last_rx_us - echo.first_rx_us;
+    r->corrupt += echo.corrupt;
+    portEXIT_CRITICAL(&echo_lock);
+
+    r->lost += UART_BENCH_BURST - echoed;
+    r->rx_bytes_s = rx_us > 0 ? (uint32_t)((uint64_t)rx_bytes * 1000000 / rx_us) : 0;
+}
+
+static void publish(const uart_bench_result_t *r, int index)
+{
+    portENTER_CRITICAL(&results_lock);
+    results[index] = *r;
+    if (index >= result_count) result_count = index + 1;
+    status.step = index + 1;
+    portEXIT_CRITICAL(&results_lock);
+}
+
+static void bench_task(void *arg)
+{
+    (void)arg;
+    uint32_t orig_baud = uart_get_baud_rate();
+    bool orig_binary = uart_is_binary_mode();
+    int route = uart_subscribe_lines(UART_ROUTE_PREFIX, "pong", pong_callback, NULL);
+    uint32_t seq = 0;
+    int index = 0;
+
+    for (int m = 0; m < MODE_COUNT && route >= 0; m++) {
+        bool binary = m == 1;
+        bool mode_ok = uart_set_binary_mode(binary);
+
+        for (int b = 0; b < RATE_COUNT && index < UART_BENCH_MAX_RESULTS; b++) {
+            if (stop_requested) break;
+            uart_bench_result_t r = {
+                .baud = b == 0 ? UART_BAUD_RATE : ladder[b - 1],
+                .binary = binary,
+            };
+            r.reached = mode_ok && uart_set_link_baud(r.baud);
+            if (r.reached) {
+                portENTER_CRITICAL(&echo_lock);
+                echo.payload_echoed = false;
+                portEXIT_CRITICAL(&echo_lock);
+
+                measure_rtt(&r, &seq);
+                measure_burst(&r, &seq);
+                portENTER_CRITICAL(&echo_lock);
+                r.payload_echoed = echo.payload_echoed;
+                portEXIT_CRITICAL(&echo_lock);
+                ESP_LOGI(TAG, "%lu %s: rtt %lu/%lu/%lu us, tx %lu B/s, rx %lu B/s, "
+                         "lost %u corrupt %u of %u",
+                         (unsigned long)r.baud, binary ? "binary" : "text",
+                         (unsigned long)r.rtt_min_us, (unsigned long)r.rtt_avg_us,
+                         (unsigned long)r.rtt_max_us, (unsigned long)r.tx_bytes_s,
+                         (unsigned long)r.rx_bytes_s, r.lost, r.corrupt, r.sent);
+            }
+            publish(&r, index++);
+        }
+    }
+
+    uart_unsubscribe_lines(route);
+    uart_set_binary_mode(orig_binary);
+    uart_set_link_baud(orig_baud);
+
+    portENTER_CRITICAL(&results_lock);
+    status.running = false;
+    portEXIT_CRITICAL(&results_lock);
+    ESP_LOGI(TAG, "Benchmark done, link back at %lu baud", (unsigned long)uart_get_baud_rate());
+    vTaskDelete(NULL);
+}
+
+esp_err_t uart_bench_start(void)
+{
+    int steps = RATE_COUNT * MODE_COUNT;
+    if (!echo_done) {
+        echo_done = xSemaphoreCreateBinary();
+        if (!echo_done) return ESP_ERR_NO_MEM;
+    }
+
+    portENTER_CRITICAL(&results_lock);
+    bool busy = status.running;
+    if (!busy) {
+        status.running = true;
+        status.step = 0;
+        status.steps = steps < UART_BENCH_MAX_RESULTS ? steps : UART_BENCH_MAX_RESULTS;
+        result_count = 0;
+    }
+    portEXIT_CRITICAL(&results_lock);
+    if (busy) return ESP_ERR_INVALID_STATE;
+
+    stop_requested = false;
+    if (xTaskCreatePinnedToCore(bench_task, "uart_bench", TASK_UART_BENCH_STACK, NULL,
+                                TASK_UART_BENCH_PRIO, NULL, TASK_UART_BENCH_CORE) != pdPASS) {
+        portENTER_CRITICAL(&results_lock);
+        status.running = false;
+        portEXIT_CRITICAL(&results_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Benchmark started, %d settings", status.steps);
+    return ESP_OK;
+}
+
+void uart_bench_stop(void)
+{
+    stop_requested = true;
+}
+
+void uart_bench_get_status(uart_bench_status_t *out)
+{
+    if (!out) return;
+    portENTER_CRITICAL(&results_lock);
+    *out = status;
+    portEXIT_CRITICAL(&results_lock);
+}
+
+int uart_bench_results(uart_bench_result_t *out, int max)
+{
+    if (!out || max <= 0) return 0;
+    portENTER_CRITICAL(&results_lock);
+    int count = result_count < max ? result_count : max;
+    memcpy(out, results, count * sizeof(uart_bench_result_t));
+    portEXIT_CRITICAL(&results_lock);
+    return count;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file uart_bench.h
+ * @brief Round-trip and throughput benchmark of the primary JanOS link
+ *
+ * For every candidate baud rate (UART_BAUD_RATE and UART_BAUD_LADDER) in
+ * text and, with CONFIG_UART_BINARY_PROTOCOL, binary framing, the link is
+ * switched over with the usual handshake and measured with pings carrying
+ * a UART_BENCH_PAYLOAD-byte payload ("ping B<seq>:<pattern>"), which
+ * JanOS echoes after "pong ":
+ *
+ * - round trip: UART_BENCH_RTT_PINGS pings one at a time, from the send
+ *   to the arrival of the echo's last byte, kept as a histogram
+ * - throughput: UART_BENCH_BURST pings sent back to back; TX is the
+ *   burst's bytes over the time to drain them from the UART, RX the echo
+ *   bytes over the time between the first and the last echo
+ * - errors: pings not echoed in time, and echoes whose payload differs
+ *
+ * A JanOS build that answers a bare "pong" is still timed, but its RX
+ * figure only covers the short replies (payload_echoed stays false).
+ * The link returns to its previous rate and framing afterwards. Nothing
+ * else should talk to the board meanwhile.
+ */
+
+#ifndef UART_BENCH_H
+#define UART_BENCH_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define UART_BENCH_PAYLOAD      64      // Payload bytes per ping
+#define UART_BENCH_RTT_PINGS    32      // Sequential pings per setting
+#define UART_BENCH_BURST        64      // Back-to-back pings per setting
+#define UART_BENCH_RTT_MS       200     // Wait for one echo
+#define UART_BENCH_BURST_MS     2000    // Wait for the last echo of a burst
+#define UART_BENCH_MAX_RESULTS  8       // Baud rates x framing modes
+
+// Round trip histogram: bucket i counts RTTs below 500 us << i, the last
+// one everything from 32 ms
+#define UART_BENCH_RTT_BUCKETS  8
+#define UART_BENCH_RTT_BASE_US  500
+
+typedef struct {
+    uint32_t baud;
+    bool binary;
+    bool reached;                       // Link could be switched to this setting
+    bool payload_echoed;                // JanOS echoed the payload back
+    uint16_t rtt_hist[UART_BENCH_RTT_BUCKETS];
+    uint32_t rtt_min_us;
+    uint32_t rtt_avg_us;
+    uint32_t rtt_max_us;
+    uint32_t tx_bytes_s;                // Sustained throughput, Cardputer -> JanOS
+    uint32_t rx_bytes_s;                // JanOS -> Cardputer
+    uint16_t sent;                      // Pings sent (round trip and burst)
+    uint16_t lost;                      // Not echoed in time
+    uint16_t corrupt;                   // Echoed with a different payload
+} uart_bench_result_t;
+
+typedef struct {
+    bool running;
+    int step;                           // Settings done so far
+    int steps;                          // Settings planned
+} uart_bench_status_t;
+
+/**
+ * @brief Start the benchmark in its own task
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if one is running, ESP_ERR_NO_MEM
+ */
+esp_err_t uart_bench_start(void);
+
+/**
+ * @brief Ask a running benchmark to stop after the current setting
+ */
+void uart_bench_stop(void);
+
+/**
+ * @brief Progress of the current or last run
+ */
+void uart_bench_get_status(uart_bench_status_t *out);
+
+/**
+ * @brief Copy the results measured so far
+ * @return Results written
+ */
+int uart_bench_results(uart_bench_result_t *out, int max);
+
+#endif // UART_BENCH_H
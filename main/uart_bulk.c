@@ -0,0 +1,49 @@
+/**
+ * @file uart_bulk.c
+ * @brief Decoder for LZ4-compressed bulk text in binary mode
+ */
+
+#include "uart_bulk.h"
+#include "lz4_block.h"
+#include <string.h>
+
+void uart_bulk_reset(uart_bulk_decoder_t *dec)
+{
+    dec->synced = false;
+    dec->next_seq = 0;
+    dec->len = 0;
+}
+
+int uart_bulk_decode(uart_bulk_decoder_t *dec, const uint8_t *payload, size_t len,
+                     const uint8_t **out)
+{
+    if (len < 2) return -1;
+    uint8_t flags = payload[0];
+    uint8_t seq = payload[1];
+
+    if (flags & UART_BULK_FLAG_RESET) {
+        dec->synced = true;
+        dec->len = 0;
+    } else if (!dec->synced || seq != dec->next_seq) {
+        dec->synced = false;
+        return -1;
+    }
+    dec->next_seq = seq + 1;
+
+    // Keep one window of history in front of the new block
+    if (dec->len > UART_BULK_WINDOW) {
+        memmove(dec->buf, dec->buf + dec->len - UART_BULK_WINDOW, UART_BULK_WINDOW);
+        dec->len = UART_BULK_WINDOW;
+    }
+
+    // Matches may reach back into the history in front of the block
+    uint8_t *start = dec->buf + dec->len;
+    int n = lz4_block_decompress_prefix(payload + 2, len - 2, start, UART_BULK_BLOCK_MAX, dec->len);
+    if (n < 0) {
+        dec->synced = false;
+        return -1;
+    }
+    dec->len += (size_t)n;
+    *out = start;
+    return n;
+}
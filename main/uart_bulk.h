@@ -0,0 +1,62 @@
+/**
+ * @file uart_bulk.h
+ * @brief Decoder for LZ4-compressed bulk text in binary mode
+ *
+ * Listings and result dumps (show_sniffer_results, list_sd, list_dir,
+ * show_probes, show_pass, list_hosts_vendor) repeat MAC prefixes and
+ * vendor names on every line. With "proto lz4 <window>" acknowledged,
+ * JanOS may send such output as UART_FRAME_BULK frames instead of text:
+ *
+ *   u8 flags | u8 seq | LZ4 block
+ *
+ * The block is in the standard LZ4 block format (no frame header or
+ * checksum; the frame CRC covers it) and expands to at most
+ * UART_BULK_BLOCK_MAX bytes of ordinary text lines. Matches may reach
+ * back UART_BULK_WINDOW bytes into the text of earlier blocks of the
+ * same stream. A stream starts with UART_BULK_FLAG_RESET, which clears
+ * that history; seq counts blocks, so a lost frame is noticed and the
+ * rest of its stream dropped instead of expanded against the wrong
+ * history.
+ *
+ * Builds without the UART driver, like uart_frame.c.
+ */
+
+#ifndef UART_BULK_H
+#define UART_BULK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define UART_BULK_WINDOW        4096    // Farthest match offset
+#define UART_BULK_BLOCK_MAX     2048    // Expanded bytes per frame
+#define UART_BULK_FLAG_RESET    0x01    // First block of a stream
+
+#define UART_PROTO_LZ4_CMD      "proto lz4"     // + UART_BULK_WINDOW
+#define UART_PROTO_LZ4_ACK      "proto lz4 ok"
+
+typedef struct {
+    bool synced;                        // History matches what JanOS has
+    uint8_t next_seq;
+    size_t len;                         // History bytes in buf
+    uint8_t buf[UART_BULK_WINDOW + UART_BULK_BLOCK_MAX];
+} uart_bulk_decoder_t;
+
+/**
+ * @brief Forget the history; blocks are dropped until the next stream
+ */
+void uart_bulk_reset(uart_bulk_decoder_t *dec);
+
+/**
+ * @brief Expand one UART_FRAME_BULK payload
+ * @param dec Decoder
+ * @param payload Frame payload (flags, seq, block)
+ * @param len Payload length
+ * @param out Set to the expanded text, valid until the next call
+ * @return Expanded bytes, -1 for a malformed block or one from a stream
+ *         that lost a block
+ */
+int uart_bulk_decode(uart_bulk_decoder_t *dec, const uint8_t *payload, size_t len,
+                     const uint8_t **out);
+
+#endif // UART_BULK_H
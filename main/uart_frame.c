@@ -0,0 +1,308 @@
+/**
+ * @file uart_frame.c
+ * @brief Binary framed protocol encoder, decoder and record parsers
+ */
+
+#include "uart_frame.h"
+#include "janos_proto.h"
+#include <stdio.h>
+#include <string.h>
+
+// Decoder states
+enum {
+    ST_SYNC0 = 0,
+    ST_SYNC1,
+    ST_TYPE,
+    ST_LEN_LO,
+    ST_LEN_HI,
+    ST_PAYLOAD,
+    ST_CRC_LO,
+    ST_CRC_HI,
+};
+
+uint16_t uart_frame_crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+size_t uart_frame_encode(uint8_t type, const uint8_t *payload, uint16_t len,
+                         uint8_t *out, size_t out_size)
+{
+    if (len > UART_FRAME_MAX_PAYLOAD || out_size < (size_t)len + UART_FRAME_OVERHEAD) {
+        return 0;
+    }
+    out[0] = UART_FRAME_SYNC0;
+    out[1] = UART_FRAME_SYNC1;
+    out[2] = type;
+    out[3] = (uint8_t)(len & 0xFF);
+    out[4] = (uint8_t)(len >> 8);
+    if (len) memcpy(&out[5], payload, len);
+    uint16_t crc = uart_frame_crc16(0xFFFF, &out[2], (size_t)len + 3);
+    out[5 + len] = (uint8_t)(crc & 0xFF);
+    out[6 + len] = (uint8_t)(crc >> 8);
+    return (size_t)len + UART_FRAME_OVERHEAD;
+}
+
+void uart_frame_decoder_reset(uart_frame_decoder_t *dec)
+{
+    dec->state = ST_SYNC0;
+    dec->pos = 0;
+    dec->crc = 0xFFFF;
+    dec->rx_crc = 0;
+}
+
+bool uart_frame_decoder_busy(const uart_frame_decoder_t *dec)
+{
+    return dec->state != ST_SYNC0;
+}
+
+uart_frame_result_t uart_frame_decoder_feed(uart_frame_decoder_t *dec, uint8_t byte)
+{
+    switch (dec->state) {
+        case ST_SYNC0:
+            if (byte != UART_FRAME_SYNC0) return UART_FRAME_ERROR;
+            dec->state = ST_SYNC1;
+            return UART_FRAME_PENDING;
+
+        case ST_SYNC1:
+            if (byte != UART_FRAME_SYNC1) break;
+            dec->crc = 0xFFFF;
+            dec->state = ST_TYPE;
+            return UART_FRAME_PENDING;
+
+        case ST_TYPE:
+            dec->frame.type = byte;
+            dec->crc = uart_frame_crc16(dec->crc, &byte, 1);
+            dec->state = ST_LEN_LO;
+            return UART_FRAME_PENDING;
+
+        case ST_LEN_LO:
+            dec->frame.len = byte;
+            dec->crc = uart_frame_crc16(dec->crc, &byte, 1);
+            dec->state = ST_LEN_HI;
+            return UART_FRAME_PENDING;
+
+        case ST_LEN_HI:
+            dec->frame.len |= (uint16_t)byte << 8;
+            dec->crc = uart_frame_crc16(dec->crc, &byte, 1);
+            if (dec->frame.len > UART_FRAME_MAX_PAYLOAD) break;
+            dec->pos = 0;
+            dec->state = (dec->frame.len > 0) ? ST_PAYLOAD : ST_CRC_LO;
+            return UART_FRAME_PENDING;
+
+        case ST_PAYLOAD:
+            dec->frame.payload[dec->pos++] = byte;
+            if (dec->pos >= dec->frame.len) {
+                dec->crc = uart_frame_crc16(dec->crc, dec->frame.payload, dec->frame.len);
+                dec->state = ST_CRC_LO;
+            }
+            return UART_FRAME_PENDING;
+
+        case ST_CRC_LO:
+            dec->rx_crc = byte;
+            dec->state = ST_CRC_HI;
+            return UART_FRAME_PENDING;
+
+        case ST_CRC_HI:
+            dec->rx_crc |= (uint16_t)byte << 8;
+            if (dec->rx_crc != dec->crc) break;
+            dec->state = ST_SYNC0;
+            return UART_FRAME_READY;
+
+        default:
+            break;
+    }
+
+    uart_frame_decoder_reset(dec);
+    return UART_FRAME_ERROR;
+}
+
+// Bounds-checked little-endian payload reader
+typedef struct {
+    const uint8_t *p;
+    size_t left;
+    bool ok;
+} reader_t;
+
+static void reader_init(reader_t *r, const uart_frame_t *frame)
+{
+    r->p = frame->payload;
+    r->left = frame->len;
+    r->ok = true;
+}
+
+static const uint8_t *take(reader_t *r, size_t n)
+{
+    if (!r->ok || r->left < n) {
+        r->ok = false;
+        return NULL;
+    }
+    const uint8_t *at = r->p;
+    r->p += n;
+    r->left -= n;
+    return at;
+}
+
+static uint8_t read_u8(reader_t *r)
+{
+    const uint8_t *b = take(r, 1);
+    return b ? b[0] : 0;
+}
+
+static uint16_t read_u16(reader_t *r)
+{
+    const uint8_t *b = take(r, 2);
+    return b ? (uint16_t)(b[0] | (b[1] << 8)) : 0;
+}
+
+static void read_bytes(reader_t *r, uint8_t *dst, size_t n)
+{
+    const uint8_t *b = take(r, n);
+    if (b) memcpy(dst, b, n);
+}
+
+// Length-prefixed string, truncated to fit dst
+static void read_str(reader_t *r, char *dst, size_t dst_size)
+{
+    uint8_t len = read_u8(r);
+    const uint8_t *b = take(r, len);
+    size_t n = (len < dst_size - 1) ? len : dst_size - 1;
+    if (b) memcpy(dst, b, n);
+    dst[b ? n : 0] = '\0';
+}
+
+static bool check(const uart_frame_t *frame, uint8_t type)
+{
+    return frame && frame->type == type;
+}
+
+bool uart_frame_parse_scan_line(const char *line, wifi_network_t *network)
+{
+    // Spans into the line - no heap traffic per scan row
+    janos_scan_row_t row;
+    if (!janos_parse_scan_row(line, &row)) {
+        return false;
+    }
+
+    network->id = row.id;
+    csv_field_copy(&row.ssid, network->ssid, sizeof(network->ssid));
+    csv_field_copy(&row.bssid, network->bssid, sizeof(network->bssid));
+    network->channel = row.channel;
+    csv_field_copy(&row.security, network->security, sizeof(network->security));
+    network->rssi = row.rssi;
+    csv_field_copy(&row.band, network->band, sizeof(network->band));
+    network->selected = false;
+    return true;
+}
+
+bool uart_frame_parse_scan_result(const uart_frame_t *frame, wifi_network_t *network)
+{
+    if (!check(frame, UART_FRAME_SCAN_RESULT) || !network) return false;
+
+    static const char *band_names[] = { "2.4GHz", "5GHz", "6GHz" };
+    reader_t r;
+    reader_init(&r, frame);
+
+    uint8_t bssid[6] = {0};
+    memset(network, 0, sizeof(*network));
+    network->id = read_u16(&r);
+    read_bytes(&r, bssid, sizeof(bssid));
+    network->channel = read_u8(&r);
+    network->rssi = (int8_t)read_u8(&r);
+    uint8_t band = read_u8(&r);
+    read_str(&r, network->ssid, sizeof(network->ssid));
+    read_str(&r, network->security, sizeof(network->security));
+    if (!r.ok) return false;
+
+    snprintf(network->bssid, sizeof(network->bssid), "%02X:%02X:%02X:%02X:%02X:%02X",
+             bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5]);
+    if (band < sizeof(band_names) / sizeof(band_names[0])) {
+        snprintf(network->band, sizeof(network->band), "%s", band_names[band]);
+    }
+    network->selected = false;
+    return true;
+}
+
+bool uart_frame_parse_scan_done(const uart_frame_t *frame, int *count)
+{
+    if (!check(frame, UART_FRAME_SCAN_DONE) || !count) return false;
+
+    reader_t r;
+    reader_init(&r, frame);
+    *count = read_u16(&r);
+    return r.ok;
+}
+
+bool uart_frame_parse_sniffer(const uart_frame_t *frame, uart_sniffer_record_t *rec)
+{
+    if (!check(frame, UART_FRAME_SNIFFER_ENTRY) || !rec) return false;
+
+    reader_t r;
+    reader_init(&r, frame);
+    read_bytes(&r, rec->bssid, sizeof(rec->bssid));
+    rec->channel = read_u8(&r);
+    rec->rssi = (int8_t)read_u8(&r);
+    rec->client_count = read_u16(&r);
+    read_str(&r, rec->ssid, sizeof(rec->ssid));
+    return r.ok;
+}
+
+bool uart_frame_parse_bt_device(const uart_frame_t *frame, uart_bt_record_t *rec)
+{
+    if (!check(frame, UART_FRAME_BT_DEVICE) || !rec) return false;
+
+    reader_t r;
+    reader_init(&r, frame);
+    read_bytes(&r, rec->mac, sizeof(rec->mac));
+    rec->rssi = (int8_t)read_u8(&r);
+    read_str(&r, rec->name, sizeof(rec->name));
+    return r.ok;
+}
+
+bool uart_frame_parse_handshake(const uart_frame_t *frame, uart_handshake_record_t *rec)
+{
+    if (!check(frame, UART_FRAME_HANDSHAKE) || !rec) return false;
+
+    reader_t r;
+    reader_init(&r, frame);
+    read_bytes(&r, rec->bssid, sizeof(rec->bssid));
+    rec->channel = read_u8(&r);
+    read_str(&r, rec->ssid, sizeof(rec->ssid));
+    return r.ok;
+}
+
+bool uart_frame_parse_status(const uart_frame_t *frame, uart_status_record_t *rec)
+{
+    if (!check(frame, UART_FRAME_STATUS) || !rec) return false;
+
+    reader_t r;
+    reader_init(&r, frame);
+    rec->code = read_u8(&r);
+    read_str(&r, rec->text, sizeof(rec->text));
+    return r.ok;
+}
+
+bool uart_frame_parse_progress(const uart_frame_t *frame, uart_progress_record_t *rec)
+{
+    if (!check(frame, UART_FRAME_PROGRESS) || !rec) return false;
+
+    reader_t r;
+    reader_init(&r, frame);
+    rec->op = read_u8(&r);
+    rec->state = read_u8(&r);
+    rec->percent = read_u8(&r);
+    rec->done = read_u16(&r);
+    rec->total = read_u16(&r);
+    rec->skipped = read_u16(&r);
+    rec->failed = read_u16(&r);
+    read_str(&r, rec->text, sizeof(rec->text));
+    if (rec->op >= UART_OP_COUNT || rec->state > UART_PROGRESS_ERROR) return false;
+    if (rec->percent > 100) rec->percent = UART_PROGRESS_UNKNOWN;
+    return r.ok;
+}
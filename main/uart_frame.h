@@ -0,0 +1,257 @@
+/**
+ * @file uart_frame.h
+ * @brief Binary framed protocol between Cardputer and JanOS
+ *
+ * Optional alternative to the text line protocol, negotiated after the
+ * ping/pong handshake. Each frame is:
+ *
+ *   0xA5 0x5A | type (1) | length (2, LE) | payload | CRC-16 (2, LE)
+ *
+ * The CRC (CCITT, init 0xFFFF) covers type, length and payload. The sync
+ * bytes never appear at the start of a text line, so text output from
+ * JanOS (logs, prompts) keeps flowing on the same link.
+ */
+
+#ifndef UART_FRAME_H
+#define UART_FRAME_H
+
+#include "uart_handler.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define UART_FRAME_SYNC0            0xA5
+#define UART_FRAME_SYNC1            0x5A
+#define UART_FRAME_MAX_PAYLOAD      256
+#define UART_FRAME_OVERHEAD         7       // Sync, type, length and CRC
+
+// Record types
+typedef enum {
+    UART_FRAME_SCAN_RESULT    = 0x01,   // One network of a scan dump
+    UART_FRAME_SCAN_DONE      = 0x02,   // End of scan dump
+    UART_FRAME_SNIFFER_ENTRY  = 0x10,   // Sniffer AP/client summary
+    UART_FRAME_BT_DEVICE      = 0x20,   // BLE device seen
+    UART_FRAME_HANDSHAKE      = 0x30,   // Handshake captured
+    UART_FRAME_STATUS         = 0x40,   // Status event with short text
+    UART_FRAME_PROGRESS       = 0x41,   // Progress of a long operation
+    UART_FRAME_LOG            = 0x42,   // Log or echo line on a quiet link (text payload)
+    UART_FRAME_GPS_TRACK      = 0x50,   // Cardputer -> JanOS: batch of CAP fixes
+    UART_FRAME_SELECT_NETWORKS = 0x51,  // Cardputer -> JanOS: attack target ids
+    UART_FRAME_CREDIT         = 0x52,   // Cardputer -> JanOS: send limit
+    UART_FRAME_BULK           = 0x60,   // LZ4-compressed text lines (uart_bulk.h)
+    UART_FRAME_FILE_DATA      = 0x70,   // Either way: chunk of a file transfer (file_xfer.h)
+    UART_FRAME_FILE_ACK       = 0x71,   // Either way: receiver's position in a transfer
+    UART_FRAME_FILE_END       = 0x72,   // Either way: size and CRC-32 of the whole file
+} uart_frame_type_t;
+
+/*
+ * GPS track payload: u8 flags, u8 count, count x 22-byte points.
+ *
+ *   flags   bit 0: receiver has a fix (clear with count 0 = fix lost)
+ *   point   u32 utc_s (0 until the date is known), u16 utc_ms,
+ *           u16 age_ms (fix time to frame transmission, for receivers
+ *           without a UTC clock), i32 lat_e7, i32 lon_e7, i32 alt_dm,
+ *           u16 hdop_x100
+ *
+ * Points are in fix order, oldest first; consecutive frames do not
+ * overlap, so JanOS keeps its own short history to interpolate between.
+ */
+#define UART_GPS_TRACK_FIX          0x01
+#define UART_GPS_POINT_SIZE         22
+#define UART_GPS_TRACK_MAX_POINTS   ((UART_FRAME_MAX_PAYLOAD - 2) / UART_GPS_POINT_SIZE)
+
+/*
+ * Select networks payload: u8 count, count x (u16 first, u16 last) id
+ * ranges, inclusive and ascending. Replaces the whole selection, like
+ * select_networks; a selection needing more ranges goes as text.
+ */
+#define UART_SELECT_RANGE_SIZE      4
+#define UART_SELECT_MAX_RANGES      ((UART_FRAME_MAX_PAYLOAD - 1) / UART_SELECT_RANGE_SIZE)
+
+/*
+ * Credit payload: u32 limit, the number of bytes JanOS may have sent in
+ * total since it acknowledged "proto credit <window>" (which grants the
+ * first window). Limits are absolute, so a repeated frame grants nothing
+ * new and a lost one is made good by the next.
+ */
+#define UART_CREDIT_SIZE            4
+
+/*
+ * File transfer payloads, all starting with u8 id (the transfer they
+ * belong to):
+ *
+ *   data    u32 offset, 1 .. UART_FILE_CHUNK bytes of the file
+ *   ack     u32 next (every byte before it is stored), u8 status
+ *   end     u32 size, u32 crc (esp_rom_crc32_le(0, ...) of the whole file)
+ *
+ * The frame CRC is the per-chunk check: a damaged chunk is dropped by
+ * the decoder and shows up as a gap. Sequence rules are in file_xfer.h.
+ */
+#define UART_FILE_CHUNK             248
+#define UART_FILE_DATA_HEADER       5
+#define UART_FILE_ACK_SIZE          6
+#define UART_FILE_END_SIZE          9
+
+typedef enum {
+    UART_FILE_ACK_MORE = 0,         // Keep sending from next
+    UART_FILE_ACK_RESEND,           // Gap before a chunk: go back to next
+    UART_FILE_ACK_DONE,             // Whole file stored and its CRC matched
+    UART_FILE_ACK_FAILED,           // Transfer given up (either side may send it)
+} uart_file_ack_t;
+
+/*
+ * Progress payload: u8 op, u8 state, u8 percent (UART_PROGRESS_UNKNOWN if
+ * JanOS cannot tell), u16 done, u16 total (0 = unknown), u16 skipped,
+ * u16 failed, str text (short phase description, may be empty).
+ *
+ * The same record is produced on the Cardputer side for operations JanOS
+ * reports in text mode (see uart_progress.h), so screens never see the
+ * difference.
+ */
+typedef enum {
+    UART_OP_NONE = 0,
+    UART_OP_WIFI_SCAN,          // scan_networks; done = networks so far
+    UART_OP_WPASEC_UPLOAD,      // wpasec_upload; done/skipped/failed = uploaded/duplicate/failed
+    UART_OP_LIST_DIR,           // list_dir; done = rows so far
+    UART_OP_CHANNEL_TIME,       // channel_time reads; done/total = replies
+    UART_OP_COUNT
+} uart_op_t;
+
+typedef enum {
+    UART_PROGRESS_IDLE = 0,     // Never started
+    UART_PROGRESS_RUNNING,
+    UART_PROGRESS_DONE,
+    UART_PROGRESS_ERROR,
+} uart_progress_state_t;
+
+#define UART_PROGRESS_UNKNOWN       0xFF    // percent not known
+
+// Decoded frame (payload still raw)
+typedef struct uart_frame {
+    uint8_t type;
+    uint16_t len;
+    uint8_t payload[UART_FRAME_MAX_PAYLOAD];
+} uart_frame_t;
+
+// Decoder result for one input byte
+typedef enum {
+    UART_FRAME_PENDING = 0,     // Byte consumed, frame not complete yet
+    UART_FRAME_READY,           // Frame complete and CRC valid
+    UART_FRAME_ERROR,           // Bad sync, length or CRC - decoder reset
+} uart_frame_result_t;
+
+// Streaming decoder state
+typedef struct {
+    uint8_t state;
+    uint16_t pos;
+    uint16_t crc;
+    uint16_t rx_crc;
+    uart_frame_t frame;
+} uart_frame_decoder_t;
+
+// Typed records
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+    int8_t rssi;
+    uint16_t client_count;
+    char ssid[MAX_SSID_LEN];
+} uart_sniffer_record_t;
+
+typedef struct {
+    uint8_t mac[6];
+    int8_t rssi;
+    char name[32];
+} uart_bt_record_t;
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+    char ssid[MAX_SSID_LEN];
+} uart_handshake_record_t;
+
+typedef struct {
+    uint8_t code;
+    char text[64];
+} uart_status_record_t;
+
+typedef struct {
+    uint8_t op;                 // uart_op_t
+    uint8_t state;              // uart_progress_state_t
+    uint8_t percent;            // 0-100 or UART_PROGRESS_UNKNOWN
+    uint16_t done;
+    uint16_t total;
+    uint16_t skipped;
+    uint16_t failed;
+    char text[40];
+} uart_progress_record_t;
+
+/**
+ * @brief CRC-16/CCITT over a buffer
+ * @param crc Running CRC (0xFFFF to start)
+ * @param data Bytes
+ * @param len Byte count
+ * @return Updated CRC
+ */
+uint16_t uart_frame_crc16(uint16_t crc, const uint8_t *data, size_t len);
+
+/**
+ * @brief Build a complete frame (sync, header, payload, CRC)
+ * @param type Record type
+ * @param payload Payload bytes (may be NULL when len is 0)
+ * @param len Payload length, at most UART_FRAME_MAX_PAYLOAD
+ * @param out Destination for len + UART_FRAME_OVERHEAD bytes
+ * @param out_size Size of out
+ * @return Frame length, or 0 if it does not fit
+ */
+size_t uart_frame_encode(uint8_t type, const uint8_t *payload, uint16_t len,
+                         uint8_t *out, size_t out_size);
+
+/**
+ * @brief Reset decoder to wait for the next sync sequence
+ */
+void uart_frame_decoder_reset(uart_frame_decoder_t *dec);
+
+/**
+ * @brief Check whether the decoder is in the middle of a frame
+ */
+bool uart_frame_decoder_busy(const uart_frame_decoder_t *dec);
+
+/**
+ * @brief Feed one received byte
+ * @param dec Decoder
+ * @param byte Received byte
+ * @return UART_FRAME_READY when dec->frame holds a valid frame
+ */
+uart_frame_result_t uart_frame_decoder_feed(uart_frame_decoder_t *dec, uint8_t byte);
+
+/**
+ * @brief Parse a text-mode scan result line
+ *
+ * Format: "1","SSID","","BSSID","channel","security","rssi","band".
+ * Kept here with the binary decoder so both record parsers build without
+ * the UART driver.
+ * @return true if the line is a complete scan record
+ */
+bool uart_frame_parse_scan_line(const char *line, wifi_network_t *network);
+
+/**
+ * @brief Decode a scan result record into the text-mode network structure
+ * @return true if the payload is well formed
+ */
+bool uart_frame_parse_scan_result(const uart_frame_t *frame, wifi_network_t *network);
+
+/**
+ * @brief Decode a scan-done record
+ * @param count Number of networks JanOS reported
+ * @return true if the payload is well formed
+ */
+bool uart_frame_parse_scan_done(const uart_frame_t *frame, int *count);
+
+bool uart_frame_parse_sniffer(const uart_frame_t *frame, uart_sniffer_record_t *rec);
+bool uart_frame_parse_bt_device(const uart_frame_t *frame, uart_bt_record_t *rec);
+bool uart_frame_parse_handshake(const uart_frame_t *frame, uart_handshake_record_t *rec);
+bool uart_frame_parse_status(const uart_frame_t *frame, uart_status_record_t *rec);
+bool uart_frame_parse_progress(const uart_frame_t *frame, uart_progress_record_t *rec);
+
+#endif // UART_FRAME_H
@@ -1,404 +1,2315 @@
 /**
  * @file uart_handler.c
  * @brief UART handler implementation with background task and callbacks
+ *
+ * Each JanOS board is a link (uart_link_t) with its own port, RX task,
+ * line assembly, frame decoder and counters. Lines from every link go
+ * through the same parsers into the shared stores; routes choose which
+ * links they hear. Requests, scan callbacks, the raw tap and replayed
+ * bytes belong to the primary link, which every call without a link
+ * argument talks to.
  */
 
 #include "uart_handler.h"
+#include "uart_frame.h"
+#include "uart_bulk.h"
+#include "uart_progress.h"
+#include "event_bus.h"
+#include "network_store.h"
+#include "uart_transcript.h"
+#include "session_log.h"
+#include "watchlist.h"
+#include "time_sync.h"
+#include "trace.h"
+#include "stall_watch.h"
+#include "cmd_latency.h"
+#include "job_manager.h"
+#include "file_xfer.h"
+#include "text_log.h"
 #include "settings.h"
+#include "board_cache.h"
+#include "power.h"
+#include "power_governor.h"
+#include "task_plan.h"
+#include "mem_monitor.h"
+#include "sdkconfig.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include "driver/uart.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/ringbuf.h"
 #include <string.h>
 #include <stdlib.h>
 
 static const char *TAG = "UART";
 
-// UART task handle
-static TaskHandle_t uart_task_handle = NULL;
+// Line routes: slot 0 is the monitor callback, slot 1 the line callback
+// (both UART_ROUTE_ANY), the rest come from uart_subscribe_lines()
+#define ROUTE_SLOT_MONITOR  0
+#define ROUTE_SLOT_LINE     1
+#define ROUTE_SLOT_FIRST    2
 
-// Line callback
-static uart_response_callback_t line_callback = NULL;
-static void *line_callback_user_data = NULL;
-// Monitor callback (always active)
-static uart_response_callback_t monitor_callback = NULL;
-static void *monitor_callback_user_data = NULL;
+typedef uint16_t route_mask_t;
+_Static_assert(UART_MAX_LINE_ROUTES <= 16, "route_mask_t too narrow");
 
-// Scan state
-static bool is_scanning = false;
+typedef struct {
+    uart_route_kind_t kind;
+    char pattern[UART_ROUTE_PATTERN_LEN];
+    uint8_t pattern_len;
+    uart_response_callback_t callback;
+    void *user_data;
+    bool paused;                            // Kept but skipped (uart_pause_lines)
+    uint8_t links;                          // UART_LINK_MASK bits of links heard
+} line_route_t;
+
+static line_route_t routes[UART_MAX_LINE_ROUTES];
+static route_mask_t any_routes;             // UART_ROUTE_ANY subscribers
+static route_mask_t prefix_routes[256];     // Indexed by the pattern's first byte
+static route_mask_t tag_routes[256];        // Indexed by the byte after '['
+static route_mask_t link_routes[UART_LINK_COUNT];   // Routes hearing each link
+
+// Scan state (primary link; each link has its own is_scanning)
+static int64_t last_scan_end_ms = 0;      // When the last scan finished, 0 = none yet
 static uart_scan_complete_callback_t scan_callback = NULL;
+static uart_scan_result_callback_t scan_result_callback = NULL;
 static void *scan_callback_user_data = NULL;
-static wifi_network_t networks[MAX_NETWORKS];
-static int network_count = 0;
-static char scan_status[64] = "Ready";
+static char scan_status[64] = "Ready";   // Formatted by uart_get_scan_status()
 
 // Mutex for thread safety
 static SemaphoreHandle_t uart_mutex = NULL;
 
+// Express commands waiting for or holding uart_mutex; bulk writes hold off
+static uint32_t express_waiting = 0;
+
 // WiFi client connection state
 static bool wifi_connected = false;
 
-// Board ping detection state
-static volatile bool pong_received = false;
+// Request queue, resolved in order against incoming lines
+typedef struct {
+    uint32_t id;
+    char cmd[UART_REQUEST_CMD_LEN];
+    char end_marker[UART_REQUEST_CMD_LEN];
+    uart_request_line_cb_t on_line;
+    uart_request_done_cb_t on_done;
+    void *user_data;
+    TickType_t timeout;
+    TickType_t started;             // Tick the request became head
+} pending_request_t;
+
+static pending_request_t requests[UART_MAX_PENDING_REQUESTS];
+static int request_head = 0;
+static int request_count = 0;
+static uint32_t next_request_id = 1;
+
+// Event type posted to wake the RX task (no driver event uses it)
+#define RX_WAKE_EVENT   UART_EVENT_MAX
+
+// One JanOS board: its port, RX task and the state of everything read from it
+typedef struct {
+    uart_link_id_t id;
+    uart_port_t port;
+    const char *prefix;             // Log prefix, "" for the primary
+    TaskHandle_t task;
+    QueueHandle_t event_queue;      // Driver events
+    
+    // Line assembly buffer: bytes are read straight in and complete lines are
+    // terminated in place, so process_line() gets a slice with no extra copy
+    char *rx_buffer;
+    size_t rx_len;                  // Bytes held in rx_buffer
+    size_t rx_line_start;           // Start of the line being assembled
+    bool rx_discarding;             // Skipping the tail of an over-long line
+    volatile bool rx_reset_pending;
+    int64_t rx_read_us;             // When the bytes in hand were read
+    int64_t line_time_us;           // When the line being delivered ended
+    int64_t ping_sent_us;           // Last "ping" written, 0 = answered
+    int64_t tx_us;                  // Last command written
+    int64_t tx_drain_us;            // When the driver will have sent all bytes written
+    
+    // Binary framing (negotiated after ping/pong, text stays as fallback)
+    volatile bool binary_mode;
+    uart_frame_decoder_t frame_decoder;
+    volatile uart_quiet_t quiet;    // Accepted quiet offer (see uart_get_quiet)
+    
+    // Flow control; credits count bytes read since "proto credit" was acked
+    volatile uart_flow_t flow;
+    uint32_t credit_consumed;
+    uint32_t credit_limit;          // Last limit granted to JanOS
+    TickType_t credit_sent;
+    volatile bool credit_restart_pending;
+    
+    // Compressed bulk text (allocated once JanOS accepts "proto lz4")
+    uart_bulk_decoder_t *bulk;
+    char *bulk_line;                // Line spanning blocks
+    size_t bulk_line_len;
+    bool bulk_discarding;
+    
+    // Link speed (starts at UART_BAUD_RATE, raised by negotiation)
+    uint32_t current_baud;
+    bool baud_negotiated;
+    
+    route_mask_t dispatching;       // Routes dispatch_line() is calling back (atomic)
+    
+    bool is_scanning;               // Between scan_networks and its last row
+    uint32_t scan_seq;              // Bumped by each scan start
+    volatile uint32_t scan_stop_seq;    // Scan an express command ended, 0 = none
+    bool store_full_warned;
+    
+    // Counters (always kept; throughput is reported in UART_LOG_COUNTERS
+    // mode). Written by the RX task only, except the TX fields.
+    uart_link_stats_t stats;
+    uint64_t callback_total_us;
+    TickType_t last_report;
+    uint32_t rx_bytes_seen, rx_lines_seen, tx_bytes_seen, tx_lines_seen;
+} uart_link_t;
+
+static uart_link_t links[UART_LINK_COUNT];
+#define PRIMARY     (&links[UART_LINK_PRIMARY])
+
+// Frames the primary link does not consume itself
+static uart_frame_callback_t frame_callback = NULL;
+static void *frame_callback_user_data = NULL;
 
-// Line buffer
-static char line_buffer[1024];
-static int line_pos = 0;
+#ifdef CONFIG_UART_RX_BUFFER_PSRAM
+#define RX_BUFFER_CAPS      (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define RX_BUFFER_CAPS      (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+MEM_BUDGET(uart_tx_buffer, UART_BUF_SIZE, UART_LINK_COUNT, MEM_BUDGET_HEAP);
+MEM_BUDGET(uart_rx_ring, UART_RX_RING_SIZE, UART_LINK_COUNT, MEM_BUDGET_HEAP);
+#ifdef CONFIG_UART_RX_BUFFER_PSRAM
+MEM_BUDGET(uart_line, UART_LINE_MAX, UART_LINK_COUNT, MEM_BUDGET_PSRAM);
+#else
+MEM_BUDGET(uart_line, UART_LINE_MAX, UART_LINK_COUNT, MEM_BUDGET_HEAP);
+#endif
+#ifdef CONFIG_SPIRAM
+MEM_BUDGET(uart_scrollback, UART_SCROLLBACK_LINES, 32 + sizeof(uint32_t), MEM_BUDGET_PSRAM);
+#else
+MEM_BUDGET(uart_scrollback, UART_SCROLLBACK_LINES, 32 + sizeof(uint32_t), MEM_BUDGET_HEAP);
+#endif
+#ifdef CONFIG_UART_BULK_COMPRESSION
+MEM_BUDGET(uart_bulk, 1, sizeof(uart_bulk_decoder_t) + UART_LINE_MAX, MEM_BUDGET_HEAP);
+#endif
+
+// Received lines for the terminal screen
+static text_log_t scrollback;
+
+// Replayed RX bytes, created on first use and drained by the primary RX task
+#define INJECT_BUFFER_SIZE  4096
+#define INJECT_CHUNK_MAX    1024
+static RingbufHandle_t inject_buffer = NULL;
+
+// Raw RX tap (USB bridge), called with uart_mutex held
+static uart_raw_tap_t raw_tap = NULL;
+static void *raw_tap_user_data = NULL;
 
 /**
  * @brief Log current memory info
  */
 static void log_memory_info(const char *context)
 {
-    ESP_LOGI(TAG, "[MEM %s] Internal: %luKB, DMA: %luKB, Total: %luKB",
+    mem_monitor_stats_t mem;
+    mem_monitor_get_stats(&mem);
+    ESP_LOGI(TAG, "[MEM %s] Internal: %luKB (largest %luKB, min %luKB), DMA: %luKB, Total: %luKB",
              context,
-             (unsigned long)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024),
-             (unsigned long)(heap_caps_get_free_size(MALLOC_CAP_DMA) / 1024),
+             (unsigned long)(mem.internal_free / 1024),
+             (unsigned long)(mem.internal_largest / 1024),
+             (unsigned long)(mem.internal_min_free / 1024),
+             (unsigned long)(mem.dma_free / 1024),
              (unsigned long)(esp_get_free_heap_size() / 1024));
 }
 
 /**
- * @brief Parse a CSV network line
- * Format: "1","SSID","","BSSID","channel","security","rssi","band"
+ * @brief Log throughput since the last report when its interval is due
+ * @return Ticks until the next report, portMAX_DELAY outside counters mode
  */
-static bool parse_network_line(const char *line, wifi_network_t *network)
+static TickType_t report_counters(uart_link_t *link)
 {
-    // Check if line starts with a quote (CSV format)
-    if (line[0] != '"') {
-        return false;
+    if (settings_get_uart_log_level() != UART_LOG_COUNTERS) {
+        link->last_report = 0;
+        return portMAX_DELAY;
+    }
+    
+    const TickType_t interval = pdMS_TO_TICKS(UART_LOG_REPORT_MS);
+    TickType_t now = xTaskGetTickCount();
+    if (link->last_report == 0) {
+        // Entering counters mode: start a fresh window
+        link->last_report = now;
+        link->rx_bytes_seen = link->stats.rx_bytes;
+        link->rx_lines_seen = link->stats.rx_lines;
+        link->tx_bytes_seen = link->stats.tx_bytes;
+        link->tx_lines_seen = link->stats.tx_lines;
+        return interval;
     }
+    
+    TickType_t elapsed = now - link->last_report;
+    if (elapsed < interval) return interval - elapsed;
+    
+    uint32_t ms = elapsed * portTICK_PERIOD_MS;
+    ESP_LOGI(TAG, "%sRX %lu lines/s %lu B/s, TX %lu lines/s %lu B/s", link->prefix,
+             (unsigned long)((link->stats.rx_lines - link->rx_lines_seen) * 1000ULL / ms),
+             (unsigned long)((link->stats.rx_bytes - link->rx_bytes_seen) * 1000ULL / ms),
+             (unsigned long)((link->stats.tx_lines - link->tx_lines_seen) * 1000ULL / ms),
+             (unsigned long)((link->stats.tx_bytes - link->tx_bytes_seen) * 1000ULL / ms));
+    
+    link->last_report = now;
+    link->rx_bytes_seen = link->stats.rx_bytes;
+    link->rx_lines_seen = link->stats.rx_lines;
+    link->tx_bytes_seen = link->stats.tx_bytes;
+    link->tx_lines_seen = link->stats.tx_lines;
+    return interval;
+}
 
-    // Parse using simple state machine
-    char *str = strdup(line);
-    if (!str) return false;
+/**
+ * @brief Store one scanned network (text or binary record)
+ *
+ * Scan progress and the streaming callback follow the primary's scans.
+ */
+static void add_scanned_network(uart_link_t *link, wifi_network_t *network)
+{
+    network->link = link->id;
+    int index = network_store_add(network);
+    if (index < 0) {
+        if (!link->store_full_warned) {
+            ESP_LOGW(TAG, "Network store full (%d), dropping further results",
+                     network_store_count());
+            link->store_full_warned = true;
+        }
+        return;
+    }
+    
+    bus_event_t event = { .type = BUS_EVENT_NETWORK_SEEN };
+    strlcpy(event.network.ssid, network->ssid, sizeof(event.network.ssid));
+    strlcpy(event.network.bssid, network->bssid, sizeof(event.network.bssid));
+    strlcpy(event.network.security, network->security, sizeof(event.network.security));
+    strlcpy(event.network.band, network->band, sizeof(event.network.band));
+    event.network.rssi = (int8_t)network->rssi;
+    event.network.channel = (uint8_t)network->channel;
+    event_bus_publish(&event);
+    if (link->id != UART_LINK_PRIMARY) return;
+    
+    uart_progress_record_t progress;
+    uart_progress_get(UART_OP_WIFI_SCAN, &progress);
+    progress.done = network_store_count();
+    uart_progress_publish(&progress);
+    
+    // Under the mutex so uart_detach_wifi_scan() cannot race a delivery
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    if (scan_result_callback) {
+        scan_result_callback(network, scan_callback_user_data);
+    }
+    xSemaphoreGive(uart_mutex);
+}
 
-    char *fields[8] = {0};
-    int field_count = 0;
-    char *ptr = str;
+/**
+ * @brief End scan mode and hand results to the scan callback
+ *
+ * Only the primary's scans are store passes; another board's rows count
+ * as seen in whatever pass is current.
+ */
+static void finish_scan(uart_link_t *link)
+{
+    if (link->id != UART_LINK_PRIMARY) {
+        link->is_scanning = false;
+        ESP_LOGI(TAG, "%sScan complete", link->prefix);
+        return;
+    }
     
-    while (*ptr && field_count < 8) {
-        // Skip leading quote
-        if (*ptr == '"') ptr++;
-        
-        // Find start of field
-        fields[field_count] = ptr;
-        
-        // Find end of field (closing quote)
-        while (*ptr && *ptr != '"') ptr++;
-        if (*ptr == '"') {
-            *ptr = '\0';
-            ptr++;
-        }
-        
-        // Skip comma
-        if (*ptr == ',') ptr++;
-        
-        field_count++;
-    }
-
-    if (field_count >= 8) {
-        network->id = atoi(fields[0]);
-        strncpy(network->ssid, fields[1], MAX_SSID_LEN - 1);
-        network->ssid[MAX_SSID_LEN - 1] = '\0';
-        // fields[2] is empty
-        strncpy(network->bssid, fields[3], MAX_BSSID_LEN - 1);
-        network->bssid[MAX_BSSID_LEN - 1] = '\0';
-        network->channel = atoi(fields[4]);
-        strncpy(network->security, fields[5], MAX_SECURITY_LEN - 1);
-        network->security[MAX_SECURITY_LEN - 1] = '\0';
-        network->rssi = atoi(fields[6]);
-        strncpy(network->band, fields[7], MAX_BAND_LEN - 1);
-        network->band[MAX_BAND_LEN - 1] = '\0';
-        network->selected = false;
-        
-        free(str);
-        return true;
+    int aged = network_store_end_pass();
+    int count = network_store_count();
+    ESP_LOGI(TAG, "Scan complete, %d networks (%d aged out)", count, aged);
+    link->is_scanning = false;
+    last_scan_end_ms = esp_timer_get_time() / 1000;
+    cmd_latency_done("scan_networks", true);
+    
+    uart_progress_record_t progress = {
+        .op = UART_OP_WIFI_SCAN,
+        .state = UART_PROGRESS_DONE,
+        .percent = 100,
+        .done = count,
+        .total = count,
+    };
+    snprintf(progress.text, sizeof(progress.text), "Found %d networks", count);
+    uart_progress_publish(&progress);
+    
+    if (scan_callback) {
+        scan_callback(count, scan_callback_user_data);
     }
+    scan_callback = NULL;
+    scan_result_callback = NULL;
+    scan_callback_user_data = NULL;
+}
 
-    free(str);
-    return false;
+/**
+ * @brief Feed the board's clock to time_sync: ESP log stamps and pong RTTs
+ */
+static void note_line_time(uart_link_t *link, const char *line)
+{
+    if ((line[0] == 'I' || line[0] == 'W' || line[0] == 'E' || line[0] == 'D') &&
+        line[1] == ' ' && line[2] == '(' && line[3] >= '0' && line[3] <= '9') {
+        char *end;
+        unsigned long ms = strtoul(line + 3, &end, 10);
+        if (*end == ')') time_sync_janos_sample(link->id, (uint32_t)ms, link->line_time_us);
+    } else if (link->ping_sent_us && strcmp(line, "pong") == 0) {
+        time_sync_ping_rtt(link->id, (uint32_t)(link->line_time_us - link->ping_sent_us));
+        link->ping_sent_us = 0;
+    }
 }
 
 /**
- * @brief Process a complete line from UART
+ * @brief Process a complete binary frame from UART
  */
-static void process_line(const char *line)
+static void process_frame(uart_link_t *link, const uart_frame_t *frame)
 {
-    ESP_LOGI(TAG, "RX: %s", line);
+    ESP_LOGD(TAG, "%sRX frame type 0x%02X, %u bytes", link->prefix, frame->type, frame->len);
+    TRACE_INSTANT(TRACE_EV_UART_FRAME, (uint32_t)link->id << 16 | frame->type);
 
-    // Call monitor callback if registered (does not interfere with line callback)
-    if (monitor_callback) {
-        monitor_callback(line, monitor_callback_user_data);
+    // Quiet link: logs are kept for the terminal and the clock, nothing parses them
+    if (frame->type == UART_FRAME_LOG) {
+        char line[UART_FRAME_MAX_PAYLOAD + 1];
+        memcpy(line, frame->payload, frame->len);
+        line[frame->len] = '\0';
+        link->stats.log_frames++;
+        text_log_append(&scrollback, link->prefix, line);
+        note_line_time(link, line);
+        return;
     }
 
-    // Call line callback if registered
-    if (line_callback) {
-        line_callback(line, line_callback_user_data);
+    // File chunks and their acknowledgements go straight to the transfer task
+    if (frame->type >= UART_FRAME_FILE_DATA && frame->type <= UART_FRAME_FILE_END) {
+        if (link->id == UART_LINK_PRIMARY) file_xfer_on_frame(frame);
+        return;
     }
 
-    // Handle scan mode
-    if (is_scanning) {
-        // Check for scan completion
-        if (strstr(line, "Scan results printed.") != NULL) {
-            ESP_LOGI(TAG, "Scan complete, found %d networks", network_count);
-            snprintf(scan_status, sizeof(scan_status), "Found %d networks", network_count);
-            is_scanning = false;
-            
-            if (scan_callback) {
-                scan_callback(networks, network_count, scan_callback_user_data);
-                scan_callback = NULL;
-                scan_callback_user_data = NULL;
+    if (link->is_scanning) {
+        if (frame->type == UART_FRAME_SCAN_RESULT) {
+            wifi_network_t network;
+            TRACE_BEGIN(TRACE_EV_PARSE, frame->len);
+            bool parsed = uart_frame_parse_scan_result(frame, &network);
+            TRACE_END(TRACE_EV_PARSE, parsed);
+            if (parsed) {
+                add_scanned_network(link, &network);
+            } else {
+                link->stats.parse_failures++;
             }
             return;
         }
-
-        // Try to parse as network entry
-        if (line[0] == '"' && network_count < MAX_NETWORKS) {
-            wifi_network_t network = {0};
-            if (parse_network_line(line, &network)) {
-                networks[network_count++] = network;
-                snprintf(scan_status, sizeof(scan_status), "Scanning... %d networks", network_count);
-            }
+        if (frame->type == UART_FRAME_SCAN_DONE) {
+            finish_scan(link);
+            return;
         }
+    }
 
-        // Update status based on known messages
-        if (strstr(line, "Starting background WiFi scan") != NULL) {
-            snprintf(scan_status, sizeof(scan_status), "Scanning...");
-        } else if (strstr(line, "WiFi scan completed") != NULL) {
-            snprintf(scan_status, sizeof(scan_status), "Processing results...");
+    if (frame->type == UART_FRAME_PROGRESS) {
+        if (link->id != UART_LINK_PRIMARY) return;
+        uart_progress_record_t progress;
+        if (uart_frame_parse_progress(frame, &progress)) {
+            uart_progress_publish(&progress);
+        } else {
+            link->stats.parse_failures++;
         }
+        return;
+    }
+
+    session_log_frame(frame);
+    if (frame_callback && link->id == UART_LINK_PRIMARY) {
+        frame_callback(frame, frame_callback_user_data);
     }
 }
 
 /**
- * @brief UART receive task
+ * @brief Rebuild the lookup tables after a route change (uart_mutex held)
  */
-static void uart_rx_task(void *arg)
+static void rebuild_route_tables(void)
 {
-    uint8_t data[128];
+    any_routes = 0;
+    memset(prefix_routes, 0, sizeof(prefix_routes));
+    memset(tag_routes, 0, sizeof(tag_routes));
+    memset(link_routes, 0, sizeof(link_routes));
     
-    while (1) {
-        int len = uart_read_bytes(UART_PORT_NUM, data, sizeof(data) - 1, pdMS_TO_TICKS(100));
-        
-        if (len > 0) {
-            data[len] = '\0';
-            
-            // Process byte by byte to find complete lines
-            for (int i = 0; i < len; i++) {
-                char c = data[i];
-                
-                if (c == '\n' || c == '\r') {
-                    if (line_pos > 0) {
-                        line_buffer[line_pos] = '\0';
-                        process_line(line_buffer);
-                        line_pos = 0;
-                    }
-                } else if (line_pos < sizeof(line_buffer) - 1) {
-                    line_buffer[line_pos++] = c;
-                }
-            }
+    for (int i = 0; i < UART_MAX_LINE_ROUTES; i++) {
+        const line_route_t *r = &routes[i];
+        if (!r->callback || r->paused) continue;
+        route_mask_t bit = (route_mask_t)(1u << i);
+        for (int l = 0; l < UART_LINK_COUNT; l++) {
+            if (r->links & UART_LINK_MASK(l)) link_routes[l] |= bit;
+        }
+        switch (r->kind) {
+            case UART_ROUTE_PREFIX:
+                prefix_routes[(uint8_t)r->pattern[0]] |= bit;
+                break;
+            case UART_ROUTE_TAG:
+                tag_routes[(uint8_t)r->pattern[1]] |= bit;
+                break;
+            default:
+                any_routes |= bit;
+                break;
         }
     }
 }
 
-esp_err_t uart_handler_init(void)
+/**
+ * @brief Install a route into a slot (uart_mutex held)
+ */
+static void set_route(int slot, uint8_t links, uart_route_kind_t kind, const char *pattern,
+                      uart_response_callback_t callback, void *user_data)
 {
-    int tx_pin = settings_get_uart_tx_pin();
-    int rx_pin = settings_get_uart_rx_pin();
-    
-    ESP_LOGI(TAG, "Initializing UART handler (TX=%d, RX=%d)...", tx_pin, rx_pin);
-
-    // Create mutex
-    uart_mutex = xSemaphoreCreateMutex();
-    if (!uart_mutex) {
-        ESP_LOGE(TAG, "Failed to create mutex");
-        return ESP_FAIL;
+    line_route_t *r = &routes[slot];
+    memset(r, 0, sizeof(*r));
+    if (callback) {
+        r->kind = kind;
+        if (kind != UART_ROUTE_ANY) {
+            strlcpy(r->pattern, pattern, sizeof(r->pattern));
+            r->pattern_len = strlen(r->pattern);
+        }
+        r->callback = callback;
+        r->user_data = user_data;
+        r->links = links;
     }
+    rebuild_route_tables();
+}
 
-    // Configure UART
-    uart_config_t uart_config = {
-        .baud_rate = UART_BAUD_RATE,
-        .data_bits = UART_DATA_8_BITS,
-        .parity = UART_PARITY_DISABLE,
-        .stop_bits = UART_STOP_BITS_1,
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
-        .source_clk = UART_SCLK_DEFAULT,
-    };
-
-    esp_err_t ret = uart_param_config(UART_PORT_NUM, &uart_config);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "UART param config failed: %s", esp_err_to_name(ret));
-        return ret;
+/**
+ * @brief Work out which routes want a line
+ *
+ * Prefix candidates come from the first byte alone; tag candidates from
+ * the byte following each '[' in the line. Only candidates among the
+ * routes hearing the link are compared.
+ */
+static route_mask_t classify_line(const uart_link_t *link, const char *line)
+{
+    route_mask_t heard = link_routes[link->id];
+    route_mask_t hits = any_routes & heard;
+    
+    route_mask_t m = prefix_routes[(uint8_t)line[0]] & heard;
+    while (m) {
+        int i = __builtin_ctz(m);
+        m &= m - 1;
+        if (strncmp(line, routes[i].pattern, routes[i].pattern_len) == 0) {
+            hits |= (route_mask_t)(1u << i);
+        }
     }
-
-    ret = uart_set_pin(UART_PORT_NUM, tx_pin, rx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "UART set pin failed: %s", esp_err_to_name(ret));
-        return ret;
+    
+    for (const char *p = strchr(line, '['); p; p = strchr(p + 1, '[')) {
+        m = tag_routes[(uint8_t)p[1]] & heard & (route_mask_t)~hits;
+        while (m) {
+            int i = __builtin_ctz(m);
+            m &= m - 1;
+            if (strncmp(p, routes[i].pattern, routes[i].pattern_len) == 0) {
+                hits |= (route_mask_t)(1u << i);
+            }
+        }
     }
+    return hits;
+}
 
-    ret = uart_driver_install(UART_PORT_NUM, UART_BUF_SIZE, UART_BUF_SIZE, 0, NULL, 0);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "UART driver install failed: %s", esp_err_to_name(ret));
-        return ret;
+/**
+ * @brief Hand a line to every matching route
+ *
+ * Callbacks are copied out under the mutex and called without it, so a
+ * callback may send commands or change routes.
+ */
+static void dispatch_line(uart_link_t *link, const char *line)
+{
+    line_route_t targets[UART_MAX_LINE_ROUTES];
+    uint8_t slots[UART_MAX_LINE_ROUTES];
+    int count = 0;
+    
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    route_mask_t hits = classify_line(link, line);
+    route_mask_t called = hits;
+    while (hits) {
+        int i = __builtin_ctz(hits);
+        hits &= hits - 1;
+        slots[count] = i;
+        targets[count++] = routes[i];
     }
-
-    // Create RX task
-    BaseType_t task_ret = xTaskCreate(uart_rx_task, "uart_rx", 4096, NULL, 10, &uart_task_handle);
-    if (task_ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create UART RX task");
-        return ESP_FAIL;
+    __atomic_store_n(&link->dispatching, called, __ATOMIC_RELAXED);
+    xSemaphoreGive(uart_mutex);
+    
+    TRACE_BEGIN(TRACE_EV_DISPATCH, count);
+    for (int i = 0; i < count; i++) {
+        int64_t start = esp_timer_get_time();
+        targets[i].callback(line, targets[i].user_data);
+        uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+        stall_watch_record(STALL_SITE_UART, targets[i].callback, us);
+        
+        link->stats.callback_calls++;
+        link->callback_total_us += us;
+        if (us > link->stats.callback_max_us) {
+            link->stats.callback_max_us = us;
+            link->stats.callback_max_route = slots[i];
+        }
     }
+    TRACE_END(TRACE_EV_DISPATCH, count);
+    __atomic_store_n(&link->dispatching, 0, __ATOMIC_RELEASE);
+}
 
-    ESP_LOGI(TAG, "UART handler initialized successfully");
-    return ESP_OK;
+/**
+ * @brief Wait until no other RX task is still calling a removed route
+ *
+ * dispatch_line() calls its copies outside uart_mutex, so a route taken
+ * out may still be running with user data its owner is about to free.
+ * A callback changing routes on its own RX task is not waited for.
+ * Called without uart_mutex, after the route was changed.
+ */
+static void wait_for_dispatch(int slot)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    route_mask_t bit = (route_mask_t)(1u << slot);
+    for (int i = 0; i < UART_LINK_COUNT; i++) {
+        if (links[i].task == self) continue;
+        while (__atomic_load_n(&links[i].dispatching, __ATOMIC_ACQUIRE) & bit) {
+            vTaskDelay(1);
+        }
+    }
 }
 
-esp_err_t uart_send_command(const char *cmd)
+/**
+ * @brief Remove the head request if it is still the one with this id
+ * @return true if it was removed (uart_mutex held)
+ */
+static bool pop_request(uint32_t id, pending_request_t *out)
 {
-    if (!cmd) return ESP_ERR_INVALID_ARG;
+    if (request_count == 0 || requests[request_head].id != id) return false;
+    *out = requests[request_head];
+    request_head = (request_head + 1) % UART_MAX_PENDING_REQUESTS;
+    request_count--;
+    if (request_count > 0) {
+        requests[request_head].started = xTaskGetTickCount();
+    }
+    return true;
+}
 
+/**
+ * @brief Offer a line to the request at the head of the queue
+ */
+static void resolve_request(const char *line)
+{
     xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    if (request_count == 0) {
+        xSemaphoreGive(uart_mutex);
+        return;
+    }
+    pending_request_t head = requests[request_head];
+    xSemaphoreGive(uart_mutex);
     
-    ESP_LOGI(TAG, "TX: %s", cmd);
-    log_memory_info("TX Command");
-    
-    int len = strlen(cmd);
-    int written = uart_write_bytes(UART_PORT_NUM, cmd, len);
+    // Skip the command echo, and the acknowledgement of a stop sent meanwhile
+    if (strcmp(line, head.cmd) == 0) return;
+    if (strncmp(line, UART_STOP_REPLY, strlen(UART_STOP_REPLY)) == 0) return;
     
-    // Send newline if not present
-    if (len > 0 && cmd[len - 1] != '\n') {
-        uart_write_bytes(UART_PORT_NUM, "\n", 1);
+    bool complete;
+    if (head.end_marker[0]) {
+        complete = strncmp(line, head.end_marker, strlen(head.end_marker)) == 0;
+        if (head.on_line && !complete) {
+            head.on_line(line, head.user_data);
+        }
+    } else if (head.on_line) {
+        complete = head.on_line(line, head.user_data);
+    } else {
+        complete = true;
     }
+    if (!complete) return;
     
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    bool popped = pop_request(head.id, &head);
     xSemaphoreGive(uart_mutex);
     
-    return (written == len) ? ESP_OK : ESP_FAIL;
+    if (popped) {
+        cmd_latency_done(head.cmd, true);
+    }
+    if (popped && head.on_done) {
+        head.on_done(UART_REQUEST_DONE, head.user_data);
+    }
 }
 
-void uart_register_line_callback(uart_response_callback_t callback, void *user_data)
+/**
+ * @brief Fail the head request if its timeout has passed
+ * @return Ticks until the next deadline, portMAX_DELAY if nothing is pending
+ */
+static TickType_t expire_requests(void)
 {
-    xSemaphoreTake(uart_mutex, portMAX_DELAY);
-    line_callback = callback;
-    line_callback_user_data = user_data;
-    xSemaphoreGive(uart_mutex);
+    while (1) {
+        xSemaphoreTake(uart_mutex, portMAX_DELAY);
+        if (request_count == 0) {
+            xSemaphoreGive(uart_mutex);
+            return portMAX_DELAY;
+        }
+        
+        pending_request_t *r = &requests[request_head];
+        TickType_t elapsed = xTaskGetTickCount() - r->started;
+        if (elapsed < r->timeout) {
+            TickType_t left = r->timeout - elapsed;
+            xSemaphoreGive(uart_mutex);
+            return left;
+        }
+        
+        pending_request_t expired;
+        pop_request(r->id, &expired);
+        xSemaphoreGive(uart_mutex);
+        
+        PRIMARY->stats.request_timeouts++;
+        ESP_LOGW(TAG, "Request '%s' timed out", expired.cmd);
+        cmd_latency_done(expired.cmd, false);
+        if (expired.on_done) {
+            expired.on_done(UART_REQUEST_TIMEOUT, expired.user_data);
+        }
+    }
 }
 
-void uart_register_monitor_callback(uart_response_callback_t callback, void *user_data)
+/**
+ * @brief Process a complete line from UART
+ */
+static void process_line(uart_link_t *link, const char *line)
 {
-    xSemaphoreTake(uart_mutex, portMAX_DELAY);
-    monitor_callback = callback;
-    monitor_callback_user_data = user_data;
-    xSemaphoreGive(uart_mutex);
-}
+    link->stats.rx_lines++;
+    TRACE_INSTANT(TRACE_EV_UART_LINE, (uint32_t)link->id << 16 | strlen(line));
+    text_log_append(&scrollback, link->prefix, line);
+    if (settings_get_uart_log_level() >= UART_LOG_LINES) {
+        ESP_LOGI(TAG, "%sRX: %s", link->prefix, line);
+    }
+    note_line_time(link, line);
+    if (link->id == UART_LINK_PRIMARY) {
+        cmd_latency_line(line, link->line_time_us);
+    }
 
-void uart_clear_line_callback(void)
-{
-    xSemaphoreTake(uart_mutex, portMAX_DELAY);
-    line_callback = NULL;
-    line_callback_user_data = NULL;
-    xSemaphoreGive(uart_mutex);
-}
+    // Requests and progress follow commands sent to the primary
+    if (link->id == UART_LINK_PRIMARY) {
+        resolve_request(line);
+    }
 
-void uart_clear_monitor_callback(void)
-{
-    xSemaphoreTake(uart_mutex, portMAX_DELAY);
-    monitor_callback = NULL;
-    monitor_callback_user_data = NULL;
-    xSemaphoreGive(uart_mutex);
+    // Monitor callback, line callback and subscribers
+    dispatch_line(link, line);
+    if (link->id == UART_LINK_PRIMARY) {
+        uart_progress_feed_line(line);
+    }
+    watchlist_check_line(line);
+
+    // Handle scan mode
+    if (link->is_scanning) {
+        // Check for scan completion
+        if (strstr(line, "Scan results printed.") != NULL) {
+            finish_scan(link);
+            return;
+        }
+
+        // Try to parse as network entry
+        if (line[0] == '"') {
+            wifi_network_t network = {0};
+            TRACE_BEGIN(TRACE_EV_PARSE, strlen(line));
+            bool parsed = uart_frame_parse_scan_line(line, &network);
+            TRACE_END(TRACE_EV_PARSE, parsed);
+            if (parsed) {
+                add_scanned_network(link, &network);
+            } else {
+                link->stats.parse_failures++;
+            }
+        }
+    } else if (line[0] == '"') {
+        // show_scan_results from any screen: keep the BSSID/SSID -> index map current
+        wifi_network_t network = { .link = link->id };
+        TRACE_BEGIN(TRACE_EV_PARSE, strlen(line));
+        bool parsed = uart_frame_parse_scan_line(line, &network);
+        TRACE_END(TRACE_EV_PARSE, parsed);
+        if (parsed) {
+            network_store_add(&network);
+        }
+    }
 }
 
-esp_err_t uart_start_wifi_scan(uart_scan_complete_callback_t callback, void *user_data)
+/**
+ * @brief Expand a compressed block and run its lines through process_line()
+ *
+ * Lines may span blocks; the unfinished one waits in bulk_line. Lines
+ * get the arrival time of the frame that completes them.
+ */
+static void process_bulk(uart_link_t *link, const uart_frame_t *frame)
 {
-    if (is_scanning) {
-        ESP_LOGW(TAG, "Scan already in progress");
-        return ESP_ERR_INVALID_STATE;
+    if (!link->bulk) {
+        link->stats.bulk_dropped++;
+        return;
     }
-
-    xSemaphoreTake(uart_mutex, portMAX_DELAY);
     
-    // Reset state
-    network_count = 0;
-    memset(networks, 0, sizeof(networks));
-    is_scanning = true;
-    scan_callback = callback;
-    scan_callback_user_data = user_data;
-    snprintf(scan_status, sizeof(scan_status), "Starting scan...");
+    const uint8_t *text;
+    int n = uart_bulk_decode(link->bulk, frame->payload, frame->len, &text);
+    if (n < 0) {
+        // The line in progress cannot be finished from this stream
+        link->stats.bulk_dropped++;
+        link->bulk_line_len = 0;
+        link->bulk_discarding = true;
+        ESP_LOGW(TAG, "%sDropped bulk block %u", link->prefix,
+                 frame->len > 1 ? frame->payload[1] : 0);
+        return;
+    }
+    if (frame->len > 0 && (frame->payload[0] & UART_BULK_FLAG_RESET)) {
+        link->bulk_line_len = 0;
+        link->bulk_discarding = false;
+    }
+    link->stats.bulk_bytes += frame->len;
+    link->stats.bulk_text += n;
     
-    xSemaphoreGive(uart_mutex);
+    for (int i = 0; i < n; i++) {
+        char c = (char)text[i];
+        if (c == '\n' || c == '\r') {
+            if (!link->bulk_discarding && link->bulk_line_len > 0) {
+                link->bulk_line[link->bulk_line_len] = '\0';
+                process_line(link, link->bulk_line);
+            }
+            link->bulk_line_len = 0;
+            link->bulk_discarding = false;
+        } else if (link->bulk_discarding) {
+            continue;
+        } else if (link->bulk_line_len < UART_LINE_MAX - 1) {
+            link->bulk_line[link->bulk_line_len++] = c;
+        } else {
+            // Same as the text path: deliver what fits, skip the rest
+            link->stats.truncated_lines++;
+            link->bulk_line[link->bulk_line_len] = '\0';
+            process_line(link, link->bulk_line);
+            link->bulk_line_len = 0;
+            link->bulk_discarding = true;
+        }
+    }
+}
 
-    // Send scan command
-    return uart_send_command("scan_networks");
+/**
+ * @brief Drop any partially assembled line or frame
+ */
+static void rx_reset(uart_link_t *link)
+{
+    link->rx_len = 0;
+    link->rx_line_start = 0;
+    link->rx_discarding = false;
+    uart_frame_decoder_reset(&link->frame_decoder);
+    if (link->bulk) {
+        // Flushed bytes may have held a block; wait for the next stream
+        uart_bulk_reset(link->bulk);
+        link->bulk_line_len = 0;
+    }
 }
 
-bool uart_is_scanning(void)
+/**
+ * @brief When byte i arrived: the read time, back by the wire time of the
+ *        bytes read after it (10 bits each)
+ */
+static int64_t end_time_us(const uart_link_t *link, size_t i)
 {
-    return is_scanning;
+    return link->rx_read_us - (int64_t)(link->rx_len - 1 - i) * 10000000 / link->current_baud;
 }
 
-const char* uart_get_scan_status(void)
+/**
+ * @brief Split newly received bytes into lines and frames
+ * @param from Offset of the first byte not scanned yet
+ */
+static void rx_scan(uart_link_t *link, size_t from)
 {
-    return scan_status;
+    for (size_t i = from; i < link->rx_len; i++) {
+        uint8_t c = (uint8_t)link->rx_buffer[i];
+        
+        // Binary frames start with a sync byte at a line boundary
+        if (link->binary_mode && (uart_frame_decoder_busy(&link->frame_decoder) ||
+                                  (i == link->rx_line_start && c == UART_FRAME_SYNC0))) {
+            uart_frame_result_t r = uart_frame_decoder_feed(&link->frame_decoder, c);
+            if (r == UART_FRAME_READY) {
+                link->line_time_us = end_time_us(link, i);
+                if (link->frame_decoder.frame.type == UART_FRAME_BULK) {
+                    process_bulk(link, &link->frame_decoder.frame);
+                } else {
+                    process_frame(link, &link->frame_decoder.frame);
+                }
+            } else if (r == UART_FRAME_ERROR) {
+                link->stats.frame_errors++;
+                ESP_LOGW(TAG, "%sDropped corrupt frame", link->prefix);
+            }
+            link->rx_line_start = i + 1;
+            continue;
+        }
+        
+        if (c == '\n' || c == '\r') {
+            if (link->rx_discarding) {
+                link->rx_discarding = false;
+            } else if (i > link->rx_line_start) {
+                link->line_time_us = end_time_us(link, i);
+                link->rx_buffer[i] = '\0';
+                process_line(link, &link->rx_buffer[link->rx_line_start]);
+            }
+            link->rx_line_start = i + 1;
+        }
+    }
+    
+    // Keep only the unfinished line, at the start of the buffer
+    if (link->rx_line_start > 0) {
+        memmove(link->rx_buffer, &link->rx_buffer[link->rx_line_start],
+                link->rx_len - link->rx_line_start);
+        link->rx_len -= link->rx_line_start;
+        link->rx_line_start = 0;
+    }
+    
+    // Line longer than the buffer: deliver what we have, skip the rest
+    if (link->rx_len >= UART_LINE_MAX - 1) {
+        ESP_LOGW(TAG, "%sLine longer than %d bytes, truncated", link->prefix, UART_LINE_MAX - 1);
+        link->rx_buffer[link->rx_len] = '\0';
+        if (!link->rx_discarding) {
+            link->stats.truncated_lines++;
+            process_line(link, link->rx_buffer);
+        }
+        link->rx_discarding = true;
+        link->rx_len = 0;
+    }
 }
 
-bool uart_is_wifi_connected(void)
+#ifdef CONFIG_UART_FLOW_SOFTWARE
+/**
+ * @brief Send the current credit limit (RX task, or a mode switch)
+ */
+static void grant_credit(uart_link_t *link)
 {
-    return wifi_connected;
+    uint8_t payload[UART_CREDIT_SIZE];
+    for (int i = 0; i < UART_CREDIT_SIZE; i++) {
+        payload[i] = (uint8_t)(link->credit_limit >> (8 * i));
+    }
+    link->credit_sent = xTaskGetTickCount();
+    uart_send_frame(UART_FRAME_CREDIT, payload, sizeof(payload));
 }
 
-void uart_set_wifi_connected(bool connected)
+/**
+ * @brief Start counting from zero on both ends after bytes were flushed
+ *
+ * Sent without waiting, as the ack is read by this very task; it is
+ * ignored when it arrives.
+ */
+static void credit_restart(uart_link_t *link)
 {
-    wifi_connected = connected;
+    char cmd[32];
+    snprintf(cmd, sizeof(cmd), "%s %u", UART_PROTO_CREDIT_CMD, (unsigned)UART_CREDIT_WINDOW);
+    link->credit_consumed = 0;
+    link->credit_limit = UART_CREDIT_WINDOW;
+    link->credit_sent = xTaskGetTickCount();
+    uart_link_send_command(link->id, cmd);
 }
+#endif
 
 /**
- * @brief Callback to detect pong response
+ * @brief Account bytes read; top the limit up once half the window is used
  */
-static void ping_response_callback(const char *line, void *user_data)
+static void credit_consume(uart_link_t *link, size_t len)
 {
-    (void)user_data;
-    if (strcmp(line, "pong") == 0) {
-        pong_received = true;
-        ESP_LOGI(TAG, "Pong received - board detected");
+#ifdef CONFIG_UART_FLOW_SOFTWARE
+    if (link->flow != UART_FLOW_CREDITS) return;
+    link->credit_consumed += len;
+    if ((int32_t)(link->credit_limit - link->credit_consumed) < UART_CREDIT_WINDOW / 2) {
+        link->credit_limit = link->credit_consumed + UART_CREDIT_WINDOW;
+        grant_credit(link);
     }
+#else
+    (void)link;
+    (void)len;
+#endif
 }
 
-bool uart_check_board_ping(int timeout_ms)
+/**
+ * @brief Repeat the credit limit when it has not been sent for a while
+ * @return Ticks until the next repeat, portMAX_DELAY without credits
+ */
+static TickType_t refresh_credit(uart_link_t *link)
+{
+#ifdef CONFIG_UART_FLOW_SOFTWARE
+    if (link->flow != UART_FLOW_CREDITS) return portMAX_DELAY;
+    
+    const TickType_t interval = pdMS_TO_TICKS(UART_CREDIT_REFRESH_MS);
+    TickType_t elapsed = xTaskGetTickCount() - link->credit_sent;
+    if (elapsed < interval) return interval - elapsed;
+    grant_credit(link);
+    return interval;
+#else
+    (void)link;
+    return portMAX_DELAY;
+#endif
+}
+
+/**
+ * @brief Read everything the driver has buffered
+ */
+static void rx_drain(uart_link_t *link)
+{
+    size_t avail = 0;
+    uart_get_buffered_data_len(link->port, &avail);
+    
+    while (avail > 0) {
+        size_t room = UART_LINE_MAX - 1 - link->rx_len;
+        size_t want = (avail < room) ? avail : room;
+        int len = uart_read_bytes(link->port, &link->rx_buffer[link->rx_len], want, 0);
+        if (len <= 0) break;
+        link->rx_read_us = esp_timer_get_time();
+        
+        size_t from = link->rx_len;
+        
+        // Transcript and tap record the primary board only
+        if (link->id == UART_LINK_PRIMARY) {
+            uart_transcript_capture(&link->rx_buffer[link->rx_len], len);
+        }
+        if (raw_tap && link->id == UART_LINK_PRIMARY) {
+            // Called under the mutex so clearing the tap waits for it
+            xSemaphoreTake(uart_mutex, portMAX_DELAY);
+            if (raw_tap) {
+                raw_tap((const uint8_t *)&link->rx_buffer[link->rx_len], len, raw_tap_user_data);
+            }
+            xSemaphoreGive(uart_mutex);
+        }
+        link->stats.rx_bytes += len;
+        link->rx_len += len;
+        avail -= len;
+        credit_consume(link, len);
+        rx_scan(link, from);
+    }
+}
+
+/**
+ * @brief Run injected (replayed) bytes through the same line splitter
+ */
+static void rx_drain_injected(uart_link_t *link)
+{
+    if (!inject_buffer || link->id != UART_LINK_PRIMARY) return;
+    
+    size_t size = 0;
+    uint8_t *item;
+    while ((item = xRingbufferReceive(inject_buffer, &size, 0)) != NULL) {
+        size_t done = 0;
+        while (done < size) {
+            size_t room = UART_LINE_MAX - 1 - link->rx_len;
+            size_t n = (size - done < room) ? size - done : room;
+            memcpy(&link->rx_buffer[link->rx_len], item + done, n);
+            link->rx_read_us = esp_timer_get_time();
+            size_t from = link->rx_len;
+            link->stats.rx_bytes += n;
+            link->rx_len += n;
+            done += n;
+            rx_scan(link, from);
+        }
+        vRingbufferReturnItem(inject_buffer, item);
+    }
+}
+
+/**
+ * @brief Run timed housekeeping and work out how long the RX task may sleep
+ */
+static TickType_t next_wait(uart_link_t *link)
+{
+    TickType_t requests_due = (link->id == UART_LINK_PRIMARY) ? expire_requests() : portMAX_DELAY;
+    TickType_t report_due = report_counters(link);
+    TickType_t credit_due = refresh_credit(link);
+    TickType_t due = (requests_due < report_due) ? requests_due : report_due;
+    return (credit_due < due) ? credit_due : due;
+}
+
+/**
+ * @brief UART receive task
+ *
+ * Sleeps on the driver event queue; the driver posts UART_DATA when its
+ * FIFO threshold or RX idle timeout fires, so lines are handled as soon
+ * as JanOS goes quiet rather than on a polling tick. One task per link.
+ */
+static void uart_rx_task(void *arg)
+{
+    uart_link_t *link = (uart_link_t *)arg;
+    uart_event_t event;
+    TickType_t wait = portMAX_DELAY;
+    
+    while (1) {
+        BaseType_t got = xQueueReceive(link->event_queue, &event, wait);
+        wait = next_wait(link);
+        if (got != pdTRUE) {
+            continue;
+        }
+        
+        if (link->rx_reset_pending) {
+            link->rx_reset_pending = false;
+            rx_reset(link);
+        }
+#ifdef CONFIG_UART_FLOW_SOFTWARE
+        if (link->credit_restart_pending) {
+            link->credit_restart_pending = false;
+            if (link->flow == UART_FLOW_CREDITS) credit_restart(link);
+        }
+#endif
+        if (link->scan_stop_seq) {
+            uint32_t seq = link->scan_stop_seq;
+            link->scan_stop_seq = 0;
+            if (link->is_scanning && seq == link->scan_seq) {
+                ESP_LOGI(TAG, "%sScan ended by an express command", link->prefix);
+                finish_scan(link);
+            }
+        }
+        
+        switch (event.type) {
+            case UART_DATA:
+                // Line splitting and dispatch run at full CPU speed
+                power_acquire(POWER_LOCK_UART);
+                rx_drain(link);
+                rx_drain_injected(link);
+                power_release(POWER_LOCK_UART);
+                break;
+                
+            case UART_BUFFER_FULL:
+                if (link->flow != UART_FLOW_NONE) {
+                    // The driver stops reading the FIFO and flow control
+                    // holds JanOS off, so nothing is lost yet: catch up
+                    link->stats.flow_holds++;
+                    power_acquire(POWER_LOCK_UART);
+                    rx_drain(link);
+                    power_release(POWER_LOCK_UART);
+                    break;
+                }
+                // fall through
+            case UART_FIFO_OVF:
+                // Data is already lost; resync on the next line boundary
+                if (event.type == UART_FIFO_OVF) {
+                    link->stats.fifo_overflows++;
+                } else {
+                    link->stats.ring_overflows++;
+                }
+                ESP_LOGW(TAG, "%sRX overflow (%s), flushing", link->prefix,
+                         event.type == UART_FIFO_OVF ? "FIFO" : "ring buffer");
+                uart_flush_input(link->port);
+                xQueueReset(link->event_queue);
+                rx_reset(link);
+                link->rx_discarding = true;
+#ifdef CONFIG_UART_FLOW_SOFTWARE
+                if (link->flow == UART_FLOW_CREDITS) credit_restart(link);
+#endif
+                break;
+                
+            case UART_FRAME_ERR:
+            case UART_PARITY_ERR:
+                link->stats.line_errors++;
+                ESP_LOGD(TAG, "RX line error %d", event.type);
+                break;
+                
+            default:
+                break;
+        }
+        
+        // Lines may have completed requests; pick up the new head's deadline
+        wait = next_wait(link);
+    }
+}
+
+/**
+ * @brief Pick software flow control for the link's framing mode
+ *
+ * Binary mode turns XON/XOFF off; credits take over once JanOS has
+ * acknowledged them (negotiate_credits).
+ */
+static void apply_sw_flow(uart_link_t *link)
+{
+#ifdef CONFIG_UART_FLOW_SOFTWARE
+    bool xon_xoff = !link->binary_mode;
+    uart_set_sw_flow_ctrl(link->port, xon_xoff, UART_FLOW_XON_THRESH, UART_FLOW_XOFF_THRESH);
+    link->flow = xon_xoff ? UART_FLOW_XON_XOFF : UART_FLOW_NONE;
+#else
+    link->flow = UART_FLOW_NONE;
+#endif
+}
+
+/**
+ * @brief Configure a link's port, allocate its buffers and start its RX task
+ */
+static esp_err_t link_start(uart_link_t *link, int tx_pin, int rx_pin,
+                            const char *task_name, task_id_t task_id)
+{
+#ifdef CONFIG_UART_FLOW_RTS_CTS
+    bool rts_cts = link->id == UART_LINK_PRIMARY;
+#else
+    bool rts_cts = false;
+#endif
+    uart_config_t uart_config = {
+        .baud_rate = UART_BAUD_RATE,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = rts_cts ? UART_HW_FLOWCTRL_CTS_RTS : UART_HW_FLOWCTRL_DISABLE,
+        .rx_flow_ctrl_thresh = UART_FLOW_XOFF_THRESH,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+
+    esp_err_t ret = uart_param_config(link->port, &uart_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "%sUART param config failed: %s", link->prefix, esp_err_to_name(ret));
+        return ret;
+    }
+
+#ifdef CONFIG_UART_FLOW_RTS_CTS
+    ret = uart_set_pin(link->port, tx_pin, rx_pin,
+                       rts_cts ? UART_RTS_PIN : UART_PIN_NO_CHANGE,
+                       rts_cts ? UART_CTS_PIN : UART_PIN_NO_CHANGE);
+#else
+    ret = uart_set_pin(link->port, tx_pin, rx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+#endif
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "%sUART set pin failed: %s", link->prefix, esp_err_to_name(ret));
+        return ret;
+    }
+
+    link->rx_buffer = heap_caps_malloc(UART_LINE_MAX, RX_BUFFER_CAPS);
+    if (!link->rx_buffer) {
+        link->rx_buffer = malloc(UART_LINE_MAX);
+    }
+    if (!link->rx_buffer) {
+        ESP_LOGE(TAG, "%sFailed to allocate RX line buffer", link->prefix);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ret = uart_driver_install(link->port, UART_RX_RING_SIZE, UART_BUF_SIZE,
+                              UART_EVENT_QUEUE_LEN, &link->event_queue, 0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "%sUART driver install failed: %s", link->prefix, esp_err_to_name(ret));
+        free(link->rx_buffer);
+        link->rx_buffer = NULL;
+        return ret;
+    }
+
+    rx_reset(link);
+    if (rts_cts) {
+        link->flow = UART_FLOW_RTS_CTS;
+    } else {
+        apply_sw_flow(link);
+    }
+
+    // Create RX task
+    BaseType_t task_ret = xTaskCreatePinnedToCore(uart_rx_task, task_name, TASK_UART_RX_STACK, link,
+                                                  TASK_UART_RX_PRIO, &link->task,
+                                                  TASK_UART_RX_CORE);
+    if (task_ret != pdPASS) {
+        ESP_LOGE(TAG, "%sFailed to create UART RX task", link->prefix);
+        uart_driver_delete(link->port);
+        link->event_queue = NULL;
+        return ESP_FAIL;
+    }
+    task_plan_track(task_id, link->task);
+    return ESP_OK;
+}
+
+esp_err_t uart_handler_init(void)
+{
+    int tx_pin = settings_get_uart_tx_pin();
+    int rx_pin = settings_get_uart_rx_pin();
+    
+    ESP_LOGI(TAG, "Initializing UART handler (TX=%d, RX=%d)...", tx_pin, rx_pin);
+
+    // Create mutex
+    uart_mutex = xSemaphoreCreateMutex();
+    if (!uart_mutex) {
+        ESP_LOGE(TAG, "Failed to create mutex");
+        return ESP_FAIL;
+    }
+
+    // Terminal scrollback; the link works without it
+    if (text_log_init(&scrollback, UART_SCROLLBACK_SIZE, UART_SCROLLBACK_LINES, true) != ESP_OK) {
+        ESP_LOGW(TAG, "No memory for %d bytes of terminal scrollback", UART_SCROLLBACK_SIZE);
+    }
+
+    // Scan results land here
+    esp_err_t store_ret = network_store_init();
+    if (store_ret != ESP_OK) {
+        return store_ret;
+    }
+
+    for (int i = 0; i < UART_LINK_COUNT; i++) {
+        links[i].id = (uart_link_id_t)i;
+        links[i].prefix = (i == UART_LINK_PRIMARY) ? "" : "B2 ";
+        links[i].current_baud = UART_BAUD_RATE;
+        links[i].stats.callback_max_route = -1;
+    }
+    PRIMARY->port = UART_PORT_NUM;
+
+    esp_err_t ret = link_start(PRIMARY, tx_pin, rx_pin, "uart_rx", TASK_ID_UART_RX);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+#ifdef CONFIG_UART_SECOND_BOARD
+    // A missing or broken second board leaves the primary working alone
+    uart_link_t *second = &links[UART_LINK_SECONDARY];
+    second->port = UART_SECOND_PORT_NUM;
+    ESP_LOGI(TAG, "Second board on UART%d (TX=%d, RX=%d)", second->port,
+             UART_SECOND_TX_PIN, UART_SECOND_RX_PIN);
+    if (link_start(second, UART_SECOND_TX_PIN, UART_SECOND_RX_PIN,
+                   "uart2_rx", TASK_ID_UART2_RX) == ESP_OK) {
+        uart_link_send_command(UART_LINK_SECONDARY, "ping");
+    }
+#endif
+
+    ESP_LOGI(TAG, "UART handler initialized successfully");
+    return ESP_OK;
+}
+
+/**
+ * @brief Check whether a command is queued as a request (uart_mutex held)
+ */
+static bool is_request(const char *cmd)
+{
+    for (int i = 0; i < request_count; i++) {
+        if (strcmp(requests[(request_head + i) % UART_MAX_PENDING_REQUESTS].cmd, cmd) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Check whether a command's first word is in UART_EXPRESS_CMDS
+ */
+static bool is_express(const char *cmd)
+{
+    size_t word = strcspn(cmd, " \n");
+    for (const char *p = UART_EXPRESS_CMDS; *p; ) {
+        size_t n = strcspn(p, " ");
+        if (n == word && strncmp(p, cmd, n) == 0) return true;
+        p += n;
+        p += strspn(p, " ");
+    }
+    return false;
+}
+
+/**
+ * @brief Account for bytes handed to the driver (uart_mutex held)
+ *
+ * Keeps an estimate of when the driver's TX ring runs empty, which is how
+ * long a command written now waits behind what is already queued.
+ */
+static void note_tx(uart_link_t *link, size_t bytes)
+{
+    int64_t now = esp_timer_get_time();
+    if (link->tx_drain_us < now) link->tx_drain_us = now;
+    link->tx_drain_us += (int64_t)bytes * 10000000 / link->current_baud;
+}
+
+/**
+ * @brief Take uart_mutex for a bulk write
+ *
+ * Waits while an express command is going out or the driver holds more
+ * than UART_BULK_BACKLOG_MS of bytes, so the next express command finds
+ * little ahead of it.
+ */
+static void bulk_lock(uart_link_t *link)
+{
+    const int64_t budget_us = UART_BULK_BACKLOG_MS * 1000;
+    while (1) {
+        xSemaphoreTake(uart_mutex, portMAX_DELAY);
+        int64_t backlog_us = link->tx_drain_us - esp_timer_get_time();
+        if (!__atomic_load_n(&express_waiting, __ATOMIC_ACQUIRE) && backlog_us <= budget_us) {
+            return;
+        }
+        xSemaphoreGive(uart_mutex);
+        
+        TickType_t wait = pdMS_TO_TICKS((backlog_us - budget_us) / 1000);
+        vTaskDelay(wait > 0 ? wait : 1);
+    }
+}
+
+/**
+ * @brief Note a command that ends JanOS's operation (uart_mutex held)
+ *
+ * A scan in progress will not get its end marker; the RX task finishes
+ * it unless another scan has started by then.
+ */
+static void end_operation(uart_link_t *link)
+{
+    if (!link->is_scanning) return;
+    link->scan_stop_seq = link->scan_seq;
+    uart_event_t wake = { .type = RX_WAKE_EVENT };
+    xQueueSend(link->event_queue, &wake, 0);
+}
+
+esp_err_t uart_link_send_command(uart_link_id_t id, const char *cmd)
+{
+    if (!cmd || id >= UART_LINK_COUNT) return ESP_ERR_INVALID_ARG;
+    uart_link_t *link = &links[id];
+    if (!link->event_queue) return ESP_ERR_INVALID_STATE;
+
+    // Express lane: bulk writers stand aside until this one is written
+    bool express = is_express(cmd);
+    int64_t start_us = 0;
+    if (express) {
+        start_us = esp_timer_get_time();
+        __atomic_add_fetch(&express_waiting, 1, __ATOMIC_RELEASE);
+    }
+    
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    
+    uart_log_level_t log_level = settings_get_uart_log_level();
+    if (log_level >= UART_LOG_LINES) {
+        ESP_LOGI(TAG, "%sTX: %s", link->prefix, cmd);
+    }
+    if (log_level >= UART_LOG_VERBOSE) {
+        log_memory_info("TX Command");
+    }
+    
+    int len = strlen(cmd);
+    int written = uart_write_bytes(link->port, cmd, len);
+    
+    // Send newline if not present
+    if (len > 0 && cmd[len - 1] != '\n') {
+        uart_write_bytes(link->port, "\n", 1);
+        link->stats.tx_bytes++;
+        note_tx(link, 1);
+    }
+    link->stats.tx_bytes += (written > 0) ? written : 0;
+    link->stats.tx_lines++;
+    note_tx(link, (written > 0) ? written : 0);
+    link->tx_us = esp_timer_get_time();
+    if (strcmp(cmd, "ping") == 0) link->ping_sent_us = link->tx_us;
+    if (id == UART_LINK_PRIMARY) {
+        cmd_latency_sent(cmd, is_request(cmd) || strcmp(cmd, "scan_networks") == 0);
+        job_manager_note_command(cmd);
+    }
+    if (express) {
+        uint32_t us = (uint32_t)(link->tx_drain_us - start_us);
+        link->stats.express_sent++;
+        if (us > link->stats.express_max_us) link->stats.express_max_us = us;
+        end_operation(link);
+        __atomic_sub_fetch(&express_waiting, 1, __ATOMIC_RELEASE);
+    }
+    
+    xSemaphoreGive(uart_mutex);
+    
+    return (written == len) ? ESP_OK : ESP_FAIL;
+}
+
+#ifdef CONFIG_UART_SECOND_BOARD
+/**
+ * @brief Repeat a primary command on the second board if its first word
+ *        is in UART_SECOND_MIRROR
+ */
+static void mirror_command(const char *cmd)
+{
+    uart_link_t *second = &links[UART_LINK_SECONDARY];
+    if (!second->event_queue) return;
+    
+    size_t word = strcspn(cmd, " \n");
+    for (const char *p = UART_SECOND_MIRROR; *p; ) {
+        size_t n = strcspn(p, " ");
+        if (n == word && strncmp(p, cmd, n) == 0) {
+            // Its rows are then parsed as a scan, like the primary's
+            if (strncmp(cmd, "scan_networks", word) == 0 && word == strlen("scan_networks")) {
+                second->store_full_warned = false;
+                second->is_scanning = true;
+                second->scan_seq++;
+            }
+            uart_link_send_command(UART_LINK_SECONDARY, cmd);
+            return;
+        }
+        p += n;
+        p += strspn(p, " ");
+    }
+}
+#endif
+
+esp_err_t uart_send_command(const char *cmd)
+{
+    esp_err_t ret = uart_link_send_command(UART_LINK_PRIMARY, cmd);
+#ifdef CONFIG_UART_SECOND_BOARD
+    if (ret == ESP_OK) mirror_command(cmd);
+#endif
+    return ret;
+}
+
+esp_err_t uart_write_raw(const void *data, size_t len)
+{
+    if (!data) return ESP_ERR_INVALID_ARG;
+    if (len == 0) return ESP_OK;
+    
+    bulk_lock(PRIMARY);
+    int written = uart_write_bytes(PRIMARY->port, data, len);
+    PRIMARY->stats.tx_bytes += (written > 0) ? written : 0;
+    note_tx(PRIMARY, (written > 0) ? written : 0);
+    xSemaphoreGive(uart_mutex);
+    
+    return (written == (int)len) ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @brief Encode and write one frame to the primary board
+ * @param bulk Bulk lane (bulk_lock) rather than at once
+ */
+static esp_err_t send_frame(bool bulk, uint8_t type, const void *payload, uint16_t len)
+{
+    if (!PRIMARY->binary_mode) return ESP_ERR_INVALID_STATE;
+    
+    uint8_t buf[UART_FRAME_MAX_PAYLOAD + UART_FRAME_OVERHEAD];
+    size_t n = uart_frame_encode(type, payload, len, buf, sizeof(buf));
+    if (n == 0) return ESP_ERR_INVALID_SIZE;
+    
+    if (bulk) {
+        bulk_lock(PRIMARY);
+    } else {
+        xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    }
+    if (settings_get_uart_log_level() >= UART_LOG_LINES) {
+        ESP_LOGI(TAG, "TX: frame 0x%02X, %u bytes", type, (unsigned)len);
+    }
+    int written = uart_write_bytes(PRIMARY->port, buf, n);
+    PRIMARY->stats.tx_bytes += (written > 0) ? written : 0;
+    note_tx(PRIMARY, (written > 0) ? written : 0);
+    xSemaphoreGive(uart_mutex);
+    
+    return (written == (int)n) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t uart_send_frame(uint8_t type, const void *payload, uint16_t len)
+{
+    return send_frame(false, type, payload, len);
+}
+
+esp_err_t uart_send_bulk_frame(uint8_t type, const void *payload, uint16_t len)
+{
+    return send_frame(true, type, payload, len);
+}
+
+void uart_register_line_callback(uart_response_callback_t callback, void *user_data)
+{
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    set_route(ROUTE_SLOT_LINE, UART_LINK_MASK(UART_LINK_PRIMARY), UART_ROUTE_ANY, NULL,
+              callback, user_data);
+    xSemaphoreGive(uart_mutex);
+    wait_for_dispatch(ROUTE_SLOT_LINE);
+}
+
+void uart_register_monitor_callback(uart_response_callback_t callback, void *user_data)
+{
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    set_route(ROUTE_SLOT_MONITOR, UART_LINK_MASK(UART_LINK_PRIMARY), UART_ROUTE_ANY, NULL,
+              callback, user_data);
+    xSemaphoreGive(uart_mutex);
+    wait_for_dispatch(ROUTE_SLOT_MONITOR);
+}
+
+void uart_clear_line_callback(void)
+{
+    uart_register_line_callback(NULL, NULL);
+}
+
+void uart_clear_monitor_callback(void)
+{
+    uart_register_monitor_callback(NULL, NULL);
+}
+
+int uart_subscribe_lines(uart_route_kind_t kind, const char *pattern,
+                         uart_response_callback_t callback, void *user_data)
+{
+    return uart_subscribe_link_lines(UART_LINK_MASK(UART_LINK_PRIMARY), kind, pattern,
+                                     callback, user_data);
+}
+
+int uart_subscribe_link_lines(uint8_t links_heard, uart_route_kind_t kind, const char *pattern,
+                              uart_response_callback_t callback, void *user_data)
+{
+    if (!callback || !links_heard) return -1;
+    if (kind != UART_ROUTE_ANY) {
+        size_t len = pattern ? strlen(pattern) : 0;
+        if (len == 0 || len >= UART_ROUTE_PATTERN_LEN) return -1;
+        if (kind == UART_ROUTE_TAG && (pattern[0] != '[' || len < 2)) return -1;
+    }
+    
+    int handle = -1;
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    for (int i = ROUTE_SLOT_FIRST; i < UART_MAX_LINE_ROUTES; i++) {
+        if (!routes[i].callback) {
+            set_route(i, links_heard, kind, pattern, callback, user_data);
+            handle = i;
+            break;
+        }
+    }
+    xSemaphoreGive(uart_mutex);
+    
+    if (handle < 0) {
+        ESP_LOGW(TAG, "No free line route for '%s'", pattern ? pattern : "*");
+    }
+    return handle;
+}
+
+void uart_unsubscribe_lines(int handle)
+{
+    if (handle < ROUTE_SLOT_FIRST || handle >= UART_MAX_LINE_ROUTES) return;
+    
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    set_route(handle, 0, UART_ROUTE_ANY, NULL, NULL, NULL);
+    xSemaphoreGive(uart_mutex);
+    wait_for_dispatch(handle);
+}
+
+void uart_pause_lines(int handle, bool paused)
+{
+    if (handle < ROUTE_SLOT_FIRST || handle >= UART_MAX_LINE_ROUTES) return;
+    
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    if (routes[handle].callback && routes[handle].paused != paused) {
+        routes[handle].paused = paused;
+        rebuild_route_tables();
+    }
+    xSemaphoreGive(uart_mutex);
+}
+
+/**
+ * @brief Add a request to the reply queue without sending its command
+ */
+static esp_err_t queue_request(const uart_request_t *req)
+{
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    if (request_count >= UART_MAX_PENDING_REQUESTS) {
+        xSemaphoreGive(uart_mutex);
+        ESP_LOGW(TAG, "Request queue full, dropping '%s'", req->cmd);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    pending_request_t *r = &requests[(request_head + request_count) % UART_MAX_PENDING_REQUESTS];
+    memset(r, 0, sizeof(*r));
+    r->id = next_request_id++;
+    strlcpy(r->cmd, req->cmd, sizeof(r->cmd));
+    if (req->end_marker) {
+        strlcpy(r->end_marker, req->end_marker, sizeof(r->end_marker));
+    }
+    r->on_line = req->on_line;
+    r->on_done = req->on_done;
+    r->user_data = req->user_data;
+    r->timeout = pdMS_TO_TICKS(req->timeout_ms > 0 ? req->timeout_ms : UART_REQUEST_TIMEOUT_MS);
+    r->started = xTaskGetTickCount();
+    request_count++;
+    xSemaphoreGive(uart_mutex);
+    
+    // Let the RX task re-arm its wait for the head deadline
+    uart_event_t wake = { .type = RX_WAKE_EVENT };
+    xQueueSend(PRIMARY->event_queue, &wake, 0);
+    return ESP_OK;
+}
+
+esp_err_t uart_request(const uart_request_t *req)
+{
+    if (!req || !req->cmd) return ESP_ERR_INVALID_ARG;
+    
+    esp_err_t ret = queue_request(req);
+    if (ret != ESP_OK) return ret;
+    return uart_send_command(req->cmd);
+}
+
+esp_err_t uart_send_batch(const char *const *cmds, int count,
+                          uart_request_done_cb_t on_done, void *user_data)
+{
+    if (!cmds || count <= 0 || count > UART_BATCH_MAX_CMDS) return ESP_ERR_INVALID_ARG;
+    
+    char buf[UART_BATCH_MAX_BYTES];
+    size_t len = 0;
+    int lines = count + (on_done ? 1 : 0);
+    for (int i = 0; i < lines; i++) {
+        const char *cmd = (i < count) ? cmds[i] : UART_BATCH_FENCE_CMD;
+        if (!cmd) return ESP_ERR_INVALID_ARG;
+        
+        size_t n = strlen(cmd);
+        if (n > 0 && cmd[n - 1] == '\n') n--;
+        if (len + n + 1 > sizeof(buf)) return ESP_ERR_INVALID_SIZE;
+        memcpy(buf + len, cmd, n);
+        len += n;
+        buf[len++] = '\n';
+    }
+    
+    // Queue the fence first so its reply cannot arrive before it is expected
+    if (on_done) {
+        const uart_request_t fence = {
+            .cmd = UART_BATCH_FENCE_CMD,
+            .end_marker = UART_BATCH_FENCE_REPLY,
+            .on_done = on_done,
+            .user_data = user_data,
+            .timeout_ms = UART_BATCH_TIMEOUT_MS,
+        };
+        esp_err_t ret = queue_request(&fence);
+        if (ret != ESP_OK) return ret;
+    }
+    
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    
+    uart_log_level_t log_level = settings_get_uart_log_level();
+    if (log_level >= UART_LOG_LINES) {
+        char shown[UART_BATCH_MAX_BYTES];
+        memcpy(shown, buf, len - 1);
+        shown[len - 1] = '\0';
+        for (char *p = shown; (p = strchr(p, '\n')) != NULL; ) *p = ';';
+        ESP_LOGI(TAG, "TX batch: %s", shown);
+    }
+    
+    int written = uart_write_bytes(PRIMARY->port, buf, len);
+    PRIMARY->stats.tx_bytes += (written > 0) ? written : 0;
+    PRIMARY->stats.tx_lines += lines;
+    note_tx(PRIMARY, (written > 0) ? written : 0);
+    PRIMARY->tx_us = esp_timer_get_time();
+    for (int i = 0; i < count; i++) {
+        job_manager_note_command(cmds[i]);
+        if (is_express(cmds[i])) end_operation(PRIMARY);
+    }
+    
+    xSemaphoreGive(uart_mutex);
+    
+    return (written == (int)len) ? ESP_OK : ESP_FAIL;
+}
+
+int uart_cancel_requests(void *user_data)
+{
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    int removed = request_count;
+    int kept = 0;
+    for (int i = 0; i < request_count; i++) {
+        pending_request_t *r = &requests[(request_head + i) % UART_MAX_PENDING_REQUESTS];
+        if (r->user_data == user_data) continue;
+        if (kept != i) {
+            requests[(request_head + kept) % UART_MAX_PENDING_REQUESTS] = *r;
+        }
+        kept++;
+    }
+    if (kept > 0 && kept != request_count) {
+        requests[request_head].started = xTaskGetTickCount();
+    }
+    request_count = kept;
+    removed -= kept;
+    xSemaphoreGive(uart_mutex);
+    return removed;
+}
+
+// Completion state for uart_request_sync
+typedef struct {
+    SemaphoreHandle_t done;
+    volatile bool ok;
+} sync_request_t;
+
+static void sync_request_done(uart_request_status_t status, void *user_data)
 {
-    ESP_LOGI(TAG, "Checking board connection (ping)...");
+    sync_request_t *sync = (sync_request_t *)user_data;
+    sync->ok = (status == UART_REQUEST_DONE);
+    xSemaphoreGive(sync->done);
+}
+
+bool uart_request_sync(const char *cmd, const char *reply, int timeout_ms)
+{
+    sync_request_t sync = { .done = xSemaphoreCreateBinary(), .ok = false };
+    if (!sync.done) return false;
+    
+    uart_request_t req = {
+        .cmd = cmd,
+        .end_marker = reply,
+        .on_done = sync_request_done,
+        .user_data = &sync,
+        .timeout_ms = timeout_ms,
+    };
+    
+    // Requests queued ahead of us may delay our turn; allow for one of them
+    if (uart_request(&req) == ESP_OK &&
+        xSemaphoreTake(sync.done, pdMS_TO_TICKS(timeout_ms + UART_REQUEST_TIMEOUT_MS)) != pdTRUE &&
+        uart_cancel_requests(&sync) == 0) {
+        // The RX task popped it already and is about to call sync_request_done,
+        // which still needs sync and its semaphore
+        xSemaphoreTake(sync.done, portMAX_DELAY);
+    }
+    
+    vSemaphoreDelete(sync.done);
+    return sync.ok;
+}
+
+void uart_set_raw_tap(uart_raw_tap_t tap, void *user_data)
+{
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    raw_tap = tap;
+    raw_tap_user_data = user_data;
+    xSemaphoreGive(uart_mutex);
+}
+
+void uart_register_frame_callback(uart_frame_callback_t callback, void *user_data)
+{
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    frame_callback = callback;
+    frame_callback_user_data = user_data;
+    xSemaphoreGive(uart_mutex);
+}
+
+void uart_clear_frame_callback(void)
+{
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    frame_callback = NULL;
+    frame_callback_user_data = NULL;
+    xSemaphoreGive(uart_mutex);
+}
+
+bool uart_is_binary_mode(void)
+{
+    return PRIMARY->binary_mode;
+}
+
+uart_quiet_t uart_get_quiet(void)
+{
+    return PRIMARY->quiet;
+}
+
+esp_err_t uart_start_wifi_scan(uart_scan_complete_callback_t callback, void *user_data)
+{
+    return uart_start_wifi_scan_streaming(NULL, callback, user_data);
+}
+
+/**
+ * @brief Enter scan mode and send scan_networks
+ * @param clear Empty the network store first (false: rows update in place)
+ */
+static esp_err_t start_scan(bool clear, uart_scan_result_callback_t on_result,
+                            uart_scan_complete_callback_t on_complete, void *user_data)
+{
+    if (PRIMARY->is_scanning) {
+        ESP_LOGW(TAG, "Scan already in progress");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    
+    // Reset state
+    if (clear) {
+        network_store_clear();
+    }
+    network_store_begin_pass();
+    PRIMARY->store_full_warned = false;
+    PRIMARY->is_scanning = true;
+    PRIMARY->scan_seq++;
+    scan_callback = on_complete;
+    scan_result_callback = on_result;
+    scan_callback_user_data = user_data;
+    
+    xSemaphoreGive(uart_mutex);
+    
+    uart_progress_begin(UART_OP_WIFI_SCAN, "Starting scan...", 0);
+
+    // Send scan command
+    return uart_send_command("scan_networks");
+}
+
+esp_err_t uart_start_wifi_scan_streaming(uart_scan_result_callback_t on_result,
+                                         uart_scan_complete_callback_t on_complete,
+                                         void *user_data)
+{
+    return start_scan(true, on_result, on_complete, user_data);
+}
+
+esp_err_t uart_refresh_wifi_scan(uart_scan_result_callback_t on_result,
+                                 uart_scan_complete_callback_t on_complete,
+                                 void *user_data)
+{
+    return start_scan(false, on_result, on_complete, user_data);
+}
+
+bool uart_rescan_if_due(uint32_t interval_ms)
+{
+    if (PRIMARY->is_scanning || last_scan_end_ms == 0) return false;
+    interval_ms = power_governor_scale_ms(interval_ms);
+    if (esp_timer_get_time() / 1000 - last_scan_end_ms < interval_ms) return false;
+    return start_scan(false, NULL, NULL, NULL) == ESP_OK;
+}
+
+/**
+ * @brief Length of the run of consecutive ids starting at ids[0]
+ */
+static int id_run(const uint16_t *ids, int count)
+{
+    int n = 1;
+    while (n < count && ids[n] <= ids[n - 1] + 1) n++;
+    return n;
+}
+
+static esp_err_t send_select_frame(const uint16_t *ids, int count)
+{
+    uint8_t payload[1 + UART_SELECT_MAX_RANGES * UART_SELECT_RANGE_SIZE];
+    uint8_t *p = payload + 1;
+    int ranges = 0;
+    for (int i = 0; i < count; ranges++) {
+        if (ranges == UART_SELECT_MAX_RANGES) return ESP_ERR_INVALID_SIZE;
+        int run = id_run(&ids[i], count - i);
+        uint16_t first = ids[i], last = ids[i + run - 1];
+        *p++ = first & 0xFF;
+        *p++ = first >> 8;
+        *p++ = last & 0xFF;
+        *p++ = last >> 8;
+        i += run;
+    }
+    payload[0] = ranges;
+    return uart_send_frame(UART_FRAME_SELECT_NETWORKS, payload, (uint16_t)(p - payload));
+}
+
+esp_err_t uart_select_networks(const uint16_t *ids, int count)
+{
+    if (!ids || count <= 0) return ESP_ERR_INVALID_ARG;
+    
+    if (PRIMARY->binary_mode) {
+        esp_err_t ret = send_select_frame(ids, count);
+        if (ret != ESP_ERR_INVALID_SIZE && ret != ESP_ERR_INVALID_STATE) return ret;
+    }
+    
+    // Worst case " 65535" per id; ranges only ever shorten that
+    size_t size = sizeof("select_networks") + (size_t)count * 6;
+    char *cmd = malloc(size);
+    if (!cmd) return ESP_ERR_NO_MEM;
+    
+    size_t len = strlcpy(cmd, "select_networks", size);
+    for (int i = 0; i < count;) {
+#ifdef CONFIG_JANOS_SELECT_RANGES
+        int run = id_run(&ids[i], count - i);
+        char sep = (i == 0) ? ' ' : ',';
+        if (run > 1) {
+            len += snprintf(cmd + len, size - len, "%c%u-%u", sep, ids[i], ids[i + run - 1]);
+        } else {
+            len += snprintf(cmd + len, size - len, "%c%u", sep, ids[i]);
+        }
+        i += run;
+#else
+        len += snprintf(cmd + len, size - len, " %u", ids[i]);
+        i++;
+#endif
+    }
+    esp_err_t ret = uart_send_command(cmd);
+    free(cmd);
+    return ret;
+}
+
+void uart_detach_wifi_scan(void *user_data)
+{
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    if (scan_callback_user_data == user_data) {
+        scan_callback = NULL;
+        scan_result_callback = NULL;
+        scan_callback_user_data = NULL;
+    }
+    xSemaphoreGive(uart_mutex);
+}
+
+bool uart_is_scanning(void)
+{
+    return PRIMARY->is_scanning;
+}
+
+bool uart_link_idle(uint32_t quiet_ms)
+{
+    xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    bool idle = request_count == 0 && !PRIMARY->is_scanning;
+    int64_t last_us = PRIMARY->tx_us > PRIMARY->rx_read_us ? PRIMARY->tx_us : PRIMARY->rx_read_us;
+    xSemaphoreGive(uart_mutex);
+    return idle && esp_timer_get_time() - last_us >= (int64_t)quiet_ms * 1000;
+}
+
+const char* uart_get_scan_status(void)
+{
+    uart_progress_record_t progress;
+    if (uart_progress_get(UART_OP_WIFI_SCAN, &progress) == 0) {
+        return "Ready";
+    }
+    if (progress.state == UART_PROGRESS_RUNNING && progress.done > 0) {
+        snprintf(scan_status, sizeof(scan_status), "Scanning... %u networks", progress.done);
+    } else {
+        strlcpy(scan_status, progress.text, sizeof(scan_status));
+    }
+    return scan_status;
+}
+
+bool uart_is_wifi_connected(void)
+{
+    return wifi_connected;
+}
+
+void uart_set_wifi_connected(bool connected)
+{
+    wifi_connected = connected;
+}
+
+/**
+ * @brief Whether to leave out an offer JanOS refused last boot (board_cache)
+ */
+static bool skip_offer(uint8_t cap, bool use_cache, const char *what)
+{
+    if (!use_cache || !board_cache_skip(cap)) return false;
+    ESP_LOGI(TAG, "%s not offered, refused last boot", what);
+    return true;
+}
+
+/**
+ * @brief Ask JanOS to send binary-mode bytes against credits only
+ *
+ * Bytes arriving between the ack and the switch below are not counted,
+ * which only makes the limits a little conservative.
+ */
+static void negotiate_credits(int timeout_ms, bool use_cache)
+{
+#ifdef CONFIG_UART_FLOW_SOFTWARE
+    if (skip_offer(BOARD_CAP_CREDITS, use_cache, "Credit flow control")) return;
+    
+    char cmd[32];
+    snprintf(cmd, sizeof(cmd), "%s %u", UART_PROTO_CREDIT_CMD, (unsigned)UART_CREDIT_WINDOW);
+    bool acked = uart_request_sync(cmd, UART_PROTO_CREDIT_ACK, timeout_ms);
+    board_cache_note(BOARD_CAP_CREDITS, acked);
+    if (acked) {
+        PRIMARY->credit_consumed = 0;
+        PRIMARY->credit_limit = UART_CREDIT_WINDOW;
+        PRIMARY->credit_sent = xTaskGetTickCount();
+        PRIMARY->flow = UART_FLOW_CREDITS;
+        ESP_LOGI(TAG, "Credit flow control, %u byte window", (unsigned)UART_CREDIT_WINDOW);
+    } else {
+        ESP_LOGW(TAG, "Credits not acknowledged, binary mode without flow control");
+    }
+#else
+    (void)timeout_ms;
+    (void)use_cache;
+#endif
+}
+
+/**
+ * @brief Offer compressed bulk output; buffers are kept once allocated
+ */
+static void negotiate_bulk(int timeout_ms, bool use_cache)
+{
+#ifdef CONFIG_UART_BULK_COMPRESSION
+    if (skip_offer(BOARD_CAP_BULK, use_cache, "Compressed bulk transfers")) return;
+    
+    // Ready before asking: blocks may follow the ack immediately
+    if (!PRIMARY->bulk) {
+        PRIMARY->bulk = heap_caps_malloc(sizeof(uart_bulk_decoder_t), RX_BUFFER_CAPS);
+        PRIMARY->bulk_line = heap_caps_malloc(UART_LINE_MAX, RX_BUFFER_CAPS);
+        if (!PRIMARY->bulk || !PRIMARY->bulk_line) {
+            ESP_LOGW(TAG, "No memory for compressed transfers");
+            free(PRIMARY->bulk);
+            free(PRIMARY->bulk_line);
+            PRIMARY->bulk = NULL;
+            PRIMARY->bulk_line = NULL;
+            return;
+        }
+        uart_bulk_reset(PRIMARY->bulk);
+        PRIMARY->bulk_line_len = 0;
+    }
+    
+    char cmd[32];
+    snprintf(cmd, sizeof(cmd), "%s %u", UART_PROTO_LZ4_CMD, (unsigned)UART_BULK_WINDOW);
+    bool acked = uart_request_sync(cmd, UART_PROTO_LZ4_ACK, timeout_ms);
+    board_cache_note(BOARD_CAP_BULK, acked);
+    if (acked) {
+        ESP_LOGI(TAG, "Compressed bulk transfers enabled");
+    } else {
+        ESP_LOGI(TAG, "Compressed bulk transfers not supported");
+    }
+#else
+    (void)timeout_ms;
+    (void)use_cache;
+#endif
+}
+
+/**
+ * @brief Ask JanOS to keep log and echo lines off the link
+ *
+ * In binary mode they are asked for as log frames, so the terminal still
+ * shows them; JanOS suppresses them while the link is in text mode.
+ */
+static void negotiate_quiet(int timeout_ms, bool use_cache)
+{
+#ifdef CONFIG_UART_QUIET_LINK
+    if (skip_offer(BOARD_CAP_QUIET, use_cache, "Quiet link")) return;
+    
+    bool framed = PRIMARY->binary_mode;
+    bool acked = uart_request_sync(framed ? UART_PROTO_QUIET_CMD " frame" : UART_PROTO_QUIET_CMD,
+                                   UART_PROTO_QUIET_ACK, timeout_ms);
+    board_cache_note(BOARD_CAP_QUIET, acked);
+    if (acked) {
+        PRIMARY->quiet = framed ? UART_QUIET_FRAMED : UART_QUIET_SUPPRESS;
+        ESP_LOGI(TAG, "Quiet link, JanOS logs %s", framed ? "framed" : "suppressed");
+    } else {
+        ESP_LOGI(TAG, "Quiet link not supported, JanOS logs stay on the link");
+    }
+#else
+    (void)timeout_ms;
+    (void)use_cache;
+#endif
+}
+
+/**
+ * @brief Offer binary framing to JanOS; stay in text mode if not acknowledged
+ * @param use_cache Leave out offers JanOS refused last boot (boot probe)
+ */
+static void negotiate_binary_mode(int timeout_ms, bool use_cache)
+{
+    if (skip_offer(BOARD_CAP_BINARY, use_cache, "Binary framing")) return;
+    
+    bool acked = uart_request_sync(UART_PROTO_BINARY_CMD, UART_PROTO_BINARY_ACK, timeout_ms);
+    board_cache_note(BOARD_CAP_BINARY, acked);
+    if (acked) {
+        uart_frame_decoder_reset(&PRIMARY->frame_decoder);
+        PRIMARY->binary_mode = true;
+        ESP_LOGI(TAG, "Binary framing enabled");
+        if (PRIMARY->flow != UART_FLOW_RTS_CTS) {
+            apply_sw_flow(PRIMARY);
+            negotiate_credits(timeout_ms, use_cache);
+        }
+        negotiate_bulk(timeout_ms, use_cache);
+    } else {
+        ESP_LOGI(TAG, "Binary framing not supported, using text protocol");
+    }
+}
+
+/**
+ * @brief Switch the local UART and drop any half-received line
+ */
+static void apply_baud_rate(uint32_t baud)
+{
+    uart_wait_tx_done(PRIMARY->port, pdMS_TO_TICKS(100));
+    uart_set_baudrate(PRIMARY->port, baud);
+    uart_flush_input(PRIMARY->port);
+    PRIMARY->rx_reset_pending = true;
+    PRIMARY->credit_restart_pending = true;
+    PRIMARY->current_baud = baud;
+}
+
+/**
+ * @brief Error-rate check: every ping of a short burst must be answered
+ */
+static bool verify_link(void)
+{
+    for (int i = 0; i < UART_BAUD_VERIFY_PINGS; i++) {
+        if (!uart_request_sync("ping", "pong", UART_BAUD_VERIFY_MS)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Ask JanOS to move to a new rate and verify the link there
+ *
+ * JanOS acknowledges at the old rate, switches, and expects "baud confirm"
+ * at the new rate; if it does not arrive it returns to the previous rate on
+ * its own, so a failed step only costs UART_BAUD_REVERT_MS.
+ */
+static bool try_baud_rate(uint32_t baud)
+{
+    char cmd[32];
+    char ack[40];
+    snprintf(cmd, sizeof(cmd), "baud %lu", (unsigned long)baud);
+    snprintf(ack, sizeof(ack), "baud %lu ok", (unsigned long)baud);
     
-    // Reset pong flag
-    pong_received = false;
+    uint32_t prev = PRIMARY->current_baud;
+    if (!uart_request_sync(cmd, ack, UART_BAUD_ACK_MS)) {
+        return false;
+    }
     
-    // Register our callback temporarily
-    uart_response_callback_t old_callback = line_callback;
-    void *old_user_data = line_callback_user_data;
+    apply_baud_rate(baud);
+    if (verify_link()) {
+        uart_send_command("baud confirm");
+        ESP_LOGI(TAG, "UART link running at %lu baud", (unsigned long)baud);
+        board_cache_note_baud(baud, true);
+        return true;
+    }
     
-    uart_register_line_callback(ping_response_callback, NULL);
+    ESP_LOGW(TAG, "Link check failed at %lu baud, reverting to %lu",
+             (unsigned long)baud, (unsigned long)prev);
+    board_cache_note_baud(baud, false);
+    vTaskDelay(pdMS_TO_TICKS(UART_BAUD_REVERT_MS));
+    apply_baud_rate(prev);
+    return false;
+}
+
+/**
+ * @brief Step the link up to the fastest rate both sides sustain
+ *
+ * Tries the last good rate from settings first so normal boots need a
+ * single step, then climbs the ladder from the current rate, stopping
+ * below a rate that failed on an earlier boot (board_cache).
+ */
+static void negotiate_baud_rate(void)
+{
+    static const uint32_t ladder[] = UART_BAUD_LADDER;
+    const int ladder_len = sizeof(ladder) / sizeof(ladder[0]);
+    uint32_t ceiling = board_cache_baud_ceiling();
     
-    // Send ping command
-    uart_send_command("ping");
+    uint32_t saved = settings_get_uart_baud();
+    if (saved > PRIMARY->current_baud && (!ceiling || saved < ceiling)) {
+        try_baud_rate(saved);
+    }
     
-    // Wait for pong with timeout
-    int elapsed = 0;
-    const int check_interval = 10;  // Check every 10ms
+    for (int i = 0; i < ladder_len; i++) {
+        if (ladder[i] <= PRIMARY->current_baud) continue;
+        if (ceiling && ladder[i] >= ceiling) break;
+        if (!try_baud_rate(ladder[i])) break;
+    }
     
-    while (elapsed < timeout_ms && !pong_received) {
-        vTaskDelay(pdMS_TO_TICKS(check_interval));
-        elapsed += check_interval;
+    if (PRIMARY->current_baud != settings_get_uart_baud()) {
+        settings_set_uart_baud(PRIMARY->current_baud);
     }
+}
+
+bool uart_check_board_ping(int timeout_ms)
+{
+    ESP_LOGI(TAG, "Checking board connection (ping)...");
     
-    // Restore previous callback
-    uart_register_line_callback(old_callback, old_user_data);
+    bool pong_received = uart_request_sync("ping", "pong", timeout_ms);
     
     if (pong_received) {
         ESP_LOGI(TAG, "Board detected successfully");
+#ifdef CONFIG_UART_BAUD_NEGOTIATION
+        if (!PRIMARY->baud_negotiated) {
+            PRIMARY->baud_negotiated = true;
+            negotiate_baud_rate();
+        }
+#endif
+#ifdef CONFIG_UART_BINARY_PROTOCOL
+        if (!PRIMARY->binary_mode) {
+            negotiate_binary_mode(UART_PROTO_NEGOTIATE_MS, true);
+        }
+#endif
+        // After framing, so the logs can be asked for as frames
+        if (PRIMARY->quiet == UART_QUIET_OFF) {
+            negotiate_quiet(UART_PROTO_NEGOTIATE_MS, true);
+        }
     } else {
         ESP_LOGW(TAG, "Board not detected (timeout after %dms)", timeout_ms);
     }
     
+    bus_event_t event = { .type = BUS_EVENT_LINK_STATE };
+    event.link.up = pong_received;
+    event.link.binary = PRIMARY->binary_mode;
+    event.link.baud = PRIMARY->current_baud;
+    event_bus_publish(&event);
+    
     return pong_received;
 }
+
+text_log_t* uart_scrollback(void)
+{
+    return scrollback.bytes ? &scrollback : NULL;
+}
+
+bool uart_set_link_baud(uint32_t baud)
+{
+    if (baud == PRIMARY->current_baud) return true;
+    return try_baud_rate(baud);
+}
+
+bool uart_set_binary_mode(bool binary)
+{
+    if (binary == PRIMARY->binary_mode) return true;
+    if (binary) {
+        negotiate_binary_mode(UART_PROTO_NEGOTIATE_MS, false);
+        // Suppressed logs can come back as frames now
+        if (PRIMARY->binary_mode && PRIMARY->quiet == UART_QUIET_SUPPRESS) {
+            negotiate_quiet(UART_PROTO_NEGOTIATE_MS, false);
+        }
+    } else if (uart_request_sync(UART_PROTO_TEXT_CMD, UART_PROTO_TEXT_ACK,
+                                 UART_PROTO_NEGOTIATE_MS)) {
+        PRIMARY->binary_mode = false;
+        uart_frame_decoder_reset(&PRIMARY->frame_decoder);
+        // No frames in text mode: JanOS suppresses the logs instead
+        if (PRIMARY->quiet == UART_QUIET_FRAMED) PRIMARY->quiet = UART_QUIET_SUPPRESS;
+        if (PRIMARY->flow != UART_FLOW_RTS_CTS) {
+            apply_sw_flow(PRIMARY);
+        }
+        ESP_LOGI(TAG, "Binary framing disabled");
+    }
+    return PRIMARY->binary_mode == binary;
+}
+
+esp_err_t uart_link_wait_tx_done(uart_link_id_t id, int timeout_ms)
+{
+    if (id >= UART_LINK_COUNT || !links[id].event_queue) return ESP_ERR_INVALID_ARG;
+    return uart_wait_tx_done(links[id].port, pdMS_TO_TICKS(timeout_ms));
+}
+
+uint32_t uart_get_baud_rate(void)
+{
+    return PRIMARY->current_baud;
+}
+
+void uart_get_link_stats(uart_link_stats_t *out)
+{
+    uart_link_get_stats(UART_LINK_PRIMARY, out);
+}
+
+void uart_link_get_stats(uart_link_id_t id, uart_link_stats_t *out)
+{
+    if (!out || id >= UART_LINK_COUNT) return;
+    
+    const uart_link_t *link = &links[id];
+    *out = link->stats;
+    out->callback_avg_us = link->stats.callback_calls ?
+        (uint32_t)(link->callback_total_us / link->stats.callback_calls) : 0;
+    out->rx_stack_free = link->task ?
+        uxTaskGetStackHighWaterMark(link->task) : 0;
+    out->flow = link->flow;
+}
+
+bool uart_link_is_up(uart_link_id_t id)
+{
+    // Every board answers the ping sent at start, so one line is enough
+    return id < UART_LINK_COUNT && links[id].stats.rx_lines > 0;
+}
+
+uart_link_id_t uart_line_link(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < UART_LINK_COUNT; i++) {
+        if (links[i].task == self) return (uart_link_id_t)i;
+    }
+    return UART_LINK_PRIMARY;
+}
+
+int64_t uart_line_time_us(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < UART_LINK_COUNT; i++) {
+        if (links[i].task == self) return links[i].line_time_us;
+    }
+    return time_sync_now_us();
+}
+
+void uart_reset_link_stats(void)
+{
+    memset(&PRIMARY->stats, 0, sizeof(PRIMARY->stats));
+    PRIMARY->stats.callback_max_route = -1;
+    PRIMARY->callback_total_us = 0;
+    PRIMARY->last_report = 0;    // Restart the throughput window
+}
+
+void uart_wake_rx(void)
+{
+    uart_event_t wake = { .type = RX_WAKE_EVENT };
+    for (int i = 0; i < UART_LINK_COUNT; i++) {
+        if (links[i].event_queue) {
+            xQueueSend(links[i].event_queue, &wake, 0);
+        }
+    }
+}
+
+esp_err_t uart_inject_rx(const void *data, size_t len, int wait_ms)
+{
+    if (!PRIMARY->event_queue) return ESP_ERR_INVALID_STATE;
+    
+    if (!inject_buffer) {
+        xSemaphoreTake(uart_mutex, portMAX_DELAY);
+        if (!inject_buffer) {
+            inject_buffer = xRingbufferCreate(INJECT_BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+        }
+        xSemaphoreGive(uart_mutex);
+        if (!inject_buffer) return ESP_ERR_NO_MEM;
+    }
+    
+    const uint8_t *p = data;
+    while (len > 0) {
+        size_t n = len > INJECT_CHUNK_MAX ? INJECT_CHUNK_MAX : len;
+        if (xRingbufferSend(inject_buffer, p, n, pdMS_TO_TICKS(wait_ms)) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+        p += n;
+        len -= n;
+        
+        // Wake the RX task the way the driver does
+        uart_event_t event = { .type = UART_DATA };
+        xQueueSend(PRIMARY->event_queue, &event, 0);
+    }
+    return ESP_OK;
+}
@@ -6,17 +6,119 @@
 #ifndef UART_HANDLER_H
 #define UART_HANDLER_H
 
+#include "sdkconfig.h"
 #include "esp_err.h"
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 // UART Configuration
 #define UART_PORT_NUM       UART_NUM_1
 #define UART_BAUD_RATE      115200
+#ifdef CONFIG_UART_TX_BUFFER_SIZE
+#define UART_BUF_SIZE       CONFIG_UART_TX_BUFFER_SIZE
+#else
 #define UART_BUF_SIZE       4096
+#endif
+
+// RX path: driver ring + event queue, lines assembled in a separate buffer
+// (PSRAM when CONFIG_UART_RX_BUFFER_PSRAM) and processed in place
+#ifdef CONFIG_UART_RX_RING_SIZE
+#define UART_RX_RING_SIZE       CONFIG_UART_RX_RING_SIZE
+#else
+#define UART_RX_RING_SIZE       16384
+#endif
+#define UART_EVENT_QUEUE_LEN    32
+
+// Scrollback of received lines for the terminal screen (text_log.h)
+#ifdef CONFIG_TERMINAL_SCROLLBACK_SIZE
+#define UART_SCROLLBACK_SIZE    CONFIG_TERMINAL_SCROLLBACK_SIZE
+#else
+#define UART_SCROLLBACK_SIZE    8192
+#endif
+#define UART_SCROLLBACK_LINES   (UART_SCROLLBACK_SIZE / 32)
+#ifdef CONFIG_UART_LINE_MAX
+#define UART_LINE_MAX           CONFIG_UART_LINE_MAX
+#else
+#define UART_LINE_MAX           4096
+#endif
+
+// JanOS boards. The primary is the one every call without a link argument
+// talks to; a second board (CONFIG_UART_SECOND_BOARD) takes UART2 from the
+// CAP GPS and feeds the same parsers and stores.
+typedef enum {
+    UART_LINK_PRIMARY = 0,
+    UART_LINK_SECONDARY,
+} uart_link_id_t;
+
+#ifdef CONFIG_UART_SECOND_BOARD
+#define UART_LINK_COUNT         2
+#define UART_SECOND_PORT_NUM    UART_NUM_2
+#define UART_SECOND_TX_PIN      CONFIG_UART_SECOND_TX_PIN
+#define UART_SECOND_RX_PIN      CONFIG_UART_SECOND_RX_PIN
+#define UART_SECOND_MIRROR      CONFIG_UART_SECOND_MIRROR
+#else
+#define UART_LINK_COUNT         1
+#endif
+#define UART_LINK_MASK(id)      (1u << (id))
+#define UART_LINK_MASK_ALL      ((1u << UART_LINK_COUNT) - 1)
+
+// Baud negotiation: handshake always starts at UART_BAUD_RATE
+#define UART_BAUD_LADDER            { 921600, 2000000, 3000000 }
+#define UART_BAUD_ACK_MS            200
+#define UART_BAUD_VERIFY_PINGS      3
+#define UART_BAUD_VERIFY_MS         100
+#define UART_BAUD_REVERT_MS         1000
+
+// Throughput summary interval in UART_LOG_COUNTERS mode (settings.h)
+#define UART_LOG_REPORT_MS          5000
+
+// Binary framing negotiation (see uart_frame.h)
+#define UART_PROTO_BINARY_CMD       "proto binary"
+#define UART_PROTO_BINARY_ACK       "proto binary ok"
+#define UART_PROTO_TEXT_CMD         "proto text"
+#define UART_PROTO_TEXT_ACK         "proto text ok"
+#define UART_PROTO_NEGOTIATE_MS     200
+
+// Flow control (CONFIG_UART_FLOW_*). RTS/CTS needs two extra wires to the
+// primary board. Software flow control is XON/XOFF in text mode, sent by
+// the UART hardware, and byte credits in binary mode, where 0x11/0x13 can
+// occur inside frames: JanOS may send up to the limit last granted in a
+// UART_FRAME_CREDIT frame.
+typedef enum {
+    UART_FLOW_NONE = 0,
+    UART_FLOW_RTS_CTS,
+    UART_FLOW_XON_XOFF,
+    UART_FLOW_CREDITS,
+} uart_flow_t;
+
+#ifdef CONFIG_UART_FLOW_RTS_CTS
+#define UART_RTS_PIN                CONFIG_UART_RTS_PIN
+#define UART_CTS_PIN                CONFIG_UART_CTS_PIN
+#endif
+#define UART_FLOW_XOFF_THRESH       100     // RX FIFO bytes (of 128) before RTS/XOFF
+#define UART_FLOW_XON_THRESH        32      // ... and before RTS/XON again
+#define UART_CREDIT_WINDOW          (UART_RX_RING_SIZE / 2)
+#define UART_CREDIT_REFRESH_MS      1000    // Limit repeated while idle, in case one was lost
+#define UART_PROTO_CREDIT_CMD       "proto credit"  // + window in bytes
+#define UART_PROTO_CREDIT_ACK       "proto credit ok"
+
+// Quiet link (CONFIG_UART_QUIET_LINK): after "proto quiet", JanOS keeps ESP
+// log lines, [MEM] reports and command echo off the control UART. Offered
+// as "proto quiet frame" in binary mode, it sends them as UART_FRAME_LOG
+// frames instead, which go to the terminal scrollback and clock sync but
+// skip every line parser; back in text mode they are suppressed. Plain
+// output (results, prompts) is unchanged, so the screens' log filters
+// only still matter for firmware that refuses.
+#define UART_PROTO_QUIET_CMD        "proto quiet"   // + " frame" in binary mode
+#define UART_PROTO_QUIET_ACK        "proto quiet ok"
+
+typedef enum {
+    UART_QUIET_OFF = 0,             // JanOS sends everything as lines
+    UART_QUIET_SUPPRESS,            // Log and echo lines not sent
+    UART_QUIET_FRAMED,              // ... sent as UART_FRAME_LOG frames
+} uart_quiet_t;
 
-// Maximum networks that can be stored
-#define MAX_NETWORKS        64
 #define MAX_SSID_LEN        33
 #define MAX_BSSID_LEN       18
 #define MAX_SECURITY_LEN    24
@@ -32,13 +134,106 @@ typedef struct {
     int rssi;
     char band[MAX_BAND_LEN];
     bool selected;
+    uint8_t link;           // uart_link_id_t that reported id
 } wifi_network_t;
 
 // Response callback type
 typedef void (*uart_response_callback_t)(const char *line, void *user_data);
 
-// Scan complete callback type
-typedef void (*uart_scan_complete_callback_t)(wifi_network_t *networks, int count, void *user_data);
+// Line routing (see uart_subscribe_lines)
+#define UART_MAX_LINE_ROUTES        16
+#define UART_ROUTE_PATTERN_LEN      24
+
+typedef enum {
+    UART_ROUTE_ANY = 0,     // Every line
+    UART_ROUTE_PREFIX,      // Line starts with the pattern, e.g. "\"" or "I ("
+    UART_ROUTE_TAG,         // Line contains the bracketed tag, e.g. "[DEAUTH]"
+} uart_route_kind_t;
+
+// Asynchronous requests (see uart_request)
+#define UART_MAX_PENDING_REQUESTS   8
+#define UART_REQUEST_CMD_LEN        64
+#define UART_REQUEST_TIMEOUT_MS     1000    // Used when timeout_ms is 0
+
+typedef enum {
+    UART_REQUEST_DONE = 0,      // Response ended (marker or line callback)
+    UART_REQUEST_TIMEOUT,       // No complete response within the timeout
+} uart_request_status_t;
+
+// Called for each response line; return true when the response is complete
+typedef bool (*uart_request_line_cb_t)(const char *line, void *user_data);
+
+// Called once when the request completes or times out
+typedef void (*uart_request_done_cb_t)(uart_request_status_t status, void *user_data);
+
+typedef struct {
+    const char *cmd;                // Command line to send
+    const char *end_marker;         // Line prefix that ends the response (may be NULL)
+    uart_request_line_cb_t on_line; // Per-line handler (may be NULL)
+    uart_request_done_cb_t on_done; // Completion handler (may be NULL)
+    void *user_data;
+    int timeout_ms;                 // Measured from when the request reaches the
+                                    // head of the queue; 0 = UART_REQUEST_TIMEOUT_MS
+} uart_request_t;
+
+// TX lanes. Express commands, whose first word is in UART_EXPRESS_CMDS,
+// end whatever JanOS is running and go ahead of everything else waiting
+// to be written. Bulk writes (uart_send_bulk_frame, uart_write_raw) hold
+// off while one is being written and keep at most UART_BULK_BACKLOG_MS of
+// bytes queued in the driver, so an express command never waits behind a
+// file transfer or bridge burst for longer than that. Other commands and
+// control frames are written at once, as before.
+#define UART_EXPRESS_CMDS           "stop unselect_networks reboot"
+#define UART_STOP_REPLY             "Stop command received"     // Never a request's reply
+#define UART_BULK_BACKLOG_MS        4
+
+// Command batches (see uart_send_batch)
+#define UART_BATCH_MAX_CMDS         8
+#define UART_BATCH_MAX_BYTES        256     // All lines of a batch, newlines included
+#define UART_BATCH_FENCE_CMD        "ping"  // Answered only after the commands before it
+#define UART_BATCH_FENCE_REPLY      "pong"
+#define UART_BATCH_TIMEOUT_MS       3000
+
+// Link statistics (counters since boot or uart_reset_link_stats)
+typedef struct {
+    uint32_t rx_bytes;
+    uint32_t rx_lines;
+    uint32_t tx_bytes;
+    uint32_t tx_lines;
+    uint32_t truncated_lines;   // Lines longer than UART_LINE_MAX - 1
+    uint32_t fifo_overflows;    // Hardware RX FIFO overruns
+    uint32_t ring_overflows;    // Driver ring buffer full, bytes lost
+    uint32_t flow_holds;        // Ring full while flow control held JanOS off
+    uint32_t line_errors;       // Framing / parity errors
+    uint32_t frame_errors;      // Binary frames dropped on sync/length/CRC
+    uint32_t bulk_bytes;        // Compressed bulk payload received
+    uint32_t bulk_text;         // ... and the text it expanded to
+    uint32_t bulk_dropped;      // Bulk blocks malformed or out of sequence
+    uint32_t parse_failures;    // Scan rows or records that did not parse
+    uint32_t request_timeouts;
+    uint32_t callback_calls;    // Line callbacks run
+    uint32_t callback_avg_us;
+    uint32_t callback_max_us;   // Slowest single callback
+    int callback_max_route;     // Route slot of the slowest callback
+    uint32_t rx_stack_free;     // uart_rx stack high-water mark, bytes
+    uint32_t log_frames;        // UART_FRAME_LOG frames set aside unparsed
+    uint32_t express_sent;      // Express commands written
+    uint32_t express_max_us;    // Slowest, from the call to its last byte on the wire
+    uart_flow_t flow;           // Flow control in effect
+} uart_link_stats_t;
+
+// Raw RX tap: every chunk read from the driver, before line splitting
+typedef void (*uart_raw_tap_t)(const uint8_t *data, size_t len, void *user_data);
+
+// Scan complete callback type; results are in network_store.h
+typedef void (*uart_scan_complete_callback_t)(int count, void *user_data);
+
+// Streaming scan callback type: one call per network as its row arrives
+typedef void (*uart_scan_result_callback_t)(const wifi_network_t *network, void *user_data);
+
+// Binary frame callback type (frame layout in uart_frame.h)
+struct uart_frame;
+typedef void (*uart_frame_callback_t)(const struct uart_frame *frame, void *user_data);
 
 /**
  * @brief Initialize UART handler
@@ -46,15 +241,148 @@ typedef void (*uart_scan_complete_callback_t)(wifi_network_t *networks, int coun
  */
 esp_err_t uart_handler_init(void);
 
+/**
+ * @brief Every line received, as it arrived; second board lines start "B2 "
+ * @return Scrollback, or NULL if it could not be allocated
+ */
+struct text_log* uart_scrollback(void);
+
 /**
  * @brief Send a command via UART
+ *
+ * With a second board, commands whose first word is listed in
+ * UART_SECOND_MIRROR are repeated there, so scans and sniffing run on
+ * both boards at once. Express commands (UART_EXPRESS_CMDS) take the
+ * express lane and end a scan in progress, whose end marker JanOS will
+ * not send.
  * @param cmd Command string to send
  * @return ESP_OK on success
  */
 esp_err_t uart_send_command(const char *cmd);
 
+/**
+ * @brief Send a command to one board only
+ * @param link Board
+ * @param cmd Command string to send
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_INVALID_STATE if the link
+ *         is not configured or failed to start
+ */
+esp_err_t uart_link_send_command(uart_link_id_t link, const char *cmd);
+
+/**
+ * @brief Check whether a board has sent anything since boot
+ */
+bool uart_link_is_up(uart_link_id_t link);
+
+/**
+ * @brief Board whose line is being delivered
+ *
+ * For line callbacks subscribed with uart_subscribe_link_lines(); elsewhere
+ * UART_LINK_PRIMARY.
+ */
+uart_link_id_t uart_line_link(void);
+
+/**
+ * @brief When the line being delivered was received (time_sync timebase)
+ *
+ * Taken when its bytes were read, less the time the bytes after it took
+ * on the wire, so a burst read at once still gets one stamp per line. On
+ * other tasks, the current time.
+ */
+int64_t uart_line_time_us(void);
+
+/**
+ * @brief Send one binary frame to JanOS (layout in uart_frame.h)
+ * @param type Record type
+ * @param payload Payload bytes
+ * @param len Payload length, at most UART_FRAME_MAX_PAYLOAD
+ * @return ESP_OK, ESP_ERR_INVALID_STATE before binary framing is negotiated,
+ *         ESP_ERR_INVALID_SIZE if the payload is too long
+ */
+esp_err_t uart_send_frame(uint8_t type, const void *payload, uint16_t len);
+
+/**
+ * @brief Send one binary frame in the bulk lane
+ *
+ * Like uart_send_frame(), but waits first while an express command is
+ * going out or the driver still holds more than UART_BULK_BACKLOG_MS of
+ * bytes. For bulk payload sent in a loop; not for the UART RX task.
+ */
+esp_err_t uart_send_bulk_frame(uint8_t type, const void *payload, uint16_t len);
+
+/**
+ * @brief Send several commands as one write, optionally acknowledged together
+ *
+ * The lines go out in a single driver write under one lock, so no other
+ * task's command can land between them and JanOS receives the whole
+ * sequence back to back. With on_done, a UART_BATCH_FENCE_CMD request is
+ * queued behind the commands; JanOS handles lines in order, so its reply
+ * confirms the whole batch was consumed (UART_REQUEST_TIMEOUT after
+ * UART_BATCH_TIMEOUT_MS otherwise). on_done runs on the UART RX task.
+ * @param cmds Command lines (without newlines)
+ * @param count Number of commands, at most UART_BATCH_MAX_CMDS
+ * @param on_done Aggregated acknowledgement (may be NULL)
+ * @param user_data Passed to on_done; uart_cancel_requests() drops it
+ * @return ESP_OK, ESP_ERR_INVALID_SIZE if the lines exceed
+ *         UART_BATCH_MAX_BYTES, ESP_ERR_NO_MEM if the request queue is full,
+ *         ESP_FAIL if the driver took fewer bytes
+ */
+esp_err_t uart_send_batch(const char *const *cmds, int count,
+                          uart_request_done_cb_t on_done, void *user_data);
+
+/**
+ * @brief Write bytes to JanOS as-is (no newline, no logging)
+ *
+ * For byte-stream bridges; counted in tx_bytes only. Bulk lane: waits
+ * like uart_send_bulk_frame().
+ * @param data Bytes
+ * @param len Byte count
+ * @return ESP_OK, or ESP_FAIL if the driver took fewer bytes
+ */
+esp_err_t uart_write_raw(const void *data, size_t len);
+
+/**
+ * @brief Queue a command whose reply is matched to it
+ *
+ * The command is sent immediately, so several requests can be in flight;
+ * JanOS answers in order and replies are resolved against the queue head.
+ * A line echoing the command is skipped. The response ends when a line
+ * starts with end_marker or on_line returns true; with neither set, the
+ * first reply line ends it. Received lines are still delivered to the
+ * line, monitor and routed callbacks as usual. Callbacks run on the UART
+ * RX task.
+ * @param req Request description (copied)
+ * @return ESP_OK if queued and sent, ESP_ERR_NO_MEM if the queue is full
+ */
+esp_err_t uart_request(const uart_request_t *req);
+
+/**
+ * @brief Drop queued requests without calling their completion handlers
+ *
+ * Use from on_destroy before freeing the user data the requests refer to.
+ * A request the RX task has already taken off the queue is not removed:
+ * its completion handler runs (or is running) regardless.
+ * @param user_data Requests with this user_data are removed
+ * @return Requests removed
+ */
+int uart_cancel_requests(void *user_data);
+
+/**
+ * @brief Send a command and block until a line starting with reply arrives
+ *
+ * Must not be called from a UART callback.
+ * @param cmd Command line
+ * @param reply Expected reply prefix (NULL accepts any reply line)
+ * @param timeout_ms Timeout in milliseconds
+ * @return true if the reply arrived in time
+ */
+bool uart_request_sync(const char *cmd, const char *reply, int timeout_ms);
+
 /**
  * @brief Register a callback for line-by-line response
+ *
+ * Returns once no RX task is still calling the callback it replaced,
+ * unless called from that callback's own RX task.
  * @param callback Function to call for each line received
  * @param user_data User data to pass to callback
  */
@@ -77,6 +405,92 @@ void uart_clear_monitor_callback(void);
  */
 void uart_clear_line_callback(void);
 
+/**
+ * @brief Subscribe to received lines matching a prefix or tag
+ *
+ * Each line is classified once (first-byte jump table for prefixes, one
+ * pass over '[' positions for tags) and handed to every matching
+ * subscriber in subscription order, so several consumers can listen to
+ * the link at the same time. Callbacks run on the UART RX task.
+ * @param kind How pattern is matched
+ * @param pattern Prefix or tag text (ignored for UART_ROUTE_ANY, copied)
+ * @param callback Function to call for each matching line
+ * @param user_data User data to pass to callback
+ * Only the primary board's lines are delivered.
+ * @return Route handle (>= 0), or -1 if the table is full or pattern invalid
+ */
+int uart_subscribe_lines(uart_route_kind_t kind, const char *pattern,
+                         uart_response_callback_t callback, void *user_data);
+
+/**
+ * @brief uart_subscribe_lines() for lines from a set of boards
+ *
+ * For parsers that file results whichever board produced them; each
+ * board's lines arrive on its own RX task, so the callback must be safe
+ * to run on two tasks at once. uart_line_link() tells the boards apart.
+ * @param links_heard UART_LINK_MASK() bits, or UART_LINK_MASK_ALL
+ */
+int uart_subscribe_link_lines(uint8_t links_heard, uart_route_kind_t kind, const char *pattern,
+                              uart_response_callback_t callback, void *user_data);
+
+/**
+ * @brief Remove a route created by uart_subscribe_lines
+ *
+ * Returns once no RX task is still calling the route's callback, so its
+ * user data may be freed; from a callback on the same RX task it returns
+ * at once.
+ * @param handle Route handle (negative values are ignored)
+ */
+void uart_unsubscribe_lines(int handle);
+
+/**
+ * @brief Stop or resume delivery on a route without giving up its slot
+ *
+ * Lines that arrive while a route is paused are not queued for it.
+ * @param handle Route handle (negative values are ignored)
+ * @param paused true to stop delivery, false to resume it
+ */
+void uart_pause_lines(int handle, bool paused);
+
+/**
+ * @brief Set (or with NULL, clear) the raw RX tap
+ *
+ * The tap sees received driver bytes in order, on the UART RX task, before
+ * they are split into lines; lines and frames are still dispatched as
+ * usual afterwards. Injected (replayed) bytes are not tapped. The tap runs
+ * with the handler's lock held and must not block or call uart_*; once
+ * clearing it returns, the old tap is no longer running.
+ * @param tap Function to call for each chunk
+ * @param user_data User data to pass to tap
+ */
+void uart_set_raw_tap(uart_raw_tap_t tap, void *user_data);
+
+/**
+ * @brief Register a callback for binary frames not consumed by the handler
+ *
+ * Only called once binary framing has been negotiated. Scan result frames
+ * are routed to the scan callback instead while a scan is running.
+ * @param callback Function to call for each frame
+ * @param user_data User data to pass to callback
+ */
+void uart_register_frame_callback(uart_frame_callback_t callback, void *user_data);
+
+/**
+ * @brief Clear registered frame callback
+ */
+void uart_clear_frame_callback(void);
+
+/**
+ * @brief Check whether binary framing was negotiated with JanOS
+ * @return true if binary frames are accepted, false for text-only mode
+ */
+bool uart_is_binary_mode(void);
+
+/**
+ * @brief How JanOS treats log and echo lines on the primary link
+ */
+uart_quiet_t uart_get_quiet(void);
+
 /**
  * @brief Start WiFi scan and register callback for results
  * @param callback Function to call when scan completes
@@ -85,12 +499,85 @@ void uart_clear_line_callback(void);
  */
 esp_err_t uart_start_wifi_scan(uart_scan_complete_callback_t callback, void *user_data);
 
+/**
+ * @brief Start WiFi scan and receive each network as soon as it is parsed
+ *
+ * Both callbacks run on the UART RX task. on_result is called with the
+ * handler's lock held and must only copy the record (no uart_* calls).
+ * Results accumulate in the network store (network_store.h), which is
+ * cleared when the scan starts.
+ * @param on_result Called for every network row (may be NULL)
+ * @param on_complete Called when the scan dump ends (may be NULL)
+ * @param user_data User data passed to both callbacks
+ * @return ESP_OK on success
+ */
+esp_err_t uart_start_wifi_scan_streaming(uart_scan_result_callback_t on_result,
+                                         uart_scan_complete_callback_t on_complete,
+                                         void *user_data);
+
+/**
+ * @brief Rescan without clearing the network store
+ *
+ * Same as uart_start_wifi_scan_streaming(), but networks already in the
+ * store keep their index and selection and get the new RSSI, channel and
+ * JanOS index; newly seen networks are appended and flagged NEW, and
+ * networks this pass misses age towards STALE (network_store.h). Screens
+ * holding store indexes stay valid across the rescan.
+ */
+esp_err_t uart_refresh_wifi_scan(uart_scan_result_callback_t on_result,
+                                 uart_scan_complete_callback_t on_complete,
+                                 void *user_data);
+
+/**
+ * @brief Start a uart_refresh_wifi_scan() once interval_ms has passed
+ *        since the last scan finished
+ *
+ * For screens that keep the store fresh while shown; the timer is shared,
+ * so screens stacked over each other do not double the scan rate.
+ * @return true if a rescan was started
+ */
+bool uart_rescan_if_due(uint32_t interval_ms);
+
+/**
+ * @brief Tell JanOS which scan ids to attack
+ *
+ * Runs of consecutive ids are sent as ranges: as one
+ * UART_FRAME_SELECT_NETWORKS frame in binary mode, else as
+ * "select_networks 1-20,25" with CONFIG_JANOS_SELECT_RANGES or one id per
+ * argument without. The command buffer is sized to the ids, so nothing
+ * is cut off however many are selected.
+ * @param ids Ids in ascending order
+ * @param count Number of ids
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for no ids, ESP_ERR_NO_MEM
+ */
+esp_err_t uart_select_networks(const uint16_t *ids, int count);
+
+/**
+ * @brief Stop delivering scan callbacks to a listener that is going away
+ *
+ * The scan itself keeps running; only callbacks registered with this
+ * user_data are dropped.
+ * @param user_data User data the scan was started with
+ */
+void uart_detach_wifi_scan(void *user_data);
+
 /**
  * @brief Check if scan is in progress
  * @return true if scanning
  */
 bool uart_is_scanning(void);
 
+/**
+ * @brief Check whether the primary link has nothing to do
+ *
+ * Used to slip in work nobody waits for yet, such as listing prefetches
+ * and background refreshes; a command the user starts makes the link busy
+ * again at once.
+ * @param quiet_ms Nothing must have been sent or received for this long
+ * @return true if no request is pending, no scan runs and the link was quiet
+ */
+bool uart_link_idle(uint32_t quiet_ms);
+
 /**
  * @brief Get scan progress message
  * @return Current status message
@@ -111,11 +598,77 @@ void uart_set_wifi_connected(bool connected);
 
 /**
  * @brief Check if board is connected by sending ping and waiting for pong
+ *
+ * On the first successful ping the link speed is negotiated upwards
+ * (CONFIG_UART_BAUD_NEGOTIATION) and binary framing is offered.
  * @param timeout_ms Timeout in milliseconds to wait for response
  * @return true if pong received within timeout, false otherwise
  */
 bool uart_check_board_ping(int timeout_ms);
 
+/**
+ * @brief Move the primary link to a baud rate (benchmarks)
+ *
+ * Same handshake and check as the negotiation; if the check fails the
+ * link returns to the rate it had. The rate is not saved to settings.
+ * @return true if the link runs at baud afterwards
+ */
+bool uart_set_link_baud(uint32_t baud);
+
+/**
+ * @brief Switch the primary link to binary framing or back to text
+ * @return true if the link is in the requested mode afterwards
+ */
+bool uart_set_binary_mode(bool binary);
+
+/**
+ * @brief Wait until everything sent to a board has left the UART
+ * @return ESP_OK, ESP_ERR_TIMEOUT, or ESP_ERR_INVALID_ARG
+ */
+esp_err_t uart_link_wait_tx_done(uart_link_id_t link, int timeout_ms);
+
+/**
+ * @brief Get the current link baud rate
+ * @return Baud rate in use (UART_BAUD_RATE until negotiation raises it)
+ */
+uint32_t uart_get_baud_rate(void);
+
+/**
+ * @brief Snapshot link statistics
+ * @param out Receives the counters
+ */
+void uart_get_link_stats(uart_link_stats_t *out);
+
+/**
+ * @brief Snapshot one board's link statistics
+ */
+void uart_link_get_stats(uart_link_id_t link, uart_link_stats_t *out);
+
+/**
+ * @brief Zero link statistics (the stack high-water mark is not reset)
+ */
+void uart_reset_link_stats(void);
+
+/**
+ * @brief Wake the RX tasks so they re-plan their timed work
+ *
+ * Called when the console log level changes: a task idling without a
+ * deadline would otherwise start counter reports only on the next byte.
+ */
+void uart_wake_rx(void);
+
+/**
+ * @brief Feed bytes into the RX path as if they came from JanOS
+ *
+ * Used by transcript replay (uart_transcript.h). Bytes are handed to the
+ * RX task, which splits them into lines and frames like driver data.
+ * @param data Raw bytes
+ * @param len Byte count
+ * @param wait_ms How long to wait for room in the injection buffer
+ * @return ESP_OK, ESP_ERR_TIMEOUT if the RX task is behind, ESP_ERR_NO_MEM
+ */
+esp_err_t uart_inject_rx(const void *data, size_t len, int wait_ms);
+
 #endif // UART_HANDLER_H
 
 
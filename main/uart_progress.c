@@ -0,0 +1,133 @@
+/**
+ * @file uart_progress.c
+ * @brief Latest progress of each long JanOS operation
+ */
+
+#include "uart_progress.h"
+#include "app_events.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    uart_progress_record_t rec;
+    uint32_t seq;
+} progress_slot_t;
+
+// Turns one text-mode line into progress; returns true if rec changed
+typedef bool (*text_adapter_t)(const char *line, uart_progress_record_t *rec);
+
+static progress_slot_t slots[UART_OP_COUNT];
+static volatile uint32_t running_mask = 0;     // Ops with a text adapter running
+static portMUX_TYPE progress_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief scan_networks phases; rows and the end are counted by uart_handler
+ */
+static bool scan_line(const char *line, uart_progress_record_t *rec)
+{
+    const char *text = NULL;
+    if (strstr(line, "Starting background WiFi scan")) {
+        text = "Scanning...";
+    } else if (strstr(line, "WiFi scan completed")) {
+        text = "Processing results...";
+    }
+    if (!text) return false;
+    strlcpy(rec->text, text, sizeof(rec->text));
+    return true;
+}
+
+/**
+ * @brief wpasec_upload ends with "Done: N uploaded, N duplicate, N failed"
+ */
+static bool wpasec_line(const char *line, uart_progress_record_t *rec)
+{
+    const char *p = strstr(line, "Done:");
+    if (p) {
+        unsigned uploaded = 0, duplicate = 0, failed = 0;
+        if (sscanf(p, "Done: %u uploaded, %u duplicate, %u failed",
+                   &uploaded, &duplicate, &failed) == 3) {
+            rec->state = UART_PROGRESS_DONE;
+            rec->percent = 100;
+            rec->done = uploaded;
+            rec->skipped = duplicate;
+            rec->failed = failed;
+            strlcpy(rec->text, "Upload complete", sizeof(rec->text));
+        } else {
+            rec->state = UART_PROGRESS_ERROR;
+            strlcpy(rec->text, "Unreadable summary", sizeof(rec->text));
+        }
+        return true;
+    }
+    if (strstr(line, "Failed") || strstr(line, "Error")) {
+        rec->state = UART_PROGRESS_ERROR;
+        strlcpy(rec->text, "Failed to send", sizeof(rec->text));
+        return true;
+    }
+    return false;
+}
+
+static const text_adapter_t text_adapters[UART_OP_COUNT] = {
+    [UART_OP_WIFI_SCAN] = scan_line,
+    [UART_OP_WPASEC_UPLOAD] = wpasec_line,
+};
+
+void uart_progress_begin(uart_op_t op, const char *text, uint16_t total)
+{
+    uart_progress_record_t rec = {
+        .op = op,
+        .state = UART_PROGRESS_RUNNING,
+        .percent = UART_PROGRESS_UNKNOWN,
+        .total = total,
+    };
+    if (text) strlcpy(rec.text, text, sizeof(rec.text));
+    uart_progress_publish(&rec);
+}
+
+void uart_progress_publish(const uart_progress_record_t *rec)
+{
+    if (!rec || rec->op == UART_OP_NONE || rec->op >= UART_OP_COUNT) return;
+
+    uint32_t bit = 1u << rec->op;
+    portENTER_CRITICAL(&progress_lock);
+    progress_slot_t *slot = &slots[rec->op];
+    slot->rec = *rec;
+    slot->seq++;
+    if (rec->state == UART_PROGRESS_RUNNING && text_adapters[rec->op]) {
+        running_mask |= bit;
+    } else {
+        running_mask &= ~bit;
+    }
+    portEXIT_CRITICAL(&progress_lock);
+
+    app_events_post(APP_EVENT_PROGRESS);
+}
+
+uint32_t uart_progress_get(uart_op_t op, uart_progress_record_t *out)
+{
+    if (op >= UART_OP_COUNT) {
+        memset(out, 0, sizeof(*out));
+        return 0;
+    }
+    portENTER_CRITICAL(&progress_lock);
+    *out = slots[op].rec;
+    uint32_t seq = slots[op].seq;
+    portEXIT_CRITICAL(&progress_lock);
+    out->op = op;
+    return seq;
+}
+
+void uart_progress_feed_line(const char *line)
+{
+    if (!running_mask || !line) return;
+
+    for (int op = 0; op < UART_OP_COUNT; op++) {
+        if (!(running_mask & (1u << op))) continue;
+
+        uart_progress_record_t rec;
+        uart_progress_get(op, &rec);
+        if (text_adapters[op](line, &rec)) {
+            uart_progress_publish(&rec);
+        }
+    }
+}
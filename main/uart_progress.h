@@ -0,0 +1,57 @@
+/**
+ * @file uart_progress.h
+ * @brief Latest progress of each long JanOS operation
+ *
+ * One uart_progress_record_t (uart_frame.h) is kept per operation. In
+ * binary mode JanOS sends them as UART_FRAME_PROGRESS frames. In text
+ * mode the adapters in uart_progress.c turn the operation's known output
+ * lines into the same records, so the free-text matching lives here and
+ * nowhere else. Cardputer-side modules (scan store, remote_dir) publish
+ * their own counts.
+ *
+ * Every published record gets a new sequence number and posts
+ * APP_EVENT_PROGRESS; screens compare the sequence in on_tick and draw
+ * with ui_progress_t (ui_widget.h).
+ */
+
+#ifndef UART_PROGRESS_H
+#define UART_PROGRESS_H
+
+#include "uart_frame.h"
+#include <stdint.h>
+
+/**
+ * @brief Mark an operation running with zeroed counts
+ *
+ * Call before sending the command so the text adapter sees every reply.
+ * @param op Operation
+ * @param text Phase text (may be NULL)
+ * @param total Expected count, 0 if unknown
+ */
+void uart_progress_begin(uart_op_t op, const char *text, uint16_t total);
+
+/**
+ * @brief Store a record as the operation's latest progress
+ *
+ * Any task; does not block.
+ * @param rec Record (rec->op selects the slot)
+ */
+void uart_progress_publish(const uart_progress_record_t *rec);
+
+/**
+ * @brief Copy an operation's latest progress
+ * @param op Operation
+ * @param out Receives the record (state UART_PROGRESS_IDLE if never started)
+ * @return Sequence number, 0 if nothing was published yet
+ */
+uint32_t uart_progress_get(uart_op_t op, uart_progress_record_t *out);
+
+/**
+ * @brief Run the text adapters of running operations on a received line
+ *
+ * Called by the UART handler for every line; returns at once when no
+ * operation with a text adapter is running.
+ */
+void uart_progress_feed_line(const char *line);
+
+#endif // UART_PROGRESS_H
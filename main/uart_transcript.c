@@ -0,0 +1,274 @@
+/**
+ * @file uart_transcript.c
+ * @brief Raw UART RX capture to SD and replay without a board attached
+ *
+ * Capture must never slow the RX task down, so records go into a ring
+ * buffer and a writer task puts them on the card; records that do not
+ * fit are dropped and counted. Replay runs on its own task and paces
+ * records by their timestamps.
+ */
+
+#include "uart_transcript.h"
+#include "uart_handler.h"
+#include "screenshot.h"
+#include "task_plan.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+static const char *TAG = "UART_TRANSCRIPT";
+
+#define TRANSCRIPT_MAGIC        "UTR1"
+#define RECORD_HEADER_SIZE      6
+#define REPLAY_CHUNK_MAX        4096
+#define REPLAY_INJECT_WAIT_MS   1000
+
+// Capture
+static RingbufHandle_t capture_buffer = NULL;
+static volatile bool recording = false;
+static volatile bool record_stopping = false;
+static int64_t record_start_us = 0;
+static volatile uint32_t record_bytes = 0;
+static volatile uint32_t record_dropped = 0;
+
+// Replay
+static volatile bool replaying = false;
+static volatile bool replay_stopping = false;
+static volatile uint32_t replay_bytes = 0;
+static volatile uint32_t replay_max_lag_ms = 0;
+static volatile int replay_progress = 0;
+static char replay_path[64];
+static int replay_speed = 1;
+
+/**
+ * @brief Highest N among rx_N.utr files, 0 if none
+ */
+static int latest_transcript_number(void)
+{
+    DIR *dir = opendir(UART_TRANSCRIPT_DIR);
+    if (!dir) return 0;
+    
+    int max_num = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int num;
+        if (sscanf(entry->d_name, "rx_%d.utr", &num) == 1 && num > max_num) {
+            max_num = num;
+        }
+    }
+    closedir(dir);
+    return max_num;
+}
+
+static void writer_task(void *arg)
+{
+    FILE *f = (FILE *)arg;
+    bool failed = false;
+    
+    for (;;) {
+        size_t size = 0;
+        void *item = xRingbufferReceive(capture_buffer, &size, pdMS_TO_TICKS(200));
+        if (!item) {
+            if (record_stopping) break;
+            continue;
+        }
+        if (!failed && fwrite(item, 1, size, f) != size) {
+            ESP_LOGE(TAG, "Write failed, capture stopped");
+            failed = true;
+            recording = false;
+        }
+        vRingbufferReturnItem(capture_buffer, item);
+    }
+    
+    fclose(f);
+    ESP_LOGI(TAG, "Capture closed: %lu bytes, %lu dropped",
+             (unsigned long)record_bytes, (unsigned long)record_dropped);
+    
+    RingbufHandle_t buf = capture_buffer;
+    capture_buffer = NULL;
+    vRingbufferDelete(buf);
+    record_stopping = false;
+    vTaskDelete(NULL);
+}
+
+esp_err_t uart_transcript_record_start(void)
+{
+    if (recording || record_stopping || replaying) return ESP_ERR_INVALID_STATE;
+    if (!screenshot_is_available()) {
+        ESP_LOGW(TAG, "SD card not mounted, cannot capture");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    struct stat st;
+    if (stat(UART_TRANSCRIPT_DIR, &st) != 0) {
+        mkdir(UART_TRANSCRIPT_DIR, 0755);
+    }
+    char path[64];
+    snprintf(path, sizeof(path), "%s/rx_%d.utr", UART_TRANSCRIPT_DIR,
+             latest_transcript_number() + 1);
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return ESP_FAIL;
+    }
+    fwrite(TRANSCRIPT_MAGIC, 1, 4, f);
+    
+    capture_buffer = xRingbufferCreate(UART_TRANSCRIPT_BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+    if (!capture_buffer) {
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+    record_bytes = 0;
+    record_dropped = 0;
+    record_start_us = esp_timer_get_time();
+    if (xTaskCreatePinnedToCore(writer_task, "utr_write", TASK_TRANSCRIPT_STACK, f,
+                                TASK_TRANSCRIPT_PRIO, NULL, TASK_TRANSCRIPT_CORE) != pdPASS) {
+        vRingbufferDelete(capture_buffer);
+        capture_buffer = NULL;
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+    recording = true;
+    ESP_LOGI(TAG, "Capturing RX to %s", path);
+    return ESP_OK;
+}
+
+void uart_transcript_record_stop(void)
+{
+    if (!recording) return;
+    recording = false;
+    record_stopping = true;
+}
+
+void uart_transcript_capture(const void *data, size_t len)
+{
+    if (!recording || len == 0) return;
+    if (len > UINT16_MAX) len = UINT16_MAX;
+    
+    // Header and payload are one ring item, so records never interleave
+    uint8_t *item = NULL;
+    if (xRingbufferSendAcquire(capture_buffer, (void **)&item,
+                               RECORD_HEADER_SIZE + len, 0) != pdTRUE) {
+        record_dropped += len;
+        return;
+    }
+    uint32_t t = (uint32_t)((esp_timer_get_time() - record_start_us) / 1000);
+    item[0] = t & 0xFF;
+    item[1] = (t >> 8) & 0xFF;
+    item[2] = (t >> 16) & 0xFF;
+    item[3] = t >> 24;
+    item[4] = len & 0xFF;
+    item[5] = len >> 8;
+    memcpy(item + RECORD_HEADER_SIZE, data, len);
+    xRingbufferSendComplete(capture_buffer, item);
+    record_bytes += len;
+}
+
+static void replay_task(void *arg)
+{
+    (void)arg;
+    uint8_t *chunk = malloc(REPLAY_CHUNK_MAX);
+    FILE *f = fopen(replay_path, "rb");
+    char magic[4];
+    
+    if (!chunk || !f || fread(magic, 1, 4, f) != 4 || memcmp(magic, TRANSCRIPT_MAGIC, 4) != 0) {
+        ESP_LOGE(TAG, "Cannot replay %s", replay_path);
+        goto done;
+    }
+    
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fseek(f, 4, SEEK_SET);
+    
+    ESP_LOGI(TAG, "Replaying %s at %s", replay_path,
+             replay_speed == UART_TRANSCRIPT_SPEED_MAX ? "max speed" : "scaled time");
+    int64_t start_us = esp_timer_get_time();
+    uint8_t header[RECORD_HEADER_SIZE];
+    
+    while (!replay_stopping && fread(header, 1, RECORD_HEADER_SIZE, f) == RECORD_HEADER_SIZE) {
+        uint32_t t = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+        size_t len = header[4] | (header[5] << 8);
+        if (len > REPLAY_CHUNK_MAX || fread(chunk, 1, len, f) != len) break;
+        
+        // Wait for the record's (scaled) time, and track how late we are
+        if (replay_speed != UART_TRANSCRIPT_SPEED_MAX) {
+            int64_t due_us = start_us + (int64_t)t * 1000 / replay_speed;
+            int64_t now = esp_timer_get_time();
+            if (due_us > now) {
+                vTaskDelay(pdMS_TO_TICKS((due_us - now) / 1000));
+            } else if ((now - due_us) / 1000 > replay_max_lag_ms) {
+                replay_max_lag_ms = (uint32_t)((now - due_us) / 1000);
+            }
+        }
+        
+        if (uart_inject_rx(chunk, len, REPLAY_INJECT_WAIT_MS) != ESP_OK) {
+            ESP_LOGW(TAG, "RX path not keeping up, replay stopped");
+            break;
+        }
+        replay_bytes += len;
+        replay_progress = file_size > 0 ? (int)(ftell(f) * 100 / file_size) : 100;
+    }
+    
+    ESP_LOGI(TAG, "Replay done: %lu bytes in %lld ms, max lag %lu ms",
+             (unsigned long)replay_bytes,
+             (long long)((esp_timer_get_time() - start_us) / 1000),
+             (unsigned long)replay_max_lag_ms);
+    
+done:
+    if (f) fclose(f);
+    free(chunk);
+    replaying = false;
+    replay_stopping = false;
+    vTaskDelete(NULL);
+}
+
+esp_err_t uart_transcript_replay_start(const char *path, int speed)
+{
+    if (replaying || recording || record_stopping) return ESP_ERR_INVALID_STATE;
+    
+    if (path) {
+        snprintf(replay_path, sizeof(replay_path), "%s", path);
+    } else {
+        int num = latest_transcript_number();
+        if (num == 0) return ESP_ERR_NOT_FOUND;
+        snprintf(replay_path, sizeof(replay_path), "%s/rx_%d.utr", UART_TRANSCRIPT_DIR, num);
+    }
+    
+    replay_speed = speed < 0 ? 1 : speed;
+    replay_bytes = 0;
+    replay_max_lag_ms = 0;
+    replay_progress = 0;
+    replaying = true;
+    if (xTaskCreatePinnedToCore(replay_task, "utr_replay", TASK_TRANSCRIPT_STACK, NULL,
+                                TASK_TRANSCRIPT_PRIO, NULL, TASK_TRANSCRIPT_CORE) != pdPASS) {
+        replaying = false;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void uart_transcript_replay_stop(void)
+{
+    if (replaying) {
+        replay_stopping = true;
+    }
+}
+
+void uart_transcript_get_status(uart_transcript_status_t *out)
+{
+    if (!out) return;
+    
+    out->recording = recording;
+    out->replaying = replaying;
+    out->bytes = replaying ? replay_bytes : record_bytes;
+    out->dropped = record_dropped;
+    out->max_lag_ms = replay_max_lag_ms;
+    out->progress_pct = replay_progress;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file uart_transcript.h
+ * @brief Raw UART RX capture to SD and replay without a board attached
+ *
+ * File format (/sdcard/uart/rx_N.utr, little-endian): "UTR1", then one
+ * record per driver read: u32 time_ms since capture start, u16 length,
+ * raw bytes. Replay feeds the bytes back through the normal RX path
+ * (uart_inject_rx), so screens see exactly what JanOS sent.
+ */
+
+#ifndef UART_TRANSCRIPT_H
+#define UART_TRANSCRIPT_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define UART_TRANSCRIPT_DIR         "/sdcard/uart"
+#define UART_TRANSCRIPT_BUFFER_SIZE (16 * 1024)     // RX task -> writer task
+#define UART_TRANSCRIPT_SPEED_MAX   0               // Replay with no delays
+
+// Capture/replay counters for diagnostics
+typedef struct {
+    bool recording;
+    bool replaying;
+    uint32_t bytes;                 // Captured or replayed so far
+    uint32_t dropped;               // Capture: bytes lost to a full buffer
+    uint32_t max_lag_ms;            // Replay: worst delay behind schedule
+    int progress_pct;               // Replay: position in the file
+} uart_transcript_status_t;
+
+/**
+ * @brief Start capturing RX bytes to the next rx_N.utr
+ * @return ESP_OK, ESP_ERR_INVALID_STATE without SD card or while busy
+ */
+esp_err_t uart_transcript_record_start(void);
+
+/**
+ * @brief Stop capturing and close the file (returns immediately)
+ */
+void uart_transcript_record_stop(void);
+
+/**
+ * @brief Hand freshly read RX bytes to the capture (RX task only)
+ *
+ * No-op unless recording; never blocks.
+ */
+void uart_transcript_capture(const void *data, size_t len);
+
+/**
+ * @brief Replay a transcript through the RX path
+ * @param path File to play, or NULL for the newest rx_N.utr
+ * @param speed Time scale (1 = real time, 8 = eight times faster),
+ *              UART_TRANSCRIPT_SPEED_MAX for no delays
+ * @return ESP_OK, ESP_ERR_NOT_FOUND, ESP_ERR_INVALID_STATE while busy
+ */
+esp_err_t uart_transcript_replay_start(const char *path, int speed);
+
+/**
+ * @brief Stop a running replay
+ */
+void uart_transcript_replay_stop(void);
+
+/**
+ * @brief Snapshot capture/replay state
+ */
+void uart_transcript_get_status(uart_transcript_status_t *out);
+
+#endif // UART_TRANSCRIPT_H
@@ -0,0 +1,212 @@
+/**
+ * @file font6x8.h
+ * @brief 6x8 monospace bitmap font for the compact text UI layout
+ * 
+ * Characters: ASCII 32-126 (space to tilde)
+ * 5x7 glyphs in a 6x8 cell (one blank column on the right, blank bottom row)
+ * 1 byte per row (MSB = leftmost pixel), 8 rows per character = 8 bytes per char
+ */
+
+#ifndef FONT6X8_H
+#define FONT6X8_H
+
+#include <stdint.h>
+
+#define FONT6X8_WIDTH  6
+#define FONT6X8_HEIGHT 8
+
+// 6x8 font data - each character is 8 bytes (1 byte per row)
+static const uint8_t font6x8_data[] = {
+    // Space (32)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    // ! (33)
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x20, 0x00,
+    // " (34)
+    0x50, 0x50, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00,
+    // # (35)
+    0x50, 0x50, 0xF8, 0x50, 0xF8, 0x50, 0x50, 0x00,
+    // $ (36)
+    0x20, 0x78, 0xA0, 0x70, 0x28, 0xF0, 0x20, 0x00,
+    // % (37)
+    0xC0, 0xC8, 0x10, 0x20, 0x40, 0x98, 0x18, 0x00,
+    // & (38)
+    0x60, 0x90, 0xA0, 0x40, 0xA8, 0x90, 0x68, 0x00,
+    // ' (39)
+    0x60, 0x20, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00,
+    // ( (40)
+    0x10, 0x20, 0x40, 0x40, 0x40, 0x20, 0x10, 0x00,
+    // ) (41)
+    0x40, 0x20, 0x10, 0x10, 0x10, 0x20, 0x40, 0x00,
+    // * (42)
+    0x00, 0x50, 0x20, 0xF8, 0x20, 0x50, 0x00, 0x00,
+    // + (43)
+    0x00, 0x20, 0x20, 0xF8, 0x20, 0x20, 0x00, 0x00,
+    // , (44)
+    0x00, 0x00, 0x00, 0x00, 0x60, 0x20, 0x40, 0x00,
+    // - (45)
+    0x00, 0x00, 0x00, 0xF8, 0x00, 0x00, 0x00, 0x00,
+    // . (46)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x60, 0x00,
+    // / (47)
+    0x00, 0x08, 0x10, 0x20, 0x40, 0x80, 0x00, 0x00,
+    // 0 (48)
+    0x70, 0x88, 0x98, 0xA8, 0xC8, 0x88, 0x70, 0x00,
+    // 1 (49)
+    0x20, 0x60, 0x20, 0x20, 0x20, 0x20, 0x70, 0x00,
+    // 2 (50)
+    0x70, 0x88, 0x08, 0x10, 0x20, 0x40, 0xF8, 0x00,
+    // 3 (51)
+    0xF8, 0x10, 0x20, 0x10, 0x08, 0x88, 0x70, 0x00,
+    // 4 (52)
+    0x10, 0x30, 0x50, 0x90, 0xF8, 0x10, 0x10, 0x00,
+    // 5 (53)
+    0xF8, 0x80, 0xF0, 0x08, 0x08, 0x88, 0x70, 0x00,
+    // 6 (54)
+    0x30, 0x40, 0x80, 0xF0, 0x88, 0x88, 0x70, 0x00,
+    // 7 (55)
+    0xF8, 0x08, 0x10, 0x20, 0x40, 0x40, 0x40, 0x00,
+    // 8 (56)
+    0x70, 0x88, 0x88, 0x70, 0x88, 0x88, 0x70, 0x00,
+    // 9 (57)
+    0x70, 0x88, 0x88, 0x78, 0x08, 0x10, 0x60, 0x00,
+    // : (58)
+    0x00, 0x60, 0x60, 0x00, 0x60, 0x60, 0x00, 0x00,
+    // ; (59)
+    0x00, 0x60, 0x60, 0x00, 0x60, 0x20, 0x40, 0x00,
+    // < (60)
+    0x10, 0x20, 0x40, 0x80, 0x40, 0x20, 0x10, 0x00,
+    // = (61)
+    0x00, 0x00, 0xF8, 0x00, 0xF8, 0x00, 0x00, 0x00,
+    // > (62)
+    0x40, 0x20, 0x10, 0x08, 0x10, 0x20, 0x40, 0x00,
+    // ? (63)
+    0x70, 0x88, 0x08, 0x10, 0x20, 0x00, 0x20, 0x00,
+    // @ (64)
+    0x70, 0x88, 0x08, 0x68, 0xA8, 0xA8, 0x70, 0x00,
+    // A (65)
+    0x70, 0x88, 0x88, 0x88, 0xF8, 0x88, 0x88, 0x00,
+    // B (66)
+    0xF0, 0x88, 0x88, 0xF0, 0x88, 0x88, 0xF0, 0x00,
+    // C (67)
+    0x70, 0x88, 0x80, 0x80, 0x80, 0x88, 0x70, 0x00,
+    // D (68)
+    0xE0, 0x90, 0x88, 0x88, 0x88, 0x90, 0xE0, 0x00,
+    // E (69)
+    0xF8, 0x80, 0x80, 0xF0, 0x80, 0x80, 0xF8, 0x00,
+    // F (70)
+    0xF8, 0x80, 0x80, 0xE0, 0x80, 0x80, 0x80, 0x00,
+    // G (71)
+    0x70, 0x88, 0x80, 0x80, 0x98, 0x88, 0x70, 0x00,
+    // H (72)
+    0x88, 0x88, 0x88, 0xF8, 0x88, 0x88, 0x88, 0x00,
+    // I (73)
+    0x70, 0x20, 0x20, 0x20, 0x20, 0x20, 0x70, 0x00,
+    // J (74)
+    0x38, 0x10, 0x10, 0x10, 0x10, 0x90, 0x60, 0x00,
+    // K (75)
+    0x88, 0x90, 0xA0, 0xC0, 0xA0, 0x90, 0x88, 0x00,
+    // L (76)
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0xF8, 0x00,
+    // M (77)
+    0x88, 0xD8, 0xA8, 0x88, 0x88, 0x88, 0x88, 0x00,
+    // N (78)
+    0x88, 0x88, 0xC8, 0xA8, 0x98, 0x88, 0x88, 0x00,
+    // O (79)
+    0x70, 0x88, 0x88, 0x88, 0x88, 0x88, 0x70, 0x00,
+    // P (80)
+    0xF0, 0x88, 0x88, 0xF0, 0x80, 0x80, 0x80, 0x00,
+    // Q (81)
+    0x70, 0x88, 0x88, 0x88, 0xA8, 0x90, 0x68, 0x00,
+    // R (82)
+    0xF0, 0x88, 0x88, 0xF0, 0xA0, 0x90, 0x88, 0x00,
+    // S (83)
+    0x78, 0x80, 0x80, 0x70, 0x08, 0x08, 0xF0, 0x00,
+    // T (84)
+    0xF8, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00,
+    // U (85)
+    0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x70, 0x00,
+    // V (86)
+    0x88, 0x88, 0x88, 0x88, 0x88, 0x50, 0x20, 0x00,
+    // W (87)
+    0x88, 0x88, 0x88, 0xA8, 0xA8, 0xD8, 0x88, 0x00,
+    // X (88)
+    0x88, 0x88, 0x50, 0x20, 0x50, 0x88, 0x88, 0x00,
+    // Y (89)
+    0x88, 0x88, 0x50, 0x20, 0x20, 0x20, 0x20, 0x00,
+    // Z (90)
+    0xF8, 0x08, 0x10, 0x20, 0x40, 0x80, 0xF8, 0x00,
+    // [ (91)
+    0x70, 0x40, 0x40, 0x40, 0x40, 0x40, 0x70, 0x00,
+    // \ (92)
+    0x00, 0x80, 0x40, 0x20, 0x10, 0x08, 0x00, 0x00,
+    // ] (93)
+    0x70, 0x10, 0x10, 0x10, 0x10, 0x10, 0x70, 0x00,
+    // ^ (94)
+    0x20, 0x50, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00,
+    // _ (95)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8, 0x00,
+    // ` (96)
+    0x40, 0x20, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00,
+    // a (97)
+    0x00, 0x00, 0x70, 0x08, 0x78, 0x88, 0x78, 0x00,
+    // b (98)
+    0x80, 0x80, 0xB0, 0xC8, 0x88, 0x88, 0xF0, 0x00,
+    // c (99)
+    0x00, 0x00, 0x70, 0x80, 0x80, 0x88, 0x70, 0x00,
+    // d (100)
+    0x08, 0x08, 0x68, 0x98, 0x88, 0x88, 0x78, 0x00,
+    // e (101)
+    0x00, 0x00, 0x70, 0x88, 0xF8, 0x80, 0x70, 0x00,
+    // f (102)
+    0x30, 0x48, 0x40, 0xE0, 0x40, 0x40, 0x40, 0x00,
+    // g (103)
+    0x00, 0x00, 0x78, 0x88, 0x78, 0x08, 0x30, 0x00,
+    // h (104)
+    0x80, 0x80, 0xB0, 0xC8, 0x88, 0x88, 0x88, 0x00,
+    // i (105)
+    0x20, 0x00, 0x60, 0x20, 0x20, 0x20, 0x70, 0x00,
+    // j (106)
+    0x10, 0x00, 0x30, 0x10, 0x10, 0x90, 0x60, 0x00,
+    // k (107)
+    0x40, 0x40, 0x48, 0x50, 0x60, 0x50, 0x48, 0x00,
+    // l (108)
+    0x60, 0x20, 0x20, 0x20, 0x20, 0x20, 0x70, 0x00,
+    // m (109)
+    0x00, 0x00, 0xD0, 0xA8, 0xA8, 0x88, 0x88, 0x00,
+    // n (110)
+    0x00, 0x00, 0xB0, 0xC8, 0x88, 0x88, 0x88, 0x00,
+    // o (111)
+    0x00, 0x00, 0x70, 0x88, 0x88, 0x88, 0x70, 0x00,
+    // p (112)
+    0x00, 0x00, 0xF0, 0x88, 0xF0, 0x80, 0x80, 0x00,
+    // q (113)
+    0x00, 0x00, 0x68, 0x98, 0x78, 0x08, 0x08, 0x00,
+    // r (114)
+    0x00, 0x00, 0xB0, 0xC8, 0x80, 0x80, 0x80, 0x00,
+    // s (115)
+    0x00, 0x00, 0x70, 0x80, 0x70, 0x08, 0xF0, 0x00,
+    // t (116)
+    0x40, 0x40, 0xE0, 0x40, 0x40, 0x48, 0x30, 0x00,
+    // u (117)
+    0x00, 0x00, 0x88, 0x88, 0x88, 0x98, 0x68, 0x00,
+    // v (118)
+    0x00, 0x00, 0x88, 0x88, 0x88, 0x50, 0x20, 0x00,
+    // w (119)
+    0x00, 0x00, 0x88, 0x88, 0xA8, 0xA8, 0x50, 0x00,
+    // x (120)
+    0x00, 0x00, 0x88, 0x50, 0x20, 0x50, 0x88, 0x00,
+    // y (121)
+    0x00, 0x00, 0x88, 0x88, 0x78, 0x08, 0x70, 0x00,
+    // z (122)
+    0x00, 0x00, 0xF8, 0x10, 0x20, 0x40, 0xF8, 0x00,
+    // { (123)
+    0x10, 0x20, 0x20, 0x40, 0x20, 0x20, 0x10, 0x00,
+    // | (124)
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00,
+    // } (125)
+    0x40, 0x20, 0x20, 0x10, 0x20, 0x20, 0x40, 0x00,
+    // ~ (126)
+    0x40, 0xA8, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+#endif // FONT6X8_H
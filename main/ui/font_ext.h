@@ -0,0 +1,372 @@
+/**
+ * @file font_ext.h
+ * @brief Extended glyphs for the text UI, as decompositions of ASCII glyphs
+ * 
+ * Each entry names an ASCII base glyph and a mark drawn over, under or
+ * through it, so a non-ASCII letter costs 4 bytes of flash instead of a
+ * bitmap per font. Covers Latin-1, Latin Extended-A, Romanian comma
+ * letters, common punctuation and symbols, and Greek/Cyrillic letters
+ * that look like ASCII ones.
+ * 
+ * Sorted by code point for binary search.
+ */
+
+#ifndef FONT_EXT_H
+#define FONT_EXT_H
+
+#include <stdint.h>
+
+// Marks combined with the base glyph
+
+#define FONT_EXT_NONE             0
+#define FONT_EXT_GRAVE            1
+#define FONT_EXT_ACUTE            2
+#define FONT_EXT_CIRCUMFLEX       3
+#define FONT_EXT_TILDE            4
+#define FONT_EXT_MACRON           5
+#define FONT_EXT_BREVE            6
+#define FONT_EXT_DOT              7
+#define FONT_EXT_DIAERESIS        8
+#define FONT_EXT_RING             9
+#define FONT_EXT_DOUBLE_ACUTE     10
+#define FONT_EXT_CARON            11
+#define FONT_EXT_CEDILLA          12
+#define FONT_EXT_OGONEK           13
+#define FONT_EXT_STROKE           14
+#define FONT_EXT_SLASH            15
+#define FONT_EXT_DOTLESS          16
+
+typedef struct {
+    uint16_t code;      // Unicode code point
+    char base;          // ASCII glyph it is drawn from
+    uint8_t mark;       // FONT_EXT_*
+} font_ext_entry_t;
+
+static const font_ext_entry_t font_ext_table[] = {
+    { 0x00A0, ' ', FONT_EXT_NONE },  // No-Break Space
+    { 0x00A1, '!', FONT_EXT_NONE },  // Inverted Exclamation Mark
+    { 0x00A2, 'c', FONT_EXT_NONE },  // Cent Sign
+    { 0x00A3, 'L', FONT_EXT_STROKE },  // Pound Sign
+    { 0x00A5, 'Y', FONT_EXT_NONE },  // Yen Sign
+    { 0x00A6, '|', FONT_EXT_NONE },  // Broken Bar
+    { 0x00A7, 'S', FONT_EXT_NONE },  // Section Sign
+    { 0x00A9, 'C', FONT_EXT_NONE },  // Copyright Sign
+    { 0x00AA, 'a', FONT_EXT_NONE },  // Feminine Ordinal Indicator
+    { 0x00AB, '<', FONT_EXT_NONE },  // Left-Pointing Double Angle Quotation Mark
+    { 0x00AC, '-', FONT_EXT_NONE },  // Not Sign
+    { 0x00AD, '-', FONT_EXT_NONE },  // Soft Hyphen
+    { 0x00AE, 'R', FONT_EXT_NONE },  // Registered Sign
+    { 0x00AF, '-', FONT_EXT_NONE },  // Macron
+    { 0x00B0, 'o', FONT_EXT_NONE },  // Degree Sign
+    { 0x00B1, '+', FONT_EXT_NONE },  // Plus-Minus Sign
+    { 0x00B2, '2', FONT_EXT_NONE },  // Superscript Two
+    { 0x00B3, '3', FONT_EXT_NONE },  // Superscript Three
+    { 0x00B4, '\'', FONT_EXT_NONE },  // Acute Accent
+    { 0x00B5, 'u', FONT_EXT_NONE },  // Micro Sign
+    { 0x00B7, '.', FONT_EXT_NONE },  // Middle Dot
+    { 0x00B8, ',', FONT_EXT_NONE },  // Cedilla
+    { 0x00B9, '1', FONT_EXT_NONE },  // Superscript One
+    { 0x00BA, 'o', FONT_EXT_NONE },  // Masculine Ordinal Indicator
+    { 0x00BB, '>', FONT_EXT_NONE },  // Right-Pointing Double Angle Quotation Mark
+    { 0x00BF, '?', FONT_EXT_NONE },  // Inverted Question Mark
+    { 0x00C0, 'A', FONT_EXT_GRAVE },  // Capital A With Grave
+    { 0x00C1, 'A', FONT_EXT_ACUTE },  // Capital A With Acute
+    { 0x00C2, 'A', FONT_EXT_CIRCUMFLEX },  // Capital A With Circumflex
+    { 0x00C3, 'A', FONT_EXT_TILDE },  // Capital A With Tilde
+    { 0x00C4, 'A', FONT_EXT_DIAERESIS },  // Capital A With Diaeresis
+    { 0x00C5, 'A', FONT_EXT_RING },  // Capital A With Ring Above
+    { 0x00C6, 'A', FONT_EXT_NONE },  // Capital Ae
+    { 0x00C7, 'C', FONT_EXT_CEDILLA },  // Capital C With Cedilla
+    { 0x00C8, 'E', FONT_EXT_GRAVE },  // Capital E With Grave
+    { 0x00C9, 'E', FONT_EXT_ACUTE },  // Capital E With Acute
+    { 0x00CA, 'E', FONT_EXT_CIRCUMFLEX },  // Capital E With Circumflex
+    { 0x00CB, 'E', FONT_EXT_DIAERESIS },  // Capital E With Diaeresis
+    { 0x00CC, 'I', FONT_EXT_GRAVE },  // Capital I With Grave
+    { 0x00CD, 'I', FONT_EXT_ACUTE },  // Capital I With Acute
+    { 0x00CE, 'I', FONT_EXT_CIRCUMFLEX },  // Capital I With Circumflex
+    { 0x00CF, 'I', FONT_EXT_DIAERESIS },  // Capital I With Diaeresis
+    { 0x00D0, 'D', FONT_EXT_STROKE },  // Capital Eth
+    { 0x00D1, 'N', FONT_EXT_TILDE },  // Capital N With Tilde
+    { 0x00D2, 'O', FONT_EXT_GRAVE },  // Capital O With Grave
+    { 0x00D3, 'O', FONT_EXT_ACUTE },  // Capital O With Acute
+    { 0x00D4, 'O', FONT_EXT_CIRCUMFLEX },  // Capital O With Circumflex
+    { 0x00D5, 'O', FONT_EXT_TILDE },  // Capital O With Tilde
+    { 0x00D6, 'O', FONT_EXT_DIAERESIS },  // Capital O With Diaeresis
+    { 0x00D7, 'x', FONT_EXT_NONE },  // Multiplication Sign
+    { 0x00D8, 'O', FONT_EXT_SLASH },  // Capital O With Stroke
+    { 0x00D9, 'U', FONT_EXT_GRAVE },  // Capital U With Grave
+    { 0x00DA, 'U', FONT_EXT_ACUTE },  // Capital U With Acute
+    { 0x00DB, 'U', FONT_EXT_CIRCUMFLEX },  // Capital U With Circumflex
+    { 0x00DC, 'U', FONT_EXT_DIAERESIS },  // Capital U With Diaeresis
+    { 0x00DD, 'Y', FONT_EXT_ACUTE },  // Capital Y With Acute
+    { 0x00DE, 'P', FONT_EXT_NONE },  // Capital Thorn
+    { 0x00DF, 'B', FONT_EXT_NONE },  // Small Sharp S
+    { 0x00E0, 'a', FONT_EXT_GRAVE },  // Small A With Grave
+    { 0x00E1, 'a', FONT_EXT_ACUTE },  // Small A With Acute
+    { 0x00E2, 'a', FONT_EXT_CIRCUMFLEX },  // Small A With Circumflex
+    { 0x00E3, 'a', FONT_EXT_TILDE },  // Small A With Tilde
+    { 0x00E4, 'a', FONT_EXT_DIAERESIS },  // Small A With Diaeresis
+    { 0x00E5, 'a', FONT_EXT_RING },  // Small A With Ring Above
+    { 0x00E6, 'a', FONT_EXT_NONE },  // Small Ae
+    { 0x00E7, 'c', FONT_EXT_CEDILLA },  // Small C With Cedilla
+    { 0x00E8, 'e', FONT_EXT_GRAVE },  // Small E With Grave
+    { 0x00E9, 'e', FONT_EXT_ACUTE },  // Small E With Acute
+    { 0x00EA, 'e', FONT_EXT_CIRCUMFLEX },  // Small E With Circumflex
+    { 0x00EB, 'e', FONT_EXT_DIAERESIS },  // Small E With Diaeresis
+    { 0x00EC, 'i', FONT_EXT_GRAVE },  // Small I With Grave
+    { 0x00ED, 'i', FONT_EXT_ACUTE },  // Small I With Acute
+    { 0x00EE, 'i', FONT_EXT_CIRCUMFLEX },  // Small I With Circumflex
+    { 0x00EF, 'i', FONT_EXT_DIAERESIS },  // Small I With Diaeresis
+    { 0x00F0, 'd', FONT_EXT_STROKE },  // Small Eth
+    { 0x00F1, 'n', FONT_EXT_TILDE },  // Small N With Tilde
+    { 0x00F2, 'o', FONT_EXT_GRAVE },  // Small O With Grave
+    { 0x00F3, 'o', FONT_EXT_ACUTE },  // Small O With Acute
+    { 0x00F4, 'o', FONT_EXT_CIRCUMFLEX },  // Small O With Circumflex
+    { 0x00F5, 'o', FONT_EXT_TILDE },  // Small O With Tilde
+    { 0x00F6, 'o', FONT_EXT_DIAERESIS },  // Small O With Diaeresis
+    { 0x00F7, '/', FONT_EXT_NONE },  // Division Sign
+    { 0x00F8, 'o', FONT_EXT_SLASH },  // Small O With Stroke
+    { 0x00F9, 'u', FONT_EXT_GRAVE },  // Small U With Grave
+    { 0x00FA, 'u', FONT_EXT_ACUTE },  // Small U With Acute
+    { 0x00FB, 'u', FONT_EXT_CIRCUMFLEX },  // Small U With Circumflex
+    { 0x00FC, 'u', FONT_EXT_DIAERESIS },  // Small U With Diaeresis
+    { 0x00FD, 'y', FONT_EXT_ACUTE },  // Small Y With Acute
+    { 0x00FE, 'p', FONT_EXT_NONE },  // Small Thorn
+    { 0x00FF, 'y', FONT_EXT_DIAERESIS },  // Small Y With Diaeresis
+    { 0x0100, 'A', FONT_EXT_MACRON },  // Capital A With Macron
+    { 0x0101, 'a', FONT_EXT_MACRON },  // Small A With Macron
+    { 0x0102, 'A', FONT_EXT_BREVE },  // Capital A With Breve
+    { 0x0103, 'a', FONT_EXT_BREVE },  // Small A With Breve
+    { 0x0104, 'A', FONT_EXT_OGONEK },  // Capital A With Ogonek
+    { 0x0105, 'a', FONT_EXT_OGONEK },  // Small A With Ogonek
+    { 0x0106, 'C', FONT_EXT_ACUTE },  // Capital C With Acute
+    { 0x0107, 'c', FONT_EXT_ACUTE },  // Small C With Acute
+    { 0x0108, 'C', FONT_EXT_CIRCUMFLEX },  // Capital C With Circumflex
+    { 0x0109, 'c', FONT_EXT_CIRCUMFLEX },  // Small C With Circumflex
+    { 0x010A, 'C', FONT_EXT_DOT },  // Capital C With Dot Above
+    { 0x010B, 'c', FONT_EXT_DOT },  // Small C With Dot Above
+    { 0x010C, 'C', FONT_EXT_CARON },  // Capital C With Caron
+    { 0x010D, 'c', FONT_EXT_CARON },  // Small C With Caron
+    { 0x010E, 'D', FONT_EXT_CARON },  // Capital D With Caron
+    { 0x010F, 'd', FONT_EXT_CARON },  // Small D With Caron
+    { 0x0110, 'D', FONT_EXT_STROKE },  // Capital D With Stroke
+    { 0x0111, 'd', FONT_EXT_STROKE },  // Small D With Stroke
+    { 0x0112, 'E', FONT_EXT_MACRON },  // Capital E With Macron
+    { 0x0113, 'e', FONT_EXT_MACRON },  // Small E With Macron
+    { 0x0114, 'E', FONT_EXT_BREVE },  // Capital E With Breve
+    { 0x0115, 'e', FONT_EXT_BREVE },  // Small E With Breve
+    { 0x0116, 'E', FONT_EXT_DOT },  // Capital E With Dot Above
+    { 0x0117, 'e', FONT_EXT_DOT },  // Small E With Dot Above
+    { 0x0118, 'E', FONT_EXT_OGONEK },  // Capital E With Ogonek
+    { 0x0119, 'e', FONT_EXT_OGONEK },  // Small E With Ogonek
+    { 0x011A, 'E', FONT_EXT_CARON },  // Capital E With Caron
+    { 0x011B, 'e', FONT_EXT_CARON },  // Small E With Caron
+    { 0x011C, 'G', FONT_EXT_CIRCUMFLEX },  // Capital G With Circumflex
+    { 0x011D, 'g', FONT_EXT_CIRCUMFLEX },  // Small G With Circumflex
+    { 0x011E, 'G', FONT_EXT_BREVE },  // Capital G With Breve
+    { 0x011F, 'g', FONT_EXT_BREVE },  // Small G With Breve
+    { 0x0120, 'G', FONT_EXT_DOT },  // Capital G With Dot Above
+    { 0x0121, 'g', FONT_EXT_DOT },  // Small G With Dot Above
+    { 0x0122, 'G', FONT_EXT_CEDILLA },  // Capital G With Cedilla
+    { 0x0123, 'g', FONT_EXT_CEDILLA },  // Small G With Cedilla
+    { 0x0124, 'H', FONT_EXT_CIRCUMFLEX },  // Capital H With Circumflex
+    { 0x0125, 'h', FONT_EXT_CIRCUMFLEX },  // Small H With Circumflex
+    { 0x0126, 'H', FONT_EXT_STROKE },  // Capital H With Stroke
+    { 0x0127, 'h', FONT_EXT_STROKE },  // Small H With Stroke
+    { 0x0128, 'I', FONT_EXT_TILDE },  // Capital I With Tilde
+    { 0x0129, 'i', FONT_EXT_TILDE },  // Small I With Tilde
+    { 0x012A, 'I', FONT_EXT_MACRON },  // Capital I With Macron
+    { 0x012B, 'i', FONT_EXT_MACRON },  // Small I With Macron
+    { 0x012C, 'I', FONT_EXT_BREVE },  // Capital I With Breve
+    { 0x012D, 'i', FONT_EXT_BREVE },  // Small I With Breve
+    { 0x012E, 'I', FONT_EXT_OGONEK },  // Capital I With Ogonek
+    { 0x012F, 'i', FONT_EXT_OGONEK },  // Small I With Ogonek
+    { 0x0130, 'I', FONT_EXT_DOT },  // Capital I With Dot Above
+    { 0x0131, 'i', FONT_EXT_DOTLESS },  // Small Dotless I
+    { 0x0132, 'J', FONT_EXT_NONE },  // Capital Ligature Ij
+    { 0x0133, 'j', FONT_EXT_NONE },  // Small Ligature Ij
+    { 0x0134, 'J', FONT_EXT_CIRCUMFLEX },  // Capital J With Circumflex
+    { 0x0135, 'j', FONT_EXT_CIRCUMFLEX },  // Small J With Circumflex
+    { 0x0136, 'K', FONT_EXT_CEDILLA },  // Capital K With Cedilla
+    { 0x0137, 'k', FONT_EXT_CEDILLA },  // Small K With Cedilla
+    { 0x0138, 'k', FONT_EXT_NONE },  // Small Kra
+    { 0x0139, 'L', FONT_EXT_ACUTE },  // Capital L With Acute
+    { 0x013A, 'l', FONT_EXT_ACUTE },  // Small L With Acute
+    { 0x013B, 'L', FONT_EXT_CEDILLA },  // Capital L With Cedilla
+    { 0x013C, 'l', FONT_EXT_CEDILLA },  // Small L With Cedilla
+    { 0x013D, 'L', FONT_EXT_CARON },  // Capital L With Caron
+    { 0x013E, 'l', FONT_EXT_CARON },  // Small L With Caron
+    { 0x013F, 'L', FONT_EXT_NONE },  // Capital L With Middle Dot
+    { 0x0140, 'l', FONT_EXT_NONE },  // Small L With Middle Dot
+    { 0x0141, 'L', FONT_EXT_STROKE },  // Capital L With Stroke
+    { 0x0142, 'l', FONT_EXT_STROKE },  // Small L With Stroke
+    { 0x0143, 'N', FONT_EXT_ACUTE },  // Capital N With Acute
+    { 0x0144, 'n', FONT_EXT_ACUTE },  // Small N With Acute
+    { 0x0145, 'N', FONT_EXT_CEDILLA },  // Capital N With Cedilla
+    { 0x0146, 'n', FONT_EXT_CEDILLA },  // Small N With Cedilla
+    { 0x0147, 'N', FONT_EXT_CARON },  // Capital N With Caron
+    { 0x0148, 'n', FONT_EXT_CARON },  // Small N With Caron
+    { 0x0149, 'n', FONT_EXT_NONE },  // Small N Preceded By Apostrophe
+    { 0x014A, 'N', FONT_EXT_NONE },  // Capital Eng
+    { 0x014B, 'n', FONT_EXT_NONE },  // Small Eng
+    { 0x014C, 'O', FONT_EXT_MACRON },  // Capital O With Macron
+    { 0x014D, 'o', FONT_EXT_MACRON },  // Small O With Macron
+    { 0x014E, 'O', FONT_EXT_BREVE },  // Capital O With Breve
+    { 0x014F, 'o', FONT_EXT_BREVE },  // Small O With Breve
+    { 0x0150, 'O', FONT_EXT_DOUBLE_ACUTE },  // Capital O With Double Acute
+    { 0x0151, 'o', FONT_EXT_DOUBLE_ACUTE },  // Small O With Double Acute
+    { 0x0152, 'O', FONT_EXT_NONE },  // Capital Ligature Oe
+    { 0x0153, 'o', FONT_EXT_NONE },  // Small Ligature Oe
+    { 0x0154, 'R', FONT_EXT_ACUTE },  // Capital R With Acute
+    { 0x0155, 'r', FONT_EXT_ACUTE },  // Small R With Acute
+    { 0x0156, 'R', FONT_EXT_CEDILLA },  // Capital R With Cedilla
+    { 0x0157, 'r', FONT_EXT_CEDILLA },  // Small R With Cedilla
+    { 0x0158, 'R', FONT_EXT_CARON },  // Capital R With Caron
+    { 0x0159, 'r', FONT_EXT_CARON },  // Small R With Caron
+    { 0x015A, 'S', FONT_EXT_ACUTE },  // Capital S With Acute
+    { 0x015B, 's', FONT_EXT_ACUTE },  // Small S With Acute
+    { 0x015C, 'S', FONT_EXT_CIRCUMFLEX },  // Capital S With Circumflex
+    { 0x015D, 's', FONT_EXT_CIRCUMFLEX },  // Small S With Circumflex
+    { 0x015E, 'S', FONT_EXT_CEDILLA },  // Capital S With Cedilla
+    { 0x015F, 's', FONT_EXT_CEDILLA },  // Small S With Cedilla
+    { 0x0160, 'S', FONT_EXT_CARON },  // Capital S With Caron
+    { 0x0161, 's', FONT_EXT_CARON },  // Small S With Caron
+    { 0x0162, 'T', FONT_EXT_CEDILLA },  // Capital T With Cedilla
+    { 0x0163, 't', FONT_EXT_CEDILLA },  // Small T With Cedilla
+    { 0x0164, 'T', FONT_EXT_CARON },  // Capital T With Caron
+    { 0x0165, 't', FONT_EXT_CARON },  // Small T With Caron
+    { 0x0166, 'T', FONT_EXT_STROKE },  // Capital T With Stroke
+    { 0x0167, 't', FONT_EXT_STROKE },  // Small T With Stroke
+    { 0x0168, 'U', FONT_EXT_TILDE },  // Capital U With Tilde
+    { 0x0169, 'u', FONT_EXT_TILDE },  // Small U With Tilde
+    { 0x016A, 'U', FONT_EXT_MACRON },  // Capital U With Macron
+    { 0x016B, 'u', FONT_EXT_MACRON },  // Small U With Macron
+    { 0x016C, 'U', FONT_EXT_BREVE },  // Capital U With Breve
+    { 0x016D, 'u', FONT_EXT_BREVE },  // Small U With Breve
+    { 0x016E, 'U', FONT_EXT_RING },  // Capital U With Ring Above
+    { 0x016F, 'u', FONT_EXT_RING },  // Small U With Ring Above
+    { 0x0170, 'U', FONT_EXT_DOUBLE_ACUTE },  // Capital U With Double Acute
+    { 0x0171, 'u', FONT_EXT_DOUBLE_ACUTE },  // Small U With Double Acute
+    { 0x0172, 'U', FONT_EXT_OGONEK },  // Capital U With Ogonek
+    { 0x0173, 'u', FONT_EXT_OGONEK },  // Small U With Ogonek
+    { 0x0174, 'W', FONT_EXT_CIRCUMFLEX },  // Capital W With Circumflex
+    { 0x0175, 'w', FONT_EXT_CIRCUMFLEX },  // Small W With Circumflex
+    { 0x0176, 'Y', FONT_EXT_CIRCUMFLEX },  // Capital Y With Circumflex
+    { 0x0177, 'y', FONT_EXT_CIRCUMFLEX },  // Small Y With Circumflex
+    { 0x0178, 'Y', FONT_EXT_DIAERESIS },  // Capital Y With Diaeresis
+    { 0x0179, 'Z', FONT_EXT_ACUTE },  // Capital Z With Acute
+    { 0x017A, 'z', FONT_EXT_ACUTE },  // Small Z With Acute
+    { 0x017B, 'Z', FONT_EXT_DOT },  // Capital Z With Dot Above
+    { 0x017C, 'z', FONT_EXT_DOT },  // Small Z With Dot Above
+    { 0x017D, 'Z', FONT_EXT_CARON },  // Capital Z With Caron
+    { 0x017E, 'z', FONT_EXT_CARON },  // Small Z With Caron
+    { 0x017F, 'f', FONT_EXT_NONE },  // Small Long S
+    { 0x0218, 'S', FONT_EXT_CEDILLA },  // Capital S With Comma Below
+    { 0x0219, 's', FONT_EXT_CEDILLA },  // Small S With Comma Below
+    { 0x021A, 'T', FONT_EXT_CEDILLA },  // Capital T With Comma Below
+    { 0x021B, 't', FONT_EXT_CEDILLA },  // Small T With Comma Below
+    { 0x0391, 'A', FONT_EXT_NONE },  // Greek Capital Alpha
+    { 0x0392, 'B', FONT_EXT_NONE },  // Greek Capital Beta
+    { 0x0395, 'E', FONT_EXT_NONE },  // Greek Capital Epsilon
+    { 0x0396, 'Z', FONT_EXT_NONE },  // Greek Capital Zeta
+    { 0x0397, 'H', FONT_EXT_NONE },  // Greek Capital Eta
+    { 0x0399, 'I', FONT_EXT_NONE },  // Greek Capital Iota
+    { 0x039A, 'K', FONT_EXT_NONE },  // Greek Capital Kappa
+    { 0x039C, 'M', FONT_EXT_NONE },  // Greek Capital Mu
+    { 0x039D, 'N', FONT_EXT_NONE },  // Greek Capital Nu
+    { 0x039F, 'O', FONT_EXT_NONE },  // Greek Capital Omicron
+    { 0x03A1, 'P', FONT_EXT_NONE },  // Greek Capital Rho
+    { 0x03A4, 'T', FONT_EXT_NONE },  // Greek Capital Tau
+    { 0x03A5, 'Y', FONT_EXT_NONE },  // Greek Capital Upsilon
+    { 0x03A7, 'X', FONT_EXT_NONE },  // Greek Capital Chi
+    { 0x03AC, 'a', FONT_EXT_ACUTE },  // Greek Small Alpha With Tonos
+    { 0x03AD, 'e', FONT_EXT_ACUTE },  // Greek Small Epsilon With Tonos
+    { 0x03B1, 'a', FONT_EXT_NONE },  // Greek Small Alpha
+    { 0x03B9, 'i', FONT_EXT_NONE },  // Greek Small Iota
+    { 0x03BA, 'k', FONT_EXT_NONE },  // Greek Small Kappa
+    { 0x03BD, 'v', FONT_EXT_NONE },  // Greek Small Nu
+    { 0x03BF, 'o', FONT_EXT_NONE },  // Greek Small Omicron
+    { 0x03C1, 'p', FONT_EXT_NONE },  // Greek Small Rho
+    { 0x03C4, 't', FONT_EXT_NONE },  // Greek Small Tau
+    { 0x03C5, 'u', FONT_EXT_NONE },  // Greek Small Upsilon
+    { 0x03C7, 'x', FONT_EXT_NONE },  // Greek Small Chi
+    { 0x03C9, 'w', FONT_EXT_NONE },  // Greek Small Omega
+    { 0x03CC, 'o', FONT_EXT_ACUTE },  // Greek Small Omicron With Tonos
+    { 0x0401, 'E', FONT_EXT_DIAERESIS },  // Cyrillic Capital Io
+    { 0x0405, 'S', FONT_EXT_NONE },  // Cyrillic Capital Dze
+    { 0x0406, 'I', FONT_EXT_NONE },  // Cyrillic Capital Byelorussian-Ukrainian I
+    { 0x0407, 'I', FONT_EXT_DIAERESIS },  // Cyrillic Capital Yi
+    { 0x0408, 'J', FONT_EXT_NONE },  // Cyrillic Capital Je
+    { 0x040E, 'Y', FONT_EXT_BREVE },  // Cyrillic Capital Short U
+    { 0x0410, 'A', FONT_EXT_NONE },  // Cyrillic Capital A
+    { 0x0412, 'B', FONT_EXT_NONE },  // Cyrillic Capital Ve
+    { 0x0415, 'E', FONT_EXT_NONE },  // Cyrillic Capital Ie
+    { 0x0417, '3', FONT_EXT_NONE },  // Cyrillic Capital Ze
+    { 0x0419, 'N', FONT_EXT_BREVE },  // Cyrillic Capital Short I
+    { 0x041A, 'K', FONT_EXT_NONE },  // Cyrillic Capital Ka
+    { 0x041C, 'M', FONT_EXT_NONE },  // Cyrillic Capital Em
+    { 0x041D, 'H', FONT_EXT_NONE },  // Cyrillic Capital En
+    { 0x041E, 'O', FONT_EXT_NONE },  // Cyrillic Capital O
+    { 0x0420, 'P', FONT_EXT_NONE },  // Cyrillic Capital Er
+    { 0x0421, 'C', FONT_EXT_NONE },  // Cyrillic Capital Es
+    { 0x0422, 'T', FONT_EXT_NONE },  // Cyrillic Capital Te
+    { 0x0423, 'Y', FONT_EXT_NONE },  // Cyrillic Capital U
+    { 0x0425, 'X', FONT_EXT_NONE },  // Cyrillic Capital Ha
+    { 0x0430, 'a', FONT_EXT_NONE },  // Cyrillic Small A
+    { 0x0432, 'b', FONT_EXT_NONE },  // Cyrillic Small Ve
+    { 0x0433, 'r', FONT_EXT_NONE },  // Cyrillic Small Ghe
+    { 0x0435, 'e', FONT_EXT_NONE },  // Cyrillic Small Ie
+    { 0x0437, '3', FONT_EXT_NONE },  // Cyrillic Small Ze
+    { 0x0438, 'u', FONT_EXT_NONE },  // Cyrillic Small I
+    { 0x0439, 'u', FONT_EXT_BREVE },  // Cyrillic Small Short I
+    { 0x043A, 'k', FONT_EXT_NONE },  // Cyrillic Small Ka
+    { 0x043C, 'm', FONT_EXT_NONE },  // Cyrillic Small Em
+    { 0x043D, 'h', FONT_EXT_NONE },  // Cyrillic Small En
+    { 0x043E, 'o', FONT_EXT_NONE },  // Cyrillic Small O
+    { 0x043F, 'n', FONT_EXT_NONE },  // Cyrillic Small Pe
+    { 0x0440, 'p', FONT_EXT_NONE },  // Cyrillic Small Er
+    { 0x0441, 'c', FONT_EXT_NONE },  // Cyrillic Small Es
+    { 0x0442, 't', FONT_EXT_NONE },  // Cyrillic Small Te
+    { 0x0443, 'y', FONT_EXT_NONE },  // Cyrillic Small U
+    { 0x0445, 'x', FONT_EXT_NONE },  // Cyrillic Small Ha
+    { 0x0448, 'w', FONT_EXT_NONE },  // Cyrillic Small Sha
+    { 0x044C, 'b', FONT_EXT_NONE },  // Cyrillic Small Soft Sign
+    { 0x0451, 'e', FONT_EXT_DIAERESIS },  // Cyrillic Small Io
+    { 0x0455, 's', FONT_EXT_NONE },  // Cyrillic Small Dze
+    { 0x0456, 'i', FONT_EXT_NONE },  // Cyrillic Small Byelorussian-Ukrainian I
+    { 0x0457, 'i', FONT_EXT_DIAERESIS },  // Cyrillic Small Yi
+    { 0x0458, 'j', FONT_EXT_NONE },  // Cyrillic Small Je
+    { 0x045E, 'y', FONT_EXT_BREVE },  // Cyrillic Small Short U
+    { 0x2010, '-', FONT_EXT_NONE },  // Hyphen
+    { 0x2011, '-', FONT_EXT_NONE },  // Non-Breaking Hyphen
+    { 0x2012, '-', FONT_EXT_NONE },  // Figure Dash
+    { 0x2013, '-', FONT_EXT_NONE },  // En Dash
+    { 0x2014, '-', FONT_EXT_NONE },  // Em Dash
+    { 0x2015, '-', FONT_EXT_NONE },  // Horizontal Bar
+    { 0x2018, '\'', FONT_EXT_NONE },  // Left Single Quotation Mark
+    { 0x2019, '\'', FONT_EXT_NONE },  // Right Single Quotation Mark
+    { 0x201A, ',', FONT_EXT_NONE },  // Single Low-9 Quotation Mark
+    { 0x201B, '\'', FONT_EXT_NONE },  // Single High-Reversed-9 Quotation Mark
+    { 0x201C, '"', FONT_EXT_NONE },  // Left Double Quotation Mark
+    { 0x201D, '"', FONT_EXT_NONE },  // Right Double Quotation Mark
+    { 0x201E, '"', FONT_EXT_NONE },  // Double Low-9 Quotation Mark
+    { 0x2022, '*', FONT_EXT_NONE },  // Bullet
+    { 0x2026, '.', FONT_EXT_NONE },  // Horizontal Ellipsis
+    { 0x2032, '\'', FONT_EXT_NONE },  // Prime
+    { 0x2033, '"', FONT_EXT_NONE },  // Double Prime
+    { 0x2039, '<', FONT_EXT_NONE },  // Single Left-Pointing Angle Quotation Mark
+    { 0x203A, '>', FONT_EXT_NONE },  // Single Right-Pointing Angle Quotation Mark
+    { 0x20AC, 'C', FONT_EXT_STROKE },  // Euro Sign
+    { 0x2122, 'T', FONT_EXT_NONE },  // Trade Mark Sign
+    { 0x2190, '<', FONT_EXT_NONE },  // Leftwards Arrow
+    { 0x2191, '^', FONT_EXT_NONE },  // Upwards Arrow
+    { 0x2192, '>', FONT_EXT_NONE },  // Rightwards Arrow
+    { 0x2193, 'v', FONT_EXT_NONE },  // Downwards Arrow
+    { 0x2605, '*', FONT_EXT_NONE },  // Black Star
+    { 0x2606, '*', FONT_EXT_NONE },  // White Star
+    { 0x2665, '*', FONT_EXT_NONE },  // Black Heart Suit
+};
+
+#define FONT_EXT_COUNT (sizeof(font_ext_table) / sizeof(font_ext_table[0]))
+
+#endif // FONT_EXT_H
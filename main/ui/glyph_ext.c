@@ -0,0 +1,281 @@
+/**
+ * @file glyph_ext.c
+ * @brief UTF-8 decoding and non-ASCII glyphs for the text UI
+ */
+
+#include "glyph_ext.h"
+#include "font_ext.h"
+#include <string.h>
+#include <ctype.h>
+
+#define ASCII_FIRST     32
+#define ASCII_LAST      126
+#define GLYPH_MAX_H     16
+
+// Mark bitmaps (MSB = leftmost pixel) for both fonts
+typedef struct {
+    uint8_t big[2];             // 8x16: two scanlines
+    uint8_t small[2];           // 6x8 over a lowercase letter: two scanlines
+    uint8_t small_tall;         // 6x8 over a capital: one scanline
+    bool below;                 // Drawn under the baseline
+} mark_shape_t;
+
+static const mark_shape_t mark_shapes[] = {
+    [FONT_EXT_GRAVE]        = { { 0x30, 0x18 }, { 0x40, 0x20 }, 0x40, false },
+    [FONT_EXT_ACUTE]        = { { 0x0C, 0x18 }, { 0x10, 0x20 }, 0x10, false },
+    [FONT_EXT_CIRCUMFLEX]   = { { 0x38, 0x6C }, { 0x20, 0x50 }, 0x70, false },
+    [FONT_EXT_TILDE]        = { { 0x76, 0xDC }, { 0x68, 0xB0 }, 0x68, false },
+    [FONT_EXT_MACRON]       = { { 0x00, 0x7C }, { 0x00, 0x70 }, 0x70, false },
+    [FONT_EXT_BREVE]        = { { 0x44, 0x38 }, { 0x88, 0x70 }, 0x88, false },
+    [FONT_EXT_DOT]          = { { 0x18, 0x18 }, { 0x00, 0x20 }, 0x20, false },
+    [FONT_EXT_DIAERESIS]    = { { 0x6C, 0x6C }, { 0x00, 0x50 }, 0x50, false },
+    [FONT_EXT_RING]         = { { 0x38, 0x28 }, { 0x70, 0x50 }, 0x20, false },
+    [FONT_EXT_DOUBLE_ACUTE] = { { 0x36, 0x6C }, { 0x28, 0x50 }, 0x50, false },
+    [FONT_EXT_CARON]        = { { 0x6C, 0x38 }, { 0x50, 0x20 }, 0x70, false },
+    [FONT_EXT_CEDILLA]      = { { 0x18, 0x30 }, { 0x20, 0x00 }, 0x20, true },
+    [FONT_EXT_OGONEK]       = { { 0x0C, 0x06 }, { 0x10, 0x00 }, 0x10, true },
+};
+
+// Placeholder for characters without a glyph
+static const uint8_t box_16[16] = {
+    0x00, 0x00, 0x7E, 0x42, 0x42, 0x42, 0x42, 0x42,
+    0x42, 0x42, 0x42, 0x7E, 0x00, 0x00, 0x00, 0x00,
+};
+static const uint8_t box_8[8] = {
+    0xF8, 0x88, 0x88, 0x88, 0x88, 0x88, 0xF8, 0x00,
+};
+
+// Composed glyphs, least recently used replaced first
+typedef struct {
+    uint32_t key;               // code | font_id << 24, 0 = empty
+    uint32_t used;
+    uint8_t bits[GLYPH_MAX_H];
+} cached_glyph_t;
+
+static cached_glyph_t cache[GLYPH_EXT_CACHE_SIZE];
+static uint32_t use_clock = 0;
+
+int glyph_ext_next(const char *text, uint32_t *code)
+{
+    const uint8_t *s = (const uint8_t *)text;
+    uint8_t lead = s[0];
+    int len;
+    uint32_t cp;
+
+    if (lead < 0x80) {
+        *code = lead;
+        return 1;
+    } else if ((lead & 0xE0) == 0xC0 && lead >= 0xC2) {
+        len = 2;
+        cp = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        len = 3;
+        cp = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0 && lead <= 0xF4) {
+        len = 4;
+        cp = lead & 0x07;
+    } else {
+        len = 0;
+        cp = 0;
+    }
+
+    for (int i = 1; i < len; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            len = 0;            // Truncated sequence (the terminator stops it too)
+            break;
+        }
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+
+    // Overlong forms and surrogates are not UTF-8 either
+    if (len == 3 && (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF))) len = 0;
+    if (len == 4 && (cp < 0x10000 || cp > 0x10FFFF)) len = 0;
+
+    if (len == 0) {
+        *code = lead;           // Latin-1
+        return 1;
+    }
+    *code = cp;
+    return len;
+}
+
+bool glyph_ext_is_zero_width(uint32_t code)
+{
+    return (code >= 0x0300 && code <= 0x036F) ||      // Combining diacritical marks
+           (code >= 0x200B && code <= 0x200F) ||      // Zero width space, joiners, marks
+           (code >= 0xFE00 && code <= 0xFE0F) ||      // Variation selectors
+           code == 0xFEFF ||                         // Byte order mark
+           (code >= 0x1F3FB && code <= 0x1F3FF) ||    // Emoji skin tones
+           (code >= 0xE0000 && code <= 0xE007F);      // Tags
+}
+
+int glyph_ext_cells(const char *text)
+{
+    int cells = 0;
+    while (text && *text) {
+        uint32_t code;
+        text += glyph_ext_next(text, &code);
+        if (code != '\n' && !glyph_ext_is_zero_width(code)) cells++;
+    }
+    return cells;
+}
+
+static const font_ext_entry_t *find_entry(uint32_t code)
+{
+    int lo = 0;
+    int hi = (int)FONT_EXT_COUNT - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (font_ext_table[mid].code == code) return &font_ext_table[mid];
+        if (font_ext_table[mid].code < code) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return NULL;
+}
+
+static const uint8_t *ascii_glyph(const uint8_t *ascii, int height, char c)
+{
+    if (c < ASCII_FIRST || c > ASCII_LAST) c = ' ';
+    return &ascii[(c - ASCII_FIRST) * height];
+}
+
+/**
+ * @brief Column of the stem a stroke crosses (leftmost one, right one of 'd')
+ */
+static int stem_col(const uint8_t *bits, int row, char base, int width)
+{
+    int col = -1;
+    for (int c = 0; c < width; c++) {
+        if (bits[row] & (0x80 >> c)) {
+            col = c;
+            if (base != 'd') break;
+        }
+    }
+    if (col < 0) return width / 2;
+    return (base == 'd' && width > 6) ? col - 1 : col;
+}
+
+static void set_pixel(uint8_t *bits, int row, int col)
+{
+    if (col >= 0 && col < 8) bits[row] |= 0x80 >> col;
+}
+
+/**
+ * @brief Draw a diagonal through the glyph's bounding box (o -> ø)
+ */
+static void add_slash(uint8_t *bits, int height)
+{
+    int top = -1, bottom = -1;
+    uint8_t cols = 0;
+    for (int r = 0; r < height; r++) {
+        if (!bits[r]) continue;
+        if (top < 0) top = r;
+        bottom = r;
+        cols |= bits[r];
+    }
+    if (top < 0 || bottom == top) return;
+
+    int left = 0, right = 7;
+    while (left < 7 && !(cols & (0x80 >> left))) left++;
+    while (right > 0 && !(cols & (0x80 >> right))) right--;
+
+    for (int r = top; r <= bottom; r++) {
+        set_pixel(bits, r, left + (right - left) * (bottom - r) / (bottom - top));
+    }
+}
+
+/**
+ * @brief Build the glyph of a base letter and a mark
+ */
+static void compose(uint8_t *bits, const uint8_t *base_bits, char base, uint8_t mark, int height)
+{
+    const bool big = height >= 16;
+    const int x_top = big ? 5 : 2;          // First scanline of lowercase letters
+    const bool tall = isupper((unsigned char)base) || strchr("bdfhklt", base) != NULL;
+
+    memcpy(bits, base_bits, height);
+
+    if (mark == FONT_EXT_DOTLESS) {
+        memset(bits, 0, x_top);
+        return;
+    }
+    if (mark == FONT_EXT_SLASH) {
+        add_slash(bits, height);
+        return;
+    }
+    if (mark == FONT_EXT_STROKE) {
+        if (big) {
+            int c = stem_col(bits, 7, base, 8);
+            set_pixel(bits, 6, c + 2);
+            set_pixel(bits, 6, c + 3);
+            set_pixel(bits, 8, c - 2);
+            set_pixel(bits, 8, c - 1);
+        } else {
+            int c = stem_col(bits, 3, base, 6);
+            set_pixel(bits, 2, c + 1);
+            set_pixel(bits, 4, c - 1);
+        }
+        return;
+    }
+    if (mark >= sizeof(mark_shapes) / sizeof(mark_shapes[0])) return;
+
+    const mark_shape_t *shape = &mark_shapes[mark];
+    if (shape->below) {
+        if (big) {
+            bits[12] |= shape->big[0];
+            bits[13] |= shape->big[1];
+        } else {
+            bits[7] |= shape->small[0];
+        }
+    } else if (big) {
+        // Capitals and ascenders leave two blank scanlines, lowercase more
+        int row = tall ? 0 : 2;
+        if (!tall) memset(bits, 0, x_top);  // i and j lose their dot
+        bits[row] |= shape->big[0];
+        bits[row + 1] |= shape->big[1];
+    } else if (tall) {
+        // 6x8 capitals fill the cell: move them down a scanline
+        memmove(&bits[1], &bits[0], height - 1);
+        bits[0] = shape->small_tall;
+    } else {
+        memset(bits, 0, x_top);
+        bits[0] |= shape->small[0];
+        bits[1] |= shape->small[1];
+    }
+}
+
+const uint8_t *glyph_ext_bitmap(uint32_t code, int font_id, const uint8_t *ascii, int height)
+{
+    const uint8_t *box = height >= 16 ? box_16 : box_8;
+
+    // Fullwidth forms and the ideographic space
+    if (code >= 0xFF01 && code <= 0xFF5E) {
+        return ascii_glyph(ascii, height, (char)(code - 0xFEE0));
+    }
+    if (code == 0x3000) {
+        return ascii_glyph(ascii, height, ' ');
+    }
+
+    const font_ext_entry_t *entry = code <= 0xFFFF ? find_entry(code) : NULL;
+    if (!entry) return box;
+    const uint8_t *base_bits = ascii_glyph(ascii, height, entry->base);
+    if (entry->mark == FONT_EXT_NONE) return base_bits;
+
+    uint32_t key = code | ((uint32_t)(font_id + 1) << 24);
+    cached_glyph_t *slot = &cache[0];
+    for (int i = 0; i < GLYPH_EXT_CACHE_SIZE; i++) {
+        if (cache[i].key == key) {
+            cache[i].used = ++use_clock;
+            return cache[i].bits;
+        }
+        if (cache[i].used < slot->used) slot = &cache[i];
+    }
+
+    compose(slot->bits, base_bits, entry->base, entry->mark, height);
+    slot->key = key;
+    slot->used = ++use_clock;
+    return slot->bits;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file glyph_ext.h
+ * @brief UTF-8 decoding and non-ASCII glyphs for the text UI
+ *
+ * Letters outside ASCII are composed from an ASCII base glyph and a mark
+ * (font_ext.h) the first time they are drawn, and kept in a small LRU
+ * cache of bitmaps, so an SSID costs the composition once and then draws
+ * like plain text. Fullwidth forms map to ASCII. Characters without a
+ * glyph (CJK, emoji) draw as a box, one per character, so names keep
+ * their length and shape. Combining marks, joiners and variation
+ * selectors take no cell.
+ *
+ * Bytes that are not valid UTF-8 are taken as Latin-1, the other encoding
+ * SSIDs are commonly sent in.
+ *
+ * Called with the UI lock held.
+ */
+
+#ifndef GLYPH_EXT_H
+#define GLYPH_EXT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Composed glyphs kept; must exceed the cells of one text line (UI_COLS_MAX)
+#define GLYPH_EXT_CACHE_SIZE    48
+
+/**
+ * @brief Decode the next character of a string
+ * @param text String, not at its terminator
+ * @param code Receives the code point
+ * @return Bytes consumed (1-4)
+ */
+int glyph_ext_next(const char *text, uint32_t *code);
+
+/**
+ * @brief Whether a code point is drawn without a cell of its own
+ */
+bool glyph_ext_is_zero_width(uint32_t code);
+
+/**
+ * @brief Count the cells a string takes
+ */
+int glyph_ext_cells(const char *text);
+
+/**
+ * @brief Bitmap of a non-ASCII character
+ * @param code Code point (128 or above)
+ * @param font_id Distinguishes fonts in the cache
+ * @param ascii Font bitmaps of ASCII 32-126, 1 byte per scanline, MSB leftmost
+ * @param height Font height (16 or 8)
+ * @return height bytes, valid until GLYPH_EXT_CACHE_SIZE other characters
+ *         have been looked up
+ */
+const uint8_t *glyph_ext_bitmap(uint32_t code, int font_id, const uint8_t *ascii, int height);
+
+#endif // GLYPH_EXT_H
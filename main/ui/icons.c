@@ -0,0 +1,210 @@
+/**
+ * @file icons.c
+ * @brief Status icon sprites and the title bar status strip
+ */
+
+#include "icons.h"
+#include "text_ui.h"
+#include "assets.h"
+#include <string.h>
+
+#define ICON_GAP        3
+#define DIGIT_W         3
+#define DIGIT_H         5
+#define DIGIT_GAP       1
+
+static const uint8_t link_bits[ICON_SIZE] = {
+    0x04, 0xFE, 0x04, 0x00, 0x20, 0x7F, 0x20, 0x00,
+};
+static const uint8_t sd_bits[ICON_SIZE] = {
+    0x3E, 0x6A, 0xEA, 0xFE, 0xFE, 0xFE, 0xFE, 0xFE,
+};
+static const uint8_t gps_bits[ICON_SIZE] = {
+    0x38, 0x44, 0x92, 0x82, 0x44, 0x28, 0x10, 0x00,
+};
+static const uint8_t capture_bits[ICON_SIZE] = {
+    0x00, 0x70, 0x88, 0x8F, 0x8B, 0x70, 0x00, 0x00,
+};
+
+#define ICON_1BPP(bits) { ICON_SIZE, ICON_SIZE, SPRITE_1BPP, 0, 0, bits }
+
+static const sprite_t builtin_icons[ICON_COUNT] = {
+    [ICON_LINK]    = ICON_1BPP(link_bits),
+    [ICON_SD]      = ICON_1BPP(sd_bits),
+    [ICON_GPS]     = ICON_1BPP(gps_bits),
+    [ICON_CAPTURE] = ICON_1BPP(capture_bits),
+};
+
+static const char *const icon_asset_names[ICON_COUNT] = {
+    [ICON_LINK]    = "icon/link",
+    [ICON_SD]      = "icon/sd",
+    [ICON_GPS]     = "icon/gps",
+    [ICON_CAPTURE] = "icon/capture",
+};
+
+// 3x5 digits for counters, one byte per row
+static const uint8_t digit_bits[10][DIGIT_H] = {
+    { 0xE0, 0xA0, 0xA0, 0xA0, 0xE0 },
+    { 0x40, 0xC0, 0x40, 0x40, 0xE0 },
+    { 0xE0, 0x20, 0xE0, 0x80, 0xE0 },
+    { 0xE0, 0x20, 0xE0, 0x20, 0xE0 },
+    { 0xA0, 0xA0, 0xE0, 0x20, 0x20 },
+    { 0xE0, 0x80, 0xE0, 0x20, 0xE0 },
+    { 0xE0, 0x80, 0xE0, 0xA0, 0xE0 },
+    { 0xE0, 0x20, 0x20, 0x20, 0x20 },
+    { 0xE0, 0xA0, 0xE0, 0xA0, 0xE0 },
+    { 0xE0, 0xA0, 0xE0, 0x20, 0xE0 },
+};
+
+static sprite_t asset_icons[ICON_COUNT];
+static bool icons_resolved = false;
+
+/**
+ * @brief Take "icon/<name>" overrides from the asset bundle
+ */
+static void resolve_icons(void)
+{
+    for (int i = 0; i < ICON_COUNT; i++) {
+        size_t size = 0;
+        const uint8_t *blob = assets_find(icon_asset_names[i], &size);
+        if (!blob || size < sizeof(assets_sprite_t)) continue;
+
+        assets_sprite_t hdr;
+        memcpy(&hdr, blob, sizeof(hdr));
+        size_t data_size = size - sizeof(hdr);
+        // Must fit the strip's ICON_SIZE slot
+        if (hdr.width == 0 || hdr.width > ICON_SIZE || hdr.height == 0 || hdr.height > ICON_SIZE) {
+            continue;
+        }
+        if (hdr.format == SPRITE_1BPP) {
+            if (data_size < (size_t)((hdr.width + 7) / 8) * hdr.height) continue;
+        } else if (hdr.format != SPRITE_RLE565 || data_size < 4) {
+            continue;
+        }
+
+        asset_icons[i] = (sprite_t){
+            .width = hdr.width,
+            .height = hdr.height,
+            .format = hdr.format,
+            .key = hdr.key,
+            .data_len = (uint16_t)(data_size / 2 > UINT16_MAX ? UINT16_MAX : data_size / 2),
+            .data = blob + sizeof(hdr),
+        };
+    }
+    icons_resolved = true;
+}
+
+const sprite_t *icon_get(icon_id_t id)
+{
+    if (id >= ICON_COUNT) return NULL;
+    if (!icons_resolved) resolve_icons();
+    return asset_icons[id].data ? &asset_icons[id] : &builtin_icons[id];
+}
+
+uint16_t icon_state_color(icon_state_t state)
+{
+    switch (state) {
+        case ICON_STATE_PENDING: return COLOR_YELLOW;
+        case ICON_STATE_OK:      return COLOR_GREEN;
+        case ICON_STATE_FAIL:    return COLOR_RED;
+        case ICON_STATE_IDLE:    return COLOR_GRAY;
+        default:                 return UI_COLOR_DIMMED;
+    }
+}
+
+void ui_status_strip_init(ui_status_strip_t *strip, int right_x, int y, uint16_t bg)
+{
+    memset(strip, 0, sizeof(*strip));
+    strip->right_x = right_x;
+    strip->y = y;
+    strip->bg = bg;
+}
+
+static bool status_equal(const ui_status_t *a, const ui_status_t *b)
+{
+    return a->link == b->link && a->sd == b->sd && a->gps == b->gps &&
+           a->captures == b->captures;
+}
+
+static int count_digits(unsigned value)
+{
+    int n = 1;
+    while (value >= 10) {
+        value /= 10;
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Pixel width of the visible indicators
+ */
+static int strip_width(const ui_status_t *status)
+{
+    int w = 0;
+    if (status->link != ICON_STATE_HIDDEN) w += ICON_SIZE + ICON_GAP;
+    if (status->sd != ICON_STATE_HIDDEN) w += ICON_SIZE + ICON_GAP;
+    if (status->gps != ICON_STATE_HIDDEN) w += ICON_SIZE + ICON_GAP;
+    if (status->captures > 0) {
+        w += ICON_SIZE + 1 + count_digits(status->captures) * (DIGIT_W + DIGIT_GAP) + ICON_GAP;
+    }
+    return w;
+}
+
+/**
+ * @brief Stamp one icon right-aligned at *x and move *x left past it
+ */
+static void stamp_icon(sprite_canvas_t *canvas, icon_id_t id, icon_state_t state, int *x)
+{
+    if (state == ICON_STATE_HIDDEN) return;
+    *x -= ICON_SIZE + ICON_GAP;
+    sprite_canvas_stamp(canvas, *x, 0, icon_get(id), icon_state_color(state));
+}
+
+static void stamp_count(sprite_canvas_t *canvas, unsigned value, int *x)
+{
+    const sprite_t digit_proto = { DIGIT_W, DIGIT_H, SPRITE_1BPP, 0, 0, NULL };
+    *x -= ICON_GAP + DIGIT_GAP;
+    do {
+        sprite_t digit = digit_proto;
+        digit.data = digit_bits[value % 10];
+        *x -= DIGIT_W;
+        sprite_canvas_stamp(canvas, *x, (ICON_SIZE - DIGIT_H) / 2 + 1, &digit,
+                            UI_COLOR_TEXT);
+        *x -= DIGIT_GAP;
+        value /= 10;
+    } while (value > 0);
+    *x += DIGIT_GAP;
+    *x -= 1 + ICON_SIZE;
+    sprite_canvas_stamp(canvas, *x, 0, icon_get(ICON_CAPTURE), UI_COLOR_HIGHLIGHT);
+}
+
+int ui_status_strip_update(ui_status_strip_t *strip, const ui_status_t *status)
+{
+    int width = strip_width(status);
+    if (strip->valid && strip->generation == ui_get_clear_generation() &&
+        status_equal(&strip->shown, status)) {
+        return strip->right_x - width;
+    }
+
+    // Cover what was painted before so a shrinking strip leaves nothing behind
+    int paint_w = width > strip->shown_width ? width : strip->shown_width;
+    if (strip->generation != ui_get_clear_generation()) paint_w = width;
+
+    sprite_canvas_t *canvas = sprite_shared_canvas();
+    if (paint_w > 0 && sprite_canvas_begin(canvas, paint_w, ICON_SIZE, strip->bg)) {
+        // Right to left: link, SD, GPS, then the capture count
+        int x = paint_w;
+        stamp_icon(canvas, ICON_LINK, status->link, &x);
+        stamp_icon(canvas, ICON_SD, status->sd, &x);
+        stamp_icon(canvas, ICON_GPS, status->gps, &x);
+        if (status->captures > 0) stamp_count(canvas, status->captures, &x);
+        sprite_canvas_blit(canvas, strip->right_x - paint_w, strip->y);
+    }
+
+    strip->shown = *status;
+    strip->shown_width = width;
+    strip->generation = ui_get_clear_generation();
+    strip->valid = true;
+    return strip->right_x - width;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file icons.h
+ * @brief Status icon sprites and the title bar status strip
+ *
+ * Icons are 8x8 1-bpp sprites tinted with their state color. An asset
+ * bundle entry "icon/<name>" (assets.h: assets_sprite_t and sprite data)
+ * replaces the built-in bitmap, in either sprite format.
+ *
+ * The status strip draws the board link, SD card, GPS fix and capture
+ * count right to left in one blit, and like the retained widgets of
+ * ui_widget.h repaints only when its state changed or the screen was
+ * cleared, so screens can update it on every tick.
+ *
+ * Called with the UI lock held.
+ */
+
+#ifndef ICONS_H
+#define ICONS_H
+
+#include "sprite.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ICON_SIZE       8
+
+typedef enum {
+    ICON_LINK = 0,              // JanOS board UART link
+    ICON_SD,
+    ICON_GPS,
+    ICON_CAPTURE,
+    ICON_COUNT
+} icon_id_t;
+
+// Indicator state, also its color
+typedef enum {
+    ICON_STATE_HIDDEN = 0,
+    ICON_STATE_PENDING,         // Yellow: probing, searching
+    ICON_STATE_OK,              // Green
+    ICON_STATE_FAIL,            // Red: missing
+    ICON_STATE_IDLE,            // Gray: present but inactive
+} icon_state_t;
+
+typedef struct {
+    uint8_t link;               // icon_state_t
+    uint8_t sd;
+    uint8_t gps;
+    uint16_t captures;          // Capture icon and count, hidden at 0
+} ui_status_t;
+
+// Retained status strip ending at right_x on the title bar
+typedef struct {
+    int right_x;
+    int y;
+    uint16_t bg;
+    ui_status_t shown;
+    int shown_width;            // Pixels painted last time
+    uint32_t generation;
+    bool valid;
+} ui_status_strip_t;
+
+/**
+ * @brief Sprite of an icon (asset bundle override or built-in)
+ */
+const sprite_t *icon_get(icon_id_t id);
+
+/**
+ * @brief RGB565 color of an indicator state
+ */
+uint16_t icon_state_color(icon_state_t state);
+
+/**
+ * @brief Initialize a status strip (nothing is drawn until updated)
+ * @param strip Strip to initialize
+ * @param right_x First pixel right of the strip
+ * @param y Top of the icons
+ * @param bg Background color (title bar)
+ */
+void ui_status_strip_init(ui_status_strip_t *strip, int right_x, int y, uint16_t bg);
+
+/**
+ * @brief Show a state, repainting only if it changed
+ * @return Left edge of the strip on screen
+ */
+int ui_status_strip_update(ui_status_strip_t *strip, const ui_status_t *status);
+
+#endif // ICONS_H
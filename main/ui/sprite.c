@@ -0,0 +1,130 @@
+/**
+ * @file sprite.c
+ * @brief Small bitmaps composed off screen and blitted in one transfer
+ */
+
+#include "sprite.h"
+#include "display.h"
+
+// One canvas for all callers; they hold the UI lock
+static sprite_canvas_t scratch;
+
+sprite_canvas_t *sprite_shared_canvas(void)
+{
+    return &scratch;
+}
+
+bool sprite_canvas_begin(sprite_canvas_t *canvas, int width, int height, uint16_t bg)
+{
+    if (width <= 0 || height <= 0 || width * height > SPRITE_CANVAS_MAX_PIXELS) {
+        canvas->width = 0;
+        canvas->height = 0;
+        return false;
+    }
+    canvas->width = width;
+    canvas->height = height;
+
+    uint16_t pbg = display_color_to_panel(bg);
+    for (int i = 0; i < width * height; i++) {
+        canvas->pixels[i] = pbg;
+    }
+    return true;
+}
+
+void sprite_canvas_fill(sprite_canvas_t *canvas, int x, int y, int w, int h, uint16_t color)
+{
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > canvas->width) w = canvas->width - x;
+    if (y + h > canvas->height) h = canvas->height - y;
+    if (w <= 0 || h <= 0) return;
+
+    uint16_t pcolor = display_color_to_panel(color);
+    for (int row = y; row < y + h; row++) {
+        uint16_t *p = &canvas->pixels[row * canvas->width + x];
+        for (int i = 0; i < w; i++) {
+            p[i] = pcolor;
+        }
+    }
+}
+
+void sprite_canvas_rect(sprite_canvas_t *canvas, int x, int y, int w, int h, uint16_t color)
+{
+    if (w <= 0 || h <= 0) return;
+    sprite_canvas_fill(canvas, x, y, w, 1, color);
+    sprite_canvas_fill(canvas, x, y + h - 1, w, 1, color);
+    sprite_canvas_fill(canvas, x, y, 1, h, color);
+    sprite_canvas_fill(canvas, x + w - 1, y, 1, h, color);
+}
+
+static inline void put_pixel(sprite_canvas_t *canvas, int x, int y, uint16_t pcolor)
+{
+    if (x >= 0 && y >= 0 && x < canvas->width && y < canvas->height) {
+        canvas->pixels[y * canvas->width + x] = pcolor;
+    }
+}
+
+static void stamp_1bpp(sprite_canvas_t *canvas, int x, int y, const sprite_t *sprite,
+                       uint16_t color)
+{
+    const uint8_t *bits = sprite->data;
+    const int stride = (sprite->width + 7) / 8;
+    uint16_t pcolor = display_color_to_panel(color);
+
+    for (int row = 0; row < sprite->height; row++) {
+        const uint8_t *line = &bits[row * stride];
+        for (int col = 0; col < sprite->width; col++) {
+            if (line[col >> 3] & (0x80 >> (col & 7))) {
+                put_pixel(canvas, x + col, y + row, pcolor);
+            }
+        }
+    }
+}
+
+static void stamp_rle565(sprite_canvas_t *canvas, int x, int y, const sprite_t *sprite)
+{
+    const uint16_t *runs = sprite->data;
+    const int total = sprite->width * sprite->height;
+    int n = 0;
+
+    // Runs may cross rows; a short stream leaves the rest transparent
+    for (int i = 0; i + 1 < sprite->data_len && n < total; i += 2) {
+        int count = runs[i];
+        uint16_t color = runs[i + 1];
+        if (count > total - n) count = total - n;
+        if (color == sprite->key) {
+            n += count;
+            continue;
+        }
+        uint16_t pcolor = display_color_to_panel(color);
+        while (count-- > 0) {
+            put_pixel(canvas, x + n % sprite->width, y + n / sprite->width, pcolor);
+            n++;
+        }
+    }
+}
+
+void sprite_canvas_stamp(sprite_canvas_t *canvas, int x, int y, const sprite_t *sprite,
+                         uint16_t color)
+{
+    if (!sprite || !sprite->data) return;
+    if (sprite->format == SPRITE_RLE565) {
+        stamp_rle565(canvas, x, y, sprite);
+    } else {
+        stamp_1bpp(canvas, x, y, sprite, color);
+    }
+}
+
+void sprite_canvas_blit(const sprite_canvas_t *canvas, int x, int y)
+{
+    if (canvas->width <= 0 || canvas->height <= 0) return;
+    display_blit(x, y, canvas->width, canvas->height, canvas->pixels);
+}
+
+void sprite_draw(int x, int y, const sprite_t *sprite, uint16_t color, uint16_t bg)
+{
+    if (!sprite) return;
+    if (!sprite_canvas_begin(&scratch, sprite->width, sprite->height, bg)) return;
+    sprite_canvas_stamp(&scratch, 0, 0, sprite, color);
+    sprite_canvas_blit(&scratch, x, y);
+}
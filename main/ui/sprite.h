@@ -0,0 +1,92 @@
+/**
+ * @file sprite.h
+ * @brief Small bitmaps composed off screen and blitted in one transfer
+ *
+ * Status icons used to be drawn with rect and line primitives, one
+ * framebuffer write each. A sprite is instead stamped into a canvas (the
+ * background plus any number of sprites and fills), and the canvas goes
+ * to the framebuffer with a single display_blit(), so an indicator can be
+ * repainted every tick for the cost of one block copy.
+ *
+ * Two formats:
+ *   SPRITE_1BPP     Rows of (width + 7) / 8 bytes, MSB leftmost. Set bits
+ *                   take the stamp color (icons tint with their state),
+ *                   clear bits are transparent.
+ *   SPRITE_RLE565   Row-major runs of uint16_t pairs { count, RGB565 }.
+ *                   Pixels of the key color are transparent.
+ *
+ * Called with the UI lock held.
+ */
+
+#ifndef SPRITE_H
+#define SPRITE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Canvas area, enough for the title bar status strip (72x10)
+#define SPRITE_CANVAS_MAX_PIXELS    (72 * 10)
+
+typedef enum {
+    SPRITE_1BPP = 0,
+    SPRITE_RLE565,
+} sprite_format_t;
+
+typedef struct {
+    uint8_t width;
+    uint8_t height;
+    uint8_t format;             // sprite_format_t
+    uint16_t key;               // RLE565 transparent color
+    uint16_t data_len;          // RLE565: uint16_t words in data
+    const void *data;
+} sprite_t;
+
+// Off-screen block in panel byte order
+typedef struct {
+    int width;
+    int height;
+    uint16_t pixels[SPRITE_CANVAS_MAX_PIXELS];
+} sprite_canvas_t;
+
+/**
+ * @brief Start a canvas filled with a background color
+ * @return false if width x height exceeds SPRITE_CANVAS_MAX_PIXELS
+ */
+bool sprite_canvas_begin(sprite_canvas_t *canvas, int width, int height, uint16_t bg);
+
+/**
+ * @brief Fill a rectangle of the canvas (clipped)
+ */
+void sprite_canvas_fill(sprite_canvas_t *canvas, int x, int y, int w, int h, uint16_t color);
+
+/**
+ * @brief Draw a 1 pixel rectangle outline on the canvas (clipped)
+ */
+void sprite_canvas_rect(sprite_canvas_t *canvas, int x, int y, int w, int h, uint16_t color);
+
+/**
+ * @brief Stamp a sprite onto the canvas (clipped, transparent pixels kept)
+ * @param color Color of set bits for SPRITE_1BPP, ignored for RLE565
+ */
+void sprite_canvas_stamp(sprite_canvas_t *canvas, int x, int y, const sprite_t *sprite,
+                         uint16_t color);
+
+/**
+ * @brief Copy the canvas to the framebuffer
+ */
+void sprite_canvas_blit(const sprite_canvas_t *canvas, int x, int y);
+
+/**
+ * @brief Canvas shared by all UI drawing (UI lock held)
+ *
+ * Compose and blit before calling anything else that draws sprites;
+ * sprite_draw() reuses it.
+ */
+sprite_canvas_t *sprite_shared_canvas(void);
+
+/**
+ * @brief Draw one sprite over a solid background in a single blit
+ */
+void sprite_draw(int x, int y, const sprite_t *sprite, uint16_t color, uint16_t bg);
+
+#endif // SPRITE_H
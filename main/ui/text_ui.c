@@ -5,70 +5,382 @@
 
 #include "text_ui.h"
 #include "font8x16.h"
+#include "glyph_ext.h"
+#include "sprite.h"
+#ifdef CONFIG_UI_COMPACT_FONT
+#include "font6x8.h"
+#endif
 #include "battery.h"
-#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
 #include <string.h>
 #include <stdio.h>
 
-// Battery voltage cache (refresh every 30 seconds)
-#define BATTERY_CACHE_INTERVAL_US   (30 * 1000000)  // 30 seconds in microseconds
-static int cached_voltage_mv = 0;
-static int cached_level = 0;
-static int64_t last_battery_read_time = 0;
+// Glyph bitmaps of one layout density (1 byte per scanline, MSB leftmost)
+typedef struct {
+    const uint8_t *data;
+    int width;
+    int height;
+    int grid_top;       // Y of grid row 0; keeps row 1 clear of the title bar
+} ui_font_t;
+
+// The 8x16 glyphs have blank top scanlines that the title bar line may
+// cover; the 6x8 ones do not, so that grid starts 3 pixels lower
+static const ui_font_t fonts[UI_DENSITY_COUNT] = {
+    [UI_DENSITY_NORMAL]  = { font8x16_data, FONT_WIDTH, FONT_HEIGHT, 0 },
+#ifdef CONFIG_UI_COMPACT_FONT
+    [UI_DENSITY_COMPACT] = { font6x8_data, FONT6X8_WIDTH, FONT6X8_HEIGHT, 3 },
+#else
+    [UI_DENSITY_COMPACT] = { font8x16_data, FONT_WIDTH, FONT_HEIGHT, 0 },
+#endif
+};
+
+// Largest cell and narrowest column of any font, for stack buffers
+#define CELL_PIXELS_MAX     (UI_CELL_W_NORMAL * UI_CELL_H_NORMAL)
+#define RUN_CELLS_MAX       UI_COLS_MAX
+
+static ui_density_t density = UI_DENSITY_NORMAL;
+static const ui_font_t *font = &fonts[UI_DENSITY_NORMAL];
+
+// Last title drawn, names the screen in profiler output
+static char last_title[UI_COLS_MAX + 1];
+static char last_status[UI_COLS_MAX + 1];
+
+// Bumped on every full clear so retained widgets know to repaint. A
+// restored frame takes back its old number, so new ones come from a
+// separate counter and are never handed out twice.
+static uint32_t clear_generation = 0;
+static uint32_t generations_issued = 0;
+
+// Title bar tray (background jobs), left of the battery icon
+static char title_tray[UI_TITLE_TRAY_LEN + 1];
+static int tray_shown_px = 0;               // Width painted, erased when it shrinks
+static uint32_t title_clear_generation = UINT32_MAX;   // Clear the bar was drawn after
+
+static void draw_title_tray(void);
+
+void ui_init(void)
+{
+    ui_clear();
+}
+
+void ui_clear(void)
+{
+    display_clear(UI_COLOR_BG);
+    clear_generation = ++generations_issued;
+}
+
+uint32_t ui_get_clear_generation(void)
+{
+    return clear_generation;
+}
+
+void ui_save_frame_state(ui_frame_state_t *out)
+{
+    out->generation = clear_generation;
+    out->tray_px = title_clear_generation == clear_generation ? (int16_t)tray_shown_px : -1;
+    strlcpy(out->title, last_title, sizeof(out->title));
+    strlcpy(out->status, last_status, sizeof(out->status));
+    clear_generation = ++generations_issued;
+}
+
+void ui_restore_frame_state(const ui_frame_state_t *state)
+{
+    clear_generation = state->generation;
+    strlcpy(last_title, state->title, sizeof(last_title));
+    strlcpy(last_status, state->status, sizeof(last_status));
+
+    // The tray may have changed while the frame was away
+    if (state->tray_px >= 0) {
+        title_clear_generation = clear_generation;
+        tray_shown_px = state->tray_px;
+        draw_title_tray();
+    }
+}
 
 /**
- * @brief Update cached battery values if interval has passed
+ * @brief Select the font (and its glyph cache) without touching the screen
  */
-static void update_battery_cache(void)
+static void use_font(ui_density_t new_density)
+{
+    density = new_density;
+    font = &fonts[density];
+}
+
+void ui_set_density(ui_density_t new_density)
+{
+    if (new_density >= UI_DENSITY_COUNT) new_density = UI_DENSITY_NORMAL;
+    if (new_density == density) return;
+
+    use_font(new_density);
+    clear_generation = ++generations_issued;    // Retained rows were laid out on the other grid
+}
+
+ui_density_t ui_get_density(void)
+{
+    return density;
+}
+
+int ui_cols(void)
 {
-    int64_t now = esp_timer_get_time();
-    if (cached_voltage_mv == 0 || (now - last_battery_read_time) >= BATTERY_CACHE_INTERVAL_US) {
-        cached_voltage_mv = battery_get_voltage_mv();
-        cached_level = battery_get_level();
-        last_battery_read_time = now;
+    return DISPLAY_WIDTH / font->width;
+}
+
+int ui_rows(void)
+{
+    return (DISPLAY_HEIGHT - font->grid_top) / font->height;
+}
+
+int ui_cell_height(void)
+{
+    return font->height;
+}
+
+int ui_row_y(int row)
+{
+    return font->grid_top + row * font->height;
+}
+
+/**
+ * @brief Get glyph bitmap for a character (unprintable maps to space)
+ */
+static const uint8_t *glyph_data(char c)
+{
+    if (c < FONT_FIRST_CHAR || c > FONT_LAST_CHAR) {
+        c = ' ';  // Replace unprintable with space
     }
+    return &font->data[(c - FONT_FIRST_CHAR) * font->height];
 }
 
-void ui_init(void)
+/**
+ * @brief Expand one glyph scanline into font->width panel-order pixels
+ */
+static inline void expand_glyph_row(uint16_t *dst, uint8_t bits, uint16_t fg, uint16_t bg)
 {
-    ui_clear();
+    for (int col = 0; col < font->width; col++) {
+        dst[col] = (bits & (0x80 >> col)) ? fg : bg;
+    }
 }
 
-void ui_clear(void)
+#ifdef CONFIG_UI_GLYPH_CACHE
+
+static const char *TAG = "TEXT_UI";
+
+#define GLYPH_COUNT         (FONT_LAST_CHAR - FONT_FIRST_CHAR + 1)
+
+#ifdef CONFIG_UI_GLYPH_CACHE_PSRAM
+#define GLYPH_CACHE_CAPS    (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define GLYPH_CACHE_CAPS    (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+// Theme colour pairs that get cached tiles
+typedef struct {
+    uint16_t fg;
+    uint16_t bg;
+    uint16_t *tiles[UI_DENSITY_COUNT];      // GLYPH_COUNT tiles per font, panel order
+    uint32_t built[UI_DENSITY_COUNT][(GLYPH_COUNT + 31) / 32];  // Bit set once a tile is expanded
+    bool alloc_failed[UI_DENSITY_COUNT];
+} glyph_cache_pair_t;
+
+static glyph_cache_pair_t glyph_cache[] = {
+    { UI_COLOR_TEXT,      UI_COLOR_BG },
+    { UI_COLOR_HIGHLIGHT, UI_COLOR_SELECTED },
+    { UI_COLOR_TITLE,     UI_COLOR_TITLE_BG },
+    { UI_COLOR_DIMMED,    UI_COLOR_STATUS_BG },
+};
+
+#define GLYPH_CACHE_PAIRS (sizeof(glyph_cache) / sizeof(glyph_cache[0]))
+
+static portMUX_TYPE glyph_cache_lock = portMUX_INITIALIZER_UNLOCKED;
+static size_t glyph_cache_bytes = 0;
+
+static glyph_cache_pair_t *glyph_cache_find(uint16_t fg, uint16_t bg)
 {
-    display_clear(UI_COLOR_BG);
+    for (int i = 0; i < GLYPH_CACHE_PAIRS; i++) {
+        if (glyph_cache[i].fg == fg && glyph_cache[i].bg == bg) {
+            return &glyph_cache[i];
+        }
+    }
+    return NULL;
+}
+
+#endif // CONFIG_UI_GLYPH_CACHE
+
+/**
+ * @brief Get the cached tile for a character, building it on first use
+ * @return Tile pointer (panel order), or NULL if the pair is not cached
+ */
+static const uint16_t *glyph_cache_get(char c, uint16_t fg, uint16_t bg)
+{
+#ifdef CONFIG_UI_GLYPH_CACHE
+    glyph_cache_pair_t *pair = glyph_cache_find(fg, bg);
+    if (!pair || pair->alloc_failed[density]) return NULL;
+
+    const int glyph_pixels = font->width * font->height;
+    if (!pair->tiles[density]) {
+        size_t bytes = GLYPH_COUNT * glyph_pixels * sizeof(uint16_t);
+        uint16_t *tiles = heap_caps_malloc(bytes, GLYPH_CACHE_CAPS);
+        if (!tiles) {
+            pair->alloc_failed[density] = true;
+            ESP_LOGW(TAG, "Glyph cache: no memory for pair 0x%04X/0x%04X", fg, bg);
+            return NULL;
+        }
+
+        bool installed = false;
+        portENTER_CRITICAL(&glyph_cache_lock);
+        if (!pair->tiles[density]) {
+            memset(pair->built[density], 0, sizeof(pair->built[density]));
+            pair->tiles[density] = tiles;
+            glyph_cache_bytes += bytes;
+            installed = true;
+        }
+        portEXIT_CRITICAL(&glyph_cache_lock);
+
+        if (installed) {
+            ESP_LOGI(TAG, "Glyph cache: pair 0x%04X/0x%04X %dx%d allocated, total %u bytes",
+                     fg, bg, font->width, font->height, (unsigned)glyph_cache_bytes);
+        } else {
+            heap_caps_free(tiles);  // Another task won the race
+        }
+    }
+
+    if (c < FONT_FIRST_CHAR || c > FONT_LAST_CHAR) {
+        c = ' ';
+    }
+    int index = c - FONT_FIRST_CHAR;
+    uint16_t *tile = &pair->tiles[density][index * glyph_pixels];
+    uint32_t *built = pair->built[density];
+
+    if (!(built[index / 32] & (1u << (index % 32)))) {
+        const uint8_t *char_data = glyph_data(c);
+        uint16_t pfg = display_color_to_panel(fg);
+        uint16_t pbg = display_color_to_panel(bg);
+        for (int row = 0; row < font->height; row++) {
+            expand_glyph_row(&tile[row * font->width], char_data[row], pfg, pbg);
+        }
+        portENTER_CRITICAL(&glyph_cache_lock);
+        built[index / 32] |= (1u << (index % 32));
+        portEXIT_CRITICAL(&glyph_cache_lock);
+    }
+    return tile;
+#else
+    (void)c;
+    (void)fg;
+    (void)bg;
+    return NULL;
+#endif
+}
+
+size_t ui_glyph_cache_get_footprint(void)
+{
+#ifdef CONFIG_UI_GLYPH_CACHE
+    return glyph_cache_bytes;
+#else
+    return 0;
+#endif
 }
 
 void ui_draw_char(int x, int y, char c, uint16_t fg, uint16_t bg)
 {
     // Bounds check
-    if (x < 0 || y < 0 || x + FONT_WIDTH > DISPLAY_WIDTH || y + FONT_HEIGHT > DISPLAY_HEIGHT) {
+    if (x < 0 || y < 0 || x + font->width > DISPLAY_WIDTH || y + font->height > DISPLAY_HEIGHT) {
         return;
     }
     
-    // Get character index
-    if (c < FONT_FIRST_CHAR || c > FONT_LAST_CHAR) {
-        c = ' ';  // Replace unprintable with space
+    const uint16_t *cached = glyph_cache_get(c, fg, bg);
+    if (cached) {
+        display_blit(x, y, font->width, font->height, cached);
+        return;
     }
     
-    int char_index = c - FONT_FIRST_CHAR;
-    const uint8_t *char_data = &font8x16_data[char_index * FONT_HEIGHT];
+    const uint8_t *char_data = glyph_data(c);
+    uint16_t pfg = display_color_to_panel(fg);
+    uint16_t pbg = display_color_to_panel(bg);
     
-    // Draw background first (if not transparent)
-    if (bg != UI_COLOR_BG) {
-        display_fill_rect(x, y, FONT_WIDTH, FONT_HEIGHT, bg);
-    } else {
-        display_fill_rect(x, y, FONT_WIDTH, FONT_HEIGHT, UI_COLOR_BG);
+    // Expand the whole cell (background included) and blit it in one go
+    uint16_t tile[CELL_PIXELS_MAX];
+    for (int row = 0; row < font->height; row++) {
+        expand_glyph_row(&tile[row * font->width], char_data[row], pfg, pbg);
     }
-    
-    // Draw character pixels
-    for (int row = 0; row < FONT_HEIGHT; row++) {
-        uint8_t row_data = char_data[row];
-        for (int col = 0; col < FONT_WIDTH; col++) {
-            if (row_data & (0x80 >> col)) {
-                display_draw_pixel(x + col, y + row, fg);
+    display_blit(x, y, font->width, font->height, tile);
+}
+
+// Longest run of characters collected before it is rendered
+#define TEXT_RUN_MAX 64
+
+// One visible line never needs more composed glyphs than the cache holds
+_Static_assert(GLYPH_EXT_CACHE_SIZE > RUN_CELLS_MAX, "extended glyph cache smaller than a line");
+
+/**
+ * @brief Bitmap of a code point in the active font
+ */
+static const uint8_t *code_glyph(uint32_t code)
+{
+    if (code < 0x80) return glyph_data((char)code);
+    return glyph_ext_bitmap(code, density, font->data, font->height);
+}
+
+/**
+ * @brief Render a run of characters on one text line
+ *
+ * Characters whose cell would not fit on screen are skipped (same rule as
+ * ui_draw_char). The visible part is expanded one scanline at a time so the
+ * stack cost stays at a single display row.
+ */
+static void draw_text_run(int x, int y, const uint32_t *run, int len, uint16_t fg, uint16_t bg)
+{
+    if (len <= 0 || y < 0 || y + font->height > DISPLAY_HEIGHT) return;
+
+    // Trim characters that fall off either edge
+    while (len > 0 && x < 0) {
+        run++;
+        len--;
+        x += font->width;
+    }
+    while (len > 0 && x + len * font->width > DISPLAY_WIDTH) {
+        len--;
+    }
+    if (len <= 0) return;
+
+    uint16_t strip[DISPLAY_WIDTH];
+
+    // Cached pair: ASCII scanlines are just copied out of the tiles
+    const uint16_t *tiles[RUN_CELLS_MAX];
+    const uint8_t *glyphs[RUN_CELLS_MAX];
+    bool cached = glyph_cache_get(' ', fg, bg) != NULL;
+    bool expand = !cached;
+    for (int i = 0; i < len; i++) {
+        tiles[i] = (cached && run[i] < 0x80) ? glyph_cache_get((char)run[i], fg, bg) : NULL;
+        glyphs[i] = tiles[i] ? NULL : code_glyph(run[i]);
+        if (!tiles[i]) expand = true;
+    }
+
+    if (!expand) {
+        for (int row = 0; row < font->height; row++) {
+            for (int i = 0; i < len; i++) {
+                memcpy(&strip[i * font->width], &tiles[i][row * font->width],
+                       font->width * sizeof(uint16_t));
+            }
+            display_blit(x, y + row, len * font->width, 1, strip);
+        }
+        return;
+    }
+
+    uint16_t pfg = display_color_to_panel(fg);
+    uint16_t pbg = display_color_to_panel(bg);
+    for (int row = 0; row < font->height; row++) {
+        for (int i = 0; i < len; i++) {
+            if (tiles[i]) {
+                memcpy(&strip[i * font->width], &tiles[i][row * font->width],
+                       font->width * sizeof(uint16_t));
+            } else {
+                expand_glyph_row(&strip[i * font->width], glyphs[i][row], pfg, pbg);
             }
         }
+        display_blit(x, y + row, len * font->width, 1, strip);
     }
 }
 
@@ -77,35 +389,55 @@ void ui_draw_text(int x, int y, const char *text, uint16_t fg, uint16_t bg)
     if (!text) return;
     
     int start_x = x;
+    uint32_t run[TEXT_RUN_MAX];
+    int run_len = 0;
+    int run_x = x;
     
     while (*text) {
-        if (*text == '\n') {
+        uint32_t code;
+        text += glyph_ext_next(text, &code);
+        
+        if (code == '\n') {
+            draw_text_run(run_x, y, run, run_len, fg, bg);
+            run_len = 0;
             x = start_x;
-            y += FONT_HEIGHT;
+            y += font->height;
+        } else if (glyph_ext_is_zero_width(code)) {
+            continue;
         } else {
-            ui_draw_char(x, y, *text, fg, bg);
-            x += FONT_WIDTH;
+            if (run_len == TEXT_RUN_MAX) {
+                draw_text_run(run_x, y, run, run_len, fg, bg);
+                run_len = 0;
+            }
+            if (run_len == 0) {
+                run_x = x;
+            }
+            run[run_len++] = code;
+            x += font->width;
         }
-        text++;
         
         // Wrap check
-        if (x + FONT_WIDTH > DISPLAY_WIDTH) {
+        if (x + font->width > DISPLAY_WIDTH) {
+            draw_text_run(run_x, y, run, run_len, fg, bg);
+            run_len = 0;
             x = start_x;
-            y += FONT_HEIGHT;
+            y += font->height;
         }
         
-        if (y + FONT_HEIGHT > DISPLAY_HEIGHT) {
+        if (y + font->height > DISPLAY_HEIGHT) {
             break;  // Stop if we go off screen
         }
     }
+
+    draw_text_run(run_x, y, run, run_len, fg, bg);
 }
 
 void ui_print(int col, int row, const char *text, uint16_t fg)
 {
-    if (col < 0 || col >= UI_COLS || row < 0 || row >= UI_ROWS) return;
+    if (col < 0 || col >= ui_cols() || row < 0 || row >= ui_rows()) return;
     
-    int x = col * FONT_WIDTH;
-    int y = row * FONT_HEIGHT;
+    int x = col * font->width;
+    int y = ui_row_y(row);
     
     ui_draw_text(x, y, text, fg, UI_COLOR_BG);
 }
@@ -114,8 +446,8 @@ void ui_print_center(int row, const char *text, uint16_t fg)
 {
     if (!text) return;
     
-    int len = strlen(text);
-    int col = (UI_COLS - len) / 2;
+    int len = glyph_ext_cells(text);
+    int col = (ui_cols() - len) / 2;
     if (col < 0) col = 0;
     
     ui_print(col, row, text, fg);
@@ -123,24 +455,37 @@ void ui_print_center(int row, const char *text, uint16_t fg)
 
 void ui_draw_line(int row, uint16_t color)
 {
-    int y = row * FONT_HEIGHT + FONT_HEIGHT / 2;
+    int y = ui_row_y(row) + font->height / 2;
     display_draw_hline(0, y, DISPLAY_WIDTH, color);
 }
 
+// Battery indicator last painted, so per-tick refreshes are free when idle
+typedef struct {
+    int level;
+    int voltage_cv;             // Centivolts, as shown
+    uint32_t generation;
+    ui_density_t density;
+    bool valid;
+} battery_shown_t;
+
+static battery_shown_t battery_shown;
+
 /**
  * @brief Draw battery icon with level indicator (icon only, no voltage text)
+ *
+ * Composed off screen and blitted once.
  * @param x X position (right edge of icon)
  * @param y Y position
+ * @param bat_width Body width
+ * @param bat_height Body height
  * @param level Battery level 0-100
  * @param bg Background color
  */
-static void draw_battery_icon(int x, int y, int level, uint16_t bg)
+static void draw_battery_icon(int x, int y, int bat_width, int bat_height, int level, uint16_t bg)
 {
-    // Battery icon dimensions
-    const int bat_width = 18;
-    const int bat_height = 10;
+    // Battery tip dimensions
     const int tip_width = 2;
-    const int tip_height = 4;
+    const int tip_height = bat_height / 2 - 1;
     
     // Determine color based on level
     uint16_t fill_color;
@@ -152,26 +497,23 @@ static void draw_battery_icon(int x, int y, int level, uint16_t bg)
         fill_color = COLOR_RED;
     }
     
-    // Battery body position (icon drawn from right edge)
-    int bx = x - bat_width - tip_width;
-    int by = y;
+    sprite_canvas_t *canvas = sprite_shared_canvas();
+    if (!sprite_canvas_begin(canvas, bat_width + tip_width, bat_height, bg)) return;
     
-    // Draw battery body outline
-    display_draw_rect(bx, by, bat_width, bat_height, UI_COLOR_TEXT);
+    // Body outline and positive terminal
+    sprite_canvas_rect(canvas, 0, 0, bat_width, bat_height, UI_COLOR_TEXT);
+    sprite_canvas_fill(canvas, bat_width, (bat_height - tip_height) / 2,
+                       tip_width, tip_height, UI_COLOR_TEXT);
     
-    // Draw battery tip (positive terminal)
-    int tip_y = by + (bat_height - tip_height) / 2;
-    display_fill_rect(bx + bat_width, tip_y, tip_width, tip_height, UI_COLOR_TEXT);
-    
-    // Clear inside of battery
-    display_fill_rect(bx + 1, by + 1, bat_width - 2, bat_height - 2, bg);
-    
-    // Draw fill level (inside battery body)
+    // Fill level (inside battery body)
     int clamped_level = (level < 0) ? 0 : (level > 100) ? 100 : level;
     int fill_width = ((bat_width - 4) * clamped_level) / 100;
     if (fill_width > 0) {
-        display_fill_rect(bx + 2, by + 2, fill_width, bat_height - 4, fill_color);
+        sprite_canvas_fill(canvas, 2, 2, fill_width, bat_height - 4, fill_color);
     }
+    
+    // Icon drawn from its right edge
+    sprite_canvas_blit(canvas, x - bat_width - tip_width, y);
 }
 
 /**
@@ -194,54 +536,133 @@ static void draw_voltage_text(int voltage_mv, uint16_t bg)
     ui_draw_text(2, 1, volt_str, UI_COLOR_DIMMED, bg);
 }
 
+/**
+ * @brief Paint the battery indicators (latest background sample, no ADC access)
+ * @param force Paint even if the reading shown is unchanged
+ */
+static void draw_battery_status(bool force)
+{
+    if (!battery_is_available()) return;
+    battery_reading_t battery = battery_get_reading();
+    if (battery.level < 0 || battery.voltage_mv <= 0) return;
+
+    int voltage_cv = battery.voltage_mv / 10;
+    if (!force && battery_shown.valid &&
+        battery_shown.generation == clear_generation && battery_shown.density == density &&
+        battery_shown.level == battery.level && battery_shown.voltage_cv == voltage_cv) {
+        return;
+    }
+
+    uint16_t title_bg = UI_COLOR_TITLE_BG;
+    // Voltage text in top left corner
+    draw_voltage_text(battery.voltage_mv, title_bg);
+    // Battery icon at right edge, sized to the bar
+    if (font->height >= UI_CELL_H_NORMAL) {
+        draw_battery_icon(DISPLAY_WIDTH - 4, 4, 18, 10, battery.level, title_bg);
+    } else {
+        draw_battery_icon(DISPLAY_WIDTH - 4, 2, 12, 6, battery.level, title_bg);
+    }
+
+    battery_shown = (battery_shown_t){
+        .level = battery.level,
+        .voltage_cv = voltage_cv,
+        .generation = clear_generation,
+        .density = density,
+        .valid = true,
+    };
+}
+
+/**
+ * @brief Paint the tray over the title bar (the bar must be on screen)
+ */
+static void draw_title_tray(void)
+{
+    int right = DISPLAY_WIDTH - 4 - (font->height >= UI_CELL_H_NORMAL ? 20 : 14) - 4;
+    if (tray_shown_px) {
+        display_fill_rect(right - tray_shown_px, 1, tray_shown_px, font->height, UI_COLOR_TITLE_BG);
+    }
+    int width = (int)strlen(title_tray) * font->width;
+    if (width) {
+        ui_draw_text(right - width, 1, title_tray, UI_COLOR_HIGHLIGHT, UI_COLOR_TITLE_BG);
+    }
+    tray_shown_px = width;
+}
+
+void ui_set_title_tray(const char *tray)
+{
+    if (!tray) tray = "";
+    if (strcmp(tray, title_tray) == 0) return;
+    strlcpy(title_tray, tray, sizeof(title_tray));
+    
+    // Only while the screen shows a title bar drawn since its last clear
+    if (title_clear_generation == clear_generation) {
+        draw_title_tray();
+    }
+}
+
 void ui_draw_title(const char *title)
 {
-    uint16_t title_bg = RGB565(0, 60, 30);
+    uint16_t title_bg = UI_COLOR_TITLE_BG;
+    
+    snprintf(last_title, sizeof(last_title), "%s", title ? title : "");
     
     // Draw title bar background
-    display_fill_rect(0, 0, DISPLAY_WIDTH, FONT_HEIGHT + 2, title_bg);
+    display_fill_rect(0, 0, DISPLAY_WIDTH, font->height + 2, title_bg);
     
     // Draw title text centered
     if (title) {
-        int len = strlen(title);
-        int x = (DISPLAY_WIDTH - len * FONT_WIDTH) / 2;
+        int len = glyph_ext_cells(title);
+        int x = (DISPLAY_WIDTH - len * font->width) / 2;
         ui_draw_text(x, 1, title, UI_COLOR_TITLE, title_bg);
     }
     
-    // Draw battery indicators (uses cached values, refreshed every 30s)
-    if (battery_is_available()) {
-        update_battery_cache();
-        if (cached_level >= 0 && cached_voltage_mv > 0) {
-            // Voltage text in top left corner
-            draw_voltage_text(cached_voltage_mv, title_bg);
-            // Battery icon at right edge
-            draw_battery_icon(DISPLAY_WIDTH - 4, 4, cached_level, title_bg);
-        }
-    }
+    // Bar was just repainted: always draw the battery and the tray
+    draw_battery_status(true);
+    tray_shown_px = 0;
+    draw_title_tray();
+    title_clear_generation = clear_generation;
     
     // Draw bottom line
-    display_draw_hline(0, FONT_HEIGHT + 2, DISPLAY_WIDTH, UI_COLOR_BORDER);
+    display_draw_hline(0, font->height + 2, DISPLAY_WIDTH, UI_COLOR_BORDER);
+}
+
+void ui_refresh_title_battery(void)
+{
+    draw_battery_status(false);
+}
+
+const char* ui_get_title(void)
+{
+    return last_title;
 }
 
 void ui_draw_status(const char *status)
 {
-    int y = DISPLAY_HEIGHT - FONT_HEIGHT - 2;
+    int y = DISPLAY_HEIGHT - font->height - 2;
+    if (status != last_status) {
+        snprintf(last_status, sizeof(last_status), "%s", status ? status : "");
+    }
     
     // Draw status bar background
-    display_fill_rect(0, y, DISPLAY_WIDTH, FONT_HEIGHT + 2, RGB565(0, 40, 20));
+    display_fill_rect(0, y, DISPLAY_WIDTH, font->height + 2, UI_COLOR_STATUS_BG);
     
     // Draw top line
     display_draw_hline(0, y, DISPLAY_WIDTH, UI_COLOR_BORDER);
     
     // Draw status text
     if (status) {
-        ui_draw_text(4, y + 1, status, UI_COLOR_DIMMED, RGB565(0, 40, 20));
+        ui_draw_text(4, y + 1, status, UI_COLOR_DIMMED, UI_COLOR_STATUS_BG);
     }
 }
 
+const char* ui_get_status(void)
+{
+    return last_status;
+}
+
 void ui_draw_menu_item(int row, const char *text, bool selected, bool has_checkbox, bool checked)
 {
-    int y = row * FONT_HEIGHT;
+    int y = ui_row_y(row);
     int x = 4;
     
     // Calculate background color
@@ -249,25 +670,28 @@ void ui_draw_menu_item(int row, const char *text, bool selected, bool has_checkb
     uint16_t fg = selected ? UI_COLOR_HIGHLIGHT : UI_COLOR_TEXT;
     
     // Draw background
-    display_fill_rect(0, y, DISPLAY_WIDTH, FONT_HEIGHT, bg);
+    display_fill_rect(0, y, DISPLAY_WIDTH, font->height, bg);
     
     // Draw selection indicator
     if (selected) {
-        display_draw_vline(0, y, FONT_HEIGHT, UI_COLOR_HIGHLIGHT);
-        display_draw_vline(1, y, FONT_HEIGHT, UI_COLOR_HIGHLIGHT);
+        display_draw_vline(0, y, font->height, UI_COLOR_HIGHLIGHT);
+        display_draw_vline(1, y, font->height, UI_COLOR_HIGHLIGHT);
     }
     
     // Draw checkbox if needed
     if (has_checkbox) {
-        // Draw checkbox box
-        display_draw_rect(x, y + 2, 12, 12, UI_COLOR_BORDER);
+        // Draw checkbox box (12px in the normal layout)
+        int box = font->height - 4;
+        int inset = box / 4;
+        display_draw_rect(x, y + 2, box, box, UI_COLOR_BORDER);
         
         // Draw check mark if checked
         if (checked) {
-            display_fill_rect(x + 3, y + 5, 6, 6, UI_COLOR_HIGHLIGHT);
+            display_fill_rect(x + inset, y + 2 + inset, box - 2 * inset, box - 2 * inset,
+                              UI_COLOR_HIGHLIGHT);
         }
         
-        x += 16;
+        x += box + 4;
     }
     
     // Draw text
@@ -276,43 +700,91 @@ void ui_draw_menu_item(int row, const char *text, bool selected, bool has_checkb
     }
 }
 
+void ui_scroll_rows(int first_row, int row_count, int delta)
+{
+    display_scroll_region(ui_row_y(first_row), row_count * font->height,
+                          delta * font->height, UI_COLOR_BG);
+}
+
+// Last menu drawn by ui_draw_menu, used to scroll instead of repainting
+static struct {
+    const char **items;
+    int count;
+    int selected;
+    int scroll_offset;
+    uint32_t generation;
+    bool valid;
+} menu_state;
+
 void ui_draw_menu(const char **items, int count, int selected, int scroll_offset)
 {
     // Available rows for menu (after title, before status)
     int start_row = 1;
-    int visible_rows = UI_ROWS - 2;  // Leave room for title and status
+    int visible_rows = ui_rows() - 2;  // Leave room for title and status
     
     // Calculate visible range
     int first_visible = scroll_offset;
     int last_visible = scroll_offset + visible_rows - 1;
     if (last_visible >= count) last_visible = count - 1;
     
-    // Draw visible items
-    for (int i = first_visible; i <= last_visible && i < count; i++) {
-        int display_row = start_row + (i - first_visible);
-        ui_draw_menu_item(display_row, items[i], i == selected, false, false);
+    int delta = menu_state.scroll_offset - scroll_offset;
+    bool can_scroll = menu_state.valid &&
+                      menu_state.generation == clear_generation &&
+                      menu_state.items == items && menu_state.count == count &&
+                      (delta == 1 || delta == -1);
+    
+    if (can_scroll) {
+        // Move the visible rows by one and repaint only the exposed row, the
+        // rows the old scroll indicators moved onto and the old/new selection
+        int old_last = menu_state.scroll_offset + visible_rows - 1;
+        bool had_up = menu_state.scroll_offset > 0;
+        bool had_down = old_last < count - 1;
+        ui_scroll_rows(start_row, visible_rows, delta);
+        int redraw[] = {
+            first_visible, last_visible, menu_state.selected, selected,
+            (had_up && delta > 0) ? first_visible + 1 : -1,
+            (had_down && delta < 0) ? last_visible - 1 : -1,
+        };
+        for (int k = 0; k < (int)(sizeof(redraw) / sizeof(redraw[0])); k++) {
+            int i = redraw[k];
+            if (i < first_visible || i > last_visible) continue;
+            ui_draw_menu_item(start_row + (i - first_visible), items[i], i == selected, false, false);
+        }
+    } else {
+        // Draw visible items
+        for (int i = first_visible; i <= last_visible && i < count; i++) {
+            int display_row = start_row + (i - first_visible);
+            ui_draw_menu_item(display_row, items[i], i == selected, false, false);
+        }
     }
     
     // Draw scroll indicators if needed
     if (scroll_offset > 0) {
-        ui_print(UI_COLS - 2, start_row, "^", UI_COLOR_DIMMED);
+        ui_print(ui_cols() - 2, start_row, "^", UI_COLOR_DIMMED);
     }
     if (last_visible < count - 1) {
-        ui_print(UI_COLS - 2, start_row + visible_rows - 1, "v", UI_COLOR_DIMMED);
+        ui_print(ui_cols() - 2, start_row + visible_rows - 1, "v", UI_COLOR_DIMMED);
     }
+    
+    menu_state.items = items;
+    menu_state.count = count;
+    menu_state.selected = selected;
+    menu_state.scroll_offset = scroll_offset;
+    menu_state.generation = clear_generation;
+    menu_state.valid = true;
 }
 
 void ui_draw_progress(int row, int progress, const char *text)
 {
-    int y = row * FONT_HEIGHT;
-    int bar_y = y + 4;
-    int bar_height = 8;
+    int y = ui_row_y(row);
+    int bar_y = y + font->height / 4;
+    int bar_height = font->height / 2;
     int bar_width = DISPLAY_WIDTH - 8;
     
     // Draw label if provided
     if (text) {
         ui_draw_text(4, y, text, UI_COLOR_TEXT, UI_COLOR_BG);
-        bar_y = y + FONT_HEIGHT + 2;
+        bar_y = y + font->height + 2;
     }
     
     // Draw progress bar outline
@@ -334,13 +806,17 @@ void ui_draw_box(int x, int y, int w, int h, uint16_t color)
 
 static void ui_show_message_impl(const char *title, const char *message, int box_h)
 {
+    // Message boxes are laid out for the 8x16 font in every density
+    ui_density_t saved_density = density;
+    use_font(UI_DENSITY_NORMAL);
+
     // Calculate box dimensions
     int box_w = DISPLAY_WIDTH - 20;
     int box_x = 10;
     int box_y = (DISPLAY_HEIGHT - box_h) / 2;
     
     // Draw box background
-    display_fill_rect(box_x, box_y, box_w, box_h, RGB565(0, 40, 20));
+    display_fill_rect(box_x, box_y, box_w, box_h, UI_COLOR_STATUS_BG);
     
     // Draw box border
     display_draw_rect(box_x, box_y, box_w, box_h, UI_COLOR_BORDER);
@@ -348,9 +824,9 @@ static void ui_show_message_impl(const char *title, const char *message, int box
     
     // Draw title
     if (title) {
-        int title_len = strlen(title);
-        int title_x = box_x + (box_w - title_len * FONT_WIDTH) / 2;
-        ui_draw_text(title_x, box_y + 6, title, UI_COLOR_TITLE, RGB565(0, 40, 20));
+        int title_len = glyph_ext_cells(title);
+        int title_x = box_x + (box_w - title_len * font->width) / 2;
+        ui_draw_text(title_x, box_y + 6, title, UI_COLOR_TITLE, UI_COLOR_STATUS_BG);
     }
     
     // Draw message
@@ -361,25 +837,26 @@ static void ui_show_message_impl(const char *title, const char *message, int box
             int line = 0;
             char *token = strtok(msg_buf, "\n");
             while (token != NULL) {
-                int msg_len = strlen(token);
-                int msg_x = box_x + (box_w - msg_len * FONT_WIDTH) / 2;
+                int msg_len = glyph_ext_cells(token);
+                int msg_x = box_x + (box_w - msg_len * font->width) / 2;
                 if (msg_x < box_x + 4) {
                     msg_x = box_x + 4;
                 }
                 ui_draw_text(msg_x,
-                             box_y + 24 + line * (FONT_HEIGHT + 2),
+                             box_y + 24 + line * (font->height + 2),
                              token,
                              UI_COLOR_TEXT,
-                             RGB565(0, 40, 20));
+                             UI_COLOR_STATUS_BG);
                 line++;
                 token = strtok(NULL, "\n");
             }
         } else {
-            int msg_len = strlen(message);
-            int msg_x = box_x + (box_w - msg_len * FONT_WIDTH) / 2;
-            ui_draw_text(msg_x, box_y + 28, message, UI_COLOR_TEXT, RGB565(0, 40, 20));
+            int msg_len = glyph_ext_cells(message);
+            int msg_x = box_x + (box_w - msg_len * font->width) / 2;
+            ui_draw_text(msg_x, box_y + 28, message, UI_COLOR_TEXT, UI_COLOR_STATUS_BG);
         }
     }
+    use_font(saved_density);
 }
 
 void ui_show_message(const char *title, const char *message)
@@ -3,21 +3,53 @@
  * @brief Simple text-based UI library for Cardputer
  * 
  * Terminal-style UI with:
- * - 8x16 monospace font
+ * - 8x16 monospace font, or 6x8 in the compact layout
+ * - UTF-8 text; non-ASCII letters are composed on demand (glyph_ext.h)
  * - Green on black theme
  * - Simple menu system
  * - Checkbox lists
+ *
+ * The grid, title and status bars follow the active layout density. A
+ * screen selects it with screen_set_density(); everything else is drawn
+ * with the normal 30x8 grid.
  */
 
 #ifndef TEXT_UI_H
 #define TEXT_UI_H
 
 #include "display.h"
+#include "sdkconfig.h"
 #include <stdbool.h>
+#include <stddef.h>
 
-// Text grid dimensions (30 chars x 8 lines for 240x135 with 8x16 font)
-#define UI_COLS (DISPLAY_WIDTH / 8)   // 30 columns
-#define UI_ROWS (DISPLAY_HEIGHT / 16) // 8 rows
+// Layout densities
+typedef enum {
+    UI_DENSITY_NORMAL = 0,      // 8x16 font, 30 x 8 grid
+    UI_DENSITY_COMPACT,         // 6x8 font, 40 x 16 grid
+    UI_DENSITY_COUNT
+} ui_density_t;
+
+// Cell size of each density (compact falls back to normal without the font)
+#define UI_CELL_W_NORMAL    8
+#define UI_CELL_H_NORMAL    16
+#ifdef CONFIG_UI_COMPACT_FONT
+#define UI_CELL_W_COMPACT   6
+#define UI_CELL_H_COMPACT   8
+#else
+#define UI_CELL_W_COMPACT   UI_CELL_W_NORMAL
+#define UI_CELL_H_COMPACT   UI_CELL_H_NORMAL
+#endif
+
+// Text grid dimensions of the normal layout (30 chars x 8 lines for 240x135)
+#define UI_COLS (DISPLAY_WIDTH / UI_CELL_W_NORMAL)   // 30 columns
+#define UI_ROWS (DISPLAY_HEIGHT / UI_CELL_H_NORMAL)  // 8 rows
+
+// Largest grid of any density, for buffers shared by both layouts
+// (the compact grid starts a few pixels down, see ui_row_y())
+#define UI_COLS_MAX (DISPLAY_WIDTH / UI_CELL_W_COMPACT)
+#define UI_ROWS_MAX (DISPLAY_HEIGHT / UI_CELL_H_COMPACT)
+
+#define UI_TITLE_TRAY_LEN 6     // Characters of the title bar tray (background jobs)
 
 // Theme colors
 #define UI_COLOR_BG         COLOR_BLACK
@@ -27,6 +59,9 @@
 #define UI_COLOR_BORDER     RGB565(0, 200, 100)  // Border green
 #define UI_COLOR_DIMMED     RGB565(80, 120, 80)  // Dimmed text
 #define UI_COLOR_HIGHLIGHT  RGB565(0, 255, 0)    // Bright highlight
+#define UI_COLOR_ERROR      COLOR_RED            // Lost data, failures
+#define UI_COLOR_TITLE_BG   RGB565(0, 60, 30)    // Title bar background
+#define UI_COLOR_STATUS_BG  RGB565(0, 40, 20)    // Status bar / message box background
 
 /**
  * @brief Initialize the text UI system
@@ -38,6 +73,67 @@ void ui_init(void);
  */
 void ui_clear(void);
 
+/**
+ * @brief Switch the font and grid used by all drawing calls
+ *
+ * Counts as a clear for retained widgets, which repaint on their next draw.
+ * Screens call screen_set_density() instead.
+ * @param density Layout density
+ */
+void ui_set_density(ui_density_t density);
+
+/**
+ * @brief Get the active layout density
+ */
+ui_density_t ui_get_density(void);
+
+/**
+ * @brief Columns of the active grid (UI_COLS in the normal layout)
+ */
+int ui_cols(void);
+
+/**
+ * @brief Rows of the active grid (UI_ROWS in the normal layout)
+ */
+int ui_rows(void);
+
+/**
+ * @brief Height of a grid cell of the active layout, in pixels
+ */
+int ui_cell_height(void);
+
+/**
+ * @brief Pixel Y of a grid row of the active layout
+ */
+int ui_row_y(int row);
+
+/**
+ * @brief Get the number of full clears since boot
+ * @return Generation counter, changes whenever ui_clear() wipes the screen
+ */
+uint32_t ui_get_clear_generation(void);
+
+// What text_ui knows about the pixels on screen (screen snapshots)
+typedef struct {
+    uint32_t generation;
+    int16_t tray_px;                // Title tray width painted, -1 if no title bar
+    char title[UI_COLS_MAX + 1];
+    char status[UI_COLS_MAX + 1];
+} ui_frame_state_t;
+
+/**
+ * @brief Record the frame on screen, before its pixels are copied away
+ *
+ * Starts a new clear generation, so retained widgets drawn from here on
+ * never count as part of the saved frame.
+ */
+void ui_save_frame_state(ui_frame_state_t *out);
+
+/**
+ * @brief The saved frame's pixels are back: widgets retained from it are valid again
+ */
+void ui_restore_frame_state(const ui_frame_state_t *state);
+
 /**
  * @brief Draw a single character at pixel position
  * @param x X pixel position
@@ -58,10 +154,16 @@ void ui_draw_char(int x, int y, char c, uint16_t fg, uint16_t bg);
  */
 void ui_draw_text(int x, int y, const char *text, uint16_t fg, uint16_t bg);
 
+/**
+ * @brief Get memory currently used by the glyph tile cache
+ * @return Bytes allocated (0 if the cache is disabled or not yet used)
+ */
+size_t ui_glyph_cache_get_footprint(void);
+
 /**
  * @brief Draw text at grid position (column, row)
- * @param col Column (0-29)
- * @param row Row (0-7)
+ * @param col Column (0 .. ui_cols() - 1)
+ * @param row Row (0 .. ui_rows() - 1)
  * @param text Text string
  * @param fg Foreground color
  */
@@ -88,12 +190,37 @@ void ui_draw_line(int row, uint16_t color);
  */
 void ui_draw_title(const char *title);
 
+/**
+ * @brief Repaint the title bar battery indicators if the reading changed
+ *
+ * Cheap when nothing changed, so screens may call it on every tick.
+ */
+void ui_refresh_title_battery(void);
+
+/**
+ * @brief Set the short text shown at the right of the title bar (background jobs)
+ *
+ * Kept for every later title bar; repainted at once if the screen shows
+ * one. "" or NULL clears it.
+ */
+void ui_set_title_tray(const char *tray);
+
+/**
+ * @brief Text of the most recent ui_draw_title() call
+ */
+const char* ui_get_title(void);
+
 /**
  * @brief Draw status bar at bottom
  * @param status Status text
  */
 void ui_draw_status(const char *status);
 
+/**
+ * @brief Text of the most recent ui_draw_status() call
+ */
+const char* ui_get_status(void);
+
 /**
  * @brief Draw a menu item
  * @param row Row number
@@ -104,8 +231,19 @@ void ui_draw_status(const char *status);
  */
 void ui_draw_menu_item(int row, const char *text, bool selected, bool has_checkbox, bool checked);
 
+/**
+ * @brief Scroll a band of grid rows, clearing the exposed rows
+ * @param first_row First row of the band
+ * @param row_count Number of rows in the band
+ * @param delta Rows to move (negative = up)
+ */
+void ui_scroll_rows(int first_row, int row_count, int delta);
+
 /**
  * @brief Draw a complete menu
+ *
+ * When called again with the same items after a one-row scroll, the visible
+ * rows are scrolled and only the changed rows are repainted.
  * @param items Array of menu item strings
  * @param count Number of items
  * @param selected Currently selected index
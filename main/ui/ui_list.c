@@ -0,0 +1,269 @@
+/**
+ * @file ui_list.c
+ * @brief Virtualized list view for list screens
+ */
+
+#include "ui_list.h"
+#include <string.h>
+
+void ui_list_init(ui_list_t *list, int first_row, int rows,
+                  ui_list_row_cb_t get_row, void *user_data)
+{
+    memset(list, 0, sizeof(*list));
+    int max_rows = ui_rows() - 1 - first_row;
+    if (max_rows > UI_LIST_MAX_ROWS) max_rows = UI_LIST_MAX_ROWS;
+    if (rows > max_rows) rows = max_rows;
+    if (rows < 1) rows = 1;
+    list->first_row = first_row;
+    list->rows = rows;
+    list->get_row = get_row;
+    list->user_data = user_data;
+}
+
+void ui_list_set_count(ui_list_t *list, int count)
+{
+    list->count = count > 0 ? count : 0;
+    if (list->typeahead) ui_typeahead_sync(list->typeahead, list->count);
+    if (list->selected >= list->count) {
+        list->selected = list->count > 0 ? list->count - 1 : 0;
+    }
+    int max_offset = list->count - list->rows;
+    if (list->scroll_offset > max_offset) {
+        list->scroll_offset = max_offset > 0 ? max_offset : 0;
+    }
+}
+
+void ui_list_select(ui_list_t *list, int index)
+{
+    if (list->count == 0) return;
+    if (index < 0) index = 0;
+    if (index >= list->count) index = list->count - 1;
+
+    list->selected = index;
+    if (index < list->scroll_offset) {
+        list->scroll_offset = index;
+    } else if (index >= list->scroll_offset + list->rows) {
+        list->scroll_offset = index - list->rows + 1;
+    }
+}
+
+void ui_list_set_typeahead(ui_list_t *list, ui_typeahead_t *typeahead)
+{
+    list->typeahead = typeahead;
+    if (typeahead) ui_typeahead_sync(typeahead, list->count);
+}
+
+void ui_list_set_marquee(ui_list_t *list, bool on)
+{
+    list->marquee_on = on;
+    ui_marquee_stop(&list->marquee);
+    list->valid = false;
+}
+
+void ui_list_rows_moved(ui_list_t *list)
+{
+    if (list->typeahead) ui_typeahead_rows_moved(list->typeahead);
+}
+
+void ui_list_draw_status(ui_list_t *list, const char *status)
+{
+    if (list->typeahead) {
+        ui_typeahead_draw_status(list->typeahead, status);
+    } else {
+        ui_draw_status(status);
+    }
+}
+
+bool ui_list_handle_key(ui_list_t *list, key_code_t key)
+{
+    if (list->typeahead) {
+        int row;
+        switch (ui_typeahead_handle_key(list->typeahead, key, list->count, &row)) {
+            case UI_TYPEAHEAD_IGNORED:
+                break;
+            case UI_TYPEAHEAD_JUMP:
+                ui_list_select(list, row);
+                return true;
+            default:
+                return true;
+        }
+    }
+
+    if (list->count == 0) return false;
+
+    switch (key) {
+        case KEY_UP:
+            ui_list_select(list, list->selected > 0 ? list->selected - 1 : list->count - 1);
+            return true;
+        case KEY_DOWN:
+            ui_list_select(list, list->selected < list->count - 1 ? list->selected + 1 : 0);
+            return true;
+        case KEY_LEFT:
+            ui_list_select(list, list->selected - list->rows);
+            return true;
+        case KEY_RIGHT:
+            ui_list_select(list, list->selected + list->rows);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void ui_list_invalidate(ui_list_t *list)
+{
+    list->valid = false;
+}
+
+/**
+ * @brief Move the retained rows with the scrolled pixels
+ */
+static void shift_rows(ui_list_t *list, int delta)
+{
+    if (delta > 0) {
+        for (int i = list->rows - 1; i >= delta; i--) {
+            memcpy(list->shown[i], list->shown[i - delta], sizeof(list->shown[i]));
+            list->shown_selected[i] = list->shown_selected[i - delta];
+            list->row_valid[i] = list->row_valid[i - delta];
+        }
+        for (int i = 0; i < delta; i++) list->row_valid[i] = false;
+    } else {
+        int up = -delta;
+        for (int i = 0; i + up < list->rows; i++) {
+            memcpy(list->shown[i], list->shown[i + up], sizeof(list->shown[i]));
+            list->shown_selected[i] = list->shown_selected[i + up];
+            list->row_valid[i] = list->row_valid[i + up];
+        }
+        for (int i = list->rows - up; i < list->rows; i++) list->row_valid[i] = false;
+    }
+}
+
+/**
+ * @brief Drop a row that carried a scroll indicator, so it is repainted clean
+ */
+static void drop_row(ui_list_t *list, int i)
+{
+    if (i >= 0 && i < list->rows) list->row_valid[i] = false;
+}
+
+void ui_list_draw(ui_list_t *list)
+{
+    if (list->count == 0) {
+        list->valid = false;
+        return;
+    }
+
+    bool on_screen = list->valid && list->generation == ui_get_clear_generation();
+    // A scrolled marquee row differs from its text; repaint it wherever it moves
+    if (list->marquee.active && list->marquee.offset > 0) {
+        drop_row(list, list->marquee.row - list->first_row);
+    }
+    if (!on_screen) {
+        memset(list->row_valid, 0, sizeof(list->row_valid));
+        list->drawn_up = false;
+        list->drawn_down = false;
+    } else if (list->drawn_offset != list->scroll_offset) {
+        int delta = list->drawn_offset - list->scroll_offset;
+        if (delta > -list->rows && delta < list->rows) {
+            // Indicators move with the pixels; their rows are repainted
+            ui_scroll_rows(list->first_row, list->rows, delta);
+            shift_rows(list, delta);
+            if (list->drawn_up) drop_row(list, delta);
+            if (list->drawn_down) drop_row(list, list->rows - 1 + delta);
+        } else {
+            memset(list->row_valid, 0, sizeof(list->row_valid));
+        }
+        list->drawn_up = false;
+        list->drawn_down = false;
+    }
+
+    bool up = list->scroll_offset > 0;
+    bool down = list->scroll_offset + list->rows < list->count;
+    if (list->drawn_up && !up) drop_row(list, 0);
+    if (list->drawn_down && !down) drop_row(list, list->rows - 1);
+
+    // Row text is cut to the active grid
+    size_t text_len = (size_t)ui_cols();
+    if (text_len > UI_LIST_TEXT_LEN + 1) text_len = UI_LIST_TEXT_LEN + 1;
+    int sel_i = list->selected - list->scroll_offset;
+    bool sel_painted = false;
+    char full[UI_MARQUEE_TEXT_LEN];
+
+    for (int i = 0; i < list->rows; i++) {
+        int index = list->scroll_offset + i;
+        char text[UI_LIST_TEXT_LEN + 1] = "";
+        bool selected = false;
+
+        if (index < list->count) {
+            if (list->marquee_on) {
+                full[0] = '\0';
+                list->get_row(index, full, sizeof(full), list->user_data);
+                ui_text_fit(text, sizeof(text), full, (int)text_len - 1);
+            } else {
+                list->get_row(index, text, text_len, list->user_data);
+            }
+            selected = (index == list->selected);
+        }
+        if (list->row_valid[i] && list->shown_selected[i] == selected &&
+            strcmp(list->shown[i], text) == 0) {
+            continue;
+        }
+        if (selected && list->marquee_on) {
+            ui_marquee_start(&list->marquee, list->first_row + i, (int)text_len - 1, full);
+            sel_painted = true;
+        }
+
+        if (index < list->count) {
+            ui_draw_menu_item(list->first_row + i, text, selected, false, false);
+        } else {
+            display_fill_rect(0, ui_row_y(list->first_row + i), DISPLAY_WIDTH,
+                              ui_cell_height(), UI_COLOR_BG);
+        }
+        memcpy(list->shown[i], text, sizeof(text));
+        list->shown_selected[i] = selected;
+        list->row_valid[i] = true;
+
+        // A repainted edge row lost its indicator
+        if (i == 0) list->drawn_up = false;
+        if (i == list->rows - 1) list->drawn_down = false;
+    }
+
+    // An unchanged selected row moved by a scroll keeps scrolling where it is now
+    if (list->marquee_on && !sel_painted) {
+        if (sel_i >= 0 && sel_i < list->rows) {
+            list->marquee.row = list->first_row + sel_i;
+        } else {
+            ui_marquee_stop(&list->marquee);
+        }
+    }
+
+    // Scroll indicators
+    if (up && !list->drawn_up) {
+        ui_print(ui_cols() - 2, list->first_row, "^", UI_COLOR_DIMMED);
+    }
+    if (down && !list->drawn_down) {
+        ui_print(ui_cols() - 2, list->first_row + list->rows - 1, "v", UI_COLOR_DIMMED);
+    }
+    list->drawn_up = up;
+    list->drawn_down = down;
+
+    list->drawn_offset = list->scroll_offset;
+    list->generation = ui_get_clear_generation();
+    list->valid = true;
+}
+
+bool ui_list_tick(ui_list_t *list)
+{
+    if (!list->marquee_on || !list->valid || list->generation != ui_get_clear_generation()) {
+        return false;
+    }
+    if (!ui_marquee_step(&list->marquee)) return false;
+
+    // The repainted row lost its scroll indicator
+    if (list->drawn_up && list->marquee.row == list->first_row) {
+        ui_print(ui_cols() - 2, list->first_row, "^", UI_COLOR_DIMMED);
+    }
+    if (list->drawn_down && list->marquee.row == list->first_row + list->rows - 1) {
+        ui_print(ui_cols() - 2, list->first_row + list->rows - 1, "v", UI_COLOR_DIMMED);
+    }
+    return true;
+}
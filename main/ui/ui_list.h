@@ -0,0 +1,164 @@
+/**
+ * @file ui_list.h
+ * @brief Virtualized list view for list screens
+ *
+ * The list owns selection and scrolling but not the items: it asks a row
+ * callback for the text of each visible index, so the screen can keep its
+ * items anywhere (a store, a paged listing) and the list itself holds only
+ * the rows it shows. Rows whose text and selection are unchanged are not
+ * repainted, and a scroll of less than a page moves the rows with
+ * ui_scroll_rows() and paints only the exposed ones. Rows are drawn with
+ * ui_draw_menu_item, so lists look like the rest of the menus.
+ *
+ * Lists use the grid of the layout density active when they are
+ * initialized; in the compact layout they show 14 rows of 39 characters.
+ *
+ * A list given a ui_typeahead_t jumps to rows by name: TAB opens the find
+ * prompt and ui_list_handle_key() feeds it the keys until it closes.
+ *
+ * A list with the marquee on (ui_list_set_marquee()) asks for whole rows
+ * and cuts them itself, with an ellipsis; the selected row scrolls its
+ * full text while the screen calls ui_list_tick() (ui_marquee.h).
+ */
+
+#ifndef UI_LIST_H
+#define UI_LIST_H
+
+#include "text_ui.h"
+#include "keyboard.h"
+#include "ui_typeahead.h"
+#include "ui_marquee.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define UI_LIST_MAX_ROWS    (UI_ROWS_MAX - 2)   // Between title and status bar
+#define UI_LIST_TEXT_LEN    (UI_COLS_MAX - 1)   // Room left of the row's x offset
+
+/**
+ * @brief Fill the text of one item
+ * @param index Item index (0..count-1)
+ * @param text Receives the row text
+ * @param len Size of text (ui_cols() of the active layout, or
+ *            UI_MARQUEE_TEXT_LEN with the marquee on: the whole row,
+ *            not padded to a width)
+ * @param user_data As passed to ui_list_init
+ */
+typedef void (*ui_list_row_cb_t)(int index, char *text, size_t len, void *user_data);
+
+typedef struct {
+    int first_row;              // Grid row of the first visible item
+    int rows;                   // Visible rows
+    int count;
+    int selected;
+    int scroll_offset;
+    ui_list_row_cb_t get_row;
+    void *user_data;
+    ui_typeahead_t *typeahead;  // NULL: no find
+    bool marquee_on;            // Rows fitted here, selected one scrolled
+    ui_marquee_t marquee;
+
+    // What is on screen
+    char shown[UI_LIST_MAX_ROWS][UI_LIST_TEXT_LEN + 1];
+    bool shown_selected[UI_LIST_MAX_ROWS];
+    bool row_valid[UI_LIST_MAX_ROWS];
+    int drawn_offset;
+    bool drawn_up;              // Scroll indicators on screen
+    bool drawn_down;
+    uint32_t generation;        // ui_clear generation of last paint
+    bool valid;
+} ui_list_t;
+
+/**
+ * @brief Initialize an empty list (nothing is drawn until ui_list_draw)
+ * @param list List to initialize
+ * @param first_row Grid row of the first item
+ * @param rows Visible rows (clipped to the rows above the status bar)
+ * @param get_row Row text callback
+ * @param user_data Passed to get_row
+ */
+void ui_list_init(ui_list_t *list, int first_row, int rows,
+                  ui_list_row_cb_t get_row, void *user_data);
+
+/**
+ * @brief Change the item count, keeping the selection in range
+ * @param list List
+ * @param count New count
+ */
+void ui_list_set_count(ui_list_t *list, int count);
+
+/**
+ * @brief Let the list jump to rows by name
+ *
+ * The screen owns the index; rows already in the list are indexed now,
+ * later ones as ui_list_set_count() adds them.
+ * @param list List
+ * @param typeahead Initialized index, or NULL to turn find off
+ */
+void ui_list_set_typeahead(ui_list_t *list, ui_typeahead_t *typeahead);
+
+/**
+ * @brief Rows changed order; the find index is rebuilt when next needed
+ * @param list List
+ */
+void ui_list_rows_moved(ui_list_t *list);
+
+/**
+ * @brief Cut long rows with an ellipsis and scroll the selected one
+ *
+ * The row callback must then fill the whole row whatever len it gets.
+ * @param list List
+ * @param on Marquee on or off
+ */
+void ui_list_set_marquee(ui_list_t *list, bool on);
+
+/**
+ * @brief Move the selected row's marquee along (from the screen's on_tick)
+ * @param list List
+ * @return true if the row was repainted
+ */
+bool ui_list_tick(ui_list_t *list);
+
+/**
+ * @brief Draw the screen's status bar, or keep the find prompt over it
+ *
+ * While the prompt is open the text is what closing it puts back.
+ * @param list List
+ * @param status Status text
+ */
+void ui_list_draw_status(ui_list_t *list, const char *status);
+
+/**
+ * @brief Select an item and scroll it into view
+ * @param list List
+ * @param index Item index (clamped to the list)
+ */
+void ui_list_select(ui_list_t *list, int index);
+
+/**
+ * @brief Move the selection for UP/DOWN (wrapping) and LEFT/RIGHT (a page)
+ * @param list List
+ * @param key Key pressed
+ * With a find index, TAB and every key while the prompt is open are
+ * taken by the find.
+ * @return true if the key was a navigation or find key and the list
+ *         should be redrawn
+ */
+bool ui_list_handle_key(ui_list_t *list, key_code_t key);
+
+/**
+ * @brief Paint rows that changed since the last draw
+ *
+ * Draws nothing while the list is empty, so the screen can show its own
+ * placeholder in the list area; the next draw with items repaints fully.
+ * @param list List
+ */
+void ui_list_draw(ui_list_t *list);
+
+/**
+ * @brief Forget what is on screen so the next draw repaints every row
+ * @param list List
+ */
+void ui_list_invalidate(ui_list_t *list);
+
+#endif // UI_LIST_H
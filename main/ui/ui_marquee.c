@@ -0,0 +1,108 @@
+/**
+ * @file ui_marquee.c
+ * @brief Ellipsis truncation and a scrolling selected row for long text
+ */
+
+#include "ui_marquee.h"
+#include "text_ui.h"
+#include "glyph_ext.h"
+#include "esp_timer.h"
+#include <string.h>
+
+#define STEP_US     ((int64_t)UI_MARQUEE_STEP_MS * 1000)
+#define PAUSE_US    ((int64_t)UI_MARQUEE_PAUSE_MS * 1000)
+
+/**
+ * @brief Bytes of the character at text plus the zero-width marks after it
+ */
+static int cell_bytes(const char *text)
+{
+    uint32_t code;
+    int n = glyph_ext_next(text, &code);
+    while (text[n]) {
+        int next = glyph_ext_next(text + n, &code);
+        if (!glyph_ext_is_zero_width(code)) break;
+        n += next;
+    }
+    return n;
+}
+
+int ui_text_window(char *out, size_t size, const char *text, int first, int cols)
+{
+    if (size == 0) return 0;
+    out[0] = '\0';
+    if (!text) return 0;
+
+    for (int cell = 0; cell < first && *text; cell++) text += cell_bytes(text);
+
+    size_t used = 0;
+    int cells = 0;
+    while (*text && cells < cols) {
+        int n = cell_bytes(text);
+        if (used + (size_t)n >= size) break;
+        memcpy(out + used, text, (size_t)n);
+        used += (size_t)n;
+        text += n;
+        cells++;
+    }
+    out[used] = '\0';
+    return cells;
+}
+
+int ui_text_fit(char *out, size_t size, const char *text, int cols)
+{
+    if (cols < 1 || size < 2) {
+        if (size) out[0] = '\0';
+        return 0;
+    }
+    if (glyph_ext_cells(text) <= cols) {
+        int cells = ui_text_window(out, size, text, 0, cols);
+        if (!text || strlen(text) < size) return cells;
+    }
+
+    // Cut one cell (and its bytes) short and mark it
+    int cells = ui_text_window(out, size - (sizeof(UI_ELLIPSIS) - 1), text, 0, cols - 1);
+    strlcat(out, UI_ELLIPSIS, size);
+    return cells + 1;
+}
+
+void ui_marquee_start(ui_marquee_t *m, int row, int cols, const char *text)
+{
+    m->cells = glyph_ext_cells(text);
+    m->active = text && cols > 0 && m->cells > cols;
+    if (!m->active) return;
+
+    strlcpy(m->text, text, sizeof(m->text));
+    m->cells = glyph_ext_cells(m->text);
+    m->cols = cols;
+    m->row = row;
+    m->offset = 0;
+    m->next_us = esp_timer_get_time() + PAUSE_US;
+}
+
+void ui_marquee_stop(ui_marquee_t *m)
+{
+    m->active = false;
+}
+
+bool ui_marquee_step(ui_marquee_t *m)
+{
+    if (!m->active) return false;
+    int64_t now = esp_timer_get_time();
+    if (now < m->next_us) return false;
+
+    int last = m->cells - m->cols;
+    char window[UI_MARQUEE_TEXT_LEN];
+    if (m->offset >= last) {
+        // Back to the start, cut as it was first drawn
+        m->offset = 0;
+        ui_text_fit(window, sizeof(window), m->text, m->cols);
+        m->next_us = now + PAUSE_US;
+    } else {
+        m->offset++;
+        ui_text_window(window, sizeof(window), m->text, m->offset, m->cols);
+        m->next_us = now + (m->offset == last ? PAUSE_US : STEP_US);
+    }
+    ui_draw_menu_item(m->row, window, true, false, false);
+    return true;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file ui_marquee.h
+ * @brief Ellipsis truncation and a scrolling selected row for long text
+ *
+ * SSIDs, vendor names and credential fields are often longer than a row.
+ * ui_text_fit() cuts a string to a number of cells (UTF-8 aware, as the
+ * glyph cache draws it) and marks the cut with UI_ELLIPSIS, so a row
+ * shows that there is more. A marquee then shows the rest on the selected
+ * row: it waits UI_MARQUEE_PAUSE_MS, moves the text one cell left every
+ * UI_MARQUEE_STEP_MS until the end is in view, waits again and starts
+ * over. Each step repaints only that row, so scrolling costs one row
+ * transfer per step whatever else is on the screen.
+ *
+ * ui_list uses this for lists that opt in (ui_list_set_marquee()).
+ *
+ * UI task only, with the UI lock held.
+ */
+
+#ifndef UI_MARQUEE_H
+#define UI_MARQUEE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define UI_MARQUEE_TEXT_LEN     128     // Longest text scrolled, in bytes
+#define UI_MARQUEE_STEP_MS      200     // One cell per step
+#define UI_MARQUEE_PAUSE_MS     1200    // Held at the start and at the end
+#define UI_ELLIPSIS             "~"     // Marks cut text (the fonts are ASCII)
+
+typedef struct {
+    char text[UI_MARQUEE_TEXT_LEN];
+    int cells;                  // Cells of text
+    int cols;                   // Cells shown
+    int offset;                 // First cell shown
+    int row;                    // Grid row
+    int64_t next_us;            // Next step (esp_timer time)
+    bool active;
+} ui_marquee_t;
+
+/**
+ * @brief Copy text cut to a number of cells, ending in UI_ELLIPSIS if cut
+ * @param out Receives the text (also cut to fit size)
+ * @param size Size of out
+ * @param text Text, UTF-8
+ * @param cols Cells available
+ * @return Cells of out
+ */
+int ui_text_fit(char *out, size_t size, const char *text, int cols);
+
+/**
+ * @brief Copy the cells [first, first + cols) of text
+ * @return Cells of out
+ */
+int ui_text_window(char *out, size_t size, const char *text, int first, int cols);
+
+/**
+ * @brief Scroll a selected menu row whose text is longer than cols
+ *
+ * The caller has just drawn the row, fitted; shorter text stops the
+ * marquee.
+ * @param m Marquee
+ * @param row Grid row
+ * @param cols Cells of text the row shows
+ * @param text Full text
+ */
+void ui_marquee_start(ui_marquee_t *m, int row, int cols, const char *text);
+
+void ui_marquee_stop(ui_marquee_t *m);
+
+/**
+ * @brief Repaint the row one cell further along if a step is due
+ * @return true if the row was repainted
+ */
+bool ui_marquee_step(ui_marquee_t *m);
+
+#endif // UI_MARQUEE_H
@@ -0,0 +1,237 @@
+/**
+ * @file ui_typeahead.c
+ * @brief Type-ahead find for list views
+ */
+
+#include "ui_typeahead.h"
+#include "text_ui.h"
+#include "keymap.h"
+#include "fixed_containers.h"
+#include "esp_heap_caps.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CONFIG_SPIRAM
+#define TYPEAHEAD_CAPS  (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define TYPEAHEAD_CAPS  (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+#define NAME_LEN        64
+
+static char fold(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+/**
+ * @brief First UI_TYPEAHEAD_KEY_LEN folded characters, first in the top byte
+ */
+static uint64_t intern(const char *text, size_t len)
+{
+    uint64_t key = 0;
+    for (size_t i = 0; i < UI_TYPEAHEAD_KEY_LEN; i++) {
+        uint8_t c = i < len ? (uint8_t)fold(text[i]) : 0;
+        key = (key << 8) | c;
+    }
+    return key;
+}
+
+static uint64_t row_key(const ui_typeahead_t *ta, int row)
+{
+    char name[NAME_LEN] = "";
+    ta->get_name(row, name, sizeof(name), ta->user_data);
+    return intern(name, strlen(name));
+}
+
+static int compare_rows(int a, int b, void *ctx)
+{
+    const uint64_t *keys = ctx;
+    if (keys[a] != keys[b]) return keys[a] < keys[b] ? -1 : 1;
+    return a - b;
+}
+
+/**
+ * @brief First position in order[] whose (key, row) is not below (key, row)
+ */
+static int lower_bound(const ui_typeahead_t *ta, uint64_t key, int row)
+{
+    int lo = 0, hi = ta->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        int r = ta->order[mid];
+        if (ta->keys[r] < key || (ta->keys[r] == key && r < row)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+esp_err_t ui_typeahead_init(ui_typeahead_t *ta, int capacity,
+                            ui_typeahead_name_cb_t get_name, void *user_data)
+{
+    memset(ta, 0, sizeof(*ta));
+    if (capacity > UINT16_MAX) capacity = UINT16_MAX;
+    ta->keys = heap_caps_malloc(capacity * sizeof(ta->keys[0]), TYPEAHEAD_CAPS);
+    if (!ta->keys) ta->keys = malloc(capacity * sizeof(ta->keys[0]));
+    ta->order = heap_caps_malloc(capacity * sizeof(ta->order[0]), TYPEAHEAD_CAPS);
+    if (!ta->order) ta->order = malloc(capacity * sizeof(ta->order[0]));
+    if (!ta->keys || !ta->order) {
+        ui_typeahead_free(ta);
+        return ESP_ERR_NO_MEM;
+    }
+    ta->capacity = capacity;
+    ta->get_name = get_name;
+    ta->user_data = user_data;
+    return ESP_OK;
+}
+
+void ui_typeahead_free(ui_typeahead_t *ta)
+{
+    if (ta->active) keyboard_set_text_input_mode(false);
+    free(ta->keys);
+    free(ta->order);
+    memset(ta, 0, sizeof(*ta));
+}
+
+void ui_typeahead_sync(ui_typeahead_t *ta, int count)
+{
+    if (!ta->keys || ta->stale) return;
+    if (count > ta->capacity) count = ta->capacity;
+    if (count < ta->count) {
+        ta->stale = true;
+        return;
+    }
+
+    // Appended rows go in at their place in name order
+    for (int row = ta->count; row < count; row++) {
+        ta->keys[row] = row_key(ta, row);
+        int pos = lower_bound(ta, ta->keys[row], row);
+        memmove(&ta->order[pos + 1], &ta->order[pos], (ta->count - pos) * sizeof(ta->order[0]));
+        ta->order[pos] = (uint16_t)row;
+        ta->count++;
+    }
+}
+
+void ui_typeahead_rows_moved(ui_typeahead_t *ta)
+{
+    ta->stale = true;
+}
+
+static void rebuild(ui_typeahead_t *ta, int count)
+{
+    if (count > ta->capacity) count = ta->capacity;
+    for (int row = 0; row < count; row++) {
+        ta->keys[row] = row_key(ta, row);
+        ta->order[row] = (uint16_t)row;
+    }
+    fixed_index_sort(ta->order, count, compare_rows, ta->keys);
+    ta->count = count;
+    ta->stale = false;
+}
+
+/**
+ * @brief First row in name order starting with the prefix
+ * @return Row, or -1 if none
+ */
+static int search(ui_typeahead_t *ta, int count)
+{
+    if (ta->stale || ta->count != count) {
+        if (!ta->stale && count > ta->count) ui_typeahead_sync(ta, count);
+        else rebuild(ta, count);
+    }
+
+    // Keys between the prefix padded with 0x00 and with 0xFF share it
+    size_t fixed = ta->prefix_len < UI_TYPEAHEAD_KEY_LEN ? ta->prefix_len : UI_TYPEAHEAD_KEY_LEN;
+    uint64_t low = intern(ta->prefix, fixed);
+    uint64_t high = low | (fixed < UI_TYPEAHEAD_KEY_LEN ? UINT64_MAX >> (8 * fixed) : 0);
+
+    for (int pos = lower_bound(ta, low, 0); pos < ta->count; pos++) {
+        int row = ta->order[pos];
+        if (ta->keys[row] > high) break;
+        if (ta->prefix_len <= UI_TYPEAHEAD_KEY_LEN) return row;
+
+        // Longer prefix: only rows with the same first characters get here
+        char name[NAME_LEN] = "";
+        ta->get_name(row, name, sizeof(name), ta->user_data);
+        int i = UI_TYPEAHEAD_KEY_LEN;
+        while (i < ta->prefix_len && fold(name[i]) == fold(ta->prefix[i])) i++;
+        if (i == ta->prefix_len) return row;
+    }
+    return -1;
+}
+
+void ui_typeahead_draw(const ui_typeahead_t *ta)
+{
+    if (!ta->active) return;
+    char prompt[UI_TYPEAHEAD_MAX_LEN + 24];
+    snprintf(prompt, sizeof(prompt), "Find: %s_%s", ta->prefix, ta->missed ? "  no match" : "");
+    ui_draw_status(prompt);
+}
+
+void ui_typeahead_draw_status(ui_typeahead_t *ta, const char *status)
+{
+    if (ta->active) {
+        snprintf(ta->saved_status, sizeof(ta->saved_status), "%s", status);
+        ui_typeahead_draw(ta);
+    } else {
+        ui_draw_status(status);
+    }
+}
+
+static ui_typeahead_result_t close_prompt(ui_typeahead_t *ta)
+{
+    ta->active = false;
+    keyboard_set_text_input_mode(false);
+    ui_draw_status(ta->saved_status);
+    return UI_TYPEAHEAD_CLOSED;
+}
+
+ui_typeahead_result_t ui_typeahead_handle_key(ui_typeahead_t *ta, key_code_t key,
+                                              int count, int *row)
+{
+    if (!ta->keys) return UI_TYPEAHEAD_IGNORED;
+
+    if (!ta->active) {
+        if (key != KEY_TAB || count == 0) return UI_TYPEAHEAD_IGNORED;
+        ta->active = true;
+        ta->missed = false;
+        ta->prefix_len = 0;
+        ta->prefix[0] = '\0';
+        snprintf(ta->saved_status, sizeof(ta->saved_status), "%s", ui_get_status());
+        keyboard_set_text_input_mode(true);
+        ui_typeahead_draw(ta);
+        return UI_TYPEAHEAD_CONSUMED;
+    }
+
+    switch (key) {
+        case KEY_ENTER:
+        case KEY_ESC:
+        case KEY_TAB:
+            return close_prompt(ta);
+
+        case KEY_BACKSPACE:
+        case KEY_DEL:
+            if (ta->prefix_len == 0) return close_prompt(ta);
+            ta->prefix[--ta->prefix_len] = '\0';
+            break;
+
+        default: {
+            char c = keymap_char(key, keyboard_is_shift_held(), keyboard_is_capslock_held());
+            if (!c || ta->prefix_len >= UI_TYPEAHEAD_MAX_LEN) return UI_TYPEAHEAD_CONSUMED;
+            ta->prefix[ta->prefix_len++] = c;
+            ta->prefix[ta->prefix_len] = '\0';
+            break;
+        }
+    }
+
+    int found = ta->prefix_len > 0 ? search(ta, count) : -1;
+    ta->missed = ta->prefix_len > 0 && found < 0;
+    ui_typeahead_draw(ta);
+    if (found < 0) return UI_TYPEAHEAD_CONSUMED;
+    *row = found;
+    return UI_TYPEAHEAD_JUMP;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file ui_typeahead.h
+ * @brief Type-ahead find for list views
+ *
+ * TAB opens a "Find:" prompt on the status bar; letters typed then jump
+ * the list to the first row, in name order, whose name starts with them
+ * (case-insensitive). ENTER or ESC closes the prompt and puts the
+ * screen's status text back. Letter keys keep their screen commands
+ * while the prompt is closed.
+ *
+ * Each row's name is interned as its first UI_TYPEAHEAD_KEY_LEN folded
+ * characters packed into one integer, and rows are kept sorted by it, so
+ * a keystroke is a binary search on integers; names are fetched again
+ * only to tell apart rows whose first characters all match a longer
+ * prefix (those are tried in list order). Rows appended to the list are
+ * inserted as they arrive. A screen whose rows change order (a re-sort,
+ * a rebuilt view) calls ui_typeahead_rows_moved() and the index is
+ * rebuilt on the next search.
+ *
+ * UI task only.
+ */
+
+#ifndef UI_TYPEAHEAD_H
+#define UI_TYPEAHEAD_H
+
+#include "keyboard.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define UI_TYPEAHEAD_MAX_LEN    16      // Characters in a prefix
+#define UI_TYPEAHEAD_KEY_LEN    8       // Characters interned per row
+
+/**
+ * @brief Fill the name a row is found by
+ * @param row List row (0..count-1)
+ * @param name Receives the name
+ * @param len Size of name
+ * @param user_data As passed to ui_typeahead_init
+ */
+typedef void (*ui_typeahead_name_cb_t)(int row, char *name, size_t len, void *user_data);
+
+typedef enum {
+    UI_TYPEAHEAD_IGNORED = 0,   // Not a find key: handle it as usual
+    UI_TYPEAHEAD_CONSUMED,      // Prompt changed, selection did not
+    UI_TYPEAHEAD_JUMP,          // Select *row
+    UI_TYPEAHEAD_CLOSED,        // Prompt closed, status bar restored
+} ui_typeahead_result_t;
+
+typedef struct {
+    uint64_t *keys;             // Interned name per row
+    uint16_t *order;            // Rows sorted by key, then row
+    int count;                  // Rows indexed
+    int capacity;
+    bool stale;                 // Rows moved since the index was built
+    ui_typeahead_name_cb_t get_name;
+    void *user_data;
+    char prefix[UI_TYPEAHEAD_MAX_LEN + 1];
+    int prefix_len;
+    bool active;                // Prompt open
+    bool missed;                // No row starts with the prefix
+    char saved_status[48];      // Screen status under the prompt
+} ui_typeahead_t;
+
+/**
+ * @brief Set up an index for up to capacity rows (PSRAM when available)
+ * @return ESP_OK, ESP_ERR_NO_MEM
+ */
+esp_err_t ui_typeahead_init(ui_typeahead_t *ta, int capacity,
+                            ui_typeahead_name_cb_t get_name, void *user_data);
+
+/**
+ * @brief Release the index (closes the prompt if open)
+ */
+void ui_typeahead_free(ui_typeahead_t *ta);
+
+/**
+ * @brief Index rows appended since the last call
+ *
+ * A count lower than before marks the index stale instead.
+ * @param count Rows in the list now
+ */
+void ui_typeahead_sync(ui_typeahead_t *ta, int count);
+
+/**
+ * @brief Rows changed order or names; rebuild before the next search
+ */
+void ui_typeahead_rows_moved(ui_typeahead_t *ta);
+
+/**
+ * @brief Feed a key
+ * @param count Rows in the list now
+ * @param row Receives the row to select on UI_TYPEAHEAD_JUMP
+ */
+ui_typeahead_result_t ui_typeahead_handle_key(ui_typeahead_t *ta, key_code_t key,
+                                              int count, int *row);
+
+/**
+ * @brief Draw the prompt again (after a full screen redraw), if open
+ */
+void ui_typeahead_draw(const ui_typeahead_t *ta);
+
+/**
+ * @brief Draw a screen's status bar, or keep the prompt over it
+ *
+ * While the prompt is open the text is what closing it puts back.
+ */
+void ui_typeahead_draw_status(ui_typeahead_t *ta, const char *status);
+
+#endif // UI_TYPEAHEAD_H
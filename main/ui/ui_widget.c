@@ -0,0 +1,402 @@
+/**
+ * @file ui_widget.c
+ * @brief Retained widgets for partial screen updates
+ */
+
+#include "ui_widget.h"
+#include <string.h>
+#include <stdio.h>
+
+// Grid cell size in pixels (matches the 8x16 font used by text_ui)
+#define CELL_W  (DISPLAY_WIDTH / UI_COLS)
+#define CELL_H  (DISPLAY_HEIGHT / UI_ROWS)
+
+/**
+ * @brief Check whether a retained widget still matches the screen
+ */
+static bool widget_on_screen(bool valid, uint32_t generation)
+{
+    return valid && generation == ui_get_clear_generation();
+}
+
+/**
+ * @brief Lay out text into a space-padded span of exactly width chars
+ */
+static void layout_text(char *dst, int width, const char *text, ui_align_t align)
+{
+    int len = text ? strlen(text) : 0;
+    if (len > width) len = width;
+
+    int pad = 0;
+    if (align == UI_ALIGN_CENTER) {
+        pad = (width - len) / 2;
+    } else if (align == UI_ALIGN_RIGHT) {
+        pad = width - len;
+    }
+
+    memset(dst, ' ', width);
+    for (int i = 0; i < len; i++) {
+        char c = text[i];
+        dst[pad + i] = (c == '\n' || c == '\r') ? ' ' : c;
+    }
+    dst[width] = '\0';
+}
+
+void ui_label_init(ui_label_t *label, int col, int row, int width,
+                   ui_align_t align, uint16_t fg, uint16_t bg)
+{
+    if (col < 0) col = 0;
+    if (col > UI_COLS) col = UI_COLS;
+    if (width < 0) width = 0;
+    if (col + width > UI_COLS) width = UI_COLS - col;
+
+    label->col = col;
+    label->row = row;
+    label->width = width;
+    label->align = align;
+    label->fg = fg;
+    label->bg = bg;
+    label->shown[0] = '\0';
+    label->generation = 0;
+    label->valid = false;
+}
+
+void ui_label_set(ui_label_t *label, const char *text)
+{
+    if (label->width <= 0 || label->row < 0 || label->row >= UI_ROWS) return;
+
+    char next[UI_COLS + 1];
+    layout_text(next, label->width, text, label->align);
+
+    int y = label->row * CELL_H;
+
+    if (!widget_on_screen(label->valid, label->generation)) {
+        ui_draw_text(label->col * CELL_W, y, next, label->fg, label->bg);
+    } else {
+        // Repaint only runs of cells whose character changed
+        int i = 0;
+        while (i < label->width) {
+            if (next[i] == label->shown[i]) {
+                i++;
+                continue;
+            }
+            int start = i;
+            while (i < label->width && next[i] != label->shown[i]) {
+                i++;
+            }
+            char run[UI_COLS + 1];
+            memcpy(run, &next[start], i - start);
+            run[i - start] = '\0';
+            ui_draw_text((label->col + start) * CELL_W, y, run, label->fg, label->bg);
+        }
+    }
+
+    memcpy(label->shown, next, label->width + 1);
+    label->generation = ui_get_clear_generation();
+    label->valid = true;
+}
+
+void ui_label_set_colors(ui_label_t *label, uint16_t fg, uint16_t bg)
+{
+    if (label->fg != fg || label->bg != bg) {
+        label->fg = fg;
+        label->bg = bg;
+        label->valid = false;
+    }
+}
+
+void ui_label_invalidate(ui_label_t *label)
+{
+    label->valid = false;
+}
+
+void ui_counter_init(ui_counter_t *counter, int col, int row, int width,
+                     ui_align_t align, const char *prefix, const char *suffix,
+                     uint16_t fg)
+{
+    ui_label_init(&counter->label, col, row, width, align, fg, UI_COLOR_BG);
+    counter->prefix = prefix;
+    counter->suffix = suffix;
+    counter->value = 0;
+}
+
+void ui_counter_set(ui_counter_t *counter, int32_t value)
+{
+    if (counter->value == value &&
+        widget_on_screen(counter->label.valid, counter->label.generation)) {
+        return;
+    }
+
+    char text[UI_COLS + 1];
+    snprintf(text, sizeof(text), "%s%ld%s",
+             counter->prefix ? counter->prefix : "",
+             (long)value,
+             counter->suffix ? counter->suffix : "");
+
+    counter->value = value;
+    ui_label_set(&counter->label, text);
+}
+
+void ui_gauge_init(ui_gauge_t *gauge, int x, int y, int w, int h,
+                   int32_t min, int32_t max, uint16_t fg, uint16_t bg)
+{
+    gauge->x = x;
+    gauge->y = y;
+    gauge->w = w;
+    gauge->h = h;
+    gauge->min = min;
+    gauge->max = (max > min) ? max : min + 1;
+    gauge->fg = fg;
+    gauge->bg = bg;
+    gauge->filled = 0;
+    gauge->generation = 0;
+    gauge->valid = false;
+}
+
+void ui_gauge_set(ui_gauge_t *gauge, int32_t value)
+{
+    if (gauge->w <= 0 || gauge->h <= 0) return;
+
+    if (value < gauge->min) value = gauge->min;
+    if (value > gauge->max) value = gauge->max;
+    int filled = (int)((int64_t)(value - gauge->min) * gauge->w /
+                       (gauge->max - gauge->min));
+
+    if (!widget_on_screen(gauge->valid, gauge->generation)) {
+        if (filled > 0) {
+            display_fill_rect(gauge->x, gauge->y, filled, gauge->h, gauge->fg);
+        }
+        if (filled < gauge->w) {
+            display_fill_rect(gauge->x + filled, gauge->y, gauge->w - filled, gauge->h, gauge->bg);
+        }
+    } else if (filled > gauge->filled) {
+        display_fill_rect(gauge->x + gauge->filled, gauge->y,
+                          filled - gauge->filled, gauge->h, gauge->fg);
+    } else if (filled < gauge->filled) {
+        display_fill_rect(gauge->x + filled, gauge->y,
+                          gauge->filled - filled, gauge->h, gauge->bg);
+    }
+
+    gauge->filled = filled;
+    gauge->generation = ui_get_clear_generation();
+    gauge->valid = true;
+}
+
+void ui_bars_init(ui_bars_t *bars, int x, int y, int h, int pitch, int bar_w,
+                  int count, int32_t max, uint16_t bg)
+{
+    bars->x = x;
+    bars->y = y;
+    bars->h = (h < UI_BARS_UNKNOWN) ? h : UI_BARS_UNKNOWN - 1;
+    bars->pitch = pitch;
+    bars->bar_w = (bar_w < pitch) ? bar_w : pitch;
+    bars->count = (count < UI_BARS_MAX) ? count : UI_BARS_MAX;
+    bars->max = (max > 0) ? max : 1;
+    bars->bg = bg;
+    bars->generation = 0;
+    bars->valid = false;
+}
+
+void ui_bars_set_max(ui_bars_t *bars, int32_t max)
+{
+    if (max < 1) max = 1;
+    if (max == bars->max) return;
+    bars->max = max;
+    memset(bars->drawn, UI_BARS_UNKNOWN, sizeof(bars->drawn));
+}
+
+void ui_bars_set(ui_bars_t *bars, int index, int32_t value, uint16_t color)
+{
+    if (index < 0 || index >= bars->count || bars->h <= 0) return;
+
+    // After ui_clear() no bar is on screen, whatever was set before
+    if (!widget_on_screen(bars->valid, bars->generation)) {
+        memset(bars->drawn, UI_BARS_UNKNOWN, sizeof(bars->drawn));
+        bars->generation = ui_get_clear_generation();
+        bars->valid = true;
+    }
+
+    if (value < 0) value = 0;
+    if (value > bars->max) value = bars->max;
+    int height = (int)((int64_t)value * bars->h / bars->max);
+    if (value > 0 && height == 0) height = 1;
+
+    int x = bars->x + index * bars->pitch;
+    int base = bars->y + bars->h;
+    int drawn = bars->drawn[index];
+    if (drawn == UI_BARS_UNKNOWN || color != bars->color[index]) {
+        if (height < bars->h) {
+            display_fill_rect(x, bars->y, bars->bar_w, bars->h - height, bars->bg);
+        }
+        if (height > 0) {
+            display_fill_rect(x, base - height, bars->bar_w, height, color);
+        }
+    } else if (height > drawn) {
+        display_fill_rect(x, base - height, bars->bar_w, height - drawn, color);
+    } else if (height < drawn) {
+        display_fill_rect(x, base - drawn, bars->bar_w, drawn - height, bars->bg);
+    }
+
+    bars->drawn[index] = (uint8_t)height;
+    bars->color[index] = color;
+}
+
+void ui_progress_init(ui_progress_t *progress, int row)
+{
+    ui_label_init(&progress->text, 0, row, UI_COLS, UI_ALIGN_CENTER,
+                  UI_COLOR_TEXT, UI_COLOR_BG);
+    ui_label_init(&progress->counts, 0, row + 1, UI_COLS, UI_ALIGN_CENTER,
+                  UI_COLOR_DIMMED, UI_COLOR_BG);
+    ui_gauge_init(&progress->bar, CELL_W * 2, (row + 2) * CELL_H + CELL_H / 4,
+                  DISPLAY_WIDTH - CELL_W * 4, CELL_H / 2, 0, 100,
+                  UI_COLOR_HIGHLIGHT, UI_COLOR_SELECTED);
+}
+
+void ui_progress_set(ui_progress_t *progress, const uart_progress_record_t *rec)
+{
+    const char *text = rec->text;
+    if (!text[0]) {
+        text = rec->state == UART_PROGRESS_DONE ? "Done" :
+               rec->state == UART_PROGRESS_ERROR ? "Failed" : "Working...";
+    }
+    ui_label_set_colors(&progress->text,
+                        rec->state == UART_PROGRESS_ERROR ? UI_COLOR_HIGHLIGHT : UI_COLOR_TEXT,
+                        UI_COLOR_BG);
+    ui_label_set(&progress->text, text);
+
+    char counts[UI_COLS + 1];
+    int len = 0;
+    if (rec->total > 0) {
+        len = snprintf(counts, sizeof(counts), "%u/%u", rec->done, rec->total);
+    } else if (rec->done > 0 || rec->state == UART_PROGRESS_DONE) {
+        len = snprintf(counts, sizeof(counts), "%u", rec->done);
+    } else {
+        counts[0] = '\0';
+    }
+    if (rec->skipped > 0 && len < (int)sizeof(counts)) {
+        len += snprintf(counts + len, sizeof(counts) - len, "  skipped %u", rec->skipped);
+    }
+    if (rec->failed > 0 && len < (int)sizeof(counts)) {
+        snprintf(counts + len, sizeof(counts) - len, "  failed %u", rec->failed);
+    }
+    ui_label_set(&progress->counts, counts);
+
+    int percent = 0;
+    if (rec->state == UART_PROGRESS_DONE) {
+        percent = 100;
+    } else if (rec->percent <= 100) {
+        percent = rec->percent;
+    } else if (rec->total > 0) {
+        percent = rec->done * 100 / rec->total;
+    }
+    ui_gauge_set(&progress->bar, percent);
+}
+
+void ui_list_row_init(ui_list_row_t *item, int row)
+{
+    ui_label_init(&item->label, 0, row, UI_COLS, UI_ALIGN_LEFT, UI_COLOR_TEXT, UI_COLOR_BG);
+    item->selected = false;
+}
+
+void ui_list_row_set(ui_list_row_t *item, const char *text, bool selected)
+{
+    item->selected = selected;
+    ui_label_set_colors(&item->label,
+                        selected ? UI_COLOR_HIGHLIGHT : UI_COLOR_TEXT,
+                        selected ? UI_COLOR_SELECTED : UI_COLOR_BG);
+    ui_label_set(&item->label, text);
+}
+
+_Static_assert((UI_HISTORY_LEN & (UI_HISTORY_LEN - 1)) == 0,
+               "History length must be a power of two");
+
+void ui_history_reset(ui_history_t *history)
+{
+    memset(history->samples, (uint8_t)UI_HISTORY_NONE, sizeof(history->samples));
+    history->count = 0;
+}
+
+void ui_history_push(ui_history_t *history, int8_t value)
+{
+    history->samples[history->count % UI_HISTORY_LEN] = value;
+    history->count++;
+}
+
+int8_t ui_history_get(const ui_history_t *history, uint32_t age)
+{
+    if (age >= history->count || age >= UI_HISTORY_LEN) return UI_HISTORY_NONE;
+    return history->samples[(history->count - 1 - age) % UI_HISTORY_LEN];
+}
+
+void ui_sparkline_init(ui_sparkline_t *spark, int x, int y, int w, int h, int col_w,
+                       int32_t min, int32_t max, uint16_t fg, uint16_t bg)
+{
+    if (col_w < 1) col_w = 1;
+    int columns = w / col_w;
+    if (columns > UI_HISTORY_LEN) columns = UI_HISTORY_LEN;
+
+    spark->x = x;
+    spark->y = y;
+    spark->w = columns * col_w;
+    spark->h = h;
+    spark->col_w = col_w;
+    spark->columns = columns;
+    spark->min = min;
+    spark->max = (max > min) ? max : min + 1;
+    spark->fg = fg;
+    spark->bg = bg;
+    spark->drawn = 0;
+    spark->generation = 0;
+    spark->valid = false;
+}
+
+/**
+ * @brief Paint the column holding sample number @p n (counted from reset)
+ */
+static void sparkline_column(const ui_sparkline_t *spark, const ui_history_t *history, uint32_t n)
+{
+    int x = spark->x + (int)(n % spark->columns) * spark->col_w;
+    int8_t v = history->samples[n % UI_HISTORY_LEN];
+
+    if (v == UI_HISTORY_NONE) {
+        // Gap: dimmed baseline only
+        display_fill_rect(x, spark->y, spark->col_w, spark->h - 1, spark->bg);
+        display_fill_rect(x, spark->y + spark->h - 1, spark->col_w, 1, UI_COLOR_DIMMED);
+        return;
+    }
+
+    int32_t level = v < spark->min ? spark->min : v > spark->max ? spark->max : v;
+    int bar = 1 + (int)((level - spark->min) * (spark->h - 1) / (spark->max - spark->min));
+    if (bar < spark->h) {
+        display_fill_rect(x, spark->y, spark->col_w, spark->h - bar, spark->bg);
+    }
+    display_fill_rect(x, spark->y + spark->h - bar, spark->col_w, bar, spark->fg);
+}
+
+void ui_sparkline_update(ui_sparkline_t *spark, const ui_history_t *history)
+{
+    if (spark->columns <= 0 || spark->h <= 0) return;
+
+    uint32_t count = history->count;
+    uint32_t from = spark->drawn;
+    bool on_screen = widget_on_screen(spark->valid, spark->generation);
+
+    if (on_screen && from == count) return;
+    if (!on_screen || count < from || count - from > (uint32_t)spark->columns) {
+        display_fill_rect(spark->x, spark->y, spark->w, spark->h, spark->bg);
+        from = count > (uint32_t)spark->columns ? count - spark->columns : 0;
+    }
+
+    for (uint32_t n = from; n < count; n++) {
+        sparkline_column(spark, history, n);
+    }
+    if (count >= (uint32_t)spark->columns) {
+        // Sweep cursor: clear the oldest column, the next one to be painted
+        int x = spark->x + (int)(count % spark->columns) * spark->col_w;
+        display_fill_rect(x, spark->y, spark->col_w, spark->h, spark->bg);
+    }
+
+    spark->drawn = count;
+    spark->generation = ui_get_clear_generation();
+    spark->valid = true;
+}
@@ -0,0 +1,314 @@
+/**
+ * @file ui_widget.h
+ * @brief Retained widgets for partial screen updates
+ *
+ * Each widget remembers what it last put on screen and repaints only the
+ * cells (or pixels, for gauges) that changed. After ui_clear() every widget
+ * repaints fully on its next update, so screens can keep a single
+ * draw function for both the first paint and later refreshes.
+ * Widgets are laid out on the normal 30x8 grid.
+ */
+
+#ifndef UI_WIDGET_H
+#define UI_WIDGET_H
+
+#include "text_ui.h"
+#include "uart_frame.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Text alignment within a widget's cell span
+typedef enum {
+    UI_ALIGN_LEFT = 0,
+    UI_ALIGN_CENTER,
+    UI_ALIGN_RIGHT,
+} ui_align_t;
+
+// Text label occupying a fixed span of cells on one grid row
+typedef struct {
+    int col;                    // First column
+    int row;                    // Grid row
+    int width;                  // Span in columns
+    ui_align_t align;
+    uint16_t fg;
+    uint16_t bg;
+    char shown[UI_COLS + 1];    // Padded text currently on screen
+    uint32_t generation;        // ui_clear generation of last paint
+    bool valid;                 // shown[] reflects the screen
+} ui_label_t;
+
+// Integer value rendered as "<prefix><value><suffix>"
+typedef struct {
+    ui_label_t label;
+    const char *prefix;
+    const char *suffix;
+    int32_t value;
+} ui_counter_t;
+
+// Horizontal bar gauge in pixel coordinates
+typedef struct {
+    int x;
+    int y;
+    int w;
+    int h;
+    int32_t min;
+    int32_t max;
+    uint16_t fg;
+    uint16_t bg;
+    int filled;                 // Filled width in pixels currently on screen
+    uint32_t generation;
+    bool valid;
+} ui_gauge_t;
+
+// Fixed-size ring of int8 samples (RSSI, per-second rates) for sparklines
+#define UI_HISTORY_LEN      128             // Power of two
+#define UI_HISTORY_NONE     INT8_MIN        // No reading for this sample
+
+typedef struct {
+    int8_t samples[UI_HISTORY_LEN];
+    uint32_t count;             // Samples pushed since reset
+} ui_history_t;
+
+// Column graph of a ui_history_t, drawn as a sweep: each new sample
+// repaints one column and clears the next, so nothing ever scrolls
+typedef struct {
+    int x;
+    int y;
+    int w;
+    int h;
+    int col_w;                  // Pixels per sample
+    int columns;                // Samples shown (w / col_w, at most UI_HISTORY_LEN)
+    int32_t min;                // Value drawn as a 1 px bar
+    int32_t max;                // Value drawn as a full-height bar
+    uint16_t fg;
+    uint16_t bg;
+    uint32_t drawn;             // History count currently on screen
+    uint32_t generation;
+    bool valid;
+} ui_sparkline_t;
+
+// Vertical bars on a shared baseline (a histogram). A bar repaints only
+// the strip between its old and new height, or whole on a color change.
+#define UI_BARS_MAX         32
+#define UI_BARS_UNKNOWN     0xFF            // Height not on screen
+
+typedef struct {
+    int x;
+    int y;                      // Top of the tallest bar
+    int h;                      // Full bar height in pixels (at most 254)
+    int pitch;                  // Pixels from one bar to the next
+    int bar_w;
+    int count;                  // Bars (at most UI_BARS_MAX)
+    int32_t max;                // Value drawn full height
+    uint16_t bg;
+    uint8_t drawn[UI_BARS_MAX]; // Height on screen, UI_BARS_UNKNOWN = repaint
+    uint16_t color[UI_BARS_MAX];
+    uint32_t generation;
+    bool valid;
+} ui_bars_t;
+
+// Progress of a long operation: phase text, counts and a bar on three rows
+typedef struct {
+    ui_label_t text;
+    ui_label_t counts;
+    ui_gauge_t bar;
+} ui_progress_t;
+
+// Full-width list row with selection highlight
+typedef struct {
+    ui_label_t label;
+    bool selected;
+} ui_list_row_t;
+
+/**
+ * @brief Initialize a label (nothing is drawn until ui_label_set)
+ * @param label Label to initialize
+ * @param col First column
+ * @param row Grid row
+ * @param width Span in columns (clipped to screen)
+ * @param align Text alignment within the span
+ * @param fg Foreground color
+ * @param bg Background color
+ */
+void ui_label_init(ui_label_t *label, int col, int row, int width,
+                   ui_align_t align, uint16_t fg, uint16_t bg);
+
+/**
+ * @brief Set label text, repainting only cells that changed
+ * @param label Label
+ * @param text New text (NULL clears the span)
+ */
+void ui_label_set(ui_label_t *label, const char *text);
+
+/**
+ * @brief Change label colors (forces a full repaint on next set)
+ * @param label Label
+ * @param fg Foreground color
+ * @param bg Background color
+ */
+void ui_label_set_colors(ui_label_t *label, uint16_t fg, uint16_t bg);
+
+/**
+ * @brief Forget what is on screen so the next set repaints the whole span
+ * @param label Label
+ */
+void ui_label_invalidate(ui_label_t *label);
+
+/**
+ * @brief Initialize a counter
+ * @param counter Counter to initialize
+ * @param col First column
+ * @param row Grid row
+ * @param width Span in columns
+ * @param align Text alignment within the span
+ * @param prefix Text before the value (may be NULL, must stay valid)
+ * @param suffix Text after the value (may be NULL, must stay valid)
+ * @param fg Foreground color
+ */
+void ui_counter_init(ui_counter_t *counter, int col, int row, int width,
+                     ui_align_t align, const char *prefix, const char *suffix,
+                     uint16_t fg);
+
+/**
+ * @brief Set counter value; no-op if unchanged and still on screen
+ * @param counter Counter
+ * @param value New value
+ */
+void ui_counter_set(ui_counter_t *counter, int32_t value);
+
+/**
+ * @brief Initialize a gauge
+ * @param gauge Gauge to initialize
+ * @param x X pixel position
+ * @param y Y pixel position
+ * @param w Width in pixels
+ * @param h Height in pixels
+ * @param min Value mapped to an empty bar
+ * @param max Value mapped to a full bar
+ * @param fg Bar color
+ * @param bg Background color
+ */
+void ui_gauge_init(ui_gauge_t *gauge, int x, int y, int w, int h,
+                   int32_t min, int32_t max, uint16_t fg, uint16_t bg);
+
+/**
+ * @brief Set gauge value, filling or clearing only the changed strip
+ * @param gauge Gauge
+ * @param value New value (clamped to min..max)
+ */
+void ui_gauge_set(ui_gauge_t *gauge, int32_t value);
+
+/**
+ * @brief Initialize a bar chart (nothing is drawn until ui_bars_set)
+ * @param bars Chart to initialize
+ * @param x X pixel position of the first bar
+ * @param y Y pixel position of the top of a full bar
+ * @param h Full bar height in pixels
+ * @param pitch Pixels from one bar's left edge to the next
+ * @param bar_w Bar width in pixels (at most pitch)
+ * @param count Number of bars (clipped to UI_BARS_MAX)
+ * @param max Value drawn full height
+ * @param bg Background color
+ */
+void ui_bars_init(ui_bars_t *bars, int x, int y, int h, int pitch, int bar_w,
+                  int count, int32_t max, uint16_t bg);
+
+/**
+ * @brief Change the full-height value; every bar repaints on its next set
+ * @param bars Chart
+ * @param max Value drawn full height
+ */
+void ui_bars_set_max(ui_bars_t *bars, int32_t max);
+
+/**
+ * @brief Set one bar, filling or clearing only the changed strip
+ * @param bars Chart
+ * @param index Bar index
+ * @param value New value (clamped to 0..max; any value above 0 shows 1 px)
+ * @param color Bar color
+ */
+void ui_bars_set(ui_bars_t *bars, int index, int32_t value, uint16_t color);
+
+/**
+ * @brief Initialize a list row spanning the full screen width
+ * @param item Row to initialize
+ * @param row Grid row
+ */
+void ui_list_row_init(ui_list_row_t *item, int row);
+
+/**
+ * @brief Set list row text and selection state
+ *
+ * A selection change repaints the row; otherwise only changed cells are drawn.
+ * @param item Row
+ * @param text Row text
+ * @param selected Whether the row is highlighted
+ */
+void ui_list_row_set(ui_list_row_t *item, const char *text, bool selected);
+
+/**
+ * @brief Initialize a progress block (nothing is drawn until ui_progress_set)
+ * @param progress Block to initialize
+ * @param row Grid row of the phase text; counts and bar use the next two
+ */
+void ui_progress_init(ui_progress_t *progress, int row);
+
+/**
+ * @brief Show an operation's progress record
+ *
+ * The bar follows percent, or done/total when JanOS gives no percent,
+ * and stays empty while neither is known.
+ * @param progress Block
+ * @param rec Latest record (uart_progress_get)
+ */
+void ui_progress_set(ui_progress_t *progress, const uart_progress_record_t *rec);
+
+/**
+ * @brief Empty a history (every sample reads UI_HISTORY_NONE)
+ * @param history History to reset
+ */
+void ui_history_reset(ui_history_t *history);
+
+/**
+ * @brief Append a sample, overwriting the oldest once full
+ * @param history History
+ * @param value Sample (UI_HISTORY_NONE for a gap)
+ */
+void ui_history_push(ui_history_t *history, int8_t value);
+
+/**
+ * @brief Read a sample by age
+ * @param history History
+ * @param age 0 for the newest sample
+ * @return Sample, or UI_HISTORY_NONE if not that many are kept
+ */
+int8_t ui_history_get(const ui_history_t *history, uint32_t age);
+
+/**
+ * @brief Initialize a sparkline (nothing is drawn until ui_sparkline_update)
+ * @param spark Sparkline to initialize
+ * @param x X pixel position
+ * @param y Y pixel position
+ * @param w Width in pixels
+ * @param h Height in pixels
+ * @param col_w Pixels per sample column
+ * @param min Value mapped to the lowest bar
+ * @param max Value mapped to a full bar
+ * @param fg Bar color
+ * @param bg Background color
+ */
+void ui_sparkline_init(ui_sparkline_t *spark, int x, int y, int w, int h, int col_w,
+                       int32_t min, int32_t max, uint16_t fg, uint16_t bg);
+
+/**
+ * @brief Paint samples pushed since the last update
+ *
+ * Only the new columns (and the cleared column after the newest) are
+ * drawn; after ui_clear(), or if more than a full sweep arrived, the
+ * whole graph is repainted.
+ * @param spark Sparkline
+ * @param history Samples to show
+ */
+void ui_sparkline_update(ui_sparkline_t *spark, const ui_history_t *history);
+
+#endif // UI_WIDGET_H
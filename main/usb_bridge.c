@@ -0,0 +1,140 @@
+/**
+ * @file usb_bridge.c
+ * @brief Byte-for-byte bridge between the USB CDC port and JanOS
+ */
+
+#include "usb_bridge.h"
+#include "uart_handler.h"
+#include "screen_mirror.h"
+#include "usb_msc.h"
+#include "task_plan.h"
+#include "power.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "driver/usb_serial_jtag.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "USB_BRIDGE";
+
+static TaskHandle_t bridge_task_handle = NULL;
+static volatile bool bridge_running = false;
+static usb_bridge_stats_t stats;
+
+/**
+ * @brief JanOS -> PC: raw tap on the UART RX task, never blocks
+ */
+static void to_pc_tap(const uint8_t *data, size_t len, void *user_data)
+{
+    (void)user_data;
+    int sent = usb_serial_jtag_write_bytes(data, len, 0);
+    if (sent < 0) sent = 0;
+    stats.to_pc_bytes += sent;
+    stats.to_pc_dropped += len - sent;
+}
+
+/**
+ * @brief PC -> JanOS: move whatever the host sent into the UART TX ring
+ */
+static void bridge_task(void *arg)
+{
+    (void)arg;
+    static uint8_t chunk[USB_BRIDGE_CHUNK];
+
+    while (bridge_running) {
+        int len = usb_serial_jtag_read_bytes(chunk, sizeof(chunk),
+                                             pdMS_TO_TICKS(USB_BRIDGE_POLL_MS));
+        if (len <= 0) continue;
+
+        power_acquire(POWER_LOCK_UART);
+        if (uart_write_raw(chunk, len) == ESP_OK) {
+            stats.to_janos_bytes += len;
+        } else {
+            stats.to_janos_dropped += len;
+        }
+        power_release(POWER_LOCK_UART);
+    }
+
+    task_plan_track(TASK_ID_USB_BRIDGE, NULL);
+    bridge_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t usb_bridge_start(void)
+{
+    if (bridge_running) return ESP_ERR_INVALID_STATE;
+    if (screen_mirror_is_active()) {
+        ESP_LOGW(TAG, "Screen mirror is using USB, stop it with Ctrl+M");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (usb_msc_is_active()) {
+        ESP_LOGW(TAG, "USB is exporting the SD card");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ESP_LOGI(TAG, "Starting USB bridge at %lu baud, logging paused",
+             (unsigned long)uart_get_baud_rate());
+    
+    usb_serial_jtag_driver_config_t config = {
+        .rx_buffer_size = USB_BRIDGE_RING_SIZE,
+        .tx_buffer_size = USB_BRIDGE_RING_SIZE,
+    };
+    esp_err_t ret = usb_serial_jtag_driver_install(&config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "USB driver install failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // Log lines would interleave with the bridged byte stream
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    stats = (usb_bridge_stats_t){ .active = true };
+    bridge_running = true;
+    BaseType_t task_ret = xTaskCreatePinnedToCore(bridge_task, "usb_bridge",
+                                                  TASK_USB_BRIDGE_STACK, NULL,
+                                                  TASK_USB_BRIDGE_PRIO, &bridge_task_handle,
+                                                  TASK_USB_BRIDGE_CORE);
+    if (task_ret != pdPASS) {
+        bridge_running = false;
+        stats.active = false;
+        usb_serial_jtag_driver_uninstall();
+        esp_log_level_set("*", CONFIG_LOG_DEFAULT_LEVEL);
+        ESP_LOGE(TAG, "Failed to create bridge task");
+        return ESP_ERR_NO_MEM;
+    }
+    task_plan_track(TASK_ID_USB_BRIDGE, bridge_task_handle);
+
+    uart_set_raw_tap(to_pc_tap, NULL);
+    return ESP_OK;
+}
+
+void usb_bridge_stop(void)
+{
+    if (!bridge_running) return;
+
+    // Returns once the tap is no longer running on the RX task
+    uart_set_raw_tap(NULL, NULL);
+
+    bridge_running = false;
+    while (bridge_task_handle) {
+        vTaskDelay(pdMS_TO_TICKS(USB_BRIDGE_POLL_MS));
+    }
+
+    usb_serial_jtag_driver_uninstall();
+    stats.active = false;
+    esp_log_level_set("*", CONFIG_LOG_DEFAULT_LEVEL);
+    ESP_LOGI(TAG, "USB bridge stopped: %lu B to JanOS, %lu B to PC (%lu dropped)",
+             (unsigned long)stats.to_janos_bytes, (unsigned long)stats.to_pc_bytes,
+             (unsigned long)stats.to_pc_dropped);
+}
+
+bool usb_bridge_is_active(void)
+{
+    return bridge_running;
+}
+
+void usb_bridge_get_stats(usb_bridge_stats_t *out)
+{
+    if (!out) return;
+    *out = stats;
+}
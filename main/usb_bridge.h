@@ -0,0 +1,59 @@
+/**
+ * @file usb_bridge.h
+ * @brief Byte-for-byte bridge between the USB CDC port and JanOS
+ *
+ * While active, the ESP32-S3's native USB Serial/JTAG CDC port is spliced
+ * to the JanOS UART: bytes from the PC go straight to uart_write_raw(),
+ * and bytes from JanOS are copied to USB by a raw tap on the UART RX task
+ * before line splitting. Nothing is parsed or reframed on the way, so
+ * desktop tooling drives JanOS at the negotiated link speed; the local
+ * parsers keep receiving JanOS output, so screens stay live.
+ *
+ * Log output shares the USB CDC port (secondary console), so logging is
+ * silenced while the bridge runs.
+ */
+
+#ifndef USB_BRIDGE_H
+#define USB_BRIDGE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// USB driver ring buffers, each direction
+#define USB_BRIDGE_RING_SIZE    8192
+
+// PC -> JanOS read chunk and poll period (for noticing a stop request)
+#define USB_BRIDGE_CHUNK        512
+#define USB_BRIDGE_POLL_MS      20
+
+typedef struct {
+    bool active;
+    uint32_t to_janos_bytes;    // PC -> JanOS
+    uint32_t to_pc_bytes;       // JanOS -> PC
+    uint32_t to_pc_dropped;     // USB ring full (host not reading)
+    uint32_t to_janos_dropped;  // UART TX did not take everything
+} usb_bridge_stats_t;
+
+/**
+ * @brief Install the USB driver and start forwarding in both directions
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if already running, or the driver error
+ */
+esp_err_t usb_bridge_start(void);
+
+/**
+ * @brief Stop forwarding, release the USB driver and restore logging
+ */
+void usb_bridge_stop(void);
+
+/**
+ * @brief Check whether the bridge is running
+ */
+bool usb_bridge_is_active(void);
+
+/**
+ * @brief Snapshot byte counters (reset by each usb_bridge_start())
+ */
+void usb_bridge_get_stats(usb_bridge_stats_t *out);
+
+#endif // USB_BRIDGE_H
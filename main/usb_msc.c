@@ -0,0 +1,130 @@
+/**
+ * @file usb_msc.c
+ * @brief Export the SD card to a PC as a USB mass-storage drive
+ */
+
+#include "usb_msc.h"
+#include "usb_bridge.h"
+#include "screen_mirror.h"
+#include "screen_record.h"
+#include "screenshot.h"
+#include "session_log.h"
+#include "uart_transcript.h"
+#include "power.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "tinyusb.h"
+#include "tusb.h"
+#include "tusb_msc_storage.h"
+
+static const char *TAG = "USB_MSC";
+
+static bool msc_active = false;
+static uint64_t card_bytes = 0;
+
+/**
+ * @brief Refuse while USB is taken or something is writing to the card
+ */
+static esp_err_t check_idle(void)
+{
+    if (msc_active) return ESP_ERR_INVALID_STATE;
+    if (!screenshot_is_available()) {
+        ESP_LOGW(TAG, "No SD card");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (usb_bridge_is_active() || screen_mirror_is_active()) {
+        ESP_LOGW(TAG, "USB is in use by the bridge or the screen mirror");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (screen_record_is_active()) {
+        ESP_LOGW(TAG, "Screen recording in progress");
+        return ESP_ERR_INVALID_STATE;
+    }
+    uart_transcript_status_t transcript;
+    uart_transcript_get_status(&transcript);
+    if (transcript.recording || transcript.replaying) {
+        ESP_LOGW(TAG, "UART transcript in progress");
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
+
+esp_err_t usb_msc_start(void)
+{
+    esp_err_t ret = check_idle();
+    if (ret != ESP_OK) return ret;
+    
+    ret = session_log_pause(true);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Session log did not close its file");
+        session_log_pause(false);
+        return ret;
+    }
+    
+    // Wardrive logs and any other open sd_io file make this fail
+    sdmmc_card_t *card = NULL;
+    ret = screenshot_export_begin(&card);
+    if (ret != ESP_OK) {
+        session_log_pause(false);
+        return ret;
+    }
+    card_bytes = (uint64_t)card->csd.capacity * card->csd.sector_size;
+    
+    ESP_LOGI(TAG, "Exporting %llu MB over USB, logging paused",
+             (unsigned long long)(card_bytes / (1024 * 1024)));
+    
+    // Default descriptors (CONFIG_TINYUSB_DESC_*); takes the USB PHY
+    const tinyusb_config_t tusb_cfg = { 0 };
+    ret = tinyusb_driver_install(&tusb_cfg);
+    if (ret == ESP_OK) {
+        const tinyusb_msc_sdmmc_config_t msc_cfg = {
+            .card = card,
+        };
+        ret = tinyusb_msc_storage_init_sdmmc(&msc_cfg);
+        if (ret != ESP_OK) {
+            tinyusb_driver_uninstall();
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "TinyUSB MSC start failed: %s", esp_err_to_name(ret));
+        screenshot_export_end();
+        session_log_pause(false);
+        return ret;
+    }
+    
+    // The console went with the PHY; full speed for the sector traffic
+    esp_log_level_set("*", ESP_LOG_NONE);
+    power_acquire(POWER_LOCK_USB);
+    msc_active = true;
+    return ESP_OK;
+}
+
+void usb_msc_stop(void)
+{
+    if (!msc_active) return;
+    
+    tinyusb_msc_storage_deinit();
+    tinyusb_driver_uninstall();
+    msc_active = false;
+    power_release(POWER_LOCK_USB);
+    esp_log_level_set("*", CONFIG_LOG_DEFAULT_LEVEL);
+    
+    if (screenshot_export_end() == ESP_OK) {
+        session_log_pause(false);
+    }
+    ESP_LOGI(TAG, "USB export stopped");
+}
+
+bool usb_msc_is_active(void)
+{
+    return msc_active;
+}
+
+void usb_msc_get_status(usb_msc_status_t *out)
+{
+    if (!out) return;
+    
+    out->active = msc_active;
+    out->host_connected = msc_active && tud_mounted();
+    out->card_bytes = card_bytes;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file usb_msc.h
+ * @brief Export the SD card to a PC as a USB mass-storage drive
+ *
+ * While active, the card mounted by screenshot_init() is unmounted locally
+ * and its sectors are served over USB full-speed by TinyUSB's MSC class,
+ * so screenshots and logs come off without pulling the card. The session
+ * log pauses (records stay buffered) and anything else that writes to the
+ * card sees no card until the export stops and the volume is mounted again.
+ *
+ * The ESP32-S3 has one USB PHY: TinyUSB moves it from the Serial/JTAG
+ * controller to the OTG controller, so the USB console, the USB bridge and
+ * the screen mirror are unavailable while exporting, and logging is
+ * silenced. Eject the drive on the PC before stopping.
+ */
+
+#ifndef USB_MSC_H
+#define USB_MSC_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    bool active;
+    bool host_connected;        // Enumerated by a PC
+    uint64_t card_bytes;
+} usb_msc_status_t;
+
+/**
+ * @brief Unmount the card locally and present it on USB
+ * @return ESP_OK, ESP_ERR_INVALID_STATE when already running, without a
+ *         card, while USB or the card is in use elsewhere, or the driver error
+ */
+esp_err_t usb_msc_start(void);
+
+/**
+ * @brief Detach from USB, mount the card again and resume logging
+ */
+void usb_msc_stop(void);
+
+/**
+ * @brief Check whether the card is exported
+ */
+bool usb_msc_is_active(void);
+
+/**
+ * @brief Snapshot export state
+ */
+void usb_msc_get_status(usb_msc_status_t *out);
+
+#endif // USB_MSC_H
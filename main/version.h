@@ -0,0 +1,17 @@
+/**
+ * @file version.h
+ * @brief Firmware version and board name, for logs and reports
+ */
+
+#ifndef VERSION_H
+#define VERSION_H
+
+#define JANOS_ADV_VERSION "1.6.0"
+
+#ifdef BOARD_K132
+#define FIRMWARE_BOARD_NAME "K132"
+#else
+#define FIRMWARE_BOARD_NAME "ADV"
+#endif
+
+#endif // VERSION_H
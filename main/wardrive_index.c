@@ -0,0 +1,151 @@
+/**
+ * @file wardrive_index.c
+ * @brief Local unique-network counts for wardriving in bounded memory
+ */
+
+#include "wardrive_index.h"
+#include "mac_set.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "WARDRIVE_IDX";
+
+#ifdef CONFIG_SPIRAM
+#define BLOOM_CAPS      (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define BLOOM_CAPS      (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+#define BLOOM_BITS_MASK (WARDRIVE_INDEX_BLOOM_BYTES * 8u - 1)
+
+_Static_assert((WARDRIVE_INDEX_BLOOM_BYTES & (WARDRIVE_INDEX_BLOOM_BYTES - 1)) == 0,
+               "Bloom filter size must be a power of two");
+
+static mac_set_t exact_set;
+static uint8_t *bloom = NULL;
+static wardrive_index_stats_t stats;
+
+// Per-second buckets of first sightings for the rate window
+static uint16_t rate_count[WARDRIVE_INDEX_RATE_SECONDS];
+static uint32_t rate_second[WARDRIVE_INDEX_RATE_SECONDS];
+
+esp_err_t wardrive_index_init(void)
+{
+    wardrive_index_free();
+    
+    bloom = heap_caps_calloc(1, WARDRIVE_INDEX_BLOOM_BYTES, BLOOM_CAPS);
+    if (!bloom) bloom = calloc(1, WARDRIVE_INDEX_BLOOM_BYTES);
+    if (!bloom || mac_set_init(&exact_set, WARDRIVE_INDEX_EXACT) != ESP_OK) {
+        ESP_LOGW(TAG, "No memory for wardrive index");
+        wardrive_index_free();
+        return ESP_ERR_NO_MEM;
+    }
+    
+    memset(&stats, 0, sizeof(stats));
+    memset(rate_count, 0, sizeof(rate_count));
+    memset(rate_second, 0, sizeof(rate_second));
+    stats.exact = true;
+    return ESP_OK;
+}
+
+void wardrive_index_free(void)
+{
+    mac_set_free(&exact_set);
+    free(bloom);
+    bloom = NULL;
+}
+
+/**
+ * @brief Test and set the key's filter bits (double hashing)
+ * @return true if every bit was already set
+ */
+static bool bloom_test_and_set(uint64_t key)
+{
+    uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+    uint32_t h1 = (uint32_t)(h >> 32);
+    uint32_t h2 = (uint32_t)h | 1;
+    bool present = true;
+    
+    for (int i = 0; i < WARDRIVE_INDEX_BLOOM_HASHES; i++) {
+        uint32_t bit = (h1 + i * h2) & BLOOM_BITS_MASK;
+        uint8_t mask = 1u << (bit & 7);
+        if (!(bloom[bit >> 3] & mask)) {
+            present = false;
+            bloom[bit >> 3] |= mask;
+        }
+    }
+    return present;
+}
+
+/**
+ * @brief Security from the first bracket group of a JanOS auth field
+ */
+static wifi_security_t auth_security(const char *auth)
+{
+    char name[MAX_SECURITY_LEN];
+    const char *p = auth;
+    if (*p == '[') p++;
+    
+    size_t n = 0;
+    while (p[n] && p[n] != ']' && p[n] != ',' && n < sizeof(name) - 1) {
+        name[n] = p[n];
+        n++;
+    }
+    name[n] = '\0';
+    return network_security_from_name(name);
+}
+
+static void count_new(uint32_t now_s)
+{
+    int bucket = now_s % WARDRIVE_INDEX_RATE_SECONDS;
+    if (rate_second[bucket] != now_s) {
+        rate_second[bucket] = now_s;
+        rate_count[bucket] = 0;
+    }
+    if (rate_count[bucket] < UINT16_MAX) rate_count[bucket]++;
+}
+
+bool wardrive_index_add(const char *bssid, const char *auth, int channel)
+{
+    uint64_t key;
+    if (!bloom || !mac_set_key_from_mac(bssid, &key)) return false;
+    
+    stats.observations++;
+    bool in_exact = mac_set_find(&exact_set, key) >= 0;
+    bool in_bloom = bloom_test_and_set(key);
+    if (in_exact) return false;
+    
+    bool evicted_before = exact_set.evictions > 0;
+    bool is_new;
+    mac_set_add(&exact_set, key, &is_new);
+    
+    // Before the first eviction the exact set knows everything, so a
+    // filter hit is a false positive; afterwards the filter decides
+    if (evicted_before && in_bloom) return false;
+    
+    stats.unique++;
+    stats.by_band[channel > 14 ? WIFI_BAND_5G : (channel > 0 ? WIFI_BAND_2G : WIFI_BAND_UNKNOWN)]++;
+    stats.by_security[auth ? auth_security(auth) : WIFI_SECURITY_UNKNOWN]++;
+    count_new((uint32_t)(esp_timer_get_time() / 1000000));
+    return true;
+}
+
+void wardrive_index_get_stats(wardrive_index_stats_t *out)
+{
+    if (!out) return;
+    
+    *out = stats;
+    out->exact = exact_set.evictions == 0;
+    
+    uint32_t now_s = (uint32_t)(esp_timer_get_time() / 1000000);
+    out->new_last_minute = 0;
+    for (int i = 0; i < WARDRIVE_INDEX_RATE_SECONDS; i++) {
+        if (rate_count[i] && now_s - rate_second[i] < WARDRIVE_INDEX_RATE_SECONDS) {
+            out->new_last_minute += rate_count[i];
+        }
+    }
+}
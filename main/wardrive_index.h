@@ -0,0 +1,59 @@
+/**
+ * @file wardrive_index.h
+ * @brief Local unique-network counts for wardriving in bounded memory
+ *
+ * An exact BSSID set (mac_set) covers the most recently seen networks; a
+ * Bloom filter remembers every BSSID ever added. While the exact set has
+ * never evicted anything counts are exact, after that a network is new if
+ * neither structure knows it, so counts may fall short by the filter's
+ * false-positive rate (about 1% at 50 000 networks).
+ */
+
+#ifndef WARDRIVE_INDEX_H
+#define WARDRIVE_INDEX_H
+
+#include "network_store.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WARDRIVE_INDEX_EXACT        4096            // BSSIDs held exactly
+#define WARDRIVE_INDEX_BLOOM_BYTES  (64 * 1024)     // Filter size
+#define WARDRIVE_INDEX_BLOOM_HASHES 4
+#define WARDRIVE_INDEX_RATE_SECONDS 60              // "New in the last minute" window
+
+typedef struct {
+    bool exact;                     // No eviction yet, counts are exact
+    uint32_t unique;                // Distinct BSSIDs
+    uint32_t by_band[WIFI_BAND_COUNT];
+    uint32_t by_security[WIFI_SECURITY_COUNT];
+    uint32_t new_last_minute;
+    uint32_t observations;          // Lines added, including repeats
+} wardrive_index_stats_t;
+
+/**
+ * @brief Allocate the index (empty)
+ * @return ESP_OK, ESP_ERR_NO_MEM
+ */
+esp_err_t wardrive_index_init(void);
+
+/**
+ * @brief Release the index
+ */
+void wardrive_index_free(void);
+
+/**
+ * @brief Add an observation
+ * @param bssid "AA:BB:CC:DD:EE:FF"
+ * @param auth JanOS auth field, e.g. "[WPA2_PSK][ESS]"
+ * @param channel WiFi channel (band is taken from it)
+ * @return true if the network was not seen before
+ */
+bool wardrive_index_add(const char *bssid, const char *auth, int channel);
+
+/**
+ * @brief Snapshot the counters
+ */
+void wardrive_index_get_stats(wardrive_index_stats_t *out);
+
+#endif // WARDRIVE_INDEX_H
@@ -0,0 +1,434 @@
+/**
+ * @file wardrive_log.c
+ * @brief Compact columnar log of wardrive observations on SD
+ *
+ * Rows are collected on the UART RX task; a full block is encoded there
+ * (a few KB of arithmetic) and handed to a writer task so the card write
+ * never stalls RX.
+ */
+
+#include "wardrive_log.h"
+#include "mac_set.h"
+#include "screenshot.h"
+#include "sd_io.h"
+#include "task_plan.h"
+#include "time_sync.h"
+#include "mem_monitor.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+static const char *TAG = "WARDRIVE_LOG";
+
+// Worst case: every row defines a BSSID and SSID, plus all columns at max width
+#define BLOCK_BUFFER_SIZE   (WARDRIVE_LOG_BLOCK_HEADER + 3 * 5 + \
+                             WARDRIVE_LOG_BLOCK_ROWS * (3 + 6) + \
+                             WARDRIVE_LOG_BLOCK_ROWS * (3 + 1 + WARDRIVE_LOG_SSID_MAX_LEN) + \
+                             WARDRIVE_LOG_AUTH_SLOTS * (1 + 1 + WARDRIVE_LOG_AUTH_MAX_LEN) + \
+                             WARDRIVE_LOG_BLOCK_ROWS * (5 * 5 + 3 * 3 + 2))
+
+#define WRITER_QUEUE_LEN    4
+
+typedef struct {
+    uint32_t time;
+    int32_t lat;
+    int32_t lon;
+    int32_t alt;
+    uint32_t acc;
+    uint16_t bssid;
+    uint16_t ssid;
+    uint8_t auth;
+    uint8_t channel;
+    int8_t rssi;
+} row_t;
+
+typedef struct {
+    uint16_t slot;
+    uint8_t mac[6];
+} bssid_define_t;
+
+typedef struct {
+    uint16_t slot;
+    uint8_t len;
+    char text[WARDRIVE_LOG_SSID_MAX_LEN];
+} string_define_t;
+
+typedef struct {
+    mac_set_t bssids;
+    mac_set_t ssids;
+    char auth[WARDRIVE_LOG_AUTH_SLOTS][WARDRIVE_LOG_AUTH_MAX_LEN];
+    int auth_count;
+    int auth_next;              // Round-robin replacement once full
+
+    row_t rows[WARDRIVE_LOG_BLOCK_ROWS];
+    int row_count;
+    bssid_define_t bssid_defs[WARDRIVE_LOG_BLOCK_ROWS];
+    int bssid_def_count;
+    string_define_t ssid_defs[WARDRIVE_LOG_BLOCK_ROWS];
+    int ssid_def_count;
+    string_define_t auth_defs[WARDRIVE_LOG_AUTH_SLOTS];
+    int auth_def_count;
+} log_state_t;
+
+// Queue item: encoded block, or NULL to close the file
+typedef struct {
+    uint8_t *data;
+    size_t len;
+} block_item_t;
+
+static log_state_t *state = NULL;
+static QueueHandle_t writer_queue = NULL;
+static int32_t state_mem_bytes = 0;          // Attributed to MEM_SUB_LOGGER while open
+static volatile uint32_t observation_count = 0;
+
+static uint8_t *put_varint(uint8_t *p, uint32_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static uint8_t *put_svarint(uint8_t *p, int32_t v)
+{
+    return put_varint(p, ((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+}
+
+/**
+ * @brief "YYYY-MM-DD HH:MM:SS" as Unix seconds, 0 if malformed
+ */
+static uint32_t parse_timestamp(const char *s)
+{
+    int y, mo, d, h, mi, sec;
+    if (sscanf(s, "%d-%d-%d %d:%d:%d", &y, &mo, &d, &h, &mi, &sec) != 6) return 0;
+    if (y < 1970 || mo < 1 || mo > 12 || d < 1 || d > 31) return 0;
+
+    int64_t days = time_sync_days_from_civil(y, mo, d);
+    return (uint32_t)(days * 86400 + h * 3600 + mi * 60 + sec);
+}
+
+static void writer_task(void *arg)
+{
+    sd_file_t *f = arg;
+    block_item_t item;
+    bool unsynced = false;
+
+    while (1) {
+        if (xQueueReceive(writer_queue, &item, pdMS_TO_TICKS(WARDRIVE_LOG_SYNC_MS)) != pdTRUE) {
+            // Quiet spell: commit the partial chunk
+            if (f && unsynced) sd_io_sync(f);
+            unsynced = false;
+            continue;
+        }
+        if (!item.data) break;
+        if (f && sd_io_write(f, item.data, item.len) != ESP_OK) {
+            ESP_LOGE(TAG, "Write failed, log closed");
+            sd_io_close(f);
+            f = NULL;
+        }
+        unsynced = true;
+        mem_free(MEM_SUB_LOGGER, item.data);
+    }
+
+    if (f) sd_io_close(f);
+    vQueueDelete(writer_queue);
+    writer_queue = NULL;
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Encode buffered rows into one block and queue it for writing
+ */
+static void flush_block(void)
+{
+    log_state_t *s = state;
+    if (s->row_count == 0) return;
+
+    uint8_t *buf = mem_malloc(MEM_SUB_LOGGER, BLOCK_BUFFER_SIZE);
+    if (!buf) {
+        ESP_LOGW(TAG, "No memory for block, %d rows lost", s->row_count);
+        goto reset;
+    }
+
+    uint8_t *p = buf + WARDRIVE_LOG_BLOCK_HEADER;
+    p = put_varint(p, s->bssid_def_count);
+    for (int i = 0; i < s->bssid_def_count; i++) {
+        p = put_varint(p, s->bssid_defs[i].slot);
+        memcpy(p, s->bssid_defs[i].mac, 6);
+        p += 6;
+    }
+    p = put_varint(p, s->ssid_def_count);
+    for (int i = 0; i < s->ssid_def_count; i++) {
+        p = put_varint(p, s->ssid_defs[i].slot);
+        *p++ = s->ssid_defs[i].len;
+        memcpy(p, s->ssid_defs[i].text, s->ssid_defs[i].len);
+        p += s->ssid_defs[i].len;
+    }
+    p = put_varint(p, s->auth_def_count);
+    for (int i = 0; i < s->auth_def_count; i++) {
+        p = put_varint(p, s->auth_defs[i].slot);
+        *p++ = s->auth_defs[i].len;
+        memcpy(p, s->auth_defs[i].text, s->auth_defs[i].len);
+        p += s->auth_defs[i].len;
+    }
+
+    // One column at a time: neighbouring deltas are alike and stay short
+    const row_t *r = s->rows;
+    int n = s->row_count;
+    for (int i = 0; i < n; i++) p = put_svarint(p, (int32_t)(r[i].time - (i ? r[i - 1].time : 0)));
+    for (int i = 0; i < n; i++) p = put_svarint(p, r[i].lat - (i ? r[i - 1].lat : 0));
+    for (int i = 0; i < n; i++) p = put_svarint(p, r[i].lon - (i ? r[i - 1].lon : 0));
+    for (int i = 0; i < n; i++) p = put_svarint(p, r[i].alt - (i ? r[i - 1].alt : 0));
+    for (int i = 0; i < n; i++) p = put_varint(p, r[i].acc);
+    for (int i = 0; i < n; i++) p = put_varint(p, r[i].bssid);
+    for (int i = 0; i < n; i++) p = put_varint(p, r[i].ssid);
+    for (int i = 0; i < n; i++) p = put_varint(p, r[i].auth);
+    for (int i = 0; i < n; i++) *p++ = r[i].channel;
+    for (int i = 0; i < n; i++) *p++ = (uint8_t)r[i].rssi;
+
+    uint32_t payload = (uint32_t)(p - buf) - WARDRIVE_LOG_BLOCK_HEADER;
+    buf[0] = WARDRIVE_LOG_BLOCK_MARKER;
+    buf[1] = n & 0xFF;
+    buf[2] = n >> 8;
+    buf[3] = payload & 0xFF;
+    buf[4] = (payload >> 8) & 0xFF;
+    buf[5] = (payload >> 16) & 0xFF;
+    buf[6] = payload >> 24;
+
+    block_item_t item = { .data = buf, .len = payload + WARDRIVE_LOG_BLOCK_HEADER };
+    if (!writer_queue || xQueueSend(writer_queue, &item, pdMS_TO_TICKS(100)) != pdTRUE) {
+        ESP_LOGW(TAG, "Writer behind, %d rows lost", n);
+        mem_free(MEM_SUB_LOGGER, buf);
+    }
+
+reset:
+    s->row_count = 0;
+    s->bssid_def_count = 0;
+    s->ssid_def_count = 0;
+    s->auth_def_count = 0;
+}
+
+static int auth_slot(log_state_t *s, const char *auth, size_t len)
+{
+    if (len >= WARDRIVE_LOG_AUTH_MAX_LEN) len = WARDRIVE_LOG_AUTH_MAX_LEN - 1;
+    for (int i = 0; i < s->auth_count; i++) {
+        if (strncmp(s->auth[i], auth, len) == 0 && s->auth[i][len] == '\0') return i;
+    }
+
+    // Only a handful of auth modes exist, so replacing one still in use
+    // by the current block is not a practical concern
+    int slot;
+    if (s->auth_count < WARDRIVE_LOG_AUTH_SLOTS) {
+        slot = s->auth_count++;
+    } else {
+        slot = s->auth_next;
+        s->auth_next = (s->auth_next + 1) % WARDRIVE_LOG_AUTH_SLOTS;
+    }
+    memcpy(s->auth[slot], auth, len);
+    s->auth[slot][len] = '\0';
+
+    string_define_t *def = &s->auth_defs[s->auth_def_count++];
+    def->slot = slot;
+    def->len = len;
+    memcpy(def->text, auth, len);
+    return slot;
+}
+
+static int32_t fixed_point(const char *s, double scale)
+{
+    return (int32_t)lround(strtod(s, NULL) * scale);
+}
+
+bool wardrive_log_add_line(const char *line)
+{
+    log_state_t *s = state;
+    if (!s) return false;
+
+    uint64_t bssid_key;
+    if (strlen(line) < 19 || line[17] != ',' || !mac_set_key_from_mac(line, &bssid_key)) {
+        return false;
+    }
+
+    // SSIDs may contain commas, so take the nine trailing fields from the right
+    const char *fields[9];
+    const char *end = line + strlen(line);
+    const char *p = end;
+    for (int i = 8; i >= 0; i--) {
+        while (p > line + 17 && *(p - 1) != ',') p--;
+        if (p <= line + 18) return false;
+        fields[i] = p;      // 0 = auth ... 8 = type
+        p--;
+    }
+    const char *ssid = line + 18;
+    size_t ssid_len = (fields[0] - 1) - ssid;
+    size_t auth_len = (fields[1] - 1) - fields[0];
+    if (ssid_len > WARDRIVE_LOG_SSID_MAX_LEN) ssid_len = WARDRIVE_LOG_SSID_MAX_LEN;
+
+    // A define must land in a block before the row that uses it
+    if (s->row_count == WARDRIVE_LOG_BLOCK_ROWS ||
+        s->auth_def_count == WARDRIVE_LOG_AUTH_SLOTS) {
+        flush_block();
+    }
+
+    row_t *row = &s->rows[s->row_count];
+    bool is_new;
+    int slot = mac_set_add(&s->bssids, bssid_key, &is_new);
+    if (slot < 0) return false;
+    row->bssid = slot;
+    if (is_new) {
+        bssid_define_t *def = &s->bssid_defs[s->bssid_def_count++];
+        def->slot = slot;
+        for (int i = 0; i < 6; i++) {
+            def->mac[i] = (uint8_t)((bssid_key >> (40 - 8 * i)) & 0xFF);
+        }
+    }
+
+    char ssid_text[WARDRIVE_LOG_SSID_MAX_LEN + 1];
+    memcpy(ssid_text, ssid, ssid_len);
+    ssid_text[ssid_len] = '\0';
+    slot = mac_set_add(&s->ssids, mac_set_key_from_string(ssid_text), &is_new);
+    if (slot < 0) return false;
+    row->ssid = slot;
+    if (is_new) {
+        string_define_t *def = &s->ssid_defs[s->ssid_def_count++];
+        def->slot = slot;
+        def->len = ssid_len;
+        memcpy(def->text, ssid, ssid_len);
+    }
+
+    row->auth = auth_slot(s, fields[0], auth_len);
+    row->time = parse_timestamp(fields[1]);
+    if (row->time == 0) {
+        row->time = (uint32_t)(esp_timer_get_time() / 1000000);
+    }
+    row->channel = (uint8_t)atoi(fields[2]);
+    row->rssi = (int8_t)atoi(fields[3]);
+    row->lat = fixed_point(fields[4], 1e7);
+    row->lon = fixed_point(fields[5], 1e7);
+    row->alt = fixed_point(fields[6], 10.0);
+    int32_t acc = fixed_point(fields[7], 10.0);
+    row->acc = acc > 0 ? (uint32_t)acc : 0;
+
+    s->row_count++;
+    observation_count++;
+    return true;
+}
+
+/**
+ * @brief Highest N among wd_N.mwd files, 0 if none
+ */
+static int latest_log_number(void)
+{
+    DIR *dir = opendir(WARDRIVE_LOG_DIR);
+    if (!dir) return 0;
+
+    int max_num = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int num;
+        if (sscanf(entry->d_name, "wd_%d.mwd", &num) == 1 && num > max_num) {
+            max_num = num;
+        }
+    }
+    closedir(dir);
+    return max_num;
+}
+
+esp_err_t wardrive_log_open(void)
+{
+    if (state || writer_queue) return ESP_ERR_INVALID_STATE;
+    if (!screenshot_is_available()) {
+        ESP_LOGW(TAG, "SD card not mounted, wardrive log disabled");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t mem_token = mem_scope_begin();
+    log_state_t *s = calloc(1, sizeof(log_state_t));
+    if (!s) return ESP_ERR_NO_MEM;
+    if (mac_set_init(&s->bssids, WARDRIVE_LOG_BSSID_SLOTS) != ESP_OK ||
+        mac_set_init(&s->ssids, WARDRIVE_LOG_SSID_SLOTS) != ESP_OK) {
+        mac_set_free(&s->bssids);
+        free(s);
+        return ESP_ERR_NO_MEM;
+    }
+
+    struct stat st;
+    if (stat(WARDRIVE_LOG_DIR, &st) != 0) {
+        mkdir(WARDRIVE_LOG_DIR, 0755);
+    }
+    char path[48];
+    snprintf(path, sizeof(path), "%s/wd_%d.mwd", WARDRIVE_LOG_DIR, latest_log_number() + 1);
+    // Not preallocated: a file cut short by power loss must end on a block,
+    // not on an unwritten extent that a reader would try to parse
+    sd_file_t *f = sd_io_open(path, 0);
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        goto fail;
+    }
+    uint8_t header[WARDRIVE_LOG_HEADER_SIZE] = {
+        'M', 'W', 'D', '1', WARDRIVE_LOG_VERSION,
+        WARDRIVE_LOG_BSSID_SLOTS & 0xFF, WARDRIVE_LOG_BSSID_SLOTS >> 8,
+        WARDRIVE_LOG_SSID_SLOTS & 0xFF, WARDRIVE_LOG_SSID_SLOTS >> 8,
+        WARDRIVE_LOG_AUTH_SLOTS,
+    };
+    sd_io_write(f, header, sizeof(header));
+
+    writer_queue = xQueueCreate(WRITER_QUEUE_LEN, sizeof(block_item_t));
+    if (!writer_queue ||
+        xTaskCreatePinnedToCore(writer_task, "wardrive_log", TASK_WARDRIVE_LOG_STACK, f,
+                                TASK_LOG_WRITER_PRIO, NULL, TASK_LOG_WRITER_CORE) != pdPASS) {
+        if (writer_queue) vQueueDelete(writer_queue);
+        writer_queue = NULL;
+        sd_io_close(f);
+        goto fail;
+    }
+
+    observation_count = 0;
+    state_mem_bytes = mem_scope_end(MEM_SUB_LOGGER, mem_token);
+    state = s;
+    ESP_LOGI(TAG, "Logging wardrive to %s", path);
+    return ESP_OK;
+
+fail:
+    mac_set_free(&s->bssids);
+    mac_set_free(&s->ssids);
+    free(s);
+    return ESP_FAIL;
+}
+
+void wardrive_log_close(void)
+{
+    log_state_t *s = state;
+    if (!s) return;
+
+    flush_block();
+    state = NULL;
+
+    block_item_t close_item = { 0 };
+    if (writer_queue) {
+        xQueueSend(writer_queue, &close_item, portMAX_DELAY);
+    }
+    ESP_LOGI(TAG, "Wardrive log closed, %lu observations",
+             (unsigned long)observation_count);
+
+    mac_set_free(&s->bssids);
+    mac_set_free(&s->ssids);
+    free(s);
+    mem_monitor_account(MEM_SUB_LOGGER, -state_mem_bytes);
+    state_mem_bytes = 0;
+}
+
+uint32_t wardrive_log_count(void)
+{
+    return observation_count;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file wardrive_log.h
+ * @brief Compact columnar log of wardrive observations on SD
+ *
+ * Observations are buffered in RAM and written in blocks of up to
+ * WARDRIVE_LOG_BLOCK_ROWS rows, each column stored separately so the
+ * delta-encoded values stay small. tools/mwd_to_wigle.py streams a file
+ * block by block into WiGLE CSV.
+ *
+ * File /sdcard/wardrive/wd_N.mwd (little-endian):
+ *
+ *   header  "MWD1", u8 version, u16 bssid_slots, u16 ssid_slots, u8 auth_slots
+ *   block   u8 0xB1, u16 rows, u32 payload_len, payload
+ *
+ * Payload, in order (varint = unsigned LEB128, svarint = zigzag varint):
+ *
+ *   BSSID defines  varint n, n x (varint slot, 6 bytes)
+ *   SSID defines   varint n, n x (varint slot, u8 len, bytes)
+ *   auth defines   varint n, n x (varint slot, u8 len, bytes)
+ *   columns        rows values each:
+ *     time         svarint delta, Unix seconds (first row from 0)
+ *     lat, lon     svarint delta, degrees x 1e7
+ *     alt          svarint delta, decimetres
+ *     accuracy     varint, decimetres
+ *     bssid, ssid  varint dictionary slot
+ *     auth         varint dictionary slot
+ *     channel      u8
+ *     rssi         i8
+ *
+ * Dictionaries are per file and keep the most recently seen values; a
+ * define replaces whatever the slot held before and applies to the block
+ * it appears in and all later ones. Blocks are self-contained apart from
+ * the dictionaries, so a reader can skip blocks by payload_len.
+ */
+
+#ifndef WARDRIVE_LOG_H
+#define WARDRIVE_LOG_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WARDRIVE_LOG_DIR            "/sdcard/wardrive"
+#define WARDRIVE_LOG_BLOCK_ROWS     256
+#define WARDRIVE_LOG_BSSID_SLOTS    4096    // Must exceed BLOCK_ROWS
+#define WARDRIVE_LOG_SSID_SLOTS     2048    // Must exceed BLOCK_ROWS
+#define WARDRIVE_LOG_AUTH_SLOTS     32
+#define WARDRIVE_LOG_SYNC_MS        5000    // Longest a written block waits for the card
+
+// File layout, for readers (obs_export)
+#define WARDRIVE_LOG_MAGIC          "MWD1"
+#define WARDRIVE_LOG_VERSION        1
+#define WARDRIVE_LOG_HEADER_SIZE    10
+#define WARDRIVE_LOG_BLOCK_MARKER   0xB1
+#define WARDRIVE_LOG_BLOCK_HEADER   7
+#define WARDRIVE_LOG_AUTH_MAX_LEN   24      // Terminator included
+#define WARDRIVE_LOG_SSID_MAX_LEN   32
+
+/**
+ * @brief Open the next wd_N.mwd
+ * @return ESP_OK, ESP_ERR_INVALID_STATE without SD card or if already open
+ */
+esp_err_t wardrive_log_open(void);
+
+/**
+ * @brief Add one JanOS wardrive CSV line
+ *
+ * Format: MAC,SSID,[AUTH],YYYY-MM-DD HH:MM:SS,ch,rssi,lat,lon,alt,acc,WIFI
+ * @return true if the line was an observation and was logged
+ */
+bool wardrive_log_add_line(const char *line);
+
+/**
+ * @brief Write buffered rows and close the file
+ */
+void wardrive_log_close(void);
+
+/**
+ * @brief Observations logged since wardrive_log_open
+ */
+uint32_t wardrive_log_count(void);
+
+#endif // WARDRIVE_LOG_H
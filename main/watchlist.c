@@ -0,0 +1,308 @@
+/**
+ * @file watchlist.c
+ * @brief Alerts when a received line names a watched BSSID, MAC or SSID
+ */
+
+#include "watchlist.h"
+#include "event_bus.h"
+#include "mac_set.h"
+#include "mem_monitor.h"
+#include "screen_manager.h"
+#include "buzzer.h"
+#include "text_ui.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+static const char *TAG = "WATCHLIST";
+
+#ifdef CONFIG_SPIRAM
+#define WATCH_CAPS      (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define WATCH_CAPS      (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+#define MAC_TEXT_LEN    17
+
+typedef struct {
+    char pattern[MAX_SSID_LEN];
+    bool is_mac;
+    uint32_t alerted_ms;        // Last hit published, 0 = never
+} entry_t;
+
+// Trie node; 0 is the root, which is never anyone's child or suffix
+typedef struct {
+    uint16_t first_edge;        // Edge index + 1, 0 = leaf
+    uint16_t fail;              // Longest proper suffix that is a trie node
+    uint16_t dict;              // Nearest suffix node ending an entry, 0 = none
+    uint16_t output;            // Entry index + 1 ending here, 0 = none
+} node_t;
+
+typedef struct {
+    uint16_t target;
+    uint16_t sibling;           // Next edge of the same node + 1, 0 = last
+    uint8_t ch;
+} edge_t;
+
+MEM_BUDGET(watchlist, WATCHLIST_MAX, sizeof(entry_t) + 2 * sizeof(uint16_t), MEM_BUDGET_PSRAM);
+
+static entry_t *entries = NULL;
+static int entry_count = 0;
+
+static node_t *nodes = NULL;
+static edge_t *edges = NULL;
+static int node_count = 0;
+static int edge_count = 0;
+static uint16_t root_next[256];             // Dense root row: most bytes stop here
+
+static mac_set_t mac_index;                 // MAC key -> mac_entry[] index
+static uint16_t *mac_entry = NULL;          // Entry index per MAC set index
+static int mac_count = 0;
+
+static volatile bool ready = false;         // Matchers built; never changes after
+static volatile uint32_t hit_count = 0;
+static int bus_sub = -1;
+
+static void *watch_alloc(size_t size)
+{
+    void *p = heap_caps_calloc(1, size, WATCH_CAPS);
+    return p ? p : calloc(1, size);
+}
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static uint16_t child(int node, uint8_t ch)
+{
+    for (int e = nodes[node].first_edge; e; e = edges[e - 1].sibling) {
+        if (edges[e - 1].ch == ch) return edges[e - 1].target;
+    }
+    return 0;
+}
+
+static void add_text(const char *text, int entry)
+{
+    int node = 0;
+    for (const uint8_t *p = (const uint8_t *)text; *p; p++) {
+        uint16_t next = child(node, *p);
+        if (!next) {
+            next = (uint16_t)node_count++;
+            edge_t *e = &edges[edge_count++];
+            e->target = next;
+            e->ch = *p;
+            e->sibling = nodes[node].first_edge;
+            nodes[node].first_edge = (uint16_t)edge_count;
+        }
+        node = next;
+    }
+    // Repeats of an entry keep the first
+    if (!nodes[node].output) nodes[node].output = (uint16_t)(entry + 1);
+}
+
+/**
+ * @brief Fill in suffix links breadth-first and the dense root row
+ */
+static esp_err_t link_trie(void)
+{
+    uint16_t *queue = malloc(node_count * sizeof(uint16_t));
+    if (!queue) return ESP_ERR_NO_MEM;
+
+    int head = 0, tail = 0;
+    for (int e = nodes[0].first_edge; e; e = edges[e - 1].sibling) {
+        root_next[edges[e - 1].ch] = edges[e - 1].target;
+        queue[tail++] = edges[e - 1].target;
+    }
+
+    while (head < tail) {
+        int node = queue[head++];
+        for (int e = nodes[node].first_edge; e; e = edges[e - 1].sibling) {
+            uint8_t ch = edges[e - 1].ch;
+            int next = edges[e - 1].target;
+
+            int f = nodes[node].fail;
+            uint16_t to = 0;
+            while (f && !(to = child(f, ch))) f = nodes[f].fail;
+            if (!f) to = root_next[ch];
+
+            node_t *n = &nodes[next];
+            n->fail = (to != next) ? to : 0;
+            n->dict = nodes[n->fail].output ? n->fail : nodes[n->fail].dict;
+            queue[tail++] = (uint16_t)next;
+        }
+    }
+    free(queue);
+    return ESP_OK;
+}
+
+static void trim(char *text)
+{
+    size_t len = strlen(text);
+    while (len > 0 && isspace((unsigned char)text[len - 1])) text[--len] = '\0';
+}
+
+/**
+ * @brief Read the file into entries[], MACs straight into the set
+ * @return Bytes of text entries
+ */
+static int read_entries(FILE *f)
+{
+    int text_bytes = 0;
+    char line[96];
+    while (fgets(line, sizeof(line), f) && entry_count < WATCHLIST_MAX) {
+        char *text = line;
+        while (isspace((unsigned char)*text)) text++;
+        trim(text);
+        if (!text[0] || text[0] == '#') continue;
+
+        entry_t *entry = &entries[entry_count];
+        uint64_t key;
+        if (strlen(text) == MAC_TEXT_LEN && mac_set_key_from_mac(text, &key)) {
+            bool is_new;
+            int index = mac_set_add(&mac_index, key, &is_new);
+            if (index < 0 || !is_new) continue;
+            mac_entry[index] = (uint16_t)entry_count;
+            entry->is_mac = true;
+            mac_count++;
+        } else {
+            text_bytes += strnlen(text, MAX_SSID_LEN - 1);
+        }
+        strlcpy(entry->pattern, text, sizeof(entry->pattern));
+        entry_count++;
+    }
+    return text_bytes;
+}
+
+esp_err_t watchlist_load(void)
+{
+    if (entries) return ESP_ERR_INVALID_STATE;
+
+    FILE *f = fopen(WATCHLIST_FILE, "r");
+    if (!f) {
+        ESP_LOGI(TAG, "No %s, watchlist off", WATCHLIST_FILE);
+        return ESP_OK;
+    }
+
+    entries = watch_alloc(WATCHLIST_MAX * sizeof(entry_t));
+    mac_entry = watch_alloc(WATCHLIST_MAX * sizeof(uint16_t));
+    if (!entries || !mac_entry || mac_set_init(&mac_index, WATCHLIST_MAX) != ESP_OK) {
+        fclose(f);
+        ESP_LOGE(TAG, "No memory for %d entries", WATCHLIST_MAX);
+        return ESP_ERR_NO_MEM;
+    }
+    int text_bytes = read_entries(f);
+    fclose(f);
+
+    nodes = watch_alloc((text_bytes + 1) * sizeof(node_t));
+    edges = watch_alloc((text_bytes + 1) * sizeof(edge_t));
+    if (!nodes || !edges) {
+        ESP_LOGE(TAG, "No memory for %d bytes of text entries", text_bytes);
+        return ESP_ERR_NO_MEM;
+    }
+    node_count = 1;
+    for (int i = 0; i < entry_count; i++) {
+        if (!entries[i].is_mac) add_text(entries[i].pattern, i);
+    }
+    if (link_trie() != ESP_OK) return ESP_ERR_NO_MEM;
+
+    if (entry_count > 0) {
+        bus_sub = event_bus_subscribe(BUS_EVENT_BIT(BUS_EVENT_WATCHLIST_HIT),
+                                      WATCHLIST_BUS_DEPTH, "watchlist");
+    }
+    ready = true;
+    ESP_LOGI(TAG, "Watching %d MACs and %d texts (%d trie nodes)",
+             mac_count, entry_count - mac_count, node_count);
+    return ESP_OK;
+}
+
+/**
+ * @brief Publish a hit unless the entry alerted recently (RX task)
+ */
+static void report(int index)
+{
+    entry_t *entry = &entries[index];
+    uint32_t now = now_ms();
+    if (entry->alerted_ms && now - entry->alerted_ms < WATCHLIST_REALERT_MS) return;
+    entry->alerted_ms = now ? now : 1;
+
+    bus_event_t event = { .type = BUS_EVENT_WATCHLIST_HIT };
+    event.watch.entry = (uint16_t)index;
+    event.watch.is_mac = entry->is_mac;
+    strlcpy(event.watch.pattern, entry->pattern, sizeof(event.watch.pattern));
+    event_bus_publish(&event);
+    hit_count++;
+}
+
+static bool is_hex(char c)
+{
+    return isxdigit((unsigned char)c) != 0;
+}
+
+void watchlist_check_line(const char *line)
+{
+    if (!ready || !line) return;
+
+    int state = 0;
+    for (const uint8_t *p = (const uint8_t *)line; *p; p++) {
+        // Text entries: follow suffix links until a node continues with *p
+        if (node_count > 1) {
+            while (1) {
+                uint16_t next = state ? child(state, *p) : root_next[*p];
+                if (next || !state) {
+                    state = next;
+                    break;
+                }
+                state = nodes[state].fail;
+            }
+            int out = nodes[state].output ? state : nodes[state].dict;
+            for (; out; out = nodes[out].dict) {
+                report(nodes[out].output - 1);
+            }
+        }
+
+        // MAC entries: look up anything shaped "xx:xx:xx:xx:xx:xx"
+        if (mac_count > 0 && is_hex(p[0]) && is_hex(p[1]) && (p[2] == ':' || p[2] == '-') &&
+            ((const char *)p == line || !is_hex(p[-1]))) {
+            uint64_t key;
+            if (mac_set_key_from_mac((const char *)p, &key)) {
+                int index = mac_set_find(&mac_index, key);
+                if (index >= 0) report(mac_entry[index]);
+            }
+        }
+    }
+}
+
+void watchlist_service(void)
+{
+    static const buzzer_tone_t alert[] = {
+        { 2400, 80 }, { 0, 40 }, { 2400, 80 }, { 0, 40 }, { 3200, 160 },
+    };
+
+    bus_event_t event;
+    bool any = false;
+    char text[UI_COLS_MAX + 1];
+    while (bus_sub >= 0 && event_bus_receive(bus_sub, &event, 0)) {
+        snprintf(text, sizeof(text), "WATCH %s", event.watch.pattern);
+        ESP_LOGW(TAG, "Watchlist hit: %s", event.watch.pattern);
+        any = true;
+    }
+    if (any) {
+        buzzer_play(alert, sizeof(alert) / sizeof(alert[0]));
+        screen_manager_show_banner(text, WATCHLIST_BANNER_MS);
+    }
+}
+
+int watchlist_count(void)
+{
+    return entry_count;
+}
+
+uint32_t watchlist_hits(void)
+{
+    return hit_count;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file watchlist.h
+ * @brief Alerts when a received line names a watched BSSID, MAC or SSID
+ *
+ * WATCHLIST_FILE holds one entry per line; lines starting with '#' are
+ * comments. An entry that parses as a MAC goes into a hash set (mac_set);
+ * anything else is matched as text anywhere in a line, through one
+ * Aho-Corasick automaton built from all text entries. Each received line is scanned
+ * once for both, so hundreds of entries cost about what a single strstr
+ * did: one table step per byte plus a hash lookup per MAC-shaped token.
+ *
+ * A hit is published on the event bus (BUS_EVENT_WATCHLIST_HIT), at most
+ * once per entry every WATCHLIST_REALERT_MS; watchlist_service() turns
+ * hits into a beep and a banner, and the session log records them.
+ *
+ * The list is loaded once, after the SD card is mounted. Lines are
+ * checked on the UART RX task.
+ */
+
+#ifndef WATCHLIST_H
+#define WATCHLIST_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define WATCHLIST_FILE          "/sdcard/watchlist.txt"
+
+#ifdef CONFIG_WATCHLIST_MAX_ENTRIES
+#define WATCHLIST_MAX           CONFIG_WATCHLIST_MAX_ENTRIES
+#else
+#define WATCHLIST_MAX           256
+#endif
+#define WATCHLIST_REALERT_MS    60000           // Quiet time per entry after a hit
+#define WATCHLIST_BANNER_MS     4000
+#define WATCHLIST_BUS_DEPTH     4               // Hits waiting for watchlist_service()
+
+/**
+ * @brief Read WATCHLIST_FILE and build the matchers (once, SD mounted)
+ * @return ESP_OK (also for a missing or empty file), ESP_ERR_NO_MEM,
+ *         ESP_ERR_INVALID_STATE if already loaded
+ */
+esp_err_t watchlist_load(void);
+
+/**
+ * @brief Scan a received line and publish any hits (UART RX task)
+ */
+void watchlist_check_line(const char *line);
+
+/**
+ * @brief Beep and show a banner for hits published since the last call
+ *
+ * Called from the main loop with the UI lock held.
+ */
+void watchlist_service(void);
+
+/**
+ * @brief Entries loaded (MAC and text)
+ */
+int watchlist_count(void);
+
+/**
+ * @brief Hits published since boot
+ */
+uint32_t watchlist_hits(void);
+
+#endif // WATCHLIST_H
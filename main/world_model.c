@@ -0,0 +1,524 @@
+/**
+ * @file world_model.c
+ * @brief JanOS output parsed once, whatever screen is showing
+ */
+
+#include "world_model.h"
+#include "event_bus.h"
+#include "bt_store.h"
+#include "probe_store.h"
+#include "station_store.h"
+#include "capture_index.h"
+#include "remote_dir.h"
+#include "handshakes_screen.h"
+#include "mac_set.h"
+#include "janos_proto.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "WORLD";
+
+#define PROBE_HEADER        "Probe requests: "
+#define SNIFFER_MARKER      "Sniffer packet count: "
+#define GPS_MARKER          "GPS fix "
+
+static volatile uint32_t generation = 0;
+static volatile uint32_t bt_passes = 0;
+static volatile uint32_t probe_listings = 0;
+static volatile int probe_total = 0;
+static int sniffer_packets[UART_LINK_COUNT];   // Latest report per board
+static uint32_t sniffer_seq = 0;
+static int tag_airtags = -1;
+static int tag_smarttags = -1;
+
+// Latest client count per sniffer AP ("SSID, CHn" key), and their sums
+typedef struct {
+    uint8_t channel;                    // 0 = entry unused
+    uint16_t clients;
+} sniffer_ap_count_t;
+
+static mac_set_t sniffer_ap_index;
+static sniffer_ap_count_t *sniffer_aps = NULL;
+static uint16_t channel_clients[256];
+
+// Deauth detector reports per attacked BSSID
+static mac_set_t deauth_index;
+static world_deauth_t *deauths = NULL;
+
+// Captures per AP (BSSID tail, or SSID hash when JanOS gives none)
+static mac_set_t capture_ap_index;
+static world_capture_ap_t *capture_aps = NULL;
+
+#define VERIFIED_PAIRS      0x3C        // message_pair 2-5
+
+// show_probes rows are only taken right after their header; an
+// "SSID (MAC)" line anywhere else could be something else entirely
+static bool in_probe_list[UART_LINK_COUNT];
+
+// station_store AP of the sniffer row above, whose client rows follow
+static int sniffer_parent[UART_LINK_COUNT];
+
+static world_handshake_t handshakes[WORLD_HANDSHAKE_LOG];
+static volatile uint32_t handshake_count = 0;
+static portMUX_TYPE world_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool is_esp_log_line(const char *line)
+{
+    return (line[0] == 'I' || line[0] == 'W' || line[0] == 'E' || line[0] == 'D') &&
+           line[1] == ' ' && line[2] == '(';
+}
+
+bool world_capture_ap_verified(const world_capture_ap_t *ap)
+{
+    return (ap->pairs & VERIFIED_PAIRS) != 0;
+}
+
+/**
+ * @brief Fold a capture into its AP record (world_lock held)
+ */
+static void file_capture_ap(const janos_handshake_t *report, world_handshake_t *h)
+{
+    h->ap = WORLD_CAPTURE_NONE;
+    if (!capture_aps) return;
+
+    uint64_t key = report->has_mac ? report->mac_tail : mac_set_key_from_string(h->ssid);
+    bool is_new;
+    int index = mac_set_add(&capture_ap_index, key, &is_new);
+    if (index < 0) return;
+
+    world_capture_ap_t *ap = &capture_aps[index];
+    if (is_new) {
+        memset(ap, 0, sizeof(*ap));
+        ap->has_mac = report->has_mac;
+        ap->mac_tail = report->mac_tail;
+        ap->first_seq = h->seq;
+    }
+    h->ap = (uint16_t)index;
+    h->ap_prev_seq = ap->last_seq;
+    h->ap_was_verified = world_capture_ap_verified(ap);
+
+    strlcpy(ap->ssid, h->ssid, sizeof(ap->ssid));     // Renamed APs show their latest name
+    if (ap->captures < UINT16_MAX) ap->captures++;
+    if (report->message_pair >= 0 && report->message_pair < 8) {
+        ap->pairs |= (uint8_t)(1u << report->message_pair);
+    }
+    ap->link = h->link;
+    ap->last_seq = h->seq;
+    h->ap_verified = world_capture_ap_verified(ap);
+}
+
+static void add_handshake(const char *line, uart_link_id_t link)
+{
+    janos_handshake_t report;
+    if (!janos_parse_handshake(line, &report)) return;
+
+    taskENTER_CRITICAL(&world_lock);
+    uint32_t seq = handshake_count + 1;
+    world_handshake_t *h = &handshakes[seq % WORLD_HANDSHAKE_LOG];
+    memset(h, 0, sizeof(*h));
+    janos_span_copy(report.ssid, h->ssid, sizeof(h->ssid));
+    h->seq = seq;
+    h->time_us = uart_line_time_us();
+    h->link = link;
+    file_capture_ap(&report, h);
+    handshake_count = seq;
+    generation++;
+    taskEXIT_CRITICAL(&world_lock);
+
+    remote_dir_invalidate(HANDSHAKES_DIR);
+
+    bus_event_t event = { .type = BUS_EVENT_HANDSHAKE_CAPTURED };
+    janos_span_copy(report.ssid, event.handshake.ssid, sizeof(event.handshake.ssid));
+    event.handshake.seq = seq;
+    ESP_LOGI(TAG, "Handshake #%lu captured for SSID: %s", (unsigned long)seq, event.handshake.ssid);
+    event_bus_publish(&event);
+}
+
+/**
+ * @brief Parse a deauth detector report
+ * Format: [DEAUTH] CH: <ch> | AP: <name> (<bssid>) | RSSI: <rssi>
+ */
+static bool parse_deauth_line(const char *line, bus_deauth_t *out)
+{
+    janos_deauth_t report;
+    if (!janos_parse_deauth(line, &report)) return false;
+
+    janos_span_copy(report.ap_name, out->ap_name, sizeof(out->ap_name));
+    out->bssid = report.bssid;
+    out->channel = (uint8_t)report.channel;
+    out->rssi = (int8_t)report.rssi;
+    return true;
+}
+
+/**
+ * @brief Sniffer AP row: "SSID, CHn: clients"; keeps the channel totals
+ * @param station_ap Receives the AP's station_store index (-1 if not kept)
+ * @return false if the line is not one
+ */
+static bool file_sniffer_ap(const char *line, int *station_ap)
+{
+    const char *ch_marker = strstr(line, ", CH");
+    if (!ch_marker) return false;
+
+    char *end;
+    long channel = strtol(ch_marker + 4, &end, 10);
+    if (end == ch_marker + 4 || end[0] != ':' || channel < 1 || channel > 255) return false;
+    long clients = strtol(end + 1, &end, 10);
+    if (*end != '\0' || clients < 0) return false;
+
+    // SSIDs repeat across channels, so the key covers both
+    char key_text[MAX_SSID_LEN + 8];
+    size_t key_len = strchr(ch_marker, ':') - line;
+    if (key_len >= sizeof(key_text)) key_len = sizeof(key_text) - 1;
+    memcpy(key_text, line, key_len);
+    key_text[key_len] = '\0';
+    uint64_t key = mac_set_key_from_string(key_text);
+
+    char ssid[MAX_SSID_LEN];
+    size_t ssid_len = ch_marker - line;
+    if (ssid_len >= sizeof(ssid)) ssid_len = sizeof(ssid) - 1;
+    memcpy(ssid, line, ssid_len);
+    ssid[ssid_len] = '\0';
+    *station_ap = station_store_add_ap(ssid, (int)channel, (int)clients);
+    if (!sniffer_aps) return true;
+
+    taskENTER_CRITICAL(&world_lock);
+    bool is_new;
+    int index = mac_set_add(&sniffer_ap_index, key, &is_new);
+    if (index < 0) {
+        taskEXIT_CRITICAL(&world_lock);
+        return true;
+    }
+    sniffer_ap_count_t *ap = &sniffer_aps[index];
+    if (ap->channel) channel_clients[ap->channel] -= ap->clients;   // Older count, or evicted AP
+    ap->channel = (uint8_t)channel;
+    ap->clients = (uint16_t)(clients < UINT16_MAX ? clients : UINT16_MAX);
+    channel_clients[ap->channel] += ap->clients;
+    generation++;
+    taskEXIT_CRITICAL(&world_lock);
+    return true;
+}
+
+/**
+ * @brief Count a deauth report against the attacked BSSID
+ */
+static void file_deauth(const bus_deauth_t *report)
+{
+    if (!deauths) return;
+
+    taskENTER_CRITICAL(&world_lock);
+    bool is_new;
+    int index = mac_set_add(&deauth_index, report->bssid, &is_new);
+    if (index >= 0) {
+        world_deauth_t *d = &deauths[index];
+        if (is_new) memset(d, 0, sizeof(*d));
+        d->reports++;
+        d->last_us = uart_line_time_us();
+        d->channel = report->channel;
+        generation++;
+    }
+    taskEXIT_CRITICAL(&world_lock);
+}
+
+/**
+ * @brief Sniffer client row: indented MAC under an AP line
+ */
+static bool parse_station_line(const char *line, bus_station_t *out)
+{
+    if (line[0] != ' ') return false;
+    while (*line == ' ') line++;
+    return mac_set_key_from_mac(line, &out->mac);
+}
+
+static void world_line(const char *line, void *user_data)
+{
+    (void)user_data;
+
+    if (line[0] == '\0' || is_esp_log_line(line)) return;
+
+    // Boards interleave, so listing state is kept per board
+    uart_link_id_t link = uart_line_link();
+    if (in_probe_list[link]) {
+        if (probe_store_add_probe_line(line) >= 0) return;
+        in_probe_list[link] = false;
+    }
+
+    // Client rows belong to the AP row right above them
+    int parent = sniffer_parent[link];
+    sniffer_parent[link] = -1;
+
+    const char *found = strstr(line, SNIFFER_MARKER);
+    if (found) {
+        int count = atoi(found + strlen(SNIFFER_MARKER));
+        taskENTER_CRITICAL(&world_lock);
+        sniffer_packets[link] = count;
+        sniffer_seq++;
+        generation++;
+        taskEXIT_CRITICAL(&world_lock);
+        return;
+    }
+
+    if (strstr(line, CAPTURE_PCAP_MARKER)) {
+        capture_index_note_saved(line);
+        return;
+    }
+
+    if (strstr(line, JANOS_HANDSHAKE_MARKER)) {
+        add_handshake(line, link);
+        return;
+    }
+
+    found = strstr(line, JANOS_DEAUTH_MARKER);
+    if (found) {
+        bus_event_t event = { .type = BUS_EVENT_DEAUTH_DETECTED };
+        if (parse_deauth_line(found, &event.deauth)) {
+            file_deauth(&event.deauth);
+            event_bus_publish(&event);
+        }
+        return;
+    }
+
+    found = strstr(line, GPS_MARKER);
+    if (found) {
+        const char *state = found + strlen(GPS_MARKER);
+        if (strncmp(state, "obtained", 8) == 0 || strncmp(state, "recovered", 9) == 0 ||
+            strncmp(state, "lost", 4) == 0) {
+            bus_event_t event = { .type = BUS_EVENT_GPS_FIX };
+            event.gps.fix = state[0] != 'l';
+            event_bus_publish(&event);
+            return;
+        }
+    }
+
+    found = strstr(line, PROBE_HEADER);
+    if (found) {
+        probe_total = atoi(found + strlen(PROBE_HEADER));
+        probe_listings++;
+        generation++;
+        in_probe_list[link] = true;
+        return;
+    }
+    if (strstr(line, "No probe") || strstr(line, "no probe")) {
+        probe_total = 0;
+        probe_listings++;
+        generation++;
+        return;
+    }
+
+    found = strstr(line, "Summary:");
+    if (found) {
+        int airtags, smarttags;
+        if (sscanf(found, "Summary: %d AirTags, %d SmartTags", &airtags, &smarttags) == 2) {
+            taskENTER_CRITICAL(&world_lock);
+            tag_airtags = airtags;
+            tag_smarttags = smarttags;
+            taskEXIT_CRITICAL(&world_lock);
+        }
+        bt_passes++;
+        generation++;
+        return;
+    }
+
+    bus_event_t event = { .type = BUS_EVENT_STATION_SEEN };
+    if (parse_station_line(line, &event.station)) {
+        station_store_add(event.station.mac, parent);
+        sniffer_parent[link] = parent;
+        event_bus_publish(&event);
+        return;
+    }
+    if (file_sniffer_ap(line, &sniffer_parent[link])) return;
+
+    bt_store_add_line(line);
+}
+
+esp_err_t world_model_init(void)
+{
+    for (int i = 0; i < UART_LINK_COUNT; i++) sniffer_parent[i] = -1;
+
+    // Channel totals are optional: without memory the view shows APs only
+    sniffer_aps = calloc(WORLD_SNIFFER_APS, sizeof(sniffer_ap_count_t));
+    if (!sniffer_aps || mac_set_init(&sniffer_ap_index, WORLD_SNIFFER_APS) != ESP_OK) {
+        ESP_LOGW(TAG, "No memory for sniffer channel totals");
+        free(sniffer_aps);
+        sniffer_aps = NULL;
+    }
+    deauths = calloc(WORLD_DEAUTH_APS, sizeof(world_deauth_t));
+    if (!deauths || mac_set_init(&deauth_index, WORLD_DEAUTH_APS) != ESP_OK) {
+        ESP_LOGW(TAG, "No memory for per-AP deauth counts");
+        free(deauths);
+        deauths = NULL;
+    }
+    capture_aps = calloc(WORLD_CAPTURE_APS, sizeof(world_capture_ap_t));
+    if (!capture_aps || mac_set_init(&capture_ap_index, WORLD_CAPTURE_APS) != ESP_OK) {
+        ESP_LOGW(TAG, "No memory for per-AP captures");
+        free(capture_aps);
+        capture_aps = NULL;
+    }
+
+    if (uart_subscribe_link_lines(UART_LINK_MASK_ALL, UART_ROUTE_ANY, NULL, world_line, NULL) < 0) {
+        ESP_LOGE(TAG, "No free UART route");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+uint32_t world_model_generation(void)
+{
+    return generation;
+}
+
+uint32_t world_model_bt_passes(void)
+{
+    return bt_passes;
+}
+
+bool world_model_tag_counts(int *airtags, int *smarttags)
+{
+    taskENTER_CRITICAL(&world_lock);
+    int a = tag_airtags;
+    int s = tag_smarttags;
+    taskEXIT_CRITICAL(&world_lock);
+
+    if (a < 0) return false;
+    if (airtags) *airtags = a;
+    if (smarttags) *smarttags = s;
+    return true;
+}
+
+uint32_t world_model_probe_listings(void)
+{
+    return probe_listings;
+}
+
+int world_model_probe_total(void)
+{
+    return probe_total;
+}
+
+int world_model_sniffer_packets(uint32_t *seq)
+{
+    taskENTER_CRITICAL(&world_lock);
+    int count = 0;
+    for (int i = 0; i < UART_LINK_COUNT; i++) count += sniffer_packets[i];
+    if (seq) *seq = sniffer_seq;
+    taskEXIT_CRITICAL(&world_lock);
+    return count;
+}
+
+int world_model_channel_clients(int channel)
+{
+    if (channel < 1 || channel > 255) return 0;
+    return channel_clients[channel];
+}
+
+int world_model_ap_clients(const char *ssid, int channel)
+{
+    if (!sniffer_aps || !ssid) return -1;
+
+    char key_text[MAX_SSID_LEN + 8];
+    snprintf(key_text, sizeof(key_text), "%s, CH%d", ssid, channel);
+
+    taskENTER_CRITICAL(&world_lock);
+    int index = mac_set_find(&sniffer_ap_index, mac_set_key_from_string(key_text));
+    int clients = index >= 0 ? sniffer_aps[index].clients : -1;
+    taskEXIT_CRITICAL(&world_lock);
+    return clients;
+}
+
+bool world_model_deauths(uint64_t bssid, world_deauth_t *out)
+{
+    if (!deauths || !out) return false;
+
+    taskENTER_CRITICAL(&world_lock);
+    int index = mac_set_find(&deauth_index, bssid);
+    if (index >= 0) *out = deauths[index];
+    taskEXIT_CRITICAL(&world_lock);
+    return index >= 0;
+}
+
+int world_model_handshakes_for(const char *ssid, world_handshake_t *latest)
+{
+    if (!ssid || !ssid[0]) return 0;
+
+    // The log is short; newest first so latest is the first match
+    int count = 0;
+    uint32_t newest = handshake_count;
+    for (uint32_t seq = newest; seq > 0 && newest - seq < WORLD_HANDSHAKE_LOG; seq--) {
+        world_handshake_t h;
+        if (!world_model_handshake_get(seq, &h) || strcmp(h.ssid, ssid) != 0) continue;
+        if (count++ == 0 && latest) *latest = h;
+    }
+    return count;
+}
+
+uint32_t world_model_handshake_count(void)
+{
+    return handshake_count;
+}
+
+bool world_model_handshake_get(uint32_t seq, world_handshake_t *out)
+{
+    if (seq == 0 || !out) return false;
+
+    taskENTER_CRITICAL(&world_lock);
+    const world_handshake_t *h = &handshakes[seq % WORLD_HANDSHAKE_LOG];
+    bool kept = (h->seq == seq);
+    if (kept) *out = *h;
+    taskEXIT_CRITICAL(&world_lock);
+    return kept;
+}
+
+bool world_model_capture_ap_get(int index, world_capture_ap_t *out)
+{
+    if (!capture_aps || !out || index < 0 || index >= WORLD_CAPTURE_APS) return false;
+
+    taskENTER_CRITICAL(&world_lock);
+    bool used = capture_aps[index].first_seq != 0;
+    if (used) *out = capture_aps[index];
+    taskEXIT_CRITICAL(&world_lock);
+    return used;
+}
+
+void world_model_capture_run_start(world_capture_run_t *run)
+{
+    run->start_seq = handshake_count;
+    run->seen_seq = run->start_seq;
+    run->aps = 0;
+    run->verified = 0;
+}
+
+bool world_model_capture_run_update(world_capture_run_t *run)
+{
+    uint32_t count = handshake_count;
+    if (run->seen_seq == count) return false;
+
+    // Older captures than the log holds were missed; only the totals know them
+    if (count - run->seen_seq > WORLD_HANDSHAKE_LOG) run->seen_seq = count - WORLD_HANDSHAKE_LOG;
+    while (run->seen_seq < count) {
+        world_handshake_t h;
+        if (!world_model_handshake_get(++run->seen_seq, &h) || h.ap == WORLD_CAPTURE_NONE) continue;
+
+        if (h.ap_prev_seq <= run->start_seq) {
+            // First capture of this AP in the run
+            if (run->aps == WORLD_CAPTURE_APS) continue;
+            world_capture_ap_t ap;
+            if (!world_model_capture_ap_get(h.ap, &ap)) continue;
+            run->ap[run->aps] = h.ap;
+            run->ap_first_seq[run->aps] = ap.first_seq;
+            run->aps++;
+            if (h.ap_verified) run->verified++;
+        } else if (h.ap_verified && !h.ap_was_verified) {
+            run->verified++;
+        }
+    }
+    return true;
+}
+
+bool world_model_capture_run_get(const world_capture_run_t *run, int row, world_capture_ap_t *out)
+{
+    if (row < 0 || row >= run->aps) return false;
+    return world_model_capture_ap_get(run->ap[row], out) && out->first_seq == run->ap_first_seq[row];
+}
@@ -0,0 +1,221 @@
+/**
+ * @file world_model.h
+ * @brief JanOS output parsed once, whatever screen is showing
+ *
+ * One UART route sees every line and files what it recognises: BT scan
+ * rows into bt_store, show_probes rows into probe_store, and sniffer
+ * packet counts, BT scan pass ends and captured handshakes into the
+ * counters below. Screens are views that read the stores and compare
+ * the sequence numbers in on_tick, so leaving and re-entering a view
+ * keeps its data and costs no UART round trip. Handshakes, deauth
+ * reports, sniffer clients and GPS fix changes are also published on
+ * the event bus (event_bus.h) for consumers that want each one.
+ *
+ * Sniffer result AP lines ("SSID, CHn: clients") and the client MACs
+ * under them are filed in station_store, which keeps who talks to which
+ * AP. The AP lines also feed per-AP and per-channel client totals. Each
+ * listing repeats every AP, so an AP's newest count replaces its last
+ * one and the channel total moves by the difference. Deauth reports are
+ * counted per attacked BSSID. Both are hash-indexed, so an AP's detail
+ * view joins them without a UART query.
+ *
+ * bt_store, probe_store and station_store are allocated by the first
+ * view that needs them; rows arriving before that are not kept. Scan
+ * results, the network_store, and credentials (cred_store) are filed by
+ * their own modules as before. Request-scoped replies (list_probes numbering)
+ * stay with their uart_request callers.
+ *
+ * Each captured handshake is also folded into a per-AP record, keyed by
+ * the BSSID tail JanOS reports (the SSID when it reports none), counting
+ * captures and which message pairs were saved. Attack screens follow
+ * their run with a world_capture_run_t: it lists each AP once, in the
+ * order first captured, and keeps the totals, at O(1) per capture however
+ * long the run.
+ *
+ * Lines from every board are filed (uart_subscribe_link_lines), so with a
+ * second board both feed the same totals: sniffer packet counts add up,
+ * and handshakes record which board captured them.
+ *
+ * Updated on the UART RX tasks; any task may read.
+ */
+
+#ifndef WORLD_MODEL_H
+#define WORLD_MODEL_H
+
+#include "esp_err.h"
+#include "uart_handler.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define WORLD_HANDSHAKE_LOG     16      // Latest captures kept
+#define WORLD_SNIFFER_APS       128     // APs counted toward channel totals
+#define WORLD_DEAUTH_APS        64      // Attacked BSSIDs remembered
+#define WORLD_CAPTURE_APS       256     // Captured APs remembered (least recent evicted)
+#define WORLD_CAPTURE_NONE      0xFFFF  // world_handshake_t.ap without an AP record
+
+// Deauth detector reports against one BSSID
+typedef struct {
+    uint32_t reports;
+    int64_t last_us;                    // Arrival of the latest report (time_sync)
+    uint8_t channel;
+} world_deauth_t;
+
+// One captured handshake
+typedef struct {
+    char ssid[MAX_SSID_LEN];
+    uint32_t seq;                       // 1 for the first capture since boot
+    int64_t time_us;                    // Arrival of the capture line (time_sync)
+    uint8_t link;                       // uart_link_id_t of the capturing board
+    uint16_t ap;                        // world_model_capture_ap_get() index, or WORLD_CAPTURE_NONE
+    uint32_t ap_prev_seq;               // The AP's previous capture, 0 if this was its first
+    bool ap_verified;                   // The AP has an authorized pair after this capture
+    bool ap_was_verified;               // ... and had one before it
+} world_handshake_t;
+
+// Everything captured from one AP
+typedef struct {
+    char ssid[MAX_SSID_LEN];
+    bool has_mac;
+    uint32_t mac_tail;                  // Last three BSSID octets (JanOS reports no more)
+    uint16_t captures;
+    uint8_t pairs;                      // Bit n set once hashcat message_pair n was saved
+    uint8_t link;                       // Board of the latest capture
+    uint32_t first_seq;                 // Handshake seq that created the record
+    uint32_t last_seq;
+} world_capture_ap_t;
+
+// One attack run's captures, per AP (see world_model_capture_run_update)
+typedef struct {
+    uint32_t start_seq;                 // Captures up to this one are not the run's
+    uint32_t seen_seq;                  // Last capture looked at
+    int aps;                            // Rows in ap[]
+    int verified;                       // Of them, with an authorized pair
+    uint16_t ap[WORLD_CAPTURE_APS];     // AP indices, first captured first
+    uint32_t ap_first_seq[WORLD_CAPTURE_APS];   // To notice a reused index
+} world_capture_run_t;
+
+/**
+ * @brief Start filing received lines (call once after uart_handler_init)
+ * @return ESP_OK, ESP_FAIL if no UART route is free
+ */
+esp_err_t world_model_init(void);
+
+/**
+ * @brief Counter bumped on every change filed outside the stores
+ */
+uint32_t world_model_generation(void);
+
+/**
+ * @brief BT scan passes ended ("Summary:" lines) since boot
+ */
+uint32_t world_model_bt_passes(void);
+
+/**
+ * @brief AirTag and SmartTag counts from the last AirTag scan summary
+ * @param airtags Receives the AirTag count (may be NULL)
+ * @param smarttags Receives the SmartTag count (may be NULL)
+ * @return false if no AirTag summary was seen yet
+ */
+bool world_model_tag_counts(int *airtags, int *smarttags);
+
+/**
+ * @brief show_probes replies seen since boot (header or "no probes")
+ */
+uint32_t world_model_probe_listings(void);
+
+/**
+ * @brief Probe total from the last show_probes header, 0 if none
+ */
+int world_model_probe_total(void);
+
+/**
+ * @brief Last sniffer packet count reported by JanOS, summed over boards
+ * @param seq Receives the report's sequence number, 0 before the first
+ *            (may be NULL); views show only reports newer than their start
+ * @return Packet count, 0 before the first report
+ */
+int world_model_sniffer_packets(uint32_t *seq);
+
+/**
+ * @brief Sniffer clients on a channel, summed over the APs last listed
+ * @param channel Channel number (1-14, 36-177)
+ * @return Clients, 0 if none or no results seen
+ */
+int world_model_channel_clients(int channel);
+
+/**
+ * @brief Clients the sniffer last listed for one AP
+ * @param ssid AP name as the sniffer lists it
+ * @param channel AP channel
+ * @return Clients, -1 if the AP was not in any sniffer listing
+ */
+int world_model_ap_clients(const char *ssid, int channel);
+
+/**
+ * @brief Deauth reports against a BSSID
+ * @param bssid mac_set key of the BSSID
+ * @param out Receives the counts
+ * @return false if none were seen (or the BSSID was evicted)
+ */
+bool world_model_deauths(uint64_t bssid, world_deauth_t *out);
+
+/**
+ * @brief Captures for an SSID among the last WORLD_HANDSHAKE_LOG
+ * @param ssid SSID
+ * @param latest Receives the newest one (may be NULL)
+ * @return Captures found
+ */
+int world_model_handshakes_for(const char *ssid, world_handshake_t *latest);
+
+/**
+ * @brief Handshakes captured since boot (also the newest capture's seq)
+ */
+uint32_t world_model_handshake_count(void);
+
+/**
+ * @brief Copy a captured handshake by sequence number
+ * @param seq Sequence number (only the last WORLD_HANDSHAKE_LOG are kept)
+ * @param out Receives the capture
+ * @return false if seq is 0, in the future, or no longer kept
+ */
+bool world_model_handshake_get(uint32_t seq, world_handshake_t *out);
+
+/**
+ * @brief Whether an AP's captures include an authorized pair
+ *
+ * Message pairs 2-5 hold the AP's M3, sent only once the station proved
+ * the key; pairs 0 and 1 are a challenge that a mistyped password also
+ * answers.
+ */
+bool world_capture_ap_verified(const world_capture_ap_t *ap);
+
+/**
+ * @brief Copy a captured AP record
+ * @param index world_handshake_t.ap
+ * @return false if the index holds no AP
+ */
+bool world_model_capture_ap_get(int index, world_capture_ap_t *out);
+
+/**
+ * @brief Start following captures from now on
+ */
+void world_model_capture_run_start(world_capture_run_t *run);
+
+/**
+ * @brief Take in the captures filed since the last call
+ *
+ * Each AP gets one row, the first time it is captured in the run. Only
+ * the last WORLD_HANDSHAKE_LOG captures are kept, so call it at least
+ * that often (every UART tick is plenty); the capture total
+ * (world_model_handshake_count() - start_seq) is exact regardless.
+ * @return true if anything changed
+ */
+bool world_model_capture_run_update(world_capture_run_t *run);
+
+/**
+ * @brief AP of a run row
+ * @return false if the row is out of range or its AP was evicted since
+ */
+bool world_model_capture_run_get(const world_capture_run_t *run, int row, world_capture_ap_t *out);
+
+#endif // WORLD_MODEL_H
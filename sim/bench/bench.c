@@ -0,0 +1,76 @@
+/**
+ * @file bench.c
+ * @brief Timing and heap counting shared by the host benchmarks
+ *
+ * malloc, calloc and realloc are interposed on glibc's allocator and
+ * counted on the benchmark thread only, so shim threads (timers, the
+ * panel) do not show up in a case's figures.
+ */
+
+#include "bench.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static _Thread_local bool counting = false;
+static atomic_llong allocations = 0;
+
+static inline void count_one(void)
+{
+    if (counting) atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+}
+
+void *malloc(size_t size)
+{
+    count_one();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    count_one();
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    count_one();
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    __libc_free(ptr);
+}
+
+long long bench_now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+void bench_count_allocs(bool on)
+{
+    counting = on;
+}
+
+long long bench_take_allocs(void)
+{
+    return atomic_exchange(&allocations, 0);
+}
+
+void *bench_malloc(size_t size)
+{
+    return __libc_malloc(size);
+}
+
+void bench_free(void *ptr)
+{
+    __libc_free(ptr);
+}
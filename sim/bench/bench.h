@@ -0,0 +1,35 @@
+/**
+ * @file bench.h
+ * @brief Timing and heap counting shared by the host benchmarks
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define BENCH_MIN_NS    200000000LL     // Run each case at least 0.2 s
+
+/**
+ * @brief Monotonic clock in ns
+ */
+long long bench_now_ns(void);
+
+/**
+ * @brief Count heap allocations made by this thread from now on
+ */
+void bench_count_allocs(bool on);
+
+/**
+ * @brief Allocations counted since the last call
+ */
+long long bench_take_allocs(void);
+
+/**
+ * @brief The host allocator, bypassing the count (benchmark inputs)
+ */
+void *bench_malloc(size_t size);
+void bench_free(void *ptr);
+
+#endif // BENCH_H
@@ -0,0 +1,200 @@
+/**
+ * @file bench_containers.c
+ * @brief Host benchmark of the fixed-capacity containers
+ *
+ *   ./bench_containers
+ *
+ * Runs the store workloads each container serves on the device: the
+ * fixed_ring of gps_uplink, the event_bus object pool, the mac_set hash
+ * index with LRU eviction, ssid_pool string interning, the sorted views
+ * of fixed_index and the fixed_bits selection sets. Reports ns per
+ * operation and heap allocations per operation, which should stay 0 once
+ * a container is set up. Host numbers only rank changes.
+ */
+
+#include "bench.h"
+#include "event_bus.h"
+#include "fixed_containers.h"
+#include "mac_set.h"
+#include "ssid_pool.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define BATCH               1000
+#define RING_CAPACITY       64
+#define BUS_DEPTH           16
+#define MAC_CAPACITY        512
+#define MAC_KEYS            (MAC_CAPACITY * 2)  // Half the lookups miss and evict
+#define SSID_NAMES          256
+#define VIEW_CAPACITY       512
+#define BITS                1024
+
+typedef void (*op_fn_t)(uint32_t i);
+
+typedef struct {
+    const char *name;
+    op_fn_t op;
+} bench_case_t;
+
+static uint32_t rng_state = 0x9E3779B9u;
+static volatile uint32_t sink;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static struct {
+    fixed_ring_t ring;
+    uint32_t slots[RING_CAPACITY];
+} ring;
+
+static void op_ring(uint32_t i)
+{
+    bool dropped;
+    ring.slots[fixed_ring_push(&ring.ring, &dropped)] = i;
+    uint32_t count = fixed_ring_count(&ring.ring);
+    sink = ring.slots[fixed_ring_slot(&ring.ring, count - 1)];
+    if (i % 8 == 7) fixed_ring_drop(&ring.ring, 4);
+}
+
+static int bus_handle = -1;
+
+static void op_pool(uint32_t i)
+{
+    bus_event_t event = { .type = BUS_EVENT_STATION_SEEN, .station.mac = i };
+    event_bus_publish(&event);
+    if (i % 4 == 3) {
+        while (event_bus_receive(bus_handle, &event, 0)) sink = (uint32_t)event.station.mac;
+    }
+}
+
+static mac_set_t macs;
+static uint64_t mac_keys[MAC_KEYS];
+
+static void op_hash(uint32_t i)
+{
+    (void)i;
+    bool is_new;
+    sink = (uint32_t)mac_set_add(&macs, mac_keys[rng() % MAC_KEYS], &is_new);
+}
+
+static char ssid_names[SSID_NAMES][33];
+static ssid_handle_t ssid_held[SSID_NAMES];
+
+static void op_intern(uint32_t i)
+{
+    (void)i;
+    uint32_t n = rng() % SSID_NAMES;
+    if (ssid_held[n] != SSID_NONE) {
+        ssid_pool_release(ssid_held[n]);
+        ssid_held[n] = SSID_NONE;
+    } else {
+        int handle = ssid_pool_acquire(ssid_names[n]);
+        if (handle > 0) ssid_held[n] = (ssid_handle_t)handle;
+    }
+}
+
+static struct {
+    int8_t rssi[VIEW_CAPACITY];
+    uint16_t order[VIEW_CAPACITY];
+    int count;
+} view;
+
+static int cmp_rssi(int a, int b, void *ctx)
+{
+    const int8_t *rssi = ctx;
+    if (rssi[a] != rssi[b]) return rssi[b] - rssi[a];
+    return a - b;
+}
+
+static void op_index(uint32_t i)
+{
+    // Fill the view one sorted insert at a time, then look rows up and resort
+    if (view.count == VIEW_CAPACITY) {
+        sink = (uint32_t)fixed_index_find(view.order, view.count, (int)(i % VIEW_CAPACITY));
+        if (i % 64 == 0) {
+            view.rssi[i % VIEW_CAPACITY] = (int8_t)-(int)(rng() % 90);
+            fixed_index_sort(view.order, view.count, cmp_rssi, view.rssi);
+        }
+        if (i % 1024 == 0) view.count = 0;
+        return;
+    }
+    int index = view.count;
+    view.rssi[index] = (int8_t)-(int)(rng() % 90);
+    fixed_index_insert(view.order, &view.count, VIEW_CAPACITY, index, cmp_rssi, view.rssi);
+}
+
+static uint32_t bits[FIXED_BITS_WORDS(BITS)];
+
+static void op_bits(uint32_t i)
+{
+    fixed_bits_put(bits, (int)(rng() % BITS), i & 1);
+    int n = 0;
+    for (int b = fixed_bits_next(bits, 0, BITS); b >= 0; b = fixed_bits_next(bits, b + 1, BITS)) n++;
+    sink = (uint32_t)(n + fixed_bits_count(bits, BITS));
+}
+
+static const bench_case_t cases[] = {
+    { "ring", op_ring },
+    { "pool", op_pool },
+    { "hash", op_hash },
+    { "intern", op_intern },
+    { "index", op_index },
+    { "bits", op_bits },
+};
+
+static int setup(void)
+{
+    fixed_ring_init(&ring.ring, RING_CAPACITY);
+
+    if (event_bus_init() != ESP_OK) return 1;
+    bus_handle = event_bus_subscribe(BUS_EVENT_BIT(BUS_EVENT_STATION_SEEN), BUS_DEPTH, "bench");
+    if (bus_handle < 0) return 1;
+
+    if (mac_set_init(&macs, MAC_CAPACITY) != ESP_OK) return 1;
+    for (int i = 0; i < MAC_KEYS; i++) {
+        mac_keys[i] = ((uint64_t)rng() << 16 ^ rng()) & 0xFFFFFFFFFFFFull;
+    }
+
+    if (ssid_pool_init() != ESP_OK) return 1;
+    for (int i = 0; i < SSID_NAMES; i++) {
+        snprintf(ssid_names[i], sizeof(ssid_names[i]), "%s-%04X%.*s",
+                 i % 3 ? "HomeNet" : "Office Guest", (unsigned)rng() & 0xFFFF,
+                 (int)(rng() % 16), "_5G_extended_name");
+    }
+    return 0;
+}
+
+int main(void)
+{
+    if (setup() != 0) {
+        fprintf(stderr, "container setup failed\n");
+        return 1;
+    }
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        long long ops = 0;
+        bench_take_allocs();
+        long long start = bench_now_ns();
+        long long elapsed;
+        do {
+            bench_count_allocs(true);
+            for (uint32_t n = 0; n < BATCH; n++) cases[c].op((uint32_t)ops + n);
+            bench_count_allocs(false);
+            ops += BATCH;
+            elapsed = bench_now_ns() - start;
+        } while (elapsed < BENCH_MIN_NS);
+        long long allocs = bench_take_allocs();
+        printf("%-7s %8.1f ns/op %12lld ops %8.4f allocs/op\n", cases[c].name,
+               (double)elapsed / (double)ops, ops, (double)allocs / (double)ops);
+    }
+    printf("hash: %u evictions, intern: %d strings\n", (unsigned)macs.evictions, ssid_pool_count());
+
+    mac_set_free(&macs);
+    return 0;
+}
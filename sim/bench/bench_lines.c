@@ -0,0 +1,231 @@
+/**
+ * @file bench_lines.c
+ * @brief Host benchmark of the UART line parsers and text_ui
+ *
+ *   ./bench_lines                  representative JanOS lines
+ *   ./bench_lines rx_0.utr         a captured transcript (uart_transcript.h)
+ *   ./bench_lines capture.txt      one JanOS line per text line
+ *
+ * Every line goes through all the line parsers, as the firmware's line
+ * routing would in the worst case, then is drawn as a list row by text_ui
+ * on the simulator's panel; each screenful also redraws the title and
+ * status bars and flushes. Reports lines/s, heap allocations per line and
+ * the slowest single line for each stage. Host numbers only rank changes;
+ * the ESP32-S3 figures come from the benchmark screen.
+ */
+
+#include "bench.h"
+#include "display.h"
+#include "janos_proto.h"
+#include "text_ui.h"
+#include "uart_frame.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CAPTURE_LINES       100000
+#define LINE_MAX_BYTES      1024
+#define TRANSCRIPT_MAGIC    "UTR1"
+#define RECORD_HEADER_SIZE  6               // u32 time_ms, u16 length
+
+static const char *const sample_lines[] = {
+    "\"17\",\"Office Guest \\\"5G\\\"\",\"\",\"AA:BB:CC:DD:EE:FF\",\"36\",\"WPA2/WPA3\",\"-71\",\"5GHz\"",
+    "\"18\",\"\",\"\",\"12:34:56:78:9A:BC\",\"6\",\"Open\",\"-88\",\"2.4GHz\"",
+    "[DEAUTH] CH: 11 | AP: Cafe Corner (aa:bb:cc:00:11:22) | RSSI: -67",
+    "  23. C4:2B:44:12:29:15  RSSI: -82 dBm  Name: WH-1000XM4",
+    "12 portal_login_page_with_a_long_name.html",
+    "192.168.4.101  ->  C4:2B:44:12:29:15 [Huawei Device Co., Ltd.]",
+    "\"AX3_2.4_12291C_79868.pcap\",\"AX3_2.4\",\"AA:BB:CC:12:29:1C\",\"1234\",\"0\",\"1186\",\"1739550000\"",
+    "Complete 4-way handshake saved for SSID: Office Guest (MAC: 12291C, message_pair: 2)",
+    "[SnifferDog #1234] DEAUTH sent: AP=30:AA:E4:3C:3F:64 -> STA=A6:02:A5:BA:DA:AB (Ch=1, RSSI=-69)",
+    "I (123456) wifi:new:<6,0>, old:<1,0>, ap:<255,255>, sta:<6,0>, prof:1",
+    "Scan results printed.",
+    "",
+};
+
+typedef struct {
+    char **lines;
+    long long count;
+    long long bytes;
+} line_set_t;
+
+typedef long long (*stage_fn_t)(const char *line, long long index);
+
+typedef struct {
+    long long lines;
+    long long bytes;
+    long long ns;
+    long long allocs;
+    long long worst_ns;
+    long long worst_index;
+    long long hits;
+} stage_result_t;
+
+static bool add_line(line_set_t *set, const char *text, size_t len)
+{
+    if (set->count >= CAPTURE_LINES) return false;
+    char *line = bench_malloc(len + 1);
+    if (!line) return false;
+    memcpy(line, text, len);
+    line[len] = '\0';
+    set->lines[set->count++] = line;
+    set->bytes += (long long)len;
+    return true;
+}
+
+/**
+ * @brief Split a transcript's RX bytes into lines as the RX task would
+ */
+static void load_transcript(FILE *f, line_set_t *set)
+{
+    char line[LINE_MAX_BYTES];
+    size_t len = 0;
+    uint8_t header[RECORD_HEADER_SIZE];
+    uint8_t chunk[UINT16_MAX];
+    while (fread(header, 1, sizeof(header), f) == sizeof(header)) {
+        size_t n = (size_t)header[4] | ((size_t)header[5] << 8);
+        if (fread(chunk, 1, n, f) != n) break;
+        for (size_t i = 0; i < n; i++) {
+            char c = (char)chunk[i];
+            if (c == '\r' || c == '\n') {
+                if (len > 0 && !add_line(set, line, len)) return;
+                len = 0;
+            } else if (len < sizeof(line) - 1) {
+                line[len++] = c;
+            }
+        }
+    }
+    if (len > 0) add_line(set, line, len);
+}
+
+static int load_lines(const char *path, line_set_t *set)
+{
+    set->lines = bench_malloc(CAPTURE_LINES * sizeof(char *));
+    if (!set->lines) return 1;
+    if (!path) {
+        for (size_t i = 0; i < sizeof(sample_lines) / sizeof(sample_lines[0]); i++) {
+            add_line(set, sample_lines[i], strlen(sample_lines[i]));
+        }
+        return 0;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return 1;
+    }
+    char magic[4];
+    if (fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+        memcmp(magic, TRANSCRIPT_MAGIC, sizeof(magic)) == 0) {
+        load_transcript(f, set);
+    } else {
+        char buf[LINE_MAX_BYTES];
+        rewind(f);
+        while (fgets(buf, sizeof(buf), f)) {
+            buf[strcspn(buf, "\r\n")] = '\0';
+            if (!add_line(set, buf, strlen(buf))) break;
+        }
+    }
+    fclose(f);
+    if (set->count == 0) {
+        fprintf(stderr, "%s: no lines\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+static long long parse_line(const char *line, long long index)
+{
+    (void)index;
+    wifi_network_t network;
+    janos_scan_row_t scan;
+    janos_deauth_t deauth;
+    janos_bt_row_t bt;
+    janos_list_row_t list;
+    janos_arp_host_t arp;
+    janos_capture_row_t hs;
+    janos_handshake_t handshake;
+    janos_dog_kick_t dog;
+    return uart_frame_parse_scan_line(line, &network) +
+           janos_parse_scan_row(line, &scan) +
+           janos_parse_deauth(line, &deauth) +
+           janos_parse_bt_row(line, &bt) +
+           janos_parse_list_row(line, &list) +
+           janos_parse_arp_host(line, &arp) +
+           janos_parse_capture_row(line, &hs) +
+           janos_parse_handshake(line, &handshake) +
+           janos_parse_dog_kick(line, &dog);
+}
+
+static long long draw_line(const char *line, long long index)
+{
+    // Rows 1 .. rows-2 sit between the title and status bars
+    int list_rows = ui_rows() - 2;
+    int row = 1 + (int)(index % list_rows);
+    if (row == 1) {
+        ui_draw_title("Bench");
+        ui_draw_status("ENTER:Select  ESC:Back");
+    }
+    ui_draw_menu_item(row, line, index % 3 == 0, index % 2 == 0, index % 4 == 0);
+    if (row == list_rows) display_flush();
+    return 1;
+}
+
+static void run_stage(const line_set_t *set, stage_fn_t fn, stage_result_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    long long start = bench_now_ns();
+    long long index = 0;
+    do {
+        for (long long i = 0; i < set->count; i++, index++) {
+            long long t0 = bench_now_ns();
+            bench_count_allocs(true);
+            out->hits += fn(set->lines[i], index);
+            bench_count_allocs(false);
+            long long t = bench_now_ns() - t0;
+            if (t > out->worst_ns) {
+                out->worst_ns = t;
+                out->worst_index = i;
+            }
+        }
+        out->lines += set->count;
+        out->bytes += set->bytes;
+        out->ns = bench_now_ns() - start;
+    } while (out->ns < BENCH_MIN_NS);
+    out->allocs = bench_take_allocs();
+}
+
+static void report(const char *name, const stage_result_t *r, const line_set_t *set)
+{
+    printf("%-6s %11.0f lines/s %8.1f MB/s %7.4f allocs/line  worst %7.1f us (line %lld: %.40s)\n",
+           name, (double)r->lines * 1e9 / (double)r->ns, (double)r->bytes * 1000.0 / (double)r->ns,
+           (double)r->allocs / (double)r->lines, (double)r->worst_ns / 1000.0,
+           r->worst_index + 1, set->lines[r->worst_index]);
+}
+
+int main(int argc, char **argv)
+{
+    line_set_t set = { 0 };
+    if (load_lines(argc > 1 ? argv[1] : NULL, &set) != 0) return 1;
+
+    if (display_init() != ESP_OK) {
+        fprintf(stderr, "display_init failed\n");
+        return 1;
+    }
+    ui_init();
+
+    stage_result_t parse;
+    stage_result_t draw;
+    run_stage(&set, parse_line, &parse);
+    run_stage(&set, draw_line, &draw);
+
+    printf("%lld lines, %lld bytes\n", set.count, set.bytes);
+    report("parse", &parse, &set);
+    report("draw", &draw, &set);
+    printf("%lld parser hits per pass\n", parse.hits * set.count / parse.lines);
+
+    for (long long i = 0; i < set.count; i++) bench_free(set.lines[i]);
+    bench_free(set.lines);
+    return 0;
+}
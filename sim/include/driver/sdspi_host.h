@@ -0,0 +1,29 @@
+/**
+ * @file sdspi_host.h
+ * @brief ESP-IDF SD-over-SPI host for the desktop simulator
+ */
+
+#ifndef SIM_DRIVER_SDSPI_HOST_H
+#define SIM_DRIVER_SDSPI_HOST_H
+
+#include "sdmmc_cmd.h"
+#include "driver/spi_common.h"
+
+typedef int sdspi_dev_handle_t;
+
+typedef struct {
+    spi_host_device_t host_id;
+    int gpio_cs;
+    int gpio_cd;
+    int gpio_wp;
+    int gpio_int;
+} sdspi_device_config_t;
+
+#define SDSPI_HOST_DEFAULT()            { .slot = SPI2_HOST, .max_freq_khz = 20000 }
+#define SDSPI_DEVICE_CONFIG_DEFAULT()   { .host_id = SPI2_HOST, .gpio_cs = -1, \
+                                          .gpio_cd = -1, .gpio_wp = -1, .gpio_int = -1 }
+
+esp_err_t sdspi_host_init_device(const sdspi_device_config_t *config, sdspi_dev_handle_t *out);
+esp_err_t sdspi_host_remove_device(sdspi_dev_handle_t handle);
+
+#endif // SIM_DRIVER_SDSPI_HOST_H
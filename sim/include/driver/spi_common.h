@@ -0,0 +1,29 @@
+/**
+ * @file spi_common.h
+ * @brief ESP-IDF SPI bus setup for the desktop simulator (no bus, calls succeed)
+ */
+
+#ifndef SIM_DRIVER_SPI_COMMON_H
+#define SIM_DRIVER_SPI_COMMON_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+typedef enum { SPI1_HOST, SPI2_HOST, SPI3_HOST } spi_host_device_t;
+typedef enum { SPI_DMA_DISABLED, SPI_DMA_CH_AUTO = 3 } spi_dma_chan_t;
+
+typedef struct {
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+    uint32_t flags;
+} spi_bus_config_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config,
+                             spi_dma_chan_t dma);
+esp_err_t spi_bus_free(spi_host_device_t host);
+
+#endif // SIM_DRIVER_SPI_COMMON_H
@@ -0,0 +1,11 @@
+/**
+ * @file spi_master.h
+ * @brief ESP-IDF SPI master driver for the desktop simulator
+ */
+
+#ifndef SIM_DRIVER_SPI_MASTER_H
+#define SIM_DRIVER_SPI_MASTER_H
+
+#include "driver/spi_common.h"
+
+#endif // SIM_DRIVER_SPI_MASTER_H
@@ -0,0 +1,27 @@
+/**
+ * @file usb_serial_jtag.h
+ * @brief ESP-IDF USB Serial/JTAG driver for the desktop simulator
+ *
+ * The host has no such port: installing the driver fails, so the USB
+ * bridge and screen mirror report themselves unavailable.
+ */
+
+#ifndef SIM_DRIVER_USB_SERIAL_JTAG_H
+#define SIM_DRIVER_USB_SERIAL_JTAG_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t tx_buffer_size;
+    uint32_t rx_buffer_size;
+} usb_serial_jtag_driver_config_t;
+
+esp_err_t usb_serial_jtag_driver_install(usb_serial_jtag_driver_config_t *config);
+esp_err_t usb_serial_jtag_driver_uninstall(void);
+int usb_serial_jtag_read_bytes(void *buf, uint32_t length, TickType_t ticks);
+int usb_serial_jtag_write_bytes(const void *src, size_t size, TickType_t ticks);
+
+#endif // SIM_DRIVER_USB_SERIAL_JTAG_H
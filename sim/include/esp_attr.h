@@ -0,0 +1,14 @@
+/**
+ * @file esp_attr.h
+ * @brief ESP-IDF placement attributes for the desktop simulator (all no-ops)
+ */
+
+#ifndef SIM_ESP_ATTR_H
+#define SIM_ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_BSS_ATTR
+#define RTC_DATA_ATTR
+
+#endif // SIM_ESP_ATTR_H
@@ -0,0 +1,18 @@
+/**
+ * @file esp_cpu.h
+ * @brief ESP-IDF CPU utilities for the desktop simulator
+ *
+ * The cycle counter runs at SIM_CPU_MHZ, the ESP32-S3's 240 MHz, so
+ * cycle figures read on the same scale as on the device.
+ */
+
+#ifndef SIM_ESP_CPU_H
+#define SIM_ESP_CPU_H
+
+#include <stdint.h>
+
+#define SIM_CPU_MHZ     240
+
+uint32_t esp_cpu_get_cycle_count(void);
+
+#endif // SIM_ESP_CPU_H
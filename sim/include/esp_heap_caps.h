@@ -0,0 +1,36 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief ESP-IDF capability heap for the desktop simulator
+ *
+ * Every capability is served by the host allocator, so blocks may be
+ * released with either heap_caps_free() or free() as on the device.
+ * Free-space queries report the board's capacities, with everything the
+ * process has allocated charged to PSRAM; heaptrack or valgrind give
+ * the real picture.
+ */
+
+#ifndef SIM_ESP_HEAP_CAPS_H
+#define SIM_ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_EXEC         (1 << 0)
+#define MALLOC_CAP_32BIT        (1 << 1)
+#define MALLOC_CAP_8BIT         (1 << 2)
+#define MALLOC_CAP_DMA          (1 << 3)
+#define MALLOC_CAP_SPIRAM       (1 << 10)
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+#define MALLOC_CAP_DEFAULT      (1 << 12)
+
+void *heap_caps_malloc(size_t size, uint32_t caps);
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps);
+void *heap_caps_realloc(void *ptr, size_t size, uint32_t caps);
+void heap_caps_free(void *ptr);
+size_t heap_caps_get_allocated_size(void *ptr);
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_total_size(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+
+#endif // SIM_ESP_HEAP_CAPS_H
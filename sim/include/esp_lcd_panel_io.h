@@ -0,0 +1,45 @@
+/**
+ * @file esp_lcd_panel_io.h
+ * @brief ESP-IDF LCD panel IO for the desktop simulator
+ *
+ * Color transfers complete as soon as they are issued: the pixels are
+ * copied into the simulated panel and the done callback runs in place.
+ */
+
+#ifndef SIM_ESP_LCD_PANEL_IO_H
+#define SIM_ESP_LCD_PANEL_IO_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct sim_lcd_io *esp_lcd_panel_io_handle_t;
+typedef struct sim_lcd_panel *esp_lcd_panel_handle_t;
+typedef int esp_lcd_spi_bus_handle_t;
+
+typedef struct {
+    int unused;
+} esp_lcd_panel_io_event_data_t;
+
+typedef bool (*esp_lcd_panel_io_color_trans_done_cb_t)(esp_lcd_panel_io_handle_t io,
+                                                       esp_lcd_panel_io_event_data_t *edata,
+                                                       void *user_ctx);
+
+typedef struct {
+    int cs_gpio_num;
+    int dc_gpio_num;
+    int spi_mode;
+    unsigned int pclk_hz;
+    size_t trans_queue_depth;
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done;
+    void *user_ctx;
+    int lcd_cmd_bits;
+    int lcd_param_bits;
+} esp_lcd_panel_io_spi_config_t;
+
+esp_err_t esp_lcd_new_panel_io_spi(esp_lcd_spi_bus_handle_t bus,
+                                   const esp_lcd_panel_io_spi_config_t *config,
+                                   esp_lcd_panel_io_handle_t *out);
+
+#endif // SIM_ESP_LCD_PANEL_IO_H
@@ -0,0 +1,21 @@
+/**
+ * @file esp_lcd_panel_ops.h
+ * @brief ESP-IDF LCD panel operations for the desktop simulator
+ */
+
+#ifndef SIM_ESP_LCD_PANEL_OPS_H
+#define SIM_ESP_LCD_PANEL_OPS_H
+
+#include "esp_lcd_panel_io.h"
+
+esp_err_t esp_lcd_panel_reset(esp_lcd_panel_handle_t panel);
+esp_err_t esp_lcd_panel_init(esp_lcd_panel_handle_t panel);
+esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start,
+                                    int x_end, int y_end, const void *color_data);
+esp_err_t esp_lcd_panel_swap_xy(esp_lcd_panel_handle_t panel, bool swap_axes);
+esp_err_t esp_lcd_panel_mirror(esp_lcd_panel_handle_t panel, bool mirror_x, bool mirror_y);
+esp_err_t esp_lcd_panel_invert_color(esp_lcd_panel_handle_t panel, bool invert);
+esp_err_t esp_lcd_panel_set_gap(esp_lcd_panel_handle_t panel, int x_gap, int y_gap);
+esp_err_t esp_lcd_panel_disp_on_off(esp_lcd_panel_handle_t panel, bool on);
+
+#endif // SIM_ESP_LCD_PANEL_OPS_H
@@ -0,0 +1,35 @@
+/**
+ * @file esp_log.h
+ * @brief ESP-IDF logging for the desktop simulator, printed to stderr
+ */
+
+#ifndef SIM_ESP_LOG_H
+#define SIM_ESP_LOG_H
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include <stdarg.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#define ESP_LOGE(tag, format, ...) esp_log_write(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) esp_log_write(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) esp_log_write(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) esp_log_write(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) esp_log_write(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+
+#endif // SIM_ESP_LOG_H
@@ -0,0 +1,50 @@
+/**
+ * @file esp_partition.h
+ * @brief ESP-IDF flash partitions for the desktop simulator
+ *
+ * A data partition is a host file named by SIM_PARTITION_<LABEL> (e.g.
+ * SIM_PARTITION_ASSETS=build/assets.bin); unset means no partition.
+ */
+
+#ifndef SIM_ESP_PARTITION_H
+#define SIM_ESP_PARTITION_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef enum {
+    ESP_PARTITION_SUBTYPE_ANY = 0xff,
+} esp_partition_subtype_t;
+
+typedef enum {
+    ESP_PARTITION_MMAP_DATA,
+    ESP_PARTITION_MMAP_INST,
+} esp_partition_mmap_memory_t;
+
+typedef uint32_t esp_partition_mmap_handle_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+    const uint8_t *data;        // Simulator: file contents
+} esp_partition_t;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char *label);
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t size);
+esp_err_t esp_partition_mmap(const esp_partition_t *part, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void **out_ptr,
+                             esp_partition_mmap_handle_t *out_handle);
+void esp_partition_munmap(esp_partition_mmap_handle_t handle);
+
+#endif // SIM_ESP_PARTITION_H
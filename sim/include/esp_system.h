@@ -0,0 +1,16 @@
+/**
+ * @file esp_system.h
+ * @brief ESP-IDF system calls for the desktop simulator
+ */
+
+#ifndef SIM_ESP_SYSTEM_H
+#define SIM_ESP_SYSTEM_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+void esp_restart(void) __attribute__((noreturn));
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
+
+#endif // SIM_ESP_SYSTEM_H
@@ -0,0 +1,35 @@
+/**
+ * @file esp_vfs_fat.h
+ * @brief ESP-IDF FAT filesystem mount for the desktop simulator
+ *
+ * There is no card to mount: the "card" is the host directory at the
+ * mount point (e.g. a symlink /sdcard -> ~/sim-card). Mounting fails
+ * when the directory does not exist, as with no card inserted.
+ */
+
+#ifndef SIM_ESP_VFS_FAT_H
+#define SIM_ESP_VFS_FAT_H
+
+#include "esp_err.h"
+#include "sdmmc_cmd.h"
+#include "driver/sdspi_host.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    bool format_if_mount_failed;
+    int max_files;
+    size_t allocation_unit_size;
+    bool disk_status_check_enable;
+} esp_vfs_fat_sdmmc_mount_config_t;
+
+esp_err_t esp_vfs_fat_sdspi_mount(const char *base_path, const sdmmc_host_t *host,
+                                  const sdspi_device_config_t *slot,
+                                  const esp_vfs_fat_sdmmc_mount_config_t *config,
+                                  sdmmc_card_t **out_card);
+esp_err_t esp_vfs_fat_sdcard_unmount(const char *base_path, sdmmc_card_t *card);
+esp_err_t esp_vfs_fat_create_contiguous_file(const char *base_path, const char *full_path,
+                                             uint64_t size, bool alloc_now);
+
+#endif // SIM_ESP_VFS_FAT_H
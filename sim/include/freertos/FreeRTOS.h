@@ -0,0 +1,62 @@
+/**
+ * @file FreeRTOS.h
+ * @brief FreeRTOS kernel API for the desktop simulator, on POSIX threads
+ *
+ * Only the part of the API the firmware uses. Ticks are milliseconds
+ * (CONFIG_FREERTOS_HZ 1000); priorities and core affinity are recorded
+ * but the host scheduler decides. Critical sections share one recursive
+ * lock, which stands in for masking interrupts on both cores.
+ */
+
+#ifndef SIM_FREERTOS_H
+#define SIM_FREERTOS_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "esp_bit_defs.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint8_t StackType_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+#define errQUEUE_FULL           0
+
+#define portMAX_DELAY           ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS      (1000 / CONFIG_FREERTOS_HZ)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * CONFIG_FREERTOS_HZ) / 1000))
+#define tskNO_AFFINITY          0x7FFFFFFF
+#define tskIDLE_PRIORITY        0
+#define configMAX_PRIORITIES    25
+#define configASSERT(x)         do { if (!(x)) abort(); } while (0)
+
+// Critical sections: one process-wide recursive lock
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { 0 }
+#define portMUX_INITIALIZE(mux)         ((void)(mux))
+
+void sim_critical_enter(void);
+void sim_critical_exit(void);
+
+#define portENTER_CRITICAL(mux)         do { (void)(mux); sim_critical_enter(); } while (0)
+#define portEXIT_CRITICAL(mux)          do { (void)(mux); sim_critical_exit(); } while (0)
+#define portENTER_CRITICAL_ISR(mux)     portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)      portEXIT_CRITICAL(mux)
+#define portYIELD_FROM_ISR(...)         ((void)0)
+#define taskENTER_CRITICAL(mux)         portENTER_CRITICAL(mux)
+#define taskEXIT_CRITICAL(mux)          portEXIT_CRITICAL(mux)
+
+BaseType_t xPortGetCoreID(void);
+
+#endif // SIM_FREERTOS_H
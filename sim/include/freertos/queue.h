@@ -0,0 +1,27 @@
+/**
+ * @file queue.h
+ * @brief FreeRTOS queues for the desktop simulator
+ */
+
+#ifndef SIM_FREERTOS_QUEUE_H
+#define SIM_FREERTOS_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+typedef struct sim_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+#define xQueueSendToBack(q, item, ticks)    xQueueSend(q, item, ticks)
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken);
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks);
+BaseType_t xQueueReset(QueueHandle_t queue);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue);
+
+#endif // SIM_FREERTOS_QUEUE_H
@@ -0,0 +1,28 @@
+/**
+ * @file ringbuf.h
+ * @brief ESP-IDF no-split ring buffers for the desktop simulator
+ */
+
+#ifndef SIM_FREERTOS_RINGBUF_H
+#define SIM_FREERTOS_RINGBUF_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct sim_ringbuf *RingbufHandle_t;
+
+typedef enum {
+    RINGBUF_TYPE_NOSPLIT = 0,
+    RINGBUF_TYPE_ALLOWSPLIT,
+    RINGBUF_TYPE_BYTEBUF,
+} RingbufferType_t;
+
+RingbufHandle_t xRingbufferCreate(size_t size, RingbufferType_t type);
+void vRingbufferDelete(RingbufHandle_t buf);
+BaseType_t xRingbufferSend(RingbufHandle_t buf, const void *data, size_t size, TickType_t ticks);
+BaseType_t xRingbufferSendAcquire(RingbufHandle_t buf, void **item, size_t size, TickType_t ticks);
+BaseType_t xRingbufferSendComplete(RingbufHandle_t buf, void *item);
+void *xRingbufferReceive(RingbufHandle_t buf, size_t *size, TickType_t ticks);
+void vRingbufferReturnItem(RingbufHandle_t buf, void *item);
+size_t xRingbufferGetCurFreeSize(RingbufHandle_t buf);
+
+#endif // SIM_FREERTOS_RINGBUF_H
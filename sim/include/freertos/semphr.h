@@ -0,0 +1,29 @@
+/**
+ * @file semphr.h
+ * @brief FreeRTOS semaphores and mutexes for the desktop simulator
+ *
+ * Semaphores are zero-size queues, as in the kernel; mutexes remember
+ * their holder so the recursive kind can be taken again.
+ */
+
+#ifndef SIM_FREERTOS_SEMPHR_H
+#define SIM_FREERTOS_SEMPHR_H
+
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem);
+#define xSemaphoreGiveFromISR(sem, woken)   xSemaphoreGive(sem)
+#define xSemaphoreTakeFromISR(sem, woken)   xSemaphoreTake(sem, 0)
+#define vSemaphoreDelete(sem)               vQueueDelete(sem)
+#define uxSemaphoreGetCount(sem)            uxQueueMessagesWaiting(sem)
+
+#endif // SIM_FREERTOS_SEMPHR_H
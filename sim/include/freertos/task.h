@@ -0,0 +1,45 @@
+/**
+ * @file task.h
+ * @brief FreeRTOS tasks and direct-to-task notifications for the desktop simulator
+ */
+
+#ifndef SIM_FREERTOS_TASK_H
+#define SIM_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct sim_task *TaskHandle_t;
+
+typedef enum {
+    eNoAction = 0,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite,
+} eNotifyAction;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *out,
+                                   BaseType_t core);
+#define xTaskCreate(fn, name, stack, arg, prio, out) \
+    xTaskCreatePinnedToCore(fn, name, stack, arg, prio, out, tskNO_AFFINITY)
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment);
+#define xTaskDelayUntil(prev, inc) (vTaskDelayUntil(prev, inc), pdTRUE)
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+const char *pcTaskGetName(TaskHandle_t task);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+BaseType_t xTaskGetCoreID(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit,
+                           uint32_t *value, TickType_t ticks);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+#define xTaskNotifyGive(task)   xTaskNotify(task, 0, eIncrement)
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+#define xTaskNotifyFromISR(task, value, action, woken) xTaskNotify(task, value, action)
+
+#endif // SIM_FREERTOS_TASK_H
@@ -0,0 +1,36 @@
+/**
+ * @file nvs.h
+ * @brief ESP-IDF non-volatile storage for the desktop simulator
+ *
+ * Each key is a file <SIM_NVS_DIR>/<namespace>.<key> holding its raw
+ * value, written through on every set (default directory "sim_nvs").
+ */
+
+#ifndef SIM_NVS_H
+#define SIM_NVS_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t nvs_handle_t;
+
+typedef enum {
+    NVS_READONLY,
+    NVS_READWRITE,
+} nvs_open_mode_t;
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out);
+void nvs_close(nvs_handle_t handle);
+esp_err_t nvs_commit(nvs_handle_t handle);
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key);
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *length);
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length);
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out);
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value);
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out);
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value);
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char *key, int32_t *out);
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char *key, int32_t value);
+
+#endif // SIM_NVS_H
@@ -0,0 +1,14 @@
+/**
+ * @file nvs_flash.h
+ * @brief ESP-IDF NVS partition setup for the desktop simulator
+ */
+
+#ifndef SIM_NVS_FLASH_H
+#define SIM_NVS_FLASH_H
+
+#include "nvs.h"
+
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
+
+#endif // SIM_NVS_FLASH_H
@@ -0,0 +1,126 @@
+/**
+ * @file sdkconfig.h
+ * @brief Configuration of the desktop simulator build
+ *
+ * Stands in for the file ESP-IDF generates from Kconfig. Project options
+ * take the defaults from main/Kconfig.projbuild, as on a PSRAM board;
+ * keep the two in step when options are added.
+ */
+
+#ifndef SIM_SDKCONFIG_H
+#define SIM_SDKCONFIG_H
+
+// ESP-IDF
+#define CONFIG_IDF_TARGET                   "host"
+#define CONFIG_FREERTOS_HZ                  1000
+#define CONFIG_LOG_DEFAULT_LEVEL            3
+#define CONFIG_LOG_MAXIMUM_LEVEL            4
+#define CONFIG_SPIRAM                       1
+
+// M5MonsterC5 UI
+#define CONFIG_UI_GLYPH_CACHE               1
+#define CONFIG_UI_GLYPH_CACHE_PSRAM         1
+#define CONFIG_UI_COMPACT_FONT              1
+#define CONFIG_SCREEN_ARENA_SIZE_KB         256
+#define CONFIG_SCREEN_STACK_MAX             32
+#define CONFIG_SCREEN_PUSH_MIN_FREE_KB      20
+#define CONFIG_SCREEN_MEM_BUDGET_KB         16
+#define CONFIG_SCREEN_CPU_BUDGET_PCT        30
+#define CONFIG_SCREEN_RECORD_INTERVAL_MS    200
+#define CONFIG_SCREEN_MIRROR_INTERVAL_MS    50
+#define CONFIG_SCREEN_CACHE_TTL_S           60
+#define CONFIG_SCREEN_SNAPSHOT_BUDGET_KB    48
+#define CONFIG_LISTING_PREFETCH_DWELL_MS    300
+#define CONFIG_LINK_REFRESH                 1
+#define CONFIG_POWER_GOVERNOR_BALANCED_LEVEL 50
+#define CONFIG_POWER_GOVERNOR_ENDURANCE_LEVEL 20
+#define CONFIG_KEY_REPEAT_DELAY_MS          400
+#define CONFIG_KEY_REPEAT_RATE_MS           90
+#define CONFIG_KEY_REPEAT_ACCEL_AFTER       8
+#define CONFIG_KEY_REPEAT_FAST_MS           30
+#define CONFIG_KEYBOARD_SCAN_MS             2
+
+// M5MonsterC5 UART link
+#define CONFIG_UART_LOG_DEFAULT_QUIET       1
+#define CONFIG_UART_BAUD_NEGOTIATION        1
+#define CONFIG_UART_BINARY_PROTOCOL         1
+#define CONFIG_UART_FLOW_NONE               1
+#define CONFIG_UART_BULK_COMPRESSION        1
+#define CONFIG_FILE_XFER_WINDOW             16
+#define CONFIG_UART_QUIET_LINK              1
+#define CONFIG_CHANNEL_PLAN_CYCLE_MS        4000
+#define CONFIG_JANOS_CHANNEL_LIST_CMD       "channel_list set"
+#define CONFIG_UART_RX_BUFFER_PSRAM         1
+#define CONFIG_NETWORK_STORE_PSRAM          1
+#define CONFIG_SESSION_LOG                  1
+#define CONFIG_SESSION_LOG_FILE_KB          512
+#define CONFIG_SESSION_LOG_KEEP_FILES       8
+#define CONFIG_SESSION_LOG_COMPRESS         1
+#define CONFIG_STORE_SNAPSHOT               1
+#define CONFIG_STORE_SNAPSHOT_INTERVAL_S    60
+#define CONFIG_CAP_GPS_RATE_HZ              5
+#define CONFIG_CAP_GPS_ASSIST               1
+#define CONFIG_CAP_GPS_HINT_SAVE_S          600
+#define CONFIG_TRACK_LOG_TOLERANCE_M        3
+#define CONFIG_GEO_LOCATE_SAMPLES           128
+#define CONFIG_WIFI_STALE_SCANS             3
+#define CONFIG_WIFI_DIFF_RSSI_DB            10
+
+// M5MonsterC5 capacity
+#define CONFIG_UART_TX_BUFFER_SIZE          4096
+#define CONFIG_UART_RX_RING_SIZE            16384
+#define CONFIG_TERMINAL_SCROLLBACK_SIZE     131072
+#define CONFIG_UART_LINE_MAX                8192
+#define CONFIG_EVENT_BUS_POOL_SIZE          64
+#define CONFIG_NETWORK_STORE_MAX_ENTRIES    2048
+#define CONFIG_BT_STORE_MAX_DEVICES         2048
+#define CONFIG_PROBE_STORE_MAX_ENTRIES      512
+#define CONFIG_CRED_STORE_MAX_ENTRIES       256
+#define CONFIG_CAPTURE_INDEX_MAX            1024
+#define CONFIG_HTML_PREVIEW_CACHE_CHUNKS    32
+#define CONFIG_TRACKER_DB_MAX_DEVICES       4096
+#define CONFIG_SNIFFER_MAX_APS              256
+#define CONFIG_SNIFFER_MAX_CLIENTS          4096
+#define CONFIG_STATION_MAX_AGE_S            300
+#define CONFIG_ARP_MAX_HOSTS                2048
+#define CONFIG_SNIFFER_DOG_MAX_PAIRS        1024
+#define CONFIG_DEAUTH_MAX_BSSIDS            256
+#define CONFIG_WATCHLIST_MAX_ENTRIES        512
+#define CONFIG_ROGUE_AP_SAVED_PASSWORDS     32
+#define CONFIG_INPUT_HISTORY_DEPTH          8
+
+// M5MonsterC5 tasks (stack sizes are recorded, host threads get their own)
+#define CONFIG_TASK_UART_RX_STACK           4096
+#define CONFIG_TASK_UART_RX_PRIO            10
+#define CONFIG_TASK_GPS_STACK               4096
+#define CONFIG_TASK_GPS_PRIO                5
+#define CONFIG_TASK_RENDER_STACK            4096
+#define CONFIG_TASK_RENDER_PRIO             4
+#define CONFIG_TASK_KEYBOARD_STACK          3072
+#define CONFIG_TASK_KEYBOARD_PRIO           6
+#define CONFIG_TASK_AUDIO_STACK             3072
+#define CONFIG_TASK_AUDIO_PRIO              3
+#define CONFIG_TASK_USB_BRIDGE_STACK        3072
+#define CONFIG_TASK_TRANSCRIPT_STACK        4096
+#define CONFIG_TASK_SCREEN_MIRROR_STACK     3072
+#define CONFIG_TASK_FILE_XFER_STACK         4096
+#define CONFIG_TASK_SCENARIO_STACK          4096
+#define CONFIG_TASK_SESSION_LOG_STACK       4096
+#define CONFIG_TASK_WARDRIVE_LOG_STACK      3072
+#define CONFIG_TASK_TRACK_LOG_STACK         3072
+#define CONFIG_TASK_TRACKER_DB_STACK        3072
+#define CONFIG_TASK_SNAPSHOT_STACK          4096
+#define CONFIG_TASK_EXPORT_STACK            4096
+#define CONFIG_TASK_SCREENSHOT_STACK        4096
+#define CONFIG_TASK_SCREEN_RECORD_STACK     4096
+#define CONFIG_TASK_BOOT_STACK              4096
+#define CONFIG_TASK_STACK_REPORT_S          0
+#define CONFIG_STALL_WATCH_MS               20
+#define CONFIG_MEM_MONITOR_PERIOD_MS        1000
+#define CONFIG_MEM_LOW_FREE_KB              32
+#define CONFIG_MEM_LOW_BLOCK_KB             12
+
+// M5MonsterC5 assets
+#define CONFIG_ASSETS_VERIFY_CRC            1
+
+#endif // SIM_SDKCONFIG_H
@@ -0,0 +1,26 @@
+/**
+ * @file sdmmc_cmd.h
+ * @brief ESP-IDF SD card protocol layer for the desktop simulator
+ */
+
+#ifndef SIM_SDMMC_CMD_H
+#define SIM_SDMMC_CMD_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+    int slot;
+    int max_freq_khz;
+} sdmmc_host_t;
+
+typedef struct {
+    sdmmc_host_t host;
+    uint64_t capacity_bytes;
+} sdmmc_card_t;
+
+esp_err_t sdmmc_card_init(const sdmmc_host_t *host, sdmmc_card_t *card);
+void sdmmc_card_print_info(FILE *stream, const sdmmc_card_t *card);
+
+#endif // SIM_SDMMC_CMD_H
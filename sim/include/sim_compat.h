@@ -0,0 +1,20 @@
+/**
+ * @file sim_compat.h
+ * @brief C library extras newlib has and the host C library may lack
+ *
+ * Force-included into every simulator translation unit.
+ */
+
+#ifndef SIM_COMPAT_H
+#define SIM_COMPAT_H
+
+#include <stddef.h>
+#include <string.h>
+
+#if !defined(__GLIBC__) || __GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char *dst, const char *src, size_t size);
+size_t strlcat(char *dst, const char *src, size_t size);
+#define SIM_NEED_STRLCPY 1
+#endif
+
+#endif // SIM_COMPAT_H
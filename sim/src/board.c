@@ -0,0 +1,157 @@
+/**
+ * @file board.c
+ * @brief Board peripherals the desktop simulator does without
+ *
+ * Battery, audio, power management, USB mass storage and the survey
+ * link are hardware the host does not have. Each keeps its API so the
+ * screens that use it behave as they do on a board where it is missing.
+ * SIM_BATTERY=<percent> fakes a battery at a fixed level.
+ */
+
+#include "battery.h"
+#include "buzzer.h"
+#include "power.h"
+#include "usb_msc.h"
+#include "survey_link.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ---------------------------------------------------------------------------
+// Battery
+// ---------------------------------------------------------------------------
+
+static int battery_level = -1;
+
+esp_err_t battery_init(void)
+{
+    const char *level = getenv("SIM_BATTERY");
+    if (!level) return ESP_ERR_NOT_SUPPORTED;
+    battery_level = atoi(level);
+    if (battery_level < 0) battery_level = 0;
+    if (battery_level > 100) battery_level = 100;
+    return ESP_OK;
+}
+
+battery_reading_t battery_get_reading(void)
+{
+    battery_reading_t reading = {
+        .voltage_mv = battery_get_voltage_mv(),
+        .level = battery_level,
+        .trend = battery_level < 0 ? BATTERY_TREND_UNKNOWN : BATTERY_TREND_STABLE,
+        .runtime_min = -1,
+    };
+    return reading;
+}
+
+int battery_get_level(void)
+{
+    return battery_level;
+}
+
+int battery_get_voltage_mv(void)
+{
+    // Linear over the 3.0-4.2 V range battery.c maps to 0-100%
+    return battery_level < 0 ? -1 : 3000 + battery_level * 12;
+}
+
+bool battery_is_available(void)
+{
+    return battery_level >= 0;
+}
+
+// ---------------------------------------------------------------------------
+// Buzzer
+// ---------------------------------------------------------------------------
+
+esp_err_t buzzer_init(void)
+{
+    return ESP_OK;
+}
+
+void buzzer_beep(uint32_t frequency_hz, uint32_t duration_ms)
+{
+    (void)frequency_hz;
+    (void)duration_ms;
+}
+
+void buzzer_play(const buzzer_tone_t *tones, int count)
+{
+    (void)tones;
+    (void)count;
+}
+
+void buzzer_play_sample(const buzzer_sample_t *sample)
+{
+    (void)sample;
+}
+
+void buzzer_beep_attack(void) {}
+void buzzer_beep_success(void) {}
+void buzzer_beep_capture(void) {}
+void buzzer_stop(void) {}
+
+// ---------------------------------------------------------------------------
+// Power management
+// ---------------------------------------------------------------------------
+
+esp_err_t power_init(void)
+{
+    return ESP_OK;
+}
+
+void power_acquire(power_lock_t lock)
+{
+    (void)lock;
+}
+
+void power_release(power_lock_t lock)
+{
+    (void)lock;
+}
+
+// ---------------------------------------------------------------------------
+// USB mass storage
+// ---------------------------------------------------------------------------
+
+esp_err_t usb_msc_start(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void usb_msc_stop(void) {}
+
+bool usb_msc_is_active(void)
+{
+    return false;
+}
+
+void usb_msc_get_status(usb_msc_status_t *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+// ---------------------------------------------------------------------------
+// Survey link
+// ---------------------------------------------------------------------------
+
+esp_err_t survey_link_init(void)
+{
+    return ESP_OK;
+}
+
+survey_role_t survey_link_role(void)
+{
+    return SURVEY_ROLE_OFF;
+}
+
+void survey_link_get_stats(survey_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+int survey_link_units(survey_unit_t *out, int max)
+{
+    (void)out;
+    (void)max;
+    return 0;
+}
@@ -0,0 +1,329 @@
+/**
+ * @file esp_system.c
+ * @brief ESP-IDF system services for the desktop simulator
+ *
+ * Logging, error names, the capability heap, restart, ROM helpers and
+ * data partitions backed by host files.
+ */
+
+#include "esp_log.h"
+#include "esp_err.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_cpu.h"
+#include "esp_rom_crc.h"
+#include "esp_rom_sys.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "sim_compat.h"
+#include <malloc.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------
+// Logging
+// ---------------------------------------------------------------------------
+
+#define LOG_TAG_LEVELS  16
+
+typedef struct {
+    char tag[24];
+    esp_log_level_t level;
+} tag_level_t;
+
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+static esp_log_level_t default_level = CONFIG_LOG_DEFAULT_LEVEL;
+static tag_level_t tag_levels[LOG_TAG_LEVELS];
+static int tag_level_count = 0;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    pthread_mutex_lock(&log_lock);
+    if (strcmp(tag, "*") == 0) {
+        default_level = level;
+        tag_level_count = 0;
+    } else {
+        int i = 0;
+        while (i < tag_level_count && strcmp(tag_levels[i].tag, tag) != 0) i++;
+        if (i < LOG_TAG_LEVELS) {
+            strlcpy(tag_levels[i].tag, tag, sizeof(tag_levels[i].tag));
+            tag_levels[i].level = level;
+            if (i == tag_level_count) tag_level_count++;
+        }
+    }
+    pthread_mutex_unlock(&log_lock);
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    static const char letters[] = "NEWIDV";
+    static const char *colors[] = {"", "\033[0;31m", "\033[0;33m", "\033[0;32m", "", ""};
+
+    pthread_mutex_lock(&log_lock);
+    esp_log_level_t limit = default_level;
+    for (int i = 0; i < tag_level_count; i++) {
+        if (strcmp(tag_levels[i].tag, tag) == 0) {
+            limit = tag_levels[i].level;
+            break;
+        }
+    }
+    if (level > limit || level == ESP_LOG_NONE) {
+        pthread_mutex_unlock(&log_lock);
+        return;
+    }
+
+    bool color = isatty(STDERR_FILENO) && colors[level][0];
+    fprintf(stderr, "%s%c (%lld) %s: ", color ? colors[level] : "", letters[level],
+            (long long)(esp_timer_get_time() / 1000), tag);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputs(color ? "\033[0m\n" : "\n", stderr);
+    pthread_mutex_unlock(&log_lock);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:                        return "ESP_OK";
+        case ESP_FAIL:                      return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:                return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:           return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:         return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:          return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:             return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:         return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:               return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE:      return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_CRC:           return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_INVALID_VERSION:       return "ESP_ERR_INVALID_VERSION";
+        case ESP_ERR_NVS_NOT_FOUND:         return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_INVALID_LENGTH:    return "ESP_ERR_NVS_INVALID_LENGTH";
+        case ESP_ERR_NVS_NO_FREE_PAGES:     return "ESP_ERR_NVS_NO_FREE_PAGES";
+        case ESP_ERR_NVS_NEW_VERSION_FOUND: return "ESP_ERR_NVS_NEW_VERSION_FOUND";
+        default:                            return "UNKNOWN ERROR";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Heap
+// ---------------------------------------------------------------------------
+
+// Cardputer-ADV: internal SRAM left to the application, and 8 MB PSRAM
+#define SIM_INTERNAL_BYTES  (320 * 1024)
+#define SIM_PSRAM_BYTES     (8 * 1024 * 1024)
+
+static size_t psram_low_water = SIM_PSRAM_BYTES;
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    return malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return calloc(n, size);
+}
+
+void *heap_caps_realloc(void *ptr, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return realloc(ptr, size);
+}
+
+void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+size_t heap_caps_get_allocated_size(void *ptr)
+{
+    return malloc_usable_size(ptr);
+}
+
+size_t heap_caps_get_total_size(uint32_t caps)
+{
+    return (caps & MALLOC_CAP_SPIRAM) ? SIM_PSRAM_BYTES : SIM_INTERNAL_BYTES;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    if (!(caps & MALLOC_CAP_SPIRAM)) return SIM_INTERNAL_BYTES;
+    struct mallinfo2 info = mallinfo2();
+    size_t used = info.uordblks + info.hblkhd;
+    size_t free_bytes = used < SIM_PSRAM_BYTES ? SIM_PSRAM_BYTES - used : 0;
+    if (free_bytes < psram_low_water) psram_low_water = free_bytes;
+    return free_bytes;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    size_t now = heap_caps_get_free_size(caps);
+    return (caps & MALLOC_CAP_SPIRAM) ? psram_low_water : now;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return heap_caps_get_free_size(caps);
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return (uint32_t)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) +
+                      heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    return (uint32_t)(heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL) +
+                      heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+}
+
+// ---------------------------------------------------------------------------
+// System and ROM
+// ---------------------------------------------------------------------------
+
+void esp_restart(void)
+{
+    ESP_LOGW("SIM", "esp_restart() - exiting");
+    fflush(NULL);
+    exit(0);
+}
+
+uint32_t esp_cpu_get_cycle_count(void)
+{
+    return (uint32_t)(esp_timer_get_time() * SIM_CPU_MHZ);
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    usleep(us);
+}
+
+static uint32_t crc_table[256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void crc_table_build(void)
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+        crc_table[i] = c;
+    }
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    pthread_once(&crc_once, crc_table_build);
+
+    crc = ~crc;
+    while (len--) crc = crc_table[(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+#ifdef SIM_NEED_STRLCPY
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+
+size_t strlcat(char *dst, const char *src, size_t size)
+{
+    size_t used = strnlen(dst, size);
+    if (used == size) return size + strlen(src);
+    return used + strlcpy(dst + used, src, size - used);
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Partitions
+// ---------------------------------------------------------------------------
+
+#define SIM_PARTITIONS_MAX  4
+
+static esp_partition_t partitions[SIM_PARTITIONS_MAX];
+static int partition_count = 0;
+
+/**
+ * @brief Load the host file SIM_PARTITION_<LABEL> names, once
+ */
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    (void)subtype;
+    if (type != ESP_PARTITION_TYPE_DATA || !label) return NULL;
+    for (int i = 0; i < partition_count; i++) {
+        if (strcmp(partitions[i].label, label) == 0) return &partitions[i];
+    }
+    if (partition_count == SIM_PARTITIONS_MAX) return NULL;
+
+    char var[48] = "SIM_PARTITION_";
+    for (size_t i = strlen(var), j = 0; label[j] && i < sizeof(var) - 1; i++, j++) {
+        var[i] = (char)(label[j] >= 'a' && label[j] <= 'z' ? label[j] - 32 : label[j]);
+        var[i + 1] = '\0';
+    }
+    const char *path = getenv(var);
+    if (!path) return NULL;
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        ESP_LOGW("SIM", "%s=%s cannot be opened", var, path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = size > 0 ? malloc((size_t)size) : NULL;
+    if (!data || fread(data, 1, (size_t)size, f) != (size_t)size) {
+        free(data);
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+
+    esp_partition_t *part = &partitions[partition_count++];
+    part->type = type;
+    part->subtype = subtype;
+    part->size = (uint32_t)size;
+    part->data = data;
+    strlcpy(part->label, label, sizeof(part->label));
+    return part;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t size)
+{
+    if (!part || offset + size > part->size) return ESP_ERR_INVALID_SIZE;
+    memcpy(dst, part->data + offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *part, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void **out_ptr,
+                             esp_partition_mmap_handle_t *out_handle)
+{
+    (void)memory;
+    if (!part || offset + size > part->size) return ESP_ERR_INVALID_SIZE;
+    *out_ptr = part->data + offset;
+    *out_handle = 0;
+    return ESP_OK;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle)
+{
+    (void)handle;   // The file stays loaded
+}
@@ -0,0 +1,191 @@
+/**
+ * @file esp_timer.c
+ * @brief ESP-IDF high resolution timers for the desktop simulator
+ *
+ * One dispatch thread runs the callbacks in deadline order, like the
+ * esp_timer task on the device. Armed timers sit in a list sorted by
+ * deadline; there are a few dozen at most.
+ */
+
+#include "esp_timer.h"
+#include "esp_log.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+    int64_t due_us;
+    uint64_t period_us;             // 0 for one-shot timers
+    bool armed;
+    struct esp_timer *next;         // Armed list, by deadline
+};
+
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_changed;
+static pthread_once_t timer_once = PTHREAD_ONCE_INIT;
+static pthread_t dispatch_thread;
+static struct esp_timer *armed = NULL;
+static struct esp_timer *running = NULL;    // Callback in progress
+static int64_t boot_us = 0;
+
+static int64_t monotonic_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    if (boot_us == 0) boot_us = monotonic_us();
+    return monotonic_us() - boot_us;
+}
+
+static void unlink_timer(struct esp_timer *timer)
+{
+    for (struct esp_timer **link = &armed; *link; link = &(*link)->next) {
+        if (*link == timer) {
+            *link = timer->next;
+            break;
+        }
+    }
+    timer->next = NULL;
+    timer->armed = false;
+}
+
+static void insert_timer(struct esp_timer *timer)
+{
+    struct esp_timer **link = &armed;
+    while (*link && (*link)->due_us <= timer->due_us) link = &(*link)->next;
+    timer->next = *link;
+    *link = timer;
+    timer->armed = true;
+}
+
+static void *dispatch_task(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&timer_lock);
+    for (;;) {
+        if (!armed) {
+            pthread_cond_wait(&timer_changed, &timer_lock);
+            continue;
+        }
+        int64_t now = esp_timer_get_time();
+        struct esp_timer *timer = armed;
+        if (timer->due_us > now) {
+            int64_t due = boot_us + timer->due_us;
+            struct timespec deadline = {
+                .tv_sec = due / 1000000,
+                .tv_nsec = (long)(due % 1000000) * 1000,
+            };
+            pthread_cond_timedwait(&timer_changed, &timer_lock, &deadline);
+            continue;
+        }
+
+        unlink_timer(timer);
+        if (timer->period_us > 0) {
+            // Skip periods missed while the process was stopped (debugger, perf)
+            timer->due_us += timer->period_us;
+            if (timer->due_us < now) timer->due_us = now + timer->period_us;
+            insert_timer(timer);
+        }
+        running = timer;
+        pthread_mutex_unlock(&timer_lock);
+        timer->callback(timer->arg);
+        pthread_mutex_lock(&timer_lock);
+        running = NULL;
+        pthread_cond_broadcast(&timer_changed);
+    }
+    return NULL;
+}
+
+static void timer_init(void)
+{
+    esp_timer_get_time();
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&timer_changed, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_create(&dispatch_thread, NULL, dispatch_task, NULL);
+    pthread_setname_np(dispatch_thread, "esp_timer");
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out)
+{
+    if (!args || !args->callback || !out) return ESP_ERR_INVALID_ARG;
+    pthread_once(&timer_once, timer_init);
+    struct esp_timer *timer = calloc(1, sizeof(*timer));
+    if (!timer) return ESP_ERR_NO_MEM;
+    timer->callback = args->callback;
+    timer->arg = args->arg;
+    timer->name = args->name;
+    *out = timer;
+    return ESP_OK;
+}
+
+static esp_err_t timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us)
+{
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&timer_lock);
+    if (timer->armed) {
+        pthread_mutex_unlock(&timer_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->due_us = esp_timer_get_time() + (int64_t)timeout_us;
+    timer->period_us = period_us;
+    insert_timer(timer);
+    pthread_cond_broadcast(&timer_changed);
+    pthread_mutex_unlock(&timer_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    return timer_start(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&timer_lock);
+    bool was_armed = timer->armed;
+    if (was_armed) unlink_timer(timer);
+    pthread_mutex_unlock(&timer_lock);
+    return was_armed ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&timer_lock);
+    if (timer->armed) {
+        pthread_mutex_unlock(&timer_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    // A callback still running elsewhere must finish before the memory goes
+    while (running == timer && !pthread_equal(pthread_self(), dispatch_thread)) {
+        pthread_cond_wait(&timer_changed, &timer_lock);
+    }
+    pthread_mutex_unlock(&timer_lock);
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    pthread_mutex_lock(&timer_lock);
+    bool active = timer && timer->armed;
+    pthread_mutex_unlock(&timer_lock);
+    return active;
+}
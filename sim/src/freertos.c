@@ -0,0 +1,788 @@
+/**
+ * @file freertos.c
+ * @brief FreeRTOS kernel objects for the desktop simulator, on POSIX threads
+ *
+ * Every queue, semaphore, ring buffer, event group and task notification
+ * lives under one kernel lock and one condition variable: a thread that
+ * blocks waits for any change and re-checks its own condition. That is
+ * plenty for a UI that exchanges a few hundred messages a second, and it
+ * keeps the blocking rules (timeouts, portMAX_DELAY, zero-tick polls) in
+ * one place.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/ringbuf.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "SIM_RTOS";
+
+#define SIM_TASK_STACK_MIN  (256 * 1024)    // Host frames are larger than Xtensa ones
+
+static pthread_mutex_t kernel_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t kernel_changed;
+static pthread_once_t kernel_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t critical_lock;
+static struct timespec boot_time;
+
+struct sim_task {
+    pthread_t thread;
+    char name[16];
+    TaskFunction_t fn;
+    void *arg;
+    UBaseType_t priority;
+    BaseType_t core;
+    uint32_t stack_depth;
+    uint32_t notify_value;
+    bool notify_pending;
+};
+
+static __thread struct sim_task *current_task = NULL;
+
+static void kernel_init(void)
+{
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&kernel_changed, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    pthread_mutexattr_t mutex_attr;
+    pthread_mutexattr_init(&mutex_attr);
+    pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&critical_lock, &mutex_attr);
+    pthread_mutexattr_destroy(&mutex_attr);
+
+    clock_gettime(CLOCK_MONOTONIC, &boot_time);
+}
+
+static inline void kernel_enter(void)
+{
+    pthread_once(&kernel_once, kernel_init);
+    pthread_mutex_lock(&kernel_lock);
+}
+
+static inline void kernel_exit_changed(void)
+{
+    pthread_cond_broadcast(&kernel_changed);
+    pthread_mutex_unlock(&kernel_lock);
+}
+
+static inline void kernel_exit(void)
+{
+    pthread_mutex_unlock(&kernel_lock);
+}
+
+/**
+ * @brief Absolute monotonic time ticks from now
+ */
+static struct timespec deadline_after(TickType_t ticks)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    uint64_t ms = (uint64_t)ticks * portTICK_PERIOD_MS;
+    t.tv_sec += ms / 1000;
+    t.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (t.tv_nsec >= 1000000000L) {
+        t.tv_sec++;
+        t.tv_nsec -= 1000000000L;
+    }
+    return t;
+}
+
+/**
+ * @brief Wait for the next change under the kernel lock
+ * @return false once the deadline has passed
+ */
+static bool kernel_wait(TickType_t ticks, const struct timespec *deadline)
+{
+    if (ticks == 0) return false;
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(&kernel_changed, &kernel_lock);
+        return true;
+    }
+    return pthread_cond_timedwait(&kernel_changed, &kernel_lock, deadline) != ETIMEDOUT;
+}
+
+void sim_critical_enter(void)
+{
+    pthread_once(&kernel_once, kernel_init);
+    pthread_mutex_lock(&critical_lock);
+}
+
+void sim_critical_exit(void)
+{
+    pthread_mutex_unlock(&critical_lock);
+}
+
+// ---------------------------------------------------------------------------
+// Tasks
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief Task record of the calling thread, made up for threads not started as tasks
+ */
+static struct sim_task *self(void)
+{
+    if (!current_task) {
+        struct sim_task *t = calloc(1, sizeof(*t));
+        if (!t) abort();
+        t->thread = pthread_self();
+        if (pthread_getname_np(t->thread, t->name, sizeof(t->name)) != 0) {
+            strcpy(t->name, "host");
+        }
+        t->core = tskNO_AFFINITY;
+        current_task = t;
+    }
+    return current_task;
+}
+
+static void *task_entry(void *arg)
+{
+    struct sim_task *t = arg;
+    current_task = t;
+    t->fn(t->arg);
+    ESP_LOGE(TAG, "Task %s returned without deleting itself", t->name);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *out,
+                                   BaseType_t core)
+{
+    pthread_once(&kernel_once, kernel_init);
+    struct sim_task *t = calloc(1, sizeof(*t));
+    if (!t) return pdFAIL;
+    strncpy(t->name, name ? name : "task", sizeof(t->name) - 1);
+    t->fn = fn;
+    t->arg = arg;
+    t->priority = priority;
+    t->core = core;
+    t->stack_depth = stack_depth;
+
+    // The handle must be valid before the task can look itself up
+    if (out) *out = t;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    size_t stack = stack_depth * 4;
+    pthread_attr_setstacksize(&attr, stack > SIM_TASK_STACK_MIN ? stack : SIM_TASK_STACK_MIN);
+    int ret = pthread_create(&t->thread, &attr, task_entry, t);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        if (out) *out = NULL;
+        free(t);
+        return pdFAIL;
+    }
+    pthread_setname_np(t->thread, t->name);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL || task == current_task) {
+        // The record stays allocated: other tasks may still hold the handle
+        pthread_exit(NULL);
+    }
+    ESP_LOGE(TAG, "Deleting another task (%s) is not simulated", task->name);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    pthread_once(&kernel_once, kernel_init);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t ms = (uint64_t)(now.tv_sec - boot_time.tv_sec) * 1000 +
+                  (now.tv_nsec - boot_time.tv_nsec) / 1000000;
+    return (TickType_t)(ms / portTICK_PERIOD_MS);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (ticks == 0) {
+        sched_yield();
+        return;
+    }
+    struct timespec t = {
+        .tv_sec = (ticks * portTICK_PERIOD_MS) / 1000,
+        .tv_nsec = (long)((ticks * portTICK_PERIOD_MS) % 1000) * 1000000L,
+    };
+    while (nanosleep(&t, &t) != 0 && errno == EINTR) {
+    }
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment)
+{
+    *previous_wake += increment;
+    int32_t left = (int32_t)(*previous_wake - xTaskGetTickCount());
+    if (left > 0) vTaskDelay((TickType_t)left);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return self();
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+    return (task ? task : self())->name;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+    return (task ? task : self())->priority;
+}
+
+BaseType_t xTaskGetCoreID(TaskHandle_t task)
+{
+    return (task ? task : self())->core;
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    BaseType_t core = self()->core;
+    return core == tskNO_AFFINITY ? 0 : core;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    // Host stacks are sized generously and not measured
+    return (task ? task : self())->stack_depth;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    BaseType_t ret = pdPASS;
+    kernel_enter();
+    switch (action) {
+        case eSetBits:
+            task->notify_value |= value;
+            break;
+        case eIncrement:
+            task->notify_value++;
+            break;
+        case eSetValueWithOverwrite:
+            task->notify_value = value;
+            break;
+        case eSetValueWithoutOverwrite:
+            if (task->notify_pending) {
+                ret = pdFAIL;
+            } else {
+                task->notify_value = value;
+            }
+            break;
+        case eNoAction:
+            break;
+    }
+    task->notify_pending = true;
+    kernel_exit_changed();
+    return ret;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    xTaskNotify(task, 0, eIncrement);
+    if (woken) *woken = pdFALSE;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit,
+                           uint32_t *value, TickType_t ticks)
+{
+    struct sim_task *t = self();
+    struct timespec deadline = deadline_after(ticks);
+    kernel_enter();
+    if (!t->notify_pending) {
+        t->notify_value &= ~clear_on_entry;
+    }
+    while (!t->notify_pending) {
+        if (!kernel_wait(ticks, &deadline)) break;
+    }
+    BaseType_t got = t->notify_pending ? pdTRUE : pdFALSE;
+    if (value) *value = t->notify_value;
+    if (got) {
+        t->notify_value &= ~clear_on_exit;
+        t->notify_pending = false;
+    }
+    kernel_exit();
+    return got;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    struct sim_task *t = self();
+    struct timespec deadline = deadline_after(ticks);
+    kernel_enter();
+    while (t->notify_value == 0) {
+        if (!kernel_wait(ticks, &deadline)) break;
+    }
+    uint32_t value = t->notify_value;
+    if (value != 0) {
+        t->notify_value = clear_on_exit ? 0 : value - 1;
+    }
+    t->notify_pending = false;
+    kernel_exit();
+    return value;
+}
+
+// ---------------------------------------------------------------------------
+// Queues and semaphores
+// ---------------------------------------------------------------------------
+
+typedef enum {
+    QUEUE_PLAIN,
+    QUEUE_MUTEX,
+    QUEUE_RECURSIVE_MUTEX,
+} queue_kind_t;
+
+struct sim_queue {
+    queue_kind_t kind;
+    UBaseType_t length;
+    UBaseType_t item_size;      // 0 for semaphores: only count matters
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t *items;
+    struct sim_task *holder;    // Mutexes
+    UBaseType_t depth;          // Recursive mutexes
+};
+
+static QueueHandle_t queue_create(queue_kind_t kind, UBaseType_t length, UBaseType_t item_size)
+{
+    struct sim_queue *q = calloc(1, sizeof(*q));
+    if (!q) return NULL;
+    q->kind = kind;
+    q->length = length;
+    q->item_size = item_size;
+    if (item_size > 0) {
+        q->items = malloc((size_t)length * item_size);
+        if (!q->items) {
+            free(q);
+            return NULL;
+        }
+    }
+    return q;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    return queue_create(QUEUE_PLAIN, length, item_size);
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (!queue) return;
+    free(queue->items);
+    free(queue);
+}
+
+static BaseType_t queue_send(QueueHandle_t q, const void *item, TickType_t ticks, bool front)
+{
+    struct timespec deadline = deadline_after(ticks);
+    kernel_enter();
+    while (q->count >= q->length) {
+        if (!kernel_wait(ticks, &deadline)) {
+            kernel_exit();
+            return errQUEUE_FULL;
+        }
+    }
+    if (q->item_size > 0) {
+        UBaseType_t slot;
+        if (front) {
+            q->head = (q->head + q->length - 1) % q->length;
+            slot = q->head;
+        } else {
+            slot = (q->head + q->count) % q->length;
+        }
+        memcpy(q->items + (size_t)slot * q->item_size, item, q->item_size);
+    }
+    q->count++;
+    kernel_exit_changed();
+    return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    return queue_send(queue, item, ticks, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    return queue_send(queue, item, ticks, true);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken)
+{
+    if (woken) *woken = pdFALSE;
+    return queue_send(queue, item, 0, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item)
+{
+    kernel_enter();
+    queue->head = 0;
+    queue->count = 0;
+    kernel_exit();
+    return queue_send(queue, item, 0, false);
+}
+
+static BaseType_t queue_receive(QueueHandle_t q, void *item, TickType_t ticks, bool peek)
+{
+    struct timespec deadline = deadline_after(ticks);
+    kernel_enter();
+    while (q->count == 0) {
+        if (!kernel_wait(ticks, &deadline)) {
+            kernel_exit();
+            return pdFALSE;
+        }
+    }
+    if (q->item_size > 0 && item) {
+        memcpy(item, q->items + (size_t)q->head * q->item_size, q->item_size);
+    }
+    if (!peek) {
+        q->head = (q->head + 1) % q->length;
+        q->count--;
+    }
+    kernel_exit_changed();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    return queue_receive(queue, item, ticks, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    return queue_receive(queue, item, ticks, true);
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    kernel_enter();
+    queue->head = 0;
+    queue->count = 0;
+    kernel_exit_changed();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    kernel_enter();
+    UBaseType_t count = queue->count;
+    kernel_exit();
+    return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    kernel_enter();
+    UBaseType_t spaces = queue->length - queue->count;
+    kernel_exit();
+    return spaces;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t sem = queue_create(QUEUE_MUTEX, 1, 0);
+    if (sem) sem->count = 1;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+    SemaphoreHandle_t sem = queue_create(QUEUE_RECURSIVE_MUTEX, 1, 0);
+    if (sem) sem->count = 1;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return queue_create(QUEUE_PLAIN, 1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    SemaphoreHandle_t sem = queue_create(QUEUE_PLAIN, max, 0);
+    if (sem) sem->count = initial;
+    return sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    struct sim_task *t = self();
+    struct timespec deadline = deadline_after(ticks);
+    kernel_enter();
+    if (sem->kind == QUEUE_RECURSIVE_MUTEX && sem->holder == t) {
+        sem->depth++;
+        kernel_exit();
+        return pdTRUE;
+    }
+    while (sem->count == 0) {
+        if (!kernel_wait(ticks, &deadline)) {
+            kernel_exit();
+            return pdFALSE;
+        }
+    }
+    sem->count--;
+    if (sem->kind != QUEUE_PLAIN) {
+        sem->holder = t;
+        sem->depth = 1;
+    }
+    kernel_exit();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    kernel_enter();
+    if (sem->kind != QUEUE_PLAIN) {
+        if (sem->holder != current_task) {
+            kernel_exit();
+            return pdFALSE;
+        }
+        if (--sem->depth > 0) {
+            kernel_exit();
+            return pdTRUE;
+        }
+        sem->holder = NULL;
+    } else if (sem->count >= sem->length) {
+        kernel_exit();
+        return pdFALSE;
+    }
+    sem->count++;
+    kernel_exit_changed();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    return xSemaphoreTake(sem, ticks);
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem)
+{
+    return xSemaphoreGive(sem);
+}
+
+// ---------------------------------------------------------------------------
+// Ring buffers (no-split items, FIFO)
+// ---------------------------------------------------------------------------
+
+typedef struct rb_item {
+    struct rb_item *next;
+    size_t size;
+    size_t charge;              // Bytes counted against the buffer size
+    bool complete;              // Sent, or acquired and completed
+    bool received;              // Handed out, not yet returned
+    uint8_t data[];
+} rb_item_t;
+
+struct sim_ringbuf {
+    size_t capacity;
+    size_t used;
+    rb_item_t *head;
+    rb_item_t *tail;
+};
+
+#define RB_ITEM_OVERHEAD    8
+
+RingbufHandle_t xRingbufferCreate(size_t size, RingbufferType_t type)
+{
+    if (type != RINGBUF_TYPE_NOSPLIT) {
+        ESP_LOGE(TAG, "Only no-split ring buffers are simulated");
+        return NULL;
+    }
+    struct sim_ringbuf *buf = calloc(1, sizeof(*buf));
+    if (buf) buf->capacity = size;
+    return buf;
+}
+
+void vRingbufferDelete(RingbufHandle_t buf)
+{
+    if (!buf) return;
+    rb_item_t *item = buf->head;
+    while (item) {
+        rb_item_t *next = item->next;
+        free(item);
+        item = next;
+    }
+    free(buf);
+}
+
+static rb_item_t *ringbuf_reserve(RingbufHandle_t buf, size_t size, TickType_t ticks)
+{
+    size_t charge = ((size + 3) & ~(size_t)3) + RB_ITEM_OVERHEAD;
+    if (charge > buf->capacity) return NULL;
+    struct timespec deadline = deadline_after(ticks);
+    while (buf->used + charge > buf->capacity) {
+        if (!kernel_wait(ticks, &deadline)) return NULL;
+    }
+    rb_item_t *item = malloc(sizeof(*item) + size);
+    if (!item) return NULL;
+    item->next = NULL;
+    item->size = size;
+    item->charge = charge;
+    item->complete = false;
+    item->received = false;
+    if (buf->tail) {
+        buf->tail->next = item;
+    } else {
+        buf->head = item;
+    }
+    buf->tail = item;
+    buf->used += charge;
+    return item;
+}
+
+BaseType_t xRingbufferSend(RingbufHandle_t buf, const void *data, size_t size, TickType_t ticks)
+{
+    kernel_enter();
+    rb_item_t *item = ringbuf_reserve(buf, size, ticks);
+    if (!item) {
+        kernel_exit();
+        return pdFALSE;
+    }
+    memcpy(item->data, data, size);
+    item->complete = true;
+    kernel_exit_changed();
+    return pdTRUE;
+}
+
+BaseType_t xRingbufferSendAcquire(RingbufHandle_t buf, void **out, size_t size, TickType_t ticks)
+{
+    kernel_enter();
+    rb_item_t *item = ringbuf_reserve(buf, size, ticks);
+    kernel_exit();
+    if (!item) return pdFALSE;
+    *out = item->data;
+    return pdTRUE;
+}
+
+BaseType_t xRingbufferSendComplete(RingbufHandle_t buf, void *data)
+{
+    (void)buf;
+    rb_item_t *item = (rb_item_t *)((uint8_t *)data - offsetof(rb_item_t, data));
+    kernel_enter();
+    item->complete = true;
+    kernel_exit_changed();
+    return pdTRUE;
+}
+
+void *xRingbufferReceive(RingbufHandle_t buf, size_t *size, TickType_t ticks)
+{
+    struct timespec deadline = deadline_after(ticks);
+    kernel_enter();
+    for (;;) {
+        // Oldest item not yet handed out; an incomplete one holds up the rest
+        rb_item_t *item = buf->head;
+        while (item && item->received) item = item->next;
+        if (item && item->complete) {
+            item->received = true;
+            kernel_exit();
+            if (size) *size = item->size;
+            return item->data;
+        }
+        if (!kernel_wait(ticks, &deadline)) break;
+    }
+    kernel_exit();
+    return NULL;
+}
+
+void vRingbufferReturnItem(RingbufHandle_t buf, void *data)
+{
+    rb_item_t *item = (rb_item_t *)((uint8_t *)data - offsetof(rb_item_t, data));
+    kernel_enter();
+    rb_item_t **link = &buf->head;
+    rb_item_t *prev = NULL;
+    while (*link && *link != item) {
+        prev = *link;
+        link = &(*link)->next;
+    }
+    if (*link) {
+        *link = item->next;
+        if (buf->tail == item) buf->tail = prev;
+        buf->used -= item->charge;
+        free(item);
+    }
+    kernel_exit_changed();
+}
+
+size_t xRingbufferGetCurFreeSize(RingbufHandle_t buf)
+{
+    kernel_enter();
+    size_t free_bytes = buf->capacity - buf->used;
+    kernel_exit();
+    return free_bytes > RB_ITEM_OVERHEAD ? free_bytes - RB_ITEM_OVERHEAD : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Event groups
+// ---------------------------------------------------------------------------
+
+struct sim_event_group {
+    EventBits_t bits;
+};
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    return calloc(1, sizeof(struct sim_event_group));
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+    free(group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    kernel_enter();
+    group->bits |= bits;
+    EventBits_t now = group->bits;
+    kernel_exit_changed();
+    return now;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    kernel_enter();
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    kernel_exit_changed();
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    kernel_enter();
+    EventBits_t now = group->bits;
+    kernel_exit();
+    return now;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+                                BaseType_t clear_on_exit, BaseType_t wait_for_all,
+                                TickType_t ticks)
+{
+    struct timespec deadline = deadline_after(ticks);
+    kernel_enter();
+    for (;;) {
+        EventBits_t match = group->bits & bits;
+        if (wait_for_all ? match == bits : match != 0) break;
+        if (!kernel_wait(ticks, &deadline)) break;
+    }
+    EventBits_t now = group->bits;
+    if (clear_on_exit && (wait_for_all ? (now & bits) == bits : (now & bits) != 0)) {
+        group->bits &= ~bits;
+    }
+    kernel_exit_changed();
+    return now;
+}
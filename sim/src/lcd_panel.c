@@ -0,0 +1,239 @@
+/**
+ * @file lcd_panel.c
+ * @brief ST7789 panel, backlight and bus drivers for the desktop simulator
+ *
+ * display.c runs unchanged: its color transfers land in a host copy of
+ * the panel, converted from the panel's byte order, and complete at once.
+ * The front end picks finished frames up with sim_panel_read().
+ */
+
+#include "sim.h"
+#include "display.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_vendor.h"
+#include "esp_lcd_panel_ops.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "driver/spi_master.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BACKLIGHT_DUTY_MAX  8191        // 13-bit LEDC resolution used by display.c
+
+struct sim_lcd_io {
+    esp_lcd_panel_io_color_trans_done_cb_t on_done;
+    void *user_ctx;
+};
+
+struct sim_lcd_panel {
+    struct sim_lcd_io *io;
+    bool on;
+};
+
+static pthread_mutex_t panel_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint16_t panel_pixels[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+static uint32_t panel_seq = 0;
+static uint32_t backlight_duty = BACKLIGHT_DUTY_MAX;
+
+bool sim_panel_read(uint16_t *rgb565, uint8_t *backlight_pct, uint32_t *seq)
+{
+    pthread_mutex_lock(&panel_lock);
+    bool changed = panel_seq != *seq;
+    if (changed) {
+        memcpy(rgb565, panel_pixels, sizeof(panel_pixels));
+        *seq = panel_seq;
+    }
+    *backlight_pct = (uint8_t)(backlight_duty * 100 / BACKLIGHT_DUTY_MAX);
+    pthread_mutex_unlock(&panel_lock);
+    return changed;
+}
+
+esp_err_t esp_lcd_new_panel_io_spi(esp_lcd_spi_bus_handle_t bus,
+                                   const esp_lcd_panel_io_spi_config_t *config,
+                                   esp_lcd_panel_io_handle_t *out)
+{
+    (void)bus;
+    struct sim_lcd_io *io = calloc(1, sizeof(*io));
+    if (!io) return ESP_ERR_NO_MEM;
+    io->on_done = config->on_color_trans_done;
+    io->user_ctx = config->user_ctx;
+    *out = io;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_new_panel_st7789(esp_lcd_panel_io_handle_t io,
+                                   const esp_lcd_panel_dev_config_t *config,
+                                   esp_lcd_panel_handle_t *out)
+{
+    (void)config;
+    struct sim_lcd_panel *panel = calloc(1, sizeof(*panel));
+    if (!panel) return ESP_ERR_NO_MEM;
+    panel->io = io;
+    *out = panel;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start,
+                                    int x_end, int y_end, const void *color_data)
+{
+    if (x_start < 0 || y_start < 0 || x_end > DISPLAY_WIDTH || y_end > DISPLAY_HEIGHT ||
+        x_start >= x_end || y_start >= y_end) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint16_t *src = color_data;
+    int w = x_end - x_start;
+
+    pthread_mutex_lock(&panel_lock);
+    for (int y = y_start; y < y_end; y++) {
+        uint16_t *dst = &panel_pixels[y * DISPLAY_WIDTH + x_start];
+        for (int x = 0; x < w; x++) {
+            uint16_t p = *src++;
+            dst[x] = (uint16_t)((p >> 8) | (p << 8));
+        }
+    }
+    panel_seq++;
+    pthread_mutex_unlock(&panel_lock);
+
+    if (panel->io->on_done) {
+        esp_lcd_panel_io_event_data_t event = {0};
+        panel->io->on_done(panel->io, &event, panel->io->user_ctx);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_reset(esp_lcd_panel_handle_t panel)
+{
+    (void)panel;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_init(esp_lcd_panel_handle_t panel)
+{
+    (void)panel;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_swap_xy(esp_lcd_panel_handle_t panel, bool swap_axes)
+{
+    (void)panel;
+    (void)swap_axes;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_mirror(esp_lcd_panel_handle_t panel, bool mirror_x, bool mirror_y)
+{
+    (void)panel;
+    (void)mirror_x;
+    (void)mirror_y;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_invert_color(esp_lcd_panel_handle_t panel, bool invert)
+{
+    // The Cardputer's IPS panel needs inversion for true colors; the host copy does not
+    (void)panel;
+    (void)invert;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_set_gap(esp_lcd_panel_handle_t panel, int x_gap, int y_gap)
+{
+    (void)panel;
+    (void)x_gap;
+    (void)y_gap;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_disp_on_off(esp_lcd_panel_handle_t panel, bool on)
+{
+    panel->on = on;
+    return ESP_OK;
+}
+
+// Backlight
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *config)
+{
+    return ledc_set_duty(config->speed_mode, config->channel, config->duty);
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty)
+{
+    (void)mode;
+    if (channel != LEDC_CHANNEL_0) return ESP_OK;
+    pthread_mutex_lock(&panel_lock);
+    backlight_duty = duty > BACKLIGHT_DUTY_MAX ? BACKLIGHT_DUTY_MAX : duty;
+    panel_seq++;
+    pthread_mutex_unlock(&panel_lock);
+    return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t mode, ledc_channel_t channel)
+{
+    (void)mode;
+    (void)channel;
+    return ESP_OK;
+}
+
+// Buses and pins: nothing behind them
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config,
+                             spi_dma_chan_t dma)
+{
+    (void)host;
+    (void)config;
+    (void)dma;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host)
+{
+    (void)host;
+    return ESP_OK;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t pin)
+{
+    (void)pin;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level)
+{
+    (void)pin;
+    (void)level;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin)
+{
+    (void)pin;
+    return 1;       // Pulled up, nothing pressed
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    (void)intr_alloc_flags;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t handler, void *arg)
+{
+    (void)pin;
+    (void)handler;
+    (void)arg;
+    return ESP_OK;
+}
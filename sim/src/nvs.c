@@ -0,0 +1,226 @@
+/**
+ * @file nvs.c
+ * @brief ESP-IDF non-volatile storage for the desktop simulator
+ *
+ * Keys are files <SIM_NVS_DIR>/<namespace>.<key>, so settings survive
+ * restarts of the simulator and can be inspected or deleted by hand.
+ * Integers are stored little-endian in their own width; a read with the
+ * wrong width fails as a type mismatch would on the device.
+ */
+
+#include "nvs_flash.h"
+#include "esp_log.h"
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define NVS_NAMESPACES_MAX  16
+#define NVS_NAME_MAX        16      // NVS_KEY_NAME_MAX_SIZE, terminator included
+
+static pthread_mutex_t nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+static char namespaces[NVS_NAMESPACES_MAX][NVS_NAME_MAX];
+static bool writable[NVS_NAMESPACES_MAX];
+static int namespace_count = 0;
+static bool initialized = false;
+
+static const char *store_dir(void)
+{
+    const char *dir = getenv("SIM_NVS_DIR");
+    return dir && dir[0] ? dir : "sim_nvs";
+}
+
+static bool key_path(nvs_handle_t handle, const char *key, char *path, size_t size)
+{
+    if (handle == 0 || handle > (nvs_handle_t)namespace_count || !key ||
+        strlen(key) >= NVS_NAME_MAX) {
+        return false;
+    }
+    snprintf(path, size, "%s/%s.%s", store_dir(), namespaces[handle - 1], key);
+    return true;
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    if (mkdir(store_dir(), 0755) != 0 && errno != EEXIST) {
+        ESP_LOGE("SIM_NVS", "Cannot create %s: %s", store_dir(), strerror(errno));
+        return ESP_ERR_NVS_NO_FREE_PAGES;
+    }
+    initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    DIR *dir = opendir(store_dir());
+    if (!dir) return ESP_OK;
+    struct dirent *entry;
+    char path[512];
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", store_dir(), entry->d_name);
+        unlink(path);
+    }
+    closedir(dir);
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out)
+{
+    if (!initialized) return ESP_ERR_INVALID_STATE;
+    if (!name || strlen(name) >= NVS_NAME_MAX || !out) return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&nvs_lock);
+    int i = 0;
+    while (i < namespace_count && strcmp(namespaces[i], name) != 0) i++;
+    if (i == namespace_count) {
+        if (namespace_count == NVS_NAMESPACES_MAX) {
+            pthread_mutex_unlock(&nvs_lock);
+            return ESP_ERR_NVS_NO_FREE_PAGES;
+        }
+        strcpy(namespaces[namespace_count++], name);
+    }
+    writable[i] |= mode == NVS_READWRITE;
+    pthread_mutex_unlock(&nvs_lock);
+
+    *out = (nvs_handle_t)(i + 1);
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    (void)handle;   // Handles are per namespace and stay valid
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    (void)handle;   // Every set is already on disk
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    char path[512];
+    if (!key_path(handle, key, path, sizeof(path))) return ESP_ERR_INVALID_ARG;
+    return unlink(path) == 0 ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+static esp_err_t write_value(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    char path[512];
+    if (!key_path(handle, key, path, sizeof(path))) return ESP_ERR_INVALID_ARG;
+    if (!writable[handle - 1]) return ESP_ERR_INVALID_STATE;
+
+    // Write beside and rename, so a crash never leaves half a value
+    char tmp[520];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return ESP_FAIL;
+    bool ok = fwrite(value, 1, length, f) == length;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Read a stored value
+ * @param out Destination, or NULL to learn the length
+ * @param length In: room at out, out: stored length
+ */
+static esp_err_t read_value(nvs_handle_t handle, const char *key, void *out, size_t *length)
+{
+    char path[512];
+    if (!key_path(handle, key, path, sizeof(path))) return ESP_ERR_INVALID_ARG;
+    FILE *f = fopen(path, "rb");
+    if (!f) return ESP_ERR_NVS_NOT_FOUND;
+    fseek(f, 0, SEEK_END);
+    size_t stored = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    esp_err_t ret = ESP_OK;
+    if (out) {
+        if (*length < stored) {
+            ret = ESP_ERR_NVS_INVALID_LENGTH;
+        } else if (fread(out, 1, stored, f) != stored) {
+            ret = ESP_FAIL;
+        }
+    }
+    fclose(f);
+    *length = stored;
+    return ret;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *length)
+{
+    if (!length) return ESP_ERR_INVALID_ARG;
+    return read_value(handle, key, out, length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return write_value(handle, key, value, length);
+}
+
+static esp_err_t get_int(nvs_handle_t handle, const char *key, void *out, size_t width)
+{
+    size_t length = 0;
+    esp_err_t ret = read_value(handle, key, NULL, &length);
+    if (ret != ESP_OK) return ret;
+    if (length != width) return ESP_ERR_NVS_NOT_FOUND;     // Stored as another type
+    uint8_t bytes[4];
+    ret = read_value(handle, key, bytes, &length);
+    if (ret != ESP_OK) return ret;
+    uint32_t value = 0;
+    for (size_t i = 0; i < width; i++) value |= (uint32_t)bytes[i] << (8 * i);
+    if (width == 1) {
+        *(uint8_t *)out = (uint8_t)value;
+    } else {
+        *(uint32_t *)out = value;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t set_int(nvs_handle_t handle, const char *key, uint32_t value, size_t width)
+{
+    uint8_t bytes[4];
+    for (size_t i = 0; i < width; i++) bytes[i] = (uint8_t)(value >> (8 * i));
+    return write_value(handle, key, bytes, width);
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out)
+{
+    return get_int(handle, key, out, 1);
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value)
+{
+    return set_int(handle, key, value, 1);
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out)
+{
+    return get_int(handle, key, out, 4);
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value)
+{
+    return set_int(handle, key, value, 4);
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char *key, int32_t *out)
+{
+    return get_int(handle, key, out, 4);
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char *key, int32_t value)
+{
+    return set_int(handle, key, (uint32_t)value, 4);
+}
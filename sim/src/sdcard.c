@@ -0,0 +1,114 @@
+/**
+ * @file sdcard.c
+ * @brief SD card and USB Serial/JTAG drivers for the desktop simulator
+ *
+ * The card is the host directory at the mount point: the firmware's
+ * "/sdcard/..." paths are used as they are, so point /sdcard at a
+ * scratch directory (see sim/README.md) to run with a card.
+ */
+
+#include "esp_vfs_fat.h"
+#include "driver/usb_serial_jtag.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+static const char *TAG = "SIM_SD";
+
+esp_err_t esp_vfs_fat_sdspi_mount(const char *base_path, const sdmmc_host_t *host,
+                                  const sdspi_device_config_t *slot,
+                                  const esp_vfs_fat_sdmmc_mount_config_t *config,
+                                  sdmmc_card_t **out_card)
+{
+    (void)slot;
+    (void)config;
+    struct stat st;
+    if (stat(base_path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        ESP_LOGW(TAG, "No directory at %s, running without a card", base_path);
+        return ESP_FAIL;
+    }
+    sdmmc_card_t *card = calloc(1, sizeof(*card));
+    if (!card) return ESP_ERR_NO_MEM;
+    card->host = *host;
+    struct statvfs fs;
+    if (statvfs(base_path, &fs) == 0) {
+        card->capacity_bytes = (uint64_t)fs.f_blocks * fs.f_frsize;
+    }
+    *out_card = card;
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_fat_sdcard_unmount(const char *base_path, sdmmc_card_t *card)
+{
+    (void)base_path;
+    free(card);
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_fat_create_contiguous_file(const char *base_path, const char *full_path,
+                                             uint64_t size, bool alloc_now)
+{
+    (void)base_path;
+    int fd = open(full_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return ESP_FAIL;
+    int ret = alloc_now ? posix_fallocate(fd, 0, (off_t)size) : 0;
+    close(fd);
+    return ret == 0 ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t sdmmc_card_init(const sdmmc_host_t *host, sdmmc_card_t *card)
+{
+    // Raw card access (USB export) has no host equivalent
+    (void)host;
+    (void)card;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void sdmmc_card_print_info(FILE *stream, const sdmmc_card_t *card)
+{
+    fprintf(stream, "Name: host directory\nSize: %lluMB\n",
+            (unsigned long long)(card->capacity_bytes >> 20));
+}
+
+esp_err_t sdspi_host_init_device(const sdspi_device_config_t *config, sdspi_dev_handle_t *out)
+{
+    *out = config->host_id;
+    return ESP_OK;
+}
+
+esp_err_t sdspi_host_remove_device(sdspi_dev_handle_t handle)
+{
+    (void)handle;
+    return ESP_OK;
+}
+
+esp_err_t usb_serial_jtag_driver_install(usb_serial_jtag_driver_config_t *config)
+{
+    (void)config;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t usb_serial_jtag_driver_uninstall(void)
+{
+    return ESP_OK;
+}
+
+int usb_serial_jtag_read_bytes(void *buf, uint32_t length, TickType_t ticks)
+{
+    (void)buf;
+    (void)length;
+    vTaskDelay(ticks);
+    return 0;
+}
+
+int usb_serial_jtag_write_bytes(const void *src, size_t size, TickType_t ticks)
+{
+    (void)src;
+    (void)ticks;
+    return (int)size;
+}
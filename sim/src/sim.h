@@ -0,0 +1,43 @@
+/**
+ * @file sim.h
+ * @brief Glue between the simulated peripherals and the simulator front end
+ *
+ * The firmware talks to the peripherals through the usual ESP-IDF and
+ * driver headers; the front end (window or headless loop in sim_main.c)
+ * reads the panel and feeds the keyboard through these calls.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include "keyboard.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Copy the panel contents if they changed since *seq
+ * @param rgb565 DISPLAY_WIDTH x DISPLAY_HEIGHT pixels, host byte order
+ * @param backlight_pct Backlight level 0-100
+ * @param seq In: last frame seen, out: frame copied
+ * @return true if a newer frame was copied
+ */
+bool sim_panel_read(uint16_t *rgb565, uint8_t *backlight_pct, uint32_t *seq);
+
+/**
+ * @brief Type a character as the Cardputer keyboard would produce it
+ *
+ * Characters that need Shift on the Cardputer are sent with Shift held.
+ */
+void sim_keyboard_type(char c);
+
+/**
+ * @brief Press and release a key that has no character (arrows, Esc, ...)
+ */
+void sim_keyboard_press(key_code_t key);
+
+/**
+ * @brief Read keys from the terminal (raw mode when it is one) on a thread
+ */
+void sim_keyboard_read_stdin(void);
+
+#endif // SIM_H
@@ -0,0 +1,278 @@
+/**
+ * @file sim_keyboard.c
+ * @brief Cardputer keyboard for the desktop simulator
+ *
+ * Keys come from the window (sim_main.c) or the terminal. A typed
+ * character is mapped back to the Cardputer key that produces it, with
+ * Shift where the Cardputer needs it, and then follows the same rules as
+ * the matrix drivers: outside text entry ; . , / are the arrows and ` is
+ * Esc. Key repeat is the host's own, so key_repeat.c is not involved.
+ *
+ * Shift travels with each queued key: keyboard_is_shift_held() reports
+ * the state of the key most recently handed out, which is when screens
+ * ask.
+ */
+
+#include "keyboard.h"
+#include "keymap.h"
+#include "sim.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+static const char *TAG = "KEYBOARD";
+
+#define KEY_QUEUE_LEN       32
+#define ESC_SEQUENCE_MS     30      // Bytes after ESC sooner than this belong to it
+#define SCRIPT_KEY_DELAY_MS 100     // Between keys read from a pipe (SIM_KEY_DELAY_MS)
+
+typedef struct {
+    key_code_t key;
+    bool shift;
+} sim_key_t;
+
+static QueueHandle_t input_queue = NULL;    // Front end -> keyboard_process()
+static QueueHandle_t key_queue = NULL;      // keyboard_process() -> keyboard_get_key()
+static key_event_callback_t key_callback = NULL;
+static keyboard_notify_callback_t notify_callback = NULL;
+static bool callback_enabled = true;
+static bool text_input_mode = false;
+static key_code_t last_key = KEY_NONE;
+static int64_t event_time_us = 0;
+static bool shift_held = false;
+
+static struct termios saved_termios;
+
+static void queue_input(key_code_t key, bool shift)
+{
+    if (!input_queue || key == KEY_NONE) return;
+    sim_key_t k = { key, shift };
+    if (xQueueSend(input_queue, &k, 0) == pdTRUE && notify_callback) {
+        notify_callback();
+    }
+}
+
+void sim_keyboard_press(key_code_t key)
+{
+    queue_input(key, false);
+}
+
+void sim_keyboard_type(char c)
+{
+    switch (c) {
+        case '\r':
+        case '\n':
+            queue_input(KEY_ENTER, false);
+            return;
+        case '\t':
+            queue_input(KEY_TAB, false);
+            return;
+        case 0x7f:
+        case '\b':
+            queue_input(KEY_BACKSPACE, false);
+            return;
+        case ' ':
+            queue_input(KEY_SPACE, false);
+            return;
+        default:
+            break;
+    }
+    for (int layer = KEYMAP_LAYER_BASE; layer <= KEYMAP_LAYER_SHIFT; layer++) {
+        for (int key = KEY_NONE + 1; key < KEY_MAX; key++) {
+            if (keymap_chars[key][layer] == c) {
+                queue_input((key_code_t)key, layer == KEYMAP_LAYER_SHIFT);
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Apply the Cardputer's navigation layer to a key
+ */
+static key_code_t navigation_key(key_code_t key)
+{
+    if (text_input_mode) return key;
+    switch (key) {
+        case KEY_GRAVE:     return KEY_ESC;
+        case KEY_SEMICOLON: return KEY_UP;
+        case KEY_DOT:       return KEY_DOWN;
+        case KEY_COMMA:     return KEY_LEFT;
+        case KEY_SLASH:     return KEY_RIGHT;
+        default:            return key;
+    }
+}
+
+static void restore_terminal(void)
+{
+    tcsetattr(STDIN_FILENO, TCSANOW, &saved_termios);
+}
+
+static bool byte_within(uint8_t *out, int timeout_ms)
+{
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+    return poll(&pfd, 1, timeout_ms) > 0 && read(STDIN_FILENO, out, 1) == 1;
+}
+
+static void *stdin_task(void *arg)
+{
+    (void)arg;
+    bool script = !isatty(STDIN_FILENO);
+    const char *delay_env = getenv("SIM_KEY_DELAY_MS");
+    int delay_ms = delay_env ? atoi(delay_env) : SCRIPT_KEY_DELAY_MS;
+
+    uint8_t c;
+    while (read(STDIN_FILENO, &c, 1) == 1) {
+        if (c == 0x1b) {
+            // Terminal escape sequences; a lone ESC is the Esc key
+            uint8_t seq[3];
+            if (!byte_within(&seq[0], ESC_SEQUENCE_MS) || seq[0] != '[' ||
+                !byte_within(&seq[1], ESC_SEQUENCE_MS)) {
+                sim_keyboard_press(KEY_ESC);
+            } else if (seq[1] == 'A') {
+                sim_keyboard_press(KEY_UP);
+            } else if (seq[1] == 'B') {
+                sim_keyboard_press(KEY_DOWN);
+            } else if (seq[1] == 'C') {
+                sim_keyboard_press(KEY_RIGHT);
+            } else if (seq[1] == 'D') {
+                sim_keyboard_press(KEY_LEFT);
+            } else if (seq[1] == '3' && byte_within(&seq[2], ESC_SEQUENCE_MS) && seq[2] == '~') {
+                sim_keyboard_press(KEY_DEL);
+            }
+        } else {
+            sim_keyboard_type((char)c);
+        }
+        if (script && delay_ms > 0) usleep((useconds_t)delay_ms * 1000);
+    }
+    ESP_LOGI(TAG, "End of keyboard input");
+    return NULL;
+}
+
+void sim_keyboard_read_stdin(void)
+{
+    if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved_termios) == 0) {
+        struct termios raw = saved_termios;
+        raw.c_lflag &= ~(ICANON | ECHO);    // Keep ISIG: Ctrl-C still quits
+        raw.c_iflag &= ~(ICRNL | IXON);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+        atexit(restore_terminal);
+    }
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, stdin_task, NULL) == 0) {
+        pthread_setname_np(thread, "sim_stdin");
+        pthread_detach(thread);
+    }
+}
+
+esp_err_t keyboard_init(void)
+{
+    input_queue = xQueueCreate(KEY_QUEUE_LEN, sizeof(sim_key_t));
+    key_queue = xQueueCreate(KEY_QUEUE_LEN, sizeof(sim_key_t));
+    if (!input_queue || !key_queue) {
+        ESP_LOGE(TAG, "Failed to create key queues");
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Simulated keyboard ready");
+    return ESP_OK;
+}
+
+void keyboard_process(void)
+{
+    event_time_us = esp_timer_get_time();
+    sim_key_t k;
+    while (input_queue && xQueueReceive(input_queue, &k, 0) == pdTRUE) {
+        k.key = navigation_key(k.key);
+        last_key = k.key;
+        xQueueSend(key_queue, &k, 0);
+        if (callback_enabled && key_callback) {
+            shift_held = k.shift;
+            key_callback(k.key, true);
+        }
+    }
+}
+
+int32_t keyboard_repeat_due_ms(void)
+{
+    return -1;      // The host repeats keys itself
+}
+
+void keyboard_register_callback(key_event_callback_t callback)
+{
+    key_callback = callback;
+}
+
+bool keyboard_set_notify_callback(keyboard_notify_callback_t callback)
+{
+    notify_callback = callback;
+    return true;
+}
+
+int64_t keyboard_get_event_time_us(void)
+{
+    return event_time_us;
+}
+
+void keyboard_set_callback_enabled(bool enabled)
+{
+    callback_enabled = enabled;
+}
+
+key_code_t keyboard_get_key(void)
+{
+    sim_key_t k;
+    if (key_queue && xQueueReceive(key_queue, &k, 0) == pdTRUE) {
+        shift_held = k.shift;
+        return k.key;
+    }
+    return KEY_NONE;
+}
+
+bool keyboard_is_pressed(key_code_t key)
+{
+    return last_key == key;
+}
+
+bool keyboard_is_shift_held(void)
+{
+    return shift_held;
+}
+
+bool keyboard_is_ctrl_held(void)
+{
+    return false;
+}
+
+bool keyboard_is_capslock_held(void)
+{
+    return false;
+}
+
+bool keyboard_is_fn_held(void)
+{
+    return false;
+}
+
+void keyboard_set_text_input_mode(bool enabled)
+{
+    text_input_mode = enabled;
+    ESP_LOGI(TAG, "Text input mode: %s", enabled ? "ON" : "OFF");
+}
+
+esp_err_t keyboard_inject(key_code_t key)
+{
+    if (!input_queue) return ESP_ERR_INVALID_STATE;
+    if (key == KEY_NONE || key >= KEY_MAX) return ESP_ERR_INVALID_ARG;
+    sim_key_t k = { key, false };
+    if (xQueueSend(input_queue, &k, 0) != pdTRUE) return ESP_ERR_TIMEOUT;
+    if (notify_callback) notify_callback();
+    return ESP_OK;
+}
@@ -0,0 +1,196 @@
+/**
+ * @file sim_main.c
+ * @brief Desktop simulator entry point and front end
+ *
+ * app_main() runs on a "main" task exactly as on the device; the process
+ * thread is the front end. With SDL2 it is a window showing the panel at
+ * SIM_SCALE (default 3) with the backlight applied, taking keys from the
+ * host keyboard. Without SDL2, or with SIM_HEADLESS=1, keys come from
+ * the terminal or a pipe and frames can be written out as PPM files.
+ *
+ * Environment:
+ *   SIM_EXIT_AFTER_MS  quit after this long (scripted and profiling runs)
+ *   SIM_FRAME_DIR      headless: write every new frame to this directory
+ *   SIM_SCALE          window scale
+ */
+
+#include "sim.h"
+#include "display.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#ifdef SIM_SDL
+#include <SDL.h>
+#endif
+
+static const char *TAG = "SIM";
+
+#define FRONT_END_PERIOD_MS 16
+#define MAIN_TASK_STACK     (8 * 1024)
+
+extern void app_main(void);
+
+static volatile sig_atomic_t quit_requested = 0;
+static uint16_t frame[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    quit_requested = 1;
+}
+
+static void main_task(void *arg)
+{
+    (void)arg;
+    app_main();
+    vTaskDelete(NULL);      // As the IDF does when app_main returns
+}
+
+static bool time_is_up(int64_t exit_after_us)
+{
+    return quit_requested || (exit_after_us > 0 && esp_timer_get_time() >= exit_after_us);
+}
+
+static void write_ppm(const char *dir, uint32_t seq)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/frame_%06u.ppm", dir, (unsigned)seq);
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        ESP_LOGW(TAG, "Cannot write %s", path);
+        return;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    for (int i = 0; i < DISPLAY_WIDTH * DISPLAY_HEIGHT; i++) {
+        uint16_t p = frame[i];
+        uint8_t rgb[3] = {
+            (uint8_t)(((p >> 11) & 0x1F) * 255 / 31),
+            (uint8_t)(((p >> 5) & 0x3F) * 255 / 63),
+            (uint8_t)((p & 0x1F) * 255 / 31),
+        };
+        fwrite(rgb, 1, sizeof(rgb), f);
+    }
+    fclose(f);
+}
+
+static void run_headless(int64_t exit_after_us)
+{
+    const char *frame_dir = getenv("SIM_FRAME_DIR");
+    uint32_t seq = 0;
+    uint8_t backlight;
+
+    sim_keyboard_read_stdin();
+    while (!time_is_up(exit_after_us)) {
+        if (sim_panel_read(frame, &backlight, &seq) && frame_dir) {
+            write_ppm(frame_dir, seq);
+        }
+        usleep(FRONT_END_PERIOD_MS * 1000);
+    }
+}
+
+#ifdef SIM_SDL
+static void sdl_key(SDL_Keycode sym)
+{
+    switch (sym) {
+        case SDLK_RETURN:
+        case SDLK_KP_ENTER:  sim_keyboard_press(KEY_ENTER); break;
+        case SDLK_BACKSPACE: sim_keyboard_press(KEY_BACKSPACE); break;
+        case SDLK_TAB:       sim_keyboard_press(KEY_TAB); break;
+        case SDLK_ESCAPE:    sim_keyboard_press(KEY_ESC); break;
+        case SDLK_DELETE:    sim_keyboard_press(KEY_DEL); break;
+        case SDLK_UP:        sim_keyboard_press(KEY_UP); break;
+        case SDLK_DOWN:      sim_keyboard_press(KEY_DOWN); break;
+        case SDLK_LEFT:      sim_keyboard_press(KEY_LEFT); break;
+        case SDLK_RIGHT:     sim_keyboard_press(KEY_RIGHT); break;
+        default:             break;     // Characters arrive as SDL_TEXTINPUT
+    }
+}
+
+static bool run_window(int64_t exit_after_us)
+{
+    const char *scale_env = getenv("SIM_SCALE");
+    int scale = scale_env ? atoi(scale_env) : 3;
+    if (scale < 1) scale = 1;
+
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        ESP_LOGW(TAG, "SDL: %s - running headless", SDL_GetError());
+        return false;
+    }
+    SDL_Window *window = SDL_CreateWindow("Cardputer", SDL_WINDOWPOS_CENTERED,
+                                          SDL_WINDOWPOS_CENTERED, DISPLAY_WIDTH * scale,
+                                          DISPLAY_HEIGHT * scale, 0);
+    SDL_Renderer *renderer = window ? SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC) : NULL;
+    SDL_Texture *texture = renderer ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGB565,
+                                                        SDL_TEXTUREACCESS_STREAMING,
+                                                        DISPLAY_WIDTH, DISPLAY_HEIGHT) : NULL;
+    if (!texture) {
+        ESP_LOGW(TAG, "SDL: %s - running headless", SDL_GetError());
+        if (renderer) SDL_DestroyRenderer(renderer);
+        if (window) SDL_DestroyWindow(window);
+        SDL_Quit();
+        return false;
+    }
+    SDL_StartTextInput();
+
+    uint32_t seq = 0;
+    uint8_t backlight = 100;
+    while (!time_is_up(exit_after_us)) {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT) {
+                quit_requested = 1;
+            } else if (event.type == SDL_TEXTINPUT) {
+                for (const char *c = event.text.text; *c; c++) sim_keyboard_type(*c);
+            } else if (event.type == SDL_KEYDOWN) {
+                sdl_key(event.key.keysym.sym);
+            }
+        }
+        if (sim_panel_read(frame, &backlight, &seq)) {
+            SDL_UpdateTexture(texture, NULL, frame, DISPLAY_WIDTH * sizeof(uint16_t));
+        }
+        uint8_t level = (uint8_t)(backlight * 255 / 100);
+        SDL_SetTextureColorMod(texture, level, level, level);
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, texture, NULL, NULL);
+        SDL_RenderPresent(renderer);
+        SDL_Delay(FRONT_END_PERIOD_MS);
+    }
+
+    SDL_DestroyTexture(texture);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return true;
+}
+#endif
+
+int main(void)
+{
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    const char *exit_env = getenv("SIM_EXIT_AFTER_MS");
+    int64_t exit_after_us = exit_env ? (int64_t)atoll(exit_env) * 1000 : 0;
+
+    esp_timer_get_time();   // Uptime starts here
+    if (xTaskCreate(main_task, "main", MAIN_TASK_STACK, NULL, 1, NULL) != pdPASS) {
+        fprintf(stderr, "Cannot start the main task\n");
+        return 1;
+    }
+
+#ifdef SIM_SDL
+    const char *headless = getenv("SIM_HEADLESS");
+    if (!(headless && headless[0] == '1') && run_window(exit_after_us)) {
+        fflush(NULL);
+        exit(0);
+    }
+#endif
+    run_headless(exit_after_us);
+    fflush(NULL);
+    exit(0);
+}
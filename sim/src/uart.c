@@ -0,0 +1,385 @@
+/**
+ * @file uart.c
+ * @brief ESP-IDF UART driver for the desktop simulator
+ *
+ * UART_NUM_1 carries the JanOS link. Its bytes come from one of:
+ *   SIM_UART=host:port     a TCP peer (a JanOS bridge or a scripted fake);
+ *                          what the firmware sends goes back to it
+ *   SIM_UART_REPLAY=file   an rx_N.utr transcript (uart_transcript.h),
+ *                          paced by its timestamps, SIM_UART_SPEED times
+ *                          faster (0 = no delays); transmit is dropped
+ * Other ports stay silent. Received bytes go through a ring of the size
+ * given at install and raise the same driver events as on the device,
+ * including UART_BUFFER_FULL when the firmware falls behind.
+ */
+
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *TAG = "SIM_UART";
+
+#define LINK_PORT           UART_NUM_1
+#define CONNECT_RETRY_MS    1000
+#define SOURCE_CHUNK        1024
+
+typedef struct {
+    bool installed;
+    QueueHandle_t events;
+    uint8_t *ring;
+    size_t ring_size;
+    size_t head;
+    size_t count;
+    uint32_t baud;
+} port_state_t;
+
+static port_state_t ports[UART_NUM_MAX];
+static pthread_mutex_t port_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t port_data = PTHREAD_COND_INITIALIZER;
+static pthread_once_t source_once = PTHREAD_ONCE_INIT;
+static int link_socket = -1;
+
+static bool port_valid(uart_port_t port)
+{
+    return port >= 0 && port < UART_NUM_MAX;
+}
+
+/**
+ * @brief Hand bytes from the source to a port, as the RX interrupt would
+ */
+static void port_receive(uart_port_t port, const uint8_t *data, size_t len)
+{
+    port_state_t *p = &ports[port];
+    pthread_mutex_lock(&port_lock);
+    if (!p->installed) {
+        pthread_mutex_unlock(&port_lock);
+        return;
+    }
+    size_t room = p->ring_size - p->count;
+    size_t take = len < room ? len : room;
+    for (size_t i = 0; i < take; i++) {
+        p->ring[(p->head + p->count + i) % p->ring_size] = data[i];
+    }
+    p->count += take;
+    QueueHandle_t events = p->events;
+    pthread_cond_broadcast(&port_data);
+    pthread_mutex_unlock(&port_lock);
+
+    if (events) {
+        uart_event_t event = {
+            .type = take < len ? UART_BUFFER_FULL : UART_DATA,
+            .size = take,
+        };
+        xQueueSend(events, &event, 0);
+    }
+}
+
+static bool port_is_installed(uart_port_t port)
+{
+    pthread_mutex_lock(&port_lock);
+    bool installed = ports[port].installed;
+    pthread_mutex_unlock(&port_lock);
+    return installed;
+}
+
+static void sleep_ms(int64_t ms)
+{
+    struct timespec t = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&t, &t) != 0 && errno == EINTR) {
+    }
+}
+
+static int connect_to(const char *spec)
+{
+    char host[128];
+    strncpy(host, spec, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    char *colon = strrchr(host, ':');
+    if (!colon) return -1;
+    *colon = '\0';
+
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(host[0] ? host : "127.0.0.1", colon + 1, &hints, &res) != 0) return -1;
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+static void run_socket(const char *spec)
+{
+    uint8_t chunk[SOURCE_CHUNK];
+    bool reported = false;
+    for (;;) {
+        int fd = connect_to(spec);
+        if (fd < 0) {
+            if (!reported) ESP_LOGW(TAG, "Waiting for a JanOS peer at %s", spec);
+            reported = true;
+            sleep_ms(CONNECT_RETRY_MS);
+            continue;
+        }
+        ESP_LOGI(TAG, "Link connected to %s", spec);
+        reported = false;
+        pthread_mutex_lock(&port_lock);
+        link_socket = fd;
+        pthread_mutex_unlock(&port_lock);
+
+        ssize_t n;
+        while ((n = recv(fd, chunk, sizeof(chunk), 0)) > 0) {
+            port_receive(LINK_PORT, chunk, (size_t)n);
+        }
+
+        pthread_mutex_lock(&port_lock);
+        link_socket = -1;
+        pthread_mutex_unlock(&port_lock);
+        close(fd);
+        ESP_LOGW(TAG, "Link to %s closed", spec);
+    }
+}
+
+static void run_replay(const char *path, int speed)
+{
+    FILE *f = fopen(path, "rb");
+    char magic[4];
+    if (!f || fread(magic, 1, 4, f) != 4 || memcmp(magic, "UTR1", 4) != 0) {
+        ESP_LOGE(TAG, "%s is not a UART transcript", path);
+        if (f) fclose(f);
+        return;
+    }
+    ESP_LOGI(TAG, "Replaying %s on the JanOS link", path);
+
+    uint8_t header[6];
+    uint8_t *chunk = malloc(UINT16_MAX);
+    int64_t start_us = esp_timer_get_time();
+    uint32_t bytes = 0;
+    while (chunk && fread(header, 1, sizeof(header), f) == sizeof(header)) {
+        uint32_t t = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+        size_t len = header[4] | (header[5] << 8);
+        if (fread(chunk, 1, len, f) != len) break;
+        if (speed > 0) {
+            int64_t wait_ms = (start_us + (int64_t)t * 1000 / speed - esp_timer_get_time()) / 1000;
+            if (wait_ms > 0) sleep_ms(wait_ms);
+        }
+        port_receive(LINK_PORT, chunk, len);
+        bytes += len;
+    }
+    ESP_LOGI(TAG, "Replay finished: %lu bytes in %lld ms", (unsigned long)bytes,
+             (long long)((esp_timer_get_time() - start_us) / 1000));
+    free(chunk);
+    fclose(f);
+}
+
+static void *source_task(void *arg)
+{
+    (void)arg;
+    const char *spec = getenv("SIM_UART");
+    const char *replay = getenv("SIM_UART_REPLAY");
+    if (spec && spec[0]) {
+        run_socket(spec);
+    } else if (replay && replay[0]) {
+        // Let the firmware open the link before the first record is due
+        while (!port_is_installed(LINK_PORT)) sleep_ms(10);
+        const char *speed = getenv("SIM_UART_SPEED");
+        run_replay(replay, speed ? atoi(speed) : 1);
+    } else {
+        ESP_LOGW(TAG, "No JanOS link (set SIM_UART=host:port or SIM_UART_REPLAY=file.utr)");
+    }
+    return NULL;
+}
+
+static void source_start(void)
+{
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, source_task, NULL) == 0) {
+        pthread_setname_np(thread, "sim_uart");
+        pthread_detach(thread);
+    }
+}
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size,
+                              int queue_size, QueueHandle_t *queue, int intr_alloc_flags)
+{
+    (void)tx_buffer_size;
+    (void)intr_alloc_flags;
+    if (!port_valid(port) || rx_buffer_size <= 0) return ESP_ERR_INVALID_ARG;
+
+    port_state_t *p = &ports[port];
+    pthread_mutex_lock(&port_lock);
+    if (p->installed) {
+        pthread_mutex_unlock(&port_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    p->ring = malloc((size_t)rx_buffer_size);
+    p->events = queue_size > 0 && queue ? xQueueCreate(queue_size, sizeof(uart_event_t)) : NULL;
+    if (!p->ring || (queue_size > 0 && queue && !p->events)) {
+        free(p->ring);
+        p->ring = NULL;
+        if (p->events) vQueueDelete(p->events);
+        p->events = NULL;
+        pthread_mutex_unlock(&port_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    p->ring_size = (size_t)rx_buffer_size;
+    p->head = 0;
+    p->count = 0;
+    p->installed = true;
+    if (queue) *queue = p->events;
+    pthread_mutex_unlock(&port_lock);
+
+    if (port == LINK_PORT) pthread_once(&source_once, source_start);
+    return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t port)
+{
+    if (!port_valid(port)) return ESP_ERR_INVALID_ARG;
+    port_state_t *p = &ports[port];
+    pthread_mutex_lock(&port_lock);
+    if (!p->installed) {
+        pthread_mutex_unlock(&port_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    p->installed = false;
+    free(p->ring);
+    p->ring = NULL;
+    QueueHandle_t events = p->events;
+    p->events = NULL;
+    pthread_cond_broadcast(&port_data);
+    pthread_mutex_unlock(&port_lock);
+    if (events) vQueueDelete(events);
+    return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *config)
+{
+    if (!port_valid(port) || !config) return ESP_ERR_INVALID_ARG;
+    ports[port].baud = (uint32_t)config->baud_rate;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts)
+{
+    (void)tx;
+    (void)rx;
+    (void)rts;
+    (void)cts;
+    return port_valid(port) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t uart_set_baudrate(uart_port_t port, uint32_t baud_rate)
+{
+    // Nothing is clocked: the peer sees bytes whatever the rate
+    if (!port_valid(port)) return ESP_ERR_INVALID_ARG;
+    ports[port].baud = baud_rate;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_sw_flow_ctrl(uart_port_t port, bool enable, uint8_t rx_thresh_xon,
+                                uint8_t rx_thresh_xoff)
+{
+    (void)enable;
+    (void)rx_thresh_xon;
+    (void)rx_thresh_xoff;
+    return port_valid(port) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int uart_read_bytes(uart_port_t port, void *buf, uint32_t length, TickType_t ticks)
+{
+    if (!port_valid(port)) return -1;
+    port_state_t *p = &ports[port];
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    uint64_t ms = (uint64_t)ticks * portTICK_PERIOD_MS;
+    deadline.tv_sec += ms / 1000;
+    deadline.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    // Like the driver: wait for the whole request or the timeout
+    pthread_mutex_lock(&port_lock);
+    while (p->installed && p->count < length && ticks > 0) {
+        int ret = ticks == portMAX_DELAY ? pthread_cond_wait(&port_data, &port_lock)
+                                         : pthread_cond_timedwait(&port_data, &port_lock, &deadline);
+        if (ret == ETIMEDOUT) break;
+    }
+    if (!p->installed) {
+        pthread_mutex_unlock(&port_lock);
+        return -1;
+    }
+    size_t n = p->count < length ? p->count : length;
+    uint8_t *out = buf;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = p->ring[(p->head + i) % p->ring_size];
+    }
+    p->head = (p->head + n) % p->ring_size;
+    p->count -= n;
+    pthread_mutex_unlock(&port_lock);
+    return (int)n;
+}
+
+int uart_write_bytes(uart_port_t port, const void *src, size_t size)
+{
+    if (!port_valid(port)) return -1;
+    if (port != LINK_PORT) return (int)size;
+
+    pthread_mutex_lock(&port_lock);
+    int fd = link_socket;
+    pthread_mutex_unlock(&port_lock);
+    if (fd >= 0) {
+        const uint8_t *p = src;
+        size_t left = size;
+        while (left > 0) {
+            ssize_t n = send(fd, p, left, MSG_NOSIGNAL);
+            if (n <= 0) break;      // The reader notices the closed link
+            p += n;
+            left -= (size_t)n;
+        }
+    }
+    return (int)size;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t *size)
+{
+    if (!port_valid(port) || !size) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&port_lock);
+    *size = ports[port].count;
+    pthread_mutex_unlock(&port_lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_flush_input(uart_port_t port)
+{
+    if (!port_valid(port)) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&port_lock);
+    ports[port].head = 0;
+    ports[port].count = 0;
+    pthread_mutex_unlock(&port_lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks)
+{
+    // Writes are handed to the socket before uart_write_bytes returns
+    (void)ticks;
+    return port_valid(port) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""
+Build assets.bin, the bundle flashed to the "assets" partition and mapped by
+main/assets.c. Updating it needs no firmware rebuild.
+
+Entries:
+  oui             OUI vendor table, from the IEEE CSV or a Wireshark manuf file
+  snd/<name>      Alert sound from a mono 16-bit WAV (attack, success, capture)
+  icon/<name>     Status icon (link, sd, gps, capture): assets_sprite_t and
+                  sprite data, given with --file
+  <name>          Any other file, stored as is (fonts, portal metadata, ...)
+
+Usage:
+    python tools/gen_assets.py -o assets.bin --oui oui.csv
+    python tools/gen_assets.py -o assets.bin --oui manuf --sound capture=chirp.wav \\
+        --file font/compact=font6x8.bin --bundle-version 3
+    parttool.py write_partition --partition-name assets --input assets.bin
+
+The layout must match assets.h.
+"""
+
+import argparse
+import struct
+import sys
+import wave
+import zlib
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent))
+from gen_oui_table import read_ieee_csv, read_manuf, short_name  # noqa: E402
+
+MAGIC = 0x4243534D              # "MSCB"
+FORMAT_VERSION = 1
+NAME_LEN = 24
+HEADER = struct.Struct("<IHHIII12x")
+ENTRY = struct.Struct(f"<{NAME_LEN}sII")
+OUI_HEADER = struct.Struct("<6I")
+SOUND_HEADER = struct.Struct("<IHBx")
+SAMPLE_PCM16 = 0
+PARTITION_SIZE = 0xF0000        # partitions.csv
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("-o", "--output", type=Path, required=True, help="Bundle to write")
+    parser.add_argument("--oui", type=Path, help="IEEE oui.csv or Wireshark manuf file")
+    parser.add_argument("--max-name", type=int, default=24,
+                        help="Truncate vendor names to this many characters (default: 24)")
+    parser.add_argument("--sound", action="append", default=[], metavar="NAME=WAV",
+                        help="Alert sound, stored as snd/NAME")
+    parser.add_argument("--file", action="append", default=[], metavar="NAME=PATH",
+                        help="Raw entry")
+    parser.add_argument("--bundle-version", type=int, default=1,
+                        help="Content revision reported at boot (default: 1)")
+    return parser.parse_args()
+
+
+def align4(data: bytes) -> bytes:
+    return data + b"\0" * (-len(data) % 4)
+
+
+def build_oui(source: Path, max_name: int) -> bytes:
+    with source.open(encoding="utf-8", errors="replace") as f:
+        is_csv = f.readline().startswith("Registry,")
+    records = read_ieee_csv(source) if is_csv else read_manuf(source)
+
+    table = {}
+    for prefix, name in records:
+        name = short_name(name, max_name)
+        if name:
+            table.setdefault(prefix, name)
+    if not table:
+        raise SystemExit(f"No OUI entries found in {source}")
+
+    vendors = sorted(set(table.values()))
+    if len(vendors) > 0xFFFF:
+        raise SystemExit("Too many distinct vendors for 16-bit ids")
+    vendor_id = {v: i for i, v in enumerate(vendors)}
+    prefixes = sorted(table)
+
+    pool = b""
+    offsets = []
+    for v in vendors:
+        offsets.append(len(pool))
+        pool += v.encode("ascii", "replace") + b"\0"
+
+    prefix_bytes = align4(b"".join(p.to_bytes(3, "big") for p in prefixes))
+    id_bytes = align4(struct.pack(f"<{len(prefixes)}H", *(vendor_id[table[p]] for p in prefixes)))
+    offset_bytes = struct.pack(f"<{len(offsets)}I", *offsets)
+
+    # The pool goes last: the firmware checks the entry ends with its NUL
+    prefixes_off = OUI_HEADER.size
+    ids_off = prefixes_off + len(prefix_bytes)
+    offsets_off = ids_off + len(id_bytes)
+    pool_off = offsets_off + len(offset_bytes)
+    header = OUI_HEADER.pack(len(prefixes), len(vendors), prefixes_off, ids_off,
+                             offsets_off, pool_off)
+    print(f"  oui: {len(prefixes)} prefixes, {len(vendors)} vendors")
+    return header + prefix_bytes + id_bytes + offset_bytes + pool
+
+
+def build_sound(path: Path) -> bytes:
+    with wave.open(str(path), "rb") as w:
+        if w.getnchannels() != 1 or w.getsampwidth() != 2:
+            raise SystemExit(f"{path}: need a mono 16-bit WAV")
+        rate = w.getframerate()
+        frames = w.getnframes()
+        data = w.readframes(frames)
+    if not 0 < rate <= 0xFFFF:
+        raise SystemExit(f"{path}: unsupported rate {rate}")
+    return SOUND_HEADER.pack(frames, rate, SAMPLE_PCM16) + data
+
+
+def split_spec(spec: str):
+    name, sep, path = spec.partition("=")
+    if not sep or not name or not path:
+        raise SystemExit(f"Expected NAME=PATH, got {spec!r}")
+    return name, Path(path)
+
+
+def main() -> int:
+    args = parse_args()
+
+    blobs = {}
+    if args.oui:
+        blobs["oui"] = build_oui(args.oui, args.max_name)
+    for spec in args.sound:
+        name, path = split_spec(spec)
+        blobs[f"snd/{name}"] = build_sound(path)
+    for spec in args.file:
+        name, path = split_spec(spec)
+        blobs[name] = path.read_bytes()
+    if not blobs:
+        print("Nothing to bundle: give --oui, --sound or --file", file=sys.stderr)
+        return 1
+    for name in blobs:
+        if len(name.encode()) >= NAME_LEN:
+            print(f"Entry name too long: {name}", file=sys.stderr)
+            return 1
+
+    # Directory sorted by name: the firmware binary-searches it
+    names = sorted(blobs, key=lambda n: n.encode())
+    offset = HEADER.size + ENTRY.size * len(names)
+    directory = b""
+    data = b""
+    for name in names:
+        blob = align4(blobs[name])
+        directory += ENTRY.pack(name.encode(), offset + len(data), len(blobs[name]))
+        data += blob
+
+    body = directory + data
+    total = HEADER.size + len(body)
+    if total > PARTITION_SIZE:
+        print(f"Bundle is {total} bytes, partition holds {PARTITION_SIZE}", file=sys.stderr)
+        return 1
+    header = HEADER.pack(MAGIC, FORMAT_VERSION, len(names), args.bundle_version, total,
+                         zlib.crc32(body))
+
+    args.output.parent.mkdir(parents=True, exist_ok=True)
+    args.output.write_bytes(header + body)
+    print(f"Wrote {args.output}: {len(names)} entries, {total} bytes, r{args.bundle_version}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""
+Generate main/oui_table.c, the flash-resident OUI vendor table used by
+oui_lookup.c.
+
+Input is either the IEEE MA-L registry CSV
+(https://standards-oui.ieee.org/oui/oui.csv) or a Wireshark "manuf" file.
+Vendor names are shortened and deduplicated into a string pool; prefixes
+are emitted sorted so the firmware can binary-search them.
+
+Usage:
+    python tools/gen_oui_table.py tools/oui_seed.csv -o main/oui_table.c
+    python tools/gen_oui_table.py oui.csv -o main/oui_table.c --max-name 16
+"""
+
+import argparse
+import csv
+import re
+import sys
+from pathlib import Path
+
+# Legal-form suffixes dropped from IEEE organization names
+SUFFIXES = re.compile(
+    r"[\s,.]+(inc|incorporated|corp|corporation|corporate|co|company|ltd|limited|"
+    r"llc|gmbh|ag|sa|s\.a|bv|b\.v|oy|ab|kk|plc|pte|pty|srl|technologies|technology)\.?$",
+    re.IGNORECASE,
+)
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", type=Path, help="IEEE oui.csv or Wireshark manuf file")
+    parser.add_argument("-o", "--output", type=Path, required=True, help="C file to write")
+    parser.add_argument("--max-name", type=int, default=24,
+                        help="Truncate vendor names to this many characters (default: 24)")
+    return parser.parse_args()
+
+
+def short_name(name: str, max_len: int) -> str:
+    name = " ".join(name.split())
+    prev = None
+    while prev != name:
+        prev = name
+        name = SUFFIXES.sub("", name).strip(" ,.")
+    # Shouting registrations ("TP-LINK TECHNOLOGIES") read better title-cased
+    if name.isupper() and len(name) > 4:
+        name = " ".join(w if len(w) <= 3 or "-" in w else w.capitalize() for w in name.split())
+    return name[:max_len].rstrip(" ,.-")
+
+
+def read_ieee_csv(path: Path):
+    with path.open(newline="", encoding="utf-8", errors="replace") as f:
+        for row in csv.DictReader(f):
+            if row.get("Registry", "MA-L") != "MA-L":
+                continue
+            assignment = row.get("Assignment", "").strip()
+            if len(assignment) == 6:
+                yield int(assignment, 16), row.get("Organization Name", "")
+
+
+def read_manuf(path: Path):
+    with path.open(encoding="utf-8", errors="replace") as f:
+        for line in f:
+            if not line.strip() or line.startswith("#"):
+                continue
+            fields = line.rstrip("\n").split("\t")
+            prefix = fields[0].strip()
+            # Only plain 24-bit assignments (no /28, /36 blocks)
+            if "/" in prefix or len(fields) < 2:
+                continue
+            digits = re.sub(r"[^0-9A-Fa-f]", "", prefix)
+            if len(digits) != 6:
+                continue
+            long_name = fields[2] if len(fields) > 2 else fields[1]
+            yield int(digits, 16), long_name
+
+
+def c_string(s: str) -> str:
+    out = []
+    for ch in s:
+        if ch in '"\\':
+            out.append("\\" + ch)
+        elif 32 <= ord(ch) < 127:
+            out.append(ch)
+        else:
+            out.append("?")
+    return "".join(out)
+
+
+def main() -> int:
+    args = parse_args()
+    with args.source.open(encoding="utf-8", errors="replace") as f:
+        is_csv = f.readline().startswith("Registry,")
+    records = read_ieee_csv(args.source) if is_csv else read_manuf(args.source)
+
+    table = {}
+    for prefix, name in records:
+        name = short_name(name, args.max_name)
+        if name:
+            table.setdefault(prefix, name)
+    if not table:
+        print(f"No OUI entries found in {args.source}", file=sys.stderr)
+        return 1
+
+    vendors = sorted(set(table.values()))
+    vendor_id = {v: i for i, v in enumerate(vendors)}
+    if len(vendors) > 0xFFFF:
+        print("Too many distinct vendors for 16-bit ids", file=sys.stderr)
+        return 1
+
+    offsets = []
+    pool_len = 0
+    for v in vendors:
+        offsets.append(pool_len)
+        pool_len += len(v.encode("ascii", "replace")) + 1
+
+    prefixes = sorted(table)
+    lines = [
+        "/**",
+        " * @file oui_table.c",
+        " * @brief OUI vendor table (generated, do not edit)",
+        " *",
+        f" * Generated by tools/gen_oui_table.py from {args.source.name}:",
+        f" * {len(prefixes)} prefixes, {len(vendors)} vendors, {pool_len} bytes of names.",
+        " */",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"const uint32_t oui_entry_count = {len(prefixes)};",
+        "",
+        "// Sorted 24-bit prefixes, big-endian",
+        "const uint8_t oui_prefixes[][3] = {",
+    ]
+    for p in prefixes:
+        lines.append(f"    {{ 0x{p >> 16:02X}, 0x{(p >> 8) & 0xFF:02X}, 0x{p & 0xFF:02X} }},")
+    lines += ["};", "", "// Vendor of each prefix, index into oui_vendor_offsets",
+              "const uint16_t oui_vendor_ids[] = {"]
+    for i in range(0, len(prefixes), 12):
+        chunk = prefixes[i:i + 12]
+        lines.append("    " + ", ".join(str(vendor_id[table[p]]) for p in chunk) + ",")
+    lines += ["};", "", "const uint32_t oui_vendor_offsets[] = {"]
+    for i in range(0, len(offsets), 12):
+        lines.append("    " + ", ".join(str(o) for o in offsets[i:i + 12]) + ",")
+    lines += ["};", "", "const char oui_vendor_pool[] ="]
+    for v in vendors:
+        lines.append(f'    "{c_string(v)}\\0"')
+    lines += ["    ;", ""]
+
+    args.output.parent.mkdir(parents=True, exist_ok=True)
+    args.output.write_text("\n".join(lines))
+    print(f"Wrote {args.output}: {len(prefixes)} prefixes, {len(vendors)} vendors")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
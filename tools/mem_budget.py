@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""
+List the capacity budget of a firmware build: every buffer declared with
+MEM_BUDGET() in main/, with its entry count, entry size and placement, and
+totals per placement. The table is read from the .mem_budget entries in
+the ELF, so it reflects the Kconfig capacity settings the image was built
+with. Requires pyelftools (part of the ESP-IDF Python environment).
+
+Usage:
+    idf.py mem_budget
+    python tools/mem_budget.py build/M5MonsterC5-CardputerADV.elf
+"""
+
+import argparse
+import struct
+import sys
+
+from elftools.elf.elffile import ELFFile
+from elftools.elf.sections import SymbolTableSection
+
+ENTRY = struct.Struct("<IIII")      # name, count, entry_size, where
+WHERE = ["static", "heap", "psram", "screen"]
+
+
+def parse_args() -> argparse.Namespace:
+    p = argparse.ArgumentParser(description=__doc__,
+                                formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("elf", help="application ELF file")
+    return p.parse_args()
+
+
+def symbol(elf: ELFFile, name: str) -> int:
+    for section in elf.iter_sections():
+        if isinstance(section, SymbolTableSection):
+            for sym in section.get_symbol_by_name(name) or []:
+                return sym["st_value"]
+    sys.exit(f"{name} not found: built without mem_monitor.lf?")
+
+
+def read(elf: ELFFile, addr: int, size: int) -> bytes:
+    for section in elf.iter_sections():
+        start = section["sh_addr"]
+        if section["sh_type"] != "SHT_NOBITS" and start <= addr < start + section["sh_size"]:
+            offset = addr - start
+            return section.data()[offset:offset + size]
+    raise ValueError(f"address 0x{addr:08x} not in a loaded section")
+
+
+def read_string(elf: ELFFile, addr: int) -> str:
+    data = read(elf, addr, 64)
+    return data.split(b"\0", 1)[0].decode("ascii", "replace")
+
+
+def main() -> None:
+    args = parse_args()
+    with open(args.elf, "rb") as f:
+        elf = ELFFile(f)
+        start = symbol(elf, "_mem_budget_start")
+        end = symbol(elf, "_mem_budget_end")
+        table = read(elf, start, end - start)
+
+        totals = dict.fromkeys(WHERE, 0)
+        print(f"{'buffer':<24}{'count':>7}{'entry':>7}{'bytes':>10}  where")
+        for pos in range(0, len(table) - ENTRY.size + 1, ENTRY.size):
+            name_ptr, count, entry_size, where = ENTRY.unpack_from(table, pos)
+            place = WHERE[where] if where < len(WHERE) else "heap"
+            size = count * entry_size
+            totals[place] += size
+            print(f"{read_string(elf, name_ptr):<24}{count:>7}{entry_size:>7}{size:>10}  {place}")
+
+    print()
+    for place, size in totals.items():
+        print(f"{place:<8}{size:>10} B  {size / 1024:8.1f} KB")
+
+
+if __name__ == "__main__":
+    main()
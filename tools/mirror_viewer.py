@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+"""
+Show the Cardputer display live on a PC while Ctrl+M mirroring runs, and
+send key presses back to it.
+
+The wire format is documented in main/drivers/screen_mirror.h. Keys typed
+in the window are sent as presses (letters, digits, symbols, arrows,
+Enter, Esc, Backspace, Tab, Delete); F5 asks for the full screen again.
+Requires pyserial and Pillow (Tk comes with Python).
+
+Usage:
+    python tools/mirror_viewer.py /dev/ttyACM0 --scale 4
+    python tools/mirror_viewer.py COM5
+"""
+
+import argparse
+import struct
+import threading
+import tkinter as tk
+
+import serial
+from PIL import Image, ImageTk
+
+PACKET = struct.Struct("<2sBI")
+HELLO = struct.Struct("<HHH")
+RECT = struct.Struct("<HHHH")
+MAX_PAYLOAD = 256 * 1024
+
+# key_code_t order in main/drivers/keyboard.h
+KEY_CODES = [
+    "NONE", "UP", "DOWN", "LEFT", "RIGHT", "ENTER", "ESC", "SPACE",
+    "BACKSPACE", "TAB",
+    *"ABCDEFGHIJKLMNOPQRSTUVWXYZ",
+    *"0123456789",
+    "`", "-", "=", "[", "]", "\\", ";", "'", ",", ".", "/",
+    "SHIFT", "CTRL", "ALT", "OPT", "FN", "CAPSLOCK", "DEL",
+]
+KEY_INDEX = {name: i for i, name in enumerate(KEY_CODES)}
+TK_KEYSYMS = {
+    "Up": "UP", "Down": "DOWN", "Left": "LEFT", "Right": "RIGHT",
+    "Return": "ENTER", "Escape": "ESC", "space": "SPACE",
+    "BackSpace": "BACKSPACE", "Tab": "TAB", "Delete": "DEL",
+}
+
+
+def parse_args() -> argparse.Namespace:
+    p = argparse.ArgumentParser(description=__doc__,
+                                formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("port", help="USB CDC serial port of the Cardputer")
+    p.add_argument("--scale", type=int, default=3, help="integer upscale factor")
+    return p.parse_args()
+
+
+def panel_to_rgb(v: int) -> tuple:
+    v = ((v & 0xFF) << 8) | (v >> 8)            # Panel order -> RGB565
+    return (((v >> 11) & 0x1F) << 3, ((v >> 5) & 0x3F) << 2, (v & 0x1F) << 3)
+
+
+class Mirror:
+    def __init__(self, port: str):
+        self.serial = serial.Serial(port, timeout=0.1)
+        self.lock = threading.Lock()
+        self.image = Image.new("RGB", (240, 135))
+        self.frames = 0
+        self.dirty = False
+
+    def read_exact(self, n: int) -> bytes:
+        data = b""
+        while len(data) < n:
+            data += self.serial.read(n - len(data))
+        return data
+
+    def sync(self) -> tuple:
+        """Find the next packet header, skipping bytes after a lost stretch"""
+        window = self.read_exact(PACKET.size)
+        while True:
+            magic, kind, length = PACKET.unpack(window)
+            if magic == b"MF" and kind in b"HRF" and length <= MAX_PAYLOAD:
+                return kind, length
+            window = window[1:] + self.read_exact(1)
+
+    def apply_rect(self, payload: bytes) -> None:
+        x, y, w, h = RECT.unpack_from(payload, 0)
+        pixels = []
+        for pos in range(RECT.size, len(payload) - 3, 4):
+            count, value = struct.unpack_from("<HH", payload, pos)
+            pixels.extend([panel_to_rgb(value)] * count)
+        if len(pixels) != w * h:
+            self.send(b"S")                     # Torn packet: ask for a full screen
+            return
+        band = Image.new("RGB", (w, h))
+        band.putdata(pixels)
+        with self.lock:
+            self.image.paste(band, (x, y))
+
+    def run(self) -> None:
+        while True:
+            kind, length = self.sync()
+            payload = self.read_exact(length)
+            if kind == ord("H"):
+                _version, width, height = HELLO.unpack_from(payload, 0)
+                with self.lock:
+                    self.image = Image.new("RGB", (width, height))
+            elif kind == ord("R"):
+                self.apply_rect(payload)
+            elif kind == ord("F"):
+                with self.lock:
+                    self.frames += 1
+                    self.dirty = True
+
+    def send(self, data: bytes) -> None:
+        self.serial.write(data)
+
+
+def main() -> None:
+    args = parse_args()
+    mirror = Mirror(args.port)
+    threading.Thread(target=mirror.run, daemon=True).start()
+
+    root = tk.Tk()
+    root.title(f"Cardputer mirror - {args.port}")
+    label = tk.Label(root)
+    label.pack()
+
+    def on_key(event):
+        if event.keysym == "F5":
+            mirror.send(b"S")
+            return
+        name = TK_KEYSYMS.get(event.keysym)
+        if name is None and len(event.char) == 1:
+            name = event.char.upper()
+        code = KEY_INDEX.get(name)
+        if code:
+            mirror.send(bytes((ord("K"), code)))
+
+    def refresh():
+        with mirror.lock:
+            if mirror.dirty:
+                mirror.dirty = False
+                frame = mirror.image.resize((mirror.image.width * args.scale,
+                                             mirror.image.height * args.scale),
+                                            Image.NEAREST)
+                photo = ImageTk.PhotoImage(frame)
+                label.configure(image=photo)
+                label.image = photo
+        root.after(20, refresh)
+
+    root.bind("<Key>", on_key)
+    mirror.send(b"S")
+    refresh()
+    root.mainloop()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""
+Convert a Ctrl+R screen recording (/sdcard/screens/rec_N.mrec) into an
+animated GIF, or into numbered PNG frames for feeding to ffmpeg.
+
+The .mrec format is documented in main/drivers/screen_record.h.
+Requires Pillow.
+
+Usage:
+    python tools/mrec_convert.py rec_1.mrec -o rec_1.gif
+    python tools/mrec_convert.py rec_1.mrec --frames out_dir --scale 2
+    ffmpeg -framerate 5 -i out_dir/frame_%05d.png rec_1.mp4
+"""
+
+import argparse
+import struct
+import sys
+from pathlib import Path
+
+from PIL import Image
+
+HEADER = struct.Struct("<4sHHHH")
+FRAME = struct.Struct("<IHHHHI")
+
+
+def parse_args() -> argparse.Namespace:
+    p = argparse.ArgumentParser(description=__doc__,
+                                formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("input", type=Path, help=".mrec recording")
+    p.add_argument("-o", "--output", type=Path, help="GIF to write")
+    p.add_argument("--frames", type=Path, help="directory for numbered PNG frames")
+    p.add_argument("--scale", type=int, default=1, help="integer upscale factor")
+    return p.parse_args()
+
+
+def rgb565_to_image(pixels: list, width: int, height: int) -> Image.Image:
+    rgb = bytearray(width * height * 3)
+    for i, v in enumerate(pixels):
+        v = ((v & 0xFF) << 8) | (v >> 8)        # Panel order -> RGB565
+        rgb[i * 3] = ((v >> 11) & 0x1F) << 3
+        rgb[i * 3 + 1] = ((v >> 5) & 0x3F) << 2
+        rgb[i * 3 + 2] = (v & 0x1F) << 3
+    return Image.frombytes("RGB", (width, height), bytes(rgb))
+
+
+def read_frames(data: bytes):
+    """Yield (time_ms, pixels) with pixels reconstructed from the deltas"""
+    magic, version, width, height, _interval = HEADER.unpack_from(data, 0)
+    if magic != b"MREC" or version != 1:
+        raise ValueError("not an MREC v1 recording")
+    pixels = [0] * (width * height)
+    pos = HEADER.size
+
+    while pos + FRAME.size <= len(data):
+        time_ms, x, y, w, h, length = FRAME.unpack_from(data, pos)
+        pos += FRAME.size
+        payload = data[pos:pos + length]
+        pos += length
+        if len(payload) < length:
+            break                               # Recording cut off mid-frame
+
+        i = 0
+        for count, value in struct.iter_unpack("<HH", payload):
+            for _ in range(count):
+                row, col = divmod(i, w)
+                pixels[(y + row) * width + x + col] ^= value
+                i += 1
+        yield width, height, time_ms, pixels
+
+
+def main() -> int:
+    args = parse_args()
+    if not args.output and not args.frames:
+        print("nothing to do: give -o and/or --frames", file=sys.stderr)
+        return 1
+
+    images, times = [], []
+    for width, height, time_ms, pixels in read_frames(args.input.read_bytes()):
+        img = rgb565_to_image(pixels, width, height)
+        if args.scale > 1:
+            img = img.resize((width * args.scale, height * args.scale), Image.NEAREST)
+        images.append(img)
+        times.append(time_ms)
+    if not images:
+        print("no frames in recording", file=sys.stderr)
+        return 1
+
+    if args.frames:
+        args.frames.mkdir(parents=True, exist_ok=True)
+        for n, img in enumerate(images):
+            img.save(args.frames / f"frame_{n:05d}.png")
+
+    if args.output:
+        # Each frame stays up until the next one was sampled
+        durations = [max(20, b - a) for a, b in zip(times, times[1:])] + [1000]
+        images[0].save(args.output, save_all=True, append_images=images[1:],
+                       duration=durations, loop=0, optimize=True)
+
+    print(f"{len(images)} frames, {times[-1] / 1000:.1f} s")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+Convert a Cardputer wardrive log (/sdcard/wardrive/wd_N.mwd) into WiGLE
+CSV for upload. The file is read one block at a time, so inputs of any
+size convert in constant memory.
+
+The .mwd format is documented in main/wardrive_log.h.
+
+Usage:
+    python tools/mwd_to_wigle.py wd_1.mwd -o wd_1.csv
+    python tools/mwd_to_wigle.py wd_1.mwd --bssid AA:BB:CC     # filter by prefix
+"""
+
+import argparse
+import csv
+import struct
+import sys
+import time
+from pathlib import Path
+
+HEADER = struct.Struct("<4sBHHB")
+BLOCK = struct.Struct("<BHI")
+BLOCK_MARKER = 0xB1
+
+WIGLE_PREAMBLE = ("WigleWifi-1.4,appRelease=1,model=Cardputer,release=1,"
+                  "device=M5MonsterC5,display=,board=,brand=M5Stack")
+WIGLE_COLUMNS = ["MAC", "SSID", "AuthMode", "FirstSeen", "Channel", "RSSI",
+                 "CurrentLatitude", "CurrentLongitude", "AltitudeMeters",
+                 "AccuracyMeters", "Type"]
+
+
+def parse_args() -> argparse.Namespace:
+    p = argparse.ArgumentParser(description=__doc__,
+                                formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("input", type=Path, help=".mwd wardrive log")
+    p.add_argument("-o", "--output", type=Path, help="CSV to write (default: stdout)")
+    p.add_argument("--bssid", help="only rows whose BSSID starts with this prefix")
+    return p.parse_args()
+
+
+class Reader:
+    def __init__(self, data: bytes):
+        self.data = data
+        self.pos = 0
+
+    def byte(self) -> int:
+        b = self.data[self.pos]
+        self.pos += 1
+        return b
+
+    def take(self, n: int) -> bytes:
+        b = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return b
+
+    def varint(self) -> int:
+        v = shift = 0
+        while True:
+            b = self.byte()
+            v |= (b & 0x7F) << shift
+            if b < 0x80:
+                return v
+            shift += 7
+
+    def svarint(self) -> int:
+        v = self.varint()
+        return (v >> 1) ^ -(v & 1)
+
+
+def deltas(r: Reader, n: int, signed: bool = True) -> list:
+    out, acc = [], 0
+    for _ in range(n):
+        acc += r.svarint() if signed else r.varint()
+        out.append(acc)
+    return out
+
+
+def convert(f, writer, bssid_prefix: str) -> int:
+    magic, version, bssid_slots, ssid_slots, auth_slots = HEADER.unpack(f.read(HEADER.size))
+    if magic != b"MWD1" or version != 1:
+        sys.exit("not an MWD1 wardrive log")
+    bssids = [""] * bssid_slots
+    ssids = [""] * ssid_slots
+    auths = [""] * auth_slots
+    rows_out = 0
+
+    while True:
+        head = f.read(BLOCK.size)
+        if len(head) < BLOCK.size:
+            break
+        marker, n, payload_len = BLOCK.unpack(head)
+        payload = f.read(payload_len)
+        if marker != BLOCK_MARKER or len(payload) < payload_len:
+            print("truncated or corrupt block, stopping", file=sys.stderr)
+            break
+        r = Reader(payload)
+
+        for _ in range(r.varint()):
+            slot = r.varint()
+            bssids[slot] = ":".join(f"{b:02X}" for b in r.take(6))
+        for table in (ssids, auths):
+            for _ in range(r.varint()):
+                slot = r.varint()
+                table[slot] = r.take(r.byte()).decode("utf-8", "replace")
+
+        times = deltas(r, n)
+        lats = deltas(r, n)
+        lons = deltas(r, n)
+        alts = deltas(r, n)
+        accs = [r.varint() for _ in range(n)]
+        bssid_ix = [r.varint() for _ in range(n)]
+        ssid_ix = [r.varint() for _ in range(n)]
+        auth_ix = [r.varint() for _ in range(n)]
+        channels = list(r.take(n))
+        rssis = [b - 256 if b > 127 else b for b in r.take(n)]
+
+        for i in range(n):
+            mac = bssids[bssid_ix[i]]
+            if bssid_prefix and not mac.startswith(bssid_prefix):
+                continue
+            writer.writerow([
+                mac, ssids[ssid_ix[i]], auths[auth_ix[i]],
+                time.strftime("%Y-%m-%d %H:%M:%S", time.gmtime(times[i])),
+                channels[i], rssis[i],
+                f"{lats[i] / 1e7:.7f}", f"{lons[i] / 1e7:.7f}",
+                f"{alts[i] / 10:.1f}", f"{accs[i] / 10:.1f}", "WIFI",
+            ])
+            rows_out += 1
+    return rows_out
+
+
+def main() -> None:
+    args = parse_args()
+    prefix = args.bssid.upper() if args.bssid else ""
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    try:
+        out.write(WIGLE_PREAMBLE + "\n")
+        writer = csv.writer(out)
+        writer.writerow(WIGLE_COLUMNS)
+        with open(args.input, "rb") as f:
+            rows = convert(f, writer, prefix)
+    finally:
+        if out is not sys.stdout:
+            out.close()
+    print(f"{rows} observations", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
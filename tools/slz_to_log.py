@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+Expand a compressed Cardputer session log (/sdcard/logs/session_N.slz)
+back into the tab-separated text of a session_N.log. Blocks are read one
+at a time, so files of any size convert in constant memory. A file cut
+short by a reset converts up to its last whole block.
+
+The .slz format is documented in main/session_file.h.
+
+Usage:
+    python tools/slz_to_log.py session_3.slz -o session_3.log
+    python tools/slz_to_log.py session_3.slz | grep HANDSHAKE
+"""
+
+import argparse
+import struct
+import sys
+from pathlib import Path
+
+HEADER = struct.Struct("<4sH")
+BLOCK = struct.Struct("<BBHHI")
+BLOCK_MARKER = 0xB2
+FLAG_RAW = 0x01
+
+
+def parse_args() -> argparse.Namespace:
+    p = argparse.ArgumentParser(description=__doc__,
+                                formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("input", type=Path, help=".slz session log")
+    p.add_argument("-o", "--output", type=Path, help="text log to write (default: stdout)")
+    return p.parse_args()
+
+
+def lz4_block_decompress(src: bytes, size: int) -> bytes:
+    """Expand one LZ4 block (no frame) of known output size"""
+    out = bytearray()
+    pos = 0
+
+    def length(n: int) -> int:
+        nonlocal pos
+        if n == 15:
+            while True:
+                b = src[pos]
+                pos += 1
+                n += b
+                if b != 255:
+                    break
+        return n
+
+    while pos < len(src):
+        token = src[pos]
+        pos += 1
+        literals = length(token >> 4)
+        out += src[pos:pos + literals]
+        pos += literals
+        if pos >= len(src):
+            break
+        offset = src[pos] | src[pos + 1] << 8
+        pos += 2
+        if offset == 0 or offset > len(out):
+            raise ValueError("bad match offset")
+        match = length(token & 15) + 4
+        start = len(out) - offset
+        for i in range(match):                  # May overlap its own output
+            out.append(out[start + i])
+    if len(out) != size:
+        raise ValueError("block expands to the wrong size")
+    return bytes(out)
+
+
+def read_blocks(f):
+    """Yield the text of each block up to the index or the first bad header"""
+    magic, _block_size = HEADER.unpack(f.read(HEADER.size))
+    if magic != b"SLZ1":
+        raise ValueError("not an SLZ1 session log")
+    expected = 0
+    while True:
+        head = f.read(BLOCK.size)
+        if len(head) < BLOCK.size:
+            return
+        marker, flags, raw_len, stored_len, raw_offset = BLOCK.unpack(head)
+        if marker != BLOCK_MARKER:
+            return                              # Block index, or the unwritten tail
+        stored = f.read(stored_len)
+        if len(stored) < stored_len:
+            return
+        if raw_offset != expected:
+            print(f"warning: gap at text offset {expected}", file=sys.stderr)
+        expected = raw_offset + raw_len
+        yield stored if flags & FLAG_RAW else lz4_block_decompress(stored, raw_len)
+
+
+def main() -> int:
+    args = parse_args()
+    out = open(args.output, "wb") if args.output else sys.stdout.buffer
+    total = 0
+    try:
+        with open(args.input, "rb") as f:
+            for text in read_blocks(f):
+                out.write(text)
+                total += len(text)
+    except ValueError as e:
+        print(f"{args.input}: {e}", file=sys.stderr)
+        return 1
+    finally:
+        if args.output:
+            out.close()
+    print(f"{total} bytes of records", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""
+Convert a Ctrl+T event trace (/sdcard/traces/trace_N.mtr) into Chrome
+trace JSON, which ui.perfetto.dev and chrome://tracing open directly.
+
+Each firmware task becomes one track; begin/end pairs (dispatch, parse,
+draw, flush, SD write) become slices and arrivals (UART lines and
+frames, key presses) instant events. The .mtr format is documented in
+main/trace.h. Times are microseconds since boot.
+
+Usage:
+    python tools/trace_to_perfetto.py trace_1.mtr -o trace_1.json
+    python tools/trace_to_perfetto.py trace_1.mtr --summary
+"""
+
+import argparse
+import json
+import struct
+import sys
+from collections import defaultdict
+from pathlib import Path
+
+HEADER = struct.Struct("<4sHHIIB")
+RECORD = struct.Struct("<QBBBBI")
+NAME_LEN = 16
+TASK_OTHER = 0xFF
+
+EVENTS = ["uart_line", "uart_frame", "dispatch", "parse", "draw", "flush",
+          "key", "sd_write"]
+PHASES = {0: "i", 1: "B", 2: "E"}
+
+
+def parse_args() -> argparse.Namespace:
+    p = argparse.ArgumentParser(description=__doc__,
+                                formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("input", type=Path, help=".mtr trace")
+    p.add_argument("-o", "--output", type=Path, help="JSON to write (default: input.json)")
+    p.add_argument("--summary", action="store_true",
+                   help="print slice counts and durations per event instead")
+    return p.parse_args()
+
+
+def read_trace(path: Path):
+    data = path.read_bytes()
+    magic, version, record_size, count, lost, name_count = HEADER.unpack_from(data, 0)
+    if magic != b"MTRC" or version != 1 or record_size != RECORD.size:
+        sys.exit(f"{path}: not a version 1 trace")
+
+    offset = HEADER.size
+    names = []
+    for _ in range(name_count):
+        names.append(data[offset:offset + NAME_LEN].split(b"\0", 1)[0].decode())
+        offset += NAME_LEN
+
+    records = []
+    for _ in range(count):
+        if offset + RECORD.size > len(data):
+            print(f"{path}: truncated after {len(records)} records", file=sys.stderr)
+            break
+        records.append(RECORD.unpack_from(data, offset))
+        offset += RECORD.size
+    return names, records, lost
+
+
+def event_args(event: str, arg: int) -> dict:
+    if event in ("uart_line", "uart_frame"):
+        key = "length" if event == "uart_line" else "type"
+        return {"link": arg >> 16, key: arg & 0xFFFF}
+    if event == "parse":
+        return {"value": arg}
+    if event == "key":
+        return {"key": arg}
+    if event == "sd_write":
+        return {"bytes": arg}
+    if event == "dispatch":
+        return {"routes": arg}
+    if event == "flush":
+        return {"rects": arg}
+    return {"depth": arg}
+
+
+def to_chrome(names, records) -> list:
+    out = []
+    tids = set()
+    for time_us, task, core, event_id, phase, arg in records:
+        event = EVENTS[event_id] if event_id < len(EVENTS) else f"event_{event_id}"
+        tid = task if task != TASK_OTHER else 1000 + core
+        tids.add((tid, task, core))
+        e = {"name": event, "ph": PHASES.get(phase, "i"), "ts": time_us,
+             "pid": 1, "tid": tid, "args": event_args(event, arg)}
+        if e["ph"] == "i":
+            e["s"] = "t"
+        out.append(e)
+
+    out.append({"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "Cardputer"}})
+    for tid, task, core in sorted(tids):
+        name = names[task] if task < len(names) else f"other (core {core})"
+        out.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": tid,
+                    "args": {"name": name}})
+    return out
+
+
+def summarize(names, records) -> None:
+    open_slices = {}
+    durations = defaultdict(list)
+    instants = defaultdict(int)
+    for time_us, task, core, event_id, phase, arg in records:
+        event = EVENTS[event_id] if event_id < len(EVENTS) else f"event_{event_id}"
+        key = (task, core, event_id)
+        if phase == 1:
+            open_slices[key] = time_us
+        elif phase == 2 and key in open_slices:
+            durations[event].append(time_us - open_slices.pop(key))
+        elif phase == 0:
+            instants[event] += 1
+
+    span = (records[-1][0] - records[0][0]) / 1e6 if len(records) > 1 else 0
+    print(f"{len(records)} events over {span:.2f} s")
+    for event, counts in sorted(instants.items()):
+        print(f"  {event:<10} {counts:6d} instants")
+    for event, d in sorted(durations.items()):
+        d.sort()
+        print(f"  {event:<10} {len(d):6d} slices  avg {sum(d) / len(d):8.0f} us"
+              f"  p99 {d[int(len(d) * 0.99)]:8d} us  max {d[-1]:8d} us")
+
+
+def main() -> None:
+    args = parse_args()
+    names, records, lost = read_trace(args.input)
+    if lost:
+        print(f"{lost} older events were overwritten before the dump", file=sys.stderr)
+
+    if args.summary:
+        summarize(names, records)
+        return
+
+    output = args.output or args.input.with_suffix(".json")
+    output.write_text(json.dumps({"traceEvents": to_chrome(names, records),
+                                  "displayTimeUnit": "ms"}))
+    print(f"Wrote {len(records)} events to {output}")
+
+
+if __name__ == "__main__":
+    main()